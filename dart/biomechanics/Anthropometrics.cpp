@@ -1,5 +1,7 @@
 #include "dart/biomechanics/Anthropometrics.hpp"
 
+#include <algorithm>
+
 #include "dart/math/FiniteDifference.hpp"
 #include "dart/utils/CompositeResourceRetriever.hpp"
 #include "dart/utils/DartResourceRetriever.hpp"
@@ -263,6 +265,9 @@ void Anthropometrics::addMetric(
     Eigen::Vector3s axis)
 {
   mMetrics.emplace_back(name, bodyPose, bodyA, offsetA, bodyB, offsetB, axis);
+  updateMetricDistIndices();
+  std::lock_guard<std::mutex> lock(mLinearMetricsMutex);
+  mLinearMetrics.clear();
 }
 
 //==============================================================================
@@ -279,6 +284,7 @@ void Anthropometrics::setDistribution(
     std::shared_ptr<math::MultivariateGaussian> dist)
 {
   mDist = dist;
+  updateMetricDistIndices();
 }
 
 //==============================================================================
@@ -359,28 +365,161 @@ std::map<std::string, s_t> Anthropometrics::measure(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
   std::map<std::string, s_t> result;
+  std::shared_ptr<const LinearMetrics> linear = getLinearMetrics(skel);
+  Eigen::VectorXs bodyScales = skel->getBodyScales();
+  for (int i = 0; i < mMetrics.size(); i++)
+  {
+    result[mMetrics[i].name] = measureLinearMetric(*linear, i, bodyScales);
+  }
+  return result;
+}
+
+//==============================================================================
+Eigen::VectorXs Anthropometrics::measureVector(
+    std::shared_ptr<dynamics::Skeleton> skel)
+{
+  if (!mDist)
+    return Eigen::VectorXs::Zero(0);
+  return measureVector(*getLinearMetrics(skel), skel->getBodyScales());
+}
+
+//==============================================================================
+/// This is measureVector(), at the given body scales
+Eigen::VectorXs Anthropometrics::measureVector(
+    const LinearMetrics& linear, const Eigen::VectorXs& bodyScales)
+{
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(mDist->getMu().size());
+  for (int i = 0; i < mMetrics.size(); i++)
+  {
+    if (mMetricDistIndices[i] == -1)
+      continue;
+    result(mMetricDistIndices[i]) = measureLinearMetric(linear, i, bodyScales);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns the linear form of every metric on `skel`, building it (and
+/// posing the skeleton, and then restoring it) only if we haven't seen
+/// `skel` before, or it's moved since we last measured a metric that
+/// depends on its pose
+std::shared_ptr<const Anthropometrics::LinearMetrics>
+Anthropometrics::getLinearMetrics(std::shared_ptr<dynamics::Skeleton> skel)
+{
+  bool dependsOnPose = false;
+  for (const AnthroMetric& metric : mMetrics)
+  {
+    dependsOnPose = dependsOnPose || metric.bodyPose.size() == 0;
+  }
+
+  std::lock_guard<std::mutex> lock(mLinearMetricsMutex);
+  auto it = mLinearMetrics.find(skel.get());
+  // Checking the weak pointer means a new skeleton that happens to land at
+  // the address of a deleted one doesn't pick up its metrics
+  if (it != mLinearMetrics.end() && it->second->skel.lock() == skel
+      && (!dependsOnPose || it->second->pose == skel->getPositions()))
+  {
+    return it->second;
+  }
+
+  // Drop anything left over from skeletons that have been deleted
+  for (auto cursor = mLinearMetrics.begin(); cursor != mLinearMetrics.end();)
+  {
+    if (cursor->second->skel.expired())
+      cursor = mLinearMetrics.erase(cursor);
+    else
+      cursor++;
+  }
+
+  std::shared_ptr<LinearMetrics> linear = std::make_shared<LinearMetrics>();
+  linear->skel = skel;
   Eigen::VectorXs originalPos = skel->getPositions();
-  for (AnthroMetric& metric : mMetrics)
+  if (dependsOnPose)
+  {
+    linear->pose = originalPos;
+  }
+  Eigen::VectorXs bodyScales = skel->getBodyScales();
+  for (const AnthroMetric& metric : mMetrics)
   {
     setSkelToMetricPose(skel, metric);
-    std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerA
-        = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
-            skel->getBodyNode(metric.bodyA), metric.offsetA);
-    std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerB
-        = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
-            skel->getBodyNode(metric.bodyB), metric.offsetB);
-    if (metric.axis == Eigen::Vector3s::Zero())
-    {
-      result[metric.name] = skel->getDistanceInWorldSpace(markerA, markerB);
-    }
-    else
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+    markers.emplace_back(skel->getBodyNode(metric.bodyA), metric.offsetA);
+    markers.emplace_back(skel->getBodyNode(metric.bodyB), metric.offsetB);
+    Eigen::VectorXs worldPositions = skel->getMarkerWorldPositions(markers);
+    Eigen::MatrixXs jac
+        = skel->getMarkerWorldPositionsJacobianWrtBodyScales(markers);
+
+    LinearMetric linearMetric;
+    linearMetric.jac = jac.topRows<3>() - jac.bottomRows<3>();
+    linearMetric.constant = worldPositions.head<3>()
+                            - worldPositions.tail<3>()
+                            - linearMetric.jac * bodyScales;
+    linear->metrics.push_back(linearMetric);
+  }
+  if (skel->getPositions() != originalPos)
+  {
+    skel->setPositions(originalPos);
+  }
+
+  mLinearMetrics[skel.get()] = linear;
+  return linear;
+}
+
+//==============================================================================
+/// This evaluates metric `i` at `bodyScales`
+s_t Anthropometrics::measureLinearMetric(
+    const LinearMetrics& linear, int i, const Eigen::VectorXs& bodyScales)
+{
+  const LinearMetric& linearMetric = linear.metrics[i];
+  Eigen::Vector3s diff = linearMetric.jac * bodyScales + linearMetric.constant;
+  if (mMetrics[i].axis == Eigen::Vector3s::Zero())
+  {
+    return diff.norm();
+  }
+  else
+  {
+    return diff.dot(mMetrics[i].axis);
+  }
+}
+
+//==============================================================================
+/// This returns the gradient of metric `i` wrt body scales, at `bodyScales`
+Eigen::VectorXs Anthropometrics::getLinearMetricGradient(
+    const LinearMetrics& linear, int i, const Eigen::VectorXs& bodyScales)
+{
+  const LinearMetric& linearMetric = linear.metrics[i];
+  if (mMetrics[i].axis == Eigen::Vector3s::Zero())
+  {
+    Eigen::Vector3s diff
+        = linearMetric.jac * bodyScales + linearMetric.constant;
+    s_t dist = diff.norm();
+    if (dist == 0)
     {
-      result[metric.name]
-          = skel->getDistanceAlongAxis(markerA, markerB, metric.axis);
+      return Eigen::VectorXs::Zero(bodyScales.size());
     }
+    return linearMetric.jac.transpose() * (diff / dist);
+  }
+  else
+  {
+    return linearMetric.jac.transpose() * mMetrics[i].axis;
+  }
+}
+
+//==============================================================================
+void Anthropometrics::updateMetricDistIndices()
+{
+  mMetricDistIndices.clear();
+  std::vector<std::string> vars;
+  if (mDist)
+  {
+    vars = mDist->getVariableNames();
+  }
+  for (AnthroMetric& metric : mMetrics)
+  {
+    auto it = std::find(vars.begin(), vars.end(), metric.name);
+    mMetricDistIndices.push_back(
+        it == vars.end() ? -1 : (int)std::distance(vars.begin(), it));
   }
-  skel->setPositions(originalPos);
-  return result;
 }
 
 //==============================================================================
@@ -388,7 +527,7 @@ s_t Anthropometrics::getPDF(std::shared_ptr<dynamics::Skeleton> skel)
 {
   if (!mDist)
     return 0.0;
-  return mDist->computePDF(mDist->convertFromMap(measure(skel)));
+  return mDist->computePDF(measureVector(skel));
 }
 
 //==============================================================================
@@ -397,7 +536,7 @@ s_t Anthropometrics::getLogPDF(
 {
   if (!mDist)
     return 0.0;
-  return mDist->computeLogPDF(mDist->convertFromMap(measure(skel)), normalized);
+  return mDist->computeLogPDF(measureVector(skel), normalized);
 }
 
 //==============================================================================
@@ -408,33 +547,19 @@ Eigen::VectorXs Anthropometrics::getGradientOfLogPDFWrtBodyScales(
   if (!mDist)
     return grad;
 
-  std::map<std::string, s_t> gradMap = mDist->convertToMap(
-      mDist->computeLogPDFGrad(mDist->convertFromMap(measure(skel))));
+  std::shared_ptr<const LinearMetrics> linear = getLinearMetrics(skel);
+  Eigen::VectorXs bodyScales = skel->getBodyScales();
+  Eigen::VectorXs logPDFGrad
+      = mDist->computeLogPDFGrad(measureVector(*linear, bodyScales));
 
-  Eigen::VectorXs originalPos = skel->getPositions();
-  for (AnthroMetric& metric : mMetrics)
+  for (int i = 0; i < mMetrics.size(); i++)
   {
-    setSkelToMetricPose(skel, metric);
-    std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerA
-        = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
-            skel->getBodyNode(metric.bodyA), metric.offsetA);
-    std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerB
-        = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
-            skel->getBodyNode(metric.bodyB), metric.offsetB);
-
-    if (metric.axis == Eigen::Vector3s::Zero())
-    {
-      grad += gradMap[metric.name]
-              * skel->getGradientOfDistanceWrtBodyScales(markerA, markerB);
-    }
-    else
-    {
-      grad += gradMap[metric.name]
-              * skel->getGradientOfDistanceAlongAxisWrtBodyScales(
-                  markerA, markerB, metric.axis);
-    }
+    // Metrics the distribution doesn't model don't affect the PDF
+    if (mMetricDistIndices[i] == -1)
+      continue;
+    grad += logPDFGrad(mMetricDistIndices[i])
+            * getLinearMetricGradient(*linear, i, bodyScales);
   }
-  skel->setPositions(originalPos);
 
   return grad;
 }
@@ -472,39 +597,10 @@ Eigen::VectorXs Anthropometrics::finiteDifferenceGradientOfLogPDFWrtBodyScales(
 Eigen::VectorXs Anthropometrics::getGradientOfLogPDFWrtGroupScales(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
-  Eigen::VectorXs grad = Eigen::VectorXs::Zero(skel->getGroupScaleDim());
   if (!mDist)
-    return grad;
-
-  std::map<std::string, s_t> gradMap = mDist->convertToMap(
-      mDist->computeLogPDFGrad(mDist->convertFromMap(measure(skel))));
-
-  Eigen::VectorXs originalPos = skel->getPositions();
-  for (AnthroMetric& metric : mMetrics)
-  {
-    setSkelToMetricPose(skel, metric);
-    std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerA
-        = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
-            skel->getBodyNode(metric.bodyA), metric.offsetA);
-    std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerB
-        = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
-            skel->getBodyNode(metric.bodyB), metric.offsetB);
-
-    if (metric.axis == Eigen::Vector3s::Zero())
-    {
-      grad += gradMap[metric.name]
-              * skel->getGradientOfDistanceWrtGroupScales(markerA, markerB);
-    }
-    else
-    {
-      grad += gradMap[metric.name]
-              * skel->getGradientOfDistanceAlongAxisWrtGroupScales(
-                  markerA, markerB, metric.axis);
-    }
-  }
-  skel->setPositions(originalPos);
-
-  return grad;
+    return Eigen::VectorXs::Zero(skel->getGroupScaleDim());
+  return skel->convertBodyScalesGradientToGroupScales(
+      getGradientOfLogPDFWrtBodyScales(skel));
 }
 
 //==============================================================================
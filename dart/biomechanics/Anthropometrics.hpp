@@ -4,6 +4,7 @@
 #include <memory>
 // #include <unordered_map>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -75,6 +76,11 @@ public:
 
   std::map<std::string, s_t> measure(std::shared_ptr<dynamics::Skeleton> skel);
 
+  /// This is the same as measure(), but laid out in the order of the
+  /// distribution's variables, which skips all the name lookups. Variables
+  /// with no matching metric are left at 0.
+  Eigen::VectorXs measureVector(std::shared_ptr<dynamics::Skeleton> skel);
+
   s_t getPDF(std::shared_ptr<dynamics::Skeleton> skel);
 
   s_t getLogPDF(
@@ -96,8 +102,57 @@ public:
       std::shared_ptr<dynamics::Skeleton> skel);
 
 protected:
+  /// Every metric is measured in a fixed pose, where the world position of
+  /// any point on a body is linear in the body scales. That means the vector
+  /// from a metric's point B to its point A is `jac * bodyScales + constant`,
+  /// so once we have those we never need to pose the skeleton or run FK again.
+  struct LinearMetric
+  {
+    Eigen::MatrixXs jac;
+    Eigen::Vector3s constant;
+  };
+
+  struct LinearMetrics
+  {
+    std::weak_ptr<dynamics::Skeleton> skel;
+    /// Metrics without a BodyPose are measured in whatever pose the skeleton
+    /// was in, so if there are any of those, this is that pose
+    Eigen::VectorXs pose;
+    std::vector<LinearMetric> metrics;
+  };
+
+  /// This returns the linear form of every metric on `skel`, building it (and
+  /// posing the skeleton, and then restoring it) only if we haven't seen
+  /// `skel` before, or it's moved since we last measured a metric that
+  /// depends on its pose
+  std::shared_ptr<const LinearMetrics> getLinearMetrics(
+      std::shared_ptr<dynamics::Skeleton> skel);
+
+  /// This evaluates metric `i` at `bodyScales`
+  s_t measureLinearMetric(
+      const LinearMetrics& linear, int i, const Eigen::VectorXs& bodyScales);
+
+  /// This returns the gradient of metric `i` wrt body scales, at `bodyScales`
+  Eigen::VectorXs getLinearMetricGradient(
+      const LinearMetrics& linear, int i, const Eigen::VectorXs& bodyScales);
+
+  /// This is measureVector(), at the given body scales
+  Eigen::VectorXs measureVector(
+      const LinearMetrics& linear, const Eigen::VectorXs& bodyScales);
+
+  void updateMetricDistIndices();
+
   std::vector<AnthroMetric> mMetrics;
   std::shared_ptr<math::MultivariateGaussian> mDist;
+  // For each metric, this is the index of its variable in mDist, or -1 if
+  // the distribution doesn't model it
+  std::vector<int> mMetricDistIndices;
+
+  // A fitter and its clones for each trial can share one prior, so this is
+  // keyed by skeleton and locked
+  std::mutex mLinearMetricsMutex;
+  std::map<const dynamics::Skeleton*, std::shared_ptr<LinearMetrics>>
+      mLinearMetrics;
 };
 
 } // namespace biomechanics
@@ -0,0 +1,227 @@
+#include "dart/biomechanics/BatchScaleQueries.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <future>
+
+#include "dart/common/Console.hpp"
+#include "dart/common/ThreadPool.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+//==============================================================================
+BatchScaleQueries::BatchScaleQueries(std::shared_ptr<dynamics::Skeleton> skel)
+  : mSkel(skel)
+{
+}
+
+//==============================================================================
+/// This computes Skeleton::getHeight() and its gradient wrt the body
+/// scales. `bodyScales` is B x (3 * numBodies), laid out like
+/// Skeleton::getBodyScales(). `poses` is either B x numDofs, or a single
+/// row used for every sample.
+BatchScaleQueryResult BatchScaleQueries::getHeights(
+    const Eigen::MatrixXs& bodyScales,
+    const Eigen::MatrixXs& poses,
+    Eigen::Vector3s up)
+{
+  const int numSamples = bodyScales.rows();
+  assert(bodyScales.cols() == mSkel->getNumBodyNodes() * 3);
+  assert(poses.cols() == mSkel->getNumDofs());
+  assert(poses.rows() == 1 || poses.rows() == numSamples);
+
+  BatchScaleQueryResult result;
+  result.values = Eigen::VectorXs::Zero(numSamples);
+  result.gradWrtBodyScales
+      = Eigen::MatrixXs::Zero(numSamples, bodyScales.cols());
+  forEachSample(
+      numSamples,
+      [&](const std::shared_ptr<dynamics::Skeleton>& skel, int i) {
+        Eigen::VectorXs pose = poses.row(poses.rows() == 1 ? 0 : i);
+        skel->setBodyScales(bodyScales.row(i).transpose());
+        result.values(i) = skel->getHeight(pose, up);
+        result.gradWrtBodyScales.row(i)
+            = skel->getGradientOfHeightWrtBodyScales(pose, up).transpose();
+      });
+  return result;
+}
+
+//==============================================================================
+/// This computes Skeleton::getLowestPoint(), and its gradients wrt the body
+/// scales and the joint positions. The inputs are the same as getHeights().
+BatchScaleQueryResult BatchScaleQueries::getLowestPoints(
+    const Eigen::MatrixXs& bodyScales,
+    const Eigen::MatrixXs& poses,
+    Eigen::Vector3s up)
+{
+  const int numSamples = bodyScales.rows();
+  assert(bodyScales.cols() == mSkel->getNumBodyNodes() * 3);
+  assert(poses.cols() == mSkel->getNumDofs());
+  assert(poses.rows() == 1 || poses.rows() == numSamples);
+
+  BatchScaleQueryResult result;
+  result.values = Eigen::VectorXs::Zero(numSamples);
+  result.gradWrtBodyScales
+      = Eigen::MatrixXs::Zero(numSamples, bodyScales.cols());
+  result.gradWrtPoses = Eigen::MatrixXs::Zero(numSamples, poses.cols());
+  forEachSample(
+      numSamples,
+      [&](const std::shared_ptr<dynamics::Skeleton>& skel, int i) {
+        skel->setPositions(poses.row(poses.rows() == 1 ? 0 : i).transpose());
+        skel->setBodyScales(bodyScales.row(i).transpose());
+        result.values(i) = skel->getLowestPoint(up);
+        result.gradWrtBodyScales.row(i)
+            = skel->getGradientOfLowestPointWrtBodyScales(up).transpose();
+        result.gradWrtPoses.row(i)
+            = skel->getGradientOfLowestPointWrtJoints(up).transpose();
+      });
+  return result;
+}
+
+//==============================================================================
+/// This computes Anthropometrics::getLogPDF(), and its gradient wrt the
+/// body scales. `bodyScales` is laid out like it is for getHeights().
+BatchScaleQueryResult BatchScaleQueries::getAnthropometricLogPDFs(
+    std::shared_ptr<Anthropometrics> anthro,
+    const Eigen::MatrixXs& bodyScales,
+    bool normalized)
+{
+  const int numSamples = bodyScales.rows();
+  assert(bodyScales.cols() == mSkel->getNumBodyNodes() * 3);
+
+  BatchScaleQueryResult result;
+  result.values = Eigen::VectorXs::Zero(numSamples);
+  result.gradWrtBodyScales
+      = Eigen::MatrixXs::Zero(numSamples, bodyScales.cols());
+  // Anthropometrics caches its linear metrics per skeleton, behind a mutex,
+  // so each clone builds its own cache once and then reuses it
+  forEachSample(
+      numSamples,
+      [&](const std::shared_ptr<dynamics::Skeleton>& skel, int i) {
+        skel->setBodyScales(bodyScales.row(i).transpose());
+        result.values(i) = anthro->getLogPDF(skel, normalized);
+        result.gradWrtBodyScales.row(i)
+            = anthro->getGradientOfLogPDFWrtBodyScales(skel).transpose();
+      });
+  return result;
+}
+
+//==============================================================================
+/// This computes BodyNode::getDistToClosestVerticesToMarker() for the body
+/// named `bodyName`, and its gradients wrt the marker offset and the body's
+/// scale. `markerOffsets` and `bodyScales` are both B x 3. Either one can
+/// instead be a single row used for every sample.
+BatchScaleQueryResult BatchScaleQueries::getMarkerDistsToNearestVertex(
+    const std::string& bodyName,
+    const Eigen::MatrixXs& markerOffsets,
+    const Eigen::MatrixXs& bodyScales)
+{
+  const int numSamples = std::max(markerOffsets.rows(), bodyScales.rows());
+  assert(markerOffsets.cols() == 3 && bodyScales.cols() == 3);
+  assert(markerOffsets.rows() == 1 || markerOffsets.rows() == numSamples);
+  assert(bodyScales.rows() == 1 || bodyScales.rows() == numSamples);
+
+  BatchScaleQueryResult result;
+  result.values = Eigen::VectorXs::Zero(numSamples);
+  result.gradWrtBodyScales = Eigen::MatrixXs::Zero(numSamples, 3);
+  result.gradWrtMarkers = Eigen::MatrixXs::Zero(numSamples, 3);
+  if (mSkel->getBodyNode(bodyName) == nullptr)
+  {
+    dterr << "BatchScaleQueries::getMarkerDistsToNearestVertex() couldn't "
+             "find a body named \""
+          << bodyName << "\". Returning zeros." << std::endl;
+    return result;
+  }
+  forEachSample(
+      numSamples,
+      [&](const std::shared_ptr<dynamics::Skeleton>& skel, int i) {
+        dynamics::BodyNode* body = skel->getBodyNode(bodyName);
+        Eigen::Vector3s marker
+            = markerOffsets.row(markerOffsets.rows() == 1 ? 0 : i).transpose();
+        body->setScale(
+            bodyScales.row(bodyScales.rows() == 1 ? 0 : i).transpose());
+        result.values(i) = body->getDistToClosestVerticesToMarker(marker);
+        result.gradWrtBodyScales.row(i)
+            = body->getGradientOfDistToClosestVerticesToMarkerWrtBodyScale(
+                      marker)
+                  .transpose();
+        result.gradWrtMarkers.row(i)
+            = body->getGradientOfDistToClosestVerticesToMarkerWrtMarker(marker)
+                  .transpose();
+      });
+  return result;
+}
+
+//==============================================================================
+/// This returns the skeleton passed to the constructor
+std::shared_ptr<dynamics::Skeleton> BatchScaleQueries::getSkeleton()
+{
+  return mSkel;
+}
+
+//==============================================================================
+/// This throws away the clones, so the next query clones the skeleton
+/// again
+void BatchScaleQueries::resetClones()
+{
+  mClones.clear();
+}
+
+//==============================================================================
+/// This calls `fn(clone, i)` for every sample `i` in [0, numSamples),
+/// spread across the global ThreadPool
+void BatchScaleQueries::forEachSample(
+    int numSamples,
+    std::function<void(const std::shared_ptr<dynamics::Skeleton>&, int)> fn)
+{
+  if (numSamples == 0)
+    return;
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  const int numChunks
+      = std::max(1, std::min(numSamples, (int)pool.getNumThreads()));
+  ensureClones(numChunks);
+
+  auto runChunk = [&](int c, int start, int end) {
+    for (int i = start; i < end; i++)
+    {
+      fn(mClones[c], i);
+    }
+  };
+
+  if (numChunks == 1)
+  {
+    runChunk(0, 0, numSamples);
+    return;
+  }
+
+  std::vector<std::future<void>> futures;
+  for (int c = 0; c < numChunks; c++)
+  {
+    int start = (numSamples * c) / numChunks;
+    int end = (numSamples * (c + 1)) / numChunks;
+    futures.push_back(pool.submit(runChunk, c, start, end));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+}
+
+//==============================================================================
+/// This makes sure we have at least `count` skeleton clones. Cloning reads
+/// from the original skeleton, so this happens on the calling thread rather
+/// than from inside the workers.
+void BatchScaleQueries::ensureClones(int count)
+{
+  while ((int)mClones.size() < count)
+  {
+    mClones.push_back(mSkel->cloneSkeleton());
+  }
+}
+
+} // namespace biomechanics
+} // namespace dart
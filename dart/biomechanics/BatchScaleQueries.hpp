@@ -0,0 +1,106 @@
+#ifndef DART_BIOMECHANICS_BATCH_SCALE_QUERIES_HPP_
+#define DART_BIOMECHANICS_BATCH_SCALE_QUERIES_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/biomechanics/Anthropometrics.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/// This is what every BatchScaleQueries query returns. Row `i` of each
+/// gradient belongs to sample `i`. Gradients a query doesn't produce are left
+/// empty.
+struct BatchScaleQueryResult
+{
+  /// The value of the query for each sample
+  Eigen::VectorXs values;
+  /// The gradient of each value wrt the body scales, laid out like the
+  /// `bodyScales` passed in
+  Eigen::MatrixXs gradWrtBodyScales;
+  /// The gradient of each value wrt the joint positions
+  Eigen::MatrixXs gradWrtPoses;
+  /// The gradient of each value wrt the marker offset
+  Eigen::MatrixXs gradWrtMarkers;
+};
+
+/// This evaluates the differentiable geometry queries on Skeleton and
+/// BodyNode (height, lowest point, marker distance to the nearest vertex, and
+/// the anthropometric log PDF) for a whole batch of body scales at once. Each
+/// row of the inputs is one sample. The samples get split across the global
+/// ThreadPool, and each worker sets the scales on its own clone of the
+/// skeleton, so the skeleton passed to the constructor is never touched.
+///
+/// The clones are taken the first time they're needed, and reused for every
+/// query after that. Call resetClones() after changing the original skeleton
+/// in ways other than its scales and positions.
+class BatchScaleQueries
+{
+public:
+  BatchScaleQueries(std::shared_ptr<dynamics::Skeleton> skel);
+
+  /// This computes Skeleton::getHeight() and its gradient wrt the body
+  /// scales. `bodyScales` is B x (3 * numBodies), laid out like
+  /// Skeleton::getBodyScales(). `poses` is either B x numDofs, or a single
+  /// row used for every sample.
+  BatchScaleQueryResult getHeights(
+      const Eigen::MatrixXs& bodyScales,
+      const Eigen::MatrixXs& poses,
+      Eigen::Vector3s up = Eigen::Vector3s::UnitY());
+
+  /// This computes Skeleton::getLowestPoint(), and its gradients wrt the body
+  /// scales and the joint positions. The inputs are the same as getHeights().
+  BatchScaleQueryResult getLowestPoints(
+      const Eigen::MatrixXs& bodyScales,
+      const Eigen::MatrixXs& poses,
+      Eigen::Vector3s up = Eigen::Vector3s::UnitY());
+
+  /// This computes Anthropometrics::getLogPDF(), and its gradient wrt the
+  /// body scales. `bodyScales` is laid out like it is for getHeights().
+  BatchScaleQueryResult getAnthropometricLogPDFs(
+      std::shared_ptr<Anthropometrics> anthro,
+      const Eigen::MatrixXs& bodyScales,
+      bool normalized = true);
+
+  /// This computes BodyNode::getDistToClosestVerticesToMarker() for the body
+  /// named `bodyName`, and its gradients wrt the marker offset and the body's
+  /// scale. `markerOffsets` and `bodyScales` are both B x 3. Either one can
+  /// instead be a single row used for every sample.
+  BatchScaleQueryResult getMarkerDistsToNearestVertex(
+      const std::string& bodyName,
+      const Eigen::MatrixXs& markerOffsets,
+      const Eigen::MatrixXs& bodyScales);
+
+  /// This returns the skeleton passed to the constructor
+  std::shared_ptr<dynamics::Skeleton> getSkeleton();
+
+  /// This throws away the clones, so the next query clones the skeleton
+  /// again
+  void resetClones();
+
+protected:
+  /// This calls `fn(clone, i)` for every sample `i` in [0, numSamples),
+  /// spread across the global ThreadPool
+  void forEachSample(
+      int numSamples,
+      std::function<void(const std::shared_ptr<dynamics::Skeleton>&, int)>
+          fn);
+
+  /// This makes sure we have at least `count` skeleton clones
+  void ensureClones(int count);
+
+  std::shared_ptr<dynamics::Skeleton> mSkel;
+  std::vector<std::shared_ptr<dynamics::Skeleton>> mClones;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -8,11 +8,108 @@
 #include "dart/biomechanics/C3DForcePlatforms.hpp"
 
 #include <ezc3d_all.h>
+#include <math.h>
+
+#include "dart/common/ThreadPool.hpp"
 
 namespace dart {
 
 namespace biomechanics {
 
+namespace {
+
+///
+/// \brief Cross each column of `a` with the matching column of `b`
+///
+Eigen::MatrixXs crossColumns(
+    const Eigen::MatrixXs& a, const Eigen::MatrixXs& b)
+{
+  Eigen::MatrixXs result(3, a.cols());
+  result.row(0)
+      = a.row(1).cwiseProduct(b.row(2)) - a.row(2).cwiseProduct(b.row(1));
+  result.row(1)
+      = a.row(2).cwiseProduct(b.row(0)) - a.row(0).cwiseProduct(b.row(2));
+  result.row(2)
+      = a.row(0).cwiseProduct(b.row(1)) - a.row(1).cwiseProduct(b.row(0));
+  return result;
+}
+
+///
+/// \brief Copy the columns of a 3xN matrix out into a vector of points
+///
+void toPoints(const Eigen::MatrixXs& mat, std::vector<Eigen::Vector3s>& out)
+{
+  out.resize(mat.cols());
+  for (int i = 0; i < mat.cols(); ++i)
+  {
+    out[i] = mat.col(i);
+  }
+}
+
+///
+/// \brief Low-pass filter `channels` and keep every `factor`-th sample,
+/// starting from the first one
+///
+/// This is a windowed-sinc FIR filter with its cutoff at the Nyquist rate of
+/// the output, evaluated in polyphase form: we only ever compute the outputs
+/// we keep, so the cost is one short dot product per kept sample rather than a
+/// full convolution at the analog rate. The filter is symmetric, so it adds no
+/// delay, and samples past either end are held at the first or last value.
+///
+Eigen::MatrixXs resampleChannels(
+    const Eigen::MatrixXs& channels, int factor, int numOutputs)
+{
+  const int numSamples = channels.cols();
+  Eigen::MatrixXs result = Eigen::MatrixXs::Zero(channels.rows(), numOutputs);
+  if (numSamples == 0)
+  {
+    return result;
+  }
+  if (factor <= 1)
+  {
+    int n = std::min(numSamples, numOutputs);
+    result.leftCols(n) = channels.leftCols(n);
+    return result;
+  }
+
+  // Four output periods on either side is plenty to keep aliasing well down,
+  // with a Blackman window to tame the sinc's ripples
+  const int halfWidth = 4 * factor;
+  Eigen::VectorXs taps(2 * halfWidth + 1);
+  for (int k = -halfWidth; k <= halfWidth; ++k)
+  {
+    s_t x = static_cast<s_t>(k) / factor;
+    s_t sinc = k == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+    s_t w = static_cast<s_t>(k) / (halfWidth + 1);
+    s_t window = 0.42 + 0.5 * cos(M_PI * w) + 0.08 * cos(2 * M_PI * w);
+    taps(k + halfWidth) = sinc * window;
+  }
+  // Unit gain at DC, so constant loads pass through unchanged
+  taps /= taps.sum();
+
+  for (int f = 0; f < numOutputs; ++f)
+  {
+    int center = f * factor;
+    int lo = center - halfWidth;
+    int hi = center + halfWidth;
+    if (lo >= 0 && hi < numSamples)
+    {
+      result.col(f) = channels.middleCols(lo, taps.size()) * taps;
+    }
+    else
+    {
+      for (int k = 0; k < taps.size(); ++k)
+      {
+        int sample = std::min(std::max(lo + k, 0), numSamples - 1);
+        result.col(f) += channels.col(sample) * taps(k);
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace
+
 const extern int FORCE_PLATFORM_NUM_CONVENTIONS = 2;
 
 ForcePlatform::ForcePlatform()
@@ -135,6 +232,26 @@ const std::vector<Eigen::Vector3s>& ForcePlatform::Tz() const
   return _Tz;
 }
 
+const std::vector<Eigen::Vector3s>& ForcePlatform::frameForces() const
+{
+  return _frameF;
+}
+
+const std::vector<Eigen::Vector3s>& ForcePlatform::frameMoments() const
+{
+  return _frameM;
+}
+
+const std::vector<Eigen::Vector3s>& ForcePlatform::frameCoP() const
+{
+  return _frameCoP;
+}
+
+const std::vector<Eigen::Vector3s>& ForcePlatform::frameTz() const
+{
+  return _frameTz;
+}
+
 void ForcePlatform::extractType(size_t idx, const ezc3d::c3d& c3d)
 {
   const ezc3d::ParametersNS::GroupNS::Group& groupFP(
@@ -203,9 +320,20 @@ ForcePlatforms::ForcePlatforms(const ezc3d::c3d& c3d, int convention)
                        .group("FORCE_PLATFORM")
                        .parameter("USED")
                        .valuesAsInt()[0]);
+  // Each platform only reads from `c3d`, so they can all be built at once
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<ForcePlatform>> futures;
   for (size_t i = 0; i < nbForcePF; ++i)
   {
-    _platforms.push_back(ForcePlatform(i, c3d, convention));
+    futures.push_back(pool.submit(
+        [&c3d, i, convention]() { return ForcePlatform(i, c3d, convention); }));
+  }
+  // Wait for every platform before get() can throw, since the tasks refer to
+  // `c3d`
+  pool.waitAll(futures);
+  for (std::future<ForcePlatform>& future : futures)
+  {
+    _platforms.push_back(future.get());
   }
 }
 
@@ -399,112 +527,125 @@ void ForcePlatform::extractDataWithConvention(
     channel_idx[i] = all_channel_idx[idx * dimensions[0] + i] - 1; // 1-based
   }
 
-  // Get the force and moment from these channel in global reference frame
+  // Copy every sample of this platform's channels into one matrix, so the
+  // conversion below can work on all of them at once
   size_t nFramesTotal(c3d.header().nbFrames() * c3d.header().nbAnalogByFrame());
-  _F.resize(nFramesTotal);
-  _M.resize(nFramesTotal);
-  _CoP.resize(nFramesTotal);
-  _Tz.resize(nFramesTotal);
+  Eigen::MatrixXs channels = Eigen::MatrixXs::Zero(nChannels, nFramesTotal);
   size_t cmp(0);
-  double* ch = new double[8];
   for (const auto& frame : c3d.data().frames())
   {
     for (size_t i = 0; i < frame.analogs().nbSubframes(); ++i)
     {
+      if (cmp >= nFramesTotal)
+      {
+        break;
+      }
       const auto& subframe(frame.analogs().subframe(i));
-      if (_type == 1)
+      for (size_t j = 0; j < nChannels; ++j)
+      {
+        channels(j, cmp) = subframe.channel(channel_idx[j]).data();
+      }
+      ++cmp;
+    }
+  }
+
+  // Get the force and moment from these channel in global reference frame
+  convertChannels(channels, convention, _F, _M, _CoP, _Tz);
+
+  // And again at the marker rate. We filter the raw channels rather than the
+  // results, since the CoP isn't linear in them.
+  Eigen::MatrixXs frameChannels = resampleChannels(
+      channels, c3d.header().nbAnalogByFrame(), c3d.header().nbFrames());
+  convertChannels(
+      frameChannels, convention, _frameF, _frameM, _frameCoP, _frameTz);
+}
+
+void ForcePlatform::convertChannels(
+    const Eigen::MatrixXs& channels,
+    int convention,
+    std::vector<Eigen::Vector3s>& F,
+    std::vector<Eigen::Vector3s>& M,
+    std::vector<Eigen::Vector3s>& CoP,
+    std::vector<Eigen::Vector3s>& Tz) const
+{
+  const int n = channels.cols();
+  if (_type == 1)
+  {
+    // CalMatrix (the example I have does not have any)
+    Eigen::MatrixXs cop_raw = Eigen::MatrixXs::Zero(3, n);
+    cop_raw.topRows(2) = channels.middleRows(3, 2);
+    Eigen::MatrixXs tz_raw = Eigen::MatrixXs::Zero(3, n);
+    tz_raw.row(2) = channels.row(5);
+
+    Eigen::MatrixXs forces = _refFrame * channels.topRows(3);
+    Eigen::MatrixXs cops = _refFrame * cop_raw;
+    Eigen::MatrixXs tzs = _refFrame * tz_raw;
+    Eigen::MatrixXs moments = crossColumns(forces, cops) - tzs;
+    cops.colwise() += _meanCorners;
+
+    toPoints(forces, F);
+    toPoints(moments, M);
+    toPoints(cops, CoP);
+    toPoints(tzs, Tz);
+  }
+  else if (_type == 2 || _type == 3 || _type == 4)
+  {
+    Eigen::MatrixXs force_raw(3, n);
+    Eigen::MatrixXs moment_raw(3, n);
+    if (_type == 3)
+    {
+      const Eigen::MatrixXs& ch = channels;
+      // CalMatrix (the example I have does not have any)
+
+      force_raw.row(0) = ch.row(0) + ch.row(1);
+      force_raw.row(1) = ch.row(2) + ch.row(3);
+      force_raw.row(2) = ch.row(4) + ch.row(5) + ch.row(6) + ch.row(7);
+
+      moment_raw.row(0)
+          = _origin(1) * (ch.row(4) + ch.row(5) - ch.row(6) - ch.row(7));
+      moment_raw.row(1)
+          = _origin(0) * (ch.row(5) + ch.row(6) - ch.row(4) - ch.row(7));
+      moment_raw.row(2) = _origin(1) * (ch.row(1) - ch.row(0))
+                          + _origin(0) * (ch.row(2) - ch.row(3));
+      moment_raw += crossColumns(
+          force_raw, Eigen::Vector3s(0, 0, _origin(2)).replicate(1, n));
+    }
+    else
+    {
+      Eigen::MatrixXs data_raw = channels.topRows(6);
+      if (_type == 4)
       {
-        Eigen::Vector3s force_raw = Eigen::Vector3s::Zero();
-        Eigen::Vector3s cop_raw = Eigen::Vector3s::Zero();
-        Eigen::Vector3s tz_raw = Eigen::Vector3s::Zero();
-        // CalMatrix (the example I have does not have any)
-
-        for (size_t j = 0; j < 3; ++j)
-        {
-          force_raw(j) = subframe.channel(channel_idx[j]).data();
-          if (j < 2)
-          {
-            cop_raw(j) = subframe.channel(channel_idx[j + 3]).data();
-          }
-          else
-          {
-            tz_raw(j) = subframe.channel(channel_idx[j + 3]).data();
-          }
-        }
-
-        _F[cmp] = _refFrame * force_raw;
-        _CoP[cmp] = _refFrame * cop_raw;
-        _Tz[cmp] = _refFrame * tz_raw;
-        _M[cmp] = _F[cmp].cross(_CoP[cmp]) - _Tz[cmp];
-        _CoP[cmp] += _meanCorners;
-
-        ++cmp;
+        data_raw = _calMatrix * data_raw;
       }
-      else if (_type == 2 || _type == 3 || _type == 4)
+      force_raw = data_raw.topRows(3);
+      moment_raw = data_raw.bottomRows(3);
+      if (convention == 1)
       {
-        Eigen::Vector3s force_raw = Eigen::Vector3s::Zero();
-        Eigen::Vector3s moment_raw = Eigen::Vector3s::Zero();
-        if (_type == 3)
-        {
-          for (size_t j = 0; j < 8; ++j)
-          {
-            ch[j] = subframe.channel(channel_idx[j]).data();
-          }
-          // CalMatrix (the example I have does not have any)
-
-          force_raw(0) = ch[0] + ch[1];
-          force_raw(1) = ch[2] + ch[3];
-          force_raw(2) = ch[4] + ch[5] + ch[6] + ch[7];
-
-          moment_raw(0) = _origin(1) * (ch[4] + ch[5] - ch[6] - ch[7]);
-          moment_raw(1) = _origin(0) * (ch[5] + ch[6] - ch[4] - ch[7]);
-          moment_raw(2)
-              = _origin(1) * (ch[1] - ch[0]) + _origin(0) * (ch[2] - ch[3]);
-          moment_raw += force_raw.cross(Eigen::Vector3s(0, 0, _origin(2)));
-        }
-        else
-        {
-          Eigen::Vector6s data_raw = Eigen::Vector6s::Zero();
-          for (size_t j = 0; j < 3; ++j)
-          {
-            data_raw(j) = subframe.channel(channel_idx[j]).data();
-            data_raw(j + 3) = subframe.channel(channel_idx[j + 3]).data();
-          }
-          if (_type == 4)
-          {
-            data_raw = _calMatrix * data_raw;
-          }
-          for (size_t j = 0; j < 3; ++j)
-          {
-            force_raw(j) = data_raw(j);
-            moment_raw(j) = data_raw(j + 3);
-          }
-          if (convention == 1)
-          {
-            moment_raw += force_raw.cross(_origin);
-          }
-        }
-        _F[cmp] = _refFrame * force_raw;
-        _M[cmp] = _refFrame * moment_raw;
-
-        Eigen::Vector3s CoP_raw = Eigen::Vector3s(
-            -moment_raw(1) / force_raw(2), moment_raw(0) / force_raw(2), 0);
-        Eigen::Vector3s originNoVertical = _origin;
-        originNoVertical(2) = 0.0;
-        if (convention == 0)
-        {
-          _CoP[cmp] = _refFrame * (CoP_raw + originNoVertical) + _meanCorners;
-        }
-        if (convention == 1)
-        {
-          _CoP[cmp] = _refFrame * CoP_raw + _meanCorners;
-        }
-        _Tz[cmp] = _refFrame * (moment_raw - force_raw.cross(-1 * CoP_raw));
-        ++cmp;
+        moment_raw += crossColumns(force_raw, _origin.replicate(1, n));
       }
     }
+    toPoints(_refFrame * force_raw, F);
+    toPoints(_refFrame * moment_raw, M);
+
+    Eigen::MatrixXs CoP_raw = Eigen::MatrixXs::Zero(3, n);
+    CoP_raw.row(0) = -moment_raw.row(1).cwiseQuotient(force_raw.row(2));
+    CoP_raw.row(1) = moment_raw.row(0).cwiseQuotient(force_raw.row(2));
+    Eigen::Vector3s originNoVertical = _origin;
+    originNoVertical(2) = 0.0;
+    Eigen::MatrixXs cops(3, n);
+    if (convention == 0)
+    {
+      cops = _refFrame * (CoP_raw.colwise() + originNoVertical);
+    }
+    if (convention == 1)
+    {
+      cops = _refFrame * CoP_raw;
+    }
+    cops.colwise() += _meanCorners;
+    toPoints(cops, CoP);
+    toPoints(
+        _refFrame * (moment_raw - crossColumns(force_raw, -1 * CoP_raw)), Tz);
   }
-  delete[] ch;
 }
 
 const std::vector<ForcePlatform>& ForcePlatforms::forcePlatforms() const
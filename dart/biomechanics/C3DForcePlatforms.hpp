@@ -100,6 +100,16 @@ protected:
   std::vector<Eigen::Vector3s>
       _Tz; ///< Moment [0, 0, Tz] vectors for all instants (including subframes)
            ///< expressed at the CoP
+  std::vector<Eigen::Vector3s>
+      _frameF; ///< Force vectors resampled to one per (marker) frame
+  std::vector<Eigen::Vector3s>
+      _frameM; ///< Moment vectors resampled to one per (marker) frame
+  std::vector<Eigen::Vector3s>
+      _frameCoP; ///< Center of Pressure vectors resampled to one per (marker)
+                 ///< frame
+  std::vector<Eigen::Vector3s>
+      _frameTz; ///< Moment [0, 0, Tz] vectors resampled to one per (marker)
+                ///< frame
 
 public:
   ///
@@ -166,6 +176,36 @@ public:
   ///
   const std::vector<Eigen::Vector3s>& Tz() const;
 
+  ///
+  /// \brief Returns the force vectors in the global reference frame, one per
+  /// (marker) frame. The analog channels are low-pass filtered and resampled
+  /// to the marker rate before converting, so these don't alias the way
+  /// picking one subframe out of forces() would.
+  /// \return The force vectors at the marker rate
+  ///
+  const std::vector<Eigen::Vector3s>& frameForces() const;
+
+  ///
+  /// \brief Returns the moment vectors in the global reference frame at
+  /// origin, one per (marker) frame. See frameForces().
+  /// \return The moment vectors at the marker rate
+  ///
+  const std::vector<Eigen::Vector3s>& frameMoments() const;
+
+  ///
+  /// \brief Returns the center of pressure in the global reference frame, one
+  /// per (marker) frame. See frameForces().
+  /// \return The center of pressure at the marker rate
+  ///
+  const std::vector<Eigen::Vector3s>& frameCoP() const;
+
+  ///
+  /// \brief Returns the moments in the global reference frame at center of
+  /// pressure, one per (marker) frame. See frameForces().
+  /// \return The moments at center of pressure at the marker rate
+  ///
+  const std::vector<Eigen::Vector3s>& frameTz() const;
+
 protected:
   ///
   /// \brief Extract the force platform's type from the parameters
@@ -207,6 +247,24 @@ protected:
   /// \param c3d A reference to the c3d
   ///
   void extractDataWithConvention(size_t idx, const ezc3d::c3d& c3d, int method);
+
+  ///
+  /// \brief Convert analog samples to forces, moments, CoP and Tz, all at once
+  /// \param channels The platform's channels, one row per channel and one
+  /// column per sample
+  /// \param convention The convention used to resolve the GRF data
+  /// \param F The force vectors in the global reference frame
+  /// \param M The moment vectors in the global reference frame at origin
+  /// \param CoP The centers of pressure in the global reference frame
+  /// \param Tz The moments in the global reference frame at the CoP
+  ///
+  void convertChannels(
+      const Eigen::MatrixXs& channels,
+      int convention,
+      std::vector<Eigen::Vector3s>& F,
+      std::vector<Eigen::Vector3s>& M,
+      std::vector<Eigen::Vector3s>& CoP,
+      std::vector<Eigen::Vector3s>& Tz) const;
 };
 
 ///
@@ -2,6 +2,7 @@
 
 #include <algorithm> // std::sort
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <random>
@@ -17,8 +18,10 @@
 #include "dart/biomechanics/C3DForcePlatforms.hpp"
 #include "dart/common/LocalResourceRetriever.hpp"
 #include "dart/common/ResourceRetriever.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/common/Uri.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/SpatialHash.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/utils/CompositeResourceRetriever.hpp"
 #include "dart/utils/DartResourceRetriever.hpp"
@@ -64,14 +67,14 @@ s_t C3D::getWeightedDistFromCoPToNearestMarker()
 
   for (ForcePlate& plate : forcePlates)
   {
-    for (int i = 0; i < markerTimesteps.size(); i++)
+    for (int i = 0; i < markerTrajectories.getNumFrames(); i++)
     {
       Eigen::Vector3s cop = plate.centersOfPressure[i];
 
       s_t minDist = std::numeric_limits<double>::infinity();
-      for (auto& pair : markerTimesteps[i])
+      for (const auto& observation : markerTrajectories.getFrame(i))
       {
-        s_t dist = (pair.second - cop).norm();
+        s_t dist = (observation.position - cop).norm();
         if (dist < minDist)
         {
           minDist = dist;
@@ -91,41 +94,97 @@ s_t C3D::getWeightedDistFromCoPToNearestMarker()
 }
 
 //==============================================================================
-C3D C3DLoader::loadC3D(const std::string& uri)
+/// This moves shuffledMarkersMatrix and shuffledMarkersMatrixMask over to
+/// single precision storage, which halves their memory, and frees the s_t
+/// copies. Use getShuffledMarkersMatrix() and
+/// getShuffledMarkersMatrixMask() to read them either way.
+void C3D::compactShuffledMarkers()
 {
-  C3D bestResult = loadC3DWithGRFConvention(uri, 0);
-  s_t bestResultRMS = bestResult.getWeightedDistFromCoPToNearestMarker();
-  for (int i = 1; i < biomechanics::FORCE_PLATFORM_NUM_CONVENTIONS; i++)
-  {
-    C3D competingConvention = loadC3DWithGRFConvention(uri, i);
-    s_t competingRMS
-        = competingConvention.getWeightedDistFromCoPToNearestMarker();
-    std::cout << "Tried force plate convention " << i << ". Best RMS "
-              << bestResultRMS << " vs this RMS " << competingRMS << std::endl;
-    if (competingRMS < bestResultRMS)
-    {
-      bestResult = competingConvention;
-      bestResultRMS = competingRMS;
-    }
+  if (shuffledMarkersMatrix.size() == 0
+      && shuffledMarkersMatrixMask.size() == 0)
+  {
+    // Already compacted (or never filled in)
+    return;
+  }
+  compactShuffledMarkersMatrix = math::CompactMatrix(shuffledMarkersMatrix);
+  compactShuffledMarkersMatrixMask
+      = math::CompactMatrix(shuffledMarkersMatrixMask);
+  shuffledMarkersMatrix.resize(0, 0);
+  shuffledMarkersMatrixMask.resize(0, 0);
+}
+
+//==============================================================================
+/// This returns shuffledMarkersMatrix, expanding it from single precision
+/// storage if compactShuffledMarkers() has been called
+Eigen::MatrixXs C3D::getShuffledMarkersMatrix() const
+{
+  if (shuffledMarkersMatrix.size() == 0)
+  {
+    return compactShuffledMarkersMatrix.toMatrix();
+  }
+  return shuffledMarkersMatrix;
+}
+
+//==============================================================================
+/// This returns shuffledMarkersMatrixMask, expanding it from single precision
+/// storage if compactShuffledMarkers() has been called
+Eigen::MatrixXs C3D::getShuffledMarkersMatrixMask() const
+{
+  if (shuffledMarkersMatrixMask.size() == 0)
+  {
+    return compactShuffledMarkersMatrixMask.toMatrix();
+  }
+  return shuffledMarkersMatrixMask;
+}
+
+//==============================================================================
+/// This loads a C3D file, and picks the GRF convention that puts the CoPs
+/// closest to the markers. The file is only parsed once, and frames are
+/// decoded in parallel blocks. `startFrame` and `numFrames` select a range of
+/// frames to keep (`numFrames = -1` keeps everything after `startFrame`). If
+/// `fixupFlips` is true, this runs the same correction as fixupMarkerFlips() on
+/// each block as soon as it's decoded, instead of making a second pass over
+/// the trial.
+C3D C3DLoader::loadC3D(
+    const std::string& uri, int startFrame, int numFrames, bool fixupFlips)
+{
+  std::vector<int> conventions;
+  for (int i = 0; i < biomechanics::FORCE_PLATFORM_NUM_CONVENTIONS; i++)
+  {
+    conventions.push_back(i);
   }
-  return bestResult;
+  return loadC3DWithGRFConventions(
+      uri, conventions, startFrame, numFrames, fixupFlips);
 }
 
 //==============================================================================
 C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
 {
-  C3D result;
-  const std::string path = getAbsolutePath(uri);
+  return loadC3DWithGRFConventions(uri, {convention}, 0, -1, false);
+}
 
+//==============================================================================
+/// This does the work for loadC3D() and loadC3DWithGRFConvention(). The force
+/// plates are read under each of the `conventions`, and the one with the
+/// lowest weighted CoP-to-marker distance is kept.
+C3D C3DLoader::loadC3DWithGRFConventions(
+    const std::string& uri,
+    const std::vector<int>& conventions,
+    int startFrame,
+    int numFrames,
+    bool fixupFlips)
+{
+  C3D result;
   std::string fullPath = getAbsolutePath(uri);
 
+  // This is the only time we read the file. Every convention below reads its
+  // force plates out of the same parsed data.
   ezc3d::c3d data(fullPath);
 
   double frameRate = data.header().frameRate();
   std::cout << "Framerate: " << frameRate << std::endl;
   result.framesPerSecond = frameRate;
-  int numFrames = data.header().nbFrames();
-  int analogFramesPerFrame = data.header().nbAnalogByFrame();
+  int numFileFrames = data.header().nbFrames();
 
   // Read the units that the mocap points are declared in
   double mocapDataScaleFactor = 1.0;
@@ -185,9 +244,16 @@ C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
     result.markers.push_back(fixed);
   }
 
-  // Load in the force platforms
-  ForcePlatforms pf(data, convention);
-  const std::vector<ForcePlatform>& forcePlatforms = pf.forcePlatforms();
+  // Load in the force platforms under every convention we're trying. These
+  // only read from `data`, so they can be built concurrently.
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<std::shared_ptr<ForcePlatforms>>> platformFutures;
+  for (int convention : conventions)
+  {
+    platformFutures.push_back(pool.submit([&data, convention]() {
+      return std::make_shared<ForcePlatforms>(data, convention);
+    }));
+  }
 
   // Force plate data
   const ezc3d::ParametersNS::GroupNS::Group& groupFP(
@@ -208,137 +274,255 @@ C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
   }
   std::cout << std::endl;
 
-  // Process all the force platforms
-  std::vector<double> forcePlateForceScaleFactors;
-  std::vector<double> forcePlateMomentScaleFactors;
-  std::vector<double> forcePlatePositionScaleFactors;
-  for (int j = 0; j < forcePlatforms.size(); j++)
+  // Process all the force platforms, under each convention
+  std::vector<std::shared_ptr<ForcePlatforms>> platforms;
+  std::vector<std::vector<ForcePlate>> conventionPlates(conventions.size());
+  std::vector<std::vector<double>> forceScaleFactors(conventions.size());
+  std::vector<std::vector<double>> momentScaleFactors(conventions.size());
+  std::vector<std::vector<double>> positionScaleFactors(conventions.size());
+  for (int c = 0; c < conventions.size(); c++)
   {
-    double forceScaleFactor = 1.0;
-    if (forcePlatforms[j].forceUnit() == "N")
-    {
-      forceScaleFactor = 1.0;
-    }
-    else if (forcePlatforms[j].forceUnit() == "mN")
-    {
-      forceScaleFactor = 0.001;
-    }
-    else if (forcePlatforms[j].forceUnit() == "cN")
+    pool.wait(platformFutures[c]);
+    platforms.push_back(platformFutures[c].get());
+    const std::vector<ForcePlatform>& forcePlatforms
+        = platforms[c]->forcePlatforms();
+    std::vector<ForcePlate>& plates = conventionPlates[c];
+    for (int j = 0; j < forcePlatforms.size(); j++)
     {
-      forceScaleFactor = 0.01;
-    }
-    forcePlateForceScaleFactors.push_back(forceScaleFactor);
+      double forceScaleFactor = 1.0;
+      if (forcePlatforms[j].forceUnit() == "N")
+      {
+        forceScaleFactor = 1.0;
+      }
+      else if (forcePlatforms[j].forceUnit() == "mN")
+      {
+        forceScaleFactor = 0.001;
+      }
+      else if (forcePlatforms[j].forceUnit() == "cN")
+      {
+        forceScaleFactor = 0.01;
+      }
+      forceScaleFactors[c].push_back(forceScaleFactor);
+
+      double momentScaleFactor = 1.0;
+      if (forcePlatforms[j].momentUnit() == "Nm")
+      {
+        momentScaleFactor = 1.0;
+      }
+      if (forcePlatforms[j].momentUnit() == "Nmm")
+      {
+        momentScaleFactor = 0.001;
+      }
+      if (forcePlatforms[j].momentUnit() == "Ncm")
+      {
+        momentScaleFactor = 0.01;
+      }
+      momentScaleFactors[c].push_back(momentScaleFactor);
+
+      if (c == 0)
+      {
+        std::cout << "forcePlatform forceUnit: "
+                  << forcePlatforms[j].forceUnit() << std::endl;
+        std::cout << "forcePlatform momentUnit: "
+                  << forcePlatforms[j].momentUnit() << std::endl;
+        std::cout << "forcePlatform positionUnit: "
+                  << forcePlatforms[j].positionUnit() << std::endl;
+        std::cout << "forcePlatform origin: "
+                  << forcePlatforms[j].origin().x() << ", "
+                  << forcePlatforms[j].origin().y() << ", "
+                  << forcePlatforms[j].origin().z() << std::endl;
+        std::cout << "forcePlatform mean corners: "
+                  << forcePlatforms[j].meanCorners().x() << ", "
+                  << forcePlatforms[j].meanCorners().y() << ", "
+                  << forcePlatforms[j].meanCorners().z() << std::endl;
+      }
+
+      double positionScaleFactor = 1.0;
+      if (forcePlatforms[j].positionUnit() == "mm")
+      {
+        positionScaleFactor = 0.001;
+      }
+      else if (forcePlatforms[j].positionUnit() == "cm")
+      {
+        positionScaleFactor = 0.01;
+      }
+      else if (forcePlatforms[j].positionUnit() == "ft")
+      {
+        positionScaleFactor = 0.3048;
+      }
+      else if (forcePlatforms[j].positionUnit() == "in")
+      {
+        positionScaleFactor = 0.0254;
+      }
+      else if (forcePlatforms[j].positionUnit() == "m")
+      {
+        positionScaleFactor = 1.0;
+      }
+      positionScaleFactors[c].push_back(positionScaleFactor);
+
+      plates.emplace_back();
+      ForcePlate& forcePlate = plates[j];
+      forcePlate.worldOrigin
+          = (forcePlatforms[j].meanCorners() + forcePlatforms[j].origin())
+            * positionScaleFactor;
+      for (const auto& corner : forcePlatforms[j].corners())
+      {
+        forcePlate.corners.push_back(Eigen::Vector3s(
+            corner.x() * positionScaleFactor,
+            corner.y() * positionScaleFactor,
+            corner.z() * positionScaleFactor));
+        // Corner 0 = +x +y
+        // Corner 1 = -x +y
+        // Corner 2 = -x -y
+        // Corner 3 = +x -y
+      }
 
-    double momentScaleFactor = 1.0;
-    if (forcePlatforms[j].momentUnit() == "Nm")
-    {
-      momentScaleFactor = 1.0;
-    }
-    if (forcePlatforms[j].momentUnit() == "Nmm")
-    {
-      momentScaleFactor = 0.001;
-    }
-    if (forcePlatforms[j].momentUnit() == "Ncm")
-    {
-      momentScaleFactor = 0.01;
-    }
-    forcePlateMomentScaleFactors.push_back(momentScaleFactor);
-
-    std::cout << "forcePlatform forceUnit: " << forcePlatforms[j].forceUnit()
-              << std::endl;
-    std::cout << "forcePlatform momentUnit: " << forcePlatforms[j].momentUnit()
-              << std::endl;
-    std::cout << "forcePlatform positionUnit: "
-              << forcePlatforms[j].positionUnit() << std::endl;
-    std::cout << "forcePlatform origin: " << forcePlatforms[j].origin().x()
-              << ", " << forcePlatforms[j].origin().y() << ", "
-              << forcePlatforms[j].origin().z() << std::endl;
-    std::cout << "forcePlatform mean corners: "
-              << forcePlatforms[j].meanCorners().x() << ", "
-              << forcePlatforms[j].meanCorners().y() << ", "
-              << forcePlatforms[j].meanCorners().z() << std::endl;
-
-    double positionScaleFactor = 1.0;
-    if (forcePlatforms[j].positionUnit() == "mm")
-    {
-      positionScaleFactor = 0.001;
-    }
-    else if (forcePlatforms[j].positionUnit() == "cm")
-    {
-      positionScaleFactor = 0.01;
-    }
-    else if (forcePlatforms[j].positionUnit() == "ft")
-    {
-      positionScaleFactor = 0.3048;
-    }
-    else if (forcePlatforms[j].positionUnit() == "in")
-    {
-      positionScaleFactor = 0.0254;
-    }
-    else if (forcePlatforms[j].positionUnit() == "m")
-    {
-      positionScaleFactor = 1.0;
     }
-    forcePlatePositionScaleFactors.push_back(positionScaleFactor);
-
-    result.forcePlates.emplace_back();
-    ForcePlate& forcePlate = result.forcePlates[j];
-    forcePlate.worldOrigin
-        = (forcePlatforms[j].meanCorners() + forcePlatforms[j].origin())
-          * positionScaleFactor;
-    for (const auto& corner : forcePlatforms[j].corners())
+  }
+
+  // The first two frames of the file are always skipped, and `startFrame` and
+  // `numFrames` are relative to what's left
+  const int skippedFrames = 2;
+  int availableFrames = std::max(numFileFrames - skippedFrames, 0);
+  startFrame = std::min(std::max(startFrame, 0), availableFrames);
+  if (numFrames < 0 || startFrame + numFrames > availableFrames)
+  {
+    numFrames = availableFrames - startFrame;
+  }
+  int firstFileFrame = skippedFrames + startFrame;
+
+  // Everything is sized up front, so each block below only ever writes to its
+  // own frames
+  result.markerTrajectories = MarkerTrajectories(result.markers, numFrames);
+  MarkerTrajectories& trajectories = result.markerTrajectories;
+  result.timestamps.resize(numFrames);
+  for (std::vector<ForcePlate>& plates : conventionPlates)
+  {
+    for (ForcePlate& plate : plates)
     {
-      forcePlate.corners.push_back(Eigen::Vector3s(
-          corner.x() * positionScaleFactor,
-          corner.y() * positionScaleFactor,
-          corner.z() * positionScaleFactor));
-      // Corner 0 = +x +y
-      // Corner 1 = -x +y
-      // Corner 2 = -x -y
-      // Corner 3 = +x -y
+      plate.forces.resize(numFrames);
+      plate.moments.resize(numFrames);
+      plate.centersOfPressure.resize(numFrames);
     }
   }
-
-  int startFrame = 2;
-  for (int t = 0; t < numFrames - startFrame; t++)
+  std::vector<int> markerColumns;
+  for (const std::string& name : result.markers)
   {
-    result.timestamps.push_back(t / frameRate);
+    markerColumns.push_back(trajectories.getMarkerIndex(name));
+  }
 
-    result.markerTimesteps.emplace_back();
-    std::map<std::string, Eigen::Vector3s>& map = result.markerTimesteps.at(t);
-    for (int i = 0; i < result.markers.size(); i++)
+  // Each block also accumulates its share of the weighted CoP-to-nearest-marker
+  // distance (see getWeightedDistFromCoPToNearestMarker()) for every
+  // convention, while its frames are still hot in cache. One row per block
+  // keeps the final sum in a fixed order.
+  const int blockSize = 256;
+  int numBlocks = (numFrames + blockSize - 1) / blockSize;
+  Eigen::MatrixXs copDist
+      = Eigen::MatrixXs::Zero(numBlocks, conventions.size());
+  Eigen::MatrixXs copWeight
+      = Eigen::MatrixXs::Zero(numBlocks, conventions.size());
+
+  auto decodeBlock = [&](int block) {
+    int blockEnd = std::min((block + 1) * blockSize, numFrames);
+    for (int t = block * blockSize; t < blockEnd; t++)
     {
-      const std::string& name = result.markers[i];
-      Eigen::Vector3s pt = Eigen::Vector3s(
-          data.data().frame(t + startFrame).points().point(i).x()
-              * mocapDataScaleFactor,
-          data.data().frame(t + startFrame).points().point(i).y()
-              * mocapDataScaleFactor,
-          data.data().frame(t + startFrame).points().point(i).z()
-              * mocapDataScaleFactor);
-      if (pt == Eigen::Vector3s::Zero() || pt.hasNaN())
+      int fileFrame = firstFileFrame + t;
+      result.timestamps[t] = (startFrame + t) / frameRate;
+
+      const auto& points = data.data().frame(fileFrame).points();
+      for (int i = 0; i < markerColumns.size(); i++)
       {
-        // Don't store points with all zeros, since those are "unobserved"
+        const auto& point = points.point(i);
+        Eigen::Vector3s pt = Eigen::Vector3s(
+            point.x() * mocapDataScaleFactor,
+            point.y() * mocapDataScaleFactor,
+            point.z() * mocapDataScaleFactor);
+        if (pt == Eigen::Vector3s::Zero() || pt.hasNaN())
+        {
+          // Don't store points with all zeros, since those are "unobserved"
+        }
+        else
+        {
+          trajectories.setPosition(t, markerColumns[i], pt);
+        }
       }
-      else
+
+      // The platforms have already filtered their analog data down to the
+      // marker rate, so this is one sample per frame
+      for (int c = 0; c < conventions.size(); c++)
       {
-        map[name] = pt;
+        const std::vector<ForcePlatform>& forcePlatforms
+            = platforms[c]->forcePlatforms();
+        for (int j = 0; j < forcePlatforms.size(); j++)
+        {
+          ForcePlate& plate = conventionPlates[c][j];
+          plate.forces[t] = forcePlatforms[j].frameForces()[fileFrame]
+                            * forceScaleFactors[c][j];
+          plate.moments[t] = forcePlatforms[j].frameTz()[fileFrame]
+                             * momentScaleFactors[c][j];
+          plate.centersOfPressure[t] = forcePlatforms[j].frameCoP()[fileFrame]
+                                       * positionScaleFactors[c][j];
+
+          s_t minDist = std::numeric_limits<double>::infinity();
+          for (const auto& observation : trajectories.getFrame(t))
+          {
+            s_t dist = (observation.position - plate.centersOfPressure[t])
+                           .norm();
+            if (dist < minDist)
+            {
+              minDist = dist;
+            }
+          }
+          if (isfinite(minDist))
+          {
+            s_t weight = plate.forces[t].norm();
+            copDist(block, c) += minDist * weight;
+            copWeight(block, c) += weight;
+          }
+        }
       }
     }
+  };
 
-    std::vector<Eigen::Vector9s> thisFrameGRFs;
-    for (int j = 0; j < forcePlatforms.size(); j++)
+  std::vector<std::future<void>> blockFutures;
+  for (int block = 0; block < numBlocks; block++)
+  {
+    blockFutures.push_back(pool.submit(decodeBlock, block));
+  }
+  std::vector<int> closestMarkerFromLastTimestep(trajectories.getNumMarkers());
+  for (int block = 0; block < numBlocks; block++)
+  {
+    pool.wait(blockFutures[block]);
+    blockFutures[block].get();
+    if (fixupFlips)
     {
-      int frame = analogFramesPerFrame * (t + startFrame);
-      result.forcePlates[j].forces.push_back(
-          forcePlatforms[j].forces()[frame] * forcePlateForceScaleFactors[j]);
-      result.forcePlates[j].moments.push_back(
-          forcePlatforms[j].Tz()[frame] * forcePlateMomentScaleFactors[j]);
-      result.forcePlates[j].centersOfPressure.push_back(
-          forcePlatforms[j].CoP()[frame] * forcePlatePositionScaleFactors[j]);
+      // Each frame is unflipped against the already-fixed frame before it, so
+      // this has to run in order, but it overlaps with decoding later blocks
+      fixupMarkerFlipsOnFrames(
+          trajectories,
+          std::max(block * blockSize, 1),
+          std::min((block + 1) * blockSize, numFrames),
+          closestMarkerFromLastTimestep);
     }
   }
 
+  // Keep the convention that puts the CoPs closest to the markers
+  int bestConvention = 0;
+  s_t bestResultRMS = copDist.col(0).sum() / copWeight.col(0).sum();
+  for (int c = 1; c < conventions.size(); c++)
+  {
+    s_t competingRMS = copDist.col(c).sum() / copWeight.col(c).sum();
+    std::cout << "Tried force plate convention " << conventions[c]
+              << ". Best RMS " << bestResultRMS << " vs this RMS "
+              << competingRMS << std::endl;
+    if (competingRMS < bestResultRMS)
+    {
+      bestConvention = c;
+      bestResultRMS = competingRMS;
+    }
+  }
+  result.forcePlates = std::move(conventionPlates[bestConvention]);
+
   result.dataRotation = Eigen::Matrix3s::Identity();
   // Automatically rotate the result so that the force plates are on the ground
   if (result.forcePlates.size() > 0
@@ -353,13 +537,13 @@ C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
     double groundLevel = result.forcePlates[0].corners[0].dot(up);
     // Flip the direction of "up" if the markers are showing up as below the
     // ground
-    if (result.markerTimesteps.size() > 0)
+    if (result.markerTrajectories.getNumFrames() > 0)
     {
       double sumDist = 0.0;
-      for (auto& pair : result.markerTimesteps[(int)std::round(
-               result.markerTimesteps.size() / 2)])
+      for (const auto& observation : result.markerTrajectories.getFrame(
+               (int)std::round(result.markerTrajectories.getNumFrames() / 2)))
       {
-        sumDist += pair.second.dot(up) - groundLevel;
+        sumDist += observation.position.dot(up) - groundLevel;
       }
       if (sumDist < 0)
       {
@@ -420,37 +604,32 @@ C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
         result.forcePlates[i].moments[t] = R * result.forcePlates[i].moments[t];
       }
     }
-    for (int t = 0; t < result.markerTimesteps.size(); t++)
-    {
-      for (auto& pair : result.markerTimesteps[t])
-      {
-        pair.second = R * pair.second;
-      }
-    }
+    result.markerTrajectories.rotate(R);
   }
 
   // These are useful for faster access to the pre-random-order marker data in
   // certain situations, for example in neural models
   result.shuffledMarkersMatrix = Eigen::MatrixXs::Zero(
-      result.markers.size() * 3, result.markerTimesteps.size());
+      result.markers.size() * 3, trajectories.getNumFrames());
   result.shuffledMarkersMatrixMask = Eigen::MatrixXs::Zero(
-      result.markers.size() * 3, result.markerTimesteps.size());
+      result.markers.size() * 3, trajectories.getNumFrames());
 
   std::vector<std::string> markerNames = result.markers;
   auto rng = std::default_random_engine();
 
-  for (int t = 0; t < result.markerTimesteps.size(); t++)
+  for (int t = 0; t < trajectories.getNumFrames(); t++)
   {
     int counter = 0;
 
     std::shuffle(std::begin(markerNames), std::end(markerNames), rng);
 
-    for (std::string name : markerNames)
+    for (const std::string& name : markerNames)
     {
-      if (result.markerTimesteps[t].count(name) > 0)
+      int index = trajectories.getMarkerIndex(name);
+      if (trajectories.isVisible(t, index))
       {
         result.shuffledMarkersMatrix.block(counter * 3, t, 3, 1)
-            = result.markerTimesteps[t][name];
+            = trajectories.getPosition(t, index);
         result.shuffledMarkersMatrixMask.block<3, 1>(counter * 3, t)
             .setConstant(1.0);
         counter++;
@@ -458,62 +637,285 @@ C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
     }
   }
 
+  // Keep the legacy per-frame maps around for callers that haven't moved over
+  // to the columnar store yet
+  result.markerTimesteps = trajectories.toFrameMaps();
+
   return result;
 }
 
-//==============================================================================
-/// This will check if markers
-/// obviously "flip" during the trajectory, and unflip them.
-void C3DLoader::fixupMarkerFlips(C3D* c3d)
+namespace {
+
+/// This is a copy of the (already fixed) frame that the next frame gets
+/// unflipped against
+struct FlipReferenceFrame
 {
-  for (int i = 1; i < c3d->markerTimesteps.size(); i++)
+  Eigen::Matrix<s_t, 3, Eigen::Dynamic> positions;
+  std::vector<unsigned char> visible;
+
+  void copyFrom(const MarkerTrajectories& trajectories, int frame)
   {
-    std::unordered_map<std::string, std::string> closestMarkerFromLastTimestep;
+    positions = trajectories.getFramePositions(frame);
+    visible.resize(trajectories.getNumMarkers());
+    for (int marker = 0; marker < visible.size(); marker++)
+    {
+      visible[marker] = trajectories.isVisible(frame, marker);
+    }
+  }
+};
 
-    for (std::string& marker : c3d->markers)
+/// This picks the grid size for finding flip candidates, which is the median
+/// distance a marker moves between frames in [startFrame, endFrame). Any
+/// positive size finds the same flips, this just keeps the searches small.
+s_t getFlipSearchCellSize(
+    const MarkerTrajectories& trajectories, int startFrame, int endFrame)
+{
+  std::vector<s_t> displacements;
+  int numMarkers = trajectories.getNumMarkers();
+  // A few thousand frames is plenty to get a typical step size
+  int stride = std::max(1, (endFrame - startFrame) / 2000);
+  for (int i = std::max(startFrame, 1); i < endFrame; i += stride)
+  {
+    for (int marker = 0; marker < numMarkers; marker++)
     {
-      closestMarkerFromLastTimestep[marker] = marker;
+      if (trajectories.isVisible(i, marker)
+          && trajectories.isVisible(i - 1, marker))
+      {
+        s_t dist = (trajectories.getPosition(i, marker)
+                    - trajectories.getPosition(i - 1, marker))
+                       .norm();
+        if (dist > 0 && std::isfinite(dist))
+        {
+          displacements.push_back(dist);
+        }
+      }
+    }
+  }
+  if (displacements.size() == 0)
+    return 1.0;
+  auto median = displacements.begin() + displacements.size() / 2;
+  std::nth_element(displacements.begin(), median, displacements.end());
+  return *median;
+}
+
+/// This unflips frame `i` against `last`, which must be the already fixed
+/// frame before it, and appends the pairs of markers it swapped to `swaps`
+/// (if it isn't null). `hash` is scratch space, and so are the vectors.
+void unflipFrame(
+    MarkerTrajectories& trajectories,
+    int i,
+    const FlipReferenceFrame& last,
+    math::SpatialHash& hash,
+    std::vector<int>& closestMarkerFromLastTimestep,
+    std::vector<int>& candidates,
+    std::vector<std::pair<int, int>>* swaps)
+{
+  int numMarkers = trajectories.getNumMarkers();
+  closestMarkerFromLastTimestep.resize(numMarkers);
+
+  hash.clear();
+  for (int marker = 0; marker < numMarkers; marker++)
+  {
+    if (last.visible[marker])
+    {
+      hash.insert(last.positions.col(marker), marker);
+    }
+  }
+
+  for (int marker = 0; marker < numMarkers; marker++)
+  {
+    closestMarkerFromLastTimestep[marker] = marker;
 
-      // If we see the marker on both timesteps, then evaluate which markers
-      // were the closest on last timestep to this marker
-      if (c3d->markerTimesteps[i].count(marker) > 0
-          && c3d->markerTimesteps[i - 1].count(marker) > 0)
+    // If we see the marker on both timesteps, then evaluate which markers
+    // were the closest on last timestep to this marker
+    if (trajectories.isVisible(i, marker) && last.visible[marker])
+    {
+      Eigen::Vector3s thisTimestep = trajectories.getPosition(i, marker);
+      s_t closestDist = (last.positions.col(marker) - thisTimestep).norm();
+      // Only markers that are closer than our own last position can win, and
+      // the hash finds all of those. Checking them in index order breaks ties
+      // the same way as scanning the whole frame would.
+      hash.findNeighborsWithin(thisTimestep, closestDist, candidates);
+      std::sort(candidates.begin(), candidates.end());
+      for (int other : candidates)
       {
-        Eigen::Vector3s thisTimestep = c3d->markerTimesteps[i].at(marker);
-        for (auto& pair : c3d->markerTimesteps[i - 1])
+        s_t dist = (last.positions.col(other) - thisTimestep).norm();
+        if (dist < closestDist)
         {
-          s_t dist = (pair.second - thisTimestep).norm();
-          if (dist < (c3d->markerTimesteps[i - 1].at(
-                          closestMarkerFromLastTimestep.at(marker))
-                      - thisTimestep)
-                         .norm())
-          {
-            closestMarkerFromLastTimestep[marker] = pair.first;
-          }
+          closestDist = dist;
+          closestMarkerFromLastTimestep[marker] = other;
         }
       }
     }
+  }
 
-    for (std::string& marker : c3d->markers)
+  for (int marker = 0; marker < numMarkers; marker++)
+  {
+    // If we weren't closest to ourselves, and instead we were closest to
+    // another marker AND IT WAS CLOSEST TO US, then we've detected a trivial
+    // flip, and we can flip back.
+    int otherMarker = closestMarkerFromLastTimestep[marker];
+    if (otherMarker != marker
+        && closestMarkerFromLastTimestep[otherMarker] == marker)
     {
-      // If we weren't closest to ourselves, and instead we were closest to
-      // another marker AND IT WAS CLOSEST TO US, then we've detected a trivial
-      // flip, and we can flip back.
-      if (closestMarkerFromLastTimestep[marker] != marker
-          && closestMarkerFromLastTimestep
-                     [closestMarkerFromLastTimestep[marker]]
-                 == marker)
+      trajectories.swapMarkers(i, marker, otherMarker);
+      closestMarkerFromLastTimestep[marker] = marker;
+      closestMarkerFromLastTimestep[otherMarker] = otherMarker;
+      if (swaps != nullptr)
+      {
+        swaps->emplace_back(marker, otherMarker);
+      }
+    }
+  }
+}
+
+} // namespace
+
+//==============================================================================
+/// This will check if markers
+/// obviously "flip" during the trajectory, and unflip them.
+///
+/// The trial is split into chunks of frames that are unflipped in parallel,
+/// each starting against the raw frame before it. Then, in order, each chunk
+/// redoes its first few frames against the fixed frame before it, until a
+/// frame comes out the same as it did the first time (after which the rest
+/// of the chunk must match too). This gives exactly the same result as
+/// unflipping every frame in order.
+void C3DLoader::fixupMarkerFlips(C3D* c3d)
+{
+  MarkerTrajectories& trajectories = c3d->markerTrajectories;
+  int numFrames = trajectories.getNumFrames();
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  // Keep the chunks long, so the frames we have to redo are a rounding error
+  const int minChunkFrames = 256;
+  int numChunks = std::min<int>(
+      pool.getNumThreads(), (numFrames - 1) / minChunkFrames);
+  if (numChunks < 2)
+  {
+    std::vector<int> closestMarkerFromLastTimestep(
+        trajectories.getNumMarkers());
+    fixupMarkerFlipsOnFrames(
+        trajectories, 1, numFrames, closestMarkerFromLastTimestep);
+    c3d->markerTimesteps = trajectories.toFrameMaps();
+    return;
+  }
+
+  s_t cellSize = getFlipSearchCellSize(trajectories, 1, numFrames);
+  int chunkSize = (numFrames - 1 + numChunks - 1) / numChunks;
+  std::vector<int> chunkStarts;
+  std::vector<int> chunkEnds;
+  for (int start = 1; start < numFrames; start += chunkSize)
+  {
+    chunkStarts.push_back(start);
+    chunkEnds.push_back(std::min(numFrames, start + chunkSize));
+  }
+
+  // Copy out the frame before each chunk now, before the chunk that owns it
+  // starts swapping its markers
+  std::vector<FlipReferenceFrame> chunkReferences(chunkStarts.size());
+  for (int k = 0; k < chunkStarts.size(); k++)
+  {
+    chunkReferences[k].copyFrom(trajectories, chunkStarts[k] - 1);
+  }
+
+  std::vector<std::vector<std::pair<int, int>>> swaps(numFrames);
+  std::vector<std::future<void>> futures;
+  for (int k = 0; k < chunkStarts.size(); k++)
+  {
+    futures.push_back(pool.submit([&, k]() {
+      math::SpatialHash hash(cellSize);
+      std::vector<int> closestMarkerFromLastTimestep;
+      std::vector<int> candidates;
+      FlipReferenceFrame& last = chunkReferences[k];
+      for (int i = chunkStarts[k]; i < chunkEnds[k]; i++)
       {
-        Eigen::Vector3s tmp = c3d->markerTimesteps[i][marker];
-        std::string otherMarker = closestMarkerFromLastTimestep[marker];
+        unflipFrame(
+            trajectories,
+            i,
+            last,
+            hash,
+            closestMarkerFromLastTimestep,
+            candidates,
+            &swaps[i]);
+        last.copyFrom(trajectories, i);
+      }
+    }));
+  }
+  // Wait for every chunk before get() can throw, since the tasks refer to
+  // locals on this stack
+  pool.waitAll(futures);
+  for (auto& future : futures)
+  {
+    future.get();
+  }
 
-        c3d->markerTimesteps[i][marker] = c3d->markerTimesteps[i][otherMarker];
-        c3d->markerTimesteps[i][otherMarker] = tmp;
-        closestMarkerFromLastTimestep[marker] = marker;
-        closestMarkerFromLastTimestep[otherMarker] = otherMarker;
+  // Reconcile the chunk boundaries, in order
+  math::SpatialHash hash(cellSize);
+  std::vector<int> closestMarkerFromLastTimestep;
+  std::vector<int> candidates;
+  std::vector<std::pair<int, int>> redoneSwaps;
+  FlipReferenceFrame last;
+  for (int k = 1; k < chunkStarts.size(); k++)
+  {
+    for (int i = chunkStarts[k]; i < chunkEnds[k]; i++)
+    {
+      // Put the raw frame back, undoing the swaps in reverse order
+      for (auto swap = swaps[i].rbegin(); swap != swaps[i].rend(); swap++)
+      {
+        trajectories.swapMarkers(i, swap->first, swap->second);
       }
+      last.copyFrom(trajectories, i - 1);
+      redoneSwaps.clear();
+      unflipFrame(
+          trajectories,
+          i,
+          last,
+          hash,
+          closestMarkerFromLastTimestep,
+          candidates,
+          &redoneSwaps);
+      bool unchanged = (redoneSwaps == swaps[i]);
+      swaps[i].swap(redoneSwaps);
+      if (unchanged)
+        break;
     }
   }
+
+  c3d->markerTimesteps = trajectories.toFrameMaps();
+}
+
+//==============================================================================
+/// This runs the flip correction from fixupMarkerFlips() over frames
+/// [startFrame, endFrame), comparing each frame to the one before it.
+/// `closestMarkerFromLastTimestep` is scratch space, so it can be reused
+/// across calls.
+void C3DLoader::fixupMarkerFlipsOnFrames(
+    MarkerTrajectories& trajectories,
+    int startFrame,
+    int endFrame,
+    std::vector<int>& closestMarkerFromLastTimestep)
+{
+  if (startFrame >= endFrame)
+    return;
+
+  math::SpatialHash hash(
+      getFlipSearchCellSize(trajectories, startFrame, endFrame));
+  std::vector<int> candidates;
+  FlipReferenceFrame last;
+  last.copyFrom(trajectories, startFrame - 1);
+  for (int i = startFrame; i < endFrame; i++)
+  {
+    unflipFrame(
+        trajectories,
+        i,
+        last,
+        hash,
+        closestMarkerFromLastTimestep,
+        candidates,
+        nullptr);
+    last.copyFrom(trajectories, i);
+  }
 }
 
 //==============================================================================
@@ -576,7 +978,7 @@ void C3DLoader::debugToGUI(
     {
       server->setObjectPosition(
           "marker_" + std::to_string(i),
-          file.markerTimesteps[timestep][file.markers[i]]);
+          file.markerTrajectories.getPosition(timestep, i));
     }
 
     for (int i = 0; i < file.forcePlates.size(); i++)
@@ -597,7 +999,7 @@ void C3DLoader::debugToGUI(
     }
 
     timestep++;
-    if (timestep >= file.markerTimesteps.size())
+    if (timestep >= file.markerTrajectories.getNumFrames())
     {
       timestep = 0;
     }
@@ -9,7 +9,9 @@
 #include <Eigen/Dense>
 
 #include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/biomechanics/MarkerTrajectories.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/CompactMatrix.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
 
 namespace dart {
@@ -22,11 +24,20 @@ struct C3D
   int framesPerSecond;
   std::vector<double> timestamps;
   std::vector<std::string> markers;
+  // This is the primary store for the marker data, indexed in the same order
+  // as `markers`
+  MarkerTrajectories markerTrajectories;
+  // This is a copy of `markerTrajectories` as one map per frame, which is kept
+  // for backwards compatibility
   std::vector<std::map<std::string, Eigen::Vector3s>> markerTimesteps;
   std::vector<ForcePlate> forcePlates;
   // These are useful for faster access to the marker data in certain situations
   Eigen::MatrixXs shuffledMarkersMatrix;
   Eigen::MatrixXs shuffledMarkersMatrixMask;
+  // These are single precision copies of the above, only filled in after
+  // compactShuffledMarkers()
+  math::CompactMatrix compactShuffledMarkersMatrix;
+  math::CompactMatrix compactShuffledMarkersMatrixMask;
   // This is the rotation applied to the loaded data, if any
   Eigen::Matrix3s dataRotation;
 
@@ -34,21 +45,74 @@ struct C3D
   /// that timestep. This is used as part of the heuristic to guess which
   /// convention a C3D file is using for storing its GRF data.
   s_t getWeightedDistFromCoPToNearestMarker();
+
+  /// This moves shuffledMarkersMatrix and shuffledMarkersMatrixMask over to
+  /// single precision storage, which halves their memory, and frees the s_t
+  /// copies. Use getShuffledMarkersMatrix() and
+  /// getShuffledMarkersMatrixMask() to read them either way.
+  void compactShuffledMarkers();
+
+  /// This returns shuffledMarkersMatrix, expanding it from single precision
+  /// storage if compactShuffledMarkers() has been called
+  Eigen::MatrixXs getShuffledMarkersMatrix() const;
+
+  /// This returns shuffledMarkersMatrixMask, expanding it from single
+  /// precision storage if compactShuffledMarkers() has been called
+  Eigen::MatrixXs getShuffledMarkersMatrixMask() const;
 };
 
 class C3DLoader
 {
 public:
-  static C3D loadC3D(const std::string& uri);
+  /// This loads a C3D file, and picks the GRF convention that puts the CoPs
+  /// closest to the markers. The file is only parsed once, and frames are
+  /// decoded in parallel blocks. `startFrame` and `numFrames` select a range
+  /// of frames to keep (`numFrames = -1` keeps everything after
+  /// `startFrame`). If `fixupFlips` is true, this runs the same correction as
+  /// fixupMarkerFlips() on each block as soon as it's decoded, instead of
+  /// making a second pass over the trial.
+  static C3D loadC3D(
+      const std::string& uri,
+      int startFrame = 0,
+      int numFrames = -1,
+      bool fixupFlips = false);
 
   static C3D loadC3DWithGRFConvention(const std::string& uri, int convention);
 
   /// This will check if markers
   /// obviously "flip" during the trajectory, and unflip them.
+  ///
+  /// The trial is split into chunks of frames that are unflipped in parallel,
+  /// each starting against the raw frame before it. Then, in order, each chunk
+  /// redoes its first few frames against the fixed frame before it, until a
+  /// frame comes out the same as it did the first time (after which the rest
+  /// of the chunk must match too). This gives exactly the same result as
+  /// unflipping every frame in order.
   static void fixupMarkerFlips(C3D* c3d);
 
   static void debugToGUI(
       C3D& file, std::shared_ptr<server::GUIWebsocketServer> server);
+
+protected:
+  /// This does the work for loadC3D() and loadC3DWithGRFConvention(). The
+  /// force plates are read under each of the `conventions`, and the one with
+  /// the lowest weighted CoP-to-marker distance is kept.
+  static C3D loadC3DWithGRFConventions(
+      const std::string& uri,
+      const std::vector<int>& conventions,
+      int startFrame,
+      int numFrames,
+      bool fixupFlips);
+
+  /// This runs the flip correction from fixupMarkerFlips() over frames
+  /// [startFrame, endFrame), comparing each frame to the one before it.
+  /// `closestMarkerFromLastTimestep` is scratch space, so it can be reused
+  /// across calls.
+  static void fixupMarkerFlipsOnFrames(
+      MarkerTrajectories& trajectories,
+      int startFrame,
+      int endFrame,
+      std::vector<int>& closestMarkerFromLastTimestep);
 };
 
 } // namespace biomechanics
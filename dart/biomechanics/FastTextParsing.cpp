@@ -0,0 +1,139 @@
+#include "dart/biomechanics/FastTextParsing.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace dart {
+
+namespace biomechanics {
+
+//==============================================================================
+/// This finds the next token in [cursor, end), where tokens are separated by
+/// spaces and tabs. On success, this sets `tokenStart` and `tokenEnd` to the
+/// bounds of the token, advances `cursor` past it, and returns true. This
+/// never allocates, so it can walk a whole file buffer in place.
+bool nextToken(
+    const char*& cursor,
+    const char* end,
+    const char*& tokenStart,
+    const char*& tokenEnd)
+{
+  while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+  {
+    cursor++;
+  }
+  if (cursor >= end)
+  {
+    return false;
+  }
+  tokenStart = cursor;
+  while (cursor < end && *cursor != ' ' && *cursor != '\t')
+  {
+    cursor++;
+  }
+  tokenEnd = cursor;
+  return true;
+}
+
+//==============================================================================
+/// This parses a number from [begin, end), with the same result as calling
+/// atof() on a copy of that token. Plain decimals that fit in a double
+/// mantissa (which covers nearly everything OpenSim and mocap exporters
+/// write) are converted directly, with correct rounding. Anything else falls
+/// back to strtod() on a copy of the token, so the buffer doesn't need a
+/// terminator at `end`.
+double parseDouble(const char* begin, const char* end)
+{
+  // Every power of ten up to 1e22 is exact in a double, so a mantissa below
+  // 2^53 times (or divided by) one of these is a single correctly rounded
+  // operation.
+  static const double powersOfTen[]
+      = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const std::uint64_t maxExactMantissa = (std::uint64_t)1 << 53;
+
+  const char* p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    p++;
+  }
+
+  std::uint64_t mantissa = 0;
+  int numDigits = 0;
+  int exponent = 0;
+  while (p < end && *p >= '0' && *p <= '9')
+  {
+    mantissa = mantissa * 10 + (*p - '0');
+    numDigits++;
+    p++;
+  }
+  if (p < end && *p == '.')
+  {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+      mantissa = mantissa * 10 + (*p - '0');
+      numDigits++;
+      exponent--;
+      p++;
+    }
+  }
+  bool fastPath = numDigits > 0 && numDigits <= 19;
+  if (fastPath && p < end && (*p == 'e' || *p == 'E'))
+  {
+    p++;
+    bool negativeExponent = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+      negativeExponent = (*p == '-');
+      p++;
+    }
+    int explicitExponent = 0;
+    int numExponentDigits = 0;
+    while (p < end && *p >= '0' && *p <= '9' && numExponentDigits < 4)
+    {
+      explicitExponent = explicitExponent * 10 + (*p - '0');
+      numExponentDigits++;
+      p++;
+    }
+    fastPath = numExponentDigits > 0;
+    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+  }
+
+  if (fastPath && p == end && mantissa <= maxExactMantissa && exponent >= -22
+      && exponent <= 22)
+  {
+    double value = (double)mantissa;
+    if (exponent < 0)
+    {
+      value /= powersOfTen[-exponent];
+    }
+    else
+    {
+      value *= powersOfTen[exponent];
+    }
+    return negative ? -value : value;
+  }
+
+  // Anything unusual (nan, inf, hex, long mantissas, trailing junk) goes
+  // through the C library. We copy the token first, because strtod() skips
+  // leading whitespace including newlines, and could otherwise read on into
+  // the next line.
+  char buffer[64];
+  std::size_t length = end - begin;
+  if (length < sizeof(buffer))
+  {
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    return std::strtod(buffer, nullptr);
+  }
+  std::string copy(begin, end);
+  return std::strtod(copy.c_str(), nullptr);
+}
+
+} // namespace biomechanics
+} // namespace dart
@@ -0,0 +1,31 @@
+#ifndef DART_BIOMECH_FAST_TEXT_PARSING_HPP_
+#define DART_BIOMECH_FAST_TEXT_PARSING_HPP_
+
+#include <string>
+
+namespace dart {
+
+namespace biomechanics {
+
+/// This finds the next token in [cursor, end), where tokens are separated by
+/// spaces and tabs. On success, this sets `tokenStart` and `tokenEnd` to the
+/// bounds of the token, advances `cursor` past it, and returns true. This
+/// never allocates, so it can walk a whole file buffer in place.
+bool nextToken(
+    const char*& cursor,
+    const char* end,
+    const char*& tokenStart,
+    const char*& tokenEnd);
+
+/// This parses a number from [begin, end), with the same result as calling
+/// atof() on a copy of that token. Plain decimals that fit in a double
+/// mantissa (which covers nearly everything OpenSim and mocap exporters
+/// write) are converted directly, with correct rounding. Anything else falls
+/// back to strtod() on a copy of the token, so the buffer doesn't need a
+/// terminator at `end`.
+double parseDouble(const char* begin, const char* end);
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
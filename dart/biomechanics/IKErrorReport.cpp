@@ -1,21 +1,64 @@
 #include "dart/biomechanics/IKErrorReport.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <ostream>
 #include <string>
 
+#include "dart/utils/CSVParser.hpp"
+
 namespace dart {
 namespace biomechanics {
 
+namespace {
+
+// Collect the names of all the observed markers on any timestep into a single
+// vector
+std::vector<std::string> getObservedMarkerNames(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>& observations)
+{
+  std::vector<std::string> markerNames;
+  for (int i = 0; i < observations.size(); i++)
+  {
+    for (auto& pair : observations[i])
+    {
+      if (std::find(markerNames.begin(), markerNames.end(), pair.first)
+          == markerNames.end())
+      {
+        markerNames.push_back(pair.first);
+      }
+    }
+  }
+  return markerNames;
+}
+
+} // namespace
+
 IKErrorReport::IKErrorReport(
     std::shared_ptr<dynamics::Skeleton> skel,
     dynamics::MarkerMap markers,
     Eigen::MatrixXs poses,
     std::vector<std::map<std::string, Eigen::Vector3s>> observations,
     std::shared_ptr<Anthropometrics> anthropometrics)
+  : IKErrorReport(
+      skel, markers, getObservedMarkerNames(observations), anthropometrics)
+{
+  addTimesteps(poses.leftCols(observations.size()), observations);
+}
+
+IKErrorReport::IKErrorReport(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    dynamics::MarkerMap markers,
+    std::vector<std::string> markerNames,
+    std::shared_ptr<Anthropometrics> anthropometrics)
   : averageRootMeanSquaredError(0.0),
     averageSumSquaredError(0.0),
-    averageMaxError(0.0)
+    averageMaxError(0.0),
+    markerNames(markerNames),
+    mSkel(skel),
+    mTotalRootMeanSquaredError(0.0),
+    mTotalSumSquaredError(0.0),
+    mTotalMaxError(0.0)
 {
   anthroPDF = 0.0;
   if (anthropometrics)
@@ -23,34 +66,32 @@ IKErrorReport::IKErrorReport(
     anthroPDF = anthropometrics->getLogPDF(skel);
   }
 
-  // Collect the names of all the observed markers on any timestep into a single
-  // vector
-  for (int i = 0; i < observations.size(); i++)
+  for (std::string& name : this->markerNames)
   {
-    for (auto& pair : observations[i])
-    {
-      if (std::find(markerNames.begin(), markerNames.end(), pair.first)
-          == markerNames.end())
-      {
-        markerNames.push_back(pair.first);
-      }
-    }
+    rmseMarkerErrors[name] = 0;
+    numMarkerObservations[name] = 0;
+    mSumSquaredMarkerErrors[name] = 0;
   }
 
-  Eigen::VectorXs originalPos = skel->getPositions();
-
-  for (std::string& name : markerNames)
+  for (auto& pair : markers)
   {
-    rmseMarkerErrors[name] = 0;
-    numMarkerObservations[name] = 0;
+    mMarkerMapIndices[pair.first] = mMarkerVector.size();
+    mMarkerMapNames.push_back(pair.first);
+    mMarkerVector.push_back(pair.second);
   }
+}
+
+void IKErrorReport::addTimesteps(
+    const Eigen::MatrixXs& poses,
+    const std::vector<std::map<std::string, Eigen::Vector3s>>& observations)
+{
+  // Run forward kinematics for every frame at once, which happens in parallel
+  // and leaves the skeleton's own pose alone
+  Eigen::MatrixXs allWorldMarkers = mSkel->getMarkerWorldPositionsBatch(
+      mMarkerVector, poses.leftCols(observations.size()));
 
   for (int i = 0; i < observations.size(); i++)
   {
-    skel->setPositions(poses.col(i));
-    std::map<std::string, Eigen::Vector3s> worldMarkers
-        = skel->getMarkerMapWorldPositions(markers);
-
     s_t thisTotalSquaredError = 0.0;
     s_t thisMaxError = 0.0;
     std::string worstMarker = "[NONE]";
@@ -64,25 +105,31 @@ IKErrorReport::IKErrorReport(
       markerErrorTableEntry[name] = 0.;
     }
 
-    for (auto pair : observations[i])
+    for (auto& pair : observations[i])
     {
-      std::string markerName = pair.first;
-      if (worldMarkers.count(markerName) > 0)
+      const std::string& markerName = pair.first;
+      auto index = mMarkerMapIndices.find(markerName);
+      if (index != mMarkerMapIndices.end())
       {
-        Eigen::Vector3s diff
-            = observations[i][markerName] - worldMarkers[markerName];
+        Eigen::Vector3s worldMarker
+            = allWorldMarkers.block<3, 1>(index->second * 3, i);
+        Eigen::Vector3s diff = pair.second - worldMarker;
         s_t squaredError = diff.squaredNorm();
-        markerErrorTableEntry[markerName] = sqrt(squaredError);
-        rmseMarkerErrors[markerName] += squaredError;
-        numMarkerObservations[markerName]++;
+        auto sum = mSumSquaredMarkerErrors.find(markerName);
+        if (sum != mSumSquaredMarkerErrors.end())
+        {
+          markerErrorTableEntry[markerName] = sqrt(squaredError);
+          sum->second += squaredError;
+          numMarkerObservations[markerName]++;
+        }
         thisTotalSquaredError += squaredError;
         thisMaxError = std::max(thisMaxError, diff.norm());
         if (diff.squaredNorm() > worstMarkerError.squaredNorm())
         {
           worstMarker = markerName;
           worstMarkerError = diff;
-          worstMarkerReal = observations[i][markerName];
-          worstMarkerPredicted = worldMarkers[markerName];
+          worstMarkerReal = pair.second;
+          worstMarkerPredicted = worldMarker;
         }
       }
     }
@@ -101,25 +148,34 @@ IKErrorReport::IKErrorReport(
     if (std::isfinite(thisRootMeanSquaredError)
         && std::isfinite(thisTotalSquaredError) && std::isfinite(thisMaxError))
     {
-      this->averageRootMeanSquaredError += thisRootMeanSquaredError;
-      this->averageSumSquaredError += thisTotalSquaredError;
-      this->averageMaxError += thisMaxError;
+      mTotalRootMeanSquaredError += thisRootMeanSquaredError;
+      mTotalSumSquaredError += thisTotalSquaredError;
+      mTotalMaxError += thisMaxError;
+    }
+
+    if (mCSVStream)
+    {
+      writeCSVRow(*mCSVStream, markerErrorTimesteps.size() - 1);
     }
   }
-  this->averageRootMeanSquaredError /= observations.size();
-  this->averageSumSquaredError /= observations.size();
-  this->averageMaxError /= observations.size();
+
+  int numTimesteps = markerErrorTimesteps.size();
+  if (numTimesteps > 0)
+  {
+    this->averageRootMeanSquaredError
+        = mTotalRootMeanSquaredError / numTimesteps;
+    this->averageSumSquaredError = mTotalSumSquaredError / numTimesteps;
+    this->averageMaxError = mTotalMaxError / numTimesteps;
+  }
 
   for (std::string& name : markerNames)
   {
     if (numMarkerObservations[name] > 0)
     {
-      rmseMarkerErrors[name] /= numMarkerObservations[name];
-      rmseMarkerErrors[name] = sqrt(rmseMarkerErrors[name]);
+      rmseMarkerErrors[name]
+          = sqrt(mSumSquaredMarkerErrors[name] / numMarkerObservations[name]);
     }
   }
-
-  skel->setPositions(originalPos);
 }
 
 void IKErrorReport::printReport(int limitTimesteps)
@@ -161,36 +217,81 @@ void IKErrorReport::printReport(int limitTimesteps)
 
 void IKErrorReport::saveCSVMarkerErrorReport(const std::string& path)
 {
-  std::ofstream errorCSV;
-  errorCSV.open(path);
+  utils::CSVParser::CSVWriter errorCSV(path);
 
-  errorCSV << "Timestep";
+  errorCSV.writeField("Timestep");
   for (std::string& markerName : markerNames)
   {
-    errorCSV << "," << markerName;
+    errorCSV.writeField(markerName);
   }
-  errorCSV << std::endl;
+  errorCSV.endRow();
 
-  errorCSV << "All Timesteps RMSE";
+  errorCSV.writeField("All Timesteps RMSE");
   for (std::string& markerName : markerNames)
   {
-    errorCSV << "," << rmseMarkerErrors.at(markerName);
+    errorCSV.writeField(rmseMarkerErrors.at(markerName));
   }
-  errorCSV << std::endl;
+  errorCSV.endRow();
 
   for (int i = 0; i < markerErrorTimesteps.size(); i++)
   {
-    errorCSV << i;
+    const std::map<std::string, s_t>& row = markerErrorTimesteps.at(i);
+    errorCSV.writeField(i);
     for (std::string& markerName : markerNames)
     {
-      errorCSV << "," << markerErrorTimesteps.at(i).at(markerName);
+      errorCSV.writeField(row.at(markerName));
     }
-    errorCSV << std::endl;
+    errorCSV.endRow();
   }
 
   errorCSV.close();
 }
 
+void IKErrorReport::startStreamingCSVMarkerErrorReport(const std::string& path)
+{
+  mCSVStream = std::make_shared<std::ofstream>(path);
+
+  *mCSVStream << "Timestep";
+  for (std::string& markerName : markerNames)
+  {
+    *mCSVStream << "," << markerName;
+  }
+  *mCSVStream << "\n";
+
+  for (int i = 0; i < markerErrorTimesteps.size(); i++)
+  {
+    writeCSVRow(*mCSVStream, i);
+  }
+}
+
+void IKErrorReport::finishStreamingCSVMarkerErrorReport()
+{
+  if (!mCSVStream)
+    return;
+
+  *mCSVStream << "All Timesteps RMSE";
+  for (std::string& markerName : markerNames)
+  {
+    *mCSVStream << "," << rmseMarkerErrors.at(markerName);
+  }
+  *mCSVStream << std::endl;
+
+  mCSVStream->close();
+  mCSVStream = nullptr;
+}
+
+void IKErrorReport::writeCSVRow(std::ostream& out, int timestep)
+{
+  const std::map<std::string, s_t>& row = markerErrorTimesteps.at(timestep);
+  out << timestep;
+  for (std::string& markerName : markerNames)
+  {
+    out << "," << row.at(markerName);
+  }
+  // Don't flush on every row, since long trials stream a lot of them
+  out << "\n";
+}
+
 std::vector<std::pair<std::string, s_t>> IKErrorReport::getSortedMarkerRMSE()
 {
   std::vector<std::pair<std::string, s_t>> sortedRMSE;
@@ -1,9 +1,11 @@
 #ifndef DART_BIOMECH_IK_ERRORS_HPP_
 #define DART_BIOMECH_IK_ERRORS_HPP_
 
+#include <fstream>
 #include <memory>
 // #include <unordered_map>
 #include <map>
+#include <string>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -30,10 +32,36 @@ public:
       std::vector<std::map<std::string, Eigen::Vector3s>> observations,
       std::shared_ptr<Anthropometrics> anthropometrics = nullptr);
 
+  /// This creates an empty report over `markerNames`, which can be fed poses
+  /// as they come out of IK with addTimesteps(). All the summary statistics
+  /// are kept up to date after every call to addTimesteps().
+  IKErrorReport(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      dynamics::MarkerMap markers,
+      std::vector<std::string> markerNames,
+      std::shared_ptr<Anthropometrics> anthropometrics = nullptr);
+
+  /// This runs FK for every column of `poses` in one batch, and appends the
+  /// errors against `observations` (one per column) to the report. If a CSV
+  /// stream is open, the new rows are written to it right away.
+  void addTimesteps(
+      const Eigen::MatrixXs& poses,
+      const std::vector<std::map<std::string, Eigen::Vector3s>>& observations);
+
   void printReport(int limitTimesteps = -1);
 
   void saveCSVMarkerErrorReport(const std::string& path);
 
+  /// This opens a CSV file at `path`, and writes the header and every
+  /// timestep we've seen so far. From then on, addTimesteps() writes each new
+  /// timestep as a row as soon as it's computed.
+  void startStreamingCSVMarkerErrorReport(const std::string& path);
+
+  /// This writes the "All Timesteps RMSE" row and closes the CSV stream. The
+  /// RMSE row comes last in streamed files, since it isn't known until all
+  /// the timesteps are in.
+  void finishStreamingCSVMarkerErrorReport();
+
   std::vector<std::pair<std::string, s_t>> getSortedMarkerRMSE();
 
   std::vector<std::string> worstMarkers;
@@ -51,6 +79,19 @@ public:
   std::map<std::string, int> numMarkerObservations;
   std::map<std::string, s_t> rmseMarkerErrors;
   std::vector<std::map<std::string, s_t>> markerErrorTimesteps;
+
+protected:
+  void writeCSVRow(std::ostream& out, int timestep);
+
+  std::shared_ptr<dynamics::Skeleton> mSkel;
+  std::vector<std::string> mMarkerMapNames;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> mMarkerVector;
+  std::map<std::string, int> mMarkerMapIndices;
+  std::map<std::string, s_t> mSumSquaredMarkerErrors;
+  s_t mTotalRootMeanSquaredError;
+  s_t mTotalSumSquaredError;
+  s_t mTotalMaxError;
+  std::shared_ptr<std::ofstream> mCSVStream;
 };
 
 } // namespace biomechanics
@@ -3,6 +3,7 @@
 #include <assimp/scene.h>
 #include <math.h>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/MeshShape.hpp"
 #include "dart/dynamics/Shape.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -13,6 +14,21 @@ using namespace dynamics;
 
 namespace biomechanics {
 
+namespace {
+
+/// This mixes a pair of tile coordinates into a well-spread hash
+std::uint64_t hashTile(int x, int y)
+{
+  std::uint64_t key = static_cast<std::uint32_t>(x);
+  key = (key << 32) | static_cast<std::uint32_t>(y);
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return key;
+}
+
+} // namespace
+
 LilypadCell::LilypadCell()
   : groundLowerBound(std::numeric_limits<s_t>::infinity()),
     groundUpperBound(-std::numeric_limits<s_t>::infinity())
@@ -31,7 +47,8 @@ LilypadSolver::LilypadSolver(
     mLateralVelThreshold(0.2),
     mVerticalAccelerationThreshold(0.0),
     mBottomThresholdPercentage(0.1),
-    mTileSize(tileSize)
+    mTileSize(tileSize),
+    mPendingStartTime(0)
 {
   Eigen::Vector3s up = Eigen::Vector3s::UnitZ();
   mXNormal = groundNormal.cross(up);
@@ -79,102 +96,198 @@ std::vector<const dynamics::BodyNode*> LilypadSolver::getContactBodies()
 /// This will attempt to find the lilypads in the pose data
 void LilypadSolver::process(Eigen::MatrixXs poses, int startTime)
 {
-  Eigen::VectorXs originalPos = mSkeleton->getPositions();
-  Eigen::VectorXs originalVel = mSkeleton->getVelocities();
-  Eigen::VectorXs originalControlForces = mSkeleton->getControlForces();
+  // The kinematics are the expensive part, and don't depend on the cells, so
+  // we do them for every frame at once. Then we fill in the cells in time
+  // order, so the results are exactly what the frame-by-frame loop gave.
+  std::vector<std::vector<dynamics::BodyNode::MovingVertex>> allVerts
+      = computeMovingVertices(poses, startTime);
+  for (const std::vector<dynamics::BodyNode::MovingVertex>& movingVerts :
+       allVerts)
+  {
+    addBodyVertices(movingVerts);
+  }
+};
+
+/// This is for streaming use. Each call appends `newPoses` to the frames
+/// we've already been given (since construction, or the last clear()), and
+/// processes every frame that now has the two following frames it needs to
+/// estimate velocity and acceleration. Feeding a trial through here in
+/// pieces gives the same cells as a single call to process().
+void LilypadSolver::processAppendedFrames(Eigen::MatrixXs newPoses)
+{
+  if (newPoses.cols() == 0)
+    return;
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(
+      newPoses.rows(), mPendingPoses.cols() + newPoses.cols());
+  if (mPendingPoses.cols() > 0)
+    poses.leftCols(mPendingPoses.cols()) = mPendingPoses;
+  poses.rightCols(newPoses.cols()) = newPoses;
+
+  process(poses, mPendingStartTime);
+
+  // Everything but the last two frames has now been processed
+  int numProcessed = std::max(0, (int)poses.cols() - 2);
+  mPendingPoses = poses.rightCols(poses.cols() - numProcessed);
+  mPendingStartTime += numProcessed;
+}
 
-  // s_t squaredVelThreshold = mVelThreshold * mVelThreshold;
+/// This returns how many cells have been touched so far
+int LilypadSolver::getNumCells() const
+{
+  return mCells.size();
+}
 
-  // Collect fast and slow vertices
-  for (int i = 0; i < poses.cols() - 2; i++)
+/// This computes the world space vertices of every contact body at every
+/// frame `i` with `i + 2 < poses.cols()`, laid out as [i * mBodies.size() +
+/// bodyIndex]. This runs in parallel on clones of the skeleton, so it
+/// doesn't change mSkeleton's state.
+std::vector<std::vector<dynamics::BodyNode::MovingVertex>>
+LilypadSolver::computeMovingVertices(
+    const Eigen::MatrixXs& poses, int startTime)
+{
+  const int numFrames = std::max(0, (int)poses.cols() - 2);
+  const int numBodies = mBodies.size();
+  std::vector<std::vector<dynamics::BodyNode::MovingVertex>> allVerts(
+      numFrames * numBodies);
+  if (numFrames == 0)
+    return allVerts;
+
+  std::vector<int> bodyIndices;
+  for (const dynamics::BodyNode* body : mBodies)
   {
-    Eigen::VectorXs vel
-        = mSkeleton->getPositionDifferences(poses.col(i + 1), poses.col(i))
-          / mSkeleton->getTimeStep();
-    Eigen::VectorXs vel2
-        = mSkeleton->getPositionDifferences(poses.col(i + 2), poses.col(i + 1))
-          / mSkeleton->getTimeStep();
-    Eigen::VectorXs accel = mSkeleton->getVelocityDifferences(vel2, vel)
-                            / mSkeleton->getTimeStep();
-    mSkeleton->setPositions(poses.col(i));
-    mSkeleton->setVelocities(vel);
-    mSkeleton->setAccelerations(accel);
-    for (const dynamics::BodyNode* body : mBodies)
-    {
-      std::vector<dynamics::BodyNode::MovingVertex> movingVerts
-          = body->getMovingVerticesInWorldSpace(startTime + i);
+    bodyIndices.push_back(body->getIndexInSkeleton());
+  }
 
-      s_t top = -std::numeric_limits<s_t>::infinity();
-      s_t bottom = std::numeric_limits<s_t>::infinity();
-      for (dynamics::BodyNode::MovingVertex& vert : movingVerts)
-      {
-        s_t height = vert.pos.dot(mGroundNormal);
-        if (height > top)
-          top = height;
-        if (height < bottom)
-          bottom = height;
-      }
-      s_t bodyHeight = top - bottom;
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  const int numChunks
+      = std::max(1, std::min(numFrames, (int)pool.getNumThreads()));
 
-      for (dynamics::BodyNode::MovingVertex& vert : movingVerts)
+  // Cloning reads from the original skeleton, so we do it all up front on
+  // this thread rather than from inside the workers
+  std::vector<std::shared_ptr<dynamics::Skeleton>> clones;
+  for (int c = 0; c < numChunks; c++)
+  {
+    clones.push_back(mSkeleton->cloneSkeleton());
+  }
+
+  auto runChunk = [&](dynamics::Skeleton* clone, int start, int end) {
+    const s_t dt = clone->getTimeStep();
+    for (int i = start; i < end; i++)
+    {
+      Eigen::VectorXs vel
+          = clone->getPositionDifferences(poses.col(i + 1), poses.col(i)) / dt;
+      Eigen::VectorXs vel2
+          = clone->getPositionDifferences(poses.col(i + 2), poses.col(i + 1))
+            / dt;
+      Eigen::VectorXs accel = clone->getVelocityDifferences(vel2, vel) / dt;
+      clone->setPositions(poses.col(i));
+      clone->setVelocities(vel);
+      clone->setAccelerations(accel);
+      for (int b = 0; b < numBodies; b++)
       {
-        s_t height = vert.pos.dot(mGroundNormal);
-        s_t heightPercentage = (height - bottom) / bodyHeight;
-        if (heightPercentage > mBottomThresholdPercentage)
-          continue;
-
-        LilypadCell& cell = getCell(vert.pos);
-
-        s_t verticalVel = vert.vel.dot(mGroundNormal);
-        Eigen::Vector3s lateralVelVector
-            = vert.vel - mGroundNormal * verticalVel;
-        s_t lateralVel = lateralVelVector.norm();
-        s_t verticalAccel = vert.accel.dot(mGroundNormal);
-        if ((verticalVel > 0 && verticalVel > mVerticalVelThreshold)
-            || (verticalVel < 0 && -verticalVel > mVerticalVelThreshold)
-            || lateralVel > mLateralVelThreshold
-            || verticalAccel < mVerticalAccelerationThreshold)
+        std::vector<dynamics::BodyNode::MovingVertex>& verts
+            = allVerts[i * numBodies + b];
+        verts = clone->getBodyNode(bodyIndices[b])
+                    ->getMovingVerticesInWorldSpace(startTime + i);
+        // Point back at the caller's bodies, not our clone's
+        for (dynamics::BodyNode::MovingVertex& vert : verts)
         {
-          cell.mFastVerts.push_back(vert);
-          /*
-          // If we're moving fast, and we're below what we thought the ground
-          // level was, then we've obviously made a mistake and the ground isn't
-          // where we thought it was
-          if (height < cell.groundLowerBound)
-          {
-            cell.groundLowerBound = std::numeric_limits<s_t>::infinity();
-            cell.groundUpperBound = -std::numeric_limits<s_t>::infinity();
-          }
-          */
-        }
-        else
-        {
-          cell.mSlowVerts.push_back(vert);
-          if (cell.groundLowerBound > height)
-          {
-            cell.groundLowerBound = height;
-          }
-          // (height + bodyHeight) is an upper bound on groundUpperBound
-          if (cell.groundUpperBound > height + bodyHeight)
-          {
-            cell.groundUpperBound = height + bodyHeight;
-          }
-
-          if (cell.groundUpperBound < height)
-          {
-            cell.groundUpperBound = height;
-          }
+          vert.bodyNode = mBodies[b];
         }
       }
     }
+  };
+
+  if (numChunks == 1)
+  {
+    runChunk(clones[0].get(), 0, numFrames);
+    return allVerts;
   }
 
-  // For each slow vertex, check if it's a lower bound on its neighbors
+  std::vector<std::future<void>> futures;
+  for (int c = 0; c < numChunks; c++)
+  {
+    int start = (numFrames * c) / numChunks;
+    int end = (numFrames * (c + 1)) / numChunks;
+    futures.push_back(pool.submit(runChunk, clones[c].get(), start, end));
+  }
+  // Wait for every chunk before get() can throw, since the chunks refer to
+  // locals on this stack
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+  return allVerts;
+}
 
-  mSkeleton->setPositions(originalPos);
-  mSkeleton->setVelocities(originalVel);
-  mSkeleton->setControlForces(originalControlForces);
-};
+/// This sorts the vertices of one body at one frame into fast and slow
+/// vertices, and updates the ground bounds of the cells they land in
+void LilypadSolver::addBodyVertices(
+    const std::vector<dynamics::BodyNode::MovingVertex>& movingVerts)
+{
+  s_t top = -std::numeric_limits<s_t>::infinity();
+  s_t bottom = std::numeric_limits<s_t>::infinity();
+  for (const dynamics::BodyNode::MovingVertex& vert : movingVerts)
+  {
+    s_t height = vert.pos.dot(mGroundNormal);
+    if (height > top)
+      top = height;
+    if (height < bottom)
+      bottom = height;
+  }
+  s_t bodyHeight = top - bottom;
+
+  for (const dynamics::BodyNode::MovingVertex& vert : movingVerts)
+  {
+    s_t height = vert.pos.dot(mGroundNormal);
+    s_t heightPercentage = (height - bottom) / bodyHeight;
+    if (heightPercentage > mBottomThresholdPercentage)
+      continue;
+
+    LilypadCell& cell = getCell(vert.pos);
+
+    s_t verticalVel = vert.vel.dot(mGroundNormal);
+    Eigen::Vector3s lateralVelVector = vert.vel - mGroundNormal * verticalVel;
+    s_t lateralVel = lateralVelVector.norm();
+    s_t verticalAccel = vert.accel.dot(mGroundNormal);
+    if ((verticalVel > 0 && verticalVel > mVerticalVelThreshold)
+        || (verticalVel < 0 && -verticalVel > mVerticalVelThreshold)
+        || lateralVel > mLateralVelThreshold
+        || verticalAccel < mVerticalAccelerationThreshold)
+    {
+      cell.mFastVerts.push_back(vert);
+      /*
+      // If we're moving fast, and we're below what we thought the ground
+      // level was, then we've obviously made a mistake and the ground isn't
+      // where we thought it was
+      if (height < cell.groundLowerBound)
+      {
+        cell.groundLowerBound = std::numeric_limits<s_t>::infinity();
+        cell.groundUpperBound = -std::numeric_limits<s_t>::infinity();
+      }
+      */
+    }
+    else
+    {
+      cell.mSlowVerts.push_back(vert);
+      if (cell.groundLowerBound > height)
+      {
+        cell.groundLowerBound = height;
+      }
+      // (height + bodyHeight) is an upper bound on groundUpperBound
+      if (cell.groundUpperBound > height + bodyHeight)
+      {
+        cell.groundUpperBound = height + bodyHeight;
+      }
+
+      if (cell.groundUpperBound < height)
+      {
+        cell.groundUpperBound = height;
+      }
+    }
+  }
+}
 
 /// Here we can set the velocity threshold that distinguishes "slow" vertices
 /// from "fast" vertices. Only slow vertices can form the basis of lilypads.
@@ -211,11 +324,46 @@ LilypadCell& LilypadSolver::getCell(Eigen::Vector3s pos)
   int x = (int)ceil(xPos / mTileSize);
   int y = (int)ceil(yPos / mTileSize);
 
-  LilypadCell& cell = mPads[std::make_pair(x, y)];
-  cell.x = x;
-  cell.y = y;
+  // Keep the table at most half full, so probe chains stay short
+  if ((mCells.size() + 1) * 2 > mCellSlots.size())
+  {
+    growSlots();
+  }
+  std::size_t slot = findSlot(x, y);
+  if (mCellSlots[slot] == -1)
+  {
+    mCellSlots[slot] = mCells.size();
+    mCells.emplace_back();
+    mCells.back().x = x;
+    mCells.back().y = y;
+  }
+  return mCells[mCellSlots[slot]];
+}
 
-  return cell;
+/// This returns the index in mCellSlots where the cell (x, y) lives, or
+/// the empty slot where it would go
+std::size_t LilypadSolver::findSlot(int x, int y) const
+{
+  const std::size_t mask = mCellSlots.size() - 1;
+  std::size_t slot = hashTile(x, y) & mask;
+  while (mCellSlots[slot] != -1)
+  {
+    const LilypadCell& cell = mCells[mCellSlots[slot]];
+    if (cell.x == x && cell.y == y)
+      return slot;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/// This doubles the size of mCellSlots, and re-inserts every cell
+void LilypadSolver::growSlots()
+{
+  mCellSlots.assign(std::max<std::size_t>(64, mCellSlots.size() * 2), -1);
+  for (int i = 0; i < (int)mCells.size(); i++)
+  {
+    mCellSlots[findSlot(mCells[i].x, mCells[i].y)] = i;
+  }
 }
 
 /// This will debug all the processed data over to our GUI, so we can see the
@@ -225,9 +373,8 @@ void LilypadSolver::debugToGUI(
 {
   server->deleteObjectsByPrefix("lilypad_tile_");
 
-  for (auto& pair : mPads)
+  for (LilypadCell& cell : mCells)
   {
-    LilypadCell& cell = pair.second;
 
     /*
     for (int i = 0; i < cell.mSlowVerts.size(); i++)
@@ -236,8 +383,8 @@ void LilypadSolver::debugToGUI(
       line.push_back(cell.mSlowVerts[i].pos);
       line.push_back(cell.mSlowVerts[i].pos + 0.01 * cell.mSlowVerts[i].vel);
       server->createLine(
-          "slow_verts_(" + std::to_string(pair.first.first) + ","
-              + std::to_string(pair.first.second) + ")_" + std::to_string(i),
+          "slow_verts_(" + std::to_string(cell.x) + ","
+              + std::to_string(cell.y) + ")_" + std::to_string(i),
           line,
           Eigen::Vector3s(0.5, 0.5, 1.0));
     }
@@ -247,8 +394,8 @@ void LilypadSolver::debugToGUI(
       line.push_back(cell.mFastVerts[i].pos);
       line.push_back(cell.mFastVerts[i].pos + 0.01 * cell.mFastVerts[i].vel);
       server->createLine(
-          "fast_verts_(" + std::to_string(pair.first.first) + ","
-              + std::to_string(pair.first.second) + ")_" + std::to_string(i),
+          "fast_verts_(" + std::to_string(cell.x) + ","
+              + std::to_string(cell.y) + ")_" + std::to_string(i),
           line,
           Eigen::Vector3s(1.0, 0.5, 0.5));
     }
@@ -283,7 +430,10 @@ void LilypadSolver::debugToGUI(
 
 void LilypadSolver::clear()
 {
-  mPads.clear();
+  mCells.clear();
+  mCellSlots.clear();
+  mPendingPoses.resize(0, 0);
+  mPendingStartTime = 0;
 }
 
 }; // namespace biomechanics
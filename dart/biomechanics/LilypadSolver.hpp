@@ -1,9 +1,9 @@
 #ifndef DART_NEURAL_LILYPAD_HPP_
 #define DART_NEURAL_LILYPAD_HPP_
 
+#include <cstdint>
+#include <deque>
 #include <memory>
-// #include <unordered_map>
-#include <map>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -64,6 +64,16 @@ public:
   /// This will attempt to find the lilypads in the supplied pose data
   void process(Eigen::MatrixXs poses, int startTime = 0);
 
+  /// This is for streaming use. Each call appends `newPoses` to the frames
+  /// we've already been given (since construction, or the last clear()), and
+  /// processes every frame that now has the two following frames it needs to
+  /// estimate velocity and acceleration. Feeding a trial through here in
+  /// pieces gives the same cells as a single call to process().
+  void processAppendedFrames(Eigen::MatrixXs newPoses);
+
+  /// This returns how many cells have been touched so far
+  int getNumCells() const;
+
   /// This returns the appropriate cell for a given position.
   LilypadCell& getCell(Eigen::Vector3s pos);
 
@@ -76,6 +86,25 @@ public:
   void clear();
 
 protected:
+  /// This computes the world space vertices of every contact body at every
+  /// frame `i` with `i + 2 < poses.cols()`, laid out as [i * mBodies.size() +
+  /// bodyIndex]. This runs in parallel on clones of the skeleton, so it
+  /// doesn't change mSkeleton's state.
+  std::vector<std::vector<dynamics::BodyNode::MovingVertex>>
+  computeMovingVertices(const Eigen::MatrixXs& poses, int startTime);
+
+  /// This sorts the vertices of one body at one frame into fast and slow
+  /// vertices, and updates the ground bounds of the cells they land in
+  void addBodyVertices(
+      const std::vector<dynamics::BodyNode::MovingVertex>& movingVerts);
+
+  /// This returns the index in mCellSlots where the cell (x, y) lives, or
+  /// the empty slot where it would go
+  std::size_t findSlot(int x, int y) const;
+
+  /// This doubles the size of mCellSlots, and re-inserts every cell
+  void growSlots();
+
   s_t lilypadRadius;
   std::shared_ptr<dynamics::Skeleton> mSkeleton;
   std::vector<const dynamics::BodyNode*> mBodies;
@@ -103,7 +132,19 @@ protected:
   /// section.
   s_t mBottomThresholdPercentage;
 
-  std::map<std::pair<int, int>, LilypadCell> mPads;
+  /// The cells live in a deque, so references returned by getCell() stay
+  /// valid as the grid grows
+  std::deque<LilypadCell> mCells;
+  /// This is an open-addressing hash table (with linear probing) from tile
+  /// coordinates to an index in mCells. Empty slots are -1. The size is always
+  /// a power of two.
+  std::vector<int> mCellSlots;
+
+  /// The last (up to two) frames passed to processAppendedFrames(), which we
+  /// haven't been able to process yet
+  Eigen::MatrixXs mPendingPoses;
+  /// The timestep of the first column of mPendingPoses
+  int mPendingStartTime;
 };
 
 } // namespace biomechanics
@@ -1,5 +1,6 @@
 #include "dart/biomechanics/MarkerFitter.hpp"
 
+#include <algorithm>
 #include <future>
 #include <iostream>
 #include <limits>
@@ -13,12 +14,15 @@
 #include <coin/IpSolveStatistics.hpp>
 #include <coin/IpTNLP.hpp>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/FiniteDifference.hpp"
 #include "dart/math/Geometry.hpp"
+#include "dart/math/LBFGSB.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/SpatialHash.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIRecording.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -30,7 +34,12 @@ namespace biomechanics {
 using namespace Ipopt;
 
 //==============================================================================
-/// This unflattens an input vector, given some information about the problm
+/// This unflattens an input vector, given some information about the problm.
+///
+/// If `threadSkeletons` isn't empty, the per-timestep work (here and in
+/// flattenGradient()) is split into one batch of timesteps per skeleton, and
+/// the batches run in parallel on the global ThreadPool. These must be clones
+/// of the fitter's skeleton that nobody else is using for now.
 MarkerFitterState::MarkerFitterState(
     const Eigen::VectorXs& flat,
     std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations,
@@ -39,7 +48,8 @@ MarkerFitterState::MarkerFitterState(
     Eigen::VectorXs jointWeights,
     Eigen::MatrixXs jointAxis,
     Eigen::VectorXs axisWeights,
-    MarkerFitter* fitter)
+    MarkerFitter* fitter,
+    const std::vector<std::shared_ptr<dynamics::Skeleton>>& threadSkeletons)
   : markerOrder(fitter->mMarkerNames),
     skeleton(fitter->mSkeleton),
     markerObservations(markerObservations),
@@ -48,7 +58,8 @@ MarkerFitterState::MarkerFitterState(
     jointWeights(jointWeights),
     jointAxis(jointAxis),
     axisWeights(axisWeights),
-    fitter(fitter)
+    fitter(fitter),
+    threadSkeletons(threadSkeletons)
 {
   for (auto joint : joints)
   {
@@ -108,12 +119,6 @@ MarkerFitterState::MarkerFitterState(
           flat.segment(groupScaleDim + markerOffsetDim, skeleton->getNumDofs()),
           flat.segment(0, groupScaleDim),
           flat.segment(groupScaleDim, markerOffsetDim));
-  std::map<std::string, std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
-      markerMap;
-  for (int i = 0; i < fitter->mMarkerNames.size(); i++)
-  {
-    markerMap[fitter->mMarkerNames[i]] = markers[i];
-  }
 
   posesAtTimesteps = Eigen::MatrixXs::Zero(
       skeleton->getNumDofs(), markerObservations.size());
@@ -137,65 +142,25 @@ MarkerFitterState::MarkerFitterState(
 
   for (int i = 0; i < markerObservations.size(); i++)
   {
-    Eigen::VectorXs pos = flat.segment(
+    posesAtTimesteps.col(i) = flat.segment(
         groupScaleDim + markerOffsetDim + (skeleton->getNumDofs() * i),
         skeleton->getNumDofs());
-    posesAtTimesteps.col(i) = pos;
-
-    // Compute marker errors at each timestep
-
-    skeleton->setPositions(pos);
-    std::map<std::string, Eigen::Vector3s> currentMarkerPoses
-        = skeleton->getMarkerMapWorldPositions(markerMap);
-    std::map<std::string, Eigen::Vector3s> desiredMarkerPoses
-        = markerObservations[i];
-
-    for (int j = 0; j < markerOrder.size(); j++)
-    {
-      std::string markerName = markerOrder[j];
-      if (desiredMarkerPoses.count(markerName))
-      {
-        markerErrorsAtTimesteps.block<3, 1>(i * 3, j)
-            = currentMarkerPoses[markerName] - desiredMarkerPoses[markerName];
-      }
-    }
-
-    // Compute the joint errors at each timestep
-
-    Eigen::VectorXs jointPoses = skeleton->getJointWorldPositions(joints);
-    jointErrorsAtTimesteps.col(i) = jointPoses - jointCenters.col(i);
-    if (jointWeights.size() > 0)
-    {
-      for (int j = 0; j < joints.size(); j++)
-      {
-        jointErrorsAtTimesteps.col(i).segment<3>(j * 3) *= jointWeights(j);
-      }
-    }
-
-    // Compute the axis errors at each timestep
+  }
 
-    if (jointAxis.size() > 0)
-    {
-      for (int j = 0; j < joints.size(); j++)
-      {
-        Eigen::Vector3s jointPos = jointPoses.segment<3>(j * 3);
-        Eigen::Vector3s axisCenter = jointAxis.block<3, 1>(j * 6, i);
-        Eigen::Vector3s axisDir
-            = jointAxis.block<3, 1>(j * 6 + 3, i).normalized();
+  // Compute the marker, joint, and axis errors at each timestep
 
-        Eigen::Vector3s diff = jointPos - axisCenter;
-        // Subtract out the component of `diff` that's parallel to the axisDir
-        diff -= diff.dot(axisDir) * axisDir;
-        // Now our measured diff is only the distance perpendicular to axisDir
-        // (ie the shortest path to the axis)
-        axisErrorsAtTimesteps.block<3, 1>(j * 3, i) = diff;
-        if (axisWeights.size() > 0)
-        {
-          axisErrorsAtTimesteps.block<3, 1>(j * 3, i) *= axisWeights(j);
-        }
-      }
-    }
-  }
+  runOnTimestepBatches(
+      markers,
+      [this](
+          int /* batch */,
+          std::shared_ptr<dynamics::Skeleton> skel,
+          const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+              skelMarkers,
+          const std::vector<dynamics::Joint*>& skelJoints,
+          int start,
+          int end) {
+        computeErrorsAtTimesteps(skel, skelMarkers, skelJoints, start, end);
+      });
 
   skeleton->setPositions(originalPos);
   skeleton->setGroupScales(originalScales);
@@ -312,13 +277,191 @@ Eigen::VectorXs MarkerFitterState::flattenGradient()
       = fitter->setConfiguration(
           skeleton, firstPose, groupScales, markerOffsetsFlat);
 
-  // 4.2. Go through each observation and accumulate gradient where appropriate
+  // 4.2. Go through each observation and accumulate gradient where appropriate.
+  // Each batch writes its own poses' gradients straight into `grad`, but the
+  // scale and marker offset gradients are shared, so we sum those up after.
+
+  std::vector<Eigen::VectorXs> batchSharedGrads(
+      std::max<int>(1, threadSkeletons.size()),
+      Eigen::VectorXs::Zero(groupScaleDim + markerOffsetDim));
+  runOnTimestepBatches(
+      markers,
+      [this, &grad, &batchSharedGrads](
+          int batch,
+          std::shared_ptr<dynamics::Skeleton> skel,
+          const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+              skelMarkers,
+          const std::vector<dynamics::Joint*>& skelJoints,
+          int start,
+          int end) {
+        batchSharedGrads[batch] += accumulateGradientAtTimesteps(
+            skel, skelMarkers, skelJoints, start, end, grad);
+      });
+  for (const Eigen::VectorXs& sharedGrad : batchSharedGrads)
+  {
+    grad.segment(0, groupScaleDim + markerOffsetDim) += sharedGrad;
+  }
 
-  for (int i = 0; i < markerObservations.size(); i++)
+  skeleton->setGroupScales(originalScales);
+  skeleton->setPositions(originalPos);
+
+  return grad;
+}
+
+//==============================================================================
+/// This splits the timesteps into one batch per thread skeleton, and runs
+/// `fn` on each batch in parallel, passing along a skeleton (with the same
+/// scales as `skeleton`) and `markers` and `joints` remapped onto it. With
+/// fewer than two thread skeletons, this just runs `fn` once over every
+/// timestep on `skeleton`.
+void MarkerFitterState::runOnTimestepBatches(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    std::function<void(
+        int batch,
+        std::shared_ptr<dynamics::Skeleton> skel,
+        const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+            skelMarkers,
+        const std::vector<dynamics::Joint*>& skelJoints,
+        int start,
+        int end)> fn)
+{
+  int numTimesteps = markerObservations.size();
+  int numBatches = std::min<int>(threadSkeletons.size(), numTimesteps);
+  if (numBatches < 2)
+  {
+    fn(0, skeleton, markers, joints, 0, numTimesteps);
+    return;
+  }
+
+  int batchSize = (numTimesteps + numBatches - 1) / numBatches;
+  Eigen::VectorXs groupScales = skeleton->getGroupScales();
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (int k = 0; k < numBatches; k++)
+  {
+    int start = k * batchSize;
+    int end = std::min(numTimesteps, start + batchSize);
+    if (start >= end)
+      break;
+
+    std::shared_ptr<dynamics::Skeleton> threadSkeleton = threadSkeletons[k];
+    threadSkeleton->setGroupScales(groupScales);
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> threadMarkers;
+    for (auto& pair : markers)
+    {
+      threadMarkers.emplace_back(
+          threadSkeleton->getBodyNode(pair.first->getName()), pair.second);
+    }
+    std::vector<dynamics::Joint*> threadJoints;
+    for (dynamics::Joint* joint : joints)
+    {
+      threadJoints.push_back(threadSkeleton->getJoint(joint->getName()));
+    }
+
+    futures.push_back(pool.submit(
+        [&fn, k, threadSkeleton, threadMarkers, threadJoints, start, end]() {
+          fn(k, threadSkeleton, threadMarkers, threadJoints, start, end);
+        }));
+  }
+  // Wait for every batch before get() can throw, since the tasks refer to
+  // locals on this stack
+  pool.waitAll(futures);
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+}
+
+//==============================================================================
+/// This fills in the marker, joint, and axis errors for the timesteps in
+/// [start, end), running FK on `skel`
+void MarkerFitterState::computeErrorsAtTimesteps(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const std::vector<dynamics::Joint*>& skelJoints,
+    int start,
+    int end)
+{
+  for (int i = start; i < end; i++)
+  {
+    skel->setPositions(posesAtTimesteps.col(i));
+
+    // Compute marker errors at each timestep
+
+    Eigen::VectorXs currentMarkerPoses = skel->getMarkerWorldPositions(markers);
+    for (auto& pair : markerObservations[i])
+    {
+      auto index = fitter->mMarkerIndices.find(pair.first);
+      if (index != fitter->mMarkerIndices.end())
+      {
+        int j = index->second;
+        markerErrorsAtTimesteps.block<3, 1>(i * 3, j)
+            = currentMarkerPoses.segment<3>(j * 3) - pair.second;
+      }
+    }
+
+    // Compute the joint errors at each timestep
+
+    Eigen::VectorXs jointPoses = skel->getJointWorldPositions(skelJoints);
+    jointErrorsAtTimesteps.col(i) = jointPoses - jointCenters.col(i);
+    if (jointWeights.size() > 0)
+    {
+      for (int j = 0; j < skelJoints.size(); j++)
+      {
+        jointErrorsAtTimesteps.col(i).segment<3>(j * 3) *= jointWeights(j);
+      }
+    }
+
+    // Compute the axis errors at each timestep
+
+    if (jointAxis.size() > 0)
+    {
+      for (int j = 0; j < skelJoints.size(); j++)
+      {
+        Eigen::Vector3s jointPos = jointPoses.segment<3>(j * 3);
+        Eigen::Vector3s axisCenter = jointAxis.block<3, 1>(j * 6, i);
+        Eigen::Vector3s axisDir
+            = jointAxis.block<3, 1>(j * 6 + 3, i).normalized();
+
+        Eigen::Vector3s diff = jointPos - axisCenter;
+        // Subtract out the component of `diff` that's parallel to the axisDir
+        diff -= diff.dot(axisDir) * axisDir;
+        // Now our measured diff is only the distance perpendicular to axisDir
+        // (ie the shortest path to the axis)
+        axisErrorsAtTimesteps.block<3, 1>(j * 3, i) = diff;
+        if (axisWeights.size() > 0)
+        {
+          axisErrorsAtTimesteps.block<3, 1>(j * 3, i) *= axisWeights(j);
+        }
+      }
+    }
+  }
+}
+
+//==============================================================================
+/// This adds the gradient wrt the poses at the timesteps in [start, end) into
+/// `grad`, and returns the gradient wrt the group scales and marker offsets
+/// (concatenated) summed over those timesteps, running FK on `skel`
+Eigen::VectorXs MarkerFitterState::accumulateGradientAtTimesteps(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const std::vector<dynamics::Joint*>& skelJoints,
+    int start,
+    int end,
+    Eigen::VectorXs& grad)
+{
+  int groupScaleDim = skel->getGroupScaleDim();
+  int markerOffsetDim = markerOrder.size() * 3;
+  int dofs = skel->getNumDofs();
+
+  Eigen::VectorXs sharedGrad
+      = Eigen::VectorXs::Zero(groupScaleDim + markerOffsetDim);
+
+  for (int i = start; i < end; i++)
   {
-    int offset = groupScaleDim + markerOffsetDim + (i * skeleton->getNumDofs());
-    Eigen::VectorXs pose = posesAtTimesteps.col(i);
-    skeleton->setPositions(pose);
+    int offset = groupScaleDim + markerOffsetDim + (i * dofs);
+    skel->setPositions(posesAtTimesteps.col(i));
 
     Eigen::VectorXs markerErrorGrad
         = Eigen::VectorXs::Zero(markerOrder.size() * 3);
@@ -332,34 +475,30 @@ Eigen::VectorXs MarkerFitterState::flattenGradient()
     Eigen::VectorXs combinedJointGrad = jointErrorGrad + axisErrorGrad;
 
     // Get loss wrt joint positions
-    grad.segment(offset, skeleton->getNumDofs())
-        += fitter->getMarkerLossGradientWrtJoints(
-            skeleton, markers, markerErrorGrad);
-    grad.segment(offset, skeleton->getNumDofs())
-        += skeleton->getJointWorldPositionsJacobianWrtJointPositions(joints)
+    grad.segment(offset, dofs) += fitter->getMarkerLossGradientWrtJoints(
+        skel, markers, markerErrorGrad);
+    grad.segment(offset, dofs)
+        += skel->getJointWorldPositionsJacobianWrtJointPositions(skelJoints)
                .transpose()
            * combinedJointGrad;
 
     // Acculumulate loss wrt the global scale groups
-    grad.segment(0, groupScaleDim)
+    sharedGrad.segment(0, groupScaleDim)
         += fitter->getMarkerLossGradientWrtGroupScales(
-            skeleton, markers, markerErrorGrad);
-    grad.segment(0, groupScaleDim)
-        += skeleton->getJointWorldPositionsJacobianWrtGroupScales(joints)
+            skel, markers, markerErrorGrad);
+    sharedGrad.segment(0, groupScaleDim)
+        += skel->getJointWorldPositionsJacobianWrtGroupScalesSparse(skelJoints)
                .transpose()
            * combinedJointGrad;
 
     // Acculumulate loss wrt the global marker offsets (this is 0 for joints,
     // since marker offsets don't change joint locations)
-    grad.segment(groupScaleDim, markerOffsetDim)
+    sharedGrad.segment(groupScaleDim, markerOffsetDim)
         += fitter->getMarkerLossGradientWrtMarkerOffsets(
-            skeleton, markers, markerErrorGrad);
+            skel, markers, markerErrorGrad);
   }
 
-  skeleton->setGroupScales(originalScales);
-  skeleton->setPositions(originalPos);
-
-  return grad;
+  return sharedGrad;
 }
 
 //==============================================================================
@@ -514,6 +653,11 @@ InitialMarkerFitParams::setMaxTimestepsToUseForMultiTrialScaling(
   return *this;
 }
 
+//==============================================================================
+TrajectoryFitDispatcher::~TrajectoryFitDispatcher()
+{
+}
+
 //==============================================================================
 MarkerFitter::MarkerFitter(
     std::shared_ptr<dynamics::Skeleton> skeleton,
@@ -524,6 +668,8 @@ MarkerFitter::MarkerFitter(
     mAnthropometricWeight(0.001),
     mInitialIKSatisfactoryLoss(0.003),
     mInitialIKMaxRestarts(100),
+    mUseTemporalWarmStart(false),
+    mUseLevenbergMarquardtIK(false),
     mMaxMarkerOffset(0.2),
     mMinVarianceCutoff(3.0),
     mMinSphereFitScore(0.01),
@@ -544,8 +690,15 @@ MarkerFitter::MarkerFitter(
     mPrintFrequency(1),
     mSilenceOutput(false),
     mDisableLinesearch(false),
+    mUseGaussNewtonHessian(false),
     mAnatomicalMarkerDefaultWeight(1.0),
-    mTrackingMarkerDefaultWeight(0.02)
+    mTrackingMarkerDefaultWeight(0.02),
+    mUseLBFGSBForJointFits(false),
+    mHasCustomLossAndGrad(false),
+    mParallelizeTrials(true),
+    mBilevelWindowSize(0),
+    mBilevelWindowOverlap(0),
+    mBilevelWindowRounds(2)
 {
   mSkeletonBallJoints = mSkeleton->convertSkeletonToBallJoints();
 
@@ -949,61 +1102,182 @@ bool MarkerFitter::checkForFlippedMarkers(
   // half of Scott Uhlrich's OpenCap trials the foot markers are on one side of
   // the foot, and in the other half of the trials the foot markers are flipped.
 
-  Eigen::VectorXs originalPose = mSkeleton->getPositions();
-  Eigen::VectorXs originalScales = mSkeleton->getGroupScales();
-  std::map<std::string, std::map<std::string, s_t>> totalDistances;
-  std::map<std::string, std::map<std::string, int>> totalObservations;
-  for (std::string& marker : mMarkerNames)
+  // 1. Lay out the observations and the model's markers in columns
+
+  int numTimesteps = init.poses.cols();
+  int numObserved = observedMarkers.size();
+  std::map<std::string, int> observedIndices;
+  for (int o = 0; o < numObserved; o++)
+  {
+    observedIndices[observedMarkers[o]] = o;
+  }
+  Eigen::MatrixXs observedPositions
+      = Eigen::MatrixXs::Zero(3 * numObserved, numTimesteps);
+  Eigen::MatrixXs observedMask
+      = Eigen::MatrixXs::Zero(numObserved, numTimesteps);
+  for (int i = 0; i < numTimesteps; i++)
   {
-    for (std::string& innerMarker : observedMarkers)
+    for (auto& pair : markerObservations[i])
     {
-      totalDistances[marker][innerMarker] = 0.0;
+      int o = observedIndices[pair.first];
+      observedPositions.block<3, 1>(3 * o, i) = pair.second;
+      observedMask(o, i) = 1.0;
     }
   }
+  Eigen::VectorXs observedCounts = observedMask.rowwise().sum();
 
-  mSkeleton->setGroupScales(init.groupScales);
-  for (int i = 0; i < init.poses.cols(); i++)
+  std::vector<std::string> modelMarkers;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
+      modelMarkerVector;
+  for (std::string& marker : mMarkerNames)
   {
-    mSkeleton->setPositions(init.poses.col(i));
-    std::map<std::string, Eigen::Vector3s> markerPos
-        = mSkeleton->getMarkerMapWorldPositions(init.updatedMarkerMap);
-    for (auto& pair : markerPos)
+    auto it = init.updatedMarkerMap.find(marker);
+    if (it != init.updatedMarkerMap.end())
     {
-      for (auto& innerPair : markerObservations[i])
-      {
-        totalDistances[pair.first][innerPair.first]
-            += (pair.second - innerPair.second).norm();
-        totalObservations[pair.first][innerPair.first]++;
-      }
+      modelMarkers.push_back(marker);
+      modelMarkerVector.push_back(it->second);
     }
   }
-  mSkeleton->setPositions(originalPose);
+  int numModel = modelMarkers.size();
+
+  Eigen::VectorXs originalScales = mSkeleton->getGroupScales();
+  mSkeleton->setGroupScales(init.groupScales);
+  Eigen::MatrixXs modelPositions
+      = mSkeleton->getMarkerWorldPositionsBatch(modelMarkerVector, init.poses);
   mSkeleton->setGroupScales(originalScales);
 
-  std::map<std::string, std::string> closestMarkers;
-  for (std::string& marker : mMarkerNames)
+  // This is the average distance from model marker `m` to observed marker
+  // `o`, over the timesteps where `o` was observed
+  auto getAverageDistance = [&](int m, int o) -> s_t {
+    Eigen::VectorXs dists
+        = (modelPositions.block(3 * m, 0, 3, numTimesteps)
+           - observedPositions.block(3 * o, 0, 3, numTimesteps))
+              .colwise()
+              .norm()
+              .transpose();
+    s_t total = observedMask.row(o).dot(dists);
+    return total / (observedCounts(o) > 0 ? observedCounts(o) : 1.0);
+  };
+
+  // 2. Get the average distance from each model marker to its own
+  // observations. Another marker can only be closer on average if it's closer
+  // than this on at least one timestep.
+
+  Eigen::VectorXs selfDistances = Eigen::VectorXs::Zero(numModel);
+  for (int m = 0; m < numModel; m++)
   {
-    std::string closestMarker = marker;
-    s_t closestMarkerDistance = totalDistances[marker][marker]
-                                / (totalObservations[marker][marker] > 0
-                                       ? totalObservations[marker][marker]
-                                       : 1.0);
+    auto self = observedIndices.find(modelMarkers[m]);
+    if (self != observedIndices.end())
+    {
+      selfDistances(m) = getAverageDistance(m, self->second);
+    }
+  }
+
+  // 3. Find the candidate (model, observed) pairs that pass that test, with a
+  // spatial hash over the observations on each timestep, in parallel over
+  // chunks of time
 
-    for (std::string& innerMarker : observedMarkers)
+  std::vector<s_t> positiveSelfDistances;
+  for (int m = 0; m < numModel; m++)
+  {
+    if (selfDistances(m) > 0 && std::isfinite(selfDistances(m)))
     {
-      int observed = totalObservations[marker][innerMarker];
-      if (observed > 0)
+      positiveSelfDistances.push_back(selfDistances(m));
+    }
+  }
+  s_t cellSize = 1.0;
+  if (positiveSelfDistances.size() > 0)
+  {
+    auto median
+        = positiveSelfDistances.begin() + positiveSelfDistances.size() / 2;
+    std::nth_element(
+        positiveSelfDistances.begin(), median, positiveSelfDistances.end());
+    cellSize = *median;
+  }
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  int numChunks = std::max<int>(
+      1, std::min<int>(pool.getNumThreads(), numTimesteps / 64));
+  int chunkSize = (numTimesteps + numChunks - 1) / numChunks;
+  std::vector<std::future<std::vector<int>>> futures;
+  for (int start = 0; start < numTimesteps; start += chunkSize)
+  {
+    int end = std::min(numTimesteps, start + chunkSize);
+    futures.push_back(pool.submit([&, start, end]() {
+      math::SpatialHash hash(cellSize);
+      std::vector<int> neighbors;
+      std::vector<int> pairs;
+      for (int i = start; i < end; i++)
       {
-        s_t avgDist = totalDistances[marker][innerMarker] / observed;
-        if (avgDist < closestMarkerDistance)
+        hash.clear();
+        for (int o = 0; o < numObserved; o++)
+        {
+          if (observedMask(o, i) > 0)
+          {
+            hash.insert(observedPositions.block<3, 1>(3 * o, i), o);
+          }
+        }
+        for (int m = 0; m < numModel; m++)
+        {
+          if (!(selfDistances(m) > 0))
+            continue;
+          Eigen::Vector3s modelPos = modelPositions.block<3, 1>(3 * m, i);
+          hash.findNeighborsWithin(modelPos, selfDistances(m), neighbors);
+          for (int o : neighbors)
+          {
+            if ((modelPos - observedPositions.block<3, 1>(3 * o, i)).norm()
+                < selfDistances(m))
+            {
+              pairs.push_back(m * numObserved + o);
+            }
+          }
+        }
+        // Keep this from growing with the length of the chunk
+        if (pairs.size() > 4 * numModel + 64)
         {
-          closestMarker = innerMarker;
-          closestMarkerDistance = avgDist;
+          std::sort(pairs.begin(), pairs.end());
+          pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
         }
       }
-    }
+      return pairs;
+    }));
+  }
+  // Wait for every chunk before get() can throw, since the tasks refer to
+  // locals on this stack
+  pool.waitAll(futures);
+  std::vector<int> candidatePairs;
+  for (auto& future : futures)
+  {
+    std::vector<int> pairs = future.get();
+    candidatePairs.insert(candidatePairs.end(), pairs.begin(), pairs.end());
+  }
+  std::sort(candidatePairs.begin(), candidatePairs.end());
+  candidatePairs.erase(
+      std::unique(candidatePairs.begin(), candidatePairs.end()),
+      candidatePairs.end());
 
-    closestMarkers[marker] = closestMarker;
+  // 4. Score only the candidates. They're sorted by model marker, and then by
+  // observed marker name, so ties break the same way as checking every pair.
+
+  std::map<std::string, std::string> closestMarkers;
+  for (std::string& marker : mMarkerNames)
+  {
+    closestMarkers[marker] = marker;
+  }
+  std::vector<s_t> closestMarkerDistances(
+      selfDistances.data(), selfDistances.data() + numModel);
+  for (int pair : candidatePairs)
+  {
+    int m = pair / numObserved;
+    int o = pair % numObserved;
+    if (observedMarkers[o] == modelMarkers[m])
+      continue;
+    s_t avgDist = getAverageDistance(m, o);
+    if (avgDist < closestMarkerDistances[m])
+    {
+      closestMarkers[modelMarkers[m]] = observedMarkers[o];
+      closestMarkerDistances[m] = avgDist;
+    }
   }
 
   std::map<std::string, std::string> swapped;
@@ -1097,13 +1371,15 @@ std::vector<MarkerInitialization> MarkerFitter::runMultiTrialKinematicsPipeline(
     // 3. Sort the trials by the amount of joint variability in each one
 
     // 3.1. First, get the joint inits for all the trials, since we need to be
-    // able to sort clips by joint variability
-    std::vector<MarkerInitialization> jointInits;
-    for (int i = 0; i < markerObservationTrials.size(); i++)
-    {
-      jointInits.push_back(
-          runJointsPipeline(markerObservationTrials[i], params));
-    }
+    // able to sort clips by joint variability. The trials are independent, so
+    // these can run side by side.
+    std::vector<MarkerInitialization> jointInits = runOnEachTrial(
+        markerObservationTrials.size(),
+        params.joints.empty(),
+        [&](MarkerFitter* fitter, int trial) {
+          return fitter->runJointsPipeline(
+              markerObservationTrials[trial], params);
+        });
 
     // 3.2. Sort the trials by the amount of joint variability in each one
     std::vector<int> orderedByJointVariability;
@@ -1191,8 +1467,31 @@ std::vector<MarkerInitialization> MarkerFitter::runMultiTrialKinematicsPipeline(
                  "on all the trials."
               << std::endl;
 
-    // 7. Use the scaling from overallInit to do IK on each skeleton
+    // 7. Use the scaling from overallInit to do IK on each skeleton. The
+    // trials that weren't part of the scaling dataset each need their own IK
+    // run, which are independent, so we do those side by side first.
+    std::vector<int> unsampledTrials;
+    for (int i = 0; i < markerObservationTrials.size(); i++)
+    {
+      if (trialSampledAtIndex[i] == -1)
+      {
+        unsampledTrials.push_back(i);
+      }
+    }
+    InitialMarkerFitParams prescaledParams
+        = InitialMarkerFitParams(params)
+              .setGroupScales(overallInit.groupScales)
+              .setMarkerOffsets(overallInit.markerOffsets);
+    std::vector<MarkerInitialization> unsampledInits = runOnEachTrial(
+        unsampledTrials.size(),
+        params.joints.empty(),
+        [&](MarkerFitter* fitter, int k) {
+          return fitter->runPrescaledPipeline(
+              markerObservationTrials[unsampledTrials[k]], prescaledParams);
+        });
+
     std::vector<MarkerInitialization> separateInits;
+    int unsampledCursor = 0;
     for (int i = 0; i < markerObservationTrials.size(); i++)
     {
       std::cout << "## IK on trial " << i << "/"
@@ -1224,11 +1523,8 @@ std::vector<MarkerInitialization> MarkerFitter::runMultiTrialKinematicsPipeline(
       }
       else
       {
-        separateInits.push_back(runPrescaledPipeline(
-            markerObservationTrials[i],
-            InitialMarkerFitParams(params)
-                .setGroupScales(overallInit.groupScales)
-                .setMarkerOffsets(overallInit.markerOffsets)));
+        separateInits.push_back(unsampledInits[unsampledCursor]);
+        unsampledCursor++;
         // separateInits.push_back(fineTuneIK(
         //     markerObservationTrials[i],
         //     params.numBlocks,
@@ -1340,7 +1636,15 @@ MarkerInitialization MarkerFitter::runKinematicsPipeline(
 
   // 4. Run bilevel optimization
   std::shared_ptr<BilevelFitResult> bilevelFit
-      = optimizeBilevel(markerObservations, reinit, numSamples);
+      = mBilevelWindowSize > 0
+            ? optimizeBilevelWindowed(
+                markerObservations,
+                reinit,
+                numSamples,
+                mBilevelWindowSize,
+                mBilevelWindowOverlap,
+                mBilevelWindowRounds)
+            : optimizeBilevel(markerObservations, reinit, numSamples);
 
   // 5. Fine-tune IK and re-fit all the points
   mSkeleton->setGroupScales(bilevelFit->groupScales);
@@ -2411,52 +2715,255 @@ std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevel(
     int numSamples,
     bool applyInnerProblemGradientConstraints)
 {
-  // Before using Eigen in a multi-threaded environment, we need to explicitly
-  // call this (at least prior to Eigen 3.3)
-  Eigen::initParallel();
-
-  // Create an instance of the IpoptApplication
-  //
-  // We are using the factory, since this allows us to compile this
-  // example with an Ipopt Windows DLL
-  SmartPtr<Ipopt::IpoptApplication> app = IpoptApplicationFactory();
-
-  // Change some options
-  // Note: The following choices are only examples, they might not be
-  //       suitable for your optimization problem.
-  app->Options()->SetNumericValue("tol", static_cast<double>(mTolerance));
-  app->Options()->SetStringValue(
-      "linear_solver",
-      "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
-
-  app->Options()->SetStringValue(
-      "hessian_approximation", "limited-memory"); // limited-memory, exacty
-
-  /*
-  app->Options()->SetStringValue(
-      "scaling_method", "none"); // none, gradient-based
-  */
-
-  app->Options()->SetIntegerValue("max_iter", mIterationLimit);
-
-  // Disable LBFGS history
-  app->Options()->SetIntegerValue(
-      "limited_memory_max_history", mLBFGSHistoryLength);
+  return solveBilevel(
+      markerObservations,
+      initialization,
+      numSamples,
+      applyInnerProblemGradientConstraints,
+      false);
+}
 
-  // Just for debugging
-  if (mCheckDerivatives)
+//==============================================================================
+/// This is a version of optimizeBilevel() for very long trials, where a
+/// single problem over the whole trial would be too big. It splits the
+/// trial into windows of `windowSize` timesteps, each overlapping the next
+/// by `windowOverlap`, and samples `samplesPerWindow` poses from each one.
+/// Each round fits every window on its own, starting from the shared body
+/// scales and marker offsets, and then sets the shared values to the
+/// average of the windows' answers, weighted by window length. After
+/// `numRounds` rounds, every window's poses are re-fit with the shared
+/// scales and offsets held fixed. If the trial fits in a single window,
+/// this is just optimizeBilevel().
+std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevelWindowed(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>&
+        markerObservations,
+    MarkerInitialization& initialization,
+    int samplesPerWindow,
+    int windowSize,
+    int windowOverlap,
+    int numRounds)
+{
+  int numTimesteps = markerObservations.size();
+  if (windowSize <= 0 || numTimesteps <= windowSize)
   {
-    app->Options()->SetStringValue("check_derivatives_for_naninf", "yes");
-    app->Options()->SetStringValue("derivative_test", "first-order");
-    app->Options()->SetNumericValue("derivative_test_perturbation", 1e-6);
+    return optimizeBilevel(
+        markerObservations, initialization, samplesPerWindow);
   }
 
-  if (mPrintFrequency > 0)
+  // 1. Split the trial into overlapping windows, as (start, length) pairs
+  int stride = std::max(1, windowSize - windowOverlap);
+  std::vector<std::pair<int, int>> windows;
+  for (int start = 0;; start += stride)
   {
-    app->Options()->SetIntegerValue("print_frequency_iter", mPrintFrequency);
+    int end = std::min(start + windowSize, numTimesteps);
+    windows.emplace_back(start, end - start);
+    if (end == numTimesteps)
+      break;
   }
-  else
-  {
+  std::cout << "Windowed bilevel fit: " << windows.size()
+            << " windows of up to " << windowSize << " timesteps, over "
+            << numTimesteps << " timesteps" << std::endl;
+
+  Eigen::VectorXs groupScales = initialization.groupScales;
+  std::map<std::string, Eigen::Vector3s> markerOffsets
+      = initialization.markerOffsets;
+  Eigen::MatrixXs poses = initialization.poses;
+
+  // This solves one window, starting from the shared scales and offsets. We
+  // only copy the window's columns, since the whole trial can be very long.
+  auto solveWindow = [&](int w, bool fixScalesAndOffsets) {
+    int start = windows[w].first;
+    int length = windows[w].second;
+    std::vector<std::map<std::string, Eigen::Vector3s>> windowObservations(
+        markerObservations.begin() + start,
+        markerObservations.begin() + start + length);
+
+    MarkerInitialization windowInit;
+    windowInit.poses = poses.block(0, start, poses.rows(), length);
+    if (initialization.poseScores.size() >= start + length)
+    {
+      windowInit.poseScores = initialization.poseScores.segment(start, length);
+    }
+    windowInit.groupScales = groupScales;
+    windowInit.markerOffsets = markerOffsets;
+    windowInit.updatedMarkerMap = initialization.updatedMarkerMap;
+    windowInit.joints = initialization.joints;
+    windowInit.jointsAdjacentMarkers = initialization.jointsAdjacentMarkers;
+    windowInit.jointMarkerVariability = initialization.jointMarkerVariability;
+    windowInit.jointLoss = initialization.jointLoss;
+    windowInit.jointWeights = initialization.jointWeights;
+    windowInit.axisWeights = initialization.axisWeights;
+    windowInit.axisLoss = initialization.axisLoss;
+    windowInit.jointCenters = initialization.jointCenters;
+    if (initialization.jointCenters.cols() >= start + length)
+    {
+      windowInit.jointCenters = initialization.jointCenters.block(
+          0, start, initialization.jointCenters.rows(), length);
+    }
+    windowInit.jointAxis = initialization.jointAxis;
+    if (initialization.jointAxis.cols() >= start + length)
+    {
+      windowInit.jointAxis = initialization.jointAxis.block(
+          0, start, initialization.jointAxis.rows(), length);
+    }
+
+    // With the scales and offsets fixed this is just IK, so we don't need the
+    // inner problem constraints
+    return solveBilevel(
+        windowObservations,
+        windowInit,
+        samplesPerWindow,
+        !fixScalesAndOffsets,
+        fixScalesAndOffsets);
+  };
+
+  for (int round = 0; round < numRounds; round++)
+  {
+    std::cout << "Windowed bilevel fit: round " << (round + 1) << "/"
+              << numRounds << std::endl;
+
+    // 2. Fit each window on its own
+    Eigen::VectorXs groupScalesSum = Eigen::VectorXs::Zero(groupScales.size());
+    std::map<std::string, Eigen::Vector3s> markerOffsetsSum;
+    s_t weightSum = 0.0;
+    for (int w = 0; w < windows.size(); w++)
+    {
+      std::shared_ptr<BilevelFitResult> windowResult = solveWindow(w, false);
+      s_t weight = windows[w].second;
+      groupScalesSum += weight * windowResult->groupScales;
+      for (auto& pair : windowResult->markerOffsets)
+      {
+        if (markerOffsetsSum.count(pair.first) == 0)
+        {
+          markerOffsetsSum[pair.first] = Eigen::Vector3s::Zero();
+        }
+        markerOffsetsSum[pair.first] += weight * pair.second;
+      }
+      weightSum += weight;
+
+      // Start the next round from this window's poses
+      for (int k = 0; k < windowResult->sampleIndices.size(); k++)
+      {
+        poses.col(windows[w].first + windowResult->sampleIndices[k])
+            = windowResult->poses[k];
+      }
+    }
+
+    // 3. The shared step: the weighted average is the least-squares
+    // compromise between the windows. Averages of values within the bounds
+    // stay within the bounds.
+    groupScales = groupScalesSum / weightSum;
+    markerOffsets.clear();
+    for (auto& pair : markerOffsetsSum)
+    {
+      markerOffsets[pair.first] = pair.second / weightSum;
+    }
+  }
+
+  // 4. Re-fit every window's poses against the shared scales and offsets, so
+  // that every pose agrees with a single skeleton
+  std::shared_ptr<BilevelFitResult> result
+      = std::make_shared<BilevelFitResult>();
+  result->success = true;
+  result->groupScales = groupScales;
+  result->markerOffsets = markerOffsets;
+  result->rawMarkerOffsets = Eigen::VectorXs::Zero(mMarkerNames.size() * 3);
+  for (int i = 0; i < mMarkerNames.size(); i++)
+  {
+    if (markerOffsets.count(mMarkerNames[i]))
+    {
+      result->rawMarkerOffsets.segment<3>(i * 3)
+          = markerOffsets.at(mMarkerNames[i]);
+    }
+  }
+  // Windows overlap, so the same timestep can get sampled twice. We keep the
+  // first pose for each timestep.
+  std::map<int, Eigen::VectorXs> sampledPoses;
+  for (int w = 0; w < windows.size(); w++)
+  {
+    std::shared_ptr<BilevelFitResult> windowResult = solveWindow(w, true);
+    result->success = result->success && windowResult->success;
+    for (int k = 0; k < windowResult->sampleIndices.size(); k++)
+    {
+      sampledPoses.emplace(
+          windows[w].first + windowResult->sampleIndices[k],
+          windowResult->poses[k]);
+    }
+  }
+  for (auto& pair : sampledPoses)
+  {
+    result->sampleIndices.push_back(pair.first);
+    result->poses.push_back(pair.second);
+  }
+  result->posesMatrix
+      = Eigen::MatrixXs::Zero(result->poses[0].size(), result->poses.size());
+  for (int i = 0; i < result->poses.size(); i++)
+  {
+    result->posesMatrix.col(i) = result->poses[i];
+  }
+
+  return result;
+}
+
+//==============================================================================
+/// This runs the IPOPT solve behind optimizeBilevel(). If
+/// `fixScalesAndOffsets` is true, the body scales and marker offsets are
+/// held at their values in `initialization`, and only the poses move.
+std::shared_ptr<BilevelFitResult> MarkerFitter::solveBilevel(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>&
+        markerObservations,
+    MarkerInitialization& initialization,
+    int numSamples,
+    bool applyInnerProblemGradientConstraints,
+    bool fixScalesAndOffsets)
+{
+  // Before using Eigen in a multi-threaded environment, we need to explicitly
+  // call this (at least prior to Eigen 3.3)
+  Eigen::initParallel();
+
+  // Create an instance of the IpoptApplication
+  //
+  // We are using the factory, since this allows us to compile this
+  // example with an Ipopt Windows DLL
+  SmartPtr<Ipopt::IpoptApplication> app = IpoptApplicationFactory();
+
+  // Change some options
+  // Note: The following choices are only examples, they might not be
+  //       suitable for your optimization problem.
+  app->Options()->SetNumericValue("tol", static_cast<double>(mTolerance));
+  app->Options()->SetStringValue(
+      "linear_solver",
+      "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
+
+  app->Options()->SetStringValue(
+      "hessian_approximation",
+      mUseGaussNewtonHessian ? "exact" : "limited-memory");
+
+  /*
+  app->Options()->SetStringValue(
+      "scaling_method", "none"); // none, gradient-based
+  */
+
+  app->Options()->SetIntegerValue("max_iter", mIterationLimit);
+
+  // Disable LBFGS history
+  app->Options()->SetIntegerValue(
+      "limited_memory_max_history", mLBFGSHistoryLength);
+
+  // Just for debugging
+  if (mCheckDerivatives)
+  {
+    app->Options()->SetStringValue("check_derivatives_for_naninf", "yes");
+    app->Options()->SetStringValue("derivative_test", "first-order");
+    app->Options()->SetNumericValue("derivative_test_perturbation", 1e-6);
+  }
+
+  if (mPrintFrequency > 0)
+  {
+    app->Options()->SetIntegerValue("print_frequency_iter", mPrintFrequency);
+  }
+  else
+  {
     app->Options()->SetIntegerValue(
         "print_frequency_iter", std::numeric_limits<int>::infinity());
   }
@@ -2496,6 +3003,7 @@ std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevel(
       numSamples,
       applyInnerProblemGradientConstraints,
       result);
+  problem->setFixScalesAndOffsets(fixScalesAndOffsets);
   result->sampleIndices = problem->getSampleIndices();
 
   SmartPtr<BilevelFitProblem> problemPtr(problem);
@@ -2560,6 +3068,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
                "between our sampled indices..."
             << std::endl;
 
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
   std::vector<std::future<void>> blockFitFutures;
 
   // 2. Do a forward pass starting at each sample index and guessing forward to
@@ -2627,9 +3136,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
         forwardScores.segment(thisIndex, segmentLength),
         false);
         */
-    blockFitFutures.push_back(std::async(
-        &MarkerFitter::fitTrajectory,
-        this,
+    blockFitFutures.push_back(submitTrajectoryFit(
         solution->groupScales,
         solution->poses[i],
         segmentMarkerObservations,
@@ -2711,9 +3218,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
         backwardScores.segment(thisIndex, segmentLength),
         true);
         */
-    blockFitFutures.push_back(std::async(
-        &MarkerFitter::fitTrajectory,
-        this,
+    blockFitFutures.push_back(submitTrajectoryFit(
         solution->groupScales,
         solution->poses[i],
         segmentMarkerObservations,
@@ -2733,6 +3238,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
   // 4. Wait for all the threads to finish
   for (int i = 0; i < blockFitFutures.size(); i++)
   {
+    pool.wait(blockFitFutures[i]);
     blockFitFutures[i].get();
   }
 
@@ -2963,15 +3469,14 @@ MarkerInitialization MarkerFitter::fineTuneIK(
       mSkeleton->getNumDofs(), markerObservations.size());
   result.poseScores = Eigen::VectorXs::Zero(markerObservations.size());
 
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
   std::vector<std::future<void>> blockFitFutures;
   for (int i = 0; i < numBlocks; i++)
   {
     std::cout << "Starting fit for whole block " << i << "/" << numBlocks
               << std::endl;
 
-    blockFitFutures.push_back(std::async(
-        &MarkerFitter::fitTrajectory,
-        this,
+    blockFitFutures.push_back(submitTrajectoryFit(
         result.groupScales,
         firstGuessPoses[i],
         blocks[i],
@@ -2992,6 +3497,7 @@ MarkerInitialization MarkerFitter::fineTuneIK(
   }
   for (int i = 0; i < numBlocks; i++)
   {
+    pool.wait(blockFitFutures[i]);
     blockFitFutures[i].get();
     std::cout << "Finished fit for whole block " << i << "/" << numBlocks
               << std::endl;
@@ -3012,6 +3518,7 @@ MarkerInitialization MarkerFitter::smoothOutIK(
 {
   MarkerInitialization smoothed(initialization);
 
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
   std::vector<std::future<void>> ikFutures;
 
   int numBlocks = 12;
@@ -3024,7 +3531,7 @@ MarkerInitialization MarkerFitter::smoothOutIK(
     int size = std::min(blockDim, (int)initialization.poses.cols() - cursor);
     int thisCursor = cursor;
 
-    ikFutures.push_back(std::async([&, size, thisCursor, skelClone]() {
+    ikFutures.push_back(pool.submit([&, size, thisCursor, skelClone]() {
       for (int i = thisCursor; i < thisCursor + size; i++)
       {
         std::vector<std::string> observedMarkerNames;
@@ -3107,6 +3614,7 @@ MarkerInitialization MarkerFitter::smoothOutIK(
   // Join all the futures
   for (int i = 0; i < ikFutures.size(); i++)
   {
+    pool.wait(ikFutures[i]);
     ikFutures[i].get();
   }
 
@@ -3231,7 +3739,18 @@ MarkerInitialization MarkerFitter::getInitialization(
     cursor += blocks[i].size();
   }
 
+  // With temporal warm starts, we seed each block at its center frame and fit
+  // outwards in both directions, which halves the longest chain of frames
+  // that have to be solved one after another
+  std::vector<int> blockSeedIndices;
+  for (int i = 0; i < blocks.size(); i++)
+  {
+    blockSeedIndices.push_back(
+        mUseTemporalWarmStart ? blocks[i].size() / 2 : 0);
+  }
+
   // 2. Find IK+scaling for the beginning of each block independently
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
   std::vector<std::future<ScaleAndFitResult>> posesAndScalesFutures;
 
   if (params.groupScales.size() > 0)
@@ -3251,17 +3770,17 @@ MarkerInitialization MarkerFitter::getInitialization(
                 << i << "/" << numBlocks << std::endl;
     }
     // posesAndScales.push_back(scaleAndFit(this, blocks[i][0]));
-    posesAndScalesFutures.push_back(std::async(
+    posesAndScalesFutures.push_back(pool.submit(
         &MarkerFitter::scaleAndFit,
         this,
-        blocks[i][0],
+        blocks[i][blockSeedIndices[i]],
         firstGuessPoses[i],
         params.markerWeights,
         params.markerOffsets,
         params.joints,
-        jointCenterBlocks[i][0],
+        jointCenterBlocks[i][blockSeedIndices[i]],
         params.jointWeights,
-        jointAxisBlocks[i][0],
+        jointAxisBlocks[i][blockSeedIndices[i]],
         params.axisWeights,
         params.dontRescaleBodies));
   }
@@ -3269,6 +3788,7 @@ MarkerInitialization MarkerFitter::getInitialization(
   std::vector<ScaleAndFitResult> posesAndScales;
   for (int i = 0; i < numBlocks; i++)
   {
+    pool.wait(posesAndScalesFutures[i]);
     ScaleAndFitResult result = posesAndScalesFutures[i].get();
 
     // Do some error checking on the results
@@ -3332,7 +3852,8 @@ MarkerInitialization MarkerFitter::getInitialization(
 
   for (int i = 0; i < numBlocks; i++)
   {
-    result.poses.col(blockStartIndices[i]) = posesAndScales[i].pose;
+    result.poses.col(blockStartIndices[i] + blockSeedIndices[i])
+        = posesAndScales[i].pose;
   }
   std::vector<bool> shouldProcessBlock;
   std::vector<s_t> lastBlockLoss;
@@ -3346,17 +3867,65 @@ MarkerInitialization MarkerFitter::getInitialization(
   // most numBlocks times
   for (int k = 0; k < params.numIKTries; k++)
   {
-    std::vector<std::future<void>> blockFitFutures;
+    common::ThreadPool& pool = common::ThreadPool::getGlobal();
+    std::vector<std::vector<std::future<void>>> blockFitFutures(numBlocks);
     for (int i = 0; i < numBlocks; i++)
     {
       std::cout << "Starting fit for whole block " << i << "/" << numBlocks
                 << std::endl;
 
-      if (shouldProcessBlock[i])
+      if (shouldProcessBlock[i] && mUseTemporalWarmStart && k == 0)
       {
-        blockFitFutures.push_back(std::async(
-            &MarkerFitter::fitTrajectory,
-            this,
+        // Fit forwards from the seed frame, and backwards from just before it.
+        // The two halves write disjoint columns, so they can run at the same
+        // time. Later retries fall through to the usual forward pass, seeded
+        // from the end of the previous block.
+        auto sliceBlock = [](const auto& block, int start, int length) {
+          return typename std::decay<decltype(block)>::type(
+              block.begin() + start, block.begin() + start + length);
+        };
+        int seed = blockSeedIndices[i];
+        int numForward = blockSizeIndices[i] - seed;
+        blockFitFutures[i].push_back(submitTrajectoryFit(
+            result.groupScales,
+            posesAndScales[i].pose,
+            sliceBlock(blocks[i], seed, numForward),
+            params.markerWeights,
+            params.markerOffsets,
+            params.joints,
+            sliceBlock(jointCenterBlocks[i], seed, numForward),
+            params.jointWeights,
+            sliceBlock(jointAxisBlocks[i], seed, numForward),
+            params.axisWeights,
+            result.poses.block(
+                0,
+                blockStartIndices[i] + seed,
+                mSkeleton->getNumDofs(),
+                numForward),
+            result.poseScores.segment(blockStartIndices[i] + seed, numForward),
+            false));
+        if (seed > 0)
+        {
+          blockFitFutures[i].push_back(submitTrajectoryFit(
+              result.groupScales,
+              posesAndScales[i].pose,
+              sliceBlock(blocks[i], 0, seed),
+              params.markerWeights,
+              params.markerOffsets,
+              params.joints,
+              sliceBlock(jointCenterBlocks[i], 0, seed),
+              params.jointWeights,
+              sliceBlock(jointAxisBlocks[i], 0, seed),
+              params.axisWeights,
+              result.poses.block(
+                  0, blockStartIndices[i], mSkeleton->getNumDofs(), seed),
+              result.poseScores.segment(blockStartIndices[i], seed),
+              true));
+        }
+      }
+      else if (shouldProcessBlock[i])
+      {
+        blockFitFutures[i].push_back(submitTrajectoryFit(
             result.groupScales,
             result.poses.col(blockStartIndices[i]),
             blocks[i],
@@ -3376,14 +3945,14 @@ MarkerInitialization MarkerFitter::getInitialization(
                 blockStartIndices[i], blockSizeIndices[i]),
             false));
       }
-      else
-      {
-        blockFitFutures.push_back(std::async([]() {}));
-      }
     }
     for (int i = 0; i < numBlocks; i++)
     {
-      blockFitFutures[i].get();
+      pool.waitAll(blockFitFutures[i]);
+      for (std::future<void>& future : blockFitFutures[i])
+      {
+        future.get();
+      }
       std::cout << "Finished fit for whole block " << i << "/" << numBlocks
                 << std::endl;
     }
@@ -3731,6 +4300,38 @@ ScaleAndFitResult MarkerFitter::scaleAndFit(
     inputNames.push_back("dof " + skeletonBallJoints->getDof(i)->getName());
   }
 
+  // Parallel IK restarts each need their own skeletons to write to, with the
+  // marker and joint lists translated over to point into them
+  struct IKWorkerSkeletons
+  {
+    std::shared_ptr<dynamics::Skeleton> skeleton;
+    std::shared_ptr<dynamics::Skeleton> skeletonBallJoints;
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markerVector;
+    std::vector<dynamics::Joint*> joints;
+  };
+  IKWorkerSkeletons original;
+  original.skeleton = skeleton;
+  original.skeletonBallJoints = skeletonBallJoints;
+  original.markerVector = markerVector;
+  original.joints = jointsForSkeletonBallJoints;
+  auto cloneIKWorkerSkeletons = [&original]() {
+    IKWorkerSkeletons copy;
+    copy.skeleton = original.skeleton->clone();
+    copy.skeletonBallJoints = copy.skeleton->convertSkeletonToBallJoints();
+    for (auto& marker : original.markerVector)
+    {
+      copy.markerVector.emplace_back(
+          copy.skeletonBallJoints->getBodyNode(marker.first->getName()),
+          marker.second);
+    }
+    for (dynamics::Joint* joint : original.joints)
+    {
+      copy.joints.push_back(
+          copy.skeletonBallJoints->getJoint(joint->getName()));
+    }
+    return copy;
+  };
+
   ScaleAndFitResult result;
   if (dontScale)
   {
@@ -3743,97 +4344,109 @@ ScaleAndFitResult MarkerFitter::scaleAndFit(
     initialPos = skeletonBallJoints->convertPositionsToBallSpace(
         skeletonBallJoints->getPositions());
 
-    // 2. Actually solve the IK
-    result.score = math::solveIK(
+    // 2. Actually solve the IK. The callbacks are built from an
+    // IKWorkerSkeletons, so each parallel restart can get its own copy.
+    auto makeSetPosAndClamp = [](IKWorkerSkeletons state) {
+      return [state](/* in*/ const Eigen::VectorXs pos, bool clamp) {
+        const dynamics::SkeletonPtr& skeleton = state.skeleton;
+        const dynamics::SkeletonPtr& skeletonBallJoints
+            = state.skeletonBallJoints;
+        skeletonBallJoints->setPositions(pos);
+        if (clamp)
+        {
+          // 1. Map the position back into eulerian space
+          skeleton->setPositions(
+              skeleton->convertPositionsFromBallSpace(pos));
+          // 2. Clamp the position to limits
+          skeleton->clampPositionsToLimits();
+          // 3. Map the position back into SO3 space
+          skeletonBallJoints->setPositions(
+              skeleton->convertPositionsToBallSpace(
+                  skeleton->getPositions()));
+        }
+
+        // Return the clamped position
+        return skeletonBallJoints->getPositions();
+      };
+    };
+    auto makeEval = [=](IKWorkerSkeletons state) {
+      return [=](/*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+                 /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
+        const dynamics::SkeletonPtr& skeletonBallJoints
+            = state.skeletonBallJoints;
+        const auto& markerVector = state.markerVector;
+        const auto& jointsForSkeletonBallJoints = state.joints;
+        diff.segment(0, markerPoses.size())
+            = skeletonBallJoints->getMarkerWorldPositions(markerVector)
+              - markerPoses;
+        Eigen::VectorXs jointPoses
+            = skeletonBallJoints->getJointWorldPositions(
+                jointsForSkeletonBallJoints);
+        computeJointIKDiff(
+            diff.segment(markerPoses.size(), jointCenters.size()),
+            jointPoses,
+            jointCenters,
+            jointWeights,
+            jointAxis,
+            axisWeights);
+
+        assert(jac.cols() == skeletonBallJoints->getNumDofs());
+        assert(
+            jac.rows()
+            == (markerVector.size() * 3)
+                   + (jointsForSkeletonBallJoints.size() * 3));
+        jac.setZero();
+        jac.block(
+            0, 0, markerVector.size() * 3, skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getMarkerWorldPositionsJacobianWrtJointPositions(
+                      markerVector);
+        jac.block(
+            markerVector.size() * 3,
+            0,
+            jointsForSkeletonBallJoints.size() * 3,
+            skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getJointWorldPositionsJacobianWrtJointPositions(
+                      jointsForSkeletonBallJoints);
+        for (int i = 0; i < markerWeightsVector.size(); i++)
+        {
+          diff.segment<3>(i * 3) *= markerWeightsVector(i);
+          jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
+        }
+        rescaleIKJacobianForWeightsAndAxis(
+            jac.block(
+                markerVector.size() * 3,
+                0,
+                jointsForSkeletonBallJoints.size() * 3,
+                skeletonBallJoints->getNumDofs()),
+            jointWeights,
+            jointAxis,
+            axisWeights);
+      };
+    };
+    result.score = math::solveIKParallel(
         initialPos,
         skeletonBallJoints->getPositionUpperLimits(),
         skeletonBallJoints->getPositionLowerLimits(),
         (markerObservations.size() * 3) + (joints.size() * 3),
         // Set positions
-        [&skeletonBallJoints, &skeleton](
-            /* in*/ const Eigen::VectorXs pos, bool clamp) {
-          skeletonBallJoints->setPositions(pos);
-          if (clamp)
-          {
-            // 1. Map the position back into eulerian space
-            skeleton->setPositions(
-                skeleton->convertPositionsFromBallSpace(pos));
-            // 2. Clamp the position to limits
-            skeleton->clampPositionsToLimits();
-            // 3. Map the position back into SO3 space
-            skeletonBallJoints->setPositions(
-                skeleton->convertPositionsToBallSpace(
-                    skeleton->getPositions()));
-          }
-
-          // Return the clamped position
-          return skeletonBallJoints->getPositions();
-        },
+        makeSetPosAndClamp(original),
         // Compute the Jacobian
-        [&skeletonBallJoints,
-         &markerPoses,
-         &markerVector,
-         &markerWeightsVector,
-         &jointsForSkeletonBallJoints,
-         &jointCenters,
-         &jointWeights,
-         &jointAxis,
-         &axisWeights](
-            /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
-            /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
-          diff.segment(0, markerPoses.size())
-              = skeletonBallJoints->getMarkerWorldPositions(markerVector)
-                - markerPoses;
-          Eigen::VectorXs jointPoses
-              = skeletonBallJoints->getJointWorldPositions(
-                  jointsForSkeletonBallJoints);
-          computeJointIKDiff(
-              diff.segment(markerPoses.size(), jointCenters.size()),
-              jointPoses,
-              jointCenters,
-              jointWeights,
-              jointAxis,
-              axisWeights);
-
-          assert(jac.cols() == skeletonBallJoints->getNumDofs());
-          assert(
-              jac.rows()
-              == (markerVector.size() * 3)
-                     + (jointsForSkeletonBallJoints.size() * 3));
-          jac.setZero();
-          jac.block(
-              0, 0, markerVector.size() * 3, skeletonBallJoints->getNumDofs())
-              = skeletonBallJoints
-                    ->getMarkerWorldPositionsJacobianWrtJointPositions(
-                        markerVector);
-          jac.block(
-              markerVector.size() * 3,
-              0,
-              jointsForSkeletonBallJoints.size() * 3,
-              skeletonBallJoints->getNumDofs())
-              = skeletonBallJoints
-                    ->getJointWorldPositionsJacobianWrtJointPositions(
-                        jointsForSkeletonBallJoints);
-          for (int i = 0; i < markerWeightsVector.size(); i++)
-          {
-            diff.segment<3>(i * 3) *= markerWeightsVector(i);
-            jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
-          }
-          rescaleIKJacobianForWeightsAndAxis(
-              jac.block(
-                  markerVector.size() * 3,
-                  0,
-                  jointsForSkeletonBallJoints.size() * 3,
-                  skeletonBallJoints->getNumDofs()),
-              jointWeights,
-              jointAxis,
-              axisWeights);
-        },
+        makeEval(original),
         // Generate a random restart position
         [&skeleton, &observedJoints](Eigen::Ref<Eigen::VectorXs> val) {
           val = skeleton->convertPositionsToBallSpace(
               skeleton->getRandomPoseForJoints(observedJoints));
         },
+        // Make a private copy of the callbacks for one restart worker
+        [&cloneIKWorkerSkeletons, &makeSetPosAndClamp, &makeEval]() {
+          IKWorkerSkeletons copy = cloneIKWorkerSkeletons();
+          math::IKWorker worker;
+          worker.setPosAndClamp = makeSetPosAndClamp(copy);
+          worker.eval = makeEval(copy);
+          return worker;
+        },
         math::IKConfig()
             .setMaxStepCount(150)
             .setConvergenceThreshold(1e-10)
@@ -3897,185 +4510,189 @@ ScaleAndFitResult MarkerFitter::scaleAndFit(
         skeletonBallJoints->getGroupScaleDim())
         = skeletonBallJoints->getGroupScalesUpperBound();
 
-    // 2. Actually solve the IK
-    result.score = math::solveIK(
+    // 2. Actually solve the IK. The callbacks are built from an
+    // IKWorkerSkeletons, so each parallel restart can get its own copy.
+    auto makeSetPosAndClamp = [](IKWorkerSkeletons state) {
+      return [state](/* in*/ const Eigen::VectorXs pos, bool clamp) {
+        const dynamics::SkeletonPtr& skeleton = state.skeleton;
+        const dynamics::SkeletonPtr& skeletonBallJoints
+            = state.skeletonBallJoints;
+        skeletonBallJoints->setPositions(
+            pos.segment(0, skeletonBallJoints->getNumDofs()));
+
+        /*
+        // Verify the translation is lossless
+        Eigen::VectorXs eulerPos = skeleton->convertPositionsFromBallSpace(
+            pos.segment(0, skeletonBallJoints->getNumDofs()));
+        Eigen::VectorXs recovered
+            = skeleton->convertPositionsToBallSpace(eulerPos);
+        Eigen::VectorXs bodyPoses = Eigen::VectorXs::Zero(
+            skeletonBallJoints->getNumBodyNodes() * 3);
+        for (int i = 0; i < skeletonBallJoints->getNumBodyNodes(); i++)
+        {
+          bodyPoses.segment<3>(i * 3) = skeletonBallJoints->getBodyNode(i)
+                                            ->getWorldTransform()
+                                            .translation();
+        }
+        skeletonBallJoints->setPositions(recovered);
+        Eigen::VectorXs recoveredBodyPoses = Eigen::VectorXs::Zero(
+            skeletonBallJoints->getNumBodyNodes() * 3);
+        for (int i = 0; i < skeletonBallJoints->getNumBodyNodes(); i++)
+        {
+          recoveredBodyPoses.segment<3>(i * 3)
+              = skeletonBallJoints->getBodyNode(i)
+                    ->getWorldTransform()
+                    .translation();
+        }
+        if ((recoveredBodyPoses - bodyPoses).norm() > 1e-3)
+        {
+          std::cout << "!!!!!! Got a recovery error of "
+                    << (recoveredBodyPoses - bodyPoses).norm() << std::endl;
+          std::cout << "Eigen::VectorXs pos = Eigen::VectorXs(" << pos.size()
+                    << ");" << std::endl;
+          std::cout << "pos << ";
+          for (int i = 0; i < pos.size(); i++)
+          {
+            if (i > 0)
+              std::cout << ", ";
+            std::cout << pos(i);
+          }
+          std::cout << ";" << std::endl;
+        }
+        // End: Verify the translation is lossless
+        */
+
+        if (clamp)
+        {
+          // 1. Map the position back into eulerian space
+          skeleton->setPositions(skeleton->convertPositionsFromBallSpace(
+              pos.segment(0, skeletonBallJoints->getNumDofs())));
+          // 2. Clamp the position to limits
+          skeleton->clampPositionsToLimits();
+          // 3. Map the position back into SO3 space
+          skeletonBallJoints->setPositions(
+              skeleton->convertPositionsToBallSpace(
+                  skeleton->getPositions()));
+        }
+
+        // Set scales
+        Eigen::VectorXs newScales = pos.segment(
+            skeletonBallJoints->getNumDofs(),
+            skeletonBallJoints->getGroupScaleDim());
+        Eigen::VectorXs scalesUpperBound
+            = skeletonBallJoints->getGroupScalesUpperBound();
+        Eigen::VectorXs scalesLowerBound
+            = skeletonBallJoints->getGroupScalesLowerBound();
+        newScales = newScales.cwiseMax(scalesLowerBound);
+        newScales = newScales.cwiseMin(scalesUpperBound);
+        skeleton->setGroupScales(newScales);
+        skeletonBallJoints->setGroupScales(newScales);
+
+        // Return the clamped position
+        Eigen::VectorXs clampedPos = Eigen::VectorXs::Zero(pos.size());
+        clampedPos.segment(0, skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints->getPositions();
+        clampedPos.segment(
+            skeletonBallJoints->getNumDofs(),
+            skeletonBallJoints->getGroupScaleDim())
+            = newScales;
+        return clampedPos;
+      };
+    };
+    auto makeEval = [=](IKWorkerSkeletons state) {
+      return [=](/*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+                 /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
+        const dynamics::SkeletonPtr& skeletonBallJoints
+            = state.skeletonBallJoints;
+        const auto& markerVector = state.markerVector;
+        const auto& jointsForSkeletonBallJoints = state.joints;
+        diff.segment(0, markerPoses.size())
+            = skeletonBallJoints->getMarkerWorldPositions(markerVector)
+              - markerPoses;
+        Eigen::VectorXs jointPoses
+            = skeletonBallJoints->getJointWorldPositions(
+                jointsForSkeletonBallJoints);
+        computeJointIKDiff(
+            diff.segment(markerPoses.size(), jointCenters.size()),
+            jointPoses,
+            jointCenters,
+            jointWeights,
+            jointAxis,
+            axisWeights);
+
+        assert(
+            jac.cols()
+            == skeletonBallJoints->getNumDofs()
+                   + skeletonBallJoints->getGroupScaleDim());
+        assert(
+            jac.rows()
+            == (markerVector.size() * 3)
+                   + (jointsForSkeletonBallJoints.size() * 3));
+        jac.setZero();
+        jac.block(
+            0, 0, markerVector.size() * 3, skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getMarkerWorldPositionsJacobianWrtJointPositions(
+                      markerVector);
+        jac.block(
+            0,
+            skeletonBallJoints->getNumDofs(),
+            markerVector.size() * 3,
+            skeletonBallJoints->getGroupScaleDim())
+            = skeletonBallJoints
+                  ->getMarkerWorldPositionsJacobianWrtGroupScalesSparse(
+                      markerVector);
+        for (int i = 0; i < markerWeightsVector.size(); i++)
+        {
+          diff.segment<3>(i * 3) *= markerWeightsVector(i);
+          jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
+        }
+
+        jac.block(
+            markerVector.size() * 3,
+            0,
+            jointsForSkeletonBallJoints.size() * 3,
+            skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getJointWorldPositionsJacobianWrtJointPositions(
+                      jointsForSkeletonBallJoints);
+        rescaleIKJacobianForWeightsAndAxis(
+            jac.block(
+                markerVector.size() * 3,
+                0,
+                jointsForSkeletonBallJoints.size() * 3,
+                skeletonBallJoints->getNumDofs()),
+            jointWeights,
+            jointAxis,
+            axisWeights);
+        jac.block(
+            markerVector.size() * 3,
+            skeletonBallJoints->getNumDofs(),
+            jointsForSkeletonBallJoints.size() * 3,
+            skeletonBallJoints->getGroupScaleDim())
+            = skeletonBallJoints
+                  ->getJointWorldPositionsJacobianWrtGroupScalesSparse(
+                      jointsForSkeletonBallJoints);
+        rescaleIKJacobianForWeightsAndAxis(
+            jac.block(
+                markerVector.size() * 3,
+                skeletonBallJoints->getNumDofs(),
+                jointsForSkeletonBallJoints.size() * 3,
+                skeletonBallJoints->getGroupScaleDim()),
+            jointWeights,
+            jointAxis,
+            axisWeights);
+      };
+    };
+    result.score = math::solveIKParallel(
         initialPos,
         upperBound,
         lowerBound,
         (markerObservations.size() * 3) + (joints.size() * 3),
         // Set positions
-        [&skeletonBallJoints, &skeleton](
-            /* in*/ const Eigen::VectorXs pos, bool clamp) {
-          skeletonBallJoints->setPositions(
-              pos.segment(0, skeletonBallJoints->getNumDofs()));
-
-          /*
-          // Verify the translation is lossless
-          Eigen::VectorXs eulerPos = skeleton->convertPositionsFromBallSpace(
-              pos.segment(0, skeletonBallJoints->getNumDofs()));
-          Eigen::VectorXs recovered
-              = skeleton->convertPositionsToBallSpace(eulerPos);
-          Eigen::VectorXs bodyPoses = Eigen::VectorXs::Zero(
-              skeletonBallJoints->getNumBodyNodes() * 3);
-          for (int i = 0; i < skeletonBallJoints->getNumBodyNodes(); i++)
-          {
-            bodyPoses.segment<3>(i * 3) = skeletonBallJoints->getBodyNode(i)
-                                              ->getWorldTransform()
-                                              .translation();
-          }
-          skeletonBallJoints->setPositions(recovered);
-          Eigen::VectorXs recoveredBodyPoses = Eigen::VectorXs::Zero(
-              skeletonBallJoints->getNumBodyNodes() * 3);
-          for (int i = 0; i < skeletonBallJoints->getNumBodyNodes(); i++)
-          {
-            recoveredBodyPoses.segment<3>(i * 3)
-                = skeletonBallJoints->getBodyNode(i)
-                      ->getWorldTransform()
-                      .translation();
-          }
-          if ((recoveredBodyPoses - bodyPoses).norm() > 1e-3)
-          {
-            std::cout << "!!!!!! Got a recovery error of "
-                      << (recoveredBodyPoses - bodyPoses).norm() << std::endl;
-            std::cout << "Eigen::VectorXs pos = Eigen::VectorXs(" << pos.size()
-                      << ");" << std::endl;
-            std::cout << "pos << ";
-            for (int i = 0; i < pos.size(); i++)
-            {
-              if (i > 0)
-                std::cout << ", ";
-              std::cout << pos(i);
-            }
-            std::cout << ";" << std::endl;
-          }
-          // End: Verify the translation is lossless
-          */
-
-          if (clamp)
-          {
-            // 1. Map the position back into eulerian space
-            skeleton->setPositions(skeleton->convertPositionsFromBallSpace(
-                pos.segment(0, skeletonBallJoints->getNumDofs())));
-            // 2. Clamp the position to limits
-            skeleton->clampPositionsToLimits();
-            // 3. Map the position back into SO3 space
-            skeletonBallJoints->setPositions(
-                skeleton->convertPositionsToBallSpace(
-                    skeleton->getPositions()));
-          }
-
-          // Set scales
-          Eigen::VectorXs newScales = pos.segment(
-              skeletonBallJoints->getNumDofs(),
-              skeletonBallJoints->getGroupScaleDim());
-          Eigen::VectorXs scalesUpperBound
-              = skeletonBallJoints->getGroupScalesUpperBound();
-          Eigen::VectorXs scalesLowerBound
-              = skeletonBallJoints->getGroupScalesLowerBound();
-          newScales = newScales.cwiseMax(scalesLowerBound);
-          newScales = newScales.cwiseMin(scalesUpperBound);
-          skeleton->setGroupScales(newScales);
-          skeletonBallJoints->setGroupScales(newScales);
-
-          // Return the clamped position
-          Eigen::VectorXs clampedPos = Eigen::VectorXs::Zero(pos.size());
-          clampedPos.segment(0, skeletonBallJoints->getNumDofs())
-              = skeletonBallJoints->getPositions();
-          clampedPos.segment(
-              skeletonBallJoints->getNumDofs(),
-              skeletonBallJoints->getGroupScaleDim())
-              = newScales;
-          return clampedPos;
-        },
+        makeSetPosAndClamp(original),
         // Compute the Jacobian
-        [&skeletonBallJoints,
-         &markerPoses,
-         &markerVector,
-         &markerWeightsVector,
-         &jointsForSkeletonBallJoints,
-         &jointCenters,
-         &jointWeights,
-         &jointAxis,
-         &axisWeights](
-            /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
-            /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
-          diff.segment(0, markerPoses.size())
-              = skeletonBallJoints->getMarkerWorldPositions(markerVector)
-                - markerPoses;
-          Eigen::VectorXs jointPoses
-              = skeletonBallJoints->getJointWorldPositions(
-                  jointsForSkeletonBallJoints);
-          computeJointIKDiff(
-              diff.segment(markerPoses.size(), jointCenters.size()),
-              jointPoses,
-              jointCenters,
-              jointWeights,
-              jointAxis,
-              axisWeights);
-
-          assert(
-              jac.cols()
-              == skeletonBallJoints->getNumDofs()
-                     + skeletonBallJoints->getGroupScaleDim());
-          assert(
-              jac.rows()
-              == (markerVector.size() * 3)
-                     + (jointsForSkeletonBallJoints.size() * 3));
-          jac.setZero();
-          jac.block(
-              0, 0, markerVector.size() * 3, skeletonBallJoints->getNumDofs())
-              = skeletonBallJoints
-                    ->getMarkerWorldPositionsJacobianWrtJointPositions(
-                        markerVector);
-          jac.block(
-              0,
-              skeletonBallJoints->getNumDofs(),
-              markerVector.size() * 3,
-              skeletonBallJoints->getGroupScaleDim())
-              = skeletonBallJoints
-                    ->getMarkerWorldPositionsJacobianWrtGroupScales(
-                        markerVector);
-          for (int i = 0; i < markerWeightsVector.size(); i++)
-          {
-            diff.segment<3>(i * 3) *= markerWeightsVector(i);
-            jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
-          }
-
-          jac.block(
-              markerVector.size() * 3,
-              0,
-              jointsForSkeletonBallJoints.size() * 3,
-              skeletonBallJoints->getNumDofs())
-              = skeletonBallJoints
-                    ->getJointWorldPositionsJacobianWrtJointPositions(
-                        jointsForSkeletonBallJoints);
-          rescaleIKJacobianForWeightsAndAxis(
-              jac.block(
-                  markerVector.size() * 3,
-                  0,
-                  jointsForSkeletonBallJoints.size() * 3,
-                  skeletonBallJoints->getNumDofs()),
-              jointWeights,
-              jointAxis,
-              axisWeights);
-          jac.block(
-              markerVector.size() * 3,
-              skeletonBallJoints->getNumDofs(),
-              jointsForSkeletonBallJoints.size() * 3,
-              skeletonBallJoints->getGroupScaleDim())
-              = skeletonBallJoints
-                    ->getJointWorldPositionsJacobianWrtGroupScales(
-                        jointsForSkeletonBallJoints);
-          rescaleIKJacobianForWeightsAndAxis(
-              jac.block(
-                  markerVector.size() * 3,
-                  skeletonBallJoints->getNumDofs(),
-                  jointsForSkeletonBallJoints.size() * 3,
-                  skeletonBallJoints->getGroupScaleDim()),
-              jointWeights,
-              jointAxis,
-              axisWeights);
-        },
+        makeEval(original),
         // Generate a random restart position
         [&skeletonBallJoints, &skeleton, &observedJoints](
             Eigen::Ref<Eigen::VectorXs> val) {
@@ -4087,6 +4704,14 @@ ScaleAndFitResult MarkerFitter::scaleAndFit(
                  skeletonBallJoints->getGroupScaleDim())
               .setConstant(1.0);
         },
+        // Make a private copy of the callbacks for one restart worker
+        [&cloneIKWorkerSkeletons, &makeSetPosAndClamp, &makeEval]() {
+          IKWorkerSkeletons copy = cloneIKWorkerSkeletons();
+          math::IKWorker worker;
+          worker.setPosAndClamp = makeSetPosAndClamp(copy);
+          worker.eval = makeEval(copy);
+          return worker;
+        },
         math::IKConfig()
             .setMaxStepCount(150)
             .setConvergenceThreshold(1e-10)
@@ -4244,8 +4869,114 @@ void MarkerFitter::fitTrajectory(
       assert(markerPoses.size() == markerVector.size() * 3);
       assert(centerPoses.size() == joints.size() * 3);
 
+      // If we're running Levenberg-Marquardt, work out which DOFs each row of
+      // the Jacobian can depend on. Joint centers sit on the child body of
+      // each joint, so they have the same structure as a marker there.
+      std::vector<std::vector<int>> jacobianSparsity;
+      if (fitter->mUseLevenbergMarquardtIK)
+      {
+        std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> points
+            = markerVector;
+        for (dynamics::Joint* joint : jointsForSkeletonBallJoints)
+        {
+          points.emplace_back(
+              joint->getChildBodyNode(), Eigen::Vector3s::Zero());
+        }
+        jacobianSparsity
+            = skeletonBallJoints->getMarkerJacobianSparsity(points);
+      }
+
       // 2.2. Actually run the IK solver
-      // Initialize at the old config
+      auto setPosAndClamp = [skeletonBallJoints, skeleton](
+                                /* in*/ const Eigen::VectorXs pos, bool clamp) {
+        skeletonBallJoints->setPositions(pos);
+        if (clamp)
+        {
+          // 1. Map the position back into eulerian space
+          skeleton->setPositions(
+              skeleton->convertPositionsFromBallSpace(pos));
+          // 2. Clamp the position to limits
+          skeleton->clampPositionsToLimits();
+          // 3. Map the position back into SO3 space
+          skeletonBallJoints->setPositions(
+              skeleton->convertPositionsToBallSpace(
+                  skeleton->getPositions()));
+        }
+
+        // Return the clamped position
+        return skeletonBallJoints->getPositions();
+      };
+      auto eval = [skeletonBallJoints,
+                   markerPoses,
+                   markerVector,
+                   markerWeightsVector,
+                   jointsForSkeletonBallJoints,
+                   centerPoses,
+                   jointWeights,
+                   axisPoses,
+                   axisWeights](
+                      /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+                      /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
+        assert(diff.size() == markerPoses.size() + centerPoses.size());
+
+        diff.segment(0, markerPoses.size())
+            = skeletonBallJoints->getMarkerWorldPositions(markerVector)
+              - markerPoses;
+        Eigen::VectorXs jointPoses
+            = skeletonBallJoints->getJointWorldPositions(
+                jointsForSkeletonBallJoints);
+        computeJointIKDiff(
+            diff.segment(markerPoses.size(), centerPoses.size()),
+            jointPoses,
+            centerPoses,
+            jointWeights,
+            axisPoses,
+            axisWeights);
+
+        assert(jac.cols() == skeletonBallJoints->getNumDofs());
+        assert(
+            jac.rows()
+            == (markerVector.size() * 3)
+                   + (jointsForSkeletonBallJoints.size() * 3));
+        jac.block(
+            0, 0, markerVector.size() * 3, skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getMarkerWorldPositionsJacobianWrtJointPositions(
+                      markerVector);
+        jac.block(
+            markerVector.size() * 3,
+            0,
+            jointsForSkeletonBallJoints.size() * 3,
+            skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getJointWorldPositionsJacobianWrtJointPositions(
+                      jointsForSkeletonBallJoints);
+        for (int i = 0; i < markerWeightsVector.size(); i++)
+        {
+          diff.segment<3>(i * 3) *= markerWeightsVector(i);
+          jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
+        }
+        rescaleIKJacobianForWeightsAndAxis(
+            jac.block(
+                markerVector.size() * 3,
+                0,
+                jointsForSkeletonBallJoints.size() * 3,
+                skeletonBallJoints->getNumDofs()),
+            jointWeights,
+            axisPoses,
+            axisWeights);
+      };
+
+      // Initialize at the old config, or if we're warm starting, carry the
+      // velocity of the last two frames forward. We extrapolate in Euler
+      // space, where the joint limits live.
+      if (fitter->mUseTemporalWarmStart && j >= 2)
+      {
+        int last = backwards ? i + 1 : i - 1;
+        int lastLast = backwards ? i + 2 : i - 2;
+        initialGuess = skeleton->convertPositionsToBallSpace(
+            2 * result.col(last) - result.col(lastLast));
+      }
 
       s_t finalLoss = math::solveIK(
           initialGuess,
@@ -4253,105 +4984,62 @@ void MarkerFitter::fitTrajectory(
           skeletonBallJoints->getPositionLowerLimits(),
           (markerVector.size() * 3) + (joints.size() * 3),
           // Set positions
-          [skeletonBallJoints, skeleton](
-              /* in*/ const Eigen::VectorXs pos, bool clamp) {
-            skeletonBallJoints->setPositions(pos);
-            if (clamp)
-            {
-              // 1. Map the position back into eulerian space
-              skeleton->setPositions(
-                  skeleton->convertPositionsFromBallSpace(pos));
-              // 2. Clamp the position to limits
-              skeleton->clampPositionsToLimits();
-              // 3. Map the position back into SO3 space
-              skeletonBallJoints->setPositions(
-                  skeleton->convertPositionsToBallSpace(
-                      skeleton->getPositions()));
-            }
-
-            // Return the clamped position
-            return skeletonBallJoints->getPositions();
+          setPosAndClamp,
+          // Compute the Jacobian
+          eval,
+          [initialGuess](Eigen::Ref<Eigen::VectorXs> val) {
+            assert(false);
+            val = initialGuess;
           },
-          [skeletonBallJoints,
-           markerPoses,
-           markerVector,
-           markerWeightsVector,
-           jointsForSkeletonBallJoints,
-           centerPoses,
-           jointWeights,
-           axisPoses,
-           axisWeights](
-              /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
-              /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
-            assert(diff.size() == markerPoses.size() + centerPoses.size());
+          math::IKConfig()
+              .setMaxStepCount(500)
+              .setConvergenceThreshold(1e-6)
+              .setDontExitTranspose(true)
+              .setLossLowerBound(1e-8)
+              .setMaxRestarts(1)
+              .setStartClamped(true)
+              .setLevenbergMarquardt(fitter->mUseLevenbergMarquardtIK)
+              .setJacobianSparsity(jacobianSparsity)
+              .setLogOutput(false)
+              .setInputNames(inputNames)
+              .setOutputNames(outputNames));
 
-            diff.segment(0, markerPoses.size())
-                = skeletonBallJoints->getMarkerWorldPositions(markerVector)
-                  - markerPoses;
-            Eigen::VectorXs jointPoses
-                = skeletonBallJoints->getJointWorldPositions(
-                    jointsForSkeletonBallJoints);
-            computeJointIKDiff(
-                diff.segment(markerPoses.size(), centerPoses.size()),
-                jointPoses,
-                centerPoses,
-                jointWeights,
-                axisPoses,
-                axisWeights);
-
-            assert(jac.cols() == skeletonBallJoints->getNumDofs());
-            assert(
-                jac.rows()
-                == (markerVector.size() * 3)
-                       + (jointsForSkeletonBallJoints.size() * 3));
-            jac.block(
-                0, 0, markerVector.size() * 3, skeletonBallJoints->getNumDofs())
-                = skeletonBallJoints
-                      ->getMarkerWorldPositionsJacobianWrtJointPositions(
-                          markerVector);
-            jac.block(
-                markerVector.size() * 3,
-                0,
-                jointsForSkeletonBallJoints.size() * 3,
-                skeletonBallJoints->getNumDofs())
-                = skeletonBallJoints
-                      ->getJointWorldPositionsJacobianWrtJointPositions(
-                          jointsForSkeletonBallJoints);
-            for (int i = 0; i < markerWeightsVector.size(); i++)
-            {
-              diff.segment<3>(i * 3) *= markerWeightsVector(i);
-              jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
-            }
-            rescaleIKJacobianForWeightsAndAxis(
-                jac.block(
-                    markerVector.size() * 3,
-                    0,
-                    jointsForSkeletonBallJoints.size() * 3,
-                    skeletonBallJoints->getNumDofs()),
-                jointWeights,
-                axisPoses,
-                axisWeights);
-          },
-          [initialGuess](Eigen::Ref<Eigen::VectorXs> val) {
-            assert(false);
-            val = initialGuess;
-          },
-          math::IKConfig()
-              .setMaxStepCount(500)
-              .setConvergenceThreshold(1e-6)
-              .setDontExitTranspose(true)
-              .setLossLowerBound(1e-8)
-              .setMaxRestarts(1)
-              .setStartClamped(true)
-              .setLogOutput(false)
-              .setInputNames(inputNames)
-              .setOutputNames(outputNames));
+      // 2.3. If the warm start landed somewhere bad (e.g. the subject moved
+      // suddenly, or markers dropped out), fall back to random restarts. The
+      // warm-started solution is restart 0, so this can only help.
+      if (fitter->mUseTemporalWarmStart
+          && finalLoss > fitter->mInitialIKSatisfactoryLoss)
+      {
+        finalLoss = math::solveIK(
+            skeletonBallJoints->getPositions(),
+            skeletonBallJoints->getPositionUpperLimits(),
+            skeletonBallJoints->getPositionLowerLimits(),
+            (markerVector.size() * 3) + (joints.size() * 3),
+            setPosAndClamp,
+            eval,
+            [&skeleton, &observedJoints](Eigen::Ref<Eigen::VectorXs> val) {
+              val = skeleton->convertPositionsToBallSpace(
+                  skeleton->getRandomPoseForJoints(observedJoints));
+            },
+            math::IKConfig()
+                .setMaxStepCount(500)
+                .setConvergenceThreshold(1e-6)
+                .setDontExitTranspose(true)
+                .setLossLowerBound(fitter->mInitialIKSatisfactoryLoss)
+                .setMaxRestarts(fitter->mInitialIKMaxRestarts)
+                .setStartClamped(true)
+                .setLevenbergMarquardt(fitter->mUseLevenbergMarquardtIK)
+                .setJacobianSparsity(jacobianSparsity)
+                .setLogOutput(false)
+                .setInputNames(inputNames)
+                .setOutputNames(outputNames));
+      }
 
-      // 2.3. Record this outcome
+      // 2.4. Record this outcome
       result.col(i) = skeleton->getPositions();
       resultScores(i) = finalLoss;
 
-      // 2.4. Set up for the next iteration, by setting the initial guess to the
+      // 2.5. Set up for the next iteration, by setting the initial guess to the
       // current solve
       initialGuess = skeletonBallJoints->getPositions();
     }
@@ -4422,6 +5110,22 @@ void MarkerFitter::fitTrajectory(
             originalMarker.second + offset);
       }
 
+      // If we're running Levenberg-Marquardt, work out which DOFs each row of
+      // the Jacobian can depend on. Joint centers sit on the child body of
+      // each joint, so they have the same structure as a marker there.
+      std::vector<std::vector<int>> jacobianSparsity;
+      if (fitter->mUseLevenbergMarquardtIK)
+      {
+        std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> points
+            = markerVector;
+        for (dynamics::Joint* joint : joints)
+        {
+          points.emplace_back(
+              joint->getChildBodyNode(), Eigen::Vector3s::Zero());
+        }
+        jacobianSparsity = skeleton->getMarkerJacobianSparsity(points);
+      }
+
       // 2.2. Actually run the IK solver
       // Initialize at the old config
 
@@ -4506,6 +5210,8 @@ void MarkerFitter::fitTrajectory(
               .setLossLowerBound(1e-8)
               .setMaxRestarts(1)
               .setStartClamped(true)
+              .setLevenbergMarquardt(fitter->mUseLevenbergMarquardtIK)
+              .setJacobianSparsity(jacobianSparsity)
               .setLogOutput(false));
 
       // 2.3. Record this outcome
@@ -4577,7 +5283,24 @@ void MarkerFitter::findJointCenters(
     exit(1);
   }
 
-  // 2. Actually compute the joint centers (multi threaded)
+  // 2. Get the world positions of all the joints at every timestep in a
+  // single pass over the poses, rather than re-running forward kinematics
+  // once per joint
+  Eigen::MatrixXs jointWorldPositions = Eigen::MatrixXs::Zero(
+      initialization.joints.size() * 3, markerObservations.size());
+  Eigen::VectorXs originalPosition = mSkeleton->getPositions();
+  for (int t = 0; t < markerObservations.size(); t++)
+  {
+    mSkeleton->setPositions(initialization.poses.col(t));
+    jointWorldPositions.col(t)
+        = mSkeleton->getJointWorldPositions(initialization.joints);
+  }
+  mSkeleton->setPositions(originalPosition);
+
+  // 3. Actually compute the joint centers (multi threaded). Problems built
+  // from precomputed joint positions don't touch the skeleton, so each task
+  // sets up its own problem as well as solving it.
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
   std::vector<std::future<std::shared_ptr<SphereFitJointCenterProblem>>>
       futures;
   for (int i = 0; i < initialization.joints.size(); i++)
@@ -4586,23 +5309,36 @@ void MarkerFitter::findJointCenters(
               << initialization.joints.size() << ": \""
               << initialization.joints[i]->getName() << "\"" << std::endl;
 
-    std::shared_ptr<SphereFitJointCenterProblem> problemPtr
-        = std::make_shared<SphereFitJointCenterProblem>(
-            this,
-            markerObservations,
-            initialization.poses,
-            initialization.joints[i],
-            newClip,
-            initialization.jointCenters.block(
-                i * 3, 0, 3, markerObservations.size()));
-    initialization.jointsAdjacentMarkers.push_back(problemPtr->mActiveMarkers);
-
-    futures.push_back(std::async(
-        [this, problemPtr] { return this->findJointCenter(problemPtr); }));
+    dynamics::Joint* joint = initialization.joints[i];
+    Eigen::Ref<Eigen::MatrixXs> out = initialization.jointCenters.block(
+        i * 3, 0, 3, markerObservations.size());
+    futures.push_back(pool.submit([this,
+                                   &markerObservations,
+                                   &jointWorldPositions,
+                                   &newClip,
+                                   joint,
+                                   out,
+                                   i] {
+      std::shared_ptr<SphereFitJointCenterProblem> problemPtr
+          = std::make_shared<SphereFitJointCenterProblem>(
+              this,
+              markerObservations,
+              joint,
+              jointWorldPositions.block(
+                  i * 3, 0, 3, markerObservations.size()),
+              newClip,
+              out);
+      return this->findJointCenter(problemPtr);
+    }));
   }
+  // Wait for every task before get() can throw, since the tasks refer to
+  // locals on this stack
+  pool.waitAll(futures);
   for (int i = 0; i < futures.size(); i++)
   {
-    s_t loss = futures[i].get()->saveSolutionBackToInitialization();
+    std::shared_ptr<SphereFitJointCenterProblem> problemPtr = futures[i].get();
+    initialization.jointsAdjacentMarkers.push_back(problemPtr->mActiveMarkers);
+    s_t loss = problemPtr->saveSolutionBackToInitialization();
     initialization.jointLoss(i) = loss / markerObservations.size();
     std::cout << "Finished computing joint center for " << i << "/"
               << initialization.joints.size() << ": \""
@@ -4617,6 +5353,20 @@ std::shared_ptr<SphereFitJointCenterProblem> MarkerFitter::findJointCenter(
     std::shared_ptr<SphereFitJointCenterProblem> problemPtr, bool logSteps)
 {
   SphereFitJointCenterProblem* problem = problemPtr.get();
+  problem->initializeWithLeastSquaresFit();
+
+  if (mUseLBFGSBForJointFits)
+  {
+    s_t initialLoss = problem->getLoss();
+    math::LBFGSB solver(
+        math::LBFGSBConfig().setMaxIterations(500).setLogOutput(logSteps));
+    math::LBFGSBResult result = solver.minimizeProblem(*problem);
+    std::cout << "Sphere-fitting \"" << problemPtr->mJointName << "\""
+              << ": initial loss=" << (initialLoss / problemPtr->mNumTimesteps)
+              << ", final loss=" << (result.loss / problemPtr->mNumTimesteps)
+              << std::endl;
+    return problemPtr;
+  }
 
   s_t lr = 1.0;
   Eigen::VectorXs x = problem->flatten();
@@ -4718,7 +5468,31 @@ void MarkerFitter::findAllJointAxis(
   }
   */
 
-  // 2. Actually compute the joint centers (multi threaded)
+  // 2. Get the world positions and relative rotations of all the joints at
+  // every timestep in a single pass over the poses, rather than re-running
+  // forward kinematics once per joint
+  Eigen::MatrixXs jointWorldPositions = Eigen::MatrixXs::Zero(
+      initialization.joints.size() * 3, markerObservations.size());
+  Eigen::MatrixXs jointAngleAxis = Eigen::MatrixXs::Zero(
+      initialization.joints.size() * 3, markerObservations.size());
+  Eigen::VectorXs originalPosition = mSkeleton->getPositions();
+  for (int t = 0; t < markerObservations.size(); t++)
+  {
+    mSkeleton->setPositions(initialization.poses.col(t));
+    jointWorldPositions.col(t)
+        = mSkeleton->getJointWorldPositions(initialization.joints);
+    for (int i = 0; i < initialization.joints.size(); i++)
+    {
+      jointAngleAxis.block<3, 1>(i * 3, t) = math::logMap(
+          initialization.joints[i]->getRelativeTransform().linear());
+    }
+  }
+  mSkeleton->setPositions(originalPosition);
+
+  // 3. Actually compute the joint axis (multi threaded). Problems built from
+  // precomputed joint positions don't touch the skeleton, so each task sets
+  // up its own problem as well as solving it.
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
   std::vector<std::future<std::shared_ptr<CylinderFitJointAxisProblem>>>
       futures;
   for (int i = 0; i < initialization.joints.size(); i++)
@@ -4727,21 +5501,35 @@ void MarkerFitter::findAllJointAxis(
               << initialization.joints.size() << ": \""
               << initialization.joints[i]->getName() << "\"" << std::endl;
 
-    std::shared_ptr<CylinderFitJointAxisProblem> problemPtr
-        = std::make_shared<CylinderFitJointAxisProblem>(
-            this,
-            markerObservations,
-            initialization.poses,
-            initialization.joints[i],
-            initialization.jointCenters.block(
-                i * 3, 0, 3, markerObservations.size()),
-            newClip,
-            initialization.jointAxis.block(
-                i * 6, 0, 6, markerObservations.size()));
-
-    futures.push_back(std::async(
-        [this, problemPtr] { return this->findJointAxis(problemPtr); }));
+    dynamics::Joint* joint = initialization.joints[i];
+    Eigen::Ref<Eigen::MatrixXs> out = initialization.jointAxis.block(
+        i * 6, 0, 6, markerObservations.size());
+    futures.push_back(pool.submit([this,
+                                   &initialization,
+                                   &markerObservations,
+                                   &jointWorldPositions,
+                                   &jointAngleAxis,
+                                   &newClip,
+                                   joint,
+                                   out,
+                                   i] {
+      int numTimesteps = markerObservations.size();
+      std::shared_ptr<CylinderFitJointAxisProblem> problemPtr
+          = std::make_shared<CylinderFitJointAxisProblem>(
+              this,
+              markerObservations,
+              joint,
+              jointWorldPositions.block(i * 3, 0, 3, numTimesteps),
+              jointAngleAxis.block(i * 3, 0, 3, numTimesteps),
+              initialization.jointCenters.block(i * 3, 0, 3, numTimesteps),
+              newClip,
+              out);
+      return this->findJointAxis(problemPtr);
+    }));
   }
+  // Wait for every task before get() can throw, since the tasks refer to
+  // locals on this stack
+  pool.waitAll(futures);
   for (int i = 0; i < futures.size(); i++)
   {
     s_t loss = futures[i].get()->saveSolutionBackToInitialization();
@@ -4761,6 +5549,19 @@ std::shared_ptr<CylinderFitJointAxisProblem> MarkerFitter::findJointAxis(
 {
   CylinderFitJointAxisProblem* problem = problemPtr.get();
 
+  if (mUseLBFGSBForJointFits)
+  {
+    s_t initialLoss = problem->getLoss();
+    math::LBFGSB solver(
+        math::LBFGSBConfig().setMaxIterations(500).setLogOutput(logSteps));
+    math::LBFGSBResult result = solver.minimizeProblem(*problem);
+    std::cout << "Cylinder fitting \"" << problemPtr->mJointName << "\""
+              << ": initial loss=" << (initialLoss / problemPtr->mNumTimesteps)
+              << ", final loss=" << (result.loss / problemPtr->mNumTimesteps)
+              << std::endl;
+    return problemPtr;
+  }
+
   s_t lr = 1.0;
   Eigen::VectorXs x = problem->flatten();
 
@@ -4988,6 +5789,15 @@ void MarkerFitter::setTrackingMarkerDefaultWeight(s_t weight)
   mTrackingMarkerDefaultWeight = weight;
 }
 
+//==============================================================================
+/// If set to true, findJointCenter() and findJointAxis() solve their (small,
+/// unconstrained) fits with the in-process L-BFGS solver in math::LBFGSB,
+/// rather than with a fixed 500 steps of adagrad. Defaults to false.
+void MarkerFitter::setUseLBFGSBForJointFits(bool useLBFGSB)
+{
+  mUseLBFGSBForJointFits = useLBFGSB;
+}
+
 //==============================================================================
 /// This returns a score summarizing how much the markers attached to this
 /// joint move relative to one another.
@@ -5210,6 +6020,40 @@ int MarkerFitter::getMarkerIndex(std::string name)
   return mMarkerIndices[name];
 }
 
+//==============================================================================
+/// This translates columnar marker observations into the (marker index, world
+/// position) pairs that getMarkerError() and friends take, one list per frame.
+/// Marker names are resolved once up front, so this doesn't build or search a
+/// map per frame. Markers this fitter doesn't know are skipped.
+std::vector<std::vector<std::pair<int, Eigen::Vector3s>>>
+MarkerFitter::getVisibleMarkerWorldPoses(
+    const MarkerTrajectories& trajectories)
+{
+  // Map each column of the trajectories to our own marker index, or -1
+  std::vector<int> fitterIndices;
+  for (const std::string& name : trajectories.getMarkerNames())
+  {
+    auto it = mMarkerIndices.find(name);
+    fitterIndices.push_back(it == mMarkerIndices.end() ? -1 : it->second);
+  }
+
+  std::vector<std::vector<std::pair<int, Eigen::Vector3s>>> result;
+  result.reserve(trajectories.getNumFrames());
+  for (int t = 0; t < trajectories.getNumFrames(); t++)
+  {
+    result.emplace_back();
+    for (const auto& observation : trajectories.getFrame(t))
+    {
+      int index = fitterIndices[observation.markerIndex];
+      if (index != -1)
+      {
+        result.back().emplace_back(index, observation.position);
+      }
+    }
+  }
+  return result;
+}
+
 //==============================================================================
 /// This method will set `skeleton` to the configuration given by the vectors
 /// of jointPositions and groupScales. It will also compute and return the
@@ -5290,6 +6134,25 @@ void MarkerFitter::setInitialIKMaxRestarts(int restarts)
   mInitialIKMaxRestarts = restarts;
 }
 
+//==============================================================================
+/// If true, the per-frame IK in the initialization seeds each frame with a
+/// constant-velocity extrapolation of the last two solutions, and only falls
+/// back to random restarts on frames that miss
+/// setInitialIKSatisfactoryLoss(). Each block is also fit outwards from its
+/// center frame, with the forward and backward halves run in parallel.
+void MarkerFitter::setUseTemporalWarmStart(bool useWarmStart)
+{
+  mUseTemporalWarmStart = useWarmStart;
+}
+
+//==============================================================================
+/// If true, the per-frame IK in the initialization takes Levenberg-Marquardt
+/// steps over the sparse marker and joint Jacobians
+void MarkerFitter::setUseLevenbergMarquardtIK(bool useLevenbergMarquardt)
+{
+  mUseLevenbergMarquardtIK = useLevenbergMarquardt;
+}
+
 //==============================================================================
 /// Sets the maximum that we'll allow markers to move from their original
 /// position, in meters
@@ -5321,6 +6184,7 @@ void MarkerFitter::setCustomLossAndGrad(
     std::function<s_t(MarkerFitterState*)> customLossAndGrad)
 {
   mLossAndGrad = customLossAndGrad;
+  mHasCustomLossAndGrad = true;
 }
 
 //==============================================================================
@@ -5397,7 +6261,7 @@ Eigen::VectorXs MarkerFitter::getMarkerLossGradientWrtGroupScales(
     const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
     Eigen::VectorXs lossGradWrtMarkerError)
 {
-  return skeleton->getMarkerWorldPositionsJacobianWrtGroupScales(markers)
+  return skeleton->getMarkerWorldPositionsJacobianWrtGroupScalesSparse(markers)
              .transpose()
          * lossGradWrtMarkerError;
 }
@@ -5663,7 +6527,7 @@ Eigen::MatrixXs MarkerFitter::getMarkerErrorJacobianWrtGroupScales(
     const std::vector<int>& sparsityMap)
 {
   Eigen::MatrixXs jac
-      = skeleton->getMarkerWorldPositionsJacobianWrtGroupScales(markers);
+      = skeleton->getMarkerWorldPositionsJacobianWrtGroupScalesSparse(markers);
 
   // Clear out the sections of the Jacobian that were not observed, since
   // those won't change the error
@@ -5738,11 +6602,20 @@ Eigen::MatrixXs MarkerFitter::getIKLossGradientWrtJointsJacobianWrtGroupScales(
   // (d/dq markerError) is getMarkerErrorJacobianWrtJoints(...)
   // markerError.transpose() * (d/dq firstOrderJac) is secondOrderJac
 
-  return 2
-         * ((firstOrderJac.transpose()
-             * getMarkerErrorJacobianWrtGroupScales(
-                 skeleton, markers, sparsityMap))
-            + secondOrderJac);
+  // This is getMarkerErrorJacobianWrtGroupScales(), but kept sparse for the
+  // product, since each marker only depends on the groups above it
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor> errorJac
+      = skeleton->getMarkerWorldPositionsJacobianWrtGroupScalesSparse(markers);
+  std::vector<bool> unobserved(markers.size(), false);
+  for (int i : sparsityMap)
+  {
+    unobserved[i] = true;
+  }
+  errorJac.prune([&](const Eigen::Index& row, const Eigen::Index&, const s_t&) {
+    return !unobserved[row / 3];
+  });
+
+  return 2 * ((firstOrderJac.transpose() * errorJac) + secondOrderJac);
 }
 
 //==============================================================================
@@ -5949,6 +6822,232 @@ void MarkerFitter::setCheckDerivatives(bool checkDerivatives)
   mCheckDerivatives = checkDerivatives;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+/// If true, the bilevel fit gives IPOPT a Gauss-Newton approximation of the
+/// Hessian (from the marker and joint center Jacobians) instead of having it
+/// build up an LBFGS approximation. That takes fewer, larger steps on the
+/// default least-squares loss. With a custom loss, the curvature still only
+/// comes from the squared marker and joint center errors.
+void MarkerFitter::setUseGaussNewtonHessian(bool useGaussNewtonHessian)
+{
+  mUseGaussNewtonHessian = useGaussNewtonHessian;
+}
+
+//==============================================================================
+/// If true (the default), runMultiTrialKinematicsPipeline() runs the
+/// per-trial stages on separate trials at the same time, each with its own
+/// copy of the skeleton. This is ignored if you've called
+/// setCustomLossAndGrad() or addZeroConstraint(), since those functions may
+/// not be safe to call from several threads at once.
+void MarkerFitter::setParallelizeTrials(bool parallelizeTrials)
+{
+  mParallelizeTrials = parallelizeTrials;
+}
+
+//==============================================================================
+/// If `windowSize` is greater than 0, runKinematicsPipeline() fits trials
+/// longer than `windowSize` timesteps with optimizeBilevelWindowed() instead
+/// of optimizeBilevel(), and its `numSamples` becomes the number of poses
+/// sampled from each window. This defaults to 0, which is off.
+void MarkerFitter::setBilevelWindow(
+    int windowSize, int windowOverlap, int numRounds)
+{
+  mBilevelWindowSize = windowSize;
+  mBilevelWindowOverlap = windowOverlap;
+  mBilevelWindowRounds = numRounds;
+}
+
+//==============================================================================
+/// If this is set, the blocks of per-frame IK that the initialization
+/// would otherwise fit on the global thread pool get handed to `dispatcher`
+/// instead, which can run them on other machines. Pass nullptr (the
+/// default) to fit everything locally.
+void MarkerFitter::setTrajectoryFitDispatcher(
+    std::shared_ptr<TrajectoryFitDispatcher> dispatcher)
+{
+  mTrajectoryFitDispatcher = dispatcher;
+}
+
+//==============================================================================
+/// This starts a fitTrajectory() call, either on the global thread pool or
+/// through our TrajectoryFitDispatcher, if we have one
+std::future<void> MarkerFitter::submitTrajectoryFit(
+    Eigen::VectorXs groupScales,
+    Eigen::VectorXs firstPoseGuess,
+    std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations,
+    std::map<std::string, s_t> markerWeights,
+    std::map<std::string, Eigen::Vector3s> markerOffsets,
+    std::vector<dynamics::Joint*> joints,
+    std::vector<Eigen::VectorXs> jointCenters,
+    Eigen::VectorXs jointWeights,
+    std::vector<Eigen::VectorXs> jointAxis,
+    Eigen::VectorXs axisWeights,
+    Eigen::Ref<Eigen::MatrixXs> result,
+    Eigen::Ref<Eigen::VectorXs> resultScores,
+    bool backwards)
+{
+  if (mTrajectoryFitDispatcher)
+  {
+    return mTrajectoryFitDispatcher->submit(
+        this,
+        groupScales,
+        firstPoseGuess,
+        markerObservations,
+        markerWeights,
+        markerOffsets,
+        joints,
+        jointCenters,
+        jointWeights,
+        jointAxis,
+        axisWeights,
+        result,
+        resultScores,
+        backwards);
+  }
+  return common::ThreadPool::getGlobal().submit(
+      &MarkerFitter::fitTrajectory,
+      this,
+      groupScales,
+      firstPoseGuess,
+      markerObservations,
+      markerWeights,
+      markerOffsets,
+      joints,
+      jointCenters,
+      jointWeights,
+      jointAxis,
+      axisWeights,
+      result,
+      resultScores,
+      backwards);
+}
+
+//==============================================================================
+/// This makes an independent copy of this fitter, with the same settings
+/// but its own clone of the skeleton, so that separate trials can be
+/// processed at the same time
+std::shared_ptr<MarkerFitter> MarkerFitter::cloneForTrial()
+{
+  std::shared_ptr<dynamics::Skeleton> skel = mSkeleton->cloneSkeleton();
+  dynamics::MarkerMap markers;
+  for (auto pair : mMarkerMap)
+  {
+    markers[pair.first] = std::make_pair(
+        skel->getBodyNode(pair.second.first->getName()), pair.second.second);
+  }
+  // Our markers have already been filtered, so the copy doesn't need to
+  // filter them again
+  std::shared_ptr<MarkerFitter> fitter
+      = std::make_shared<MarkerFitter>(skel, markers, false);
+
+  fitter->mMarkerIsTracking = mMarkerIsTracking;
+  fitter->mAnthropometrics = mAnthropometrics;
+  fitter->mAnthropometricWeight = mAnthropometricWeight;
+  fitter->mInitialIKSatisfactoryLoss = mInitialIKSatisfactoryLoss;
+  fitter->mInitialIKMaxRestarts = mInitialIKMaxRestarts;
+  fitter->mUseTemporalWarmStart = mUseTemporalWarmStart;
+  fitter->mUseLevenbergMarquardtIK = mUseLevenbergMarquardtIK;
+  fitter->mTrajectoryFitDispatcher = mTrajectoryFitDispatcher;
+  fitter->mMaxMarkerOffset = mMaxMarkerOffset;
+  fitter->mMinVarianceCutoff = mMinVarianceCutoff;
+  fitter->mMinSphereFitScore = mMinSphereFitScore;
+  fitter->mMinAxisFitScore = mMinAxisFitScore;
+  fitter->mMaxJointWeight = mMaxJointWeight;
+  fitter->mMaxAxisWeight = mMaxAxisWeight;
+  fitter->mDebugJointVariability = mDebugJointVariability;
+  fitter->mRegularizeTrackingMarkerOffsets = mRegularizeTrackingMarkerOffsets;
+  fitter->mRegularizeAnatomicalMarkerOffsets
+      = mRegularizeAnatomicalMarkerOffsets;
+  fitter->mRegularizeIndividualBodyScales = mRegularizeIndividualBodyScales;
+  fitter->mRegularizeAllBodyScales = mRegularizeAllBodyScales;
+  fitter->mAnatomicalMarkerDefaultWeight = mAnatomicalMarkerDefaultWeight;
+  fitter->mTrackingMarkerDefaultWeight = mTrackingMarkerDefaultWeight;
+  fitter->mUseLBFGSBForJointFits = mUseLBFGSBForJointFits;
+  fitter->mTolerance = mTolerance;
+  fitter->mIterationLimit = mIterationLimit;
+  fitter->mLBFGSHistoryLength = mLBFGSHistoryLength;
+  fitter->mCheckDerivatives = mCheckDerivatives;
+  fitter->mPrintFrequency = mPrintFrequency;
+  fitter->mSilenceOutput = mSilenceOutput;
+  fitter->mDisableLinesearch = mDisableLinesearch;
+  fitter->mUseGaussNewtonHessian = mUseGaussNewtonHessian;
+  fitter->mBilevelWindowSize = mBilevelWindowSize;
+  fitter->mBilevelWindowOverlap = mBilevelWindowOverlap;
+  fitter->mBilevelWindowRounds = mBilevelWindowRounds;
+  // The copies already run side by side, so they shouldn't fan out again
+  fitter->mParallelizeTrials = false;
+  return fitter;
+}
+
+//==============================================================================
+/// This points the joints and markers in `init`, which came from a fitter
+/// made by cloneForTrial(), back at our own skeleton
+void MarkerFitter::rebindInitialization(MarkerInitialization& init)
+{
+  for (int i = 0; i < init.joints.size(); i++)
+  {
+    init.joints[i] = mSkeleton->getJoint(init.joints[i]->getName());
+  }
+  for (auto& pair : init.updatedMarkerMap)
+  {
+    pair.second.first = mSkeleton->getBodyNode(pair.second.first->getName());
+  }
+}
+
+//==============================================================================
+/// This runs `pipeline` once for each of `numTrials` trials, and returns
+/// the results in trial order. If `parallel` is true, and it's safe to, each
+/// trial runs on the global thread pool with a fitter from cloneForTrial().
+/// Otherwise the trials run one after another on this fitter.
+std::vector<MarkerInitialization> MarkerFitter::runOnEachTrial(
+    int numTrials,
+    bool parallel,
+    std::function<MarkerInitialization(MarkerFitter* fitter, int trial)>
+        pipeline)
+{
+  std::vector<MarkerInitialization> results(numTrials);
+  if (!parallel || !mParallelizeTrials || mHasCustomLossAndGrad
+      || mZeroConstraints.size() > 0 || numTrials <= 1)
+  {
+    for (int i = 0; i < numTrials; i++)
+    {
+      results[i] = pipeline(this, i);
+    }
+    return results;
+  }
+
+  // Make the copies up front on this thread, since cloning reads (and can
+  // lazily update) our skeleton
+  std::vector<std::shared_ptr<MarkerFitter>> fitters;
+  for (int i = 0; i < numTrials; i++)
+  {
+    fitters.push_back(cloneForTrial());
+  }
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < numTrials; i++)
+  {
+    futures.push_back(pool.submit([&results, &fitters, &pipeline, i]() {
+      results[i] = pipeline(fitters[i].get(), i);
+    }));
+  }
+  // Wait for every trial before get() can throw, since the tasks refer to
+  // locals on this stack
+  pool.waitAll(futures);
+  for (int i = 0; i < numTrials; i++)
+  {
+    futures[i].get();
+  }
+
+  // The copies are about to go away, so point the results at our skeleton
+  for (int i = 0; i < numTrials; i++)
+  {
+    rebindInitialization(results[i]);
+  }
+  return results;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 // The SphereFitJointCenterProblem, which maps the sphere-fitting joint-center
 // problem onto a differentiable format.
@@ -5963,8 +7062,30 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
     dynamics::Joint* joint,
     const std::vector<bool>& newClip,
     Eigen::Ref<Eigen::MatrixXs> out)
+  : SphereFitJointCenterProblem(
+      fitter,
+      markerObservations,
+      joint,
+      getJointWorldPositions(fitter, ikPoses, joint),
+      newClip,
+      out)
+{
+}
+
+//==============================================================================
+/// This is the same as above, except that it takes the world position of the
+/// joint at each timestep (as a 3 x T matrix) instead of IK poses. That means
+/// it never touches the skeleton, so problems for different joints can be
+/// constructed at the same time.
+SphereFitJointCenterProblem::SphereFitJointCenterProblem(
+    MarkerFitter* fitter,
+    const std::vector<std::map<std::string, Eigen::Vector3s>>&
+        markerObservations,
+    dynamics::Joint* joint,
+    const Eigen::MatrixXs& jointWorldPositions,
+    const std::vector<bool>& newClip,
+    Eigen::Ref<Eigen::MatrixXs> out)
   : mFitter(fitter),
-    mMarkerObservations(markerObservations),
     mOut(out),
     mJointName(joint->getName()),
     mNewClip(newClip),
@@ -5985,7 +7106,7 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
       // divide by zeros
       for (int i = 0; i < mNumTimesteps; i++)
       {
-        if (mMarkerObservations[i].count(pair.first) > 0)
+        if (markerObservations[i].count(pair.first) > 0)
         {
           mActiveMarkers.push_back(pair.first);
           break;
@@ -6017,41 +7138,32 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
   Eigen::VectorXi numRadiiObservations
       = Eigen::VectorXi::Zero(mActiveMarkers.size());
 
-  Eigen::VectorXs originalPosition = mFitter->mSkeleton->getPositions();
-  std::vector<dynamics::Joint*> jointVec;
-  jointVec.push_back(joint);
-
   for (int i = 0; i < mNumTimesteps; i++)
   {
-    mFitter->mSkeleton->setPositions(ikPoses.col(i));
-    mCenterPoints.segment<3>(i * 3)
-        = mFitter->mSkeleton->getJointWorldPositions(jointVec);
+    mCenterPoints.segment<3>(i * 3) = jointWorldPositions.col(i);
     for (int j = 0; j < mActiveMarkers.size(); j++)
     {
-      std::string name = mActiveMarkers[j];
-      if (mMarkerObservations[i].count(name) > 0)
+      const std::string& name = mActiveMarkers[j];
+      auto observed = markerObservations[i].find(name);
+      if (observed != markerObservations[i].end())
       {
 #ifndef NDEBUG
-        if (mMarkerObservations[i][name].hasNaN())
+        if (observed->second.hasNaN())
         {
           std::cout << "MARKER NaN DETECTED!! timestep " << i << " name "
-                    << name << ": " << mMarkerObservations[i][name]
-                    << std::endl;
+                    << name << ": " << observed->second << std::endl;
           exit(1);
         }
 #endif
-        mMarkerPositions.block<3, 1>(j * 3, i) = mMarkerObservations[i][name];
+        mMarkerPositions.block<3, 1>(j * 3, i) = observed->second;
         mMarkerObserved(j, i) = 1;
         mRadii(j)
-            += (mCenterPoints.segment<3>(i * 3) - mMarkerObservations[i][name])
-                   .norm();
+            += (mCenterPoints.segment<3>(i * 3) - observed->second).norm();
         numRadiiObservations(j)++;
       }
     }
   }
 
-  mFitter->mSkeleton->setPositions(originalPosition);
-
   for (int j = 0; j < mActiveMarkers.size(); j++)
   {
     if (numRadiiObservations(j) > 0)
@@ -6060,6 +7172,15 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
     }
   }
 
+  // 3. Precompute masks, so the loss and gradient can work on all the
+  // timesteps at once
+  mObservedMask = mMarkerObserved.cast<s_t>();
+  mSmoothingMask = Eigen::VectorXs::Zero(std::max(mNumTimesteps - 1, 0));
+  for (int i = 1; i < mNumTimesteps; i++)
+  {
+    mSmoothingMask(i - 1) = mNewClip[i] ? 0.0 : 1.0;
+  }
+
 #ifndef NDEBUG
   if (mRadii.hasNaN())
   {
@@ -6073,6 +7194,27 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
 #endif
 }
 
+//==============================================================================
+/// This returns the world position of `joint` at each of the `ikPoses`, as a
+/// 3 x T matrix. This leaves the skeleton's positions unchanged.
+Eigen::MatrixXs SphereFitJointCenterProblem::getJointWorldPositions(
+    MarkerFitter* fitter,
+    const Eigen::MatrixXs& ikPoses,
+    dynamics::Joint* joint)
+{
+  Eigen::MatrixXs positions = Eigen::MatrixXs::Zero(3, ikPoses.cols());
+  Eigen::VectorXs originalPosition = fitter->mSkeleton->getPositions();
+  std::vector<dynamics::Joint*> jointVec;
+  jointVec.push_back(joint);
+  for (int i = 0; i < ikPoses.cols(); i++)
+  {
+    fitter->mSkeleton->setPositions(ikPoses.col(i));
+    positions.col(i) = fitter->mSkeleton->getJointWorldPositions(jointVec);
+  }
+  fitter->mSkeleton->setPositions(originalPosition);
+  return positions;
+}
+
 //==============================================================================
 /// This returns true if the given body is the parent of the joint OR if
 /// there's a hierarchy of fixed joints that connect it to the parent
@@ -6210,31 +7352,22 @@ void SphereFitJointCenterProblem::unflatten(Eigen::VectorXs x)
 //==============================================================================
 s_t SphereFitJointCenterProblem::getLoss()
 {
-  s_t loss = 0.0;
+  Eigen::Map<const Eigen::MatrixXs> centers(
+      mCenterPoints.data(), 3, mNumTimesteps);
 
-  for (int i = 0; i < mNumTimesteps; i++)
+  s_t loss = 0.0;
+  if (mNumTimesteps > 1)
   {
-    if (i > 0)
-    {
-      if (!mNewClip[i])
-      {
-        loss += mSmoothingLoss
-                * (mCenterPoints.segment<3>(i * 3)
-                   - mCenterPoints.segment<3>((i - 1) * 3))
-                      .squaredNorm();
-      }
-    }
-    for (int j = 0; j < mActiveMarkers.size(); j++)
-    {
-      if (mMarkerObserved(j, i))
-      {
-        s_t diff = mRadii(j) * mRadii(j)
-                   - (mCenterPoints.segment<3>(i * 3)
-                      - mMarkerPositions.block<3, 1>(j * 3, i))
-                         .squaredNorm();
-        loss += diff * diff;
-      }
-    }
+    loss += mSmoothingLoss
+            * (centers.rightCols(mNumTimesteps - 1)
+               - centers.leftCols(mNumTimesteps - 1))
+                  .colwise()
+                  .squaredNorm()
+                  .dot(mSmoothingMask.transpose());
+  }
+  for (int j = 0; j < mActiveMarkers.size(); j++)
+  {
+    loss += getMarkerResiduals(j, centers).squaredNorm();
   }
 
   return loss;
@@ -6245,42 +7378,157 @@ Eigen::VectorXs SphereFitJointCenterProblem::getGradient()
 {
   Eigen::VectorXs grad
       = Eigen::VectorXs::Zero(mRadii.size() + mCenterPoints.size());
+  Eigen::Map<const Eigen::MatrixXs> centers(
+      mCenterPoints.data(), 3, mNumTimesteps);
+  Eigen::Map<Eigen::MatrixXs> centersGrad(
+      grad.data() + mRadii.size(), 3, mNumTimesteps);
 
-  for (int i = 0; i < mNumTimesteps; i++)
+  if (mNumTimesteps > 1)
   {
-    if (i > 0)
-    {
-      if (!mNewClip[i])
-      {
-        grad.segment<3>(mRadii.size() + i * 3)
-            += 2 * mSmoothingLoss
-               * (mCenterPoints.segment<3>(i * 3)
-                  - mCenterPoints.segment<3>((i - 1) * 3));
-        grad.segment<3>(mRadii.size() + (i - 1) * 3)
-            -= 2 * mSmoothingLoss
-               * (mCenterPoints.segment<3>(i * 3)
-                  - mCenterPoints.segment<3>((i - 1) * 3));
-      }
-    }
-    for (int j = 0; j < mActiveMarkers.size(); j++)
+    Eigen::MatrixXs smoothingGrad = 2 * mSmoothingLoss
+                                    * (centers.rightCols(mNumTimesteps - 1)
+                                       - centers.leftCols(mNumTimesteps - 1))
+                                    * mSmoothingMask.asDiagonal();
+    centersGrad.rightCols(mNumTimesteps - 1) += smoothingGrad;
+    centersGrad.leftCols(mNumTimesteps - 1) -= smoothingGrad;
+  }
+  for (int j = 0; j < mActiveMarkers.size(); j++)
+  {
+    Eigen::VectorXs diff = getMarkerResiduals(j, centers);
+    grad(j) += 4 * mRadii(j) * diff.sum();
+    centersGrad -= 4 * (centers - mMarkerPositions.middleRows(j * 3, 3))
+                   * diff.asDiagonal();
+  }
+
+  return grad;
+}
+
+//==============================================================================
+/// This returns the residual (radius^2 - distance^2) between marker `j` and
+/// the center at every timestep, which is zero wherever `j` isn't observed
+Eigen::VectorXs SphereFitJointCenterProblem::getMarkerResiduals(
+    int j, const Eigen::Ref<const Eigen::MatrixXs>& centers)
+{
+  return ((mRadii(j) * mRadii(j)
+           - (centers - mMarkerPositions.middleRows(j * 3, 3))
+                 .colwise()
+                 .squaredNorm()
+                 .transpose()
+                 .array())
+          * mObservedMask.row(j).transpose().array())
+      .matrix();
+}
+
+//==============================================================================
+/// This improves the starting point for gradient descent with closed form
+/// least-squares fits. Holding the centers fixed, the best radius for each
+/// marker is its RMS distance to the centers. Holding the radii fixed,
+/// subtracting the mean sphere equation from each marker's sphere equation
+/// leaves a linear system for the center at that timestep. We solve that
+/// wherever at least four markers are observed, and keep the answer wherever
+/// it fits better than the center from IK.
+void SphereFitJointCenterProblem::initializeWithLeastSquaresFit()
+{
+  if (mRadii.size() == 0)
+  {
+    return;
+  }
+
+  Eigen::Map<Eigen::MatrixXs> centers(mCenterPoints.data(), 3, mNumTimesteps);
+  auto fitRadii = [&]() {
+    for (int j = 0; j < mRadii.size(); j++)
+    {
+      s_t numObserved = mObservedMask.row(j).sum();
+      if (numObserved > 0)
+      {
+        s_t meanSquaredDist
+            = (centers - mMarkerPositions.middleRows(j * 3, 3))
+                  .colwise()
+                  .squaredNorm()
+                  .dot(mObservedMask.row(j))
+              / numObserved;
+        mRadii(j) = sqrt(meanSquaredDist);
+      }
+    }
+  };
+
+  fitRadii();
+  for (int i = 0; i < mNumTimesteps; i++)
+  {
+    s_t numObserved = mObservedMask.col(i).sum();
+    if (numObserved < 4)
+    {
+      continue;
+    }
+
+    Eigen::Vector3s meanPos = Eigen::Vector3s::Zero();
+    s_t meanSquaredPos = 0.0;
+    s_t meanSquaredRadius = 0.0;
+    for (int j = 0; j < mRadii.size(); j++)
     {
       if (mMarkerObserved(j, i))
       {
-        s_t diff = mRadii(j) * mRadii(j)
-                   - (mCenterPoints.segment<3>(i * 3)
-                      - mMarkerPositions.block<3, 1>(j * 3, i))
-                         .squaredNorm();
-        grad(j) += (2 * diff) * (2 * mRadii(j));
-        grad.segment<3>(mRadii.size() + i * 3)
-            += (2 * diff)
-               * (-2
-                  * (mCenterPoints.segment<3>(i * 3)
-                     - mMarkerPositions.block<3, 1>(j * 3, i)));
+        Eigen::Vector3s pos = mMarkerPositions.block<3, 1>(j * 3, i);
+        meanPos += pos;
+        meanSquaredPos += pos.squaredNorm();
+        meanSquaredRadius += mRadii(j) * mRadii(j);
       }
     }
-  }
+    meanPos /= numObserved;
+    meanSquaredPos /= numObserved;
+    meanSquaredRadius /= numObserved;
 
-  return grad;
+    // |c - p_j|^2 = r_j^2, minus its mean over j, gives
+    // 2 (p_j - mean(p)) . c = |p_j|^2 - mean(|p|^2) - r_j^2 + mean(r^2)
+    Eigen::Matrix3s AtA = Eigen::Matrix3s::Zero();
+    Eigen::Vector3s Atb = Eigen::Vector3s::Zero();
+    for (int j = 0; j < mRadii.size(); j++)
+    {
+      if (mMarkerObserved(j, i))
+      {
+        Eigen::Vector3s pos = mMarkerPositions.block<3, 1>(j * 3, i);
+        Eigen::Vector3s a = 2 * (pos - meanPos);
+        s_t b = pos.squaredNorm() - meanSquaredPos - mRadii(j) * mRadii(j)
+                + meanSquaredRadius;
+        AtA += a * a.transpose();
+        Atb += a * b;
+      }
+    }
+    // If the markers are (nearly) coplanar, the center isn't pinned down
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3s> eigen(AtA);
+    if (eigen.eigenvalues()(2) <= 0
+        || eigen.eigenvalues()(0) < 1e-8 * eigen.eigenvalues()(2))
+    {
+      continue;
+    }
+    Eigen::Vector3s fit = eigen.eigenvectors()
+                          * (eigen.eigenvectors().transpose() * Atb)
+                                .cwiseQuotient(eigen.eigenvalues());
+    if (!fit.allFinite())
+    {
+      continue;
+    }
+
+    auto residual = [&](const Eigen::Vector3s& center) {
+      s_t sum = 0.0;
+      for (int j = 0; j < mRadii.size(); j++)
+      {
+        if (mMarkerObserved(j, i))
+        {
+          s_t diff = mRadii(j) * mRadii(j)
+                     - (center - mMarkerPositions.block<3, 1>(j * 3, i))
+                           .squaredNorm();
+          sum += diff * diff;
+        }
+      }
+      return sum;
+    };
+    if (residual(fit) < residual(centers.col(i)))
+    {
+      centers.col(i) = fit;
+    }
+  }
+  fitRadii();
 }
 
 //==============================================================================
@@ -6333,8 +7581,36 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
     Eigen::MatrixXs centers,
     const std::vector<bool>& newClip,
     Eigen::Ref<Eigen::MatrixXs> out)
+  : CylinderFitJointAxisProblem(
+      fitter,
+      markerObservations,
+      joint,
+      SphereFitJointCenterProblem::getJointWorldPositions(
+          fitter, ikPoses, joint),
+      getJointAngleAxis(fitter, ikPoses, joint),
+      centers,
+      newClip,
+      out)
+{
+}
+
+//==============================================================================
+/// This is the same as above, except that it takes the world position of the
+/// joint, and the angle-axis of the joint's relative rotation, at each
+/// timestep (each as a 3 x T matrix) instead of IK poses. That means it never
+/// touches the skeleton, so problems for different joints can be constructed
+/// at the same time.
+CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
+    MarkerFitter* fitter,
+    const std::vector<std::map<std::string, Eigen::Vector3s>>&
+        markerObservations,
+    dynamics::Joint* joint,
+    const Eigen::MatrixXs& jointWorldPositions,
+    const Eigen::MatrixXs& jointAngleAxis,
+    Eigen::MatrixXs centers,
+    const std::vector<bool>& newClip,
+    Eigen::Ref<Eigen::MatrixXs> out)
   : mFitter(fitter),
-    mMarkerObservations(markerObservations),
     mOut(out),
     mJointName(joint->getName()),
     mJointCenters(centers),
@@ -6359,7 +7635,7 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
       // divide by zeros
       for (int i = 0; i < mNumTimesteps; i++)
       {
-        if (mMarkerObservations[i].count(pair.first) > 0)
+        if (markerObservations[i].count(pair.first) > 0)
         {
           mActiveMarkers.push_back(pair.first);
           break;
@@ -6392,21 +7668,13 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
   Eigen::VectorXi numRadiiObservations
       = Eigen::VectorXi::Zero(mActiveMarkers.size());
 
-  Eigen::VectorXs originalPosition = mFitter->mSkeleton->getPositions();
-  std::vector<dynamics::Joint*> jointVec;
-  jointVec.push_back(joint);
-
   for (int i = 0; i < mNumTimesteps; i++)
   {
-    mFitter->mSkeleton->setPositions(ikPoses.col(i));
-
     // Find the center points
-    mAxisLines.segment<3>(i * 6)
-        = mFitter->mSkeleton->getJointWorldPositions(jointVec);
+    mAxisLines.segment<3>(i * 6) = jointWorldPositions.col(i);
 
     // Find the axis by the angle being formed by this joint
-    Eigen::Vector3s angleAxis
-        = math::logMap(joint->getRelativeTransform().linear());
+    Eigen::Vector3s angleAxis = jointAngleAxis.col(i);
 
     if (angleAxis.squaredNorm() < 0.01)
     {
@@ -6446,13 +7714,12 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
 
     for (int j = 0; j < mActiveMarkers.size(); j++)
     {
-      std::string name = mActiveMarkers[j];
-      if (mMarkerObservations[i].count(name) > 0)
+      auto observed = markerObservations[i].find(mActiveMarkers[j]);
+      if (observed != markerObservations[i].end())
       {
-        mMarkerPositions.block<3, 1>(j * 3, i) = mMarkerObservations[i][name];
+        mMarkerPositions.block<3, 1>(j * 3, i) = observed->second;
         mMarkerObserved(j, i) = 1;
-        Eigen::Vector3s diff
-            = mAxisLines.segment<3>(i * 6) - mMarkerObservations[i][name];
+        Eigen::Vector3s diff = mAxisLines.segment<3>(i * 6) - observed->second;
         // The radius is our distance to the cylinder at the nearest point
         mPerpendicularRadii(j) += (diff
                                    - (diff.dot(mAxisLines.segment<3>(i * 6 + 3))
@@ -6466,8 +7733,6 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
     }
   }
 
-  mFitter->mSkeleton->setPositions(originalPosition);
-
   for (int j = 0; j < mActiveMarkers.size(); j++)
   {
     if (numRadiiObservations(j) > 0)
@@ -6476,6 +7741,35 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
       mParallelRadii(j) /= numRadiiObservations(j);
     }
   }
+
+  // 3. Precompute masks, so the loss and gradient can work on all the
+  // timesteps at once
+  mObservedMask = mMarkerObserved.cast<s_t>();
+  mSmoothingMask = Eigen::VectorXs::Zero(std::max(mNumTimesteps - 1, 0));
+  for (int i = 1; i < mNumTimesteps; i++)
+  {
+    mSmoothingMask(i - 1) = mNewClip[i] ? 0.0 : 1.0;
+  }
+}
+
+//==============================================================================
+/// This returns the angle-axis of the relative rotation of `joint` at each of
+/// the `ikPoses`, as a 3 x T matrix. This leaves the skeleton's positions
+/// unchanged.
+Eigen::MatrixXs CylinderFitJointAxisProblem::getJointAngleAxis(
+    MarkerFitter* fitter,
+    const Eigen::MatrixXs& ikPoses,
+    dynamics::Joint* joint)
+{
+  Eigen::MatrixXs angleAxis = Eigen::MatrixXs::Zero(3, ikPoses.cols());
+  Eigen::VectorXs originalPosition = fitter->mSkeleton->getPositions();
+  for (int i = 0; i < ikPoses.cols(); i++)
+  {
+    fitter->mSkeleton->setPositions(ikPoses.col(i));
+    angleAxis.col(i) = math::logMap(joint->getRelativeTransform().linear());
+  }
+  fitter->mSkeleton->setPositions(originalPosition);
+  return angleAxis;
 }
 
 //==============================================================================
@@ -6515,78 +7809,32 @@ void CylinderFitJointAxisProblem::unflatten(Eigen::VectorXs x)
 //==============================================================================
 s_t CylinderFitJointAxisProblem::getLoss()
 {
-  s_t loss = 0.0;
+  Eigen::Map<const Eigen::MatrixXs> lines(mAxisLines.data(), 6, mNumTimesteps);
+  const Eigen::MatrixXs centers = lines.topRows(3);
+  const Eigen::MatrixXs axis = lines.bottomRows(3);
 
-  for (int i = 0; i < mNumTimesteps; i++)
+  s_t loss = 0.0;
+  if (mNumTimesteps > 1)
+  {
+    const int n = mNumTimesteps - 1;
+    loss += mKeepCenterLoss
+            * (centers.rightCols(n) - mJointCenters.rightCols(n)).squaredNorm();
+    loss += mSmoothingCenterLoss
+            * (centers.rightCols(n) - centers.leftCols(n))
+                  .colwise()
+                  .squaredNorm()
+                  .dot(mSmoothingMask.transpose());
+    loss += mSmoothingAxisLoss
+            * (axis.rightCols(n) - axis.leftCols(n))
+                  .colwise()
+                  .squaredNorm()
+                  .dot(mSmoothingMask.transpose());
+  }
+  for (int j = 0; j < mActiveMarkers.size(); j++)
   {
-    if (i > 0)
-    {
-      loss += mKeepCenterLoss
-              * (mAxisLines.segment<3>(i * 6) - mJointCenters.col(i))
-                    .squaredNorm();
-      if (!mNewClip[i])
-      {
-        loss += mSmoothingCenterLoss
-                * (mAxisLines.segment<3>(i * 6)
-                   - mAxisLines.segment<3>((i - 1) * 6))
-                      .squaredNorm();
-        loss += mSmoothingAxisLoss
-                * (mAxisLines.segment<3>(i * 6 + 3)
-                   - mAxisLines.segment<3>((i - 1) * 6 + 3))
-                      .squaredNorm();
-      }
-    }
-    for (int j = 0; j < mActiveMarkers.size(); j++)
-    {
-      if (mMarkerObserved(j, i))
-      {
-        Eigen::Vector3s center = mAxisLines.segment<3>(i * 6);
-        Eigen::Vector3s axis = mAxisLines.segment<3>(i * 6 + 3);
-        Eigen::Vector3s jointToCenter
-            = (center - mMarkerPositions.block<3, 1>(j * 3, i));
-        s_t diff = mPerpendicularRadii(j) * mPerpendicularRadii(j)
-                   - (jointToCenter - (jointToCenter.dot(axis) * axis))
-                         .squaredNorm();
-        (void)diff;
-        loss += diff * diff;
-        s_t parallelDiff = mParallelRadii(j) * mParallelRadii(j)
-                           - (jointToCenter.dot(axis) * axis).squaredNorm();
-        (void)parallelDiff;
-        loss += parallelDiff * parallelDiff;
-
-        /*
-        s_t dist = (jointToCenter.dot(axis) * axis).squaredNorm();
-        s_t dist2 = (axis * axis.transpose() * jointToCenter).squaredNorm();
-        s_t dist3 = (jointToCenter.transpose() * axis * axis.transpose())
-                    * (axis * axis.transpose() * jointToCenter);
-        s_t dist4 = jointToCenter.transpose()
-                    * ((axis * axis.transpose()) * (axis * axis.transpose()))
-                    * jointToCenter;
-        s_t dist5 = axis.dot(axis) * jointToCenter.dot(axis)
-                    * jointToCenter.dot(axis);
-        if (abs(dist - dist2) > 1e-14)
-        {
-          std::cout << "Dist1 != dist2: " << dist << ", " << dist2 << std::endl;
-        }
-        if (abs(dist - dist3) > 1e-14)
-        {
-          std::cout << "Dist != dist3: " << dist << ", " << dist3 << std::endl;
-        }
-        if (abs(dist - dist4) > 1e-14)
-        {
-          std::cout << "Dist != dist4: " << dist << ", " << dist4 << std::endl;
-        }
-        if (abs(dist - dist5) > 1e-14)
-        {
-          std::cout << "Dist != dist5: " << dist << ", " << dist5 << std::endl;
-        }
-        // loss += dist * dist;
-
-        // loss += dist4 * dist4;
-        // loss += -2 * jointToCenter.dot(axis) * jointToCenter.dot(axis);
-        */
-      }
-    }
+    MarkerResiduals residuals = getMarkerResiduals(j, centers, axis);
+    loss += residuals.perpendicularDiff.squaredNorm()
+            + residuals.parallelDiff.squaredNorm();
   }
 
   return loss;
@@ -6599,102 +7847,120 @@ Eigen::VectorXs CylinderFitJointAxisProblem::getGradient()
       mPerpendicularRadii.size() + mParallelRadii.size() + mAxisLines.size());
 
   int offset = mPerpendicularRadii.size() + mParallelRadii.size();
-  for (int i = 0; i < mNumTimesteps; i++)
+  Eigen::Map<const Eigen::MatrixXs> lines(mAxisLines.data(), 6, mNumTimesteps);
+  const Eigen::MatrixXs centers = lines.topRows(3);
+  const Eigen::MatrixXs axis = lines.bottomRows(3);
+  Eigen::MatrixXs centersGrad = Eigen::MatrixXs::Zero(3, mNumTimesteps);
+  Eigen::MatrixXs axisGrad = Eigen::MatrixXs::Zero(3, mNumTimesteps);
+
+  if (mNumTimesteps > 1)
+  {
+    const int n = mNumTimesteps - 1;
+    centersGrad.rightCols(n)
+        += 2 * mKeepCenterLoss
+           * (centers.rightCols(n) - mJointCenters.rightCols(n));
+
+    Eigen::MatrixXs centerSmoothingGrad
+        = 2 * mSmoothingCenterLoss
+          * (centers.rightCols(n) - centers.leftCols(n))
+          * mSmoothingMask.asDiagonal();
+    centersGrad.rightCols(n) += centerSmoothingGrad;
+    centersGrad.leftCols(n) -= centerSmoothingGrad;
+    Eigen::MatrixXs axisSmoothingGrad
+        = 2 * mSmoothingAxisLoss * (axis.rightCols(n) - axis.leftCols(n))
+          * mSmoothingMask.asDiagonal();
+    axisGrad.rightCols(n) += axisSmoothingGrad;
+    axisGrad.leftCols(n) -= axisSmoothingGrad;
+  }
+
+  const Eigen::VectorXs axisDotAxis = axis.colwise().squaredNorm().transpose();
+  for (int j = 0; j < mActiveMarkers.size(); j++)
   {
-    if (i > 0)
-    {
-      grad.segment<3>(offset + i * 6)
-          += 2 * mKeepCenterLoss
-             * (mAxisLines.segment<3>(i * 6) - mJointCenters.col(i));
-
-      if (!mNewClip[i])
-      {
-        grad.segment<3>(offset + i * 6)
-            += 2 * mSmoothingCenterLoss
-               * (mAxisLines.segment<3>(i * 6)
-                  - mAxisLines.segment<3>((i - 1) * 6));
-        grad.segment<3>(offset + (i - 1) * 6)
-            -= 2 * mSmoothingCenterLoss
-               * (mAxisLines.segment<3>(i * 6)
-                  - mAxisLines.segment<3>((i - 1) * 6));
-        grad.segment<3>(offset + i * 6 + 3)
-            += 2 * mSmoothingAxisLoss
-               * (mAxisLines.segment<3>(i * 6 + 3)
-                  - mAxisLines.segment<3>((i - 1) * 6 + 3));
-        grad.segment<3>(offset + (i - 1) * 6 + 3)
-            -= 2 * mSmoothingAxisLoss
-               * (mAxisLines.segment<3>(i * 6 + 3)
-                  - mAxisLines.segment<3>((i - 1) * 6 + 3));
-      }
-    }
-
-    const Eigen::Vector3s center = mAxisLines.segment<3>(i * 6);
-    const Eigen::Vector3s axis = mAxisLines.segment<3>(i * 6 + 3);
-    const s_t axisDotAxis = axis.dot(axis);
-    for (int j = 0; j < mActiveMarkers.size(); j++)
-    {
-      if (mMarkerObserved(j, i))
-      {
-        const Eigen::Vector3s jointToCenter
-            = (center - mMarkerPositions.block<3, 1>(j * 3, i));
-        const s_t jointToCenterDotAxis = jointToCenter.dot(axis);
-        const Eigen::Vector3s jointToCenterAlongAxis
-            = jointToCenterDotAxis * axis;
-        const s_t diff
-            = mPerpendicularRadii(j) * mPerpendicularRadii(j)
-              - (jointToCenter - (jointToCenterAlongAxis)).squaredNorm();
-        const s_t parallelDiff = mParallelRadii(j) * mParallelRadii(j)
-                                 - (jointToCenterAlongAxis).squaredNorm();
-        // Gradient wrt perpendicular radii
-        grad(j) += (2 * diff) * (2 * mPerpendicularRadii(j));
-        // Gradient wrt parallel radii
-        grad(mParallelRadii.size() + j)
-            += (2 * parallelDiff) * (2 * mParallelRadii(j));
-
-        // Gradient wrt the axis center of perpendicular term
-        grad.segment<3>(offset + i * 6)
-            += (2 * diff) * -2
-               * (jointToCenter - axisDotAxis * jointToCenterAlongAxis);
-        // Gradient wrt the axis of perpendicular term
-        grad.segment<3>(offset + i * 6 + 3)
-            += 2 * diff * -1
-               * ((-4 + 2 * axisDotAxis) * jointToCenterDotAxis * jointToCenter
-                  + 2 * jointToCenterDotAxis * jointToCenterDotAxis * axis);
-        // Gradient wrt the axis center of parallel term
-        grad.segment<3>(offset + i * 6)
-            += -2 * parallelDiff * 2 * (axisDotAxis * jointToCenterAlongAxis);
-        // Gradient wrt the axis of parallel term
-        grad.segment<3>(offset + i * 6 + 3)
-            += -2 * parallelDiff
-               * (2 * jointToCenterAlongAxis * jointToCenterDotAxis
-                  + axisDotAxis * 2 * jointToCenterDotAxis * jointToCenter);
-      }
-    }
-
-    // Keep only the portion of the gradient wrt the normal vector that's
-    // perpendicular to the current normal
-    // Operate on the last timestep gradient, since that's now complete
-    if (i > 0)
-    {
-      Eigen::Vector3s axisDir
-          = mAxisLines.segment<3>((i - 1) * 6 + 3).normalized();
-      s_t dot = grad.segment<3>(offset + (i - 1) * 6 + 3).dot(axisDir);
-      grad.segment<3>(offset + (i - 1) * 6 + 3) -= axisDir * dot;
-    }
+    MarkerResiduals r = getMarkerResiduals(j, centers, axis);
+    const Eigen::VectorXs& diff = r.perpendicularDiff;
+    const Eigen::VectorXs& parallelDiff = r.parallelDiff;
+    const Eigen::VectorXs& dot = r.jointToCenterDotAxis;
+
+    // Gradient wrt perpendicular radii
+    grad(j) += 4 * mPerpendicularRadii(j) * diff.sum();
+    // Gradient wrt parallel radii
+    grad(mParallelRadii.size() + j)
+        += 4 * mParallelRadii(j) * parallelDiff.sum();
+
+    // Gradient wrt the axis center of perpendicular term
+    centersGrad
+        -= 4
+           * (r.jointToCenter
+              - r.jointToCenterAlongAxis * axisDotAxis.asDiagonal())
+           * diff.asDiagonal();
+    // Gradient wrt the axis of perpendicular term
+    axisGrad
+        -= 2
+           * (r.jointToCenter
+                  * ((2 * axisDotAxis.array() - 4) * dot.array())
+                        .matrix()
+                        .asDiagonal()
+              + 2 * axis * dot.cwiseProduct(dot).asDiagonal())
+           * diff.asDiagonal();
+    // Gradient wrt the axis center of parallel term
+    centersGrad -= 4 * r.jointToCenterAlongAxis * axisDotAxis.asDiagonal()
+                   * parallelDiff.asDiagonal();
+    // Gradient wrt the axis of parallel term
+    axisGrad -= 4
+                * (r.jointToCenterAlongAxis
+                   + r.jointToCenter * axisDotAxis.asDiagonal())
+                * dot.cwiseProduct(parallelDiff).asDiagonal();
   }
 
   // Keep only the portion of the gradient wrt the normal vector that's
   // perpendicular to the current normal
-  // Patch the last timestep gradient, since that never gets patched in the
-  // normal loop
-  Eigen::Vector3s axisDir
-      = mAxisLines.segment<3>((mNumTimesteps - 1) * 6 + 3).normalized();
-  s_t dot = grad.segment<3>(offset + (mNumTimesteps - 1) * 6 + 3).dot(axisDir);
-  grad.segment<3>(offset + (mNumTimesteps - 1) * 6 + 3) -= axisDir * dot;
+  for (int i = 0; i < mNumTimesteps; i++)
+  {
+    Eigen::Vector3s axisDir = axis.col(i).normalized();
+    axisGrad.col(i) -= axisDir * axisGrad.col(i).dot(axisDir);
+  }
+
+  Eigen::Map<Eigen::MatrixXs> linesGrad(
+      grad.data() + offset, 6, mNumTimesteps);
+  linesGrad.topRows(3) = centersGrad;
+  linesGrad.bottomRows(3) = axisGrad;
 
   return grad;
 }
 
+//==============================================================================
+/// This computes the perpendicular and parallel residuals between marker `j`
+/// and the axis at every timestep, which are zero wherever `j` isn't observed
+CylinderFitJointAxisProblem::MarkerResiduals
+CylinderFitJointAxisProblem::getMarkerResiduals(
+    int j,
+    const Eigen::Ref<const Eigen::MatrixXs>& centers,
+    const Eigen::Ref<const Eigen::MatrixXs>& axis)
+{
+  MarkerResiduals r;
+  r.jointToCenter = centers - mMarkerPositions.middleRows(j * 3, 3);
+  r.jointToCenterDotAxis
+      = r.jointToCenter.cwiseProduct(axis).colwise().sum().transpose();
+  r.jointToCenterAlongAxis = axis * r.jointToCenterDotAxis.asDiagonal();
+  r.perpendicularDiff
+      = ((mPerpendicularRadii(j) * mPerpendicularRadii(j)
+          - (r.jointToCenter - r.jointToCenterAlongAxis)
+                .colwise()
+                .squaredNorm()
+                .transpose()
+                .array())
+         * mObservedMask.row(j).transpose().array())
+            .matrix();
+  r.parallelDiff = ((mParallelRadii(j) * mParallelRadii(j)
+                     - r.jointToCenterAlongAxis.colwise()
+                           .squaredNorm()
+                           .transpose()
+                           .array())
+                    * mObservedMask.row(j).transpose().array())
+                       .matrix();
+  return r;
+}
+
 //==============================================================================
 Eigen::VectorXs CylinderFitJointAxisProblem::finiteDifferenceGradient()
 {
@@ -6755,6 +8021,7 @@ BilevelFitProblem::BilevelFitProblem(
     mOutResult(outResult),
     mInitialization(initialization),
     mApplyInnerProblemGradientConstraints(applyInnerProblemGradientConstraints),
+    mFixScalesAndOffsets(false),
     mBestObjectiveValue(std::numeric_limits<s_t>::infinity())
 {
   // 1. Select the random indices we'll be using for this problem
@@ -6868,6 +8135,14 @@ BilevelFitProblem::~BilevelFitProblem()
 {
 }
 
+//==============================================================================
+/// If true, the body scales and marker offsets are held at their initial
+/// values, and only the poses are optimized. This defaults to false.
+void BilevelFitProblem::setFixScalesAndOffsets(bool fix)
+{
+  mFixScalesAndOffsets = fix;
+}
+
 //==============================================================================
 int BilevelFitProblem::getProblemSize()
 {
@@ -6931,7 +8206,8 @@ s_t BilevelFitProblem::getLoss(Eigen::VectorXs x)
       mJointWeights,
       mJointAxis,
       mAxisWeights,
-      mFitter);
+      mFitter,
+      mPerThreadSkeletons);
   return mFitter->mLossAndGrad(&state);
 }
 
@@ -6949,7 +8225,8 @@ Eigen::VectorXs BilevelFitProblem::getGradient(Eigen::VectorXs x)
       mJointWeights,
       mJointAxis,
       mAxisWeights,
-      mFitter);
+      mFitter,
+      mPerThreadSkeletons);
   mFitter->mLossAndGrad(&state);
   return state.flattenGradient();
 }
@@ -6999,6 +8276,7 @@ Eigen::VectorXs BilevelFitProblem::getConstraints(Eigen::VectorXs x)
     bool multiThreaded = true;
     if (multiThreaded)
     {
+      common::ThreadPool& pool = common::ThreadPool::getGlobal();
       std::vector<std::future<Eigen::VectorXs>> futures;
       for (int k = 0; k < mNumThreads; k++)
       {
@@ -7016,7 +8294,7 @@ Eigen::VectorXs BilevelFitProblem::getConstraints(Eigen::VectorXs x)
         }
 
         futures.push_back(
-            std::async([&, threadCursors, threadSkeleton, threadMarkers]() {
+            pool.submit([&, threadCursors, threadSkeleton, threadMarkers]() {
               Eigen::VectorXs ikGradLocal
                   = Eigen::VectorXs::Zero(threadSkeleton->getNumDofs());
 
@@ -7045,6 +8323,7 @@ Eigen::VectorXs BilevelFitProblem::getConstraints(Eigen::VectorXs x)
       }
       for (int k = 0; k < mNumThreads; k++)
       {
+        pool.wait(futures[k]);
         ikGrad += futures[k].get();
       }
     }
@@ -7080,7 +8359,8 @@ Eigen::VectorXs BilevelFitProblem::getConstraints(Eigen::VectorXs x)
         mJointWeights,
         mJointAxis,
         mAxisWeights,
-        mFitter);
+        mFitter,
+        mPerThreadSkeletons);
 
     Eigen::VectorXs concatenatedConstraints = Eigen::VectorXs::Zero(
         ikGrad.size() + mFitter->mZeroConstraints.size());
@@ -7105,25 +8385,119 @@ Eigen::VectorXs BilevelFitProblem::getConstraints(Eigen::VectorXs x)
 /// q_0, ..., q_N]
 Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
 {
-  Eigen::MatrixXs jac
-      = Eigen::MatrixXs::Zero(mFitter->mSkeleton->getNumDofs(), x.size());
+  int nnz = getConstraintsJacobianNonZeros();
+  Eigen::VectorXi rows = Eigen::VectorXi::Zero(nnz);
+  Eigen::VectorXi cols = Eigen::VectorXi::Zero(nnz);
+  getConstraintsJacobianSparsity(rows, cols);
+  Eigen::VectorXs vals = getSparseConstraintsJacobian(x);
+
+  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(
+      mFitter->mSkeleton->getNumDofs() + mFitter->mZeroConstraints.size(),
+      x.size());
+  for (int i = 0; i < nnz; i++)
+  {
+    jac(rows(i), cols(i)) = vals(i);
+  }
+  return jac;
+}
+
+//==============================================================================
+/// This returns the number of structurally non-zero entries in the
+/// constraint Jacobian. The IK gradient constraints only couple each pose to
+/// itself and to the shared [groupSizes, markerOffsets], so they form a
+/// block-arrow shape. The zero constraints are treated as dense rows.
+int BilevelFitProblem::getConstraintsJacobianNonZeros()
+{
+  int dofs = mFitter->mSkeleton->getNumDofs();
+  int sharedDims
+      = mFitter->mSkeleton->getGroupScaleDim() + mFitter->mMarkers.size() * 3;
+  int n = sharedDims + dofs * mMarkerObservations.size();
+  return (dofs * sharedDims) + (dofs * dofs * mMarkerObservations.size())
+         + (mFitter->mZeroConstraints.size() * n);
+}
+
+//==============================================================================
+/// This fills in the (row, col) pairs of the structurally non-zero entries
+/// in the constraint Jacobian, in the same order as the values returned by
+/// getSparseConstraintsJacobian()
+void BilevelFitProblem::getConstraintsJacobianSparsity(
+    Eigen::Ref<Eigen::VectorXi> rows, Eigen::Ref<Eigen::VectorXi> cols)
+{
+  int dofs = mFitter->mSkeleton->getNumDofs();
+  int sharedDims
+      = mFitter->mSkeleton->getGroupScaleDim() + mFitter->mMarkers.size() * 3;
+  int n = sharedDims + dofs * mMarkerObservations.size();
 
+  int cursor = 0;
+  // 1. The IK gradient wrt the shared scales and marker offsets, column major
+  for (int col = 0; col < sharedDims; col++)
+  {
+    for (int row = 0; row < dofs; row++)
+    {
+      rows(cursor) = row;
+      cols(cursor) = col;
+      cursor++;
+    }
+  }
+  // 2. The IK gradient wrt each timestep's pose, one column major block each
+  for (int t = 0; t < mMarkerObservations.size(); t++)
+  {
+    int offset = sharedDims + t * dofs;
+    for (int col = 0; col < dofs; col++)
+    {
+      for (int row = 0; row < dofs; row++)
+      {
+        rows(cursor) = row;
+        cols(cursor) = offset + col;
+        cursor++;
+      }
+    }
+  }
+  // 3. The zero constraints can depend on anything, so they're dense
+  for (int z = 0; z < mFitter->mZeroConstraints.size(); z++)
+  {
+    for (int col = 0; col < n; col++)
+    {
+      rows(cursor) = dofs + z;
+      cols(cursor) = col;
+      cursor++;
+    }
+  }
+  assert(cursor == rows.size());
+  assert(cursor == cols.size());
+}
+
+//==============================================================================
+/// This evaluates the structurally non-zero entries of the Jacobian of our
+/// constraint vector wrt x, in the order given by
+/// getConstraintsJacobianSparsity(). This never forms the dense Jacobian.
+Eigen::VectorXs BilevelFitProblem::getSparseConstraintsJacobian(
+    Eigen::VectorXs x)
+{
+  Eigen::VectorXs vals = Eigen::VectorXs::Zero(getConstraintsJacobianNonZeros());
+
+  int dofs = mFitter->mSkeleton->getNumDofs();
   int scaleGroupDims = mFitter->mSkeleton->getGroupScaleDim();
   int markerOffsetDims = mFitter->mMarkers.size() * 3;
+  int sharedDims = scaleGroupDims + markerOffsetDims;
   Eigen::VectorXs groupScales = x.segment(0, scaleGroupDims);
   Eigen::VectorXs markerOffsets = x.segment(scaleGroupDims, markerOffsetDims);
-  Eigen::VectorXs firstPose = x.segment(
-      scaleGroupDims + markerOffsetDims, mFitter->mSkeleton->getNumDofs());
+  Eigen::VectorXs firstPose = x.segment(sharedDims, dofs);
 
   std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers
       = mFitter->setConfiguration(
           mFitter->mSkeleton, firstPose, groupScales, markerOffsets);
 
+  // This is the (dofs x sharedDims) block at the start of vals
+  Eigen::Map<Eigen::MatrixXs> sharedJac(vals.data(), dofs, sharedDims);
+  const int poseBlocksStart = dofs * sharedDims;
+
   if (mApplyInnerProblemGradientConstraints)
   {
     bool multiThreaded = true;
     if (multiThreaded)
     {
+      common::ThreadPool& pool = common::ThreadPool::getGlobal();
       std::vector<std::future<Eigen::MatrixXs>> futures;
       for (int k = 0; k < mNumThreads; k++)
       {
@@ -7140,19 +8514,17 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
               threadSkeleton->getBodyNode(pair.first->getName()), pair.second);
         }
 
-        futures.push_back(std::async([&,
+        futures.push_back(pool.submit([&,
                                       threadCursors,
                                       threadSkeleton,
                                       threadMarkers]() {
-          Eigen::MatrixXs markersAndScalesLocalJac = Eigen::MatrixXs::Zero(
-              threadSkeleton->getNumDofs(), scaleGroupDims + markerOffsetDims);
+          Eigen::MatrixXs markersAndScalesLocalJac
+              = Eigen::MatrixXs::Zero(dofs, sharedDims);
 
           for (int i : threadCursors)
           {
-            int offset = scaleGroupDims + markerOffsetDims
-                         + (i * threadSkeleton->getNumDofs());
-            Eigen::VectorXs pose
-                = x.segment(offset, threadSkeleton->getNumDofs());
+            int offset = sharedDims + (i * dofs);
+            Eigen::VectorXs pose = x.segment(offset, dofs);
             threadSkeleton->setPositions(pose);
 
             Eigen::VectorXs markerError = mFitter->getMarkerError(
@@ -7160,28 +8532,22 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
             std::vector<int> sparsityMap = mFitter->getSparsityMap(
                 threadMarkers, mMarkerObservations[i]);
 
-            // Get loss wrt joint positions
-            jac.block(
-                0,
-                offset,
-                threadSkeleton->getNumDofs(),
-                threadSkeleton->getNumDofs())
+            // Get loss wrt joint positions. Each timestep owns a disjoint
+            // block of vals, so it's safe to write this from any thread.
+            Eigen::Map<Eigen::MatrixXs>(
+                vals.data() + poseBlocksStart + (i * dofs * dofs), dofs, dofs)
                 = mFitter->getIKLossGradientWrtJointsJacobianWrtJoints(
                       threadSkeleton, threadMarkers, markerError, sparsityMap)
                   * mObservationWeights(i);
 
             // Acculumulate loss wrt the global scale groups
-            markersAndScalesLocalJac.block(
-                0, 0, threadSkeleton->getNumDofs(), scaleGroupDims)
+            markersAndScalesLocalJac.block(0, 0, dofs, scaleGroupDims)
                 += mFitter->getIKLossGradientWrtJointsJacobianWrtGroupScales(
                        threadSkeleton, threadMarkers, markerError, sparsityMap)
                    * mObservationWeights(i);
             // Acculumulate loss wrt the global marker offsets
             markersAndScalesLocalJac.block(
-                0,
-                scaleGroupDims,
-                threadSkeleton->getNumDofs(),
-                markerOffsetDims)
+                0, scaleGroupDims, dofs, markerOffsetDims)
                 += mFitter->getIKLossGradientWrtJointsJacobianWrtMarkerOffsets(
                        threadSkeleton, threadMarkers, markerError, sparsityMap)
                    * mObservationWeights(i);
@@ -7192,22 +8558,16 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
       }
       for (int k = 0; k < mNumThreads; k++)
       {
-        jac.block(
-            0,
-            0,
-            mFitter->mSkeleton->getNumDofs(),
-            scaleGroupDims + markerOffsetDims)
-            += futures[k].get();
+        pool.wait(futures[k]);
+        sharedJac += futures[k].get();
       }
     }
     else
     {
       for (int i = 0; i < mMarkerObservations.size(); i++)
       {
-        int offset = scaleGroupDims + markerOffsetDims
-                     + (i * mFitter->mSkeleton->getNumDofs());
-        Eigen::VectorXs pose
-            = x.segment(offset, mFitter->mSkeleton->getNumDofs());
+        int offset = sharedDims + (i * dofs);
+        Eigen::VectorXs pose = x.segment(offset, dofs);
         mFitter->mSkeleton->setPositions(pose);
 
         Eigen::VectorXs markerError = mFitter->getMarkerError(
@@ -7216,26 +8576,19 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
             = mFitter->getSparsityMap(markers, mMarkerObservations[i]);
 
         // Get loss wrt joint positions
-        jac.block(
-            0,
-            offset,
-            mFitter->mSkeleton->getNumDofs(),
-            mFitter->mSkeleton->getNumDofs())
+        Eigen::Map<Eigen::MatrixXs>(
+            vals.data() + poseBlocksStart + (i * dofs * dofs), dofs, dofs)
             = mFitter->getIKLossGradientWrtJointsJacobianWrtJoints(
                   mFitter->mSkeleton, markers, markerError, sparsityMap)
               * mObservationWeights(i);
 
         // Acculumulate loss wrt the global scale groups
-        jac.block(0, 0, mFitter->mSkeleton->getNumDofs(), scaleGroupDims)
+        sharedJac.block(0, 0, dofs, scaleGroupDims)
             += mFitter->getIKLossGradientWrtJointsJacobianWrtGroupScales(
                    mFitter->mSkeleton, markers, markerError, sparsityMap)
                * mObservationWeights(i);
         // Acculumulate loss wrt the global marker offsets
-        jac.block(
-            0,
-            scaleGroupDims,
-            mFitter->mSkeleton->getNumDofs(),
-            markerOffsetDims)
+        sharedJac.block(0, scaleGroupDims, dofs, markerOffsetDims)
             += mFitter->getIKLossGradientWrtJointsJacobianWrtMarkerOffsets(
                    mFitter->mSkeleton, markers, markerError, sparsityMap)
                * mObservationWeights(i);
@@ -7253,24 +8606,250 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
         mJointWeights,
         mJointAxis,
         mAxisWeights,
-        mFitter);
+        mFitter,
+        mPerThreadSkeletons);
 
-    Eigen::MatrixXs concatenatedJac = Eigen::MatrixXs::Zero(
-        jac.rows() + mFitter->mZeroConstraints.size(), jac.cols());
-    concatenatedJac.block(0, 0, jac.rows(), jac.cols()) = jac;
-    int cursor = jac.rows();
+    int cursor = poseBlocksStart + (mMarkerObservations.size() * dofs * dofs);
     for (auto pair : mFitter->mZeroConstraints)
     {
       pair.second(&state);
-      concatenatedJac.row(cursor) = state.flattenGradient();
+      vals.segment(cursor, x.size()) = state.flattenGradient();
+      cursor += x.size();
+    }
+    assert(cursor == vals.size());
+  }
+
+  return vals;
+}
+
+//==============================================================================
+/// This returns the number of structurally non-zero entries in the lower
+/// triangle of the Hessian of the Lagrangian. Poses at different timesteps
+/// never interact directly, so this also has a block-arrow shape.
+int BilevelFitProblem::getHessianNonZeros()
+{
+  int dofs = mFitter->mSkeleton->getNumDofs();
+  int sharedDims
+      = mFitter->mSkeleton->getGroupScaleDim() + mFitter->mMarkers.size() * 3;
+  int sharedBlock = (sharedDims * (sharedDims + 1)) / 2;
+  int perTimestep = (dofs * sharedDims) + ((dofs * (dofs + 1)) / 2);
+  return sharedBlock + perTimestep * mMarkerObservations.size();
+}
+
+//==============================================================================
+/// This fills in the (row, col) pairs of the structurally non-zero entries
+/// in the lower triangle of the Hessian of the Lagrangian
+void BilevelFitProblem::getHessianSparsity(
+    Eigen::Ref<Eigen::VectorXi> rows, Eigen::Ref<Eigen::VectorXi> cols)
+{
+  int dofs = mFitter->mSkeleton->getNumDofs();
+  int sharedDims
+      = mFitter->mSkeleton->getGroupScaleDim() + mFitter->mMarkers.size() * 3;
+
+  int cursor = 0;
+  // 1. Shared scales and marker offsets against each other
+  for (int row = 0; row < sharedDims; row++)
+  {
+    for (int col = 0; col <= row; col++)
+    {
+      rows(cursor) = row;
+      cols(cursor) = col;
       cursor++;
     }
-    return concatenatedJac;
   }
-  else
+  // 2. Each pose against the shared variables, and against itself
+  for (int t = 0; t < mMarkerObservations.size(); t++)
+  {
+    int offset = sharedDims + t * dofs;
+    for (int row = 0; row < dofs; row++)
+    {
+      for (int col = 0; col < sharedDims; col++)
+      {
+        rows(cursor) = offset + row;
+        cols(cursor) = col;
+        cursor++;
+      }
+      for (int col = 0; col <= row; col++)
+      {
+        rows(cursor) = offset + row;
+        cols(cursor) = offset + col;
+        cursor++;
+      }
+    }
+  }
+  assert(cursor == rows.size());
+  assert(cursor == cols.size());
+}
+
+//==============================================================================
+/// This evaluates a Gauss-Newton approximation of the Hessian of the loss,
+/// in the order given by getHessianSparsity(). The curvature comes from the
+/// squared marker and joint center errors, plus the (exactly quadratic)
+/// marker offset regularization. Everything else, including the
+/// constraints, is treated as flat, which keeps this positive semi-definite.
+Eigen::VectorXs BilevelFitProblem::getSparseGaussNewtonHessian(
+    Eigen::VectorXs x)
+{
+  Eigen::VectorXs vals = Eigen::VectorXs::Zero(getHessianNonZeros());
+
+  int dofs = mFitter->mSkeleton->getNumDofs();
+  int scaleGroupDims = mFitter->mSkeleton->getGroupScaleDim();
+  int markerOffsetDims = mFitter->mMarkers.size() * 3;
+  int sharedDims = scaleGroupDims + markerOffsetDims;
+  Eigen::VectorXs groupScales = x.segment(0, scaleGroupDims);
+  Eigen::VectorXs markerOffsets = x.segment(scaleGroupDims, markerOffsetDims);
+  Eigen::VectorXs firstPose = x.segment(sharedDims, dofs);
+
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers
+      = mFitter->setConfiguration(
+          mFitter->mSkeleton, firstPose, groupScales, markerOffsets);
+
+  const int sharedBlock = (sharedDims * (sharedDims + 1)) / 2;
+  const int perTimestep = (dofs * sharedDims) + ((dofs * (dofs + 1)) / 2);
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<Eigen::MatrixXs>> futures;
+  for (int k = 0; k < mNumThreads; k++)
+  {
+    std::vector<int> threadCursors = mPerThreadCursor[k];
+    std::shared_ptr<dynamics::Skeleton> threadSkeleton
+        = mPerThreadSkeletons[k];
+    threadSkeleton->setGroupScales(mFitter->mSkeleton->getGroupScales());
+
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
+        threadMarkers;
+    for (auto pair : markers)
+    {
+      threadMarkers.emplace_back(
+          threadSkeleton->getBodyNode(pair.first->getName()), pair.second);
+    }
+    std::vector<dynamics::Joint*> threadJoints;
+    for (dynamics::Joint* joint : mInitialization.joints)
+    {
+      threadJoints.push_back(threadSkeleton->getJoint(joint->getName()));
+    }
+
+    futures.push_back(pool.submit([&,
+                                  threadCursors,
+                                  threadSkeleton,
+                                  threadMarkers,
+                                  threadJoints]() {
+      Eigen::MatrixXs sharedHessian
+          = Eigen::MatrixXs::Zero(sharedDims, sharedDims);
+      int numJointRows = threadJoints.size() * 3;
+
+      for (int i : threadCursors)
+      {
+        int offset = sharedDims + (i * dofs);
+        Eigen::VectorXs pose = x.segment(offset, dofs);
+        threadSkeleton->setPositions(pose);
+
+        // Stack up the Jacobians of every residual at this timestep: three
+        // rows for each visible marker, and three for each joint center
+        const std::vector<std::pair<int, Eigen::Vector3s>>& visible
+            = mMarkerObservations[i];
+        int numMarkerRows = visible.size() * 3;
+        int numRows = numMarkerRows + numJointRows;
+        Eigen::MatrixXs jacPose = Eigen::MatrixXs::Zero(numRows, dofs);
+        Eigen::MatrixXs jacShared = Eigen::MatrixXs::Zero(numRows, sharedDims);
+
+        Eigen::MatrixXs markersWrtPose
+            = threadSkeleton->getMarkerWorldPositionsJacobianWrtJointPositions(
+                threadMarkers);
+        Eigen::SparseMatrix<s_t, Eigen::RowMajor> markersWrtScales
+            = threadSkeleton
+                  ->getMarkerWorldPositionsJacobianWrtGroupScalesSparse(
+                      threadMarkers);
+        Eigen::MatrixXs markersWrtOffsets
+            = threadSkeleton->getMarkerWorldPositionsJacobianWrtMarkerOffsets(
+                threadMarkers);
+        for (int j = 0; j < visible.size(); j++)
+        {
+          int index = visible[j].first;
+          jacPose.block(j * 3, 0, 3, dofs)
+              = markersWrtPose.block(index * 3, 0, 3, dofs);
+          jacShared.block(j * 3, 0, 3, scaleGroupDims)
+              = markersWrtScales.middleRows(index * 3, 3);
+          jacShared.block(j * 3, scaleGroupDims, 3, markerOffsetDims)
+              = markersWrtOffsets.block(index * 3, 0, 3, markerOffsetDims);
+        }
+        if (numJointRows > 0)
+        {
+          // Marker offsets don't move joint centers, so those columns stay 0
+          jacPose.block(numMarkerRows, 0, numJointRows, dofs)
+              = threadSkeleton->getJointWorldPositionsJacobianWrtJointPositions(
+                  threadJoints);
+          jacShared.block(numMarkerRows, 0, numJointRows, scaleGroupDims)
+              = threadSkeleton
+                    ->getJointWorldPositionsJacobianWrtGroupScalesSparse(
+                        threadJoints);
+          if (mJointWeights.size() > 0)
+          {
+            for (int j = 0; j < threadJoints.size(); j++)
+            {
+              jacPose.block(numMarkerRows + j * 3, 0, 3, dofs)
+                  *= mJointWeights(j);
+              jacShared.block(numMarkerRows + j * 3, 0, 3, sharedDims)
+                  *= mJointWeights(j);
+            }
+          }
+        }
+
+        // The loss is the squared norm of the residuals, so the Gauss-Newton
+        // Hessian is 2 * J^T * J
+        Eigen::MatrixXs hessianPose = 2 * jacPose.transpose() * jacPose;
+        Eigen::MatrixXs hessianCross = 2 * jacPose.transpose() * jacShared;
+        sharedHessian += 2 * jacShared.transpose() * jacShared;
+
+        // Each timestep owns a disjoint block of vals, so it's safe to write
+        // this from any thread
+        int cursor = sharedBlock + (i * perTimestep);
+        for (int row = 0; row < dofs; row++)
+        {
+          vals.segment(cursor, sharedDims) = hessianCross.row(row).transpose();
+          cursor += sharedDims;
+          vals.segment(cursor, row + 1)
+              = hessianPose.row(row).segment(0, row + 1).transpose();
+          cursor += row + 1;
+        }
+      }
+
+      return sharedHessian;
+    }));
+  }
+  Eigen::MatrixXs sharedHessian = Eigen::MatrixXs::Zero(sharedDims, sharedDims);
+  for (int k = 0; k < mNumThreads; k++)
+  {
+    pool.wait(futures[k]);
+    sharedHessian += futures[k].get();
+  }
+
+  // The marker offset regularization is already quadratic, so its part of the
+  // Hessian is exact
+  int numTimesteps = mMarkerObservations.size();
+  for (int i = 0; i < mFitter->mMarkerIsTracking.size(); i++)
+  {
+    s_t multiple
+        = (mFitter->mMarkerIsTracking[i]
+               ? mFitter->mRegularizeTrackingMarkerOffsets
+               : mFitter->mRegularizeAnatomicalMarkerOffsets);
+    for (int axis = 0; axis < 3; axis++)
+    {
+      int index = scaleGroupDims + (i * 3) + axis;
+      sharedHessian(index, index) += 2 * numTimesteps * multiple;
+    }
+  }
+
+  int cursor = 0;
+  for (int row = 0; row < sharedDims; row++)
   {
-    return jac;
+    vals.segment(cursor, row + 1)
+        = sharedHessian.row(row).segment(0, row + 1).transpose();
+    cursor += row + 1;
   }
+  assert(cursor == sharedBlock);
+
+  return vals;
 }
 
 //==============================================================================
@@ -7351,10 +8930,10 @@ bool BilevelFitProblem::get_nlp_info(
   m = mFitter->mSkeleton->getNumDofs() + mFitter->mZeroConstraints.size();
 
   // Set the number of entries in the constraint Jacobian
-  nnz_jac_g = m * n;
+  nnz_jac_g = getConstraintsJacobianNonZeros();
 
   // Set the number of entries in the Hessian
-  nnz_h_lag = n * n;
+  nnz_h_lag = getHessianNonZeros();
 
   // use the C style indexing (0-based)
   index_style = Ipopt::TNLP::C_STYLE;
@@ -7400,6 +8979,15 @@ bool BilevelFitProblem::get_bounds_info(
     lowerBounds.segment(scaleGroupDim + markerOffsetDim + (i * dofs), dofs)
         = mFitter->mSkeleton->getPositionLowerLimits();
   }
+  if (mFixScalesAndOffsets)
+  {
+    // IPOPT treats variables with equal bounds as constants
+    Eigen::VectorXs init = getInitialization();
+    upperBounds.segment(0, scaleGroupDim + markerOffsetDim)
+        = init.segment(0, scaleGroupDim + markerOffsetDim);
+    lowerBounds.segment(0, scaleGroupDim + markerOffsetDim)
+        = init.segment(0, scaleGroupDim + markerOffsetDim);
+  }
 
   // Our constraint function has to be 0
   Eigen::Map<Eigen::VectorXd> constraintUpperBounds(g_u, m);
@@ -7514,38 +9102,17 @@ bool BilevelFitProblem::eval_jac_g(
 
   if (nullptr == _x)
   {
+    assert(_nnzj == getConstraintsJacobianNonZeros());
     Eigen::Map<Eigen::VectorXi> rows(_iRow, _nnzj);
     Eigen::Map<Eigen::VectorXi> cols(_jCol, _nnzj);
-    int cursor = 0;
-    for (int col = 0; col < _n; col++)
-    {
-      for (int row = 0; row < _m; row++)
-      {
-        rows(cursor) = row;
-        cols(cursor) = col;
-        cursor++;
-      }
-    }
-    assert(cursor == _nnzj);
+    getConstraintsJacobianSparsity(rows, cols);
   }
   else
   {
-    // Return the concatenated gradient of everything
+    // Return the block-arrow entries, without ever forming the dense Jacobian
     Eigen::Map<const Eigen::VectorXd> x(_x, _n);
     Eigen::Map<Eigen::VectorXd> vals(_values, _nnzj);
-
-    Eigen::MatrixXs jac = getConstraintsJacobian(x);
-
-    int cursor = 0;
-    for (int col = 0; col < jac.cols(); col++)
-    {
-      for (int row = 0; row < jac.rows(); row++)
-      {
-        vals(cursor) = jac(row, col);
-        cursor++;
-      }
-    }
-    assert(cursor == _nnzj);
+    vals = getSparseConstraintsJacobian(x);
   }
 
   return true;
@@ -7569,18 +9136,35 @@ bool BilevelFitProblem::eval_h(
     Ipopt::Index* _jCol,
     Ipopt::Number* _values)
 {
-  (void)_n;
-  (void)_x;
   (void)_new_x;
-  (void)_obj_factor;
   (void)_m;
   (void)_lambda;
   (void)_new_lambda;
-  (void)_nele_hess;
-  (void)_iRow;
-  (void)_jCol;
-  (void)_values;
-  return false;
+
+  // We always report the block-arrow structure so IPOPT can size its data
+  // structures sensibly. We only have values if we're using Gauss-Newton,
+  // otherwise IPOPT falls back to LBFGS.
+  if (nullptr == _values)
+  {
+    assert(_nele_hess == getHessianNonZeros());
+    Eigen::Map<Eigen::VectorXi> rows(_iRow, _nele_hess);
+    Eigen::Map<Eigen::VectorXi> cols(_jCol, _nele_hess);
+    getHessianSparsity(rows, cols);
+    return true;
+  }
+
+  if (!mFitter->mUseGaussNewtonHessian)
+  {
+    (void)_iRow;
+    (void)_jCol;
+    return false;
+  }
+
+  // The constraints are treated as flat, so the multipliers drop out
+  Eigen::Map<const Eigen::VectorXd> x(_x, _n);
+  Eigen::Map<Eigen::VectorXd> vals(_values, _nele_hess);
+  vals = _obj_factor * getSparseGaussNewtonHessian(x);
+  return true;
 }
 
 /// \brief This method is called when the algorithm is complete so the TNLP
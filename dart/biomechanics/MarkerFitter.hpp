@@ -3,6 +3,8 @@
 
 #include <memory>
 // #include <unordered_map>
+#include <functional>
+#include <future>
 #include <map>
 #include <mutex>
 #include <vector>
@@ -13,6 +15,7 @@
 
 #include "dart/biomechanics/Anthropometrics.hpp"
 #include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/biomechanics/MarkerTrajectories.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/Joint.hpp"
@@ -76,7 +79,12 @@ struct MarkerFitterState
   Eigen::MatrixXs jointErrorsAtTimestepsGrad;
   Eigen::MatrixXs axisErrorsAtTimestepsGrad;
 
-  /// This unflattens an input vector, given some information about the problm
+  /// This unflattens an input vector, given some information about the problm.
+  ///
+  /// If `threadSkeletons` isn't empty, the per-timestep work (here and in
+  /// flattenGradient()) is split into one batch of timesteps per skeleton, and
+  /// the batches run in parallel on the global ThreadPool. These must be
+  /// clones of the fitter's skeleton that nobody else is using for now.
   MarkerFitterState(
       const Eigen::VectorXs& flat,
       std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations,
@@ -85,7 +93,9 @@ struct MarkerFitterState
       Eigen::VectorXs jointWeights,
       Eigen::MatrixXs jointAxis,
       Eigen::VectorXs axisWeights,
-      MarkerFitter* fitter);
+      MarkerFitter* fitter,
+      const std::vector<std::shared_ptr<dynamics::Skeleton>>& threadSkeletons
+      = std::vector<std::shared_ptr<dynamics::Skeleton>>());
 
   /// This returns a single flat vector representing this whole problem state
   Eigen::VectorXs flattenState();
@@ -95,12 +105,52 @@ struct MarkerFitterState
   Eigen::VectorXs flattenGradient();
 
 protected:
+  /// This splits the timesteps into one batch per thread skeleton, and runs
+  /// `fn` on each batch in parallel, passing along a skeleton (with the same
+  /// scales as `skeleton`) and `markers` and `joints` remapped onto it. With
+  /// fewer than two thread skeletons, this just runs `fn` once over every
+  /// timestep on `skeleton`.
+  void runOnTimestepBatches(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      std::function<void(
+          int batch,
+          std::shared_ptr<dynamics::Skeleton> skel,
+          const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+              skelMarkers,
+          const std::vector<dynamics::Joint*>& skelJoints,
+          int start,
+          int end)> fn);
+
+  /// This fills in the marker, joint, and axis errors for the timesteps in
+  /// [start, end), running FK on `skel`
+  void computeErrorsAtTimesteps(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const std::vector<dynamics::Joint*>& skelJoints,
+      int start,
+      int end);
+
+  /// This adds the gradient wrt the poses at the timesteps in [start, end)
+  /// into `grad`, and returns the gradient wrt the group scales and marker
+  /// offsets (concatenated) summed over those timesteps, running FK on `skel`
+  Eigen::VectorXs accumulateGradientAtTimesteps(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const std::vector<dynamics::Joint*>& skelJoints,
+      int start,
+      int end,
+      Eigen::VectorXs& grad);
+
   std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations;
   std::shared_ptr<dynamics::Skeleton> skeleton;
   std::vector<dynamics::Joint*> joints;
   Eigen::MatrixXs jointCenters;
   Eigen::MatrixXs jointAxis;
   MarkerFitter* fitter;
+  std::vector<std::shared_ptr<dynamics::Skeleton>> threadSkeletons;
 };
 
 /**
@@ -144,6 +194,26 @@ public:
       const std::vector<bool>& newClip,
       Eigen::Ref<Eigen::MatrixXs> out);
 
+  /// This is the same as above, except that it takes the world position of the
+  /// joint at each timestep (as a 3 x T matrix) instead of IK poses. That means
+  /// it never touches the skeleton, so problems for different joints can be
+  /// constructed at the same time.
+  SphereFitJointCenterProblem(
+      MarkerFitter* fitter,
+      const std::vector<std::map<std::string, Eigen::Vector3s>>&
+          markerObservations,
+      dynamics::Joint* joint,
+      const Eigen::MatrixXs& jointWorldPositions,
+      const std::vector<bool>& newClip,
+      Eigen::Ref<Eigen::MatrixXs> out);
+
+  /// This returns the world position of `joint` at each of the `ikPoses`, as a
+  /// 3 x T matrix. This leaves the skeleton's positions unchanged.
+  static Eigen::MatrixXs getJointWorldPositions(
+      MarkerFitter* fitter,
+      const Eigen::MatrixXs& ikPoses,
+      dynamics::Joint* joint);
+
   /// This returns true if the given body is the parent of the joint OR if
   /// there's a hierarchy of fixed joints that connect it to the parent
   static bool isDynamicParentOfJoint(
@@ -172,16 +242,33 @@ public:
 
   Eigen::VectorXs finiteDifferenceGradient();
 
+  /// This improves the starting point for gradient descent with closed form
+  /// least-squares fits. Holding the centers fixed, the best radius for each
+  /// marker is its RMS distance to the centers. Holding the radii fixed,
+  /// subtracting the mean sphere equation from each marker's sphere equation
+  /// leaves a linear system for the center at that timestep. We solve that
+  /// wherever at least four markers are observed, and keep the answer wherever
+  /// it fits better than the center from IK.
+  void initializeWithLeastSquaresFit();
+
   /// This writes the solution back to the output matrix reference passed in
   /// during initialization. This also returns a loss we achieved, which can be
   /// used as a confidence for downstream tasks.
   s_t saveSolutionBackToInitialization();
 
 protected:
+  /// This returns the residual (radius^2 - distance^2) between marker `j` and
+  /// the center at every timestep, which is zero wherever `j` isn't observed
+  Eigen::VectorXs getMarkerResiduals(
+      int j, const Eigen::Ref<const Eigen::MatrixXs>& centers);
+
   MarkerFitter* mFitter;
-  std::vector<std::map<std::string, Eigen::Vector3s>> mMarkerObservations;
   Eigen::Ref<Eigen::MatrixXs> mOut;
   s_t mSmoothingLoss;
+  // These are mMarkerObserved as 0 or 1, and whether each timestep after the
+  // first is smoothed against the one before it
+  Eigen::MatrixXs mObservedMask;
+  Eigen::VectorXs mSmoothingMask;
 
 public:
   std::vector<std::string> mActiveMarkers;
@@ -212,6 +299,30 @@ public:
       const std::vector<bool>& newClip,
       Eigen::Ref<Eigen::MatrixXs> out);
 
+  /// This is the same as above, except that it takes the world position of the
+  /// joint, and the angle-axis of the joint's relative rotation, at each
+  /// timestep (each as a 3 x T matrix) instead of IK poses. That means it never
+  /// touches the skeleton, so problems for different joints can be constructed
+  /// at the same time.
+  CylinderFitJointAxisProblem(
+      MarkerFitter* fitter,
+      const std::vector<std::map<std::string, Eigen::Vector3s>>&
+          markerObservations,
+      dynamics::Joint* joint,
+      const Eigen::MatrixXs& jointWorldPositions,
+      const Eigen::MatrixXs& jointAngleAxis,
+      Eigen::MatrixXs centers,
+      const std::vector<bool>& newClip,
+      Eigen::Ref<Eigen::MatrixXs> out);
+
+  /// This returns the angle-axis of the relative rotation of `joint` at each of
+  /// the `ikPoses`, as a 3 x T matrix. This leaves the skeleton's positions
+  /// unchanged.
+  static Eigen::MatrixXs getJointAngleAxis(
+      MarkerFitter* fitter,
+      const Eigen::MatrixXs& ikPoses,
+      dynamics::Joint* joint);
+
   int getProblemDim();
 
   Eigen::VectorXs flatten();
@@ -230,12 +341,33 @@ public:
   s_t saveSolutionBackToInitialization();
 
 protected:
+  /// These are the per-timestep terms of the loss for a single marker, each
+  /// with one column (or entry) per timestep
+  struct MarkerResiduals
+  {
+    Eigen::MatrixXs jointToCenter;
+    Eigen::VectorXs jointToCenterDotAxis;
+    Eigen::MatrixXs jointToCenterAlongAxis;
+    Eigen::VectorXs perpendicularDiff;
+    Eigen::VectorXs parallelDiff;
+  };
+
+  /// This computes the perpendicular and parallel residuals between marker `j`
+  /// and the axis at every timestep, which are zero wherever `j` isn't observed
+  MarkerResiduals getMarkerResiduals(
+      int j,
+      const Eigen::Ref<const Eigen::MatrixXs>& centers,
+      const Eigen::Ref<const Eigen::MatrixXs>& axis);
+
   MarkerFitter* mFitter;
-  std::vector<std::map<std::string, Eigen::Vector3s>> mMarkerObservations;
   Eigen::Ref<Eigen::MatrixXs> mOut;
   s_t mKeepCenterLoss;
   s_t mSmoothingCenterLoss;
   s_t mSmoothingAxisLoss;
+  // These are mMarkerObserved as 0 or 1, and whether each timestep after the
+  // first is smoothed against the one before it
+  Eigen::MatrixXs mObservedMask;
+  Eigen::VectorXs mSmoothingMask;
 
   std::vector<std::pair<int, int>> mThreadSplits;
 
@@ -323,6 +455,37 @@ struct MarkersErrorReport
       markerObservationsAttemptedFixed;
 };
 
+/// This runs MarkerFitter::fitTrajectory() calls somewhere other than the
+/// global thread pool. The blocks that the initialization fits in parallel
+/// all go through here, so an implementation can shard them out to other
+/// machines (see MarkerFitterRemote).
+class TrajectoryFitDispatcher
+{
+public:
+  virtual ~TrajectoryFitDispatcher();
+
+  /// This takes the same arguments as MarkerFitter::fitTrajectory(), and
+  /// returns a future that's ready once `result` and `resultScores` have been
+  /// filled in. The caller keeps everything `result` and `resultScores`
+  /// point into alive until then.
+  virtual std::future<void> submit(
+      const MarkerFitter* fitter,
+      Eigen::VectorXs groupScales,
+      Eigen::VectorXs firstPoseGuess,
+      std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations,
+      std::map<std::string, s_t> markerWeights,
+      std::map<std::string, Eigen::Vector3s> markerOffsets,
+      std::vector<dynamics::Joint*> joints,
+      std::vector<Eigen::VectorXs> jointCenters,
+      Eigen::VectorXs jointWeights,
+      std::vector<Eigen::VectorXs> jointAxis,
+      Eigen::VectorXs axisWeights,
+      Eigen::Ref<Eigen::MatrixXs> result,
+      Eigen::Ref<Eigen::VectorXs> resultScores,
+      bool backwards)
+      = 0;
+};
+
 /**
  * This is the high level object that handles fitting skeletons to mocap data.
  *
@@ -588,6 +751,11 @@ public:
   /// IK, if nothing marker-specific gets assigned.
   void setTrackingMarkerDefaultWeight(s_t weight);
 
+  /// If set to true, findJointCenter() and findJointAxis() solve their (small,
+  /// unconstrained) fits with the in-process L-BFGS solver in math::LBFGSB,
+  /// rather than with a fixed 500 steps of adagrad. Defaults to false.
+  void setUseLBFGSBForJointFits(bool useLBFGSB);
+
   /// This returns a score summarizing how much the markers attached to this
   /// joint move relative to one another.
   s_t computeJointVariability(
@@ -609,6 +777,25 @@ public:
       int numSamples,
       bool applyInnerProblemGradientConstraints = true);
 
+  /// This is a version of optimizeBilevel() for very long trials, where a
+  /// single problem over the whole trial would be too big. It splits the
+  /// trial into windows of `windowSize` timesteps, each overlapping the next
+  /// by `windowOverlap`, and samples `samplesPerWindow` poses from each one.
+  /// Each round fits every window on its own, starting from the shared body
+  /// scales and marker offsets, and then sets the shared values to the
+  /// average of the windows' answers, weighted by window length. After
+  /// `numRounds` rounds, every window's poses are re-fit with the shared
+  /// scales and offsets held fixed. If the trial fits in a single window,
+  /// this is just optimizeBilevel().
+  std::shared_ptr<BilevelFitResult> optimizeBilevelWindowed(
+      const std::vector<std::map<std::string, Eigen::Vector3s>>&
+          markerObservations,
+      MarkerInitialization& initialization,
+      int samplesPerWindow,
+      int windowSize,
+      int windowOverlap,
+      int numRounds = 2);
+
   ///////////////////////////////////////////////////////////////////////////
   // Pipeline step 5: Complete the intermittent pose information of the
   // BilevelFitResult by running IK to extend each section.
@@ -694,6 +881,13 @@ public:
   /// name.
   int getMarkerIndex(std::string name);
 
+  /// This translates columnar marker observations into the (marker index,
+  /// world position) pairs that getMarkerError() and friends take, one list
+  /// per frame. Marker names are resolved once up front, so this doesn't build
+  /// or search a map per frame. Markers this fitter doesn't know are skipped.
+  std::vector<std::vector<std::pair<int, Eigen::Vector3s>>>
+  getVisibleMarkerWorldPoses(const MarkerTrajectories& trajectories);
+
   /// This method will set `skeleton` to the configuration given by the vectors
   /// of jointPositions and groupScales. It will also compute and return the
   /// list of markers given by markerDiffs.
@@ -728,6 +922,19 @@ public:
   /// This sets the maximum number of restarts allowed for the initial IK solver
   void setInitialIKMaxRestarts(int restarts);
 
+  /// If true, the per-frame IK in the initialization seeds each frame with a
+  /// constant-velocity extrapolation of the last two solutions, and only falls
+  /// back to random restarts on frames that miss
+  /// setInitialIKSatisfactoryLoss(). Each block is also fit outwards from its
+  /// center frame, with the forward and backward halves run in parallel.
+  void setUseTemporalWarmStart(bool useWarmStart);
+
+  /// If true, the per-frame IK in the initialization takes Levenberg-Marquardt
+  /// steps over the sparse marker and joint Jacobians, which usually
+  /// converges in a handful of iterations instead of hundreds. This defaults
+  /// to false.
+  void setUseLevenbergMarquardtIK(bool useLevenbergMarquardt);
+
   /// Sets the maximum that we'll allow markers to move from their original
   /// position, in meters
   void setMaxMarkerOffset(s_t offset);
@@ -916,12 +1123,88 @@ public:
   void setLBFGSHistory(int hist);
   void setCheckDerivatives(bool checkDerivatives);
 
+  /// If true, the bilevel fit gives IPOPT a Gauss-Newton approximation of the
+  /// Hessian (from the marker and joint center Jacobians) instead of having it
+  /// build up an LBFGS approximation. That takes fewer, larger steps on the
+  /// default least-squares loss. With a custom loss, the curvature still only
+  /// comes from the squared marker and joint center errors.
+  void setUseGaussNewtonHessian(bool useGaussNewtonHessian);
+
+  /// If true (the default), runMultiTrialKinematicsPipeline() runs the
+  /// per-trial stages on separate trials at the same time, each with its own
+  /// copy of the skeleton. This is ignored if you've called
+  /// setCustomLossAndGrad() or addZeroConstraint(), since those functions may
+  /// not be safe to call from several threads at once.
+  void setParallelizeTrials(bool parallelizeTrials);
+
+  /// If `windowSize` is greater than 0, runKinematicsPipeline() fits trials
+  /// longer than `windowSize` timesteps with optimizeBilevelWindowed() instead
+  /// of optimizeBilevel(), and its `numSamples` becomes the number of poses
+  /// sampled from each window. This defaults to 0, which is off.
+  void setBilevelWindow(int windowSize, int windowOverlap, int numRounds = 2);
+
+  /// If this is set, the blocks of per-frame IK that the initialization
+  /// would otherwise fit on the global thread pool get handed to `dispatcher`
+  /// instead, which can run them on other machines. Pass nullptr (the
+  /// default) to fit everything locally.
+  void setTrajectoryFitDispatcher(
+      std::shared_ptr<TrajectoryFitDispatcher> dispatcher);
+
   friend class BilevelFitProblem;
   friend class SphereFitJointCenterProblem;
   friend class CylinderFitJointAxisProblem;
   friend struct MarkerFitterState;
+  friend class MarkerFitterRemote;
+  friend class MarkerFitterWorker;
 
 protected:
+  /// This starts a fitTrajectory() call, either on the global thread pool or
+  /// through our TrajectoryFitDispatcher, if we have one
+  std::future<void> submitTrajectoryFit(
+      Eigen::VectorXs groupScales,
+      Eigen::VectorXs firstPoseGuess,
+      std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations,
+      std::map<std::string, s_t> markerWeights,
+      std::map<std::string, Eigen::Vector3s> markerOffsets,
+      std::vector<dynamics::Joint*> joints,
+      std::vector<Eigen::VectorXs> jointCenters,
+      Eigen::VectorXs jointWeights,
+      std::vector<Eigen::VectorXs> jointAxis,
+      Eigen::VectorXs axisWeights,
+      Eigen::Ref<Eigen::MatrixXs> result,
+      Eigen::Ref<Eigen::VectorXs> resultScores,
+      bool backwards);
+
+  /// This makes an independent copy of this fitter, with the same settings
+  /// but its own clone of the skeleton, so that separate trials can be
+  /// processed at the same time
+  std::shared_ptr<MarkerFitter> cloneForTrial();
+
+  /// This points the joints and markers in `init`, which came from a fitter
+  /// made by cloneForTrial(), back at our own skeleton
+  void rebindInitialization(MarkerInitialization& init);
+
+  /// This runs `pipeline` once for each of `numTrials` trials, and returns
+  /// the results in trial order. If `parallel` is true, and it's safe to, each
+  /// trial runs on the global thread pool with a fitter from cloneForTrial().
+  /// Otherwise the trials run one after another on this fitter.
+  std::vector<MarkerInitialization> runOnEachTrial(
+      int numTrials,
+      bool parallel,
+      std::function<MarkerInitialization(MarkerFitter* fitter, int trial)>
+          pipeline);
+
+  /// This runs the IPOPT solve behind optimizeBilevel(). If
+  /// `fixScalesAndOffsets` is true, the body scales and marker offsets are
+  /// held at their values in `initialization`, and only the poses move.
+  std::shared_ptr<BilevelFitResult> solveBilevel(
+      const std::vector<std::map<std::string, Eigen::Vector3s>>&
+          markerObservations,
+      MarkerInitialization& initialization,
+      int numSamples,
+      bool applyInnerProblemGradientConstraints,
+      bool fixScalesAndOffsets);
+
   std::map<std::string, int> mMarkerIndices;
   std::vector<std::string> mMarkerNames;
   std::vector<bool> mMarkerIsTracking;
@@ -947,6 +1230,8 @@ protected:
 
   s_t mInitialIKSatisfactoryLoss;
   int mInitialIKMaxRestarts;
+  bool mUseTemporalWarmStart;
+  bool mUseLevenbergMarquardtIK;
   s_t mMaxMarkerOffset;
   // Parameters for joint weighting
   s_t mMinVarianceCutoff;
@@ -961,6 +1246,7 @@ protected:
   s_t mRegularizeAllBodyScales;
   s_t mAnatomicalMarkerDefaultWeight;
   s_t mTrackingMarkerDefaultWeight;
+  bool mUseLBFGSBForJointFits;
 
   // These are IPOPT settings
   double mTolerance;
@@ -970,6 +1256,17 @@ protected:
   int mPrintFrequency;
   bool mSilenceOutput;
   bool mDisableLinesearch;
+  bool mUseGaussNewtonHessian;
+
+  bool mHasCustomLossAndGrad;
+  bool mParallelizeTrials;
+
+  // These are the settings for windowed bilevel fitting
+  int mBilevelWindowSize;
+  int mBilevelWindowOverlap;
+  int mBilevelWindowRounds;
+
+  std::shared_ptr<TrajectoryFitDispatcher> mTrajectoryFitDispatcher;
 };
 
 /*
@@ -999,6 +1296,10 @@ public:
 
   int getProblemSize();
 
+  /// If true, the body scales and marker offsets are held at their initial
+  /// values, and only the poses are optimized. This defaults to false.
+  void setFixScalesAndOffsets(bool fix);
+
   /// This gets a decent initial guess for the problem. We can guess scaling and
   /// joint positions from the first marker observation, and then use that
   /// scaling to get joint positions for all the other entries. This initially
@@ -1032,6 +1333,40 @@ public:
   /// q_0, ..., q_N]
   Eigen::MatrixXs finiteDifferenceConstraintsJacobian(Eigen::VectorXs x);
 
+  /// This returns the number of structurally non-zero entries in the
+  /// constraint Jacobian. The IK gradient constraints only couple each pose to
+  /// itself and to the shared [groupSizes, markerOffsets], so they form a
+  /// block-arrow shape. The zero constraints are treated as dense rows.
+  int getConstraintsJacobianNonZeros();
+
+  /// This fills in the (row, col) pairs of the structurally non-zero entries
+  /// in the constraint Jacobian, in the same order as the values returned by
+  /// getSparseConstraintsJacobian()
+  void getConstraintsJacobianSparsity(
+      Eigen::Ref<Eigen::VectorXi> rows, Eigen::Ref<Eigen::VectorXi> cols);
+
+  /// This evaluates the structurally non-zero entries of the Jacobian of our
+  /// constraint vector wrt x, in the order given by
+  /// getConstraintsJacobianSparsity(). This never forms the dense Jacobian.
+  Eigen::VectorXs getSparseConstraintsJacobian(Eigen::VectorXs x);
+
+  /// This returns the number of structurally non-zero entries in the lower
+  /// triangle of the Hessian of the Lagrangian. Poses at different timesteps
+  /// never interact directly, so this also has a block-arrow shape.
+  int getHessianNonZeros();
+
+  /// This fills in the (row, col) pairs of the structurally non-zero entries
+  /// in the lower triangle of the Hessian of the Lagrangian
+  void getHessianSparsity(
+      Eigen::Ref<Eigen::VectorXi> rows, Eigen::Ref<Eigen::VectorXi> cols);
+
+  /// This evaluates a Gauss-Newton approximation of the Hessian of the loss,
+  /// in the order given by getHessianSparsity(). The curvature comes from the
+  /// squared marker and joint center errors, plus the (exactly quadratic)
+  /// marker offset regularization. Everything else, including the
+  /// constraints, is treated as flat, which keeps this positive semi-definite.
+  Eigen::VectorXs getSparseGaussNewtonHessian(Eigen::VectorXs x);
+
   /// This returns the indices that this problem is using to specify the problem
   const std::vector<int>& getSampleIndices();
 
@@ -1173,6 +1508,7 @@ protected:
   std::vector<int> mSampleIndices;
   MarkerInitialization& mInitialization;
   bool mApplyInnerProblemGradientConstraints;
+  bool mFixScalesAndOffsets;
   Eigen::VectorXs mObservationWeights;
   std::shared_ptr<BilevelFitResult>& mOutResult;
 
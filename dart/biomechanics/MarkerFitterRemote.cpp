@@ -0,0 +1,490 @@
+#include "dart/biomechanics/MarkerFitterRemote.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include <grpcpp/grpcpp.h>
+#include <unistd.h>
+
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/common/LocalResourceRetriever.hpp"
+#include "dart/common/ThreadPool.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/proto/SerializeEigen.hpp"
+#include "dart/utils/CompositeResourceRetriever.hpp"
+#include "dart/utils/DartResourceRetriever.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+namespace {
+
+/// This packs per-frame vectors (which are either all the same size, or all
+/// empty) into the columns of a matrix
+Eigen::MatrixXs packColumns(const std::vector<Eigen::VectorXs>& columns)
+{
+  if (columns.size() == 0 || columns[0].size() == 0)
+  {
+    return Eigen::MatrixXs::Zero(0, 0);
+  }
+  Eigen::MatrixXs packed(columns[0].size(), columns.size());
+  for (int i = 0; i < columns.size(); i++)
+  {
+    assert(columns[i].size() == packed.rows());
+    packed.col(i) = columns[i];
+  }
+  return packed;
+}
+
+/// This undoes packColumns(), producing `numFrames` empty vectors if the
+/// matrix has no columns
+std::vector<Eigen::VectorXs> unpackColumns(
+    const Eigen::MatrixXs& packed, int numFrames)
+{
+  std::vector<Eigen::VectorXs> columns;
+  for (int i = 0; i < numFrames; i++)
+  {
+    if (packed.cols() == 0)
+    {
+      columns.push_back(Eigen::VectorXs::Zero(0));
+    }
+    else
+    {
+      columns.push_back(packed.col(i));
+    }
+  }
+  return columns;
+}
+
+} // namespace
+
+//==============================================================================
+MarkerFitterRemote::MarkerFitterRemote(
+    const std::vector<std::string>& workerAddresses,
+    const common::Uri& osimUri)
+  : mNextSubjectId(0)
+{
+  auto retriever = std::make_shared<utils::CompositeResourceRetriever>();
+  retriever->addSchemaRetriever(
+      "file", std::make_shared<common::LocalResourceRetriever>());
+  retriever->addSchemaRetriever("dart", utils::DartResourceRetriever::create());
+  mOsimFileContents = retriever->readAll(osimUri);
+
+  std::random_device rd;
+  std::stringstream session;
+  session << std::hex << rd() << rd();
+  mSessionId = session.str();
+
+  // Replies carry whole blocks of poses, which can be over the 4MB default
+  grpc::ChannelArguments args;
+  args.SetMaxReceiveMessageSize(-1);
+  for (const std::string& address : workerAddresses)
+  {
+    mChannels.push_back(grpc::CreateCustomChannel(
+        address, grpc::InsecureChannelCredentials(), args));
+    mStubs.push_back(proto::MarkerFitterWorkerService::NewStub(
+        mChannels[mChannels.size() - 1]));
+    mTasksInFlight.push_back(0);
+  }
+}
+
+//==============================================================================
+std::future<void> MarkerFitterRemote::submit(
+    const MarkerFitter* fitter,
+    Eigen::VectorXs groupScales,
+    Eigen::VectorXs firstPoseGuess,
+    std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations,
+    std::map<std::string, s_t> markerWeights,
+    std::map<std::string, Eigen::Vector3s> markerOffsets,
+    std::vector<dynamics::Joint*> joints,
+    std::vector<Eigen::VectorXs> jointCenters,
+    Eigen::VectorXs jointWeights,
+    std::vector<Eigen::VectorXs> jointAxis,
+    Eigen::VectorXs axisWeights,
+    Eigen::Ref<Eigen::MatrixXs> result,
+    Eigen::Ref<Eigen::VectorXs> resultScores,
+    bool backwards)
+{
+  if (mStubs.size() == 0)
+  {
+    return common::ThreadPool::getGlobal().submit(
+        &MarkerFitter::fitTrajectory,
+        fitter,
+        groupScales,
+        firstPoseGuess,
+        markerObservations,
+        markerWeights,
+        markerOffsets,
+        joints,
+        jointCenters,
+        jointWeights,
+        jointAxis,
+        axisWeights,
+        result,
+        resultScores,
+        backwards);
+  }
+
+  std::string subjectId = getSubjectId(fitter, groupScales, markerOffsets);
+
+  // 1. Build the request on the caller's thread, while all the arguments are
+  // still at hand
+  auto request = std::make_shared<proto::MarkerFitterFitTrajectoryRequest>();
+  request->set_subjectid(subjectId);
+  proto::serializeVector(*request->mutable_firstposeguess(), firstPoseGuess);
+  for (auto& observations : markerObservations)
+  {
+    proto::MarkerFitterObservationFrame* frame
+        = request->add_markerobservations();
+    for (auto& pair : observations)
+    {
+      frame->add_names(pair.first);
+      for (int i = 0; i < 3; i++)
+      {
+        frame->add_positions(static_cast<double>(pair.second(i)));
+      }
+    }
+  }
+  for (auto& pair : markerWeights)
+  {
+    (*request->mutable_markerweights())[pair.first]
+        = static_cast<double>(pair.second);
+  }
+  for (dynamics::Joint* joint : joints)
+  {
+    request->add_jointnames(joint->getName());
+  }
+  proto::serializeMatrix(
+      *request->mutable_jointcenters(), packColumns(jointCenters));
+  proto::serializeVector(*request->mutable_jointweights(), jointWeights);
+  proto::serializeMatrix(*request->mutable_jointaxis(), packColumns(jointAxis));
+  proto::serializeVector(*request->mutable_axisweights(), axisWeights);
+  request->set_backwards(backwards);
+
+  // 2. Send it to the least busy worker
+  int worker = 0;
+  {
+    const std::lock_guard<std::mutex> lock(mMutex);
+    for (int i = 1; i < mTasksInFlight.size(); i++)
+    {
+      if (mTasksInFlight[i] < mTasksInFlight[worker])
+      {
+        worker = i;
+      }
+    }
+    mTasksInFlight[worker]++;
+  }
+
+  return std::async(std::launch::async, [=]() mutable {
+    grpc::ClientContext context;
+    proto::MarkerFitterFitTrajectoryReply reply;
+    grpc::Status status
+        = mStubs[worker]->FitTrajectory(&context, *request, &reply);
+    {
+      const std::lock_guard<std::mutex> lock(mMutex);
+      mTasksInFlight[worker]--;
+    }
+
+    if (status.ok())
+    {
+      Eigen::MatrixXs poses = proto::deserializeMatrix(reply.poses());
+      Eigen::VectorXs scores = proto::deserializeVector(reply.scores());
+      if (poses.rows() == result.rows() && poses.cols() == result.cols()
+          && scores.size() == resultScores.size())
+      {
+        result = poses;
+        resultScores = scores;
+        return;
+      }
+      std::cout << "MarkerFitterRemote got a result of the wrong shape from "
+                   "worker "
+                << worker << ", fitting the block locally" << std::endl;
+    }
+    else
+    {
+      std::cout << "MarkerFitterRemote worker " << worker
+                << " failed: " << status.error_message()
+                << ", fitting the block locally" << std::endl;
+    }
+
+    MarkerFitter::fitTrajectory(
+        fitter,
+        groupScales,
+        firstPoseGuess,
+        markerObservations,
+        markerWeights,
+        markerOffsets,
+        joints,
+        jointCenters,
+        jointWeights,
+        jointAxis,
+        axisWeights,
+        result,
+        resultScores,
+        backwards);
+  });
+}
+
+//==============================================================================
+/// This returns the id of a subject the workers already have for this
+/// (fitter, scales, offsets), broadcasting a new one if there isn't one
+std::string MarkerFitterRemote::getSubjectId(
+    const MarkerFitter* fitter,
+    const Eigen::VectorXs& groupScales,
+    const std::map<std::string, Eigen::Vector3s>& markerOffsets)
+{
+  // Hold the lock through the broadcast, so that blocks submitted at the same
+  // time for a new subject wait for it rather than each sending their own
+  const std::lock_guard<std::mutex> lock(mMutex);
+  for (const Subject& subject : mSubjects)
+  {
+    if (subject.fitter == fitter
+        && subject.groupScales.size() == groupScales.size()
+        && subject.groupScales == groupScales
+        && subject.markerOffsets == markerOffsets)
+    {
+      return subject.id;
+    }
+  }
+
+  Subject subject;
+  subject.id = mSessionId + "_" + std::to_string(mNextSubjectId);
+  mNextSubjectId++;
+  subject.fitter = fitter;
+  subject.groupScales = groupScales;
+  subject.markerOffsets = markerOffsets;
+
+  proto::MarkerFitterLoadSubjectRequest request;
+  request.set_subjectid(subject.id);
+  request.set_osimfilecontents(mOsimFileContents);
+  for (int i = 0; i < fitter->mMarkerNames.size(); i++)
+  {
+    const std::string& name = fitter->mMarkerNames[i];
+    auto& marker = fitter->mMarkerMap.at(name);
+    proto::MarkerFitterMarker* markerProto = request.add_markers();
+    markerProto->set_name(name);
+    markerProto->set_bodyname(marker.first->getName());
+    proto::serializeVector(*markerProto->mutable_offset(), marker.second);
+    markerProto->set_istracking(fitter->mMarkerIsTracking[i]);
+  }
+  proto::serializeVector(*request.mutable_groupscales(), groupScales);
+  for (auto& pair : markerOffsets)
+  {
+    proto::serializeVector(
+        (*request.mutable_markeroffsets())[pair.first], pair.second);
+  }
+  request.set_initialiksatisfactoryloss(
+      static_cast<double>(fitter->mInitialIKSatisfactoryLoss));
+  request.set_initialikmaxrestarts(fitter->mInitialIKMaxRestarts);
+  request.set_usetemporalwarmstart(fitter->mUseTemporalWarmStart);
+  request.set_uselevenbergmarquardtik(fitter->mUseLevenbergMarquardtIK);
+  request.set_anatomicalmarkerdefaultweight(
+      static_cast<double>(fitter->mAnatomicalMarkerDefaultWeight));
+  request.set_trackingmarkerdefaultweight(
+      static_cast<double>(fitter->mTrackingMarkerDefaultWeight));
+
+  for (int i = 0; i < mStubs.size(); i++)
+  {
+    grpc::ClientContext context;
+    proto::MarkerFitterLoadSubjectReply reply;
+    grpc::Status status = mStubs[i]->LoadSubject(&context, request, &reply);
+    if (!status.ok())
+    {
+      // Tasks sent to this worker will fail, and get fit locally
+      std::cout << "MarkerFitterRemote couldn't load the subject on worker "
+                << i << ": " << status.error_message() << std::endl;
+    }
+  }
+
+  mSubjects.push_back(subject);
+  if (mSubjects.size() > MAX_SUBJECTS)
+  {
+    mSubjects.pop_front();
+  }
+  return subject.id;
+}
+
+//==============================================================================
+grpc::Status MarkerFitterWorker::LoadSubject(
+    grpc::ServerContext* /* context */,
+    const proto::MarkerFitterLoadSubjectRequest* request,
+    proto::MarkerFitterLoadSubjectReply* /* reply */)
+{
+  // The parser reads from a URI, so put the model somewhere it can find it
+  char path[] = "/tmp/nimble_marker_fitter_XXXXXX.osim";
+  int fd = mkstemps(path, 5);
+  if (fd == -1)
+  {
+    return grpc::Status(
+        grpc::StatusCode::INTERNAL, "Couldn't create a temporary *.osim file");
+  }
+  const std::string& contents = request->osimfilecontents();
+  bool wroteAll
+      = write(fd, contents.data(), contents.size()) == (ssize_t)contents.size();
+  close(fd);
+  OpenSimFile file;
+  if (wroteAll)
+  {
+    file = OpenSimParser::parseOsimUncached(common::Uri::createFromPath(path));
+  }
+  std::remove(path);
+  if (!wroteAll || file.skeleton == nullptr)
+  {
+    return grpc::Status(
+        grpc::StatusCode::INVALID_ARGUMENT, "Couldn't parse the *.osim file");
+  }
+
+  dynamics::MarkerMap markers;
+  for (const proto::MarkerFitterMarker& marker : request->markers())
+  {
+    dynamics::BodyNode* body = file.skeleton->getBodyNode(marker.bodyname());
+    if (body == nullptr)
+    {
+      return grpc::Status(
+          grpc::StatusCode::INVALID_ARGUMENT,
+          "Marker " + marker.name() + " is on missing body "
+              + marker.bodyname());
+    }
+    markers[marker.name()]
+        = std::make_pair(body, proto::deserializeVector(marker.offset()));
+  }
+
+  std::shared_ptr<Subject> subject = std::make_shared<Subject>();
+  subject->fitter = std::make_shared<MarkerFitter>(file.skeleton, markers);
+  for (const proto::MarkerFitterMarker& marker : request->markers())
+  {
+    subject->fitter->setMarkerIsTracking(marker.name(), marker.istracking());
+  }
+  subject->fitter->mInitialIKSatisfactoryLoss
+      = request->initialiksatisfactoryloss();
+  subject->fitter->mInitialIKMaxRestarts = request->initialikmaxrestarts();
+  subject->fitter->mUseTemporalWarmStart = request->usetemporalwarmstart();
+  subject->fitter->mUseLevenbergMarquardtIK
+      = request->uselevenbergmarquardtik();
+  subject->fitter->mAnatomicalMarkerDefaultWeight
+      = request->anatomicalmarkerdefaultweight();
+  subject->fitter->mTrackingMarkerDefaultWeight
+      = request->trackingmarkerdefaultweight();
+  subject->groupScales = proto::deserializeVector(request->groupscales());
+  for (auto& pair : request->markeroffsets())
+  {
+    subject->markerOffsets[pair.first] = proto::deserializeVector(pair.second);
+  }
+
+  const std::lock_guard<std::mutex> lock(mMutex);
+  if (mSubjects.count(request->subjectid()) == 0)
+  {
+    mSubjectOrder.push_back(request->subjectid());
+  }
+  mSubjects[request->subjectid()] = subject;
+  while (mSubjectOrder.size() > MarkerFitterRemote::MAX_SUBJECTS)
+  {
+    mSubjects.erase(mSubjectOrder.front());
+    mSubjectOrder.pop_front();
+  }
+  return grpc::Status::OK;
+}
+
+//==============================================================================
+grpc::Status MarkerFitterWorker::FitTrajectory(
+    grpc::ServerContext* /* context */,
+    const proto::MarkerFitterFitTrajectoryRequest* request,
+    proto::MarkerFitterFitTrajectoryReply* reply)
+{
+  std::shared_ptr<Subject> subject;
+  {
+    const std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mSubjects.find(request->subjectid());
+    if (it == mSubjects.end())
+    {
+      return grpc::Status(
+          grpc::StatusCode::NOT_FOUND,
+          "Unknown subject " + request->subjectid());
+    }
+    subject = it->second;
+  }
+
+  int numFrames = request->markerobservations_size();
+  std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations;
+  for (const proto::MarkerFitterObservationFrame& frame :
+       request->markerobservations())
+  {
+    markerObservations.emplace_back();
+    for (int i = 0; i < frame.names_size(); i++)
+    {
+      markerObservations[markerObservations.size() - 1][frame.names(i)]
+          = Eigen::Vector3s(
+              frame.positions(i * 3),
+              frame.positions(i * 3 + 1),
+              frame.positions(i * 3 + 2));
+    }
+  }
+  std::map<std::string, s_t> markerWeights;
+  for (auto& pair : request->markerweights())
+  {
+    markerWeights[pair.first] = pair.second;
+  }
+  std::vector<dynamics::Joint*> joints;
+  for (const std::string& name : request->jointnames())
+  {
+    dynamics::Joint* joint = subject->fitter->mSkeleton->getJoint(name);
+    if (joint == nullptr)
+    {
+      return grpc::Status(
+          grpc::StatusCode::INVALID_ARGUMENT, "Unknown joint " + name);
+    }
+    joints.push_back(joint);
+  }
+
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(
+      subject->fitter->mSkeleton->getNumDofs(), numFrames);
+  Eigen::VectorXs scores = Eigen::VectorXs::Zero(numFrames);
+  MarkerFitter::fitTrajectory(
+      subject->fitter.get(),
+      subject->groupScales,
+      proto::deserializeVector(request->firstposeguess()),
+      markerObservations,
+      markerWeights,
+      subject->markerOffsets,
+      joints,
+      unpackColumns(
+          proto::deserializeMatrix(request->jointcenters()), numFrames),
+      proto::deserializeVector(request->jointweights()),
+      unpackColumns(proto::deserializeMatrix(request->jointaxis()), numFrames),
+      proto::deserializeVector(request->axisweights()),
+      poses,
+      scores,
+      request->backwards());
+
+  proto::serializeMatrix(*reply->mutable_poses(), poses);
+  proto::serializeVector(*reply->mutable_scores(), scores);
+  return grpc::Status::OK;
+}
+
+//==============================================================================
+/// This launches a worker on the specified port. This call blocks.
+void MarkerFitterWorker::serve(int port)
+{
+  std::string server_address("0.0.0.0:" + std::to_string(port));
+
+  grpc::EnableDefaultHealthCheckService(true);
+  grpc::ServerBuilder builder;
+  // Subjects carry a whole *.osim file, which can be over the 4MB default
+  builder.SetMaxReceiveMessageSize(-1);
+  builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+  MarkerFitterWorker worker;
+  builder.RegisterService(&worker);
+  std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+  std::cout << "MarkerFitterWorker listening on " << server_address
+            << std::endl;
+
+  // Wait for the server to shutdown. Note that some other thread must be
+  // responsible for shutting down the server for this call to ever return.
+  server->Wait();
+}
+
+} // namespace biomechanics
+} // namespace dart
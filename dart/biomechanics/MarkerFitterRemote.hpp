@@ -0,0 +1,127 @@
+#ifndef DART_BIOMECH_MARKERFITTERREMOTE_HPP_
+#define DART_BIOMECH_MARKERFITTERREMOTE_HPP_
+
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/biomechanics/MarkerFitter.hpp"
+#include "dart/common/Uri.hpp"
+#include "dart/math/MathTypes.hpp"
+#include "dart/proto/MarkerFitter.grpc.pb.h"
+
+namespace grpc {
+class Channel;
+}
+
+namespace dart {
+
+namespace biomechanics {
+
+/// This shards the per-frame IK blocks of a MarkerFitter out over a set of
+/// MarkerFitterWorker servers, over gRPC. Pass it to
+/// MarkerFitter::setTrajectoryFitDispatcher().
+///
+/// The skeleton, markers, scales and marker offsets only get sent to each
+/// worker once per subject (and again whenever the scales or offsets
+/// change), and each task just refers back to them. Tasks go to whichever
+/// worker has the fewest in flight. If a task fails on its worker (say, the
+/// worker restarted and lost the subject), it's fit locally instead.
+class MarkerFitterRemote : public TrajectoryFitDispatcher
+{
+public:
+  /// The workers are given as "host:port" addresses. The skeleton of every
+  /// fitter that uses this must have come from the *.osim file at `osimUri`,
+  /// which gets sent to the workers so they don't need access to it.
+  MarkerFitterRemote(
+      const std::vector<std::string>& workerAddresses,
+      const common::Uri& osimUri);
+
+  std::future<void> submit(
+      const MarkerFitter* fitter,
+      Eigen::VectorXs groupScales,
+      Eigen::VectorXs firstPoseGuess,
+      std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations,
+      std::map<std::string, s_t> markerWeights,
+      std::map<std::string, Eigen::Vector3s> markerOffsets,
+      std::vector<dynamics::Joint*> joints,
+      std::vector<Eigen::VectorXs> jointCenters,
+      Eigen::VectorXs jointWeights,
+      std::vector<Eigen::VectorXs> jointAxis,
+      Eigen::VectorXs axisWeights,
+      Eigen::Ref<Eigen::MatrixXs> result,
+      Eigen::Ref<Eigen::VectorXs> resultScores,
+      bool backwards) override;
+
+  /// Workers only hold on to this many subjects at once, dropping the oldest
+  static constexpr int MAX_SUBJECTS = 32;
+
+protected:
+  struct Subject
+  {
+    std::string id;
+    const MarkerFitter* fitter;
+    Eigen::VectorXs groupScales;
+    std::map<std::string, Eigen::Vector3s> markerOffsets;
+  };
+
+  /// This returns the id of a subject the workers already have for this
+  /// (fitter, scales, offsets), broadcasting a new one if there isn't one
+  std::string getSubjectId(
+      const MarkerFitter* fitter,
+      const Eigen::VectorXs& groupScales,
+      const std::map<std::string, Eigen::Vector3s>& markerOffsets);
+
+  /// This gets prefixed to our subject ids, so workers shared between several
+  /// clients don't mix up their subjects
+  std::string mSessionId;
+  std::string mOsimFileContents;
+  std::vector<std::shared_ptr<grpc::Channel>> mChannels;
+  std::vector<std::unique_ptr<proto::MarkerFitterWorkerService::Stub>> mStubs;
+
+  std::mutex mMutex;
+  std::vector<int> mTasksInFlight;
+  std::deque<Subject> mSubjects;
+  int mNextSubjectId;
+};
+
+/// This serves fitTrajectory() tasks from a MarkerFitterRemote
+class MarkerFitterWorker : public proto::MarkerFitterWorkerService::Service
+{
+public:
+  grpc::Status LoadSubject(
+      grpc::ServerContext* context,
+      const proto::MarkerFitterLoadSubjectRequest* request,
+      proto::MarkerFitterLoadSubjectReply* reply) override;
+
+  grpc::Status FitTrajectory(
+      grpc::ServerContext* context,
+      const proto::MarkerFitterFitTrajectoryRequest* request,
+      proto::MarkerFitterFitTrajectoryReply* reply) override;
+
+  /// This launches a worker on the specified port. This call blocks.
+  static void serve(int port);
+
+protected:
+  struct Subject
+  {
+    std::shared_ptr<MarkerFitter> fitter;
+    Eigen::VectorXs groupScales;
+    std::map<std::string, Eigen::Vector3s> markerOffsets;
+  };
+
+  std::mutex mMutex;
+  std::map<std::string, std::shared_ptr<Subject>> mSubjects;
+  std::deque<std::string> mSubjectOrder;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -1,5 +1,8 @@
 #include "dart/biomechanics/MarkerLabeller.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <string>
@@ -10,6 +13,7 @@
 #include "dart/math/AssignmentMatcher.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/SpatialHash.hpp"
 
 namespace dart {
 namespace biomechanics {
@@ -75,18 +79,26 @@ s_t MarkerTrace::pointToAppendDistance(
   {
     return 0.0;
   }
+  return (point - expectedAppendPoint(time, extrapolate)).norm();
+}
+
+//==============================================================================
+/// This gives the point that pointToAppendDistance() measures from: the last
+/// point, or (if extrapolate is true) its linear extrapolation to `time`.
+/// This must not be called on an empty trace.
+Eigen::Vector3s MarkerTrace::expectedAppendPoint(int time, bool extrapolate)
+{
   Eigen::Vector3s& lastPoint = mPoints.at(mPoints.size() - 1);
   if (extrapolate && mPoints.size() > 1)
   {
     int lastTime = mTimes.at(mTimes.size() - 1);
     Eigen::Vector3d v = (lastPoint - mPoints.at(mPoints.size() - 2))
                         / (lastTime - mTimes.at(mTimes.size() - 2));
-    Eigen::Vector3s projected = lastPoint + (v * (time - lastTime));
-    return (point - projected).norm();
+    return lastPoint + (v * (time - lastTime));
   }
   else
   {
-    return (point - lastPoint).norm();
+    return lastPoint;
   }
 }
 
@@ -99,73 +111,182 @@ std::vector<MarkerTrace> MarkerTrace::createRawTraces(
     s_t mergeDistance,
     int mergeFrames)
 {
-  std::vector<MarkerTrace> traces;
-  std::vector<int> activeTraces;
+  MarkerTraceTracker tracker(mergeDistance, mergeFrames);
   for (int t = 0; t < pointClouds.size(); t++)
   {
-    // 1. Only count as "active" the traces that are within `mergeFrames` of now
-    std::vector<int> tracesToRemove;
-    for (int i = 0; i < activeTraces.size(); i++)
+    tracker.addFrame(t, pointClouds[t]);
+  }
+  return tracker.getTraces();
+}
+
+//==============================================================================
+MarkerTraceTracker::MarkerTraceTracker(
+    s_t mergeDistance, int mergeFrames, bool keepInactiveTraces)
+  : mMergeDistance(mergeDistance),
+    mMergeFrames(mergeFrames),
+    mKeepInactiveTraces(keepInactiveTraces),
+    // The hash needs a positive, finite cell size. Otherwise, we just score
+    // every pair.
+    mUseHash(mergeDistance > 0 && std::isfinite(mergeDistance)),
+    // Pad the cells a hair, so round-off at a cell boundary never hides a pair
+    // that is right at `mergeDistance`
+    mActiveTraceHash(mUseHash ? mergeDistance * (1 + 1e-6) : 1.0)
+{
+}
+
+//==============================================================================
+/// This adds the point cloud observed at `time`, which must be later than
+/// any time passed in before. This returns, for each point, the index into
+/// getTraces() of the trace it was appended to (or started).
+std::vector<int> MarkerTraceTracker::addFrame(
+    int t, const std::vector<Eigen::Vector3s>& pointCloud)
+{
+  // 1. Only count as "active" the traces that are within `mergeFrames` of now
+  deactivateStaleTraces(t);
+
+  std::vector<int> pointTraces(pointCloud.size(), -1);
+  // Bail early on empty frames
+  if (pointCloud.size() == 0)
+  {
+    return pointTraces;
+  }
+
+  // 2. Find the (point, trace) pairs within `mergeDistance`. Only traces
+  // whose expected position is in a neighboring cell of the hash can be
+  // close enough, so we never score any of the others.
+  if (mUseHash)
+  {
+    mActiveTraceHash.clear();
+    for (int j = 0; j < mActiveTraces.size(); j++)
+    {
+      mActiveTraceHash.insert(
+          mTraces[mActiveTraces[j]].expectedAppendPoint(t, true), j);
+    }
+  }
+  mEdges.clear();
+  s_t maxDist = 0.0;
+  for (int i = 0; i < pointCloud.size(); i++)
+  {
+    if (mUseHash)
+    {
+      mActiveTraceHash.findNeighbors(pointCloud[i], mCandidates);
+    }
+    else
     {
-      if (traces[activeTraces[i]].lastTimestep() < t - mergeFrames)
+      mCandidates.resize(mActiveTraces.size());
+      for (int j = 0; j < mActiveTraces.size(); j++)
       {
-        // This needs to be deactivated
-        tracesToRemove.push_back(i);
+        mCandidates[j] = j;
       }
     }
-    for (int j = tracesToRemove.size() - 1; j >= 0; j--)
+    for (int j : mCandidates)
     {
-      activeTraces.erase(activeTraces.begin() + tracesToRemove[j]);
+      s_t dist = mTraces[mActiveTraces[j]].pointToAppendDistance(
+          t, pointCloud[i], true);
+      if (dist <= mMergeDistance)
+      {
+        mEdges.push_back(math::AssignmentMatcher::Edge{i, j, dist});
+        maxDist = std::max(maxDist, dist);
+      }
     }
+  }
 
-    // Bail early on empty frames
-    if (pointClouds[t].size() == 0)
+  // 3. Assign points to active traces, or create new traces for unassigned
+  // points. We maximize the total of (gate - distance), which is the usual
+  // gated nearest-neighbor objective: a pair is only worth matching if it
+  // beats leaving both sides unmatched. Each trace's price is carried over
+  // from the last frame, which warm starts the auction.
+  const s_t gate = mUseHash ? mMergeDistance : maxDist + 1.0;
+  for (auto& edge : mEdges)
+  {
+    edge.weight = gate - edge.weight;
+  }
+  Eigen::VectorXs prices(mActiveTraces.size());
+  for (int j = 0; j < mActiveTraces.size(); j++)
+  {
+    prices(j) = mTracePrices[mActiveTraces[j]];
+  }
+  Eigen::VectorXi map = math::AssignmentMatcher::assignRowsToColumnsSparse(
+      pointCloud.size(), mActiveTraces.size(), mEdges, &prices);
+  for (int j = 0; j < mActiveTraces.size(); j++)
+  {
+    mTracePrices[mActiveTraces[j]] = prices(j);
+  }
+  for (int i = 0; i < map.size(); i++)
+  {
+    if (map(i) == -1)
     {
-      continue;
+      mTraces.emplace_back(t, pointCloud[i]);
+      mTracePrices.push_back(0.0);
+      assert(mTraces.at(mTraces.size() - 1).mPoints.size() == 1);
+      mActiveTraces.push_back(mTraces.size() - 1);
+      pointTraces[i] = mTraces.size() - 1;
     }
-
-    // 2. Compute affinity scores between active traces and points
-    Eigen::MatrixXs weights
-        = Eigen::MatrixXs(pointClouds[t].size(), activeTraces.size());
-    for (int i = 0; i < pointClouds[t].size(); i++)
+    else
     {
-      for (int j = 0; j < activeTraces.size(); j++)
+      MarkerTrace& trace = mTraces[mActiveTraces[map(i)]];
+      trace.appendPoint(t, pointCloud[i]);
+      if (!mKeepInactiveTraces && trace.mPoints.size() > 2)
       {
-        s_t dist = traces[activeTraces[j]].pointToAppendDistance(
-            t, pointClouds[t][i], true);
-        if (dist > mergeDistance)
-        {
-          weights(i, j) = -1 * std::numeric_limits<double>::infinity();
-        }
-        else
-        {
-          weights(i, j) = 1.0 / dist;
-        }
+        // Extrapolation only ever looks at the last two points
+        trace.mPoints.erase(trace.mPoints.begin());
+        trace.mTimes.erase(trace.mTimes.begin());
       }
+      pointTraces[i] = mActiveTraces[map(i)];
     }
+  }
+
+  return pointTraces;
+}
+
+//==============================================================================
+/// These are all the traces so far (or, if we're not keeping inactive
+/// traces, just the ones still active). Indices into this are only stable
+/// until the next call to addFrame().
+std::vector<MarkerTrace>& MarkerTraceTracker::getTraces()
+{
+  return mTraces;
+}
 
-    // 3. Assign points to active traces, or create new traces for unassigned
-    // points
-    Eigen::VectorXi map = math::AssignmentMatcher::assignRowsToColumns(weights);
-    for (int i = 0; i < map.size(); i++)
+//==============================================================================
+/// This returns the indices into getTraces() of the active traces
+const std::vector<int>& MarkerTraceTracker::getActiveTraces() const
+{
+  return mActiveTraces;
+}
+
+//==============================================================================
+/// This drops traces that haven't seen a point within `mergeFrames` of
+/// `time` from the active set (and from memory, if we're not keeping them)
+void MarkerTraceTracker::deactivateStaleTraces(int t)
+{
+  std::vector<int> stillActive;
+  stillActive.reserve(mActiveTraces.size());
+  for (int i = 0; i < mActiveTraces.size(); i++)
+  {
+    if (mTraces[mActiveTraces[i]].lastTimestep() >= t - mMergeFrames)
     {
-      if (map(i) == -1)
-      {
-        traces.emplace_back(t, pointClouds[t][i]);
-        assert(traces.at(traces.size() - 1).mPoints.size() == 1);
-        activeTraces.push_back(traces.size() - 1);
-        assert(
-            traces.at(activeTraces.at(activeTraces.size() - 1)).mPoints.size()
-            == 1);
-      }
-      else
-      {
-        traces[activeTraces[map(i)]].appendPoint(t, pointClouds[t][i]);
-      }
+      stillActive.push_back(mActiveTraces[i]);
     }
   }
+  mActiveTraces.swap(stillActive);
 
-  return traces;
+  if (!mKeepInactiveTraces)
+  {
+    // Compact the traces down to just the active ones, keeping their order
+    std::vector<MarkerTrace> traces;
+    std::vector<s_t> prices;
+    traces.reserve(mActiveTraces.size());
+    prices.reserve(mActiveTraces.size());
+    for (int i = 0; i < mActiveTraces.size(); i++)
+    {
+      traces.push_back(std::move(mTraces[mActiveTraces[i]]));
+      prices.push_back(mTracePrices[mActiveTraces[i]]);
+      mActiveTraces[i] = i;
+    }
+    mTraces.swap(traces);
+    mTracePrices.swap(prices);
+  }
 }
 
 //==============================================================================
@@ -693,7 +814,6 @@ LabelledMarkers MarkerLabeller::labelPointClouds(
   }
 
   // 5. Now we can ditch the traces, and reconstruct labeled point clouds
-  std::vector<std::map<std::string, Eigen::Vector3s>> labeledPointClouds;
 
   // 5.1. Create all the blank timestep objects we need
   int maxTimestep = 0;
@@ -704,22 +824,26 @@ LabelledMarkers MarkerLabeller::labelPointClouds(
       maxTimestep = trace.mMaxTime;
     }
   }
-  for (int i = 0; i <= maxTimestep; i++)
+  std::vector<std::string> markerNames;
+  for (auto& pair : markers)
   {
-    labeledPointClouds.emplace_back();
+    markerNames.push_back(pair.first);
   }
+  MarkerTrajectories labeledPointClouds(markerNames, maxTimestep + 1);
 
   // 5.2. Populate the labeled point clouds
   for (MarkerTrace& trace : traces)
   {
+    int markerIndex = labeledPointClouds.getMarkerIndex(trace.mMarkerLabel);
     for (int i = 0; i < trace.mTimes.size(); i++)
     {
-      labeledPointClouds[trace.mTimes[i]][trace.mMarkerLabel]
-          = trace.mPoints[i];
+      labeledPointClouds.setPosition(
+          trace.mTimes[i], markerIndex, trace.mPoints[i]);
     }
   }
 
-  result.markerObservations = labeledPointClouds;
+  result.markerTrajectories = labeledPointClouds;
+  result.markerObservations = labeledPointClouds.toFrameMaps();
   result.markerOffsets = markers;
   result.jointCenterGuesses = jointCenters;
   result.traces = traces;
@@ -735,15 +859,27 @@ void MarkerLabeller::evaluate(
         markerOffsets,
     const std::vector<std::map<std::string, Eigen::Vector3s>>&
         labeledPointClouds)
+{
+  evaluate(
+      markerOffsets, MarkerTrajectories::fromFrameMaps(labeledPointClouds));
+}
+
+//==============================================================================
+/// This is the same as evaluate() on per-frame maps, but reads the labeled
+/// point clouds straight out of a columnar MarkerTrajectories store.
+void MarkerLabeller::evaluate(
+    const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+        markerOffsets,
+    const MarkerTrajectories& labeledPointClouds)
 {
   // 1. Create an unlabeled copy of the point clouds
   std::vector<std::vector<Eigen::Vector3s>> pointClouds;
-  for (int t = 0; t < labeledPointClouds.size(); t++)
+  for (int t = 0; t < labeledPointClouds.getNumFrames(); t++)
   {
     std::vector<Eigen::Vector3s> pointCloud;
-    for (auto& pair : labeledPointClouds[t])
+    for (const auto& observation : labeledPointClouds.getFrame(t))
     {
-      pointCloud.push_back(pair.second);
+      pointCloud.push_back(observation.position);
     }
     pointClouds.push_back(pointCloud);
   }
@@ -780,13 +916,13 @@ void MarkerLabeller::evaluate(
       std::string trueBody = "";
       Eigen::Vector3s trueOffset = Eigen::Vector3s::Zero();
       bool foundPoint = false;
-      for (auto& pair : labeledPointClouds[t])
+      for (const auto& observation : labeledPointClouds.getFrame(t))
       {
-        if ((pair.second - p).squaredNorm() < 1e-9)
+        if ((observation.position - p).squaredNorm() < 1e-9)
         {
-          markerName = pair.first;
-          trueBody = markerOffsets.at(pair.first).first;
-          trueOffset = markerOffsets.at(pair.first).second;
+          markerName = observation.name;
+          trueBody = markerOffsets.at(observation.name).first;
+          trueOffset = markerOffsets.at(observation.name).second;
           foundPoint = true;
           break;
         }
@@ -1006,7 +1142,18 @@ void MarkerLabeller::evaluate(
 NeuralMarkerLabeller::NeuralMarkerLabeller(
     std::function<std::vector<std::map<std::string, Eigen::Vector3s>>(
         const std::vector<std::vector<Eigen::Vector3s>>&)> jointCenterPredictor)
-  : mJointCenterPredictor(jointCenterPredictor)
+  : mJointCenterPredictor(jointCenterPredictor), mMaxBatchSize(0)
+{
+}
+
+//==============================================================================
+NeuralMarkerLabeller::NeuralMarkerLabeller(
+    BatchedJointCenterPredictor batchedJointCenterPredictor,
+    const std::vector<std::string>& jointNames,
+    int maxBatchSize)
+  : mBatchedJointCenterPredictor(batchedJointCenterPredictor),
+    mJointNames(jointNames),
+    mMaxBatchSize(maxBatchSize)
 {
 }
 
@@ -1020,7 +1167,70 @@ std::vector<std::map<std::string, Eigen::Vector3s>>
 NeuralMarkerLabeller::guessJointLocations(
     const std::vector<std::vector<Eigen::Vector3s>>& pointClouds)
 {
-  return mJointCenterPredictor(pointClouds);
+  if (!mBatchedJointCenterPredictor)
+  {
+    return mJointCenterPredictor(pointClouds);
+  }
+
+  const int numFrames = pointClouds.size();
+  int maxPoints = 0;
+  for (const std::vector<Eigen::Vector3s>& cloud : pointClouds)
+  {
+    maxPoints = std::max(maxPoints, (int)cloud.size());
+  }
+  const int batchSize = mMaxBatchSize > 0
+                            ? std::min(mMaxBatchSize, numFrames)
+                            : numFrames;
+  const int numJoints = mJointNames.size();
+
+  std::vector<std::map<std::string, Eigen::Vector3s>> jointCenters;
+  jointCenters.reserve(numFrames);
+
+  // These get reused across batches. The last batch can be short, in which
+  // case we only hand over its top rows, which are still contiguous.
+  PointsBatch points = PointsBatch::Zero(batchSize, maxPoints * 3);
+  MaskBatch mask = MaskBatch::Constant(batchSize, maxPoints, false);
+  for (int start = 0; start < numFrames; start += batchSize)
+  {
+    const int rows = std::min(batchSize, numFrames - start);
+    points.setZero();
+    mask.setConstant(false);
+    for (int row = 0; row < rows; row++)
+    {
+      const std::vector<Eigen::Vector3s>& cloud = pointClouds[start + row];
+      for (int i = 0; i < cloud.size(); i++)
+      {
+        points.block<1, 3>(row, i * 3) = cloud[i].transpose();
+        mask(row, i) = true;
+      }
+    }
+
+    Eigen::MatrixXs predicted = mBatchedJointCenterPredictor(
+        points.topRows(rows), mask.topRows(rows));
+    if (predicted.rows() != rows || predicted.cols() != numJoints * 3)
+    {
+      std::cout << "NeuralMarkerLabeller: the batched predictor returned a "
+                << predicted.rows() << "x" << predicted.cols()
+                << " matrix, but we expected " << rows << "x" << numJoints * 3
+                << " (one (x, y, z) per joint name, for each frame). Leaving "
+                   "those frames without joint centers."
+                << std::endl;
+      assert(false);
+      jointCenters.resize(start + rows);
+      continue;
+    }
+    for (int row = 0; row < rows; row++)
+    {
+      std::map<std::string, Eigen::Vector3s> frame;
+      for (int j = 0; j < numJoints; j++)
+      {
+        frame[mJointNames[j]] = predicted.block<1, 3>(row, j * 3).transpose();
+      }
+      jointCenters.push_back(frame);
+    }
+  }
+
+  return jointCenters;
 }
 
 //==============================================================================
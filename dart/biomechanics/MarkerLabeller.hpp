@@ -15,11 +15,14 @@
 
 #include "dart/biomechanics/Anthropometrics.hpp"
 #include "dart/biomechanics/C3DLoader.hpp"
+#include "dart/biomechanics/MarkerTrajectories.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/Shape.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/AssignmentMatcher.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/SpatialHash.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
 
 namespace dart {
@@ -59,6 +62,11 @@ public:
   /// timestep of the last point, of order up to 2)
   s_t pointToAppendDistance(int time, Eigen::Vector3s point, bool extrapolate);
 
+  /// This gives the point that pointToAppendDistance() measures from: the last
+  /// point, or (if extrapolate is true) its linear extrapolation to `time`.
+  /// This must not be called on an empty trace.
+  Eigen::Vector3s expectedAppendPoint(int time, bool extrapolate);
+
   /// This merges point clouds over time, to create a set of raw MarkerTraces
   /// over time. These traces can then be intelligently merged using any desired
   /// algorithm.
@@ -97,8 +105,62 @@ public:
   int lastTimestep();
 };
 
+/// This builds MarkerTraces incrementally, one point cloud at a time. This is
+/// what MarkerTrace::createRawTraces() runs over a whole trial, and it's also
+/// what streaming consumers (like StreamingMarkerFitter) use to track markers
+/// frame by frame during a live capture.
+class MarkerTraceTracker
+{
+public:
+  /// Points get appended to an active trace if they land within
+  /// `mergeDistance` of where that trace is expected to be, and traces stop
+  /// being active once they've gone `mergeFrames` without a point. If
+  /// `keepInactiveTraces` is false, traces get dropped once they go inactive,
+  /// and each trace only keeps the last few points it needs to extrapolate,
+  /// so memory stays bounded no matter how long the stream runs.
+  MarkerTraceTracker(
+      s_t mergeDistance = 0.01,
+      int mergeFrames = 5,
+      bool keepInactiveTraces = true);
+
+  /// This adds the point cloud observed at `time`, which must be later than
+  /// any time passed in before. This returns, for each point, the index into
+  /// getTraces() of the trace it was appended to (or started).
+  std::vector<int> addFrame(
+      int time, const std::vector<Eigen::Vector3s>& pointCloud);
+
+  /// These are all the traces so far (or, if we're not keeping inactive
+  /// traces, just the ones still active). Indices into this are only stable
+  /// until the next call to addFrame().
+  std::vector<MarkerTrace>& getTraces();
+
+  /// This returns the indices into getTraces() of the active traces
+  const std::vector<int>& getActiveTraces() const;
+
+protected:
+  /// This drops traces that haven't seen a point within `mergeFrames` of
+  /// `time` from the active set (and from memory, if we're not keeping them)
+  void deactivateStaleTraces(int time);
+
+  s_t mMergeDistance;
+  int mMergeFrames;
+  bool mKeepInactiveTraces;
+  bool mUseHash;
+
+  std::vector<MarkerTrace> mTraces;
+  std::vector<s_t> mTracePrices;
+  std::vector<int> mActiveTraces;
+
+  // These are just scratch space, kept around to avoid reallocating each frame
+  math::SpatialHash mActiveTraceHash;
+  std::vector<int> mCandidates;
+  std::vector<math::AssignmentMatcher::Edge> mEdges;
+};
+
 struct LabelledMarkers
 {
+  MarkerTrajectories markerTrajectories;
+  // This is a copy of `markerTrajectories` as one map per frame
   std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations;
   std::map<std::string, std::pair<std::string, Eigen::Vector3s>> markerOffsets;
   std::vector<std::map<std::string, Eigen::Vector3s>> jointCenterGuesses;
@@ -136,6 +198,13 @@ public:
       const std::vector<std::map<std::string, Eigen::Vector3s>>&
           labeledPointClouds);
 
+  /// This is the same as evaluate() on per-frame maps, but reads the labeled
+  /// point clouds straight out of a columnar MarkerTrajectories store.
+  void evaluate(
+      const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+          markerOffsets,
+      const MarkerTrajectories& labeledPointClouds);
+
 protected:
   std::shared_ptr<dynamics::Skeleton> mSkeleton;
   std::map<std::string, std::string> mJointToSkelJointNames;
@@ -144,11 +213,37 @@ protected:
 class NeuralMarkerLabeller : public MarkerLabeller
 {
 public:
+  /// A batch of point clouds, one frame per row. Row t holds the points of
+  /// frame t as consecutive (x, y, z) triples, padded with zeros.
+  using PointsBatch
+      = Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /// Which points in a PointsBatch are real, as one row of N flags per frame
+  using MaskBatch
+      = Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /// This takes a T x 3N PointsBatch and its T x N MaskBatch, and returns a
+  /// T x 3J matrix of predicted joint centers, one (x, y, z) per joint name.
+  /// Both inputs point straight into the labeller's buffers: from Python they
+  /// arrive as numpy arrays that share that memory (so `points.reshape(T, N,
+  /// 3)` and torch.from_numpy() don't copy), and they're only valid until the
+  /// predictor returns.
+  using BatchedJointCenterPredictor = std::function<Eigen::MatrixXs(
+      Eigen::Ref<const PointsBatch> points, Eigen::Ref<const MaskBatch> mask)>;
+
   NeuralMarkerLabeller(
       std::function<std::vector<std::map<std::string, Eigen::Vector3s>>(
           const std::vector<std::vector<Eigen::Vector3s>>&)>
           jointCenterPredictor);
 
+  /// This builds a labeller around a predictor that sees many frames per
+  /// call. Frames go to the predictor in batches of at most `maxBatchSize`
+  /// (or all at once, if that's 0).
+  NeuralMarkerLabeller(
+      BatchedJointCenterPredictor batchedJointCenterPredictor,
+      const std::vector<std::string>& jointNames,
+      int maxBatchSize = 0);
+
   virtual ~NeuralMarkerLabeller();
 
   virtual std::vector<std::map<std::string, Eigen::Vector3s>>
@@ -159,6 +254,10 @@ protected:
   std::function<std::vector<std::map<std::string, Eigen::Vector3s>>(
       const std::vector<std::vector<Eigen::Vector3s>>&)>
       mJointCenterPredictor;
+
+  BatchedJointCenterPredictor mBatchedJointCenterPredictor;
+  std::vector<std::string> mJointNames;
+  int mMaxBatchSize;
 };
 
 class MarkerLabellerMock : public MarkerLabeller
@@ -0,0 +1,347 @@
+#include "dart/biomechanics/MarkerTrajectories.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <set>
+
+namespace dart {
+namespace biomechanics {
+
+//==============================================================================
+MarkerTrajectories::Frame::const_iterator::const_iterator(
+    const MarkerTrajectories* trajectories, int frame, int i)
+  : mTrajectories(trajectories), mFrame(frame), mMarker(i)
+{
+  skipHidden();
+}
+
+//==============================================================================
+MarkerTrajectories::Observation
+MarkerTrajectories::Frame::const_iterator::operator*() const
+{
+  return Observation{mMarker,
+                     mTrajectories->mMarkerNames[mMarker],
+                     mTrajectories->getPosition(mFrame, mMarker)};
+}
+
+//==============================================================================
+MarkerTrajectories::Frame::const_iterator&
+MarkerTrajectories::Frame::const_iterator::operator++()
+{
+  mMarker++;
+  skipHidden();
+  return *this;
+}
+
+//==============================================================================
+bool MarkerTrajectories::Frame::const_iterator::operator==(
+    const const_iterator& other) const
+{
+  return mTrajectories == other.mTrajectories && mFrame == other.mFrame
+         && mMarker == other.mMarker;
+}
+
+//==============================================================================
+bool MarkerTrajectories::Frame::const_iterator::operator!=(
+    const const_iterator& other) const
+{
+  return !(*this == other);
+}
+
+//==============================================================================
+void MarkerTrajectories::Frame::const_iterator::skipHidden()
+{
+  int numMarkers = mTrajectories->getNumMarkers();
+  while (mMarker < numMarkers && !mTrajectories->isVisible(mFrame, mMarker))
+  {
+    mMarker++;
+  }
+}
+
+//==============================================================================
+MarkerTrajectories::Frame::Frame(
+    const MarkerTrajectories* trajectories, int frame)
+  : mTrajectories(trajectories), mFrame(frame)
+{
+}
+
+//==============================================================================
+/// This returns the index of this frame in the trial
+int MarkerTrajectories::Frame::getFrameIndex() const
+{
+  return mFrame;
+}
+
+//==============================================================================
+/// This returns the number of markers that are visible on this frame
+int MarkerTrajectories::Frame::size() const
+{
+  return mTrajectories->getNumVisible(mFrame);
+}
+
+//==============================================================================
+/// This returns true if the named marker is visible on this frame
+bool MarkerTrajectories::Frame::isVisible(const std::string& name) const
+{
+  int marker = mTrajectories->getMarkerIndex(name);
+  return marker != -1 && mTrajectories->isVisible(mFrame, marker);
+}
+
+//==============================================================================
+/// This returns the position of a visible marker. It is an error to call this
+/// on a marker that is not visible.
+Eigen::Vector3s MarkerTrajectories::Frame::at(const std::string& name) const
+{
+  int marker = mTrajectories->getMarkerIndex(name);
+  assert(marker != -1 && mTrajectories->isVisible(mFrame, marker));
+  return mTrajectories->getPosition(mFrame, marker);
+}
+
+//==============================================================================
+MarkerTrajectories::Frame::const_iterator MarkerTrajectories::Frame::begin()
+    const
+{
+  return const_iterator(mTrajectories, mFrame, 0);
+}
+
+//==============================================================================
+MarkerTrajectories::Frame::const_iterator MarkerTrajectories::Frame::end() const
+{
+  return const_iterator(mTrajectories, mFrame, mTrajectories->getNumMarkers());
+}
+
+//==============================================================================
+MarkerTrajectories::MarkerTrajectories() : mNumFrames(0)
+{
+}
+
+//==============================================================================
+/// This creates a trial with the given markers and number of frames, with
+/// every marker initially hidden.
+MarkerTrajectories::MarkerTrajectories(
+    const std::vector<std::string>& markerNames, int numFrames)
+  : mMarkerNames(markerNames), mNumFrames(numFrames)
+{
+  for (int i = 0; i < mMarkerNames.size(); i++)
+  {
+    mMarkerIndices[mMarkerNames[i]] = i;
+  }
+  mPositions = Eigen::Matrix<s_t, 3, Eigen::Dynamic>::Zero(
+      3, mMarkerNames.size() * numFrames);
+  mVisible.resize(mMarkerNames.size() * numFrames, 0);
+}
+
+//==============================================================================
+/// This builds a columnar store out of the legacy per-frame maps. Markers are
+/// indexed in sorted name order.
+MarkerTrajectories MarkerTrajectories::fromFrameMaps(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>& frames)
+{
+  std::set<std::string> names;
+  for (auto& frame : frames)
+  {
+    for (auto& pair : frame)
+    {
+      names.insert(pair.first);
+    }
+  }
+
+  MarkerTrajectories result(
+      std::vector<std::string>(names.begin(), names.end()), frames.size());
+  for (int t = 0; t < frames.size(); t++)
+  {
+    for (auto& pair : frames[t])
+    {
+      result.setPosition(t, result.getMarkerIndex(pair.first), pair.second);
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+/// This rebuilds the legacy per-frame maps, for callers that still need them.
+std::vector<std::map<std::string, Eigen::Vector3s>>
+MarkerTrajectories::toFrameMaps() const
+{
+  std::vector<std::map<std::string, Eigen::Vector3s>> result;
+  result.reserve(mNumFrames);
+  for (int t = 0; t < mNumFrames; t++)
+  {
+    result.emplace_back();
+    std::map<std::string, Eigen::Vector3s>& map = result.back();
+    // Markers within a frame are inserted in index order, so when the names
+    // are sorted (as they are after fromFrameMaps) each insert is a hinted
+    // append at the end of the tree. If a name shows up twice, the later
+    // column wins, like it would with repeated map assignment.
+    for (int i = 0; i < mMarkerNames.size(); i++)
+    {
+      if (isVisible(t, i))
+      {
+        auto it = map.emplace_hint(
+            map.end(), mMarkerNames[i], Eigen::Vector3s::Zero());
+        it->second = getPosition(t, i);
+      }
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns the number of frames in the trial
+int MarkerTrajectories::getNumFrames() const
+{
+  return mNumFrames;
+}
+
+//==============================================================================
+/// This returns the number of distinct markers in the trial
+int MarkerTrajectories::getNumMarkers() const
+{
+  return mMarkerNames.size();
+}
+
+//==============================================================================
+/// This returns the marker names, in index order
+const std::vector<std::string>& MarkerTrajectories::getMarkerNames() const
+{
+  return mMarkerNames;
+}
+
+//==============================================================================
+/// This returns the index of a marker, or -1 if there's no marker with that
+/// name in this trial
+int MarkerTrajectories::getMarkerIndex(const std::string& name) const
+{
+  auto it = mMarkerIndices.find(name);
+  if (it == mMarkerIndices.end())
+  {
+    return -1;
+  }
+  return it->second;
+}
+
+//==============================================================================
+/// This returns true if the marker was observed on the given frame
+bool MarkerTrajectories::isVisible(int frame, int marker) const
+{
+  assert(frame >= 0 && frame < mNumFrames);
+  assert(marker >= 0 && marker < mMarkerNames.size());
+  return mVisible[frame * mMarkerNames.size() + marker];
+}
+
+//==============================================================================
+/// This returns the number of visible markers on the given frame
+int MarkerTrajectories::getNumVisible(int frame) const
+{
+  int count = 0;
+  for (int i = 0; i < mMarkerNames.size(); i++)
+  {
+    if (isVisible(frame, i))
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+//==============================================================================
+/// This returns the position of a marker on the given frame. Hidden markers
+/// read back as zero.
+Eigen::Vector3s MarkerTrajectories::getPosition(int frame, int marker) const
+{
+  assert(frame >= 0 && frame < mNumFrames);
+  assert(marker >= 0 && marker < mMarkerNames.size());
+  return mPositions.col(frame * mMarkerNames.size() + marker);
+}
+
+//==============================================================================
+/// This records an observation of a marker on the given frame
+void MarkerTrajectories::setPosition(
+    int frame, int marker, const Eigen::Vector3s& position)
+{
+  assert(frame >= 0 && frame < mNumFrames);
+  assert(marker >= 0 && marker < mMarkerNames.size());
+  int col = frame * mMarkerNames.size() + marker;
+  mPositions.col(col) = position;
+  mVisible[col] = 1;
+}
+
+//==============================================================================
+/// This marks a marker as unobserved on the given frame
+void MarkerTrajectories::setHidden(int frame, int marker)
+{
+  assert(frame >= 0 && frame < mNumFrames);
+  assert(marker >= 0 && marker < mMarkerNames.size());
+  int col = frame * mMarkerNames.size() + marker;
+  mPositions.col(col).setZero();
+  mVisible[col] = 0;
+}
+
+//==============================================================================
+/// This swaps the observations (and visibility) of two markers on a frame
+void MarkerTrajectories::swapMarkers(int frame, int markerA, int markerB)
+{
+  int colA = frame * mMarkerNames.size() + markerA;
+  int colB = frame * mMarkerNames.size() + markerB;
+  mPositions.col(colA).swap(mPositions.col(colB));
+  unsigned char visibleA = mVisible[colA];
+  mVisible[colA] = mVisible[colB];
+  mVisible[colB] = visibleA;
+}
+
+//==============================================================================
+/// This appends a new frame with every marker hidden, and returns its index.
+/// Storage grows geometrically, so this is cheap to call while streaming in a
+/// file of unknown length.
+int MarkerTrajectories::appendFrame()
+{
+  int numMarkers = mMarkerNames.size();
+  int neededCols = (mNumFrames + 1) * numMarkers;
+  if (neededCols > mPositions.cols())
+  {
+    int newCols = std::max(neededCols, (int)mPositions.cols() * 2);
+    mPositions.conservativeResize(Eigen::NoChange, newCols);
+  }
+  mPositions.middleCols(mNumFrames * numMarkers, numMarkers).setZero();
+  mVisible.resize(neededCols, 0);
+  return mNumFrames++;
+}
+
+//==============================================================================
+/// This applies a rotation to every marker position in the trial
+void MarkerTrajectories::rotate(const Eigen::Matrix3s& R)
+{
+  int cols = mNumFrames * mMarkerNames.size();
+  mPositions.leftCols(cols) = R * mPositions.leftCols(cols);
+}
+
+//==============================================================================
+/// This returns the 3 x (markers * frames) position matrix. Column
+/// `frame * getNumMarkers() + marker` holds that marker on that frame.
+Eigen::Ref<const Eigen::Matrix<s_t, 3, Eigen::Dynamic>>
+MarkerTrajectories::getPositions() const
+{
+  return mPositions.leftCols(mNumFrames * mMarkerNames.size());
+}
+
+//==============================================================================
+/// This returns the 3 x markers block of positions for a single frame
+Eigen::Ref<const Eigen::Matrix<s_t, 3, Eigen::Dynamic>>
+MarkerTrajectories::getFramePositions(int frame) const
+{
+  assert(frame >= 0 && frame < mNumFrames);
+  return mPositions.middleCols(
+      frame * mMarkerNames.size(), mMarkerNames.size());
+}
+
+//==============================================================================
+/// This returns a view of one frame that can be iterated without building a
+/// map
+MarkerTrajectories::Frame MarkerTrajectories::getFrame(int frame) const
+{
+  assert(frame >= 0 && frame < mNumFrames);
+  return Frame(this, frame);
+}
+
+} // namespace biomechanics
+} // namespace dart
@@ -0,0 +1,170 @@
+#ifndef DART_BIOMECH_MARKERTRAJECTORIES_HPP_
+#define DART_BIOMECH_MARKERTRAJECTORIES_HPP_
+
+#include <iterator>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace biomechanics {
+
+/// This holds marker observations for a whole trial in a dense columnar
+/// layout. Every marker gets an index, positions live in a single 3 x (markers
+/// * frames) matrix (frame-major, so each frame is a contiguous 3 x markers
+/// block), and a bitmask records which markers were actually seen on each
+/// frame. Compared to a std::map per frame this does no per-frame allocation,
+/// and lookups by marker index are a single offset computation.
+class MarkerTrajectories
+{
+public:
+  /// A single visible marker on a single frame, as yielded by iterating a
+  /// Frame view.
+  struct Observation
+  {
+    int markerIndex;
+    const std::string& name;
+    Eigen::Vector3s position;
+  };
+
+  /// This is a lightweight, non-owning view of one frame, which can be
+  /// iterated like the old per-frame std::map (visible markers only, in marker
+  /// index order) without building one.
+  class Frame
+  {
+  public:
+    class const_iterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Observation;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = Observation;
+
+      const_iterator(const MarkerTrajectories* trajectories, int frame, int i);
+      Observation operator*() const;
+      const_iterator& operator++();
+      bool operator==(const const_iterator& other) const;
+      bool operator!=(const const_iterator& other) const;
+
+    protected:
+      void skipHidden();
+
+      const MarkerTrajectories* mTrajectories;
+      int mFrame;
+      int mMarker;
+    };
+
+    Frame(const MarkerTrajectories* trajectories, int frame);
+
+    /// This returns the index of this frame in the trial
+    int getFrameIndex() const;
+
+    /// This returns the number of markers that are visible on this frame
+    int size() const;
+
+    /// This returns true if the named marker is visible on this frame
+    bool isVisible(const std::string& name) const;
+
+    /// This returns the position of a visible marker. It is an error to call
+    /// this on a marker that is not visible.
+    Eigen::Vector3s at(const std::string& name) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+  protected:
+    const MarkerTrajectories* mTrajectories;
+    int mFrame;
+  };
+
+  MarkerTrajectories();
+
+  /// This creates a trial with the given markers and number of frames, with
+  /// every marker initially hidden.
+  MarkerTrajectories(const std::vector<std::string>& markerNames, int numFrames);
+
+  /// This builds a columnar store out of the legacy per-frame maps. Markers
+  /// are indexed in sorted name order.
+  static MarkerTrajectories fromFrameMaps(
+      const std::vector<std::map<std::string, Eigen::Vector3s>>& frames);
+
+  /// This rebuilds the legacy per-frame maps, for callers that still need
+  /// them.
+  std::vector<std::map<std::string, Eigen::Vector3s>> toFrameMaps() const;
+
+  /// This returns the number of frames in the trial
+  int getNumFrames() const;
+
+  /// This returns the number of distinct markers in the trial
+  int getNumMarkers() const;
+
+  /// This returns the marker names, in index order
+  const std::vector<std::string>& getMarkerNames() const;
+
+  /// This returns the index of a marker, or -1 if there's no marker with that
+  /// name in this trial
+  int getMarkerIndex(const std::string& name) const;
+
+  /// This returns true if the marker was observed on the given frame
+  bool isVisible(int frame, int marker) const;
+
+  /// This returns the number of visible markers on the given frame
+  int getNumVisible(int frame) const;
+
+  /// This returns the position of a marker on the given frame. Hidden markers
+  /// read back as zero.
+  Eigen::Vector3s getPosition(int frame, int marker) const;
+
+  /// This records an observation of a marker on the given frame
+  void setPosition(int frame, int marker, const Eigen::Vector3s& position);
+
+  /// This marks a marker as unobserved on the given frame
+  void setHidden(int frame, int marker);
+
+  /// This swaps the observations (and visibility) of two markers on a frame
+  void swapMarkers(int frame, int markerA, int markerB);
+
+  /// This appends a new frame with every marker hidden, and returns its index.
+  /// Storage grows geometrically, so this is cheap to call while streaming in
+  /// a file of unknown length.
+  int appendFrame();
+
+  /// This applies a rotation to every marker position in the trial
+  void rotate(const Eigen::Matrix3s& R);
+
+  /// This returns the 3 x (markers * frames) position matrix. Column
+  /// `frame * getNumMarkers() + marker` holds that marker on that frame.
+  Eigen::Ref<const Eigen::Matrix<s_t, 3, Eigen::Dynamic>> getPositions() const;
+
+  /// This returns the 3 x markers block of positions for a single frame
+  Eigen::Ref<const Eigen::Matrix<s_t, 3, Eigen::Dynamic>> getFramePositions(
+      int frame) const;
+
+  /// This returns a view of one frame that can be iterated without building a
+  /// map
+  Frame getFrame(int frame) const;
+
+protected:
+  std::vector<std::string> mMarkerNames;
+  std::unordered_map<std::string, int> mMarkerIndices;
+  int mNumFrames;
+  // This may have more columns than we're using, to allow cheap appends
+  Eigen::Matrix<s_t, 3, Eigen::Dynamic> mPositions;
+  // Indexed the same way as the columns of mPositions. This is deliberately
+  // not std::vector<bool>, so that different frames can be written from
+  // different threads without sharing a word.
+  std::vector<unsigned char> mVisible;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -0,0 +1,351 @@
+#include "dart/biomechanics/OpenSimBatchExporter.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iostream>
+
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/common/CachedResourceRetriever.hpp"
+#include "dart/common/Console.hpp"
+#include "dart/common/LocalResourceRetriever.hpp"
+#include "dart/common/ThreadPool.hpp"
+#include "dart/utils/CompositeResourceRetriever.hpp"
+#include "dart/utils/DartResourceRetriever.hpp"
+#include "dart/utils/XmlHelpers.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+namespace {
+
+//==============================================================================
+common::ResourceRetrieverPtr ensureRetriever(
+    const common::ResourceRetrieverPtr& _retriever)
+{
+  if (_retriever)
+  {
+    return _retriever;
+  }
+  else
+  {
+    auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
+    newRetriever->addSchemaRetriever(
+        "file",
+        std::make_shared<common::CachedResourceRetriever>(
+            std::make_shared<common::LocalResourceRetriever>()));
+    newRetriever->addSchemaRetriever(
+        "dart", utils::DartResourceRetriever::create());
+    return newRetriever;
+  }
+}
+
+//==============================================================================
+tinyxml2::XMLElement* findModelElement(tinyxml2::XMLDocument& doc)
+{
+  tinyxml2::XMLElement* docElement = doc.FirstChildElement("OpenSimDocument");
+  if (docElement == nullptr)
+    return nullptr;
+  return docElement->FirstChildElement("Model");
+}
+
+} // namespace
+
+//==============================================================================
+/// This parses the *.osim file at `uri`. If that fails, isValid() returns
+/// false, and every save*() does nothing.
+OpenSimBatchExporter::OpenSimBatchExporter(
+    const common::Uri& uri, const common::ResourceRetrieverPtr& nullOrRetriever)
+  : mValid(false), mUri(uri.toString())
+{
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+  try
+  {
+    utils::openXMLFile(mModel, uri, retriever);
+  }
+  catch (std::exception const& e)
+  {
+    std::cout << "LoadFile [" << mUri << "] Fails: " << e.what() << std::endl;
+    return;
+  }
+
+  tinyxml2::XMLElement* modelElement = findModelElement(mModel);
+  if (modelElement == nullptr)
+  {
+    dterr << "OpenSim file[" << mUri
+          << "] does not contain <OpenSimDocument><Model> as the root "
+             "elements.\n";
+    return;
+  }
+  tinyxml2::XMLElement* markerSet
+      = modelElement->FirstChildElement("MarkerSet");
+  if (markerSet == nullptr
+      || markerSet->FirstChildElement("objects") == nullptr)
+  {
+    dterr << "OpenSim file[" << mUri
+          << "] does not contain <MarkerSet><objects> as the child of the "
+             "root <Model> element.\n";
+    return;
+  }
+  mModelMarkers = indexMarkers(mModel);
+
+  // Strip the copy down to the markers, the same way filterJustMarkers()
+  // does
+  mModel.DeepCopy(&mJustMarkers);
+  modelElement = findModelElement(mJustMarkers);
+  markerSet = modelElement->FirstChildElement("MarkerSet");
+  tinyxml2::XMLNode* cursor = modelElement->FirstChild();
+  while (cursor != nullptr)
+  {
+    tinyxml2::XMLNode* next = cursor->NextSibling();
+    if (cursor != markerSet)
+    {
+      modelElement->DeleteChild(cursor);
+    }
+    cursor = next;
+  }
+  mJustMarkersMarkers = indexMarkers(mJustMarkers);
+
+  mValid = true;
+}
+
+//==============================================================================
+/// This returns true if the *.osim parsed, and has a <MarkerSet>
+bool OpenSimBatchExporter::isValid() const
+{
+  return mValid;
+}
+
+//==============================================================================
+/// This writes the same file as OpenSimParser::moveOsimMarkers() would for
+/// the model passed to the constructor
+void OpenSimBatchExporter::saveMovedMarkers(
+    const std::map<std::string, Eigen::Vector3s>& bodyScales,
+    const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+        markerOffsets,
+    const std::string& outputPath)
+{
+  if (!mValid)
+    return;
+  std::lock_guard<std::mutex> lock(mMutex);
+  applyMarkerOffsets(mModelMarkers, bodyScales, markerOffsets);
+  saveXMLBuffered(mModel, outputPath);
+  restoreMarkers(mModelMarkers);
+}
+
+//==============================================================================
+/// This writes the same file as running OpenSimParser::filterJustMarkers() on
+/// the output of saveMovedMarkers() with the same arguments
+void OpenSimBatchExporter::saveJustMarkers(
+    const std::map<std::string, Eigen::Vector3s>& bodyScales,
+    const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+        markerOffsets,
+    const std::string& outputPath)
+{
+  if (!mValid)
+    return;
+  std::lock_guard<std::mutex> lock(mMutex);
+  applyMarkerOffsets(mJustMarkersMarkers, bodyScales, markerOffsets);
+  saveXMLBuffered(mJustMarkers, outputPath);
+  restoreMarkers(mJustMarkersMarkers);
+}
+
+//==============================================================================
+/// This writes the OpenSim files for every trial into `outputFolder`, with
+/// the trials spread across the global ThreadPool.
+void OpenSimBatchExporter::saveTrials(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    const std::vector<std::string>& markerNames,
+    const std::string& modelFileName,
+    const std::vector<OpenSimExportTrial>& trials,
+    const std::string& outputFolder)
+{
+  if (trials.empty())
+    return;
+
+  std::string folder = outputFolder;
+  if (!folder.empty() && folder.back() != '/')
+    folder += "/";
+
+  // Build the setup files once, with placeholder names that each trial
+  // swaps out
+  tinyxml2::XMLDocument ikTemplate;
+  OpenSimParser::makeOsimInverseKinematicsXML(
+      ikTemplate, "", markerNames, modelFileName, "", "");
+  tinyxml2::XMLDocument idTemplate;
+  OpenSimParser::makeOsimInverseDynamicsXML(
+      idTemplate, "", modelFileName, "", "", "", "");
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  const int numTasks
+      = std::max(1, std::min((int)trials.size(), (int)pool.getNumThreads()));
+  std::vector<std::future<void>> futures;
+  for (int task = 0; task < numTasks; task++)
+  {
+    futures.push_back(pool.submit([&, task]() {
+      // Working out which foot is on which force plate poses the skeleton,
+      // so each task needs its own
+      std::shared_ptr<dynamics::Skeleton> taskSkel = skel->cloneSkeleton();
+
+      tinyxml2::XMLDocument ik;
+      ikTemplate.DeepCopy(&ik);
+      tinyxml2::XMLElement* ikTool
+          = ik.FirstChildElement("OpenSimDocument")
+                ->FirstChildElement("InverseKinematicsTool");
+      tinyxml2::XMLElement* ikMarkerFile
+          = ikTool->FirstChildElement("marker_file");
+      tinyxml2::XMLElement* ikOutputMotionFile
+          = ikTool->FirstChildElement("output_motion_file");
+
+      tinyxml2::XMLDocument id;
+      idTemplate.DeepCopy(&id);
+      tinyxml2::XMLElement* idTool
+          = id.FirstChildElement("OpenSimDocument")
+                ->FirstChildElement("InverseDynamicsTool");
+      tinyxml2::XMLElement* idExternalLoadsFile
+          = idTool->FirstChildElement("external_loads_file");
+      tinyxml2::XMLElement* idCoordinatesFile
+          = idTool->FirstChildElement("coordinates_file");
+      tinyxml2::XMLElement* idOutputGenForceFile
+          = idTool->FirstChildElement("output_gen_force_file");
+      tinyxml2::XMLElement* idOutputBodyForcesFile
+          = idTool->FirstChildElement("output_body_forces_file");
+
+      for (int i = task; i < trials.size(); i += numTasks)
+      {
+        const OpenSimExportTrial& trial = trials[i];
+        const std::string& name = trial.name;
+        const std::string base = folder + name;
+
+        if (!trial.markerTimesteps.empty())
+        {
+          OpenSimParser::saveTRC(
+              base + ".trc", trial.timestamps, trial.markerTimesteps);
+        }
+        OpenSimParser::saveMot(
+            taskSkel, base + "_ik.mot", trial.timestamps, trial.poses);
+
+        ikTool->SetAttribute("name", name.c_str());
+        ikMarkerFile->SetText((name + ".trc").c_str());
+        ikOutputMotionFile->SetText((name + "_ik_by_opensim.mot").c_str());
+        saveXMLBuffered(ik, base + "_ik_setup.xml");
+
+        if (trial.forcePlates.empty())
+          continue;
+
+        OpenSimParser::saveGRFMot(
+            base + "_grf.mot", trial.timestamps, trial.forcePlates);
+        OpenSimParser::saveOsimInverseDynamicsForcesXMLFile(
+            name,
+            taskSkel,
+            trial.poses,
+            trial.forcePlates,
+            name + "_grf.mot",
+            base + "_external_forces.xml");
+
+        idTool->SetAttribute("name", name.c_str());
+        idExternalLoadsFile->SetText((name + "_external_forces.xml").c_str());
+        idCoordinatesFile->SetText((name + "_ik.mot").c_str());
+        idOutputGenForceFile->SetText((name + "_id.sto").c_str());
+        idOutputBodyForcesFile->SetText((name + "_id_body_forces.sto").c_str());
+        saveXMLBuffered(id, base + "_id_setup.xml");
+      }
+    }));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+}
+
+//==============================================================================
+/// This writes `doc` to `path` with a single write, rather than the many
+/// small ones tinyxml2::XMLDocument::SaveFile() makes
+void OpenSimBatchExporter::saveXMLBuffered(
+    const tinyxml2::XMLDocument& doc, const std::string& path)
+{
+  tinyxml2::XMLPrinter printer;
+  doc.Print(&printer);
+  std::ofstream file(path, std::ios::out | std::ios::binary);
+  if (!file)
+  {
+    dterr << "Couldn't open [" << path << "] for writing.\n";
+    return;
+  }
+  // CStrSize() counts the null terminator
+  file.write(printer.CStr(), printer.CStrSize() - 1);
+}
+
+//==============================================================================
+/// This finds the <location> of every <Marker> in the <MarkerSet> of `doc`
+std::vector<OpenSimBatchExporter::MarkerLocation>
+OpenSimBatchExporter::indexMarkers(tinyxml2::XMLDocument& doc)
+{
+  std::vector<MarkerLocation> markers;
+  tinyxml2::XMLElement* marker = findModelElement(doc)
+                                     ->FirstChildElement("MarkerSet")
+                                     ->FirstChildElement("objects")
+                                     ->FirstChildElement("Marker");
+  while (marker != nullptr)
+  {
+    MarkerLocation entry;
+    const char* name = marker->Attribute("name");
+    entry.name = name == nullptr ? "" : name;
+    entry.location = marker->FirstChildElement("location");
+    if (entry.location != nullptr)
+    {
+      const char* text = entry.location->GetText();
+      entry.hadText = text != nullptr;
+      entry.originalText = entry.hadText ? text : "";
+      markers.push_back(entry);
+    }
+    marker = marker->NextSiblingElement("Marker");
+  }
+  return markers;
+}
+
+//==============================================================================
+/// This overwrites the marker locations the same way moveOsimMarkers() does
+void OpenSimBatchExporter::applyMarkerOffsets(
+    std::vector<MarkerLocation>& markers,
+    const std::map<std::string, Eigen::Vector3s>& bodyScales,
+    const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+        markerOffsets)
+{
+  for (MarkerLocation& marker : markers)
+  {
+    auto offset = markerOffsets.find(marker.name);
+    if (offset == markerOffsets.end())
+    {
+      std::cout << "WARNING: moveOsimMarkers() found a marker in the .osim "
+                   "file that isn't specified in our scalings: \""
+                << marker.name << "\"" << std::endl;
+      continue;
+    }
+    auto scale = bodyScales.find(offset->second.first);
+    Eigen::Vector3s markerOffset = offset->second.second.cwiseProduct(
+        scale != bodyScales.end() ? scale->second : Eigen::Vector3s::Ones());
+    marker.location->SetText((" " + std::to_string(markerOffset(0)) + " "
+                              + std::to_string(markerOffset(1)) + " "
+                              + std::to_string(markerOffset(2)))
+                                 .c_str());
+  }
+}
+
+//==============================================================================
+/// This puts the marker locations back to how they were in the *.osim
+void OpenSimBatchExporter::restoreMarkers(std::vector<MarkerLocation>& markers)
+{
+  for (MarkerLocation& marker : markers)
+  {
+    if (marker.hadText)
+      marker.location->SetText(marker.originalText.c_str());
+    else
+      marker.location->DeleteChildren();
+  }
+}
+
+} // namespace biomechanics
+} // namespace dart
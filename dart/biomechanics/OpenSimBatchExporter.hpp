@@ -0,0 +1,138 @@
+#ifndef DART_BIOMECHANICS_OPENSIM_BATCH_EXPORTER_HPP_
+#define DART_BIOMECHANICS_OPENSIM_BATCH_EXPORTER_HPP_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <tinyxml2.h>
+
+#include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/common/ResourceRetriever.hpp"
+#include "dart/common/Uri.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/// These are the results for one trial, to be written out by
+/// OpenSimBatchExporter::saveTrials()
+struct OpenSimExportTrial
+{
+  /// This is used as the prefix of every file written for the trial
+  std::string name;
+  std::vector<double> timestamps;
+  Eigen::MatrixXs poses;
+  /// If this is empty, we skip the ground reaction force and ID files
+  std::vector<ForcePlate> forcePlates;
+  /// If this is empty, we skip the *.trc file
+  std::vector<std::map<std::string, Eigen::Vector3s>> markerTimesteps;
+};
+
+/// This writes the OpenSim files for a whole subject. The OpenSimParser
+/// save*() methods each re-read the source *.osim, or rebuild their XML
+/// document from scratch, for every file they write. This instead parses the
+/// *.osim once and keeps it in memory as a template, editing just the marker
+/// locations for each output and putting them back afterwards. The IK and ID
+/// setup files are built once per batch, and each worker thread only swaps
+/// the file names in its own copy. XML is printed to memory and written out
+/// in one go.
+///
+/// The model and setup files written are the same, byte for byte, as the ones
+/// moveOsimMarkers() and the save*XMLFile() methods write.
+class OpenSimBatchExporter
+{
+public:
+  /// This parses the *.osim file at `uri`. If that fails, isValid() returns
+  /// false, and every save*() does nothing.
+  OpenSimBatchExporter(
+      const common::Uri& uri,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This returns true if the *.osim parsed, and has a <MarkerSet>
+  bool isValid() const;
+
+  /// This writes the same file as OpenSimParser::moveOsimMarkers() would
+  /// for the model passed to the constructor
+  void saveMovedMarkers(
+      const std::map<std::string, Eigen::Vector3s>& bodyScales,
+      const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+          markerOffsets,
+      const std::string& outputPath);
+
+  /// This writes the same file as running OpenSimParser::filterJustMarkers()
+  /// on the output of saveMovedMarkers() with the same arguments
+  void saveJustMarkers(
+      const std::map<std::string, Eigen::Vector3s>& bodyScales,
+      const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+          markerOffsets,
+      const std::string& outputPath);
+
+  /// This writes the OpenSim files for every trial into `outputFolder`, with
+  /// the trials spread across the global ThreadPool. For a trial named
+  /// "walk1" that's:
+  ///
+  ///   walk1.trc                  (if there are marker timesteps)
+  ///   walk1_ik.mot               the poses
+  ///   walk1_ik_setup.xml         an OpenSim IK setup for the trial
+  ///   walk1_grf.mot              (if there are force plates)
+  ///   walk1_external_forces.xml  (if there are force plates)
+  ///   walk1_id_setup.xml         (if there are force plates)
+  ///
+  /// The setup files refer to each other, and to `modelFileName`, by file
+  /// name only, so they're meant to be run from inside `outputFolder`.
+  void saveTrials(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      const std::vector<std::string>& markerNames,
+      const std::string& modelFileName,
+      const std::vector<OpenSimExportTrial>& trials,
+      const std::string& outputFolder);
+
+  /// This writes `doc` to `path` with a single write, rather than the many
+  /// small ones tinyxml2::XMLDocument::SaveFile() makes
+  static void saveXMLBuffered(
+      const tinyxml2::XMLDocument& doc, const std::string& path);
+
+protected:
+  struct MarkerLocation
+  {
+    std::string name;
+    tinyxml2::XMLElement* location;
+    std::string originalText;
+    bool hadText;
+  };
+
+  /// This finds the <location> of every <Marker> in the <MarkerSet> of `doc`
+  static std::vector<MarkerLocation> indexMarkers(tinyxml2::XMLDocument& doc);
+
+  /// This overwrites the marker locations the same way moveOsimMarkers()
+  /// does
+  static void applyMarkerOffsets(
+      std::vector<MarkerLocation>& markers,
+      const std::map<std::string, Eigen::Vector3s>& bodyScales,
+      const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+          markerOffsets);
+
+  /// This puts the marker locations back to how they were in the *.osim
+  static void restoreMarkers(std::vector<MarkerLocation>& markers);
+
+  bool mValid;
+  std::string mUri;
+  // The parsed *.osim, and a copy with everything but the markers stripped
+  // out. These get edited in place, so they're guarded by mMutex.
+  tinyxml2::XMLDocument mModel;
+  tinyxml2::XMLDocument mJustMarkers;
+  std::vector<MarkerLocation> mModelMarkers;
+  std::vector<MarkerLocation> mJustMarkersMarkers;
+  std::mutex mMutex;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
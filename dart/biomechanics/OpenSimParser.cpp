@@ -1,17 +1,22 @@
 #include "dart/biomechanics/OpenSimParser.hpp"
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "dart/biomechanics/FastTextParsing.hpp"
 #include "dart/biomechanics/ForcePlate.hpp"
 #include "dart/biomechanics/IKErrorReport.hpp"
+#include "dart/common/CachedResourceRetriever.hpp"
 #include "dart/common/Uri.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/CustomJoint.hpp"
@@ -97,7 +102,9 @@ common::ResourceRetrieverPtr ensureRetriever(
   {
     auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
     newRetriever->addSchemaRetriever(
-        "file", std::make_shared<common::LocalResourceRetriever>());
+        "file",
+        std::make_shared<common::CachedResourceRetriever>(
+            std::make_shared<common::LocalResourceRetriever>()));
     newRetriever->addSchemaRetriever("dart", DartResourceRetriever::create());
     return newRetriever;
   }
@@ -208,13 +215,105 @@ Eigen::Vector3s getAxisFlips(std::vector<Eigen::Vector3s> axisList)
   return vec;
 }
 
+namespace {
+
+/// This is the parseOsim() cache. Each entry holds a private copy of a parsed
+/// file, which callers only ever get clones of.
+std::mutex gParseCacheMutex;
+bool gParseCacheEnabled = true;
+std::unordered_map<std::string, OpenSimFile> gParseCache;
+
+/// This is a 64 bit FNV-1a hash of the file contents, plus the length
+std::string hashOsimContents(const std::string& contents)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (char c : contents)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return std::to_string(hash) + "-" + std::to_string(contents.size());
+}
+
+/// This copies an OpenSimFile, with a fresh clone of the Skeleton and the
+/// markers rebound to the cloned BodyNodes
+OpenSimFile cloneOsimFile(const OpenSimFile& file)
+{
+  OpenSimFile clone;
+  clone.skeleton = file.skeleton->cloneSkeleton();
+  for (auto& pair : file.markersMap)
+  {
+    dynamics::BodyNode* body
+        = pair.second.first == nullptr
+              ? nullptr
+              : clone.skeleton->getBodyNode(pair.second.first->getName());
+    clone.markersMap[pair.first] = std::make_pair(body, pair.second.second);
+  }
+  clone.anatomicalMarkers = file.anatomicalMarkers;
+  clone.trackingMarkers = file.trackingMarkers;
+  return clone;
+}
+
+} // namespace
+
 //==============================================================================
+/// Read Skeleton from *.osim file. Parsed models are cached in memory, keyed
+/// by URI and a hash of the file contents, so loading the same file again
+/// just clones the Skeleton we built last time. Every call returns its own
+/// Skeleton, so it's safe to scale or otherwise modify the result.
 OpenSimFile OpenSimParser::parseOsim(
     const common::Uri& uri, const common::ResourceRetrieverPtr& nullOrRetriever)
 {
   const common::ResourceRetrieverPtr retriever
       = ensureRetriever(nullOrRetriever);
 
+  {
+    std::lock_guard<std::mutex> lock(gParseCacheMutex);
+    if (!gParseCacheEnabled)
+      return parseOsimUncached(uri, retriever);
+  }
+
+  // Meshes are found relative to the URI, so the same contents at a different
+  // URI can still build a different Skeleton
+  std::string key;
+  try
+  {
+    key = uri.toString() + "\n" + hashOsimContents(retriever->readAll(uri));
+  }
+  catch (std::exception const&)
+  {
+    // Let the parser report the failure
+    return parseOsimUncached(uri, retriever);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(gParseCacheMutex);
+    auto cached = gParseCache.find(key);
+    if (cached != gParseCache.end())
+      return cloneOsimFile(cached->second);
+  }
+
+  // We parse without holding the lock, since that's the slow part
+  OpenSimFile file = parseOsimUncached(uri, retriever);
+  if (file.skeleton == nullptr)
+    return file;
+
+  // The caller is free to modify what we return, so we keep our own copy
+  std::lock_guard<std::mutex> lock(gParseCacheMutex);
+  if (gParseCacheEnabled)
+    gParseCache.emplace(key, cloneOsimFile(file));
+  return file;
+}
+
+//==============================================================================
+/// This always parses the *.osim file from scratch, bypassing the cache used
+/// by parseOsim()
+OpenSimFile OpenSimParser::parseOsimUncached(
+    const common::Uri& uri, const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+
   OpenSimFile null_file;
   null_file.skeleton = nullptr;
 
@@ -264,6 +363,24 @@ OpenSimFile OpenSimParser::parseOsim(
   }
 }
 
+//==============================================================================
+/// This turns the parseOsim() cache on or off. It's on by default.
+void OpenSimParser::setParseCacheEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(gParseCacheMutex);
+  gParseCacheEnabled = enabled;
+  if (!enabled)
+    gParseCache.clear();
+}
+
+//==============================================================================
+/// This drops every model held in the parseOsim() cache
+void OpenSimParser::clearParseCache()
+{
+  std::lock_guard<std::mutex> lock(gParseCacheMutex);
+  gParseCache.clear();
+}
+
 //==============================================================================
 /// This creates an XML configuration file, which you can pass to the OpenSim
 /// scaling tool to rescale a skeleton
@@ -520,7 +637,31 @@ void OpenSimParser::saveOsimInverseKinematicsXMLFile(
   */
   // clang-format on
 
-  XMLDocument xmlDoc;
+  tinyxml2::XMLDocument xmlDoc;
+  makeOsimInverseKinematicsXML(
+      xmlDoc,
+      subjectName,
+      markerNames,
+      osimInputModelPath,
+      osimInputTrcPath,
+      osimOutputMotPath);
+  xmlDoc.SaveFile(ikInstructionsOutputPath.c_str());
+}
+
+//==============================================================================
+/// This builds the XML configuration that saveOsimInverseKinematicsXMLFile()
+/// writes into `xmlDoc`, replacing anything that was in it
+void OpenSimParser::makeOsimInverseKinematicsXML(
+    tinyxml2::XMLDocument& xmlDoc,
+    const std::string& subjectName,
+    const std::vector<std::string>& markerNames,
+    const std::string& osimInputModelPath,
+    const std::string& osimInputTrcPath,
+    const std::string& osimOutputMotPath)
+{
+  using namespace tinyxml2;
+
+  xmlDoc.Clear();
   XMLElement* openSimRoot = xmlDoc.NewElement("OpenSimDocument");
   openSimRoot->SetAttribute("Version", "40000");
   xmlDoc.InsertFirstChild(openSimRoot);
@@ -538,7 +679,7 @@ void OpenSimParser::saveOsimInverseKinematicsXMLFile(
   toolRoot->InsertEndChild(taskSet);
   XMLElement* taskList = xmlDoc.NewElement("objects");
   taskSet->InsertEndChild(taskList);
-  for (std::string& markerName : markerNames)
+  for (const std::string& markerName : markerNames)
   {
     XMLElement* markerNode = xmlDoc.NewElement("IKMarkerTask");
     markerNode->SetAttribute("name", markerName.c_str());
@@ -566,8 +707,6 @@ void OpenSimParser::saveOsimInverseKinematicsXMLFile(
   XMLElement* reportErrors = xmlDoc.NewElement("report_errors");
   reportErrors->SetText("true");
   toolRoot->InsertEndChild(reportErrors);
-
-  xmlDoc.SaveFile(ikInstructionsOutputPath.c_str());
 }
 
 //==============================================================================
@@ -781,7 +920,33 @@ void OpenSimParser::saveOsimInverseDynamicsXMLFile(
   */
   // clang-format on
 
-  XMLDocument xmlDoc;
+  tinyxml2::XMLDocument xmlDoc;
+  makeOsimInverseDynamicsXML(
+      xmlDoc,
+      subjectName,
+      osimInputModelPath,
+      osimInputMotPath,
+      osimForcesXmlPath,
+      osimOutputStoPath,
+      osimOutputBodyForcesStoPath);
+  xmlDoc.SaveFile(idInstructionsOutputPath.c_str());
+}
+
+//==============================================================================
+/// This builds the XML configuration that saveOsimInverseDynamicsXMLFile()
+/// writes into `xmlDoc`, replacing anything that was in it
+void OpenSimParser::makeOsimInverseDynamicsXML(
+    tinyxml2::XMLDocument& xmlDoc,
+    const std::string& subjectName,
+    const std::string& osimInputModelPath,
+    const std::string& osimInputMotPath,
+    const std::string& osimForcesXmlPath,
+    const std::string& osimOutputStoPath,
+    const std::string& osimOutputBodyForcesStoPath)
+{
+  using namespace tinyxml2;
+
+  xmlDoc.Clear();
   XMLElement* openSimRoot = xmlDoc.NewElement("OpenSimDocument");
   openSimRoot->SetAttribute("Version", "40000");
   xmlDoc.InsertFirstChild(openSimRoot);
@@ -818,8 +983,6 @@ void OpenSimParser::saveOsimInverseDynamicsXMLFile(
       = xmlDoc.NewElement("output_body_forces_file");
   outputBodyForcesFile->SetText(osimOutputBodyForcesStoPath.c_str());
   toolRoot->InsertEndChild(outputBodyForcesFile);
-
-  xmlDoc.SaveFile(idInstructionsOutputPath.c_str());
 }
 
 /// This gets called by rationalizeCustomJoints()
@@ -1376,6 +1539,35 @@ void OpenSimParser::filterJustMarkers(
   newFile.SaveFile(outputPath.c_str());
 }
 
+//==============================================================================
+/// Once `markerTrajectories` and `timestamps` are filled in, this derives the
+/// rest of the fields of an OpenSimTRC from them
+void finishLoadingTRC(OpenSimTRC& result)
+{
+  // Translate into a "lines" format, where each marker gets a full trajectory
+  for (int i = 0; i < result.markerTrajectories.getNumFrames(); i++)
+  {
+    // TODO: this will result in a bug if some timesteps are missing marker
+    // observations
+    for (const auto& observation : result.markerTrajectories.getFrame(i))
+    {
+      result.markerLines[observation.name].push_back(observation.position);
+    }
+  }
+
+  // Keep the legacy per-frame maps around for callers that haven't moved over
+  // to the columnar store yet
+  result.markerTimesteps = result.markerTrajectories.toFrameMaps();
+
+  if (result.timestamps.size() > 1)
+  {
+    int frames = result.timestamps.size();
+    s_t elapsed = result.timestamps[result.timestamps.size() - 1]
+                  - result.timestamps[0];
+    result.framesPerSecond = std::round(frames / elapsed);
+  }
+}
+
 //==============================================================================
 /// This grabs the marker trajectories from a TRC file
 OpenSimTRC OpenSimParser::loadTRC(
@@ -1396,19 +1588,27 @@ OpenSimTRC OpenSimParser::loadTRC(
   auto end = content.find("\n");
   while (end != std::string::npos)
   {
-    std::string line = content.substr(start, end - start);
+    // We walk the line in place, rather than copying it and its tokens out
+    const char* cursor = content.data() + start;
+    const char* lineEnd = content.data() + end;
 
-    std::map<std::string, Eigen::Vector3s> markerPositions;
+    if (lineNumber == 4)
+    {
+      // By now we've read the header, so we know which markers to expect
+      result.markerTrajectories = MarkerTrajectories(markerNames, 0);
+    }
+    int frame = -1;
+    if (lineNumber > 5)
+    {
+      frame = result.markerTrajectories.appendFrame();
+    }
     double timestamp = 0.0;
 
     int tokenNumber = 0;
-    std::string whitespace = " \t";
-    auto tokenStart = line.find_first_not_of(whitespace);
-    while (tokenStart != std::string::npos)
+    const char* tokenStart;
+    const char* tokenEnd;
+    while (nextToken(cursor, lineEnd, tokenStart, tokenEnd))
     {
-      auto tokenEnd = line.find_first_of(whitespace, tokenStart + 1);
-      std::string token = line.substr(tokenStart, tokenEnd - tokenStart);
-
       /////////////////////////////////////////////////////////
       // Process the token, given tokenNumber and lineNumber
 
@@ -1416,10 +1616,11 @@ OpenSimTRC OpenSimParser::loadTRC(
       {
         if (tokenNumber == 0)
         { // DataRate
-          // timestep = 1.0 / atof(token.c_str());
+          // timestep = 1.0 / parseDouble(tokenStart, tokenEnd);
         }
         if (tokenNumber == 4)
         { // Units
+          std::string token(tokenStart, tokenEnd);
           if (token == "m")
             unitsMultiplier = 1.0;
           else if (token == "mm")
@@ -1433,13 +1634,13 @@ OpenSimTRC OpenSimParser::loadTRC(
       }
       else if (lineNumber == 3 && tokenNumber > 1)
       {
-        markerNames.push_back(token);
+        markerNames.emplace_back(tokenStart, tokenEnd);
       }
       else if (lineNumber > 5)
       {
         if (tokenNumber == 1)
         {
-          timestamp = atof(token.c_str());
+          timestamp = parseDouble(tokenStart, tokenEnd);
         }
         else if (tokenNumber > 1)
         {
@@ -1447,13 +1648,14 @@ OpenSimTRC OpenSimParser::loadTRC(
               = tokenNumber - 2; // first two cols are "frame #" and "time"
           int markerNumber = (int)floor((double)offset / 3);
           int axisNumber = offset - (markerNumber * 3);
-          markerSwapSpace(axisNumber) = atof(token.c_str()) * unitsMultiplier;
+          markerSwapSpace(axisNumber)
+              = parseDouble(tokenStart, tokenEnd) * unitsMultiplier;
           if (axisNumber == 2)
           {
             if (!markerSwapSpace.hasNaN())
             {
-              markerPositions[markerNames[markerNumber]]
-                  = Eigen::Vector3s(markerSwapSpace);
+              result.markerTrajectories.setPosition(
+                  frame, markerNumber, markerSwapSpace);
             }
           }
         }
@@ -1462,16 +1664,10 @@ OpenSimTRC OpenSimParser::loadTRC(
       /////////////////////////////////////////////////////////
 
       tokenNumber++;
-      if (tokenEnd == std::string::npos)
-      {
-        break;
-      }
-      tokenStart = line.find_first_not_of(whitespace, tokenEnd + 1);
     }
 
     if (lineNumber > 5)
     {
-      result.markerTimesteps.push_back(markerPositions);
       result.timestamps.push_back(timestamp);
     }
 
@@ -1480,24 +1676,7 @@ OpenSimTRC OpenSimParser::loadTRC(
     lineNumber++;
   }
 
-  // Translate into a "lines" format, where each marker gets a full trajectory
-  for (int i = 0; i < result.markerTimesteps.size(); i++)
-  {
-    // TODO: this will result in a bug if some timesteps are missing marker
-    // observations
-    for (auto pair : result.markerTimesteps[i])
-    {
-      result.markerLines[pair.first].push_back(pair.second);
-    }
-  }
-
-  if (result.timestamps.size() > 1)
-  {
-    int frames = result.timestamps.size();
-    s_t elapsed = result.timestamps[result.timestamps.size() - 1]
-                  - result.timestamps[0];
-    result.framesPerSecond = std::round(frames / elapsed);
-  }
+  finishLoadingTRC(result);
 
   return result;
 }
@@ -1570,6 +1749,32 @@ void OpenSimParser::saveTRC(
   trcFile.close();
 }
 
+//==============================================================================
+/// This moves `poses` over to single precision storage, which halves its
+/// memory, and frees the s_t copy. Use getPoses() to read them either way.
+void OpenSimMot::compactPoses()
+{
+  if (poses.size() == 0)
+  {
+    // Already compacted (or never filled in)
+    return;
+  }
+  compactedPoses = math::CompactMatrix(poses);
+  poses.resize(0, 0);
+}
+
+//==============================================================================
+/// This returns `poses`, expanding them from single precision storage if
+/// compactPoses() has been called
+Eigen::MatrixXs OpenSimMot::getPoses() const
+{
+  if (poses.size() == 0)
+  {
+    return compactedPoses.toMatrix();
+  }
+  return poses;
+}
+
 //==============================================================================
 /// This grabs the joint angles from a *.mot file
 OpenSimMot OpenSimParser::loadMot(
@@ -1599,16 +1804,20 @@ OpenSimMot OpenSimParser::loadMot(
   auto end = content.find("\n");
   while (end != std::string::npos)
   {
-    std::string line = content.substr(start, end - start);
+    // Data rows are walked in place, rather than copying them and their tokens
+    // out
+    const char* lineStart = content.data() + start;
+    const char* lineEnd = content.data() + end;
 
     // Trim '\r', in case this file was saved on a Windows machine
-    if (line.size() > 0 && line[line.size() - 1] == '\r')
+    if (lineEnd > lineStart && *(lineEnd - 1) == '\r')
     {
-      line = line.substr(0, line.size() - 1);
+      lineEnd--;
     }
 
     if (inHeader)
     {
+      std::string line(lineStart, lineEnd);
       std::string ENDHEADER = "endheader";
       if (line.size() >= ENDHEADER.size()
           && line.substr(0, ENDHEADER.size()) == ENDHEADER)
@@ -1630,15 +1839,13 @@ OpenSimMot OpenSimParser::loadMot(
     else
     {
       int tokenNumber = 0;
-      std::string whitespace = " \t";
-      auto tokenStart = line.find_first_not_of(whitespace);
+      const char* cursor = lineStart;
+      const char* tokenStart;
+      const char* tokenEnd;
       Eigen::VectorXs pose = Eigen::VectorXs::Zero(skel->getNumDofs());
       double timestamp = 0.0;
-      while (tokenStart != std::string::npos)
+      while (nextToken(cursor, lineEnd, tokenStart, tokenEnd))
       {
-        auto tokenEnd = line.find_first_of(whitespace, tokenStart + 1);
-        std::string token = line.substr(tokenStart, tokenEnd - tokenStart);
-
         /////////////////////////////////////////////////////////
         // Process the token, given tokenNumber and lineNumber
 
@@ -1648,6 +1855,7 @@ OpenSimMot OpenSimParser::loadMot(
           {
             // This means we're on the row defining the names of the joints
             // we're recording positions of
+            std::string token(tokenStart, tokenEnd);
             dynamics::DegreeOfFreedom* dof = skel->getDof(token);
             bool isRotationalJoint = true;
             if (dof != nullptr)
@@ -1678,7 +1886,7 @@ OpenSimMot OpenSimParser::loadMot(
         }
         else
         {
-          double value = atof(token.c_str());
+          double value = parseDouble(tokenStart, tokenEnd);
           if (tokenNumber == 0)
           {
             timestamp = value;
@@ -1701,11 +1909,6 @@ OpenSimMot OpenSimParser::loadMot(
         /////////////////////////////////////////////////////////
 
         tokenNumber++;
-        if (tokenEnd == std::string::npos)
-        {
-          break;
-        }
-        tokenStart = line.find_first_not_of(whitespace, tokenEnd + 1);
       }
 
       if (lineNumber > 0)
@@ -1728,25 +1931,29 @@ OpenSimMot OpenSimParser::loadMot(
       = Eigen::MatrixXs::Zero(skel->getNumDofs(), poses.size());
   for (int i = 0; i < poses.size(); i++)
   {
-    if (skel->getJoint(0)->getType()
-        == dynamics::EulerFreeJoint::getStaticType())
+    posesMatrix.col(i) = poses[i];
+  }
+  if (skel->getJoint(0)->getType() == dynamics::EulerFreeJoint::getStaticType())
+  {
+    // Convert the whole trial at once, so the rotation math is batched
+    Eigen::MatrixXs ballPoses
+        = skel->convertPositionsToBallSpaceBatch(posesMatrix);
+
+    // Rotate the orientation
+    Eigen::MatrixXs rotations
+        = math::expMapRotBatch(ballPoses.block(0, 0, 3, ballPoses.cols()));
+    for (int i = 0; i < rotations.cols(); i++)
     {
-      Eigen::VectorXs ballPoses = skel->convertPositionsToBallSpace(poses[i]);
-
-      // Rotate the orientation
-      Eigen::Vector3s so3 = ballPoses.segment<3>(0);
-      Eigen::Matrix3s R = math::expMapRot(so3);
-      ballPoses.segment<3>(0) = math::logMap(rotateBy * R);
+      Eigen::Map<Eigen::Matrix3s> R(rotations.col(i).data());
+      R = rotateBy * R;
+    }
+    ballPoses.block(0, 0, 3, ballPoses.cols()) = math::logMapBatch(rotations);
 
-      // Rotate the offset
-      ballPoses.segment<3>(3) = rotateBy * ballPoses.segment<3>(3);
+    // Rotate the offset
+    ballPoses.block(3, 0, 3, ballPoses.cols())
+        = rotateBy * ballPoses.block(3, 0, 3, ballPoses.cols());
 
-      posesMatrix.col(i) = skel->convertPositionsFromBallSpace(ballPoses);
-    }
-    else
-    {
-      posesMatrix.col(i) = poses[i];
-    }
+    posesMatrix = skel->convertPositionsFromBallSpaceBatch(ballPoses);
   }
   OpenSimMot mot;
   mot.poses = posesMatrix;
@@ -2061,16 +2268,20 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
   auto end = content.find("\n");
   while (end != std::string::npos)
   {
-    std::string line = content.substr(start, end - start);
+    // Data rows are walked in place, rather than copying them and their tokens
+    // out
+    const char* lineStart = content.data() + start;
+    const char* lineEnd = content.data() + end;
 
     // Trim '\r', in case this file was saved on a Windows machine
-    if (line.size() > 0 && line[line.size() - 1] == '\r')
+    if (lineEnd > lineStart && *(lineEnd - 1) == '\r')
     {
-      line = line.substr(0, line.size() - 1);
+      lineEnd--;
     }
 
     if (inHeader)
     {
+      std::string line(lineStart, lineEnd);
       std::string ENDHEADER = "endheader";
       if (line.size() >= ENDHEADER.size()
           && line.substr(0, ENDHEADER.size()) == ENDHEADER)
@@ -2091,8 +2302,9 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
     else
     {
       int tokenNumber = 0;
-      std::string whitespace = " \t";
-      auto tokenStart = line.find_first_not_of(whitespace);
+      const char* cursor = lineStart;
+      const char* tokenStart;
+      const char* tokenEnd;
 
       double timestamp = 0.0;
       std::vector<Eigen::Vector3s> cops;
@@ -2104,21 +2316,18 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
         cops.push_back(Eigen::Vector3s::Zero());
       }
 
-      while (tokenStart != std::string::npos)
+      while (nextToken(cursor, lineEnd, tokenStart, tokenEnd))
       {
-        auto tokenEnd = line.find_first_of(whitespace, tokenStart + 1);
-        std::string token = line.substr(tokenStart, tokenEnd - tokenStart);
-
         /////////////////////////////////////////////////////////
         // Process the token, given tokenNumber and lineNumber
 
         if (lineNumber == 0)
         {
-          colNames.push_back(token);
+          colNames.emplace_back(tokenStart, tokenEnd);
         }
         else
         {
-          double value = atof(token.c_str());
+          double value = parseDouble(tokenStart, tokenEnd);
           if (tokenNumber == 0)
           {
             timestamp = value;
@@ -2145,11 +2354,6 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
         /////////////////////////////////////////////////////////
 
         tokenNumber++;
-        if (tokenEnd == std::string::npos)
-        {
-          break;
-        }
-        tokenStart = line.find_first_not_of(whitespace, tokenEnd + 1);
       }
 
       if (lineNumber == 0)
@@ -2355,6 +2559,329 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
   return forcePlates;
 }
 
+//==============================================================================
+// The binary sidecar files written by saveTRCBinary(), saveMotBinary() and
+// saveGRFBinary() all share one layout, in host byte order:
+//
+//   char[8]   "NIMBLTBL"
+//   uint32    format version (currently 1)
+//   uint32    kind (see BinaryTableKind)
+//   uint32    number of rows (frames)
+//   uint32    number of columns
+//   uint32    number of names, then for each name a uint32 length and the
+//             name's bytes
+//   double    one timestamp per row
+//   double    the columns, one after another, each `rows` values long
+//
+// Values are stored as doubles, which is exactly what the text loaders
+// produce, so nothing is lost going text -> loaded -> binary -> loaded.
+const char BINARY_TABLE_MAGIC[8] = {'N', 'I', 'M', 'B', 'L', 'T', 'B', 'L'};
+const std::uint32_t BINARY_TABLE_VERSION = 1;
+
+enum BinaryTableKind
+{
+  BINARY_TABLE_TRC = 1,
+  BINARY_TABLE_MOT = 2,
+  BINARY_TABLE_GRF = 3
+};
+
+struct BinaryTable
+{
+  std::vector<std::string> names;
+  std::vector<double> timestamps;
+  // rows x columns, so that each column is contiguous
+  Eigen::MatrixXd columns;
+};
+
+//==============================================================================
+/// This writes a table out in the binary sidecar layout
+void writeBinaryTable(
+    const std::string& outputPath,
+    BinaryTableKind kind,
+    const BinaryTable& table)
+{
+  std::ofstream file(outputPath, std::ios::out | std::ios::binary);
+  std::uint32_t header[] = {BINARY_TABLE_VERSION,
+                            (std::uint32_t)kind,
+                            (std::uint32_t)table.columns.rows(),
+                            (std::uint32_t)table.columns.cols(),
+                            (std::uint32_t)table.names.size()};
+  file.write(BINARY_TABLE_MAGIC, sizeof(BINARY_TABLE_MAGIC));
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  for (const std::string& name : table.names)
+  {
+    std::uint32_t length = name.size();
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(name.data(), length);
+  }
+  assert(table.timestamps.size() == table.columns.rows());
+  file.write(
+      reinterpret_cast<const char*>(table.timestamps.data()),
+      table.timestamps.size() * sizeof(double));
+  file.write(
+      reinterpret_cast<const char*>(table.columns.data()),
+      table.columns.size() * sizeof(double));
+  file.close();
+}
+
+//==============================================================================
+/// This reads a table in the binary sidecar layout out of `content`. This
+/// returns false, leaving `table` in an unspecified state, if `content` isn't
+/// a well formed table of the expected kind.
+bool readBinaryTable(
+    const std::string& content, BinaryTableKind kind, BinaryTable& table)
+{
+  const char* cursor = content.data();
+  const char* end = content.data() + content.size();
+  auto read = [&](void* out, std::size_t bytes) {
+    if ((std::size_t)(end - cursor) < bytes)
+    {
+      return false;
+    }
+    std::memcpy(out, cursor, bytes);
+    cursor += bytes;
+    return true;
+  };
+
+  char magic[sizeof(BINARY_TABLE_MAGIC)];
+  std::uint32_t header[5];
+  if (!read(magic, sizeof(magic))
+      || std::memcmp(magic, BINARY_TABLE_MAGIC, sizeof(magic)) != 0
+      || !read(header, sizeof(header)) || header[0] != BINARY_TABLE_VERSION
+      || header[1] != (std::uint32_t)kind)
+  {
+    return false;
+  }
+  std::uint32_t rows = header[2];
+  std::uint32_t cols = header[3];
+  std::uint32_t numNames = header[4];
+
+  table.names.clear();
+  for (std::uint32_t i = 0; i < numNames; i++)
+  {
+    std::uint32_t length;
+    if (!read(&length, sizeof(length)) || (std::size_t)(end - cursor) < length)
+    {
+      return false;
+    }
+    table.names.emplace_back(cursor, length);
+    cursor += length;
+  }
+
+  // Check the size up front, so a corrupt header can't make us allocate a
+  // huge table
+  std::size_t remaining = end - cursor;
+  std::size_t expected
+      = ((std::size_t)rows + (std::size_t)rows * cols) * sizeof(double);
+  if (remaining != expected)
+  {
+    return false;
+  }
+  table.timestamps.resize(rows);
+  table.columns.resize(rows, cols);
+  read(table.timestamps.data(), rows * sizeof(double));
+  read(table.columns.data(), (std::size_t)rows * cols * sizeof(double));
+  return true;
+}
+
+//==============================================================================
+/// This saves marker data in the compact binary sidecar format. Loading it
+/// back with loadTRCBinary() gives exactly the same OpenSimTRC, without any
+/// text parsing.
+void OpenSimParser::saveTRCBinary(
+    const std::string& outputPath, const OpenSimTRC& trc)
+{
+  const MarkerTrajectories& trajectories = trc.markerTrajectories;
+  int numFrames = trajectories.getNumFrames();
+  int numMarkers = trajectories.getNumMarkers();
+
+  BinaryTable table;
+  table.names = trajectories.getMarkerNames();
+  table.timestamps = trc.timestamps;
+  // Hidden markers are written as NaN, which the text format does too
+  table.columns = Eigen::MatrixXd::Constant(
+      numFrames, numMarkers * 3, std::numeric_limits<double>::quiet_NaN());
+  for (int t = 0; t < numFrames; t++)
+  {
+    for (int i = 0; i < numMarkers; i++)
+    {
+      if (trajectories.isVisible(t, i))
+      {
+        Eigen::Vector3s p = trajectories.getPosition(t, i);
+        for (int axis = 0; axis < 3; axis++)
+        {
+          table.columns(t, i * 3 + axis) = (double)p(axis);
+        }
+      }
+    }
+  }
+  writeBinaryTable(outputPath, BINARY_TABLE_TRC, table);
+}
+
+//==============================================================================
+/// This loads marker data saved by saveTRCBinary()
+OpenSimTRC OpenSimParser::loadTRCBinary(
+    const common::Uri& uri, const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+
+  OpenSimTRC result;
+  BinaryTable table;
+  if (!readBinaryTable(retriever->readAll(uri), BINARY_TABLE_TRC, table)
+      || table.columns.cols() != table.names.size() * 3)
+  {
+    dterr << "Binary TRC file[" << uri.toString() << "] is malformed.\n";
+    return result;
+  }
+
+  int numFrames = table.columns.rows();
+  result.timestamps = table.timestamps;
+  result.markerTrajectories = MarkerTrajectories(table.names, numFrames);
+  for (int t = 0; t < numFrames; t++)
+  {
+    for (int i = 0; i < table.names.size(); i++)
+    {
+      Eigen::Vector3s p = Eigen::Vector3s(
+          table.columns(t, i * 3),
+          table.columns(t, i * 3 + 1),
+          table.columns(t, i * 3 + 2));
+      if (!p.hasNaN())
+      {
+        result.markerTrajectories.setPosition(t, i, p);
+      }
+    }
+  }
+  finishLoadingTRC(result);
+
+  return result;
+}
+
+//==============================================================================
+/// This saves joint angles in the compact binary sidecar format, with one
+/// column per DOF of `skel`
+void OpenSimParser::saveMotBinary(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    const std::string& outputPath,
+    const std::vector<double>& timestamps,
+    const Eigen::MatrixXs& poses)
+{
+  BinaryTable table;
+  for (int i = 0; i < skel->getNumDofs(); i++)
+  {
+    table.names.push_back(skel->getDof(i)->getName());
+  }
+  table.timestamps = timestamps;
+  table.columns = poses.transpose().cast<double>();
+  writeBinaryTable(outputPath, BINARY_TABLE_MOT, table);
+}
+
+//==============================================================================
+/// This loads joint angles saved by saveMotBinary(). Columns are matched to
+/// DOFs of `skel` by name, like loadMot() does, and any DOF without a column
+/// is left at zero.
+OpenSimMot OpenSimParser::loadMotBinary(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    const common::Uri& uri,
+    const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+
+  OpenSimMot mot;
+  BinaryTable table;
+  if (!readBinaryTable(retriever->readAll(uri), BINARY_TABLE_MOT, table)
+      || table.columns.cols() != table.names.size())
+  {
+    dterr << "Binary MOT file[" << uri.toString() << "] is malformed.\n";
+    return mot;
+  }
+
+  mot.timestamps = table.timestamps;
+  mot.poses = Eigen::MatrixXs::Zero(skel->getNumDofs(), table.columns.rows());
+  for (int i = 0; i < table.names.size(); i++)
+  {
+    dynamics::DegreeOfFreedom* dof = skel->getDof(table.names[i]);
+    if (dof != nullptr)
+    {
+      mot.poses.row(dof->getIndexInSkeleton())
+          = table.columns.col(i).transpose().cast<s_t>();
+    }
+  }
+
+  return mot;
+}
+
+//==============================================================================
+/// This saves ground reaction forces in the compact binary sidecar format.
+/// Unlike saveGRFMot(), NaNs are kept as-is.
+void OpenSimParser::saveGRFBinary(
+    const std::string& outputPath,
+    const std::vector<double>& timestamps,
+    const std::vector<biomechanics::ForcePlate>& forcePlates)
+{
+  BinaryTable table;
+  table.timestamps = timestamps;
+  table.columns
+      = Eigen::MatrixXd::Zero(timestamps.size(), 9 * forcePlates.size());
+  for (int i = 0; i < forcePlates.size(); i++)
+  {
+    std::string num = std::to_string(i + 1);
+    for (std::string suffix :
+         {"vx", "vy", "vz", "px", "py", "pz", "mx", "my", "mz"})
+    {
+      table.names.push_back("ground_force_" + num + "_" + suffix);
+    }
+    for (int t = 0; t < timestamps.size(); t++)
+    {
+      for (int axis = 0; axis < 3; axis++)
+      {
+        table.columns(t, i * 9 + axis) = forcePlates[i].forces[t](axis);
+        table.columns(t, i * 9 + 3 + axis)
+            = forcePlates[i].centersOfPressure[t](axis);
+        table.columns(t, i * 9 + 6 + axis) = forcePlates[i].moments[t](axis);
+      }
+    }
+  }
+  writeBinaryTable(outputPath, BINARY_TABLE_GRF, table);
+}
+
+//==============================================================================
+/// This loads ground reaction forces saved by saveGRFBinary()
+std::vector<ForcePlate> OpenSimParser::loadGRFBinary(
+    const common::Uri& uri, const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+
+  std::vector<ForcePlate> forcePlates;
+  BinaryTable table;
+  if (!readBinaryTable(retriever->readAll(uri), BINARY_TABLE_GRF, table)
+      || table.columns.cols() % 9 != 0)
+  {
+    dterr << "Binary GRF file[" << uri.toString() << "] is malformed.\n";
+    return forcePlates;
+  }
+
+  int numFrames = table.columns.rows();
+  for (int i = 0; i < table.columns.cols() / 9; i++)
+  {
+    forcePlates.emplace_back();
+    ForcePlate& forcePlate = forcePlates.back();
+    for (int t = 0; t < numFrames; t++)
+    {
+      forcePlate.forces.push_back(
+          table.columns.block<1, 3>(t, i * 9).transpose().cast<s_t>());
+      forcePlate.centersOfPressure.push_back(
+          table.columns.block<1, 3>(t, i * 9 + 3).transpose().cast<s_t>());
+      forcePlate.moments.push_back(
+          table.columns.block<1, 3>(t, i * 9 + 6).transpose().cast<s_t>());
+    }
+  }
+
+  return forcePlates;
+}
+
 template <std::size_t Dimension>
 std::pair<dynamics::CustomJoint<Dimension>*, dynamics::BodyNode*>
 createCustomJoint(
@@ -8,6 +8,7 @@
 
 #include "dart/biomechanics/C3DLoader.hpp"
 #include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/biomechanics/MarkerTrajectories.hpp"
 #include "dart/common/LocalResourceRetriever.hpp"
 #include "dart/common/Uri.hpp"
 #include "dart/dynamics/BodyNode.hpp"
@@ -15,6 +16,7 @@
 #include "dart/dynamics/EulerFreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/CompactMatrix.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/utils/XmlHelpers.hpp"
 
@@ -49,6 +51,10 @@ struct OpenSimScaleAndMarkerOffsets
 struct OpenSimTRC
 {
   std::vector<double> timestamps;
+  // This is the primary store for the marker data
+  MarkerTrajectories markerTrajectories;
+  // This is a copy of `markerTrajectories` as one map per frame, which is kept
+  // for backwards compatibility
   std::vector<std::map<std::string, Eigen::Vector3s>> markerTimesteps;
   std::map<std::string, std::vector<Eigen::Vector3s>> markerLines;
   int framesPerSecond;
@@ -58,6 +64,17 @@ struct OpenSimMot
 {
   std::vector<double> timestamps;
   Eigen::MatrixXs poses;
+  // This is a single precision copy of `poses`, only filled in after
+  // compactPoses()
+  math::CompactMatrix compactedPoses;
+
+  /// This moves `poses` over to single precision storage, which halves its
+  /// memory, and frees the s_t copy. Use getPoses() to read them either way.
+  void compactPoses();
+
+  /// This returns `poses`, expanding them from single precision storage if
+  /// compactPoses() has been called
+  Eigen::MatrixXs getPoses() const;
 };
 
 struct OpenSimGRF
@@ -70,11 +87,26 @@ struct OpenSimGRF
 class OpenSimParser
 {
 public:
-  /// Read Skeleton from *.osim file
+  /// Read Skeleton from *.osim file. Parsed models are cached in memory, keyed
+  /// by URI and a hash of the file contents, so loading the same file again
+  /// just clones the Skeleton we built last time. Every call returns its own
+  /// Skeleton, so it's safe to scale or otherwise modify the result.
   static OpenSimFile parseOsim(
       const common::Uri& uri,
       const common::ResourceRetrieverPtr& retriever = nullptr);
 
+  /// This always parses the *.osim file from scratch, bypassing the cache
+  /// used by parseOsim()
+  static OpenSimFile parseOsimUncached(
+      const common::Uri& uri,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This turns the parseOsim() cache on or off. It's on by default.
+  static void setParseCacheEnabled(bool enabled);
+
+  /// This drops every model held in the parseOsim() cache
+  static void clearParseCache();
+
   /// This creates an XML configuration file, which you can pass to the OpenSim
   /// scaling tool to rescale a skeleton
   static void saveOsimScalingXMLFile(
@@ -97,6 +129,16 @@ public:
       const std::string& osimOutputMotPath,
       const std::string& ikInstructionsOutputPath);
 
+  /// This builds the XML configuration that saveOsimInverseKinematicsXMLFile()
+  /// writes into `xmlDoc`, replacing anything that was in it
+  static void makeOsimInverseKinematicsXML(
+      tinyxml2::XMLDocument& xmlDoc,
+      const std::string& subjectName,
+      const std::vector<std::string>& markerNames,
+      const std::string& osimInputModelPath,
+      const std::string& osimInputTrcPath,
+      const std::string& osimOutputMotPath);
+
   /// This creates an XML configuration file, which you can pass to the OpenSim
   /// ID tool to recreate / validate the results of ID created from this tool
   static void saveOsimInverseDynamicsForcesXMLFile(
@@ -118,6 +160,17 @@ public:
       const std::string& osimOutputBodyForcesStoPath,
       const std::string& idInstructionsOutputPath);
 
+  /// This builds the XML configuration that saveOsimInverseDynamicsXMLFile()
+  /// writes into `xmlDoc`, replacing anything that was in it
+  static void makeOsimInverseDynamicsXML(
+      tinyxml2::XMLDocument& xmlDoc,
+      const std::string& subjectName,
+      const std::string& osimInputModelPath,
+      const std::string& osimInputMotPath,
+      const std::string& osimForcesXmlPath,
+      const std::string& osimOutputStoPath,
+      const std::string& osimOutputBodyForcesStoPath);
+
   /// This gets called by rationalizeJoints()
   static void updateRootJointLimits(
       tinyxml2::XMLElement* element, dynamics::EulerFreeJoint* joint);
@@ -219,6 +272,45 @@ public:
       int targetFramesPerSecond = 100,
       const common::ResourceRetrieverPtr& retriever = nullptr);
 
+  /// This saves marker data in the compact binary sidecar format. Loading it
+  /// back with loadTRCBinary() gives exactly the same OpenSimTRC, without any
+  /// text parsing.
+  static void saveTRCBinary(
+      const std::string& outputPath, const OpenSimTRC& trc);
+
+  /// This loads marker data saved by saveTRCBinary()
+  static OpenSimTRC loadTRCBinary(
+      const common::Uri& uri,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This saves joint angles in the compact binary sidecar format, with one
+  /// column per DOF of `skel`
+  static void saveMotBinary(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      const std::string& outputPath,
+      const std::vector<double>& timestamps,
+      const Eigen::MatrixXs& poses);
+
+  /// This loads joint angles saved by saveMotBinary(). Columns are matched to
+  /// DOFs of `skel` by name, like loadMot() does, and any DOF without a column
+  /// is left at zero.
+  static OpenSimMot loadMotBinary(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      const common::Uri& uri,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This saves ground reaction forces in the compact binary sidecar format.
+  /// Unlike saveGRFMot(), NaNs are kept as-is.
+  static void saveGRFBinary(
+      const std::string& outputPath,
+      const std::vector<double>& timestamps,
+      const std::vector<biomechanics::ForcePlate>& forcePlates);
+
+  /// This loads ground reaction forces saved by saveGRFBinary()
+  static std::vector<ForcePlate> loadGRFBinary(
+      const common::Uri& uri,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
   /// When people finish preparing their model in OpenSim, they save a *.osim
   /// file with all the scales and offsets baked in. This is a utility to go
   /// through and get out the scales and offsets in terms of a standard
@@ -1,8 +1,11 @@
 #include "dart/biomechanics/SkeletonConverter.hpp"
 
+#include <algorithm>
+#include <future>
 #include <unordered_map>
 #include <vector>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 
 namespace dart {
@@ -11,7 +14,9 @@ namespace biomechanics {
 //==============================================================================
 SkeletonConverter::SkeletonConverter(
     dynamics::SkeletonPtr source, dynamics::SkeletonPtr target)
-  : mSourceSkeleton(source), mTargetSkeleton(target)
+  : mSourceSkeleton(source),
+    mTargetSkeleton(target),
+    mUseLevenbergMarquardt(false)
 {
   mSourceSkeletonBallJoints = mSourceSkeleton->convertSkeletonToBallJoints();
 }
@@ -37,6 +42,14 @@ void SkeletonConverter::linkJoints(
   mTargetJoints.push_back(targetJoint);
 }
 
+//==============================================================================
+/// If true, the marker fits run Levenberg-Marquardt IK over the sparse marker
+/// Jacobians, instead of damped least squares
+void SkeletonConverter::setUseLevenbergMarquardt(bool useLevenbergMarquardt)
+{
+  mUseLevenbergMarquardt = useLevenbergMarquardt;
+}
+
 //==============================================================================
 /// This returns the concatenated 3-vectors for world positions of each joint
 /// in 3D world space, for the registered source joints.
@@ -235,7 +248,8 @@ s_t SkeletonConverter::fitSourceToTarget(
     int maxStepCount,
     s_t leastSquaresDamping,
     bool lineSearch,
-    bool logOutput)
+    bool logOutput,
+    int maxRestarts)
 {
   // We can do this gradient descent in a
   // gimbal-lock-free version of the skeleton, and then convert back when we're
@@ -254,7 +268,8 @@ s_t SkeletonConverter::fitSourceToTarget(
           .setMaxStepCount(maxStepCount)
           .setLeastSquaresDamping(leastSquaresDamping)
           .setLineSearch(lineSearch)
-          .setMaxRestarts(1)
+          .setMaxRestarts(maxRestarts)
+          .setLevenbergMarquardt(mUseLevenbergMarquardt)
           .setLogOutput(logOutput));
   mSourceSkeleton->setPositions(mSourceSkeleton->convertPositionsFromBallSpace(
       mSourceSkeletonBallJoints->getPositions()));
@@ -282,6 +297,7 @@ s_t SkeletonConverter::fitTargetToSource(
           .setLeastSquaresDamping(leastSquaresDamping)
           .setLineSearch(lineSearch)
           .setMaxRestarts(1)
+          .setLevenbergMarquardt(mUseLevenbergMarquardt)
           .setLogOutput(logOutput));
   return error;
 }
@@ -415,6 +431,161 @@ Eigen::MatrixXs SkeletonConverter::convertMotion(
   return sourceMotion;
 }
 
+//==============================================================================
+Eigen::MatrixXs SkeletonConverter::convertMotionParallel(
+    const Eigen::MatrixXs& targetMotion,
+    int numChunks,
+    s_t regressionRatio,
+    int maxRestarts,
+    ////// IK options
+    s_t convergenceThreshold,
+    int maxStepCount,
+    s_t leastSquaresDamping,
+    bool lineSearch)
+{
+  const int numFrames = targetMotion.cols();
+  Eigen::MatrixXs sourceMotion
+      = Eigen::MatrixXs::Zero(mSourceSkeleton->getNumDofs(), numFrames);
+  if (numFrames == 0)
+    return sourceMotion;
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  if (numChunks <= 0)
+    numChunks = pool.getNumThreads();
+  numChunks = std::max(1, std::min(numChunks, numFrames));
+
+  // Cloning skeletons isn't safe to do concurrently, so we make every chunk's
+  // converter here before starting
+  std::vector<std::shared_ptr<SkeletonConverter>> converters;
+  for (int c = 0; c < numChunks; c++)
+  {
+    converters.push_back(cloneWithNewSkeletons());
+  }
+
+  // Each chunk writes disjoint columns of sourceMotion, so this doesn't need a
+  // lock
+  auto runChunk = [&](int c) {
+    converters[c]->convertMotionChunk(
+        targetMotion,
+        (numFrames * c) / numChunks,
+        (numFrames * (c + 1)) / numChunks,
+        sourceMotion,
+        regressionRatio,
+        maxRestarts,
+        convergenceThreshold,
+        maxStepCount,
+        leastSquaresDamping,
+        lineSearch);
+  };
+
+  if (numChunks == 1)
+  {
+    runChunk(0);
+    return sourceMotion;
+  }
+
+  std::vector<std::future<void>> futures;
+  for (int c = 0; c < numChunks; c++)
+  {
+    futures.push_back(pool.submit(runChunk, c));
+  }
+  // Wait for every chunk before get() can throw, since the chunks refer to our
+  // stack
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+  return sourceMotion;
+}
+
+//==============================================================================
+void SkeletonConverter::convertMotionChunk(
+    const Eigen::MatrixXs& targetMotion,
+    int start,
+    int end,
+    Eigen::MatrixXs& sourceMotion,
+    s_t regressionRatio,
+    int maxRestarts,
+    s_t convergenceThreshold,
+    int maxStepCount,
+    s_t leastSquaresDamping,
+    bool lineSearch)
+{
+  s_t lastLoss = 0.0;
+  for (int i = start; i < end; i++)
+  {
+    mTargetSkeleton->setPositions(targetMotion.col(i));
+    // The first frame has nothing to warm start from, except wherever the
+    // skeleton happened to be
+    s_t loss = fitSourceToTarget(
+        convergenceThreshold,
+        maxStepCount,
+        leastSquaresDamping,
+        lineSearch,
+        false,
+        i == start ? maxRestarts : 1);
+    if (i > start && maxRestarts > 1
+        && loss > regressionRatio * lastLoss + convergenceThreshold)
+    {
+      // The first restart picks up from the warm started fit, so this can
+      // only improve on it
+      loss = fitSourceToTarget(
+          convergenceThreshold,
+          maxStepCount,
+          leastSquaresDamping,
+          lineSearch,
+          false,
+          maxRestarts);
+    }
+    sourceMotion.col(i) = mSourceSkeleton->getPositions();
+    lastLoss = loss;
+  }
+}
+
+//==============================================================================
+std::shared_ptr<SkeletonConverter> SkeletonConverter::cloneWithNewSkeletons()
+{
+  dynamics::SkeletonPtr source = mSourceSkeleton->cloneSkeleton();
+  dynamics::SkeletonPtr target = mTargetSkeleton->cloneSkeleton();
+  std::shared_ptr<SkeletonConverter> clone
+      = std::make_shared<SkeletonConverter>(source, target);
+  for (int i = 0; i < source->getNumBodyNodes(); i++)
+  {
+    clone->mSourceSkeletonBallJoints->getBodyNode(i)->setScale(
+        source->getBodyNode(i)->getScale());
+  }
+
+  for (int i = 0; i < mSourceJoints.size(); i++)
+  {
+    clone->linkJoints(
+        source->getJoint(mSourceJoints[i]->getJointIndexInSkeleton()),
+        target->getJoint(mTargetJoints[i]->getJointIndexInSkeleton()));
+  }
+  for (auto& marker : mSourceMarkers)
+  {
+    clone->mSourceMarkers.emplace_back(
+        source->getBodyNode(marker.first->getIndexInSkeleton()),
+        marker.second);
+  }
+  for (auto& marker : mSourceMarkersBallJoints)
+  {
+    clone->mSourceMarkersBallJoints.emplace_back(
+        clone->mSourceSkeletonBallJoints->getBodyNode(
+            marker.first->getIndexInSkeleton()),
+        marker.second);
+  }
+  for (auto& marker : mTargetMarkers)
+  {
+    clone->mTargetMarkers.emplace_back(
+        target->getBodyNode(marker.first->getIndexInSkeleton()),
+        marker.second);
+  }
+  clone->mMarkerWeights = mMarkerWeights;
+  clone->mUseLevenbergMarquardt = mUseLevenbergMarquardt;
+  return clone;
+}
+
 //==============================================================================
 /// This will display the state of the linkages between the two skeletons into
 /// the provided GUI.
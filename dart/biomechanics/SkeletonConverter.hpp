@@ -1,7 +1,9 @@
 #ifndef DART_UTILS_SKELCONVERTER_HPP_
 #define DART_UTILS_SKELCONVERTER_HPP_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -24,6 +26,12 @@ public:
   /// rotations are as close as possible.
   void linkJoints(dynamics::Joint* sourceJoint, dynamics::Joint* targetJoint);
 
+  /// If true, the marker fits (fitSourceToTarget(), fitTargetToSource(), and
+  /// the motion conversions built on them) run Levenberg-Marquardt IK over
+  /// the sparse marker Jacobians, instead of damped least squares. This
+  /// defaults to false.
+  void setUseLevenbergMarquardt(bool useLevenbergMarquardt);
+
   /// This will do its best to map the target onto the source skeleton
   void rescaleAndPrepTarget(
       int addFakeMarkers = 3,
@@ -37,13 +45,15 @@ public:
       bool logOutput = false);
 
   /// This will try to get the source skeleton configured to match the target as
-  /// closely as possible
+  /// closely as possible. With `maxRestarts` above 1, this also tries random
+  /// poses after the current one, and keeps the best fit.
   s_t fitSourceToTarget(
       s_t convergenceThreshold = 1e-7,
       int maxStepCount = 100,
       s_t leastSquaresDamping = 0.01,
       bool lineSearch = true,
-      bool logOutput = false);
+      bool logOutput = false,
+      int maxRestarts = 1);
 
   /// This will try to get the target skeleton configured to match the source as
   /// closely as possible. This is mostly just here for debugging, in general
@@ -67,6 +77,25 @@ public:
       bool lineSearch = true,
       bool logIKOutput = false);
 
+  /// This converts a motion like convertMotion(), but splits it into
+  /// `numChunks` runs of consecutive frames (0 means one per thread), which
+  /// get converted in parallel on the global ThreadPool, each on its own
+  /// clones of the skeletons. The first frame of each chunk gets a fit with
+  /// `maxRestarts` random restarts. After that, each frame is warm started
+  /// from the previous frame's fit with a single IK run, and only if its loss
+  /// regresses to more than `regressionRatio` times the previous frame's loss
+  /// (plus `convergenceThreshold`) do we pay for restarts again.
+  Eigen::MatrixXs convertMotionParallel(
+      const Eigen::MatrixXs& targetMotion,
+      int numChunks = 0,
+      s_t regressionRatio = 2.0,
+      int maxRestarts = 5,
+      // IK Options
+      s_t convergenceThreshold = 1e-7,
+      int maxStepCount = 100,
+      s_t leastSquaresDamping = 0.01,
+      bool lineSearch = true);
+
   /// This returns the concatenated 3-vectors for world positions of each joint
   /// in 3D world space, for the registered target joints.
   Eigen::VectorXs getSourceJointWorldPositions();
@@ -98,6 +127,24 @@ public:
   getTargetMarkers() const;
 
 protected:
+  /// This makes a converter with the same links, markers and weights as this
+  /// one, on fresh clones of both skeletons, so it can run on another thread
+  std::shared_ptr<SkeletonConverter> cloneWithNewSkeletons();
+
+  /// This converts frames [start, end) of `targetMotion` into the same
+  /// columns of `sourceMotion`, for convertMotionParallel()
+  void convertMotionChunk(
+      const Eigen::MatrixXs& targetMotion,
+      int start,
+      int end,
+      Eigen::MatrixXs& sourceMotion,
+      s_t regressionRatio,
+      int maxRestarts,
+      s_t convergenceThreshold,
+      int maxStepCount,
+      s_t leastSquaresDamping,
+      bool lineSearch);
+
   dynamics::SkeletonPtr mSourceSkeleton;
   dynamics::SkeletonPtr mSourceSkeletonBallJoints;
   dynamics::SkeletonPtr mTargetSkeleton;
@@ -111,6 +158,7 @@ protected:
       mSourceMarkersBallJoints;
   std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> mTargetMarkers;
   Eigen::VectorXs mMarkerWeights;
+  bool mUseLevenbergMarquardt;
 }; // namespace OpenSimParser
 
 } // namespace biomechanics
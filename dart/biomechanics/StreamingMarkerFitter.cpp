@@ -0,0 +1,326 @@
+#include "dart/biomechanics/StreamingMarkerFitter.hpp"
+
+#include <chrono>
+#include <cmath>
+
+#include "dart/math/AssignmentMatcher.hpp"
+#include "dart/math/IKSolver.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+//==============================================================================
+StreamingMarkerFitter::StreamingMarkerFitter(
+    std::shared_ptr<dynamics::Skeleton> skeleton,
+    dynamics::MarkerMap markers,
+    s_t mergeDistance,
+    int mergeFrames)
+  : mSkeleton(skeleton),
+    mMarkerMap(markers),
+    mMergeDistance(mergeDistance),
+    mMergeFrames(mergeFrames),
+    mTracker(mergeDistance, mergeFrames, false),
+    mPose(skeleton->getPositions()),
+    mTime(0),
+    mLabelDistance(0.05),
+    mMaxIKStepsPerFrame(10),
+    mUseLevenbergMarquardt(true),
+    mGUIPrefix("live_")
+{
+  for (auto& pair : mMarkerMap)
+  {
+    mMarkerNames.push_back(pair.first);
+    mMarkers.push_back(pair.second);
+  }
+}
+
+//==============================================================================
+/// This sets the furthest an unlabelled point can be from where the
+/// skeleton predicts a marker to be, and still get that marker's label.
+/// Labelled points that end up further than this from their marker after
+/// IK lose their label, so they can be labelled again on the next frame.
+void StreamingMarkerFitter::setLabelDistance(s_t distance)
+{
+  mLabelDistance = distance;
+}
+
+//==============================================================================
+/// This caps the number of IK steps we take each frame, which bounds the
+/// per-frame latency
+void StreamingMarkerFitter::setMaxIKStepsPerFrame(int steps)
+{
+  mMaxIKStepsPerFrame = steps;
+}
+
+//==============================================================================
+/// If true, the per-frame IK takes sparse Levenberg-Marquardt steps. This
+/// is on by default, since it converges in far fewer steps from a warm
+/// start.
+void StreamingMarkerFitter::setUseLevenbergMarquardt(bool useLevenbergMarquardt)
+{
+  mUseLevenbergMarquardt = useLevenbergMarquardt;
+}
+
+//==============================================================================
+/// If this is set, every frame gets rendered to the GUI, with the skeleton
+/// and spheres for each labelled marker under `prefix`
+void StreamingMarkerFitter::setGUIServer(
+    std::shared_ptr<server::GUIWebsocketServer> server,
+    const std::string& prefix)
+{
+  mServer = server;
+  mGUIPrefix = prefix;
+  mRenderedMarkers.clear();
+}
+
+//==============================================================================
+/// This gets called with every frame once it's fit, for passing the
+/// results on (for example, to the realtime subsystem). It's called on the
+/// thread that observed the frame, so it should return quickly.
+void StreamingMarkerFitter::setFrameCallback(
+    std::function<void(const StreamingFrame&)> callback)
+{
+  mFrameCallback = callback;
+}
+
+//==============================================================================
+/// This forgets all the traces and labels, and starts the next frame from
+/// `pose`
+void StreamingMarkerFitter::reset(const Eigen::VectorXs& pose)
+{
+  mTracker = MarkerTraceTracker(mMergeDistance, mMergeFrames, false);
+  mPose = pose;
+  mTime = 0;
+}
+
+//==============================================================================
+/// This labels an unlabelled point cloud, fits the skeleton to it, and
+/// publishes the result
+StreamingFrame StreamingMarkerFitter::observePointCloud(
+    const std::vector<Eigen::Vector3s>& pointCloud)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  StreamingFrame frame;
+  frame.time = mTime;
+  frame.pointLabels.resize(pointCloud.size());
+
+  // 1. Extend the traces. Traces that already have a label keep it.
+  std::vector<int> pointTraces = mTracker.addFrame(mTime, pointCloud);
+  std::vector<MarkerTrace>& traces = mTracker.getTraces();
+
+  // 2. Label the points on unlabelled traces, by matching them to the markers
+  // that no active trace has claimed yet, at the last fitted pose
+  std::set<std::string> claimedLabels;
+  for (int trace : mTracker.getActiveTraces())
+  {
+    if (traces[trace].mMarkerLabel != "")
+    {
+      claimedLabels.insert(traces[trace].mMarkerLabel);
+    }
+  }
+  std::vector<int> unlabelledPoints;
+  for (int i = 0; i < pointCloud.size(); i++)
+  {
+    if (traces[pointTraces[i]].mMarkerLabel == "")
+    {
+      unlabelledPoints.push_back(i);
+    }
+  }
+  if (unlabelledPoints.size() > 0 && claimedLabels.size() < mMarkers.size())
+  {
+    mSkeleton->setPositions(mPose);
+    Eigen::VectorXs predicted = mSkeleton->getMarkerWorldPositions(mMarkers);
+
+    std::vector<math::AssignmentMatcher::Edge> edges;
+    for (int i = 0; i < unlabelledPoints.size(); i++)
+    {
+      const Eigen::Vector3s& point = pointCloud[unlabelledPoints[i]];
+      for (int j = 0; j < mMarkers.size(); j++)
+      {
+        if (claimedLabels.count(mMarkerNames[j]))
+          continue;
+        s_t dist = (predicted.segment<3>(j * 3) - point).norm();
+        if (dist <= mLabelDistance)
+        {
+          // Same gated objective as the trace tracking: only match a pair if
+          // it beats leaving both unmatched
+          edges.push_back(
+              math::AssignmentMatcher::Edge{i, j, mLabelDistance - dist});
+        }
+      }
+    }
+    Eigen::VectorXi map = math::AssignmentMatcher::assignRowsToColumnsSparse(
+        unlabelledPoints.size(), mMarkers.size(), edges);
+    for (int i = 0; i < map.size(); i++)
+    {
+      if (map(i) != -1)
+      {
+        traces[pointTraces[unlabelledPoints[i]]].mMarkerLabel
+            = mMarkerNames[map(i)];
+      }
+    }
+  }
+
+  // 3. Fit to the labelled points
+  std::map<std::string, Eigen::Vector3s> markerObservations;
+  for (int i = 0; i < pointCloud.size(); i++)
+  {
+    const std::string& label = traces[pointTraces[i]].mMarkerLabel;
+    if (label != "")
+    {
+      markerObservations[label] = pointCloud[i];
+    }
+  }
+  fitPose(markerObservations, frame);
+
+  // 4. Any label that the fit couldn't explain was probably a mistake, so
+  // drop it and let that trace get labelled again next frame
+  for (int i = 0; i < pointCloud.size(); i++)
+  {
+    std::string& label = traces[pointTraces[i]].mMarkerLabel;
+    if (label == "")
+      continue;
+    auto& marker = mMarkerMap.at(label);
+    Eigen::Vector3s markerPos = marker.first->getWorldTransform()
+                                * marker.second.cwiseProduct(
+                                    marker.first->getScale());
+    if ((markerPos - pointCloud[i]).norm() > mLabelDistance)
+    {
+      label = "";
+      continue;
+    }
+    frame.pointLabels[i] = label;
+  }
+
+  frame.solveSeconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  mTime++;
+  publish(frame);
+  return frame;
+}
+
+//==============================================================================
+/// This skips labelling, for streams (like a Vicon stream) that already
+/// label markers, and just fits the skeleton and publishes the result.
+/// Labels that aren't on the skeleton get ignored.
+StreamingFrame StreamingMarkerFitter::observeLabelledMarkers(
+    const std::map<std::string, Eigen::Vector3s>& markerObservations)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  StreamingFrame frame;
+  frame.time = mTime;
+  fitPose(markerObservations, frame);
+
+  frame.solveSeconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  mTime++;
+  publish(frame);
+  return frame;
+}
+
+//==============================================================================
+/// This returns the last fitted pose
+const Eigen::VectorXs& StreamingMarkerFitter::getPose() const
+{
+  return mPose;
+}
+
+//==============================================================================
+/// This runs warm started IK from mPose against `markerObservations`, and
+/// fills in the pose and error on `frame`
+void StreamingMarkerFitter::fitPose(
+    const std::map<std::string, Eigen::Vector3s>& markerObservations,
+    StreamingFrame& frame)
+{
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  std::vector<Eigen::Vector3s> targets;
+  for (auto& pair : markerObservations)
+  {
+    if (mMarkerMap.count(pair.first) == 0)
+      continue;
+    frame.markerObservations[pair.first] = pair.second;
+    markers.push_back(mMarkerMap.at(pair.first));
+    targets.push_back(pair.second);
+  }
+
+  mSkeleton->setPositions(mPose);
+  frame.rmsMarkerError = 0.0;
+  if (markers.size() > 0)
+  {
+    Eigen::VectorXs targetPositions(markers.size() * 3);
+    for (int i = 0; i < targets.size(); i++)
+    {
+      targetPositions.segment<3>(i * 3) = targets[i];
+    }
+
+    // No random restarts: the last frame's pose is already close, and
+    // restarting would blow the latency budget
+    mSkeleton->fitMarkersToWorldPositions(
+        markers,
+        targetPositions,
+        Eigen::VectorXs::Ones(markers.size()),
+        false,
+        math::IKConfig()
+            .setMaxRestarts(1)
+            .setMaxStepCount(mMaxIKStepsPerFrame)
+            .setLevenbergMarquardt(mUseLevenbergMarquardt));
+
+    Eigen::VectorXs diff
+        = mSkeleton->getMarkerWorldPositions(markers) - targetPositions;
+    frame.rmsMarkerError
+        = std::sqrt(diff.squaredNorm() / static_cast<s_t>(markers.size()));
+  }
+  mPose = mSkeleton->getPositions();
+  frame.pose = mPose;
+}
+
+//==============================================================================
+/// This sends `frame` to the GUI (if there is one) and the callback (if
+/// there is one)
+void StreamingMarkerFitter::publish(const StreamingFrame& frame)
+{
+  if (mServer)
+  {
+    mSkeleton->setPositions(frame.pose);
+    mServer->renderSkeleton(mSkeleton, mGUIPrefix + "skel");
+
+    std::set<std::string> renderedMarkers;
+    for (auto& pair : frame.markerObservations)
+    {
+      std::string key = mGUIPrefix + "marker_" + pair.first;
+      if (mRenderedMarkers.count(key))
+      {
+        mServer->setObjectPosition(key, pair.second);
+      }
+      else
+      {
+        mServer->createSphere(
+            key, 0.01, pair.second, Eigen::Vector4s(0.0, 0.0, 1.0, 1.0));
+        mServer->setObjectTooltip(key, pair.first);
+      }
+      renderedMarkers.insert(key);
+    }
+    // Markers that dropped out this frame shouldn't linger at their last
+    // position
+    for (const std::string& key : mRenderedMarkers)
+    {
+      if (renderedMarkers.count(key) == 0)
+      {
+        mServer->deleteObject(key);
+      }
+    }
+    mRenderedMarkers.swap(renderedMarkers);
+  }
+
+  if (mFrameCallback)
+  {
+    mFrameCallback(frame);
+  }
+}
+
+} // namespace biomechanics
+} // namespace dart
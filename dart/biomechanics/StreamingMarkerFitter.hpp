@@ -0,0 +1,140 @@
+#ifndef DART_BIOMECH_STREAMINGMARKERFITTER_HPP_
+#define DART_BIOMECH_STREAMINGMARKERFITTER_HPP_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/biomechanics/MarkerLabeller.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/MathTypes.hpp"
+#include "dart/server/GUIWebsocketServer.hpp"
+
+namespace dart {
+
+namespace biomechanics {
+
+struct StreamingFrame
+{
+  /// This is the index of the frame in the stream, starting from 0
+  int time;
+  /// This is the fitted pose of the skeleton
+  Eigen::VectorXs pose;
+  /// This is the label given to each point of the input point cloud, or the
+  /// empty string if that point couldn't be labelled
+  std::vector<std::string> pointLabels;
+  /// These are the labelled points that the IK was fit to
+  std::map<std::string, Eigen::Vector3s> markerObservations;
+  /// This is the RMS distance between the observed markers and the fitted
+  /// skeleton's markers
+  s_t rmsMarkerError;
+  /// This is how long labelling and fitting this frame took
+  s_t solveSeconds;
+};
+
+/// This labels markers and fits a skeleton to them one frame at a time, for
+/// live capture. The offline pipelines (MarkerLabeller::labelPointClouds() and
+/// MarkerFitter::runKinematicsPipeline()) need the whole trial, so instead
+/// this expects a skeleton that's already been scaled and had its markers
+/// placed for the subject (for example, by
+/// MarkerFitter::runPrescaledPipeline() on a calibration trial).
+///
+/// Each frame, points get tracked into MarkerTraces. A trace keeps its label
+/// once it has one, and unlabelled traces get labelled by matching them to
+/// the markers on the skeleton at the last fitted pose. Then we run a few IK
+/// steps, warm started from the last pose, so the work per frame is bounded.
+class StreamingMarkerFitter
+{
+public:
+  StreamingMarkerFitter(
+      std::shared_ptr<dynamics::Skeleton> skeleton,
+      dynamics::MarkerMap markers,
+      s_t mergeDistance = 0.01,
+      int mergeFrames = 5);
+
+  /// This sets the furthest an unlabelled point can be from where the
+  /// skeleton predicts a marker to be, and still get that marker's label.
+  /// Labelled points that end up further than this from their marker after
+  /// IK lose their label, so they can be labelled again on the next frame.
+  void setLabelDistance(s_t distance);
+
+  /// This caps the number of IK steps we take each frame, which bounds the
+  /// per-frame latency
+  void setMaxIKStepsPerFrame(int steps);
+
+  /// If true, the per-frame IK takes sparse Levenberg-Marquardt steps. This
+  /// is on by default, since it converges in far fewer steps from a warm
+  /// start.
+  void setUseLevenbergMarquardt(bool useLevenbergMarquardt);
+
+  /// If this is set, every frame gets rendered to the GUI, with the skeleton
+  /// and spheres for each labelled marker under `prefix`
+  void setGUIServer(
+      std::shared_ptr<server::GUIWebsocketServer> server,
+      const std::string& prefix = "live_");
+
+  /// This gets called with every frame once it's fit, for passing the
+  /// results on (for example, to the realtime subsystem). It's called on the
+  /// thread that observed the frame, so it should return quickly.
+  void setFrameCallback(std::function<void(const StreamingFrame&)> callback);
+
+  /// This forgets all the traces and labels, and starts the next frame from
+  /// `pose`
+  void reset(const Eigen::VectorXs& pose);
+
+  /// This labels an unlabelled point cloud, fits the skeleton to it, and
+  /// publishes the result
+  StreamingFrame observePointCloud(
+      const std::vector<Eigen::Vector3s>& pointCloud);
+
+  /// This skips labelling, for streams (like a Vicon stream) that already
+  /// label markers, and just fits the skeleton and publishes the result.
+  /// Labels that aren't on the skeleton get ignored.
+  StreamingFrame observeLabelledMarkers(
+      const std::map<std::string, Eigen::Vector3s>& markerObservations);
+
+  /// This returns the last fitted pose
+  const Eigen::VectorXs& getPose() const;
+
+protected:
+  /// This runs warm started IK from mPose against `markerObservations`, and
+  /// fills in the pose and error on `frame`
+  void fitPose(
+      const std::map<std::string, Eigen::Vector3s>& markerObservations,
+      StreamingFrame& frame);
+
+  /// This sends `frame` to the GUI (if there is one) and the callback (if
+  /// there is one)
+  void publish(const StreamingFrame& frame);
+
+  std::shared_ptr<dynamics::Skeleton> mSkeleton;
+  dynamics::MarkerMap mMarkerMap;
+  std::vector<std::string> mMarkerNames;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> mMarkers;
+
+  s_t mMergeDistance;
+  int mMergeFrames;
+  MarkerTraceTracker mTracker;
+  Eigen::VectorXs mPose;
+  int mTime;
+
+  s_t mLabelDistance;
+  int mMaxIKStepsPerFrame;
+  bool mUseLevenbergMarquardt;
+
+  std::shared_ptr<server::GUIWebsocketServer> mServer;
+  std::string mGUIPrefix;
+  std::set<std::string> mRenderedMarkers;
+  std::function<void(const StreamingFrame&)> mFrameCallback;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -0,0 +1,691 @@
+#include "dart/biomechanics/SubjectOnDisk.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define DART_SUBJECT_USE_MMAP
+#endif
+
+#include "dart/common/Console.hpp"
+#include "dart/common/LocalResourceRetriever.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/utils/CompositeResourceRetriever.hpp"
+#include "dart/utils/DartResourceRetriever.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+namespace {
+
+/// The file starts with these 4 bytes, then a uint32 version, a uint32 count
+/// of DOFs, a uint32 count of trials, and a uint64 size of the whole index
+/// (which is padded to 8 bytes). The index holds the *.osim file contents,
+/// the DOF names, the body scales, the marker offsets, and for each trial its
+/// name, timestep, frame count, force plate count and the byte offset of its
+/// first chunk. Strings are a uint64 length followed by the bytes.
+///
+/// Each chunk holds up to FRAMES_PER_CHUNK frames, as consecutive arrays of
+/// doubles: the poses, velocities and accelerations (numDofs per frame), the
+/// GRF forces, centers of pressure and moments (3 per force plate per frame),
+/// and the RMS marker errors (1 per frame). Every chunk but the last one in a
+/// trial is full, so the chunks don't need headers of their own.
+const char SUBJECT_MAGIC[4] = {'N', 'S', 'U', 'B'};
+const uint32_t SUBJECT_VERSION = 1;
+const std::size_t SUBJECT_HEADER_BYTES = 24;
+
+std::size_t alignTo8(std::size_t bytes)
+{
+  return (bytes + 7) & ~static_cast<std::size_t>(7);
+}
+
+template <typename T>
+void writeValue(std::ostream& out, T value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(std::ostream& out, const std::string& value)
+{
+  writeValue<uint64_t>(out, value.size());
+  out.write(value.data(), value.size());
+}
+
+/// This reads values out of the index, and fails (rather than reading past
+/// the end) if the index is truncated
+class IndexReader
+{
+public:
+  IndexReader(const char* data, std::size_t size)
+    : mData(data), mSize(size), mCursor(0)
+  {
+  }
+
+  template <typename T>
+  bool read(T& value)
+  {
+    if (mCursor + sizeof(T) > mSize)
+      return false;
+    std::memcpy(&value, mData + mCursor, sizeof(T));
+    mCursor += sizeof(T);
+    return true;
+  }
+
+  bool readString(std::string& value)
+  {
+    uint64_t length;
+    if (!read(length) || length > mSize - mCursor)
+      return false;
+    value.assign(mData + mCursor, length);
+    mCursor += length;
+    return true;
+  }
+
+private:
+  const char* mData;
+  std::size_t mSize;
+  std::size_t mCursor;
+};
+
+/// This finite differences the columns of `values`, using central differences
+/// everywhere but the ends
+template <typename Difference>
+Eigen::MatrixXs finiteDifference(
+    const Eigen::MatrixXs& values, s_t timestep, Difference difference)
+{
+  Eigen::MatrixXs result = Eigen::MatrixXs::Zero(values.rows(), values.cols());
+  if (values.cols() < 2)
+    return result;
+  for (int t = 0; t < values.cols(); t++)
+  {
+    int prev = std::max(t - 1, 0);
+    int next = std::min(t + 1, (int)values.cols() - 1);
+    result.col(t) = difference(values.col(next), values.col(prev))
+                    / ((next - prev) * timestep);
+  }
+  return result;
+}
+
+} // namespace
+
+//==============================================================================
+/// The bytes of a subject file, either memory-mapped or, where we can't map
+/// files, read into memory we own
+struct SubjectOnDisk::MappedFile
+{
+  MappedFile() : mapped(nullptr), size(0)
+  {
+  }
+
+  ~MappedFile()
+  {
+#ifdef DART_SUBJECT_USE_MMAP
+    if (mapped != nullptr)
+      munmap(mapped, size);
+#endif
+  }
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  const char* data() const
+  {
+    return mapped != nullptr ? static_cast<const char*>(mapped)
+                             : reinterpret_cast<const char*>(owned.data());
+  }
+
+  static std::shared_ptr<MappedFile> open(const std::string& path)
+  {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+      return nullptr;
+
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    file->size = info.st_size;
+    if (file->size == 0)
+      return file;
+#ifdef DART_SUBJECT_USE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return nullptr;
+    void* mapped = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (mapped == MAP_FAILED)
+      return nullptr;
+    file->mapped = mapped;
+#else
+    // Doubles, so the chunks inside stay aligned
+    file->owned.resize((file->size + 7) / 8);
+    std::ifstream in(path, std::ios::binary);
+    if (!in.read(reinterpret_cast<char*>(file->owned.data()), file->size))
+      return nullptr;
+#endif
+    return file;
+  }
+
+  void* mapped;
+  std::vector<double> owned;
+  std::size_t size;
+};
+
+//==============================================================================
+SubjectOnDisk::SubjectOnDisk()
+{
+}
+
+//==============================================================================
+SubjectOnDisk::~SubjectOnDisk()
+{
+}
+
+//==============================================================================
+/// This writes a subject to `outputPath`, in native byte order. The
+/// skeleton is the one in the *.osim file at `osimUri`, before scaling, and
+/// `bodyScales` and `markerOffsets` are what we fit for it (laid out like
+/// Skeleton::getBodyScales() and MarkerInitialization::markerOffsets). This
+/// returns false if the file can't be written, or if the trials don't match
+/// the skeleton.
+bool SubjectOnDisk::writeSubject(
+    const std::string& outputPath,
+    const common::Uri& osimUri,
+    const Eigen::VectorXs& bodyScales,
+    const std::map<std::string, Eigen::Vector3s>& markerOffsets,
+    const std::vector<SubjectOnDiskTrial>& trials,
+    const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  common::ResourceRetrieverPtr retriever = nullOrRetriever;
+  if (!retriever)
+  {
+    auto composite = std::make_shared<utils::CompositeResourceRetriever>();
+    composite->addSchemaRetriever(
+        "file", std::make_shared<common::LocalResourceRetriever>());
+    composite->addSchemaRetriever(
+        "dart", utils::DartResourceRetriever::create());
+    retriever = composite;
+  }
+  std::string osimFileContents = retriever->readAll(osimUri);
+  OpenSimFile osim = OpenSimParser::parseOsim(osimUri, retriever);
+  if (osim.skeleton == nullptr)
+  {
+    dterr << "[SubjectOnDisk::writeSubject] Couldn't parse "
+          << osimUri.toString() << ".\n";
+    return false;
+  }
+  std::shared_ptr<dynamics::Skeleton> skel = osim.skeleton;
+  const int numDofs = skel->getNumDofs();
+
+  // Fill in anything the caller left out, and make sure everything else lines
+  // up, before we write a single byte
+  std::vector<SubjectOnDiskTrial> filled = trials;
+  for (SubjectOnDiskTrial& trial : filled)
+  {
+    const int numFrames = trial.poses.cols();
+    if (trial.poses.rows() != numDofs)
+    {
+      dterr << "[SubjectOnDisk::writeSubject] Trial " << trial.name << " has "
+            << trial.poses.rows() << " DOFs, but the skeleton has " << numDofs
+            << ".\n";
+      return false;
+    }
+    if (trial.velocities.size() == 0)
+    {
+      trial.velocities = finiteDifference(
+          trial.poses,
+          trial.timestep,
+          [&](const Eigen::VectorXs& next, const Eigen::VectorXs& prev) {
+            return skel->getPositionDifferences(next, prev);
+          });
+    }
+    if (trial.accelerations.size() == 0)
+    {
+      trial.accelerations = finiteDifference(
+          trial.velocities,
+          trial.timestep,
+          [](const Eigen::VectorXs& next, const Eigen::VectorXs& prev) {
+            return Eigen::VectorXs(next - prev);
+          });
+    }
+    if (trial.markerRMSErrors.size() == 0)
+    {
+      trial.markerRMSErrors = Eigen::VectorXs::Constant(
+          numFrames, std::numeric_limits<double>::quiet_NaN());
+    }
+    bool plateLengthsMatch = true;
+    for (const ForcePlate& plate : trial.forcePlates)
+    {
+      plateLengthsMatch = plateLengthsMatch && plate.forces.size() == numFrames
+                          && plate.centersOfPressure.size() == numFrames
+                          && plate.moments.size() == numFrames;
+    }
+    if (trial.velocities.rows() != numDofs
+        || trial.velocities.cols() != numFrames
+        || trial.accelerations.rows() != numDofs
+        || trial.accelerations.cols() != numFrames
+        || trial.markerRMSErrors.size() != numFrames || !plateLengthsMatch)
+    {
+      dterr << "[SubjectOnDisk::writeSubject] Trial " << trial.name
+            << " doesn't have the same number of frames of every kind of "
+               "data.\n";
+      return false;
+    }
+  }
+
+  // Write the index. The trial offsets depend on the size of the index, but
+  // the size of the index doesn't depend on the offsets, so we write it once
+  // with placeholders and patch the offsets in afterwards.
+  std::ostringstream index;
+  index.write(SUBJECT_MAGIC, 4);
+  writeValue<uint32_t>(index, SUBJECT_VERSION);
+  writeValue<uint32_t>(index, numDofs);
+  writeValue<uint32_t>(index, filled.size());
+  writeValue<uint64_t>(index, 0);
+  writeString(index, osimFileContents);
+  for (int i = 0; i < numDofs; i++)
+  {
+    writeString(index, skel->getDof(i)->getName());
+  }
+  writeValue<uint64_t>(index, bodyScales.size());
+  for (int i = 0; i < bodyScales.size(); i++)
+  {
+    writeValue<double>(index, static_cast<double>(bodyScales(i)));
+  }
+  writeValue<uint64_t>(index, markerOffsets.size());
+  for (auto& pair : markerOffsets)
+  {
+    writeString(index, pair.first);
+    for (int i = 0; i < 3; i++)
+    {
+      writeValue<double>(index, static_cast<double>(pair.second(i)));
+    }
+  }
+  std::vector<std::size_t> offsetPositions;
+  for (const SubjectOnDiskTrial& trial : filled)
+  {
+    writeString(index, trial.name);
+    writeValue<double>(index, static_cast<double>(trial.timestep));
+    writeValue<uint32_t>(index, trial.poses.cols());
+    writeValue<uint32_t>(index, trial.forcePlates.size());
+    offsetPositions.push_back(index.tellp());
+    writeValue<uint64_t>(index, 0);
+  }
+  std::string indexBytes = index.str();
+  indexBytes.resize(alignTo8(indexBytes.size()), '\0');
+
+  uint64_t indexSize = indexBytes.size();
+  std::memcpy(&indexBytes[16], &indexSize, 8);
+  uint64_t offset = indexSize;
+  for (int i = 0; i < filled.size(); i++)
+  {
+    std::memcpy(&indexBytes[offsetPositions[i]], &offset, 8);
+    offset += sizeof(double) * filled[i].poses.cols()
+              * getFrameDoubles(numDofs, filled[i].forcePlates.size());
+  }
+
+  // Write to a temporary file and rename it over `outputPath`, so that anybody
+  // who has `outputPath` mapped keeps seeing the old contents
+  std::string tempPath = outputPath + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+      dterr << "[SubjectOnDisk::writeSubject] Couldn't open " << tempPath
+            << " for writing.\n";
+      return false;
+    }
+    out.write(indexBytes.data(), indexBytes.size());
+
+    std::vector<double> chunk;
+    for (const SubjectOnDiskTrial& trial : filled)
+    {
+      const int numFrames = trial.poses.cols();
+      const int numPlates = trial.forcePlates.size();
+      for (int start = 0; start < numFrames; start += FRAMES_PER_CHUNK)
+      {
+        const int n = std::min(FRAMES_PER_CHUNK, numFrames - start);
+        chunk.clear();
+        chunk.reserve(n * getFrameDoubles(numDofs, numPlates));
+        for (const Eigen::MatrixXs* matrix :
+             {&trial.poses, &trial.velocities, &trial.accelerations})
+        {
+          for (int t = start; t < start + n; t++)
+          {
+            for (int i = 0; i < numDofs; i++)
+            {
+              chunk.push_back(static_cast<double>((*matrix)(i, t)));
+            }
+          }
+        }
+        for (auto member :
+             {&ForcePlate::forces,
+              &ForcePlate::centersOfPressure,
+              &ForcePlate::moments})
+        {
+          for (int t = start; t < start + n; t++)
+          {
+            for (const ForcePlate& plate : trial.forcePlates)
+            {
+              for (int i = 0; i < 3; i++)
+              {
+                chunk.push_back(static_cast<double>((plate.*member)[t](i)));
+              }
+            }
+          }
+        }
+        for (int t = start; t < start + n; t++)
+        {
+          chunk.push_back(static_cast<double>(trial.markerRMSErrors(t)));
+        }
+        out.write(
+            reinterpret_cast<const char*>(chunk.data()),
+            sizeof(double) * chunk.size());
+      }
+    }
+    if (!out)
+    {
+      dterr << "[SubjectOnDisk::writeSubject] Failed writing " << tempPath
+            << ".\n";
+      return false;
+    }
+  }
+  if (std::rename(tempPath.c_str(), outputPath.c_str()) != 0)
+  {
+    dterr << "[SubjectOnDisk::writeSubject] Couldn't move " << tempPath
+          << " to " << outputPath << ".\n";
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+/// This opens a file written by writeSubject(), and just reads the index.
+/// This returns nullptr if the file can't be read.
+std::shared_ptr<SubjectOnDisk> SubjectOnDisk::load(const std::string& path)
+{
+  std::shared_ptr<MappedFile> file = MappedFile::open(path);
+  if (!file || file->size < SUBJECT_HEADER_BYTES
+      || std::memcmp(file->data(), SUBJECT_MAGIC, 4) != 0)
+  {
+    dterr << "[SubjectOnDisk::load] " << path
+          << " isn't a subject written by SubjectOnDisk::writeSubject().\n";
+    return nullptr;
+  }
+
+  const char* data = file->data();
+  uint32_t version;
+  uint32_t numDofs;
+  uint32_t numTrials;
+  uint64_t indexSize;
+  std::memcpy(&version, data + 4, 4);
+  std::memcpy(&numDofs, data + 8, 4);
+  std::memcpy(&numTrials, data + 12, 4);
+  std::memcpy(&indexSize, data + 16, 8);
+  if (version != SUBJECT_VERSION || indexSize < SUBJECT_HEADER_BYTES
+      || indexSize > file->size)
+  {
+    dterr << "[SubjectOnDisk::load] " << path
+          << " has an unsupported version or a truncated index.\n";
+    return nullptr;
+  }
+
+  std::shared_ptr<SubjectOnDisk> subject(new SubjectOnDisk());
+  subject->mFile = file;
+  // Only read up to the end of the index, so a bad length can't send us off
+  // into the chunks
+  IndexReader reader(
+      data + SUBJECT_HEADER_BYTES, indexSize - SUBJECT_HEADER_BYTES);
+  bool ok = reader.readString(subject->mOsimFileContents);
+  subject->mDofNames.resize(numDofs);
+  for (int i = 0; ok && i < numDofs; i++)
+  {
+    ok = reader.readString(subject->mDofNames[i]);
+  }
+  uint64_t numScales = 0;
+  ok = ok && reader.read(numScales) && numScales <= indexSize / 8;
+  if (ok)
+  {
+    subject->mBodyScales.resize(numScales);
+  }
+  for (int i = 0; ok && i < numScales; i++)
+  {
+    double scale;
+    ok = reader.read(scale);
+    subject->mBodyScales(i) = scale;
+  }
+  uint64_t numOffsets = 0;
+  ok = ok && reader.read(numOffsets);
+  for (int i = 0; ok && i < numOffsets; i++)
+  {
+    std::string name;
+    double offset[3];
+    ok = reader.readString(name) && reader.read(offset);
+    subject->mMarkerOffsets[name] = Eigen::Vector3s(
+        static_cast<s_t>(offset[0]),
+        static_cast<s_t>(offset[1]),
+        static_cast<s_t>(offset[2]));
+  }
+  for (int i = 0; ok && i < numTrials; i++)
+  {
+    Trial trial;
+    double timestep;
+    uint32_t numFrames;
+    uint32_t numPlates;
+    uint64_t offset;
+    ok = reader.readString(trial.name) && reader.read(timestep)
+         && reader.read(numFrames) && reader.read(numPlates)
+         && reader.read(offset);
+    trial.timestep = timestep;
+    trial.numFrames = numFrames;
+    trial.numForcePlates = numPlates;
+    trial.offset = offset;
+    ok = ok && offset % 8 == 0
+         && offset + sizeof(double) * numFrames
+                         * getFrameDoubles(numDofs, numPlates)
+                <= file->size;
+    subject->mTrials.push_back(trial);
+  }
+  if (!ok)
+  {
+    dterr << "[SubjectOnDisk::load] " << path << " has a malformed index.\n";
+    return nullptr;
+  }
+  return subject;
+}
+
+//==============================================================================
+/// This parses the stored *.osim file, and returns the skeleton with our
+/// body scales applied and the markers with our offsets applied. Meshes
+/// aren't stored, so the skeleton won't have any.
+OpenSimFile SubjectOnDisk::readOpenSimFile() const
+{
+  OpenSimFile file;
+  file.skeleton = nullptr;
+
+  // The parser reads from a URI, so put the model somewhere it can find it
+  char path[] = "/tmp/nimble_subject_XXXXXX.osim";
+  int fd = mkstemps(path, 5);
+  if (fd == -1)
+  {
+    dterr << "[SubjectOnDisk::readOpenSimFile] Couldn't create a temporary "
+             "*.osim file.\n";
+    return file;
+  }
+  bool wroteAll = write(fd, mOsimFileContents.data(), mOsimFileContents.size())
+                  == (ssize_t)mOsimFileContents.size();
+  close(fd);
+  if (wroteAll)
+  {
+    file = OpenSimParser::parseOsimUncached(common::Uri::createFromPath(path));
+  }
+  std::remove(path);
+  if (file.skeleton == nullptr)
+  {
+    dterr << "[SubjectOnDisk::readOpenSimFile] Couldn't parse the stored "
+             "*.osim file.\n";
+    return file;
+  }
+
+  if (mBodyScales.size() == file.skeleton->getNumBodyNodes() * 3)
+  {
+    file.skeleton->setBodyScales(mBodyScales);
+  }
+  for (auto& pair : mMarkerOffsets)
+  {
+    auto marker = file.markersMap.find(pair.first);
+    if (marker != file.markersMap.end())
+    {
+      marker->second.second += pair.second;
+    }
+  }
+  return file;
+}
+
+//==============================================================================
+/// This returns the raw contents of the unscaled *.osim file
+const std::string& SubjectOnDisk::getOsimFileContents() const
+{
+  return mOsimFileContents;
+}
+
+//==============================================================================
+int SubjectOnDisk::getNumDofs() const
+{
+  return mDofNames.size();
+}
+
+//==============================================================================
+const std::vector<std::string>& SubjectOnDisk::getDofNames() const
+{
+  return mDofNames;
+}
+
+//==============================================================================
+const Eigen::VectorXs& SubjectOnDisk::getBodyScales() const
+{
+  return mBodyScales;
+}
+
+//==============================================================================
+const std::map<std::string, Eigen::Vector3s>& SubjectOnDisk::getMarkerOffsets()
+    const
+{
+  return mMarkerOffsets;
+}
+
+//==============================================================================
+int SubjectOnDisk::getNumTrials() const
+{
+  return mTrials.size();
+}
+
+//==============================================================================
+const std::string& SubjectOnDisk::getTrialName(int trial) const
+{
+  return mTrials[trial].name;
+}
+
+//==============================================================================
+s_t SubjectOnDisk::getTrialTimestep(int trial) const
+{
+  return mTrials[trial].timestep;
+}
+
+//==============================================================================
+int SubjectOnDisk::getTrialLength(int trial) const
+{
+  return mTrials[trial].numFrames;
+}
+
+//==============================================================================
+int SubjectOnDisk::getTrialNumForcePlates(int trial) const
+{
+  return mTrials[trial].numForcePlates;
+}
+
+//==============================================================================
+/// This reads `numFrames` frames of `trial`, starting at `startFrame`. The
+/// window gets clipped to the end of the trial.
+SubjectOnDiskFrames SubjectOnDisk::readFrames(
+    int trial, int startFrame, int numFrames) const
+{
+  const Trial& info = mTrials[trial];
+  const int numDofs = getNumDofs();
+  const int numPlateRows = 3 * info.numForcePlates;
+  startFrame = std::max(0, std::min(startFrame, info.numFrames));
+  numFrames = std::max(0, std::min(numFrames, info.numFrames - startFrame));
+
+  SubjectOnDiskFrames frames;
+  frames.startFrame = startFrame;
+  frames.poses.resize(numDofs, numFrames);
+  frames.velocities.resize(numDofs, numFrames);
+  frames.accelerations.resize(numDofs, numFrames);
+  frames.grfForces.resize(numPlateRows, numFrames);
+  frames.grfCentersOfPressure.resize(numPlateRows, numFrames);
+  frames.grfMoments.resize(numPlateRows, numFrames);
+  frames.markerRMSErrors.resize(numFrames);
+
+  const std::size_t frameDoubles
+      = getFrameDoubles(numDofs, info.numForcePlates);
+  int copied = 0;
+  while (copied < numFrames)
+  {
+    const int frame = startFrame + copied;
+    const int chunkIndex = frame / FRAMES_PER_CHUNK;
+    const int chunkStart = chunkIndex * FRAMES_PER_CHUNK;
+    const int chunkFrames
+        = std::min(FRAMES_PER_CHUNK, info.numFrames - chunkStart);
+    const int inChunk = frame - chunkStart;
+    const int n = std::min(chunkFrames - inChunk, numFrames - copied);
+
+    const double* chunk = reinterpret_cast<const double*>(
+        mFile->data() + info.offset
+        + sizeof(double) * chunkStart * frameDoubles);
+    // Each array in the chunk is laid out column-major, one column per frame
+    const double* cursor = chunk;
+    for (Eigen::MatrixXs* matrix :
+         {&frames.poses, &frames.velocities, &frames.accelerations})
+    {
+      matrix->block(0, copied, numDofs, n)
+          = Eigen::Map<const Eigen::MatrixXd>(
+                cursor + inChunk * numDofs, numDofs, n)
+                .cast<s_t>();
+      cursor += static_cast<std::size_t>(chunkFrames) * numDofs;
+    }
+    for (Eigen::MatrixXs* matrix :
+         {&frames.grfForces, &frames.grfCentersOfPressure, &frames.grfMoments})
+    {
+      matrix->block(0, copied, numPlateRows, n)
+          = Eigen::Map<const Eigen::MatrixXd>(
+                cursor + inChunk * numPlateRows, numPlateRows, n)
+                .cast<s_t>();
+      cursor += static_cast<std::size_t>(chunkFrames) * numPlateRows;
+    }
+    frames.markerRMSErrors.segment(copied, n)
+        = Eigen::Map<const Eigen::VectorXd>(cursor + inChunk, n).cast<s_t>();
+
+    copied += n;
+  }
+  return frames;
+}
+
+//==============================================================================
+/// This returns the number of doubles we store for each frame of a trial
+/// with `numForcePlates` force plates
+std::size_t SubjectOnDisk::getFrameDoubles(int numDofs, int numForcePlates)
+{
+  return 3 * static_cast<std::size_t>(numDofs) + 9 * numForcePlates + 1;
+}
+
+} // namespace biomechanics
+} // namespace dart
@@ -0,0 +1,156 @@
+#ifndef DART_BIOMECH_SUBJECTONDISK_HPP_
+#define DART_BIOMECH_SUBJECTONDISK_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/common/Uri.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace biomechanics {
+
+/// This is one trial of a processed subject, as it gets passed to
+/// SubjectOnDisk::writeSubject()
+struct SubjectOnDiskTrial
+{
+  std::string name;
+  s_t timestep;
+  /// One column per frame
+  Eigen::MatrixXs poses;
+  /// One column per frame. If this is empty, it gets finite differenced from
+  /// the poses.
+  Eigen::MatrixXs velocities;
+  /// One column per frame. If this is empty, it gets finite differenced from
+  /// the velocities.
+  Eigen::MatrixXs accelerations;
+  /// Each force plate needs one force, center of pressure and moment per
+  /// frame. Corners and origins don't get saved.
+  std::vector<ForcePlate> forcePlates;
+  /// The RMS marker error on each frame. If this is empty, it's saved as NaN.
+  Eigen::VectorXs markerRMSErrors;
+};
+
+/// This is a window of frames read back out of a SubjectOnDisk
+struct SubjectOnDiskFrames
+{
+  int startFrame;
+  /// One column per frame, for each of these
+  Eigen::MatrixXs poses;
+  Eigen::MatrixXs velocities;
+  Eigen::MatrixXs accelerations;
+  /// Each of these has 3 rows per force plate, and one column per frame
+  Eigen::MatrixXs grfForces;
+  Eigen::MatrixXs grfCentersOfPressure;
+  Eigen::MatrixXs grfMoments;
+  Eigen::VectorXs markerRMSErrors;
+};
+
+/// This is a single binary file holding everything we know about a processed
+/// subject: the unscaled *.osim model, the body scales and marker offsets we
+/// fit, and the poses, velocities, accelerations, ground reaction forces and
+/// marker errors of every trial. It replaces the pile of *.mot, *.trc and
+/// *.xml files we'd otherwise write out per subject, which are slow to parse
+/// over and over when training models on the results.
+///
+/// The file is memory-mapped where the platform supports it, and each trial's
+/// frames are stored in chunks of FRAMES_PER_CHUNK, with each kind of data in
+/// its own contiguous array within a chunk. That means reading any window of
+/// any trial only pages in the chunks that window overlaps, and nothing gets
+/// parsed except the small index at the start of the file.
+class SubjectOnDisk
+{
+public:
+  /// Number of frames in each chunk
+  static constexpr int FRAMES_PER_CHUNK = 256;
+
+  ~SubjectOnDisk();
+
+  /// This writes a subject to `outputPath`, in native byte order. The
+  /// skeleton is the one in the *.osim file at `osimUri`, before scaling, and
+  /// `bodyScales` and `markerOffsets` are what we fit for it (laid out like
+  /// Skeleton::getBodyScales() and MarkerInitialization::markerOffsets). This
+  /// returns false if the file can't be written, or if the trials don't match
+  /// the skeleton.
+  static bool writeSubject(
+      const std::string& outputPath,
+      const common::Uri& osimUri,
+      const Eigen::VectorXs& bodyScales,
+      const std::map<std::string, Eigen::Vector3s>& markerOffsets,
+      const std::vector<SubjectOnDiskTrial>& trials,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This opens a file written by writeSubject(), and just reads the index.
+  /// This returns nullptr if the file can't be read.
+  static std::shared_ptr<SubjectOnDisk> load(const std::string& path);
+
+  /// This parses the stored *.osim file, and returns the skeleton with our
+  /// body scales applied and the markers with our offsets applied. Meshes
+  /// aren't stored, so the skeleton won't have any.
+  OpenSimFile readOpenSimFile() const;
+
+  /// This returns the raw contents of the unscaled *.osim file
+  const std::string& getOsimFileContents() const;
+
+  int getNumDofs() const;
+
+  const std::vector<std::string>& getDofNames() const;
+
+  const Eigen::VectorXs& getBodyScales() const;
+
+  const std::map<std::string, Eigen::Vector3s>& getMarkerOffsets() const;
+
+  int getNumTrials() const;
+
+  const std::string& getTrialName(int trial) const;
+
+  s_t getTrialTimestep(int trial) const;
+
+  int getTrialLength(int trial) const;
+
+  int getTrialNumForcePlates(int trial) const;
+
+  /// This reads `numFrames` frames of `trial`, starting at `startFrame`. The
+  /// window gets clipped to the end of the trial.
+  SubjectOnDiskFrames readFrames(
+      int trial, int startFrame, int numFrames) const;
+
+private:
+  struct MappedFile;
+
+  struct Trial
+  {
+    std::string name;
+    s_t timestep;
+    int numFrames;
+    int numForcePlates;
+    /// The byte offset of the trial's first chunk in mFile
+    std::size_t offset;
+  };
+
+  SubjectOnDisk();
+
+  /// This returns the number of doubles we store for each frame of a trial
+  /// with `numForcePlates` force plates
+  static std::size_t getFrameDoubles(int numDofs, int numForcePlates);
+
+  std::shared_ptr<MappedFile> mFile;
+  std::string mOsimFileContents;
+  std::vector<std::string> mDofNames;
+  Eigen::VectorXs mBodyScales;
+  std::map<std::string, Eigen::Vector3s> mMarkerOffsets;
+  std::vector<Trial> mTrials;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
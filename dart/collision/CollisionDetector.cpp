@@ -69,6 +69,32 @@ bool CollisionDetector::raycast(
   return false;
 }
 
+//==============================================================================
+RaycastBatchResult CollisionDetector::raycastBatch(
+    CollisionGroup* group,
+    const Eigen::MatrixXs& origins,
+    const Eigen::MatrixXs& directions,
+    int /*numThreads*/)
+{
+  assert(origins.cols() == directions.cols());
+  RaycastBatchResult batch(origins.cols());
+  RaycastOption option(false, true);
+  RaycastResult result;
+  for (int i = 0; i < origins.cols(); i++)
+  {
+    const Eigen::Vector3s from = origins.col(i);
+    const Eigen::Vector3s to = from + directions.col(i);
+    result.clear();
+    if (!raycast(group, from, to, option, &result) || !result.hasHit())
+      continue;
+    const RayHit& hit = result.mRayHits[0];
+    batch.mDistances(i) = hit.mFraction * directions.col(i).norm();
+    batch.mNormals.col(i) = hit.mNormal;
+    batch.mCollisionObjects[i] = hit.mCollisionObject;
+  }
+  return batch;
+}
+
 //==============================================================================
 std::shared_ptr<CollisionObject> CollisionDetector::claimCollisionObject(
     const dynamics::ShapeFrame* shapeFrame)
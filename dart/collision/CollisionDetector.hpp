@@ -173,6 +173,23 @@ public:
       const RaycastOption& option = RaycastOption(),
       RaycastResult* result = nullptr);
 
+  /// Performs many raycasts to a collision group at once, keeping only the
+  /// closest hit of each ray.
+  ///
+  /// \param[in] group The collision group the rays will be casted onto.
+  /// \param[in] origins A 3xN matrix of ray start points in world coordinates.
+  /// \param[in] directions A 3xN matrix of ray displacements: ray i runs from
+  /// origins.col(i) to origins.col(i) + directions.col(i).
+  /// \param[in] numThreads How many threads to split the rays over, or <= 0 to
+  /// use every thread in the global pool. Detectors that don't parallelize
+  /// ignore this.
+  /// \return The distance, normal and object of each ray's closest hit.
+  virtual RaycastBatchResult raycastBatch(
+      CollisionGroup* group,
+      const Eigen::MatrixXs& origins,
+      const Eigen::MatrixXs& directions,
+      int numThreads = 0);
+
 protected:
 
   class CollisionObjectManager;
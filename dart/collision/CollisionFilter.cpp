@@ -33,11 +33,57 @@
 #include "dart/collision/CollisionFilter.hpp"
 
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
 #include "dart/collision/CollisionObject.hpp"
 
 namespace dart {
 namespace collision {
 
+//==============================================================================
+CollisionFilterData::CollisionFilterData(const CollisionObject* object)
+  : object(object),
+    bodyNode(nullptr),
+    skeleton(nullptr),
+    indexInSkeleton(0),
+    collisionLayers(1u),
+    collisionMask(0xFFFFFFFFu)
+{
+  if (!object)
+    return;
+
+  const dynamics::ShapeFrame* shapeFrame = object->getShapeFrame();
+  const dynamics::CollisionAspect* aspect = shapeFrame->getCollisionAspect();
+  if (aspect)
+  {
+    collisionLayers = aspect->getCollisionLayers();
+    collisionMask = aspect->getCollisionMask();
+  }
+
+  const dynamics::ShapeNode* shapeNode = shapeFrame->asShapeNode();
+  if (shapeNode)
+  {
+    bodyNode = shapeNode->getBodyNodePtr().get();
+    skeleton = bodyNode->getSkeleton().get();
+    indexInSkeleton = bodyNode->getIndexInSkeleton();
+  }
+}
+
+//==============================================================================
+bool CollisionFilterData::layersExclude(
+    const CollisionFilterData& data1, const CollisionFilterData& data2)
+{
+  return (data1.collisionLayers & data2.collisionMask) == 0u
+         || (data2.collisionLayers & data1.collisionMask) == 0u;
+}
+
+//==============================================================================
+bool CollisionFilter::ignoresCollisionData(
+    const CollisionFilterData& data1, const CollisionFilterData& data2) const
+{
+  return ignoresCollision(data1.object, data2.object);
+}
+
 //==============================================================================
 bool CollisionFilter::needCollision(
     const CollisionObject* object1, const CollisionObject* object2) const
@@ -81,6 +127,19 @@ bool CompositeCollisionFilter::ignoresCollision(
   return false;
 }
 
+//==============================================================================
+bool CompositeCollisionFilter::ignoresCollisionData(
+    const CollisionFilterData& data1, const CollisionFilterData& data2) const
+{
+  for (const auto* filter : mFilters)
+  {
+    if (filter->ignoresCollisionData(data1, data2))
+      return true;
+  }
+
+  return false;
+}
+
 //==============================================================================
 void BodyNodeCollisionFilter::addBodyNodePairToBlackList(
     const dynamics::BodyNode* bodyNode1, const dynamics::BodyNode* bodyNode2)
@@ -106,33 +165,35 @@ bool BodyNodeCollisionFilter::ignoresCollision(
     const collision::CollisionObject* object1,
     const collision::CollisionObject* object2) const
 {
-  if (object1 == object2)
-    return true;
+  return ignoresCollisionData(
+      CollisionFilterData(object1), CollisionFilterData(object2));
+}
 
-  auto shapeNode1 = object1->getShapeFrame()->asShapeNode();
-  auto shapeNode2 = object2->getShapeFrame()->asShapeNode();
+//==============================================================================
+bool BodyNodeCollisionFilter::ignoresCollisionData(
+    const CollisionFilterData& data1, const CollisionFilterData& data2) const
+{
+  if (data1.object == data2.object)
+    return true;
 
   // We don't filter out for non-ShapeNode because this class shouldn't have the
   // authority to make decisions about filtering any ShapeFrames that aren't
   // attached to a BodyNode. So here we just return false. In order to decide
   // whether the non-ShapeNode should be ignored, please use other collision
   // filters.
-  if (!shapeNode1 || !shapeNode2)
+  if (!data1.bodyNode || !data2.bodyNode)
     return false;
 
-  auto bodyNode1 = shapeNode1->getBodyNodePtr();
-  auto bodyNode2 = shapeNode2->getBodyNodePtr();
-
-  if (bodyNode1 == bodyNode2)
+  if (data1.bodyNode == data2.bodyNode)
     return true;
 
-  if (!bodyNode1->isCollidable() || !bodyNode2->isCollidable())
+  if (!data1.bodyNode->isCollidable() || !data2.bodyNode->isCollidable())
     return true;
 
-  const auto& skel1 = bodyNode1->getSkeleton();
-  const auto& skel2 = bodyNode2->getSkeleton();
+  const dynamics::Skeleton* skel1 = data1.skeleton;
+  const dynamics::Skeleton* skel2 = data2.skeleton;
 
-  if ( !skel1->isMobile() && !skel2->isMobile() )
+  if (!skel1->isMobile() && !skel2->isMobile())
     return true;
 
   if (skel1 == skel2)
@@ -140,30 +201,19 @@ bool BodyNodeCollisionFilter::ignoresCollision(
     if (!skel1->isEnabledSelfCollisionCheck())
       return true;
 
-    if (!skel1->isEnabledAdjacentBodyCheck())
-    {
-      if (areAdjacentBodies(bodyNode1, bodyNode2))
-        return true;
-    }
-  }
-
-  if (mBodyNodeBlackList.contains(bodyNode1, bodyNode2))
-    return true;
+    if (!skel1->isEnabledAdjacentBodyCheck()
+        && skel1->areBodyNodesAdjacent(
+            data1.indexInSkeleton, data2.indexInSkeleton))
+      return true;
 
-  return false;
-}
+    if (!skel1->canBodyNodesSelfCollide(
+            data1.indexInSkeleton, data2.indexInSkeleton))
+      return true;
+  }
 
-//==============================================================================
-bool BodyNodeCollisionFilter::areAdjacentBodies(
-    const dynamics::BodyNode* bodyNode1,
-    const dynamics::BodyNode* bodyNode2) const
-{
-  if ((bodyNode1->getParentBodyNode() == bodyNode2)
-      || (bodyNode2->getParentBodyNode() == bodyNode1))
-  {
-    assert(bodyNode1->getSkeleton() == bodyNode2->getSkeleton());
+  if (!mBodyNodeBlackList.empty()
+      && mBodyNodeBlackList.contains(data1.bodyNode, data2.bodyNode))
     return true;
-  }
 
   return false;
 }
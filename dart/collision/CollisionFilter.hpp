@@ -33,6 +33,8 @@
 #ifndef DART_COLLISION_COLLISIONFILTER_HPP_
 #define DART_COLLISION_COLLISIONFILTER_HPP_
 
+#include <cstdint>
+
 #include "dart/collision/detail/UnorderedPairs.hpp"
 #include "dart/common/Deprecated.hpp"
 
@@ -40,12 +42,43 @@ namespace dart {
 
 namespace dynamics {
 class BodyNode;
+class Skeleton;
 } // namespace dynamics
 
 namespace collision {
 
 class CollisionObject;
 
+/// This is what filters need to know about one CollisionObject. Collision
+/// detectors gather it once per object per query, so that testing each
+/// candidate pair doesn't chase (and lock) the same pointers over and over.
+struct CollisionFilterData
+{
+  /// This gathers the data for `object`
+  explicit CollisionFilterData(const CollisionObject* object = nullptr);
+
+  /// Returns true if the collision layers and masks of the two objects rule
+  /// out a collision between them. This is the only check that doesn't
+  /// depend on which filter is in use.
+  static bool layersExclude(
+      const CollisionFilterData& data1, const CollisionFilterData& data2);
+
+  const CollisionObject* object;
+
+  /// The BodyNode the object's ShapeNode is attached to, or nullptr if the
+  /// object isn't a ShapeNode
+  const dynamics::BodyNode* bodyNode;
+
+  /// The Skeleton of bodyNode, and the index of bodyNode in it
+  const dynamics::Skeleton* skeleton;
+  std::size_t indexInSkeleton;
+
+  /// The layers and mask from the object's CollisionAspect, or (1, all) if
+  /// it has none
+  std::uint32_t collisionLayers;
+  std::uint32_t collisionMask;
+};
+
 class CollisionFilter
 {
 public:
@@ -64,6 +97,12 @@ public:
   /// collision detector, false otherwise.
   virtual bool ignoresCollision(
       const CollisionObject* object1, const CollisionObject* object2) const = 0;
+
+  /// This is ignoresCollision() for two objects whose filter data has already
+  /// been gathered. By default this just calls ignoresCollision() on the
+  /// objects, but filters that can decide from the data alone override it.
+  virtual bool ignoresCollisionData(
+      const CollisionFilterData& data1, const CollisionFilterData& data2) const;
 };
 
 class CompositeCollisionFilter : public CollisionFilter
@@ -83,6 +122,11 @@ public:
       const CollisionObject* object1,
       const CollisionObject* object2) const override;
 
+  // Documentation inherited
+  bool ignoresCollisionData(
+      const CollisionFilterData& data1,
+      const CollisionFilterData& data2) const override;
+
 protected:
   /// Collision filters
   std::unordered_set<const CollisionFilter*> mFilters;
@@ -107,13 +151,14 @@ public:
       const CollisionObject* object1,
       const CollisionObject* object2) const override;
 
-private:
-  /// Returns true if the two BodyNodes are adjacent BodyNodes (i.e., the two
-  /// BodyNodes are connected by a Joint).
-  bool areAdjacentBodies(
-      const dynamics::BodyNode* bodyNode1,
-      const dynamics::BodyNode* bodyNode2) const;
+  /// This decides everything from the gathered data: adjacency comes from the
+  /// skeleton's precomputed bitset, and the blacklist is only searched when
+  /// it isn't empty.
+  bool ignoresCollisionData(
+      const CollisionFilterData& data1,
+      const CollisionFilterData& data2) const override;
 
+private:
   /// List of pairs to be ignored in the collision detection.
   detail::UnorderedPairs<dynamics::BodyNode> mBodyNodeBlackList;
 };
@@ -37,6 +37,7 @@
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/CollisionDetector.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 
 namespace dart {
@@ -233,6 +234,19 @@ bool CollisionGroup::raycast(
   return mCollisionDetector->raycast(this, from, to, option, result);
 }
 
+//==============================================================================
+RaycastBatchResult CollisionGroup::raycastBatch(
+    const Eigen::MatrixXs& origins,
+    const Eigen::MatrixXs& directions,
+    int numThreads)
+{
+  if(mUpdateAutomatically)
+    update();
+
+  return mCollisionDetector->raycastBatch(
+      this, origins, directions, numThreads);
+}
+
 //==============================================================================
 void CollisionGroup::setAutomaticUpdate(const bool automatic)
 {
@@ -302,7 +316,14 @@ void CollisionGroup::removeDeletedShapeFrames()
 void CollisionGroup::updateEngineData()
 {
   for (const auto& info : mObjectInfoList)
+  {
+    // Catch up any shapes whose scale change the Skeleton deferred
+    if (const dynamics::ShapeNode* shapeNode = info->mFrame->asShapeNode())
+      const_cast<dynamics::BodyNode*>(shapeNode->getBodyNodePtr().get())
+          ->applyDeferredScale();
+
     info->mObject->updateEngineData();
+  }
 
   updateCollisionGroupEngineData();
 }
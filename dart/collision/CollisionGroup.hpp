@@ -283,6 +283,20 @@ public:
       const RaycastOption& option = RaycastOption(),
       RaycastResult* result = nullptr);
 
+  /// Performs many raycasts to this collision group at once, keeping only the
+  /// closest hit of each ray.
+  ///
+  /// \param[in] origins A 3xN matrix of ray start points in world coordinates.
+  /// \param[in] directions A 3xN matrix of ray displacements: ray i runs from
+  /// origins.col(i) to origins.col(i) + directions.col(i).
+  /// \param[in] numThreads How many threads to split the rays over, or <= 0 to
+  /// use every thread in the global pool.
+  /// \return The distance, normal and object of each ray's closest hit.
+  RaycastBatchResult raycastBatch(
+      const Eigen::MatrixXs& origins,
+      const Eigen::MatrixXs& directions,
+      int numThreads = 0);
+
   /// Set whether this CollisionGroup will automatically check for updates.
   void setAutomaticUpdate(bool automatic = true);
 
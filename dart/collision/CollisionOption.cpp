@@ -42,11 +42,13 @@ CollisionOption::CollisionOption(
     bool enableContact,
     std::size_t maxNumContacts,
     const std::shared_ptr<CollisionFilter>& collisionFilter,
-    s_t contactClippingDepth)
+    s_t contactClippingDepth,
+    s_t speculativeContactDistance)
   : enableContact(enableContact),
     maxNumContacts(maxNumContacts),
     collisionFilter(collisionFilter),
-    contactClippingDepth(contactClippingDepth)
+    contactClippingDepth(contactClippingDepth),
+    speculativeContactDistance(speculativeContactDistance)
 {
   // Do nothing
 }
@@ -63,12 +63,19 @@ struct CollisionOption
   /// CollisionFilter
   std::shared_ptr<CollisionFilter> collisionFilter;
 
+  /// Shapes closer than this distance (but not yet touching) still report a
+  /// contact, with a negative penetration depth equal to minus the gap. This
+  /// is only supported by the sphere-sphere and sphere-box pairs of the DART
+  /// collision detector. Zero (the default) only reports touching shapes.
+  s_t speculativeContactDistance;
+
   /// Constructor
   CollisionOption(
       bool enableContact = true,
       std::size_t maxNumContacts = 1000u,
       const std::shared_ptr<CollisionFilter>& collisionFilter = nullptr,
-      s_t contactClippingDepth = 0.03);
+      s_t contactClippingDepth = 0.03,
+      s_t speculativeContactDistance = 0.0);
 };
 
 } // namespace collision
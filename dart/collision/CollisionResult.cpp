@@ -55,11 +55,13 @@ void CollisionResult::addContact(const Contact& contact)
            "unit test, but this could lead to invalid behavior downstream."
         << std::endl;
   }
-  else
-  {
-    addObject(contact.collisionObject1);
-    addObject(contact.collisionObject2);
-  }
+  mCollidingObjectsDirty = true;
+}
+
+//==============================================================================
+void CollisionResult::reserve(std::size_t numContacts)
+{
+  mContacts.reserve(numContacts);
 }
 
 //==============================================================================
@@ -73,6 +75,8 @@ Contact& CollisionResult::getContact(std::size_t index)
 {
   assert(index < mContacts.size());
 
+  // The caller could change which objects this contact is between
+  mCollidingObjectsDirty = true;
   return mContacts[index];
 }
 
@@ -129,6 +133,7 @@ const std::vector<Contact>& CollisionResult::getContacts() const
 const std::unordered_set<const dynamics::BodyNode*>&
 CollisionResult::getCollidingBodyNodes() const
 {
+  updateCollidingObjects();
   return mCollidingBodyNodes;
 }
 
@@ -136,18 +141,21 @@ CollisionResult::getCollidingBodyNodes() const
 const std::unordered_set<const dynamics::ShapeFrame*>&
 CollisionResult::getCollidingShapeFrames() const
 {
+  updateCollidingObjects();
   return mCollidingShapeFrames;
 }
 
 //==============================================================================
 bool CollisionResult::inCollision(const dynamics::BodyNode* bn) const
 {
+  updateCollidingObjects();
   return (mCollidingBodyNodes.find(bn) != mCollidingBodyNodes.end());
 }
 
 //==============================================================================
 bool CollisionResult::inCollision(const dynamics::ShapeFrame* frame) const
 {
+  updateCollidingObjects();
   return (mCollidingShapeFrames.find(frame) != mCollidingShapeFrames.end());
 }
 
@@ -169,10 +177,32 @@ void CollisionResult::clear()
   mContacts.clear();
   mCollidingShapeFrames.clear();
   mCollidingBodyNodes.clear();
+  mCollidingObjectsDirty = false;
+}
+
+//==============================================================================
+void CollisionResult::updateCollidingObjects() const
+{
+  if (!mCollidingObjectsDirty)
+    return;
+
+  mCollidingShapeFrames.clear();
+  mCollidingBodyNodes.clear();
+  for (const Contact& contact : mContacts)
+  {
+    // addContact() already complained about any nullptr objects
+    if (contact.collisionObject1 == nullptr
+        || contact.collisionObject2 == nullptr)
+      continue;
+
+    addObject(contact.collisionObject1);
+    addObject(contact.collisionObject2);
+  }
+  mCollidingObjectsDirty = false;
 }
 
 //==============================================================================
-void CollisionResult::addObject(CollisionObject* object)
+void CollisionResult::addObject(CollisionObject* object) const
 {
   if (!object)
   {
@@ -49,12 +49,22 @@ class ShapeFrame;
 
 namespace collision {
 
+/// The contacts found by a collision query.
+///
+/// Clearing a CollisionResult keeps the storage it has grown, so reusing one
+/// instance from step to step (as ConstraintSolver does) stops allocating once
+/// it has seen the largest number of contacts. The sets of colliding
+/// BodyNodes and ShapeFrames are only built the first time they're asked for,
+/// so adding contacts never allocates set entries.
 class CollisionResult
 {
 public:
   /// Add one contact
   void addContact(const Contact& contact);
 
+  /// Make room for `numContacts` contacts without reallocating
+  void reserve(std::size_t numContacts);
+
   /// Return number of contacts
   std::size_t getNumContacts() const;
 
@@ -96,16 +106,25 @@ public:
   void clear();
 
 protected:
-  void addObject(CollisionObject* object);
+  void addObject(CollisionObject* object) const;
+
+  /// This rebuilds mCollidingBodyNodes and mCollidingShapeFrames from the
+  /// contacts, if they're out of date
+  void updateCollidingObjects() const;
 
   /// List of contact information for each contact
   std::vector<Contact> mContacts;
 
   /// Set of BodyNodes that are colliding
-  std::unordered_set<const dynamics::BodyNode*> mCollidingBodyNodes;
+  mutable std::unordered_set<const dynamics::BodyNode*> mCollidingBodyNodes;
 
   /// Set of ShapeFrames that are colliding
-  std::unordered_set<const dynamics::ShapeFrame*> mCollidingShapeFrames;
+  mutable std::unordered_set<const dynamics::ShapeFrame*>
+      mCollidingShapeFrames;
+
+  /// True if the contacts have changed since mCollidingBodyNodes and
+  /// mCollidingShapeFrames were last built
+  mutable bool mCollidingObjectsDirty = false;
 };
 
 } // namespace collision
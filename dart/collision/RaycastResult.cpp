@@ -32,6 +32,8 @@
 
 #include "dart/collision/RaycastResult.hpp"
 
+#include <limits>
+
 namespace dart {
 namespace collision {
 
@@ -53,5 +55,21 @@ bool RaycastResult::hasHit() const
   return !mRayHits.empty();
 }
 
+//==============================================================================
+RaycastBatchResult::RaycastBatchResult(int numRays)
+  : mDistances(Eigen::VectorXs::Constant(
+      numRays, std::numeric_limits<s_t>::infinity())),
+    mNormals(Eigen::MatrixXs::Zero(3, numRays)),
+    mCollisionObjects(numRays, nullptr)
+{
+  // Do nothing
+}
+
+//==============================================================================
+bool RaycastBatchResult::hasHit(int i) const
+{
+  return mCollisionObjects[i] != nullptr;
+}
+
 } // namespace collision
 } // namespace dart
@@ -75,6 +75,28 @@ struct RaycastResult
   std::vector<RayHit> mRayHits;
 };
 
+/// This holds the closest hit of each ray in a batch, in contiguous arrays so
+/// that sensor code can read them without walking per-ray hit lists
+struct RaycastBatchResult
+{
+  /// Constructor, for a batch of `numRays` rays that haven't hit anything yet
+  RaycastBatchResult(int numRays = 0);
+
+  /// Returns true if ray i hit something
+  bool hasHit(int i) const;
+
+  /// The distance from each ray's origin to its closest hit, or infinity if
+  /// it missed
+  Eigen::VectorXs mDistances;
+
+  /// Column i is the world-space unit normal at ray i's closest hit, or zero
+  /// if it missed
+  Eigen::MatrixXs mNormals;
+
+  /// The collision object each ray hit first, or nullptr if it missed
+  std::vector<const CollisionObject*> mCollisionObjects;
+};
+
 } // namespace collision
 } // namespace dart
 
@@ -32,19 +32,25 @@
 
 #include "dart/collision/dart/DARTCollide.hpp"
 
+#include <limits>
 #include <memory>
 #include <thread>
 
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/CapsuleShape.hpp"
 #include "dart/dynamics/CylinderShape.hpp"
 #include "dart/dynamics/EllipsoidShape.hpp"
+#include "dart/dynamics/HeightmapShape.hpp"
 #include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/MultiSphereConvexHullShape.hpp"
+#include "dart/dynamics/PointCloudShape.hpp"
 #include "dart/dynamics/SphereShape.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
+#include "dart/math/SphereTree.hpp"
 
 namespace dart {
 namespace collision {
@@ -55,6 +61,15 @@ namespace collision {
 
 #define DART_COLLISION_WITNESS_PLANE_DEPTH 0.01
 #define DART_COLLISION_EPS 1E-6
+// Bounding volumes have to be at least this far apart before we skip GJK, so
+// that MPR's own tolerance can never find a contact that we culled
+#define DART_COLLISION_BOUNDS_MARGIN 1E-3
+
+// GJK stops once a new support point brings it closer by less than this
+// (relative) amount, or the cores get closer than the absolute tolerance
+#define DART_GJK_RELATIVE_TOLERANCE 1E-10
+#define DART_GJK_ABSOLUTE_TOLERANCE 1E-10
+#define DART_GJK_MAX_ITERATIONS 64
 // static const int MAX_CYLBOX_CLIP_POINTS = 16;
 // static const int nCYLINDER_AXIS = 2;
 // Number of segment of cylinder base circle.
@@ -1606,7 +1621,9 @@ int collideBoxSphere(
     return 0;
   }
 
-  if (penetration < 0.0)
+  // A negative penetration is a gap, which we keep only if it's within the
+  // speculative margin
+  if (penetration < -option.speculativeContactDistance)
   {
     return 0;
   }
@@ -1764,7 +1781,9 @@ int collideSphereBox(
   if (penetration > option.contactClippingDepth)
     return 0;
 
-  if (penetration < 0.0)
+  // A negative penetration is a gap, which we keep only if it's within the
+  // speculative margin
+  if (penetration < -option.speculativeContactDistance)
   {
     return 0;
   }
@@ -1825,7 +1844,8 @@ int collideSphereSphere(
   Eigen::Vector3s normal = c0.translation() - c1.translation();
   s_t normal_sqr = normal.squaredNorm();
 
-  if (normal_sqr > rsum * rsum)
+  s_t maxDist = rsum + option.speculativeContactDistance;
+  if (normal_sqr > maxDist * maxDist)
   {
     return 0;
   }
@@ -1948,20 +1968,34 @@ void ccdSupportMesh(const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out)
   s_t maxDot = -std::numeric_limits<s_t>::infinity();
   Eigen::Vector3s maxDotPoint = Eigen::Vector3s::Zero();
 
-  for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
+  if (mesh->hull != nullptr)
   {
-    aiMesh* m = mesh->mesh->mMeshes[i];
-    for (int k = 0; k < m->mNumVertices; k++)
+    // The furthest vertex is always on the hull, and successive queries from
+    // GJK / MPR are close together, so this is usually a couple hops
+    int support = mesh->hull->findSupport(localDir, mesh->supportHint);
+    if (support != -1)
+    {
+      mesh->supportHint = support;
+      maxDotPoint = mesh->hull->getVertices()[support];
+    }
+  }
+  else
+  {
+    for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
     {
-      s_t dot = m->mVertices[k].x * localDir(0)
-                + m->mVertices[k].y * localDir(1)
-                + m->mVertices[k].z * localDir(2);
-      if (dot > maxDot)
+      aiMesh* m = mesh->mesh->mMeshes[i];
+      for (int k = 0; k < m->mNumVertices; k++)
       {
-        maxDot = dot;
-        maxDotPoint(0) = m->mVertices[k].x;
-        maxDotPoint(1) = m->mVertices[k].y;
-        maxDotPoint(2) = m->mVertices[k].z;
+        s_t dot = m->mVertices[k].x * localDir(0)
+                  + m->mVertices[k].y * localDir(1)
+                  + m->mVertices[k].z * localDir(2);
+        if (dot > maxDot)
+        {
+          maxDot = dot;
+          maxDotPoint(0) = m->mVertices[k].x;
+          maxDotPoint(1) = m->mVertices[k].y;
+          maxDotPoint(2) = m->mVertices[k].z;
+        }
       }
     }
   }
@@ -2054,6 +2088,61 @@ void ccdCenterCapsule(const void* _obj, ccd_vec3_t* _center)
   _center->v[2] = static_cast<ccd_real_t>(capsule->transform->translation()(2));
 }
 
+/// libccd support function for the convex hull of a set of spheres
+void ccdSupportMultiSphere(
+    const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out)
+{
+  const ccdMultiSphere* hull = (const ccdMultiSphere*)_obj;
+
+  Eigen::Vector3s dir;
+  dir(0) = static_cast<s_t>(_dir->v[0]);
+  dir(1) = static_cast<s_t>(_dir->v[1]);
+  dir(2) = static_cast<s_t>(_dir->v[2]);
+
+  // apply rotation on direction vector
+  Eigen::Vector3s localDir = hull->transform->linear().transpose() * dir;
+  const s_t norm = localDir.norm();
+  if (norm > 0)
+    localDir /= norm;
+
+  // The support point of the hull is the support point of whichever sphere
+  // reaches furthest along the direction
+  Eigen::Vector3s best = Eigen::Vector3s::Zero();
+  s_t bestDot = -std::numeric_limits<s_t>::infinity();
+  for (const auto& sphere : *hull->spheres)
+  {
+    s_t dot = sphere.second.dot(localDir) + sphere.first;
+    if (dot > bestDot)
+    {
+      bestDot = dot;
+      best = sphere.second + sphere.first * localDir;
+    }
+  }
+
+  // transform support point according to position and rotation of object
+  Eigen::Vector3s out = *(hull->transform) * best;
+  _out->v[0] = static_cast<ccd_real_t>(out(0));
+  _out->v[1] = static_cast<ccd_real_t>(out(1));
+  _out->v[2] = static_cast<ccd_real_t>(out(2));
+}
+
+/// libccd center function for the convex hull of a set of spheres
+void ccdCenterMultiSphere(const void* _obj, ccd_vec3_t* _center)
+{
+  const ccdMultiSphere* hull = (const ccdMultiSphere*)_obj;
+  Eigen::Vector3s center = Eigen::Vector3s::Zero();
+  for (const auto& sphere : *hull->spheres)
+  {
+    center += sphere.second;
+  }
+  if (!hull->spheres->empty())
+    center /= hull->spheres->size();
+  center = *(hull->transform) * center;
+  _center->v[0] = static_cast<ccd_real_t>(center(0));
+  _center->v[1] = static_cast<ccd_real_t>(center(1));
+  _center->v[2] = static_cast<ccd_real_t>(center(2));
+}
+
 /// Find all the vertices within epsilon of lying on the witness plane
 std::vector<Eigen::Vector3s> ccdPointsAtWitnessBox(
     ccdBox* box, ccd_vec3_t* _dir, bool neg)
@@ -2133,20 +2222,78 @@ std::vector<Eigen::Vector3s> ccdPointsAtWitnessMesh(
   s_t maxDot = (neg ? 1 : -1) * std::numeric_limits<s_t>::infinity();
 
   // 1. Find the max dot
-  for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
+  if (mesh->hull != nullptr && !mesh->hull->getVertices().empty())
+  {
+    Eigen::Vector3s witnessDir
+        = localDir.cwiseProduct(*mesh->scale).cwiseProduct(*mesh->scale);
+    int support = mesh->hull->findSupport(
+        neg ? Eigen::Vector3s(-witnessDir) : witnessDir, mesh->supportHint);
+    maxDot = witnessDir.dot(mesh->hull->getVertices()[support]);
+
+    // On a convex mesh, the vertices on the witness plane are a connected
+    // patch around the support vertex, so we can walk out to them instead of
+    // scanning the whole mesh. This visits them in the same order as the scan
+    // below, so it finds exactly the same points.
+    const math::MeshAdjacency* adjacency = mesh->hull->getMeshAdjacency();
+    int start = -1;
+    if (adjacency != nullptr && adjacency->isConvex())
+    {
+      start = adjacency->findVertex(mesh->hull->getVertices()[support]);
+    }
+    if (start != -1)
+    {
+      const std::vector<Eigen::Vector3s>& vertices = adjacency->getVertices();
+      const Eigen::Vector3s& scale = *mesh->scale;
+      std::vector<int> patch;
+      adjacency->floodFill(
+          start,
+          [&](int i) {
+            const Eigen::Vector3s& v = vertices[i];
+            s_t dot = v(0) * localDir(0) * scale(0) * scale(0)
+                      + v(1) * localDir(1) * scale(1) * scale(1)
+                      + v(2) * localDir(2) * scale(2) * scale(2);
+            return abs(dot - maxDot) < DART_COLLISION_WITNESS_PLANE_DEPTH;
+          },
+          patch);
+      for (int i : patch)
+      {
+        Eigen::Vector3s proposedPoint
+            = *(mesh->transform) * vertices[i].cwiseProduct(scale);
+        // Welding only merged exact duplicates, so filter out near ones
+        bool foundDuplicate = false;
+        for (int j = 0; j < points.size(); j++)
+        {
+          if ((points[j] - proposedPoint).squaredNorm() < 1e-6)
+          {
+            foundDuplicate = true;
+            break;
+          }
+        }
+        if (!foundDuplicate)
+        {
+          points.push_back(proposedPoint);
+        }
+      }
+      return points;
+    }
+  }
+  else
   {
-    aiMesh* m = mesh->mesh->mMeshes[i];
-    for (int k = 0; k < m->mNumVertices; k++)
+    for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
     {
-      s_t dot = m->mVertices[k].x * localDir(0) * (*mesh->scale)(0)
-                    * (*mesh->scale)(0)
-                + m->mVertices[k].y * localDir(1) * (*mesh->scale)(1)
-                      * (*mesh->scale)(1)
-                + m->mVertices[k].z * localDir(2) * (*mesh->scale)(2)
-                      * (*mesh->scale)(2);
-      if (((dot > maxDot) && !neg) || ((dot < maxDot) && neg))
+      aiMesh* m = mesh->mesh->mMeshes[i];
+      for (int k = 0; k < m->mNumVertices; k++)
       {
-        maxDot = dot;
+        s_t dot = m->mVertices[k].x * localDir(0) * (*mesh->scale)(0)
+                      * (*mesh->scale)(0)
+                  + m->mVertices[k].y * localDir(1) * (*mesh->scale)(1)
+                        * (*mesh->scale)(1)
+                  + m->mVertices[k].z * localDir(2) * (*mesh->scale)(2)
+                        * (*mesh->scale)(2);
+        if (((dot > maxDot) && !neg) || ((dot < maxDot) && neg))
+        {
+          maxDot = dot;
+        }
       }
     }
   }
@@ -2195,6 +2342,44 @@ std::vector<Eigen::Vector3s> ccdPointsAtWitnessMesh(
   return points;
 }
 
+/// Find the points where each sphere that reaches the witness plane touches
+/// it. These play the part of vertices for a multi-sphere hull, so two
+/// spheres resting on a face give an edge, and three or more give a face.
+std::vector<Eigen::Vector3s> ccdPointsAtWitnessMultiSphere(
+    const ccdMultiSphere* hull, ccd_vec3_t* _dir, bool neg)
+{
+  Eigen::Vector3s dir;
+  dir(0) = static_cast<s_t>(_dir->v[0]);
+  dir(1) = static_cast<s_t>(_dir->v[1]);
+  dir(2) = static_cast<s_t>(_dir->v[2]);
+  if (neg)
+    dir = -dir;
+
+  // apply rotation on direction vector
+  Eigen::Vector3s localDir = hull->transform->linear().transpose() * dir;
+  const s_t norm = localDir.norm();
+  if (norm > 0)
+    localDir /= norm;
+
+  s_t maxDot = -std::numeric_limits<s_t>::infinity();
+  for (const auto& sphere : *hull->spheres)
+  {
+    maxDot = std::max(maxDot, sphere.second.dot(localDir) + sphere.first);
+  }
+
+  std::vector<Eigen::Vector3s> points;
+  for (const auto& sphere : *hull->spheres)
+  {
+    if (maxDot - (sphere.second.dot(localDir) + sphere.first)
+        < DART_COLLISION_WITNESS_PLANE_DEPTH)
+    {
+      points.push_back(
+          *(hull->transform) * (sphere.second + sphere.first * localDir));
+    }
+  }
+  return points;
+}
+
 /// This is a helper for creating contacts between a pair of faces, or face-edge
 /// or edge-face pairs. This shows up several times in mesh-mesh collisions, as
 /// well as capsule-mesh collisions, so is factored out as its own method.
@@ -3738,15 +3923,117 @@ inline void setCcdDefaultSettings(ccd_t& ccd)
   ccd.max_iterations = 10000;
 }
 
+namespace {
+
+/// This is the warm-start data CCD keeps between calls for a single pair of
+/// objects. `generation` records which clearCcdCache() epoch last touched it.
+struct CcdWarmStart
+{
+  ccd_vec3_t dir;
+  ccd_vec3_t pos;
+  unsigned long generation;
+};
+
+struct CcdPairHash
+{
+  std::size_t operator()(
+      const std::pair<CollisionObject*, CollisionObject*>& pair) const
+  {
+    std::size_t h1 = std::hash<CollisionObject*>()(pair.first);
+    std::size_t h2 = std::hash<CollisionObject*>()(pair.second);
+    return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
+  }
+};
+
+/// Each thread gets its own cache, so collision checks on cloned worlds in
+/// parallel never touch shared state.
+struct CcdWarmStartCache
+{
+  std::unordered_map<
+      std::pair<CollisionObject*, CollisionObject*>,
+      CcdWarmStart,
+      CcdPairHash>
+      entries;
+  unsigned long generation = 0;
+  // The number of entries stamped with the current generation
+  std::size_t numLive = 0;
+};
+
+/// We won't bother sweeping stale entries until there are at least this many
+static const std::size_t CCD_CACHE_MIN_EVICTION_SIZE = 256;
+
+thread_local CcdWarmStartCache _ccdCache;
+
+/// In deterministic mode every check starts cold from this instead
+thread_local CcdWarmStart _ccdColdStart;
+
+/// This finds (or creates) the warm start for a pair of objects on the
+/// calling thread, resetting it if it's left over from an older generation.
+CcdWarmStart& getCcdWarmStart(CollisionObject* o1, CollisionObject* o2)
+{
+  // Which warm starts a thread has depends on which checks it happened to run
+  // before, so the results can't depend on them in deterministic mode
+  if (common::ThreadPool::isDeterministic())
+  {
+    ccdVec3Set(&_ccdColdStart.dir, 0, 0, 0);
+    ccdVec3Set(&_ccdColdStart.pos, 0, 0, 0);
+    return _ccdColdStart;
+  }
+
+  CcdWarmStartCache& cache = _ccdCache;
+  auto key = std::make_pair(o1, o2);
+  auto it = cache.entries.find(key);
+  if (it != cache.entries.end() && it->second.generation == cache.generation)
+  {
+    return it->second;
+  }
+
+  if (it == cache.entries.end())
+  {
+    // Before growing the map, drop everything that went stale. This can never
+    // invalidate a reference handed out this generation, since those entries
+    // are all live.
+    if (cache.entries.size() >= CCD_CACHE_MIN_EVICTION_SIZE
+        && cache.entries.size() >= 2 * cache.numLive)
+    {
+      for (auto sweep = cache.entries.begin(); sweep != cache.entries.end();)
+      {
+        if (sweep->second.generation != cache.generation)
+          sweep = cache.entries.erase(sweep);
+        else
+          ++sweep;
+      }
+    }
+    it = cache.entries.emplace(key, CcdWarmStart()).first;
+  }
+
+  CcdWarmStart& entry = it->second;
+  ccdVec3Set(&entry.dir, 0, 0, 0);
+  ccdVec3Set(&entry.pos, 0, 0, 0);
+  entry.generation = cache.generation;
+  cache.numLive++;
+  return entry;
+}
+
+} // namespace
+
 /// This allows us to prevent weird effects where we don't want to carry over
-/// cacheing
+/// cacheing. This only forgets the warm starts on the calling thread, and is
+/// O(1): it bumps a generation counter, and entries from older generations are
+/// reset the next time they're looked up (or evicted, once enough of them
+/// pile up).
 void clearCcdCache()
 {
-  const std::thread::id tid = std::this_thread::get_id();
-  _ccdDirCache[tid].clear();
-  _ccdPosCache[tid].clear();
-  // _ccdDirCache.clear();
-  // _ccdPosCache.clear();
+  _ccdCache.generation++;
+  _ccdCache.numLive = 0;
+}
+
+/// This returns the number of object pairs currently held in the calling
+/// thread's CCD warm-start cache, including stale entries that haven't been
+/// evicted yet. This is mostly useful for testing.
+std::size_t getCcdCacheSize()
+{
+  return _ccdCache.entries.size();
 }
 
 /*
@@ -3908,22 +4195,184 @@ bool get2DLineIntersection(
   return false; // No collision
 }
 
-// Get the `pos` vec for CCD for this pair of objects
+// Get the `pos` vec for CCD for this pair of objects. The cache is
+// thread_local, so the returned reference must not be shared across threads.
 ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2)
 {
-  long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& pos = _ccdPosCache[tid][key];
-  return pos;
+  return getCcdWarmStart(o1, o2).pos;
 }
 
-// Get the `dir` vec for CCD for this pair of objects
+// Get the `dir` vec for CCD for this pair of objects. The cache is
+// thread_local, so the returned reference must not be shared across threads.
 ccd_vec3_t& getCachedCcdDir(CollisionObject* o1, CollisionObject* o2)
 {
-  long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& dir = _ccdDirCache[tid][key];
-  return dir;
+  return getCcdWarmStart(o1, o2).dir;
+}
+
+namespace {
+
+/// This gets the oriented bounding box of a scaled mesh hull, in world space
+void getHullObb(
+    const math::SupportHull* hull,
+    const Eigen::Vector3s& scale,
+    const Eigen::Isometry3s& T,
+    Eigen::Vector3s& halfExtents,
+    Eigen::Isometry3s& obbT)
+{
+  halfExtents
+      = ((hull->getBoxMax() - hull->getBoxMin()) / 2).cwiseProduct(
+          scale.cwiseAbs());
+  obbT = T;
+  obbT.translation()
+      = T * ((hull->getBoxMax() + hull->getBoxMin()) / 2).cwiseProduct(scale);
+}
+
+/// This gets the bounding sphere of a scaled mesh hull, in world space
+void getHullSphere(
+    const math::SupportHull* hull,
+    const Eigen::Vector3s& scale,
+    const Eigen::Isometry3s& T,
+    Eigen::Vector3s& center,
+    s_t& radius)
+{
+  center = T * hull->getBoundingSphereCenter().cwiseProduct(scale);
+  radius = hull->getBoundingSphereRadius() * scale.cwiseAbs().maxCoeff();
+}
+
+} // namespace
+
+/// This returns true if the bounding sphere of the mesh hull is separated from
+/// the sphere at `center` with `radius`
+bool hullMissesSphere(
+    const math::SupportHull* hull,
+    const Eigen::Vector3s& scale,
+    const Eigen::Isometry3s& T,
+    const Eigen::Vector3s& center,
+    s_t radius)
+{
+  if (hull == nullptr)
+    return false;
+  Eigen::Vector3s hullCenter;
+  s_t hullRadius;
+  getHullSphere(hull, scale, T, hullCenter, hullRadius);
+  if ((hullCenter - center).norm()
+      > hullRadius + radius + DART_COLLISION_BOUNDS_MARGIN)
+    return true;
+
+  // The box is usually a tighter fit, and a sphere against a box is cheap
+  Eigen::Vector3s halfExtents;
+  Eigen::Isometry3s obbT;
+  getHullObb(hull, scale, T, halfExtents, obbT);
+  Eigen::Vector3s local = obbT.inverse() * center;
+  Eigen::Vector3s outside
+      = (local.cwiseAbs() - halfExtents).cwiseMax(Eigen::Vector3s::Zero());
+  return outside.norm() > radius + DART_COLLISION_BOUNDS_MARGIN;
+}
+
+/// This returns true if the bounding volumes of the mesh hull are separated
+/// from the box with `halfExtents` at `boxT`
+bool hullMissesBox(
+    const math::SupportHull* hull,
+    const Eigen::Vector3s& scale,
+    const Eigen::Isometry3s& T,
+    const Eigen::Vector3s& halfExtents,
+    const Eigen::Isometry3s& boxT)
+{
+  if (hull == nullptr)
+    return false;
+  Eigen::Vector3s hullCenter;
+  s_t hullRadius;
+  getHullSphere(hull, scale, T, hullCenter, hullRadius);
+  if ((hullCenter - boxT.translation()).norm()
+      > hullRadius + halfExtents.norm() + DART_COLLISION_BOUNDS_MARGIN)
+    return true;
+
+  Eigen::Vector3s hullHalfExtents;
+  Eigen::Isometry3s hullT;
+  getHullObb(hull, scale, T, hullHalfExtents, hullT);
+  return obbsDisjoint(
+      hullHalfExtents, hullT, halfExtents, boxT, DART_COLLISION_BOUNDS_MARGIN);
+}
+
+/// This returns true if the bounding volumes of two mesh hulls are separated
+bool hullsDisjoint(
+    const math::SupportHull* hull0,
+    const Eigen::Vector3s& scale0,
+    const Eigen::Isometry3s& T0,
+    const math::SupportHull* hull1,
+    const Eigen::Vector3s& scale1,
+    const Eigen::Isometry3s& T1)
+{
+  if (hull0 == nullptr || hull1 == nullptr)
+    return false;
+  Eigen::Vector3s center0;
+  s_t radius0;
+  getHullSphere(hull0, scale0, T0, center0, radius0);
+  Eigen::Vector3s center1;
+  s_t radius1;
+  getHullSphere(hull1, scale1, T1, center1, radius1);
+  if ((center0 - center1).norm()
+      > radius0 + radius1 + DART_COLLISION_BOUNDS_MARGIN)
+    return true;
+
+  Eigen::Vector3s halfExtents0;
+  Eigen::Isometry3s obbT0;
+  getHullObb(hull0, scale0, T0, halfExtents0, obbT0);
+  Eigen::Vector3s halfExtents1;
+  Eigen::Isometry3s obbT1;
+  getHullObb(hull1, scale1, T1, halfExtents1, obbT1);
+  return obbsDisjoint(
+      halfExtents0, obbT0, halfExtents1, obbT1, DART_COLLISION_BOUNDS_MARGIN);
+}
+
+/// This runs the separating axis test on two oriented boxes, and returns true
+/// if they're apart by more than `margin`
+bool obbsDisjoint(
+    const Eigen::Vector3s& halfExtents0,
+    const Eigen::Isometry3s& T0,
+    const Eigen::Vector3s& halfExtents1,
+    const Eigen::Isometry3s& T1,
+    s_t margin)
+{
+  const Eigen::Vector3s& a = halfExtents0;
+  const Eigen::Vector3s& b = halfExtents1;
+  // Everything below is in box 0's frame
+  Eigen::Matrix3s R = T0.linear().transpose() * T1.linear();
+  Eigen::Vector3s t
+      = T0.linear().transpose() * (T1.translation() - T0.translation());
+  // Padding |R| keeps near-parallel edges from producing a zero cross product
+  // axis that would spuriously "separate" the boxes
+  Eigen::Matrix3s absR = R.cwiseAbs().array() + DART_COLLISION_EPS;
+
+  // 1. The face normals of box 0
+  for (int i = 0; i < 3; i++)
+  {
+    if (abs(t(i)) > a(i) + b.dot(absR.row(i)) + margin)
+      return true;
+  }
+  // 2. The face normals of box 1
+  for (int j = 0; j < 3; j++)
+  {
+    if (abs(t.dot(R.col(j))) > a.dot(absR.col(j)) + b(j) + margin)
+      return true;
+  }
+  // 3. The cross products of each pair of edges. These axes are at most unit
+  // length, so a plain `margin` here is conservative.
+  for (int i = 0; i < 3; i++)
+  {
+    int i1 = (i + 1) % 3;
+    int i2 = (i + 2) % 3;
+    for (int j = 0; j < 3; j++)
+    {
+      int j1 = (j + 1) % 3;
+      int j2 = (j + 2) % 3;
+      s_t ra = a(i1) * absR(i2, j) + a(i2) * absR(i1, j);
+      s_t rb = b(j1) * absR(i, j2) + b(j2) * absR(i, j1);
+      if (abs(t(i2) * R(i1, j) - t(i1) * R(i2, j)) > ra + rb + margin)
+        return true;
+    }
+  }
+  return false;
 }
 
 int collideBoxBoxAsMesh(
@@ -3981,8 +4430,12 @@ int collideMeshBox(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::SupportHull* hull0)
 {
+  if (hullMissesBox(hull0, size0, c0, size1 / 2, c1))
+    return 0;
+
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
 
@@ -3997,6 +4450,7 @@ int collideMeshBox(
   mesh1.mesh = mesh0;
   mesh1.transform = &c0;
   mesh1.scale = &size0;
+  mesh1.hull = hull0;
 
   ccdBox box2;
   box2.size = &size1;
@@ -4029,8 +4483,12 @@ int collideBoxMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::SupportHull* hull1)
 {
+  if (hullMissesBox(hull1, size1, c1, size0 / 2, c0))
+    return 0;
+
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
 
@@ -4049,6 +4507,7 @@ int collideBoxMesh(
   mesh2.mesh = m1;
   mesh2.transform = &c1;
   mesh2.scale = &size1;
+  mesh2.hull = hull1;
 
   ccd_real_t depth;
   ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
@@ -4084,8 +4543,12 @@ int collideMeshSphere(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace /* halfspace */)
+    ClipSphereHalfspace /* halfspace */,
+    const math::SupportHull* hull0)
 {
+  if (hullMissesSphere(hull0, size0, c0, c1.translation(), r1))
+    return 0;
+
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
 
@@ -4093,6 +4556,7 @@ int collideMeshSphere(
   mesh.mesh = mesh0;
   mesh.transform = &c0;
   mesh.scale = &size0;
+  mesh.hull = hull0;
 
   ccdSphere sphere;
   sphere.radius = r1;
@@ -4132,8 +4596,12 @@ int collideSphereMesh(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace /* halfspace */)
+    ClipSphereHalfspace /* halfspace */,
+    const math::SupportHull* hull1)
 {
+  if (hullMissesSphere(hull1, size1, c1, c0.translation(), r0))
+    return 0;
+
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
 
@@ -4145,6 +4613,7 @@ int collideSphereMesh(
   mesh.mesh = mesh1;
   mesh.transform = &c1;
   mesh.scale = &size1;
+  mesh.hull = hull1;
 
   // set up ccd_t struct
   ccd.support1 = ccdSupportSphere; // support function for first object
@@ -4180,8 +4649,13 @@ int collideMeshMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::SupportHull* hull0,
+    const math::SupportHull* hull1)
 {
+  if (hullsDisjoint(hull0, size0, c0, hull1, size1, c1))
+    return 0;
+
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
 
@@ -4196,11 +4670,13 @@ int collideMeshMesh(
   mesh1.mesh = m0;
   mesh1.transform = &c0;
   mesh1.scale = &size0;
+  mesh1.hull = hull0;
 
   ccdMesh mesh2;
   mesh2.mesh = m1;
   mesh2.transform = &c1;
   mesh2.scale = &size1;
+  mesh2.hull = hull1;
 
   ccd_real_t depth;
   ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
@@ -4694,8 +5170,13 @@ int collideMeshCapsule(
     s_t radius1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::SupportHull* hull0)
 {
+  if (hullMissesSphere(
+          hull0, size0, T0, T1.translation(), radius1 + height1 / 2))
+    return 0;
+
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
 
@@ -4710,6 +5191,7 @@ int collideMeshCapsule(
   mesh1.mesh = m0;
   mesh1.transform = &T0;
   mesh1.scale = &size0;
+  mesh1.hull = hull0;
 
   ccdCapsule capsule2;
   capsule2.height = height1;
@@ -4744,7 +5226,8 @@ int collideMeshCapsule(
           T1 * sphereTransform,
           option,
           result,
-          ClipSphereHalfspace::TOP);
+          ClipSphereHalfspace::TOP,
+          hull0);
     }
     else if (localPos(2) < -height1 / 2)
     {
@@ -4760,7 +5243,8 @@ int collideMeshCapsule(
           T1 * sphereTransform,
           option,
           result,
-          ClipSphereHalfspace::BOTTOM);
+          ClipSphereHalfspace::BOTTOM,
+          hull0);
     }
 
     // Otherwise we're on an edge, and have to handle the pipe collisions
@@ -4802,8 +5286,13 @@ int collideCapsuleMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::SupportHull* hull1)
 {
+  if (hullMissesSphere(
+          hull1, size1, T1, T0.translation(), radius0 + height0 / 2))
+    return 0;
+
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
 
@@ -4823,6 +5312,7 @@ int collideCapsuleMesh(
   mesh2.mesh = m1;
   mesh2.scale = &size1;
   mesh2.transform = &T1;
+  mesh2.hull = hull1;
 
   ccd_real_t depth;
   ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
@@ -4852,7 +5342,8 @@ int collideCapsuleMesh(
           T1,
           option,
           result,
-          ClipSphereHalfspace::TOP);
+          ClipSphereHalfspace::TOP,
+          hull1);
     }
     else if (localPos(2) < -height0 / 2)
     {
@@ -4868,7 +5359,8 @@ int collideCapsuleMesh(
           T1,
           option,
           result,
-          ClipSphereHalfspace::BOTTOM);
+          ClipSphereHalfspace::BOTTOM,
+          hull1);
     }
 
     // Otherwise we're on an edge, and have to handle the pipe collisions
@@ -4900,62 +5392,845 @@ int collideCapsuleMesh(
   return 0;
 }
 
-int collideCylinderSphere(
-    CollisionObject* o1,
-    CollisionObject* o2,
-    const s_t& cyl_rad,
-    const s_t& half_height,
-    const Eigen::Isometry3s& T0,
-    const s_t& sphere_rad,
-    const Eigen::Isometry3s& T1,
-    CollisionResult& result,
-    const CollisionOption& /* option */,
-    ClipSphereHalfspace /* halfspace */)
+namespace {
+
+/// This is one triangle of a heightmap cell, extruded straight down (along
+/// the heightmap's -Z) to below the lowest point of the heightmap. The
+/// vertices are in world space, with the top triangle first.
+struct ccdHeightmapPrism
 {
-  Eigen::Vector3s center = T0.inverse() * T1.translation();
+  Eigen::Vector3s vertices[6];
+  // The top triangle, projected onto the heightmap's XY plane
+  Eigen::Vector2s footprint[3];
+  // The upward normal of the top triangle, in the heightmap's frame
+  Eigen::Vector3s normal;
+};
 
-  s_t dist = sqrt(center[0] * center[0] + center[1] * center[1]);
+/// libccd support function for a heightmap prism
+void ccdSupportHeightmapPrism(
+    const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out)
+{
+  const ccdHeightmapPrism* prism = (const ccdHeightmapPrism*)_obj;
+  Eigen::Vector3s dir;
+  dir(0) = static_cast<s_t>(_dir->v[0]);
+  dir(1) = static_cast<s_t>(_dir->v[1]);
+  dir(2) = static_cast<s_t>(_dir->v[2]);
 
-  if (dist < cyl_rad && abs(center[2]) < half_height + sphere_rad)
+  int best = 0;
+  s_t bestDot = prism->vertices[0].dot(dir);
+  for (int i = 1; i < 6; i++)
   {
-    Contact contact;
-    contact.collisionObject1 = o1;
-    contact.collisionObject2 = o2;
-    contact.penetrationDepth
-        = 0.5 * (half_height + sphere_rad - math::sign(center[2]) * center[2]);
-    contact.point
-        = T0
-          * Eigen::Vector3s(
-              center[0], center[1], half_height - contact.penetrationDepth);
-    contact.normal
-        = T0.linear() * Eigen::Vector3s(0.0, 0.0, math::sign(center[2]));
-    result.addContact(contact);
-    return 1;
+    s_t dot = prism->vertices[i].dot(dir);
+    if (dot > bestDot)
+    {
+      bestDot = dot;
+      best = i;
+    }
   }
-  else
+  _out->v[0] = static_cast<ccd_real_t>(prism->vertices[best](0));
+  _out->v[1] = static_cast<ccd_real_t>(prism->vertices[best](1));
+  _out->v[2] = static_cast<ccd_real_t>(prism->vertices[best](2));
+}
+
+/// libccd center function for a heightmap prism
+void ccdCenterHeightmapPrism(const void* _obj, ccd_vec3_t* _center)
+{
+  const ccdHeightmapPrism* prism = (const ccdHeightmapPrism*)_obj;
+  Eigen::Vector3s center = Eigen::Vector3s::Zero();
+  for (int i = 0; i < 6; i++)
   {
-    s_t penetration = 0.5 * (cyl_rad + sphere_rad - dist);
-    if (penetration > 0.0)
-    {
-      if (abs(center[2]) > half_height)
-      {
-        Eigen::Vector3s point
-            = (Eigen::Vector3s(center[0], center[1], 0.0).normalized());
-        point *= cyl_rad;
-        point[2] = math::sign(center[2]) * half_height;
-        Eigen::Vector3s normal = point - center;
-        penetration = sphere_rad - normal.norm();
-        normal = (T0.linear() * normal).normalized();
-        point = T0 * point;
+    center += prism->vertices[i];
+  }
+  center /= 6;
+  _center->v[0] = static_cast<ccd_real_t>(center(0));
+  _center->v[1] = static_cast<ccd_real_t>(center(1));
+  _center->v[2] = static_cast<ccd_real_t>(center(2));
+}
 
-        if (penetration > 0.0)
-        {
-          Contact contact;
-          contact.collisionObject1 = o1;
-          contact.collisionObject2 = o2;
-          contact.point = point;
-          contact.normal = normal;
-          contact.penetrationDepth = penetration;
+/// Find all the vertices within epsilon of lying on the witness plane
+std::vector<Eigen::Vector3s> ccdPointsAtWitnessHeightmapPrism(
+    const void* _obj, ccd_vec3_t* _dir, bool neg)
+{
+  const ccdHeightmapPrism* prism = (const ccdHeightmapPrism*)_obj;
+  Eigen::Vector3s dir;
+  dir(0) = static_cast<s_t>(_dir->v[0]);
+  dir(1) = static_cast<s_t>(_dir->v[1]);
+  dir(2) = static_cast<s_t>(_dir->v[2]);
+  if (neg)
+    dir = -dir;
+
+  s_t maxDot = -std::numeric_limits<s_t>::infinity();
+  for (int i = 0; i < 6; i++)
+  {
+    maxDot = std::max(maxDot, prism->vertices[i].dot(dir));
+  }
+
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 6; i++)
+  {
+    if (maxDot - prism->vertices[i].dot(dir)
+        < DART_COLLISION_WITNESS_PLANE_DEPTH)
+    {
+      points.push_back(prism->vertices[i]);
+    }
+  }
+  return points;
+}
+
+/// This is the shape we're colliding against a heightmap, point cloud, or
+/// multi-sphere hull, wrapped up for libccd. Only the member matching `kind`
+/// is filled in. The ccd structs point into this, so it must not be copied
+/// once it's been set up.
+struct ConvexOpponent
+{
+  enum Kind
+  {
+    BOX,
+    SPHERE,
+    CAPSULE,
+    MESH,
+    MULTISPHERE
+  };
+
+  Kind kind;
+  ccdBox box;
+  ccdSphere sphere;
+  ccdCapsule capsule;
+  ccdMesh mesh;
+  ccdMultiSphere multiSphere;
+  // Storage for the box size or mesh scale, which the ccd structs point to
+  Eigen::Vector3s size;
+};
+
+/// This sets up `out` for the shape of `o`, or returns false if it isn't a
+/// convex shape we know how to wrap. `o` has to outlive `out`.
+bool initConvexOpponent(CollisionObject* o, ConvexOpponent& out)
+{
+  const Eigen::Isometry3s& T = o->getTransform();
+  const auto& shape = o->getShape();
+  const auto& shapeType = shape->getType();
+
+  if (dynamics::BoxShape::getStaticType() == shapeType)
+  {
+    out.kind = ConvexOpponent::BOX;
+    out.size = static_cast<const dynamics::BoxShape*>(shape.get())->getSize();
+    out.box.size = &out.size;
+    out.box.transform = &T;
+  }
+  else if (dynamics::SphereShape::getStaticType() == shapeType)
+  {
+    out.kind = ConvexOpponent::SPHERE;
+    out.sphere.radius
+        = static_cast<const dynamics::SphereShape*>(shape.get())->getRadius();
+    out.sphere.transform = &T;
+  }
+  else if (dynamics::EllipsoidShape::getStaticType() == shapeType)
+  {
+    // Like the rest of collide(), we treat ellipsoids as spheres
+    out.kind = ConvexOpponent::SPHERE;
+    out.sphere.radius
+        = static_cast<const dynamics::EllipsoidShape*>(shape.get())
+              ->getRadii()[0];
+    out.sphere.transform = &T;
+  }
+  else if (dynamics::CapsuleShape::getStaticType() == shapeType)
+  {
+    const auto* capsule
+        = static_cast<const dynamics::CapsuleShape*>(shape.get());
+    out.kind = ConvexOpponent::CAPSULE;
+    out.capsule.radius = capsule->getRadius();
+    out.capsule.height = capsule->getHeight();
+    out.capsule.transform = &T;
+  }
+  else if (dynamics::MeshShape::getStaticType() == shapeType)
+  {
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape.get());
+    out.kind = ConvexOpponent::MESH;
+    out.size = mesh->getScale();
+    out.mesh.mesh = mesh->getMesh();
+    out.mesh.transform = &T;
+    out.mesh.scale = &out.size;
+    out.mesh.hull = mesh->getSupportHull().get();
+  }
+  else if (dynamics::MultiSphereConvexHullShape::getStaticType() == shapeType)
+  {
+    const auto* hull
+        = static_cast<const dynamics::MultiSphereConvexHullShape*>(
+            shape.get());
+    if (hull->getNumSpheres() == 0)
+      return false;
+    out.kind = ConvexOpponent::MULTISPHERE;
+    out.multiSphere.spheres = &hull->getSpheres();
+    out.multiSphere.transform = &T;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+/// This puts the bounding box of the shape of `o` into the frame `T`, as an
+/// axis-aligned box [min, max] that contains it
+void getBoundsInFrame(
+    CollisionObject* o,
+    const Eigen::Isometry3s& T,
+    Eigen::Vector3s& min,
+    Eigen::Vector3s& max)
+{
+  const math::BoundingBox& box = o->getShape()->getBoundingBox();
+  const Eigen::Isometry3s oInFrame = T.inverse() * o->getTransform();
+  const Eigen::Vector3s center = oInFrame * box.computeCenter();
+  const Eigen::Vector3s halfExtents
+      = oInFrame.linear().cwiseAbs() * box.computeHalfExtents().cwiseAbs();
+  min = center - halfExtents;
+  max = center + halfExtents;
+}
+
+/// This is a convex piece of a shape that libccd can find support points
+/// on, along with a way to list its vertices on a witness plane
+struct ConvexPiece
+{
+  const void* obj;
+  ccd_support_fn support;
+  ccd_center_fn center;
+  std::vector<Eigen::Vector3s> (*witnessPoints)(
+      const void* obj, ccd_vec3_t* dir, bool neg);
+};
+
+/// This lists the witness points of a ccdMultiSphere, for a ConvexPiece
+std::vector<Eigen::Vector3s> ccdPointsAtWitnessMultiSpherePiece(
+    const void* obj, ccd_vec3_t* dir, bool neg)
+{
+  return ccdPointsAtWitnessMultiSphere(
+      static_cast<const ccdMultiSphere*>(obj), dir, neg);
+}
+
+/// This runs the narrowphase between a convex piece and the opponent shape,
+/// and adds the resulting contacts to `result`. The contacts come from the
+/// same helpers as mesh contacts, so they carry everything we need for
+/// analytic gradients. `pieceFirst` is true if `o1` holds the piece. This
+/// returns the number of contacts added.
+int collideConvexPiece(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const ConvexPiece& piece,
+    ConvexOpponent& opponent,
+    bool pieceFirst,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  const void* opponentObj = nullptr;
+  ccd_support_fn opponentSupport = nullptr;
+  ccd_center_fn opponentCenter = nullptr;
+  if (opponent.kind == ConvexOpponent::BOX)
+  {
+    opponentObj = &opponent.box;
+    opponentSupport = ccdSupportBox;
+    opponentCenter = ccdCenterBox;
+  }
+  else if (opponent.kind == ConvexOpponent::SPHERE)
+  {
+    opponentObj = &opponent.sphere;
+    opponentSupport = ccdSupportSphere;
+    opponentCenter = ccdCenterSphere;
+  }
+  else if (opponent.kind == ConvexOpponent::CAPSULE)
+  {
+    opponentObj = &opponent.capsule;
+    opponentSupport = ccdSupportCapsule;
+    opponentCenter = ccdCenterCapsule;
+  }
+  else if (opponent.kind == ConvexOpponent::MESH)
+  {
+    opponentObj = &opponent.mesh;
+    opponentSupport = ccdSupportMesh;
+    opponentCenter = ccdCenterMesh;
+  }
+  else
+  {
+    opponentObj = &opponent.multiSphere;
+    opponentSupport = ccdSupportMultiSphere;
+    opponentCenter = ccdCenterMultiSphere;
+  }
+
+  ccd_t ccd;
+  CCD_INIT(&ccd); // initialize ccd_t struct
+  const void* obj1 = piece.obj;
+  const void* obj2 = opponentObj;
+  ccd.support1 = piece.support;
+  ccd.support2 = opponentSupport;
+  ccd.center1 = piece.center;
+  ccd.center2 = opponentCenter;
+  if (!pieceFirst)
+  {
+    std::swap(obj1, obj2);
+    std::swap(ccd.support1, ccd.support2);
+    std::swap(ccd.center1, ccd.center2);
+  }
+  setCcdDefaultSettings(ccd); // maximal tolerance
+
+  // Pieces are usually one of many convex bits of a larger shape, so there's
+  // nothing useful to warm start from
+  ccd_real_t depth;
+  ccd_vec3_t dir;
+  ccd_vec3_t pos;
+  ccdVec3Set(&dir, 0, 0, 0);
+  ccdVec3Set(&pos, 0, 0, 0);
+  int intersect = ccdMPRPenetration(obj1, obj2, &ccd, &depth, &dir, &pos);
+  if (depth > option.contactClippingDepth)
+    return 0;
+  if (intersect != 0)
+    return 0;
+
+  if (opponent.kind == ConvexOpponent::CAPSULE)
+  {
+    // Like collideMeshCapsule(), the capsule's ends are handled as spheres
+    const ccdCapsule& capsule = opponent.capsule;
+    Eigen::Vector3s posWorld;
+    posWorld(0) = static_cast<s_t>(pos.v[0]);
+    posWorld(1) = static_cast<s_t>(pos.v[1]);
+    posWorld(2) = static_cast<s_t>(pos.v[2]);
+    Eigen::Vector3s localPos = capsule.transform->inverse() * posWorld;
+    if (abs(localPos(2)) > capsule.height / 2)
+    {
+      s_t endZ = (localPos(2) > 0 ? 0.5 : -0.5) * capsule.height;
+      Eigen::Isometry3s sphereTransform = Eigen::Isometry3s::Identity();
+      sphereTransform.translation() = Eigen::Vector3s(0, 0, endZ);
+      Eigen::Isometry3s endT = *capsule.transform * sphereTransform;
+      ConvexOpponent end;
+      end.kind = ConvexOpponent::SPHERE;
+      end.sphere.radius = capsule.radius;
+      end.sphere.transform = &endT;
+      return collideConvexPiece(
+          o1, o2, piece, end, pieceFirst, option, result);
+    }
+  }
+
+  const int before = result.getNumContacts();
+  std::vector<Eigen::Vector3s> piecePoints
+      = piece.witnessPoints(piece.obj, &dir, !pieceFirst);
+  if (opponent.kind == ConvexOpponent::BOX
+      || opponent.kind == ConvexOpponent::MESH
+      || opponent.kind == ConvexOpponent::MULTISPHERE)
+  {
+    std::vector<Eigen::Vector3s> opponentPoints;
+    if (opponent.kind == ConvexOpponent::BOX)
+      opponentPoints = ccdPointsAtWitnessBox(&opponent.box, &dir, pieceFirst);
+    else if (opponent.kind == ConvexOpponent::MESH)
+      opponentPoints
+          = ccdPointsAtWitnessMesh(&opponent.mesh, &dir, pieceFirst);
+    else
+      opponentPoints = ccdPointsAtWitnessMultiSphere(
+          &opponent.multiSphere, &dir, pieceFirst);
+    if (opponentPoints.empty() || piecePoints.empty())
+      return 0;
+    if (pieceFirst)
+      createMeshMeshContacts(
+          o1, o2, result, &dir, piecePoints, opponentPoints);
+    else
+      createMeshMeshContacts(
+          o1, o2, result, &dir, opponentPoints, piecePoints);
+  }
+  else if (opponent.kind == ConvexOpponent::SPHERE)
+  {
+    const Eigen::Vector3s center = opponent.sphere.transform->translation();
+    const s_t radius = opponent.sphere.radius;
+    if (pieceFirst)
+      createMeshSphereContact(
+          o1, o2, result, &dir, piecePoints, center, radius);
+    else
+      createSphereMeshContact(
+          o1, o2, result, &dir, center, radius, piecePoints);
+  }
+  else
+  {
+    const ccdCapsule& capsule = opponent.capsule;
+    std::vector<Contact> contacts;
+    createCapsuleMeshContact(
+        o1,
+        o2,
+        contacts,
+        &dir,
+        *capsule.transform * Eigen::Vector3s(0, 0, capsule.height / 2),
+        *capsule.transform * Eigen::Vector3s(0, 0, -capsule.height / 2),
+        capsule.radius,
+        piecePoints,
+        pieceFirst,
+        option);
+    for (const Contact& contact : contacts)
+    {
+      result.addContact(contact);
+    }
+  }
+  return result.getNumContacts() - before;
+}
+
+/// This returns true if `point` (in the heightmap's XY plane) is over the
+/// prism's top triangle, give or take `tol`
+bool footprintContains(
+    const ccdHeightmapPrism& prism, const Eigen::Vector2s& point, s_t tol)
+{
+  s_t area = crossProduct2D(
+      prism.footprint[1] - prism.footprint[0],
+      prism.footprint[2] - prism.footprint[0]);
+  s_t sign = area > 0 ? 1.0 : -1.0;
+  for (int i = 0; i < 3; i++)
+  {
+    const Eigen::Vector2s& a = prism.footprint[i];
+    const Eigen::Vector2s& b = prism.footprint[(i + 1) % 3];
+    if (sign * crossProduct2D(b - a, point - a) < -tol * (b - a).norm())
+      return false;
+  }
+  return true;
+}
+
+/// This runs the narrowphase between one heightmap prism and the opponent
+/// shape, and adds the resulting contacts to `result`.
+///
+/// Only the top of each prism is real terrain. Contacts that don't lie over
+/// the prism's own triangle are dropped, since the neighboring prism reports
+/// them, and reporting both would double up the forces along cell seams.
+/// Contacts that push out through the vertical sides of the prism are dropped
+/// too, because those sides are buried inside the terrain.
+int collideHeightmapPrism(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const ccdHeightmapPrism& prism,
+    ConvexOpponent& opponent,
+    bool heightmapFirst,
+    const Eigen::Isometry3s& heightmapT,
+    s_t footprintTol,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  ConvexPiece piece;
+  piece.obj = &prism;
+  piece.support = ccdSupportHeightmapPrism;
+  piece.center = ccdCenterHeightmapPrism;
+  piece.witnessPoints = ccdPointsAtWitnessHeightmapPrism;
+  CollisionResult pairResult;
+  if (collideConvexPiece(
+          o1, o2, piece, opponent, heightmapFirst, option, pairResult)
+      == 0)
+    return 0;
+
+  const Eigen::Isometry3s heightmapInv = heightmapT.inverse();
+  int numContacts = 0;
+  for (const Contact& contact : pairResult.getContacts())
+  {
+    Eigen::Vector3s local = heightmapInv * contact.point;
+    if (!footprintContains(prism, local.head<2>(), footprintTol))
+      continue;
+    Eigen::Vector3s localNormal = heightmapInv.linear() * contact.normal;
+    if (std::abs(localNormal(2)) < 0.5 * prism.normal(2))
+      continue;
+    result.addContact(contact);
+    numContacts++;
+  }
+  return numContacts;
+}
+
+/// This is the implementation of collideHeightmap(), for both float and s_t
+/// heightmaps
+template <typename S>
+int collideHeightmapImpl(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::HeightmapShape<S>* heightmap,
+    bool heightmapFirst,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  CollisionObject* heightmapObj = heightmapFirst ? o1 : o2;
+  CollisionObject* opponentObj = heightmapFirst ? o2 : o1;
+  const Eigen::Isometry3s& heightmapT = heightmapObj->getTransform();
+
+  ConvexOpponent opponent;
+  if (!initConvexOpponent(opponentObj, opponent))
+    return 0;
+
+  const auto& heights = heightmap->getHeightField();
+  const int width = heights.cols();
+  const int depth = heights.rows();
+  if (width < 2 || depth < 2)
+    return 0;
+  const Eigen::Vector3s scale = heightmap->getScale().template cast<s_t>();
+
+  // Put the opponent's bounding box into the heightmap's frame
+  Eigen::Vector3s aabbMin;
+  Eigen::Vector3s aabbMax;
+  getBoundsInFrame(opponentObj, heightmapT, aabbMin, aabbMax);
+
+  // Vertex (row, col) sits at x = x0 + col * scale.x, y = y0 - row * scale.y,
+  // so the grid is centered on the origin with row 0 along +Y
+  const s_t x0 = -0.5 * (width - 1) * scale(0);
+  const s_t y0 = 0.5 * (depth - 1) * scale(1);
+  const int colMin = std::max(
+      0, static_cast<int>(std::floor((aabbMin(0) - x0) / scale(0))));
+  const int colMax = std::min(
+      width - 2, static_cast<int>(std::floor((aabbMax(0) - x0) / scale(0))));
+  const int rowMin = std::max(
+      0, static_cast<int>(std::floor((y0 - aabbMax(1)) / scale(1))));
+  const int rowMax = std::min(
+      depth - 2, static_cast<int>(std::floor((y0 - aabbMin(1)) / scale(1))));
+  if (colMin > colMax || rowMin > rowMax)
+    return 0;
+
+  // The prisms reach a full cell below the lowest point of the terrain, so
+  // there's always some volume under the surface to push objects back out of
+  const s_t bottom = static_cast<s_t>(heightmap->getMinHeight()) * scale(2)
+                     - std::max(scale(0), scale(1));
+  const s_t footprintTol = 1e-9 * std::max(scale(0), scale(1));
+
+  auto vertexAt = [&](int row, int col) {
+    return Eigen::Vector3s(
+        x0 + col * scale(0),
+        y0 - row * scale(1),
+        static_cast<s_t>(heights(row, col)) * scale(2));
+  };
+
+  int numContacts = 0;
+  ccdHeightmapPrism prism;
+  for (int row = rowMin; row <= rowMax; row++)
+  {
+    for (int col = colMin; col <= colMax; col++)
+    {
+      const Eigen::Vector3s corners[4] = {vertexAt(row, col),
+                                          vertexAt(row + 1, col),
+                                          vertexAt(row + 1, col + 1),
+                                          vertexAt(row, col + 1)};
+      // Every cell is split along the same diagonal, into two triangles
+      const int triangles[2][3] = {{0, 1, 2}, {0, 2, 3}};
+      for (int t = 0; t < 2; t++)
+      {
+        s_t top = -std::numeric_limits<s_t>::infinity();
+        for (int k = 0; k < 3; k++)
+        {
+          const Eigen::Vector3s& corner = corners[triangles[t][k]];
+          top = std::max(top, corner(2));
+          Eigen::Vector3s under = corner;
+          under(2) = bottom;
+          prism.vertices[k] = heightmapT * corner;
+          prism.vertices[k + 3] = heightmapT * under;
+          prism.footprint[k] = corner.head<2>();
+        }
+        // If the opponent is entirely above this triangle, we can skip it
+        if (aabbMin(2) > top)
+          continue;
+        const Eigen::Vector3s& a = corners[triangles[t][0]];
+        const Eigen::Vector3s& b = corners[triangles[t][1]];
+        const Eigen::Vector3s& c = corners[triangles[t][2]];
+        prism.normal = (b - a).cross(c - a).normalized();
+        if (prism.normal(2) < 0)
+          prism.normal *= -1;
+
+        numContacts += collideHeightmapPrism(
+            o1,
+            o2,
+            prism,
+            opponent,
+            heightmapFirst,
+            heightmapT,
+            footprintTol,
+            option,
+            result);
+        if (result.getNumContacts() >= option.maxNumContacts)
+          return numContacts;
+      }
+    }
+  }
+  return numContacts;
+}
+
+} // namespace
+
+int collideHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::HeightmapShapef* heightmap,
+    bool heightmapFirst,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  return collideHeightmapImpl(
+      o1, o2, heightmap, heightmapFirst, option, result);
+}
+
+int collideHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::HeightmapShaped* heightmap,
+    bool heightmapFirst,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  return collideHeightmapImpl(
+      o1, o2, heightmap, heightmapFirst, option, result);
+}
+
+namespace {
+
+/// This collides one sphere of a point cloud, of `radius` at `sphereT`, with
+/// the shape of `other`, through the same code a SphereShape would go
+/// through. `sphereFirst` is true if `o1` holds the point cloud.
+int collideCloudSphere(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    s_t radius,
+    const Eigen::Isometry3s& sphereT,
+    CollisionObject* other,
+    bool sphereFirst,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  const auto& shape = other->getShape();
+  const auto& shapeType = shape->getType();
+  const Eigen::Isometry3s& otherT = other->getTransform();
+
+  s_t otherRadius = -1;
+  if (dynamics::SphereShape::getStaticType() == shapeType)
+  {
+    otherRadius
+        = static_cast<const dynamics::SphereShape*>(shape.get())->getRadius();
+  }
+  else if (dynamics::EllipsoidShape::getStaticType() == shapeType)
+  {
+    otherRadius = static_cast<const dynamics::EllipsoidShape*>(shape.get())
+                      ->getRadii()[0];
+  }
+  if (otherRadius >= 0)
+  {
+    if (sphereFirst)
+      return collideSphereSphere(
+          o1, o2, radius, sphereT, otherRadius, otherT, option, result);
+    return collideSphereSphere(
+        o1, o2, otherRadius, otherT, radius, sphereT, option, result);
+  }
+
+  if (dynamics::BoxShape::getStaticType() == shapeType)
+  {
+    const Eigen::Vector3s& size
+        = static_cast<const dynamics::BoxShape*>(shape.get())->getSize();
+    if (sphereFirst)
+      return collideSphereBox(
+          o1, o2, radius, sphereT, size, otherT, option, result);
+    return collideBoxSphere(
+        o1, o2, size, otherT, radius, sphereT, option, result);
+  }
+  else if (dynamics::CapsuleShape::getStaticType() == shapeType)
+  {
+    const auto* capsule
+        = static_cast<const dynamics::CapsuleShape*>(shape.get());
+    if (sphereFirst)
+      return collideSphereCapsule(
+          o1,
+          o2,
+          radius,
+          sphereT,
+          capsule->getHeight(),
+          capsule->getRadius(),
+          otherT,
+          option,
+          result);
+    return collideCapsuleSphere(
+        o1,
+        o2,
+        capsule->getHeight(),
+        capsule->getRadius(),
+        otherT,
+        radius,
+        sphereT,
+        option,
+        result);
+  }
+  else if (dynamics::MeshShape::getStaticType() == shapeType)
+  {
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape.get());
+    if (sphereFirst)
+      return collideSphereMesh(
+          o1,
+          o2,
+          radius,
+          sphereT,
+          mesh->getMesh(),
+          mesh->getScale(),
+          otherT,
+          option,
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh->getSupportHull().get());
+    return collideMeshSphere(
+        o1,
+        o2,
+        mesh->getMesh(),
+        mesh->getScale(),
+        otherT,
+        radius,
+        sphereT,
+        option,
+        result,
+        ClipSphereHalfspace::BOTH,
+        mesh->getSupportHull().get());
+  }
+  else if (dynamics::MultiSphereConvexHullShape::getStaticType() == shapeType)
+  {
+    const auto* hull
+        = static_cast<const dynamics::MultiSphereConvexHullShape*>(
+            shape.get());
+    if (hull->getNumSpheres() == 0)
+      return 0;
+    ccdMultiSphere hullCcd;
+    hullCcd.spheres = &hull->getSpheres();
+    hullCcd.transform = &otherT;
+    ConvexPiece piece;
+    piece.obj = &hullCcd;
+    piece.support = ccdSupportMultiSphere;
+    piece.center = ccdCenterMultiSphere;
+    piece.witnessPoints = ccdPointsAtWitnessMultiSpherePiece;
+    ConvexOpponent point;
+    point.kind = ConvexOpponent::SPHERE;
+    point.sphere.radius = radius;
+    point.sphere.transform = &sphereT;
+    return collideConvexPiece(
+        o1, o2, piece, point, !sphereFirst, option, result);
+  }
+  return 0;
+}
+
+} // namespace
+
+//==============================================================================
+int collidePointCloud(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::PointCloudShape* cloud,
+    bool cloudFirst,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  CollisionObject* cloudObj = cloudFirst ? o1 : o2;
+  CollisionObject* otherObj = cloudFirst ? o2 : o1;
+  const Eigen::Isometry3s& cloudT = cloudObj->getTransform();
+
+  std::shared_ptr<const math::SphereTree> tree = cloud->getSphereTree();
+  if (tree->getNumSpheres() == 0)
+    return 0;
+
+  // The tree is in the cloud's frame, so we cull against the other shape's
+  // bounding box in that frame
+  Eigen::Vector3s aabbMin;
+  Eigen::Vector3s aabbMax;
+  getBoundsInFrame(otherObj, cloudT, aabbMin, aabbMax);
+  std::vector<int> candidates;
+  tree->findOverlapping(aabbMin, aabbMax, candidates);
+
+  int numContacts = 0;
+  Eigen::Isometry3s sphereT = cloudT;
+  for (int i : candidates)
+  {
+    sphereT.translation() = cloudT * tree->getCenter(i);
+    numContacts += collideCloudSphere(
+        o1,
+        o2,
+        tree->getRadius(i),
+        sphereT,
+        otherObj,
+        cloudFirst,
+        option,
+        result);
+    if (result.getNumContacts() >= option.maxNumContacts)
+      break;
+  }
+  return numContacts;
+}
+
+//==============================================================================
+int collideMultiSphere(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::MultiSphereConvexHullShape* hull,
+    bool hullFirst,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  if (hull->getNumSpheres() == 0)
+    return 0;
+  CollisionObject* hullObj = hullFirst ? o1 : o2;
+  CollisionObject* otherObj = hullFirst ? o2 : o1;
+
+  ConvexOpponent opponent;
+  if (!initConvexOpponent(otherObj, opponent))
+    return 0;
+
+  ccdMultiSphere hullCcd;
+  hullCcd.spheres = &hull->getSpheres();
+  hullCcd.transform = &hullObj->getTransform();
+  ConvexPiece piece;
+  piece.obj = &hullCcd;
+  piece.support = ccdSupportMultiSphere;
+  piece.center = ccdCenterMultiSphere;
+  piece.witnessPoints = ccdPointsAtWitnessMultiSpherePiece;
+  return collideConvexPiece(
+      o1, o2, piece, opponent, hullFirst, option, result);
+}
+
+int collideCylinderSphere(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const s_t& cyl_rad,
+    const s_t& half_height,
+    const Eigen::Isometry3s& T0,
+    const s_t& sphere_rad,
+    const Eigen::Isometry3s& T1,
+    CollisionResult& result,
+    const CollisionOption& /* option */,
+    ClipSphereHalfspace /* halfspace */)
+{
+  Eigen::Vector3s center = T0.inverse() * T1.translation();
+
+  s_t dist = sqrt(center[0] * center[0] + center[1] * center[1]);
+
+  if (dist < cyl_rad && abs(center[2]) < half_height + sphere_rad)
+  {
+    Contact contact;
+    contact.collisionObject1 = o1;
+    contact.collisionObject2 = o2;
+    contact.penetrationDepth
+        = 0.5 * (half_height + sphere_rad - math::sign(center[2]) * center[2]);
+    contact.point
+        = T0
+          * Eigen::Vector3s(
+              center[0], center[1], half_height - contact.penetrationDepth);
+    contact.normal
+        = T0.linear() * Eigen::Vector3s(0.0, 0.0, math::sign(center[2]));
+    result.addContact(contact);
+    return 1;
+  }
+  else
+  {
+    s_t penetration = 0.5 * (cyl_rad + sphere_rad - dist);
+    if (penetration > 0.0)
+    {
+      if (abs(center[2]) > half_height)
+      {
+        Eigen::Vector3s point
+            = (Eigen::Vector3s(center[0], center[1], 0.0).normalized());
+        point *= cyl_rad;
+        point[2] = math::sign(center[2]) * half_height;
+        Eigen::Vector3s normal = point - center;
+        penetration = sphere_rad - normal.norm();
+        normal = (T0.linear() * normal).normalized();
+        point = T0 * point;
+
+        if (penetration > 0.0)
+        {
+          Contact contact;
+          contact.collisionObject1 = o1;
+          contact.collisionObject2 = o2;
+          contact.point = point;
+          contact.normal = normal;
+          contact.penetrationDepth = penetration;
           result.addContact(contact);
           return 1;
         }
@@ -5085,6 +6360,94 @@ int collide(
   const Eigen::Isometry3s& T1 = o1->getTransform();
   const Eigen::Isometry3s& T2 = o2->getTransform();
 
+  // Heightmaps collide with everything through the same grid walk
+  if (dynamics::HeightmapShaped::getStaticType() == shapeType1)
+  {
+    return collideHeightmap(
+        o1,
+        o2,
+        static_cast<const dynamics::HeightmapShaped*>(shape1.get()),
+        true,
+        option,
+        result);
+  }
+  else if (dynamics::HeightmapShapef::getStaticType() == shapeType1)
+  {
+    return collideHeightmap(
+        o1,
+        o2,
+        static_cast<const dynamics::HeightmapShapef*>(shape1.get()),
+        true,
+        option,
+        result);
+  }
+  else if (dynamics::HeightmapShaped::getStaticType() == shapeType2)
+  {
+    return collideHeightmap(
+        o1,
+        o2,
+        static_cast<const dynamics::HeightmapShaped*>(shape2.get()),
+        false,
+        option,
+        result);
+  }
+  else if (dynamics::HeightmapShapef::getStaticType() == shapeType2)
+  {
+    return collideHeightmap(
+        o1,
+        o2,
+        static_cast<const dynamics::HeightmapShapef*>(shape2.get()),
+        false,
+        option,
+        result);
+  }
+
+  // Point clouds walk their sphere tree, and hand each nearby point to the
+  // sphere code
+  if (dynamics::PointCloudShape::getStaticType() == shapeType1)
+  {
+    return collidePointCloud(
+        o1,
+        o2,
+        static_cast<const dynamics::PointCloudShape*>(shape1.get()),
+        true,
+        option,
+        result);
+  }
+  else if (dynamics::PointCloudShape::getStaticType() == shapeType2)
+  {
+    return collidePointCloud(
+        o1,
+        o2,
+        static_cast<const dynamics::PointCloudShape*>(shape2.get()),
+        false,
+        option,
+        result);
+  }
+
+  if (dynamics::MultiSphereConvexHullShape::getStaticType() == shapeType1)
+  {
+    return collideMultiSphere(
+        o1,
+        o2,
+        static_cast<const dynamics::MultiSphereConvexHullShape*>(
+            shape1.get()),
+        true,
+        option,
+        result);
+  }
+  else if (dynamics::MultiSphereConvexHullShape::getStaticType() == shapeType2)
+  {
+    return collideMultiSphere(
+        o1,
+        o2,
+        static_cast<const dynamics::MultiSphereConvexHullShape*>(
+            shape2.get()),
+        false,
+        option,
+        result);
+  }
+
   if (dynamics::SphereShape::getStaticType() == shapeType1)
   {
     const auto* sphere0
@@ -5147,7 +6510,9 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh1->getSupportHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5352,7 +6717,8 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          mesh1->getSupportHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5433,7 +6799,9 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh1->getSupportHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5469,7 +6837,8 @@ int collide(
           box1->getSize(),
           T2,
           option,
-          result);
+          result,
+          mesh0->getSupportHull().get());
     }
     else if (dynamics::SphereShape::getStaticType() == shapeType2)
     {
@@ -5485,7 +6854,9 @@ int collide(
           sphere1->getRadius(),
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh0->getSupportHull().get());
     }
     else if (dynamics::EllipsoidShape::getStaticType() == shapeType2)
     {
@@ -5501,7 +6872,9 @@ int collide(
           ellipsoid1->getRadii()[0],
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh0->getSupportHull().get());
     }
     else if (dynamics::MeshShape::getStaticType() == shapeType2)
     {
@@ -5517,7 +6890,9 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          mesh0->getSupportHull().get(),
+          mesh1->getSupportHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5534,7 +6909,8 @@ int collide(
           capsule1->getRadius(),
           T2,
           option,
-          result);
+          result,
+          mesh0->getSupportHull().get());
     }
   }
   else if (dynamics::CapsuleShape::getStaticType() == shapeType1)
@@ -5603,7 +6979,8 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          mesh1->getSupportHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5632,5 +7009,576 @@ int collide(
   return false;
 }
 
+namespace {
+
+/// This is a convex shape for distance queries, split into a convex "core"
+/// that we run GJK on and a radius that rounds it off. Spheres are a point
+/// core and capsules are a segment core (both as zero-width boxes), so GJK
+/// converges exactly on them. This points into itself, so it must not be
+/// copied once it's been set up.
+struct DistanceShape
+{
+  ccdBox box;
+  ccdMesh mesh;
+  Eigen::Vector3s size;
+  const void* core;
+  ccd_support_fn support;
+  ccd_center_fn center;
+  s_t radius;
+};
+
+/// This sets up `out` for the shape of `o`, or returns false if we can't
+/// compute distances to that kind of shape
+bool initDistanceShape(CollisionObject* o, DistanceShape& out)
+{
+  const auto& shape = o->getShape();
+  const auto& shapeType = shape->getType();
+  const Eigen::Isometry3s& T = o->getTransform();
+
+  out.size.setZero();
+  out.box.size = &out.size;
+  out.box.transform = &T;
+  out.core = &out.box;
+  out.support = ccdSupportBox;
+  out.center = ccdCenterBox;
+  out.radius = 0.0;
+
+  if (dynamics::SphereShape::getStaticType() == shapeType)
+  {
+    out.radius
+        = static_cast<const dynamics::SphereShape*>(shape.get())->getRadius();
+  }
+  else if (dynamics::EllipsoidShape::getStaticType() == shapeType)
+  {
+    out.radius = static_cast<const dynamics::EllipsoidShape*>(shape.get())
+                     ->getRadii()[0];
+  }
+  else if (dynamics::BoxShape::getStaticType() == shapeType)
+  {
+    out.size = static_cast<const dynamics::BoxShape*>(shape.get())->getSize();
+  }
+  else if (dynamics::CapsuleShape::getStaticType() == shapeType)
+  {
+    const auto* capsule
+        = static_cast<const dynamics::CapsuleShape*>(shape.get());
+    out.size(2) = capsule->getHeight();
+    out.radius = capsule->getRadius();
+  }
+  else if (dynamics::MeshShape::getStaticType() == shapeType)
+  {
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape.get());
+    if (mesh->getMesh() == nullptr)
+      return false;
+    out.mesh.mesh = mesh->getMesh();
+    out.mesh.transform = &T;
+    out.mesh.scale = &mesh->getScale();
+    // The hull is owned by the shape, which `o` keeps alive
+    out.mesh.hull = mesh->getSupportHull().get();
+    out.mesh.supportHint = 0;
+    out.core = &out.mesh;
+    out.support = ccdSupportMesh;
+    out.center = ccdCenterMesh;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+/// This returns the furthest point on the core of `shape` along `dir`
+Eigen::Vector3s distanceSupport(
+    const DistanceShape& shape, const Eigen::Vector3s& dir)
+{
+  ccd_vec3_t ccdDir;
+  ccdDir.v[0] = static_cast<ccd_real_t>(dir(0));
+  ccdDir.v[1] = static_cast<ccd_real_t>(dir(1));
+  ccdDir.v[2] = static_cast<ccd_real_t>(dir(2));
+  ccd_vec3_t out;
+  shape.support(shape.core, &ccdDir, &out);
+  return Eigen::Vector3s(
+      static_cast<s_t>(out.v[0]),
+      static_cast<s_t>(out.v[1]),
+      static_cast<s_t>(out.v[2]));
+}
+
+/// This returns the approximate center of the core of `shape`
+Eigen::Vector3s distanceCenter(const DistanceShape& shape)
+{
+  ccd_vec3_t out;
+  shape.center(shape.core, &out);
+  return Eigen::Vector3s(
+      static_cast<s_t>(out.v[0]),
+      static_cast<s_t>(out.v[1]),
+      static_cast<s_t>(out.v[2]));
+}
+
+/// A vertex of the GJK simplex on the Minkowski difference A - B, along with
+/// the points on A and B that it came from
+struct GjkVertex
+{
+  Eigen::Vector3s w;
+  Eigen::Vector3s a;
+  Eigen::Vector3s b;
+};
+
+/// This finds the point on the hull of `simplex` (1 to 4 vertices) closest to
+/// the origin, and shrinks `simplex` down to the smallest face containing
+/// that point. `weights` gets the barycentric coordinates of the point on
+/// the remaining vertices. With at most 15 faces to try, brute force is both
+/// cheap and far more robust than Johnson's sub-algorithm.
+Eigen::Vector3s reduceGjkSimplex(
+    std::vector<GjkVertex>& simplex, std::vector<s_t>& weights)
+{
+  const int n = simplex.size();
+  s_t bestNorm = std::numeric_limits<s_t>::infinity();
+  int bestCount = 0;
+  int bestMask = 0;
+  Eigen::Vector3s bestPoint = simplex[0].w;
+  std::vector<s_t> bestWeights;
+  std::vector<int> indices;
+  for (int mask = 1; mask < (1 << n); mask++)
+  {
+    indices.clear();
+    for (int i = 0; i < n; i++)
+    {
+      if (mask & (1 << i))
+        indices.push_back(i);
+    }
+    const int k = indices.size();
+
+    // Solve for the closest point to the origin on the affine hull of this
+    // face, as w0 + sum_j mu_j (w_j - w0)
+    const Eigen::Vector3s& w0 = simplex[indices[0]].w;
+    Eigen::VectorXs mu = Eigen::VectorXs::Zero(k - 1);
+    if (k > 1)
+    {
+      Eigen::MatrixXs A(3, k - 1);
+      for (int j = 1; j < k; j++)
+      {
+        A.col(j - 1) = simplex[indices[j]].w - w0;
+      }
+      Eigen::FullPivLU<Eigen::MatrixXs> lu(A.transpose() * A);
+      if (lu.rank() < k - 1)
+        continue;
+      mu = lu.solve(-A.transpose() * w0);
+    }
+    std::vector<s_t> faceWeights(k);
+    faceWeights[0] = 1.0 - mu.sum();
+    for (int j = 1; j < k; j++)
+    {
+      faceWeights[j] = mu(j - 1);
+    }
+    // Points outside this face are handled by one of its sub-faces
+    if (*std::min_element(faceWeights.begin(), faceWeights.end()) < -1e-12)
+      continue;
+
+    Eigen::Vector3s point = Eigen::Vector3s::Zero();
+    for (int j = 0; j < k; j++)
+    {
+      point += faceWeights[j] * simplex[indices[j]].w;
+    }
+    s_t norm = point.norm();
+    // On ties, prefer the smaller face, so the simplex stays small
+    if (norm < bestNorm - 1e-15 || (norm <= bestNorm + 1e-15 && k < bestCount))
+    {
+      bestNorm = norm;
+      bestCount = k;
+      bestMask = mask;
+      bestPoint = point;
+      bestWeights = faceWeights;
+    }
+  }
+
+  if (bestMask == 0)
+  {
+    // Every face was degenerate, which GJK never builds, but fall back to the
+    // newest vertex rather than leaving garbage behind
+    GjkVertex last = simplex.back();
+    simplex.assign(1, last);
+    weights.assign(1, 1.0);
+    return last.w;
+  }
+
+  std::vector<GjkVertex> reduced;
+  for (int i = 0; i < n; i++)
+  {
+    if (bestMask & (1 << i))
+      reduced.push_back(simplex[i]);
+  }
+  simplex.swap(reduced);
+  weights.swap(bestWeights);
+  return bestPoint;
+}
+
+/// This runs GJK on the cores of `a` and `b`, and returns the distance
+/// between them, with the nearest points on each in pointA and pointB.
+/// Returns 0 if the cores overlap (pointA and pointB are then meaningless).
+s_t gjkCoreDistance(
+    const DistanceShape& a,
+    const DistanceShape& b,
+    Eigen::Vector3s& pointA,
+    Eigen::Vector3s& pointB)
+{
+  Eigen::Vector3s v = distanceCenter(a) - distanceCenter(b);
+  if (v.squaredNorm() < DART_GJK_ABSOLUTE_TOLERANCE)
+    v = Eigen::Vector3s::UnitX();
+
+  std::vector<GjkVertex> simplex;
+  std::vector<s_t> weights;
+  GjkVertex first;
+  first.a = distanceSupport(a, -v);
+  first.b = distanceSupport(b, v);
+  first.w = first.a - first.b;
+  simplex.push_back(first);
+  weights.push_back(1.0);
+  v = first.w;
+
+  for (int iter = 0; iter < DART_GJK_MAX_ITERATIONS; iter++)
+  {
+    s_t vNorm2 = v.squaredNorm();
+    if (vNorm2 <= DART_GJK_ABSOLUTE_TOLERANCE * DART_GJK_ABSOLUTE_TOLERANCE)
+      return 0.0;
+
+    GjkVertex next;
+    next.a = distanceSupport(a, -v);
+    next.b = distanceSupport(b, v);
+    next.w = next.a - next.b;
+
+    // If nothing in A - B is much closer along v than v itself, v is as
+    // close as we're going to get
+    if (vNorm2 - v.dot(next.w) <= DART_GJK_RELATIVE_TOLERANCE * vNorm2)
+      break;
+    bool repeated = false;
+    for (const GjkVertex& vertex : simplex)
+    {
+      if ((vertex.w - next.w).squaredNorm()
+          <= DART_GJK_RELATIVE_TOLERANCE * vNorm2)
+        repeated = true;
+    }
+    if (repeated)
+      break;
+
+    simplex.push_back(next);
+    v = reduceGjkSimplex(simplex, weights);
+  }
+  if (v.norm() <= DART_GJK_ABSOLUTE_TOLERANCE)
+    return 0.0;
+
+  pointA.setZero();
+  pointB.setZero();
+  for (std::size_t i = 0; i < simplex.size(); i++)
+  {
+    pointA += weights[i] * simplex[i].a;
+    pointB += weights[i] * simplex[i].b;
+  }
+  return v.norm();
+}
+
+} // namespace
+
+//==============================================================================
+bool computeSignedDistance(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    s_t& distance,
+    Eigen::Vector3s& point1,
+    Eigen::Vector3s& point2)
+{
+  DistanceShape a;
+  DistanceShape b;
+  if (!initDistanceShape(o1, a) || !initDistanceShape(o2, b))
+  {
+    dtwarn << "[DARTCollisionDetector] Attempting to compute the distance "
+           << "for an unsupported shape pair: [" << o1->getShape()->getType()
+           << "] - [" << o2->getShape()->getType() << "]. Skipping.\n";
+    return false;
+  }
+
+  Eigen::Vector3s coreA;
+  Eigen::Vector3s coreB;
+  s_t coreDistance = gjkCoreDistance(a, b, coreA, coreB);
+  if (coreDistance > 0)
+  {
+    // The rounded shapes are the cores grown by their radius, so the nearest
+    // points move out along the line between the cores
+    Eigen::Vector3s normal = (coreB - coreA) / coreDistance;
+    distance = coreDistance - a.radius - b.radius;
+    point1 = coreA + a.radius * normal;
+    point2 = coreB - b.radius * normal;
+    return true;
+  }
+
+  // The cores overlap, so fall back to MPR to find how deep
+  ccd_t ccd;
+  CCD_INIT(&ccd);
+  ccd.support1 = a.support;
+  ccd.support2 = b.support;
+  ccd.center1 = a.center;
+  ccd.center2 = b.center;
+  setCcdDefaultSettings(ccd);
+
+  ccd_real_t depth;
+  ccd_vec3_t dir;
+  ccd_vec3_t pos;
+  if (ccdMPRPenetration(a.core, b.core, &ccd, &depth, &dir, &pos) == 0)
+  {
+    Eigen::Vector3s normal(
+        static_cast<s_t>(dir.v[0]),
+        static_cast<s_t>(dir.v[1]),
+        static_cast<s_t>(dir.v[2]));
+    Eigen::Vector3s mid(
+        static_cast<s_t>(pos.v[0]),
+        static_cast<s_t>(pos.v[1]),
+        static_cast<s_t>(pos.v[2]));
+    s_t coreDepth = static_cast<s_t>(depth);
+    distance = -(coreDepth + a.radius + b.radius);
+    // `dir` points from the first object into the second, and `pos` sits
+    // halfway between the deepest points of the cores
+    point1 = mid + (coreDepth / 2 + a.radius) * normal;
+    point2 = mid - (coreDepth / 2 + b.radius) * normal;
+  }
+  else
+  {
+    // The cores just touch, so only the radii overlap
+    distance = -(a.radius + b.radius);
+    point1 = distanceCenter(a);
+    point2 = distanceCenter(b);
+  }
+  return true;
+}
+
+namespace {
+
+/// This is the first entry of a ray into the sphere of `radius` at `center`,
+/// in the same frame as the ray
+bool raycastSphere(
+    const Eigen::Vector3s& origin,
+    const Eigen::Vector3s& dir,
+    const Eigen::Vector3s& center,
+    s_t radius,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  Eigen::Vector3s offset = origin - center;
+  s_t a = dir.squaredNorm();
+  s_t b = offset.dot(dir);
+  s_t c = offset.squaredNorm() - radius * radius;
+  // c < 0 means we start inside
+  if (a == 0 || c < 0)
+    return false;
+  s_t disc = b * b - a * c;
+  if (disc < 0)
+    return false;
+  s_t hitT = (-b - std::sqrt(disc)) / a;
+  if (hitT < 0 || hitT > maxT)
+    return false;
+  t = hitT;
+  normal = (offset + hitT * dir) / radius;
+  return true;
+}
+
+/// This is the first entry of a ray into the box [-halfSize, halfSize]
+bool raycastBox(
+    const Eigen::Vector3s& origin,
+    const Eigen::Vector3s& dir,
+    const Eigen::Vector3s& halfSize,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  s_t tMin = -std::numeric_limits<s_t>::infinity();
+  s_t tMax = std::numeric_limits<s_t>::infinity();
+  int enterAxis = -1;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (dir(axis) == 0)
+    {
+      if (std::abs(origin(axis)) > halfSize(axis))
+        return false;
+      continue;
+    }
+    s_t t0 = (-halfSize(axis) - origin(axis)) / dir(axis);
+    s_t t1 = (halfSize(axis) - origin(axis)) / dir(axis);
+    if (t0 > t1)
+      std::swap(t0, t1);
+    if (t0 > tMin)
+    {
+      tMin = t0;
+      enterAxis = axis;
+    }
+    if (t1 < tMax)
+      tMax = t1;
+  }
+  // tMin < 0 means we start inside
+  if (enterAxis == -1 || tMin > tMax || tMin < 0 || tMin > maxT)
+    return false;
+  t = tMin;
+  normal.setZero();
+  normal(enterAxis) = dir(enterAxis) > 0 ? -1 : 1;
+  return true;
+}
+
+/// This is the first entry of a ray into a capsule along the z axis, with
+/// `height` between the centers of its end caps
+bool raycastCapsule(
+    const Eigen::Vector3s& origin,
+    const Eigen::Vector3s& dir,
+    s_t radius,
+    s_t height,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  s_t halfHeight = 0.5 * height;
+  Eigen::Vector3s axisPoint(
+      0, 0, std::max(-halfHeight, std::min(halfHeight, origin(2))));
+  if ((origin - axisPoint).squaredNorm() < radius * radius)
+    return false;
+
+  // The surface is the union of the side and the two caps, and we start
+  // outside all of them, so the first hit is the nearest of theirs
+  bool hit = false;
+  s_t a = dir(0) * dir(0) + dir(1) * dir(1);
+  if (a > 0)
+  {
+    s_t b = origin(0) * dir(0) + origin(1) * dir(1);
+    s_t c = origin(0) * origin(0) + origin(1) * origin(1) - radius * radius;
+    s_t disc = b * b - a * c;
+    if (disc >= 0)
+    {
+      s_t hitT = (-b - std::sqrt(disc)) / a;
+      s_t z = origin(2) + hitT * dir(2);
+      if (hitT >= 0 && hitT <= maxT && std::abs(z) <= halfHeight)
+      {
+        t = hitT;
+        maxT = hitT;
+        normal = Eigen::Vector3s(
+            (origin(0) + hitT * dir(0)) / radius,
+            (origin(1) + hitT * dir(1)) / radius,
+            0);
+        hit = true;
+      }
+    }
+  }
+  for (s_t z : {-halfHeight, halfHeight})
+  {
+    s_t capT;
+    Eigen::Vector3s capNormal;
+    if (raycastSphere(
+            origin,
+            dir,
+            Eigen::Vector3s(0, 0, z),
+            radius,
+            maxT,
+            capT,
+            capNormal))
+    {
+      t = capT;
+      maxT = capT;
+      normal = capNormal;
+      hit = true;
+    }
+  }
+  return hit;
+}
+
+} // namespace
+
+//==============================================================================
+bool raycastShape(
+    const CollisionObject* o,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& dir,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  const dynamics::Shape* shape = o->getShape().get();
+  const Eigen::Isometry3s& T = o->getTransform();
+  const std::string& type = shape->getType();
+
+  // Everything below works in the shape's frame, where t is unchanged
+  const Eigen::Vector3s localFrom = T.inverse() * from;
+  const Eigen::Vector3s localDir = T.linear().transpose() * dir;
+  Eigen::Vector3s localNormal;
+  bool hit = false;
+
+  if (type == dynamics::SphereShape::getStaticType())
+  {
+    const auto* sphere = static_cast<const dynamics::SphereShape*>(shape);
+    hit = raycastSphere(
+        localFrom,
+        localDir,
+        Eigen::Vector3s::Zero(),
+        sphere->getRadius(),
+        maxT,
+        t,
+        localNormal);
+  }
+  else if (type == dynamics::BoxShape::getStaticType())
+  {
+    const auto* box = static_cast<const dynamics::BoxShape*>(shape);
+    hit = raycastBox(
+        localFrom, localDir, 0.5 * box->getSize(), maxT, t, localNormal);
+  }
+  else if (type == dynamics::EllipsoidShape::getStaticType())
+  {
+    // Squash the ray so the ellipsoid becomes the unit sphere. Normals map
+    // back through the inverse transpose of the squash, which divides again.
+    const auto* ellipsoid = static_cast<const dynamics::EllipsoidShape*>(shape);
+    const Eigen::Vector3s radii = 0.5 * ellipsoid->getDiameters();
+    hit = raycastSphere(
+        localFrom.cwiseQuotient(radii),
+        localDir.cwiseQuotient(radii),
+        Eigen::Vector3s::Zero(),
+        1.0,
+        maxT,
+        t,
+        localNormal);
+    if (hit)
+      localNormal = localNormal.cwiseQuotient(radii).normalized();
+  }
+  else if (type == dynamics::CapsuleShape::getStaticType())
+  {
+    const auto* capsule = static_cast<const dynamics::CapsuleShape*>(shape);
+    hit = raycastCapsule(
+        localFrom,
+        localDir,
+        capsule->getRadius(),
+        capsule->getHeight(),
+        maxT,
+        t,
+        localNormal);
+  }
+  else if (type == dynamics::MeshShape::getStaticType())
+  {
+    // The BVH is over the unscaled mesh, so unscale the ray instead, the same
+    // way the ellipsoid does
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape);
+    std::shared_ptr<const math::TriangleBvh> bvh = mesh->getTriangleBvh();
+    if (!bvh)
+      return false;
+    const Eigen::Vector3s& scale = mesh->getScale();
+    hit = bvh->raycast(
+        localFrom.cwiseQuotient(scale),
+        localDir.cwiseQuotient(scale),
+        maxT,
+        t,
+        localNormal);
+    if (hit)
+      localNormal = localNormal.cwiseQuotient(scale).normalized();
+  }
+  else
+  {
+    return false;
+  }
+
+  if (hit)
+    normal = T.linear() * localNormal;
+  return hit;
+}
+
 } // namespace collision
 } // namespace dart
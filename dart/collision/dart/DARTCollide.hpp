@@ -43,6 +43,10 @@
 #include <ccd/vec3.h>
 
 #include "dart/collision/CollisionDetector.hpp"
+#include "dart/dynamics/HeightmapShape.hpp"
+#include "dart/dynamics/MultiSphereConvexHullShape.hpp"
+#include "dart/dynamics/PointCloudShape.hpp"
+#include "dart/math/SupportHull.hpp"
 
 namespace dart {
 namespace collision {
@@ -53,6 +57,32 @@ int collide(
     const CollisionOption& option,
     CollisionResult& result);
 
+/// This computes the signed distance between the shapes of o1 and o2: the gap
+/// between them if they're apart, or minus the penetration depth if they
+/// overlap. point1 and point2 are set to the nearest points on each shape (or
+/// the deepest points, if they overlap). This supports boxes, spheres,
+/// ellipsoids (treated as spheres, like collide() does), capsules and meshes,
+/// and returns false for any other shape.
+bool computeSignedDistance(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    s_t& distance,
+    Eigen::Vector3s& point1,
+    Eigen::Vector3s& point2);
+
+/// This finds where the segment `from + t * dir`, for t in [0, maxT], first
+/// enters the shape of o, and sets `t` and the unit world-space surface
+/// `normal` there. This supports boxes, spheres, ellipsoids, capsules and
+/// meshes (whose triangles are double sided), and returns false for any other
+/// shape. Rays that start inside a solid shape don't hit it.
+bool raycastShape(
+    const CollisionObject* o,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& dir,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal);
+
 /// This is for when we use the sphere collision routines for capsule-ends. If
 /// we have a capsule in deep inter-penetration with another object, we want to
 /// only detect collisions on one half of the sphere. This is easy to decide,
@@ -139,7 +169,8 @@ int collideMeshBox(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::SupportHull* hull0 = nullptr);
 
 int collideBoxMesh(
     CollisionObject* o1,
@@ -150,7 +181,8 @@ int collideBoxMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::SupportHull* hull1 = nullptr);
 
 int collideMeshSphere(
     CollisionObject* o1,
@@ -162,7 +194,8 @@ int collideMeshSphere(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH);
+    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH,
+    const math::SupportHull* hull0 = nullptr);
 
 int collideSphereMesh(
     CollisionObject* o1,
@@ -174,7 +207,8 @@ int collideSphereMesh(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH);
+    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH,
+    const math::SupportHull* hull1 = nullptr);
 
 int collideMeshMesh(
     CollisionObject* o1,
@@ -186,7 +220,9 @@ int collideMeshMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::SupportHull* hull0 = nullptr,
+    const math::SupportHull* hull1 = nullptr);
 
 int collideCapsuleCapsule(
     CollisionObject* o1,
@@ -254,7 +290,8 @@ int collideMeshCapsule(
     s_t radius1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::SupportHull* hull0 = nullptr);
 
 int collideCapsuleMesh(
     CollisionObject* o1,
@@ -266,7 +303,8 @@ int collideCapsuleMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::SupportHull* hull1 = nullptr);
 
 int collideCylinderSphere(
     CollisionObject* o1,
@@ -291,14 +329,70 @@ int collideCylinderPlane(
     const CollisionOption& option,
     CollisionResult& result);
 
+/// This collides a heightmap with a box, sphere, capsule or mesh. Only the
+/// grid cells under the other shape's bounding box get checked, so this costs
+/// the same no matter how large the terrain is. Each half of a grid cell is
+/// treated as a triangular prism that reaches below the lowest point of the
+/// terrain, and the contacts come from the same helpers as mesh contacts, so
+/// they carry everything we need for analytic gradients. `heightmapFirst` is
+/// true if `o1` holds the heightmap.
+int collideHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::HeightmapShapef* heightmap,
+    bool heightmapFirst,
+    const CollisionOption& option,
+    CollisionResult& result);
+
+/// This collides a heightmap with a box, sphere, capsule or mesh. See the
+/// float overload.
+int collideHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::HeightmapShaped* heightmap,
+    bool heightmapFirst,
+    const CollisionOption& option,
+    CollisionResult& result);
+
+/// This collides a point cloud with a sphere, box, capsule, mesh, or
+/// multi-sphere hull. Each point is a sphere with a diameter of the cloud's
+/// visual size. The cloud's sphere tree (see PointCloudShape::getSphereTree())
+/// picks out the points near the other shape's bounding box, and only those
+/// get a narrowphase, so this scales with the number of points touching the
+/// other shape rather than the size of the scan. Each of those points goes
+/// through the same sphere-vs-X code as a SphereShape would. `cloudFirst` is
+/// true if `o1` holds the point cloud. Point clouds don't collide with other
+/// point clouds or heightmaps.
+int collidePointCloud(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::PointCloudShape* cloud,
+    bool cloudFirst,
+    const CollisionOption& option,
+    CollisionResult& result);
+
+/// This collides the convex hull of a MultiSphereConvexHullShape with a
+/// sphere, box, capsule, mesh, or another multi-sphere hull, by running MPR
+/// on the hull's support function. `hullFirst` is true if `o1` holds the
+/// hull.
+int collideMultiSphere(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::MultiSphereConvexHullShape* hull,
+    bool hullFirst,
+    const CollisionOption& option,
+    CollisionResult& result);
+
 /////////////////////////////////////////////////////////////////////
 // Interface with libccd:
 /////////////////////////////////////////////////////////////////////
 
-// Get the `pos` vec for CCD for this pair of objects
+// Get the `pos` vec for CCD for this pair of objects. The cache is
+// thread_local, so the returned reference must not be shared across threads.
 ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2);
 
-// Get the `dir` vec for CCD for this pair of objects
+// Get the `dir` vec for CCD for this pair of objects. The cache is
+// thread_local, so the returned reference must not be shared across threads.
 ccd_vec3_t& getCachedCcdDir(CollisionObject* o1, CollisionObject* o2);
 
 // We need to define structs for each object type that we pass to libccd, with
@@ -320,6 +414,11 @@ struct ccdMesh
   const aiScene* mesh;
   const Eigen::Isometry3s* transform;
   const Eigen::Vector3s* scale;
+  // If this is set, support queries hill-climb over the precomputed convex
+  // hull instead of scanning every vertex of `mesh`
+  const math::SupportHull* hull = nullptr;
+  // The last support vertex we found on `hull`, where the next query starts
+  int supportHint = 0;
 };
 
 struct ccdCapsule
@@ -329,6 +428,12 @@ struct ccdCapsule
   const Eigen::Isometry3s* transform;
 };
 
+struct ccdMultiSphere
+{
+  const dynamics::MultiSphereConvexHullShape::Spheres* spheres;
+  const Eigen::Isometry3s* transform;
+};
+
 // We also need to define "support" functions that will find the furthest point
 // in the object along the direction "_dir", and return it in "_vec" for each
 // type of object.
@@ -339,6 +444,8 @@ void ccdSupportSphere(
 void ccdSupportMesh(const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out);
 void ccdSupportCapsule(
     const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out);
+void ccdSupportMultiSphere(
+    const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out);
 
 // Finally, we need to define the "center" function for objects. This returns
 // the approximate center of each object.
@@ -347,6 +454,7 @@ void ccdCenterBox(const void* _obj, ccd_vec3_t* _center);
 void ccdCenterSphere(const void* _obj, ccd_vec3_t* _center);
 void ccdCenterMesh(const void* _obj, ccd_vec3_t* _center);
 void ccdCenterCapsule(const void* _obj, ccd_vec3_t* _center);
+void ccdCenterMultiSphere(const void* _obj, ccd_vec3_t* _center);
 
 // In order to differentiate between different types of contact, we need to be
 // able to get all the vertices that are within some small epsilon of being on
@@ -356,6 +464,48 @@ std::vector<Eigen::Vector3s> ccdPointsAtWitnessBox(
     ccdBox* box, ccd_vec3_t* dir, bool neg);
 std::vector<Eigen::Vector3s> ccdPointsAtWitnessMesh(
     ccdMesh* mesh, ccd_vec3_t* dir, bool neg);
+std::vector<Eigen::Vector3s> ccdPointsAtWitnessMultiSphere(
+    const ccdMultiSphere* hull, ccd_vec3_t* dir, bool neg);
+
+// Before running GJK / MPR on a mesh, we can cheaply reject pairs whose
+// bounding volumes (from the mesh's SupportHull) are clearly apart. These all
+// return false if `hull` is nullptr, so they never skip a real check.
+
+/// This returns true if the bounding sphere of the mesh hull is separated from
+/// the sphere at `center` with `radius`
+bool hullMissesSphere(
+    const math::SupportHull* hull,
+    const Eigen::Vector3s& scale,
+    const Eigen::Isometry3s& T,
+    const Eigen::Vector3s& center,
+    s_t radius);
+
+/// This returns true if the bounding volumes of the mesh hull are separated
+/// from the box with `halfExtents` at `boxT`
+bool hullMissesBox(
+    const math::SupportHull* hull,
+    const Eigen::Vector3s& scale,
+    const Eigen::Isometry3s& T,
+    const Eigen::Vector3s& halfExtents,
+    const Eigen::Isometry3s& boxT);
+
+/// This returns true if the bounding volumes of two mesh hulls are separated
+bool hullsDisjoint(
+    const math::SupportHull* hull0,
+    const Eigen::Vector3s& scale0,
+    const Eigen::Isometry3s& T0,
+    const math::SupportHull* hull1,
+    const Eigen::Vector3s& scale1,
+    const Eigen::Isometry3s& T1);
+
+/// This runs the separating axis test on two oriented boxes, and returns true
+/// if they're apart by more than `margin`
+bool obbsDisjoint(
+    const Eigen::Vector3s& halfExtents0,
+    const Eigen::Isometry3s& T0,
+    const Eigen::Vector3s& halfExtents1,
+    const Eigen::Isometry3s& T1,
+    s_t margin);
 
 /// This is responsible for creating and annotating all the contact objects with
 /// all the metadata we need in order to get accurate gradients.
@@ -460,14 +610,16 @@ bool get2DLineIntersection(
 inline void setCcdDefaultSettings(ccd_t& ccd);
 
 /// This allows us to prevent weird effects where we don't want to carry over
-/// cacheing
+/// cacheing. This only forgets the warm starts on the calling thread, and is
+/// O(1): it bumps a generation counter, and entries from older generations are
+/// reset the next time they're looked up (or evicted, once enough of them
+/// pile up).
 void clearCcdCache();
 
-/// This is the static cache for all the CCD collision search data
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdDirCache;
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdPosCache;
+/// This returns the number of object pairs currently held in the calling
+/// thread's CCD warm-start cache, including stale entries that haven't been
+/// evicted yet. This is mostly useful for testing.
+std::size_t getCcdCacheSize();
 
 } // namespace collision
 } // namespace dart
@@ -32,27 +32,68 @@
 
 #include "dart/collision/dart/DARTCollisionDetector.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
 #include "dart/collision/CollisionFilter.hpp"
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/DistanceFilter.hpp"
 #include "dart/collision/dart/DARTCollide.hpp"
 #include "dart/collision/dart/DARTCollisionGroup.hpp"
 #include "dart/collision/dart/DARTCollisionObject.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/CapsuleShape.hpp"
 #include "dart/dynamics/EllipsoidShape.hpp"
+#include "dart/dynamics/HeightmapShape.hpp"
 #include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/MultiSphereConvexHullShape.hpp"
+#include "dart/dynamics/PointCloudShape.hpp"
 #include "dart/dynamics/ShapeFrame.hpp"
 #include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/RayBvh.hpp"
 
 namespace dart {
 namespace collision {
 
 namespace {
 
+/// This is a spatial hash over the contact points already reported by one
+/// collide() call, so checking a new point for a repeat only looks at the
+/// handful of points in neighboring cells instead of every contact so far.
+class ContactPointIndex
+{
+public:
+  ContactPointIndex(s_t tol);
+
+  /// This returns true (and remembers the point) if there's no point within
+  /// `tol` of `point` yet, and false if `point` is a repeat
+  bool insertIfNew(const Eigen::Vector3s& point);
+
+protected:
+  struct CellHash
+  {
+    std::size_t operator()(const Eigen::Matrix<long long, 3, 1>& cell) const;
+  };
+
+  s_t mTol;
+  std::unordered_map<
+      Eigen::Matrix<long long, 3, 1>,
+      std::vector<Eigen::Vector3s>,
+      CellHash>
+      mCells;
+};
+
 bool checkPair(
     CollisionObject* o1,
     CollisionObject* o2,
     const CollisionOption& option,
+    ContactPointIndex& index,
+    CollisionResult& pairResult,
     CollisionResult* result = nullptr);
 
 bool isClose(
@@ -63,7 +104,22 @@ void postProcess(
     CollisionObject* o2,
     const CollisionOption& option,
     CollisionResult& totalResult,
-    const CollisionResult& pairResult);
+    const CollisionResult& pairResult,
+    ContactPointIndex& index);
+
+// Contacts closer than this to one we've already reported are dropped
+const s_t CONTACT_REPEAT_TOL = 3.0e-12;
+
+double distanceOverCandidates(
+    const std::vector<DARTCollisionGroup::DistanceCandidate>& candidates,
+    const std::vector<CollisionObject*>& objects1,
+    const std::vector<CollisionObject*>& objects2,
+    const DistanceOption& option,
+    DistanceResult* result);
+
+// Rays in a batch are handed to the thread pool in packets of this many, so
+// each task amortizes its overhead over plenty of traversals
+const int RAY_PACKET_SIZE = 256;
 
 } // anonymous namespace
 
@@ -123,6 +179,17 @@ static bool checkGroupValidity(DARTCollisionDetector* cd, CollisionGroup* group)
   return true;
 }
 
+//==============================================================================
+static void fitBroadphaseMargin(
+    DARTCollisionGroup* group, const CollisionOption& option)
+{
+  // Two AABBs inflated by the margin still overlap when the shapes are up to
+  // twice the margin apart, so that's as far as speculative contacts can reach
+  s_t margin = 0.5 * option.speculativeContactDistance;
+  if (group->getBroadphaseMargin() < margin)
+    group->setBroadphaseMargin(margin);
+}
+
 //==============================================================================
 bool DARTCollisionDetector::collide(
     CollisionGroup* group,
@@ -144,33 +211,48 @@ bool DARTCollisionDetector::collide(
   if (objects.empty())
     return false;
 
+  // Cull the pairs whose AABBs don't overlap before running the narrowphase.
+  // The pairs come back in the same order as the brute force double loop, so
+  // the contacts we report are unchanged.
+  fitBroadphaseMargin(casted, option);
+  casted->updateEngineData();
+  // The group holds onto these buffers, so they stop allocating once they've
+  // grown to fit the busiest step
+  auto& pairs = casted->mPairBuffer;
+  casted->computeBroadphasePairs(pairs);
+  DARTCollisionGroup::cullSeparatedPrimitivePairs(
+      casted, casted, option.speculativeContactDistance, pairs);
+
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
+  ContactPointIndex index(CONTACT_REPEAT_TOL);
+  CollisionResult& pairResult = casted->mPairResult;
 
-  for (auto i = 0u; i < objects.size() - 1; ++i)
+  for (const auto& pair : pairs)
   {
-    auto* collObj1 = objects[i];
-
-    for (auto j = i + 1u; j < objects.size(); ++j)
-    {
-      auto* collObj2 = objects[j];
+    auto* collObj1 = objects[pair.first];
+    auto* collObj2 = objects[pair.second];
 
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+    if (filter
+        && filter->ignoresCollisionData(
+            casted->mFilterData[pair.first], casted->mFilterData[pair.second]))
+      continue;
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+    // Culled pairs never reach this point, so accumulate rather than only
+    // reporting whether the last visited pair happened to collide
+    if (checkPair(collObj1, collObj2, option, index, pairResult, result))
+      collisionFound = true;
 
-      if (result)
-      {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
-      {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
-      }
+    if (result)
+    {
+      if (result->getNumContacts() >= option.maxNumContacts)
+        return true;
+    }
+    else
+    {
+      // If no result is passed, stop checking when the first contact is found
+      if (collisionFound)
+        return true;
     }
   }
 
@@ -206,33 +288,46 @@ bool DARTCollisionDetector::collide(
   if (objects1.empty() || objects2.empty())
     return false;
 
+  fitBroadphaseMargin(casted1, option);
+  fitBroadphaseMargin(casted2, option);
+  casted1->updateEngineData();
+  casted2->updateEngineData();
+  auto& pairs = casted1->mPairBuffer;
+  DARTCollisionGroup::computeBroadphasePairs(casted1, casted2, pairs);
+  DARTCollisionGroup::cullSeparatedPrimitivePairs(
+      casted1, casted2, option.speculativeContactDistance, pairs);
+
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
+  ContactPointIndex index(CONTACT_REPEAT_TOL);
+  CollisionResult& pairResult = casted1->mPairResult;
 
-  for (auto i = 0u; i < objects1.size(); ++i)
+  for (const auto& pair : pairs)
   {
-    auto* collObj1 = objects1[i];
-
-    for (auto j = 0u; j < objects2.size(); ++j)
-    {
-      auto* collObj2 = objects2[j];
+    auto* collObj1 = objects1[pair.first];
+    auto* collObj2 = objects2[pair.second];
 
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+    if (filter
+        && filter->ignoresCollisionData(
+            casted1->mFilterData[pair.first],
+            casted2->mFilterData[pair.second]))
+      continue;
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+    // Culled pairs never reach this point, so accumulate rather than only
+    // reporting whether the last visited pair happened to collide
+    if (checkPair(collObj1, collObj2, option, index, pairResult, result))
+      collisionFound = true;
 
-      if (result)
-      {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
-      {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
-      }
+    if (result)
+    {
+      if (result->getNumContacts() >= option.maxNumContacts)
+        return true;
+    }
+    else
+    {
+      // If no result is passed, stop checking when the first contact is found
+      if (collisionFound)
+        return true;
     }
   }
 
@@ -242,27 +337,266 @@ bool DARTCollisionDetector::collide(
 
 //==============================================================================
 double DARTCollisionDetector::distance(
-    CollisionGroup* /*group*/,
-    const DistanceOption& /*option*/,
-    DistanceResult* /*result*/)
+    CollisionGroup* group,
+    const DistanceOption& option,
+    DistanceResult* result)
 {
-  dtwarn << "[DARTCollisionDetector::distance] This collision detector does "
-         << "not support (signed) distance queries. Returning 0.0.\n";
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group))
+    return 0.0;
+
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+  const auto& objects = casted->mCollisionObjects;
 
-  return 0.0;
+  if (objects.empty())
+    return 0.0;
+
+  casted->updateEngineData();
+  std::vector<DARTCollisionGroup::DistanceCandidate> candidates;
+  casted->computeBroadphaseDistanceCandidates(candidates);
+
+  return distanceOverCandidates(candidates, objects, objects, option, result);
 }
 
 //==============================================================================
 double DARTCollisionDetector::distance(
-    CollisionGroup* /*group1*/,
-    CollisionGroup* /*group2*/,
-    const DistanceOption& /*option*/,
-    DistanceResult* /*result*/)
+    CollisionGroup* group1,
+    CollisionGroup* group2,
+    const DistanceOption& option,
+    DistanceResult* result)
+{
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group1))
+    return 0.0;
+
+  if (!checkGroupValidity(this, group2))
+    return 0.0;
+
+  auto casted1 = static_cast<DARTCollisionGroup*>(group1);
+  auto casted2 = static_cast<DARTCollisionGroup*>(group2);
+
+  const auto& objects1 = casted1->mCollisionObjects;
+  const auto& objects2 = casted2->mCollisionObjects;
+
+  if (objects1.empty() || objects2.empty())
+    return 0.0;
+
+  casted1->updateEngineData();
+  casted2->updateEngineData();
+  std::vector<DARTCollisionGroup::DistanceCandidate> candidates;
+  DARTCollisionGroup::computeBroadphaseDistanceCandidates(
+      casted1, casted2, candidates);
+
+  return distanceOverCandidates(
+      candidates, objects1, objects2, option, result);
+}
+
+//==============================================================================
+bool DARTCollisionDetector::raycast(
+    CollisionGroup* group,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    const RaycastOption& option,
+    RaycastResult* result)
+{
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group))
+    return false;
+
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+  const auto& objects = casted->mCollisionObjects;
+
+  if (objects.empty())
+    return false;
+
+  casted->updateEngineData();
+
+  // A single ray doesn't pay for building a BVH, so just cull with the AABBs
+  // the broadphase already has. Fractions run from 0 at `from` to 1 at `to`.
+  const Eigen::Vector3s dir = to - from;
+  const Eigen::Vector3s invDir = dir.cwiseInverse();
+  const bool allHits = result && option.mEnableAllHits;
+  s_t maxT = 1.0;
+  RayHit closest;
+  bool hitFound = false;
+  for (std::size_t i = 0; i < objects.size(); i++)
+  {
+    s_t tEnter;
+    if (casted->mAabbMins[i].allFinite() && casted->mAabbMaxs[i].allFinite()
+        && !math::RayBvh::intersectBox(
+            from,
+            invDir,
+            casted->mAabbMins[i],
+            casted->mAabbMaxs[i],
+            maxT,
+            tEnter))
+      continue;
+
+    s_t t;
+    Eigen::Vector3s normal;
+    if (!raycastShape(objects[i], from, dir, maxT, t, normal))
+      continue;
+
+    hitFound = true;
+    RayHit hit;
+    hit.mCollisionObject = objects[i];
+    hit.mNormal = normal;
+    hit.mPoint = from + t * dir;
+    hit.mFraction = t;
+    if (allHits)
+    {
+      result->mRayHits.push_back(hit);
+    }
+    else
+    {
+      // Only the closest hit matters, so nothing behind this one can count
+      closest = hit;
+      maxT = t;
+    }
+  }
+
+  if (result && hitFound)
+  {
+    if (!allHits)
+    {
+      result->mRayHits.push_back(closest);
+    }
+    else if (option.mSortByClosest)
+    {
+      std::sort(
+          result->mRayHits.begin(),
+          result->mRayHits.end(),
+          [](const RayHit& a, const RayHit& b) {
+            return a.mFraction < b.mFraction;
+          });
+    }
+  }
+  if (result)
+    result->mHasHit = hitFound;
+
+  return hitFound;
+}
+
+//==============================================================================
+RaycastBatchResult DARTCollisionDetector::raycastBatch(
+    CollisionGroup* group,
+    const Eigen::MatrixXs& origins,
+    const Eigen::MatrixXs& directions,
+    int numThreads)
 {
-  dtwarn << "[DARTCollisionDetector::distance] This collision detector does "
-         << "not support (signed) distance queries. Returning 0.0.\n";
+  assert(origins.rows() == 3 && directions.rows() == 3);
+  assert(origins.cols() == directions.cols());
+  const int numRays = origins.cols();
+  RaycastBatchResult batch(numRays);
+
+  if (!checkGroupValidity(this, group))
+    return batch;
+
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+  const auto& objects = casted->mCollisionObjects;
+
+  if (objects.empty() || numRays == 0)
+    return batch;
+
+  casted->updateEngineData();
+
+  // The broadphase is sweep-and-prune, which doesn't help a ray, so build a
+  // BVH over the same AABBs once and share it across the whole batch
+  std::vector<Eigen::Vector3s> mins;
+  std::vector<Eigen::Vector3s> maxs;
+  std::vector<std::size_t> bounded;
+  for (std::size_t i = 0; i < objects.size(); i++)
+  {
+    if (casted->mAabbMins[i].allFinite() && casted->mAabbMaxs[i].allFinite())
+    {
+      mins.push_back(casted->mAabbMins[i]);
+      maxs.push_back(casted->mAabbMaxs[i]);
+      bounded.push_back(i);
+    }
+  }
+  const math::RayBvh bvh(mins, maxs);
+  const std::vector<std::size_t>& unbounded = casted->mUnboundedIndices;
+
+  // Each ray only writes its own entries of `batch`, so packets don't need to
+  // lock anything
+  auto castPacket = [&](int begin, int end) {
+    for (int r = begin; r < end; r++)
+    {
+      const Eigen::Vector3s from = origins.col(r);
+      const Eigen::Vector3s dir = directions.col(r);
+      s_t bestT = 1.0;
+      const CollisionObject* bestObject = nullptr;
+      Eigen::Vector3s bestNormal;
+      auto visit = [&](std::size_t index, s_t maxT) -> s_t {
+        s_t t;
+        Eigen::Vector3s normal;
+        if (raycastShape(objects[index], from, dir, maxT, t, normal))
+        {
+          bestT = t;
+          bestObject = objects[index];
+          bestNormal = normal;
+          return t;
+        }
+        return maxT;
+      };
+      for (std::size_t index : unbounded)
+      {
+        bestT = visit(index, bestT);
+      }
+      bvh.raycast(from, dir, bestT, [&](int box, s_t maxT) {
+        return visit(bounded[box], maxT);
+      });
+
+      if (bestObject != nullptr)
+      {
+        batch.mDistances(r) = bestT * dir.norm();
+        batch.mNormals.col(r) = bestNormal;
+        batch.mCollisionObjects[r] = bestObject;
+      }
+    }
+  };
+
+  const int numPackets = (numRays + RAY_PACKET_SIZE - 1) / RAY_PACKET_SIZE;
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  if (numThreads <= 0)
+    numThreads = pool.getNumThreads();
+  numThreads = std::max(1, std::min(numThreads, numPackets));
+  if (numThreads == 1)
+  {
+    castPacket(0, numRays);
+    return batch;
+  }
 
-  return 0.0;
+  std::atomic<int> nextPacket(0);
+  auto runWorker = [&]() {
+    while (true)
+    {
+      int packet = nextPacket.fetch_add(1);
+      if (packet >= numPackets)
+        break;
+      int begin = packet * RAY_PACKET_SIZE;
+      castPacket(begin, std::min(numRays, begin + RAY_PACKET_SIZE));
+    }
+  };
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < numThreads; i++)
+  {
+    futures.push_back(pool.submit(runWorker));
+  }
+  // Wait for every worker before get() can throw, since the workers refer to
+  // our stack
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+  return batch;
 }
 
 //==============================================================================
@@ -292,6 +626,16 @@ void warnUnsupportedShapeType(const dynamics::ShapeFrame* shapeFrame)
   if (shapeType == dynamics::CapsuleShape::getStaticType())
     return;
 
+  if (shapeType == dynamics::HeightmapShaped::getStaticType()
+      || shapeType == dynamics::HeightmapShapef::getStaticType())
+    return;
+
+  if (shapeType == dynamics::PointCloudShape::getStaticType())
+    return;
+
+  if (shapeType == dynamics::MultiSphereConvexHullShape::getStaticType())
+    return;
+
   if (shapeType == dynamics::EllipsoidShape::getStaticType())
   {
     const auto& ellipsoid
@@ -305,7 +649,8 @@ void warnUnsupportedShapeType(const dynamics::ShapeFrame* shapeFrame)
         << shapeType << "] that is not supported "
         << "by DARTCollisionDetector. Currently, only BoxShape and "
         << "EllipsoidShape (only when all the radii are equal) and SphereShape "
-           "and MeshShape and CapsuleShape are "
+           "and MeshShape and CapsuleShape and HeightmapShape and "
+           "PointCloudShape and MultiSphereConvexHullShape are "
         << "supported. This shape will always get penetrated by other "
         << "objects.\n";
 }
@@ -328,14 +673,73 @@ void DARTCollisionDetector::refreshCollisionObject(CollisionObject* /*object*/)
 
 namespace {
 
+//==============================================================================
+ContactPointIndex::ContactPointIndex(s_t tol) : mTol(tol)
+{
+}
+
+//==============================================================================
+bool ContactPointIndex::insertIfNew(const Eigen::Vector3s& point)
+{
+  // With cells as wide as the tolerance, anything close enough to count as a
+  // repeat has to be in the same cell or one of its 26 neighbors
+  Eigen::Vector3s scaled = point / mTol;
+
+  // We can't bucket NaNs, infinities, or points so far out that their cell
+  // index would overflow, so those always count as new
+  if (!scaled.allFinite() || scaled.cwiseAbs().maxCoeff() > 1e18)
+    return true;
+
+  Eigen::Matrix<long long, 3, 1> cell;
+  for (int i = 0; i < 3; i++)
+    cell(i) = static_cast<long long>(std::floor(scaled(i)));
+
+  for (long long dx = -1; dx <= 1; dx++)
+  {
+    for (long long dy = -1; dy <= 1; dy++)
+    {
+      for (long long dz = -1; dz <= 1; dz++)
+      {
+        auto found = mCells.find(
+            cell + Eigen::Matrix<long long, 3, 1>(dx, dy, dz));
+        if (found == mCells.end())
+          continue;
+        for (const Eigen::Vector3s& other : found->second)
+        {
+          if (isClose(point, other, mTol))
+            return false;
+        }
+      }
+    }
+  }
+
+  mCells[cell].push_back(point);
+  return true;
+}
+
+//==============================================================================
+std::size_t ContactPointIndex::CellHash::operator()(
+    const Eigen::Matrix<long long, 3, 1>& cell) const
+{
+  std::size_t seed = std::hash<long long>()(cell(0));
+  seed ^= std::hash<long long>()(cell(1)) + 0x9e3779b9 + (seed << 6)
+          + (seed >> 2);
+  seed ^= std::hash<long long>()(cell(2)) + 0x9e3779b9 + (seed << 6)
+          + (seed >> 2);
+  return seed;
+}
+
 //==============================================================================
 bool checkPair(
     CollisionObject* o1,
     CollisionObject* o2,
     const CollisionOption& option,
+    ContactPointIndex& index,
+    CollisionResult& pairResult,
     CollisionResult* result)
 {
-  CollisionResult pairResult;
+  // Reuse the caller's buffer, so its storage survives from pair to pair
+  pairResult.clear();
 
   // Perform narrow-phase detection
   collide(o1, o2, option, pairResult);
@@ -344,7 +748,7 @@ bool checkPair(
   if (!result)
     return pairResult.isCollision();
 
-  postProcess(o1, o2, option, *result, pairResult);
+  postProcess(o1, o2, option, *result, pairResult, index);
 
   return pairResult.isCollision();
 }
@@ -362,28 +766,16 @@ void postProcess(
     CollisionObject* o2,
     const CollisionOption& option,
     CollisionResult& totalResult,
-    const CollisionResult& pairResult)
+    const CollisionResult& pairResult,
+    ContactPointIndex& index)
 {
   if (!pairResult.isCollision())
     return;
 
-  // Don't add repeated points
-  const auto tol = 3.0e-12;
-
-  for (auto pairContact : pairResult.getContacts())
+  for (const auto& pairContact : pairResult.getContacts())
   {
-    auto foundClose = false;
-
-    for (auto totalContact : totalResult.getContacts())
-    {
-      if (isClose(pairContact.point, totalContact.point, tol))
-      {
-        foundClose = true;
-        break;
-      }
-    }
-
-    if (foundClose)
+    // Don't add repeated points
+    if (!index.insertIfNew(pairContact.point))
       continue;
 
     auto contact = pairContact;
@@ -396,6 +788,79 @@ void postProcess(
   }
 }
 
+//==============================================================================
+double distanceOverCandidates(
+    const std::vector<DARTCollisionGroup::DistanceCandidate>& candidates,
+    const std::vector<CollisionObject*>& objects1,
+    const std::vector<CollisionObject*>& objects2,
+    const DistanceOption& option,
+    DistanceResult* result)
+{
+  const auto& filter = option.distanceFilter;
+
+  bool found = false;
+  s_t minDistance = std::numeric_limits<s_t>::infinity();
+  CollisionObject* nearest1 = nullptr;
+  CollisionObject* nearest2 = nullptr;
+  Eigen::Vector3s nearestPoint1 = Eigen::Vector3s::Zero();
+  Eigen::Vector3s nearestPoint2 = Eigen::Vector3s::Zero();
+
+  for (const auto& candidate : candidates)
+  {
+    // Candidates are sorted by their lower bound, so once that's no better
+    // than what we have, nothing left can be either
+    if (found && candidate.lowerBound >= minDistance)
+      break;
+
+    auto* collObj1 = objects1[candidate.first];
+    auto* collObj2 = objects2[candidate.second];
+
+    if (filter && !filter->needDistance(collObj1, collObj2))
+      continue;
+
+    s_t pairDistance;
+    Eigen::Vector3s point1;
+    Eigen::Vector3s point2;
+    if (!computeSignedDistance(
+            collObj1, collObj2, pairDistance, point1, point2))
+      continue;
+
+    if (!found || pairDistance < minDistance)
+    {
+      found = true;
+      minDistance = pairDistance;
+      nearest1 = collObj1;
+      nearest2 = collObj2;
+      nearestPoint1 = point1;
+      nearestPoint2 = point2;
+    }
+
+    if (minDistance <= option.distanceLowerBound)
+      break;
+  }
+
+  if (!found)
+    return 0.0;
+
+  const double unclamped = static_cast<double>(minDistance);
+  const double clamped = std::max(unclamped, option.distanceLowerBound);
+
+  if (result)
+  {
+    result->minDistance = clamped;
+    result->unclampedMinDistance = unclamped;
+    result->shapeFrame1 = nearest1->getShapeFrame();
+    result->shapeFrame2 = nearest2->getShapeFrame();
+    if (option.enableNearestPoints)
+    {
+      result->nearestPoint1 = nearestPoint1;
+      result->nearestPoint2 = nearestPoint2;
+    }
+  }
+
+  return clamped;
+}
+
 } // anonymous namespace
 
 } // namespace collision
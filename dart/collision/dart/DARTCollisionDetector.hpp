@@ -87,6 +87,23 @@ public:
       const DistanceOption& option = DistanceOption(false, 0.0, nullptr),
       DistanceResult* result = nullptr) override;
 
+  // Documentation inherited
+  bool raycast(
+      CollisionGroup* group,
+      const Eigen::Vector3s& from,
+      const Eigen::Vector3s& to,
+      const RaycastOption& option = RaycastOption(),
+      RaycastResult* result = nullptr) override;
+
+  /// This builds a BVH over the AABBs of the objects in the group once, and
+  /// then traverses it for packets of rays in parallel on the global thread
+  /// pool.
+  RaycastBatchResult raycastBatch(
+      CollisionGroup* group,
+      const Eigen::MatrixXs& origins,
+      const Eigen::MatrixXs& directions,
+      int numThreads = 0) override;
+
 protected:
 
   /// Constructor
@@ -32,7 +32,14 @@
 
 #include "dart/collision/dart/DARTCollisionGroup.hpp"
 
+#include <algorithm>
+#include <limits>
+
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/Shape.hpp"
+#include "dart/dynamics/SphereShape.hpp"
 
 namespace dart {
 namespace collision {
@@ -40,11 +47,453 @@ namespace collision {
 //==============================================================================
 DARTCollisionGroup::DARTCollisionGroup(
     const CollisionDetectorPtr& collisionDetector)
-  : CollisionGroup(collisionDetector)
+  : CollisionGroup(collisionDetector),
+    mSweepAxis(0),
+    mBroadphaseMargin(1e-3),
+    mBroadphaseStructureDirty(true)
 {
   // Do nothing
 }
 
+//==============================================================================
+void DARTCollisionGroup::setBroadphaseMargin(s_t margin)
+{
+  mBroadphaseMargin = margin;
+  // Every AABB is inflated by the margin, so they all need to be refit
+  mRefitStates.clear();
+}
+
+//==============================================================================
+s_t DARTCollisionGroup::getBroadphaseMargin() const
+{
+  return mBroadphaseMargin;
+}
+
+//==============================================================================
+void DARTCollisionGroup::refitBroadphase()
+{
+  const std::size_t numObjects = mCollisionObjects.size();
+  mAabbMins.resize(numObjects);
+  mAabbMaxs.resize(numObjects);
+  mBoundingCenters.resize(numObjects);
+  mBoundingRadii.resize(numObjects);
+
+  // Gathering this once per object here saves every candidate pair from
+  // chasing the same pointers through the filter
+  mFilterData.resize(numObjects);
+  for (std::size_t i = 0; i < numObjects; i++)
+  {
+    mFilterData[i] = CollisionFilterData(mCollisionObjects[i]);
+  }
+
+  // Objects are indexed by position in mCollisionObjects, so any change to
+  // the structure invalidates everything we remember about them
+  if (mBroadphaseStructureDirty || mRefitStates.size() != numObjects)
+  {
+    mRefitStates.clear();
+  }
+  mRefitStates.resize(numObjects);
+
+  // Refit the world-space AABBs of the objects that moved or changed shape
+  // since the last refit. Anything static keeps the AABB it got when it was
+  // added.
+  std::vector<bool> bounded(numObjects, true);
+  Eigen::Vector3s centerSum = Eigen::Vector3s::Zero();
+  Eigen::Vector3s centerSqSum = Eigen::Vector3s::Zero();
+  std::size_t numBounded = 0;
+  for (std::size_t i = 0; i < numObjects; i++)
+  {
+    CollisionObject* object = mCollisionObjects[i];
+    const dynamics::ShapeFrame* frame = object->getShapeFrame();
+    const dynamics::ConstShapePtr shape = object->getShape();
+    const std::size_t transformVersion = frame->getTransformVersion();
+    const std::size_t shapeVersion = shape->getVersion();
+
+    RefitState& state = mRefitStates[i];
+    if (!state.mValid || state.mShape != shape.get()
+        || state.mShapeVersion != shapeVersion
+        || state.mTransformVersion != transformVersion)
+    {
+      const auto& box = shape->getBoundingBox();
+      const Eigen::Isometry3s& T = object->getTransform();
+
+      const Eigen::Vector3s localCenter = box.computeCenter();
+      const Eigen::Vector3s localHalfExtents
+          = box.computeHalfExtents().cwiseAbs();
+      const Eigen::Vector3s center = T * localCenter;
+      const Eigen::Vector3s halfExtents
+          = T.linear().cwiseAbs() * localHalfExtents
+            + Eigen::Vector3s::Constant(mBroadphaseMargin);
+
+      mAabbMins[i] = center - halfExtents;
+      mAabbMaxs[i] = center + halfExtents;
+
+      mBoundingCenters[i] = center;
+      if (shape->is<dynamics::SphereShape>() || shape->is<dynamics::BoxShape>()
+          || shape->is<dynamics::CapsuleShape>())
+        mBoundingRadii[i] = localHalfExtents.norm();
+      else
+        mBoundingRadii[i] = std::numeric_limits<s_t>::infinity();
+
+      state.mValid = true;
+      state.mShape = shape.get();
+      state.mShapeVersion = shapeVersion;
+      state.mTransformVersion = transformVersion;
+    }
+
+    if (!mAabbMins[i].allFinite() || !mAabbMaxs[i].allFinite())
+    {
+      bounded[i] = false;
+      continue;
+    }
+
+    const Eigen::Vector3s center = 0.5 * (mAabbMins[i] + mAabbMaxs[i]);
+    centerSum += center;
+    centerSqSum += center.cwiseProduct(center);
+    numBounded++;
+  }
+
+  // Sweep along the axis where the objects are most spread out
+  int bestAxis = mSweepAxis;
+  if (numBounded > 1)
+  {
+    const Eigen::Vector3s mean = centerSum / (s_t)numBounded;
+    const Eigen::Vector3s variance
+        = centerSqSum / (s_t)numBounded - mean.cwiseProduct(mean);
+    variance.maxCoeff(&bestAxis);
+  }
+
+  if (mBroadphaseStructureDirty
+      || mSortedIndices.size() + mUnboundedIndices.size() != numObjects)
+  {
+    mSortedIndices.clear();
+    mUnboundedIndices.clear();
+    for (std::size_t i = 0; i < numObjects; i++)
+    {
+      if (bounded[i])
+        mSortedIndices.push_back(i);
+      else
+        mUnboundedIndices.push_back(i);
+    }
+    mBroadphaseStructureDirty = false;
+    mSweepAxis = -1;
+  }
+  else
+  {
+    // An object may have moved between being bounded and unbounded (for
+    // example, if its shape was resized to something degenerate), so we need
+    // to double check the partition before sorting.
+    bool partitionValid = true;
+    for (std::size_t index : mSortedIndices)
+    {
+      if (!bounded[index])
+      {
+        partitionValid = false;
+        break;
+      }
+    }
+    for (std::size_t index : mUnboundedIndices)
+    {
+      if (bounded[index])
+      {
+        partitionValid = false;
+        break;
+      }
+    }
+    if (!partitionValid)
+    {
+      mBroadphaseStructureDirty = true;
+      refitBroadphase();
+      return;
+    }
+  }
+
+  const auto lessAlongAxis = [this, bestAxis](std::size_t a, std::size_t b) {
+    return mAabbMins[a](bestAxis) < mAabbMins[b](bestAxis);
+  };
+
+  if (bestAxis != mSweepAxis)
+  {
+    // The previous order is useless along a new axis, so sort from scratch
+    std::sort(mSortedIndices.begin(), mSortedIndices.end(), lessAlongAxis);
+    mSweepAxis = bestAxis;
+  }
+  else
+  {
+    // Objects usually only move a little between steps, so the previous order
+    // is nearly sorted, and insertion sort fixes it up in close to O(n)
+    for (std::size_t i = 1; i < mSortedIndices.size(); i++)
+    {
+      const std::size_t index = mSortedIndices[i];
+      std::size_t j = i;
+      while (j > 0 && lessAlongAxis(index, mSortedIndices[j - 1]))
+      {
+        mSortedIndices[j] = mSortedIndices[j - 1];
+        j--;
+      }
+      mSortedIndices[j] = index;
+    }
+  }
+}
+
+//==============================================================================
+void DARTCollisionGroup::computeBroadphasePairs(
+    std::vector<std::pair<std::size_t, std::size_t>>& pairs) const
+{
+  pairs.clear();
+  const int axis = mSweepAxis < 0 ? 0 : mSweepAxis;
+
+  for (std::size_t a = 0; a < mSortedIndices.size(); a++)
+  {
+    const std::size_t i = mSortedIndices[a];
+    const s_t maxAlongAxis = mAabbMaxs[i](axis);
+    for (std::size_t b = a + 1; b < mSortedIndices.size(); b++)
+    {
+      const std::size_t j = mSortedIndices[b];
+      // Everything after this starts past the end of object i along the sweep
+      // axis, so it can't overlap
+      if (mAabbMins[j](axis) > maxAlongAxis)
+        break;
+      if (aabbsOverlap(i, this, j) && layersAllow(i, this, j))
+        pairs.emplace_back(std::min(i, j), std::max(i, j));
+    }
+  }
+
+  for (std::size_t a = 0; a < mUnboundedIndices.size(); a++)
+  {
+    const std::size_t i = mUnboundedIndices[a];
+    for (std::size_t j = 0; j < mCollisionObjects.size(); j++)
+    {
+      if (i == j)
+        continue;
+      // Avoid emitting pairs of two unbounded objects twice
+      if (j < i
+          && std::find(
+                 mUnboundedIndices.begin(), mUnboundedIndices.end(), j)
+                 != mUnboundedIndices.end())
+        continue;
+      if (layersAllow(i, this, j))
+        pairs.emplace_back(std::min(i, j), std::max(i, j));
+    }
+  }
+
+  std::sort(pairs.begin(), pairs.end());
+}
+
+//==============================================================================
+void DARTCollisionGroup::computeBroadphasePairs(
+    const DARTCollisionGroup* group1,
+    const DARTCollisionGroup* group2,
+    std::vector<std::pair<std::size_t, std::size_t>>& pairs)
+{
+  pairs.clear();
+  const int axis = group1->mSweepAxis < 0 ? 0 : group1->mSweepAxis;
+
+  // Both lists need to be sorted along the same axis for the sweep
+  std::vector<std::size_t> sorted2Copy;
+  const std::vector<std::size_t>* sorted2 = &group2->mSortedIndices;
+  if (group2->mSweepAxis != axis)
+  {
+    sorted2Copy = group2->mSortedIndices;
+    std::sort(
+        sorted2Copy.begin(),
+        sorted2Copy.end(),
+        [group2, axis](std::size_t a, std::size_t b) {
+          return group2->mAabbMins[a](axis) < group2->mAabbMins[b](axis);
+        });
+    sorted2 = &sorted2Copy;
+  }
+  const std::vector<std::size_t>& sorted1 = group1->mSortedIndices;
+
+  // Sweep both lists at once. Whichever object starts first along the axis
+  // gets checked against every object from the other list that starts before
+  // it ends.
+  std::size_t a = 0;
+  std::size_t b = 0;
+  while (a < sorted1.size() && b < sorted2->size())
+  {
+    const std::size_t i = sorted1[a];
+    const std::size_t j = (*sorted2)[b];
+    if (group1->mAabbMins[i](axis) < group2->mAabbMins[j](axis))
+    {
+      const s_t maxAlongAxis = group1->mAabbMaxs[i](axis);
+      for (std::size_t k = b; k < sorted2->size(); k++)
+      {
+        const std::size_t other = (*sorted2)[k];
+        if (group2->mAabbMins[other](axis) > maxAlongAxis)
+          break;
+        if (group1->aabbsOverlap(i, group2, other)
+            && group1->layersAllow(i, group2, other))
+          pairs.emplace_back(i, other);
+      }
+      a++;
+    }
+    else
+    {
+      const s_t maxAlongAxis = group2->mAabbMaxs[j](axis);
+      for (std::size_t k = a; k < sorted1.size(); k++)
+      {
+        const std::size_t other = sorted1[k];
+        if (group1->mAabbMins[other](axis) > maxAlongAxis)
+          break;
+        if (group1->aabbsOverlap(other, group2, j)
+            && group1->layersAllow(other, group2, j))
+          pairs.emplace_back(other, j);
+      }
+      b++;
+    }
+  }
+
+  for (std::size_t i : group1->mUnboundedIndices)
+    for (std::size_t j = 0; j < group2->mCollisionObjects.size(); j++)
+      if (group1->layersAllow(i, group2, j))
+        pairs.emplace_back(i, j);
+  for (std::size_t j : group2->mUnboundedIndices)
+    for (std::size_t i = 0; i < group1->mCollisionObjects.size(); i++)
+      if (std::find(
+              group1->mUnboundedIndices.begin(),
+              group1->mUnboundedIndices.end(),
+              i)
+              == group1->mUnboundedIndices.end()
+          && group1->layersAllow(i, group2, j))
+        pairs.emplace_back(i, j);
+
+  std::sort(pairs.begin(), pairs.end());
+}
+
+//==============================================================================
+void DARTCollisionGroup::cullSeparatedPrimitivePairs(
+    const DARTCollisionGroup* group1,
+    const DARTCollisionGroup* group2,
+    s_t speculativeDistance,
+    std::vector<std::pair<std::size_t, std::size_t>>& pairs)
+{
+  const std::size_t numPairs = pairs.size();
+  if (numPairs == 0)
+    return;
+
+  // Gathering everything into flat arrays first turns the test itself into
+  // one branch-free pass that the compiler can vectorize. The extra slack
+  // covers narrowphases that accept shapes that are just barely touching.
+  const s_t slack = speculativeDistance + 1e-6;
+  Eigen::Matrix<s_t, 3, Eigen::Dynamic> deltas(3, numPairs);
+  Eigen::Array<s_t, 1, Eigen::Dynamic> reach(numPairs);
+  for (std::size_t k = 0; k < numPairs; k++)
+  {
+    const std::size_t i = pairs[k].first;
+    const std::size_t j = pairs[k].second;
+    deltas.col(k)
+        = group1->mBoundingCenters[i] - group2->mBoundingCenters[j];
+    reach(k) = group1->mBoundingRadii[i] + group2->mBoundingRadii[j] + slack;
+  }
+  const Eigen::Array<s_t, 1, Eigen::Dynamic> distSq
+      = deltas.colwise().squaredNorm().array();
+  const Eigen::Array<s_t, 1, Eigen::Dynamic> reachSq = reach.square();
+
+  // Keep the survivors in their original order, so the contacts we report
+  // don't change. Pairs with non-finite positions are kept too, and left for
+  // the narrowphase to deal with like before.
+  std::size_t numKept = 0;
+  for (std::size_t k = 0; k < numPairs; k++)
+  {
+    if (!(distSq(k) > reachSq(k)))
+      pairs[numKept++] = pairs[k];
+  }
+  pairs.resize(numKept);
+}
+
+//==============================================================================
+void DARTCollisionGroup::computeBroadphaseDistanceCandidates(
+    std::vector<DistanceCandidate>& candidates) const
+{
+  candidates.clear();
+  const std::size_t numObjects = mCollisionObjects.size();
+  candidates.reserve(numObjects * (numObjects - 1) / 2);
+  for (std::size_t i = 0; i < numObjects; i++)
+  {
+    for (std::size_t j = i + 1; j < numObjects; j++)
+    {
+      candidates.push_back(DistanceCandidate{aabbGap(i, this, j), i, j});
+    }
+  }
+  // Stable, so that ties are visited in the same order as a double loop
+  std::stable_sort(
+      candidates.begin(),
+      candidates.end(),
+      [](const DistanceCandidate& a, const DistanceCandidate& b) {
+        return a.lowerBound < b.lowerBound;
+      });
+}
+
+//==============================================================================
+void DARTCollisionGroup::computeBroadphaseDistanceCandidates(
+    const DARTCollisionGroup* group1,
+    const DARTCollisionGroup* group2,
+    std::vector<DistanceCandidate>& candidates)
+{
+  candidates.clear();
+  candidates.reserve(
+      group1->mCollisionObjects.size() * group2->mCollisionObjects.size());
+  for (std::size_t i = 0; i < group1->mCollisionObjects.size(); i++)
+  {
+    for (std::size_t j = 0; j < group2->mCollisionObjects.size(); j++)
+    {
+      candidates.push_back(
+          DistanceCandidate{group1->aabbGap(i, group2, j), i, j});
+    }
+  }
+  std::stable_sort(
+      candidates.begin(),
+      candidates.end(),
+      [](const DistanceCandidate& a, const DistanceCandidate& b) {
+        return a.lowerBound < b.lowerBound;
+      });
+}
+
+//==============================================================================
+bool DARTCollisionGroup::aabbsOverlap(
+    std::size_t i, const DARTCollisionGroup* other, std::size_t j) const
+{
+  const Eigen::Vector3s& min1 = mAabbMins[i];
+  const Eigen::Vector3s& max1 = mAabbMaxs[i];
+  const Eigen::Vector3s& min2 = other->mAabbMins[j];
+  const Eigen::Vector3s& max2 = other->mAabbMaxs[j];
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (min1(axis) > max2(axis) || min2(axis) > max1(axis))
+      return false;
+  }
+  return true;
+}
+
+//==============================================================================
+bool DARTCollisionGroup::layersAllow(
+    std::size_t i, const DARTCollisionGroup* other, std::size_t j) const
+{
+  return !CollisionFilterData::layersExclude(
+      mFilterData[i], other->mFilterData[j]);
+}
+
+//==============================================================================
+s_t DARTCollisionGroup::aabbGap(
+    std::size_t i, const DARTCollisionGroup* other, std::size_t j) const
+{
+  const Eigen::Vector3s& min1 = mAabbMins[i];
+  const Eigen::Vector3s& max1 = mAabbMaxs[i];
+  const Eigen::Vector3s& min2 = other->mAabbMins[j];
+  const Eigen::Vector3s& max2 = other->mAabbMaxs[j];
+  Eigen::Vector3s gap = Eigen::Vector3s::Zero();
+  for (int axis = 0; axis < 3; axis++)
+  {
+    gap(axis) = std::max(
+        (s_t)0.0, std::max(min2(axis) - max1(axis), min1(axis) - max2(axis)));
+  }
+  // Unbounded objects give us NaNs or infinities, which tell us nothing
+  if (!gap.allFinite())
+    return 0.0;
+  return gap.norm();
+}
+
 //==============================================================================
 void DARTCollisionGroup::initializeEngineData()
 {
@@ -58,6 +507,7 @@ void DARTCollisionGroup::addCollisionObjectToEngine(CollisionObject* object)
       == mCollisionObjects.end())
   {
     mCollisionObjects.push_back(object);
+    mBroadphaseStructureDirty = true;
   }
 }
 
@@ -74,19 +524,22 @@ void DARTCollisionGroup::removeCollisionObjectFromEngine(
     CollisionObject* object)
 {
   mCollisionObjects.erase(
-      std::remove(mCollisionObjects.begin(), mCollisionObjects.end(), object));
+      std::remove(mCollisionObjects.begin(), mCollisionObjects.end(), object),
+      mCollisionObjects.end());
+  mBroadphaseStructureDirty = true;
 }
 
 //==============================================================================
 void DARTCollisionGroup::removeAllCollisionObjectsFromEngine()
 {
   mCollisionObjects.clear();
+  mBroadphaseStructureDirty = true;
 }
 
 //==============================================================================
 void DARTCollisionGroup::updateCollisionGroupEngineData()
 {
-  // Do nothing
+  refitBroadphase();
 }
 
 }  // namespace collision
@@ -33,7 +33,16 @@
 #ifndef DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 #define DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/collision/CollisionFilter.hpp"
 #include "dart/collision/CollisionGroup.hpp"
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/math/MathTypes.hpp"
 
 namespace dart {
 namespace collision {
@@ -46,12 +55,87 @@ public:
 
   friend class DARTCollisionDetector;
 
+  /// A pair of objects for a distance query, along with a lower bound on how
+  /// far apart they can be
+  struct DistanceCandidate
+  {
+    s_t lowerBound;
+    std::size_t first;
+    std::size_t second;
+  };
+
   /// Constructor
   DARTCollisionGroup(const CollisionDetectorPtr& collisionDetector);
 
   /// Destructor
   virtual ~DARTCollisionGroup() = default;
 
+  /// Set the distance by which every world-space AABB is inflated in the
+  /// broadphase. Pairs whose inflated AABBs don't overlap are never sent to the
+  /// narrowphase, so this must be at least as large as any contact tolerance
+  /// used by the narrowphase.
+  void setBroadphaseMargin(s_t margin);
+
+  /// Get the distance by which every world-space AABB is inflated in the
+  /// broadphase.
+  s_t getBroadphaseMargin() const;
+
+  /// Refit the AABBs of all the objects in this group to their current
+  /// transforms, and re-sort the sweep-and-prune axis. Only objects whose
+  /// ShapeFrame has been dirtied (see Entity::getTransformVersion()), or whose
+  /// Shape has changed, get their AABB recomputed. This is cheap when objects
+  /// have only moved a little since the last call, because the sorted order is
+  /// repaired with an insertion sort. This also regathers the
+  /// CollisionFilterData of every object.
+  void refitBroadphase();
+
+  /// Fill pairs with the (i < j) indices into the collision objects of this
+  /// group whose AABBs overlap, and whose collision layers and masks allow
+  /// them to collide. The pairs are sorted lexicographically, which
+  /// is the same order a brute force double loop would visit them in. This
+  /// assumes refitBroadphase() has already been called.
+  void computeBroadphasePairs(
+      std::vector<std::pair<std::size_t, std::size_t>>& pairs) const;
+
+  /// Fill pairs with the (i, j) indices of objects from group1 and group2,
+  /// respectively, whose AABBs overlap and whose collision layers and masks
+  /// allow them to collide. The pairs are sorted
+  /// lexicographically. This assumes refitBroadphase() has already been
+  /// called on both groups.
+  static void computeBroadphasePairs(
+      const DARTCollisionGroup* group1,
+      const DARTCollisionGroup* group2,
+      std::vector<std::pair<std::size_t, std::size_t>>& pairs);
+
+  /// Remove the (i, j) pairs of objects from group1 and group2 whose bounding
+  /// spheres are more than `speculativeDistance` apart, keeping the rest in
+  /// order. Only spheres, boxes and capsules have finite bounding spheres, and
+  /// their narrowphases never report contacts further apart than that, so
+  /// this never drops a contact. The test runs over all the pairs at once, as
+  /// one vectorizable pass. This assumes refitBroadphase() has already been
+  /// called on both groups.
+  static void cullSeparatedPrimitivePairs(
+      const DARTCollisionGroup* group1,
+      const DARTCollisionGroup* group2,
+      s_t speculativeDistance,
+      std::vector<std::pair<std::size_t, std::size_t>>& pairs);
+
+  /// Fill candidates with every (i < j) pair of objects in this group, each
+  /// with the gap between their AABBs as a lower bound on their distance,
+  /// sorted from nearest to furthest. A distance query can stop as soon as
+  /// the next lower bound is no better than the best distance found so far.
+  /// This assumes refitBroadphase() has already been called.
+  void computeBroadphaseDistanceCandidates(
+      std::vector<DistanceCandidate>& candidates) const;
+
+  /// Fill candidates with every (i, j) pair of objects from group1 and
+  /// group2, respectively, sorted by the AABB lower bound on their distance.
+  /// This assumes refitBroadphase() has already been called on both groups.
+  static void computeBroadphaseDistanceCandidates(
+      const DARTCollisionGroup* group1,
+      const DARTCollisionGroup* group2,
+      std::vector<DistanceCandidate>& candidates);
+
 protected:
 
   // Documentation inherited
@@ -75,9 +159,84 @@ protected:
 
 protected:
 
+  /// Returns true if the world-space AABBs of objects i (in this group) and j
+  /// (in other) overlap
+  bool aabbsOverlap(
+      std::size_t i, const DARTCollisionGroup* other, std::size_t j) const;
+
+  /// Returns true if the collision layers and masks of objects i (in this
+  /// group) and j (in other) allow them to collide
+  bool layersAllow(
+      std::size_t i, const DARTCollisionGroup* other, std::size_t j) const;
+
+  /// Returns the distance between the world-space AABBs of objects i (in this
+  /// group) and j (in other), or 0 if they overlap or either is unbounded
+  s_t aabbGap(
+      std::size_t i, const DARTCollisionGroup* other, std::size_t j) const;
+
   /// CollisionObjects added to this DARTCollisionGroup
   std::vector<CollisionObject*> mCollisionObjects;
 
+  /// The world-space AABB minimums for each entry in mCollisionObjects, as of
+  /// the last refitBroadphase()
+  std::vector<Eigen::Vector3s> mAabbMins;
+
+  /// The world-space AABB maximums for each entry in mCollisionObjects, as of
+  /// the last refitBroadphase()
+  std::vector<Eigen::Vector3s> mAabbMaxs;
+
+  /// The world-space centers of spheres bounding each entry in
+  /// mCollisionObjects, as of the last refitBroadphase()
+  std::vector<Eigen::Vector3s> mBoundingCenters;
+
+  /// The radii of the spheres in mBoundingCenters. This is infinite for shapes
+  /// whose narrowphase isn't guaranteed to stay inside them (anything other
+  /// than spheres, boxes and capsules).
+  std::vector<s_t> mBoundingRadii;
+
+  /// The filter data for each entry in mCollisionObjects, as of the last
+  /// refitBroadphase()
+  std::vector<CollisionFilterData> mFilterData;
+
+  /// What an entry in mCollisionObjects looked like when its AABB was last
+  /// computed
+  struct RefitState
+  {
+    bool mValid = false;
+    const dynamics::Shape* mShape = nullptr;
+    std::size_t mShapeVersion = 0;
+    std::size_t mTransformVersion = 0;
+  };
+
+  /// The RefitState of each entry in mCollisionObjects. This gets cleared
+  /// whenever objects are added or removed, or the margin changes.
+  std::vector<RefitState> mRefitStates;
+
+  /// Indices into mCollisionObjects of the objects with finite AABBs, sorted by
+  /// their AABB minimum along mSweepAxis
+  std::vector<std::size_t> mSortedIndices;
+
+  /// Indices into mCollisionObjects of the objects with infinite (or
+  /// undefined) AABBs, which are paired with everything
+  std::vector<std::size_t> mUnboundedIndices;
+
+  /// The axis (0 = x, 1 = y, 2 = z) that mSortedIndices is sorted along
+  int mSweepAxis;
+
+  /// The distance by which to inflate every AABB
+  s_t mBroadphaseMargin;
+
+  /// This gets set whenever objects are added or removed, so that the next
+  /// refitBroadphase() rebuilds the sorted index from scratch
+  bool mBroadphaseStructureDirty;
+
+  /// Scratch space for the candidate pairs of a collision query, kept between
+  /// queries so it doesn't get reallocated every step
+  std::vector<std::pair<std::size_t, std::size_t>> mPairBuffer;
+
+  /// Scratch space for the contacts of a single pair during a collision query
+  CollisionResult mPairResult;
+
 };
 
 }  // namespace collision
@@ -56,6 +56,9 @@ public:
   /// Returns true if this container contains the pair.
   bool contains(const T* left, const T* right) const;
 
+  /// Returns true if this container has no pairs.
+  bool empty() const;
+
 private:
   /// The actual container to store pairs.
   ///
@@ -147,6 +150,13 @@ bool UnorderedPairs<T>::contains(const T* left, const T* right) const
   return false;
 }
 
+//==============================================================================
+template <class T>
+bool UnorderedPairs<T>::empty() const
+{
+  return mList.empty();
+}
+
 } // namespace detail
 } // namespace collision
 } // namespace dart
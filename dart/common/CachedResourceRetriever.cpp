@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "dart/common/CachedResourceRetriever.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define DART_CACHED_RESOURCE_USE_MMAP
+#endif
+
+#include "dart/common/Console.hpp"
+
+namespace dart {
+namespace common {
+
+namespace {
+
+/// The bytes of a single cached resource, either memory-mapped from a file or
+/// copied into memory we own
+class CachedContents
+{
+public:
+  explicit CachedContents(std::string owned)
+    : mOwned(std::move(owned)), mMapped(nullptr), mSize(mOwned.size())
+  {
+  }
+
+  CachedContents(void* mapped, std::size_t size)
+    : mMapped(mapped), mSize(size)
+  {
+  }
+
+  ~CachedContents()
+  {
+#ifdef DART_CACHED_RESOURCE_USE_MMAP
+    if (mMapped != nullptr)
+      munmap(mMapped, mSize);
+#endif
+  }
+
+  CachedContents(const CachedContents& _other) = delete;
+  CachedContents& operator=(const CachedContents& _other) = delete;
+
+  const char* data() const
+  {
+    return mMapped != nullptr ? static_cast<const char*>(mMapped)
+                              : mOwned.data();
+  }
+
+  std::size_t size() const
+  {
+    return mSize;
+  }
+
+private:
+  std::string mOwned;
+  void* mMapped;
+  std::size_t mSize;
+};
+
+using CachedContentsPtr = std::shared_ptr<const CachedContents>;
+
+/// A Resource that reads out of CachedContents. It keeps the contents alive,
+/// so it stays valid even if the cache evicts them.
+class CachedResource : public virtual Resource
+{
+public:
+  explicit CachedResource(CachedContentsPtr contents)
+    : mContents(std::move(contents)), mPosition(0)
+  {
+  }
+
+  // Documentation inherited.
+  std::size_t getSize() override
+  {
+    return mContents->size();
+  }
+
+  // Documentation inherited.
+  std::size_t tell() override
+  {
+    return mPosition;
+  }
+
+  // Documentation inherited.
+  bool seek(ptrdiff_t _offset, SeekType _mode) override
+  {
+    ptrdiff_t origin;
+    switch (_mode)
+    {
+      case Resource::SEEKTYPE_CUR:
+        origin = mPosition;
+        break;
+      case Resource::SEEKTYPE_END:
+        origin = mContents->size();
+        break;
+      case Resource::SEEKTYPE_SET:
+        origin = 0;
+        break;
+      default:
+        dtwarn << "[CachedResource::seek] Invalid origin. Expected"
+                  " SEEKTYPE_CUR, SEEKTYPE_END, or SEEKTYPE_SET.\n";
+        return false;
+    }
+
+    const ptrdiff_t position = origin + _offset;
+    if (position < 0)
+    {
+      dtwarn << "[CachedResource::seek] Failed seeking to a negative"
+                " offset.\n";
+      return false;
+    }
+    mPosition = position;
+    return true;
+  }
+
+  // Documentation inherited.
+  std::size_t read(
+      void* _buffer, std::size_t _size, std::size_t _count) override
+  {
+    if (_size == 0 || mPosition >= mContents->size())
+      return 0;
+
+    // Like fread, only whole elements count
+    const std::size_t remaining = mContents->size() - mPosition;
+    const std::size_t count = std::min(_count, remaining / _size);
+    std::memcpy(_buffer, mContents->data() + mPosition, count * _size);
+    mPosition += count * _size;
+    return count;
+  }
+
+  // Documentation inherited.
+  std::string readAll() override
+  {
+    return std::string(mContents->data(), mContents->size());
+  }
+
+private:
+  CachedContentsPtr mContents;
+  std::size_t mPosition;
+};
+
+/// Enough about a file to tell if it has changed since we cached it
+struct FileStamp
+{
+  std::size_t size = 0;
+  long long inode = 0;
+  long long mtimeNanos = 0;
+
+  bool operator==(const FileStamp& other) const
+  {
+    return size == other.size && inode == other.inode
+           && mtimeNanos == other.mtimeNanos;
+  }
+};
+
+/// This fills in `stamp` for the file at `path`, and returns false if it
+/// can't be stat'd
+bool statFile(const std::string& path, FileStamp& stamp)
+{
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0 || !(info.st_mode & S_IFREG))
+    return false;
+  stamp.size = static_cast<std::size_t>(info.st_size);
+  stamp.inode = static_cast<long long>(info.st_ino);
+#if defined(__APPLE__)
+  stamp.mtimeNanos = info.st_mtimespec.tv_sec * 1000000000LL
+                     + info.st_mtimespec.tv_nsec;
+#elif defined(__unix__)
+  stamp.mtimeNanos
+      = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#else
+  stamp.mtimeNanos = info.st_mtime * 1000000000LL;
+#endif
+  return true;
+}
+
+/// Files smaller than this get copied into memory instead of mapped. Small
+/// files (model descriptions, configs) are the ones likely to be edited in
+/// place, and mapping them saves next to nothing.
+constexpr std::size_t MIN_MAPPED_FILE_BYTES = 64 * 1024;
+
+/// This memory-maps the file at `path`, or returns nullptr if we can't (or
+/// it's too small to be worth it)
+CachedContentsPtr mapFile(const std::string& path, std::size_t size)
+{
+#ifdef DART_CACHED_RESOURCE_USE_MMAP
+  if (size < MIN_MAPPED_FILE_BYTES)
+    return nullptr;
+
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed
+  close(fd);
+  if (mapped == MAP_FAILED)
+    return nullptr;
+  return std::make_shared<CachedContents>(mapped, size);
+#else
+  (void)path;
+  (void)size;
+  return nullptr;
+#endif
+}
+
+struct CacheEntry
+{
+  CachedContentsPtr contents;
+  /// The local file these contents came from, or "" if there isn't one
+  std::string path;
+  FileStamp stamp;
+  std::list<std::string>::iterator lruPosition;
+};
+
+/// The cache shared by every CachedResourceRetriever
+struct SharedCache
+{
+  std::mutex mutex;
+  std::unordered_map<std::string, CacheEntry> entries;
+  /// Keys, most recently used first
+  std::list<std::string> lru;
+  std::size_t cachedBytes = 0;
+  std::size_t maxBytes = 512 * 1024 * 1024;
+
+  /// This must be called while holding `mutex`
+  void erase(std::unordered_map<std::string, CacheEntry>::iterator it)
+  {
+    cachedBytes -= it->second.contents->size();
+    lru.erase(it->second.lruPosition);
+    entries.erase(it);
+  }
+
+  /// This must be called while holding `mutex`
+  void evictDownTo(std::size_t budget)
+  {
+    while (cachedBytes > budget && !lru.empty())
+      erase(entries.find(lru.back()));
+  }
+};
+
+SharedCache& getSharedCache()
+{
+  static SharedCache cache;
+  return cache;
+}
+
+/// Local files are cached under their URI, so every CachedResourceRetriever
+/// shares them. Anything else might resolve differently depending on the
+/// delegate (for example, package:// URIs), so those keys are private to one
+/// retriever instance.
+std::string getCacheKey(const Uri& uri, int retrieverId)
+{
+  if (uri.mScheme.get_value_or("file") == "file")
+    return uri.toString();
+  std::stringstream key;
+  key << "#" << retrieverId << ":" << uri.toString();
+  return key.str();
+}
+
+std::atomic<int> nextRetrieverId(0);
+
+/// This returns the cached contents for `uri`, or nullptr if there aren't
+/// any (or they came from a file that has since changed)
+CachedContentsPtr lookup(const Uri& uri, int retrieverId)
+{
+  SharedCache& cache = getSharedCache();
+  const std::string key = getCacheKey(uri, retrieverId);
+
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.entries.find(key);
+    if (it == cache.entries.end())
+      return nullptr;
+    path = it->second.path;
+    if (path.empty())
+    {
+      cache.lru.splice(cache.lru.begin(), cache.lru, it->second.lruPosition);
+      return it->second.contents;
+    }
+  }
+
+  // Check the file hasn't changed underneath us. This is a lot cheaper than
+  // re-reading it, but we don't want to do it while holding the lock.
+  FileStamp stamp;
+  const bool stillThere = statFile(path, stamp);
+
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto it = cache.entries.find(key);
+  if (it == cache.entries.end())
+    return nullptr;
+  if (!stillThere || !(stamp == it->second.stamp))
+  {
+    cache.erase(it);
+    return nullptr;
+  }
+  cache.lru.splice(cache.lru.begin(), cache.lru, it->second.lruPosition);
+  return it->second.contents;
+}
+
+/// This returns the contents for `uri`, loading them through `delegate` and
+/// caching them on a miss. Returns nullptr if `delegate` can't provide them.
+CachedContentsPtr fetch(
+    const ResourceRetrieverPtr& delegate, const Uri& uri, int retrieverId)
+{
+  CachedContentsPtr hit = lookup(uri, retrieverId);
+  if (hit)
+    return hit;
+
+  std::string path;
+  if (uri.mScheme.get_value_or("file") == "file")
+  {
+    if (uri.mPath)
+      path = uri.getFilesystemPath();
+  }
+  else
+  {
+    path = delegate->getFilePath(uri);
+  }
+
+  CacheEntry entry;
+  if (!path.empty() && statFile(path, entry.stamp))
+  {
+    entry.path = path;
+    entry.contents = mapFile(path, entry.stamp.size);
+  }
+  if (!entry.contents)
+  {
+    const ResourcePtr resource = delegate->retrieve(uri);
+    if (!resource)
+      return nullptr;
+    try
+    {
+      entry.contents = std::make_shared<CachedContents>(resource->readAll());
+    }
+    catch (const std::runtime_error& e)
+    {
+      dtwarn << "[CachedResourceRetriever::retrieve] " << e.what() << "\n";
+      return nullptr;
+    }
+  }
+
+  SharedCache& cache = getSharedCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  if (entry.contents->size() > cache.maxBytes)
+    return entry.contents;
+
+  const std::string key = getCacheKey(uri, retrieverId);
+  // Another thread may have loaded this while we were
+  auto existing = cache.entries.find(key);
+  if (existing != cache.entries.end())
+    cache.erase(existing);
+
+  cache.evictDownTo(cache.maxBytes - entry.contents->size());
+  cache.lru.push_front(key);
+  entry.lruPosition = cache.lru.begin();
+  cache.cachedBytes += entry.contents->size();
+  CachedContentsPtr contents = entry.contents;
+  cache.entries.emplace(key, std::move(entry));
+  return contents;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+CachedResourceRetriever::CachedResourceRetriever(
+    const ResourceRetrieverPtr& delegate)
+  : mDelegate(delegate), mId(nextRetrieverId++)
+{
+}
+
+//==============================================================================
+bool CachedResourceRetriever::exists(const Uri& _uri)
+{
+  if (lookup(_uri, mId) != nullptr)
+    return true;
+  return mDelegate->exists(_uri);
+}
+
+//==============================================================================
+ResourcePtr CachedResourceRetriever::retrieve(const Uri& _uri)
+{
+  CachedContentsPtr contents = fetch(mDelegate, _uri, mId);
+  if (!contents)
+    return nullptr;
+  return std::make_shared<CachedResource>(contents);
+}
+
+//==============================================================================
+std::string CachedResourceRetriever::readAll(const Uri& uri)
+{
+  CachedContentsPtr contents = fetch(mDelegate, uri, mId);
+  if (!contents)
+  {
+    std::stringstream ss;
+    ss << "Failed to retrieve a resource from URI [" << uri.toString()
+       << "].";
+    throw std::runtime_error(ss.str());
+  }
+  return std::string(contents->data(), contents->size());
+}
+
+//==============================================================================
+std::string CachedResourceRetriever::getFilePath(const Uri& uri)
+{
+  return mDelegate->getFilePath(uri);
+}
+
+//==============================================================================
+ResourceRetrieverPtr CachedResourceRetriever::getDelegate() const
+{
+  return mDelegate;
+}
+
+//==============================================================================
+void CachedResourceRetriever::setMaxCacheBytes(std::size_t maxBytes)
+{
+  SharedCache& cache = getSharedCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.maxBytes = maxBytes;
+  cache.evictDownTo(maxBytes);
+}
+
+//==============================================================================
+std::size_t CachedResourceRetriever::getMaxCacheBytes()
+{
+  SharedCache& cache = getSharedCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  return cache.maxBytes;
+}
+
+//==============================================================================
+std::size_t CachedResourceRetriever::getCachedBytes()
+{
+  SharedCache& cache = getSharedCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  return cache.cachedBytes;
+}
+
+//==============================================================================
+void CachedResourceRetriever::clearCache()
+{
+  SharedCache& cache = getSharedCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.entries.clear();
+  cache.lru.clear();
+  cache.cachedBytes = 0;
+}
+
+} // namespace common
+} // namespace dart
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef DART_COMMON_CACHEDRESOURCERETRIEVER_HPP_
+#define DART_COMMON_CACHEDRESOURCERETRIEVER_HPP_
+
+#include <cstddef>
+#include <string>
+
+#include "dart/common/ResourceRetriever.hpp"
+
+namespace dart {
+namespace common {
+
+/// CachedResourceRetriever wraps another ResourceRetriever, and keeps the
+/// contents of recently retrieved resources in memory so that loading the
+/// same meshes and package files over and over (for example, when opening
+/// many copies of a skeleton) only touches the filesystem once. Large
+/// resources that resolve to a local file are memory-mapped rather than
+/// copied, where the platform supports it. Replace those files (write a new
+/// one and rename it over the old one) rather than rewriting them in place,
+/// or resources already handed out will see the new bytes.
+///
+/// The cache is shared by every CachedResourceRetriever in the process, so
+/// parsers that each build their own retriever still share contents. It is
+/// bounded by setMaxCacheBytes(), evicting the least recently used entries
+/// first. Entries backed by a file are re-read if the file is replaced, or
+/// its size or modification time changes.
+class CachedResourceRetriever : public virtual ResourceRetriever
+{
+public:
+  explicit CachedResourceRetriever(const ResourceRetrieverPtr& delegate);
+
+  virtual ~CachedResourceRetriever() = default;
+
+  // Documentation inherited.
+  bool exists(const Uri& _uri) override;
+
+  // Documentation inherited.
+  ResourcePtr retrieve(const Uri& _uri) override;
+
+  // Documentation inherited.
+  std::string readAll(const Uri& uri) override;
+
+  // Documentation inherited.
+  std::string getFilePath(const Uri& uri) override;
+
+  /// Returns the retriever that cache misses are forwarded to
+  ResourceRetrieverPtr getDelegate() const;
+
+  /// Sets the most memory the shared cache will hold onto. Resources bigger
+  /// than this are never cached. Defaults to 512MB.
+  static void setMaxCacheBytes(std::size_t maxBytes);
+
+  /// Returns the most memory the shared cache will hold onto
+  static std::size_t getMaxCacheBytes();
+
+  /// Returns how many bytes of resource contents the shared cache is holding
+  static std::size_t getCachedBytes();
+
+  /// Drops everything from the shared cache. Resources that were already
+  /// retrieved stay valid.
+  static void clearCache();
+
+private:
+  ResourceRetrieverPtr mDelegate;
+  /// Keys for URIs that only this delegate knows how to resolve are tagged
+  /// with this, so they never collide with another retriever's
+  int mId;
+};
+
+using CachedResourceRetrieverPtr = std::shared_ptr<CachedResourceRetriever>;
+
+} // namespace common
+} // namespace dart
+
+#endif // ifndef DART_COMMON_CACHEDRESOURCERETRIEVER_HPP_
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COMMON_PIPELINE_HPP_
+#define DART_COMMON_PIPELINE_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dart {
+namespace common {
+
+/// These are the running totals for one stage of a Pipeline
+struct PipelineStageStats
+{
+  std::string name;
+  int numWorkers = 0;
+  int queueCapacity = 0;
+  /// Items the stage finished without throwing
+  int itemsProcessed = 0;
+  /// Items the stage threw on, which were dropped from the pipeline
+  int itemsFailed = 0;
+  /// Total time spent inside the stage function, summed over workers
+  double busySeconds = 0.0;
+  /// Total time workers sat waiting for an item to arrive
+  double waitingForInputSeconds = 0.0;
+  /// Total time workers sat waiting for room in the next stage's queue. If
+  /// this is large, the next stage is the bottleneck.
+  double waitingForOutputSeconds = 0.0;
+  /// The most items ever waiting in this stage's input queue at once
+  int maxQueueDepth = 0;
+  /// Items processed per second of wall time since start()
+  double itemsPerSecond = 0.0;
+  /// busySeconds, as a fraction of the time all the workers were alive
+  double utilization = 0.0;
+};
+
+/// This records an item that a stage threw on
+struct PipelineFailure
+{
+  /// The position the item was pushed in
+  int index;
+  std::string stage;
+  std::string message;
+};
+
+/// This runs items through a series of stages, with a fixed number of
+/// threads per stage, and a bounded queue in front of each stage. Each stage
+/// picks items up as soon as the stage before it is done with them, so
+/// stages work on different items at the same time. For example, a subject's
+/// trials can go through
+///
+///   load (C3D / TRC) -> clean up (flips, labels, GRFs) -> fit -> ID -> export
+///
+/// with the next trial's files loading while this one is being fit. Stages
+/// that are I/O bound can get more workers than they'd need for compute, and
+/// stages that are already parallel inside (like MarkerFitter, which uses the
+/// global ThreadPool) can get just one. The queues stop fast stages from
+/// running far ahead of slow ones and filling up memory.
+///
+/// Stage threads are dedicated threads, not ThreadPool workers, so a stage
+/// blocked on I/O never holds up compute on the global pool.
+///
+/// T is the type of the work item, which each stage edits in place. It has
+/// to be movable. If a stage throws, the item is dropped, and the error is
+/// recorded in getFailures().
+template <typename T>
+class Pipeline
+{
+public:
+  using StageFunction = std::function<void(T&)>;
+
+  Pipeline();
+
+  /// If the pipeline is still running, this finishes it first
+  ~Pipeline();
+
+  Pipeline(const Pipeline&) = delete;
+  Pipeline& operator=(const Pipeline&) = delete;
+
+  /// This adds a stage to the end of the pipeline, which runs `fn` on every
+  /// item on `numWorkers` threads, and holds up to `queueCapacity` items
+  /// waiting for those threads. Stages can only be added while the pipeline
+  /// isn't running.
+  Pipeline& addStage(
+      const std::string& name,
+      StageFunction fn,
+      int numWorkers = 1,
+      int queueCapacity = 2);
+
+  /// This returns the number of stages
+  int getNumStages() const;
+
+  /// This starts the stage threads. Statistics, failures and results from
+  /// any previous run are cleared.
+  void start();
+
+  /// This feeds an item into the first stage, blocking while its queue is
+  /// full. This returns the position of the item, which is what finish()
+  /// orders results by. Call start() first.
+  int push(T item);
+
+  /// This waits for every pushed item to get through the pipeline, stops the
+  /// stage threads, and returns the items that made it through every stage,
+  /// in the order they were pushed
+  std::vector<T> finish();
+
+  /// This is start(), push() on every item, then finish()
+  std::vector<T> run(std::vector<T> items);
+
+  /// This returns true between start() and finish()
+  bool isRunning() const;
+
+  /// This returns the statistics for each stage. This is safe to call while
+  /// the pipeline is running, to watch its progress.
+  std::vector<PipelineStageStats> getStageStats() const;
+
+  /// This returns the items that stages threw on in the last run
+  std::vector<PipelineFailure> getFailures() const;
+
+protected:
+  struct Slot
+  {
+    int index;
+    T item;
+  };
+
+  /// This is a blocking FIFO with a fixed capacity. Once it's closed, pushes
+  /// are dropped, and pops return false as soon as it's empty.
+  class BoundedQueue
+  {
+  public:
+    explicit BoundedQueue(int capacity);
+
+    /// This blocks while the queue is full, and returns the seconds spent
+    /// blocked
+    double push(std::unique_ptr<Slot> slot);
+
+    /// This blocks while the queue is empty and still open, and returns false
+    /// if it's closed and drained. `waited` gets the seconds spent blocked.
+    bool pop(std::unique_ptr<Slot>& slot, double& waited);
+
+    void close();
+
+    int getMaxDepth() const;
+
+  protected:
+    int mCapacity;
+    bool mClosed;
+    int mMaxDepth;
+    std::deque<std::unique_ptr<Slot>> mSlots;
+    mutable std::mutex mMutex;
+    std::condition_variable mNotEmpty;
+    std::condition_variable mNotFull;
+  };
+
+  struct Stage
+  {
+    std::string name;
+    StageFunction fn;
+    int numWorkers;
+    int queueCapacity;
+    std::unique_ptr<BoundedQueue> input;
+    // Workers still running, so the last one out can close the next queue
+    int liveWorkers;
+    PipelineStageStats stats;
+  };
+
+  /// The loop each worker of stage `s` runs
+  void workerLoop(int s);
+
+  std::vector<std::unique_ptr<Stage>> mStages;
+  std::vector<std::thread> mThreads;
+  bool mRunning;
+  int mNumPushed;
+  std::chrono::steady_clock::time_point mStartTime;
+  std::chrono::steady_clock::time_point mEndTime;
+
+  std::vector<std::unique_ptr<Slot>> mResults;
+  std::vector<PipelineFailure> mFailures;
+  // Guards the stats, mResults, and mFailures
+  mutable std::mutex mMutex;
+};
+
+} // namespace common
+} // namespace dart
+
+#include "dart/common/detail/Pipeline-impl.hpp"
+
+#endif // DART_COMMON_PIPELINE_HPP_
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/common/ThreadPool.hpp"
+
+#include <cstdlib>
+#include <string>
+
+#include "dart/common/Console.hpp"
+
+namespace dart {
+namespace common {
+
+namespace {
+
+/// The pool (if any) that owns the calling thread, and which worker it is
+thread_local const ThreadPool* tlsOwningPool = nullptr;
+thread_local std::size_t tlsWorkerIndex = 0;
+
+std::mutex gGlobalPoolMutex;
+std::unique_ptr<ThreadPool> gGlobalPool;
+
+std::atomic<bool> gDeterministic(false);
+
+/// This is what deterministic mode tracks for each running task, and for each
+/// thread outside of any task
+struct TaskContext
+{
+  std::uint64_t seed = 0;
+  /// The number of tasks this context has submitted so far
+  std::uint64_t numSubmitted = 0;
+  /// This is only created if the task asks for it
+  std::unique_ptr<std::mt19937> generator;
+};
+
+thread_local TaskContext tlsThreadContext;
+/// The task running on the calling thread, or nullptr. Workers that run
+/// other tasks while they wait() nest these, so each task restores the
+/// previous one when it finishes.
+thread_local TaskContext* tlsTaskContext = nullptr;
+
+//==============================================================================
+/// This is splitmix64, which gives well spread out seeds for neighboring
+/// child indices
+std::uint64_t mixSeed(std::uint64_t seed, std::uint64_t index)
+{
+  std::uint64_t z = seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+//==============================================================================
+std::size_t getDefaultNumThreads()
+{
+  const char* env = std::getenv("DART_NUM_THREADS");
+  if (env != nullptr)
+  {
+    try
+    {
+      int fromEnv = std::stoi(env);
+      if (fromEnv > 0)
+        return static_cast<std::size_t>(fromEnv);
+    }
+    catch (const std::exception&)
+    {
+      // Fall through to the default
+    }
+    dtwarn << "[ThreadPool] Ignoring invalid DART_NUM_THREADS value \"" << env
+           << "\"\n";
+  }
+
+  std::size_t hardware = std::thread::hardware_concurrency();
+  return hardware > 0 ? hardware : 1;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+ThreadPool::ThreadPool(std::size_t numThreads)
+  : mNumQueuedTasks(0), mNextQueue(0), mStopping(false)
+{
+  if (numThreads == 0)
+    numThreads = getDefaultNumThreads();
+
+  for (std::size_t i = 0; i < numThreads; i++)
+    mQueues.push_back(std::make_unique<WorkerQueue>());
+  for (std::size_t i = 0; i < numThreads; i++)
+    mWorkers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+//==============================================================================
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mStopping = true;
+  }
+  mWakeUp.notify_all();
+  for (std::thread& worker : mWorkers)
+    worker.join();
+}
+
+//==============================================================================
+std::size_t ThreadPool::getNumThreads() const
+{
+  return mWorkers.size();
+}
+
+//==============================================================================
+bool ThreadPool::isWorkerThread() const
+{
+  return tlsOwningPool == this;
+}
+
+//==============================================================================
+ThreadPool& ThreadPool::getGlobal()
+{
+  std::lock_guard<std::mutex> lock(gGlobalPoolMutex);
+  if (!gGlobalPool)
+    gGlobalPool = std::make_unique<ThreadPool>();
+  return *gGlobalPool;
+}
+
+//==============================================================================
+void ThreadPool::setGlobalNumThreads(std::size_t numThreads)
+{
+  std::unique_ptr<ThreadPool> oldPool;
+  {
+    std::lock_guard<std::mutex> lock(gGlobalPoolMutex);
+    oldPool = std::move(gGlobalPool);
+    gGlobalPool = std::make_unique<ThreadPool>(numThreads);
+  }
+  // The old pool drains its queue and joins its workers here, outside the lock
+}
+
+//==============================================================================
+void ThreadPool::setDeterministic(bool deterministic)
+{
+  gDeterministic.store(deterministic);
+}
+
+//==============================================================================
+bool ThreadPool::isDeterministic()
+{
+  return gDeterministic.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+void ThreadPool::setTaskSeed(std::uint64_t seed)
+{
+  tlsThreadContext.seed = seed;
+  tlsThreadContext.numSubmitted = 0;
+  tlsThreadContext.generator.reset();
+}
+
+//==============================================================================
+std::mt19937* ThreadPool::getTaskGenerator()
+{
+  TaskContext* context = tlsTaskContext;
+  if (context == nullptr)
+    return nullptr;
+  if (!context->generator)
+  {
+    std::seed_seq seq{static_cast<std::uint32_t>(context->seed),
+                      static_cast<std::uint32_t>(context->seed >> 32)};
+    context->generator = std::make_unique<std::mt19937>(seq);
+  }
+  return context->generator.get();
+}
+
+//==============================================================================
+void ThreadPool::enqueue(std::function<void()> task)
+{
+  if (isDeterministic())
+  {
+    // The seed only depends on where this task sits in the tree of
+    // submissions, never on which thread submitted it or when
+    TaskContext& parent
+        = tlsTaskContext != nullptr ? *tlsTaskContext : tlsThreadContext;
+    std::uint64_t seed = mixSeed(parent.seed, parent.numSubmitted++);
+    task = [seed, inner = std::move(task)]() {
+      TaskContext context;
+      context.seed = seed;
+      TaskContext* previous = tlsTaskContext;
+      tlsTaskContext = &context;
+      // Tasks come from submit(), whose packaged_task catches any exception,
+      // so this always gets to restore the previous context
+      inner();
+      tlsTaskContext = previous;
+    };
+  }
+
+  // Count the task before it's visible, so the count never goes negative when
+  // a worker grabs the task right after we push it
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mNumQueuedTasks++;
+  }
+
+  std::size_t queueIndex;
+  if (isWorkerThread())
+  {
+    // Keep nested work on the worker that created it, since it's likely to
+    // touch the same data. Other workers can still steal it.
+    queueIndex = tlsWorkerIndex;
+    std::lock_guard<std::mutex> lock(mQueues[queueIndex]->mutex);
+    mQueues[queueIndex]->tasks.push_front(std::move(task));
+  }
+  else
+  {
+    queueIndex = mNextQueue.fetch_add(1) % mQueues.size();
+    std::lock_guard<std::mutex> lock(mQueues[queueIndex]->mutex);
+    mQueues[queueIndex]->tasks.push_back(std::move(task));
+  }
+
+  mWakeUp.notify_one();
+}
+
+//==============================================================================
+bool ThreadPool::runPendingTask(std::size_t preferredQueue)
+{
+  if (mNumQueuedTasks.load() == 0)
+    return false;
+
+  std::function<void()> task;
+  const std::size_t numQueues = mQueues.size();
+  for (std::size_t offset = 0; offset < numQueues && !task; offset++)
+  {
+    WorkerQueue& queue = *mQueues[(preferredQueue + offset) % numQueues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+
+    if (offset == 0)
+    {
+      // Our own queue: take the newest task
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    else
+    {
+      // Someone else's queue: steal the oldest task
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+  }
+
+  if (!task)
+    return false;
+
+  mNumQueuedTasks--;
+  task();
+  return true;
+}
+
+//==============================================================================
+void ThreadPool::workerLoop(std::size_t workerIndex)
+{
+  tlsOwningPool = this;
+  tlsWorkerIndex = workerIndex;
+
+  while (true)
+  {
+    if (runPendingTask(workerIndex))
+      continue;
+
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    mWakeUp.wait(
+        lock, [this]() { return mStopping || mNumQueuedTasks.load() > 0; });
+    if (mStopping && mNumQueuedTasks.load() == 0)
+      return;
+  }
+}
+
+//==============================================================================
+std::size_t ThreadPool::getPreferredQueue()
+{
+  if (isWorkerThread())
+    return tlsWorkerIndex;
+  return mNextQueue.load() % mQueues.size();
+}
+
+} // namespace common
+} // namespace dart
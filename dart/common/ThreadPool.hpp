@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COMMON_THREADPOOL_HPP_
+#define DART_COMMON_THREADPOOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace dart {
+namespace common {
+
+/// ThreadPool is a fixed set of worker threads that run submitted tasks. Each
+/// worker owns a task queue. Tasks submitted from inside a worker go to the
+/// front of that worker's own queue, and idle workers steal from the back of
+/// the other queues, which keeps nested parallelism (a task that submits more
+/// tasks) cheap and well balanced.
+///
+/// Code that blocks on the result of a task should use wait() rather than
+/// std::future::wait() directly. wait() runs other pending tasks while it
+/// waits, so tasks that wait on their own subtasks can't starve the pool.
+class ThreadPool
+{
+public:
+  /// Create a pool with numThreads workers. If numThreads is 0, this uses the
+  /// value of the DART_NUM_THREADS environment variable if it's set, and
+  /// std::thread::hardware_concurrency() otherwise.
+  explicit ThreadPool(std::size_t numThreads = 0);
+
+  /// Finishes every task that's already been submitted, then joins the workers
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Returns the number of worker threads in this pool
+  std::size_t getNumThreads() const;
+
+  /// Queue func(args...) to run on the pool, and return a future for its
+  /// result. Like std::async, the arguments are copied (or moved) when the
+  /// task is submitted. Exceptions thrown by the task are rethrown from the
+  /// future. Unlike a std::async future, the returned future doesn't block
+  /// when it's destroyed, so callers that need the task to have finished
+  /// (e.g. because it writes into their locals) must wait() on it first.
+  template <typename Func, typename... Args>
+  auto submit(Func&& func, Args&&... args) -> std::future<
+      typename std::result_of<typename std::decay<Func>::type(
+          typename std::decay<Args>::type&...)>::type>;
+
+  /// Block until future is ready, running other pending tasks in the meantime
+  template <typename T>
+  void wait(const std::future<T>& future);
+
+  /// Block until every future in futures is ready, running other pending
+  /// tasks in the meantime. Call this before a batch of submitted futures
+  /// goes out of scope, since they won't wait on destruction.
+  template <typename T>
+  void waitAll(const std::vector<std::future<T>>& futures);
+
+  /// Returns true if the calling thread is one of this pool's workers
+  bool isWorkerThread() const;
+
+  /// Returns the pool shared by everything in DART. This is created on first
+  /// use.
+  static ThreadPool& getGlobal();
+
+  /// Replace the global pool with a new one with numThreads workers (0 picks
+  /// the default, see the constructor). This waits for any tasks queued on the
+  /// old pool to finish, so don't call it while other threads are still
+  /// submitting to the global pool.
+  static void setGlobalNumThreads(std::size_t numThreads);
+
+  /// Turn deterministic mode on or off, for every pool. In deterministic mode
+  /// each task gets its own random generator, seeded from the seed of
+  /// whatever submitted it (a task, or a thread outside any task) and how
+  /// many tasks that submitter had queued before it. math::Random draws from
+  /// that generator while the task runs, so the numbers a task sees don't
+  /// depend on which worker runs it, or on what the other workers are doing.
+  /// Code whose results depend on how work lands on threads (like the CCD
+  /// warm starts, or cost-balanced schedules) also checks this flag and falls
+  /// back to a fixed scheme. Only turn this on or off while no tasks are
+  /// running.
+  static void setDeterministic(bool deterministic);
+
+  /// Returns true if deterministic mode is on
+  static bool isDeterministic();
+
+  /// Sets the seed that tasks submitted from the calling thread (outside of
+  /// any task) derive their seeds from, and restarts its count of submitted
+  /// tasks. math::Random::setSeed() calls this for you.
+  static void setTaskSeed(std::uint64_t seed);
+
+  /// Returns the random generator of the task running on the calling thread,
+  /// or nullptr if we're not in deterministic mode, or not inside a task
+  static std::mt19937* getTaskGenerator();
+
+protected:
+  struct WorkerQueue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  /// Push a type-erased task onto a queue and wake up a worker
+  void enqueue(std::function<void()> task);
+
+  /// Pop and run one task, preferring the queue at preferredQueue and
+  /// stealing from the others if it's empty. Returns false if there was no
+  /// task to run.
+  bool runPendingTask(std::size_t preferredQueue);
+
+  /// The main loop for worker workerIndex
+  void workerLoop(std::size_t workerIndex);
+
+  /// Returns the index to prefer when the calling thread looks for work
+  std::size_t getPreferredQueue();
+
+  std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+  std::vector<std::thread> mWorkers;
+
+  /// Guards sleeping and waking workers, so no wakeups get lost
+  std::mutex mSleepMutex;
+  std::condition_variable mWakeUp;
+
+  /// The number of tasks that have been queued but not yet popped
+  std::atomic<std::size_t> mNumQueuedTasks;
+
+  /// Used to spread tasks submitted from outside the pool over the queues
+  std::atomic<std::size_t> mNextQueue;
+
+  bool mStopping;
+};
+
+} // namespace common
+} // namespace dart
+
+#include "dart/common/detail/ThreadPool-impl.hpp"
+
+#endif // DART_COMMON_THREADPOOL_HPP_
@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COMMON_DETAIL_PIPELINE_IMPL_HPP_
+#define DART_COMMON_DETAIL_PIPELINE_IMPL_HPP_
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "dart/common/Pipeline.hpp"
+
+namespace dart {
+namespace common {
+
+namespace detail {
+
+//==============================================================================
+inline double secondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace detail
+
+//==============================================================================
+template <typename T>
+Pipeline<T>::BoundedQueue::BoundedQueue(int capacity)
+  : mCapacity(std::max(1, capacity)), mClosed(false), mMaxDepth(0)
+{
+}
+
+//==============================================================================
+template <typename T>
+double Pipeline<T>::BoundedQueue::push(std::unique_ptr<Slot> slot)
+{
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mMutex);
+  mNotFull.wait(
+      lock, [this] { return mClosed || (int)mSlots.size() < mCapacity; });
+  double waited = detail::secondsSince(start);
+  if (mClosed)
+    return waited;
+  mSlots.push_back(std::move(slot));
+  mMaxDepth = std::max(mMaxDepth, (int)mSlots.size());
+  lock.unlock();
+  mNotEmpty.notify_one();
+  return waited;
+}
+
+//==============================================================================
+template <typename T>
+bool Pipeline<T>::BoundedQueue::pop(std::unique_ptr<Slot>& slot, double& waited)
+{
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mMutex);
+  mNotEmpty.wait(lock, [this] { return mClosed || !mSlots.empty(); });
+  waited = detail::secondsSince(start);
+  if (mSlots.empty())
+    return false;
+  slot = std::move(mSlots.front());
+  mSlots.pop_front();
+  lock.unlock();
+  mNotFull.notify_one();
+  return true;
+}
+
+//==============================================================================
+template <typename T>
+void Pipeline<T>::BoundedQueue::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosed = true;
+  }
+  mNotEmpty.notify_all();
+  mNotFull.notify_all();
+}
+
+//==============================================================================
+template <typename T>
+int Pipeline<T>::BoundedQueue::getMaxDepth() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mMaxDepth;
+}
+
+//==============================================================================
+template <typename T>
+Pipeline<T>::Pipeline() : mRunning(false), mNumPushed(0)
+{
+}
+
+//==============================================================================
+template <typename T>
+Pipeline<T>::~Pipeline()
+{
+  if (mRunning)
+    finish();
+}
+
+//==============================================================================
+template <typename T>
+Pipeline<T>& Pipeline<T>::addStage(
+    const std::string& name, StageFunction fn, int numWorkers, int queueCapacity)
+{
+  if (mRunning)
+  {
+    throw std::logic_error(
+        "Pipeline::addStage() called while the pipeline is running");
+  }
+  std::unique_ptr<Stage> stage(new Stage());
+  stage->name = name;
+  stage->fn = std::move(fn);
+  stage->numWorkers = std::max(1, numWorkers);
+  stage->queueCapacity = std::max(1, queueCapacity);
+  stage->liveWorkers = 0;
+  mStages.push_back(std::move(stage));
+  return *this;
+}
+
+//==============================================================================
+template <typename T>
+int Pipeline<T>::getNumStages() const
+{
+  return (int)mStages.size();
+}
+
+//==============================================================================
+template <typename T>
+void Pipeline<T>::start()
+{
+  if (mRunning)
+  {
+    throw std::logic_error(
+        "Pipeline::start() called while the pipeline is already running");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mResults.clear();
+    mFailures.clear();
+    for (std::unique_ptr<Stage>& stage : mStages)
+    {
+      stage->input.reset(new BoundedQueue(stage->queueCapacity));
+      stage->liveWorkers = stage->numWorkers;
+      stage->stats = PipelineStageStats();
+      stage->stats.name = stage->name;
+      stage->stats.numWorkers = stage->numWorkers;
+      stage->stats.queueCapacity = stage->queueCapacity;
+    }
+    mNumPushed = 0;
+    mStartTime = std::chrono::steady_clock::now();
+    mRunning = true;
+  }
+
+  for (int s = 0; s < (int)mStages.size(); s++)
+  {
+    for (int w = 0; w < mStages[s]->numWorkers; w++)
+    {
+      mThreads.emplace_back(&Pipeline<T>::workerLoop, this, s);
+    }
+  }
+}
+
+//==============================================================================
+template <typename T>
+int Pipeline<T>::push(T item)
+{
+  if (!mRunning)
+  {
+    throw std::logic_error(
+        "Pipeline::push() called before Pipeline::start()");
+  }
+
+  std::unique_ptr<Slot> slot(new Slot{mNumPushed, std::move(item)});
+  mNumPushed++;
+  if (mStages.empty())
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mResults.push_back(std::move(slot));
+  }
+  else
+  {
+    mStages[0]->input->push(std::move(slot));
+  }
+  return mNumPushed - 1;
+}
+
+//==============================================================================
+template <typename T>
+std::vector<T> Pipeline<T>::finish()
+{
+  if (!mRunning)
+  {
+    throw std::logic_error(
+        "Pipeline::finish() called before Pipeline::start()");
+  }
+
+  // Each stage closes the queue after it once its last worker runs dry, so
+  // closing the first queue drains the whole pipeline in order
+  if (!mStages.empty())
+    mStages[0]->input->close();
+  for (std::thread& thread : mThreads)
+  {
+    thread.join();
+  }
+  mThreads.clear();
+
+  std::vector<T> results;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEndTime = std::chrono::steady_clock::now();
+    mRunning = false;
+
+    std::sort(
+        mResults.begin(),
+        mResults.end(),
+        [](const std::unique_ptr<Slot>& a, const std::unique_ptr<Slot>& b) {
+          return a->index < b->index;
+        });
+    results.reserve(mResults.size());
+    for (std::unique_ptr<Slot>& slot : mResults)
+    {
+      results.push_back(std::move(slot->item));
+    }
+    mResults.clear();
+
+    std::sort(
+        mFailures.begin(),
+        mFailures.end(),
+        [](const PipelineFailure& a, const PipelineFailure& b) {
+          return a.index < b.index;
+        });
+  }
+  return results;
+}
+
+//==============================================================================
+template <typename T>
+std::vector<T> Pipeline<T>::run(std::vector<T> items)
+{
+  start();
+  for (T& item : items)
+  {
+    push(std::move(item));
+  }
+  return finish();
+}
+
+//==============================================================================
+template <typename T>
+bool Pipeline<T>::isRunning() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mRunning;
+}
+
+//==============================================================================
+template <typename T>
+std::vector<PipelineStageStats> Pipeline<T>::getStageStats() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  double elapsed = std::chrono::duration<double>(
+                       (mRunning ? std::chrono::steady_clock::now() : mEndTime)
+                       - mStartTime)
+                       .count();
+
+  std::vector<PipelineStageStats> stats;
+  for (const std::unique_ptr<Stage>& stage : mStages)
+  {
+    PipelineStageStats copy = stage->stats;
+    if (stage->input)
+      copy.maxQueueDepth = stage->input->getMaxDepth();
+    if (elapsed > 0)
+    {
+      copy.itemsPerSecond = copy.itemsProcessed / elapsed;
+      copy.utilization = copy.busySeconds / (elapsed * copy.numWorkers);
+    }
+    stats.push_back(copy);
+  }
+  return stats;
+}
+
+//==============================================================================
+template <typename T>
+std::vector<PipelineFailure> Pipeline<T>::getFailures() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFailures;
+}
+
+//==============================================================================
+template <typename T>
+void Pipeline<T>::workerLoop(int s)
+{
+  Stage& stage = *mStages[s];
+  const bool isLast = (s + 1 == (int)mStages.size());
+
+  std::unique_ptr<Slot> slot;
+  double waitedForInput = 0.0;
+  while (stage.input->pop(slot, waitedForInput))
+  {
+    auto start = std::chrono::steady_clock::now();
+    bool failed = false;
+    std::string message;
+    try
+    {
+      stage.fn(slot->item);
+    }
+    catch (const std::exception& e)
+    {
+      failed = true;
+      message = e.what();
+    }
+    catch (...)
+    {
+      failed = true;
+      message = "unknown exception";
+    }
+    double busy = detail::secondsSince(start);
+
+    double waitedForOutput = 0.0;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      stage.stats.busySeconds += busy;
+      stage.stats.waitingForInputSeconds += waitedForInput;
+      if (failed)
+      {
+        stage.stats.itemsFailed++;
+        mFailures.push_back(PipelineFailure{slot->index, stage.name, message});
+      }
+      else
+      {
+        stage.stats.itemsProcessed++;
+        if (isLast)
+          mResults.push_back(std::move(slot));
+      }
+    }
+    if (failed)
+    {
+      // Dropped outside the lock, in case freeing the item needs to wait on
+      // something (like Python's GIL) that a caller of getStageStats() holds
+      slot.reset();
+    }
+    else if (slot)
+    {
+      waitedForOutput = mStages[s + 1]->input->push(std::move(slot));
+      std::lock_guard<std::mutex> lock(mMutex);
+      stage.stats.waitingForOutputSeconds += waitedForOutput;
+    }
+  }
+
+  // The last worker out tells the next stage there's nothing more coming
+  bool lastWorker = false;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    stage.stats.waitingForInputSeconds += waitedForInput;
+    stage.liveWorkers--;
+    lastWorker = (stage.liveWorkers == 0);
+  }
+  if (lastWorker && !isLast)
+    mStages[s + 1]->input->close();
+}
+
+} // namespace common
+} // namespace dart
+
+#endif // DART_COMMON_DETAIL_PIPELINE_IMPL_HPP_
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COMMON_DETAIL_THREADPOOL_IMPL_HPP_
+#define DART_COMMON_DETAIL_THREADPOOL_IMPL_HPP_
+
+#include <chrono>
+#include <functional>
+
+#include "dart/common/ThreadPool.hpp"
+
+namespace dart {
+namespace common {
+
+//==============================================================================
+template <typename Func, typename... Args>
+auto ThreadPool::submit(Func&& func, Args&&... args) -> std::future<
+    typename std::result_of<typename std::decay<Func>::type(
+        typename std::decay<Args>::type&...)>::type>
+{
+  using ReturnType = typename std::result_of<typename std::decay<Func>::type(
+      typename std::decay<Args>::type&...)>::type;
+
+  // std::function needs to be copyable, and std::packaged_task isn't, so we
+  // hold it by shared_ptr
+  auto packaged = std::make_shared<std::packaged_task<ReturnType()>>(
+      std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+  std::future<ReturnType> future = packaged->get_future();
+  enqueue([packaged]() { (*packaged)(); });
+  return future;
+}
+
+//==============================================================================
+template <typename T>
+void ThreadPool::wait(const std::future<T>& future)
+{
+  const std::size_t preferredQueue = getPreferredQueue();
+  while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    // Help out instead of sleeping, so that a task waiting on its subtasks
+    // can't deadlock the pool
+    if (!runPendingTask(preferredQueue))
+      future.wait_for(std::chrono::microseconds(50));
+  }
+}
+
+//==============================================================================
+template <typename T>
+void ThreadPool::waitAll(const std::vector<std::future<T>>& futures)
+{
+  for (const auto& future : futures)
+    wait(future);
+}
+
+} // namespace common
+} // namespace dart
+
+#endif // DART_COMMON_DETAIL_THREADPOOL_IMPL_HPP_
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/constraint/AdmmBoxedLcpSolver.hpp"
+
+#include <algorithm>
+
+#include "dart/constraint/LCPUtils.hpp"
+#include "dart/external/odelcpsolver/matrix.h"
+
+namespace dart {
+namespace constraint {
+
+//==============================================================================
+AdmmBoxedLcpSolver::Option::Option(
+    int maxIteration,
+    s_t rho,
+    s_t sigma,
+    s_t relaxation,
+    s_t tolerance,
+    bool warmStart,
+    bool polish)
+  : mMaxIteration(maxIteration),
+    mRho(rho),
+    mSigma(sigma),
+    mRelaxation(relaxation),
+    mTolerance(tolerance),
+    mWarmStart(warmStart),
+    mPolish(polish)
+{
+  // Do nothing
+}
+
+//==============================================================================
+const std::string& AdmmBoxedLcpSolver::getType() const
+{
+  return getStaticType();
+}
+
+//==============================================================================
+const std::string& AdmmBoxedLcpSolver::getStaticType()
+{
+  static const std::string type = "AdmmBoxedLcpSolver";
+  return type;
+}
+
+//==============================================================================
+bool AdmmBoxedLcpSolver::solve(
+    int n,
+    s_t* A,
+    s_t* x,
+    s_t* b,
+    int /*nub*/,
+    s_t* lo,
+    s_t* hi,
+    int* findex,
+    bool /*earlyTermination*/)
+{
+  std::lock_guard<std::mutex> lock(mCacheMutex);
+  if (n == 0)
+    return true;
+
+  const int nskip = dPAD(n);
+  const Eigen::MatrixXs fullA = Eigen::Map<
+      const Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+      0,
+      Eigen::OuterStride<>>(A, n, n, Eigen::OuterStride<>(nskip));
+  const Eigen::VectorXs fullB = Eigen::Map<const Eigen::VectorXs>(b, n);
+
+  // Scaling rho by the diagonal of A keeps the defaults sensible for both
+  // light and heavy bodies
+  const s_t meanDiagonal = fullA.diagonal().cwiseAbs().mean();
+  const s_t rho = mOption.mRho * std::max<s_t>(meanDiagonal, 1e-9);
+  const s_t sigma = mOption.mSigma;
+
+  // Refactor only when A (or rho) changed since the last solve, which for
+  // resting contact is rarely
+  if (mCachedA.rows() != n || rho != mCachedRho || fullA != mCachedA)
+  {
+    mCachedA = fullA;
+    mCachedRho = rho;
+    mCachedFactorization.compute(
+        fullA
+        + (sigma + rho) * Eigen::MatrixXs::Identity(n, n));
+    mNumFactorizations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Eigen::VectorXs z = Eigen::Map<Eigen::VectorXs>(x, n);
+  project(z, lo, hi, findex);
+  Eigen::VectorXs y = Eigen::VectorXs::Zero(n);
+  if (mOption.mWarmStart && mCachedY.size() == n)
+    y = mCachedY;
+  Eigen::VectorXs xTilde = z;
+  Eigen::VectorXs zPrev(n);
+
+  const s_t tolerance
+      = mOption.mTolerance * std::max<s_t>(1.0, fullB.cwiseAbs().maxCoeff());
+  bool converged = false;
+  int iteration = 0;
+  while (iteration < mOption.mMaxIteration && !converged)
+  {
+    iteration++;
+    xTilde = mCachedFactorization.solve(
+        sigma * xTilde + fullB + rho * z - y);
+    const Eigen::VectorXs xHat
+        = mOption.mRelaxation * xTilde + (1.0 - mOption.mRelaxation) * z;
+    zPrev = z;
+    z = xHat + y / rho;
+    project(z, lo, hi, findex);
+    y += rho * (xHat - z);
+
+    const s_t primalResidual = (xTilde - z).cwiseAbs().maxCoeff();
+    const s_t dualResidual = rho * (z - zPrev).cwiseAbs().maxCoeff();
+    converged = primalResidual <= tolerance && dualResidual <= tolerance;
+  }
+  mNumIterations.fetch_add(iteration, std::memory_order_relaxed);
+  mCachedY = y;
+
+  if (z.hasNaN())
+    return false;
+
+  if (converged && mOption.mPolish)
+  {
+    Eigen::VectorXs loVec = Eigen::Map<const Eigen::VectorXs>(lo, n);
+    Eigen::VectorXs hiVec = Eigen::Map<const Eigen::VectorXs>(hi, n);
+    Eigen::VectorXi fIndexVec = Eigen::Map<const Eigen::VectorXi>(findex, n);
+    LCPUtils::solveWithActiveSet(fullA, z, fullB, hiVec, loVec, fIndexVec);
+  }
+
+  Eigen::Map<Eigen::VectorXs>(x, n) = z;
+  return converged;
+}
+
+#ifndef NDEBUG
+//==============================================================================
+bool AdmmBoxedLcpSolver::canSolve(int /*n*/, const s_t* /*A*/)
+{
+  // TODO(JS): Not implemented.
+  return true;
+}
+#endif
+
+//==============================================================================
+void AdmmBoxedLcpSolver::setOption(const AdmmBoxedLcpSolver::Option& option)
+{
+  std::lock_guard<std::mutex> lock(mCacheMutex);
+  mOption = option;
+  // rho may have changed, which invalidates the factorization
+  mCachedA.resize(0, 0);
+}
+
+//==============================================================================
+const AdmmBoxedLcpSolver::Option& AdmmBoxedLcpSolver::getOption() const
+{
+  return mOption;
+}
+
+//==============================================================================
+long AdmmBoxedLcpSolver::getNumIterations() const
+{
+  return mNumIterations.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+long AdmmBoxedLcpSolver::getNumFactorizations() const
+{
+  return mNumFactorizations.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+void AdmmBoxedLcpSolver::project(
+    Eigen::VectorXs& z, const s_t* lo, const s_t* hi, const int* findex) const
+{
+  const int n = z.size();
+  for (int i = 0; i < n; i++)
+  {
+    if (findex[i] < 0)
+      z(i) = std::min(std::max(z(i), lo[i]), hi[i]);
+  }
+  // Friction rows are bounded by a multiple of their normal impulse, like the
+  // Dantzig and PGS solvers do it
+  for (int i = 0; i < n; i++)
+  {
+    if (findex[i] >= 0)
+    {
+      const s_t bound = abs(hi[i] * z(findex[i]));
+      z(i) = std::min(std::max(z(i), -bound), bound);
+    }
+  }
+}
+
+} // namespace constraint
+} // namespace dart
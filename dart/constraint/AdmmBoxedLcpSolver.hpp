@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_CONSTRAINT_ADMMBOXEDLCPSOLVER_HPP_
+#define DART_CONSTRAINT_ADMMBOXEDLCPSOLVER_HPP_
+
+#include <atomic>
+#include <mutex>
+
+#include <Eigen/Dense>
+
+#include "dart/constraint/BoxedLcpSolver.hpp"
+
+namespace dart {
+namespace constraint {
+
+/// A boxed LCP solver that treats the problem as the convex QP
+///
+///   min 1/2 x^T A x - b^T x   subject to   lo <= x <= hi
+///
+/// (with friction bounds scaled by their normal impulse) and solves it with
+/// ADMM, in the style of OSQP. Every iteration is one back substitution with
+/// a factorization of A + (sigma + rho) I, which is cached and reused for as
+/// long as A stays the same, plus a cheap projection onto the bounds. That
+/// makes the cost per step predictable on large contact sets, at the price of
+/// only converging to a tolerance.
+///
+/// Once ADMM converges, the solution is polished: we read off which bounds
+/// are active and solve for them exactly with LCPUtils::solveWithActiveSet().
+/// A polished solution satisfies the complementarity conditions to machine
+/// precision, so ConstrainedGroupGradientMatrices can classify and
+/// differentiate it exactly as it would a Dantzig solution.
+class AdmmBoxedLcpSolver : public BoxedLcpSolver
+{
+public:
+  struct Option
+  {
+    /// The most ADMM iterations per solve
+    int mMaxIteration;
+
+    /// The step size, relative to the mean of the diagonal of A
+    s_t mRho;
+
+    /// A small regularization on the x update, which keeps the factorization
+    /// well defined when A is only positive semi-definite
+    s_t mSigma;
+
+    /// The over-relaxation factor, in (0, 2). OSQP recommends 1.6.
+    s_t mRelaxation;
+
+    /// We stop once both the primary and dual residuals are below this
+    /// (relative to the largest entry of b)
+    s_t mTolerance;
+
+    /// If true, warm start the dual variables from the last solve of the same
+    /// size
+    bool mWarmStart;
+
+    /// If true, polish converged solutions with an exact active-set solve
+    bool mPolish;
+
+    Option(
+        int maxIteration = 500,
+        s_t rho = 0.1,
+        s_t sigma = 1e-6,
+        s_t relaxation = 1.6,
+        s_t tolerance = 1e-7,
+        bool warmStart = true,
+        bool polish = true);
+  };
+
+  // Documentation inherited.
+  const std::string& getType() const override;
+
+  /// Returns type for this class
+  static const std::string& getStaticType();
+
+  // Documentation inherited.
+  bool solve(
+      int n,
+      s_t* A,
+      s_t* x,
+      s_t* b,
+      int nub,
+      s_t* lo,
+      s_t* hi,
+      int* findex,
+      bool earlyTermination) override;
+
+#ifndef NDEBUG
+  // Documentation inherited.
+  bool canSolve(int n, const s_t* A) override;
+#endif
+
+  /// Sets options
+  void setOption(const Option& option);
+
+  /// Returns options.
+  const Option& getOption() const;
+
+  // Documentation inherited.
+  long getNumIterations() const override;
+
+  /// This returns how many times we've had to factor a new A, over the
+  /// solver's lifetime. Solves that reuse the cached factorization don't
+  /// count.
+  long getNumFactorizations() const;
+
+protected:
+  /// This projects z onto the bounds, normal rows first so friction rows see
+  /// the projected normal impulse
+  void project(
+      Eigen::VectorXs& z,
+      const s_t* lo,
+      const s_t* hi,
+      const int* findex) const;
+
+  Option mOption;
+
+  /// The A the cached factorization was built from, and the rho it used
+  Eigen::MatrixXs mCachedA;
+  s_t mCachedRho;
+  Eigen::LDLT<Eigen::MatrixXs> mCachedFactorization;
+
+  /// The dual variables from the last solve, for warm starting
+  Eigen::VectorXs mCachedY;
+
+  /// The caches above are shared between calls, so this serializes solve()
+  /// when constrained groups are solved in parallel
+  std::mutex mCacheMutex;
+
+  /// This counts the ADMM iterations solve() has run, over its lifetime
+  std::atomic<long> mNumIterations{0};
+
+  /// This counts the factorizations solve() has computed, over its lifetime
+  std::atomic<long> mNumFactorizations{0};
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif // DART_CONSTRAINT_ADMMBOXEDLCPSOLVER_HPP_
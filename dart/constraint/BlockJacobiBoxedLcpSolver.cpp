@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/constraint/BlockJacobiBoxedLcpSolver.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+
+#include <Eigen/Dense>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/external/odelcpsolver/matrix.h"
+
+namespace dart {
+namespace constraint {
+
+//==============================================================================
+BlockJacobiBoxedLcpSolver::Option::Option(
+    int maxBlockSize,
+    int maxIteration,
+    s_t relativeDeltaXTolerance,
+    s_t relaxation)
+  : mMaxBlockSize(maxBlockSize),
+    mMaxIteration(maxIteration),
+    mRelativeDeltaXTolerance(relativeDeltaXTolerance),
+    mRelaxation(relaxation)
+{
+  // Do nothing
+}
+
+//==============================================================================
+const std::string& BlockJacobiBoxedLcpSolver::getType() const
+{
+  return getStaticType();
+}
+
+//==============================================================================
+const std::string& BlockJacobiBoxedLcpSolver::getStaticType()
+{
+  static const std::string type = "BlockJacobiBoxedLcpSolver";
+  return type;
+}
+
+//==============================================================================
+bool BlockJacobiBoxedLcpSolver::solve(
+    int n,
+    s_t* A,
+    s_t* x,
+    s_t* b,
+    int nub,
+    s_t* lo,
+    s_t* hi,
+    int* findex,
+    bool earlyTermination)
+{
+  const int nskip = dPAD(n);
+
+  // Unbounded rows would need to stay together, and small problems don't have
+  // enough to split up, so both go straight to Dantzig
+  if (nub > 0 || n <= mOption.mMaxBlockSize)
+  {
+    return mBlockSolver.solve(
+        n, A, x, b, nub, lo, hi, findex, earlyTermination);
+  }
+
+  std::vector<int> rows;
+  std::vector<int> start;
+  partition(n, nskip, A, findex, rows, start);
+  const int numBlocks = start.size() - 1;
+  if (numBlocks == 1)
+  {
+    return mBlockSolver.solve(
+        n, A, x, b, nub, lo, hi, findex, earlyTermination);
+  }
+
+  // Each row's index within its block, for remapping findex
+  std::vector<int> localIndex(n);
+  for (int block = 0; block < numBlocks; block++)
+  {
+    for (int i = start[block]; i < start[block + 1]; i++)
+    {
+      localIndex[rows[i]] = i - start[block];
+    }
+  }
+
+  Eigen::Map<
+      const Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+      0,
+      Eigen::OuterStride<>>
+      fullA(A, n, n, Eigen::OuterStride<>(nskip));
+  Eigen::Map<Eigen::VectorXs> fullX(x, n);
+  const Eigen::Map<const Eigen::VectorXs> fullB(b, n);
+
+  Eigen::VectorXs oldX = fullX;
+  Eigen::VectorXs newX(n);
+  Eigen::VectorXs residual(n);
+
+  // Solves one block against the other blocks' impulses in oldX, writing its
+  // rows of newX. Blocks touch disjoint rows, so these can run concurrently.
+  auto solveBlock = [&](int block) -> bool {
+    const int begin = start[block];
+    const int k = start[block + 1] - begin;
+    const int kskip = dPAD(k);
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        blockA = Eigen::MatrixXs::Zero(k, kskip);
+    Eigen::VectorXs blockX(k);
+    Eigen::VectorXs blockB(k);
+    Eigen::VectorXs blockLo(k);
+    Eigen::VectorXs blockHi(k);
+    Eigen::VectorXi blockFIndex(k);
+    for (int r = 0; r < k; r++)
+    {
+      const int row = rows[begin + r];
+      s_t coupled = 0.0;
+      for (int c = 0; c < k; c++)
+      {
+        blockA(r, c) = fullA(row, rows[begin + c]);
+        coupled += blockA(r, c) * oldX(rows[begin + c]);
+      }
+      // residual = b - A * oldX, so add back this block's own contribution
+      blockB(r) = residual(row) + coupled;
+      blockX(r) = oldX(row);
+      blockLo(r) = lo[row];
+      blockHi(r) = hi[row];
+      blockFIndex(r) = findex[row] >= 0 ? localIndex[findex[row]] : findex[row];
+    }
+    if (!mBlockSolver.solve(
+            k,
+            blockA.data(),
+            blockX.data(),
+            blockB.data(),
+            0,
+            blockLo.data(),
+            blockHi.data(),
+            blockFIndex.data(),
+            earlyTermination))
+      return false;
+    for (int r = 0; r < k; r++)
+    {
+      newX(rows[begin + r]) = blockX(r);
+    }
+    return true;
+  };
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  bool converged = false;
+  int iteration = 0;
+  for (; iteration < mOption.mMaxIteration && !converged; iteration++)
+  {
+    residual = fullB - fullA * oldX;
+
+    std::vector<std::future<bool>> futures;
+    futures.reserve(numBlocks - 1);
+    for (int block = 1; block < numBlocks; block++)
+    {
+      futures.push_back(pool.submit(solveBlock, block));
+    }
+    bool success = solveBlock(0);
+    pool.waitAll(futures);
+    for (auto& future : futures)
+    {
+      success = future.get() && success;
+    }
+    if (!success || newX.hasNaN())
+      break;
+
+    const s_t change = (newX - oldX).cwiseAbs().maxCoeff();
+    oldX += mOption.mRelaxation * (newX - oldX);
+    const s_t scale = std::max<s_t>(1.0, oldX.cwiseAbs().maxCoeff());
+    converged = change <= mOption.mRelativeDeltaXTolerance * scale;
+  }
+  mNumIterations.fetch_add(iteration, std::memory_order_relaxed);
+
+  fullX = oldX;
+  return converged;
+}
+
+#ifndef NDEBUG
+//==============================================================================
+bool BlockJacobiBoxedLcpSolver::canSolve(int /*n*/, const s_t* /*A*/)
+{
+  // TODO(JS): Not implemented.
+  return true;
+}
+#endif
+
+//==============================================================================
+void BlockJacobiBoxedLcpSolver::setOption(
+    const BlockJacobiBoxedLcpSolver::Option& option)
+{
+  mOption = option;
+}
+
+//==============================================================================
+const BlockJacobiBoxedLcpSolver::Option& BlockJacobiBoxedLcpSolver::getOption()
+    const
+{
+  return mOption;
+}
+
+//==============================================================================
+long BlockJacobiBoxedLcpSolver::getNumIterations() const
+{
+  return mNumIterations.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+void BlockJacobiBoxedLcpSolver::partition(
+    int n,
+    int nskip,
+    const s_t* A,
+    const int* findex,
+    std::vector<int>& rows,
+    std::vector<int>& start) const
+{
+  // Every row belongs to the contact of its normal row
+  std::vector<int> contactOf(n, -1);
+  std::vector<int> contactRoots;
+  for (int i = 0; i < n; i++)
+  {
+    if (findex[i] < 0)
+    {
+      contactOf[i] = contactRoots.size();
+      contactRoots.push_back(i);
+    }
+  }
+  for (int i = 0; i < n; i++)
+  {
+    if (findex[i] >= 0)
+      contactOf[i] = contactOf[findex[i]];
+  }
+  const int numContacts = contactRoots.size();
+
+  std::vector<std::vector<int>> contactRows(numContacts);
+  for (int i = 0; i < n; i++)
+  {
+    contactRows[contactOf[i]].push_back(i);
+  }
+
+  // Two contacts are neighbors if they're coupled anywhere in A, which
+  // happens when they push on a shared body
+  std::vector<std::vector<int>> neighbors(numContacts);
+  for (int i = 0; i < n; i++)
+  {
+    for (int j = i + 1; j < n; j++)
+    {
+      const int ci = contactOf[i];
+      const int cj = contactOf[j];
+      if (ci != cj && (A[nskip * i + j] != 0 || A[nskip * j + i] != 0))
+      {
+        neighbors[ci].push_back(cj);
+        neighbors[cj].push_back(ci);
+      }
+    }
+  }
+  for (auto& list : neighbors)
+  {
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+  }
+
+  // Grow each block breadth first from the lowest unassigned contact, so
+  // blocks are connected patches of the contact graph. A contact that doesn't
+  // fit gets released to seed a later block.
+  rows.clear();
+  rows.reserve(n);
+  start.clear();
+  start.push_back(0);
+  std::vector<bool> queued(numContacts, false);
+  std::vector<bool> assigned(numContacts, false);
+  std::deque<int> queue;
+  for (int seed = 0; seed < numContacts; seed++)
+  {
+    if (assigned[seed])
+      continue;
+
+    int blockRows = 0;
+    queued[seed] = true;
+    queue.push_back(seed);
+    while (!queue.empty())
+    {
+      const int contact = queue.front();
+      queue.pop_front();
+      const int size = contactRows[contact].size();
+      if (blockRows > 0 && blockRows + size > mOption.mMaxBlockSize)
+      {
+        queued[contact] = false;
+        continue;
+      }
+
+      assigned[contact] = true;
+      blockRows += size;
+      rows.insert(
+          rows.end(), contactRows[contact].begin(), contactRows[contact].end());
+      for (int neighbor : neighbors[contact])
+      {
+        if (!queued[neighbor])
+        {
+          queued[neighbor] = true;
+          queue.push_back(neighbor);
+        }
+      }
+    }
+    start.push_back(rows.size());
+  }
+}
+
+} // namespace constraint
+} // namespace dart
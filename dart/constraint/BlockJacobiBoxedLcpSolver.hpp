@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_CONSTRAINT_BLOCKJACOBIBOXEDLCPSOLVER_HPP_
+#define DART_CONSTRAINT_BLOCKJACOBIBOXEDLCPSOLVER_HPP_
+
+#include <atomic>
+#include <vector>
+
+#include "dart/constraint/BoxedLcpSolver.hpp"
+#include "dart/constraint/DantzigBoxedLcpSolver.hpp"
+
+namespace dart {
+namespace constraint {
+
+/// A boxed LCP solver for very large constrained groups, like piles of objects
+/// or a humanoid lying on terrain. It partitions the contacts into blocks that
+/// are tightly coupled in A (contacts on the same bodies end up together),
+/// solves every block with Dantzig in parallel on the global ThreadPool, and
+/// iterates block Jacobi style, feeding each block the latest impulses from
+/// the others, until the impulses stop changing. Problems that fit in a single
+/// block are handed straight to Dantzig.
+class BlockJacobiBoxedLcpSolver : public BoxedLcpSolver
+{
+public:
+  struct Option
+  {
+    /// Blocks are grown up to this many rows. Friction rows always stay in the
+    /// same block as their normal row, so blocks can end up smaller.
+    int mMaxBlockSize;
+
+    /// The most block Jacobi sweeps before we give up
+    int mMaxIteration;
+
+    /// We stop once no impulse changes by more than this (relative to the
+    /// largest impulse) in a sweep
+    s_t mRelativeDeltaXTolerance;
+
+    /// Each sweep moves this fraction of the way from the old impulses to the
+    /// block solutions. Values below 1 damp the oscillation between strongly
+    /// coupled blocks.
+    s_t mRelaxation;
+
+    Option(
+        int maxBlockSize = 60,
+        int maxIteration = 100,
+        s_t relativeDeltaXTolerance = 1e-8,
+        s_t relaxation = 0.7);
+  };
+
+  // Documentation inherited.
+  const std::string& getType() const override;
+
+  /// Returns type for this class
+  static const std::string& getStaticType();
+
+  // Documentation inherited.
+  bool solve(
+      int n,
+      s_t* A,
+      s_t* x,
+      s_t* b,
+      int nub,
+      s_t* lo,
+      s_t* hi,
+      int* findex,
+      bool earlyTermination) override;
+
+#ifndef NDEBUG
+  // Documentation inherited.
+  bool canSolve(int n, const s_t* A) override;
+#endif
+
+  /// Sets options
+  void setOption(const Option& option);
+
+  /// Returns options.
+  const Option& getOption() const;
+
+  // Documentation inherited.
+  long getNumIterations() const override;
+
+protected:
+  /// This groups every normal row with its friction rows into a contact, then
+  /// grows blocks of contacts breadth first along the non-zero entries of A.
+  /// Block i is rows[start[i]..start[i+1]).
+  void partition(
+      int n,
+      int nskip,
+      const s_t* A,
+      const int* findex,
+      std::vector<int>& rows,
+      std::vector<int>& start) const;
+
+  Option mOption;
+
+  /// This solves each block
+  DantzigBoxedLcpSolver mBlockSolver;
+
+  /// This counts the sweeps solve() has run, over the solver's lifetime
+  std::atomic<long> mNumIterations{0};
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif // DART_CONSTRAINT_BLOCKJACOBIBOXEDLCPSOLVER_HPP_
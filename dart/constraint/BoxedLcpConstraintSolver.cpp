@@ -32,7 +32,9 @@
 
 #include "dart/constraint/BoxedLcpConstraintSolver.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 #ifndef NDEBUG
 #include <iomanip>
 #include <iostream>
@@ -52,6 +54,33 @@
 namespace dart {
 namespace constraint {
 
+namespace {
+
+//==============================================================================
+/// After the streak-th failure in a row, skip the solver for this many solves
+int backoffSolves(int streak, int maxBackoffSolves)
+{
+  if (streak <= 0)
+    return 0;
+  return std::min(1 << std::min(streak - 1, 16), maxBackoffSolves);
+}
+
+} // namespace
+
+//==============================================================================
+BoxedLcpConstraintSolver::AdaptiveSelectionOption::AdaptiveSelectionOption(
+    bool enabled,
+    int maxPrimaryDimension,
+    s_t maxPrimaryDiagonalRatio,
+    int maxBackoffSolves)
+  : mEnabled(enabled),
+    mMaxPrimaryDimension(maxPrimaryDimension),
+    mMaxPrimaryDiagonalRatio(maxPrimaryDiagonalRatio),
+    mMaxBackoffSolves(maxBackoffSolves)
+{
+  // Do nothing
+}
+
 //==============================================================================
 BoxedLcpConstraintSolver::BoxedLcpConstraintSolver(
     s_t timeStep,
@@ -88,7 +117,11 @@ BoxedLcpConstraintSolver::BoxedLcpConstraintSolver(
 //==============================================================================
 BoxedLcpConstraintSolver::BoxedLcpConstraintSolver(
     BoxedLcpSolverPtr boxedLcpSolver, BoxedLcpSolverPtr secondaryBoxedLcpSolver)
-  : ConstraintSolver()
+  : ConstraintSolver(),
+    mWarmStartContactTolerance(0.01),
+    mActiveSetWarmStart(true),
+    mMixedPrecision(false),
+    mSolvingInParallel(false)
 {
   if (boxedLcpSolver)
   {
@@ -182,12 +215,280 @@ Eigen::VectorXs BoxedLcpConstraintSolver::getCachedLCPSolution()
 /// because it can effect the forward solutions of physics problems because of
 /// our optimistic LCP-stabilization-to-acceptance approach.
 void BoxedLcpConstraintSolver::setCachedLCPSolution(Eigen::VectorXs X)
+{
+  setCachedLCPSolutionFrom(X);
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::getCachedLCPSolutionInto(Eigen::VectorXs& out)
+{
+  out = mX;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setCachedLCPSolutionFrom(
+    const Eigen::Ref<const Eigen::VectorXs>& X)
 {
   mX = X;
+  // An explicitly set cache should win over whatever contacts we remember, so
+  // that restoring a snapshot reproduces the same solve.
+  for (auto& pair : mWorkspaces)
+  {
+    pair.second.mContactImpulses.clear();
+  }
+}
+
+//==============================================================================
+long BoxedLcpConstraintSolver::getNumLcpIterations() const
+{
+  long iterations = mBoxedLcpSolver ? mBoxedLcpSolver->getNumIterations() : 0;
+  if (mSecondaryBoxedLcpSolver)
+    iterations += mSecondaryBoxedLcpSolver->getNumIterations();
+  return iterations;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setAdaptiveSelectionOption(
+    const AdaptiveSelectionOption& option)
+{
+  mAdaptiveSelectionOption = option;
+}
+
+//==============================================================================
+const BoxedLcpConstraintSolver::AdaptiveSelectionOption&
+BoxedLcpConstraintSolver::getAdaptiveSelectionOption() const
+{
+  return mAdaptiveSelectionOption;
+}
+
+//==============================================================================
+long BoxedLcpConstraintSolver::getNumPrimarySolverSkips() const
+{
+  return mNumPrimarySolverSkips.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+long BoxedLcpConstraintSolver::getNumSecondarySolverSkips() const
+{
+  return mNumSecondarySolverSkips.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+/// When gradients are disabled, each constrained group is warm-started from
+/// the impulses it solved for last timestep. A contact is matched to the
+/// closest contact from last timestep between the same pair of collision
+/// objects, as long as the contact points are no further apart than this
+/// distance. Pass 0 to disable contact warm starts.
+void BoxedLcpConstraintSolver::setWarmStartContactTolerance(s_t tolerance)
+{
+  mWarmStartContactTolerance = tolerance;
+  if (tolerance <= 0)
+  {
+    for (auto& pair : mWorkspaces)
+    {
+      pair.second.mContactImpulses.clear();
+    }
+  }
+}
+
+//==============================================================================
+/// Returns the distance within which contacts are matched across timesteps
+/// for warm starting.
+s_t BoxedLcpConstraintSolver::getWarmStartContactTolerance() const
+{
+  return mWarmStartContactTolerance;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setActiveSetWarmStart(bool enabled)
+{
+  mActiveSetWarmStart = enabled;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::getActiveSetWarmStart() const
+{
+  return mActiveSetWarmStart;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setMixedPrecision(bool enabled)
+{
+  mMixedPrecision = enabled;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::getMixedPrecision() const
+{
+  return mMixedPrecision;
+}
+
+//==============================================================================
+/// This forgets all the per-group buffers and remembered impulses. The next
+/// solve for every group will reallocate, and won't be warm-started from
+/// contacts.
+void BoxedLcpConstraintSolver::clearWorkspaces()
+{
+  mWorkspaces.clear();
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::beginParallelSolve()
+{
+  mParallelSolveX = mX;
+  mSolvingInParallel = true;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::endParallelSolve()
+{
+  mSolvingInParallel = false;
+  // Leave the shared cache the way a serial solve would have, holding the
+  // solution for the last group we solved
+  for (auto it = mConstrainedGroups.rbegin(); it != mConstrainedGroups.rend();
+       ++it)
+  {
+    if (it->getTotalDimension() > 0)
+    {
+      mX = getWorkspace(*it).mX;
+      break;
+    }
+  }
+}
+
+//==============================================================================
+BoxedLcpConstraintSolver::LcpWorkspace& BoxedLcpConstraintSolver::getWorkspace(
+    ConstrainedGroup& group)
+{
+  std::lock_guard<std::mutex> lock(mWorkspacesMutex);
+  const std::shared_ptr<dynamics::Skeleton>& root = group.getRootSkeleton();
+  auto it = mWorkspaces.find(root.get());
+  if (it != mWorkspaces.end())
+  {
+    if (it->second.mRootSkeleton.lock() == root)
+    {
+      return it->second;
+    }
+    // The skeleton we made this for is gone, and a new one has been allocated
+    // at the same address, so none of the old contents apply.
+    mWorkspaces.erase(it);
+  }
+
+  // Before we grow the map, drop workspaces for skeletons that no longer exist
+  for (auto jt = mWorkspaces.begin(); jt != mWorkspaces.end();)
+  {
+    if (jt->second.mRootSkeleton.expired())
+      jt = mWorkspaces.erase(jt);
+    else
+      ++jt;
+  }
+
+  LcpWorkspace& ws = mWorkspaces[root.get()];
+  ws.mRootSkeleton = root;
+  return ws;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::warmStartFromContacts(
+    ConstrainedGroup& group, LcpWorkspace& ws)
+{
+  const std::size_t numConstraints = group.getNumConstraints();
+  const std::size_t n = group.getTotalDimension();
+
+  std::vector<bool> used(ws.mContactImpulses.size(), false);
+  Eigen::VectorXs guess;
+  for (std::size_t i = 0; i < numConstraints; ++i)
+  {
+    const ConstraintBasePtr& constraint = group.getConstraint(i);
+    if (!constraint->isContactConstraint())
+      continue;
+
+    const collision::Contact& contact
+        = std::static_pointer_cast<ContactConstraint>(constraint)->getContact();
+    const int dim = constraint->getDimension();
+
+    // Find the closest unclaimed contact between the same objects last step
+    int best = -1;
+    s_t bestDist = mWarmStartContactTolerance * mWarmStartContactTolerance;
+    for (std::size_t j = 0; j < ws.mContactImpulses.size(); ++j)
+    {
+      const ContactImpulse& prev = ws.mContactImpulses[j];
+      if (used[j] || prev.collisionObject1 != contact.collisionObject1
+          || prev.collisionObject2 != contact.collisionObject2)
+        continue;
+      s_t dist = (prev.point - contact.point).squaredNorm();
+      if (dist < bestDist)
+      {
+        best = j;
+        bestDist = dist;
+      }
+    }
+
+    if (best != -1)
+    {
+      used[best] = true;
+      const ContactImpulse& prev = ws.mContactImpulses[best];
+      for (int j = 0; j < dim; ++j)
+      {
+        // If friction was toggled since last step, we only carry over the
+        // normal impulse
+        ws.mX(ws.mOffset[i] + j) = j < prev.dim ? prev.impulse(j) : 0.0;
+      }
+    }
+    else
+    {
+      // This is a new contact, so fall back to the same heuristic we use when
+      // we've got no cache at all
+      if (guess.size() == 0)
+      {
+        guess = LCPUtils::guessSolution(
+            ws.mA.block(0, 0, n, n), ws.mB, ws.mHi, ws.mLo, ws.mFIndex);
+      }
+      ws.mX.segment(ws.mOffset[i], dim) = guess.segment(ws.mOffset[i], dim);
+    }
+  }
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::recordContactImpulses(
+    ConstrainedGroup& group, LcpWorkspace& ws)
+{
+  ws.mContactImpulses.clear();
+  if (mWarmStartContactTolerance <= 0)
+    return;
+
+  const std::size_t numConstraints = group.getNumConstraints();
+  for (std::size_t i = 0; i < numConstraints; ++i)
+  {
+    const ConstraintBasePtr& constraint = group.getConstraint(i);
+    if (!constraint->isContactConstraint())
+      continue;
+
+    const collision::Contact& contact
+        = std::static_pointer_cast<ContactConstraint>(constraint)->getContact();
+    ContactImpulse impulse;
+    impulse.collisionObject1 = contact.collisionObject1;
+    impulse.collisionObject2 = contact.collisionObject2;
+    impulse.point = contact.point;
+    impulse.dim = std::min<int>(constraint->getDimension(), 3);
+    impulse.impulse.setZero();
+    impulse.impulse.head(impulse.dim)
+        = ws.mX.segment(ws.mOffset[i], impulse.dim);
+    ws.mContactImpulses.push_back(impulse);
+  }
 }
 
 //==============================================================================
 LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
+{
+  LcpWorkspace& ws = getWorkspace(group);
+  buildLcpInputs(group, ws);
+  return static_cast<const LcpInputs&>(ws);
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::buildLcpInputs(
+    ConstrainedGroup& group, LcpWorkspace& ws)
 {
   // Build LCP terms by aggregating them from constraints
   const std::size_t numConstraints = group.getNumConstraints();
@@ -195,31 +496,50 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
 
   const int nSkip = dPAD(n); // nSkip = n + (n % 4);
 #ifdef NDEBUG                // release
-  mA.resize(n, nSkip);
+  ws.mA.resize(n, nSkip);
 #else // debug
-  mA.setZero(n, nSkip); // rows = n, cols = n + (n % 4)
+  ws.mA.setZero(n, nSkip); // rows = n, cols = n + (n % 4)
 #endif
-  bool mXResized = mX.size() != n;
-  bool shouldReinitializeMx = mXResized;
-  if (mXResized)
+  // When we're computing gradients, the warm start has to be reproducible from
+  // getCachedLCPSolution(), so we keep using the shared cache. Otherwise, we
+  // can warm start from the contacts this group saw last timestep.
+  const bool useContactWarmStart = !group.getGradientConstraintMatrices()
+                                   && !ws.mContactImpulses.empty();
+  bool shouldReinitializeMx = false;
+  if (useContactWarmStart)
   {
-    mX.resize(n);
-    mX.setZero();
+    ws.mX.setZero(n);
   }
-  mB.resize(n);
-  mW.setZero(n); // set w to 0
-  mLo.resize(n);
-  mHi.resize(n);
-  mFIndex.setConstant(n, -1); // set findex to -1
+  else
+  {
+    // While groups are being solved in parallel, they all read the cache as it
+    // was at the start of the solve, so the order they finish in doesn't
+    // matter.
+    const Eigen::VectorXs& cachedX = mSolvingInParallel ? mParallelSolveX : mX;
+    shouldReinitializeMx = cachedX.size() != n;
+    if (shouldReinitializeMx)
+    {
+      ws.mX.setZero(n);
+    }
+    else
+    {
+      ws.mX = cachedX;
+    }
+  }
+  ws.mB.resize(n);
+  ws.mW.setZero(n); // set w to 0
+  ws.mLo.resize(n);
+  ws.mHi.resize(n);
+  ws.mFIndex.setConstant(n, -1); // set findex to -1
 
   // Compute offset indices
-  mOffset.resize(numConstraints);
-  mOffset[0] = 0;
+  ws.mOffset.resize(numConstraints);
+  ws.mOffset[0] = 0;
   for (std::size_t i = 1; i < numConstraints; ++i)
   {
     const ConstraintBasePtr& constraint = group.getConstraint(i - 1);
     assert(constraint->getDimension() > 0);
-    mOffset[i] = mOffset[i - 1] + constraint->getDimension();
+    ws.mOffset[i] = ws.mOffset[i - 1] + constraint->getDimension();
   }
 
   // For each constraint
@@ -229,12 +549,12 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
   {
     const ConstraintBasePtr& constraint = group.getConstraint(i);
 
-    constInfo.x = mX.data() + mOffset[i];
-    constInfo.lo = mLo.data() + mOffset[i];
-    constInfo.hi = mHi.data() + mOffset[i];
-    constInfo.b = mB.data() + mOffset[i];
-    constInfo.findex = mFIndex.data() + mOffset[i];
-    constInfo.w = mW.data() + mOffset[i];
+    constInfo.x = ws.mX.data() + ws.mOffset[i];
+    constInfo.lo = ws.mLo.data() + ws.mOffset[i];
+    constInfo.hi = ws.mHi.data() + ws.mOffset[i];
+    constInfo.b = ws.mB.data() + ws.mOffset[i];
+    constInfo.findex = ws.mFIndex.data() + ws.mOffset[i];
+    constInfo.w = ws.mW.data() + ws.mOffset[i];
 
     // Fill vectors: lo, hi, b, w
     constraint->getInformation(&constInfo);
@@ -250,12 +570,11 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
     // Fill a matrix by impulse tests: A
     constraint->excite();
 
-    s_t* impulses = new s_t[constraint->getDimension()];
     for (std::size_t j = 0; j < constraint->getDimension(); ++j)
     {
       // Adjust findex for global index
-      if (mFIndex[mOffset[i] + j] >= 0)
-        mFIndex[mOffset[i] + j] += mOffset[i];
+      if (ws.mFIndex[ws.mOffset[i] + j] >= 0)
+        ws.mFIndex[ws.mOffset[i] + j] += ws.mOffset[i];
 
       // Apply impulse for impulse test
       constraint->applyUnitImpulse(j);
@@ -284,32 +603,32 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
 
       // Create a 3x3 square from A(mOffset[i], mOffset[i]) iterating over j
       // This iteration fill in row j
-      int index = nSkip * (mOffset[i] + j) + mOffset[i];
+      int index = nSkip * (ws.mOffset[i] + j) + ws.mOffset[i];
       // We never apply constraint force mixing in the individual constraints,
       // instead we apply it at the whole matrix level to make it easier to
       // differentiate.
-      constraint->getVelocityChange(mA.data() + index, false);
+      constraint->getVelocityChange(ws.mA.data() + index, false);
 
       for (std::size_t k = i + 1; k < numConstraints; ++k)
       {
         // Create a 3x3 square from A(mOffset[i], mOffset[k]), iterating over j
         // This iteration fill in row j
         // Probably mostly 0s
-        index = nSkip * (mOffset[i] + j) + mOffset[k];
-        group.getConstraint(k)->getVelocityChange(mA.data() + index, false);
+        index = nSkip * (ws.mOffset[i] + j) + ws.mOffset[k];
+        group.getConstraint(k)->getVelocityChange(ws.mA.data() + index, false);
       }
 
       // Filling symmetric part of A matrix
       for (std::size_t k = 0; k < i; ++k)
       {
-        const int indexI = mOffset[i] + j;
+        const int indexI = ws.mOffset[i] + j;
         for (std::size_t l = 0; l < group.getConstraint(k)->getDimension(); ++l)
         {
-          const int indexJ = mOffset[k] + l;
+          const int indexJ = ws.mOffset[k] + l;
           // We've already calculate the velocity of
           // mA(column for this constraint, previous constraint row) =
           //     mA(previous constraint row, column for this constraint)
-          mA(indexI, indexJ) = mA(indexJ, indexI);
+          ws.mA(indexI, indexJ) = ws.mA(indexJ, indexI);
         }
       }
 
@@ -319,63 +638,56 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
             constraint, j);
       }
     }
-    delete[] impulses;
 
     assert(isSymmetric(
-        n, mA.data(), mOffset[i], mOffset[i] + constraint->getDimension() - 1));
+        n, ws.mA.data(), ws.mOffset[i], ws.mOffset[i] + constraint->getDimension() - 1));
 
     constraint->unexcite();
   }
 
-  assert(isSymmetric(n, mA.data()));
+  assert(isSymmetric(n, ws.mA.data()));
 
   // If we just zeroed out the mX vector, let's re-initialize it with a
   // reasonable guess, since those are often correct.
   if (shouldReinitializeMx)
   {
-    mX = LCPUtils::guessSolution(mA.block(0, 0, n, n), mB, mHi, mLo, mFIndex);
+    ws.mX = LCPUtils::guessSolution(
+        ws.mA.block(0, 0, n, n), ws.mB, ws.mHi, ws.mLo, ws.mFIndex);
+  }
+  else if (useContactWarmStart)
+  {
+    warmStartFromContacts(group, ws);
   }
-
-  LcpInputs lcpInputs;
-  lcpInputs.mA = mA;
-  lcpInputs.mX = mX;
-  lcpInputs.mB = mB;
-  lcpInputs.mW = mW;
-  lcpInputs.mLo = mLo;
-  lcpInputs.mHi = mHi;
-  lcpInputs.mFIndex = mFIndex;
-  lcpInputs.mOffset = mOffset;
-  return lcpInputs;
 }
 
 //==============================================================================
 std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
     LcpInputs lcpInputs, ConstrainedGroup& group)
+{
+  LcpWorkspace& ws = getWorkspace(group);
+  static_cast<LcpInputs&>(ws) = std::move(lcpInputs);
+  return solveLcp(ws, group);
+}
+
+//==============================================================================
+std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
+    LcpWorkspace& ws, ConstrainedGroup& group)
 {
   const std::size_t numConstraints = group.getNumConstraints();
   const std::size_t n = group.getTotalDimension();
 
-  mA = lcpInputs.mA;
-  mX = lcpInputs.mX;
-  mB = lcpInputs.mB;
-  mW = lcpInputs.mW;
-  mLo = lcpInputs.mLo;
-  mHi = lcpInputs.mHi;
-  mFIndex = lcpInputs.mFIndex;
-  mOffset = lcpInputs.mOffset;
-
   // Print LCP formulation
   /*
   dtdbg << "Before solve:" << std::endl;
   print(
       n,
-      mA.data(),
-      mX.data(),
-      mLo.data(),
-      mHi.data(),
-      mB.data(),
-      mW.data(),
-      mFIndex.data());
+      ws.mA.data(),
+      ws.mX.data(),
+      ws.mLo.data(),
+      ws.mHi.data(),
+      ws.mB.data(),
+      ws.mW.data(),
+      ws.mFIndex.data());
   std::cout << std::endl;
   */
 
@@ -393,31 +705,32 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
   {
     // Make backups for the secondary LCP solver because the primary solver
     // modifies the original terms.
-    mABackup = mA;
-    mXBackup = mX;
-    mBBackup = mB;
-    mLoBackup = mLo;
-    mHiBackup = mHi;
-    mFIndexBackup = mFIndex;
+    ws.mABackup = ws.mA;
+    ws.mXBackup = ws.mX;
+    ws.mBBackup = ws.mB;
+    ws.mLoBackup = ws.mLo;
+    ws.mHiBackup = ws.mHi;
+    ws.mFIndexBackup = ws.mFIndex;
   }
   // Always make backups of these variables, regardless of whether we're using
   // a secondary solver, because we need them for gradients
-  Eigen::VectorXs loGradientBackup = mLo;
-  Eigen::VectorXs hiGradientBackup = mHi;
-  Eigen::VectorXi fIndexGradientBackup = mFIndex;
-  Eigen::VectorXs bGradientBackup = mB;
+  Eigen::VectorXs loGradientBackup = ws.mLo;
+  Eigen::VectorXs hiGradientBackup = ws.mHi;
+  Eigen::VectorXi fIndexGradientBackup = ws.mFIndex;
+  Eigen::VectorXs bGradientBackup = ws.mB;
   Eigen::VectorXs aColNormGradientBackup = Eigen::VectorXs::Zero(n);
   for (std::size_t i = 0; i < n; i++)
   {
-    aColNormGradientBackup(i) = mA.col(i).squaredNorm();
+    aColNormGradientBackup(i) = ws.mA.col(i).squaredNorm();
   }
   // mA can actually be non-square, for efficiency reasons, so we make sure we
   // keep just the square block.
-  Eigen::MatrixXs aGradientBackup = mA.block(0, 0, n, n);
+  Eigen::MatrixXs aGradientBackup = ws.mA.block(0, 0, n, n);
 
   bool success = false;
   bool shortCircuitLCP = false;
   bool hadToIgnoreFrictionToSolve = false;
+  bool solvedBySecondary = false;
 
   // Pre-solve, if we're using gradients. We're going to assume that the
   // initialization mX is from last time step, and then guess that nothing has
@@ -436,11 +749,11 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
     std::shared_ptr<neural::ConstrainedGroupGradientMatrices> grads
         = group.getGradientConstraintMatrices();
     grads->registerLCPResults(
-        mX,
-        mHi,
-        mLo,
-        mFIndex,
-        mB,
+        ws.mX,
+        ws.mHi,
+        ws.mLo,
+        ws.mFIndex,
+        ws.mB,
         aColNormGradientBackup,
         aGradientBackup,
         cfm,
@@ -451,24 +764,86 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
     // since the ones we just made already work by construction
     if (success)
     {
-      mX = grads->getContactConstraintImpulses();
+      ws.mX = grads->getContactConstraintImpulses();
     }
     shortCircuitLCP = success;
   }
+  // Without gradients, we do the same thing on our own: if every index stays
+  // where the warm start has it, a single linear solve is the exact answer.
+  else if (mActiveSetWarmStart)
+  {
+    success = LCPUtils::solveWithActiveSet(
+        aGradientBackup,
+        ws.mX,
+        ws.mB,
+        ws.mHi,
+        ws.mLo,
+        ws.mFIndex,
+        mMixedPrecision);
+    shortCircuitLCP = success;
+  }
+
+  // Decide which solvers are worth trying. Without a secondary solver there's
+  // nothing to choose between, so we always run the primary.
+  bool tryPrimary = true;
+  bool trySecondary = (mSecondaryBoxedLcpSolver != nullptr);
+  const AdaptiveSelectionOption& adaptive = mAdaptiveSelectionOption;
+  if (!success && adaptive.mEnabled && trySecondary)
+  {
+    if (ws.mSkipPrimarySolves > 0)
+    {
+      ws.mSkipPrimarySolves--;
+      tryPrimary = false;
+    }
+    else if (static_cast<int>(n) > adaptive.mMaxPrimaryDimension)
+    {
+      tryPrimary = false;
+    }
+    else
+    {
+      s_t maxDiagonal = 0.0;
+      s_t minDiagonal = std::numeric_limits<s_t>::infinity();
+      for (std::size_t i = 0; i < n; i++)
+      {
+        const s_t diagonal = abs(ws.mA(i, i));
+        if (diagonal == 0)
+          continue;
+        maxDiagonal = std::max(maxDiagonal, diagonal);
+        minDiagonal = std::min(minDiagonal, diagonal);
+      }
+      if (maxDiagonal > adaptive.mMaxPrimaryDiagonalRatio * minDiagonal)
+        tryPrimary = false;
+    }
+
+    // Only skip the secondary solver too if it's been failing on this group,
+    // in which case we'd just end up dropping friction anyways
+    if (!tryPrimary && ws.mSkipSecondarySolves > 0)
+    {
+      ws.mSkipSecondarySolves--;
+      trySecondary = false;
+    }
+
+    if (!tryPrimary)
+      mNumPrimarySolverSkips.fetch_add(1, std::memory_order_relaxed);
+    if (!trySecondary)
+      mNumSecondarySolverSkips.fetch_add(1, std::memory_order_relaxed);
+  }
 
   // If we were unable to solve the problem by approximation from the previous
   // solution, then re-solve it fully using Dantzig
-  if (!success)
+  bool ranPrimary = false;
+  if (!success && tryPrimary)
   {
+    ranPrimary = true;
     const bool earlyTermination = (mSecondaryBoxedLcpSolver != nullptr);
     assert(mBoxedLcpSolver);
 
-    Eigen::MatrixXs mAReduced = mA.block(0, 0, n, n);
-    Eigen::VectorXs mXReduced = mX;
-    Eigen::VectorXs mBReduced = mB;
-    Eigen::VectorXs mHiReduced = mHi;
-    Eigen::VectorXs mLoReduced = mLo;
-    Eigen::VectorXi mFIndexReduced = mFIndex;
+    Eigen::MatrixXs mAReduced = ws.mA.block(0, 0, n, n);
+    Eigen::VectorXs mXReduced = ws.mX;
+    Eigen::VectorXs mBReduced = ws.mB;
+    Eigen::VectorXs mHiReduced = ws.mHi;
+    Eigen::VectorXs mLoReduced = ws.mLo;
+    Eigen::VectorXi mFIndexReduced = ws.mFIndex;
     Eigen::MatrixXs mapOut = LCPUtils::reduce(
         mAReduced,
         mXReduced,
@@ -494,27 +869,27 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
 
     if (success)
     {
-      mX = mapOut * mXReduced;
+      ws.mX = mapOut * mXReduced;
       // Double check if the LCP solution is valid. The ODE solver can sometimes
       // return invalid solutions with success=true >:(
       if (!LCPUtils::isLCPSolutionValid(
               aGradientBackup,
-              mX,
-              mBBackup,
-              mHiBackup,
-              mLoBackup,
-              mFIndexBackup,
+              ws.mX,
+              ws.mBBackup,
+              ws.mHiBackup,
+              ws.mLoBackup,
+              ws.mFIndexBackup,
               false))
       {
         /*
         std::cout << "ODE failed to produce a valid solution" << std::endl;
         LCPUtils::printReplicationCode(
             aGradientBackup,
-            mXBackup,
-            mLoBackup,
-            mHiBackup,
-            mBBackup,
-            mFIndexBackup);
+            ws.mXBackup,
+            ws.mLoBackup,
+            ws.mHiBackup,
+            ws.mBBackup,
+            ws.mFIndexBackup);
         */
         success = false;
       }
@@ -523,12 +898,12 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
 
   // Sanity check. LCP solvers should not report success with nan values, but
   // it could happen. So we set the sucees to false for nan values.
-  if (mX.hasNaN())
+  if (ws.mX.hasNaN())
   {
     success = false;
     // secondary PGS solver will produce NaNs if mX is initialized with NaNs, so
     // reset mX
-    mX.setZero();
+    ws.mX.setZero();
   }
 
   // If we failed to solve the LCP, at this point apply some constraint force
@@ -540,21 +915,35 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
   {
     cfm = mFallbackConstraintForceMixingConstant;
     // Apply the constraint force mixing
-    mABackup.diagonal()
-        += Eigen::VectorXs::Ones(mABackup.diagonal().size()) * cfm;
+    ws.mABackup.diagonal()
+        += Eigen::VectorXs::Ones(ws.mABackup.diagonal().size()) * cfm;
     aGradientBackup.diagonal()
         += Eigen::VectorXs::Ones(aGradientBackup.diagonal().size()) * cfm;
   }
 
+  // Keep track of how the primary solver is doing on this group, so we can
+  // stop wasting time on it if it keeps failing
+  if (ranPrimary)
+  {
+    ws.mPrimaryFailureStreak = success ? 0 : ws.mPrimaryFailureStreak + 1;
+    if (adaptive.mEnabled)
+    {
+      ws.mSkipPrimarySolves = backoffSolves(
+          ws.mPrimaryFailureStreak, adaptive.mMaxBackoffSolves);
+    }
+  }
+
   // If Dantzig failed to solve the problem, fall back to PGS
-  if (!success && mSecondaryBoxedLcpSolver)
-  {
-    Eigen::MatrixXs mAReduced = mABackup.block(0, 0, n, n);
-    Eigen::VectorXs mXReduced = mXBackup;
-    Eigen::VectorXs mBReduced = mBBackup;
-    Eigen::VectorXs mHiReduced = mHiBackup;
-    Eigen::VectorXs mLoReduced = mLoBackup;
-    Eigen::VectorXi mFIndexReduced = mFIndexBackup;
+  bool ranSecondary = false;
+  if (!success && mSecondaryBoxedLcpSolver && trySecondary)
+  {
+    ranSecondary = true;
+    Eigen::MatrixXs mAReduced = ws.mABackup.block(0, 0, n, n);
+    Eigen::VectorXs mXReduced = ws.mXBackup;
+    Eigen::VectorXs mBReduced = ws.mBBackup;
+    Eigen::VectorXs mHiReduced = ws.mHiBackup;
+    Eigen::VectorXs mLoReduced = ws.mLoBackup;
+    Eigen::VectorXi mFIndexReduced = ws.mFIndexBackup;
     Eigen::MatrixXs mapOut = LCPUtils::reduce(
         mAReduced,
         mXReduced,
@@ -579,10 +968,10 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
         false);
     if (success)
     {
-      mX = mapOut * mXReduced;
+      ws.mX = mapOut * mXReduced;
       if (!LCPUtils::isLCPSolutionValid(
               aGradientBackup,
-              mX,
+              ws.mX,
               bGradientBackup,
               hiGradientBackup,
               loGradientBackup,
@@ -594,6 +983,17 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
         // aren't guaranteed to be solvable with friction.
       }
     }
+    solvedBySecondary = success;
+  }
+
+  if (ranSecondary)
+  {
+    ws.mSecondaryFailureStreak = success ? 0 : ws.mSecondaryFailureStreak + 1;
+    if (adaptive.mEnabled)
+    {
+      ws.mSkipSecondarySolves = backoffSolves(
+          ws.mSecondaryFailureStreak, adaptive.mMaxBackoffSolves);
+    }
   }
 
   // If Dantzig (and PGS, if we've got it) both failed to solve the problem, our
@@ -607,12 +1007,12 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
   {
     hadToIgnoreFrictionToSolve = true;
 
-    Eigen::MatrixXs mAReduced = mABackup.block(0, 0, n, n);
-    Eigen::VectorXs mXReduced = mXBackup;
-    Eigen::VectorXs mBReduced = mBBackup;
-    Eigen::VectorXs mHiReduced = mHiBackup;
-    Eigen::VectorXs mLoReduced = mLoBackup;
-    Eigen::VectorXi mFIndexReduced = mFIndexBackup;
+    Eigen::MatrixXs mAReduced = ws.mABackup.block(0, 0, n, n);
+    Eigen::VectorXs mXReduced = ws.mXBackup;
+    Eigen::VectorXs mBReduced = ws.mBBackup;
+    Eigen::VectorXs mHiReduced = ws.mHiBackup;
+    Eigen::VectorXs mLoReduced = ws.mLoBackup;
+    Eigen::VectorXi mFIndexReduced = ws.mFIndexBackup;
     Eigen::MatrixXs mapOut = LCPUtils::removeFriction(
         mAReduced,
         mXReduced,
@@ -654,7 +1054,7 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
           mFIndexReduced.data(),
           true);
     }
-    mX = mapOut * mXReduced;
+    ws.mX = mapOut * mXReduced;
     // Don't bother checking validity at this point, because we know the
     // solution is invalid with friction constraints, and that's ok.
 
@@ -676,14 +1076,14 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
     */
   }
 
-  if (mX.hasNaN())
+  if (ws.mX.hasNaN())
   {
     dterr << "[BoxedLcpConstraintSolver] The solution of LCP includes NAN "
-          << "values: " << mX.transpose() << ". We're setting it zero for "
+          << "values: " << ws.mX.transpose() << ". We're setting it zero for "
           << "safety. Consider using more robust solver such as PGS as a "
           << "secondary solver. If this happens even with PGS solver, please "
           << "report this as a bug.\n";
-    mX.setZero();
+    ws.mX.setZero();
   }
 
   // Print LCP formulation
@@ -691,13 +1091,13 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
   dtdbg << "After solve:" << std::endl;
   print(
       n,
-      mA.data(),
-      mX.data(),
-      mLo.data(),
-      mHi.data(),
-      mB.data(),
-      mW.data(),
-      mFIndex.data());
+      ws.mA.data(),
+      ws.mX.data(),
+      ws.mLo.data(),
+      ws.mHi.data(),
+      ws.mB.data(),
+      ws.mW.data(),
+      ws.mFIndex.data());
   std::cout << std::endl;
   */
 
@@ -706,19 +1106,28 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
   /*
   LCPUtils::cleanUpResults(
       aGradientBackup,
-      mX,
+      ws.mX,
       bGradientBackup,
       hiGradientBackup,
       loGradientBackup,
       fIndexGradientBackup);
   */
 
+  if (shortCircuitLCP)
+    recordLcpSolve(WARM_START);
+  else if (hadToIgnoreFrictionToSolve)
+    recordLcpSolve(FRICTIONLESS);
+  else if (solvedBySecondary)
+    recordLcpSolve(SECONDARY);
+  else
+    recordLcpSolve(PRIMARY);
+
   // If our short circuit didn't work, then we had to use the full LCP to get a
   // fresh solution, and now we have to generate new constraint matrices.
   if (group.getGradientConstraintMatrices() && !shortCircuitLCP)
   {
     group.getGradientConstraintMatrices()->registerLCPResults(
-        mX,
+        ws.mX,
         hiGradientBackup,
         loGradientBackup,
         fIndexGradientBackup,
@@ -730,11 +1139,23 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
     group.getGradientConstraintMatrices()->constructMatrices();
     if (group.getGradientConstraintMatrices()->areResultsStandardized())
     {
-      mX = group.getGradientConstraintMatrices()
+      ws.mX = group.getGradientConstraintMatrices()
                ->getContactConstraintImpulses();
     }
   }
 
+  // Keep this solution around, both as the shared cache and (if gradients are
+  // off) as the per-contact warm start for this group's next timestep. In a
+  // parallel solve, endParallelSolve() updates the shared cache instead.
+  if (!mSolvingInParallel)
+  {
+    mX = ws.mX;
+  }
+  if (!group.getGradientConstraintMatrices())
+  {
+    recordContactImpulses(group, ws);
+  }
+
   // Initialize the vector of constraint impulses we will eventually return.
   // Each ith element of the vector will contain a pointer to the constraint
   // impulse to be applied for the ith constraint.
@@ -755,7 +1176,7 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
       // the contact object for visualization later.
       const_cast<collision::Contact*>(&contactConstraint->getContact())
           ->lcpResult
-          = mX(mOffset[i]);
+          = ws.mX(ws.mOffset[i]);
       // Similar to storing lcpResult, we're storing a bunch of other useful
       // contact information users may want related to each contact.
       const_cast<collision::Contact*>(&contactConstraint->getContact())
@@ -768,10 +1189,10 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
       {
         const_cast<collision::Contact*>(&contactConstraint->getContact())
             ->lcpResultTangent1
-            = mX(mOffset[i] + 1);
+            = ws.mX(ws.mOffset[i] + 1);
         const_cast<collision::Contact*>(&contactConstraint->getContact())
             ->lcpResultTangent2
-            = mX(mOffset[i] + 2);
+            = ws.mX(ws.mOffset[i] + 2);
         const ContactConstraint::TangentBasisMatrix D
             = contactConstraint->getTangentBasisMatrixODE(
                 contactConstraint->getContact().normal);
@@ -783,7 +1204,7 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
             = D.col(1);
       }
     }
-    constraintImpulses.push_back(mX.data() + mOffset[i]);
+    constraintImpulses.push_back(ws.mX.data() + ws.mOffset[i]);
   }
   return constraintImpulses;
 }
@@ -792,8 +1213,9 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
 std::vector<s_t*> BoxedLcpConstraintSolver::solveConstrainedGroup(
     ConstrainedGroup& group)
 {
-  LcpInputs lcpInputs = buildLcpInputs(group);
-  return solveLcp(lcpInputs, group);
+  LcpWorkspace& ws = getWorkspace(group);
+  buildLcpInputs(group, ws);
+  return solveLcp(ws, group);
 }
 
 //==============================================================================
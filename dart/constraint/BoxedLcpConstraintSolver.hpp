@@ -33,6 +33,12 @@
 #ifndef DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 #define DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "dart/constraint/BoxedLcpSolver.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/constraint/SmartPointer.hpp"
@@ -43,6 +49,35 @@ namespace constraint {
 class BoxedLcpConstraintSolver : public ConstraintSolver
 {
 public:
+  /// Settings for picking which LCP solvers to try on each constrained group,
+  /// based on the size of its LCP and on how its earlier solves went.
+  struct AdaptiveSelectionOption
+  {
+    /// If false, every solve tries the primary solver, then the secondary
+    /// solver, then drops friction, in that order. False by default.
+    bool mEnabled;
+
+    /// LCPs with more rows than this skip the primary solver and go straight
+    /// to the secondary solver. Dantzig's pivoting is cubic in the size of
+    /// the LCP, while PGS sweeps are quadratic.
+    int mMaxPrimaryDimension;
+
+    /// LCPs where the ratio of the largest to the smallest non-zero diagonal
+    /// entry of A is larger than this skip the primary solver. Badly
+    /// conditioned problems are where Dantzig tends to fail.
+    s_t mMaxPrimaryDiagonalRatio;
+
+    /// After a solver fails on a group, we skip it on that group for the next
+    /// 1, 2, 4, ... solves as failures keep piling up, capped at this many.
+    int mMaxBackoffSolves;
+
+    AdaptiveSelectionOption(
+        bool enabled = false,
+        int maxPrimaryDimension = 120,
+        s_t maxPrimaryDiagonalRatio = 1e10,
+        int maxBackoffSolves = 16);
+  };
+
   /// Constructor
   ///
   /// \param[in] timeStep Simulation time step
@@ -113,6 +148,67 @@ public:
   /// our optimistic LCP-stabilization-to-acceptance approach.
   virtual void setCachedLCPSolution(Eigen::VectorXs X) override;
 
+  // Documentation inherited.
+  void getCachedLCPSolutionInto(Eigen::VectorXs& out) override;
+
+  // Documentation inherited.
+  void setCachedLCPSolutionFrom(
+      const Eigen::Ref<const Eigen::VectorXs>& X) override;
+
+  // Documentation inherited.
+  long getNumLcpIterations() const override;
+
+  /// Sets how we pick which LCP solvers to try on each constrained group
+  void setAdaptiveSelectionOption(const AdaptiveSelectionOption& option);
+
+  /// Returns how we pick which LCP solvers to try on each constrained group
+  const AdaptiveSelectionOption& getAdaptiveSelectionOption() const;
+
+  /// This returns how many solves skipped the primary solver because of the
+  /// adaptive selection, over the lifetime of this solver
+  long getNumPrimarySolverSkips() const;
+
+  /// This returns how many solves skipped both the primary and the secondary
+  /// solver because of the adaptive selection, and went straight to dropping
+  /// friction, over the lifetime of this solver
+  long getNumSecondarySolverSkips() const;
+
+  /// When gradients are disabled, each constrained group is warm-started from
+  /// the impulses it solved for last timestep. A contact is matched to the
+  /// closest contact from last timestep between the same pair of collision
+  /// objects, as long as the contact points are no further apart than this
+  /// distance. Pass 0 to disable contact warm starts.
+  void setWarmStartContactTolerance(s_t tolerance);
+
+  /// Returns the distance within which contacts are matched across timesteps
+  /// for warm starting.
+  s_t getWarmStartContactTolerance() const;
+
+  /// When gradients are disabled and this is on (the default), we read off
+  /// which contacts are sticking, sliding or separating in the warm start, and
+  /// try a single linear solve that keeps them that way before falling back to
+  /// the pivoting solvers. When nothing changes category between steps, as in
+  /// steady resting contact or a periodic gait, that's the whole solve.
+  void setActiveSetWarmStart(bool enabled);
+
+  /// Returns true if we try an active-set solve before the LCP solvers
+  bool getActiveSetWarmStart() const;
+
+  /// When this is on, the active-set solve factors its linear system in single
+  /// precision and recovers full precision by iterative refinement. Results
+  /// still have to pass the same validity check, so this only trades speed for
+  /// the occasional fall through to the LCP solvers on badly conditioned
+  /// groups. This is off by default.
+  void setMixedPrecision(bool enabled);
+
+  /// Returns true if the active-set solve factors in single precision
+  bool getMixedPrecision() const;
+
+  /// This forgets all the per-group buffers and remembered impulses. The next
+  /// solve for every group will reallocate, and won't be warm-started from
+  /// contacts.
+  void clearWorkspaces();
+
   // Documentation inherited.
   std::vector<s_t*> solveConstrainedGroup(ConstrainedGroup& group) override;
 
@@ -123,6 +219,74 @@ public:
   std::vector<s_t*> solveLcp(LcpInputs lcpInputs, ConstrainedGroup& group);
 
 protected:
+  /// The impulse we solved for on a single contact, remembered until the next
+  /// timestep so we can warm-start the matching contact.
+  struct ContactImpulse
+  {
+    const collision::CollisionObject* collisionObject1;
+    const collision::CollisionObject* collisionObject2;
+    Eigen::Vector3s point;
+    /// Normal impulse, followed by the two friction impulses if friction was
+    /// on.
+    Eigen::Vector3s impulse;
+    int dim;
+  };
+
+  /// The buffers for the boxed LCP formulation of a single constrained group.
+  /// These persist across timesteps, so a group whose size doesn't change
+  /// doesn't reallocate anything.
+  struct LcpWorkspace : public LcpInputs
+  {
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        mABackup;
+    Eigen::VectorXs mXBackup;
+    Eigen::VectorXs mBBackup;
+    Eigen::VectorXs mLoBackup;
+    Eigen::VectorXs mHiBackup;
+    Eigen::VectorXi mFIndexBackup;
+
+    /// The skeleton this workspace was created for, so we can tell if the
+    /// pointer we're keyed on has been reused by a new skeleton.
+    std::weak_ptr<dynamics::Skeleton> mRootSkeleton;
+
+    /// The contact impulses this group solved for on its last timestep
+    std::vector<ContactImpulse> mContactImpulses;
+
+    /// How many solves in a row the primary and secondary solvers have failed
+    /// on this group, for the adaptive selection
+    int mPrimaryFailureStreak = 0;
+    int mSecondaryFailureStreak = 0;
+
+    /// How many more solves on this group should skip the primary and
+    /// secondary solvers, for the adaptive selection
+    int mSkipPrimarySolves = 0;
+    int mSkipSecondarySolves = 0;
+  };
+
+  // Documentation inherited.
+  void beginParallelSolve() override;
+
+  // Documentation inherited.
+  void endParallelSolve() override;
+
+  /// This finds (or creates) the workspace for a constrained group. This is
+  /// safe to call concurrently for different groups.
+  LcpWorkspace& getWorkspace(ConstrainedGroup& group);
+
+  /// This fills the workspace with the LCP for the constrained group
+  void buildLcpInputs(ConstrainedGroup& group, LcpWorkspace& ws);
+
+  /// This solves the LCP already sitting in the workspace
+  std::vector<s_t*> solveLcp(LcpWorkspace& ws, ConstrainedGroup& group);
+
+  /// This overwrites the contact rows of ws.mX with the impulses from the
+  /// matching contacts last timestep. Contacts that don't have a match get
+  /// rows from the heuristic guess instead.
+  void warmStartFromContacts(ConstrainedGroup& group, LcpWorkspace& ws);
+
+  /// This remembers the contact impulses in ws.mX for the next timestep
+  void recordContactImpulses(ConstrainedGroup& group, LcpWorkspace& ws);
+
   /// Boxed LCP solver
   BoxedLcpSolverPtr mBoxedLcpSolver;
   // TODO(JS): Hold as unique_ptr because there is no reason to share. Make this
@@ -133,47 +297,38 @@ protected:
   // TODO(JS): Hold as unique_ptr because there is no reason to share. Make this
   // change in DART 7 because it's API breaking change.
 
-  /// Cache data for boxed LCP formulation
-  Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> mA;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> mABackup;
-
-  /// Cache data for boxed LCP formulation
+  /// The LCP solution from the last constrained group we solved. This is what
+  /// getCachedLCPSolution() and setCachedLCPSolution() read and write, and
+  /// it's the warm start whenever gradients are enabled.
   Eigen::VectorXs mX;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mXBackup;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mB;
-
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mBBackup;
+  /// Per-group buffers, keyed by the root skeleton of the constrained group
+  std::unordered_map<const dynamics::Skeleton*, LcpWorkspace> mWorkspaces;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mW;
+  /// The distance within which contacts are matched across timesteps
+  s_t mWarmStartContactTolerance;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mLo;
+  /// Whether to try LCPUtils::solveWithActiveSet() before the LCP solvers
+  bool mActiveSetWarmStart;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mLoBackup;
+  /// Whether the active-set solve uses LCPUtils::solveMixedPrecision()
+  bool mMixedPrecision;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mHi;
+  /// How we pick which LCP solvers to try on each constrained group
+  AdaptiveSelectionOption mAdaptiveSelectionOption;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXs mHiBackup;
+  /// These count solves where the adaptive selection skipped solvers
+  std::atomic<long> mNumPrimarySolverSkips{0};
+  std::atomic<long> mNumSecondarySolverSkips{0};
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXi mFIndex;
+  /// Guards insertions into mWorkspaces during a parallel solve
+  std::mutex mWorkspacesMutex;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXi mFIndexBackup;
+  /// True between beginParallelSolve() and endParallelSolve()
+  bool mSolvingInParallel;
 
-  /// Cache data for boxed LCP formulation
-  Eigen::VectorXi mOffset;
+  /// The shared cache as it was when the current parallel solve started
+  Eigen::VectorXs mParallelSolveX;
 
 #ifndef NDEBUG
 private:
@@ -134,6 +134,13 @@ public:
       bool earlyTermination = false)
       = 0;
 
+  /// Returns how many iterations this solver has run, over its lifetime. This
+  /// is always 0 for direct solvers, which don't iterate.
+  virtual long getNumIterations() const
+  {
+    return 0;
+  }
+
 #ifndef NDEBUG
   virtual bool canSolve(int n, const s_t* A) = 0;
 #endif
@@ -155,5 +155,12 @@ ConstrainedGroup::getGradientConstraintMatrices()
   return mGradientConstraintMatrices;
 }
 
+//==============================================================================
+const std::shared_ptr<dynamics::Skeleton>& ConstrainedGroup::getRootSkeleton()
+    const
+{
+  return mRootSkeleton;
+}
+
 } // namespace constraint
 } // namespace dart
@@ -72,6 +72,14 @@ public:
   /// Destructor
   virtual ~ConstrainedGroup();
 
+  ConstrainedGroup(const ConstrainedGroup&) = default;
+  ConstrainedGroup& operator=(const ConstrainedGroup&) = default;
+
+  /// The ConstraintSolver moves groups between steps to reuse their buffers,
+  /// so these need to exist despite the virtual destructor
+  ConstrainedGroup(ConstrainedGroup&&) = default;
+  ConstrainedGroup& operator=(ConstrainedGroup&&) = default;
+
   //----------------------------------------------------------------------------
   // Setting
   //----------------------------------------------------------------------------
@@ -110,6 +118,9 @@ public:
   std::shared_ptr<neural::ConstrainedGroupGradientMatrices>
   getGradientConstraintMatrices();
 
+  /// Return the skeleton at the root of the union of skeletons in this group
+  const std::shared_ptr<dynamics::Skeleton>& getRootSkeleton() const;
+
   //----------------------------------------------------------------------------
   // Friendship
   //----------------------------------------------------------------------------
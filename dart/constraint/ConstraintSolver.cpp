@@ -32,12 +32,16 @@
 
 #include "dart/constraint/ConstraintSolver.hpp"
 
+#include <chrono>
+#include <limits>
+
 #include "dart/collision/CollisionFilter.hpp"
 #include "dart/collision/CollisionGroup.hpp"
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
 #include "dart/collision/dart/DARTCollisionDetector.hpp"
 #include "dart/common/Console.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/constraint/ConstrainedGroup.hpp"
 #include "dart/constraint/ContactConstraint.hpp"
 #include "dart/constraint/JointCoulombFrictionConstraint.hpp"
@@ -70,9 +74,14 @@ ConstraintSolver::ConstraintSolver(s_t timeStep)
         false), // Default to no penetration correction, because it breaks our
                 // gradients
     mContactClippingDepth(
-        0.03) // Default to clipping only after fairly deep penetration
+        0.03), // Default to clipping only after fairly deep penetration
+    mSpeculativeContactDistance(0.0),
+    mParallelConstrainedGroups(false),
+    mLastCollisionNanos(0)
 {
   assert(timeStep > 0.0);
+  for (int i = 0; i < NUM_LCP_SOLVE_PATHS; i++)
+    mNumLcpSolves[i].store(0);
 }
 
 //==============================================================================
@@ -88,10 +97,15 @@ ConstraintSolver::ConstraintSolver()
                 // gradients
     mContactClippingDepth(
         0.03), // Default to clipping only after fairly deep penetration
+    mSpeculativeContactDistance(0.0),
+    mParallelConstrainedGroups(false),
+    mLastCollisionNanos(0),
     mEnforceContactAndJointAndCustomConstraintsFn([this]() {
       return enforceContactAndJointAndCustomConstraintsWithLcp();
     })
 {
+  for (int i = 0; i < NUM_LCP_SOLVE_PATHS; i++)
+    mNumLcpSolves[i].store(0);
 }
 
 //==============================================================================
@@ -143,6 +157,7 @@ void ConstraintSolver::removeSkeleton(const SkeletonPtr& skeleton)
   }
 
   mCollisionGroup->removeShapeFramesOf(skeleton.get());
+  clearConstraintPools(skeleton.get());
   mSkeletons.erase(
       remove(mSkeletons.begin(), mSkeletons.end(), skeleton), mSkeletons.end());
   mConstrainedGroups.reserve(mSkeletons.size());
@@ -161,6 +176,22 @@ void ConstraintSolver::removeAllSkeletons()
 {
   mCollisionGroup->removeAllShapeFrames();
   mSkeletons.clear();
+  mContactConstraintPool.clear();
+  mJointLimitConstraintPool.clear();
+  mJointCoulombFrictionConstraintPool.clear();
+}
+
+//==============================================================================
+void ConstraintSolver::clearConstraintPools(const dynamics::Skeleton* skeleton)
+{
+  // Pooled contact constraints hold BodyNodePtrs, which would keep the
+  // skeleton alive
+  mContactConstraintPool.clear();
+  for (std::size_t i = 0; i < skeleton->getNumJoints(); i++)
+  {
+    mJointLimitConstraintPool.erase(skeleton->getJoint(i));
+    mJointCoulombFrictionConstraintPool.erase(skeleton->getJoint(i));
+  }
 }
 
 //==============================================================================
@@ -422,6 +453,7 @@ void ConstraintSolver::setFromOtherConstraintSolver(
 
   addSkeletons(other.getSkeletons());
   mManualConstraints = other.mManualConstraints;
+  mParallelConstrainedGroups = other.mParallelConstrainedGroups;
 }
 
 //==============================================================================
@@ -467,6 +499,19 @@ void ConstraintSolver::setCachedLCPSolution(Eigen::VectorXs /* X */)
   assert(false && "You should never call setCachedLCPSolution() on the root ConstraintSolver, only on BoxedLCPConstraintSolver!");
 }
 
+//==============================================================================
+void ConstraintSolver::getCachedLCPSolutionInto(Eigen::VectorXs& out)
+{
+  out = getCachedLCPSolution();
+}
+
+//==============================================================================
+void ConstraintSolver::setCachedLCPSolutionFrom(
+    const Eigen::Ref<const Eigen::VectorXs>& X)
+{
+  setCachedLCPSolution(X);
+}
+
 //==============================================================================
 void ConstraintSolver::setContactClippingDepth(s_t depth)
 {
@@ -480,6 +525,67 @@ s_t ConstraintSolver::getContactClippingDepth()
   return mContactClippingDepth;
 }
 
+//==============================================================================
+void ConstraintSolver::setSpeculativeContactDistance(s_t distance)
+{
+  mSpeculativeContactDistance = distance;
+  mCollisionOption.speculativeContactDistance = distance;
+}
+
+//==============================================================================
+s_t ConstraintSolver::getSpeculativeContactDistance()
+{
+  return mSpeculativeContactDistance;
+}
+
+//==============================================================================
+void ConstraintSolver::setParallelConstrainedGroups(bool parallel)
+{
+  mParallelConstrainedGroups = parallel;
+}
+
+//==============================================================================
+bool ConstraintSolver::getParallelConstrainedGroups() const
+{
+  return mParallelConstrainedGroups;
+}
+
+//==============================================================================
+long ConstraintSolver::getLastCollisionNanos() const
+{
+  return mLastCollisionNanos;
+}
+
+//==============================================================================
+long ConstraintSolver::getNumLcpSolves(LcpSolvePath path) const
+{
+  return mNumLcpSolves[path].load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+long ConstraintSolver::getNumLcpIterations() const
+{
+  return 0;
+}
+
+//==============================================================================
+void ConstraintSolver::recordLcpSolve(LcpSolvePath path)
+{
+  mNumLcpSolves[path].fetch_add(1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void ConstraintSolver::beginParallelSolve()
+{
+  // Do nothing
+}
+
+//==============================================================================
+void ConstraintSolver::endParallelSolve()
+{
+  // Do nothing
+}
+
 //==============================================================================
 bool ConstraintSolver::containSkeleton(const ConstSkeletonPtr& _skeleton) const
 {
@@ -541,8 +647,14 @@ bool ConstraintSolver::checkAndAddConstraint(
 //==============================================================================
 void ConstraintSolver::updateConstraints()
 {
-  // Clear previous active constraint list
+  // Clear previous active constraint list. The groups let go of last step's
+  // constraints too, so the ones nothing else kept can be recycled below.
   mActiveConstraints.clear();
+  for (auto& constrainedGroup : mConstrainedGroups)
+  {
+    constrainedGroup.removeAllConstraints();
+    constrainedGroup.mGradientConstraintMatrices = nullptr;
+  }
 
   //----------------------------------------------------------------------------
   // Update manual constraints
@@ -560,9 +672,18 @@ void ConstraintSolver::updateConstraints()
   //----------------------------------------------------------------------------
   mCollisionResult.clear();
 
+  auto collisionStart = std::chrono::steady_clock::now();
   mCollisionGroup->collide(mCollisionOption, &mCollisionResult);
+  mLastCollisionNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - collisionStart)
+                            .count();
 
-  // Destroy previous contact constraints
+  // Destroy previous contact constraints, keeping the ones nobody else holds
+  for (auto& contactConstraint : mContactConstraints)
+  {
+    if (contactConstraint.use_count() == 1)
+      mContactConstraintPool.push_back(std::move(contactConstraint));
+  }
   mContactConstraints.clear();
 
   // Destroy previous soft contact constraints
@@ -592,10 +713,9 @@ void ConstraintSolver::updateConstraints()
     DART_SUPPRESS_DEPRECATED_END
 
     // If penetration depth is negative, then the collision isn't really
-    // happening and the contact point should be ignored.
-    // TODO(MXG): Investigate ways to leverage the proximity information of a
-    //            negative penetration to improve collision handling.
-    if (contact.penetrationDepth < 0.0)
+    // happening. We only keep those contacts if they're close enough to be
+    // speculative, in which case ContactConstraint lets the gap close.
+    if (contact.penetrationDepth < -mSpeculativeContactDistance)
       continue;
     if (contact.penetrationDepth > mContactClippingDepth)
       continue;
@@ -607,8 +727,18 @@ void ConstraintSolver::updateConstraints()
     }
     else
     {
-      mContactConstraints.push_back(std::make_shared<ContactConstraint>(
-          contact, mTimeStep, mPenetrationCorrectionEnabled));
+      if (mContactConstraintPool.empty())
+      {
+        mContactConstraints.push_back(std::make_shared<ContactConstraint>(
+            contact, mTimeStep, mPenetrationCorrectionEnabled));
+      }
+      else
+      {
+        mContactConstraints.push_back(std::move(mContactConstraintPool.back()));
+        mContactConstraintPool.pop_back();
+        mContactConstraints.back()->reset(
+            contact, mTimeStep, mPenetrationCorrectionEnabled);
+      }
     }
   }
 
@@ -655,16 +785,24 @@ void ConstraintSolver::updateConstraints()
       {
         if (joint->getCoulombFriction(j) != 0.0)
         {
-          mJointCoulombFrictionConstraints.push_back(
-              std::make_shared<JointCoulombFrictionConstraint>(joint));
+          auto& pooled = mJointCoulombFrictionConstraintPool[joint];
+          if (pooled == nullptr || pooled.use_count() > 1)
+            pooled = std::make_shared<JointCoulombFrictionConstraint>(joint);
+          else
+            pooled->reset();
+          mJointCoulombFrictionConstraints.push_back(pooled);
           break;
         }
       }
 
       if (joint->isPositionLimitEnforced())
       {
-        mJointLimitConstraints.push_back(
-            std::make_shared<JointLimitConstraint>(joint));
+        auto& pooled = mJointLimitConstraintPool[joint];
+        if (pooled == nullptr || pooled.use_count() > 1)
+          pooled = std::make_shared<JointLimitConstraint>(joint);
+        else
+          pooled->reset();
+        mJointLimitConstraints.push_back(pooled);
       }
 
       if (joint->getActuatorType() == dynamics::Joint::SERVO)
@@ -722,8 +860,13 @@ void ConstraintSolver::updateConstraints()
 //==============================================================================
 void ConstraintSolver::buildConstrainedGroups()
 {
-  // Clear constrained groups
-  mConstrainedGroups.clear();
+  // Clear constrained groups. We keep the group objects around, so the ones
+  // whose skeletons are still in contact next step can be reused.
+  for (auto& constrainedGroup : mConstrainedGroups)
+  {
+    constrainedGroup.removeAllConstraints();
+    constrainedGroup.mGradientConstraintMatrices = nullptr;
+  }
   if (mGradientEnabled)
   {
     for (const auto& skel : mSkeletons)
@@ -734,7 +877,15 @@ void ConstraintSolver::buildConstrainedGroups()
 
   // Exit if there is no active constraint
   if (mActiveConstraints.empty())
+  {
+    for (auto& constrainedGroup : mConstrainedGroups)
+    {
+      constrainedGroup.mRootSkeleton = nullptr;
+      mSpareConstrainedGroups.push_back(std::move(constrainedGroup));
+    }
+    mConstrainedGroups.clear();
     return;
+  }
 
   //----------------------------------------------------------------------------
   // Unite skeletons according to constraints's relationships
@@ -745,28 +896,53 @@ void ConstraintSolver::buildConstrainedGroups()
   //----------------------------------------------------------------------------
   // Build constraint groups
   //----------------------------------------------------------------------------
+  const std::size_t noGroup = std::numeric_limits<std::size_t>::max();
+  for (const auto& skel : mSkeletons)
+    skel->mUnionIndex = noGroup;
+
+  // Assign every root skeleton an index in the new group list, in the order
+  // the constraints reach them, which is the same order as before
+  std::vector<dynamics::SkeletonPtr> roots;
   for (const auto& activeConstraint : mActiveConstraints)
   {
-    bool found = false;
     const auto& skel = activeConstraint->getRootSkeleton();
+    if (skel->mUnionIndex != noGroup)
+      continue;
 
-    for (const auto& constrainedGroup : mConstrainedGroups)
+    skel->mUnionIndex = roots.size();
+    roots.push_back(skel);
+  }
+
+  // Reuse the group that had the same root last step if there is one, then
+  // spares, and only construct a group when we run out of both
+  std::vector<ConstrainedGroup> groups(roots.size());
+  std::vector<bool> filled(roots.size(), false);
+  for (auto& constrainedGroup : mConstrainedGroups)
+  {
+    const auto& skel = constrainedGroup.mRootSkeleton;
+    if (skel != nullptr && skel->mUnionIndex != noGroup
+        && skel->mUnionIndex < roots.size() && roots[skel->mUnionIndex] == skel
+        && !filled[skel->mUnionIndex])
     {
-      if (constrainedGroup.mRootSkeleton == skel)
-      {
-        found = true;
-        break;
-      }
+      filled[skel->mUnionIndex] = true;
+      groups[skel->mUnionIndex] = std::move(constrainedGroup);
+    }
+    else
+    {
+      constrainedGroup.mRootSkeleton = nullptr;
+      mSpareConstrainedGroups.push_back(std::move(constrainedGroup));
     }
-
-    if (found)
-      continue;
-
-    ConstrainedGroup newConstGroup;
-    newConstGroup.mRootSkeleton = skel;
-    skel->mUnionIndex = mConstrainedGroups.size();
-    mConstrainedGroups.push_back(newConstGroup);
   }
+  for (std::size_t i = 0; i < roots.size(); i++)
+  {
+    if (!filled[i] && !mSpareConstrainedGroups.empty())
+    {
+      groups[i] = std::move(mSpareConstrainedGroups.back());
+      mSpareConstrainedGroups.pop_back();
+    }
+    groups[i].mRootSkeleton = roots[i];
+  }
+  mConstrainedGroups.swap(groups);
 
   // Add active constraints to constrained groups
   for (const auto& activeConstraint : mActiveConstraints)
@@ -778,10 +954,35 @@ void ConstraintSolver::buildConstrainedGroups()
   // Create the gradient matrices for this gradient mode
   if (mGradientEnabled)
   {
-    for (auto& constrainedGroup : mConstrainedGroups)
+    if (mParallelConstrainedGroups && mConstrainedGroups.size() > 1)
     {
-      auto m = neural::createGradientMatrices(constrainedGroup, mTimeStep);
-      constrainedGroup.setGradientConstraintMatrices(m);
+      // Each group only reads the skeletons it owns, so the matrices can be
+      // built concurrently. We attach them in group order afterwards.
+      common::ThreadPool& pool = common::ThreadPool::getGlobal();
+      std::vector<
+          std::future<std::shared_ptr<neural::ConstrainedGroupGradientMatrices>>>
+          futures;
+      futures.reserve(mConstrainedGroups.size());
+      for (auto& constrainedGroup : mConstrainedGroups)
+      {
+        ConstrainedGroup* group = &constrainedGroup;
+        futures.push_back(pool.submit([this, group]() {
+          return neural::createGradientMatrices(*group, mTimeStep);
+        }));
+      }
+      for (std::size_t i = 0; i < mConstrainedGroups.size(); i++)
+      {
+        pool.wait(futures[i]);
+        mConstrainedGroups[i].setGradientConstraintMatrices(futures[i].get());
+      }
+    }
+    else
+    {
+      for (auto& constrainedGroup : mConstrainedGroups)
+      {
+        auto m = neural::createGradientMatrices(constrainedGroup, mTimeStep);
+        constrainedGroup.setGradientConstraintMatrices(m);
+      }
     }
   }
 
@@ -795,6 +996,36 @@ void ConstraintSolver::buildConstrainedGroups()
 //==============================================================================
 void ConstraintSolver::solveConstrainedGroups()
 {
+  if (mParallelConstrainedGroups && mConstrainedGroups.size() > 1)
+  {
+    common::ThreadPool& pool = common::ThreadPool::getGlobal();
+
+    beginParallelSolve();
+    std::vector<ConstrainedGroup*> groups;
+    std::vector<std::future<std::vector<s_t*>>> futures;
+    for (auto& constraintGroup : mConstrainedGroups)
+    {
+      // If there are no constraints, then we are done with the group.
+      if (0u == constraintGroup.getTotalDimension())
+        continue;
+
+      ConstrainedGroup* group = &constraintGroup;
+      groups.push_back(group);
+      futures.push_back(pool.submit(
+          [this, group]() { return solveConstrainedGroup(*group); }));
+    }
+    pool.waitAll(futures);
+    endParallelSolve();
+
+    // Applying impulses is cheap, so we do it here in group order to keep the
+    // results independent of how the solves were scheduled
+    for (std::size_t i = 0; i < groups.size(); i++)
+    {
+      applyConstraintImpulses(groups[i]->getConstraints(), futures[i].get());
+    }
+    return;
+  }
+
   for (auto& constraintGroup : mConstrainedGroups)
   {
     // Build LCP terms by aggregating them from constraints
@@ -33,7 +33,9 @@
 #ifndef DART_CONSTRAINT_CONSTRAINTSOVER_HPP_
 #define DART_CONSTRAINT_CONSTRAINTSOVER_HPP_
 
+#include <atomic>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -65,6 +67,22 @@ public:
   using enforceContactAndJointAndCustomConstraintsFnType
       = std::function<void(void)>;
 
+  /// These are the ways a constrained group's LCP can end up getting solved,
+  /// from cheapest to most desperate
+  enum LcpSolvePath
+  {
+    /// Guessing that no contacts changed class since the last step worked
+    WARM_START = 0,
+    /// The primary (usually Dantzig) solver found a valid solution
+    PRIMARY,
+    /// The primary solver failed, and the secondary (usually PGS) solver found
+    /// a valid solution
+    SECONDARY,
+    /// Both failed, so we dropped friction and solved the plain LCP
+    FRICTIONLESS,
+    NUM_LCP_SOLVE_PATHS
+  };
+
   /// Constructor
   ///
   /// \deprecated Deprecated in DART 6.8. Please use other constructors that
@@ -202,6 +220,9 @@ public:
   /// Build constrained groupsContact
   void buildConstrainedGroups();
 
+  /// Drop any recycled constraints that refer to this skeleton
+  void clearConstraintPools(const dynamics::Skeleton* skeleton);
+
   /// Solve constrained groups
   void solveConstrainedGroups();
 
@@ -256,6 +277,15 @@ public:
   /// our optimistic LCP-stabilization-to-acceptance approach.
   virtual void setCachedLCPSolution(Eigen::VectorXs X);
 
+  /// This copies the cached LCP solution into `out`, which only allocates if
+  /// `out` isn't already the right size.
+  virtual void getCachedLCPSolutionInto(Eigen::VectorXs& out);
+
+  /// This is setCachedLCPSolution() without the copy of the argument, so it
+  /// only allocates if the cache changes size.
+  virtual void setCachedLCPSolutionFrom(
+      const Eigen::Ref<const Eigen::VectorXs>& X);
+
   /// Contacts whose penetrationDepth is deeper than this depth will be ignored.
   /// This is a simple solution to avoid extremely nasty situations with
   /// impossibly deep inter-penetration during multiple shooting optimization.
@@ -266,7 +296,51 @@ public:
   /// impossibly deep inter-penetration during multiple shooting optimization.
   s_t getContactClippingDepth();
 
+  /// Shapes that are separated by less than this distance get a speculative
+  /// contact, which lets them close the gap during this timestep but no more.
+  /// This keeps fast moving objects from tunneling through thin geometry at
+  /// large timesteps. Zero (the default) turns speculative contacts off.
+  void setSpeculativeContactDistance(s_t distance);
+
+  /// Shapes that are separated by less than this distance get a speculative
+  /// contact, which lets them close the gap during this timestep but no more.
+  s_t getSpeculativeContactDistance();
+
+  /// False by default. When this is on, and a timestep has more than one
+  /// constrained group, the groups are solved concurrently on the global
+  /// ThreadPool. The groups share no reactive skeletons, so this doesn't change
+  /// the physics, and impulses are still applied in group order.
+  void setParallelConstrainedGroups(bool parallel);
+
+  /// Returns true if constrained groups are solved concurrently
+  bool getParallelConstrainedGroups() const;
+
+  /// This returns how long collision detection took during the last solve(),
+  /// in nanoseconds
+  long getLastCollisionNanos() const;
+
+  /// This returns how many constrained groups have had their LCP solved along
+  /// `path`, over the lifetime of this solver
+  long getNumLcpSolves(LcpSolvePath path) const;
+
+  /// This returns how many iterations the LCP solvers have run, over the
+  /// lifetime of this solver. Only iterative solvers (like PGS) count
+  /// iterations, so this is 0 if we've only used direct ones (like Dantzig).
+  virtual long getNumLcpIterations() const;
+
 protected:
+  /// This records that a constrained group's LCP got solved along `path`.
+  /// This is safe to call from concurrent group solves.
+  void recordLcpSolve(LcpSolvePath path);
+
+  /// These bracket a parallel solve of the constrained groups. Between the two
+  /// calls, solveConstrainedGroup() is called concurrently for different
+  /// groups, so subclasses can use these to snapshot and then write back any
+  /// state they would otherwise share between groups.
+  virtual void beginParallelSolve();
+
+  virtual void endParallelSolve();
+
   /// Check if the skeleton is contained in this solver
   bool containSkeleton(const dynamics::ConstSkeletonPtr& skeleton) const;
 
@@ -321,6 +395,21 @@ protected:
   std::vector<JointCoulombFrictionConstraintPtr>
       mJointCoulombFrictionConstraints;
 
+  /// Contact constraints from earlier steps that nothing else holds on to,
+  /// waiting to be reset() onto new contacts
+  std::vector<ContactConstraintPtr> mContactConstraintPool;
+
+  /// The last joint limit constraint created for each joint. These get
+  /// reset() and reused as long as nothing else (like a BackpropSnapshot)
+  /// still holds on to them.
+  std::unordered_map<const dynamics::Joint*, JointLimitConstraintPtr>
+      mJointLimitConstraintPool;
+
+  /// The last Coulomb friction constraint created for each joint, reused like
+  /// mJointLimitConstraintPool
+  std::unordered_map<const dynamics::Joint*, JointCoulombFrictionConstraintPtr>
+      mJointCoulombFrictionConstraintPool;
+
   /// Constraints that manually added
   std::vector<ConstraintBasePtr> mManualConstraints;
 
@@ -330,6 +419,11 @@ protected:
   /// Constraint group list
   std::vector<ConstrainedGroup> mConstrainedGroups;
 
+  /// Groups from earlier steps whose root skeleton isn't a root anymore. These
+  /// get handed out before we construct new groups, so their constraint lists
+  /// keep their capacity between steps.
+  std::vector<ConstrainedGroup> mSpareConstrainedGroups;
+
   /// The type of gradients we want to use for backprop
   bool mGradientEnabled;
 
@@ -354,6 +448,19 @@ protected:
   /// impossibly deep inter-penetration during multiple shooting optimization.
   s_t mContactClippingDepth;
 
+  /// Shapes that are separated by less than this distance get a speculative
+  /// contact
+  s_t mSpeculativeContactDistance;
+
+  /// True if constrained groups are solved concurrently
+  bool mParallelConstrainedGroups;
+
+  /// This is how long collision detection took during the last solve()
+  long mLastCollisionNanos;
+
+  /// These count LCP solves along each LcpSolvePath
+  std::atomic<long> mNumLcpSolves[NUM_LCP_SOLVE_PATHS];
+
   /// Function that we will call during solve() to enforce contact, joint, and
   /// custom constraints.
   enforceContactAndJointAndCustomConstraintsFnType
@@ -67,25 +67,35 @@ ContactConstraint::ContactConstraint(
     collision::Contact& contact,
     s_t timeStep,
     bool penetrationCorrectionEnabled)
-  : ConstraintBase(),
-    mTimeStep(timeStep),
-    mBodyNodeA(const_cast<dynamics::ShapeFrame*>(
+  : ConstraintBase(), mContact(&contact)
+{
+  reset(contact, timeStep, penetrationCorrectionEnabled);
+}
+
+//==============================================================================
+void ContactConstraint::reset(
+    collision::Contact& contact,
+    s_t timeStep,
+    bool penetrationCorrectionEnabled)
+{
+  mTimeStep = timeStep;
+  mBodyNodeA = const_cast<dynamics::ShapeFrame*>(
                    contact.collisionObject1->getShapeFrame())
                    ->asShapeNode()
-                   ->getBodyNodePtr()),
-    mBodyNodeB(const_cast<dynamics::ShapeFrame*>(
+                   ->getBodyNodePtr();
+  mBodyNodeB = const_cast<dynamics::ShapeFrame*>(
                    contact.collisionObject2->getShapeFrame())
                    ->asShapeNode()
-                   ->getBodyNodePtr()),
-    mContact(contact),
-    mFirstFrictionalDirection(Eigen::Vector3s::UnitZ()),
-    mIsFrictionOn(true),
-    mAppliedImpulseIndex(dynamics::INVALID_INDEX),
-    mPenetrationCorrectionEnabled(penetrationCorrectionEnabled),
-    mDidBounce(false),
-    mIsBounceOn(false),
-    mActive(false)
-{
+                   ->getBodyNodePtr();
+  mContact = &contact;
+  mFirstFrictionalDirection = Eigen::Vector3s::UnitZ();
+  mIsFrictionOn = true;
+  mAppliedImpulseIndex = dynamics::INVALID_INDEX;
+  mPenetrationCorrectionEnabled = penetrationCorrectionEnabled;
+  mDidBounce = false;
+  mIsBounceOn = false;
+  mActive = false;
+
   assert(
       contact.normal.squaredNorm() >= DART_CONTACT_CONSTRAINT_EPSILON_SQUARED);
 
@@ -148,7 +158,7 @@ ContactConstraint::ContactConstraint(
     Eigen::Vector3s bodyPointA;
     Eigen::Vector3s bodyPointB;
 
-    collision::Contact& ct = mContact;
+    collision::Contact& ct = *mContact;
 
     // TODO(JS): Assumed that the number of tangent basis is 2.
     const TangentBasisMatrix D = getTangentBasisMatrixODE(ct.normal);
@@ -207,7 +217,7 @@ ContactConstraint::ContactConstraint(
     mSpatialNormalA.resize(6, 1);
     mSpatialNormalB.resize(6, 1);
 
-    collision::Contact& ct = mContact;
+    collision::Contact& ct = *mContact;
 
     // Contact normal in the local coordinates
     const Eigen::Vector3s bodyDirectionA
@@ -392,7 +402,7 @@ void ContactConstraint::getInformation(ConstraintInfo* info)
     // Bouncing
     //------------------------------------------------------------------------
     // A. Penetration correction
-    s_t bouncingVelocity = mContact.penetrationDepth - mErrorAllowance;
+    s_t bouncingVelocity = mContact->penetrationDepth - mErrorAllowance;
     if (bouncingVelocity < 0.0)
     {
       bouncingVelocity = 0.0;
@@ -410,12 +420,19 @@ void ContactConstraint::getInformation(ConstraintInfo* info)
       bouncingVelocity = 0;
     }
 
+    // A speculative contact (the shapes are still apart) lets the gap close
+    // during this timestep, but no further
+    if (mContact->penetrationDepth < 0.0)
+    {
+      bouncingVelocity = mContact->penetrationDepth * info->invTimeStep;
+    }
+
     // At this point, the bouncing velocity is exactly due to the penetration
     // correction hack saying "bouncing" should be non-zero.
     mPenetrationCorrectionVelocity = bouncingVelocity;
 
-    // B. Restitution
-    if (mIsBounceOn)
+    // B. Restitution. We wait until the shapes actually touch to bounce.
+    if (mIsBounceOn && mContact->penetrationDepth >= 0.0)
     {
       s_t& negativeRelativeVel = info->b[0];
       s_t restitutionVel = negativeRelativeVel * mRestitutionCoeff;
@@ -461,7 +478,7 @@ void ContactConstraint::getInformation(ConstraintInfo* info)
     // Bouncing
     //------------------------------------------------------------------------
     // A. Penetration correction
-    s_t bouncingVelocity = mContact.penetrationDepth - DART_ERROR_ALLOWANCE;
+    s_t bouncingVelocity = mContact->penetrationDepth - DART_ERROR_ALLOWANCE;
     if (bouncingVelocity < 0.0)
     {
       bouncingVelocity = 0.0;
@@ -479,12 +496,19 @@ void ContactConstraint::getInformation(ConstraintInfo* info)
       bouncingVelocity = 0;
     }
 
+    // A speculative contact (the shapes are still apart) lets the gap close
+    // during this timestep, but no further
+    if (mContact->penetrationDepth < 0.0)
+    {
+      bouncingVelocity = mContact->penetrationDepth * info->invTimeStep;
+    }
+
     // At this point, the bouncing velocity is exactly due to the penetration
     // correction hack saying "bouncing" should be non-zero.
     mPenetrationCorrectionVelocity = bouncingVelocity;
 
-    // B. Restitution
-    if (mIsBounceOn)
+    // B. Restitution. We wait until the shapes actually touch to bounce.
+    if (mIsBounceOn && mContact->penetrationDepth >= 0.0)
     {
       s_t& negativeRelativeVel = info->b[0];
       s_t restitutionVel = negativeRelativeVel * mRestitutionCoeff;
@@ -639,7 +663,7 @@ void ContactConstraint::applyImpulse(s_t* lambda)
     assert(!math::isNan(lambda[2]));
 
     // Store contact impulse (force) toward the normal w.r.t. world frame
-    mContact.force = mContact.normal * lambda[0] / mTimeStep;
+    mContact->force = mContact->normal * lambda[0] / mTimeStep;
 
     // Normal impulsive force
     if (mBodyNodeA->isReactive())
@@ -648,8 +672,8 @@ void ContactConstraint::applyImpulse(s_t* lambda)
       mBodyNodeB->addConstraintImpulse(mSpatialNormalB.col(0) * lambda[0]);
 
     // Add contact impulse (force) toward the tangential w.r.t. world frame
-    const Eigen::MatrixXs D = getTangentBasisMatrixODE(mContact.normal);
-    mContact.force += D.col(0) * lambda[1] / mTimeStep;
+    const Eigen::MatrixXs D = getTangentBasisMatrixODE(mContact->normal);
+    mContact->force += D.col(0) * lambda[1] / mTimeStep;
 
     // Tangential direction-1 impulsive force
     if (mBodyNodeA->isReactive())
@@ -658,7 +682,7 @@ void ContactConstraint::applyImpulse(s_t* lambda)
       mBodyNodeB->addConstraintImpulse(mSpatialNormalB.col(1) * lambda[1]);
 
     // Add contact impulse (force) toward the tangential w.r.t. world frame
-    mContact.force += D.col(1) * lambda[2] / mTimeStep;
+    mContact->force += D.col(1) * lambda[2] / mTimeStep;
 
     // Tangential direction-2 impulsive force
     if (mBodyNodeA->isReactive())
@@ -679,7 +703,7 @@ void ContactConstraint::applyImpulse(s_t* lambda)
       mBodyNodeB->addConstraintImpulse(mSpatialNormalB * lambda[0]);
 
     // Store contact impulse (force) toward the normal w.r.t. world frame
-    mContact.force = mContact.normal * lambda[0] / mTimeStep;
+    mContact->force = mContact->normal * lambda[0] / mTimeStep;
   }
 }
 
@@ -922,7 +946,7 @@ std::vector<dynamics::SkeletonPtr> ContactConstraint::getSkeletons() const
 //==============================================================================
 const collision::Contact& ContactConstraint::getContact() const
 {
-  return mContact;
+  return *mContact;
 }
 
 //==============================================================================
@@ -952,6 +976,12 @@ s_t ContactConstraint::getCoefficientOfRestitution()
     return mRestitutionCoeff;
 }
 
+//==============================================================================
+bool ContactConstraint::didBounce() const
+{
+  return mIsBounceOn && mDidBounce;
+}
+
 //==============================================================================
 s_t ContactConstraint::getPenetrationCorrectionVelocity()
 {
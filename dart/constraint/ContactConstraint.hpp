@@ -59,6 +59,14 @@ public:
   /// Destructor
   ~ContactConstraint() override = default;
 
+  /// This points this constraint at a new contact, leaving it in the same
+  /// state as a freshly constructed one. ConstraintSolver uses this to
+  /// recycle constraint objects between steps.
+  void reset(
+      collision::Contact& contact,
+      s_t timeStep,
+      bool penetrationCorrectionEnabled);
+
   //----------------------------------------------------------------------------
   // Property settings
   //----------------------------------------------------------------------------
@@ -164,6 +172,9 @@ public:
   /// coefficient of restitution
   s_t getCoefficientOfRestitution() override;
 
+  /// Returns true if this contact bounced on the last solve
+  bool didBounce() const;
+
   /// Returns 0 if this constraint isn't using the "bouncing" hack to correct
   /// penetration. Otherwise, this returns the velocity being used by the
   /// penetration correction hack.
@@ -197,7 +208,7 @@ private:
   dynamics::BodyNodePtr mBodyNodeB;
 
   /// Contact between mBodyNode1 and mBodyNode2
-  collision::Contact& mContact;
+  collision::Contact* mContact;
 
   /// First frictional direction
   Eigen::Vector3s mFirstFrictionalDirection;
@@ -57,6 +57,15 @@ JointCoulombFrictionConstraint::JointCoulombFrictionConstraint(
   assert(_joint);
   assert(mBodyNode);
 
+  reset();
+}
+
+//==============================================================================
+void JointCoulombFrictionConstraint::reset()
+{
+  mBodyNode = mJoint->getChildBodyNode();
+  mAppliedImpulseIndex = 0;
+
   mLifeTime[0] = 0;
   mLifeTime[1] = 0;
   mLifeTime[2] = 0;
@@ -54,6 +54,11 @@ public:
   /// Destructor
   virtual ~JointCoulombFrictionConstraint();
 
+  /// This forgets which DOFs were active on earlier steps, leaving this in the
+  /// same state as a freshly constructed constraint on the same joint.
+  /// ConstraintSolver uses this to recycle constraint objects between steps.
+  void reset();
+
   //----------------------------------------------------------------------------
   // Property settings
   //----------------------------------------------------------------------------
@@ -63,6 +63,15 @@ JointLimitConstraint::JointLimitConstraint(dynamics::Joint* _joint)
   assert(_joint);
   assert(mBodyNode);
 
+  reset();
+}
+
+//==============================================================================
+void JointLimitConstraint::reset()
+{
+  mBodyNode = mJoint->getChildBodyNode();
+  mAppliedImpulseIndex = 0;
+
   mLifeTime[0] = 0;
   mLifeTime[1] = 0;
   mLifeTime[2] = 0;
@@ -55,6 +55,11 @@ public:
   /// Destructor
   virtual ~JointLimitConstraint();
 
+  /// This forgets which DOFs were active on earlier steps, leaving this in the
+  /// same state as a freshly constructed constraint on the same joint.
+  /// ConstraintSolver uses this to recycle constraint objects between steps.
+  void reset();
+
   //----------------------------------------------------------------------------
   // Property settings
   //----------------------------------------------------------------------------
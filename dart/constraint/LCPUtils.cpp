@@ -1,5 +1,6 @@
 #include "dart/constraint/LCPUtils.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -139,6 +140,144 @@ Eigen::VectorXs LCPUtils::guessSolution(
   return fullX;
 }
 
+//==============================================================================
+/// This reads off which bound (if any) each index of the warm start X sits
+/// at, and solves the linear system that keeps every index in that same
+/// place. If the warm start came from a previous timestep where nothing has
+/// changed categories, that's the exact solution in a single solve.
+bool LCPUtils::solveWithActiveSet(
+    const Eigen::MatrixXs& A,
+    Eigen::VectorXs& X,
+    const Eigen::VectorXs& b,
+    const Eigen::VectorXs& hi,
+    const Eigen::VectorXs& lo,
+    const Eigen::VectorXi& fIndex,
+    bool mixedPrecision)
+{
+  const int n = X.size();
+  if (n == 0)
+    return false;
+
+  const s_t tol = 1e-5;
+  auto isAt = [tol](s_t x, s_t bound) {
+    return isfinite(bound)
+           && abs(x - bound) <= tol * std::max<s_t>(1.0, abs(bound));
+  };
+
+  // Every x(i) is either free, or pinned to a bound. Friction bounds scale
+  // with their normal force, so x(i) = bound * x(fIndex(i)) is still linear in
+  // the free variables. We write x = map * freeX + offset.
+  std::vector<int> freeIndex(n, -1);
+  std::vector<s_t> pinnedBound(n, 0.0);
+  int numFree = 0;
+  for (int i = 0; i < n; i++)
+  {
+    s_t lowerLimit = lo(i);
+    s_t upperLimit = hi(i);
+    if (fIndex(i) != -1)
+    {
+      lowerLimit *= X(fIndex(i));
+      upperLimit *= X(fIndex(i));
+    }
+    if (isAt(X(i), lowerLimit))
+      pinnedBound[i] = lo(i);
+    else if (isAt(X(i), upperLimit))
+      pinnedBound[i] = hi(i);
+    else
+      freeIndex[i] = numFree++;
+  }
+  if (numFree == 0)
+    return false;
+
+  Eigen::MatrixXs map = Eigen::MatrixXs::Zero(n, numFree);
+  Eigen::VectorXs offset = Eigen::VectorXs::Zero(n);
+  // Fill in the normal forces first, since friction depends on them
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      if ((fIndex(i) == -1) != (pass == 0))
+        continue;
+      if (freeIndex[i] != -1)
+      {
+        map(i, freeIndex[i]) = 1.0;
+      }
+      else if (fIndex(i) == -1)
+      {
+        offset(i) = pinnedBound[i];
+      }
+      else
+      {
+        map.row(i) = pinnedBound[i] * map.row(fIndex(i));
+        offset(i) = pinnedBound[i] * offset(fIndex(i));
+      }
+    }
+  }
+
+  // The free indices get w = 0, which means (A * x)(i) = b(i)
+  Eigen::MatrixXs freeA(numFree, numFree);
+  Eigen::VectorXs freeB(numFree);
+  const Eigen::MatrixXs aMap = A * map;
+  const Eigen::VectorXs aOffset = A * offset;
+  for (int i = 0; i < n; i++)
+  {
+    if (freeIndex[i] == -1)
+      continue;
+    freeA.row(freeIndex[i]) = aMap.row(i);
+    freeB(freeIndex[i]) = b(i) - aOffset(i);
+  }
+  Eigen::VectorXs freeX
+      = mixedPrecision ? solveMixedPrecision(freeA, freeB)
+                       : freeA.completeOrthogonalDecomposition().solve(freeB);
+  Eigen::VectorXs guess = map * freeX + offset;
+
+  if (guess.hasNaN()
+      || !isLCPSolutionValid(A, guess, b, hi, lo, fIndex, false))
+    return false;
+  X = guess;
+  return true;
+}
+
+//==============================================================================
+Eigen::VectorXs LCPUtils::solveMixedPrecision(
+    const Eigen::MatrixXs& A, const Eigen::VectorXs& b, int maxRefinements)
+{
+  auto toFloat = [](s_t v) {
+    return static_cast<float>(static_cast<double>(v));
+  };
+  auto toScalar = [](float v) { return static_cast<s_t>(v); };
+
+  const Eigen::PartialPivLU<Eigen::MatrixXf> lu(A.unaryExpr(toFloat).eval());
+
+  // Each pass solves for the correction to x from the full precision residual,
+  // so the error shrinks by about the float round-off times cond(A) per pass.
+  // Once that stops helping we're at the limit of s_t, so we keep the best x
+  // if it's close enough.
+  const s_t scale = std::max<s_t>(1.0, b.norm());
+  Eigen::VectorXs x = Eigen::VectorXs::Zero(b.size());
+  Eigen::VectorXs bestX = x;
+  Eigen::VectorXs residual = b;
+  s_t bestNorm = b.norm();
+  for (int i = 0; i < maxRefinements; i++)
+  {
+    const Eigen::VectorXf correction
+        = lu.solve(residual.unaryExpr(toFloat).eval());
+    x += correction.unaryExpr(toScalar);
+    residual = b - A * x;
+    const s_t norm = residual.norm();
+    // This also catches NaNs from a singular factorization
+    if (!(norm < bestNorm))
+      break;
+    bestX = x;
+    bestNorm = norm;
+    if (norm <= 1e-12 * scale)
+      break;
+  }
+  if (bestNorm <= 1e-9 * scale)
+    return bestX;
+  return A.completeOrthogonalDecomposition().solve(b);
+}
+
 //==============================================================================
 /// This reduces an LCP problem by merging any near-identical contact points.
 Eigen::MatrixXs LCPUtils::reduce(
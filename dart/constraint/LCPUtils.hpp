@@ -32,6 +32,32 @@ public:
       const Eigen::VectorXs& mLo,
       const Eigen::VectorXi& mFIndex);
 
+  /// This reads off which bound (if any) each index of the warm start X sits
+  /// at, and solves the linear system that keeps every index in that same
+  /// place. If the result is a valid solution, this overwrites X with it and
+  /// returns true. Otherwise X is untouched. When the warm start is the
+  /// previous timestep's solution and no contact changed categories, this
+  /// gets the exact answer from a single linear solve. With mixedPrecision,
+  /// that solve goes through solveMixedPrecision().
+  static bool solveWithActiveSet(
+      const Eigen::MatrixXs& A,
+      Eigen::VectorXs& X,
+      const Eigen::VectorXs& b,
+      const Eigen::VectorXs& hi,
+      const Eigen::VectorXs& lo,
+      const Eigen::VectorXi& fIndex,
+      bool mixedPrecision = false);
+
+  /// This solves A * x = b by factoring A in single precision, which is
+  /// cheaper and vectorizes twice as wide, and then recovering full precision
+  /// with iterative refinement against the residual in s_t. If refinement
+  /// stalls because A is too ill-conditioned for floats, this falls back to a
+  /// full precision solve.
+  static Eigen::VectorXs solveMixedPrecision(
+      const Eigen::MatrixXs& A,
+      const Eigen::VectorXs& b,
+      int maxRefinements = 10);
+
   /// This reduces an LCP problem by merging any near-identical contact points.
   /// It returns a mapOut matrix, such that if you solve this LCP and then
   /// multiply the resulting x as mapOut*x, you'll get the solution to the
@@ -32,11 +32,13 @@
 
 #include "dart/constraint/PgsBoxedLcpSolver.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
 #include <Eigen/Dense>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/external/odelcpsolver/matrix.h"
 #include "dart/external/odelcpsolver/misc.h"
 #include "dart/math/Constants.hpp"
@@ -46,18 +48,76 @@
 namespace dart {
 namespace constraint {
 
+namespace {
+
+/// Colors with fewer blocks than this are swept on the calling thread
+constexpr int kMinBlocksPerColorTask = 16;
+
+//==============================================================================
+/// Returns b - A_ptr.dot(x), leaving out the diagonal entry i. Both halves of
+/// the row are contiguous, so Eigen can vectorize the dot products.
+s_t offDiagonalResidual(const s_t* A_ptr, const s_t* x, s_t b, int i, int n)
+{
+  Eigen::Map<const Eigen::VectorXs> row(A_ptr, n);
+  Eigen::Map<const Eigen::VectorXs> xs(x, n);
+  s_t residual = b;
+  if (i > 0)
+    residual -= row.head(i).dot(xs.head(i));
+  if (i + 1 < n)
+    residual -= row.tail(n - i - 1).dot(xs.tail(n - i - 1));
+  return residual;
+}
+
+//==============================================================================
+/// Clamps new_x into the bounds for row i. Friction rows are bounded by a
+/// multiple of the current impulse on their normal row.
+s_t clampToBounds(
+    s_t new_x,
+    int i,
+    const s_t* x,
+    const s_t* lo,
+    const s_t* hi,
+    const int* findex)
+{
+  if (findex[i] >= 0)
+  {
+    const s_t hi_tmp = hi[i] * x[findex[i]];
+    const s_t lo_tmp = -hi_tmp;
+
+    if (new_x > hi_tmp)
+      return hi_tmp;
+    else if (new_x < lo_tmp)
+      return lo_tmp;
+    return new_x;
+  }
+
+  if (new_x > hi[i])
+    return hi[i];
+  else if (new_x < lo[i])
+    return lo[i];
+  return new_x;
+}
+
+} // namespace
+
 //==============================================================================
 PgsBoxedLcpSolver::Option::Option(
     int maxIteration,
     s_t deltaXTolerance,
     s_t relativeDeltaXTolerance,
     s_t epsilonForDivision,
-    bool randomizeConstraintOrder)
+    bool randomizeConstraintOrder,
+    s_t relaxation,
+    bool groupFrictionRows,
+    bool parallelColoring)
   : mMaxIteration(maxIteration),
     mDeltaXThreshold(deltaXTolerance),
     mRelativeDeltaXTolerance(relativeDeltaXTolerance),
     mEpsilonForDivision(epsilonForDivision),
-    mRandomizeConstraintOrder(randomizeConstraintOrder)
+    mRandomizeConstraintOrder(randomizeConstraintOrder),
+    mRelaxation(relaxation),
+    mGroupFrictionRows(groupFrictionRows),
+    mParallelColoring(parallelColoring)
 {
   // Do nothing
 }
@@ -87,6 +147,7 @@ bool PgsBoxedLcpSolver::solve(
     int* findex,
     bool /*earlyTermination*/)
 {
+  std::lock_guard<std::mutex> lock(mCacheMutex);
   const int nskip = dPAD(n);
 
   // If all the variables are unbounded then we can just factor, solve, and
@@ -140,40 +201,14 @@ bool PgsBoxedLcpSolver::solve(
     const s_t old_x = x[i];
     assert(!isnan(old_x));
 
-    s_t new_x = b[i];
-
-    for (int j = 0; j < i; ++j)
-      new_x -= A_ptr[j] * x[j];
-
-    for (int j = i + 1; j < n; ++j)
-      new_x -= A_ptr[j] * x[j];
+    s_t new_x = offDiagonalResidual(A_ptr, x, b[i], i, n);
 
     assert(!isnan(new_x));
     assert(A[nskip * i + i] != 0);
     new_x /= A[nskip * i + i];
     assert(!isnan(new_x));
 
-    if (findex[i] >= 0)
-    {
-      const s_t hi_tmp = hi[i] * x[findex[i]];
-      const s_t lo_tmp = -hi_tmp;
-
-      if (new_x > hi_tmp)
-        x[i] = hi_tmp;
-      else if (new_x < lo_tmp)
-        x[i] = lo_tmp;
-      else
-        x[i] = new_x;
-    }
-    else
-    {
-      if (new_x > hi[i])
-        x[i] = hi[i];
-      else if (new_x < lo[i])
-        x[i] = lo[i];
-      else
-        x[i] = new_x;
-    }
+    x[i] = clampToBounds(new_x, i, x, lo, hi, findex);
     assert(!isnan(x[i]));
 
     // Test
@@ -199,58 +234,186 @@ bool PgsBoxedLcpSolver::solve(
       A[nskip * index + j] *= dummy;
   }
 
+  const bool parallel = mOption.mParallelColoring;
+  buildBlocks(n, findex, mOption.mGroupFrictionRows || parallel);
+  if (parallel)
+    colorBlocks(nskip, A);
+
+  int numIterations = 0;
   for (int iter = 1; iter < mOption.mMaxIteration; ++iter)
   {
-    if (mOption.mRandomizeConstraintOrder)
+    numIterations++;
+    if (parallel)
     {
-      if ((iter & 7) == 0)
+      possibleToTerminate = sweepColored(n, A, x, b, lo, hi, findex);
+    }
+    else
+    {
+      if (mOption.mRandomizeConstraintOrder)
       {
-        for (std::size_t i = 1; i < mCacheOrder.size(); ++i)
+        if ((iter & 7) == 0)
         {
-          const int tmp = mCacheOrder[i];
-          const int swapi = dRandInt(i + 1);
-          mCacheOrder[i] = mCacheOrder[swapi];
-          mCacheOrder[swapi] = tmp;
+          for (std::size_t i = 1; i < mCacheBlockOrder.size(); ++i)
+          {
+            const int tmp = mCacheBlockOrder[i];
+            const int swapi = dRandInt(i + 1);
+            mCacheBlockOrder[i] = mCacheBlockOrder[swapi];
+            mCacheBlockOrder[swapi] = tmp;
+          }
         }
       }
+      possibleToTerminate = sweepSequential(n, A, x, b, lo, hi, findex);
     }
 
-    possibleToTerminate = true;
+    if (possibleToTerminate)
+      break;
+  }
+  mNumIterations.fetch_add(numIterations, std::memory_order_relaxed);
+
+  return possibleToTerminate;
+}
+
+//==============================================================================
+void PgsBoxedLcpSolver::buildBlocks(
+    int n, const int* findex, bool groupFrictionRows)
+{
+  mCacheBlockRows.clear();
+  mCacheBlockStart.clear();
+  mCacheBlockRows.reserve(mCacheOrder.size());
 
-    // Single loop
-    for (const auto& index : mCacheOrder)
+  if (!groupFrictionRows)
+  {
+    for (int index : mCacheOrder)
     {
-      const s_t* A_ptr = A + nskip * index;
-      s_t new_x = b[index];
-      const s_t old_x = x[index];
+      mCacheBlockStart.push_back(mCacheBlockRows.size());
+      mCacheBlockRows.push_back(index);
+    }
+    mCacheBlockStart.push_back(mCacheBlockRows.size());
+  }
+  else
+  {
+    std::vector<bool> solving(n, false);
+    for (int index : mCacheOrder)
+      solving[index] = true;
+
+    // Every row that isn't bounded by another row we're solving for starts a
+    // block, and each friction row joins the block of its normal row
+    auto startsBlock = [&](int index) {
+      const int f = findex[index];
+      return f < 0 || !solving[f] || findex[f] >= 0;
+    };
+    std::vector<int> blockOf(n, -1);
+    int numBlocks = 0;
+    for (int index : mCacheOrder)
+    {
+      if (startsBlock(index))
+        blockOf[index] = numBlocks++;
+    }
+    std::vector<int> blockSize(numBlocks, 0);
+    for (int index : mCacheOrder)
+    {
+      if (blockOf[index] == -1)
+        blockOf[index] = blockOf[findex[index]];
+      blockSize[blockOf[index]]++;
+    }
 
-      for (int j = 0; j < index; j++)
-        new_x -= A_ptr[j] * x[j];
+    // Bucket the rows by block, keeping the normal row first
+    mCacheBlockStart.resize(numBlocks + 1);
+    mCacheBlockStart[0] = 0;
+    for (int i = 0; i < numBlocks; i++)
+      mCacheBlockStart[i + 1] = mCacheBlockStart[i] + blockSize[i];
+    mCacheBlockRows.resize(mCacheOrder.size());
+    std::vector<int> cursor(
+        mCacheBlockStart.begin(), mCacheBlockStart.end() - 1);
+    for (int index : mCacheOrder)
+    {
+      if (startsBlock(index))
+        mCacheBlockRows[cursor[blockOf[index]]++] = index;
+    }
+    for (int index : mCacheOrder)
+    {
+      if (!startsBlock(index))
+        mCacheBlockRows[cursor[blockOf[index]]++] = index;
+    }
+  }
 
-      for (int j = index + 1; j < n; j++)
-        new_x -= A_ptr[j] * x[j];
+  const int numBlocks = mCacheBlockStart.size() - 1;
+  mCacheBlockOrder.resize(numBlocks);
+  for (int i = 0; i < numBlocks; i++)
+    mCacheBlockOrder[i] = i;
+}
 
-      if (findex[index] >= 0)
-      {
-        const s_t hi_tmp = hi[index] * x[findex[index]];
-        const s_t lo_tmp = -hi_tmp;
-
-        if (new_x > hi_tmp)
-          x[index] = hi_tmp;
-        else if (new_x < lo_tmp)
-          x[index] = lo_tmp;
-        else
-          x[index] = new_x;
-      }
-      else
+//==============================================================================
+void PgsBoxedLcpSolver::colorBlocks(int nskip, const s_t* A)
+{
+  const int numBlocks = mCacheBlockOrder.size();
+  std::vector<int> colorOf(numBlocks, -1);
+  std::vector<int> neighborColorStamp;
+  mCacheColors.clear();
+
+  for (int blockA = 0; blockA < numBlocks; blockA++)
+  {
+    neighborColorStamp.assign(mCacheColors.size(), -1);
+    for (int blockB = 0; blockB < blockA; blockB++)
+    {
+      bool coupled = false;
+      for (int i = mCacheBlockStart[blockA];
+           !coupled && i < mCacheBlockStart[blockA + 1];
+           i++)
       {
-        if (new_x > hi[index])
-          x[index] = hi[index];
-        else if (new_x < lo[index])
-          x[index] = lo[index];
-        else
-          x[index] = new_x;
+        const int row = mCacheBlockRows[i];
+        for (int j = mCacheBlockStart[blockB]; j < mCacheBlockStart[blockB + 1];
+             j++)
+        {
+          const int col = mCacheBlockRows[j];
+          if (A[nskip * row + col] != 0 || A[nskip * col + row] != 0)
+          {
+            coupled = true;
+            break;
+          }
+        }
       }
+      if (coupled)
+        neighborColorStamp[colorOf[blockB]] = blockA;
+    }
+
+    int color = 0;
+    while (color < static_cast<int>(mCacheColors.size())
+           && neighborColorStamp[color] == blockA)
+      color++;
+    if (color == static_cast<int>(mCacheColors.size()))
+      mCacheColors.emplace_back();
+    mCacheColors[color].push_back(blockA);
+    colorOf[blockA] = color;
+  }
+}
+
+//==============================================================================
+bool PgsBoxedLcpSolver::sweepSequential(
+    int n,
+    const s_t* A,
+    s_t* x,
+    const s_t* b,
+    const s_t* lo,
+    const s_t* hi,
+    const int* findex)
+{
+  const int nskip = dPAD(n);
+  const s_t relaxation = mOption.mRelaxation;
+  bool possibleToTerminate = true;
+
+  for (int block : mCacheBlockOrder)
+  {
+    for (int i = mCacheBlockStart[block]; i < mCacheBlockStart[block + 1]; i++)
+    {
+      const int index = mCacheBlockRows[i];
+      // A has been normalized, so the diagonal is 1
+      s_t new_x = offDiagonalResidual(A + nskip * index, x, b[index], index, n);
+      const s_t old_x = x[index];
+      if (relaxation != 1.0)
+        new_x = old_x + relaxation * (new_x - old_x);
+
+      x[index] = clampToBounds(new_x, index, x, lo, hi, findex);
 
       if (possibleToTerminate && abs(x[index]) > mOption.mEpsilonForDivision)
       {
@@ -259,9 +422,109 @@ bool PgsBoxedLcpSolver::solve(
           possibleToTerminate = false;
       }
     }
+  }
 
-    if (possibleToTerminate)
-      break;
+  return possibleToTerminate;
+}
+
+//==============================================================================
+bool PgsBoxedLcpSolver::sweepColored(
+    int n,
+    const s_t* A,
+    s_t* x,
+    const s_t* b,
+    const s_t* lo,
+    const s_t* hi,
+    const int* findex)
+{
+  const int nskip = dPAD(n);
+  const s_t relaxation = mOption.mRelaxation;
+  const s_t epsilon = mOption.mEpsilonForDivision;
+  const s_t tolerance = mOption.mRelativeDeltaXTolerance;
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+
+  // Each task only writes the rows of its own blocks. Everything else is read
+  // from this snapshot, which is exact because blocks of the same color don't
+  // share any entries in A.
+  mCacheOldX = Eigen::Map<const Eigen::VectorXs>(x, n);
+  const s_t* snapshot = mCacheOldX.data();
+
+  auto sweepBlocks = [&](const std::vector<int>& blocks, int first, int last) {
+    bool converged = true;
+    for (int k = first; k < last; k++)
+    {
+      const int block = blocks[k];
+      const int start = mCacheBlockStart[block];
+      const int end = mCacheBlockStart[block + 1];
+      for (int i = start; i < end; i++)
+      {
+        const int index = mCacheBlockRows[i];
+        const s_t* A_ptr = A + nskip * index;
+        s_t new_x = offDiagonalResidual(A_ptr, snapshot, b[index], index, n);
+        // Swap the snapshot values for this block's rows for the ones we've
+        // already updated
+        for (int j = start; j < end; j++)
+        {
+          const int other = mCacheBlockRows[j];
+          if (other != index)
+            new_x += A_ptr[other] * (snapshot[other] - x[other]);
+        }
+        const s_t old_x = x[index];
+        if (relaxation != 1.0)
+          new_x = old_x + relaxation * (new_x - old_x);
+
+        x[index] = clampToBounds(new_x, index, x, lo, hi, findex);
+
+        if (converged && abs(x[index]) > epsilon)
+        {
+          if (abs((x[index] - old_x) / x[index]) > tolerance)
+            converged = false;
+        }
+      }
+    }
+    return converged;
+  };
+
+  bool possibleToTerminate = true;
+  for (const std::vector<int>& blocks : mCacheColors)
+  {
+    const int numBlocks = blocks.size();
+    const int numTasks = std::min(
+        static_cast<int>(pool.getNumThreads()),
+        numBlocks / kMinBlocksPerColorTask);
+    if (numTasks <= 1)
+    {
+      possibleToTerminate &= sweepBlocks(blocks, 0, numBlocks);
+    }
+    else
+    {
+      std::vector<std::future<bool>> futures;
+      for (int t = 0; t < numTasks; t++)
+      {
+        const int first = t * numBlocks / numTasks;
+        const int last = (t + 1) * numBlocks / numTasks;
+        futures.push_back(pool.submit(
+            [&sweepBlocks, &blocks, first, last]() {
+              return sweepBlocks(blocks, first, last);
+            }));
+      }
+      pool.waitAll(futures);
+      for (std::future<bool>& future : futures)
+      {
+        possibleToTerminate &= future.get();
+      }
+    }
+
+    // Refresh the snapshot with this color's updates before the next color
+    for (int block : blocks)
+    {
+      for (int i = mCacheBlockStart[block]; i < mCacheBlockStart[block + 1];
+           i++)
+      {
+        const int index = mCacheBlockRows[i];
+        mCacheOldX(index) = x[index];
+      }
+    }
   }
 
   return possibleToTerminate;
@@ -302,5 +565,11 @@ const PgsBoxedLcpSolver::Option& PgsBoxedLcpSolver::getOption() const
   return mOption;
 }
 
+//==============================================================================
+long PgsBoxedLcpSolver::getNumIterations() const
+{
+  return mNumIterations.load(std::memory_order_relaxed);
+}
+
 } // namespace constraint
 } // namespace dart
@@ -56,6 +56,8 @@ DART_COMMON_DECLARE_SHARED_WEAK(BoxedLcpSolver)
 DART_COMMON_DECLARE_SHARED_WEAK(PgsBoxedLcpSolver)
 DART_COMMON_DECLARE_SHARED_WEAK(PsorBoxedLcpSolver)
 DART_COMMON_DECLARE_SHARED_WEAK(JacobiBoxedLcpSolver)
+DART_COMMON_DECLARE_SHARED_WEAK(BlockJacobiBoxedLcpSolver)
+DART_COMMON_DECLARE_SHARED_WEAK(AdmmBoxedLcpSolver)
 
 DART_COMMON_DECLARE_SHARED_WEAK(JointConstraint)
 DART_COMMON_DECLARE_SHARED_WEAK(BallJointConstraint)
@@ -250,6 +250,9 @@ void ArrowShape::configureArrow(
 
   mIsBoundingBoxDirty = true;
   mIsVolumeDirty = true;
+  // We just moved the vertices, so any cached collision hull is stale
+  if (mMesh)
+    mMesh->invalidateSupportHull();
 
   incrementVersion();
 }
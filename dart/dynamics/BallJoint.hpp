@@ -204,7 +204,7 @@ protected:
 #endif
 public:
   // To get byte-aligned Eigen vectors
-  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  DART_SKELETON_ARENA_OPERATOR_NEW
 };
 
 } // namespace dynamics
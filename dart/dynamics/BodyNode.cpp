@@ -46,6 +46,8 @@
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Marker.hpp"
 #include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/MultiSphereConvexHullShape.hpp"
+#include "dart/dynamics/PointCloudShape.hpp"
 #include "dart/dynamics/Shape.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/dynamics/SoftBodyNode.hpp"
@@ -166,6 +168,12 @@ ConstSkeletonPtr SkeletonRefCountingBase::getSkeleton() const
   return mSkeleton.lock();
 }
 
+//==============================================================================
+int SkeletonRefCountingBase::getReferenceCount() const
+{
+  return mReferenceCount.load();
+}
+
 /// SKEL_SET_FLAGS : Lock a Skeleton pointer and activate dirty flags of X for
 /// the tree that this BodyNode belongs to, as well as the flag for the Skeleton
 /// overall
@@ -514,13 +522,6 @@ void BodyNode::setScale(Eigen::Vector3s newScale, bool silentlyClamp)
     }
   }
 
-  Eigen::Vector3s ratio = newScale.cwiseQuotient(mScale);
-
-  // Rescale inertia, COM, mass
-  Inertia inertia = getInertia();
-  inertia.rescale(ratio);
-  setInertia(inertia);
-
   // Rescale distance to parent joint
   Joint* parentJoint = getParentJoint();
   parentJoint->setChildScale(newScale);
@@ -532,6 +533,36 @@ void BodyNode::setScale(Eigen::Vector3s newScale, bool silentlyClamp)
     childJoint->setParentScale(newScale);
   }
 
+  mScale = newScale;
+
+  // If the skeleton is deferring scale updates, that's all kinematics needs.
+  // The shapes and inertia get caught up later by applyDeferredScale().
+  const SkeletonPtr& skel = getSkeleton();
+  if (skel && skel->mDeferScaleUpdates)
+  {
+    if (mScale != mAppliedScale)
+      skel->mHasDeferredScales = true;
+    return;
+  }
+
+  applyDeferredScale();
+}
+
+//==============================================================================
+void BodyNode::applyDeferredScale()
+{
+  if (mScale == mAppliedScale)
+    return;
+
+  const Eigen::Vector3s& newScale = mScale;
+  Eigen::Vector3s ratio = newScale.cwiseQuotient(mAppliedScale);
+  mAppliedScale = mScale;
+
+  // Rescale inertia, COM, mass
+  Inertia inertia = mAspectProperties.mInertia;
+  inertia.rescale(ratio);
+  setInertia(inertia);
+
   // Rescale all visible shapes and colliders
   for (int i = 0; i < getNumShapeNodes(); i++)
   {
@@ -575,9 +606,35 @@ void BodyNode::setScale(Eigen::Vector3s newScale, bool silentlyClamp)
       capsule->setRadius(capsule->getRadius() * ratio(0));
       capsule->setHeight(capsule->getHeight() * ratio(1));
     }
+    else if (shapePtr->getType() == PointCloudShape::getStaticType())
+    {
+      // This only refits the collision tree, rather than rebuilding it
+      PointCloudShape* cloud = static_cast<PointCloudShape*>(shapePtr.get());
+      cloud->setScale(cloud->getScale().cwiseProduct(ratio));
+    }
+    else if (
+        shapePtr->getType() == MultiSphereConvexHullShape::getStaticType())
+    {
+      if (ratio(0) != ratio(1) || ratio(1) != ratio(2))
+      {
+        std::cout << "WARNING: BodyNode attempting to setScale(" << newScale
+                  << ") but we're scaling an attached multi-sphere shape, "
+                     "whose spheres can't skew. Scaling radii by X-axis, "
+                     "arbitrarily."
+                  << std::endl;
+      }
+      MultiSphereConvexHullShape* hull
+          = static_cast<MultiSphereConvexHullShape*>(shapePtr.get());
+      MultiSphereConvexHullShape::Spheres spheres = hull->getSpheres();
+      for (auto& sphere : spheres)
+      {
+        sphere.first *= ratio(0);
+        sphere.second = sphere.second.cwiseProduct(ratio);
+      }
+      hull->removeAllSpheres();
+      hull->addSpheres(spheres);
+    }
   }
-
-  mScale = newScale;
 }
 
 //==============================================================================
@@ -658,6 +715,7 @@ Eigen::Vector3s BodyNode::getBeta()
 void BodyNode::setMomentOfInertia(
     s_t _Ixx, s_t _Iyy, s_t _Izz, s_t _Ixy, s_t _Ixz, s_t _Iyz)
 {
+  applyDeferredScale();
   mAspectProperties.mInertia.setMoment(_Ixx, _Iyy, _Izz, _Ixy, _Ixz, _Iyz);
 
   dirtyArticulatedInertia();
@@ -667,6 +725,7 @@ void BodyNode::setMomentOfInertia(
 void BodyNode::getMomentOfInertia(
     s_t& _Ixx, s_t& _Iyy, s_t& _Izz, s_t& _Ixy, s_t& _Ixz, s_t& _Iyz) const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
   _Ixx = mAspectProperties.mInertia.getParameter(Inertia::I_XX);
   _Iyy = mAspectProperties.mInertia.getParameter(Inertia::I_YY);
   _Izz = mAspectProperties.mInertia.getParameter(Inertia::I_ZZ);
@@ -679,12 +738,14 @@ void BodyNode::getMomentOfInertia(
 //==============================================================================
 const Eigen::Matrix6s& BodyNode::getSpatialInertia() const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
   return mAspectProperties.mInertia.getSpatialTensor();
 }
 
 //==============================================================================
 void BodyNode::setInertia(const Inertia& inertia)
 {
+  applyDeferredScale();
   if (inertia == mAspectProperties.mInertia)
     return;
 
@@ -703,6 +764,7 @@ void BodyNode::setInertia(const Inertia& inertia)
 //==============================================================================
 const Inertia& BodyNode::getInertia() const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
   return mAspectProperties.mInertia;
 }
 
@@ -729,6 +791,7 @@ const math::Inertia& BodyNode::getArticulatedInertiaImplicit() const
 //==============================================================================
 void BodyNode::setLocalCOM(const Eigen::Vector3s& _com)
 {
+  applyDeferredScale();
   mAspectProperties.mInertia.setLocalCOM(_com);
 
   dirtyArticulatedInertia();
@@ -737,6 +800,7 @@ void BodyNode::setLocalCOM(const Eigen::Vector3s& _com)
 //==============================================================================
 const Eigen::Vector3s& BodyNode::getLocalCOM() const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
   return mAspectProperties.mInertia.getLocalCOM();
 }
 
@@ -839,16 +903,22 @@ Eigen::Vector3s BodyNode::getClosestVerticesToMarker(Eigen::Vector3s marker)
     {
       dynamics::MeshShape* meshShape
           = static_cast<dynamics::MeshShape*>(shape.get());
-      std::vector<Eigen::Vector3s> vertices = meshShape->getVertices();
-      for (int j = 0; j < vertices.size(); j++)
+      // The k-d tree is built on the unscaled mesh, and takes our scale at
+      // query time, so it stays valid as we get rescaled
+      std::shared_ptr<const math::VertexKdTree> tree
+          = meshShape->getVertexKdTree();
+      if (tree == nullptr)
+        continue;
+      int nearest = tree->findNearest(marker, getScale());
+      if (nearest == -1)
+        continue;
+      Eigen::Vector3s vertex
+          = getScale().cwiseProduct(tree->getVertices()[nearest]);
+      Eigen::Vector3s diff = marker - vertex;
+      if (diff.squaredNorm() < minDist)
       {
-        Eigen::Vector3s vertex = getScale().cwiseProduct(vertices[j]);
-        Eigen::Vector3s diff = marker - vertex;
-        if (diff.squaredNorm() < minDist)
-        {
-          minDist = diff.squaredNorm();
-          minDistVertex = vertex;
-        }
+        minDist = diff.squaredNorm();
+        minDistVertex = vertex;
       }
     }
   }
@@ -1171,6 +1241,8 @@ DART_BAKE_SPECIALIZED_NODE_DEFINITIONS(BodyNode, ShapeNode)
 //==============================================================================
 const std::vector<ShapeNode*> BodyNode::getShapeNodes()
 {
+  applyDeferredScale();
+
   const auto numShapeNodes = getNumShapeNodes();
 
   std::vector<ShapeNode*> shapeNodes(numShapeNodes);
@@ -1184,6 +1256,8 @@ const std::vector<ShapeNode*> BodyNode::getShapeNodes()
 //==============================================================================
 const std::vector<const ShapeNode*> BodyNode::getShapeNodes() const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
+
   const auto numShapeNodes = getNumShapeNodes();
 
   std::vector<const ShapeNode*> shapeNodes(numShapeNodes);
@@ -1206,6 +1280,8 @@ void BodyNode::removeAllShapeNodes()
 /// This gets all the vertices from any mesh colliders, in local space
 std::vector<Eigen::Vector3s> BodyNode::getLocalVertices() const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
+
   std::vector<Eigen::Vector3s> verts;
   for (int k = 0; k < getNumShapeNodes(); k++)
   {
@@ -1582,6 +1658,7 @@ BodyNode::BodyNode(
     mParentJoint(_parentJoint),
     mParentBodyNode(nullptr),
     mScale(Eigen::Vector3s::Ones()),
+    mAppliedScale(Eigen::Vector3s::Ones()),
     mScaleLowerBound(Eigen::Vector3s::Ones() * 0.75),
     mScaleUpperBound(Eigen::Vector3s::Ones() * 1.5),
     mPartialAcceleration(Eigen::Vector6s::Zero()),
@@ -1637,11 +1714,16 @@ BodyNode::BodyNode(const std::tuple<BodyNode*, Joint*, Properties>& args)
 BodyNode* BodyNode::clone(
     BodyNode* _parentBodyNode, Joint* _parentJoint, bool cloneNodes) const
 {
+  // The clone copies our inertia and shapes as they are, so catch them up first
+  const_cast<BodyNode*>(this)->applyDeferredScale();
+
   BodyNode* clonedBn
       = new BodyNode(_parentBodyNode, _parentJoint, getBodyNodeProperties());
   clonedBn->mScale = mScale;
+  clonedBn->mAppliedScale = mAppliedScale;
   clonedBn->mScaleLowerBound = mScaleLowerBound;
   clonedBn->mScaleUpperBound = mScaleUpperBound;
+  clonedBn->mBeta = mBeta;
 
   clonedBn->matchAspects(this);
 
@@ -1806,6 +1888,7 @@ void BodyNode::dirtyTransform()
     return;
 
   mNeedTransformUpdate = true;
+  ++mTransformVersion;
 
   const SkeletonPtr& skel = getSkeleton();
   if (skel)
@@ -1818,6 +1901,11 @@ void BodyNode::dirtyTransform()
     SET_FLAGS(mGravityForces);
     SET_FLAGS(mCoriolisAndGravityForces);
     SET_FLAGS(mExternalForces);
+
+    // The KinematicsContext only lives on the Skeleton as a whole. It gets
+    // rebuilt with every BodyNode's transform clean, so the early return above
+    // can't cause us to miss a change here.
+    skel->mSkelCache.mDirty.mKinematicsContext = true;
   }
 
   // Child BodyNodes and other generic Entities are notified separately to allow
@@ -2301,6 +2389,7 @@ s_t BodyNode::getKineticEnergy() const
 //==============================================================================
 s_t BodyNode::computeKineticEnergy() const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
   const Eigen::Vector6s& V = getSpatialVelocity();
   const Eigen::Matrix6s& G = mAspectProperties.mInertia.getSpatialTensor();
 
@@ -2322,6 +2411,7 @@ s_t BodyNode::computePotentialEnergy(const Eigen::Vector3s& gravity) const
 //==============================================================================
 Eigen::Vector3s BodyNode::getLinearMomentum() const
 {
+  const_cast<BodyNode*>(this)->applyDeferredScale();
   const Eigen::Matrix6s& mI = mAspectProperties.mInertia.getSpatialTensor();
   return (mI * getSpatialVelocity()).tail<3>();
 }
@@ -2329,6 +2419,7 @@ Eigen::Vector3s BodyNode::getLinearMomentum() const
 //==============================================================================
 Eigen::Vector3s BodyNode::getAngularMomentum(const Eigen::Vector3s& _pivot)
 {
+  applyDeferredScale();
   Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
   const Eigen::Matrix6s& mI = mAspectProperties.mInertia.getSpatialTensor();
   T.translation() = _pivot;
@@ -2992,6 +3083,7 @@ void BodyNode::computeJacobianOfMForward(neural::WithRespectTo* wrt)
 void BodyNode::computeJacobianOfMBackward(
     neural::WithRespectTo* wrt, Eigen::MatrixXs& dMddq)
 {
+  applyDeferredScale();
   using math::AdInvRLinear;
   using math::dad;
   using math::dAdInvT;
@@ -3357,6 +3449,7 @@ void BodyNode::computeJacobianOfCBackward(
     Eigen::MatrixXs& dCg,
     const Eigen::Vector3s& gravity)
 {
+  applyDeferredScale();
   using math::AdInvRLinear;
   using math::dad;
   using math::dAdInvT;
@@ -3483,6 +3576,196 @@ void BodyNode::computeJacobianOfCBackward(
   }
 }
 
+//==============================================================================
+void BodyNode::computeDynamicsJacobiansForward()
+{
+  using math::ad;
+  using math::AdInvT;
+  using math::Jacobian;
+
+  const auto skel = getSkeleton();
+  const int numDofs = static_cast<int>(skel->getNumDofs());
+
+  // To update mCg_dV
+  updateCombinedVector();
+
+  mCg_V_p.resize(6, numDofs);
+  mCg_dV_p.resize(6, numDofs);
+  mMddq_dV_p.resize(6, numDofs);
+  mCg_V_v.resize(6, numDofs);
+  mCg_dV_v.resize(6, numDofs);
+
+  const Eigen::Isometry3s& T = mParentJoint->getRelativeTransform();
+  const Jacobian& H = mParentJoint->getRelativeJacobianInPositionSpace();
+  const Jacobian& S = mParentJoint->getRelativeJacobian();
+  const Jacobian& dS = mParentJoint->getRelativeJacobianTimeDeriv();
+  const Eigen::VectorXs& dq = mParentJoint->getVelocities();
+  const Eigen::VectorXs& ddq = mParentJoint->getAccelerations();
+  const Eigen::Vector6s& V = getSpatialVelocity();
+  const Eigen::Vector6s Sdq = S * dq;
+
+  Eigen::Vector6s parentV = Eigen::Vector6s::Zero();
+  Eigen::Vector6s parentCg_dV = Eigen::Vector6s::Zero();
+  Eigen::Vector6s parentMddq_dV = Eigen::Vector6s::Zero();
+  if (mParentBodyNode)
+  {
+    parentV = AdInvT(T, mParentBodyNode->getSpatialVelocity());
+    parentCg_dV = AdInvT(T, mParentBodyNode->mCg_dV);
+    parentMddq_dV = AdInvT(T, mParentBodyNode->mMddq_dV);
+  }
+  mMddq_dV = parentMddq_dV + S * ddq;
+
+  for (int i = 0; i < numDofs; ++i)
+  {
+    if (mParentBodyNode)
+    {
+      mCg_V_p.col(i) = AdInvT(T, mParentBodyNode->mCg_V_p.col(i));
+      mCg_dV_p.col(i) = AdInvT(T, mParentBodyNode->mCg_dV_p.col(i));
+      mMddq_dV_p.col(i) = AdInvT(T, mParentBodyNode->mMddq_dV_p.col(i));
+      mCg_V_v.col(i) = AdInvT(T, mParentBodyNode->mCg_V_v.col(i));
+      mCg_dV_v.col(i) = AdInvT(T, mParentBodyNode->mCg_dV_v.col(i));
+    }
+    else
+    {
+      mCg_V_p.col(i).setZero();
+      mCg_dV_p.col(i).setZero();
+      mMddq_dV_p.col(i).setZero();
+      mCg_V_v.col(i).setZero();
+      mCg_dV_v.col(i).setZero();
+    }
+
+    const DegreeOfFreedom* dof = skel->getDof(i);
+    if (mParentJoint->hasDof(dof))
+    {
+      const std::size_t dofIndexInJoint = dof->getIndexInJoint();
+      const Eigen::Vector6s Hcol = H.col(dofIndexInJoint);
+      const Eigen::Vector6s Scol = S.col(dofIndexInJoint);
+
+      const Jacobian DS_Dq
+          = mParentJoint->getRelativeJacobianDeriv(dofIndexInJoint);
+      const Jacobian DdS_Dq
+          = mParentJoint->getRelativeJacobianTimeDerivDerivWrtPosition(
+              dofIndexInJoint);
+      const Jacobian DdS_Ddq
+          = mParentJoint->getRelativeJacobianTimeDerivDerivWrtVelocity(
+              dofIndexInJoint);
+      const Eigen::Vector6s DS_Dq_dq = DS_Dq * dq;
+
+      mCg_V_p.col(i) += DS_Dq_dq - ad(Hcol, parentV);
+      mCg_dV_p.col(i)
+          += ad(V, DS_Dq_dq) + DdS_Dq * dq - ad(Hcol, parentCg_dV);
+      mMddq_dV_p.col(i) += DS_Dq * ddq - ad(Hcol, parentMddq_dV);
+
+      mCg_V_v.col(i) += Scol;
+      mCg_dV_v.col(i) += ad(V, Scol) + DdS_Ddq * dq + dS.col(dofIndexInJoint);
+    }
+
+    mCg_dV_p.col(i) += ad(mCg_V_p.col(i), Sdq);
+    mCg_dV_v.col(i) += ad(mCg_V_v.col(i), Sdq);
+  }
+}
+
+//==============================================================================
+void BodyNode::computeDynamicsJacobiansBackward(
+    Eigen::MatrixXs& dMddq_dq,
+    Eigen::MatrixXs& dC_dq,
+    Eigen::MatrixXs& dC_dv,
+    const Eigen::Vector3s& gravity)
+{
+  applyDeferredScale();
+  using math::dad;
+  using math::dAdInvT;
+  using math::Jacobian;
+
+  const auto skel = getSkeleton();
+  const int numDofs = static_cast<int>(skel->getNumDofs());
+
+  Eigen::VectorXs tmp;
+  tmp.resize(numDofs);
+  aggregateCombinedVector(tmp, gravity);
+
+  mCg_F_p.resize(6, numDofs);
+  mCg_g_p.resize(6, numDofs);
+  mCg_g_p.setZero();
+  mMddq_F_p.resize(6, numDofs);
+  mCg_F_v.resize(6, numDofs);
+
+  const Eigen::Matrix6s& G = mAspectProperties.mInertia.getSpatialTensor();
+  const Jacobian& H = skel->getJacobianInPositionSpace(this);
+  const Eigen::Vector6s& V = getSpatialVelocity();
+  const Eigen::Vector6s GV = G * V;
+  const Eigen::Vector3s localGravity
+      = getWorldTransform().linear().transpose() * gravity;
+
+  mMddq_F = G * mMddq_dV + mAspectState.mFext;
+  for (BodyNode* childBody : mChildBodyNodes)
+  {
+    const Eigen::Isometry3s& childT
+        = childBody->getParentJoint()->getRelativeTransform();
+    mMddq_F += dAdInvT(childT, childBody->mMddq_F);
+  }
+
+  for (int i = 0; i < numDofs; ++i)
+  {
+    const DegreeOfFreedom* dof = skel->getDof(i);
+
+    // Derivative of gravity force
+    mCg_g_p.col(i).tail<3>().noalias()
+        = -1 * math::makeSkewSymmetric(H.col(i).head<3>()) * localGravity;
+    mCg_g_p.col(i) = G * mCg_g_p.col(i);
+
+    const Eigen::Vector6s V_p = mCg_V_p.col(i);
+    mCg_F_p.col(i) = G * mCg_dV_p.col(i) - dad(V_p, GV) - dad(V, G * V_p)
+                     - mCg_g_p.col(i);
+    mMddq_F_p.col(i) = G * mMddq_dV_p.col(i);
+    const Eigen::Vector6s V_v = mCg_V_v.col(i);
+    mCg_F_v.col(i) = G * mCg_dV_v.col(i) - dad(V_v, GV) - dad(V, G * V_v);
+
+    for (BodyNode* childBody : mChildBodyNodes)
+    {
+      const Joint* childJoint = childBody->getParentJoint();
+      const Eigen::Isometry3s& childT = childJoint->getRelativeTransform();
+
+      Eigen::Vector6s childCg_F_p = childBody->mCg_F_p.col(i);
+      Eigen::Vector6s childMddq_F_p = childBody->mMddq_F_p.col(i);
+      if (childJoint->hasDof(dof))
+      {
+        const Eigen::Vector6s Hcol
+            = childJoint->getRelativeJacobianInPositionSpace().col(
+                dof->getIndexInJoint());
+        childCg_F_p -= dad(Hcol, childBody->mCg_F);
+        childMddq_F_p -= dad(Hcol, childBody->mMddq_F);
+      }
+      mCg_F_p.col(i) += dAdInvT(childT, childCg_F_p);
+      mMddq_F_p.col(i) += dAdInvT(childT, childMddq_F_p);
+      mCg_F_v.col(i) += dAdInvT(childT, childBody->mCg_F_v.col(i));
+    }
+  }
+
+  const int jointNumDofs = static_cast<int>(mParentJoint->getNumDofs());
+  if (jointNumDofs == 0)
+    return;
+
+  const Jacobian& S = mParentJoint->getRelativeJacobian();
+  const int iStart
+      = static_cast<int>(mParentJoint->getDof(0)->getIndexInSkeleton());
+  dC_dq.middleRows(iStart, jointNumDofs).noalias() = S.transpose() * mCg_F_p;
+  dMddq_dq.middleRows(iStart, jointNumDofs).noalias()
+      = S.transpose() * mMddq_F_p;
+  dC_dv.middleRows(iStart, jointNumDofs).noalias() = S.transpose() * mCg_F_v;
+
+  // Only this joint's own positions move S
+  for (int j = 0; j < jointNumDofs; ++j)
+  {
+    const int col = static_cast<int>(mParentJoint->getIndexInSkeleton(j));
+    const Jacobian DS_Dq = mParentJoint->getRelativeJacobianDeriv(j);
+    dC_dq.block(iStart, col, jointNumDofs, 1).noalias()
+        += DS_Dq.transpose() * mCg_F;
+    dMddq_dq.block(iStart, col, jointNumDofs, 1).noalias()
+        += DS_Dq.transpose() * mMddq_F;
+  }
+}
+
 //==============================================================================
 /// This checks the intermediate analytical results of
 /// computeJacobianOfCBackword() against the finite differencing equivalents.
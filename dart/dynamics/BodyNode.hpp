@@ -46,6 +46,7 @@
 #include "dart/dynamics/Frame.hpp"
 #include "dart/dynamics/Node.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SkeletonArena.hpp"
 #include "dart/dynamics/SmartPointer.hpp"
 #include "dart/dynamics/SpecializedNodeManager.hpp"
 #include "dart/dynamics/TemplatedJacobianNode.hpp"
@@ -180,6 +181,11 @@ public:
   /// Returns the scale of the body node.
   Eigen::Vector3s getScale() const;
 
+  /// This rescales our shapes and inertia to match getScale(), if
+  /// setScale() was called while our Skeleton was deferring scale updates
+  /// (see Skeleton::setDeferScaleUpdates()). Otherwise this does nothing.
+  void applyDeferredScale();
+
   void setScaleLowerBound(Eigen::Vector3s lowerBound);
   Eigen::Vector3s getScaleLowerBound() const;
   void setScaleUpperBound(Eigen::Vector3s upperBound);
@@ -967,6 +973,7 @@ public:
   friend class SoftBodyNode;
   friend class PointMass;
   friend class Node;
+  friend class JointDispatchTable;
 
 protected:
   /// Constructor called by Skeleton class
@@ -1153,6 +1160,20 @@ protected:
       Eigen::MatrixXs& dCg,
       const Eigen::Vector3s& gravity);
 
+  /// This does the work of computeJacobianOfMForward(POSITION) and
+  /// computeJacobianOfCForward() for both POSITION and VELOCITY in a single
+  /// visit, so each derivative of the joint's Jacobian is only computed once.
+  /// The M terms use the joint's current accelerations.
+  void computeDynamicsJacobiansForward();
+
+  /// This is the backward half of computeDynamicsJacobiansForward(). It writes
+  /// this body's rows of d(M * ddq)/dq, dC/dq and dC/dv.
+  void computeDynamicsJacobiansBackward(
+      Eigen::MatrixXs& dMddq_dq,
+      Eigen::MatrixXs& dC_dq,
+      Eigen::MatrixXs& dC_dv,
+      const Eigen::Vector3s& gravity);
+
   void computeJacobianOfMinvXInit();
   void computeJacobianOfMinvXBackward();
   void computeJacobianOfMinvXForward(Eigen::MatrixXs& DinvMx_Dq);
@@ -1276,6 +1297,10 @@ public:
   /// to 1.0 when a body is created, but can be updated by calls to setScale().
   Eigen::Vector3s mScale;
 
+  /// This is the scale our shapes and inertia were last rescaled to. It only
+  /// differs from mScale while the Skeleton is deferring scale updates.
+  Eigen::Vector3s mAppliedScale;
+
   Eigen::Vector3s mScaleLowerBound;
   Eigen::Vector3s mScaleUpperBound;
 
@@ -1376,6 +1401,14 @@ public:
   math::Jacobian mCg_V_ad_IV_p;
   math::Jacobian mCg_IdV_p;
 
+  /// The same as mCg_V_p, mCg_dV_p and mCg_F_p, but with respect to velocity.
+  /// Only computeDynamicsJacobiansForward() and
+  /// computeDynamicsJacobiansBackward() use these, since they need both at
+  /// once.
+  math::Jacobian mCg_V_v;
+  math::Jacobian mCg_dV_v;
+  math::Jacobian mCg_F_v;
+
   std::vector<math::Inertia> mInvM_DAI_Dq;
   math::Jacobian mInvM_DAB_Dq;
   std::vector<math::Inertia> mInvM_DPi_Dq;
@@ -1410,7 +1443,7 @@ public:
 
 public:
   // To get byte-aligned Eigen vectors
-  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  DART_SKELETON_ARENA_OPERATOR_NEW
 
   //----------------------------------------------------------------------------
   /// \{ \name Slot registers
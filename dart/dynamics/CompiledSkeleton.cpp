@@ -0,0 +1,570 @@
+#include "dart/dynamics/CompiledSkeleton.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "dart/common/Console.hpp"
+#include "dart/common/SharedLibrary.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/JointDispatchTable.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+// The mutex and the version counter are constant-initialized, so they're safe
+// to use from other files' static initializers. The containers aren't, so
+// they're built on first use instead, since generated files register
+// themselves from static initializers that can run before this file's.
+std::mutex gRegistryMutex;
+std::atomic<std::size_t> gRegistryVersion(0);
+
+using Registry = std::
+    unordered_map<std::string, std::shared_ptr<CompiledSkeletonDynamics>>;
+
+//==============================================================================
+Registry& getRegistry()
+{
+  static Registry registry;
+  return registry;
+}
+
+//==============================================================================
+std::vector<std::shared_ptr<common::SharedLibrary>>& getPlugins()
+{
+  static std::vector<std::shared_ptr<common::SharedLibrary>> plugins;
+  return plugins;
+}
+
+/// What the generator needs to know about each body
+struct BodyInfo
+{
+  int parent;
+  int numDofs;
+  std::size_t dofOffset;
+  JointDispatchTable::JointKind kind;
+  /// True if the joint's Jacobian never depends on its positions, so we can
+  /// skip asking for its derivatives
+  bool constantJacobian;
+  std::string jointType;
+  std::string name;
+};
+
+//==============================================================================
+/// This fills in `bodies` for `skel`, and returns false if generated code
+/// can't handle it
+bool getBodyInfo(const Skeleton* skel, std::vector<BodyInfo>& bodies)
+{
+  bodies.clear();
+  if (skel->getNumSoftBodyNodes() > 0)
+    return false;
+
+  for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    const BodyNode* bodyNode = skel->getBodyNode(i);
+    const Joint* joint = bodyNode->getParentJoint();
+
+    BodyInfo info;
+    const BodyNode* parent = bodyNode->getParentBodyNode();
+    info.parent = parent == nullptr
+                      ? -1
+                      : static_cast<int>(parent->getIndexInSkeleton());
+    info.numDofs = joint->getNumDofs();
+    info.dofOffset = info.numDofs > 0 ? joint->getIndexInSkeleton(0) : 0;
+    info.kind = JointDispatchTable::getJointKind(joint);
+    info.jointType = joint->getType();
+    info.constantJacobian = info.jointType == "RevoluteJoint"
+                            || info.jointType == "PrismaticJoint"
+                            || info.jointType == "ScrewJoint"
+                            || info.jointType == "WeldJoint";
+    info.name = bodyNode->getName() + " (" + joint->getName() + ")";
+
+    if (info.kind == JointDispatchTable::JointKind::VIRTUAL)
+      return false;
+    // Parents have to come first, since the passes run in index order
+    if (info.parent >= static_cast<int>(i))
+      return false;
+    for (int d = 0; d < info.numDofs; d++)
+    {
+      if (joint->getIndexInSkeleton(d) != info.dofOffset + d)
+        return false;
+    }
+    bodies.push_back(info);
+  }
+  return true;
+}
+
+//==============================================================================
+/// This returns the configuration space class for `kind`
+std::string getConfigSpaceName(JointDispatchTable::JointKind kind)
+{
+  switch (kind)
+  {
+    case JointDispatchTable::JointKind::R1:
+      return "dart::math::R1Space";
+    case JointDispatchTable::JointKind::R2:
+      return "dart::math::R2Space";
+    case JointDispatchTable::JointKind::R3:
+      return "dart::math::R3Space";
+    case JointDispatchTable::JointKind::R6:
+      return "dart::math::R6Space";
+    case JointDispatchTable::JointKind::SO3:
+      return "dart::math::SO3Space";
+    case JointDispatchTable::JointKind::SE3:
+      return "dart::math::SE3Space";
+    default:
+      return "";
+  }
+}
+
+//==============================================================================
+/// This makes `name` safe to put in a C++ comment
+std::string sanitizeComment(const std::string& name)
+{
+  std::string out;
+  for (char c : name)
+  {
+    if (c == '\n' || c == '\r' || c == '*' || c == '/' || c == '\\')
+      out.push_back('_');
+    else
+      out.push_back(c);
+  }
+  return out;
+}
+
+//==============================================================================
+bool isIdentifier(const std::string& name)
+{
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+    return false;
+  for (char c : name)
+  {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_')
+      return false;
+  }
+  return true;
+}
+
+//==============================================================================
+/// This writes out the tangent passes for every coordinate, with respect to
+/// positions or velocities
+void writeTangents(
+    std::ostream& out,
+    const std::vector<BodyInfo>& bodies,
+    const std::vector<std::vector<int>>& subtrees,
+    bool wrtVelocity)
+{
+  const int numBodies = bodies.size();
+  for (int j = 0; j < numBodies; j++)
+  {
+    const BodyInfo& owner = bodies[j];
+    for (int l = 0; l < owner.numDofs; l++)
+    {
+      const std::size_t col = owner.dofOffset + l;
+      if (col > 0)
+        out << "\n";
+      out << "    // " << (wrtVelocity ? "Velocity " : "Position ") << col
+          << ": " << sanitizeComment(owner.name) << ", DOF " << l << "\n";
+
+      // Nothing above the joint moves, so the ancestors only collect forces
+      for (int a = owner.parent; a >= 0; a = bodies[a].parent)
+      {
+        out << "    b.b" << a << ".tF.setZero();\n";
+      }
+
+      const std::vector<int>& subtree = subtrees[j];
+      for (int i : subtree)
+      {
+        if (i == j)
+        {
+          out << "    tangentStart(b.b" << i << ");\n";
+          out << "    tangentOwn" << (wrtVelocity ? "Velocity" : "Position")
+              << "(b.b" << i << ", " << l << ", "
+              << (owner.constantJacobian ? "true" : "false") << ");\n";
+        }
+        else
+        {
+          out << "    tangentForward(b.b" << i << ", b.b" << bodies[i].parent
+              << ");\n";
+        }
+        out << "    finishTangent(b.b" << i << ");\n";
+      }
+
+      for (auto it = subtree.rbegin(); it != subtree.rend(); ++it)
+      {
+        int i = *it;
+        bool ownPosition = !wrtVelocity && i == j;
+        if (bodies[i].numDofs > 0)
+        {
+          out << "    tangentProject(b.b" << i << ", " << bodies[i].dofOffset
+              << ", "
+              << (ownPosition && !owner.constantJacobian ? "true" : "false")
+              << ", J, " << col << ");\n";
+        }
+        if (bodies[i].parent >= 0)
+        {
+          out << "    tangentBackward(b.b" << i << ", b.b" << bodies[i].parent
+              << ", " << (ownPosition ? l : -1) << ");\n";
+        }
+      }
+
+      for (int a = owner.parent; a >= 0; a = bodies[a].parent)
+      {
+        if (bodies[a].numDofs > 0)
+        {
+          out << "    tangentProject(b.b" << a << ", " << bodies[a].dofOffset
+              << ", false, J, " << col << ");\n";
+        }
+        if (bodies[a].parent >= 0)
+        {
+          out << "    tangentBackward(b.b" << a << ", b.b" << bodies[a].parent
+              << ", -1);\n";
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+//==============================================================================
+CompiledSkeletonDynamics::~CompiledSkeletonDynamics()
+{
+}
+
+//==============================================================================
+/// This returns a string that identifies the topology and joint types of
+/// `skel`. Two Skeletons with the same signature can share generated code.
+/// This returns an empty string if `skel` has anything that generated code
+/// can't handle, like SoftBodyNodes or joints on unusual configuration
+/// spaces.
+std::string CompiledSkeletonDynamics::getSignature(const Skeleton* skel)
+{
+  std::vector<BodyInfo> bodies;
+  if (!getBodyInfo(skel, bodies))
+    return "";
+
+  std::stringstream out;
+  out << "v1";
+  for (const BodyInfo& body : bodies)
+  {
+    out << ";" << body.parent << "," << body.jointType << ","
+        << static_cast<int>(body.kind) << "," << body.numDofs << ","
+        << body.dofOffset;
+  }
+  return out.str();
+}
+
+//==============================================================================
+/// This writes out a C++ source file with a subclass of
+/// CompiledSkeletonDynamics called `className`, specialized to `skel`. The
+/// file registers its class when it's loaded. This returns an empty string
+/// if getSignature() can't handle `skel`.
+std::string CompiledSkeletonDynamics::generateSource(
+    const Skeleton* skel, const std::string& className)
+{
+  if (!isIdentifier(className))
+  {
+    dterr << "[CompiledSkeletonDynamics::generateSource] \"" << className
+          << "\" isn't a valid C++ class name.\n";
+    return "";
+  }
+  std::vector<BodyInfo> bodies;
+  if (!getBodyInfo(skel, bodies))
+  {
+    dterr << "[CompiledSkeletonDynamics::generateSource] Skeleton \""
+          << skel->getName()
+          << "\" has SoftBodyNodes, or joints that generated code doesn't "
+             "support.\n";
+    return "";
+  }
+
+  const int numBodies = bodies.size();
+  std::vector<std::vector<int>> subtrees(numBodies);
+  for (int i = 0; i < numBodies; i++)
+  {
+    for (int a = i; a >= 0; a = bodies[a].parent)
+    {
+      subtrees[a].push_back(i);
+    }
+  }
+
+  std::stringstream out;
+  out << "// This file was generated by "
+         "dart::dynamics::CompiledSkeletonDynamics::generateSource() for the\n"
+      << "// Skeleton \"" << sanitizeComment(skel->getName())
+      << "\". Don't edit it by hand, regenerate it instead.\n\n";
+  out << "#include \"dart/dynamics/detail/CompiledSkeletonKernels.hpp\"\n\n";
+  out << "namespace {\n\n";
+  out << "using namespace dart::dynamics::compiled;\n";
+  out << "using dart::dynamics::Skeleton;\n\n";
+  out << "class " << className
+      << " final : public dart::dynamics::CompiledSkeletonDynamics\n{\n";
+  out << "public:\n";
+
+  // getSignature()
+  out << "  std::string getSignature() const override\n  {\n";
+  out << "    return \"" << getSignature(skel) << "\";\n  }\n\n";
+
+  // computeMassMatrix(), as the composite rigid body algorithm
+  out << "  void computeMassMatrix(\n"
+      << "      const Skeleton* skel, Eigen::MatrixXs& M) const override\n"
+      << "  {\n";
+  out << "    Bodies b;\n";
+  out << "    load(skel, b, false, nullptr);\n";
+  out << "    M.setZero();\n\n";
+  out << "    // The inertia of each body and everything below it\n";
+  for (int i = 0; i < numBodies; i++)
+  {
+    out << "    Eigen::Matrix6s I" << i << " = *b.b" << i << ".G;\n";
+  }
+  for (int i = numBodies - 1; i >= 0; i--)
+  {
+    if (bodies[i].parent >= 0)
+    {
+      out << "    I" << bodies[i].parent << " += moveInertiaToParent(b.b" << i
+          << ", I" << i << ");\n";
+    }
+  }
+  out << "\n";
+  for (int i = 0; i < numBodies; i++)
+  {
+    const int n = bodies[i].numDofs;
+    if (n == 0)
+      continue;
+    out << "    {\n";
+    out << "      Eigen::Matrix<s_t, 6, " << n << "> F = I" << i << " * b.b"
+        << i << ".S;\n";
+    out << "      M.block<" << n << ", " << n << ">(" << bodies[i].dofOffset
+        << ", " << bodies[i].dofOffset << ").noalias() = b.b" << i
+        << ".S.transpose() * F;\n";
+    for (int c = i, a = bodies[i].parent; a >= 0; c = a, a = bodies[a].parent)
+    {
+      out << "      moveForcesToParent(b.b" << c << ", F);\n";
+      if (bodies[a].numDofs > 0)
+      {
+        out << "      M.block<" << bodies[a].numDofs << ", " << n << ">("
+            << bodies[a].dofOffset << ", " << bodies[i].dofOffset
+            << ").noalias() = b.b" << a << ".S.transpose() * F;\n";
+      }
+    }
+    out << "    }\n";
+  }
+  out << "    M.triangularView<Eigen::StrictlyLower>() = M.transpose();\n";
+  out << "  }\n\n";
+
+  // computeCoriolisAndGravityForces()
+  out << "  void computeCoriolisAndGravityForces(\n"
+      << "      const Skeleton* skel, Eigen::VectorXs& Cg) const override\n"
+      << "  {\n";
+  out << "    Bodies b;\n";
+  out << "    load(skel, b, true, nullptr);\n";
+  out << "    rnea(b, skel->getGravity(), Cg);\n";
+  out << "  }\n\n";
+
+  // computeInverseDynamics()
+  out << "  void computeInverseDynamics(\n"
+      << "      const Skeleton* skel,\n"
+      << "      const Eigen::VectorXs& ddq,\n"
+      << "      Eigen::VectorXs& tau) const override\n"
+      << "  {\n";
+  out << "    Bodies b;\n";
+  out << "    load(skel, b, true, &ddq);\n";
+  out << "    rnea(b, skel->getGravity(), tau);\n";
+  out << "  }\n\n";
+
+  // computeJacobianOfID()
+  out << "  void computeJacobianOfID(\n"
+      << "      const Skeleton* skel,\n"
+      << "      const Eigen::VectorXs& ddq,\n"
+      << "      bool withBiasForces,\n"
+      << "      bool wrtVelocity,\n"
+      << "      Eigen::MatrixXs& J) const override\n"
+      << "  {\n";
+  out << "    J.setZero();\n";
+  out << "    // M * ddq doesn't depend on the velocities\n";
+  out << "    if (wrtVelocity && !withBiasForces)\n";
+  out << "      return;\n";
+  out << "    Bodies b;\n";
+  out << "    load(skel, b, withBiasForces, &ddq);\n";
+  out << "    Eigen::VectorXs tau(J.rows());\n";
+  out << "    rnea(\n"
+      << "        b,\n"
+      << "        withBiasForces ? skel->getGravity() : "
+         "Eigen::Vector3s::Zero().eval(),\n"
+      << "        tau);\n";
+  out << "    if (wrtVelocity)\n";
+  out << "      tangentsWrtVelocities(b, J);\n";
+  out << "    else\n";
+  out << "      tangentsWrtPositions(b, J);\n";
+  out << "  }\n\n";
+
+  out << "private:\n";
+
+  // Bodies
+  out << "  struct Bodies\n  {\n";
+  for (int i = 0; i < numBodies; i++)
+  {
+    out << "    // " << sanitizeComment(bodies[i].name) << ", a "
+        << bodies[i].jointType << "\n";
+    out << "    Body<" << bodies[i].numDofs << "> b" << i << ";\n";
+  }
+  out << "\n    EIGEN_MAKE_ALIGNED_OPERATOR_NEW\n";
+  out << "  };\n\n";
+
+  // load()
+  out << "  static void load(\n"
+      << "      const Skeleton* skel,\n"
+      << "      Bodies& b,\n"
+      << "      bool withVelocity,\n"
+      << "      const Eigen::VectorXs* ddq)\n"
+      << "  {\n";
+  bool usesVelocity = false;
+  bool usesDdq = false;
+  for (int i = 0; i < numBodies; i++)
+  {
+    if (bodies[i].kind == JointDispatchTable::JointKind::ZERO_DOF)
+    {
+      out << "    loadWeldBody(skel, " << i << ", b.b" << i << ");\n";
+    }
+    else
+    {
+      usesVelocity = true;
+      usesDdq = true;
+      out << "    loadBody<" << getConfigSpaceName(bodies[i].kind)
+          << ">(\n        skel, " << i << ", " << bodies[i].dofOffset
+          << ", withVelocity, ddq, b.b" << i << ");\n";
+    }
+  }
+  if (!usesVelocity)
+    out << "    (void)withVelocity;\n";
+  if (!usesDdq)
+    out << "    (void)ddq;\n";
+  out << "  }\n\n";
+
+  // rnea()
+  out << "  static void rnea(\n"
+      << "      Bodies& b, const Eigen::Vector3s& gravity, Eigen::VectorXs& "
+         "tau)\n"
+      << "  {\n";
+  for (int i = 0; i < numBodies; i++)
+  {
+    if (bodies[i].parent < 0)
+      out << "    forwardRoot(b.b" << i << ", gravity);\n";
+    else
+      out << "    forward(b.b" << i << ", b.b" << bodies[i].parent << ");\n";
+  }
+  for (int i = numBodies - 1; i >= 0; i--)
+  {
+    if (bodies[i].numDofs > 0)
+    {
+      out << "    project(b.b" << i << ", " << bodies[i].dofOffset
+          << ", tau);\n";
+    }
+    if (bodies[i].parent >= 0)
+    {
+      out << "    backward(b.b" << i << ", b.b" << bodies[i].parent << ");\n";
+    }
+  }
+  out << "  }\n\n";
+
+  // The tangents. These need rnea() to have run first, since they use the
+  // velocities and the transmitted forces.
+  out << "  static void tangentsWrtPositions(Bodies& b, Eigen::MatrixXs& J)\n"
+      << "  {\n";
+  writeTangents(out, bodies, subtrees, false);
+  out << "  }\n\n";
+  out << "  static void tangentsWrtVelocities(Bodies& b, Eigen::MatrixXs& J)\n"
+      << "  {\n";
+  writeTangents(out, bodies, subtrees, true);
+  out << "  }\n";
+
+  out << "};\n\n";
+
+  // Registration
+  out << "struct " << className << "Registrar\n{\n";
+  out << "  " << className << "Registrar()\n  {\n";
+  out << "    dart::dynamics::CompiledSkeletonDynamics::registerDynamics(\n"
+      << "        std::make_shared<" << className << ">());\n";
+  out << "  }\n";
+  out << "} register" << className << ";\n\n";
+  out << "} // namespace\n";
+
+  return out.str();
+}
+
+//==============================================================================
+/// This makes `dynamics` available to every Skeleton with a matching
+/// signature. A later registration for the same signature replaces an
+/// earlier one. This always returns true, so generated files can call it
+/// from a static initializer.
+bool CompiledSkeletonDynamics::registerDynamics(
+    std::shared_ptr<CompiledSkeletonDynamics> dynamics)
+{
+  std::lock_guard<std::mutex> lock(gRegistryMutex);
+  getRegistry()[dynamics->getSignature()] = dynamics;
+  gRegistryVersion++;
+  return true;
+}
+
+//==============================================================================
+/// This removes every registered CompiledSkeletonDynamics
+void CompiledSkeletonDynamics::clearRegistry()
+{
+  std::lock_guard<std::mutex> lock(gRegistryMutex);
+  getRegistry().clear();
+  gRegistryVersion++;
+}
+
+//==============================================================================
+/// This returns the registered CompiledSkeletonDynamics for `signature`,
+/// or nullptr if there isn't one
+std::shared_ptr<CompiledSkeletonDynamics> CompiledSkeletonDynamics::find(
+    const std::string& signature)
+{
+  std::lock_guard<std::mutex> lock(gRegistryMutex);
+  Registry& registry = getRegistry();
+  auto it = registry.find(signature);
+  if (it == registry.end())
+    return nullptr;
+  return it->second;
+}
+
+//==============================================================================
+/// This loads a shared library built from one or more generated files,
+/// which registers everything in it. The library stays loaded for the rest
+/// of the process. Returns false if the library couldn't be loaded.
+bool CompiledSkeletonDynamics::loadPlugin(const std::string& path)
+{
+  // The generated files register themselves from static initializers, which
+  // run while the library is being loaded
+  std::shared_ptr<common::SharedLibrary> library
+      = common::SharedLibrary::create(path);
+  if (!library || !library->isValid())
+  {
+    dterr << "[CompiledSkeletonDynamics::loadPlugin] Failed to load \""
+          << path << "\".\n";
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(gRegistryMutex);
+  getPlugins().push_back(library);
+  return true;
+}
+
+//==============================================================================
+/// This goes up by one every time the registry changes, so Skeletons know
+/// when to look themselves up again
+std::size_t CompiledSkeletonDynamics::getRegistryVersion()
+{
+  return gRegistryVersion.load();
+}
+
+} // namespace dynamics
+} // namespace dart
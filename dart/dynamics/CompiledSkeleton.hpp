@@ -0,0 +1,110 @@
+#ifndef DART_DYNAMICS_COMPILEDSKELETON_HPP_
+#define DART_DYNAMICS_COMPILEDSKELETON_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class Skeleton;
+
+/// This is the dynamics of one fixed Skeleton topology, compiled ahead of
+/// time. generateSource() writes out a subclass of this for a given Skeleton,
+/// with the recursions over the bodies unrolled, every joint's Jacobian held
+/// in a fixed-size matrix, and every joint call made non-virtually. The
+/// parameters (joint transforms, axes, inertias, scales) are still read off
+/// of the Skeleton on every call, so the generated code stays valid when a
+/// model gets rescaled or has its masses changed. Only the tree and the joint
+/// types are baked in.
+///
+/// The generated file registers itself when it's loaded, so it can either be
+/// compiled straight into an executable, or built as a shared library and
+/// loaded at runtime with loadPlugin(). After that, any Skeleton whose
+/// getSignature() matches uses it for its mass matrix, Coriolis and gravity
+/// forces, and the Jacobians of those with respect to position and velocity.
+/// Everything built on top of those (the Jacobians of the inverse and forward
+/// dynamics, and of M^{-1}) picks up the speedup too.
+class CompiledSkeletonDynamics
+{
+public:
+  virtual ~CompiledSkeletonDynamics();
+
+  /// This returns the signature of the topology this was generated for
+  virtual std::string getSignature() const = 0;
+
+  /// This computes the mass matrix of `skel` into `M`, which must already be
+  /// the right size
+  virtual void computeMassMatrix(
+      const Skeleton* skel, Eigen::MatrixXs& M) const = 0;
+
+  /// This computes the Coriolis and gravity forces of `skel` into `Cg`, which
+  /// must already be the right size
+  virtual void computeCoriolisAndGravityForces(
+      const Skeleton* skel, Eigen::VectorXs& Cg) const = 0;
+
+  /// This computes M * ddq + Cg for `skel` into `tau`, which must already be
+  /// the right size
+  virtual void computeInverseDynamics(
+      const Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      Eigen::VectorXs& tau) const = 0;
+
+  /// This computes the Jacobian of M * ddq (plus Cg, if `withBiasForces`)
+  /// with respect to the positions of `skel`, or the velocities if
+  /// `wrtVelocity`. `J` must already be the right size.
+  virtual void computeJacobianOfID(
+      const Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      bool withBiasForces,
+      bool wrtVelocity,
+      Eigen::MatrixXs& J) const = 0;
+
+  /// This returns a string that identifies the topology and joint types of
+  /// `skel`. Two Skeletons with the same signature can share generated code.
+  /// This returns an empty string if `skel` has anything that generated code
+  /// can't handle, like SoftBodyNodes or joints on unusual configuration
+  /// spaces.
+  static std::string getSignature(const Skeleton* skel);
+
+  /// This writes out a C++ source file with a subclass of
+  /// CompiledSkeletonDynamics called `className`, specialized to `skel`. The
+  /// file registers its class when it's loaded. This returns an empty string
+  /// if getSignature() can't handle `skel`.
+  static std::string generateSource(
+      const Skeleton* skel, const std::string& className);
+
+  /// This makes `dynamics` available to every Skeleton with a matching
+  /// signature. A later registration for the same signature replaces an
+  /// earlier one. This always returns true, so generated files can call it
+  /// from a static initializer.
+  static bool registerDynamics(
+      std::shared_ptr<CompiledSkeletonDynamics> dynamics);
+
+  /// This removes every registered CompiledSkeletonDynamics
+  static void clearRegistry();
+
+  /// This returns the registered CompiledSkeletonDynamics for `signature`,
+  /// or nullptr if there isn't one
+  static std::shared_ptr<CompiledSkeletonDynamics> find(
+      const std::string& signature);
+
+  /// This loads a shared library built from one or more generated files,
+  /// which registers everything in it. The library stays loaded for the rest
+  /// of the process. Returns false if the library couldn't be loaded.
+  static bool loadPlugin(const std::string& path);
+
+  /// This goes up by one every time the registry changes, so Skeletons know
+  /// when to look themselves up again
+  static std::size_t getRegistryVersion();
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
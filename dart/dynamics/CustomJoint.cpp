@@ -31,6 +31,7 @@ CustomJoint<Dimension>::CustomJoint(
     mFunctions.push_back(std::make_shared<math::ConstantFunction>(0));
     mFunctionDrivenByDof.push_back(0);
   }
+  mPackedFunctions.pack(mFunctions);
 }
 
 //==============================================================================
@@ -43,6 +44,7 @@ void CustomJoint<Dimension>::setCustomFunction(
   assert(fn.get() != nullptr);
   mFunctions[i] = fn;
   mFunctionDrivenByDof[i] = drivenByDof;
+  mPackedFunctions.pack(mFunctions);
   this->notifyPositionUpdated();
 }
 
@@ -136,7 +138,7 @@ math::Jacobian CustomJoint<Dimension>::getCustomFunctionGradientAt(
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = mFunctionDrivenByDof[i];
-    df(i, drivenByDof) = mFunctions[i]->calcDerivative(1, x(drivenByDof));
+    df(i, drivenByDof) = evalCustomFunction(i, x)(1);
   }
   return df;
 }
@@ -151,8 +153,7 @@ math::Jacobian CustomJoint<Dimension>::getCustomFunctionGradientAtTimeDeriv(
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = mFunctionDrivenByDof[i];
-    dfdt(i, drivenByDof)
-        = mFunctions[i]->calcDerivative(2, x(drivenByDof)) * dx(drivenByDof);
+    dfdt(i, drivenByDof) = evalCustomFunction(i, x)(2) * dx(drivenByDof);
   }
   return dfdt;
 }
@@ -220,10 +221,8 @@ CustomJoint<Dimension>::getCustomFunctionGradientAtTimeDerivPosDeriv(
     int drivenByDof = mFunctionDrivenByDof[i];
     if (drivenByDof == index)
     {
-      dfdt(i, drivenByDof)
-          = mFunctions[i]->calcDerivative(2, x(drivenByDof)) * ddx(drivenByDof)
-            + mFunctions[i]->calcDerivative(3, x(drivenByDof))
-                  * dx(drivenByDof);
+      Eigen::Vector4s f = evalCustomFunction(i, x);
+      dfdt(i, drivenByDof) = f(2) * ddx(drivenByDof) + f(3) * dx(drivenByDof);
     }
   }
   return dfdt;
@@ -324,7 +323,7 @@ math::Jacobian CustomJoint<Dimension>::getCustomFunctionSecondGradientAt(
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = mFunctionDrivenByDof[i];
-    ddf(i, drivenByDof) = mFunctions[i]->calcDerivative(2, x(drivenByDof));
+    ddf(i, drivenByDof) = evalCustomFunction(i, x)(2);
   }
   return ddf;
 }
@@ -339,7 +338,7 @@ Eigen::Vector6s CustomJoint<Dimension>::getCustomFunctionPositions(
   Eigen::Vector6s pos = Eigen::Vector6s::Zero();
   for (int i = 0; i < 6; i++)
   {
-    pos(i) = mFunctions[i]->calcValue(x(mFunctionDrivenByDof[i]));
+    pos(i) = evalCustomFunction(i, x)(0);
   }
   return pos;
 }
@@ -352,11 +351,10 @@ Eigen::Vector6s CustomJoint<Dimension>::getCustomFunctionVelocities(
     const Eigen::VectorXs& x, const Eigen::VectorXs& dx) const
 {
   Eigen::Vector6s vel = Eigen::Vector6s::Zero();
-  math::Jacobian fnGrad = getCustomFunctionGradientAt(x);
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = this->mFunctionDrivenByDof[i];
-    vel(i) = fnGrad(i, drivenByDof) * dx(drivenByDof);
+    vel(i) = evalCustomFunction(i, x)(1) * dx(drivenByDof);
   }
   return vel;
 }
@@ -370,15 +368,13 @@ Eigen::Vector6s CustomJoint<Dimension>::getCustomFunctionAccelerations(
     const Eigen::VectorXs& dx,
     const Eigen::VectorXs& ddx) const
 {
-  math::Jacobian ddf = getCustomFunctionGradientAt(x);
   Eigen::Vector6s acc;
 
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = this->mFunctionDrivenByDof[i];
-    acc(i)
-        = ddf(i, drivenByDof) * ddx(drivenByDof)
-          + mFunctions[i]->calcDerivative(2, x(drivenByDof)) * dx(drivenByDof);
+    Eigen::Vector4s f = evalCustomFunction(i, x);
+    acc(i) = f(1) * ddx(drivenByDof) + f(2) * dx(drivenByDof);
   }
 
   return acc;
@@ -392,12 +388,11 @@ math::Jacobian
 CustomJoint<Dimension>::getCustomFunctionVelocitiesDerivativeWrtPos(
     const Eigen::VectorXs& x, const Eigen::VectorXs& dx) const
 {
-  math::Jacobian fnGrad = getCustomFunctionSecondGradientAt(x);
   math::Jacobian jac = math::Jacobian::Zero(6, Dimension);
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = this->mFunctionDrivenByDof[i];
-    jac(i, drivenByDof) = fnGrad(i, drivenByDof) * dx(drivenByDof);
+    jac(i, drivenByDof) = evalCustomFunction(i, x)(2) * dx(drivenByDof);
   }
   return jac;
 }
@@ -437,16 +432,15 @@ CustomJoint<Dimension>::getCustomFunctionAccelerationsDerivativeWrtPos(
 {
   math::Jacobian jac = math::Jacobian::Zero(6, Dimension);
 
-  math::Jacobian ddf_dx = getCustomFunctionSecondGradientAt(x);
   for (int i = 0; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
+    Eigen::Vector4s f = evalCustomFunction(i, x);
 
-    jac(i, drivenBy)
-        = ddx(drivenBy) * ddf_dx(i, drivenBy)
-          // Most custom functions will have a 0 third derivative, but this is
-          // here just in case
-          + mFunctions[i]->calcDerivative(3, x(drivenBy)) * dx(drivenBy);
+    jac(i, drivenBy) = ddx(drivenBy) * f(2)
+                       // Most custom functions will have a 0 third
+                       // derivative, but this is here just in case
+                       + f(3) * dx(drivenBy);
   }
 
   return jac;
@@ -489,7 +483,7 @@ CustomJoint<Dimension>::getCustomFunctionAccelerationsDerivativeWrtVel(
   for (int i = 0; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    jac(i, drivenBy) = mFunctions[i]->calcDerivative(2, x(drivenBy));
+    jac(i, drivenBy) = evalCustomFunction(i, x)(2);
   }
   return jac;
 }
@@ -527,8 +521,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getEulerPositions(
   Eigen::Vector3s pos;
   for (int i = 0; i < 3; i++)
   {
-    int drivenBy = this->mFunctionDrivenByDof[i];
-    pos(i) = mFunctions[i]->calcValue(x(drivenBy));
+    pos(i) = evalCustomFunction(i, x)(0);
   }
   return pos;
 }
@@ -543,7 +536,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getEulerVelocities(
   for (int i = 0; i < 3; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    vel(i) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * dx(drivenBy);
+    vel(i) = evalCustomFunction(i, x)(1) * dx(drivenBy);
   }
   return vel;
 }
@@ -560,8 +553,8 @@ Eigen::Vector3s CustomJoint<Dimension>::getEulerAccelerations(
   for (int i = 0; i < 3; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    acc(i) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * ddx(drivenBy)
-             + mFunctions[i]->calcDerivative(2, x(drivenBy)) * dx(drivenBy);
+    Eigen::Vector4s f = evalCustomFunction(i, x);
+    acc(i) = f(1) * ddx(drivenBy) + f(2) * dx(drivenBy);
   }
   return acc;
 }
@@ -575,8 +568,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getTranslationPositions(
   Eigen::Vector3s pos;
   for (int i = 3; i < 6; i++)
   {
-    int drivenBy = this->mFunctionDrivenByDof[i];
-    pos(i - 3) = mFunctions[i]->calcValue(x(drivenBy));
+    pos(i - 3) = evalCustomFunction(i, x)(0);
   }
   return pos;
 }
@@ -591,7 +583,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getTranslationVelocities(
   for (int i = 3; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    vel(i - 3) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * dx(drivenBy);
+    vel(i - 3) = evalCustomFunction(i, x)(1) * dx(drivenBy);
   }
   return vel;
 }
@@ -608,12 +600,22 @@ Eigen::Vector3s CustomJoint<Dimension>::getTranslationAccelerations(
   for (int i = 3; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    acc(i - 3) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * ddx(drivenBy)
-                 + mFunctions[i]->calcDerivative(2, x(drivenBy)) * dx(drivenBy);
+    Eigen::Vector4s f = evalCustomFunction(i, x);
+    acc(i - 3) = f(1) * ddx(drivenBy) + f(2) * dx(drivenBy);
   }
   return acc;
 }
 
+//==============================================================================
+/// This evaluates custom function i at its driving dof in x, returning
+/// [value, first derivative, second derivative, third derivative]
+template <std::size_t Dimension>
+Eigen::Vector4s CustomJoint<Dimension>::evalCustomFunction(
+    std::size_t i, const Eigen::VectorXs& x) const
+{
+  return mPackedFunctions.evaluate(i, x(mFunctionDrivenByDof[i]));
+}
+
 //==============================================================================
 template <std::size_t Dimension>
 const std::string& CustomJoint<Dimension>::getType() const
@@ -681,6 +683,7 @@ dart::dynamics::Joint* CustomJoint<Dimension>::clone() const
       = new CustomJoint<Dimension>(this->getJointProperties());
   joint->mFunctions = mFunctions;
   joint->mFunctionDrivenByDof = mFunctionDrivenByDof;
+  joint->mPackedFunctions = mPackedFunctions;
   joint->copyTransformsFrom(this);
   joint->setFlipAxisMap(getFlipAxisMap());
   joint->setAxisOrder(getAxisOrder());
@@ -42,6 +42,7 @@
 #include "dart/math/ConfigurationSpace.hpp"
 #include "dart/math/CustomFunction.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/PackedCustomFunctions.hpp"
 #include "dart/math/SimmSpline.hpp"
 
 namespace dart {
@@ -297,6 +298,11 @@ public:
   Eigen::Vector6s scratchAnalytical();
 
 protected:
+  /// This evaluates custom function i at its driving dof in x, returning
+  /// [value, first derivative, second derivative, third derivative]
+  Eigen::Vector4s evalCustomFunction(
+      std::size_t i, const Eigen::VectorXs& x) const;
+
   dynamics::EulerJoint::AxisOrder mAxisOrder;
 
   /// This contains 1's and -1's to indicate whether we should flip a given
@@ -308,6 +314,10 @@ protected:
 
   // Each function is driven by a single degree of freedom
   std::vector<int> mFunctionDrivenByDof;
+
+  // A packed copy of mFunctions, which is what we actually evaluate. This gets
+  // rebuilt whenever mFunctions changes.
+  math::PackedCustomFunctions mPackedFunctions;
 };
 
 }; // namespace dynamics
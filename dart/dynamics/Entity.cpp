@@ -138,6 +138,7 @@ void Entity::notifyTransformUpdate()
 void Entity::dirtyTransform()
 {
   mNeedTransformUpdate = true;
+  ++mTransformVersion;
 
   // The actual transform hasn't updated yet. But when its getter is called,
   // the transformation will be updated automatically.
@@ -150,6 +151,12 @@ bool Entity::needsTransformUpdate() const
   return mNeedTransformUpdate;
 }
 
+//==============================================================================
+std::size_t Entity::getTransformVersion() const
+{
+  return mTransformVersion;
+}
+
 //==============================================================================
 void Entity::notifyVelocityUpdate()
 {
@@ -128,6 +128,11 @@ public:
   /// Returns true iff a transform update is needed for this Entity
   bool needsTransformUpdate() const;
 
+  /// Returns a counter that goes up whenever the transform of this Entity gets
+  /// dirtied after having been clean. If this hasn't changed since the last
+  /// time you read the transform, then the transform hasn't changed either.
+  std::size_t getTransformVersion() const;
+
   /// Notify the velocity update of this Entity that its parent Frame's velocity
   /// is needed
   DART_DEPRECATED(6.2)
@@ -178,6 +183,10 @@ protected:
   mutable bool mNeedTransformUpdate;
   // TODO(JS): Rename this to mIsTransformDirty in DART 7
 
+  /// See getTransformVersion(). Every override of dirtyTransform() must
+  /// increment this whenever it sets mNeedTransformUpdate.
+  std::size_t mTransformVersion = 0;
+
   /// Does this Entity need a Velocity update
   mutable bool mNeedVelocityUpdate;
   // TODO(JS): Rename this to mIsVelocityDirty in DART 7
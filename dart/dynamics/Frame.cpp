@@ -494,6 +494,7 @@ void Frame::dirtyTransform()
     return;
 
   mNeedTransformUpdate = true;
+  ++mTransformVersion;
 
   for (Entity* entity : mChildEntities)
     entity->dirtyTransform();
@@ -573,6 +573,8 @@ public:
   /// \}
 
 protected:
+  friend class JointDispatchTable;
+
   GenericJoint(const Properties& properties);
 
   // Documentation inherited
@@ -206,6 +206,50 @@ const Eigen::Matrix6s& Inertia::getSpatialTensor() const
   return mSpatialTensor;
 }
 
+//==============================================================================
+Eigen::Matrix6s Inertia::getSpatialTensorGradient(Param _param) const
+{
+  Eigen::Matrix6s grad = Eigen::Matrix6s::Zero();
+  Eigen::Matrix3s C = math::makeSkewSymmetric(mCenterOfMass);
+
+  if (_param == MASS)
+  {
+    grad.block<3, 3>(0, 0) = C * C.transpose();
+    grad.block<3, 3>(3, 0) = C.transpose();
+    grad.block<3, 3>(0, 3) = C;
+    grad.block<3, 3>(3, 3) = Eigen::Matrix3s::Identity();
+  }
+  else if (_param <= COM_Z)
+  {
+    Eigen::Matrix3s dC
+        = math::makeSkewSymmetric(Eigen::Vector3s::Unit(_param - COM_X));
+    grad.block<3, 3>(0, 0)
+        = mMass * (dC * C.transpose() + C * dC.transpose());
+    grad.block<3, 3>(3, 0) = mMass * dC.transpose();
+    grad.block<3, 3>(0, 3) = mMass * dC;
+  }
+  else if (_param <= I_ZZ)
+  {
+    grad(_param - I_XX, _param - I_XX) = 1.0;
+  }
+  else if (_param <= I_YZ)
+  {
+    // I_XY, I_XZ, I_YZ each appear twice in the symmetric moment
+    int row = (_param == I_YZ) ? 1 : 0;
+    int col = (_param == I_XY) ? 1 : 2;
+    grad(row, col) = 1.0;
+    grad(col, row) = 1.0;
+  }
+  else
+  {
+    dtwarn << "[Inertia::getSpatialTensorGradient] Requested Param #"
+           << _param << ", but inertial parameters only go up to " << I_YZ
+           << ". Returning 0\n";
+  }
+
+  return grad;
+}
+
 //==============================================================================
 bool Inertia::verifyMoment(
     const Eigen::Matrix3s& _moment, bool _printWarnings, s_t _tolerance)
@@ -119,6 +119,11 @@ public:
   /// Get the spatial inertia tensor
   const Eigen::Matrix6s& getSpatialTensor() const;
 
+  /// Get the derivative of the spatial inertia tensor with respect to one of
+  /// the inertial parameters, holding the others fixed. The tensor is linear
+  /// in the mass and the moment, and quadratic in the center of mass.
+  Eigen::Matrix6s getSpatialTensorGradient(Param _param) const;
+
   /// Returns true iff _moment is a physically valid moment of inertia
   static bool verifyMoment(
       const Eigen::Matrix3s& _moment,
@@ -874,7 +874,7 @@ void Joint::notifyPositionUpdated()
   if (skel)
   {
     std::size_t tree = mChildBodyNode->mTreeIndex;
-    skel->dirtyArticulatedInertia(tree);
+    skel->dirtyArticulatedInertiaForPositions(mChildBodyNode);
     skel->mTreeCache[tree].mDirty.mExternalForces = true;
     skel->mSkelCache.mDirty.mExternalForces = true;
   }
@@ -41,6 +41,7 @@
 #include "dart/common/EmbeddedAspect.hpp"
 #include "dart/common/Subject.hpp"
 #include "dart/common/VersionCounter.hpp"
+#include "dart/dynamics/SkeletonArena.hpp"
 #include "dart/dynamics/SmartPointer.hpp"
 #include "dart/dynamics/detail/JointAspect.hpp"
 #include "dart/math/MathTypes.hpp"
@@ -913,6 +914,7 @@ public:
   friend class BodyNode;
   friend class SoftBodyNode;
   friend class Skeleton;
+  friend class JointDispatchTable;
 
 protected:
   /// Constructor called by inheriting class
@@ -1228,7 +1230,7 @@ protected:
 
 public:
   // To get byte-aligned Eigen vectors
-  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  DART_SKELETON_ARENA_OPERATOR_NEW
 };
 
 } // namespace dynamics
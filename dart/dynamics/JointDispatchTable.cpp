@@ -0,0 +1,523 @@
+#include "dart/dynamics/JointDispatchTable.hpp"
+
+#include <algorithm>
+#include <future>
+#include <unordered_map>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/GenericJoint.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/ZeroDofJoint.hpp"
+#include "dart/math/ConfigurationSpace.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+template <typename JointType>
+struct JointTag
+{
+  using Type = JointType;
+};
+
+} // namespace
+
+//==============================================================================
+void JointDispatchTable::invalidate()
+{
+  mBuilt = false;
+}
+
+//==============================================================================
+template <typename Visitor>
+void JointDispatchTable::visitConcrete(JointKind kind, Visitor&& visitor)
+{
+  switch (kind)
+  {
+    case JointKind::ZERO_DOF:
+      visitor(JointTag<ZeroDofJoint>());
+      break;
+    case JointKind::R1:
+      visitor(JointTag<GenericJoint<math::R1Space>>());
+      break;
+    case JointKind::R2:
+      visitor(JointTag<GenericJoint<math::R2Space>>());
+      break;
+    case JointKind::R3:
+      visitor(JointTag<GenericJoint<math::R3Space>>());
+      break;
+    case JointKind::R6:
+      visitor(JointTag<GenericJoint<math::R6Space>>());
+      break;
+    case JointKind::SO3:
+      visitor(JointTag<GenericJoint<math::SO3Space>>());
+      break;
+    case JointKind::SE3:
+      visitor(JointTag<GenericJoint<math::SE3Space>>());
+      break;
+    case JointKind::VIRTUAL:
+      assert(false && "visitConcrete() can't be called with VIRTUAL");
+      break;
+  }
+}
+
+//==============================================================================
+JointDispatchTable::JointKind JointDispatchTable::getJointKind(
+    const Joint* joint)
+{
+  if (dynamic_cast<const ZeroDofJoint*>(joint))
+    return JointKind::ZERO_DOF;
+  if (dynamic_cast<const GenericJoint<math::R1Space>*>(joint))
+    return JointKind::R1;
+  if (dynamic_cast<const GenericJoint<math::R2Space>*>(joint))
+    return JointKind::R2;
+  if (dynamic_cast<const GenericJoint<math::R3Space>*>(joint))
+    return JointKind::R3;
+  if (dynamic_cast<const GenericJoint<math::R6Space>*>(joint))
+    return JointKind::R6;
+  if (dynamic_cast<const GenericJoint<math::SO3Space>*>(joint))
+    return JointKind::SO3;
+  if (dynamic_cast<const GenericJoint<math::SE3Space>*>(joint))
+    return JointKind::SE3;
+  return JointKind::VIRTUAL;
+}
+
+//==============================================================================
+void JointDispatchTable::ensureBuilt(const std::vector<BodyNode*>& bodyNodes)
+{
+  if (mBuilt)
+    return;
+
+  // Work out the depth of each body. Parents always come before their
+  // children, so one pass is enough.
+  std::unordered_map<const BodyNode*, int> depths;
+  std::vector<int> bodyDepths;
+  bodyDepths.reserve(bodyNodes.size());
+  int numLevels = 0;
+  for (BodyNode* body : bodyNodes)
+  {
+    int depth = 0;
+    auto parent = depths.find(body->getParentBodyNode());
+    if (parent != depths.end())
+      depth = parent->second + 1;
+    depths[body] = depth;
+    bodyDepths.push_back(depth);
+    numLevels = std::max(numLevels, depth + 1);
+  }
+
+  std::vector<JointKind> kinds;
+  kinds.reserve(bodyNodes.size());
+  for (BodyNode* body : bodyNodes)
+  {
+    if (body->asSoftBodyNode() != nullptr)
+      kinds.push_back(JointKind::VIRTUAL);
+    else
+      kinds.push_back(getJointKind(body->getParentJoint()));
+  }
+
+  // Sort by level, then by kind. The sort is stable so the schedule doesn't
+  // depend on the sort implementation.
+  std::vector<std::size_t> order(bodyNodes.size());
+  for (std::size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::stable_sort(
+      order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        if (bodyDepths[a] != bodyDepths[b])
+          return bodyDepths[a] < bodyDepths[b];
+        return kinds[a] < kinds[b];
+      });
+
+  mBodies.clear();
+  mBodyKinds.clear();
+  mChildStarts.clear();
+  mChildren.clear();
+  mChildKinds.clear();
+  mBatches.clear();
+  mLevelStarts.clear();
+  mLevelParallel.clear();
+
+  int level = -1;
+  for (std::size_t i : order)
+  {
+    BodyNode* body = bodyNodes[i];
+    std::size_t index = mBodies.size();
+
+    while (level < bodyDepths[i])
+    {
+      level++;
+      mLevelStarts.push_back(mBatches.size());
+    }
+    if (mBatches.size() == mLevelStarts.back()
+        || mBatches.back().kind != kinds[i])
+    {
+      mBatches.push_back(Batch{kinds[i], index, index});
+    }
+    mBatches.back().end = index + 1;
+
+    mBodies.push_back(body);
+    mBodyKinds.push_back(kinds[i]);
+    mChildStarts.push_back(mChildren.size());
+    for (std::size_t j = 0; j < body->getNumChildBodyNodes(); j++)
+    {
+      BodyNode* child = body->getChildBodyNode(j);
+      mChildren.push_back(child);
+      mChildKinds.push_back(getJointKind(child->getParentJoint()));
+    }
+  }
+  mChildStarts.push_back(mChildren.size());
+  mLevelStarts.push_back(mBatches.size());
+  assert(mLevelStarts.size() == static_cast<std::size_t>(numLevels) + 1);
+
+  mLevelParallel.assign(numLevels, false);
+  for (int l = 0; l < numLevels; l++)
+  {
+    const Batch& first = mBatches[mLevelStarts[l]];
+    const Batch& last = mBatches[mLevelStarts[l + 1] - 1];
+    bool anyVirtual = false;
+    for (std::size_t b = mLevelStarts[l]; b < mLevelStarts[l + 1]; b++)
+      anyVirtual |= mBatches[b].kind == JointKind::VIRTUAL;
+    mLevelParallel[l]
+        = !anyVirtual && last.end - first.begin >= PARALLEL_MIN_LEVEL_WIDTH;
+  }
+
+  mBuilt = true;
+}
+
+//==============================================================================
+void JointDispatchTable::addChildArtInertia(
+    JointKind kind, const BodyNode* child, const BodyNode* parent)
+{
+  if (kind == JointKind::VIRTUAL)
+  {
+    child->mParentJoint->addChildArtInertiaTo(
+        parent->mArtInertia, child->mArtInertia);
+    child->mParentJoint->addChildArtInertiaImplicitTo(
+        parent->mArtInertiaImplicit, child->mArtInertiaImplicit);
+    return;
+  }
+
+  visitConcrete(kind, [&](auto tag) {
+    using JointType = typename decltype(tag)::Type;
+    JointType* joint = static_cast<JointType*>(child->mParentJoint);
+    joint->JointType::addChildArtInertiaTo(
+        parent->mArtInertia, child->mArtInertia);
+    joint->JointType::addChildArtInertiaImplicitTo(
+        parent->mArtInertiaImplicit, child->mArtInertiaImplicit);
+  });
+}
+
+//==============================================================================
+void JointDispatchTable::addChildBiasForce(
+    JointKind kind, const BodyNode* child, BodyNode* parent)
+{
+  if (kind == JointKind::VIRTUAL)
+  {
+    child->mParentJoint->addChildBiasForceTo(
+        parent->mBiasForce,
+        child->getArticulatedInertia(),
+        child->mBiasForce,
+        child->getPartialAcceleration());
+    return;
+  }
+
+  visitConcrete(kind, [&](auto tag) {
+    using JointType = typename decltype(tag)::Type;
+    JointType* joint = static_cast<JointType*>(child->mParentJoint);
+    joint->JointType::addChildBiasForceTo(
+        parent->mBiasForce,
+        child->getArticulatedInertia(),
+        child->mBiasForce,
+        child->getPartialAcceleration());
+  });
+}
+
+//==============================================================================
+bool JointDispatchTable::willRunParallel(bool parallel) const
+{
+  if (!parallel)
+    return false;
+  // Check this first, so narrow skeletons never start up the global pool
+  if (std::find(mLevelParallel.begin(), mLevelParallel.end(), true)
+      == mLevelParallel.end())
+    return false;
+  return common::ThreadPool::getGlobal().getNumThreads() >= 2;
+}
+
+//==============================================================================
+void JointDispatchTable::prepareForParallel(
+    bool articulatedInertia, bool accelerations)
+{
+  // mBodies is in level order, so each body's parent is already up to date
+  // by the time we get to it
+  for (BodyNode* body : mBodies)
+  {
+    body->getWorldTransform();
+    body->getSpatialVelocity();
+    body->getPartialAcceleration();
+    body->mParentJoint->getRelativeTransform();
+    body->mParentJoint->getRelativeJacobian();
+    if (articulatedInertia)
+      body->getArticulatedInertia();
+    if (accelerations)
+      body->getSpatialAcceleration();
+  }
+}
+
+//==============================================================================
+template <typename Function>
+void JointDispatchTable::forEachBatch(
+    std::size_t level, bool parallel, Function&& fn)
+{
+  const std::size_t firstBatch = mLevelStarts[level];
+  const std::size_t lastBatch = mLevelStarts[level + 1];
+
+  auto runRange = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t b = firstBatch; b < lastBatch; b++)
+    {
+      const Batch& batch = mBatches[b];
+      std::size_t batchBegin = std::max(batch.begin, begin);
+      std::size_t batchEnd = std::min(batch.end, end);
+      if (batchBegin < batchEnd)
+        fn(batch, batchBegin, batchEnd);
+    }
+  };
+
+  const std::size_t levelBegin = mBatches[firstBatch].begin;
+  const std::size_t levelEnd = mBatches[lastBatch - 1].end;
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  if (!parallel || !mLevelParallel[level] || pool.getNumThreads() < 2)
+  {
+    runRange(levelBegin, levelEnd);
+    return;
+  }
+
+  // Split the level into chunks of at least half the minimum width, one per
+  // thread at most, and run the first one on this thread
+  const std::size_t width = levelEnd - levelBegin;
+  const std::size_t numChunks = std::min(
+      pool.getNumThreads(), width / (PARALLEL_MIN_LEVEL_WIDTH / 2));
+  std::vector<std::future<void>> futures;
+  futures.reserve(numChunks - 1);
+  for (std::size_t k = 1; k < numChunks; k++)
+  {
+    std::size_t begin = levelBegin + width * k / numChunks;
+    std::size_t end = levelBegin + width * (k + 1) / numChunks;
+    futures.push_back(
+        pool.submit([&runRange, begin, end]() { runRange(begin, end); }));
+  }
+  runRange(levelBegin, levelBegin + width / numChunks);
+  pool.waitAll(futures);
+}
+
+//==============================================================================
+void JointDispatchTable::updateArtInertia(
+    const std::vector<BodyNode*>& bodyNodes, s_t timeStep, bool parallel)
+{
+  ensureBuilt(bodyNodes);
+
+  // The articulated inertia pass only reads the joints' own cached
+  // transforms and Jacobians
+  parallel = willRunParallel(parallel);
+  if (parallel)
+  {
+    for (BodyNode* body : mBodies)
+    {
+      body->mParentJoint->getRelativeTransform();
+      body->mParentJoint->getRelativeJacobian();
+    }
+  }
+
+  for (std::size_t level = mLevelStarts.size() - 1; level-- > 0;)
+  {
+    forEachBatch(
+        level,
+        parallel,
+        [&](const Batch& batch, std::size_t begin, std::size_t end) {
+          if (batch.kind == JointKind::VIRTUAL)
+          {
+            for (std::size_t i = begin; i < end; i++)
+              mBodies[i]->updateArtInertia(timeStep);
+            return;
+          }
+
+          // This mirrors BodyNode::updateArtInertia()
+          visitConcrete(batch.kind, [&](auto tag) {
+            using JointType = typename decltype(tag)::Type;
+            for (std::size_t i = begin; i < end; i++)
+            {
+              BodyNode* body = mBodies[i];
+              body->mArtInertia
+                  = body->mAspectProperties.mInertia.getSpatialTensor();
+              body->mArtInertiaImplicit = body->mArtInertia;
+
+              for (std::size_t c = mChildStarts[i]; c < mChildStarts[i + 1];
+                   c++)
+                addChildArtInertia(mChildKinds[c], mChildren[c], body);
+
+              assert(!math::isNan(body->mArtInertiaImplicit));
+
+              JointType* joint = static_cast<JointType*>(body->mParentJoint);
+              joint->JointType::updateInvProjArtInertia(body->mArtInertia);
+              joint->JointType::updateInvProjArtInertiaImplicit(
+                  body->mArtInertiaImplicit, timeStep);
+            }
+          });
+        });
+  }
+}
+
+//==============================================================================
+void JointDispatchTable::updateBiasForce(
+    const std::vector<BodyNode*>& bodyNodes,
+    const Eigen::Vector3s& gravity,
+    s_t timeStep,
+    bool parallel)
+{
+  ensureBuilt(bodyNodes);
+
+  parallel = willRunParallel(parallel);
+  if (parallel)
+    prepareForParallel(true, false);
+
+  for (std::size_t level = mLevelStarts.size() - 1; level-- > 0;)
+  {
+    forEachBatch(
+        level,
+        parallel,
+        [&](const Batch& batch, std::size_t begin, std::size_t end) {
+          if (batch.kind == JointKind::VIRTUAL)
+          {
+            for (std::size_t i = begin; i < end; i++)
+              mBodies[i]->updateBiasForce(gravity, timeStep);
+            return;
+          }
+
+          // This mirrors BodyNode::updateBiasForce()
+          visitConcrete(batch.kind, [&](auto tag) {
+            using JointType = typename decltype(tag)::Type;
+            for (std::size_t i = begin; i < end; i++)
+            {
+              BodyNode* body = mBodies[i];
+              const Eigen::Matrix6s& mI
+                  = body->mAspectProperties.mInertia.getSpatialTensor();
+              if (body->mAspectProperties.mGravityMode == true)
+                body->mFgravity.noalias()
+                    = mI
+                      * math::AdInvRLinear(body->getWorldTransform(), gravity);
+              else
+                body->mFgravity.setZero();
+
+              const Eigen::Vector6s& V = body->getSpatialVelocity();
+              body->mBiasForce = -math::dad(V, mI * V)
+                                 - body->mAspectState.mFext - body->mFgravity;
+
+              for (std::size_t c = mChildStarts[i]; c < mChildStarts[i + 1];
+                   c++)
+                addChildBiasForce(mChildKinds[c], mChildren[c], body);
+
+              assert(!math::isNan(body->mBiasForce));
+
+              JointType* joint = static_cast<JointType*>(body->mParentJoint);
+              joint->JointType::updateTotalForce(
+                  body->getArticulatedInertia() * body->getPartialAcceleration()
+                      + body->mBiasForce,
+                  timeStep);
+            }
+          });
+        });
+  }
+}
+
+//==============================================================================
+void JointDispatchTable::updateInverseDynamics(
+    const std::vector<BodyNode*>& bodyNodes,
+    const Eigen::Vector3s& gravity,
+    bool withExternalForces,
+    s_t timeStep,
+    bool withDampingForces,
+    bool withSpringForces,
+    bool parallel)
+{
+  ensureBuilt(bodyNodes);
+
+  parallel = willRunParallel(parallel);
+  if (parallel)
+    prepareForParallel(false, true);
+
+  for (std::size_t level = mLevelStarts.size() - 1; level-- > 0;)
+  {
+    forEachBatch(
+        level,
+        parallel,
+        [&](const Batch& batch, std::size_t begin, std::size_t end) {
+          if (batch.kind == JointKind::VIRTUAL)
+          {
+            for (std::size_t i = begin; i < end; i++)
+            {
+              mBodies[i]->updateTransmittedForceID(gravity, withExternalForces);
+              mBodies[i]->updateJointForceID(
+                  timeStep, withDampingForces, withSpringForces);
+            }
+            return;
+          }
+
+          visitConcrete(batch.kind, [&](auto tag) {
+            using JointType = typename decltype(tag)::Type;
+            for (std::size_t i = begin; i < end; i++)
+            {
+              BodyNode* body = mBodies[i];
+              body->BodyNode::updateTransmittedForceID(
+                  gravity, withExternalForces);
+              JointType* joint = static_cast<JointType*>(body->mParentJoint);
+              joint->JointType::updateForceID(
+                  body->mF, timeStep, withDampingForces, withSpringForces);
+            }
+          });
+        });
+  }
+}
+
+//==============================================================================
+void JointDispatchTable::updateCoriolisAndGravityForces(
+    const std::vector<BodyNode*>& bodyNodes,
+    Eigen::VectorXs& Cg,
+    const Eigen::Vector3s& gravity,
+    bool parallel)
+{
+  ensureBuilt(bodyNodes);
+
+  parallel = willRunParallel(parallel);
+  if (parallel)
+    prepareForParallel(false, false);
+
+  // Each body only reads its parent's combined vector on the way down, and
+  // only its children's on the way up, and writes its own slice of Cg
+  for (std::size_t level = 0; level + 1 < mLevelStarts.size(); level++)
+  {
+    forEachBatch(
+        level,
+        parallel,
+        [&](const Batch& /* batch */, std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; i++)
+            mBodies[i]->updateCombinedVector();
+        });
+  }
+
+  for (std::size_t level = mLevelStarts.size() - 1; level-- > 0;)
+  {
+    forEachBatch(
+        level,
+        parallel,
+        [&](const Batch& /* batch */, std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; i++)
+            mBodies[i]->aggregateCombinedVector(Cg, gravity);
+        });
+  }
+}
+
+} // namespace dynamics
+} // namespace dart
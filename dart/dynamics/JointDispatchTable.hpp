@@ -0,0 +1,180 @@
+#ifndef DART_DYNAMICS_JOINTDISPATCHTABLE_HPP_
+#define DART_DYNAMICS_JOINTDISPATCHTABLE_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class BodyNode;
+class Joint;
+
+/// This is a precompiled schedule for the recursive articulated body passes
+/// over a set of BodyNodes (one tree of a Skeleton, or the whole Skeleton).
+///
+/// BodyNode::updateArtInertia(), updateBiasForce() and updateJointForceID()
+/// each make several virtual calls into the parent Joint of every body (and of
+/// every child), even though the only classes that actually implement those
+/// functions are GenericJoint<ConfigSpace> and ZeroDofJoint. This groups the
+/// bodies by depth in the tree, and then within each level by which of those
+/// classes implements their parent joint. Each batch then runs with the joint
+/// type known at compile time, so the calls are non-virtual and can be inlined
+/// into a loop over bodies that all do the same fixed-size math.
+///
+/// Bodies in the same level never depend on each other, and every body still
+/// visits its children in order, so the results are bit-for-bit the same as
+/// the virtual passes. SoftBodyNodes, and joints on some other configuration
+/// space, just fall back to the virtual calls.
+///
+/// That independence also means that wide levels (lots of fingers, legs, or
+/// trees in one Skeleton) can be split over the global common::ThreadPool.
+/// Levels with at least PARALLEL_MIN_LEVEL_WIDTH bodies get split into chunks
+/// that run in parallel, with a barrier between levels. Before a parallel
+/// pass, the lazily computed transforms, velocities and so on that the pass
+/// reads are brought up to date in one sequential sweep, so the workers only
+/// ever write to their own bodies and joints.
+class JointDispatchTable
+{
+public:
+  /// Levels with fewer bodies than this never get split over threads, since
+  /// the overhead would outweigh the work
+  static constexpr std::size_t PARALLEL_MIN_LEVEL_WIDTH = 32;
+
+  /// The class that implements the articulated body functions of a joint
+  enum class JointKind : int
+  {
+    ZERO_DOF = 0,
+    R1 = 1,
+    R2 = 2,
+    R3 = 3,
+    R6 = 4,
+    SO3 = 5,
+    SE3 = 6,
+    /// Anything else goes through virtual calls
+    VIRTUAL = 7
+  };
+
+  /// This marks the table out of date, so it gets rebuilt on next use. This
+  /// needs to be called whenever bodies are added or removed.
+  void invalidate();
+
+  /// Same as calling BodyNode::updateArtInertia() on `bodyNodes` from the last
+  /// to the first. `bodyNodes` must list every parent before its children.
+  ///
+  /// If `parallel` is true, wide levels get split over threads.
+  void updateArtInertia(
+      const std::vector<BodyNode*>& bodyNodes, s_t timeStep, bool parallel);
+
+  /// Same as calling BodyNode::updateBiasForce() on `bodyNodes` from the last
+  /// to the first
+  void updateBiasForce(
+      const std::vector<BodyNode*>& bodyNodes,
+      const Eigen::Vector3s& gravity,
+      s_t timeStep,
+      bool parallel);
+
+  /// Same as calling BodyNode::updateTransmittedForceID() and then
+  /// BodyNode::updateJointForceID() on `bodyNodes` from the last to the first
+  void updateInverseDynamics(
+      const std::vector<BodyNode*>& bodyNodes,
+      const Eigen::Vector3s& gravity,
+      bool withExternalForces,
+      s_t timeStep,
+      bool withDampingForces,
+      bool withSpringForces,
+      bool parallel);
+
+  /// Same as calling BodyNode::updateCombinedVector() on `bodyNodes` from the
+  /// first to the last, and then BodyNode::aggregateCombinedVector() from the
+  /// last to the first
+  void updateCoriolisAndGravityForces(
+      const std::vector<BodyNode*>& bodyNodes,
+      Eigen::VectorXs& Cg,
+      const Eigen::Vector3s& gravity,
+      bool parallel);
+
+  /// Returns the class that implements the articulated body functions of
+  /// `joint`
+  static JointKind getJointKind(const Joint* joint);
+
+protected:
+  /// A run of bodies in the same level that share a JointKind
+  struct Batch
+  {
+    JointKind kind;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  /// This rebuilds the schedule from `bodyNodes`, if it's out of date
+  void ensureBuilt(const std::vector<BodyNode*>& bodyNodes);
+
+  /// Returns true if a pass with `parallel` set would split some level over
+  /// threads
+  bool willRunParallel(bool parallel) const;
+
+  /// This brings every lazily computed quantity that the passes read up to
+  /// date, from the root down, so that parallel workers never trigger a lazy
+  /// update of some other body's data. `articulatedInertia` and
+  /// `accelerations` also update the articulated inertias and spatial
+  /// accelerations, which only some passes need.
+  void prepareForParallel(bool articulatedInertia, bool accelerations);
+
+  /// This calls `fn(batch, begin, end)` for every batch in `level`, with
+  /// [begin, end) the part of the batch to process. If `parallel` is true and
+  /// the level is wide enough, the level gets split into chunks that run on
+  /// the global ThreadPool, and this returns once they're all done.
+  template <typename Function>
+  void forEachBatch(std::size_t level, bool parallel, Function&& fn);
+
+  /// This adds the articulated inertias of `child` to its parent
+  static void addChildArtInertia(
+      JointKind kind, const BodyNode* child, const BodyNode* parent);
+
+  /// This adds the bias force of `child` to its parent
+  static void addChildBiasForce(
+      JointKind kind, const BodyNode* child, BodyNode* parent);
+
+  /// This calls `visitor` with a JointTag of the class that implements `kind`,
+  /// which must not be VIRTUAL
+  template <typename Visitor>
+  static void visitConcrete(JointKind kind, Visitor&& visitor);
+
+  bool mBuilt = false;
+
+  /// The bodies, ordered by depth, and by JointKind within each depth
+  std::vector<BodyNode*> mBodies;
+
+  /// The JointKind each body in mBodies gets batched by. This is VIRTUAL for
+  /// SoftBodyNodes, which override the passes.
+  std::vector<JointKind> mBodyKinds;
+
+  /// The children of mBodies[i] are mChildren[mChildStarts[i]] up to
+  /// mChildren[mChildStarts[i + 1]], in the order the body lists them
+  std::vector<std::size_t> mChildStarts;
+  std::vector<BodyNode*> mChildren;
+
+  /// The JointKind of the parent joint of each of mChildren
+  std::vector<JointKind> mChildKinds;
+
+  /// The batches, level by level
+  std::vector<Batch> mBatches;
+
+  /// The batches of level i are mBatches[mLevelStarts[i]] up to
+  /// mBatches[mLevelStarts[i + 1]]
+  std::vector<std::size_t> mLevelStarts;
+
+  /// True for each level that's wide enough to split over threads, and has no
+  /// VIRTUAL batches (SoftBodyNodes touch too much shared state to be safe)
+  std::vector<bool> mLevelParallel;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
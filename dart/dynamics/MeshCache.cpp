@@ -0,0 +1,248 @@
+#include "dart/dynamics/MeshCache.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <assimp/cexport.h>
+#include <assimp/cimport.h>
+#include <unistd.h>
+
+#include "dart/dynamics/MeshShape.hpp"
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+/// This names a file by its contents: a 64 bit FNV-1a hash, plus the length
+/// to make collisions even less likely
+std::string hashContents(const std::string& contents)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (char c : contents)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  std::stringstream ss;
+  ss << std::hex << hash << "-" << std::dec << contents.size();
+  return ss.str();
+}
+
+} // namespace
+
+//==============================================================================
+MeshCache::MeshCache()
+  : mEnabled(true), mNumHits(0), mNumDiskHits(0), mNumImports(0)
+{
+}
+
+//==============================================================================
+/// This is the cache that MeshShape::loadMesh() uses
+MeshCache& MeshCache::getGlobal()
+{
+  static MeshCache cache;
+  return cache;
+}
+
+//==============================================================================
+/// This returns the mesh at `uri`, only importing it if we haven't already
+/// loaded it (or a file with the same contents). Returns nullptr if the mesh
+/// can't be loaded.
+std::shared_ptr<SharedMeshWrapper> MeshCache::load(
+    const std::string& uri, const common::ResourceRetrieverPtr& retriever)
+{
+  bool enabled;
+  std::string diskCacheDirectory;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    enabled = mEnabled;
+    if (enabled)
+    {
+      auto cached = mByUri.find(uri);
+      if (cached != mByUri.end())
+      {
+        mNumHits++;
+        return cached->second;
+      }
+    }
+    else
+    {
+      mNumImports++;
+    }
+    diskCacheDirectory = mDiskCacheDirectory;
+  }
+  if (!enabled)
+    return MeshShape::importMesh(uri, retriever);
+
+  // We don't hold the lock while reading or importing, since that's the slow
+  // part. If two threads race to load the same mesh, they'll both import it,
+  // but only the first one to finish gets stored.
+  common::ResourcePtr resource = retriever->retrieve(uri);
+  if (!resource)
+  {
+    // Let the importer report the failure
+    return MeshShape::importMesh(uri, retriever);
+  }
+  const std::string contentsKey = hashContents(resource->readAll());
+
+  std::shared_ptr<SharedMeshWrapper> mesh;
+  bool fromDisk = false;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto cached = mByContents.find(contentsKey);
+    if (cached != mByContents.end())
+    {
+      mNumHits++;
+      mByUri[uri] = cached->second;
+      return cached->second;
+    }
+  }
+
+  const std::string diskPath = diskCacheDirectory.empty()
+                                   ? ""
+                                   : diskCacheDirectory + "/" + contentsKey
+                                         + ".assbin";
+  if (!diskPath.empty())
+  {
+    mesh = loadFromDisk(diskPath);
+    fromDisk = (mesh != nullptr);
+  }
+  if (!mesh)
+  {
+    mesh = MeshShape::importMesh(uri, retriever);
+    if (!mesh)
+      return nullptr;
+    if (!diskPath.empty())
+      saveToDisk(*mesh, diskPath);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (fromDisk)
+    mNumDiskHits++;
+  else
+    mNumImports++;
+  auto inserted = mByContents.emplace(contentsKey, mesh);
+  mByUri[uri] = inserted.first->second;
+  return inserted.first->second;
+}
+
+//==============================================================================
+/// If this is false, load() always imports a fresh copy of the mesh. This
+/// defaults to true.
+void MeshCache::setEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mEnabled = enabled;
+}
+
+//==============================================================================
+/// Returns true if load() shares meshes
+bool MeshCache::isEnabled() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mEnabled;
+}
+
+//==============================================================================
+/// This sets a directory to store post-processed meshes in, which must
+/// already exist. Pass "" (the default) to only cache in memory.
+void MeshCache::setDiskCacheDirectory(const std::string& directory)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mDiskCacheDirectory = directory;
+}
+
+//==============================================================================
+/// Returns the on-disk cache directory, or "" if there isn't one
+std::string MeshCache::getDiskCacheDirectory() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mDiskCacheDirectory;
+}
+
+//==============================================================================
+/// This drops every mesh held in memory. MeshShapes that already use a mesh
+/// keep it alive. This doesn't touch the on-disk cache.
+void MeshCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mByUri.clear();
+  mByContents.clear();
+}
+
+//==============================================================================
+/// Returns the number of distinct meshes held in memory
+std::size_t MeshCache::getNumMeshes() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mByContents.size();
+}
+
+//==============================================================================
+/// Returns how many load() calls were answered from memory
+long MeshCache::getNumHits() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumHits;
+}
+
+//==============================================================================
+/// Returns how many load() calls were answered from the on-disk cache
+long MeshCache::getNumDiskHits() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumDiskHits;
+}
+
+//==============================================================================
+/// Returns how many load() calls had to import the mesh through Assimp
+long MeshCache::getNumImports() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumImports;
+}
+
+//==============================================================================
+/// This loads a post-processed mesh from the on-disk cache, or returns
+/// nullptr if it isn't there
+std::shared_ptr<SharedMeshWrapper> MeshCache::loadFromDisk(
+    const std::string& path)
+{
+  if (!std::ifstream(path).good())
+    return nullptr;
+  // The cached scene has already been through all of loadMesh()'s
+  // post-processing, so we import it exactly as it was written
+  const aiScene* scene = aiImportFile(path.c_str(), 0);
+  if (!scene)
+    return nullptr;
+  return std::make_shared<SharedMeshWrapper>(scene);
+}
+
+//==============================================================================
+/// This writes a post-processed mesh to the on-disk cache. Failures are
+/// ignored, since the cache is only an optimization.
+void MeshCache::saveToDisk(
+    const SharedMeshWrapper& mesh, const std::string& path)
+{
+  if (mesh.mesh == nullptr)
+    return;
+  // Write to a temporary file and then rename it into place, so that other
+  // processes sharing the cache never see a partly written file
+  const std::string tmpPath = path + ".tmp" + std::to_string(::getpid()) + "-"
+                              + std::to_string(
+                                  reinterpret_cast<std::uintptr_t>(&mesh));
+  if (aiExportScene(mesh.mesh, "assbin", tmpPath.c_str(), 0)
+      != aiReturn_SUCCESS)
+  {
+    std::remove(tmpPath.c_str());
+    return;
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    std::remove(tmpPath.c_str());
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,97 @@
+#ifndef DART_DYNAMICS_MESHCACHE_HPP_
+#define DART_DYNAMICS_MESHCACHE_HPP_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "dart/common/ResourceRetriever.hpp"
+
+namespace dart {
+namespace dynamics {
+
+struct SharedMeshWrapper;
+
+/// This is a process-wide cache of imported meshes, which MeshShape::loadMesh()
+/// goes through. Loading the same mesh for many skeletons (or many clones of a
+/// skeleton) only runs Assimp once, and every MeshShape then shares the one
+/// SharedMeshWrapper, along with its vertex buffers, convex hull, and bounding
+/// box. Meshes handed out by the cache are shared, so treat them as read-only.
+///
+/// Meshes are looked up first by resolved URI, and then by a hash of the file
+/// contents, so the same file reached through different URIs is still only
+/// imported once. MeshShape applies its scale at query time, so meshes with
+/// different scales share the same entry.
+///
+/// Optionally, the cache can also keep already post-processed meshes on disk
+/// (in Assimp's binary "assbin" format), named by content hash, so that new
+/// processes can skip Assimp's post-processing steps too.
+class MeshCache
+{
+public:
+  MeshCache();
+
+  /// This is the cache that MeshShape::loadMesh() uses
+  static MeshCache& getGlobal();
+
+  /// This returns the mesh at `uri`, only importing it if we haven't already
+  /// loaded it (or a file with the same contents). Returns nullptr if the mesh
+  /// can't be loaded.
+  std::shared_ptr<SharedMeshWrapper> load(
+      const std::string& uri, const common::ResourceRetrieverPtr& retriever);
+
+  /// If this is false, load() always imports a fresh copy of the mesh. This
+  /// defaults to true.
+  void setEnabled(bool enabled);
+
+  /// Returns true if load() shares meshes
+  bool isEnabled() const;
+
+  /// This sets a directory to store post-processed meshes in, which must
+  /// already exist. Pass "" (the default) to only cache in memory.
+  void setDiskCacheDirectory(const std::string& directory);
+
+  /// Returns the on-disk cache directory, or "" if there isn't one
+  std::string getDiskCacheDirectory() const;
+
+  /// This drops every mesh held in memory. MeshShapes that already use a mesh
+  /// keep it alive. This doesn't touch the on-disk cache.
+  void clear();
+
+  /// Returns the number of distinct meshes held in memory
+  std::size_t getNumMeshes() const;
+
+  /// Returns how many load() calls were answered from memory
+  long getNumHits() const;
+
+  /// Returns how many load() calls were answered from the on-disk cache
+  long getNumDiskHits() const;
+
+  /// Returns how many load() calls had to import the mesh through Assimp
+  long getNumImports() const;
+
+protected:
+  /// This loads a post-processed mesh from the on-disk cache, or returns
+  /// nullptr if it isn't there
+  std::shared_ptr<SharedMeshWrapper> loadFromDisk(const std::string& path);
+
+  /// This writes a post-processed mesh to the on-disk cache. Failures are
+  /// ignored, since the cache is only an optimization.
+  void saveToDisk(const SharedMeshWrapper& mesh, const std::string& path);
+
+  mutable std::mutex mMutex;
+  bool mEnabled;
+  std::string mDiskCacheDirectory;
+  std::unordered_map<std::string, std::shared_ptr<SharedMeshWrapper>> mByUri;
+  std::unordered_map<std::string, std::shared_ptr<SharedMeshWrapper>>
+      mByContents;
+  long mNumHits;
+  long mNumDiskHits;
+  long mNumImports;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
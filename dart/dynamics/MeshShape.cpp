@@ -48,6 +48,7 @@
 #include "dart/config.hpp"
 #include "dart/dynamics/AssimpInputResourceAdaptor.hpp"
 #include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/MeshCache.hpp"
 
 #if !(ASSIMP_AISCENE_CTOR_DTOR_DEFINED)
 // We define our own constructor and destructor for aiScene, because it seems to
@@ -160,6 +161,158 @@ SharedMeshWrapper::~SharedMeshWrapper()
   aiReleaseImport(mesh);
 }
 
+//==============================================================================
+/// This returns the convex hull of every vertex in the mesh, which collision
+/// detection uses for fast support queries. It's built the first time anyone
+/// asks, and then shared by every MeshShape (and clone) that uses this mesh.
+/// The hull also carries the mesh's surface connectivity (see
+/// math::SupportHull::getMeshAdjacency()).
+std::shared_ptr<const math::SupportHull> SharedMeshWrapper::getSupportHull()
+    const
+{
+  std::lock_guard<std::mutex> lock(mSupportHullMutex);
+  if (!mSupportHull && mesh != nullptr)
+  {
+    std::vector<Eigen::Vector3s> vertices;
+    std::vector<Eigen::Vector3i> triangles;
+    for (int s = 0; s < mesh->mNumMeshes; s++)
+    {
+      const aiMesh* m = mesh->mMeshes[s];
+      int offset = vertices.size();
+      for (int v = 0; v < m->mNumVertices; v++)
+      {
+        aiVector3D vec = m->mVertices[v];
+        vertices.emplace_back(vec.x, vec.y, vec.z);
+      }
+      for (int f = 0; f < m->mNumFaces; f++)
+      {
+        const aiFace& face = m->mFaces[f];
+        if (face.mNumIndices != 3)
+          continue;
+        triangles.emplace_back(
+            offset + face.mIndices[0],
+            offset + face.mIndices[1],
+            offset + face.mIndices[2]);
+      }
+    }
+    // Contact generation walks the mesh surface from the support point, so
+    // the surface connectivity rides along with the hull
+    std::shared_ptr<math::SupportHull> hull
+        = std::make_shared<math::SupportHull>(vertices);
+    hull->setMeshAdjacency(
+        std::make_shared<const math::MeshAdjacency>(vertices, triangles));
+    mSupportHull = hull;
+  }
+  return mSupportHull;
+}
+
+//==============================================================================
+/// This returns the axis-aligned bounding box of every vertex in the mesh,
+/// before any MeshShape scaling. Like the hull, it's computed once and then
+/// shared.
+math::BoundingBox SharedMeshWrapper::getBoundingBox() const
+{
+  std::lock_guard<std::mutex> lock(mSupportHullMutex);
+  if (!mHasBoundingBox && mesh != nullptr)
+  {
+    Eigen::Vector3s min
+        = Eigen::Vector3s::Constant(std::numeric_limits<s_t>::infinity());
+    Eigen::Vector3s max
+        = Eigen::Vector3s::Constant(-std::numeric_limits<s_t>::infinity());
+    for (unsigned int i = 0; i < mesh->mNumMeshes; i++)
+    {
+      const aiMesh* m = mesh->mMeshes[i];
+      for (unsigned int j = 0; j < m->mNumVertices; j++)
+      {
+        Eigen::Vector3s vertex(
+            m->mVertices[j].x, m->mVertices[j].y, m->mVertices[j].z);
+        min = min.cwiseMin(vertex);
+        max = max.cwiseMax(vertex);
+      }
+    }
+    mBoundingBox.setMin(min);
+    mBoundingBox.setMax(max);
+    mHasBoundingBox = true;
+  }
+  return mBoundingBox;
+}
+
+//==============================================================================
+/// This returns a k-d tree over every vertex in the mesh, before any MeshShape
+/// scaling, for nearest-vertex queries. Like the hull, it's built once and
+/// then shared.
+std::shared_ptr<const math::VertexKdTree> SharedMeshWrapper::getVertexKdTree()
+    const
+{
+  std::lock_guard<std::mutex> lock(mSupportHullMutex);
+  if (!mVertexKdTree && mesh != nullptr)
+  {
+    std::vector<Eigen::Vector3s> vertices;
+    for (int s = 0; s < mesh->mNumMeshes; s++)
+    {
+      const aiMesh* m = mesh->mMeshes[s];
+      for (int v = 0; v < m->mNumVertices; v++)
+      {
+        aiVector3D vec = m->mVertices[v];
+        vertices.emplace_back(vec.x, vec.y, vec.z);
+      }
+    }
+    mVertexKdTree = std::make_shared<const math::VertexKdTree>(vertices);
+  }
+  return mVertexKdTree;
+}
+
+//==============================================================================
+/// This returns a BVH over every triangle in the mesh, before any MeshShape
+/// scaling, for raycasts. Faces that aren't triangles are skipped. Like the
+/// hull, it's built once and then shared.
+std::shared_ptr<const math::TriangleBvh> SharedMeshWrapper::getTriangleBvh()
+    const
+{
+  std::lock_guard<std::mutex> lock(mSupportHullMutex);
+  if (!mTriangleBvh && mesh != nullptr)
+  {
+    std::vector<Eigen::Vector3s> vertices;
+    std::vector<Eigen::Vector3i> triangles;
+    for (int s = 0; s < mesh->mNumMeshes; s++)
+    {
+      const aiMesh* m = mesh->mMeshes[s];
+      int offset = vertices.size();
+      for (int v = 0; v < m->mNumVertices; v++)
+      {
+        aiVector3D vec = m->mVertices[v];
+        vertices.emplace_back(vec.x, vec.y, vec.z);
+      }
+      for (int f = 0; f < m->mNumFaces; f++)
+      {
+        const aiFace& face = m->mFaces[f];
+        if (face.mNumIndices != 3)
+          continue;
+        triangles.emplace_back(
+            offset + face.mIndices[0],
+            offset + face.mIndices[1],
+            offset + face.mIndices[2]);
+      }
+    }
+    mTriangleBvh
+        = std::make_shared<const math::TriangleBvh>(vertices, triangles);
+  }
+  return mTriangleBvh;
+}
+
+//==============================================================================
+/// If you edit the vertices of `mesh` in place, call this so that the next
+/// getSupportHull(), getBoundingBox(), getVertexKdTree() and getTriangleBvh()
+/// recompute from the new vertices.
+void SharedMeshWrapper::invalidateSupportHull()
+{
+  std::lock_guard<std::mutex> lock(mSupportHullMutex);
+  mSupportHull = nullptr;
+  mVertexKdTree = nullptr;
+  mTriangleBvh = nullptr;
+  mHasBoundingBox = false;
+}
+
 //==============================================================================
 MeshShape::MeshShape(
     const Eigen::Vector3s& scale,
@@ -231,6 +384,36 @@ std::vector<Eigen::Vector3s> MeshShape::getVertices() const
   return vertices;
 }
 
+//==============================================================================
+/// This returns the (cached) convex hull of the vertices, in the unscaled mesh
+/// frame, or nullptr if there's no mesh.
+std::shared_ptr<const math::SupportHull> MeshShape::getSupportHull() const
+{
+  if (!mMesh)
+    return nullptr;
+  return mMesh->getSupportHull();
+}
+
+//==============================================================================
+/// This returns the (cached) k-d tree over the vertices, in the unscaled mesh
+/// frame, or nullptr if there's no mesh.
+std::shared_ptr<const math::VertexKdTree> MeshShape::getVertexKdTree() const
+{
+  if (!mMesh)
+    return nullptr;
+  return mMesh->getVertexKdTree();
+}
+
+//==============================================================================
+/// This returns the (cached) BVH over the triangles, in the unscaled mesh
+/// frame, or nullptr if there's no mesh.
+std::shared_ptr<const math::TriangleBvh> MeshShape::getTriangleBvh() const
+{
+  if (!mMesh)
+    return nullptr;
+  return mMesh->getTriangleBvh();
+}
+
 //==============================================================================
 const aiScene* MeshShape::getMesh() const
 {
@@ -399,36 +582,11 @@ void MeshShape::updateBoundingBox() const
     return;
   }
 
-  s_t max_X = -std::numeric_limits<s_t>::infinity();
-  s_t max_Y = -std::numeric_limits<s_t>::infinity();
-  s_t max_Z = -std::numeric_limits<s_t>::infinity();
-  s_t min_X = std::numeric_limits<s_t>::infinity();
-  s_t min_Y = std::numeric_limits<s_t>::infinity();
-  s_t min_Z = std::numeric_limits<s_t>::infinity();
-
-  const aiScene* mesh = getMesh();
-  for (unsigned int i = 0; i < mesh->mNumMeshes; i++)
-  {
-    for (unsigned int j = 0; j < mesh->mMeshes[i]->mNumVertices; j++)
-    {
-      if (mesh->mMeshes[i]->mVertices[j].x > max_X)
-        max_X = mesh->mMeshes[i]->mVertices[j].x;
-      if (mesh->mMeshes[i]->mVertices[j].x < min_X)
-        min_X = mesh->mMeshes[i]->mVertices[j].x;
-      if (mesh->mMeshes[i]->mVertices[j].y > max_Y)
-        max_Y = mesh->mMeshes[i]->mVertices[j].y;
-      if (mesh->mMeshes[i]->mVertices[j].y < min_Y)
-        min_Y = mesh->mMeshes[i]->mVertices[j].y;
-      if (mesh->mMeshes[i]->mVertices[j].z > max_Z)
-        max_Z = mesh->mMeshes[i]->mVertices[j].z;
-      if (mesh->mMeshes[i]->mVertices[j].z < min_Z)
-        min_Z = mesh->mMeshes[i]->mVertices[j].z;
-    }
-  }
-  mBoundingBox.setMin(
-      Eigen::Vector3s(min_X * mScale[0], min_Y * mScale[1], min_Z * mScale[2]));
-  mBoundingBox.setMax(
-      Eigen::Vector3s(max_X * mScale[0], max_Y * mScale[1], max_Z * mScale[2]));
+  // The unscaled box is shared by every MeshShape using this mesh, so we only
+  // walk the vertices once
+  const math::BoundingBox box = mMesh->getBoundingBox();
+  mBoundingBox.setMin(box.getMin().cwiseProduct(mScale));
+  mBoundingBox.setMax(box.getMax().cwiseProduct(mScale));
 
   mIsBoundingBoxDirty = false;
 }
@@ -442,8 +600,19 @@ void MeshShape::updateVolume() const
 }
 
 //==============================================================================
+/// This loads a mesh through the global MeshCache, so it only gets imported
+/// the first time. The returned mesh may be shared with other MeshShapes.
 std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
     const std::string& _uri, const common::ResourceRetrieverPtr& retriever)
+{
+  return MeshCache::getGlobal().load(_uri, retriever);
+}
+
+//==============================================================================
+/// This always imports a fresh copy of the mesh through Assimp, bypassing the
+/// MeshCache
+std::shared_ptr<SharedMeshWrapper> MeshShape::importMesh(
+    const std::string& _uri, const common::ResourceRetrieverPtr& retriever)
 {
   // Remove points and lines from the import.
   aiPropertyStore* propertyStore = aiCreatePropertyStore();
@@ -488,7 +657,7 @@ std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
   // necessary because the importer owns the memory that it allocates.
   if (!scene)
   {
-    dtwarn << "[MeshShape::loadMesh] Failed loading mesh '" << _uri
+    dtwarn << "[MeshShape::importMesh] Failed loading mesh '" << _uri
            << "' with ASSIMP error '" << std::string(aiGetErrorString())
            << "'.\n";
 
@@ -519,7 +688,7 @@ std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
   // import process, because we may have changed mTransformation above.
   scene = aiApplyPostProcessing(scene, aiProcess_PreTransformVertices);
   if (!scene)
-    dtwarn << "[MeshShape::loadMesh] Failed pre-transforming vertices.\n";
+    dtwarn << "[MeshShape::importMesh] Failed pre-transforming vertices.\n";
 
   aiReleasePropertyStore(propertyStore);
 
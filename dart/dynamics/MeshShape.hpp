@@ -33,6 +33,8 @@
 #ifndef DART_DYNAMICS_MESHSHAPE_HPP_
 #define DART_DYNAMICS_MESHSHAPE_HPP_
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -40,6 +42,9 @@
 
 #include "dart/common/ResourceRetriever.hpp"
 #include "dart/dynamics/Shape.hpp"
+#include "dart/math/SupportHull.hpp"
+#include "dart/math/TriangleBvh.hpp"
+#include "dart/math/VertexKdTree.hpp"
 
 namespace dart {
 namespace dynamics {
@@ -49,7 +54,42 @@ struct SharedMeshWrapper
   SharedMeshWrapper(const aiScene* mesh);
   ~SharedMeshWrapper();
 
+  /// This returns the convex hull of every vertex in the mesh, which
+  /// collision detection uses for fast support queries. It's built the first
+  /// time anyone asks, and then shared by every MeshShape (and clone) that
+  /// uses this mesh. The hull also carries the mesh's surface connectivity
+  /// (see math::SupportHull::getMeshAdjacency()).
+  std::shared_ptr<const math::SupportHull> getSupportHull() const;
+
+  /// This returns the axis-aligned bounding box of every vertex in the mesh,
+  /// before any MeshShape scaling. Like the hull, it's computed once and then
+  /// shared.
+  math::BoundingBox getBoundingBox() const;
+
+  /// This returns a k-d tree over every vertex in the mesh, before any
+  /// MeshShape scaling, for nearest-vertex queries. Like the hull, it's built
+  /// once and then shared.
+  std::shared_ptr<const math::VertexKdTree> getVertexKdTree() const;
+
+  /// This returns a BVH over every triangle in the mesh, before any MeshShape
+  /// scaling, for raycasts. Faces that aren't triangles are skipped. Like the
+  /// hull, it's built once and then shared.
+  std::shared_ptr<const math::TriangleBvh> getTriangleBvh() const;
+
+  /// If you edit the vertices of `mesh` in place, call this so that the next
+  /// getSupportHull(), getBoundingBox(), getVertexKdTree() and
+  /// getTriangleBvh() recompute from the new vertices.
+  void invalidateSupportHull();
+
   const aiScene* mesh;
+
+protected:
+  mutable std::mutex mSupportHullMutex;
+  mutable std::shared_ptr<const math::SupportHull> mSupportHull;
+  mutable std::shared_ptr<const math::VertexKdTree> mVertexKdTree;
+  mutable std::shared_ptr<const math::TriangleBvh> mTriangleBvh;
+  mutable bool mHasBoundingBox = false;
+  mutable math::BoundingBox mBoundingBox;
 };
 
 class MeshShape : public Shape
@@ -112,6 +152,18 @@ public:
 
   std::vector<Eigen::Vector3s> getVertices() const;
 
+  /// This returns the (cached) convex hull of the vertices, in the unscaled
+  /// mesh frame, or nullptr if there's no mesh.
+  std::shared_ptr<const math::SupportHull> getSupportHull() const;
+
+  /// This returns the (cached) k-d tree over the vertices, in the unscaled
+  /// mesh frame, or nullptr if there's no mesh.
+  std::shared_ptr<const math::VertexKdTree> getVertexKdTree() const;
+
+  /// This returns the (cached) BVH over the triangles, in the unscaled mesh
+  /// frame, or nullptr if there's no mesh.
+  std::shared_ptr<const math::TriangleBvh> getTriangleBvh() const;
+
   /// Updates positions of the vertices or the elements. By default, this does
   /// nothing; you must extend the MeshShape class and implement your own
   /// version of this function if you want the mesh data to get updated before
@@ -173,12 +225,19 @@ public:
   static std::shared_ptr<SharedMeshWrapper> loadMesh(
       const std::string& filePath);
 
+  /// This loads a mesh through the global MeshCache, so it only gets imported
+  /// the first time. The returned mesh may be shared with other MeshShapes.
   static std::shared_ptr<SharedMeshWrapper> loadMesh(
       const std::string& _uri, const common::ResourceRetrieverPtr& retriever);
 
   static std::shared_ptr<SharedMeshWrapper> loadMesh(
       const common::Uri& uri, const common::ResourceRetrieverPtr& retriever);
 
+  /// This always imports a fresh copy of the mesh through Assimp, bypassing
+  /// the MeshCache
+  static std::shared_ptr<SharedMeshWrapper> importMesh(
+      const std::string& uri, const common::ResourceRetrieverPtr& retriever);
+
   // Documentation inherited.
   Eigen::Matrix3s computeInertia(s_t mass) const override;
 
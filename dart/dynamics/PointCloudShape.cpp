@@ -56,7 +56,8 @@ PointCloudShape::PointCloudShape(s_t visualSize)
   : Shape(),
     mPointShapeType(BOX),
     mColorMode(USE_SHAPE_COLOR),
-    mVisualSize(visualSize)
+    mVisualSize(visualSize),
+    mScale(Eigen::Vector3s::Ones())
 {
   // Do nothing
 }
@@ -90,6 +91,7 @@ void PointCloudShape::reserve(std::size_t size)
 void PointCloudShape::addPoint(const Eigen::Vector3s& point)
 {
   mPoints.emplace_back(point);
+  invalidateSphereTree();
   incrementVersion();
 }
 
@@ -99,6 +101,7 @@ void PointCloudShape::addPoint(const std::vector<Eigen::Vector3s>& points)
   mPoints.reserve(mPoints.size() + points.size());
   for (const auto& point : points)
     mPoints.emplace_back(point);
+  invalidateSphereTree();
   incrementVersion();
 }
 
@@ -106,6 +109,7 @@ void PointCloudShape::addPoint(const std::vector<Eigen::Vector3s>& points)
 void PointCloudShape::setPoint(const std::vector<Eigen::Vector3s>& points)
 {
   mPoints = points;
+  invalidateSphereTree();
   incrementVersion();
 }
 
@@ -116,6 +120,7 @@ void PointCloudShape::setPoints(octomap::Pointcloud& pointCloud)
   mPoints.resize(pointCloud.size());
   for (auto i = 0u; i < mPoints.size(); ++i)
     mPoints[i] = toVector3s(pointCloud[i]);
+  invalidateSphereTree();
   incrementVersion();
 }
 
@@ -125,6 +130,7 @@ void PointCloudShape::addPoints(octomap::Pointcloud& pointCloud)
   mPoints.reserve(mPoints.size() + pointCloud.size());
   for (const auto& point : pointCloud)
     mPoints.emplace_back(toVector3s(point));
+  invalidateSphereTree();
   incrementVersion();
 }
 #endif
@@ -145,6 +151,7 @@ std::size_t PointCloudShape::getNumPoints() const
 void PointCloudShape::removeAllPoints()
 {
   mPoints.clear();
+  invalidateSphereTree();
 }
 
 //==============================================================================
@@ -223,6 +230,7 @@ PointCloudShape::getColors() const
 void PointCloudShape::setVisualSize(s_t size)
 {
   mVisualSize = size;
+  invalidateSphereTree();
   incrementVersion();
 }
 
@@ -232,12 +240,78 @@ s_t PointCloudShape::getVisualSize() const
   return mVisualSize;
 }
 
+//==============================================================================
+/// Sets the scale the points are multiplied through by. BodyNode::setScale()
+/// uses this, so the points themselves never get rewritten.
+void PointCloudShape::setScale(const Eigen::Vector3s& scale)
+{
+  mScale = scale;
+  mIsBoundingBoxDirty = true;
+  incrementVersion();
+}
+
+//==============================================================================
+/// Returns the scale the points are multiplied through by.
+const Eigen::Vector3s& PointCloudShape::getScale() const
+{
+  return mScale;
+}
+
+//==============================================================================
+/// This returns a sphere tree over the points, which collision detection uses
+/// to only test the points near the other shape. Each point collides as a
+/// sphere with a diameter of getVisualSize(), so it's as thick as it looks.
+/// The tree is built the first time anyone asks, after which a change of
+/// scale just refits it, and only editing the points or the visual size
+/// rebuilds it. The tree is at the current scale.
+std::shared_ptr<const math::SphereTree> PointCloudShape::getSphereTree() const
+{
+  std::lock_guard<std::mutex> lock(mSphereTreeMutex);
+  if (!mSphereTree)
+  {
+    auto tree = std::make_shared<math::SphereTree>(mPoints, 0.5 * mVisualSize);
+    tree->refit(mScale);
+    mSphereTree = tree;
+  }
+  else if (mSphereTree->getScale() != mScale)
+  {
+    // Anyone still holding the old tree keeps a consistent copy
+    auto tree = std::make_shared<math::SphereTree>(*mSphereTree);
+    tree->refit(mScale);
+    mSphereTree = tree;
+  }
+  return mSphereTree;
+}
+
+//==============================================================================
+/// This drops the cached sphere tree and bounding box, after the points change
+void PointCloudShape::invalidateSphereTree()
+{
+  std::lock_guard<std::mutex> lock(mSphereTreeMutex);
+  mSphereTree = nullptr;
+  mIsBoundingBoxDirty = true;
+}
+
 //==============================================================================
 void PointCloudShape::notifyColorUpdated(const Eigen::Vector4s& /*color*/)
 {
   incrementVersion();
 }
 
+//==============================================================================
+/// Allow us to clone shapes, to avoid race conditions when scaling shapes
+/// belonging to different skeletons
+ShapePtr PointCloudShape::clone() const
+{
+  auto cloud = std::make_shared<PointCloudShape>(mVisualSize);
+  cloud->setPoint(mPoints);
+  cloud->setPointShapeType(mPointShapeType);
+  cloud->setColorMode(mColorMode);
+  cloud->setColors(mColors);
+  cloud->setScale(mScale);
+  return cloud;
+}
+
 //==============================================================================
 void PointCloudShape::updateVolume() const
 {
@@ -263,12 +337,15 @@ void PointCloudShape::updateBoundingBox() const
 
   for (const auto& vertex : mPoints)
   {
-    min = min.cwiseMin(vertex);
-    max = max.cwiseMax(vertex);
+    min = min.cwiseMin(mScale.cwiseProduct(vertex));
+    max = max.cwiseMax(mScale.cwiseProduct(vertex));
   }
 
-  mBoundingBox.setMin(min);
-  mBoundingBox.setMax(max);
+  // Leave room for the spheres the points collide as
+  const Eigen::Vector3s extent = Eigen::Vector3s::Constant(
+      0.5 * mVisualSize * mScale.cwiseAbs().maxCoeff());
+  mBoundingBox.setMin(min - extent);
+  mBoundingBox.setMax(max + extent);
 
   mIsBoundingBoxDirty = false;
 }
@@ -33,7 +33,11 @@
 #ifndef DART_DYNAMICS_POINTCLOUDSHAPE_HPP_
 #define DART_DYNAMICS_POINTCLOUDSHAPE_HPP_
 
+#include <memory>
+#include <mutex>
+
 #include "dart/dynamics/Shape.hpp"
+#include "dart/math/SphereTree.hpp"
 
 #if HAVE_OCTOMAP
 #include <octomap/Pointcloud.h>
@@ -149,9 +153,28 @@ public:
   /// Returns size of visual object that represents each point.
   s_t getVisualSize() const;
 
+  /// Sets the scale the points are multiplied through by. BodyNode::setScale()
+  /// uses this, so the points themselves never get rewritten.
+  void setScale(const Eigen::Vector3s& scale);
+
+  /// Returns the scale the points are multiplied through by.
+  const Eigen::Vector3s& getScale() const;
+
+  /// This returns a sphere tree over the points, which collision detection
+  /// uses to only test the points near the other shape. Each point collides
+  /// as a sphere with a diameter of getVisualSize(), so it's as thick as it
+  /// looks. The tree is built the first time anyone asks, after which a
+  /// change of scale just refits it, and only editing the points or the
+  /// visual size rebuilds it. The tree is at the current scale.
+  std::shared_ptr<const math::SphereTree> getSphereTree() const;
+
   // Documentation inherited.
   void notifyColorUpdated(const Eigen::Vector4s& color) override;
 
+  /// Allow us to clone shapes, to avoid race conditions when scaling shapes
+  /// belonging to different skeletons
+  ShapePtr clone() const override;
+
 protected:
   // Documentation inherited.
   void updateVolume() const override;
@@ -174,6 +197,17 @@ protected:
 
   /// The size of visual object that represents each point.
   s_t mVisualSize;
+
+  /// See setScale()
+  Eigen::Vector3s mScale;
+
+  /// See getSphereTree(). This is reset whenever the points change.
+  mutable std::mutex mSphereTreeMutex;
+  mutable std::shared_ptr<const math::SphereTree> mSphereTree;
+
+  /// This drops the cached sphere tree and bounding box, after the points
+  /// change
+  void invalidateSphereTree();
 };
 
 } // namespace dynamics
@@ -1120,6 +1120,7 @@ void PointMassNotifier::clearAccelerationNotice()
 void PointMassNotifier::dirtyTransform()
 {
   mNeedTransformUpdate = true;
+  ++mTransformVersion;
   mNeedVelocityUpdate = true;
   mNeedPartialAccelerationUpdate = true;
   mNeedAccelerationUpdate = true;
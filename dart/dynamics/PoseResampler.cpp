@@ -0,0 +1,196 @@
+#include "dart/dynamics/PoseResampler.hpp"
+
+#include <algorithm>
+#include <future>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+/// Below this many frames per block, splitting across threads costs more than
+/// it saves
+constexpr int MIN_FRAMES_PER_BLOCK = 64;
+
+} // namespace
+
+//==============================================================================
+PoseResampler::PoseResampler(const std::shared_ptr<Skeleton>& skel)
+  : mNumDofs(skel->getNumDofs())
+{
+  for (std::size_t i = 0; i < skel->getNumJoints(); i++)
+  {
+    const Joint* joint = skel->getJoint(i);
+    if (joint->getNumDofs() == 0)
+      continue;
+    // Both joint types keep their rotation as exponential coordinates in the
+    // first three dofs. FreeJoint translations are interpolated linearly.
+    if (joint->getType() == BallJoint::getStaticType()
+        || joint->getType() == FreeJoint::getStaticType())
+    {
+      mRotationDofs.push_back(joint->getIndexInSkeleton(0));
+    }
+  }
+}
+
+//==============================================================================
+Eigen::MatrixXs PoseResampler::resample(
+    const Eigen::MatrixXs& poses,
+    const std::vector<double>& times,
+    const std::vector<double>& newTimes,
+    int numThreads) const
+{
+  assert(poses.rows() == mNumDofs);
+  assert(poses.cols() == static_cast<int>(times.size()));
+
+  const int numFrames = poses.cols();
+  const int numNewFrames = newTimes.size();
+  Eigen::MatrixXs result = Eigen::MatrixXs::Zero(poses.rows(), numNewFrames);
+  if (numFrames == 0 || numNewFrames == 0)
+    return result;
+
+  auto resampleBlock = [&](int first, int last) {
+    for (int j = first; j < last; j++)
+    {
+      const double t = newTimes[j];
+      // The last frame at or before t
+      int i = static_cast<int>(
+                  std::upper_bound(times.begin(), times.end(), t)
+                  - times.begin())
+              - 1;
+      if (i < 0)
+      {
+        result.col(j) = poses.col(0);
+      }
+      else if (i >= numFrames - 1)
+      {
+        result.col(j) = poses.col(numFrames - 1);
+      }
+      else
+      {
+        const double span = times[i + 1] - times[i];
+        const s_t alpha = span > 0 ? (t - times[i]) / span : 0.0;
+        interpolateInto(poses.col(i), poses.col(i + 1), alpha, result.col(j));
+      }
+    }
+  };
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  if (numThreads <= 0)
+    numThreads = static_cast<int>(pool.getNumThreads());
+  const int numBlocks = std::max(
+      1, std::min(numThreads, numNewFrames / MIN_FRAMES_PER_BLOCK));
+  if (numBlocks == 1)
+  {
+    resampleBlock(0, numNewFrames);
+    return result;
+  }
+
+  std::vector<std::future<void>> futures;
+  for (int block = 0; block < numBlocks; block++)
+  {
+    const int first = static_cast<int>(
+        static_cast<long>(numNewFrames) * block / numBlocks);
+    const int last = static_cast<int>(
+        static_cast<long>(numNewFrames) * (block + 1) / numBlocks);
+    futures.push_back(pool.submit(resampleBlock, first, last));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+    future.get();
+  return result;
+}
+
+//==============================================================================
+Eigen::MatrixXs PoseResampler::resampleUniform(
+    const Eigen::MatrixXs& poses,
+    s_t timestep,
+    s_t newTimestep,
+    int numThreads) const
+{
+  assert(timestep > 0 && newTimestep > 0);
+  const int numFrames = poses.cols();
+  std::vector<double> times(numFrames);
+  for (int i = 0; i < numFrames; i++)
+    times[i] = static_cast<double>(i * timestep);
+  if (numFrames == 0)
+    return Eigen::MatrixXs::Zero(poses.rows(), 0);
+
+  // Allow a little slack so rounding doesn't drop the last frame when the
+  // two rates line up exactly
+  const double duration = times.back();
+  const double newDt = static_cast<double>(newTimestep);
+  const int numNewFrames = static_cast<int>(duration / newDt + 1e-9) + 1;
+  std::vector<double> newTimes(numNewFrames);
+  for (int i = 0; i < numNewFrames; i++)
+    newTimes[i] = i * newDt;
+  return resample(poses, times, newTimes, numThreads);
+}
+
+//==============================================================================
+Eigen::VectorXs PoseResampler::interpolate(
+    const Eigen::VectorXs& from, const Eigen::VectorXs& to, s_t t) const
+{
+  Eigen::VectorXs out(from.size());
+  interpolateInto(from, to, t, out);
+  return out;
+}
+
+//==============================================================================
+const std::vector<int>& PoseResampler::getRotationDofs() const
+{
+  return mRotationDofs;
+}
+
+//==============================================================================
+void PoseResampler::interpolateInto(
+    const Eigen::Ref<const Eigen::VectorXs>& from,
+    const Eigen::Ref<const Eigen::VectorXs>& to,
+    s_t t,
+    Eigen::Ref<Eigen::VectorXs> out) const
+{
+  // Everything starts out linear, in one vectorized pass, and then the
+  // rotations get overwritten
+  out = (1 - t) * from + t * to;
+  if (t == 0 || t == 1)
+    return;
+
+  for (int dof : mRotationDofs)
+  {
+    const Eigen::Vector3s a = from.segment<3>(dof);
+    const Eigen::Vector3s b = to.segment<3>(dof);
+    const Eigen::Matrix3s R0 = math::expMapRot(a);
+    const Eigen::Vector3s delta
+        = math::logMap(R0.transpose() * math::expMapRot(b));
+    Eigen::Vector3s w = math::logMap(R0 * math::expMapRot(t * delta));
+
+    // logMap() always returns an angle of at most pi, but trials often carry
+    // unwrapped angles past that. Pick the equivalent coordinates closest to
+    // the linear interpolation, so the resampled trial stays continuous.
+    const s_t angle = w.norm();
+    if (angle > 1e-12)
+    {
+      const Eigen::Vector3s turn = w * (2 * M_PI / angle);
+      const Eigen::Vector3s linear = out.segment<3>(dof);
+      Eigen::Vector3s best = w;
+      for (int k = -1; k <= 1; k += 2)
+      {
+        const Eigen::Vector3s candidate = w + static_cast<s_t>(k) * turn;
+        if ((candidate - linear).squaredNorm() < (best - linear).squaredNorm())
+          best = candidate;
+      }
+      w = best;
+    }
+    out.segment<3>(dof) = w;
+  }
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,73 @@
+#ifndef DART_DYNAMICS_POSERESAMPLER_HPP_
+#define DART_DYNAMICS_POSERESAMPLER_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class Skeleton;
+
+/// This resamples whole trials of a Skeleton's generalized positions to new
+/// timestamps, for example to bring a .mot file, a C3D recording, and a
+/// controller running on millisecond steps onto the same clock.
+///
+/// The rotational coordinates of BallJoints and FreeJoints are interpolated
+/// along the shortest rotation between the two poses (SLERP), and every other
+/// coordinate is interpolated linearly. The joint types are inspected once, in
+/// the constructor, so resampling works purely on the pose matrices and never
+/// calls setPositions() on the Skeleton. Long trials are split into blocks of
+/// frames that are resampled on the global thread pool.
+class PoseResampler
+{
+public:
+  explicit PoseResampler(const std::shared_ptr<Skeleton>& skel);
+
+  /// Resamples `poses` (one column per frame, with frame i at `times[i]`) to
+  /// `newTimes`. `times` must be increasing. Times outside the range of
+  /// `times` get the first or last pose. numThreads <= 0 uses every worker in
+  /// the global thread pool.
+  Eigen::MatrixXs resample(
+      const Eigen::MatrixXs& poses,
+      const std::vector<double>& times,
+      const std::vector<double>& newTimes,
+      int numThreads = 0) const;
+
+  /// Resamples `poses`, recorded every `timestep` seconds, to one pose every
+  /// `newTimestep` seconds over the same span
+  Eigen::MatrixXs resampleUniform(
+      const Eigen::MatrixXs& poses,
+      s_t timestep,
+      s_t newTimestep,
+      int numThreads = 0) const;
+
+  /// Interpolates a single pose `t` of the way (from 0 to 1) from `from` to
+  /// `to`
+  Eigen::VectorXs interpolate(
+      const Eigen::VectorXs& from, const Eigen::VectorXs& to, s_t t) const;
+
+  /// Returns the index of the first of the three rotational coordinates of
+  /// each BallJoint and FreeJoint in the Skeleton
+  const std::vector<int>& getRotationDofs() const;
+
+protected:
+  /// Writes the interpolation between `from` and `to` into `out`
+  void interpolateInto(
+      const Eigen::Ref<const Eigen::VectorXs>& from,
+      const Eigen::Ref<const Eigen::VectorXs>& to,
+      s_t t,
+      Eigen::Ref<Eigen::VectorXs> out) const;
+
+  int mNumDofs;
+  std::vector<int> mRotationDofs;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
@@ -454,6 +454,28 @@ std::size_t ReferentialSkeleton::getIndexOf(
   return it->second.mDofIndices[localIndex];
 }
 
+//==============================================================================
+const std::vector<std::pair<std::size_t, std::size_t>>&
+ReferentialSkeleton::getDependentDofColumns(const JacobianNode* _node) const
+{
+  const std::vector<const DegreeOfFreedom*>& dofs = _node->getDependentDofs();
+
+  DependentDofColumns& entry = mDependentDofColumns[_node];
+  if(entry.mDofs != dofs)
+  {
+    entry.mDofs = dofs;
+    entry.mColumns.clear();
+    for(std::size_t i=0; i < dofs.size(); ++i)
+    {
+      std::size_t refIndex = getIndexOf(dofs[i], false);
+      if(INVALID_INDEX != refIndex)
+        entry.mColumns.emplace_back(i, refIndex);
+    }
+  }
+
+  return entry.mColumns;
+}
+
 //==============================================================================
 static bool isValidBodyNode(const ReferentialSkeleton* /*_refSkel*/,
                             const JacobianNode* _node,
@@ -481,17 +503,8 @@ void assignJacobian(JacobianType& _J,
                     const JacobianNode* _node,
                     const JacobianType& _JBodyNode)
 {
-  const std::vector<const DegreeOfFreedom*>& bn_dofs =
-      _node->getDependentDofs();
-  std::size_t nDofs = bn_dofs.size();
-  for(std::size_t i=0; i<nDofs; ++i)
-  {
-    std::size_t refIndex = _refSkel->getIndexOf(bn_dofs[i], false);
-    if(INVALID_INDEX == refIndex)
-      continue;
-
-    _J.col(refIndex) = _JBodyNode.col(i);
-  }
+  for(const auto& column : _refSkel->getDependentDofColumns(_node))
+    _J.col(column.second) = _JBodyNode.col(column.first);
 }
 
 //==============================================================================
@@ -506,7 +519,7 @@ math::Jacobian variadicGetJacobian(
   if( !isValidBodyNode(_refSkel, _node, "getJacobian") )
     return J;
 
-  const math::Jacobian JBodyNode = _node->getJacobian(args...);
+  const math::Jacobian& JBodyNode = _node->getJacobian(args...);
 
   assignJacobian(J, _refSkel, _node, JBodyNode);
 
@@ -552,7 +565,7 @@ math::Jacobian variadicGetWorldJacobian(const ReferentialSkeleton* _refSkel,
   if( !isValidBodyNode(_refSkel, _node, "getWorldJacobian") )
     return J;
 
-  const math::Jacobian JBodyNode = _node->getWorldJacobian(args...);
+  const math::Jacobian& JBodyNode = _node->getWorldJacobian(args...);
 
   assignJacobian(J, _refSkel, _node, JBodyNode);
 
@@ -585,7 +598,7 @@ math::LinearJacobian variadicGetLinearJacobian(
   if( !isValidBodyNode(_refSkel, _node, "getLinearJacobian") )
     return J;
 
-  const math::LinearJacobian JBodyNode = _node->getLinearJacobian(args...);
+  const math::LinearJacobian& JBodyNode = _node->getLinearJacobian(args...);
 
   assignJacobian(J, _refSkel, _node, JBodyNode);
 
@@ -620,7 +633,7 @@ math::AngularJacobian variadicGetAngularJacobian(
   if( !isValidBodyNode(_refSkel, _node, "getAngularJacobian") )
     return J;
 
-  const math::AngularJacobian JBodyNode =
+  const math::AngularJacobian& JBodyNode =
       _node->getAngularJacobian(args...);
 
   assignJacobian(J, _refSkel, _node, JBodyNode);
@@ -646,7 +659,7 @@ math::Jacobian variadicGetJacobianSpatialDeriv(
   if( !isValidBodyNode(_refSkel, _node, "getJacobianSpatialDeriv") )
     return dJ;
 
-  const math::Jacobian dJBodyNode = _node->getJacobianSpatialDeriv(args...);
+  const math::Jacobian& dJBodyNode = _node->getJacobianSpatialDeriv(args...);
 
   assignJacobian(dJ, _refSkel, _node, dJBodyNode);
 
@@ -694,7 +707,7 @@ math::Jacobian variadicGetJacobianClassicDeriv(
   if( !isValidBodyNode(_refSkel, _node, "getJacobianClassicDeriv") )
     return dJ;
 
-  const math::Jacobian dJBodyNode = _node->getJacobianClassicDeriv(args...);
+  const math::Jacobian& dJBodyNode = _node->getJacobianClassicDeriv(args...);
 
   assignJacobian(dJ, _refSkel, _node, dJBodyNode);
 
@@ -736,7 +749,7 @@ math::LinearJacobian variadicGetLinearJacobianDeriv(
   if( !isValidBodyNode(_refSkel, _node, "getLinearJacobianDeriv") )
     return dJv;
 
-  const math::LinearJacobian dJvBodyNode =
+  const math::LinearJacobian& dJvBodyNode =
       _node->getLinearJacobianDeriv(args...);
 
   assignJacobian(dJv, _refSkel, _node, dJvBodyNode);
@@ -772,7 +785,7 @@ math::AngularJacobian variadicGetAngularJacobianDeriv(
   if( !isValidBodyNode(_refSkel, _node, "getAngularJacobianDeriv") )
     return dJw;
 
-  const math::AngularJacobian dJwBodyNode =
+  const math::AngularJacobian& dJwBodyNode =
       _node->getAngularJacobianDeriv(args...);
 
   assignJacobian(dJw, _refSkel, _node, dJwBodyNode);
@@ -1081,17 +1094,8 @@ JacType getCOMJacobianTemplate(const ReferentialSkeleton* _refSkel,
                                                   _inCoordinatesOf);
     totalMass += bn->getMass();
 
-    const std::vector<const DegreeOfFreedom*>& dofs = bn->getDependentDofs();
-    std::size_t nDofs = dofs.size();
-    for(std::size_t i=0; i<nDofs; ++i)
-    {
-      const DegreeOfFreedom* dof = dofs[i];
-      std::size_t index = _refSkel->getIndexOf(dof, false);
-      if(INVALID_INDEX == index)
-        continue;
-
-      J.col(index) += bnJ.col(i);
-    }
+    for(const auto& column : _refSkel->getDependentDofColumns(bn))
+      J.col(column.second) += bnJ.col(column.first);
   }
 
   assert(totalMass != 0.0);
@@ -1449,6 +1453,8 @@ void ReferentialSkeleton::updateCaches()
     mRawConstDofs.push_back(dof);
   }
 
+  mDependentDofColumns.clear();
+
   std::size_t nDofs = mDofs.size();
   mM        = Eigen::MatrixXs::Zero(nDofs, nDofs);
   mAugM     = Eigen::MatrixXs::Zero(nDofs, nDofs);
@@ -199,6 +199,15 @@ public:
   std::size_t getIndexOf(const DegreeOfFreedom* _dof,
                     bool _warning=true) const override;
 
+  /// Returns the pairs (i, j) where column i of a Jacobian of `_node` goes to
+  /// column j of the same Jacobian in this ReferentialSkeleton, for every
+  /// dependent DegreeOfFreedom of `_node` that this ReferentialSkeleton
+  /// contains. This gets cached per node, and rebuilt whenever the structure
+  /// of this ReferentialSkeleton or the dependent DegreesOfFreedom of `_node`
+  /// change.
+  const std::vector<std::pair<std::size_t, std::size_t>>&
+  getDependentDofColumns(const JacobianNode* _node) const;
+
   /// \}
 
   //----------------------------------------------------------------------------
@@ -508,6 +517,21 @@ protected:
   /// DegreesOfFreedom
   std::unordered_map<const BodyNode*, IndexMap> mIndexMap;
 
+  /// The columns that the dependent DegreesOfFreedom of a JacobianNode map to
+  struct DependentDofColumns
+  {
+    /// The dependent DegreesOfFreedom of the node when this was built, to
+    /// check whether it's still valid
+    std::vector<const DegreeOfFreedom*> mDofs;
+
+    /// See getDependentDofColumns()
+    std::vector<std::pair<std::size_t, std::size_t>> mColumns;
+  };
+
+  /// Cache for getDependentDofColumns(). This gets cleared by updateCaches().
+  mutable std::unordered_map<const JacobianNode*, DependentDofColumns>
+      mDependentDofColumns;
+
   /// Cache for Mass Matrix
   mutable Eigen::MatrixXs mM;
 
@@ -129,6 +129,14 @@ public:
   // void setCollidable(const bool& value);
   // const bool& getCollidable() const;
 
+  DART_COMMON_SET_GET_ASPECT_PROPERTY(std::uint32_t, CollisionLayers)
+  // void setCollisionLayers(const std::uint32_t& value);
+  // const std::uint32_t& getCollisionLayers() const;
+
+  DART_COMMON_SET_GET_ASPECT_PROPERTY(std::uint32_t, CollisionMask)
+  // void setCollisionMask(const std::uint32_t& value);
+  // const std::uint32_t& getCollisionMask() const;
+
   /// Return true if this body can collide with others bodies
   bool isCollidable() const;
 };
@@ -8,6 +8,51 @@
 namespace dart {
 namespace dynamics {
 
+namespace {
+
+// This is the motion across a joint, specialized at compile time for each
+// joint type
+template <int JointType>
+Eigen::Isometry3s jointTransform(const Eigen::Vector6s& axis, s_t pos);
+
+template <>
+Eigen::Isometry3s jointTransform<SCREW>(const Eigen::Vector6s& axis, s_t pos)
+{
+  return math::expMap(axis * pos);
+}
+
+template <>
+Eigen::Isometry3s jointTransform<REVOLUTE>(
+    const Eigen::Vector6s& axis, s_t pos)
+{
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.linear() = math::expMapRot(axis.head<3>() * pos);
+  return T;
+}
+
+template <>
+Eigen::Isometry3s jointTransform<PRISMATIC>(
+    const Eigen::Vector6s& axis, s_t pos)
+{
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = axis.tail<3>() * pos;
+  return T;
+}
+
+template <int JointType>
+void updateTransform(
+    const JointAndBody& jointAndBody,
+    s_t pos,
+    FeatherstoneScratchSpace& scratch)
+{
+  scratch.transformFromParent
+      = jointAndBody.transformFromParent
+        * jointTransform<JointType>(jointAndBody.axis, pos)
+        * jointAndBody.transformFromChildren;
+}
+
+} // namespace
+
 // This creates a new JointAndBody object in our vector, and returns it by
 // reference
 JointAndBody& SimpleFeatherstone::emplaceBack()
@@ -29,13 +74,11 @@ void SimpleFeatherstone::forwardDynamics(
     s_t* force,
     /* OUT */ s_t* accelerations)
 {
+  updateTransforms(pos);
+
   // Forward pass
   for (int i = 0; i < len(); i++)
   {
-    mScratchSpace[i].transformFromParent
-        = mJointsAndBodies[i].transformFromParent
-          * math::expMap(mJointsAndBodies[i].axis * pos[i])
-          * mJointsAndBodies[i].transformFromChildren;
     if (mJointsAndBodies[i].parentIndex != -1)
     {
       mScratchSpace[i].spatialVelocity
@@ -68,11 +111,6 @@ void SimpleFeatherstone::forwardDynamics(
              * mScratchSpace[i].articulatedInertia * mJointsAndBodies[i].axis)
                 .value();
 
-    mScratchSpace[i].phi
-        = mScratchSpace[i].psi * mScratchSpace[i].articulatedInertia
-          * mJointsAndBodies[i].axis * mJointsAndBodies[i].axis.transpose()
-          * mScratchSpace[i].articulatedInertia;
-
     // Total force on the joint, see GenericJoint.hpp:2028 for DART equivalent
     // Inside GenericJoint::addChildBiasForceToDynamic()
     mScratchSpace[i].totalForce
@@ -92,7 +130,7 @@ void SimpleFeatherstone::forwardDynamics(
     // AIS = Articulated_Inertia_times_axiS
     Eigen::Vector6s AIS
         = mScratchSpace[i].articulatedInertia * mJointsAndBodies[i].axis;
-    Eigen::MatrixXs PI = mScratchSpace[i].articulatedInertia;
+    Eigen::Matrix6s PI = mScratchSpace[i].articulatedInertia;
     PI.noalias() -= AIS * mScratchSpace[i].psi * AIS.transpose();
     mScratchSpace[mJointsAndBodies[i].parentIndex].articulatedInertia
         += math::transformInertia(
@@ -137,6 +175,186 @@ void SimpleFeatherstone::forwardDynamics(
   }
 }
 
+// This computes the joint forces needed to produce the given accelerations,
+// using recursive Newton-Euler. Like forwardDynamics(), this ignores gravity.
+void SimpleFeatherstone::inverseDynamics(
+    s_t* pos,
+    s_t* vel,
+    s_t* accelerations,
+    /* OUT */ s_t* forces)
+{
+  updateTransforms(pos);
+
+  // Forward pass: velocities, accelerations and the force each body needs
+  for (int i = 0; i < len(); i++)
+  {
+    const JointAndBody& jointAndBody = mJointsAndBodies[i];
+    FeatherstoneScratchSpace& scratch = mScratchSpace[i];
+
+    Eigen::Vector6s jointVel = jointAndBody.axis * vel[i];
+    if (jointAndBody.parentIndex != -1)
+    {
+      const FeatherstoneScratchSpace& parent
+          = mScratchSpace[jointAndBody.parentIndex];
+      scratch.spatialVelocity
+          = math::AdInvT(scratch.transformFromParent, parent.spatialVelocity)
+            + jointVel;
+      scratch.spatialAcceleration
+          = math::AdInvT(
+                scratch.transformFromParent, parent.spatialAcceleration)
+            + jointAndBody.axis * accelerations[i]
+            + math::ad(scratch.spatialVelocity, jointVel);
+    }
+    else
+    {
+      scratch.spatialVelocity = jointVel;
+      scratch.spatialAcceleration
+          = jointAndBody.axis * accelerations[i]
+            + math::ad(scratch.spatialVelocity, jointVel);
+    }
+    scratch.spatialForce
+        = jointAndBody.inertia * scratch.spatialAcceleration
+          - math::dad(
+              scratch.spatialVelocity,
+              jointAndBody.inertia * scratch.spatialVelocity);
+  }
+
+  // Backward pass: project onto each joint, and pass the rest to the parent
+  for (int i = len() - 1; i >= 0; i--)
+  {
+    const JointAndBody& jointAndBody = mJointsAndBodies[i];
+    forces[i] = jointAndBody.axis.dot(mScratchSpace[i].spatialForce);
+    if (jointAndBody.parentIndex != -1)
+    {
+      mScratchSpace[jointAndBody.parentIndex].spatialForce += math::dAdInvT(
+          mScratchSpace[i].transformFromParent, mScratchSpace[i].spatialForce);
+    }
+  }
+}
+
+// This computes the Coriolis and centrifugal forces, which is inverse dynamics
+// with zero acceleration.
+void SimpleFeatherstone::coriolisForces(
+    s_t* pos, s_t* vel, /* OUT */ s_t* forces)
+{
+  std::vector<s_t> zero(len(), 0.0);
+  inverseDynamics(pos, vel, zero.data(), forces);
+}
+
+// This computes the generalized forces that gravity applies to each joint.
+// Gravity on a body is the same as the body being held still while the world
+// accelerates upwards, so this is inverse dynamics with zero velocity and
+// each body accelerating at -gravity, negated.
+void SimpleFeatherstone::gravityForces(
+    s_t* pos, const Eigen::Vector3s& gravity, /* OUT */ s_t* forces)
+{
+  updateWorldTransforms(pos);
+
+  for (int i = 0; i < len(); i++)
+  {
+    FeatherstoneScratchSpace& scratch = mScratchSpace[i];
+    Eigen::Vector6s lift = Eigen::Vector6s::Zero();
+    lift.tail<3>() = -(scratch.worldTransform.linear().transpose() * gravity);
+    scratch.spatialForce = mJointsAndBodies[i].inertia * lift;
+  }
+  for (int i = len() - 1; i >= 0; i--)
+  {
+    const JointAndBody& jointAndBody = mJointsAndBodies[i];
+    forces[i] = -jointAndBody.axis.dot(mScratchSpace[i].spatialForce);
+    if (jointAndBody.parentIndex != -1)
+    {
+      mScratchSpace[jointAndBody.parentIndex].spatialForce += math::dAdInvT(
+          mScratchSpace[i].transformFromParent, mScratchSpace[i].spatialForce);
+    }
+  }
+}
+
+// This computes the len() x len() joint-space mass matrix at the given
+// positions, using the composite rigid body algorithm. The output is written
+// column-major.
+void SimpleFeatherstone::massMatrix(s_t* pos, /* OUT */ s_t* massMatrix)
+{
+  const int n = len();
+  updateTransforms(pos);
+
+  for (int i = 0; i < n; i++)
+  {
+    mScratchSpace[i].compositeInertia = mJointsAndBodies[i].inertia;
+  }
+  for (int i = n - 1; i >= 0; i--)
+  {
+    if (mJointsAndBodies[i].parentIndex != -1)
+    {
+      mScratchSpace[mJointsAndBodies[i].parentIndex].compositeInertia
+          += math::transformInertia(
+              mScratchSpace[i].transformFromParent.inverse(),
+              mScratchSpace[i].compositeInertia);
+    }
+  }
+
+  Eigen::Map<Eigen::MatrixXs> M(massMatrix, n, n);
+  M.setZero();
+  for (int i = 0; i < n; i++)
+  {
+    Eigen::Vector6s F
+        = mScratchSpace[i].compositeInertia * mJointsAndBodies[i].axis;
+    M(i, i) = mJointsAndBodies[i].axis.dot(F);
+
+    // Walk up the tree to fill in the coupling with each ancestor
+    int j = i;
+    while (mJointsAndBodies[j].parentIndex != -1)
+    {
+      F = math::dAdInvT(mScratchSpace[j].transformFromParent, F);
+      j = mJointsAndBodies[j].parentIndex;
+      M(i, j) = mJointsAndBodies[j].axis.dot(F);
+      M(j, i) = M(i, j);
+    }
+  }
+}
+
+// This fills in mScratchSpace[i].transformFromParent for every joint
+void SimpleFeatherstone::updateTransforms(s_t* pos)
+{
+  for (int i = 0; i < len(); i++)
+  {
+    switch (mJointsAndBodies[i].jointType)
+    {
+      case REVOLUTE:
+        updateTransform<REVOLUTE>(
+            mJointsAndBodies[i], pos[i], mScratchSpace[i]);
+        break;
+      case PRISMATIC:
+        updateTransform<PRISMATIC>(
+            mJointsAndBodies[i], pos[i], mScratchSpace[i]);
+        break;
+      default:
+        updateTransform<SCREW>(mJointsAndBodies[i], pos[i], mScratchSpace[i]);
+        break;
+    }
+  }
+}
+
+// This fills in mScratchSpace[i].transformFromParent and
+// mScratchSpace[i].worldTransform for every joint
+void SimpleFeatherstone::updateWorldTransforms(s_t* pos)
+{
+  updateTransforms(pos);
+  for (int i = 0; i < len(); i++)
+  {
+    FeatherstoneScratchSpace& scratch = mScratchSpace[i];
+    if (mJointsAndBodies[i].parentIndex != -1)
+    {
+      scratch.worldTransform
+          = mScratchSpace[mJointsAndBodies[i].parentIndex].worldTransform
+            * scratch.transformFromParent;
+    }
+    else
+    {
+      scratch.worldTransform = scratch.transformFromParent;
+    }
+  }
+}
+
 // This gets the values from a DART skeleton to populate our Featherstone
 // implementation
 void SimpleFeatherstone::populateFromSkeleton(
@@ -157,6 +375,15 @@ void SimpleFeatherstone::populateFromSkeleton(
         = dof->getJoint()->getTransformFromParentBodyNode();
     jointAndBody.inertia
         = dof->getChildBodyNode()->getInertia().getSpatialTensor();
+    jointAndBody.jointType = SCREW;
+    if (jointAndBody.axis.tail<3>().isZero(0))
+    {
+      jointAndBody.jointType = REVOLUTE;
+    }
+    else if (jointAndBody.axis.head<3>().isZero(0))
+    {
+      jointAndBody.jointType = PRISMATIC;
+    }
     jointAndBody.parentIndex = -1;
     if (dof->getJoint()->getParentBodyNode() != nullptr)
     {
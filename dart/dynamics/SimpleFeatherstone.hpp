@@ -13,6 +13,19 @@ namespace dynamics {
 
 class Skeleton;
 
+// The kind of motion a joint's axis describes. Each kind gets its own
+// compile-time specialized kernel for the joint transform, so the common cases
+// don't pay for a general screw exponential.
+enum FeatherstoneJointType
+{
+  // A general screw motion, which goes through math::expMap()
+  SCREW = 0,
+  // The axis has no linear part, so the joint is a pure rotation
+  REVOLUTE = 1,
+  // The axis has no angular part, so the joint is a pure translation
+  PRISMATIC = 2
+};
+
 struct JointAndBody
 {
   // This is a normalized transform, represented in log-space. You can recover
@@ -27,6 +40,9 @@ struct JointAndBody
   // -1 indicates this is the root element, otherwise this is the index into
   // SimpleFeatherstone::mJointsAndBodies where the parent lives
   int parentIndex;
+  // This picks which kernel we use to compute the joint transform. SCREW is
+  // always correct, the others are faster special cases.
+  FeatherstoneJointType jointType = SCREW;
 };
 
 struct FeatherstoneScratchSpace
@@ -44,6 +60,13 @@ struct FeatherstoneScratchSpace
   s_t totalForce;
   Eigen::Vector6s partialAcceleration; // = eta
   Eigen::Matrix6s phi;
+
+  // Used by inverseDynamics() and massMatrix()
+  Eigen::Vector6s spatialForce;
+  Eigen::Matrix6s compositeInertia;
+
+  // Filled in by updateWorldTransforms()
+  Eigen::Isometry3s worldTransform;
 };
 
 class SimpleFeatherstone
@@ -64,11 +87,46 @@ public:
       s_t* force,
       /* OUT */ s_t* accelerations);
 
+  // This computes the joint forces needed to produce the given accelerations,
+  // using recursive Newton-Euler. Like forwardDynamics(), this ignores gravity.
+  // All the pointer arguments are assumed to point to arrays of length len()
+  void inverseDynamics(
+      s_t* pos,
+      s_t* vel,
+      s_t* accelerations,
+      /* OUT */ s_t* forces);
+
+  // This computes the Coriolis and centrifugal forces, which is inverse
+  // dynamics with zero acceleration. All the pointer arguments are assumed to
+  // point to arrays of length len()
+  void coriolisForces(s_t* pos, s_t* vel, /* OUT */ s_t* forces);
+
+  // This computes the generalized forces that gravity applies to each joint.
+  // This is what forwardDynamics() and inverseDynamics() leave out, so adding
+  // it to `force` before calling forwardDynamics() gives the motion under
+  // gravity. All the pointer arguments are assumed to point to arrays of
+  // length len()
+  void gravityForces(
+      s_t* pos, const Eigen::Vector3s& gravity, /* OUT */ s_t* forces);
+
+  // This computes the len() x len() joint-space mass matrix at the given
+  // positions, using the composite rigid body algorithm. The output is written
+  // column-major.
+  void massMatrix(s_t* pos, /* OUT */ s_t* massMatrix);
+
   // This gets the values from a DART skeleton to populate our Featherstone
   // implementation
   void populateFromSkeleton(
       const std::shared_ptr<dynamics::Skeleton>& skeleton);
 
+  // This fills in mScratchSpace[i].transformFromParent for every joint
+  void updateTransforms(s_t* pos);
+
+  // This fills in mScratchSpace[i].transformFromParent and
+  // mScratchSpace[i].worldTransform for every joint. This assumes the root
+  // joint's parent is the world.
+  void updateWorldTransforms(s_t* pos);
+
   // protected:
   std::vector<JointAndBody> mJointsAndBodies;
   std::vector<FeatherstoneScratchSpace> mScratchSpace;
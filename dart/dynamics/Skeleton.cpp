@@ -34,16 +34,23 @@
 
 #include <algorithm>
 #include <array>
+#include <functional>
+#include <future>
 #include <limits>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include <Eigen/SparseCore>
+#include <Eigen/SparseLU>
+
 #include "dart/common/Console.hpp"
 #include "dart/common/Deprecated.hpp"
 #include "dart/common/StlHelpers.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/CompiledSkeleton.hpp"
 #include "dart/dynamics/CustomJoint.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/EndEffector.hpp"
@@ -55,12 +62,15 @@
 #include "dart/dynamics/PointMass.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
+#include "dart/dynamics/SkeletonArena.hpp"
 #include "dart/dynamics/SoftBodyNode.hpp"
 #include "dart/math/FiniteDifference.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/SupportHull.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
 
 #define SET_ALL_FLAGS(X)                                                       \
   for (auto& cache : mTreeCache)                                               \
@@ -447,6 +457,8 @@ Skeleton::~Skeleton()
 {
   for (BodyNode* bn : mSkelCache.mBodyNodes)
     delete bn;
+  if (mArena != nullptr)
+    mArena->release();
 }
 
 //==============================================================================
@@ -470,7 +482,12 @@ SkeletonPtr Skeleton::cloneSkeleton() const
 //==============================================================================
 SkeletonPtr Skeleton::cloneSkeleton(const std::string& cloneName) const
 {
+  // Clones copy inertia and shapes as they are, so those need to be current
+  ensureScalesApplied();
+
   SkeletonPtr skelClone = Skeleton::create(cloneName);
+  skelClone->setCompactStorage(getCompactStorage());
+  SkeletonArena::Scope arenaScope(skelClone->mArena);
 
   for (std::size_t i = 0; i < getNumBodyNodes(); ++i)
   {
@@ -516,6 +533,8 @@ SkeletonPtr Skeleton::cloneSkeleton(const std::string& cloneName) const
   skelClone->setProperties(getAspectProperties());
   skelClone->setName(cloneName);
   skelClone->setState(getState());
+  // The BodyNodes were cloned in order, so the indices still line up
+  skelClone->mSelfCollisionPairBits = mSelfCollisionPairBits;
 
   // Fix mimic joint references
   for (std::size_t i = 0; i < getNumJoints(); ++i)
@@ -815,6 +834,132 @@ bool Skeleton::isEnabledAdjacentBodyCheck() const
   return getAdjacentBodyCheck();
 }
 
+//==============================================================================
+bool Skeleton::areBodyNodesAdjacent(std::size_t i, std::size_t j) const
+{
+  const std::size_t wordsPerRow = (getNumBodyNodes() + 63) / 64;
+  assert(mAdjacentBodyBits.size() == getNumBodyNodes() * wordsPerRow);
+  return (mAdjacentBodyBits[i * wordsPerRow + j / 64] >> (j % 64)) & 1u;
+}
+
+//==============================================================================
+void Skeleton::computeSelfCollisionPairs(int numSamples, s_t margin)
+{
+  const std::size_t numBodies = getNumBodyNodes();
+  const std::size_t wordsPerRow = (numBodies + 63) / 64;
+  std::vector<std::uint64_t> bits(numBodies * wordsPerRow, 0u);
+
+  const Eigen::VectorXs originalPositions = getPositions();
+  Eigen::VectorXs lower = getPositionLowerLimits();
+  Eigen::VectorXs upper = getPositionUpperLimits();
+  for (int i = 0; i < getNumDofs(); i++)
+  {
+    if (!std::isfinite(lower(i)))
+      lower(i) = originalPositions(i) - M_PI;
+    if (!std::isfinite(upper(i)))
+      upper(i) = originalPositions(i) + M_PI;
+  }
+
+  std::vector<Eigen::Vector3s> mins(numBodies);
+  std::vector<Eigen::Vector3s> maxs(numBodies);
+  std::vector<bool> hasShapes(numBodies);
+  for (int sample = 0; sample <= numSamples; sample++)
+  {
+    // Sample 0 is the current pose
+    if (sample > 0)
+    {
+      Eigen::VectorXs t
+          = (Eigen::VectorXs::Random(getNumDofs()).array() + 1.0) * 0.5;
+      setPositions(lower + t.cwiseProduct(upper - lower));
+    }
+
+    for (std::size_t i = 0; i < numBodies; i++)
+    {
+      const BodyNode* body = getBodyNode(i);
+      hasShapes[i] = false;
+      for (const ShapeNode* shapeNode :
+           body->getShapeNodesWith<CollisionAspect>())
+      {
+        const math::BoundingBox& box = shapeNode->getShape()->getBoundingBox();
+        const Eigen::Isometry3s& T = shapeNode->getWorldTransform();
+        const Eigen::Vector3s center = T * box.computeCenter();
+        const Eigen::Vector3s halfExtents
+            = T.linear().cwiseAbs() * box.computeHalfExtents().cwiseAbs()
+              + Eigen::Vector3s::Constant(margin);
+        if (!hasShapes[i])
+        {
+          mins[i] = center - halfExtents;
+          maxs[i] = center + halfExtents;
+          hasShapes[i] = true;
+        }
+        else
+        {
+          mins[i] = mins[i].cwiseMin(center - halfExtents);
+          maxs[i] = maxs[i].cwiseMax(center + halfExtents);
+        }
+      }
+    }
+
+    for (std::size_t i = 0; i < numBodies; i++)
+    {
+      if (!hasShapes[i])
+        continue;
+      for (std::size_t j = i + 1; j < numBodies; j++)
+      {
+        if (!hasShapes[j]
+            || ((bits[i * wordsPerRow + j / 64] >> (j % 64)) & 1u))
+          continue;
+        if ((mins[i].array() <= maxs[j].array()).all()
+            && (mins[j].array() <= maxs[i].array()).all())
+        {
+          bits[i * wordsPerRow + j / 64] |= std::uint64_t(1) << (j % 64);
+          bits[j * wordsPerRow + i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+      }
+    }
+  }
+
+  setPositions(originalPositions);
+  mSelfCollisionPairBits = bits;
+}
+
+//==============================================================================
+void Skeleton::clearSelfCollisionPairs()
+{
+  mSelfCollisionPairBits.clear();
+}
+
+//==============================================================================
+bool Skeleton::hasSelfCollisionPairs() const
+{
+  return !mSelfCollisionPairBits.empty();
+}
+
+//==============================================================================
+bool Skeleton::canBodyNodesSelfCollide(std::size_t i, std::size_t j) const
+{
+  if (mSelfCollisionPairBits.empty())
+    return true;
+  const std::size_t wordsPerRow = (getNumBodyNodes() + 63) / 64;
+  return (mSelfCollisionPairBits[i * wordsPerRow + j / 64] >> (j % 64)) & 1u;
+}
+
+//==============================================================================
+std::vector<std::pair<std::size_t, std::size_t>>
+Skeleton::getSelfCollisionPairs() const
+{
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  for (std::size_t i = 0; i < getNumBodyNodes(); i++)
+  {
+    for (std::size_t j = i + 1; j < getNumBodyNodes(); j++)
+    {
+      if (canBodyNodesSelfCollide(i, j))
+        pairs.emplace_back(i, j);
+    }
+  }
+  return pairs;
+}
+
 //==============================================================================
 void Skeleton::setMobile(bool _isMobile)
 {
@@ -1127,11 +1272,16 @@ Joint* Skeleton::getJoint(std::size_t _idx)
 // Gets the index in the skeleton where this joint lives
 int Skeleton::getJointIndex(const Joint* joint)
 {
-  for (int i = 0; i < getNumJoints(); i++)
-  {
-    if (getJoint(i) == joint)
-      return i;
-  }
+  // Every joint is the parent joint of exactly one BodyNode, and shares its
+  // index, so there's no need to search
+  if (joint == nullptr)
+    return -1;
+  const BodyNode* child = joint->getChildBodyNode();
+  if (child == nullptr)
+    return -1;
+  std::size_t index = child->getIndexInSkeleton();
+  if (index < getNumBodyNodes() && getBodyNode(index) == child)
+    return index;
   return -1;
 }
 
@@ -1638,6 +1788,60 @@ const Eigen::MatrixXi& Skeleton::getJointParentMap()
   return mSkelCache.mJointParentMap;
 }
 
+//==============================================================================
+/// This returns the KinematicsContext for the current pose and scales. It's
+/// built on first use, and reused by every later query until something
+/// (setPositions(), setScale(), ...) moves a body in this skeleton.
+const Skeleton::KinematicsContext& Skeleton::getKinematicsContext() const
+{
+  KinematicsContext& context = mSkelCache.mKinematicsContext;
+  const int numDofs = getNumDofs();
+  const int numBodies = getNumBodyNodes();
+  // The size checks catch structural changes, which don't dirty transforms on
+  // bodies that already existed
+  if (mSkelCache.mDirty.mKinematicsContext
+      || context.dofScrews.size() != numDofs
+      || context.bodyDependsOnDof.rows() != numBodies)
+  {
+    context.dofJoints.resize(numDofs);
+    context.dofIndexInJoint.resize(numDofs);
+    context.dofJointIndices.resize(numDofs);
+    context.dofScrews.resize(numDofs);
+    for (int i = 0; i < numDofs; i++)
+    {
+      const DegreeOfFreedom* dof = getDof(i);
+      context.dofJoints[i] = const_cast<Joint*>(dof->getJoint());
+      context.dofIndexInJoint[i] = dof->getIndexInJoint();
+      context.dofJointIndices[i]
+          = context.dofJoints[i]->getJointIndexInSkeleton();
+      context.dofScrews[i]
+          = context.dofJoints[i]->getWorldAxisScrewForPosition(
+              context.dofIndexInJoint[i]);
+    }
+
+    context.bodyDependsOnDof = Eigen::MatrixXi::Zero(numBodies, numDofs);
+    for (int b = 0; b < numBodies; b++)
+    {
+      const BodyNode* body = getBodyNode(b);
+      // Leaving every transform clean is what lets BodyNode::dirtyTransform()
+      // safely skip re-dirtying us when it returns early
+      body->getWorldTransform();
+      for (const BodyNode* cursor = body; cursor != nullptr;
+           cursor = cursor->getParentBodyNode())
+      {
+        const Joint* joint = cursor->getParentJoint();
+        for (int k = 0; k < joint->getNumDofs(); k++)
+        {
+          context.bodyDependsOnDof(b, joint->getIndexInSkeleton(k)) = 1;
+        }
+      }
+    }
+
+    mSkelCache.mDirty.mKinematicsContext = false;
+  }
+  return context;
+}
+
 //==============================================================================
 DART_BAKE_SPECIALIZED_NODE_SKEL_DEFINITIONS(Skeleton, Marker)
 
@@ -1681,6 +1885,19 @@ Eigen::MatrixXs Skeleton::getJacobianOfC(neural::WithRespectTo* wrt)
       wrt == neural::WithRespectTo::POSITION
       || wrt == neural::WithRespectTo::VELOCITY)
   {
+    if (std::shared_ptr<CompiledSkeletonDynamics> compiled
+        = getCompiledDynamics())
+    {
+      ensureScalesApplied();
+      compiled->computeJacobianOfID(
+          this,
+          Eigen::VectorXs::Zero(dofs),
+          true,
+          wrt == neural::WithRespectTo::VELOCITY,
+          DCg_Dp);
+      return DCg_Dp;
+    }
+
     std::vector<BodyNode*>& bodyNodes = mSkelCache.mBodyNodes;
 
 #ifdef DART_DEBUG_ANALYTICAL_DERIV
@@ -1705,6 +1922,12 @@ Eigen::MatrixXs Skeleton::getJacobianOfC(neural::WithRespectTo* wrt)
 
     return DCg_Dp;
   }
+  else if (
+      auto* massWrt = dynamic_cast<neural::WithRespectToMass*>(wrt))
+  {
+    return getJacobianOfIDWrtInertia(
+        Eigen::VectorXs::Zero(dofs), massWrt, true);
+  }
   else
   {
     return finiteDifferenceJacobianOfC(wrt);
@@ -1725,6 +1948,14 @@ Eigen::MatrixXs Skeleton::getJacobianOfM(
   }
   else if (wrt == neural::WithRespectTo::POSITION)
   {
+    if (std::shared_ptr<CompiledSkeletonDynamics> compiled
+        = getCompiledDynamics())
+    {
+      ensureScalesApplied();
+      compiled->computeJacobianOfID(this, x, false, false, DM_Dq);
+      return DM_Dq;
+    }
+
     const auto old_ddq = getAccelerations();
     setAccelerations(x);
 
@@ -1745,13 +1976,79 @@ Eigen::MatrixXs Skeleton::getJacobianOfM(
 
     return DM_Dq;
   }
+  else if (
+      auto* massWrt = dynamic_cast<neural::WithRespectToMass*>(wrt))
+  {
+    return getJacobianOfIDWrtInertia(x, massWrt, false);
+  }
   else
   {
-    // other than pos/vel/force such as mass
     return finiteDifferenceJacobianOfM(x, wrt);
   }
 }
 
+//==============================================================================
+Eigen::MatrixXs Skeleton::getJacobianOfIDWrtInertia(
+    const Eigen::VectorXs& ddq,
+    neural::WithRespectToMass* wrt,
+    bool includeBiasForces)
+{
+  const Eigen::VectorXs& dq = getVelocities();
+  Eigen::MatrixXs J = Eigen::MatrixXs::Zero(getNumDofs(), wrt->dim(this));
+  common::aligned_vector<Eigen::Matrix6s> dG;
+
+  int col = 0;
+  for (neural::WrtMassBodyNodyEntry& entry : wrt->getEntries(this))
+  {
+    BodyNode* node = getBodyNode(entry.linkName);
+    entry.getSpatialTensorGradients(this, dG);
+
+    // Each body contributes J^T (G * A - dad(V, G * V)) to the inverse
+    // dynamics, where A already folds in gravity. That's linear in G, so we
+    // get the column for each parameter by swapping dG in for G.
+    const std::vector<std::size_t>& indices
+        = node->getDependentGenCoordIndices();
+    const math::Jacobian& Jb = node->getJacobian();
+    Eigen::VectorXs localDdq(indices.size());
+    Eigen::VectorXs localDq(indices.size());
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+      localDdq(i) = ddq(indices[i]);
+      localDq(i) = dq(indices[i]);
+    }
+
+    Eigen::Vector6s A = Jb * localDdq;
+    Eigen::Vector6s V = Eigen::Vector6s::Zero();
+    if (includeBiasForces)
+    {
+      A += node->getJacobianSpatialDeriv() * localDq;
+      if (node->getGravityMode())
+      {
+        A -= math::AdInvRLinear(node->getWorldTransform(), getGravity());
+      }
+      V = node->getSpatialVelocity();
+    }
+
+    for (std::size_t k = 0; k < dG.size(); k++)
+    {
+      Eigen::Vector6s F = dG[k] * A;
+      if (includeBiasForces)
+      {
+        F -= math::dad(V, dG[k] * V);
+      }
+      Eigen::VectorXs tau = Jb.transpose() * F;
+      for (std::size_t i = 0; i < indices.size(); i++)
+      {
+        J(indices[i], col + k) += tau(i);
+      }
+    }
+    col += dG.size();
+  }
+  assert(col == J.cols());
+
+  return J;
+}
+
 //==============================================================================
 Eigen::MatrixXs Skeleton::getJacobianOfID(
     const Eigen::VectorXs& x, neural::WithRespectTo* wrt)
@@ -1940,7 +2237,9 @@ Eigen::MatrixXs Skeleton::getJacobianOfMinv_ID(
     const int dofs = static_cast<int>(getNumDofs());
     return Eigen::MatrixXs::Zero(dofs, dofs);
   }
-  else if (wrt == neural::WithRespectTo::POSITION)
+  else if (
+      wrt == neural::WithRespectTo::POSITION
+      || dynamic_cast<neural::WithRespectToMass*>(wrt) != nullptr)
   {
     const Eigen::MatrixXs& Minv = getInvMassMatrix();
     const Eigen::MatrixXs& DMddq_Dq = getJacobianOfM(Minv * f, wrt);
@@ -2101,6 +2400,18 @@ Eigen::MatrixXs Skeleton::getJacobianOfFD(neural::WithRespectTo* wrt)
   const auto& spring_force = getSpringForce();
   const auto& damping_force = getDampingForce();
 
+  if (wrt == neural::WithRespectTo::POSITION)
+  {
+    // d/dq M^{-1}f - M^{-1} dC/dq = -M^{-1} (d/dq (M ddq) + dC/dq), at
+    // ddq = M^{-1}f, so one fused sweep covers both terms
+    DynamicsJacobians jacobians;
+    computeDynamicsJacobians(
+        Minv * (tau - Cg - damping_force - spring_force), jacobians);
+    return -Minv
+           * (jacobians.dMddq_dq + jacobians.dC_dq
+              + getJacobianOfDampSpring(wrt));
+  }
+
   const auto& DMinv_Dp
       = getJacobianOfMinv(tau - Cg - damping_force - spring_force, wrt);
   const auto& DC_Dp = getJacobianOfC(wrt);
@@ -2117,17 +2428,17 @@ Eigen::MatrixXs Skeleton::getUnconstrainedVelJacobianWrt(
   Eigen::VectorXs C = getCoriolisAndGravityForces() - getExternalForces();
 
   Eigen::MatrixXs Minv = getInvMassMatrix();
-  Eigen::MatrixXs dC = getJacobianOfC(wrt);
 
   if (wrt == neural::WithRespectTo::POSITION)
   {
-    Eigen::MatrixXs dM = getJacobianOfMinv(
-        dt * (tau - C - getDampingForce() - getSpringForce()), wrt);
-    return dM - Minv * dt * dC;
+    DynamicsJacobians jacobians;
+    computeDynamicsJacobians(
+        Minv * (tau - C - getDampingForce() - getSpringForce()), jacobians);
+    return -dt * Minv * (jacobians.dMddq_dq + jacobians.dC_dq);
   }
   else
   {
-    return -Minv * dt * dC;
+    return -Minv * dt * getJacobianOfC(wrt);
   }
 }
 
@@ -2139,6 +2450,48 @@ Eigen::MatrixXs Skeleton::getVelCJacobian()
   return getJacobianOfC(neural::WithRespectTo::VELOCITY);
 }
 
+//==============================================================================
+void Skeleton::computeDynamicsJacobians(
+    const Eigen::VectorXs& ddq, DynamicsJacobians& jacobians)
+{
+  const int dofs = static_cast<int>(getNumDofs());
+  jacobians.dMddq_dq.setZero(dofs, dofs);
+  jacobians.dC_dq.setZero(dofs, dofs);
+  jacobians.dC_dv.setZero(dofs, dofs);
+  if (dofs == 0)
+    return;
+
+  if (std::shared_ptr<CompiledSkeletonDynamics> compiled
+      = getCompiledDynamics())
+  {
+    ensureScalesApplied();
+    const Eigen::VectorXs zero = Eigen::VectorXs::Zero(dofs);
+    compiled->computeJacobianOfID(this, ddq, false, false, jacobians.dMddq_dq);
+    compiled->computeJacobianOfID(this, zero, true, false, jacobians.dC_dq);
+    compiled->computeJacobianOfID(this, zero, true, true, jacobians.dC_dv);
+    return;
+  }
+
+  const auto old_ddq = getAccelerations();
+  setAccelerations(ddq);
+
+  std::vector<BodyNode*>& bodyNodes = mSkelCache.mBodyNodes;
+  for (BodyNode* bodyNode : bodyNodes)
+  {
+    bodyNode->computeDynamicsJacobiansForward();
+  }
+  for (int i = bodyNodes.size() - 1; i >= 0; i--)
+  {
+    bodyNodes[i]->computeDynamicsJacobiansBackward(
+        jacobians.dMddq_dq,
+        jacobians.dC_dq,
+        jacobians.dC_dv,
+        mAspectProperties.mGravity);
+  }
+
+  setAccelerations(old_ddq);
+}
+
 #ifdef DART_DEBUG_ANALYTICAL_DERIV
 //==============================================================================
 void Skeleton::DiffC::Data::init()
@@ -2246,26 +2599,26 @@ Eigen::MatrixXs Skeleton::finiteDifferenceJacobianOfM(
   Eigen::VectorXs originalWrt = wrt->get(this);
 
   s_t eps = useRidders ? 1e-3 : 5e-7;
-  math::finiteDifference(
-      [&](/* in*/ s_t eps,
-          /* in*/ int dof,
-          /*out*/ Eigen::VectorXs& perturbed) {
-        Eigen::VectorXs tweakedWrt = originalWrt;
-        tweakedWrt(dof) += eps;
-        wrt->set(this, tweakedWrt);
-        mSkelCache.mDirty.mMassMatrix = true;
-        perturbed = getMassMatrix() * x;
-        return true;
+  // Each worker perturbs its own clone, so we never touch our own state
+  math::finiteDifferenceParallel(
+      [&]() -> std::function<bool(s_t, int, Eigen::VectorXs&)> {
+        SkeletonPtr clone = cloneSkeleton();
+        return [clone, wrt, originalWrt, &x](
+                   /* in*/ s_t eps,
+                   /* in*/ int dof,
+                   /*out*/ Eigen::VectorXs& perturbed) {
+          Eigen::VectorXs tweakedWrt = originalWrt;
+          tweakedWrt(dof) += eps;
+          wrt->set(clone.get(), tweakedWrt);
+          clone->mSkelCache.mDirty.mMassMatrix = true;
+          perturbed = clone->getMassMatrix() * x;
+          return true;
+        };
       },
       result,
       eps,
       useRidders);
 
-  // Reset everything how we left it
-  wrt->set(this, originalWrt);
-  mSkelCache.mDirty.mMassMatrix = true;
-  getMassMatrix();
-
   return result;
 }
 
@@ -2279,23 +2632,26 @@ Eigen::MatrixXs Skeleton::finiteDifferenceJacobianOfC(
   Eigen::VectorXs originalWrt = wrt->get(this);
 
   s_t eps = useRidders ? 1e-3 : 1e-7;
-  math::finiteDifference(
-      [&](/* in*/ s_t eps,
-          /* in*/ int dof,
-          /*out*/ Eigen::VectorXs& perturbed) {
-        Eigen::VectorXs tweakedWrt = originalWrt;
-        tweakedWrt(dof) += eps;
-        wrt->set(this, tweakedWrt);
-        perturbed = getCoriolisAndGravityForces() - getExternalForces();
-        return true;
+  // Each worker perturbs its own clone, so we never touch our own state
+  math::finiteDifferenceParallel(
+      [&]() -> std::function<bool(s_t, int, Eigen::VectorXs&)> {
+        SkeletonPtr clone = cloneSkeleton();
+        return [clone, wrt, originalWrt](
+                   /* in*/ s_t eps,
+                   /* in*/ int dof,
+                   /*out*/ Eigen::VectorXs& perturbed) {
+          Eigen::VectorXs tweakedWrt = originalWrt;
+          tweakedWrt(dof) += eps;
+          wrt->set(clone.get(), tweakedWrt);
+          perturbed = clone->getCoriolisAndGravityForces()
+                      - clone->getExternalForces();
+          return true;
+        };
       },
       result,
       eps,
       useRidders);
 
-  // Reset everything how we left it
-  wrt->set(this, originalWrt);
-
   return result;
 }
 
@@ -2308,29 +2664,28 @@ Eigen::MatrixXs Skeleton::finiteDifferenceJacobianOfID(
   Eigen::MatrixXs result(n, m);
   Eigen::VectorXs originalWrt = wrt->get(this);
 
-  const Eigen::VectorXs old_ddq = getAccelerations();
-  setAccelerations(f);
-
   s_t eps = useRidders ? 1e-3 : 5e-7;
-  math::finiteDifference(
-      [&](/* in*/ s_t eps,
-          /* in*/ int dof,
-          /*out*/ Eigen::VectorXs& perturbed) {
-        Eigen::VectorXs tweakedWrt = originalWrt;
-        tweakedWrt(dof) += eps;
-        wrt->set(this, tweakedWrt);
-        computeInverseDynamics();
-        perturbed = getControlForces();
-        return true;
+  // Each worker perturbs its own clone, so we never touch our own state
+  math::finiteDifferenceParallel(
+      [&]() -> std::function<bool(s_t, int, Eigen::VectorXs&)> {
+        SkeletonPtr clone = cloneSkeleton();
+        clone->setAccelerations(f);
+        return [clone, wrt, originalWrt](
+                   /* in*/ s_t eps,
+                   /* in*/ int dof,
+                   /*out*/ Eigen::VectorXs& perturbed) {
+          Eigen::VectorXs tweakedWrt = originalWrt;
+          tweakedWrt(dof) += eps;
+          wrt->set(clone.get(), tweakedWrt);
+          clone->computeInverseDynamics();
+          perturbed = clone->getControlForces();
+          return true;
+        };
       },
       result,
       eps,
       useRidders);
 
-  // Reset everything how we left it
-  wrt->set(this, originalWrt);
-  setAccelerations(old_ddq);
-
   return result;
 }
 
@@ -2344,23 +2699,25 @@ Eigen::MatrixXs Skeleton::finiteDifferenceJacobianOfMinv(
   Eigen::VectorXs originalWrt = wrt->get(this);
 
   s_t eps = useRidders ? 1e-3 : 5e-7;
-  math::finiteDifference(
-      [&](/* in*/ s_t eps,
-          /* in*/ int dof,
-          /*out*/ Eigen::VectorXs& perturbed) {
-        Eigen::VectorXs tweakedWrt = originalWrt;
-        tweakedWrt(dof) += eps;
-        wrt->set(this, tweakedWrt);
-        perturbed = multiplyByImplicitInvMassMatrix(f);
-        return true;
+  // Each worker perturbs its own clone, so we never touch our own state
+  math::finiteDifferenceParallel(
+      [&]() -> std::function<bool(s_t, int, Eigen::VectorXs&)> {
+        SkeletonPtr clone = cloneSkeleton();
+        return [clone, wrt, originalWrt, &f](
+                   /* in*/ s_t eps,
+                   /* in*/ int dof,
+                   /*out*/ Eigen::VectorXs& perturbed) {
+          Eigen::VectorXs tweakedWrt = originalWrt;
+          tweakedWrt(dof) += eps;
+          wrt->set(clone.get(), tweakedWrt);
+          perturbed = clone->multiplyByImplicitInvMassMatrix(f);
+          return true;
+        };
       },
       result,
       eps,
       useRidders);
 
-  // Reset everything how we left it
-  wrt->set(this, originalWrt);
-
   return result;
 }
 
@@ -2568,8 +2925,20 @@ Eigen::VectorXs Skeleton::finiteDifferenceGradientOfHeightWrtBodyScales(
 std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
 Skeleton::getLowestPointMarkers(Eigen::Vector3s up)
 {
-  s_t minUp = std::numeric_limits<s_t>::infinity();
-  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> minMarkers;
+  // The lowest vertex on a mesh is always a vertex of its convex hull, and the
+  // (cached) SupportHull can find the furthest hull vertex along a direction
+  // without scanning the mesh. So we first find each shape's lowest point with
+  // one support query, and only scan the hull vertices of the shapes that come
+  // within a hair of the overall minimum, to collect any tied markers.
+  struct Candidate
+  {
+    dynamics::BodyNode* node;
+    const dynamics::ShapeNode* shapeNode;
+    std::shared_ptr<const math::SupportHull> hull;
+    s_t lowest;
+  };
+  std::vector<Candidate> candidates;
+  s_t minLowest = std::numeric_limits<s_t>::infinity();
 
   for (int i = 0; i < getNumBodyNodes(); i++)
   {
@@ -2582,22 +2951,20 @@ Skeleton::getLowestPointMarkers(Eigen::Vector3s up)
       {
         dynamics::MeshShape* mesh
             = static_cast<dynamics::MeshShape*>(shape.get());
-        for (Eigen::Vector3s rawVertex : mesh->getVertices())
-        {
-          Eigen::Vector3s vertex = node->getScale().cwiseProduct(rawVertex);
-          Eigen::Vector3s worldVertex = shapeNode->getWorldTransform() * vertex;
-          s_t upDist = up.dot(worldVertex);
-          if (upDist < minUp)
-          {
-            minUp = upDist;
-            minMarkers.clear();
-          }
-          if (upDist <= minUp)
-          {
-            minMarkers.emplace_back(
-                node, node->getWorldTransform().inverse() * worldVertex);
-          }
-        }
+        std::shared_ptr<const math::SupportHull> hull = mesh->getSupportHull();
+        if (hull == nullptr || hull->getVertices().empty())
+          continue;
+
+        // up.dot(T * (scale .* v)) == (scale .* (R^T up)).dot(v) + up.dot(p)
+        const Eigen::Isometry3s& T = shapeNode->getWorldTransform();
+        Eigen::Vector3s down
+            = -node->getScale().cwiseProduct(T.linear().transpose() * up);
+        int support = hull->findSupport(down);
+        s_t lowest = up.dot(
+            T * node->getScale().cwiseProduct(hull->getVertices()[support]));
+
+        candidates.push_back({node, shapeNode, hull, lowest});
+        minLowest = std::min(minLowest, lowest);
       }
       else
       {
@@ -2611,6 +2978,37 @@ Skeleton::getLowestPointMarkers(Eigen::Vector3s up)
     }
   }
 
+  // The support query works in the mesh frame, so its answer can round
+  // differently from the world-frame heights we compare below
+  const s_t slack = 1e-9 * std::max((s_t)1.0, std::abs(minLowest));
+
+  s_t minUp = std::numeric_limits<s_t>::infinity();
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> minMarkers;
+  for (const Candidate& candidate : candidates)
+  {
+    if (candidate.lowest > minLowest + slack)
+      continue;
+
+    dynamics::BodyNode* node = candidate.node;
+    for (const Eigen::Vector3s& rawVertex : candidate.hull->getVertices())
+    {
+      Eigen::Vector3s vertex = node->getScale().cwiseProduct(rawVertex);
+      Eigen::Vector3s worldVertex
+          = candidate.shapeNode->getWorldTransform() * vertex;
+      s_t upDist = up.dot(worldVertex);
+      if (upDist < minUp)
+      {
+        minUp = upDist;
+        minMarkers.clear();
+      }
+      if (upDist <= minUp)
+      {
+        minMarkers.emplace_back(
+            node, node->getWorldTransform().inverse() * worldVertex);
+      }
+    }
+  }
+
   return minMarkers;
 }
 
@@ -2733,6 +3131,65 @@ Eigen::VectorXs Skeleton::finiteDifferenceGradientOfLowestPointWrtJoints(
   return result;
 }
 
+//==============================================================================
+/// This returns, for each marker, the squared distance to the closest mesh
+/// vertex on the body it's attached to, measured in that body's local frame.
+Eigen::VectorXs Skeleton::getDistToClosestVerticesToMarkers(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+        markers)
+{
+  Eigen::VectorXs dists = Eigen::VectorXs::Zero(markers.size());
+  for (int i = 0; i < markers.size(); i++)
+  {
+    dists(i)
+        = markers[i].first->getDistToClosestVerticesToMarker(markers[i].second);
+  }
+  return dists;
+}
+
+//==============================================================================
+/// This returns the Jacobian of getDistToClosestVerticesToMarkers() with
+/// respect to the concatenated marker offsets
+Eigen::MatrixXs
+Skeleton::getGradientOfDistToClosestVerticesToMarkersWrtMarkers(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+        markers)
+{
+  Eigen::MatrixXs jac
+      = Eigen::MatrixXs::Zero(markers.size(), markers.size() * 3);
+  for (int i = 0; i < markers.size(); i++)
+  {
+    jac.block<1, 3>(i, i * 3)
+        = markers[i]
+              .first
+              ->getGradientOfDistToClosestVerticesToMarkerWrtMarker(
+                  markers[i].second)
+              .transpose();
+  }
+  return jac;
+}
+
+//==============================================================================
+/// This returns the Jacobian of getDistToClosestVerticesToMarkers() with
+/// respect to the body scales
+Eigen::MatrixXs
+Skeleton::getGradientOfDistToClosestVerticesToMarkersWrtBodyScales(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+        markers)
+{
+  Eigen::MatrixXs jac
+      = Eigen::MatrixXs::Zero(markers.size(), getNumBodyNodes() * 3);
+  for (int i = 0; i < markers.size(); i++)
+  {
+    dynamics::BodyNode* node = markers[i].first;
+    jac.block<1, 3>(i, node->getIndexInSkeleton() * 3)
+        = node->getGradientOfDistToClosestVerticesToMarkerWrtBodyScale(
+                  markers[i].second)
+              .transpose();
+  }
+  return jac;
+}
+
 //==============================================================================
 /// This gets a random pose that's valid within joint limits
 Eigen::VectorXs Skeleton::getRandomPose()
@@ -3380,6 +3837,106 @@ void Skeleton::setBodyScales(Eigen::VectorXs scales)
   }
 }
 
+//==============================================================================
+void Skeleton::setDeferScaleUpdates(bool defer)
+{
+  mDeferScaleUpdates = defer;
+  if (!defer)
+    applyDeferredScales();
+}
+
+//==============================================================================
+bool Skeleton::getDeferScaleUpdates() const
+{
+  return mDeferScaleUpdates;
+}
+
+//==============================================================================
+void Skeleton::applyDeferredScales() const
+{
+  // Clear the flag first, since applying the scales goes through setInertia(),
+  // which calls back into getters that check it
+  mHasDeferredScales = false;
+  for (std::size_t i = 0; i < getNumBodyNodes(); i++)
+  {
+    const_cast<BodyNode*>(getBodyNode(i))->applyDeferredScale();
+  }
+}
+
+//==============================================================================
+void Skeleton::setParallelDynamics(bool parallel)
+{
+  mParallelDynamics = parallel;
+}
+
+//==============================================================================
+bool Skeleton::getParallelDynamics() const
+{
+  return mParallelDynamics;
+}
+
+//==============================================================================
+void Skeleton::setCompactStorage(bool compact)
+{
+  if (compact == getCompactStorage())
+    return;
+  if (compact)
+  {
+    mArena = SkeletonArena::create();
+  }
+  else
+  {
+    // Objects already in the arena keep it alive until they're deleted
+    mArena->release();
+    mArena = nullptr;
+  }
+}
+
+//==============================================================================
+bool Skeleton::getCompactStorage() const
+{
+  return mArena != nullptr;
+}
+
+//==============================================================================
+void Skeleton::setCompiledDynamicsEnabled(bool enabled)
+{
+  mCompiledDynamicsEnabled = enabled;
+  mSkelCache.mDirty.mMassMatrix = true;
+  mSkelCache.mDirty.mCoriolisAndGravityForces = true;
+}
+
+//==============================================================================
+bool Skeleton::getCompiledDynamicsEnabled() const
+{
+  return mCompiledDynamicsEnabled;
+}
+
+//==============================================================================
+std::shared_ptr<CompiledSkeletonDynamics> Skeleton::getCompiledDynamics() const
+{
+  if (!mCompiledDynamicsEnabled)
+    return nullptr;
+
+  const std::size_t version = CompiledSkeletonDynamics::getRegistryVersion();
+  if (mCompiledDynamicsVersion != version + 1)
+  {
+    mCompiledDynamics = nullptr;
+    const std::string signature = CompiledSkeletonDynamics::getSignature(this);
+    if (!signature.empty())
+      mCompiledDynamics = CompiledSkeletonDynamics::find(signature);
+    mCompiledDynamicsVersion = version + 1;
+  }
+  return mCompiledDynamics;
+}
+
+//==============================================================================
+void Skeleton::ensureScalesApplied() const
+{
+  if (mHasDeferredScales)
+    applyDeferredScales();
+}
+
 //==============================================================================
 // This sets all the positions of the joints to within their limit range, if
 // they're currently outside it.
@@ -4073,6 +4630,169 @@ Skeleton::finiteDifferenceMarkerWorldPositionsJacobianWrtGroupScales(
   return jac;
 }
 
+//==============================================================================
+/// This is getJointWorldPositionsJacobianWrtGroupScales(), but sparse. Each
+/// joint only moves with the scales of the bodies above it in the tree, so
+/// this only visits those, rather than every body for every joint.
+Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+Skeleton::getJointWorldPositionsJacobianWrtGroupScalesSparse(
+    const std::vector<dynamics::Joint*>& joints)
+{
+  std::vector<int> groupIndex = getGroupScaleIndexForBodyScales();
+  std::vector<Eigen::Triplet<s_t>> triplets;
+
+  for (int j = 0; j < joints.size(); j++)
+  {
+    // Walk up from the joint, where each body on the way moves everything
+    // below it by its scaled offsets to the joint above it and the joint
+    // below it
+    const dynamics::Joint* childJoint = joints[j];
+    const dynamics::BodyNode* bodyNode = childJoint->getParentBodyNode();
+    while (bodyNode != nullptr)
+    {
+      Eigen::Matrix3s R = bodyNode->getWorldTransform().linear();
+      Eigen::Vector3s parentOffset = bodyNode->getParentJoint()
+                                         ->getTransformFromChildBodyNode()
+                                         .translation();
+      Eigen::Vector3s childOffset
+          = childJoint->getTransformFromParentBodyNode().translation();
+      for (int axis = 0; axis < 3; axis++)
+      {
+        addGroupScaleJacobianColumn(
+            triplets,
+            groupIndex,
+            j * 3,
+            bodyNode,
+            axis,
+            R.col(axis) * (childOffset(axis) - parentOffset(axis))
+                / bodyNode->getScale()(axis));
+      }
+      childJoint = bodyNode->getParentJoint();
+      bodyNode = bodyNode->getParentBodyNode();
+    }
+  }
+
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor> jac(
+      joints.size() * 3, getGroupScaleDim());
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
+//==============================================================================
+/// This is getMarkerWorldPositionsJacobianWrtGroupScales(), but sparse. Each
+/// marker only moves with the scales of its body and the bodies above it in
+/// the tree, so this only visits those, rather than every body for every
+/// marker.
+Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+Skeleton::getMarkerWorldPositionsJacobianWrtGroupScalesSparse(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+{
+  std::vector<int> groupIndex = getGroupScaleIndexForBodyScales();
+  std::vector<Eigen::Triplet<s_t>> triplets;
+
+  for (int j = 0; j < markers.size(); j++)
+  {
+    // The marker's own body scales the marker offset, as well as the offset
+    // to its parent joint
+    const dynamics::BodyNode* bodyNode = markers[j].first;
+    {
+      Eigen::Matrix3s R = bodyNode->getWorldTransform().linear();
+      Eigen::Vector3s parentOffset = bodyNode->getParentJoint()
+                                         ->getTransformFromChildBodyNode()
+                                         .translation();
+      for (int axis = 0; axis < 3; axis++)
+      {
+        addGroupScaleJacobianColumn(
+            triplets,
+            groupIndex,
+            j * 3,
+            bodyNode,
+            axis,
+            R.col(axis)
+                * (markers[j].second(axis)
+                   - parentOffset(axis) / bodyNode->getScale()(axis)));
+      }
+    }
+
+    // Then every body above it works just like it does for joints
+    const dynamics::Joint* childJoint = bodyNode->getParentJoint();
+    bodyNode = bodyNode->getParentBodyNode();
+    while (bodyNode != nullptr)
+    {
+      Eigen::Matrix3s R = bodyNode->getWorldTransform().linear();
+      Eigen::Vector3s parentOffset = bodyNode->getParentJoint()
+                                         ->getTransformFromChildBodyNode()
+                                         .translation();
+      Eigen::Vector3s childOffset
+          = childJoint->getTransformFromParentBodyNode().translation();
+      for (int axis = 0; axis < 3; axis++)
+      {
+        addGroupScaleJacobianColumn(
+            triplets,
+            groupIndex,
+            j * 3,
+            bodyNode,
+            axis,
+            R.col(axis) * (childOffset(axis) - parentOffset(axis))
+                / bodyNode->getScale()(axis));
+      }
+      childJoint = bodyNode->getParentJoint();
+      bodyNode = bodyNode->getParentBodyNode();
+    }
+  }
+
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor> jac(
+      markers.size() * 3, getGroupScaleDim());
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
+//==============================================================================
+/// This returns the index in the group scales vector that each body scale
+/// (laid out like getBodyScales()) feeds into, or -1 if it's in no group
+std::vector<int> Skeleton::getGroupScaleIndexForBodyScales()
+{
+  ensureBodyScaleGroups();
+  std::vector<int> groupIndex(getNumBodyNodes() * 3, -1);
+  int cursor = 0;
+  for (int i = 0; i < mBodyScaleGroups.size(); i++)
+  {
+    for (dynamics::BodyNode* node : mBodyScaleGroups[i].nodes)
+    {
+      for (int axis = 0; axis < 3; axis++)
+      {
+        groupIndex[node->getIndexInSkeleton() * 3 + axis]
+            = mBodyScaleGroups[i].uniformScaling ? cursor : cursor + axis;
+      }
+    }
+    cursor += mBodyScaleGroups[i].uniformScaling ? 1 : 3;
+  }
+  return groupIndex;
+}
+
+//==============================================================================
+/// This appends the 3 x 1 Jacobian column of a point wrt `node`'s scale
+/// along `axis` to `triplets`, at row `row` and the group column that scale
+/// belongs to
+void Skeleton::addGroupScaleJacobianColumn(
+    std::vector<Eigen::Triplet<s_t>>& triplets,
+    const std::vector<int>& groupIndex,
+    int row,
+    const dynamics::BodyNode* node,
+    int axis,
+    const Eigen::Vector3s& column)
+{
+  int col = groupIndex[node->getIndexInSkeleton() * 3 + axis];
+  if (col == -1)
+    return;
+  // Duplicate entries (from bodies that share a group) get summed when the
+  // matrix is built
+  for (int i = 0; i < 3; i++)
+  {
+    triplets.emplace_back(row + i, col, column(i));
+  }
+}
+
 //==============================================================================
 /// This gets the Jacobian of leftMultiply.transpose()*J with respect to group
 /// scales
@@ -4486,6 +5206,170 @@ Eigen::VectorXs Skeleton::convertPositionsFromBallSpace(Eigen::VectorXs pos)
   return translated;
 }
 
+//==============================================================================
+// This is convertPositionsToBallSpace() for every column of `poses`, with the
+// logMap() for each joint batched across all the frames.
+Eigen::MatrixXs Skeleton::convertPositionsToBallSpaceBatch(
+    const Eigen::MatrixXs& poses)
+{
+  Eigen::MatrixXs translated = poses;
+  Eigen::MatrixXs rotations = Eigen::MatrixXs::Zero(9, poses.cols());
+  int cursor = 0;
+  for (int i = 0; i < getNumJoints(); i++)
+  {
+    dynamics::Joint* joint = getJoint(i);
+    EulerJoint::AxisOrder axisOrder = EulerJoint::AxisOrder::XYZ;
+    Eigen::Vector3s flipAxisMap;
+    if (joint->getType() == EulerFreeJoint::getStaticType())
+    {
+      dynamics::EulerFreeJoint* eulerFreeJoint
+          = static_cast<dynamics::EulerFreeJoint*>(joint);
+      axisOrder = eulerFreeJoint->getAxisOrder();
+      flipAxisMap = eulerFreeJoint->getFlipAxisMap();
+    }
+    else if (joint->getType() == EulerJoint::getStaticType())
+    {
+      dynamics::EulerJoint* eulerJoint
+          = static_cast<dynamics::EulerJoint*>(joint);
+      axisOrder = eulerJoint->getAxisOrder();
+      flipAxisMap = eulerJoint->getFlipAxisMap();
+    }
+    else
+    {
+      cursor += joint->getNumDofs();
+      continue;
+    }
+
+    for (int t = 0; t < poses.cols(); t++)
+    {
+      Eigen::Map<Eigen::Matrix3s>(rotations.col(t).data())
+          = EulerJoint::convertToTransform(
+                translated.block<3, 1>(cursor, t), axisOrder, flipAxisMap)
+                .linear();
+    }
+    translated.block(cursor, 0, 3, poses.cols())
+        = math::logMapBatch(rotations);
+    cursor += joint->getNumDofs();
+  }
+  assert(cursor == translated.rows());
+  return translated;
+}
+
+//==============================================================================
+// This is convertPositionsFromBallSpace() for every column of `poses`, with
+// the expMapRot() for each joint batched across all the frames.
+Eigen::MatrixXs Skeleton::convertPositionsFromBallSpaceBatch(
+    const Eigen::MatrixXs& poses)
+{
+  Eigen::MatrixXs translated = poses;
+  int cursor = 0;
+  for (int i = 0; i < getNumJoints(); i++)
+  {
+    dynamics::Joint* joint = getJoint(i);
+    EulerJoint::AxisOrder axisOrder = EulerJoint::AxisOrder::XYZ;
+    Eigen::Vector3s flipAxisMap;
+    Eigen::Vector3s upperLimits;
+    Eigen::Vector3s lowerLimits;
+    if (joint->getType() == EulerFreeJoint::getStaticType())
+    {
+      dynamics::EulerFreeJoint* eulerFreeJoint
+          = static_cast<dynamics::EulerFreeJoint*>(joint);
+      axisOrder = eulerFreeJoint->getAxisOrder();
+      flipAxisMap = eulerFreeJoint->getFlipAxisMap();
+      upperLimits = eulerFreeJoint->getPositionUpperLimits().head<3>();
+      lowerLimits = eulerFreeJoint->getPositionLowerLimits().head<3>();
+    }
+    else if (joint->getType() == EulerJoint::getStaticType())
+    {
+      dynamics::EulerJoint* eulerJoint
+          = static_cast<dynamics::EulerJoint*>(joint);
+      axisOrder = eulerJoint->getAxisOrder();
+      flipAxisMap = eulerJoint->getFlipAxisMap();
+      upperLimits = eulerJoint->getPositionUpperLimits();
+      lowerLimits = eulerJoint->getPositionLowerLimits();
+    }
+    else
+    {
+      cursor += joint->getNumDofs();
+      continue;
+    }
+
+    Eigen::MatrixXs rotations
+        = math::expMapRotBatch(translated.block(cursor, 0, 3, poses.cols()));
+    for (int t = 0; t < poses.cols(); t++)
+    {
+      Eigen::Map<const Eigen::Matrix3s> R(rotations.col(t).data());
+      Eigen::Vector3s euler = Eigen::Vector3s::Zero();
+      if (axisOrder == EulerJoint::AxisOrder::XYZ)
+      {
+        euler = math::matrixToEulerXYZ(R);
+      }
+      else if (axisOrder == EulerJoint::AxisOrder::XZY)
+      {
+        euler = math::matrixToEulerXZY(R);
+      }
+      else if (axisOrder == EulerJoint::AxisOrder::ZXY)
+      {
+        euler = math::matrixToEulerZXY(R);
+      }
+      else if (axisOrder == EulerJoint::AxisOrder::ZYX)
+      {
+        euler = math::matrixToEulerZYX(R);
+      }
+      else
+      {
+        assert(false && "Unsupported AxisOrder when decoding EulerJoint");
+      }
+      // Do our best to pick an equivalent set of EulerAngles that's within
+      // joint bounds, if one exists
+      translated.block<3, 1>(cursor, t)
+          = math::attemptToClampEulerAnglesToBounds(
+              euler.cwiseProduct(flipAxisMap), upperLimits, lowerLimits);
+    }
+    cursor += joint->getNumDofs();
+  }
+  return translated;
+}
+
+//==============================================================================
+void Skeleton::getBodyWorldTransforms(
+    common::aligned_vector<Eigen::Isometry3s>& transforms) const
+{
+  const std::size_t numBodies = getNumBodyNodes();
+  transforms.resize(numBodies);
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    transforms[i] = getBodyNode(i)->getWorldTransform();
+  }
+}
+
+//==============================================================================
+void Skeleton::getShapeNodeWorldTransforms(
+    std::vector<const ShapeNode*>& shapeNodes,
+    common::aligned_vector<Eigen::Isometry3s>& transforms) const
+{
+  ensureScalesApplied();
+
+  shapeNodes.clear();
+  transforms.clear();
+  const std::size_t numBodies = getNumBodyNodes();
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const BodyNode* body = getBodyNode(i);
+    const std::size_t numShapes = body->getNumShapeNodes();
+    if (numShapes == 0)
+      continue;
+
+    const Eigen::Isometry3s& T_body = body->getWorldTransform();
+    for (std::size_t j = 0; j < numShapes; j++)
+    {
+      const ShapeNode* shapeNode = body->getShapeNode(j);
+      shapeNodes.push_back(shapeNode);
+      transforms.push_back(T_body * shapeNode->getRelativeTransform());
+    }
+  }
+}
+
 //==============================================================================
 /// This returns the concatenated 3-vectors for world positions of each joint
 /// in 3D world space, for the registered source joints.
@@ -4555,6 +5439,124 @@ Eigen::MatrixXs Skeleton::getJointWorldPositionsJacobianWrtJointPositions(
   return jac;
 }
 
+//==============================================================================
+namespace {
+
+/// This calls fn(clone, t) for every column t of `poses`, where clone is a
+/// copy of `skel` set to that pose. Frames are split into contiguous chunks
+/// across the global thread pool, and each chunk gets its own clone, so the
+/// original skeleton never moves and the chunks never share kinematic caches.
+void forEachPoseInParallel(
+    const Skeleton* skel,
+    const Eigen::MatrixXs& poses,
+    const std::function<void(Skeleton* clone, int t)>& fn)
+{
+  const int numFrames = poses.cols();
+  if (numFrames == 0)
+    return;
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  const int numChunks
+      = std::max(1, std::min(numFrames, (int)pool.getNumThreads()));
+
+  // Cloning reads from the original skeleton, so we do it all up front on
+  // this thread rather than from inside the workers
+  std::vector<SkeletonPtr> clones;
+  for (int c = 0; c < numChunks; c++)
+  {
+    clones.push_back(skel->cloneSkeleton());
+  }
+
+  auto runChunk = [&poses, &fn](Skeleton* clone, int start, int end) {
+    for (int t = start; t < end; t++)
+    {
+      clone->setPositions(poses.col(t));
+      fn(clone, t);
+    }
+  };
+
+  if (numChunks == 1)
+  {
+    runChunk(clones[0].get(), 0, numFrames);
+    return;
+  }
+
+  std::vector<std::future<void>> futures;
+  for (int c = 0; c < numChunks; c++)
+  {
+    int start = (numFrames * c) / numChunks;
+    int end = (numFrames * (c + 1)) / numChunks;
+    futures.push_back(pool.submit(runChunk, clones[c].get(), start, end));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    // This rethrows anything that went wrong on a worker
+    future.get();
+  }
+}
+
+} // namespace
+
+//==============================================================================
+/// This returns the world positions of each joint (like
+/// getJointWorldPositions()) for every column of `poses`, as a (3 * joints)
+/// by T matrix. Frames are evaluated in parallel on copies of this skeleton,
+/// so this skeleton's own state is left untouched.
+Eigen::MatrixXs Skeleton::getJointWorldPositionsBatch(
+    const std::vector<dynamics::Joint*>& joints,
+    const Eigen::MatrixXs& poses) const
+{
+  assert(poses.rows() == getNumDofs());
+  std::vector<int> jointIndices;
+  for (const dynamics::Joint* joint : joints)
+  {
+    jointIndices.push_back(joint->getJointIndexInSkeleton());
+  }
+
+  Eigen::MatrixXs result
+      = Eigen::MatrixXs::Zero(joints.size() * 3, poses.cols());
+  forEachPoseInParallel(this, poses, [&](Skeleton* clone, int t) {
+    std::vector<dynamics::Joint*> cloneJoints;
+    for (int index : jointIndices)
+    {
+      cloneJoints.push_back(clone->getJoint(index));
+    }
+    result.col(t) = clone->getJointWorldPositions(cloneJoints);
+  });
+  return result;
+}
+
+//==============================================================================
+/// This returns getJointWorldPositionsJacobianWrtJointPositions() for every
+/// column of `poses`, one block per frame. Like
+/// getJointWorldPositionsBatch(), this runs in parallel and doesn't change
+/// this skeleton's state.
+std::vector<Eigen::MatrixXs>
+Skeleton::getJointWorldPositionsJacobianWrtJointPositionsBatch(
+    const std::vector<dynamics::Joint*>& joints,
+    const Eigen::MatrixXs& poses) const
+{
+  assert(poses.rows() == getNumDofs());
+  std::vector<int> jointIndices;
+  for (const dynamics::Joint* joint : joints)
+  {
+    jointIndices.push_back(joint->getJointIndexInSkeleton());
+  }
+
+  std::vector<Eigen::MatrixXs> result(poses.cols());
+  forEachPoseInParallel(this, poses, [&](Skeleton* clone, int t) {
+    std::vector<dynamics::Joint*> cloneJoints;
+    for (int index : jointIndices)
+    {
+      cloneJoints.push_back(clone->getJoint(index));
+    }
+    result[t]
+        = clone->getJointWorldPositionsJacobianWrtJointPositions(cloneJoints);
+  });
+  return result;
+}
+
 //==============================================================================
 /// This returns the Jacobian relating changes in source skeleton joint
 /// positions to changes in source joint world positions.
@@ -4797,18 +5799,104 @@ Eigen::MatrixXs Skeleton::getMarkerWorldPositionsJacobianWrtJointPositions(
     const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
     const
 {
-  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(markers.size() * 3, getNumDofs());
-
+  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(markers.size() * 3, getNumDofs());
+
+  // This is the linear half of getWorldPositionJacobian(), which is all we
+  // need, straight from the shared screws
+  const KinematicsContext& context = getKinematicsContext();
+  for (int i = 0; i < markers.size(); i++)
+  {
+    const BodyNode* body = markers[i].first;
+    const int bodyIndex = body->getIndexInSkeleton();
+    const Eigen::Vector3s worldMarker
+        = body->getWorldTransform()
+          * body->getScale().cwiseProduct(markers[i].second);
+    for (int j = 0; j < getNumDofs(); j++)
+    {
+      if (context.bodyDependsOnDof(bodyIndex, j))
+      {
+        const Eigen::Vector6s& screw = context.dofScrews[j];
+        jac.block<3, 1>(3 * i, j)
+            = screw.tail<3>() + screw.head<3>().cross(worldMarker);
+      }
+    }
+  }
+
+  return jac;
+}
+
+//==============================================================================
+/// This returns, for each row of
+/// getMarkerWorldPositionsJacobianWrtJointPositions(), the DOFs that can
+/// have non-zero entries: the DOFs between the marker's body and the root.
+std::vector<std::vector<int>> Skeleton::getMarkerJacobianSparsity(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+    const
+{
+  std::vector<std::vector<int>> sparsity;
+  sparsity.reserve(markers.size() * 3);
   for (int i = 0; i < markers.size(); i++)
   {
-    math::Jacobian bodyJac = getWorldPositionJacobian(
-        markers[i].first,
-        markers[i].first->getScale().cwiseProduct(markers[i].second));
-    jac.block(3 * i, 0, 3, bodyJac.cols())
-        = bodyJac.block(3, 0, 3, bodyJac.cols());
+    const std::vector<std::size_t>& dofs
+        = markers[i].first->getDependentGenCoordIndices();
+    std::vector<int> cols(dofs.begin(), dofs.end());
+    for (int axis = 0; axis < 3; axis++)
+    {
+      sparsity.push_back(cols);
+    }
   }
+  return sparsity;
+}
 
-  return jac;
+//==============================================================================
+/// This returns the world positions of each marker (like
+/// getMarkerWorldPositions()) for every column of `poses`, as a
+/// (3 * markers) by T matrix. Frames are evaluated in parallel on copies of
+/// this skeleton, so this skeleton's own state is left untouched.
+Eigen::MatrixXs Skeleton::getMarkerWorldPositionsBatch(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+        markers,
+    const Eigen::MatrixXs& poses) const
+{
+  assert(poses.rows() == getNumDofs());
+  Eigen::MatrixXs result
+      = Eigen::MatrixXs::Zero(markers.size() * 3, poses.cols());
+  forEachPoseInParallel(this, poses, [&](Skeleton* clone, int t) {
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> cloneMarkers;
+    for (auto& pair : markers)
+    {
+      cloneMarkers.emplace_back(
+          clone->getBodyNode(pair.first->getIndexInSkeleton()), pair.second);
+    }
+    result.col(t) = clone->getMarkerWorldPositions(cloneMarkers);
+  });
+  return result;
+}
+
+//==============================================================================
+/// This returns getMarkerWorldPositionsJacobianWrtJointPositions() for
+/// every column of `poses`, one block per frame. Like
+/// getMarkerWorldPositionsBatch(), this runs in parallel and doesn't change
+/// this skeleton's state.
+std::vector<Eigen::MatrixXs>
+Skeleton::getMarkerWorldPositionsJacobianWrtJointPositionsBatch(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+        markers,
+    const Eigen::MatrixXs& poses) const
+{
+  assert(poses.rows() == getNumDofs());
+  std::vector<Eigen::MatrixXs> result(poses.cols());
+  forEachPoseInParallel(this, poses, [&](Skeleton* clone, int t) {
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> cloneMarkers;
+    for (auto& pair : markers)
+    {
+      cloneMarkers.emplace_back(
+          clone->getBodyNode(pair.first->getIndexInSkeleton()), pair.second);
+    }
+    result[t]
+        = clone->getMarkerWorldPositionsJacobianWrtJointPositions(cloneMarkers);
+  });
+  return result;
 }
 
 //==============================================================================
@@ -5052,6 +6140,243 @@ Skeleton::finiteDifferenceMarkerWorldPositionDiffToGoalGradientWrtJointPos(
   return result;
 }
 
+//==============================================================================
+/// This gets the product of the Hessian of ||f(q) - x||^2 with respect to q
+/// with `direction`, without forming the Hessian. It's one pass over the
+/// markers and DOFs, so it costs about as much as the gradient.
+Eigen::VectorXs
+Skeleton::getMarkerWorldPositionDiffToGoalHessianVectorProductWrtJointPos(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const Eigen::VectorXs& goal,
+    const Eigen::VectorXs& direction)
+{
+  const int dofs = getNumDofs();
+  assert(direction.size() == dofs);
+  assert(goal.size() == markers.size() * 3);
+
+  // The Hessian is 2 * (J^T J + dJ^T r), where r is the residual and dJ is
+  // the derivative of the Jacobian along `direction`. We get both terms from
+  // each column of J, the marker's velocity along `direction` (J * direction),
+  // and the velocity of the frame each column's screw lives in.
+  const KinematicsContext& context = getKinematicsContext();
+  const common::aligned_vector<Eigen::Vector6s>& dofScrews = context.dofScrews;
+
+  // The gradient of each DOF's screw along `direction`, from the other DOFs in
+  // its own joint
+  common::aligned_vector<Eigen::Vector6s> screwGrads(dofs);
+  for (int j = 0; j < dofs; j++)
+  {
+    Joint* joint = context.dofJoints[j];
+    screwGrads[j].setZero();
+    for (int k = 0; k < joint->getNumDofs(); k++)
+    {
+      const s_t dq = direction(joint->getDof(k)->getIndexInSkeleton());
+      if (dq != 0)
+      {
+        screwGrads[j]
+            += dq
+               * joint->getScrewAxisGradientForPosition(
+                   context.dofIndexInJoint[j], k);
+      }
+    }
+  }
+
+  // The world velocity (angular, linear) of each joint's parent body along
+  // `direction`, which is what moves the screws of that joint's DOFs
+  common::aligned_vector<Eigen::Vector6s> parentVels(getNumJoints());
+  for (int b = 0; b < getNumBodyNodes(); b++)
+  {
+    const BodyNode* body = getBodyNode(b);
+    const int jointIndex = getJointIndex(body->getParentJoint());
+    parentVels[jointIndex].setZero();
+    const BodyNode* parent = body->getParentBodyNode();
+    if (parent == nullptr)
+      continue;
+    const int parentIndex = parent->getIndexInSkeleton();
+    for (int k = 0; k < dofs; k++)
+    {
+      if (context.bodyDependsOnDof(parentIndex, k))
+        parentVels[jointIndex] += direction(k) * dofScrews[k];
+    }
+  }
+
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(dofs);
+  for (int i = 0; i < markers.size(); i++)
+  {
+    const BodyNode* body = markers[i].first;
+    const int bodyIndex = body->getIndexInSkeleton();
+    const Eigen::Vector3s worldMarker
+        = body->getWorldTransform()
+          * body->getScale().cwiseProduct(markers[i].second);
+    const Eigen::Vector3s residual = worldMarker - goal.segment<3>(i * 3);
+
+    Eigen::Vector3s markerVel = Eigen::Vector3s::Zero();
+    for (int k = 0; k < dofs; k++)
+    {
+      if (context.bodyDependsOnDof(bodyIndex, k))
+      {
+        markerVel += direction(k)
+                     * (dofScrews[k].tail<3>()
+                        + dofScrews[k].head<3>().cross(worldMarker));
+      }
+    }
+
+    for (int j = 0; j < dofs; j++)
+    {
+      if (!context.bodyDependsOnDof(bodyIndex, j))
+        continue;
+      const Eigen::Vector6s& screw = dofScrews[j];
+      const Eigen::Vector6s& frameVel = parentVels[context.dofJointIndices[j]];
+      const Eigen::Vector3s col
+          = screw.tail<3>() + screw.head<3>().cross(worldMarker);
+
+      // The ancestors rotate the column rigidly, the rest of the column's own
+      // joint changes the screw, and everything between the joint and the
+      // marker moves the marker relative to the screw
+      const Eigen::Vector3s relativeMarkerVel
+          = markerVel - frameVel.tail<3>()
+            - frameVel.head<3>().cross(worldMarker);
+      const Eigen::Vector3s colGrad
+          = frameVel.head<3>().cross(col) + screwGrads[j].tail<3>()
+            + screwGrads[j].head<3>().cross(worldMarker)
+            + screw.head<3>().cross(relativeMarkerVel);
+
+      result(j) += col.dot(markerVel) + residual.dot(colGrad);
+    }
+  }
+
+  return 2 * result;
+}
+
+//==============================================================================
+/// This gets the product of the Hessian of ||f(q) - x||^2 with respect to q
+/// with `direction`, by finite differencing the gradient
+Eigen::VectorXs Skeleton::
+    finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtJointPos(
+        const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+            markers,
+        const Eigen::VectorXs& goal,
+        const Eigen::VectorXs& direction)
+{
+  const s_t EPS = 1e-7;
+  Eigen::VectorXs originalPos = getPositions();
+
+  setPositions(originalPos + EPS * direction);
+  Eigen::VectorXs plus
+      = getMarkerWorldPositionDiffToGoalGradientWrtJointPos(markers, goal);
+
+  setPositions(originalPos - EPS * direction);
+  Eigen::VectorXs minus
+      = getMarkerWorldPositionDiffToGoalGradientWrtJointPos(markers, goal);
+
+  setPositions(originalPos);
+  return (plus - minus) / (2 * EPS);
+}
+
+//==============================================================================
+/// This gets the product of the Hessian of ||f(s) - x||^2 with respect to
+/// body scales with `direction`. Marker positions are linear in the body
+/// scales, so this is exactly the Gauss-Newton product and doesn't depend on
+/// the goal.
+Eigen::VectorXs
+Skeleton::getMarkerWorldPositionDiffToGoalHessianVectorProductWrtBodyScales(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const Eigen::VectorXs& direction)
+{
+  assert(direction.size() == getNumBodyNodes() * 3);
+  Eigen::MatrixXs J = getMarkerWorldPositionsJacobianWrtBodyScales(markers);
+  return 2 * J.transpose() * (J * direction);
+}
+
+//==============================================================================
+/// This gets the product of the Hessian of ||f(s) - x||^2 with respect to
+/// body scales with `direction`, by finite differencing the gradient
+Eigen::VectorXs Skeleton::
+    finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtBodyScales(
+        const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+            markers,
+        const Eigen::VectorXs& goal,
+        const Eigen::VectorXs& direction)
+{
+  const s_t EPS = 1e-7;
+  Eigen::VectorXs originalScales = getBodyScales();
+
+  setBodyScales(originalScales + EPS * direction);
+  Eigen::VectorXs plus
+      = 2
+        * getMarkerWorldPositionsJacobianWrtBodyScales(markers).transpose()
+        * (getMarkerWorldPositions(markers) - goal);
+
+  setBodyScales(originalScales - EPS * direction);
+  Eigen::VectorXs minus
+      = 2
+        * getMarkerWorldPositionsJacobianWrtBodyScales(markers).transpose()
+        * (getMarkerWorldPositions(markers) - goal);
+
+  setBodyScales(originalScales);
+  return (plus - minus) / (2 * EPS);
+}
+
+//==============================================================================
+/// This gets the product of the Hessian of ||f(o) - x||^2 with respect to
+/// marker offsets with `direction`. Marker positions are linear in the
+/// offsets, so like the body scales this doesn't depend on the goal.
+Eigen::VectorXs
+Skeleton::getMarkerWorldPositionDiffToGoalHessianVectorProductWrtMarkerOffsets(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const Eigen::VectorXs& direction) const
+{
+  assert(direction.size() == markers.size() * 3);
+  // Each marker's block of the Jacobian is R * diag(scale), and R is
+  // orthonormal, so J^T J is just diag(scale^2)
+  Eigen::VectorXs result(markers.size() * 3);
+  for (int i = 0; i < markers.size(); i++)
+  {
+    const Eigen::Vector3s& scale = markers[i].first->getScale();
+    result.segment<3>(i * 3) = 2
+                               * scale.cwiseProduct(scale).cwiseProduct(
+                                   direction.segment<3>(i * 3));
+  }
+  return result;
+}
+
+//==============================================================================
+/// This gets the product of the Hessian of ||f(o) - x||^2 with respect to
+/// marker offsets with `direction`, by finite differencing the gradient
+Eigen::VectorXs Skeleton::
+    finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtMarkerOffsets(
+        const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+            markers,
+        const Eigen::VectorXs& goal,
+        const Eigen::VectorXs& direction)
+{
+  const s_t EPS = 1e-7;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> perturbed
+      = markers;
+
+  for (int i = 0; i < markers.size(); i++)
+  {
+    perturbed[i].second
+        = markers[i].second + EPS * direction.segment<3>(i * 3);
+  }
+  Eigen::VectorXs plus
+      = 2
+        * getMarkerWorldPositionsJacobianWrtMarkerOffsets(perturbed).transpose()
+        * (getMarkerWorldPositions(perturbed) - goal);
+
+  for (int i = 0; i < markers.size(); i++)
+  {
+    perturbed[i].second
+        = markers[i].second - EPS * direction.segment<3>(i * 3);
+  }
+  Eigen::VectorXs minus
+      = 2
+        * getMarkerWorldPositionsJacobianWrtMarkerOffsets(perturbed).transpose()
+        * (getMarkerWorldPositions(perturbed) - goal);
+
+  return (plus - minus) / (2 * EPS);
+}
+
 //==============================================================================
 /// This should be equivalent to
 /// `getMarkerWorldPositionsJacobianWrtJointPositions`, just slower. This is
@@ -5066,12 +6391,12 @@ Skeleton::getScrewsMarkerWorldPositionsJacobianWrtJointPositions(
   Eigen::VectorXs worldMarkers = getMarkerWorldPositions(markers);
   const Eigen::MatrixXi& parentMap = getJointParentMap();
 
+  const KinematicsContext& context = getKinematicsContext();
   for (int j = 0; j < getNumDofs(); j++)
   {
-    dynamics::Joint* parentJoint = getDof(j)->getJoint();
-    Eigen::Vector6s screw = parentJoint->getWorldAxisScrewForPosition(
-        getDof(j)->getIndexInJoint());
-    int parentJointIndex = getJointIndex(parentJoint);
+    dynamics::Joint* parentJoint = context.dofJoints[j];
+    const Eigen::Vector6s& screw = context.dofScrews[j];
+    int parentJointIndex = context.dofJointIndices[j];
     for (int i = 0; i < markers.size(); i++)
     {
       dynamics::Joint* sourceJoint = markers[i].first->getParentJoint();
@@ -5105,17 +6430,16 @@ Skeleton::getMarkerWorldPositionsDerivativeOfJacobianWrtJointsWrtJoints(
   const Eigen::MatrixXi& parentMap = getJointParentMap();
 
   // Differentiating the whole mess wrt this joint
-  dynamics::Joint* rootJoint = getDof(index)->getJoint();
-  Eigen::Vector6s rootScrew = rootJoint->getWorldAxisScrewForPosition(
-      getDof(index)->getIndexInJoint());
-  int rootJointIndex = getJointIndex(rootJoint);
+  const KinematicsContext& context = getKinematicsContext();
+  dynamics::Joint* rootJoint = context.dofJoints[index];
+  const Eigen::Vector6s& rootScrew = context.dofScrews[index];
+  int rootJointIndex = context.dofJointIndices[index];
 
   for (int j = 0; j < getNumDofs(); j++)
   {
-    dynamics::Joint* parentJoint = getDof(j)->getJoint();
-    Eigen::Vector6s screw = parentJoint->getWorldAxisScrewForPosition(
-        getDof(j)->getIndexInJoint());
-    int parentJointIndex = getJointIndex(parentJoint);
+    dynamics::Joint* parentJoint = context.dofJoints[j];
+    const Eigen::Vector6s& screw = context.dofScrews[j];
+    int parentJointIndex = context.dofJointIndices[j];
     for (int i = 0; i < markers.size(); i++)
     {
       dynamics::Joint* sourceJoint = markers[i].first->getParentJoint();
@@ -5236,18 +6560,11 @@ Skeleton::getMarkerWorldPositionsSecondJacobianWrtJointWrtJointPositions(
 
   // We're creating these caches outside of the inner loops, to avoid calling
   // these getter's a bazillion times in the hot inner loops
-  std::vector<dynamics::Joint*> dofJoints;
-  std::vector<Eigen::Vector6s> dofScrews;
-  std::vector<int> dofJointIndices;
-  std::vector<int> dofIndexInJoint;
-  for (int j = 0; j < getNumDofs(); j++)
-  {
-    dofJoints.push_back(getDof(j)->getJoint());
-    dofIndexInJoint.push_back(getDof(j)->getIndexInJoint());
-    dofScrews.push_back(
-        dofJoints[j]->getWorldAxisScrewForPosition(dofIndexInJoint[j]));
-    dofJointIndices.push_back(getJointIndex(dofJoints[j]));
-  }
+  const KinematicsContext& context = getKinematicsContext();
+  const std::vector<dynamics::Joint*>& dofJoints = context.dofJoints;
+  const common::aligned_vector<Eigen::Vector6s>& dofScrews = context.dofScrews;
+  const std::vector<int>& dofJointIndices = context.dofJointIndices;
+  const std::vector<int>& dofIndexInJoint = context.dofIndexInJoint;
 
   std::vector<dynamics::Joint*> markerSourceJoints;
   std::vector<int> markerSourceJointIndices;
@@ -5446,12 +6763,12 @@ Skeleton::getMarkerWorldPositionsDerivativeOfJacobianWrtJointsWrtBodyScale(
   Eigen::VectorXs worldMarkers = getMarkerWorldPositions(markers);
   const Eigen::MatrixXi& parentMap = getJointParentMap();
 
+  const KinematicsContext& context = getKinematicsContext();
   for (int j = 0; j < getNumDofs(); j++)
   {
-    dynamics::Joint* parentJoint = getDof(j)->getJoint();
-    Eigen::Vector6s screw = parentJoint->getWorldAxisScrewForPosition(
-        getDof(j)->getIndexInJoint());
-    int parentJointIndex = getJointIndex(parentJoint);
+    dynamics::Joint* parentJoint = context.dofJoints[j];
+    const Eigen::Vector6s& screw = context.dofScrews[j];
+    int parentJointIndex = context.dofJointIndices[j];
     for (int i = 0; i < markers.size(); i++)
     {
       dynamics::Joint* sourceJoint = markers[i].first->getParentJoint();
@@ -5532,16 +6849,10 @@ Skeleton::getMarkerWorldPositionsSecondJacobianWrtJointWrtBodyScale(
 
   // We're creating these caches outside of the inner loops, to avoid calling
   // these getter's a bazillion times in the hot inner loops
-  std::vector<dynamics::Joint*> parentJoints;
-  std::vector<Eigen::Vector6s> screws;
-  std::vector<int> parentJointIndices;
-  for (int j = 0; j < getNumDofs(); j++)
-  {
-    parentJoints.push_back(getDof(j)->getJoint());
-    screws.push_back(parentJoints[j]->getWorldAxisScrewForPosition(
-        getDof(j)->getIndexInJoint()));
-    parentJointIndices.push_back(getJointIndex(parentJoints[j]));
-  }
+  const KinematicsContext& context = getKinematicsContext();
+  const std::vector<dynamics::Joint*>& parentJoints = context.dofJoints;
+  const common::aligned_vector<Eigen::Vector6s>& screws = context.dofScrews;
+  const std::vector<int>& parentJointIndices = context.dofJointIndices;
 
   std::vector<dynamics::Joint*> markerSourceJoints;
   std::vector<int> markerSourceJointIndices;
@@ -5683,12 +6994,12 @@ Skeleton::getMarkerWorldPositionsDerivativeOfJacobianWrtJointsWrtMarkerOffsets(
   // Eigen::VectorXs worldMarkers = getMarkerWorldPositions(markers);
   const Eigen::MatrixXi& parentMap = getJointParentMap();
 
+  const KinematicsContext& context = getKinematicsContext();
   for (int j = 0; j < getNumDofs(); j++)
   {
-    dynamics::Joint* parentJoint = getDof(j)->getJoint();
-    Eigen::Vector6s screw = parentJoint->getWorldAxisScrewForPosition(
-        getDof(j)->getIndexInJoint());
-    int parentJointIndex = getJointIndex(parentJoint);
+    dynamics::Joint* parentJoint = context.dofJoints[j];
+    const Eigen::Vector6s& screw = context.dofScrews[j];
+    int parentJointIndex = context.dofJointIndices[j];
     for (int i = 0; i < markers.size(); i++)
     {
       dynamics::Joint* sourceJoint = markers[i].first->getParentJoint();
@@ -5761,16 +7072,10 @@ Skeleton::getMarkerWorldPositionsSecondJacobianWrtJointWrtMarkerOffsets(
 
   // We're creating these caches outside of the inner loops, to avoid calling
   // these getter's a bazillion times in the hot inner loops
-  std::vector<dynamics::Joint*> parentJoints;
-  std::vector<Eigen::Vector6s> screws;
-  std::vector<int> parentJointIndices;
-  for (int j = 0; j < getNumDofs(); j++)
-  {
-    parentJoints.push_back(getDof(j)->getJoint());
-    screws.push_back(parentJoints[j]->getWorldAxisScrewForPosition(
-        getDof(j)->getIndexInJoint()));
-    parentJointIndices.push_back(getJointIndex(parentJoints[j]));
-  }
+  const KinematicsContext& context = getKinematicsContext();
+  const std::vector<dynamics::Joint*>& parentJoints = context.dofJoints;
+  const common::aligned_vector<Eigen::Vector6s>& screws = context.dofScrews;
+  const std::vector<int>& parentJointIndices = context.dofJointIndices;
 
   std::vector<dynamics::Joint*> markerSourceJoints;
   std::vector<int> markerSourceJointIndices;
@@ -5992,6 +7297,23 @@ s_t Skeleton::fitMarkersToWorldPositions(
     bool scaleBodies,
     math::IKConfig config)
 {
+  if (config.levenbergMarquardt && config.jacobianSparsity.empty())
+  {
+    config.jacobianSparsity = getMarkerJacobianSparsity(markers);
+    if (scaleBodies)
+    {
+      // Body scales also move markers, but they're grouped across bodies, so
+      // every row just gets all the scale columns
+      for (std::vector<int>& cols : config.jacobianSparsity)
+      {
+        for (int i = 0; i < getGroupScaleDim(); i++)
+        {
+          cols.push_back(getNumDofs() + i);
+        }
+      }
+    }
+  }
+
   if (scaleBodies)
   {
     Eigen::VectorXs initialPos
@@ -6810,11 +8132,29 @@ Skeleton::getMultipleContactInverseDynamicsOverTime(
 
   int timesteps = positions.cols() - 2;
   result.timesteps = timesteps;
-  Eigen::MatrixXs B = Eigen::MatrixXs::Zero(fDim * timesteps, fDim * timesteps);
+  const int bRows = fDim * timesteps;
+  const int kktSize = bRows + 6 * timesteps;
   Eigen::VectorXs b = Eigen::VectorXs::Zero(fDim * timesteps);
-  Eigen::MatrixXs A = Eigen::MatrixXs::Zero(6 * timesteps, fDim * timesteps);
   Eigen::VectorXs c = Eigen::VectorXs::Zero(6 * timesteps);
 
+  // The KKT matrix [2B, A^T; A, 0] is very sparse. B only has entries on the
+  // diagonals of its fDim x fDim blocks, and only couples neighboring
+  // timesteps, and A is block diagonal. So rather than building it densely
+  // and paying a cubic factorization, we collect it as triplets (duplicates get
+  // summed) and factor it sparse, which scales linearly with the number of
+  // timesteps.
+  std::vector<Eigen::Triplet<s_t>> kktEntries;
+  kktEntries.reserve(timesteps * (6 * fDim + 4 * fDim + 2 * 6 * fDim));
+  auto addToB = [&](int row, int col, s_t value) {
+    kktEntries.emplace_back(row, col, 2 * value);
+  };
+  auto addIdentityToB = [&](int rowBlock, int colBlock, s_t weight) {
+    for (int k = 0; k < fDim; k++)
+    {
+      addToB(fDim * rowBlock + k, fDim * colBlock + k, weight);
+    }
+  };
+
   result.positions = Eigen::MatrixXs::Zero(dofs, timesteps);
   result.velocities = Eigen::MatrixXs::Zero(dofs, timesteps);
   result.nextVelocities = Eigen::MatrixXs::Zero(dofs, timesteps);
@@ -6823,17 +8163,17 @@ Skeleton::getMultipleContactInverseDynamicsOverTime(
   std::vector<Eigen::MatrixXs> timestepJacs;
   std::vector<Eigen::VectorXs> timestepJointTorques;
 
-  Eigen::MatrixXs torqueStamp = Eigen::MatrixXs::Identity(fDim, fDim);
+  // This is the diagonal of the (diagonal) torque penalty for one timestep
+  Eigen::VectorXs torqueStamp = Eigen::VectorXs::Ones(fDim);
   s_t eps = 0.01;
   for (int j = 0; j < bodies.size(); j++)
   {
-    torqueStamp(j * 6 + 3, j * 6 + 3) = eps;
-    torqueStamp(j * 6 + 4, j * 6 + 4) = eps;
-    torqueStamp(j * 6 + 5, j * 6 + 5) = eps;
+    torqueStamp(j * 6 + 3) = eps;
+    torqueStamp(j * 6 + 4) = eps;
+    torqueStamp(j * 6 + 5) = eps;
   }
 
-  B.block(0, 0, fDim, fDim)
-      += prevContactWeight * Eigen::MatrixXs::Identity(fDim, fDim);
+  addIdentityToB(0, 0, prevContactWeight);
   if (prevContactWeight > 0)
   {
     result.prevContactForces = prevContactForces;
@@ -6845,24 +8185,26 @@ Skeleton::getMultipleContactInverseDynamicsOverTime(
   }
   for (int i = 0; i < timesteps; i++)
   {
-    B.block(fDim * i, fDim * i, fDim, fDim) += minTorqueWeight * torqueStamp;
+    for (int k = 0; k < fDim; k++)
+    {
+      addToB(fDim * i + k, fDim * i + k, minTorqueWeight * torqueStamp(k));
+    }
     if (i + 1 < timesteps)
     {
-      B.block(fDim * i, fDim * i, fDim, fDim)
-          += smoothingWeight * Eigen::MatrixXs::Identity(fDim, fDim);
-      B.block(fDim * (i + 1), fDim * i, fDim, fDim)
-          -= smoothingWeight * Eigen::MatrixXs::Identity(fDim, fDim);
-      B.block(fDim * i, fDim * (i + 1), fDim, fDim)
-          -= smoothingWeight * Eigen::MatrixXs::Identity(fDim, fDim);
-      B.block(fDim * (i + 1), fDim * (i + 1), fDim, fDim)
-          += smoothingWeight * Eigen::MatrixXs::Identity(fDim, fDim);
+      addIdentityToB(i, i, smoothingWeight);
+      addIdentityToB(i + 1, i, -smoothingWeight);
+      addIdentityToB(i, i + 1, -smoothingWeight);
+      addIdentityToB(i + 1, i + 1, smoothingWeight);
     }
     if (magnitudeCosts.rows() == bodies.size())
     {
       for (int j = 0; j < bodies.size(); j++)
       {
-        B.block<6, 6>(fDim * i + j * 6, fDim * i + j * 6)
-            += Eigen::Matrix6s::Identity() * magnitudeCosts(j, i);
+        for (int k = 0; k < 6; k++)
+        {
+          addToB(
+              fDim * i + j * 6 + k, fDim * i + j * 6 + k, magnitudeCosts(j, i));
+        }
       }
     }
 
@@ -6892,7 +8234,10 @@ Skeleton::getMultipleContactInverseDynamicsOverTime(
       s_t velNorm = worldVel.squaredNorm();
       velCosts.segment<6>(j * 6) *= velocityPenalty(velNorm);
     }
-    B.block(fDim * i, fDim * i, fDim, fDim) += velCosts.asDiagonal();
+    for (int k = 0; k < fDim; k++)
+    {
+      addToB(fDim * i + k, fDim * i + k, velCosts(k));
+    }
 
     // This is the Jacobian in local body space. We're going to end up applying
     // our contact force in local body space, so this works out.
@@ -6905,7 +8250,17 @@ Skeleton::getMultipleContactInverseDynamicsOverTime(
     }
     timestepJacs.push_back(jacs);
 
-    A.block(6 * i, fDim * i, 6, fDim) = jacs.block(0, 0, fDim, 6).transpose();
+    // A's block for this timestep is the root rows of the contact Jacobians,
+    // and it goes in both off-diagonal corners of the KKT matrix
+    for (int row = 0; row < 6; row++)
+    {
+      for (int col = 0; col < fDim; col++)
+      {
+        s_t value = jacs(col, row);
+        kktEntries.emplace_back(bRows + 6 * i + row, fDim * i + col, value);
+        kktEntries.emplace_back(fDim * i + col, bRows + 6 * i + row, value);
+      }
+    }
 
     Eigen::VectorXs jointTorques
         = (multiplyByImplicitMassMatrix(accel) + getCoriolisAndGravityForces()
@@ -6916,18 +8271,29 @@ Skeleton::getMultipleContactInverseDynamicsOverTime(
 
   // We now have B, b, A, and c, so build the KKT matrix
 
-  Eigen::MatrixXs kktMatrix
-      = Eigen::MatrixXs::Zero(B.rows() + A.rows(), B.rows() + A.rows());
-  kktMatrix.block(0, 0, B.rows(), B.cols()) = 2 * B;
-  kktMatrix.block(B.rows(), 0, A.rows(), A.cols()) = A;
-  kktMatrix.block(0, B.cols(), A.cols(), A.rows()) = A.transpose();
+  Eigen::SparseMatrix<s_t> kktMatrix(kktSize, kktSize);
+  kktMatrix.setFromTriplets(kktEntries.begin(), kktEntries.end());
+  kktMatrix.makeCompressed();
   Eigen::VectorXs kktVector = Eigen::VectorXs::Zero(b.size() + c.size());
   kktVector.segment(0, b.size()) = -b;
   kktVector.segment(b.size(), c.size()) = c;
 
   // Now factor and solve:
 
-  Eigen::VectorXs kktSolution = kktMatrix.householderQr().solve(kktVector);
+  Eigen::VectorXs kktSolution;
+  Eigen::SparseLU<Eigen::SparseMatrix<s_t>> kktSolver;
+  kktSolver.compute(kktMatrix);
+  if (kktSolver.info() == Eigen::Success)
+  {
+    kktSolution = kktSolver.solve(kktVector);
+  }
+  if (kktSolver.info() != Eigen::Success || !kktSolution.allFinite())
+  {
+    // A rank deficient system (for example, with all the weights at zero)
+    // makes the LU give up, so fall back to a dense QR, which always gives us
+    // some answer
+    kktSolution = Eigen::MatrixXs(kktMatrix).householderQr().solve(kktVector);
+  }
 
   // And we can read the solution off of the result:
   for (int i = 0; i < timesteps; i++)
@@ -7105,33 +8471,17 @@ math::Jacobian Skeleton::getWorldPositionJacobian(
   const BodyNode* bodyNode = static_cast<const BodyNode*>(_node);
   Eigen::Vector3s originalRotation
       = math::logMap(bodyNode->getWorldTransform().linear());
+  const Eigen::Vector3s worldPoint
+      = bodyNode->getWorldTransform() * _localOffset;
 
+  const KinematicsContext& context = getKinematicsContext();
+  const int bodyIndex = bodyNode->getIndexInSkeleton();
   for (int i = 0; i < getNumDofs(); i++)
   {
-    const DegreeOfFreedom* dof = getDof(i);
-    const Joint* joint = dof->getJoint();
-
-    bool isParent = false;
-    const BodyNode* cursor = bodyNode;
-    while (cursor != nullptr)
-    {
-      if (cursor->getParentJoint() == joint)
-      {
-        isParent = true;
-        break;
-      }
-      if (cursor->getParentJoint() != nullptr)
-      {
-        cursor = cursor->getParentJoint()->getParentBodyNode();
-      }
-    }
-
-    if (isParent)
+    if (context.bodyDependsOnDof(bodyIndex, i))
     {
-      Eigen::Vector6s screw
-          = joint->getWorldAxisScrewForPosition(dof->getIndexInJoint());
-      screw.tail<3>() += screw.head<3>().cross(
-          bodyNode->getWorldTransform() * _localOffset);
+      Eigen::Vector6s screw = context.dofScrews[i];
+      screw.tail<3>() += screw.head<3>().cross(worldPoint);
       // This is key so we get an actual gradient of the angle (as a screw),
       // rather than just a screw representing a rotation.
       screw.head<3>()
@@ -7402,7 +8752,8 @@ s_t Skeleton::getMass() const
 //==============================================================================
 const Eigen::MatrixXs& Skeleton::getMassMatrix(std::size_t _treeIdx) const
 {
-  if (mTreeCache[_treeIdx].mDirty.mMassMatrix)
+  if (mTreeCache[_treeIdx].mDirty.mMassMatrix
+      || mTreeCache[_treeIdx].mAnyMassMatrixColumnDirty)
     updateMassMatrix(_treeIdx);
   return mTreeCache[_treeIdx].mM;
 }
@@ -7745,6 +9096,52 @@ Eigen::VectorXs Skeleton::getSpringForce()
       = spring_stiffs.asDiagonal() * (pose - rest_pose + dt * velocities);
   return spring_force;
 }
+
+//==============================================================================
+Eigen::VectorXs Skeleton::getImplicitSpringDampingDiagonal(s_t dt)
+{
+  Eigen::VectorXs h
+      = dt * getDampingCoeffVector() + dt * dt * getSpringStiffVector();
+  for (std::size_t i = 0; i < getNumDofs(); i++)
+  {
+    if (getDof(i)->getJoint()->isKinematic())
+      h(i) = 0.0;
+  }
+  return h;
+}
+
+//==============================================================================
+Eigen::MatrixXs Skeleton::getImplicitSpringDampingMassMatrix(s_t dt)
+{
+  Eigen::MatrixXs augM = getMassMatrix();
+  augM.diagonal() += getImplicitSpringDampingDiagonal(dt);
+  for (std::size_t i = 0; i < getNumDofs(); i++)
+  {
+    if (getDof(i)->getJoint()->isKinematic())
+    {
+      augM.row(i).setZero();
+      augM.col(i).setZero();
+      augM(i, i) = 1.0;
+    }
+  }
+  return augM;
+}
+
+//==============================================================================
+void Skeleton::applyImplicitSpringDamping(s_t dt)
+{
+  Eigen::VectorXs h = getImplicitSpringDampingDiagonal(dt);
+  if (h.isZero(0))
+    return;
+
+  // computeForwardDynamics() left us with M * ddq = f, and we want
+  // (M + H) * ddq' = f, so ddq' = ddq - (M + H)^-1 * H * ddq
+  Eigen::VectorXs accel = getAccelerations();
+  setAccelerations(
+      accel
+      - getImplicitSpringDampingMassMatrix(dt).ldlt().solve(
+          h.cwiseProduct(accel)));
+}
 //==============================================================================
 const Eigen::VectorXs& Skeleton::getConstraintForces(std::size_t _treeIdx) const
 {
@@ -7766,7 +9163,15 @@ const Eigen::VectorXs& Skeleton::getConstraintForces() const
 
 //==============================================================================
 Skeleton::Skeleton(const AspectPropertiesData& properties)
-  : mTotalMass(0.0), mIsImpulseApplied(false), mUnionSize(1)
+  : mTotalMass(0.0),
+    mDeferScaleUpdates(false),
+    mHasDeferredScales(false),
+    mParallelDynamics(true),
+    mArena(nullptr),
+    mCompiledDynamicsEnabled(true),
+    mCompiledDynamicsVersion(0),
+    mIsImpulseApplied(false),
+    mUnionSize(1)
 {
   createAspect<Aspect>(properties);
   createAspect<detail::BodyNodeVectorProxyAspect>();
@@ -7899,6 +9304,9 @@ void Skeleton::registerBodyNode(BodyNode* _newBodyNode)
   }
 #endif // ------- Debug mode
 
+  updateAdjacentBodyBits();
+  clearSelfCollisionPairs();
+
   _newBodyNode->mStructuralChangeSignal.raise(_newBodyNode);
 }
 
@@ -8071,6 +9479,8 @@ void Skeleton::unregisterBodyNode(BodyNode* _oldBodyNode)
   }
 
   updateTotalMass();
+  updateAdjacentBodyBits();
+  clearSelfCollisionPairs();
 }
 
 //==============================================================================
@@ -8305,6 +9715,8 @@ std::pair<Joint*, BodyNode*> Skeleton::cloneBodyNodeTree(
   std::map<std::string, BodyNode*> nameMap;
   std::vector<BodyNode*> clones;
   clones.reserve(tree.size());
+  SkeletonArena::Scope arenaScope(
+      _newSkeleton == nullptr ? nullptr : _newSkeleton->mArena);
 
   for (std::size_t i = 0; i < tree.size(); ++i)
   {
@@ -8395,6 +9807,27 @@ void Skeleton::receiveBodyNodeTree(const std::vector<BodyNode*>& _tree)
     registerBodyNode(bn);
 }
 
+//==============================================================================
+void Skeleton::updateAdjacentBodyBits()
+{
+  const std::size_t numBodies = mSkelCache.mBodyNodes.size();
+  const std::size_t wordsPerRow = (numBodies + 63) / 64;
+  mAdjacentBodyBits.assign(numBodies * wordsPerRow, 0u);
+  for (std::size_t i = 0; i < numBodies; i++)
+  {
+    const BodyNode* parent = mSkelCache.mBodyNodes[i]->getParentBodyNode();
+    if (parent == nullptr)
+      continue;
+    // While a tree is being moved between skeletons, a parent may not be
+    // registered here (yet, or anymore)
+    const std::size_t j = parent->getIndexInSkeleton();
+    if (j >= numBodies || mSkelCache.mBodyNodes[j] != parent)
+      continue;
+    mAdjacentBodyBits[i * wordsPerRow + j / 64] |= std::uint64_t(1) << (j % 64);
+    mAdjacentBodyBits[j * wordsPerRow + i / 64] |= std::uint64_t(1) << (i % 64);
+  }
+}
+
 //==============================================================================
 void Skeleton::updateTotalMass()
 {
@@ -8406,8 +9839,13 @@ void Skeleton::updateTotalMass()
 //==============================================================================
 void Skeleton::updateCacheDimensions(Skeleton::DataCache& _cache)
 {
+  _cache.mJointDispatch.invalidate();
+  mCompiledDynamicsVersion = 0;
+
   std::size_t dof = _cache.mDofs.size();
   _cache.mM = Eigen::MatrixXs::Zero(dof, dof);
+  _cache.mMassMatrixDirtyColumns.assign(dof, false);
+  _cache.mAnyMassMatrixColumnDirty = false;
   _cache.mAugM = Eigen::MatrixXs::Zero(dof, dof);
   _cache.mInvM = Eigen::MatrixXs::Zero(dof, dof);
   _cache.mInvAugM = Eigen::MatrixXs::Zero(dof, dof);
@@ -8430,14 +9868,11 @@ void Skeleton::updateCacheDimensions(std::size_t _treeIdx)
 //==============================================================================
 void Skeleton::updateArticulatedInertia(std::size_t _tree) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_tree];
-  for (std::vector<BodyNode*>::const_reverse_iterator it
-       = cache.mBodyNodes.rbegin();
-       it != cache.mBodyNodes.rend();
-       ++it)
-  {
-    (*it)->updateArtInertia(mAspectProperties.mTimeStep);
-  }
+  cache.mJointDispatch.updateArtInertia(
+      cache.mBodyNodes, mAspectProperties.mTimeStep, mParallelDynamics);
 
   cache.mDirty.mArticulatedInertia = false;
 }
@@ -8458,6 +9893,8 @@ void Skeleton::updateArticulatedInertia() const
 //==============================================================================
 void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_treeIdx];
   std::size_t dof = cache.mDofs.size();
   assert(
@@ -8466,10 +9903,18 @@ void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
   if (dof == 0)
   {
     cache.mDirty.mMassMatrix = false;
+    cache.mAnyMassMatrixColumnDirty = false;
     return;
   }
 
-  cache.mM.setZero();
+  // If only some joints have moved since the last update, we only need to
+  // recompute the columns for their DOFs and their ancestors' DOFs. Every
+  // other entry of the mass matrix only depends on the relative transforms
+  // within a subtree that hasn't changed.
+  const bool onlyDirtyColumns = !cache.mDirty.mMassMatrix
+                                && cache.mMassMatrixDirtyColumns.size() == dof;
+  if (!onlyDirtyColumns)
+    cache.mM.setZero();
 
   // Backup the original internal force
   Eigen::VectorXs originalGenAcceleration = getAccelerations();
@@ -8481,6 +9926,14 @@ void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
 
   for (std::size_t j = 0; j < dof; ++j)
   {
+    if (onlyDirtyColumns)
+    {
+      if (!cache.mMassMatrixDirtyColumns[j])
+        continue;
+      // We only fill in the lower triangle, and mirror it at the end
+      cache.mM.col(j).tail(dof - j).setZero();
+    }
+
     // Set the acceleration of this DOF to 1.0 while all the rest are 0.0
     cache.mDofs[j]->setAcceleration(1.0);
 
@@ -8518,6 +9971,11 @@ void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
   const_cast<Skeleton*>(this)->setAccelerations(originalGenAcceleration);
 
   cache.mDirty.mMassMatrix = false;
+  std::fill(
+      cache.mMassMatrixDirtyColumns.begin(),
+      cache.mMassMatrixDirtyColumns.end(),
+      false);
+  cache.mAnyMassMatrixColumnDirty = false;
 }
 
 //==============================================================================
@@ -8533,6 +9991,15 @@ void Skeleton::updateMassMatrix() const
     return;
   }
 
+  if (std::shared_ptr<CompiledSkeletonDynamics> compiled
+      = getCompiledDynamics())
+  {
+    ensureScalesApplied();
+    compiled->computeMassMatrix(this, mSkelCache.mM);
+    mSkelCache.mDirty.mMassMatrix = false;
+    return;
+  }
+
   mSkelCache.mM.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -8558,6 +10025,8 @@ void Skeleton::updateMassMatrix() const
 //==============================================================================
 void Skeleton::updateAugMassMatrix(std::size_t _treeIdx) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_treeIdx];
   std::size_t dof = cache.mDofs.size();
   assert(
@@ -8659,6 +10128,8 @@ void Skeleton::updateAugMassMatrix() const
 //==============================================================================
 void Skeleton::updateInvMassMatrix(std::size_t _treeIdx) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_treeIdx];
   std::size_t dof = cache.mDofs.size();
   assert(
@@ -8784,6 +10255,8 @@ void Skeleton::updateInvMassMatrix() const
 //==============================================================================
 void Skeleton::updateInvAugMassMatrix(std::size_t _treeIdx) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_treeIdx];
   std::size_t dof = cache.mDofs.size();
   assert(
@@ -8887,6 +10360,8 @@ void Skeleton::updateInvAugMassMatrix() const
 //==============================================================================
 void Skeleton::updateCoriolisForces(std::size_t _treeIdx) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_treeIdx];
   std::size_t dof = cache.mDofs.size();
   assert(static_cast<std::size_t>(cache.mCvec.size()) == dof);
@@ -8947,6 +10422,8 @@ void Skeleton::updateCoriolisForces() const
 //==============================================================================
 void Skeleton::updateGravityForces(std::size_t _treeIdx) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_treeIdx];
   std::size_t dof = cache.mDofs.size();
   assert(static_cast<std::size_t>(cache.mG.size()) == dof);
@@ -9000,6 +10477,8 @@ void Skeleton::updateGravityForces() const
 //==============================================================================
 void Skeleton::updateCoriolisAndGravityForces(std::size_t _treeIdx) const
 {
+  ensureScalesApplied();
+
   DataCache& cache = mTreeCache[_treeIdx];
   std::size_t dof = cache.mDofs.size();
   assert(static_cast<std::size_t>(cache.mCg.size()) == dof);
@@ -9011,20 +10490,11 @@ void Skeleton::updateCoriolisAndGravityForces(std::size_t _treeIdx) const
 
   cache.mCg.setZero();
 
-  for (std::vector<BodyNode*>::const_iterator it = cache.mBodyNodes.begin();
-       it != cache.mBodyNodes.end();
-       ++it)
-  {
-    (*it)->updateCombinedVector();
-  }
-
-  for (std::vector<BodyNode*>::const_reverse_iterator it
-       = cache.mBodyNodes.rbegin();
-       it != cache.mBodyNodes.rend();
-       ++it)
-  {
-    (*it)->aggregateCombinedVector(cache.mCg, mAspectProperties.mGravity);
-  }
+  cache.mJointDispatch.updateCoriolisAndGravityForces(
+      cache.mBodyNodes,
+      cache.mCg,
+      mAspectProperties.mGravity,
+      mParallelDynamics);
 
   cache.mDirty.mCoriolisAndGravityForces = false;
 }
@@ -9040,6 +10510,15 @@ void Skeleton::updateCoriolisAndGravityForces() const
     return;
   }
 
+  if (std::shared_ptr<CompiledSkeletonDynamics> compiled
+      = getCompiledDynamics())
+  {
+    ensureScalesApplied();
+    compiled->computeCoriolisAndGravityForces(this, mSkelCache.mCg);
+    mSkelCache.mDirty.mCoriolisAndGravityForces = false;
+    return;
+  }
+
   mSkelCache.mCg.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -9382,14 +10861,16 @@ void Skeleton::computeForwardKinematics(
 //==============================================================================
 void Skeleton::computeForwardDynamics()
 {
+  ensureScalesApplied();
+
   // Note: Articulated Inertias will be updated automatically when
   // getArtInertiaImplicit() is called in BodyNode::updateBiasForce()
 
-  for (auto it = mSkelCache.mBodyNodes.rbegin();
-       it != mSkelCache.mBodyNodes.rend();
-       ++it)
-    (*it)->updateBiasForce(
-        mAspectProperties.mGravity, mAspectProperties.mTimeStep);
+  mSkelCache.mJointDispatch.updateBiasForce(
+      mSkelCache.mBodyNodes,
+      mAspectProperties.mGravity,
+      mAspectProperties.mTimeStep,
+      mParallelDynamics);
 
   // Forward recursion
   for (auto& bodyNode : mSkelCache.mBodyNodes)
@@ -9404,20 +10885,21 @@ void Skeleton::computeForwardDynamics()
 void Skeleton::computeInverseDynamics(
     bool _withExternalForces, bool _withDampingForces, bool _withSpringForces)
 {
+  ensureScalesApplied();
+
   // Skip immobile or 0-dof skeleton
   if (getNumDofs() == 0)
     return;
 
   // Backward recursion
-  for (auto it = mSkelCache.mBodyNodes.rbegin();
-       it != mSkelCache.mBodyNodes.rend();
-       ++it)
-  {
-    (*it)->updateTransmittedForceID(
-        mAspectProperties.mGravity, _withExternalForces);
-    (*it)->updateJointForceID(
-        mAspectProperties.mTimeStep, _withDampingForces, _withSpringForces);
-  }
+  mSkelCache.mJointDispatch.updateInverseDynamics(
+      mSkelCache.mBodyNodes,
+      mAspectProperties.mGravity,
+      _withExternalForces,
+      mAspectProperties.mTimeStep,
+      _withDampingForces,
+      _withSpringForces,
+      mParallelDynamics);
 }
 
 //==============================================================================
@@ -9453,6 +10935,46 @@ void Skeleton::dirtyArticulatedInertia(std::size_t _treeIdx)
   SET_FLAG(_treeIdx, mCoriolisAndGravityForces);
 }
 
+//==============================================================================
+void Skeleton::dirtyArticulatedInertiaForPositions(const BodyNode* _bodyNode)
+{
+  const std::size_t tree = _bodyNode->mTreeIndex;
+  DataCache& cache = mTreeCache[tree];
+  if (!cache.mDirty.mMassMatrix
+      && cache.mMassMatrixDirtyColumns.size() == cache.mDofs.size())
+  {
+    for (const BodyNode* body = _bodyNode; body != nullptr;
+         body = body->getParentBodyNode())
+    {
+      const Joint* joint = body->getParentJoint();
+      const std::size_t numDofs = joint->getNumDofs();
+      if (numDofs == 0)
+        continue;
+      const std::size_t start = joint->getIndexInTree(0);
+      // The ancestors of a dirty column are always dirty already
+      if (cache.mMassMatrixDirtyColumns[start])
+        break;
+      for (std::size_t i = 0; i < numDofs; i++)
+        cache.mMassMatrixDirtyColumns[start + i] = true;
+      cache.mAnyMassMatrixColumnDirty = true;
+    }
+  }
+  else
+  {
+    cache.mDirty.mMassMatrix = true;
+  }
+  mSkelCache.mDirty.mMassMatrix = true;
+
+  // Everything else here depends on the configuration of the whole tree
+  SET_FLAG(tree, mArticulatedInertia);
+  SET_FLAG(tree, mAugMassMatrix);
+  SET_FLAG(tree, mInvMassMatrix);
+  SET_FLAG(tree, mInvAugMassMatrix);
+  SET_FLAG(tree, mCoriolisForces);
+  SET_FLAG(tree, mGravityForces);
+  SET_FLAG(tree, mCoriolisAndGravityForces);
+}
+
 //==============================================================================
 void Skeleton::notifySupportUpdate(std::size_t _treeIdx)
 {
@@ -9911,6 +11433,7 @@ Skeleton::DirtyFlags::DirtyFlags()
     mSupport(true),
     mDofParentMap(true),
     mJointParentMap(true),
+    mKinematicsContext(true),
     mSupportVersion(0)
 {
   // Do nothing
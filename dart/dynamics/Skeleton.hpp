@@ -33,14 +33,19 @@
 #ifndef DART_DYNAMICS_SKELETON_HPP_
 #define DART_DYNAMICS_SKELETON_HPP_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 
+#include <Eigen/SparseCore>
+
+#include "dart/common/Memory.hpp"
 #include "dart/common/NameManager.hpp"
 #include "dart/common/VersionCounter.hpp"
 #include "dart/dynamics/EndEffector.hpp"
 #include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/JointDispatchTable.hpp"
 #include "dart/dynamics/Marker.hpp"
 #include "dart/dynamics/MetaSkeleton.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
@@ -56,10 +61,13 @@ namespace dart {
 
 namespace neural {
 class ConstrainedGroupGradientMatrices;
+class WithRespectToMass;
 }
 
 namespace dynamics {
 
+class CompiledSkeletonDynamics;
+
 typedef std::map<std::string, std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
     MarkerMap;
 
@@ -315,6 +323,42 @@ public:
   /// Return true if self-collision check is enabled including adjacent bodies.
   bool isEnabledAdjacentBodyCheck() const;
 
+  /// Return true if the BodyNodes at indices i and j of this skeleton are
+  /// connected by a Joint. This reads a bitset that's rebuilt whenever
+  /// BodyNodes are added or removed, so collision filters can call it for
+  /// every candidate pair.
+  bool areBodyNodesAdjacent(std::size_t i, std::size_t j) const;
+
+  /// This samples `numSamples` random poses within the joint limits, and
+  /// records every pair of BodyNodes whose collision shape AABBs, grown by
+  /// `margin` to cover the motion between samples, overlap in any of them (or
+  /// in the current pose). From then on BodyNodeCollisionFilter skips every
+  /// other pair of this skeleton's BodyNodes, so self-collision only pays for
+  /// pairs that can actually touch. Joints without limits are sampled within
+  /// pi of their current position. The pairs are copied to clones, and
+  /// cleared whenever BodyNodes are added or removed. Rerun this after
+  /// rescaling bodies or changing joint limits.
+  void computeSelfCollisionPairs(int numSamples = 1000, s_t margin = 0.05);
+
+  /// This forgets the pairs from computeSelfCollisionPairs(), so that every
+  /// pair of BodyNodes can self-collide again
+  void clearSelfCollisionPairs();
+
+  /// Returns true if computeSelfCollisionPairs() has been run since the last
+  /// structural change
+  bool hasSelfCollisionPairs() const;
+
+  /// Returns true if the BodyNodes at indices i and j may come into contact,
+  /// according to computeSelfCollisionPairs(). If that hasn't been run, this
+  /// is always true.
+  bool canBodyNodesSelfCollide(std::size_t i, std::size_t j) const;
+
+  /// Returns the (i < j) index pairs of BodyNodes that may come into contact,
+  /// according to computeSelfCollisionPairs(), or every pair if that hasn't
+  /// been run.
+  std::vector<std::pair<std::size_t, std::size_t>> getSelfCollisionPairs()
+      const;
+
   /// Set whether this skeleton will be updated by forward dynamics.
   /// \param[in] _isMobile True if this skeleton is mobile.
   void setMobile(bool _isMobile);
@@ -569,6 +613,32 @@ public:
   /// This is computed in bulk, and cached in the skeleton.
   const Eigen::MatrixXi& getJointParentMap();
 
+  /// This holds the pieces of kinematic state that the marker and joint
+  /// Jacobians all share: the world screw axis of every DOF, and which DOFs
+  /// move which bodies. It's valid for one pose and scale setting.
+  struct KinematicsContext
+  {
+    /// The joint each DOF belongs to
+    std::vector<Joint*> dofJoints;
+
+    /// The index of each DOF within its joint
+    std::vector<int> dofIndexInJoint;
+
+    /// The index of each DOF's joint in this skeleton
+    std::vector<int> dofJointIndices;
+
+    /// The world screw axis of each DOF, at the current pose
+    common::aligned_vector<Eigen::Vector6s> dofScrews;
+
+    /// bodyDependsOnDof(b, i) == 1 if moving DOF i moves BodyNode b
+    Eigen::MatrixXi bodyDependsOnDof;
+  };
+
+  /// This returns the KinematicsContext for the current pose and scales. It's
+  /// built on first use, and reused by every later query until something
+  /// (setPositions(), setScale(), ...) moves a body in this skeleton.
+  const KinematicsContext& getKinematicsContext() const;
+
   /// \}
 
   //----------------------------------------------------------------------------
@@ -596,6 +666,29 @@ public:
   /// This gives the unconstrained Jacobian giving the difference in C(pos, vel)
   Eigen::MatrixXs getVelCJacobian();
 
+  /// The Jacobians of the unconstrained dynamics that a backprop step needs.
+  /// Everything else comes from sums and products of these: the Jacobian of
+  /// inverse dynamics wrt position is dMddq_dq + dC_dq, and the Jacobian of
+  /// M^{-1}f wrt position is -M^{-1} * dMddq_dq at ddq = M^{-1}f.
+  struct DynamicsJacobians
+  {
+    /// d(M(q) * ddq)/dq, at the ddq passed to computeDynamicsJacobians()
+    Eigen::MatrixXs dMddq_dq;
+
+    /// d(C(q, dq))/dq
+    Eigen::MatrixXs dC_dq;
+
+    /// d(C(q, dq))/d(dq)
+    Eigen::MatrixXs dC_dv;
+  };
+
+  /// This fills in every DynamicsJacobians term in one forward and one
+  /// backward sweep over the tree. That's cheaper than getJacobianOfM() plus
+  /// getJacobianOfC() for both POSITION and VELOCITY, which repeat the
+  /// recursion and the joint Jacobian derivatives three times.
+  void computeDynamicsJacobians(
+      const Eigen::VectorXs& ddq, DynamicsJacobians& jacobians);
+
 #ifdef DART_DEBUG_ANALYTICAL_DERIV
   struct DiffC
   {
@@ -643,6 +736,16 @@ public:
   Eigen::MatrixXs getJacobianOfID(
       const Eigen::VectorXs& x, neural::WithRespectTo* wrt);
 
+  /// This gives the Jacobian of the inverse dynamics M*ddq (plus C(pos, vel)
+  /// if `includeBiasForces`) with respect to the inertial parameters in `wrt`.
+  /// The inverse dynamics are linear in each body's spatial inertia, so every
+  /// column comes out of a single pass over the registered bodies, instead of
+  /// one perturbed inverse dynamics solve per parameter.
+  Eigen::MatrixXs getJacobianOfIDWrtInertia(
+      const Eigen::VectorXs& ddq,
+      neural::WithRespectToMass* wrt,
+      bool includeBiasForces);
+
 #ifdef DART_DEBUG_ANALYTICAL_DERIV
   struct DiffMinv
   {
@@ -784,6 +887,26 @@ public:
   Eigen::VectorXs finiteDifferenceGradientOfLowestPointWrtJoints(
       Eigen::Vector3s up = Eigen::Vector3s::UnitY());
 
+  /// This returns, for each marker, the squared distance to the closest mesh
+  /// vertex on the body it's attached to, measured in that body's local frame.
+  /// This is a batched BodyNode::getDistToClosestVerticesToMarker().
+  Eigen::VectorXs getDistToClosestVerticesToMarkers(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers);
+
+  /// This returns the Jacobian of getDistToClosestVerticesToMarkers() with
+  /// respect to the concatenated marker offsets. Each marker only moves its
+  /// own distance, so this is block diagonal.
+  Eigen::MatrixXs getGradientOfDistToClosestVerticesToMarkersWrtMarkers(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers);
+
+  /// This returns the Jacobian of getDistToClosestVerticesToMarkers() with
+  /// respect to the body scales, laid out like getBodyScales()
+  Eigen::MatrixXs getGradientOfDistToClosestVerticesToMarkersWrtBodyScales(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers);
+
   //----------------------------------------------------------------------------
   // Randomness
   //----------------------------------------------------------------------------
@@ -909,6 +1032,65 @@ public:
   // Sets all the link scales for the skeleton, from a flat vector
   void setBodyScales(Eigen::VectorXs scales);
 
+  /// When this is on, BodyNode::setScale() (and so setBodyScales() and
+  /// setGroupScales()) only updates the joint offsets, which is all that
+  /// kinematics needs. Rescaling each body's shapes and inertia is put off
+  /// until something asks for them: the inertia, COM or shape node getters on
+  /// that body, any of the dynamics caches, collision checks, rendering, or an
+  /// explicit call to applyDeferredScales(). This is meant for scale-search
+  /// loops that call setGroupScales() thousands of times and only look at
+  /// joint and marker positions. Turning this off applies any pending scales.
+  void setDeferScaleUpdates(bool defer);
+
+  /// Returns true if scale changes are only applied to shapes and inertia
+  /// lazily. See setDeferScaleUpdates().
+  bool getDeferScaleUpdates() const;
+
+  /// This rescales the shapes and inertia of every body whose scale changed
+  /// while setDeferScaleUpdates() was on. This is cheap if nothing is pending.
+  void applyDeferredScales() const;
+
+  /// When this is on (the default), the articulated inertia, forward and
+  /// inverse dynamics, and Coriolis and gravity passes split any level of the
+  /// tree with at least JointDispatchTable::PARALLEL_MIN_LEVEL_WIDTH bodies
+  /// over the global common::ThreadPool. Narrower skeletons always run
+  /// sequentially, so this only matters for very wide models.
+  void setParallelDynamics(bool parallel);
+
+  /// Returns true if wide levels of the dynamics passes get split over
+  /// threads. See setParallelDynamics().
+  bool getParallelDynamics() const;
+
+  /// When this is on, every BodyNode and Joint created for this Skeleton from
+  /// then on (by createJointAndBodyNodePair(), by cloning, or by copying a
+  /// tree of BodyNodes in) goes into one SkeletonArena, back to back in the
+  /// order they're created, instead of each getting its own heap allocation.
+  /// That order is parents before children, and depth first for skeletons
+  /// built by the parsers or by cloning, so the recursive dynamics passes
+  /// walk through memory front to back. Clones inherit this setting, so the
+  /// way to compact an existing Skeleton is to turn this on and clone it.
+  /// It's off by default.
+  void setCompactStorage(bool compact);
+
+  /// Returns true if new BodyNodes and Joints are placed in this Skeleton's
+  /// arena. See setCompactStorage().
+  bool getCompactStorage() const;
+
+  /// When this is on (the default) and a CompiledSkeletonDynamics has been
+  /// registered for this Skeleton's signature, the mass matrix, the Coriolis
+  /// and gravity forces, and their Jacobians with respect to position and
+  /// velocity all come from the generated code instead of the generic
+  /// recursions.
+  void setCompiledDynamicsEnabled(bool enabled);
+
+  /// Returns true if this Skeleton uses generated code when it's available.
+  /// See setCompiledDynamicsEnabled().
+  bool getCompiledDynamicsEnabled() const;
+
+  /// This returns the generated dynamics this Skeleton currently dispatches
+  /// to, or nullptr if there aren't any (or they're disabled)
+  std::shared_ptr<CompiledSkeletonDynamics> getCompiledDynamics() const;
+
   // This sets all the positions of the joints to within their limit range, if
   // they're currently outside it.
   void clampPositionsToLimits();
@@ -1025,6 +1207,22 @@ public:
       const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
           markers);
 
+  /// This is getJointWorldPositionsJacobianWrtGroupScales(), but sparse. Each
+  /// joint only moves with the scales of the bodies above it in the tree, so
+  /// this only visits those, rather than every body for every joint.
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+  getJointWorldPositionsJacobianWrtGroupScalesSparse(
+      const std::vector<dynamics::Joint*>& joints);
+
+  /// This is getMarkerWorldPositionsJacobianWrtGroupScales(), but sparse. Each
+  /// marker only moves with the scales of its body and the bodies above it in
+  /// the tree, so this only visits those, rather than every body for every
+  /// marker.
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+  getMarkerWorldPositionsJacobianWrtGroupScalesSparse(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers);
+
   /// This gets the Jacobian of leftMultiply.transpose()*J with respect to group
   /// scales
   Eigen::MatrixXs getMarkerWorldPositionsSecondJacobianWrtJointWrtGroupScales(
@@ -1091,6 +1289,33 @@ public:
   // in vector unchanged.
   Eigen::VectorXs convertPositionsFromBallSpace(Eigen::VectorXs pos);
 
+  // This is convertPositionsToBallSpace() for every column of `poses`, for
+  // converting whole trials at once. The rotation math for each joint runs
+  // as one batched kernel across all the frames.
+  Eigen::MatrixXs convertPositionsToBallSpaceBatch(
+      const Eigen::MatrixXs& poses);
+
+  // This is convertPositionsFromBallSpace() for every column of `poses`,
+  // batched the same way as convertPositionsToBallSpaceBatch().
+  Eigen::MatrixXs convertPositionsFromBallSpaceBatch(
+      const Eigen::MatrixXs& poses);
+
+  /// This fills `transforms` with the world transform of every BodyNode, in
+  /// the order of getBodyNodes(). Since every parent comes before its
+  /// children, each body only costs one multiply onto its parent's (already
+  /// updated) transform, instead of each caller walking up the tree. The
+  /// BodyNodes' own cached world transforms get brought up to date too.
+  void getBodyWorldTransforms(
+      common::aligned_vector<Eigen::Isometry3s>& transforms) const;
+
+  /// This fills `transforms` with the world transform of every ShapeNode, body
+  /// by body in the order of getBodyNodes(), and in the order each BodyNode
+  /// lists them within a body. `shapeNodes` gets the ShapeNode that each
+  /// transform belongs to. Any deferred scales get applied first.
+  void getShapeNodeWorldTransforms(
+      std::vector<const ShapeNode*>& shapeNodes,
+      common::aligned_vector<Eigen::Isometry3s>& transforms) const;
+
   //----------------------------------------------------------------------------
   // IK for retargetting (especially between similar but not identical human
   // skeletons)
@@ -1115,6 +1340,23 @@ public:
   Eigen::MatrixXs getJointWorldPositionsJacobianWrtJointPositions(
       const std::vector<dynamics::Joint*>& joints) const;
 
+  /// This returns the world positions of each joint (like
+  /// getJointWorldPositions()) for every column of `poses`, as a (3 * joints)
+  /// by T matrix. Frames are evaluated in parallel on copies of this skeleton,
+  /// so this skeleton's own state is left untouched.
+  Eigen::MatrixXs getJointWorldPositionsBatch(
+      const std::vector<dynamics::Joint*>& joints,
+      const Eigen::MatrixXs& poses) const;
+
+  /// This returns getJointWorldPositionsJacobianWrtJointPositions() for every
+  /// column of `poses`, one block per frame. Like
+  /// getJointWorldPositionsBatch(), this runs in parallel and doesn't change
+  /// this skeleton's state.
+  std::vector<Eigen::MatrixXs>
+  getJointWorldPositionsJacobianWrtJointPositionsBatch(
+      const std::vector<dynamics::Joint*>& joints,
+      const Eigen::MatrixXs& poses) const;
+
   /// This returns the Jacobian relating changes in source skeleton joint
   /// positions to changes in source joint world positions.
   Eigen::MatrixXs finiteDifferenceJointWorldPositionsJacobianWrtJointPositions(
@@ -1164,6 +1406,33 @@ public:
       const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
           markers) const;
 
+  /// This returns, for each row of
+  /// getMarkerWorldPositionsJacobianWrtJointPositions(), the DOFs that can
+  /// have non-zero entries: the DOFs between the marker's body and the root.
+  /// This is the structure IKConfig::setJacobianSparsity() expects.
+  std::vector<std::vector<int>> getMarkerJacobianSparsity(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers) const;
+
+  /// This returns the world positions of each marker (like
+  /// getMarkerWorldPositions()) for every column of `poses`, as a
+  /// (3 * markers) by T matrix. Frames are evaluated in parallel on copies of
+  /// this skeleton, so this skeleton's own state is left untouched.
+  Eigen::MatrixXs getMarkerWorldPositionsBatch(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::MatrixXs& poses) const;
+
+  /// This returns getMarkerWorldPositionsJacobianWrtJointPositions() for
+  /// every column of `poses`, one block per frame. Like
+  /// getMarkerWorldPositionsBatch(), this runs in parallel and doesn't change
+  /// this skeleton's state.
+  std::vector<Eigen::MatrixXs>
+  getMarkerWorldPositionsJacobianWrtJointPositionsBatch(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::MatrixXs& poses) const;
+
   /// This returns the Jacobian relating changes in joint
   /// positions to changes in marker world positions.
   Eigen::MatrixXs finiteDifferenceMarkerWorldPositionsJacobianWrtJointPositions(
@@ -1207,6 +1476,62 @@ public:
           markers,
       Eigen::VectorXs goal);
 
+  /// This gets the product of the Hessian of ||f(q) - x||^2 with respect to q
+  /// with `direction`, without forming the Hessian. It's one pass over the
+  /// markers and DOFs, so it costs about as much as the gradient.
+  Eigen::VectorXs
+  getMarkerWorldPositionDiffToGoalHessianVectorProductWrtJointPos(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::VectorXs& goal,
+      const Eigen::VectorXs& direction);
+
+  /// This gets the product of the Hessian of ||f(q) - x||^2 with respect to q
+  /// with `direction`, by finite differencing the gradient
+  Eigen::VectorXs
+  finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtJointPos(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::VectorXs& goal,
+      const Eigen::VectorXs& direction);
+
+  /// This gets the product of the Hessian of ||f(s) - x||^2 with respect to
+  /// body scales with `direction`. Marker positions are linear in the body
+  /// scales, so this is exactly the Gauss-Newton product and doesn't depend on
+  /// the goal.
+  Eigen::VectorXs
+  getMarkerWorldPositionDiffToGoalHessianVectorProductWrtBodyScales(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::VectorXs& direction);
+
+  /// This gets the product of the Hessian of ||f(s) - x||^2 with respect to
+  /// body scales with `direction`, by finite differencing the gradient
+  Eigen::VectorXs
+  finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtBodyScales(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::VectorXs& goal,
+      const Eigen::VectorXs& direction);
+
+  /// This gets the product of the Hessian of ||f(o) - x||^2 with respect to
+  /// marker offsets with `direction`. Marker positions are linear in the
+  /// offsets, so like the body scales this doesn't depend on the goal.
+  Eigen::VectorXs
+  getMarkerWorldPositionDiffToGoalHessianVectorProductWrtMarkerOffsets(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::VectorXs& direction) const;
+
+  /// This gets the product of the Hessian of ||f(o) - x||^2 with respect to
+  /// marker offsets with `direction`, by finite differencing the gradient
+  Eigen::VectorXs
+  finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtMarkerOffsets(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const Eigen::VectorXs& goal,
+      const Eigen::VectorXs& direction);
+
   /// This should be equivalent to
   /// `getMarkerWorldPositionsJacobianWrtJointPositions`, just slower. This is
   /// here so there's a simple non-recursive formula for the Jacobian to take
@@ -1890,6 +2215,27 @@ public:
   // Get Spring Forces
   Eigen::VectorXs getSpringForce();
 
+  /// This returns the diagonal H = dt * D + dt^2 * K that implicit spring and
+  /// damper integration adds to the mass matrix, with zeros for DOFs of
+  /// kinematic joints (whose accelerations are prescribed).
+  Eigen::VectorXs getImplicitSpringDampingDiagonal(s_t dt);
+
+  /// This returns M + H (see getImplicitSpringDampingDiagonal()). Rows and
+  /// columns of kinematic DOFs are replaced by the identity, so solving against
+  /// this never changes a prescribed acceleration.
+  Eigen::MatrixXs getImplicitSpringDampingMassMatrix(s_t dt);
+
+  /// This replaces the accelerations left by computeForwardDynamics() with
+  /// the ones from treating joint springs and damping implicitly (linearized
+  /// backward Euler) over a step of length `dt`. That solves
+  ///
+  ///   (M + dt * D + dt^2 * K) ddq = tau - C - D dq - K (q - q_rest + dt dq)
+  ///
+  /// instead of the same system without the dt terms on the left, which stays
+  /// stable for stiff springs and heavy damping at much larger timesteps. This
+  /// does nothing if no DOF has a spring or a damper.
+  void applyImplicitSpringDamping(s_t dt);
+
   /// Get constraint force vector for a tree
   const Eigen::VectorXs& getConstraintForces(std::size_t _treeIdx) const;
 
@@ -1911,6 +2257,13 @@ public:
   /// needs to be updated
   void dirtyArticulatedInertia(std::size_t _treeIdx);
 
+  /// This is like dirtyArticulatedInertia(), for when only the positions of
+  /// _bodyNode's parent Joint have changed. In generalized coordinates, that
+  /// only changes the mass matrix columns (and rows) for that Joint's DOFs
+  /// and its ancestors' DOFs, so the rest of the tree's mass matrix is kept
+  /// and only those columns get recomputed.
+  void dirtyArticulatedInertiaForPositions(const BodyNode* _bodyNode);
+
   /// Notify that the support polygon of a tree needs to be updated
   DART_DEPRECATED(6.2)
   void notifySupportUpdate(std::size_t _treeIdx);
@@ -2013,6 +2366,21 @@ public:
 protected:
   struct DataCache;
 
+  /// This returns the index in the group scales vector that each body scale
+  /// (laid out like getBodyScales()) feeds into, or -1 if it's in no group
+  std::vector<int> getGroupScaleIndexForBodyScales();
+
+  /// This appends the 3 x 1 Jacobian column of a point wrt `node`'s scale
+  /// along `axis` to `triplets`, at row `row` and the group column that scale
+  /// belongs to
+  void addGroupScaleJacobianColumn(
+      std::vector<Eigen::Triplet<s_t>>& triplets,
+      const std::vector<int>& groupIndex,
+      int row,
+      const dynamics::BodyNode* node,
+      int axis,
+      const Eigen::Vector3s& column);
+
   /// Constructor called by create()
   Skeleton(const AspectPropertiesData& _properties);
 
@@ -2102,6 +2470,13 @@ protected:
   /// Update the computation for total mass
   void updateTotalMass();
 
+  /// This is just applyDeferredScales() with a cheap early out, for the
+  /// dynamics cache updates to call first
+  void ensureScalesApplied() const;
+
+  /// Rebuild mAdjacentBodyBits from the current parent of each BodyNode
+  void updateAdjacentBodyBits();
+
   /// Update the dimensions for a specific cache
   void updateCacheDimensions(DataCache& _cache);
 
@@ -2242,6 +2617,9 @@ protected:
     bool mDofParentMap;
     bool mJointParentMap;
 
+    /// Dirty flag for the KinematicsContext
+    bool mKinematicsContext;
+
     /// Increments each time a new support polygon is computed to help keep
     /// track of changes in the support polygon
     std::size_t mSupportVersion;
@@ -2257,6 +2635,10 @@ protected:
     /// Cache for const BodyNodes, for the sake of the API
     std::vector<const BodyNode*> mConstBodyNodes;
 
+    /// The level-order schedule of mBodyNodes that the articulated body passes
+    /// run through
+    JointDispatchTable mJointDispatch;
+
     /// Degrees of Freedom belonging to this tree
     std::vector<DegreeOfFreedom*> mDofs;
 
@@ -2266,6 +2648,15 @@ protected:
     /// Mass matrix cache
     Eigen::MatrixXs mM;
 
+    /// If mDirty.mMassMatrix is false, this marks the columns of mM that are
+    /// out of date anyway, because the positions of that DOF or one of its
+    /// descendants have changed. A dirty column's ancestors are always dirty
+    /// too.
+    std::vector<bool> mMassMatrixDirtyColumns;
+
+    /// True if any of mMassMatrixDirtyColumns is set
+    bool mAnyMassMatrixColumnDirty = false;
+
     /// Mass matrix for the skeleton.
     Eigen::MatrixXs mAugM;
 
@@ -2312,6 +2703,9 @@ protected:
     Eigen::MatrixXi mDofParentMap;
     Eigen::MatrixXi mJointParentMap;
 
+    /// The shared kinematic state for the marker and joint Jacobians
+    KinematicsContext mKinematicsContext;
+
     /// A shared pointer to the saved gradient matrices for the ConstrainedGroup
     /// this skeleton was part of in the last LCP solve.
     std::shared_ptr<neural::ConstrainedGroupGradientMatrices>
@@ -2333,6 +2727,38 @@ protected:
   /// Total mass.
   s_t mTotalMass;
 
+  /// See setDeferScaleUpdates()
+  bool mDeferScaleUpdates;
+
+  /// True if some BodyNode has a scale whose shapes and inertia haven't been
+  /// updated yet
+  mutable bool mHasDeferredScales;
+
+  /// See setParallelDynamics()
+  bool mParallelDynamics;
+
+  /// See setCompactStorage(). We hold one reference on this, and every object
+  /// allocated in it holds another.
+  SkeletonArena* mArena;
+
+  /// See setCompiledDynamicsEnabled()
+  bool mCompiledDynamicsEnabled;
+
+  /// The result of the last registry lookup for this Skeleton. It's redone
+  /// when the registry changes (mCompiledDynamicsVersion is one past the
+  /// registry version it was looked up at, or 0 if it's stale) or when the
+  /// structure of the Skeleton changes.
+  mutable std::shared_ptr<CompiledSkeletonDynamics> mCompiledDynamics;
+  mutable std::size_t mCompiledDynamicsVersion;
+
+  /// A symmetric N x N bitset of which BodyNodes share a Joint, with each row
+  /// padded to a whole number of 64 bit words
+  std::vector<std::uint64_t> mAdjacentBodyBits;
+
+  /// A symmetric bitset, laid out like mAdjacentBodyBits, of which BodyNodes
+  /// may come into contact. This is empty until computeSelfCollisionPairs().
+  std::vector<std::uint64_t> mSelfCollisionPairBits;
+
   // TODO(JS): Better naming
   /// Flag for status of impulse testing.
   bool mIsImpulseApplied;
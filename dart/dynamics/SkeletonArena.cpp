@@ -0,0 +1,182 @@
+#include "dart/dynamics/SkeletonArena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+// Every object gets a header this big in front of it, holding the arena it
+// came from (or nullptr for the heap), so that the object itself stays as
+// aligned as Eigen needs it to be
+constexpr std::size_t kAlign = EIGEN_MAX_ALIGN_BYTES > 16
+                                   ? (std::size_t)EIGEN_MAX_ALIGN_BYTES
+                                   : (std::size_t)16;
+
+std::size_t roundUp(std::size_t size)
+{
+  return (size + kAlign - 1) / kAlign * kAlign;
+}
+
+thread_local SkeletonArena* gCurrentArena = nullptr;
+
+} // namespace
+
+//==============================================================================
+/// This creates an arena with one reference, held by the caller
+SkeletonArena* SkeletonArena::create(std::size_t blockSize)
+{
+  return new SkeletonArena(blockSize);
+}
+
+//==============================================================================
+SkeletonArena::SkeletonArena(std::size_t blockSize)
+  : mBlockSize(roundUp(std::max(blockSize, (std::size_t)1024))),
+    mReferences(1),
+    mCursor(0),
+    mBytesUsed(0)
+{
+}
+
+//==============================================================================
+SkeletonArena::~SkeletonArena()
+{
+  for (char* block : mBlocks)
+  {
+    Eigen::internal::conditional_aligned_free<true>(block);
+  }
+}
+
+//==============================================================================
+/// This adds a reference to the arena
+void SkeletonArena::acquire()
+{
+  mReferences.fetch_add(1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+/// This drops a reference to the arena, and frees it if that was the last one
+void SkeletonArena::release()
+{
+  if (mReferences.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    delete this;
+  }
+}
+
+//==============================================================================
+/// This returns the number of bytes handed out so far
+std::size_t SkeletonArena::getBytesUsed() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mBytesUsed;
+}
+
+//==============================================================================
+/// This returns the number of blocks the arena has allocated
+std::size_t SkeletonArena::getNumBlocks() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mBlocks.size();
+}
+
+//==============================================================================
+/// This returns true if `object` (as returned by allocateObject()) lives in
+/// this arena
+bool SkeletonArena::owns(const void* object) const
+{
+  if (object == nullptr)
+    return false;
+  const SkeletonArena* const* header
+      = reinterpret_cast<const SkeletonArena* const*>(
+          static_cast<const char*>(object) - kAlign);
+  return *header == this;
+}
+
+//==============================================================================
+SkeletonArena::Scope::Scope(SkeletonArena* arena) : mPrevious(gCurrentArena)
+{
+  gCurrentArena = arena;
+}
+
+//==============================================================================
+SkeletonArena::Scope::~Scope()
+{
+  gCurrentArena = mPrevious;
+}
+
+//==============================================================================
+/// This returns the arena of the innermost active Scope on this thread, or
+/// nullptr
+SkeletonArena* SkeletonArena::getCurrent()
+{
+  return gCurrentArena;
+}
+
+//==============================================================================
+/// This is the operator new of BodyNode and Joint. It allocates from the
+/// current arena if there is one, and from the (aligned) heap otherwise.
+void* SkeletonArena::allocateObject(std::size_t size)
+{
+  SkeletonArena* arena = gCurrentArena;
+  char* raw;
+  if (arena == nullptr)
+  {
+    raw = static_cast<char*>(
+        Eigen::internal::conditional_aligned_malloc<true>(kAlign + size));
+  }
+  else
+  {
+    raw = static_cast<char*>(arena->allocateRaw(kAlign + size));
+    arena->acquire();
+  }
+  *reinterpret_cast<SkeletonArena**>(raw) = arena;
+  return raw + kAlign;
+}
+
+//==============================================================================
+/// This is the operator delete of BodyNode and Joint
+void SkeletonArena::deallocateObject(void* object)
+{
+  if (object == nullptr)
+    return;
+  char* raw = static_cast<char*>(object) - kAlign;
+  SkeletonArena* arena = *reinterpret_cast<SkeletonArena**>(raw);
+  if (arena == nullptr)
+  {
+    Eigen::internal::conditional_aligned_free<true>(raw);
+  }
+  else
+  {
+    // The memory itself goes back when the whole arena does
+    arena->release();
+  }
+}
+
+//==============================================================================
+/// This carves `size` bytes, aligned for Eigen, off the end of the last block,
+/// starting a new block if it doesn't fit
+void* SkeletonArena::allocateRaw(std::size_t size)
+{
+  size = roundUp(size);
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mBlocks.empty() || mCursor + size > mBlockSizes.back())
+  {
+    // Anything bigger than a block gets a block of its own
+    const std::size_t blockSize = std::max(mBlockSize, size);
+    char* block = static_cast<char*>(
+        Eigen::internal::conditional_aligned_malloc<true>(blockSize));
+    mBlocks.push_back(block);
+    mBlockSizes.push_back(blockSize);
+    mCursor = 0;
+  }
+  void* result = mBlocks.back() + mCursor;
+  mCursor += size;
+  mBytesUsed += size;
+  return result;
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,145 @@
+#ifndef DART_DYNAMICS_SKELETONARENA_HPP_
+#define DART_DYNAMICS_SKELETONARENA_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace dart {
+namespace dynamics {
+
+/// This is a bump allocator for the BodyNodes and Joints of one Skeleton.
+/// While a SkeletonArena::Scope is active on a thread, every BodyNode and
+/// Joint created on that thread is placed in the arena, right after the one
+/// created before it, instead of getting its own heap allocation. Everything
+/// a BodyNode or Joint keeps inline (transforms, velocities, articulated
+/// inertias, Jacobians, and the other spatial caches the dynamics passes
+/// read) comes along with it, so a Skeleton built in one pass ends up as one
+/// run of memory, in the order the passes walk it.
+///
+/// Objects in the arena are deleted as usual, but their memory only goes
+/// back to the system once every object in the arena is gone and the last
+/// owner has called release(). Objects can outlive the Skeleton they were
+/// created for (e.g. when moved to another Skeleton), since each of them
+/// holds a reference on the arena.
+class SkeletonArena
+{
+public:
+  /// This creates an arena with one reference, held by the caller
+  static SkeletonArena* create(std::size_t blockSize = 64 * 1024);
+
+  /// This adds a reference to the arena
+  void acquire();
+
+  /// This drops a reference to the arena, and frees it if that was the last
+  /// one
+  void release();
+
+  /// This returns the number of bytes handed out so far
+  std::size_t getBytesUsed() const;
+
+  /// This returns the number of blocks the arena has allocated
+  std::size_t getNumBlocks() const;
+
+  /// This returns true if `object` (as returned by allocateObject()) lives in
+  /// this arena
+  bool owns(const void* object) const;
+
+  /// While one of these is alive, BodyNodes and Joints created on this thread
+  /// go into `arena`. Passing nullptr routes them to the heap, which is how
+  /// code that doesn't want an arena can opt out inside an outer Scope.
+  /// Scopes nest.
+  class Scope
+  {
+  public:
+    explicit Scope(SkeletonArena* arena);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  protected:
+    SkeletonArena* mPrevious;
+  };
+
+  /// This returns the arena of the innermost active Scope on this thread, or
+  /// nullptr
+  static SkeletonArena* getCurrent();
+
+  /// This is the operator new of BodyNode and Joint. It allocates from the
+  /// current arena if there is one, and from the (aligned) heap otherwise.
+  static void* allocateObject(std::size_t size);
+
+  /// This is the operator delete of BodyNode and Joint
+  static void deallocateObject(void* object);
+
+protected:
+  explicit SkeletonArena(std::size_t blockSize);
+  ~SkeletonArena();
+
+  /// This carves `size` bytes, aligned for Eigen, off the end of the last
+  /// block, starting a new block if it doesn't fit
+  void* allocateRaw(std::size_t size);
+
+  std::size_t mBlockSize;
+  // Live objects, plus owners
+  std::atomic<int> mReferences;
+  mutable std::mutex mMutex;
+  std::vector<char*> mBlocks;
+  std::vector<std::size_t> mBlockSizes;
+  std::size_t mCursor;
+  std::size_t mBytesUsed;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+/// This replaces EIGEN_MAKE_ALIGNED_OPERATOR_NEW in BodyNode, Joint, and any
+/// subclass of those that needs its own operator new, so they can be placed
+/// in a SkeletonArena. Allocations are aligned just like Eigen's.
+#define DART_SKELETON_ARENA_OPERATOR_NEW                                       \
+  static void* operator new(std::size_t size)                                  \
+  {                                                                            \
+    return ::dart::dynamics::SkeletonArena::allocateObject(size);             \
+  }                                                                            \
+  static void operator delete(void* ptr) noexcept                              \
+  {                                                                            \
+    ::dart::dynamics::SkeletonArena::deallocateObject(ptr);                   \
+  }                                                                            \
+  static void* operator new(std::size_t size, const std::nothrow_t&) noexcept  \
+  {                                                                            \
+    try                                                                        \
+    {                                                                          \
+      return ::dart::dynamics::SkeletonArena::allocateObject(size);           \
+    }                                                                          \
+    catch (...)                                                                \
+    {                                                                          \
+      return nullptr;                                                          \
+    }                                                                          \
+  }                                                                            \
+  static void operator delete(void* ptr, const std::nothrow_t&) noexcept       \
+  {                                                                            \
+    ::dart::dynamics::SkeletonArena::deallocateObject(ptr);                   \
+  }                                                                            \
+  static void* operator new[](std::size_t size)                                \
+  {                                                                            \
+    return Eigen::internal::conditional_aligned_malloc<true>(size);            \
+  }                                                                            \
+  static void operator delete[](void* ptr) noexcept                            \
+  {                                                                            \
+    Eigen::internal::conditional_aligned_free<true>(ptr);                      \
+  }                                                                            \
+  static void* operator new(std::size_t, void* ptr) noexcept                   \
+  {                                                                            \
+    return ptr;                                                                \
+  }                                                                            \
+  static void operator delete(void*, void*) noexcept                           \
+  {                                                                            \
+  }                                                                            \
+  typedef void eigen_aligned_operator_new_marker_type;
+
+#endif
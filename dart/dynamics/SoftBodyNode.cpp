@@ -589,8 +589,16 @@ void SoftBodyNode::updateTransmittedForceID(
 {
   const Eigen::Matrix6s& mI
       = BodyNode::mAspectProperties.mInertia.getSpatialTensor();
-  for (auto& pointMass : mPointMasses)
+  const std::size_t numPointMasses = mPointMasses.size();
+  mPointMassPositions.resize(3, numPointMasses);
+  mPointMassForces.resize(3, numPointMasses);
+  for (std::size_t i = 0; i < numPointMasses; ++i)
+  {
+    PointMass* pointMass = mPointMasses[i];
     pointMass->updateTransmittedForceID(_gravity, _withExternalForces);
+    mPointMassPositions.col(i) = pointMass->getLocalPosition();
+    mPointMassForces.col(i) = pointMass->mF;
+  }
 
   // Gravity force
   if (BodyNode::mAspectProperties.mGravityMode == true)
@@ -625,11 +633,7 @@ void SoftBodyNode::updateTransmittedForceID(
     mF += math::dAdInvT(
         childJoint->getRelativeTransform(), childBodyNode->getBodyForce());
   }
-  for (auto& pointMass : mPointMasses)
-  {
-    mF.head<3>() += pointMass->getLocalPosition().cross(pointMass->mF);
-    mF.tail<3>() += pointMass->mF;
-  }
+  _addPointMassForces(mF);
 
   // Verification
   assert(!math::isNan(mF));
@@ -666,8 +670,18 @@ void SoftBodyNode::updateArtInertia(s_t _timeStep) const
 {
   const Eigen::Matrix6s& mI
       = BodyNode::mAspectProperties.mInertia.getSpatialTensor();
-  for (auto& pointMass : mPointMasses)
+  const std::size_t numPointMasses = mPointMasses.size();
+  mPointMassPositions.resize(3, numPointMasses);
+  mPointMassPi.resize(numPointMasses);
+  mPointMassImplicitPi.resize(numPointMasses);
+  for (std::size_t i = 0; i < numPointMasses; ++i)
+  {
+    PointMass* pointMass = mPointMasses[i];
     pointMass->updateArtInertiaFD(_timeStep);
+    mPointMassPositions.col(i) = pointMass->getLocalPosition();
+    mPointMassPi(i) = pointMass->mPi;
+    mPointMassImplicitPi(i) = pointMass->mImplicitPi;
+  }
 
   assert(mParentJoint != nullptr);
 
@@ -686,12 +700,8 @@ void SoftBodyNode::updateArtInertia(s_t _timeStep) const
   }
 
   //
-  for (const auto& pointMass : mPointMasses)
-  {
-    _addPiToArtInertia(pointMass->getLocalPosition(), pointMass->mPi);
-    _addPiToArtInertiaImplicit(
-        pointMass->getLocalPosition(), pointMass->mImplicitPi);
-  }
+  _addPointMassesToArtInertia(mArtInertia, mPointMassPi);
+  _addPointMassesToArtInertia(mArtInertiaImplicit, mPointMassImplicitPi);
 
   // Verification
   assert(!math::isNan(mArtInertia));
@@ -712,8 +722,16 @@ void SoftBodyNode::updateBiasForce(
 {
   const Eigen::Matrix6s& mI
       = BodyNode::mAspectProperties.mInertia.getSpatialTensor();
-  for (auto& pointMass : mPointMasses)
+  const std::size_t numPointMasses = mPointMasses.size();
+  mPointMassPositions.resize(3, numPointMasses);
+  mPointMassForces.resize(3, numPointMasses);
+  for (std::size_t i = 0; i < numPointMasses; ++i)
+  {
+    PointMass* pointMass = mPointMasses[i];
     pointMass->updateBiasForceFD(_timeStep, _gravity);
+    mPointMassPositions.col(i) = pointMass->getLocalPosition();
+    mPointMassForces.col(i) = pointMass->mBeta;
+  }
 
   // Gravity force
   if (BodyNode::mAspectProperties.mGravityMode == true)
@@ -748,12 +766,7 @@ void SoftBodyNode::updateBiasForce(
   }
 
   //
-  for (const auto& pointMass : mPointMasses)
-  {
-    mBiasForce.head<3>()
-        += pointMass->getLocalPosition().cross(pointMass->mBeta);
-    mBiasForce.tail<3>() += pointMass->mBeta;
-  }
+  _addPointMassForces(mBiasForce);
 
   // Verifycation
   assert(!math::isNan(mBiasForce));
@@ -793,8 +806,16 @@ void SoftBodyNode::updateTransmittedForceFD()
 //==============================================================================
 void SoftBodyNode::updateBiasImpulse()
 {
-  for (auto& pointMass : mPointMasses)
+  const std::size_t numPointMasses = mPointMasses.size();
+  mPointMassPositions.resize(3, numPointMasses);
+  mPointMassForces.resize(3, numPointMasses);
+  for (std::size_t i = 0; i < numPointMasses; ++i)
+  {
+    PointMass* pointMass = mPointMasses[i];
     pointMass->updateBiasImpulseFD();
+    mPointMassPositions.col(i) = pointMass->getLocalPosition();
+    mPointMassForces.col(i) = pointMass->mImpBeta;
+  }
 
   // Update impulsive bias force
   mBiasImpulse = -mConstraintImpulse;
@@ -810,12 +831,7 @@ void SoftBodyNode::updateBiasImpulse()
         childBodyNode->mBiasImpulse);
   }
 
-  for (auto& pointMass : mPointMasses)
-  {
-    mBiasImpulse.head<3>()
-        += pointMass->getLocalPosition().cross(pointMass->mImpBeta);
-    mBiasImpulse.tail<3>() += pointMass->mImpBeta;
-  }
+  _addPointMassForces(mBiasImpulse);
 
   // Verification
   assert(!math::isNan(mBiasImpulse));
@@ -1287,6 +1303,44 @@ void SoftBodyNode::_addPiToArtInertiaImplicit(
   mArtInertiaImplicit(5, 5) += _ImplicitPi;
 }
 
+//==============================================================================
+void SoftBodyNode::_addPointMassesToArtInertia(
+    math::Inertia& _artInertia, const Eigen::VectorXs& _Pi) const
+{
+  // Summing _Pi * [p]^2 over the point masses, with [p]^2 = p*p^T - |p|^2*I,
+  // only needs P*diag(Pi)*P^T and its trace, where P holds the positions as
+  // columns. Likewise the sum of _Pi * [p] is the skew of P*Pi.
+  const Eigen::Matrix<s_t, 3, Eigen::Dynamic>& P = mPointMassPositions;
+  assert(P.cols() == _Pi.size());
+  const Eigen::Matrix3s weightedOuter
+      = (P.array().rowwise() * _Pi.transpose().array()).matrix()
+        * P.transpose();
+  const Eigen::Matrix3s weightedSkew = math::makeSkewSymmetric(P * _Pi);
+
+  _artInertia.topLeftCorner<3, 3>() -= weightedOuter;
+  _artInertia.topLeftCorner<3, 3>().diagonal().array()
+      += weightedOuter.trace();
+  _artInertia.topRightCorner<3, 3>() += weightedSkew;
+  _artInertia.bottomLeftCorner<3, 3>() -= weightedSkew;
+  _artInertia.bottomRightCorner<3, 3>().diagonal().array() += _Pi.sum();
+}
+
+//==============================================================================
+void SoftBodyNode::_addPointMassForces(Eigen::Vector6s& _F) const
+{
+  // Sum of p x f over the point masses, one row of the cross product at a time
+  const Eigen::Matrix<s_t, 3, Eigen::Dynamic>& P = mPointMassPositions;
+  const Eigen::Matrix<s_t, 3, Eigen::Dynamic>& f = mPointMassForces;
+  assert(P.cols() == f.cols());
+  _F(0) += (P.row(1).cwiseProduct(f.row(2)) - P.row(2).cwiseProduct(f.row(1)))
+               .sum();
+  _F(1) += (P.row(2).cwiseProduct(f.row(0)) - P.row(0).cwiseProduct(f.row(2)))
+               .sum();
+  _F(2) += (P.row(0).cwiseProduct(f.row(1)) - P.row(1).cwiseProduct(f.row(0)))
+               .sum();
+  _F.tail<3>() += f.rowwise().sum();
+}
+
 //==============================================================================
 void SoftBodyNode::updateInertiaWithPointMass()
 {
@@ -314,6 +314,19 @@ protected:
   ///
   math::Inertia mArtInertiaImplicit2;
 
+  /// Structure-of-arrays copies of the point masses' local positions and of
+  /// the per-point terms the current recursion pass needs. They are gathered
+  /// once per pass, so that folding hundreds of point masses into this node
+  /// is a few dense products instead of a 3x3 update per point mass.
+  mutable Eigen::Matrix<s_t, 3, Eigen::Dynamic> mPointMassPositions;
+
+  /// Per-point-mass forces (mF, mBeta or mImpBeta) for the current pass
+  Eigen::Matrix<s_t, 3, Eigen::Dynamic> mPointMassForces;
+
+  /// Per-point-mass mPi and mImplicitPi for the articulated inertia pass
+  mutable Eigen::VectorXs mPointMassPi;
+  mutable Eigen::VectorXs mPointMassImplicitPi;
+
 private:
   /// \brief
   void _addPiToArtInertia(const Eigen::Vector3s& _p, s_t _Pi) const;
@@ -322,6 +335,15 @@ private:
   void _addPiToArtInertiaImplicit(const Eigen::Vector3s& _p,
                                   s_t _ImplicitPi) const;
 
+  /// This is _addPiToArtInertia() summed over every point mass, using the
+  /// gathered mPointMassPositions and the per-point weights `_Pi`.
+  void _addPointMassesToArtInertia(
+      math::Inertia& _artInertia, const Eigen::VectorXs& _Pi) const;
+
+  /// Adds the spatial force of mPointMassForces, applied at
+  /// mPointMassPositions, to `_F`
+  void _addPointMassForces(Eigen::Vector6s& _F) const;
+
   ///
   void updateInertiaWithPointMass();
 };
@@ -407,6 +407,7 @@ public:
   Eigen::Vector6s getBodyConstraintWrench() const override;
 
 protected:
+  friend class JointDispatchTable;
 
   /// Constructor called by inheriting classes
   ZeroDofJoint();
@@ -62,6 +62,9 @@ public:
   /// Return the (const) Skeleton this BodyNode belongs to
   std::shared_ptr<const Skeleton> getSkeleton() const;
 
+  /// Return the number of BodyNodePtrs that currently refer to this BodyNode
+  int getReferenceCount() const;
+
 private:
 
   //--------------------------------------------------------------------------
@@ -135,6 +138,14 @@ public:
   /// Destructor. Releases the BodyNode reference before being destroyed
   ~TemplateBodyNodePtr() { set(nullptr); }
 
+  /// User defined copy-assignment. The implicit one would copy the raw
+  /// pointer without taking a reference on the BodyNode.
+  TemplateBodyNodePtr& operator = (const TemplateBodyNodePtr& _bnp)
+  {
+    set(_bnp.get());
+    return *this;
+  }
+
   /// Change the BodyNode that this BodyNodePtr references
   template <class OtherBodyNodeT>
   TemplateBodyNodePtr& operator = (
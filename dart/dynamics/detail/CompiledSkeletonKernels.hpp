@@ -0,0 +1,321 @@
+#ifndef DART_DYNAMICS_DETAIL_COMPILEDSKELETONKERNELS_HPP_
+#define DART_DYNAMICS_DETAIL_COMPILEDSKELETONKERNELS_HPP_
+
+#include <Eigen/Dense>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/CompiledSkeleton.hpp"
+#include "dart/dynamics/GenericJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/ZeroDofJoint.hpp"
+#include "dart/math/ConfigurationSpace.hpp"
+#include "dart/math/Geometry.hpp"
+
+// These are the building blocks that the code from
+// CompiledSkeletonDynamics::generateSource() is made of. Each one handles a
+// single body with its number of DOFs known at compile time. The generated
+// code calls them in a fixed order for a fixed tree, so they're all small
+// enough to inline.
+//
+// Everything is in the body frame, with the same conventions as BodyNode:
+// spatial vectors are [angular, linear], and each body's relative transform T
+// takes points in its frame to its parent's.
+
+namespace dart {
+namespace dynamics {
+namespace compiled {
+
+/// Everything the passes need to know about one body with N DOFs
+template <int N>
+struct Body
+{
+  using JacobianMatrix = Eigen::Matrix<s_t, 6, N>;
+  using Vector = Eigen::Matrix<s_t, N, 1>;
+
+  const Joint* joint;
+  Eigen::Isometry3s T;
+  JacobianMatrix S;
+  JacobianMatrix dS;
+  // The Jacobian of T with respect to the joint's positions, rather than its
+  // velocities. This is the same as S, except for joints like BallJoint and
+  // FreeJoint, whose positions and velocities live in different spaces.
+  JacobianMatrix H;
+  Vector dq;
+  Vector ddq;
+  const Eigen::Matrix6s* G;
+  bool gravityMode;
+
+  // The forward pass fills these in. parentV and parentA are the parent's
+  // velocity and acceleration, moved into this body's frame. After the
+  // backward pass, F holds the force transmitted through the parent joint.
+  Eigen::Vector6s parentV;
+  Eigen::Vector6s parentA;
+  Eigen::Vector6s V;
+  Eigen::Vector6s A;
+  Eigen::Vector3s g;
+  Eigen::Vector6s F;
+
+  // The tangent passes use these, for one coordinate at a time. dSl is the
+  // derivative of S with respect to the coordinate, when it belongs to this
+  // body's joint.
+  Eigen::Vector6s tV;
+  Eigen::Vector6s tA;
+  Eigen::Vector3s tg;
+  Eigen::Vector6s tF;
+  JacobianMatrix dSl;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//==============================================================================
+/// This reads a body whose parent joint is a GenericJoint<ConfigSpace>. If
+/// `withVelocity` is false, the body acts as if it's at rest. `ddq` holds the
+/// accelerations of the whole Skeleton, or is nullptr for zero.
+template <typename ConfigSpace>
+void loadBody(
+    const Skeleton* skel,
+    std::size_t index,
+    std::size_t dofOffset,
+    bool withVelocity,
+    const Eigen::VectorXs* ddq,
+    Body<ConfigSpace::NumDofsEigen>& body)
+{
+  constexpr int N = ConfigSpace::NumDofsEigen;
+  const BodyNode* bodyNode = skel->getBodyNode(index);
+  const auto* joint = static_cast<const GenericJoint<ConfigSpace>*>(
+      bodyNode->getParentJoint());
+  body.joint = joint;
+  body.T = joint->getRelativeTransform();
+  body.S = joint->getRelativeJacobianStatic();
+  body.dS = joint->getRelativeJacobianTimeDerivStatic();
+  body.H = joint->getRelativeJacobianInPositionSpaceStatic();
+  if (withVelocity)
+    body.dq = joint->getVelocitiesStatic();
+  else
+    body.dq.setZero();
+  if (ddq != nullptr)
+    body.ddq = ddq->template segment<N>(dofOffset);
+  else
+    body.ddq.setZero();
+  body.G = &bodyNode->getInertia().getSpatialTensor();
+  body.gravityMode = bodyNode->getGravityMode();
+}
+
+//==============================================================================
+/// This reads a body whose parent joint has no DOFs
+inline void loadWeldBody(
+    const Skeleton* skel, std::size_t index, Body<0>& body)
+{
+  const BodyNode* bodyNode = skel->getBodyNode(index);
+  body.joint = bodyNode->getParentJoint();
+  body.T = body.joint->getRelativeTransform();
+  body.G = &bodyNode->getInertia().getSpatialTensor();
+  body.gravityMode = bodyNode->getGravityMode();
+}
+
+//==============================================================================
+/// This finishes the forward pass for `body`, once parentV, parentA and g are
+/// set
+template <int N>
+void finishForward(Body<N>& body)
+{
+  const Eigen::Vector6s Sdq = body.S * body.dq;
+  body.V = body.parentV + Sdq;
+  body.A = body.parentA + math::ad(body.V, Sdq) + body.dS * body.dq
+           + body.S * body.ddq;
+  const Eigen::Matrix6s& G = *body.G;
+  body.F = G * body.A - math::dad(body.V, G * body.V);
+  if (body.gravityMode)
+    body.F -= G.template rightCols<3>() * body.g;
+}
+
+//==============================================================================
+/// This runs the forward pass for a body attached to the world
+template <int N>
+void forwardRoot(Body<N>& body, const Eigen::Vector3s& gravity)
+{
+  body.parentV.setZero();
+  body.parentA.setZero();
+  body.g.noalias() = body.T.linear().transpose() * gravity;
+  finishForward(body);
+}
+
+//==============================================================================
+/// This runs the forward pass for a body attached to `parent`
+template <int N, int P>
+void forward(Body<N>& body, const Body<P>& parent)
+{
+  body.parentV = math::AdInvT(body.T, parent.V);
+  body.parentA = math::AdInvT(body.T, parent.A);
+  body.g.noalias() = body.T.linear().transpose() * parent.g;
+  finishForward(body);
+}
+
+//==============================================================================
+/// This adds the force transmitted through `body` onto its parent
+template <int N, int P>
+void backward(const Body<N>& body, Body<P>& parent)
+{
+  parent.F += math::dAdInvT(body.T, body.F);
+}
+
+//==============================================================================
+/// This writes the generalized forces of `body` into `tau`
+template <int N>
+void project(const Body<N>& body, std::size_t dofOffset, Eigen::VectorXs& tau)
+{
+  tau.template segment<N>(dofOffset).noalias() = body.S.transpose() * body.F;
+}
+
+//==============================================================================
+/// This returns the spatial inertia of everything from `body` down, moved
+/// into its parent's frame: X^T I X with X = Ad(T^{-1})
+template <int N>
+Eigen::Matrix6s moveInertiaToParent(
+    const Body<N>& body, const Eigen::Matrix6s& inertia)
+{
+  const Eigen::Matrix6s X = math::getAdTMatrix(body.T.inverse());
+  return X.transpose() * inertia * X;
+}
+
+//==============================================================================
+/// This moves a block of spatial forces from `body`'s frame into its
+/// parent's, column by column
+template <int N, int Cols>
+void moveForcesToParent(
+    const Body<N>& body, Eigen::Matrix<s_t, 6, Cols>& forces)
+{
+  for (int i = 0; i < Cols; i++)
+  {
+    forces.col(i) = math::dAdInvT(body.T, forces.col(i));
+  }
+}
+
+//==============================================================================
+/// This starts a tangent pass at a body whose parent isn't moved by the
+/// coordinate (or is the world)
+template <int N>
+void tangentStart(Body<N>& body)
+{
+  body.tV.setZero();
+  body.tA.setZero();
+  body.tg.setZero();
+}
+
+//==============================================================================
+/// This carries the tangent of `parent` into `body`
+template <int N, int P>
+void tangentForward(Body<N>& body, const Body<P>& parent)
+{
+  body.tV = math::AdInvT(body.T, parent.tV);
+  body.tA = math::AdInvT(body.T, parent.tA);
+  body.tg.noalias() = body.T.linear().transpose() * parent.tg;
+}
+
+//==============================================================================
+/// This adds the direct effect of position `l` of `body`'s own joint. If
+/// `constantJacobian` is true, the joint's S can't depend on its positions,
+/// so the calls to get its derivatives are skipped.
+template <int N>
+void tangentOwnPosition(Body<N>& body, int l, bool constantJacobian)
+{
+  const Eigen::Vector6s xi = body.H.col(l);
+  body.tV -= math::ad(xi, body.parentV);
+  body.tA -= math::ad(xi, body.parentA);
+  body.tg -= xi.template head<3>().cross(body.g);
+  if (constantJacobian)
+  {
+    body.dSl.setZero();
+    return;
+  }
+  body.dSl = body.joint->getRelativeJacobianDeriv(l);
+  const Eigen::Vector6s dSdq = body.dSl * body.dq;
+  body.tV += dSdq;
+  body.tA += math::ad(body.V, dSdq)
+             + body.joint->getRelativeJacobianTimeDerivDerivWrtPosition(l)
+                   * body.dq
+             + body.dSl * body.ddq;
+}
+
+//==============================================================================
+/// This adds the direct effect of velocity `l` of `body`'s own joint
+template <int N>
+void tangentOwnVelocity(Body<N>& body, int l, bool constantJacobian)
+{
+  const Eigen::Vector6s Sl = body.S.col(l);
+  body.tV += Sl;
+  body.tA += math::ad(body.V, Sl) + body.dS.col(l);
+  if (!constantJacobian)
+  {
+    body.tA += body.joint->getRelativeJacobianTimeDerivDerivWrtVelocity(l)
+               * body.dq;
+  }
+}
+
+//==============================================================================
+/// This finishes the tangent of `body`'s acceleration and force
+template <int N>
+void finishTangent(Body<N>& body)
+{
+  body.tA += math::ad(body.tV, body.S * body.dq);
+  const Eigen::Matrix6s& G = *body.G;
+  body.tF = G * body.tA - math::dad(body.tV, G * body.V)
+            - math::dad(body.V, G * body.tV);
+  if (body.gravityMode)
+    body.tF -= G.template rightCols<3>() * body.tg;
+}
+
+//==============================================================================
+/// This returns how much moving position `l` of `body`'s own joint rotates
+/// the force `body` transmits, in its own frame
+template <int N>
+Eigen::Vector6s ownPositionForceTangent(const Body<N>& body, int l)
+{
+  return math::dad(body.H.col(l), body.F);
+}
+
+//==============================================================================
+/// A body with no DOFs has no positions of its own, and H has no columns to
+/// take
+inline Eigen::Vector6s ownPositionForceTangent(const Body<0>&, int)
+{
+  return Eigen::Vector6s::Zero();
+}
+
+//==============================================================================
+/// This adds the tangent of the force transmitted through `body` onto its
+/// parent. `ownPosition` is the index of the position of `body`'s joint
+/// being differentiated, or -1.
+template <int N, int P>
+void tangentBackward(const Body<N>& body, Body<P>& parent, int ownPosition)
+{
+  parent.tF += math::dAdInvT(body.T, body.tF);
+  if (ownPosition >= 0)
+  {
+    parent.tF
+        -= math::dAdInvT(body.T, ownPositionForceTangent(body, ownPosition));
+  }
+}
+
+//==============================================================================
+/// This writes the tangent of the generalized forces of `body` into column
+/// `col` of `J`
+template <int N>
+void tangentProject(
+    const Body<N>& body,
+    std::size_t dofOffset,
+    bool ownPosition,
+    Eigen::MatrixXs& J,
+    std::size_t col)
+{
+  auto out = J.col(col).template segment<N>(dofOffset);
+  out.noalias() = body.S.transpose() * body.tF;
+  if (ownPosition)
+    out.noalias() += body.dSl.transpose() * body.F;
+}
+
+} // namespace compiled
+} // namespace dynamics
+} // namespace dart
+
+#endif
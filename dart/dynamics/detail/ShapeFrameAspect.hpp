@@ -33,6 +33,8 @@
 #ifndef DART_DYNAMICS_DETAIL_SHAPEFRAMEASPECT_HPP_
 #define DART_DYNAMICS_DETAIL_SHAPEFRAMEASPECT_HPP_
 
+#include <cstdint>
+
 #include <Eigen/Core>
 
 #include "dart/common/EmbeddedAspect.hpp"
@@ -83,8 +85,18 @@ struct CollisionAspectProperties
   /// This object is collidable if true
   bool mCollidable;
 
+  /// The layers this object belongs to, as a bitmask
+  std::uint32_t mCollisionLayers;
+
+  /// The layers this object collides with. Two objects are only checked for
+  /// collision if each one's layers overlap the other's mask.
+  std::uint32_t mCollisionMask;
+
   /// Constructor
-  CollisionAspectProperties(const bool collidable = true);
+  CollisionAspectProperties(
+      const bool collidable = true,
+      const std::uint32_t collisionLayers = 1u,
+      const std::uint32_t collisionMask = 0xFFFFFFFFu);
 
   /// Destructor
   virtual ~CollisionAspectProperties() = default;
@@ -79,6 +79,7 @@ std::pair<JointType*, NodeType*> Skeleton::createJointAndBodyNodePair(
     const typename JointType::Properties& _jointProperties,
     const typename NodeType::Properties& _bodyProperties)
 {
+  SkeletonArena::Scope arenaScope(mArena);
   JointType* joint = new JointType(_jointProperties);
   NodeType* node = new NodeType(_parent, joint, _bodyProperties);
   registerBodyNode(node);
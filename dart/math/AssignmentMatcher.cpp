@@ -1,5 +1,9 @@
 #include "dart/math/AssignmentMatcher.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace dart {
 namespace math {
 
@@ -89,5 +93,239 @@ std::map<std::string, std::string> AssignmentMatcher::assignKeysToKeys(
   return result;
 }
 
+/// This finds the assignment of rows to columns that maximizes the total
+/// weight, where each row can only be paired with a column it shares an edge
+/// with, and rows or columns may also be left unassigned (at a weight of 0).
+/// Unassigned rows get -1. Edges with non-finite weights are ignored, as are
+/// all but the heaviest of any duplicate edges.
+///
+/// This runs the auction algorithm with epsilon scaling, which is optimal to
+/// within about 1e-9 of the weight range, in time roughly proportional to the
+/// number of edges. If `columnPrices` is not null and has one entry per
+/// column, it's used as a warm start, and it's always overwritten with the
+/// final prices. Passing the prices from the last frame of a slowly changing
+/// problem (like tracking markers) back in makes this much faster.
+Eigen::VectorXi AssignmentMatcher::assignRowsToColumnsSparse(
+    int numRows,
+    int numCols,
+    const std::vector<Edge>& edges,
+    Eigen::VectorXs* columnPrices)
+{
+  Eigen::VectorXi mapping = -1 * Eigen::VectorXi::Ones(numRows);
+
+  // 1. Drop unusable edges, and keep only the heaviest of any duplicates
+  std::vector<Edge> unique;
+  unique.reserve(edges.size());
+  for (const Edge& edge : edges)
+  {
+    if (edge.row >= 0 && edge.row < numRows && edge.col >= 0
+        && edge.col < numCols && std::isfinite(edge.weight))
+    {
+      unique.push_back(edge);
+    }
+  }
+  std::sort(unique.begin(), unique.end(), [](const Edge& a, const Edge& b) {
+    if (a.row != b.row)
+      return a.row < b.row;
+    if (a.col != b.col)
+      return a.col < b.col;
+    return a.weight > b.weight;
+  });
+  unique.erase(
+      std::unique(
+          unique.begin(),
+          unique.end(),
+          [](const Edge& a, const Edge& b) {
+            return a.row == b.row && a.col == b.col;
+          }),
+      unique.end());
+
+  bool warmStart = columnPrices != nullptr && columnPrices->size() == numCols;
+  if (unique.empty())
+  {
+    if (columnPrices != nullptr)
+      *columnPrices = Eigen::VectorXs::Zero(numCols);
+    return mapping;
+  }
+
+  // 2. The auction needs a square problem with a perfect matching, so we add
+  // a "stays unassigned" object for every row and a "stays unassigned" bidder
+  // for every column. Bidders [0, numRows) are the rows, and bidders
+  // [numRows, numRows + numCols) are the empty columns. Objects [0, numCols)
+  // are the columns, and objects [numCols, numCols + numRows) are the empty
+  // rows. When row i takes column j, the empty bidder for j needs somewhere
+  // to go, so for every edge (i, j) it may take the empty object for i.
+  const int n = numRows + numCols;
+  std::vector<int> adjacencyStart(n + 1, 0);
+  for (const Edge& edge : unique)
+  {
+    adjacencyStart[edge.row + 1]++;
+    adjacencyStart[numRows + edge.col + 1]++;
+  }
+  for (int p = 0; p < n; p++)
+  {
+    // Everyone can also take their own "unassigned" object
+    adjacencyStart[p + 1]++;
+    adjacencyStart[p + 1] += adjacencyStart[p];
+  }
+  std::vector<int> adjacencyObject(adjacencyStart[n]);
+  std::vector<s_t> adjacencyValue(adjacencyStart[n]);
+  std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+  s_t maxWeight = 0.0;
+  s_t minWeight = 0.0;
+  for (const Edge& edge : unique)
+  {
+    adjacencyObject[fill[edge.row]] = edge.col;
+    adjacencyValue[fill[edge.row]++] = edge.weight;
+    adjacencyObject[fill[numRows + edge.col]] = numCols + edge.row;
+    adjacencyValue[fill[numRows + edge.col]++] = 0.0;
+    maxWeight = std::max(maxWeight, edge.weight);
+    minWeight = std::min(minWeight, edge.weight);
+  }
+  for (int i = 0; i < numRows; i++)
+  {
+    adjacencyObject[fill[i]] = numCols + i;
+    adjacencyValue[fill[i]++] = 0.0;
+  }
+  for (int j = 0; j < numCols; j++)
+  {
+    adjacencyObject[fill[numRows + j]] = j;
+    adjacencyValue[fill[numRows + j]++] = 0.0;
+  }
+
+  // 3. Run the auction, tightening epsilon each round. Any prices are a valid
+  // start for a square problem, so warm starts just skip the early rounds.
+  const s_t range = std::max(maxWeight - minWeight, (s_t)1e-12);
+  const s_t epsilonFinal = range * 1e-9 / n;
+  s_t epsilon = std::max(epsilonFinal, warmStart ? range * 1e-3 : range / 4);
+  std::vector<s_t> prices(n, 0.0);
+  if (warmStart)
+  {
+    for (int j = 0; j < numCols; j++)
+    {
+      prices[j] = (*columnPrices)(j);
+    }
+  }
+  std::vector<int> ownerOf(n);
+  std::vector<int> objectOf(n);
+  std::vector<int> unassigned;
+  while (true)
+  {
+    std::fill(ownerOf.begin(), ownerOf.end(), -1);
+    std::fill(objectOf.begin(), objectOf.end(), -1);
+    unassigned.clear();
+    for (int p = n - 1; p >= 0; p--)
+    {
+      unassigned.push_back(p);
+    }
+
+    while (!unassigned.empty())
+    {
+      int p = unassigned.back();
+      unassigned.pop_back();
+
+      int bestObject = -1;
+      s_t bestValue = -std::numeric_limits<s_t>::infinity();
+      s_t secondValue = -std::numeric_limits<s_t>::infinity();
+      for (int k = adjacencyStart[p]; k < adjacencyStart[p + 1]; k++)
+      {
+        s_t value = adjacencyValue[k] - prices[adjacencyObject[k]];
+        if (value > bestValue)
+        {
+          secondValue = bestValue;
+          bestValue = value;
+          bestObject = adjacencyObject[k];
+        }
+        else if (value > secondValue)
+        {
+          secondValue = value;
+        }
+      }
+      // With only one option, any bid works, so bid high enough that nobody
+      // else will bother competing for it
+      if (secondValue == -std::numeric_limits<s_t>::infinity())
+        secondValue = bestValue - range;
+
+      prices[bestObject] += bestValue - secondValue + epsilon;
+      if (ownerOf[bestObject] != -1)
+      {
+        objectOf[ownerOf[bestObject]] = -1;
+        unassigned.push_back(ownerOf[bestObject]);
+      }
+      ownerOf[bestObject] = p;
+      objectOf[p] = bestObject;
+    }
+
+    if (epsilon <= epsilonFinal)
+      break;
+    epsilon = std::max(epsilonFinal, epsilon / 5);
+  }
+
+  for (int i = 0; i < numRows; i++)
+  {
+    if (objectOf[i] < numCols)
+      mapping(i) = objectOf[i];
+  }
+
+  if (columnPrices != nullptr)
+  {
+    // Prices only ever go up, so shift them back down to keep them from
+    // drifting over many warm-started calls. Shifting every price by the
+    // same amount doesn't change the auction.
+    *columnPrices = Eigen::VectorXs::Zero(numCols);
+    s_t minPrice = *std::min_element(prices.begin(), prices.end());
+    for (int j = 0; j < numCols; j++)
+    {
+      (*columnPrices)(j) = prices[j] - minPrice;
+    }
+  }
+
+  return mapping;
+}
+
+/// This is the sparse version of assignKeysToKeys(). Rather than scoring every
+/// pair, `candidates` gets called once per source key, and returns the
+/// (target, weight) pairs that key is allowed to map to. Like
+/// assignRowsToColumnsSparse(), this maximizes the total weight.
+std::map<std::string, std::string> AssignmentMatcher::assignKeysToKeysSparse(
+    std::vector<std::string> source,
+    std::vector<std::string> target,
+    std::function<std::vector<std::pair<std::string, double>>(std::string)>
+        candidates)
+{
+  std::map<std::string, int> targetIndex;
+  for (int j = 0; j < target.size(); j++)
+  {
+    targetIndex[target[j]] = j;
+  }
+
+  std::vector<Edge> edges;
+  for (int i = 0; i < source.size(); i++)
+  {
+    for (auto& candidate : candidates(source[i]))
+    {
+      auto index = targetIndex.find(candidate.first);
+      if (index != targetIndex.end())
+      {
+        edges.push_back(Edge{i, index->second, (s_t)candidate.second});
+      }
+    }
+  }
+
+  Eigen::VectorXi assignment
+      = assignRowsToColumnsSparse(source.size(), target.size(), edges);
+
+  std::map<std::string, std::string> result;
+  for (int i = 0; i < assignment.size(); i++)
+  {
+    if (assignment[i] != -1)
+    {
+      result[source[i]] = target[assignment[i]];
+    }
+  }
+
+  return result;
+}
+
 } // namespace math
 } // namespace dart
\ No newline at end of file
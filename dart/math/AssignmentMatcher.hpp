@@ -10,6 +10,15 @@ namespace math {
 class AssignmentMatcher
 {
 public:
+  /// This is one allowed pairing of a row with a column, for the sparse
+  /// assignment problem
+  struct Edge
+  {
+    int row;
+    int col;
+    s_t weight;
+  };
+
   /// This maps the rows to columns. If there are fewer columns than rows,
   /// unassigned rows get assigned to -1
   static Eigen::VectorXi assignRowsToColumns(const Eigen::MatrixXs& weights);
@@ -19,6 +28,34 @@ public:
       std::vector<std::string> target,
       std::function<double(std::string, std::string)> weight);
 
+  /// This finds the assignment of rows to columns that maximizes the total
+  /// weight, where each row can only be paired with a column it shares an
+  /// edge with, and rows or columns may also be left unassigned (at a weight
+  /// of 0). Unassigned rows get -1. Edges with non-finite weights are
+  /// ignored, as are all but the heaviest of any duplicate edges.
+  ///
+  /// This runs the auction algorithm with epsilon scaling, which is optimal
+  /// to within about 1e-9 of the weight range, in time roughly proportional
+  /// to the number of edges. If `columnPrices` is not null and has one entry
+  /// per column, it's used as a warm start, and it's always overwritten with
+  /// the final prices. Passing the prices from the last frame of a slowly
+  /// changing problem (like tracking markers) back in makes this much faster.
+  static Eigen::VectorXi assignRowsToColumnsSparse(
+      int numRows,
+      int numCols,
+      const std::vector<Edge>& edges,
+      Eigen::VectorXs* columnPrices = nullptr);
+
+  /// This is the sparse version of assignKeysToKeys(). Rather than scoring
+  /// every pair, `candidates` gets called once per source key, and returns
+  /// the (target, weight) pairs that key is allowed to map to. Like
+  /// assignRowsToColumnsSparse(), this maximizes the total weight.
+  static std::map<std::string, std::string> assignKeysToKeysSparse(
+      std::vector<std::string> source,
+      std::vector<std::string> target,
+      std::function<std::vector<std::pair<std::string, double>>(std::string)>
+          candidates);
+
 protected:
 };
 
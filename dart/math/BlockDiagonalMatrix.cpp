@@ -0,0 +1,160 @@
+#include "dart/math/BlockDiagonalMatrix.hpp"
+
+#include <cassert>
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+BlockDiagonalMatrix::BlockDiagonalMatrix() : mDim(0)
+{
+}
+
+//==============================================================================
+/// This appends a square block to the bottom-right corner of the diagonal
+void BlockDiagonalMatrix::addBlock(const Eigen::MatrixXs& block)
+{
+  assert(block.rows() == block.cols());
+  mBlocks.push_back(block);
+  mOffsets.push_back(mDim);
+  mDim += block.rows();
+}
+
+//==============================================================================
+/// This returns the number of rows (and columns) of the full matrix
+int BlockDiagonalMatrix::rows() const
+{
+  return mDim;
+}
+
+//==============================================================================
+/// This returns the number of columns (and rows) of the full matrix
+int BlockDiagonalMatrix::cols() const
+{
+  return mDim;
+}
+
+//==============================================================================
+/// This returns the number of blocks along the diagonal
+int BlockDiagonalMatrix::getNumBlocks() const
+{
+  return mBlocks.size();
+}
+
+//==============================================================================
+/// This returns the i'th block along the diagonal
+const Eigen::MatrixXs& BlockDiagonalMatrix::getBlock(int i) const
+{
+  return mBlocks[i];
+}
+
+//==============================================================================
+/// This returns the i'th block along the diagonal
+Eigen::MatrixXs& BlockDiagonalMatrix::getBlock(int i)
+{
+  return mBlocks[i];
+}
+
+//==============================================================================
+/// This returns the row (and column) of the full matrix where the i'th block
+/// starts
+int BlockDiagonalMatrix::getBlockOffset(int i) const
+{
+  return mOffsets[i];
+}
+
+//==============================================================================
+/// This builds the full dense matrix, zeros and all
+Eigen::MatrixXs BlockDiagonalMatrix::toDense() const
+{
+  Eigen::MatrixXs result = Eigen::MatrixXs::Zero(mDim, mDim);
+  for (int i = 0; i < mBlocks.size(); i++)
+  {
+    int dim = mBlocks[i].rows();
+    result.block(mOffsets[i], mOffsets[i], dim, dim) = mBlocks[i];
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns the transpose, which is block diagonal with the same layout
+BlockDiagonalMatrix BlockDiagonalMatrix::transpose() const
+{
+  BlockDiagonalMatrix result;
+  for (const Eigen::MatrixXs& block : mBlocks)
+  {
+    result.addBlock(block.transpose());
+  }
+  return result;
+}
+
+//==============================================================================
+/// This multiplies this matrix on the left of a dense matrix (or vector)
+Eigen::MatrixXs BlockDiagonalMatrix::operator*(
+    const Eigen::Ref<const Eigen::MatrixXs>& rhs) const
+{
+  assert(rhs.rows() == mDim);
+  Eigen::MatrixXs result(mDim, rhs.cols());
+  for (int i = 0; i < mBlocks.size(); i++)
+  {
+    int dim = mBlocks[i].rows();
+    result.middleRows(mOffsets[i], dim).noalias()
+        = mBlocks[i] * rhs.middleRows(mOffsets[i], dim);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This multiplies two block diagonal matrices with the same block layout
+BlockDiagonalMatrix BlockDiagonalMatrix::operator*(
+    const BlockDiagonalMatrix& rhs) const
+{
+  assert(rhs.mOffsets == mOffsets);
+  BlockDiagonalMatrix result;
+  for (int i = 0; i < mBlocks.size(); i++)
+  {
+    result.addBlock(mBlocks[i] * rhs.mBlocks[i]);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This scales every block by a constant
+BlockDiagonalMatrix BlockDiagonalMatrix::operator*(s_t scale) const
+{
+  BlockDiagonalMatrix result;
+  for (const Eigen::MatrixXs& block : mBlocks)
+  {
+    result.addBlock(block * scale);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This multiplies a dense matrix (or row vector) on the left of a block
+/// diagonal matrix
+Eigen::MatrixXs operator*(
+    const Eigen::Ref<const Eigen::MatrixXs>& lhs,
+    const BlockDiagonalMatrix& rhs)
+{
+  assert(lhs.cols() == rhs.rows());
+  Eigen::MatrixXs result(lhs.rows(), rhs.cols());
+  for (int i = 0; i < rhs.getNumBlocks(); i++)
+  {
+    int offset = rhs.getBlockOffset(i);
+    int dim = rhs.getBlock(i).rows();
+    result.middleCols(offset, dim).noalias()
+        = lhs.middleCols(offset, dim) * rhs.getBlock(i);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This scales every block of a block diagonal matrix by a constant
+BlockDiagonalMatrix operator*(s_t scale, const BlockDiagonalMatrix& rhs)
+{
+  return rhs * scale;
+}
+
+} // namespace math
+} // namespace dart
@@ -0,0 +1,79 @@
+#ifndef MATH_BLOCK_DIAGONAL_MATRIX_H_
+#define MATH_BLOCK_DIAGONAL_MATRIX_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a square matrix made of square dense blocks along the diagonal,
+/// with zeros everywhere else. The World builds these for its mass matrix and
+/// integration Jacobians, with one block per Skeleton. Products against a
+/// BlockDiagonalMatrix only touch the blocks, so they skip all the zeros that
+/// a dense world-sized matrix would carry between independent Skeletons.
+class BlockDiagonalMatrix
+{
+public:
+  BlockDiagonalMatrix();
+
+  /// This appends a square block to the bottom-right corner of the diagonal
+  void addBlock(const Eigen::MatrixXs& block);
+
+  /// This returns the number of rows (and columns) of the full matrix
+  int rows() const;
+
+  /// This returns the number of columns (and rows) of the full matrix
+  int cols() const;
+
+  /// This returns the number of blocks along the diagonal
+  int getNumBlocks() const;
+
+  /// This returns the i'th block along the diagonal
+  const Eigen::MatrixXs& getBlock(int i) const;
+
+  /// This returns the i'th block along the diagonal
+  Eigen::MatrixXs& getBlock(int i);
+
+  /// This returns the row (and column) of the full matrix where the i'th block
+  /// starts
+  int getBlockOffset(int i) const;
+
+  /// This builds the full dense matrix, zeros and all
+  Eigen::MatrixXs toDense() const;
+
+  /// This returns the transpose, which is block diagonal with the same layout
+  BlockDiagonalMatrix transpose() const;
+
+  /// This multiplies this matrix on the left of a dense matrix (or vector)
+  Eigen::MatrixXs operator*(
+      const Eigen::Ref<const Eigen::MatrixXs>& rhs) const;
+
+  /// This multiplies two block diagonal matrices with the same block layout
+  BlockDiagonalMatrix operator*(const BlockDiagonalMatrix& rhs) const;
+
+  /// This scales every block by a constant
+  BlockDiagonalMatrix operator*(s_t scale) const;
+
+protected:
+  std::vector<Eigen::MatrixXs> mBlocks;
+  std::vector<int> mOffsets;
+  int mDim;
+};
+
+/// This multiplies a dense matrix (or row vector) on the left of a block
+/// diagonal matrix
+Eigen::MatrixXs operator*(
+    const Eigen::Ref<const Eigen::MatrixXs>& lhs,
+    const BlockDiagonalMatrix& rhs);
+
+/// This scales every block of a block diagonal matrix by a constant
+BlockDiagonalMatrix operator*(s_t scale, const BlockDiagonalMatrix& rhs);
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,66 @@
+#include "dart/math/CompactMatrix.hpp"
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+CompactMatrix::CompactMatrix()
+{
+}
+
+//==============================================================================
+CompactMatrix::CompactMatrix(const Eigen::MatrixXs& mat)
+  : mData(mat.cast<float>())
+{
+}
+
+//==============================================================================
+/// This expands a full precision copy of the whole matrix
+Eigen::MatrixXs CompactMatrix::toMatrix() const
+{
+  return mData.cast<s_t>();
+}
+
+//==============================================================================
+/// This expands a full precision copy of column `i`
+Eigen::VectorXs CompactMatrix::col(int i) const
+{
+  return mData.col(i).cast<s_t>();
+}
+
+//==============================================================================
+/// This rounds `value` to single precision, and stores it in column `i`
+void CompactMatrix::setCol(int i, const Eigen::VectorXs& value)
+{
+  mData.col(i) = value.cast<float>();
+}
+
+//==============================================================================
+int CompactMatrix::rows() const
+{
+  return mData.rows();
+}
+
+//==============================================================================
+int CompactMatrix::cols() const
+{
+  return mData.cols();
+}
+
+//==============================================================================
+/// This returns the number of bytes used to store the values
+std::size_t CompactMatrix::bytes() const
+{
+  return mData.size() * sizeof(float);
+}
+
+//==============================================================================
+/// This gives direct access to the single precision values, for example to
+/// hand them off to something that takes floats anyways
+const Eigen::MatrixXf& CompactMatrix::data() const
+{
+  return mData;
+}
+
+} // namespace math
+} // namespace dart
@@ -0,0 +1,52 @@
+#ifndef MATH_COMPACT_MATRIX_H_
+#define MATH_COMPACT_MATRIX_H_
+
+#include <cstddef>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a storage-only, single precision copy of a matrix of s_t. It takes
+/// half the memory of an Eigen::MatrixXs (and far less when s_t is
+/// multiprecision), so it's meant for big time series that we only need to
+/// hold on to. All the math stays in s_t: expand values back out with
+/// toMatrix() or col() before using them.
+class CompactMatrix
+{
+public:
+  CompactMatrix();
+
+  explicit CompactMatrix(const Eigen::MatrixXs& mat);
+
+  /// This expands a full precision copy of the whole matrix
+  Eigen::MatrixXs toMatrix() const;
+
+  /// This expands a full precision copy of column `i`
+  Eigen::VectorXs col(int i) const;
+
+  /// This rounds `value` to single precision, and stores it in column `i`
+  void setCol(int i, const Eigen::VectorXs& value);
+
+  int rows() const;
+
+  int cols() const;
+
+  /// This returns the number of bytes used to store the values
+  std::size_t bytes() const;
+
+  /// This gives direct access to the single precision values, for example to
+  /// hand them off to something that takes floats anyways
+  const Eigen::MatrixXf& data() const;
+
+protected:
+  Eigen::MatrixXf mData;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -1,8 +1,11 @@
 #include "dart/math/FiniteDifference.hpp"
 
-#include <array>
-#include <exception>
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <future>
+
+#include "dart/common/ThreadPool.hpp"
 
 using namespace dart;
 
@@ -10,42 +13,22 @@ namespace dart {
 namespace math {
 
 //==============================================================================
-void centralDifference(
+void finiteDifference(
     std::function<bool(
         /* in*/ s_t eps,
         /* in*/ int dof,
         /*out*/ Eigen::VectorXs& perturbed)> getPerturbed,
     Eigen::MatrixXs& result,
-    s_t eps)
+    s_t eps,
+    bool useRidders)
 {
-  if (result.size() == 0)
-    return;
-
-  // Run central differences for every column of the result separately
-  for (std::size_t dof = 0; dof < result.cols(); dof++)
+  if (useRidders)
   {
-    s_t epsPos = eps;
-    Eigen::VectorXs perturbedPlus;
-    // Get perturbed result with smaller and smaller eps until valid
-    while (!getPerturbed(epsPos, dof, perturbedPlus))
-    {
-      epsPos *= 0.5;
-      if (abs(epsPos) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    s_t epsNeg = eps;
-    Eigen::VectorXs perturbedMinus;
-    while (!getPerturbed(-epsNeg, dof, perturbedMinus))
-    {
-      epsNeg *= 0.5;
-      if (abs(epsPos) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    // if this point is reached, getPerturbed should have produced valid results
-    Eigen::VectorXs grad = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
-    result.col(dof).noalias() = grad;
+    detail::riddersMethodColumns(getPerturbed, result, eps);
+  }
+  else
+  {
+    detail::centralDifferenceColumns(getPerturbed, result, eps);
   }
 
   return;
@@ -53,41 +36,22 @@ void centralDifference(
 
 //==============================================================================
 template <class T>
-void centralDifference(
+void finiteDifference(
     std::function<bool(
         /* in*/ s_t eps,
         /* in*/ int dof,
         /*out*/ s_t& perturbed)> getPerturbed,
     T& result,
-    s_t eps)
+    s_t eps,
+    bool useRidders)
 {
-  if (result.size() == 0)
-    return;
-
-  // Run central differences for every column of the result separately
-  for (std::size_t dof = 0; dof < result.size(); dof++)
+  if (useRidders)
   {
-    s_t epsPos = eps;
-    s_t perturbedPlus;
-    // Get perturbed result with smaller and smaller eps until valid
-    while (!getPerturbed(epsPos, dof, perturbedPlus))
-    {
-      epsPos *= 0.5;
-      if (abs(epsPos) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    s_t epsNeg = eps;
-    s_t perturbedMinus;
-    while (!getPerturbed(-epsNeg, dof, perturbedMinus))
-    {
-      epsNeg *= 0.5;
-      if (abs(epsPos) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    // if this point is reached, getPerturbed should have produced valid results
-    result(dof) = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
+    detail::riddersMethodScalars(getPerturbed, result, eps);
+  }
+  else
+  {
+    detail::centralDifferenceScalars(getPerturbed, result, eps);
   }
 
   return;
@@ -95,484 +59,235 @@ void centralDifference(
 
 //==============================================================================
 template <class T>
-void centralDifference(
+void finiteDifference(
     std::function<bool(
         /* in*/ s_t eps,
         /*out*/ T& perturbed)> getPerturbed,
     T& result,
-    s_t eps)
+    s_t eps,
+    bool useRidders)
 {
-  if (result.size() == 0)
-    return;
-
-  s_t epsPos = eps;
-  T perturbedPlus;
-  // Get perturbed result with smaller and smaller eps until valid
-  while (!getPerturbed(epsPos, perturbedPlus))
+  if (useRidders)
   {
-    epsPos *= 0.5;
-    if (abs(epsPos) <= 1e-20)
-      throw non_differentiable_point_exception();
+    detail::riddersMethodStatic(getPerturbed, result, eps);
   }
-
-  s_t epsNeg = eps;
-  T perturbedMinus;
-  while (!getPerturbed(-epsNeg, perturbedMinus))
+  else
   {
-    epsNeg *= 0.5;
-    if (abs(epsPos) <= 1e-20)
-      throw non_differentiable_point_exception();
+    detail::centralDifferenceStatic(getPerturbed, result, eps);
   }
 
-  // if this point is reached, getPerturbed should have produced valid results
-  result = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
-
   return;
 }
 
 //==============================================================================
-void centralDifference(
+void finiteDifference(
     std::function<bool(
         /* in*/ s_t eps,
         /*out*/ s_t& perturbed)> getPerturbed,
     s_t& result,
-    s_t eps)
+    s_t eps,
+    bool useRidders)
 {
-  s_t epsPos = eps;
-  s_t perturbedPlus;
-  // Get perturbed result with smaller and smaller eps until valid
-  while (!getPerturbed(epsPos, perturbedPlus))
+  if (useRidders)
   {
-    epsPos *= 0.5;
-    if (abs(epsPos) <= 1e-20)
-      throw non_differentiable_point_exception();
+    detail::riddersMethodScalar(getPerturbed, result, eps);
   }
-
-  s_t epsNeg = eps;
-  s_t perturbedMinus;
-  while (!getPerturbed(-epsNeg, perturbedMinus))
+  else
   {
-    epsNeg *= 0.5;
-    if (abs(epsPos) <= 1e-20)
-      throw non_differentiable_point_exception();
+    detail::centralDifferenceScalar(getPerturbed, result, eps);
   }
 
-  // if this point is reached, getPerturbed should have produced valid results
-  result = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
-
   return;
 }
 
-//==============================================================================
-void riddersMethod(
-    std::function<bool(
-        /* in*/ s_t eps,
-        /* in*/ int dof,
-        /*out*/ Eigen::VectorXs& perturbed)> getPerturbed,
+namespace {
+
+using GroupPerturbation = std::function<bool(
+    /* in*/ s_t eps,
+    /* in*/ const std::vector<int>& dofs,
+    /*out*/ Eigen::VectorXs& perturbed)>;
+
+/// This differences each group of columns on the global thread pool, and
+/// scatters the results into `result`. If `columnRows` is null, every group
+/// is a single dense column.
+void differenceGroups(
+    const std::function<GroupPerturbation()>& createWorker,
+    const std::vector<std::vector<int>>& groups,
+    const std::vector<std::vector<int>>* columnRows,
     Eigen::MatrixXs& result,
-    s_t eps)
+    s_t eps,
+    bool useRidders)
 {
-  if (result.size() == 0)
+  if (result.size() == 0 || groups.size() == 0)
     return;
 
-  s_t originalStepSize = eps;
-  const s_t con = 1.4, con2 = (con * con);
-  const s_t safeThreshold = 2.0;
-  const int tabSize = 10;
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  int numWorkers = std::max(
+      1, std::min((int)pool.getNumThreads(), (int)groups.size()));
 
-  // Run central differences for every column of the result separately
-  for (std::size_t dof = 0; dof < result.cols(); dof++)
+  // Workers usually clone a skeleton, which isn't safe to do concurrently, so
+  // we make them all here before starting
+  std::vector<GroupPerturbation> workers;
+  for (int i = 0; i < numWorkers; i++)
   {
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXs, tabSize>, tabSize> tab;
-
-    // Get perturbed result with smaller and smaller eps until valid
-    // For Ridders we want the pos and neg epsilons to be the same.
-    Eigen::VectorXs perturbedPlus, perturbedMinus;
-    while (!getPerturbed(originalStepSize, dof, perturbedPlus)
-           || !getPerturbed(-originalStepSize, dof, perturbedMinus))
-    {
-      originalStepSize *= 0.5;
-      if (abs(originalStepSize) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    // if this point is reached, getPerturbed should have produced valid results
-    tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
-
-    s_t stepSize = originalStepSize;
-    s_t bestError = std::numeric_limits<s_t>::max();
+    workers.push_back(createWorker());
+  }
 
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
+  std::atomic<int> nextGroup(0);
+  auto runWorker = [&](int i) {
+    GroupPerturbation& worker = workers[i];
+    Eigen::VectorXs combined(result.rows());
+    while (true)
     {
-      stepSize /= con;
-
-      if (!getPerturbed(stepSize, dof, perturbedPlus)
-          || !getPerturbed(-stepSize, dof, perturbedMinus))
+      int g = nextGroup.fetch_add(1);
+      if (g >= (int)groups.size())
       {
-        throw ridders_invalid_state_exception();
+        break;
       }
-
-      tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
-
-      s_t fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new
-      // evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
+      const std::vector<int>& dofs = groups[g];
+      auto getPerturbed = [&](/* in*/ s_t eps,
+                              /* in*/ int /* dof */,
+                              /*out*/ Eigen::VectorXs& perturbed) {
+        return worker(eps, dofs, perturbed);
+      };
+      if (useRidders)
       {
-        tab[jTab][iTab] = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1])
-                          / (fac - 1.0);
-        fac = con2 * fac;
-        s_t currError = max(
-            (tab[jTab][iTab] - tab[jTab - 1][iTab]).array().abs().maxCoeff(),
-            (tab[jTab][iTab] - tab[jTab - 1][iTab - 1])
-                .array()
-                .abs()
-                .maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          result.col(dof).noalias() = tab[jTab][iTab];
-        }
+        detail::riddersMethodColumns(getPerturbed, combined, eps);
       }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1]).array().abs().maxCoeff()
-          >= safeThreshold * bestError)
+      else
       {
-        break;
+        detail::centralDifferenceColumns(getPerturbed, combined, eps);
       }
-    }
-  }
-
-  return;
-}
 
-//==============================================================================
-template <class T>
-void riddersMethod(
-    std::function<bool(
-        /* in*/ s_t eps,
-        /* in*/ int dof,
-        /*out*/ s_t& perturbed)> getPerturbed,
-    T& result,
-    s_t eps)
-{
-  if (result.size() == 0)
-    return;
-
-  s_t originalStepSize = eps;
-  const s_t con = 1.4, con2 = (con * con);
-  const s_t safeThreshold = 2.0;
-  const int tabSize = 10;
-
-  // Run central differences for every column of the result separately
-  for (std::size_t dof = 0; dof < result.size(); dof++)
-  {
-    // Neville tableau of finite difference results
-    std::array<std::array<s_t, tabSize>, tabSize> tab;
-
-    // Get perturbed result with smaller and smaller eps until valid
-    // For Ridders we want the pos and neg epsilons to be the same.
-    s_t perturbedPlus, perturbedMinus;
-    while (!getPerturbed(originalStepSize, dof, perturbedPlus)
-           || !getPerturbed(-originalStepSize, dof, perturbedMinus))
-    {
-      originalStepSize *= 0.5;
-      if (abs(originalStepSize) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    // if this point is reached, getPerturbed should have produced valid results
-    tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
-
-    s_t stepSize = originalStepSize;
-    s_t bestError = std::numeric_limits<s_t>::max();
-
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
-    {
-      stepSize /= con;
-
-      if (!getPerturbed(stepSize, dof, perturbedPlus)
-          || !getPerturbed(-stepSize, dof, perturbedMinus))
+      // Each group writes disjoint columns, so this doesn't need a lock
+      for (int dof : dofs)
       {
-        throw ridders_invalid_state_exception();
-      }
-
-      tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
-
-      s_t fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new
-      // evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
-      {
-        tab[jTab][iTab] = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1])
-                          / (fac - 1.0);
-        fac = con2 * fac;
-        s_t currError = max(
-            (tab[jTab][iTab] - tab[jTab - 1][iTab]),
-            (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]));
-        if (currError < bestError)
+        if (columnRows == nullptr)
         {
-          bestError = currError;
-          result(dof) = tab[jTab][iTab];
+          result.col(dof) = combined;
+          continue;
+        }
+        result.col(dof).setZero();
+        for (int row : (*columnRows)[dof])
+        {
+          result(row, dof) = combined(row);
         }
-      }
-
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1])
-          >= safeThreshold * bestError)
-      {
-        break;
       }
     }
-  }
-
-  return;
-}
-
-//==============================================================================
-template <class T>
-void riddersMethod(
-    std::function<bool(
-        /* in*/ s_t eps,
-        /*out*/ T& perturbed)> getPerturbed,
-    T& result,
-    s_t eps)
-{
-  if (result.size() == 0)
-    return;
+  };
 
-  s_t originalStepSize = eps;
-  const s_t con = 1.4, con2 = (con * con);
-  const s_t safeThreshold = 2.0;
-  const int tabSize = 10;
-
-  // Neville tableau of finite difference results
-  std::array<std::array<T, tabSize>, tabSize> tab;
-
-  // Get perturbed result with smaller and smaller eps until valid
-  // For Ridders we want the pos and neg epsilons to be the same.
-  T perturbedPlus, perturbedMinus;
-  while (!getPerturbed(originalStepSize, perturbedPlus)
-         || !getPerturbed(-originalStepSize, perturbedMinus))
+  if (numWorkers == 1)
   {
-    originalStepSize *= 0.5;
-    if (abs(originalStepSize) <= 1e-20)
-      throw non_differentiable_point_exception();
+    runWorker(0);
+    return;
   }
 
-  // if this point is reached, getPerturbed should have produced valid results
-  tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
-
-  s_t stepSize = originalStepSize;
-  s_t bestError = std::numeric_limits<s_t>::max();
-
-  // Iterate over smaller and smaller step sizes
-  for (int iTab = 1; iTab < tabSize; iTab++)
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < numWorkers; i++)
   {
-    stepSize /= con;
-
-    if (!getPerturbed(stepSize, perturbedPlus)
-        || !getPerturbed(-stepSize, perturbedMinus))
-    {
-      throw ridders_invalid_state_exception();
-    }
-
-    tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
-
-    s_t fac = con2;
-    // Compute extrapolations of increasing orders, requiring no new
-    // evaluations
-    for (int jTab = 1; jTab <= iTab; jTab++)
-    {
-      tab[jTab][iTab]
-          = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1]) / (fac - 1.0);
-      fac = con2 * fac;
-      s_t currError = max(
-          (tab[jTab][iTab] - tab[jTab - 1][iTab]).array().abs().maxCoeff(),
-          (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]).array().abs().maxCoeff());
-      if (currError < bestError)
-      {
-        bestError = currError;
-        result = tab[jTab][iTab];
-      }
-    }
-
-    // If higher order is worse by a significant factor, quit early.
-    if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1]).array().abs().maxCoeff()
-        >= safeThreshold * bestError)
-    {
-      break;
-    }
+    futures.push_back(pool.submit(runWorker, i));
   }
-
-  return;
-}
-
-//==============================================================================
-void riddersMethod(
-    std::function<bool(
-        /* in*/ s_t eps,
-        /*out*/ s_t& perturbed)> getPerturbed,
-    s_t& result,
-    s_t eps)
-{
-  s_t originalStepSize = eps;
-  const s_t con = 1.4, con2 = (con * con);
-  const s_t safeThreshold = 2.0;
-  const int tabSize = 10;
-
-  // Neville tableau of finite difference results
-  std::array<std::array<s_t, tabSize>, tabSize> tab;
-
-  // Get perturbed result with smaller and smaller eps until valid
-  // For Ridders we want the pos and neg epsilons to be the same.
-  s_t perturbedPlus, perturbedMinus;
-  while (!getPerturbed(originalStepSize, perturbedPlus)
-         || !getPerturbed(-originalStepSize, perturbedMinus))
+  // Wait for every worker before get() can throw, since the workers refer to
+  // our stack
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
   {
-    originalStepSize *= 0.5;
-    if (abs(originalStepSize) <= 1e-20)
-      throw non_differentiable_point_exception();
+    future.get();
   }
-
-  // if this point is reached, getPerturbed should have produced valid results
-  tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
-
-  s_t stepSize = originalStepSize;
-  s_t bestError = std::numeric_limits<s_t>::max();
-
-  // Iterate over smaller and smaller step sizes
-  for (int iTab = 1; iTab < tabSize; iTab++)
-  {
-    stepSize /= con;
-
-    if (!getPerturbed(stepSize, perturbedPlus)
-        || !getPerturbed(-stepSize, perturbedMinus))
-    {
-      throw ridders_invalid_state_exception();
-    }
-
-    tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
-
-    s_t fac = con2;
-    // Compute extrapolations of increasing orders, requiring no new
-    // evaluations
-    for (int jTab = 1; jTab <= iTab; jTab++)
-    {
-      tab[jTab][iTab]
-          = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1]) / (fac - 1.0);
-      fac = con2 * fac;
-      s_t currError = max(
-          (tab[jTab][iTab] - tab[jTab - 1][iTab]),
-          (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]));
-      if (currError < bestError)
-      {
-        bestError = currError;
-        result = tab[jTab][iTab];
-      }
-    }
-
-    // If higher order is worse by a significant factor, quit early.
-    if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1])
-        >= safeThreshold * bestError)
-    {
-      break;
-    }
-  }
-
-  return;
 }
 
-//==============================================================================
-void finiteDifference(
-    std::function<bool(
-        /* in*/ s_t eps,
-        /* in*/ int dof,
-        /*out*/ Eigen::VectorXs& perturbed)> getPerturbed,
-    Eigen::MatrixXs& result,
-    s_t eps,
-    bool useRidders)
-{
-  if (useRidders)
-  {
-    riddersMethod(getPerturbed, result, eps);
-  }
-  else
-  {
-    centralDifference(getPerturbed, result, eps);
-  }
-
-  return;
-}
+} // namespace
 
 //==============================================================================
-template <class T>
-void finiteDifference(
-    std::function<bool(
+void finiteDifferenceParallel(
+    std::function<std::function<bool(
         /* in*/ s_t eps,
         /* in*/ int dof,
-        /*out*/ s_t& perturbed)> getPerturbed,
-    T& result,
+        /*out*/ Eigen::VectorXs& perturbed)>()> createWorker,
+    Eigen::MatrixXs& result,
     s_t eps,
     bool useRidders)
 {
-  if (useRidders)
+  std::vector<std::vector<int>> groups;
+  for (int dof = 0; dof < result.cols(); dof++)
   {
-    riddersMethod(getPerturbed, result, eps);
+    groups.push_back(std::vector<int>(1, dof));
   }
-  else
-  {
-    centralDifference(getPerturbed, result, eps);
-  }
-
-  return;
+  differenceGroups(
+      [&]() -> GroupPerturbation {
+        std::function<bool(s_t, int, Eigen::VectorXs&)> worker
+            = createWorker();
+        return [worker](
+                   /* in*/ s_t eps,
+                   /* in*/ const std::vector<int>& dofs,
+                   /*out*/ Eigen::VectorXs& perturbed) {
+          return worker(eps, dofs[0], perturbed);
+        };
+      },
+      groups,
+      nullptr,
+      result,
+      eps,
+      useRidders);
 }
 
 //==============================================================================
-template <class T>
-void finiteDifference(
-    std::function<bool(
+void finiteDifferenceParallel(
+    std::function<std::function<bool(
         /* in*/ s_t eps,
-        /*out*/ T& perturbed)> getPerturbed,
-    T& result,
+        /* in*/ const std::vector<int>& dofs,
+        /*out*/ Eigen::VectorXs& perturbed)>()> createWorker,
+    const std::vector<std::vector<int>>& columnRows,
+    Eigen::MatrixXs& result,
     s_t eps,
     bool useRidders)
 {
-  if (useRidders)
-  {
-    riddersMethod(getPerturbed, result, eps);
-  }
-  else
-  {
-    centralDifference(getPerturbed, result, eps);
-  }
-
-  return;
+  assert(columnRows.size() == result.cols());
+  differenceGroups(
+      createWorker,
+      colorJacobianColumns(columnRows, result.rows()),
+      &columnRows,
+      result,
+      eps,
+      useRidders);
 }
 
 //==============================================================================
-void finiteDifference(
-    std::function<bool(
-        /* in*/ s_t eps,
-        /*out*/ s_t& perturbed)> getPerturbed,
-    s_t& result,
-    s_t eps,
-    bool useRidders)
+std::vector<std::vector<int>> colorJacobianColumns(
+    const std::vector<std::vector<int>>& columnRows, int numRows)
 {
-  if (useRidders)
+  std::vector<std::vector<int>> groups;
+  // Not std::vector<bool>, to keep the inner loop cheap
+  std::vector<std::vector<char>> rowsTaken;
+  for (int col = 0; col < (int)columnRows.size(); col++)
   {
-    riddersMethod(getPerturbed, result, eps);
-  }
-  else
-  {
-    centralDifference(getPerturbed, result, eps);
+    std::size_t group = 0;
+    for (; group < groups.size(); group++)
+    {
+      bool fits = true;
+      for (int row : columnRows[col])
+      {
+        if (rowsTaken[group][row])
+        {
+          fits = false;
+          break;
+        }
+      }
+      if (fits)
+        break;
+    }
+    if (group == groups.size())
+    {
+      groups.emplace_back();
+      rowsTaken.emplace_back(numRows, 0);
+    }
+    groups[group].push_back(col);
+    for (int row : columnRows[col])
+    {
+      rowsTaken[group][row] = 1;
+    }
   }
-
-  return;
+  return groups;
 }
 
 //==============================================================================
@@ -2,6 +2,9 @@
 #define DART_MATH_FINITE_DIFFERENCE_HPP_
 
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -13,6 +16,38 @@ using namespace dart;
 namespace dart {
 namespace math {
 
+namespace detail {
+
+/// This is true if `F` can be called with arguments of types `Args...`
+template <typename F, typename... Args>
+struct IsPerturbation
+{
+  template <typename G>
+  static auto test(int) -> decltype(
+      std::declval<G&>()(std::declval<Args>()...), std::true_type());
+
+  template <typename G>
+  static std::false_type test(...);
+
+  static constexpr bool value = decltype(test<F>(0))::value;
+};
+
+/// This is the type of one column of the Eigen matrix `T`, which is what the
+/// per-DOF callback fills in. It's left empty for non-Eigen types, so
+/// overloads that use it drop out of overload resolution.
+template <typename T>
+struct ColumnOf
+{
+};
+
+template <int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+struct ColumnOf<Eigen::Matrix<s_t, Rows, Cols, Options, MaxRows, MaxCols>>
+{
+  using type = Eigen::Matrix<s_t, Rows, 1>;
+};
+
+} // namespace detail
+
 /// Finite differences a vector function, iterating and perturbing
 /// the partial derivatives w.r.t the input DOFs one by one.
 /// Note that if using Ridders, epsilon should be very large, >=1e-4
@@ -63,6 +98,89 @@ void finiteDifference(
     s_t eps = 1e-7,
     bool useRidders = false);
 
+/// This is the same as the vector finiteDifference() above, except the columns
+/// are spread over the global thread pool. `createWorker` gets called once per
+/// worker (on the calling thread, before any columns start) to make a private
+/// callback, which must only touch state it owns (usually a cloned skeleton).
+/// Each column starts again from `eps`, so this matches finiteDifference()
+/// exactly unless some perturbations get rejected.
+void finiteDifferenceParallel(
+    std::function<std::function<bool(
+        /* in*/ s_t eps,
+        /* in*/ int dof,
+        /*out*/ Eigen::VectorXs& perturbed)>()> createWorker,
+    Eigen::MatrixXs& result,
+    s_t eps = 1e-7,
+    bool useRidders = false);
+
+/// This is finiteDifferenceParallel() for sparse Jacobians. `columnRows[i]`
+/// lists the only rows that column `i` can be nonzero in. Columns that share
+/// no rows get perturbed together (see colorJacobianColumns()), so the
+/// callbacks must accept a whole group of `dofs`, and perturb every one of
+/// them by `eps`. Rows outside of a column's pattern come back as zero.
+void finiteDifferenceParallel(
+    std::function<std::function<bool(
+        /* in*/ s_t eps,
+        /* in*/ const std::vector<int>& dofs,
+        /*out*/ Eigen::VectorXs& perturbed)>()> createWorker,
+    const std::vector<std::vector<int>>& columnRows,
+    Eigen::MatrixXs& result,
+    s_t eps = 1e-7,
+    bool useRidders = false);
+
+/// This greedily partitions the columns of a Jacobian with the sparsity
+/// pattern `columnRows` (see finiteDifferenceParallel()) into groups where no
+/// two columns share a row, so each group can be differenced with a single
+/// set of perturbations.
+std::vector<std::vector<int>> colorJacobianColumns(
+    const std::vector<std::vector<int>>& columnRows, int numRows);
+
+/// These are the same as the overloads above, except they take the callback
+/// as a template parameter instead of a std::function, so the compiler can
+/// inline it into the differencing loops. Lambdas pick these automatically.
+/// T can be any Eigen matrix type, including fixed-size ones, in which case
+/// the per-DOF callback gets a fixed-size column to fill in.
+template <class T, class GetPerturbed>
+typename std::enable_if<detail::IsPerturbation<
+    GetPerturbed,
+    s_t,
+    int,
+    typename detail::ColumnOf<T>::type&>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed,
+    T& result,
+    s_t eps = 1e-7,
+    bool useRidders = false);
+
+template <class T, class GetPerturbed>
+typename std::enable_if<
+    detail::IsPerturbation<GetPerturbed, s_t, int, s_t&>::value
+    && std::is_class<typename detail::ColumnOf<T>::type>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed,
+    T& result,
+    s_t eps = 1e-7,
+    bool useRidders = false);
+
+template <class T, class GetPerturbed>
+typename std::enable_if<
+    detail::IsPerturbation<GetPerturbed, s_t, T&>::value
+    && std::is_class<typename detail::ColumnOf<T>::type>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed,
+    T& result,
+    s_t eps = 1e-7,
+    bool useRidders = false);
+
+template <class GetPerturbed>
+typename std::enable_if<
+    detail::IsPerturbation<GetPerturbed, s_t, s_t&>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed,
+    s_t& result,
+    s_t eps = 1e-7,
+    bool useRidders = false);
+
 struct non_differentiable_point_exception : public std::exception
 {
   const char* what() const throw()
@@ -82,4 +200,6 @@ struct ridders_invalid_state_exception : public std::exception
 } // namespace math
 } // namespace dart
 
-#endif
\ No newline at end of file
+#include "dart/math/detail/FiniteDifference-impl.hpp"
+
+#endif
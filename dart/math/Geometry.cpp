@@ -551,6 +551,42 @@ Eigen::Matrix3s expMapRot(const Eigen::Vector3s& _q)
   return R;
 }
 
+Eigen::MatrixXs expMapRotBatch(const Eigen::MatrixXs& expmaps)
+{
+  using ArrayXs = Eigen::Array<s_t, Eigen::Dynamic, 1>;
+  assert(expmaps.rows() == 3);
+  int n = expmaps.cols();
+
+  ArrayXs x = expmaps.row(0).transpose().array();
+  ArrayXs y = expmaps.row(1).transpose().array();
+  ArrayXs z = expmaps.row(2).transpose().array();
+  ArrayXs theta2 = x * x + y * y + z * z;
+  ArrayXs theta = theta2.sqrt();
+
+  // R = I + a*[q] + b*[q]^2, with the same small angle expansion as
+  // expMapRot(). The unselected branch may divide by zero, but select() never
+  // reads it for those entries.
+  ArrayXs a = (theta < EPSILON_EXPMAP_THETA)
+                  .select(ArrayXs::Ones(n), theta.sin() / theta);
+  ArrayXs b = (theta < EPSILON_EXPMAP_THETA)
+                  .select(
+                      ArrayXs::Constant(n, 0.5),
+                      (ArrayXs::Ones(n) - theta.cos()) / theta2);
+
+  // [q]^2 = q*q^T - theta^2 * I
+  Eigen::MatrixXs R(9, n);
+  R.row(0) = (1.0 + b * (x * x - theta2)).matrix().transpose();
+  R.row(1) = (a * z + b * x * y).matrix().transpose();
+  R.row(2) = (-a * y + b * x * z).matrix().transpose();
+  R.row(3) = (-a * z + b * x * y).matrix().transpose();
+  R.row(4) = (1.0 + b * (y * y - theta2)).matrix().transpose();
+  R.row(5) = (a * x + b * y * z).matrix().transpose();
+  R.row(6) = (a * y + b * x * z).matrix().transpose();
+  R.row(7) = (-a * x + b * y * z).matrix().transpose();
+  R.row(8) = (1.0 + b * (z * z - theta2)).matrix().transpose();
+  return R;
+}
+
 Eigen::Matrix3s expMapJac(const Eigen::Vector3s& _q)
 {
   s_t theta = _q.norm();
@@ -757,6 +793,49 @@ Eigen::Vector3s logMap(const Eigen::Matrix3s& _R)
   // return aa.angle() * aa.axis();
 }
 
+Eigen::MatrixXs logMapBatch(const Eigen::MatrixXs& rotations)
+{
+  using ArrayXs = Eigen::Array<s_t, Eigen::Dynamic, 1>;
+  assert(rotations.rows() == 9);
+  int n = rotations.cols();
+
+  // Rows follow the column-major layout of each 3x3 rotation
+  ArrayXs trace = (rotations.row(0) + rotations.row(4) + rotations.row(8))
+                      .transpose()
+                      .array();
+  ArrayXs theta = (0.5 * (trace - 1.0)).max(-1.0).min(1.0).acos();
+  ArrayXs alpha = (theta > DART_EPSILON)
+                      .select(
+                          0.5 * theta / theta.sin(),
+                          0.5 + (1.0 / 12.0) * theta * theta);
+
+  Eigen::MatrixXs result(3, n);
+  result.row(0) = (alpha
+                   * (rotations.row(5) - rotations.row(7)).transpose().array())
+                      .matrix()
+                      .transpose();
+  result.row(1) = (alpha
+                   * (rotations.row(6) - rotations.row(2)).transpose().array())
+                      .matrix()
+                      .transpose();
+  result.row(2) = (alpha
+                   * (rotations.row(1) - rotations.row(3)).transpose().array())
+                      .matrix()
+                      .transpose();
+
+  // Rotations by nearly pi need the sign disambiguation in logMap(), but
+  // they're rare enough to handle one at a time
+  for (int i = 0; i < n; i++)
+  {
+    if (theta(i) > constantsd::pi() - DART_EPSILON)
+    {
+      result.col(i)
+          = logMap(Eigen::Map<const Eigen::Matrix3s>(rotations.col(i).data()));
+    }
+  }
+  return result;
+}
+
 /// \brief Log mapping
 /// \note This gets the value of d/dt logMap(R), given R and d/dt R
 Eigen::Vector3s dLogMap(const Eigen::Matrix3s& _R, const Eigen::Matrix3s& dR)
@@ -281,6 +281,12 @@ Eigen::Isometry3s expAngular(const Eigen::Vector3s& _s);
 /// \brief Computes the Rotation matrix from a given expmap vector.
 Eigen::Matrix3s expMapRot(const Eigen::Vector3s& _expmap);
 
+/// \brief Computes expMapRot() for every column of a 3xN matrix of expmap
+/// vectors at once, which is much faster than looping over whole trajectories
+/// or skeletons. Column i of the 9xN result holds the rotation for column i,
+/// stored column-major, so Eigen::Map<Eigen::Matrix3s> can read it back.
+Eigen::MatrixXs expMapRotBatch(const Eigen::MatrixXs& expmaps);
+
 /// \brief Computes the Jacobian of the expmap
 Eigen::Matrix3s expMapJac(const Eigen::Vector3s& _expmap);
 
@@ -343,6 +349,10 @@ Eigen::Vector3s finiteDifferenceExpMapNestedGradient(
 /// The implementation returns only the positive one.
 Eigen::Vector3s logMap(const Eigen::Matrix3s& _R);
 
+/// \brief Computes logMap() for every rotation in a 9xN matrix, laid out the
+/// way expMapRotBatch() returns them, and returns the 3xN expmap vectors.
+Eigen::MatrixXs logMapBatch(const Eigen::MatrixXs& rotations);
+
 /// \brief Log mapping
 /// \note This gets the value of d/dt logMap(R), given R and d/dt R
 Eigen::Vector3s dLogMap(const Eigen::Matrix3s& R, const Eigen::Matrix3s& dR);
@@ -2,13 +2,16 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <future>
 #include <iomanip>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/math/FiniteDifference.hpp"
 #include "dart/math/Helpers.hpp"
 #include "dart/math/MathTypes.hpp"
@@ -25,7 +28,8 @@ IKConfig::IKConfig()
     lossLowerBound(1e-10),
     startClamped(false),
     lineSearch(true),
-    logOutput(false)
+    logOutput(false),
+    levenbergMarquardt(false)
 {
 }
 
@@ -95,6 +99,19 @@ IKConfig& IKConfig::setOutputNames(const std::vector<std::string>& v)
   return *this;
 }
 
+IKConfig& IKConfig::setLevenbergMarquardt(bool v)
+{
+  levenbergMarquardt = v;
+  return *this;
+}
+
+IKConfig& IKConfig::setJacobianSparsity(
+    const std::vector<std::vector<int>>& v)
+{
+  jacobianSparsity = v;
+  return *this;
+}
+
 void verifyJacobian(
     const Eigen::VectorXs& originalPos,
     const Eigen::VectorXs& upperBound,
@@ -203,73 +220,140 @@ s_t solveIK(
         getRandomRestart,
     IKConfig config)
 {
-  /*
-#ifndef NDEBUG
-  verifyJacobian(
+  return detail::solveIK<Eigen::Dynamic, Eigen::Dynamic>(
       initialPos,
       upperBound,
       lowerBound,
       targetSize,
       setPosAndClamp,
       eval,
+      getRandomRestart,
       config);
-#endif
-  */
-
-  s_t bestError = std::numeric_limits<s_t>::infinity();
-  Eigen::VectorXs bestResult = initialPos;
-
-  Eigen::VectorXs pos = setPosAndClamp(initialPos, config.startClamped);
+}
 
-  // For each of the restarts, only do 20 steps, to gauge which one seems most
-  // promising
-  for (int k = 0; k < config.maxRestarts; k++)
+s_t solveIKParallel(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    std::function<Eigen::VectorXs(
+        /* in*/ const Eigen::VectorXs& pos, bool clamp)> setPosAndClamp,
+    std::function<void(
+        /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+        /*out*/ Eigen::Ref<Eigen::MatrixXs> jac)> eval,
+    std::function<void(/*out*/ Eigen::Ref<Eigen::VectorXs> pos)>
+        getRandomRestart,
+    std::function<IKWorker()> createWorker,
+    IKConfig config)
+{
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  int numWorkers = std::min((int)pool.getNumThreads(), config.maxRestarts);
+  if (numWorkers <= 1)
   {
-    if (k > 0)
-    {
-      getRandomRestart(pos);
-      pos = setPosAndClamp(pos, true);
-      if (config.logOutput)
-      {
-        std::cout << "## IK random restart " << k << " [best = " << bestError
-                  << "]" << std::endl;
-      }
-    }
-
-    IKResult result = refineIK(
-        pos,
+    return solveIK(
+        initialPos,
         upperBound,
         lowerBound,
         targetSize,
         setPosAndClamp,
         eval,
-        IKConfig(config).setMaxStepCount(20));
+        getRandomRestart,
+        config);
+  }
 
-    if (result.loss < bestError && result.clamped)
-    {
-      bestError = result.loss;
-      bestResult = result.pos;
-      if (result.loss <= config.lossLowerBound)
+  // Draw all the restarts up front, in order, on this thread. That way the
+  // random stream is consumed exactly as it would be serially, and callers
+  // don't need a thread-safe getRandomRestart().
+  Eigen::VectorXs startPos = setPosAndClamp(initialPos, config.startClamped);
+  std::vector<Eigen::VectorXs> restartPos(config.maxRestarts, startPos);
+  for (int k = 1; k < config.maxRestarts; k++)
+  {
+    getRandomRestart(restartPos[k]);
+  }
+
+  // Workers often clone a skeleton, which isn't safe to do concurrently, so we
+  // make them all here before starting
+  std::vector<IKWorker> workers;
+  for (int i = 0; i < numWorkers; i++)
+  {
+    workers.push_back(createWorker());
+  }
+
+  std::vector<IKResult> results(config.maxRestarts);
+  // Not std::vector<bool>, because different workers write neighboring flags
+  std::vector<char> finished(config.maxRestarts, 0);
+  std::atomic<int> nextRestart(0);
+  std::atomic<bool> satisfied(false);
+  IKConfig restartConfig = IKConfig(config).setMaxStepCount(20);
+
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < numWorkers; i++)
+  {
+    futures.push_back(pool.submit([&, i]() {
+      IKWorker& worker = workers[i];
+      // Cancellation is cooperative: a restart in flight runs to completion
+      // (at most 20 steps), but nobody starts a new one once we're satisfied
+      while (!satisfied.load())
       {
-        if (config.logOutput)
+        int k = nextRestart.fetch_add(1);
+        if (k >= config.maxRestarts)
         {
-          std::cout
-              << "Terminating random restarts early, because we found an loss "
+          break;
+        }
+        Eigen::VectorXs pos = worker.setPosAndClamp(
+            restartPos[k], k == 0 ? config.startClamped : true);
+        results[k] = refineIK(
+            pos,
+            upperBound,
+            lowerBound,
+            targetSize,
+            worker.setPosAndClamp,
+            worker.eval,
+            restartConfig);
+        finished[k] = 1;
+        if (results[k].clamped && results[k].loss <= config.lossLowerBound)
+        {
+          satisfied.store(true);
+        }
+      }
+    }));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+
+  // Break ties towards earlier restarts, which is what the serial search does
+  s_t bestError = std::numeric_limits<s_t>::infinity();
+  Eigen::VectorXs bestResult = initialPos;
+  int numFinished = 0;
+  for (int k = 0; k < config.maxRestarts; k++)
+  {
+    if (!finished[k])
+      continue;
+    numFinished++;
+    if (results[k].loss < bestError && results[k].clamped)
+    {
+      bestError = results[k].loss;
+      bestResult = results[k].pos;
+    }
+  }
+  if (config.logOutput && numFinished < config.maxRestarts)
+  {
+    std::cout << "Cancelled " << (config.maxRestarts - numFinished)
+              << " random restarts early, because we found an loss "
               << bestError << " <= " << config.lossLowerBound
               << " that satisfies or exceeds the loss lower-bound we "
                  "were expecting."
               << std::endl;
-        }
-        break;
-      }
-    }
   }
 
   setPosAndClamp(bestResult, true);
 
   // For the best restart, run the remainder of the steps to further refine the
   // IK solution
-  IKResult result = refineIK(
+  refineIK(
       bestResult,
       upperBound,
       lowerBound,
@@ -297,189 +381,14 @@ IKResult refineIK(
         /*out*/ Eigen::Ref<Eigen::MatrixXs> jac)> eval,
     IKConfig config)
 {
-  (void)upperBound;
-  (void)lowerBound;
-
-  Eigen::VectorXs pos = initialPos;
-
-  // Allocate these values once, to re-use in the inner loop
-  Eigen::VectorXs diff = Eigen::VectorXs::Zero(targetSize);
-  Eigen::MatrixXs J = Eigen::MatrixXs::Zero(targetSize, pos.size());
-
-  s_t lastError = std::numeric_limits<s_t>::infinity();
-  s_t lr = 1.0;
-  bool useTranspose = false;
-  bool clamp = config.startClamped;
-
-  pos = setPosAndClamp(pos, clamp);
-
-  Eigen::VectorXs lastPos = pos;
-
-  for (int i = 0; i < config.maxStepCount; i++)
-  {
-    // Force clamping on the last 5 steps of IK, even if we wouldn't have
-    // otherwise clamped. This means that each run results in _something_
-    // valid, even if we hit our maxStepCount before we hit our convergence
-    // threshold.
-    if (i > config.maxStepCount - 5)
-    {
-      clamp = true;
-    }
-
-    /////////////////////////////////////////////////////////////////////////////
-    // Get a current error
-    /////////////////////////////////////////////////////////////////////////////
-
-    eval(diff, J);
-    s_t currentError = diff.squaredNorm();
-
-    /////////////////////////////////////////////////////////////////////////////
-    // Measure change from last timestep
-    /////////////////////////////////////////////////////////////////////////////
-
-    if (i > 0)
-    {
-      s_t errorChange = currentError - lastError;
-
-      if (config.logOutput)
-      {
-        std::cout << "IK "
-                  << " iteration " << i - 1
-                  << " step: " << (useTranspose ? "transpose" : "DLS")
-                  << " clamp: " << clamp << " lr: " << lr
-                  << " loss: " << currentError << " change: " << errorChange
-                  << std::endl;
-      }
-
-      if (currentError < 1e-21)
-      {
-        if (config.logOutput)
-        {
-          std::cout << "Terminating IK search after " << i
-                    << " iterations with loss: " << currentError << std::endl;
-        }
-        break;
-      }
-      if (errorChange > 0)
-      {
-        lr *= 0.5;
-        if (lr < 1e-4)
-        {
-          useTranspose = true;
-        }
-        else if (!config.dontExitTranspose)
-        {
-          useTranspose = false;
-        }
-
-        if (config.lineSearch)
-        {
-          pos = setPosAndClamp(lastPos, clamp);
-        }
-        if (lr < 1e-10)
-        {
-          if (config.logOutput)
-          {
-            std::cout << "Terminating IK search after " << i
-                      << " iterations because learning rate is vanishing, "
-                         "with loss: "
-                      << currentError << std::endl;
-          }
-          break;
-        }
-      }
-      else if (errorChange > -config.convergenceThreshold)
-      {
-        if (!useTranspose)
-        {
-          // Go ahead and tighten down the solution with the transpose as far
-          // as we can
-          if (lr > 5e-5)
-          {
-            lr = 5e-5;
-          }
-          useTranspose = true;
-        }
-        else
-        {
-          if (!clamp)
-          {
-            clamp = true;
-          }
-          else
-          {
-            // Terminate after we've reached the limit _and_ we're clamping
-            // properly
-            if (config.logOutput)
-            {
-              std::cout << "Terminating IK search after " << i
-                        << " iterations with optimal loss: " << currentError
-                        << std::endl;
-            }
-            break;
-          }
-        }
-      }
-      else
-      {
-        // Slowly grow LR while we're safely decreasing loss
-        lr *= 1.1;
-      }
-    }
-
-    lastError = currentError;
-
-    /////////////////////////////////////////////////////////////////////////////
-    // Do the actual IK update
-    /////////////////////////////////////////////////////////////////////////////
-
-    Eigen::VectorXs delta;
-    if (useTranspose)
-    {
-      delta = J.transpose() * diff;
-    }
-    else
-    {
-      // Do damped-least-squares
-      if (config.leastSquaresDamping == 0)
-      {
-        delta = J.completeOrthogonalDecomposition().solve(diff);
-      }
-      else
-      {
-        if (J.cols() < J.rows())
-        {
-          Eigen::MatrixXs toInvert
-              = J * J.transpose()
-                + config.leastSquaresDamping
-                      * Eigen::MatrixXs::Identity(J.rows(), J.rows());
-          delta = J.transpose() * toInvert.llt().solve(diff);
-        }
-        else
-        {
-          Eigen::MatrixXs toInvert
-              = J.transpose() * J
-                + config.leastSquaresDamping
-                      * Eigen::MatrixXs::Identity(J.cols(), J.cols());
-          delta = toInvert.llt().solve(J.transpose() * diff);
-        }
-      }
-    }
-    lastPos = pos;
-    pos = setPosAndClamp(pos - (lr * delta), clamp);
-  }
-
-  if (config.logOutput)
-  {
-    std::cout << "Finished IK search with loss: " << lastError << std::endl;
-  }
-
-  IKResult result;
-  result.pos = pos;
-  result.loss = lastError;
-  result.clamped = clamp;
-
-  return result;
+  return detail::refineIK<Eigen::Dynamic, Eigen::Dynamic>(
+      initialPos,
+      upperBound,
+      lowerBound,
+      targetSize,
+      setPosAndClamp,
+      eval,
+      config);
 }
 
 } // namespace math
@@ -27,6 +27,9 @@ struct IKConfig
   IKConfig& setLogOutput(bool v);
   IKConfig& setInputNames(const std::vector<std::string>& inputNames);
   IKConfig& setOutputNames(const std::vector<std::string>& outputNames);
+  IKConfig& setLevenbergMarquardt(bool v);
+  IKConfig& setJacobianSparsity(
+      const std::vector<std::vector<int>>& jacobianSparsity);
 
   s_t convergenceThreshold = 1e-7;
   int maxStepCount = 100;
@@ -39,6 +42,16 @@ struct IKConfig
   bool logOutput = false;
   std::vector<std::string> inputNames;
   std::vector<std::string> outputNames;
+  /// If true, refineIK() takes trust-region Levenberg-Marquardt steps with
+  /// adaptive damping, instead of damped least squares with a learning rate.
+  /// `leastSquaresDamping` then sets the initial damping, relative to the
+  /// largest diagonal entry of J^T J.
+  bool levenbergMarquardt = false;
+  /// Optionally, for each row of the Jacobian, the columns that can be
+  /// non-zero (for markers on a skeleton, the DOFs of the ancestor joints).
+  /// Levenberg-Marquardt uses this to build J^T J without touching the zeros.
+  /// If empty, the Jacobian is treated as dense.
+  std::vector<std::vector<int>> jacobianSparsity;
 };
 
 struct IKResult
@@ -48,6 +61,20 @@ struct IKResult
   bool clamped;
 };
 
+/// These are the callbacks solveIKParallel() gives to each of its workers.
+/// Each set must only touch state it owns (usually a cloned skeleton), so
+/// that different workers can run restarts at the same time.
+struct IKWorker
+{
+  std::function<Eigen::VectorXs(
+      /* in*/ const Eigen::VectorXs& pos, bool clamp)>
+      setPosAndClamp;
+  std::function<void(
+      /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+      /*out*/ Eigen::Ref<Eigen::MatrixXs> jac)>
+      eval;
+};
+
 void verifyJacobian(
     const Eigen::VectorXs& atPos,
     const Eigen::VectorXs& upperBound,
@@ -74,6 +101,28 @@ s_t solveIK(
         getRandomRestart,
     IKConfig config = IKConfig());
 
+/// This is the same search as solveIK(), except the random restarts are spread
+/// over the global thread pool. `createWorker` gets called once per worker (on
+/// the calling thread, before any restarts start) to make a private set of
+/// callbacks. As soon as any restart reaches `config.lossLowerBound`, the
+/// workers stop picking up new restarts. The final refinement of the best
+/// restart runs on the caller's own callbacks, so the caller's state ends up
+/// at the solution, just like solveIK().
+s_t solveIKParallel(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    std::function<Eigen::VectorXs(
+        /* in*/ const Eigen::VectorXs& pos, bool clamp)> setPosAndClamp,
+    std::function<void(
+        /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+        /*out*/ Eigen::Ref<Eigen::MatrixXs> jac)> eval,
+    std::function<void(/*out*/ Eigen::Ref<Eigen::VectorXs> pos)>
+        getRandomRestart,
+    std::function<IKWorker()> createWorker,
+    IKConfig config = IKConfig());
+
 IKResult refineIK(
     const Eigen::VectorXs& initialPos,
     const Eigen::VectorXs& upperBound,
@@ -86,7 +135,45 @@ IKResult refineIK(
         /*out*/ Eigen::Ref<Eigen::MatrixXs> jac)> eval,
     IKConfig config = IKConfig());
 
+/// These are the same as refineIK() and solveIK() above, except they take the
+/// callbacks as template parameters instead of std::functions, so the
+/// compiler can inline them into the IK loop. Lambdas pick these
+/// automatically. If the number of DOFs and targets are known at compile
+/// time, pass them as `Dofs` and `Targets` to keep all the IK buffers
+/// fixed-size, for example refineIK<3, 3>(...).
+template <
+    int Dofs = Eigen::Dynamic,
+    int Targets = Eigen::Dynamic,
+    class SetPosAndClamp,
+    class Eval>
+IKResult refineIK(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    SetPosAndClamp setPosAndClamp,
+    Eval eval,
+    IKConfig config = IKConfig());
+
+template <
+    int Dofs = Eigen::Dynamic,
+    int Targets = Eigen::Dynamic,
+    class SetPosAndClamp,
+    class Eval,
+    class GetRandomRestart>
+s_t solveIK(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    SetPosAndClamp setPosAndClamp,
+    Eval eval,
+    GetRandomRestart getRandomRestart,
+    IKConfig config = IKConfig());
+
 } // namespace math
 } // namespace dart
 
+#include "dart/math/detail/IKSolver-impl.hpp"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,301 @@
+#include "dart/math/LBFGSB.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+LBFGSBConfig::LBFGSBConfig()
+{
+}
+
+//==============================================================================
+LBFGSBConfig& LBFGSBConfig::setMaxIterations(int v)
+{
+  maxIterations = v;
+  return *this;
+}
+
+//==============================================================================
+LBFGSBConfig& LBFGSBConfig::setHistoryLength(int v)
+{
+  historyLength = v;
+  return *this;
+}
+
+//==============================================================================
+LBFGSBConfig& LBFGSBConfig::setGradientTolerance(s_t v)
+{
+  gradientTolerance = v;
+  return *this;
+}
+
+//==============================================================================
+LBFGSBConfig& LBFGSBConfig::setLossTolerance(s_t v)
+{
+  lossTolerance = v;
+  return *this;
+}
+
+//==============================================================================
+LBFGSBConfig& LBFGSBConfig::setMaxLineSearchSteps(int v)
+{
+  maxLineSearchSteps = v;
+  return *this;
+}
+
+//==============================================================================
+LBFGSBConfig& LBFGSBConfig::setLogOutput(bool v)
+{
+  logOutput = v;
+  return *this;
+}
+
+//==============================================================================
+/// This returns true if we stopped because we converged
+bool LBFGSBResult::converged() const
+{
+  return status == LBFGSBStatus::CONVERGED_GRADIENT
+         || status == LBFGSBStatus::CONVERGED_LOSS;
+}
+
+//==============================================================================
+LBFGSB::LBFGSB(LBFGSBConfig config)
+  : mConfig(config), mDim(-1), mHistorySize(0), mHistoryStart(0), mGamma(1.0)
+{
+}
+
+//==============================================================================
+/// This sets the config used by later calls to minimize(), and reallocates
+/// the history if its length changed
+void LBFGSB::setConfig(LBFGSBConfig config)
+{
+  bool resize = config.historyLength != mConfig.historyLength;
+  mConfig = config;
+  if (resize && mDim >= 0)
+  {
+    int dim = mDim;
+    mDim = -1;
+    reserve(dim);
+  }
+}
+
+//==============================================================================
+const LBFGSBConfig& LBFGSB::getConfig() const
+{
+  return mConfig;
+}
+
+//==============================================================================
+/// This registers a callback to get called after every iteration
+void LBFGSB::setIterationCallback(IterationCallback callback)
+{
+  mCallback = callback;
+}
+
+//==============================================================================
+/// This allocates the workspace for problems with `dim` variables, so the
+/// first minimize() doesn't have to
+void LBFGSB::reserve(int dim)
+{
+  if (dim == mDim)
+    return;
+  mDim = dim;
+  const int m = std::max(mConfig.historyLength, 1);
+  mS.resize(dim, m);
+  mY.resize(dim, m);
+  mRho.resize(m);
+  mAlpha.resize(m);
+  mGrad.resize(dim);
+  mNewGrad.resize(dim);
+  mNewX.resize(dim);
+  mProjectedGrad.resize(dim);
+  mDirection.resize(dim);
+  mFree.resize(dim);
+  resetHistory();
+}
+
+//==============================================================================
+/// This minimizes `objective` over the box [lower, upper], starting from
+/// (and writing the answer into) `x`. Bounds can be infinite. Every accepted
+/// step lowers the loss, so `x` ends up at the best point found.
+LBFGSBResult LBFGSB::minimize(
+    const Objective& objective,
+    Eigen::Ref<Eigen::VectorXs> x,
+    const Eigen::Ref<const Eigen::VectorXs>& lower,
+    const Eigen::Ref<const Eigen::VectorXs>& upper)
+{
+  const int n = x.size();
+  assert(lower.size() == n && upper.size() == n);
+  reserve(n);
+  resetHistory();
+  const int m = mS.cols();
+
+  LBFGSBResult result;
+  result.status = LBFGSBStatus::ITERATION_LIMIT;
+  result.iterations = 0;
+  result.evaluations = 1;
+
+  // Start inside the box
+  mNewX = x.cwiseMax(lower).cwiseMin(upper);
+  s_t loss = objective(mNewX, mGrad);
+  x = mNewX;
+
+  for (int iter = 0; iter < mConfig.maxIterations; iter++)
+  {
+    // Variables pinned against a bound by the gradient stay where they are
+    for (int i = 0; i < n; i++)
+    {
+      bool pinned = (x(i) <= lower(i) && mGrad(i) > 0)
+                    || (x(i) >= upper(i) && mGrad(i) < 0);
+      mFree(i) = pinned ? 0.0 : 1.0;
+    }
+    mProjectedGrad = mGrad.cwiseProduct(mFree);
+    if (mProjectedGrad.lpNorm<Eigen::Infinity>() <= mConfig.gradientTolerance)
+    {
+      result.status = LBFGSBStatus::CONVERGED_GRADIENT;
+      break;
+    }
+
+    computeDirection();
+    if (!(mDirection.dot(mGrad) < 0))
+    {
+      // The history has gone stale, so fall back to steepest descent
+      resetHistory();
+      mDirection = -mProjectedGrad;
+    }
+
+    // Without any history we have no idea of the scale of the problem, so
+    // start with a step of unit length
+    s_t stepSize = 1.0;
+    if (mHistorySize == 0)
+      stepSize = std::min<s_t>(1.0, 1.0 / mDirection.norm());
+
+    bool accepted = false;
+    s_t newLoss = loss;
+    for (int ls = 0; ls < mConfig.maxLineSearchSteps; ls++)
+    {
+      mNewX = (x + stepSize * mDirection).cwiseMax(lower).cwiseMin(upper);
+      newLoss = objective(mNewX, mNewGrad);
+      result.evaluations++;
+      // Armijo along the projected path
+      if (std::isfinite(static_cast<double>(newLoss))
+          && newLoss <= loss + 1e-4 * mGrad.dot(mNewX - x))
+      {
+        accepted = true;
+        break;
+      }
+      stepSize *= 0.5;
+    }
+    if (!accepted)
+    {
+      if (mHistorySize > 0)
+      {
+        resetHistory();
+        continue;
+      }
+      result.status = LBFGSBStatus::LINE_SEARCH_FAILED;
+      break;
+    }
+
+    // Write the new pair into the next slot of the ring buffer, and only
+    // keep it if it has positive curvature
+    int slot = (mHistoryStart + mHistorySize) % m;
+    mS.col(slot) = mNewX - x;
+    mY.col(slot) = mNewGrad - mGrad;
+    s_t sy = mS.col(slot).dot(mY.col(slot));
+    s_t yy = mY.col(slot).squaredNorm();
+    if (sy > 1e-10 * yy && yy > 0)
+    {
+      mRho(slot) = 1.0 / sy;
+      mGamma = sy / yy;
+      if (mHistorySize < m)
+        mHistorySize++;
+      else
+        mHistoryStart = (mHistoryStart + 1) % m;
+    }
+
+    s_t improvement = loss - newLoss;
+    x = mNewX;
+    mGrad.swap(mNewGrad);
+    loss = newLoss;
+    result.iterations++;
+
+    if (mConfig.logOutput)
+    {
+      std::cout << "[LBFGSB] " << iter << ": loss=" << loss
+                << ", step=" << stepSize << std::endl;
+    }
+    if (mCallback && !mCallback(iter, loss, mNewX))
+    {
+      result.status = LBFGSBStatus::STOPPED_BY_CALLBACK;
+      break;
+    }
+    if (improvement
+        <= mConfig.lossTolerance * std::max<s_t>(1.0, std::abs(loss)))
+    {
+      result.status = LBFGSBStatus::CONVERGED_LOSS;
+      break;
+    }
+  }
+
+  result.loss = loss;
+  return result;
+}
+
+//==============================================================================
+/// This is the same as above, but without bounds
+LBFGSBResult LBFGSB::minimize(
+    const Objective& objective, Eigen::Ref<Eigen::VectorXs> x)
+{
+  const int n = x.size();
+  return minimize(
+      objective,
+      x,
+      Eigen::VectorXs::Constant(n, -std::numeric_limits<s_t>::infinity()),
+      Eigen::VectorXs::Constant(n, std::numeric_limits<s_t>::infinity()));
+}
+
+//==============================================================================
+/// This computes mDirection = -H * mProjectedGrad from the history, over the
+/// variables in mFree
+void LBFGSB::computeDirection()
+{
+  const int m = mS.cols();
+  // The standard two-loop recursion, with every vector restricted to the
+  // free variables
+  mDirection = mProjectedGrad;
+  for (int k = mHistorySize - 1; k >= 0; k--)
+  {
+    int idx = (mHistoryStart + k) % m;
+    mAlpha(idx)
+        = mRho(idx) * mS.col(idx).cwiseProduct(mFree).dot(mDirection);
+    mDirection -= mAlpha(idx) * mY.col(idx).cwiseProduct(mFree);
+  }
+  if (mHistorySize > 0)
+    mDirection *= mGamma;
+  for (int k = 0; k < mHistorySize; k++)
+  {
+    int idx = (mHistoryStart + k) % m;
+    s_t beta = mRho(idx) * mY.col(idx).cwiseProduct(mFree).dot(mDirection);
+    mDirection += (mAlpha(idx) - beta) * mS.col(idx).cwiseProduct(mFree);
+  }
+  mDirection = -mDirection;
+}
+
+//==============================================================================
+/// This drops the history
+void LBFGSB::resetHistory()
+{
+  mHistorySize = 0;
+  mHistoryStart = 0;
+  mGamma = 1.0;
+}
+
+} // namespace math
+} // namespace dart
@@ -0,0 +1,163 @@
+#ifndef DART_MATH_LBFGSB_HPP_
+#define DART_MATH_LBFGSB_HPP_
+
+#include <functional>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+struct LBFGSBConfig
+{
+  LBFGSBConfig();
+
+  LBFGSBConfig& setMaxIterations(int v);
+  LBFGSBConfig& setHistoryLength(int v);
+  LBFGSBConfig& setGradientTolerance(s_t v);
+  LBFGSBConfig& setLossTolerance(s_t v);
+  LBFGSBConfig& setMaxLineSearchSteps(int v);
+  LBFGSBConfig& setLogOutput(bool v);
+
+  int maxIterations = 200;
+  /// The number of (step, gradient change) pairs kept to build the inverse
+  /// Hessian approximation
+  int historyLength = 6;
+  /// We stop once the largest entry of the projected gradient is below this
+  s_t gradientTolerance = 1e-8;
+  /// We stop once an iteration improves the loss by less than this, relative
+  /// to the size of the loss
+  s_t lossTolerance = 1e-12;
+  int maxLineSearchSteps = 30;
+  bool logOutput = false;
+};
+
+enum class LBFGSBStatus
+{
+  /// The projected gradient fell below `gradientTolerance`
+  CONVERGED_GRADIENT,
+  /// An iteration improved the loss by less than `lossTolerance`
+  CONVERGED_LOSS,
+  /// We hit `maxIterations`
+  ITERATION_LIMIT,
+  /// Even a steepest descent step couldn't reduce the loss
+  LINE_SEARCH_FAILED,
+  /// The iteration callback asked us to stop
+  STOPPED_BY_CALLBACK
+};
+
+struct LBFGSBResult
+{
+  LBFGSBStatus status;
+  s_t loss;
+  int iterations;
+  int evaluations;
+
+  /// This returns true if we stopped because we converged
+  bool converged() const;
+};
+
+/// This is a small in-process solver for box-bounded problems, for when
+/// standing up IPOPT would cost more than the solve itself. It's the
+/// projected, active-set flavor of L-BFGS-B. Each iteration freezes the
+/// variables that are pinned against a bound by the gradient, takes an
+/// L-BFGS step in the rest, and then backtracks along the projection of that
+/// step back into the box until the loss drops enough (Armijo). It skips
+/// L-BFGS-B's generalized Cauchy point search, which matters little for the
+/// mostly-interior problems this is meant for.
+///
+/// All the workspace is allocated up front and reused from one minimize() to
+/// the next, as long as the problem size doesn't change, so one solver can
+/// churn through many tiny problems cheaply.
+class LBFGSB
+{
+public:
+  /// This evaluates the loss at `x`, and writes its gradient into `grad`
+  /// (which is already the right size)
+  using Objective = std::function<s_t(
+      const Eigen::VectorXs& x, /* OUT */ Eigen::VectorXs& grad)>;
+
+  /// This gets called after every iteration. Returning false stops the
+  /// solve.
+  using IterationCallback
+      = std::function<bool(int iteration, s_t loss, const Eigen::VectorXs& x)>;
+
+  LBFGSB(LBFGSBConfig config = LBFGSBConfig());
+
+  /// This sets the config used by later calls to minimize(), and reallocates
+  /// the history if its length changed
+  void setConfig(LBFGSBConfig config);
+
+  const LBFGSBConfig& getConfig() const;
+
+  /// This registers a callback to get called after every iteration
+  void setIterationCallback(IterationCallback callback);
+
+  /// This allocates the workspace for problems with `dim` variables, so the
+  /// first minimize() doesn't have to
+  void reserve(int dim);
+
+  /// This minimizes `objective` over the box [lower, upper], starting from
+  /// (and writing the answer into) `x`. Bounds can be infinite. Every
+  /// accepted step lowers the loss, so `x` ends up at the best point found.
+  LBFGSBResult minimize(
+      const Objective& objective,
+      Eigen::Ref<Eigen::VectorXs> x,
+      const Eigen::Ref<const Eigen::VectorXs>& lower,
+      const Eigen::Ref<const Eigen::VectorXs>& upper);
+
+  /// This is the same as above, but without bounds
+  LBFGSBResult minimize(
+      const Objective& objective, Eigen::Ref<Eigen::VectorXs> x);
+
+  /// This minimizes any problem object with the flatten(), unflatten(x),
+  /// getLoss() and getGradient() methods the MarkerFitter subproblems have,
+  /// over the box [lower, upper]. The problem is left unflattened at the
+  /// answer.
+  template <typename ProblemT>
+  LBFGSBResult minimizeProblem(
+      ProblemT& problem,
+      const Eigen::Ref<const Eigen::VectorXs>& lower,
+      const Eigen::Ref<const Eigen::VectorXs>& upper);
+
+  /// This is the same as above, but without bounds
+  template <typename ProblemT>
+  LBFGSBResult minimizeProblem(ProblemT& problem);
+
+protected:
+  /// This computes mDirection = -H * mProjectedGrad from the history, over
+  /// the variables in mFree
+  void computeDirection();
+
+  /// This drops the history
+  void resetHistory();
+
+  LBFGSBConfig mConfig;
+  IterationCallback mCallback;
+
+  // Workspace, reused across solves
+  int mDim;
+  Eigen::MatrixXs mS;
+  Eigen::MatrixXs mY;
+  Eigen::VectorXs mRho;
+  Eigen::VectorXs mAlpha;
+  Eigen::VectorXs mGrad;
+  Eigen::VectorXs mNewGrad;
+  Eigen::VectorXs mNewX;
+  Eigen::VectorXs mProjectedGrad;
+  Eigen::VectorXs mDirection;
+  Eigen::VectorXs mFree;
+  // The history is a ring buffer. mHistoryStart is the oldest pair.
+  int mHistorySize;
+  int mHistoryStart;
+  s_t mGamma;
+};
+
+} // namespace math
+} // namespace dart
+
+#include "dart/math/detail/LBFGSB-impl.hpp"
+
+#endif
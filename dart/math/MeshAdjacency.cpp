@@ -0,0 +1,298 @@
+#include "dart/math/MeshAdjacency.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace dart {
+namespace math {
+
+namespace {
+
+long long edgeKey(int a, int b)
+{
+  return ((long long)a << 32) | (unsigned int)b;
+}
+
+bool lexicographicLess(const Eigen::Vector3s& a, const Eigen::Vector3s& b)
+{
+  if (a(0) != b(0))
+    return a(0) < b(0);
+  if (a(1) != b(1))
+    return a(1) < b(1);
+  return a(2) < b(2);
+}
+
+} // namespace
+
+//==============================================================================
+/// This builds the adjacency of the triangles in `triangles`, which index
+/// into `vertices`. `vertices` can repeat positions (meshes usually do, once
+/// per face), and those get welded into a single vertex.
+MeshAdjacency::MeshAdjacency(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3i>& triangles)
+  : mClosed(false), mConvex(false)
+{
+  const int numRaw = vertices.size();
+
+  // 1. Weld exact duplicates. A stable sort keeps the lowest original index
+  // at the front of each run of equal positions.
+  std::vector<int> order(numRaw);
+  for (int i = 0; i < numRaw; i++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return lexicographicLess(vertices[a], vertices[b]);
+  });
+  std::vector<int> runStarts;
+  for (int i = 0; i < numRaw; i++)
+  {
+    if (i == 0 || vertices[order[i]] != vertices[order[i - 1]])
+      runStarts.push_back(i);
+  }
+  // Number the welded vertices in the order they first show up
+  std::vector<int> runByFirstIndex(runStarts.size());
+  for (int r = 0; r < runStarts.size(); r++)
+    runByFirstIndex[r] = r;
+  std::sort(runByFirstIndex.begin(), runByFirstIndex.end(), [&](int a, int b) {
+    return order[runStarts[a]] < order[runStarts[b]];
+  });
+  std::vector<int> weldedIdOfRun(runStarts.size());
+  for (int id = 0; id < runByFirstIndex.size(); id++)
+    weldedIdOfRun[runByFirstIndex[id]] = id;
+
+  mVertices.resize(runStarts.size());
+  mFirstIndices.resize(runStarts.size());
+  mSortedVertices.resize(runStarts.size());
+  mWeldedIndices.resize(numRaw);
+  for (int r = 0; r < runStarts.size(); r++)
+  {
+    int id = weldedIdOfRun[r];
+    int end = r + 1 < runStarts.size() ? runStarts[r + 1] : numRaw;
+    mVertices[id] = vertices[order[runStarts[r]]];
+    mFirstIndices[id] = order[runStarts[r]];
+    mSortedVertices[r] = id;
+    for (int i = runStarts[r]; i < end; i++)
+      mWeldedIndices[order[i]] = id;
+  }
+
+  // 2. Re-index the triangles, dropping any that collapse when welded
+  for (const Eigen::Vector3i& triangle : triangles)
+  {
+    Eigen::Vector3i welded(
+        mWeldedIndices[triangle(0)],
+        mWeldedIndices[triangle(1)],
+        mWeldedIndices[triangle(2)]);
+    if (welded(0) == welded(1) || welded(1) == welded(2)
+        || welded(2) == welded(0))
+      continue;
+    mTriangles.push_back(welded);
+    Eigen::Vector3s normal
+        = (mVertices[welded(1)] - mVertices[welded(0)])
+              .cross(mVertices[welded(2)] - mVertices[welded(0)]);
+    s_t norm = normal.norm();
+    mFaceNormals.push_back(norm > 0 ? Eigen::Vector3s(normal / norm) : normal);
+  }
+
+  // 3. Pair up the half-edges. An edge used twice in the same direction
+  // isn't manifold, so it doesn't get a twin.
+  const int numHalfEdges = 3 * mTriangles.size();
+  std::unordered_map<long long, int> halfEdgeByKey;
+  halfEdgeByKey.reserve(numHalfEdges);
+  for (int h = 0; h < numHalfEdges; h++)
+  {
+    int a = mTriangles[h / 3]((h % 3));
+    int b = mTriangles[h / 3]((h % 3 + 1) % 3);
+    auto inserted = halfEdgeByKey.emplace(edgeKey(a, b), h);
+    if (!inserted.second)
+      inserted.first->second = -1;
+  }
+  mTwins.resize(numHalfEdges, -1);
+  mNeighbors.resize(mVertices.size());
+  bool allTwinned = true;
+  for (int h = 0; h < numHalfEdges; h++)
+  {
+    int a = mTriangles[h / 3]((h % 3));
+    int b = mTriangles[h / 3]((h % 3 + 1) % 3);
+    mNeighbors[a].push_back(b);
+    mNeighbors[b].push_back(a);
+    auto self = halfEdgeByKey.find(edgeKey(a, b));
+    auto twin = halfEdgeByKey.find(edgeKey(b, a));
+    if (self->second != -1 && twin != halfEdgeByKey.end()
+        && twin->second != -1)
+    {
+      mTwins[h] = twin->second;
+    }
+    else
+    {
+      allTwinned = false;
+    }
+  }
+  bool allUsed = true;
+  for (std::vector<int>& neighbors : mNeighbors)
+  {
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(
+        std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    if (neighbors.empty())
+      allUsed = false;
+  }
+  mClosed = allTwinned && allUsed && !mTriangles.empty();
+  if (!mClosed)
+    return;
+
+  // 4. Check convexity: one connected piece, with the far vertex of the
+  // triangle across each edge on the same side of every face
+  std::vector<int> reached;
+  floodFill(0, [](int) { return true; }, reached);
+  if (reached.size() != mVertices.size())
+    return;
+  Eigen::Vector3s boxMin = mVertices[0];
+  Eigen::Vector3s boxMax = mVertices[0];
+  for (const Eigen::Vector3s& vertex : mVertices)
+  {
+    boxMin = boxMin.cwiseMin(vertex);
+    boxMax = boxMax.cwiseMax(vertex);
+  }
+  const s_t tolerance = 1e-6 * (boxMax - boxMin).norm();
+  bool allBelow = true;
+  bool allAbove = true;
+  for (int h = 0; h < numHalfEdges; h++)
+  {
+    const Eigen::Vector3s& normal = mFaceNormals[h / 3];
+    int twin = mTwins[h];
+    int far = mTriangles[twin / 3]((twin % 3 + 2) % 3);
+    s_t height = normal.dot(
+        mVertices[far] - mVertices[mTriangles[h / 3]((h % 3))]);
+    if (height > tolerance)
+      allBelow = false;
+    if (height < -tolerance)
+      allAbove = false;
+  }
+  mConvex = allBelow || allAbove;
+}
+
+//==============================================================================
+/// These are the welded vertices
+const std::vector<Eigen::Vector3s>& MeshAdjacency::getVertices() const
+{
+  return mVertices;
+}
+
+//==============================================================================
+/// This maps each of the vertices passed to the constructor to its index in
+/// getVertices()
+const std::vector<int>& MeshAdjacency::getWeldedIndices() const
+{
+  return mWeldedIndices;
+}
+
+//==============================================================================
+/// This returns, for each welded vertex, the smallest index of the
+/// constructor's vertices that got welded into it. Sorting by this puts
+/// welded vertices back in the order a scan over the original vertices would
+/// first see them.
+const std::vector<int>& MeshAdjacency::getFirstIndices() const
+{
+  return mFirstIndices;
+}
+
+//==============================================================================
+/// This is the list of neighbors (along triangle edges) of each welded vertex
+const std::vector<std::vector<int>>& MeshAdjacency::getNeighbors() const
+{
+  return mNeighbors;
+}
+
+//==============================================================================
+/// These are the triangles, indexing into getVertices()
+const std::vector<Eigen::Vector3i>& MeshAdjacency::getTriangles() const
+{
+  return mTriangles;
+}
+
+//==============================================================================
+/// These are the unit normals of the triangles, following the winding order.
+/// Degenerate triangles get a zero normal.
+const std::vector<Eigen::Vector3s>& MeshAdjacency::getFaceNormals() const
+{
+  return mFaceNormals;
+}
+
+//==============================================================================
+/// This is the twin of each half-edge, or -1 if the edge is on a boundary (or
+/// is shared by more than two triangles)
+const std::vector<int>& MeshAdjacency::getHalfEdgeTwins() const
+{
+  return mTwins;
+}
+
+//==============================================================================
+/// This returns true if every half-edge has a twin, and every welded vertex
+/// is on at least one triangle
+bool MeshAdjacency::isClosed() const
+{
+  return mClosed;
+}
+
+//==============================================================================
+/// This returns true if the mesh is closed, connected, and bends the same way
+/// (up to a small tolerance) across every edge, which means it's the surface
+/// of a convex solid.
+bool MeshAdjacency::isConvex() const
+{
+  return mConvex;
+}
+
+//==============================================================================
+/// This returns the index of the welded vertex at exactly `point`, or -1 if
+/// there isn't one
+int MeshAdjacency::findVertex(const Eigen::Vector3s& point) const
+{
+  auto it = std::lower_bound(
+      mSortedVertices.begin(),
+      mSortedVertices.end(),
+      point,
+      [this](int id, const Eigen::Vector3s& p) {
+        return lexicographicLess(mVertices[id], p);
+      });
+  if (it == mSortedVertices.end() || mVertices[*it] != point)
+    return -1;
+  return *it;
+}
+
+//==============================================================================
+/// This collects every welded vertex that `inside` returns true for and that
+/// can be reached from `start` by walking along edges between such vertices.
+/// The result is sorted by getFirstIndices().
+void MeshAdjacency::floodFill(
+    int start,
+    const std::function<bool(int)>& inside,
+    std::vector<int>& out) const
+{
+  out.clear();
+  if (start < 0 || start >= (int)mVertices.size() || !inside(start))
+    return;
+
+  std::unordered_set<int> seen;
+  seen.insert(start);
+  std::vector<int> frontier;
+  frontier.push_back(start);
+  while (!frontier.empty())
+  {
+    int vertex = frontier.back();
+    frontier.pop_back();
+    out.push_back(vertex);
+    for (int neighbor : mNeighbors[vertex])
+    {
+      if (seen.insert(neighbor).second && inside(neighbor))
+        frontier.push_back(neighbor);
+    }
+  }
+  std::sort(out.begin(), out.end(), [this](int a, int b) {
+    return mFirstIndices[a] < mFirstIndices[b];
+  });
+}
+
+} // namespace math
+} // namespace dart
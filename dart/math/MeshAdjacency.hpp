@@ -0,0 +1,102 @@
+#ifndef DART_MATH_MESH_ADJACENCY_HPP_
+#define DART_MATH_MESH_ADJACENCY_HPP_
+
+#include <functional>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is the connectivity of a triangle mesh surface: the mesh vertices with
+/// exact duplicates welded together, a neighbor list for each vertex, the
+/// triangles with their normals, and half-edge twins. It's built once per mesh
+/// so that contact generation can walk across the surface from a known vertex
+/// instead of scanning every vertex of the mesh.
+///
+/// Half-edge `3 * f + k` runs from corner `k` to corner `(k + 1) % 3` of
+/// triangle `f`, and its twin is the half-edge running the other way along the
+/// same edge, in the neighboring triangle.
+class MeshAdjacency
+{
+public:
+  /// This builds the adjacency of the triangles in `triangles`, which index
+  /// into `vertices`. `vertices` can repeat positions (meshes usually do, once
+  /// per face), and those get welded into a single vertex.
+  MeshAdjacency(
+      const std::vector<Eigen::Vector3s>& vertices,
+      const std::vector<Eigen::Vector3i>& triangles);
+
+  /// These are the welded vertices
+  const std::vector<Eigen::Vector3s>& getVertices() const;
+
+  /// This maps each of the vertices passed to the constructor to its index in
+  /// getVertices()
+  const std::vector<int>& getWeldedIndices() const;
+
+  /// This returns, for each welded vertex, the smallest index of the
+  /// constructor's vertices that got welded into it. Sorting by this puts
+  /// welded vertices back in the order a scan over the original vertices would
+  /// first see them.
+  const std::vector<int>& getFirstIndices() const;
+
+  /// This is the list of neighbors (along triangle edges) of each welded
+  /// vertex
+  const std::vector<std::vector<int>>& getNeighbors() const;
+
+  /// These are the triangles, indexing into getVertices()
+  const std::vector<Eigen::Vector3i>& getTriangles() const;
+
+  /// These are the unit normals of the triangles, following the winding
+  /// order. Degenerate triangles get a zero normal.
+  const std::vector<Eigen::Vector3s>& getFaceNormals() const;
+
+  /// This is the twin of each half-edge, or -1 if the edge is on a boundary
+  /// (or is shared by more than two triangles)
+  const std::vector<int>& getHalfEdgeTwins() const;
+
+  /// This returns true if every half-edge has a twin, and every welded vertex
+  /// is on at least one triangle
+  bool isClosed() const;
+
+  /// This returns true if the mesh is closed, connected, and bends the same
+  /// way (up to a small tolerance) across every edge, which means it's the
+  /// surface of a convex solid. On a convex mesh, the vertices within any
+  /// distance of a supporting plane form a connected patch, so they can all be
+  /// found by walking out from one of them.
+  bool isConvex() const;
+
+  /// This returns the index of the welded vertex at exactly `point`, or -1 if
+  /// there isn't one
+  int findVertex(const Eigen::Vector3s& point) const;
+
+  /// This collects every welded vertex that `inside` returns true for and that
+  /// can be reached from `start` by walking along edges between such
+  /// vertices. The result is sorted by getFirstIndices(). `out` is cleared
+  /// first, and stays empty if `inside(start)` is false.
+  void floodFill(
+      int start,
+      const std::function<bool(int)>& inside,
+      /* OUT */ std::vector<int>& out) const;
+
+protected:
+  std::vector<Eigen::Vector3s> mVertices;
+  std::vector<int> mWeldedIndices;
+  std::vector<int> mFirstIndices;
+  std::vector<std::vector<int>> mNeighbors;
+  std::vector<Eigen::Vector3i> mTriangles;
+  std::vector<Eigen::Vector3s> mFaceNormals;
+  std::vector<int> mTwins;
+  // The welded vertices in lexicographic order, for findVertex()
+  std::vector<int> mSortedVertices;
+  bool mClosed;
+  bool mConvex;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -16,6 +16,8 @@ MultivariateGaussian::MultivariateGaussian(
   s_t logTwoPi = log(twoPi);
   s_t logTwoPiExp = logTwoPi * (((s_t)mVars.size()) / 2);
   mCovInv = Eigen::LLT<Eigen::MatrixXs>(mCov);
+  mPrecision
+      = mCovInv.solve(Eigen::MatrixXs::Identity(mCov.rows(), mCov.cols()));
 
   // Compute the log-determinant
   auto& U = mCovInv.matrixL();
@@ -28,9 +30,9 @@ MultivariateGaussian::MultivariateGaussian(
 
   mLogNormalizationConstant = -1 * (logSqrtDet + logTwoPiExp);
 
-  s_t det = mCov.determinant();
-  s_t twoPiExp = pow(twoPi, mVars.size());
-  mNormalizationConstant = 1. / (sqrt(twoPiExp * det));
+  // This is 1 / sqrt((2 pi)^n * det(cov)), but we've already got the
+  // determinant from the Cholesky factor, so there's no need for another LU
+  mNormalizationConstant = exp(mLogNormalizationConstant);
 }
 
 void MultivariateGaussian::debugToStdout()
@@ -111,7 +113,28 @@ s_t MultivariateGaussian::computeLogPDF(Eigen::VectorXs x, bool normalized)
 Eigen::VectorXs MultivariateGaussian::computeLogPDFGrad(Eigen::VectorXs x)
 {
   Eigen::VectorXs diff = x - mMu;
-  return -mCovInv.solve(diff);
+  return -mPrecision * diff;
+}
+
+Eigen::VectorXs MultivariateGaussian::computeLogPDFBatch(
+    const Eigen::MatrixXs& xs, bool normalized)
+{
+  Eigen::MatrixXs diffs = xs.colwise() - mMu;
+  // diff^T cov^-1 diff = |L^-1 diff|^2, where cov = L L^T
+  Eigen::MatrixXs whitened = mCovInv.matrixL().solve(diffs);
+  Eigen::VectorXs result
+      = -0.5 * whitened.colwise().squaredNorm().transpose();
+  if (normalized)
+  {
+    result.array() += mLogNormalizationConstant;
+  }
+  return result;
+}
+
+Eigen::MatrixXs MultivariateGaussian::computeLogPDFGradBatch(
+    const Eigen::MatrixXs& xs)
+{
+  return -mPrecision * (xs.colwise() - mMu);
 }
 
 Eigen::VectorXs MultivariateGaussian::finiteDifferenceLogPDFGrad(
@@ -36,6 +36,15 @@ public:
 
   Eigen::VectorXs computeLogPDFGrad(Eigen::VectorXs x);
 
+  /// This evaluates computeLogPDF() on every column of `xs` at once, reusing
+  /// the cached Cholesky factor for a single triangular solve.
+  Eigen::VectorXs computeLogPDFBatch(
+      const Eigen::MatrixXs& xs, bool normalized = true);
+
+  /// This evaluates computeLogPDFGrad() on every column of `xs` at once,
+  /// returning the gradients as columns.
+  Eigen::MatrixXs computeLogPDFGradBatch(const Eigen::MatrixXs& xs);
+
   Eigen::VectorXs finiteDifferenceLogPDFGrad(Eigen::VectorXs x);
 
   std::vector<std::string> getVariableNames();
@@ -66,6 +75,8 @@ protected:
   Eigen::VectorXs mMu;
   Eigen::MatrixXs mCov;
   Eigen::LLT<Eigen::MatrixXs> mCovInv;
+  // This is the inverse of mCov, so gradients are a single mat-vec
+  Eigen::MatrixXs mPrecision;
   s_t mNormalizationConstant;
   s_t mLogNormalizationConstant;
 };
@@ -0,0 +1,193 @@
+#include "dart/math/PackedCustomFunctions.hpp"
+
+#include "dart/math/ConstantFunction.hpp"
+#include "dart/math/LinearFunction.hpp"
+#include "dart/math/PolynomialFunction.hpp"
+#include "dart/math/SimmSpline.hpp"
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+PackedCustomFunctions::PackedCustomFunctions()
+{
+}
+
+//==============================================================================
+/// This replaces the packed functions with a copy of `functions`
+void PackedCustomFunctions::pack(
+    const std::vector<std::shared_ptr<CustomFunction>>& functions)
+{
+  mFunctions.clear();
+  mCoefficients.clear();
+  mLastSegment.clear();
+  mFunctions.reserve(functions.size());
+  mLastSegment.resize(functions.size(), 0);
+
+  for (const std::shared_ptr<CustomFunction>& fn : functions)
+  {
+    PackedFunction packed;
+    packed.offset = mCoefficients.size();
+
+    if (auto spline = std::dynamic_pointer_cast<SimmSpline>(fn))
+    {
+      packed.type = SPLINE;
+      packed.size = spline->getNumberOfPoints();
+      const std::vector<s_t>& x = spline->getX();
+      const std::vector<s_t>& y = spline->getY();
+      const std::vector<s_t>& b = spline->getB();
+      const std::vector<s_t>& c = spline->getC();
+      const std::vector<s_t>& d = spline->getD();
+      mCoefficients.insert(mCoefficients.end(), x.begin(), x.end());
+      for (int k = 0; k < packed.size; k++)
+      {
+        mCoefficients.push_back(y[k]);
+        mCoefficients.push_back(b[k]);
+        mCoefficients.push_back(c[k]);
+        mCoefficients.push_back(d[k]);
+      }
+    }
+    else if (auto poly = std::dynamic_pointer_cast<PolynomialFunction>(fn))
+    {
+      packed.type = POLYNOMIAL;
+      packed.size = poly->mCoeffs.size();
+      mCoefficients.insert(
+          mCoefficients.end(), poly->mCoeffs.begin(), poly->mCoeffs.end());
+    }
+    else if (auto linear = std::dynamic_pointer_cast<LinearFunction>(fn))
+    {
+      packed.type = POLYNOMIAL;
+      packed.size = 2;
+      mCoefficients.push_back(linear->mYIntercept);
+      mCoefficients.push_back(linear->mSlope);
+    }
+    else if (auto constant = std::dynamic_pointer_cast<ConstantFunction>(fn))
+    {
+      packed.type = POLYNOMIAL;
+      packed.size = 1;
+      mCoefficients.push_back(constant->mValue);
+    }
+    else
+    {
+      packed.type = GENERIC;
+      packed.size = 0;
+      packed.function = fn;
+    }
+
+    mFunctions.push_back(packed);
+  }
+}
+
+//==============================================================================
+/// This returns the number of packed functions
+int PackedCustomFunctions::size() const
+{
+  return mFunctions.size();
+}
+
+//==============================================================================
+/// This evaluates function i at x, returning [value, first derivative,
+/// second derivative, third derivative]
+Eigen::Vector4s PackedCustomFunctions::evaluate(int i, s_t x) const
+{
+  const PackedFunction& fn = mFunctions[i];
+  Eigen::Vector4s result;
+
+  if (fn.type == SPLINE)
+  {
+    const s_t* knots = mCoefficients.data() + fn.offset;
+    int k = findSplineSegment(i, knots, fn.size, x);
+    const s_t* coeffs = knots + fn.size + 4 * k;
+    s_t y = coeffs[0];
+    s_t b = coeffs[1];
+    s_t c = coeffs[2];
+    s_t d = coeffs[3];
+    s_t dx = x - knots[k];
+    result(0) = y + dx * (b + dx * (c + dx * d));
+    result(1) = b + dx * (2.0 * c + 3.0 * dx * d);
+    result(2) = 2.0 * c + 6.0 * dx * d;
+    result(3) = 6.0 * d;
+  }
+  else if (fn.type == POLYNOMIAL)
+  {
+    // Horner's method, carrying the first three derivatives along
+    const s_t* coeffs = mCoefficients.data() + fn.offset;
+    s_t p = 0.0;
+    s_t dp = 0.0;
+    s_t ddp = 0.0;
+    s_t dddp = 0.0;
+    for (int j = fn.size - 1; j >= 0; j--)
+    {
+      dddp = dddp * x + ddp;
+      ddp = ddp * x + dp;
+      dp = dp * x + p;
+      p = p * x + coeffs[j];
+    }
+    result(0) = p;
+    result(1) = dp;
+    result(2) = 2.0 * ddp;
+    result(3) = 6.0 * dddp;
+  }
+  else
+  {
+    result(0) = fn.function->calcValue(x);
+    result(1) = fn.function->calcDerivative(1, x);
+    result(2) = fn.function->calcDerivative(2, x);
+    result(3) = fn.function->calcDerivative(3, x);
+  }
+
+  return result;
+}
+
+//==============================================================================
+/// This finds the spline segment that `x` falls in, using (and updating) the
+/// interval cache for function i
+int PackedCustomFunctions::findSplineSegment(
+    int i, const s_t* knots, int n, s_t x) const
+{
+  // This mirrors the segment selection in SimmSpline::calcValue()
+  if (n < 3)
+  {
+    return 0;
+  }
+  if (EQUAL_WITHIN_ERROR(x, knots[0]) || x < knots[0])
+  {
+    return 0;
+  }
+  if (EQUAL_WITHIN_ERROR(x, knots[n - 1]) || x > knots[n - 1])
+  {
+    return n - 1;
+  }
+
+  // Check the last segment we used, and its neighbors
+  int last = mLastSegment[i];
+  const int candidates[3] = {last, last + 1, last - 1};
+  for (int k : candidates)
+  {
+    if (k >= 0 && k < n - 1 && knots[k] <= x && x <= knots[k + 1])
+    {
+      mLastSegment[i] = k;
+      return k;
+    }
+  }
+
+  // Fall back to a binary search
+  int lo = 0;
+  int hi = n;
+  int k;
+  while (true)
+  {
+    k = (lo + hi) / 2;
+    if (x < knots[k])
+      hi = k;
+    else if (x > knots[k + 1])
+      lo = k;
+    else
+      break;
+  }
+  mLastSegment[i] = k;
+  return k;
+}
+
+} // namespace math
+} // namespace dart
@@ -0,0 +1,81 @@
+#ifndef MATH_PACKED_CUSTOM_FUNCTIONS_H_
+#define MATH_PACKED_CUSTOM_FUNCTIONS_H_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/CustomFunction.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This packs the coefficients of a list of CustomFunctions (as used by a
+/// CustomJoint) into a single contiguous array, so that they can be evaluated
+/// without virtual calls. Each evaluation returns the value and the first three
+/// derivatives together. SimmSpline, PolynomialFunction, LinearFunction and
+/// ConstantFunction are packed. Any other CustomFunction is evaluated through
+/// its virtual interface.
+///
+/// For splines, this remembers the last knot interval used by each function,
+/// and checks it (and its neighbors) before falling back to a binary search.
+/// Consecutive timesteps almost always land in the same interval.
+///
+/// The packed copy doesn't see later edits to the source functions, so call
+/// pack() again after mutating one.
+class PackedCustomFunctions
+{
+public:
+  PackedCustomFunctions();
+
+  /// This replaces the packed functions with a copy of `functions`
+  void pack(const std::vector<std::shared_ptr<CustomFunction>>& functions);
+
+  /// This returns the number of packed functions
+  int size() const;
+
+  /// This evaluates function i at x, returning [value, first derivative,
+  /// second derivative, third derivative]
+  Eigen::Vector4s evaluate(int i, s_t x) const;
+
+protected:
+  enum FunctionType
+  {
+    POLYNOMIAL,
+    SPLINE,
+    GENERIC
+  };
+
+  struct PackedFunction
+  {
+    FunctionType type;
+    // The offset into mCoefficients where this function's data starts
+    int offset;
+    // For POLYNOMIAL this is the number of coefficients, for SPLINE this is
+    // the number of knots
+    int size;
+    // This is only used for GENERIC functions
+    std::shared_ptr<CustomFunction> function;
+  };
+
+  /// This finds the spline segment that `x` falls in, using (and updating) the
+  /// interval cache for function i
+  int findSplineSegment(int i, const s_t* knots, int n, s_t x) const;
+
+  std::vector<PackedFunction> mFunctions;
+
+  /// For POLYNOMIAL functions, this holds the coefficients in ascending order.
+  /// For SPLINE functions with n knots, this holds the n knot positions,
+  /// followed by [y, b, c, d] for each knot.
+  std::vector<s_t> mCoefficients;
+
+  /// The last spline segment used by each function
+  mutable std::vector<int> mLastSegment;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
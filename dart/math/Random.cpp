@@ -32,12 +32,18 @@
 
 #include "dart/math/Random.hpp"
 
+#include "dart/common/ThreadPool.hpp"
+
 namespace dart {
 namespace math {
 
 //==============================================================================
 Random::GeneratorType& Random::getGenerator()
 {
+  // Tasks share the generator below, so in deterministic mode each task draws
+  // from its own instead
+  if (GeneratorType* taskGenerator = common::ThreadPool::getTaskGenerator())
+    return *taskGenerator;
   static GeneratorType randGenerator(getSeed());
   return randGenerator;
 }
@@ -48,6 +54,7 @@ void Random::setSeed(unsigned int seed)
   std::seed_seq seq{seed};
   getSeedMutable() = seed;
   getGenerator().seed(seq);
+  common::ThreadPool::setTaskSeed(seed);
 }
 
 //==============================================================================
@@ -58,14 +58,17 @@ public:
   template <typename FloatType>
   using NormalRealDist = std::normal_distribution<FloatType>;
 
-  /// Returns a mutable reference to the random generator
+  /// Returns a mutable reference to the random generator. Inside a task on a
+  /// ThreadPool in deterministic mode, this is the task's own generator (see
+  /// common::ThreadPool::setDeterministic()).
   static GeneratorType& getGenerator();
 
   /// Sets the seed value.
   ///
   /// The same seed gives the same sequence of random values so that you can
   /// regenerate the same sequencial random values as long as you knot the seed
-  /// value.
+  /// value. This also re-seeds the tasks that the calling thread submits to a
+  /// ThreadPool in deterministic mode.
   static void setSeed(unsigned int seed);
 
   /// Generates a seed value using the default random device.
@@ -0,0 +1,178 @@
+#include "dart/math/RayBvh.hpp"
+
+#include <algorithm>
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+RayBvh::RayBvh(
+    const std::vector<Eigen::Vector3s>& mins,
+    const std::vector<Eigen::Vector3s>& maxs)
+{
+  mBoxes.resize(mins.size());
+  for (int i = 0; i < mBoxes.size(); i++)
+  {
+    mBoxes[i] = i;
+  }
+  if (!mBoxes.empty())
+  {
+    mNodes.reserve(2 * (mBoxes.size() / LEAF_SIZE + 1));
+    build(0, mBoxes.size(), mins, maxs);
+  }
+}
+
+//==============================================================================
+void RayBvh::raycast(
+    const Eigen::Vector3s& origin,
+    const Eigen::Vector3s& dir,
+    s_t maxT,
+    const std::function<s_t(int, s_t)>& visit) const
+{
+  if (mNodes.empty())
+    return;
+
+  const Eigen::Vector3s invDir = dir.cwiseInverse();
+  s_t tEnter;
+  if (!intersectBox(
+          origin, invDir, mNodes[0].min, mNodes[0].max, maxT, tEnter))
+    return;
+
+  // Each stack entry carries the t where the ray enters that node, so that
+  // nodes behind an earlier hit get skipped when they're popped
+  std::vector<std::pair<int, s_t>> stack;
+  stack.emplace_back(0, tEnter);
+  while (!stack.empty())
+  {
+    std::pair<int, s_t> top = stack.back();
+    stack.pop_back();
+    if (top.second > maxT)
+      continue;
+
+    const Node& node = mNodes[top.first];
+    if (node.left == -1)
+    {
+      for (int i = node.begin; i < node.end; i++)
+      {
+        maxT = visit(mBoxes[i], maxT);
+      }
+      continue;
+    }
+
+    s_t tLeft;
+    s_t tRight;
+    const Node& left = mNodes[node.left];
+    const Node& right = mNodes[node.right];
+    bool hitLeft
+        = intersectBox(origin, invDir, left.min, left.max, maxT, tLeft);
+    bool hitRight
+        = intersectBox(origin, invDir, right.min, right.max, maxT, tRight);
+    // Push the further child first, so the nearer one is visited first
+    if (hitLeft && hitRight)
+    {
+      if (tLeft < tRight)
+      {
+        stack.emplace_back(node.right, tRight);
+        stack.emplace_back(node.left, tLeft);
+      }
+      else
+      {
+        stack.emplace_back(node.left, tLeft);
+        stack.emplace_back(node.right, tRight);
+      }
+    }
+    else if (hitLeft)
+    {
+      stack.emplace_back(node.left, tLeft);
+    }
+    else if (hitRight)
+    {
+      stack.emplace_back(node.right, tRight);
+    }
+  }
+}
+
+//==============================================================================
+int RayBvh::getNumBoxes() const
+{
+  return mBoxes.size();
+}
+
+//==============================================================================
+bool RayBvh::intersectBox(
+    const Eigen::Vector3s& origin,
+    const Eigen::Vector3s& invDir,
+    const Eigen::Vector3s& min,
+    const Eigen::Vector3s& max,
+    s_t maxT,
+    s_t& tEnter)
+{
+  s_t tMin = 0.0;
+  s_t tMax = maxT;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    s_t t0 = (min(axis) - origin(axis)) * invDir(axis);
+    s_t t1 = (max(axis) - origin(axis)) * invDir(axis);
+    // A ray parallel to this slab gives (+/-inf, +/-inf) if it's outside the
+    // slab, or NaN if it starts exactly on a face. Treat NaN as "inside".
+    if (t0 > t1)
+      std::swap(t0, t1);
+    if (t0 > tMin)
+      tMin = t0;
+    if (t1 < tMax)
+      tMax = t1;
+    if (tMin > tMax)
+      return false;
+  }
+  tEnter = tMin;
+  return true;
+}
+
+//==============================================================================
+int RayBvh::build(
+    int begin,
+    int end,
+    const std::vector<Eigen::Vector3s>& mins,
+    const std::vector<Eigen::Vector3s>& maxs)
+{
+  Eigen::Vector3s min = mins[mBoxes[begin]];
+  Eigen::Vector3s max = maxs[mBoxes[begin]];
+  Eigen::Vector3s centerMin = min + max;
+  Eigen::Vector3s centerMax = centerMin;
+  for (int i = begin + 1; i < end; i++)
+  {
+    min = min.cwiseMin(mins[mBoxes[i]]);
+    max = max.cwiseMax(maxs[mBoxes[i]]);
+    // These are twice the centers, which is fine for picking a split
+    Eigen::Vector3s center = mins[mBoxes[i]] + maxs[mBoxes[i]];
+    centerMin = centerMin.cwiseMin(center);
+    centerMax = centerMax.cwiseMax(center);
+  }
+
+  int index = mNodes.size();
+  mNodes.push_back(Node{min, max, -1, -1, begin, end});
+  if (end - begin <= LEAF_SIZE)
+    return index;
+
+  // Split at the median center along the axis where the centers spread most
+  int axis = 0;
+  (centerMax - centerMin).maxCoeff(&axis);
+  int mid = begin + (end - begin) / 2;
+  std::nth_element(
+      mBoxes.begin() + begin,
+      mBoxes.begin() + mid,
+      mBoxes.begin() + end,
+      [&](int a, int b) {
+        return mins[a](axis) + maxs[a](axis) < mins[b](axis) + maxs[b](axis);
+      });
+
+  // build() grows mNodes, so don't hold a reference across it
+  int left = build(begin, mid, mins, maxs);
+  int right = build(mid, end, mins, maxs);
+  mNodes[index].left = left;
+  mNodes[index].right = right;
+  return index;
+}
+
+} // namespace math
+} // namespace dart
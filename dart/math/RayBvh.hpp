@@ -0,0 +1,85 @@
+#ifndef DART_MATH_RAY_BVH_HPP_
+#define DART_MATH_RAY_BVH_HPP_
+
+#include <functional>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a static bounding volume hierarchy over a set of axis-aligned
+/// boxes, for casting rays against whatever the boxes bound (collision
+/// objects, or the triangles of a mesh). Rays are segments
+/// `origin + t * dir` for t in [0, maxT], and the traversal visits nearer
+/// subtrees first and shrinks maxT as hits come in, so closest-hit queries
+/// only open the few leaves along the front of the ray.
+class RayBvh
+{
+public:
+  /// Leaves hold at most this many boxes, which get tested one by one
+  static constexpr int LEAF_SIZE = 4;
+
+  /// This builds the tree over the boxes [mins[i], maxs[i]]. Every box must be
+  /// finite.
+  RayBvh(
+      const std::vector<Eigen::Vector3s>& mins,
+      const std::vector<Eigen::Vector3s>& maxs);
+
+  /// This calls `visit(i, maxT)` on every box i the ray passes through before
+  /// maxT. `visit` returns the maxT to keep searching within, which lets a
+  /// closest-hit query return its best t so far and prune everything behind
+  /// it.
+  void raycast(
+      const Eigen::Vector3s& origin,
+      const Eigen::Vector3s& dir,
+      s_t maxT,
+      const std::function<s_t(int, s_t)>& visit) const;
+
+  /// This returns the number of boxes in the tree
+  int getNumBoxes() const;
+
+  /// This is the slab test: it returns true if the ray passes through the box
+  /// [min, max] somewhere in [0, maxT], and sets `tEnter` to where it enters
+  /// (or 0 if the origin is inside). `invDir` is the componentwise inverse of
+  /// the ray direction, which may contain infinities.
+  static bool intersectBox(
+      const Eigen::Vector3s& origin,
+      const Eigen::Vector3s& invDir,
+      const Eigen::Vector3s& min,
+      const Eigen::Vector3s& max,
+      s_t maxT,
+      s_t& tEnter);
+
+protected:
+  struct Node
+  {
+    Eigen::Vector3s min;
+    Eigen::Vector3s max;
+    /// Child indices into mNodes, or -1 for a leaf
+    int left;
+    int right;
+    /// The range of mBoxes under a leaf
+    int begin;
+    int end;
+  };
+
+  /// This builds the subtree over mBoxes[begin, end), and returns its index
+  int build(
+      int begin,
+      int end,
+      const std::vector<Eigen::Vector3s>& mins,
+      const std::vector<Eigen::Vector3s>& maxs);
+
+  /// Box indices, reordered so every leaf covers a contiguous range
+  std::vector<int> mBoxes;
+  std::vector<Node> mNodes;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -98,6 +98,21 @@ const std::vector<s_t>& SimmSpline::getY() const
   return (_y);
 }
 
+const std::vector<s_t>& SimmSpline::getB() const
+{
+  return (_b);
+}
+
+const std::vector<s_t>& SimmSpline::getC() const
+{
+  return (_c);
+}
+
+const std::vector<s_t>& SimmSpline::getD() const
+{
+  return (_d);
+}
+
 int SimmSpline::getNumberOfPoints() const
 {
   return _x.size();
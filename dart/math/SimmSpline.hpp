@@ -100,6 +100,11 @@ public:
   int getSize() const;
   const std::vector<s_t>& getX() const;
   const std::vector<s_t>& getY() const;
+  /** The per-knot spline coefficients, such that on the segment starting at
+  knot k the spline is y[k] + dx * (b[k] + dx * (c[k] + dx * d[k])). */
+  const std::vector<s_t>& getB() const;
+  const std::vector<s_t>& getC() const;
+  const std::vector<s_t>& getD() const;
   int getNumberOfPoints() const;
   s_t getX(int aIndex) const;
   s_t getY(int aIndex) const;
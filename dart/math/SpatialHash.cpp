@@ -0,0 +1,132 @@
+#include "dart/math/SpatialHash.hpp"
+
+#include <cmath>
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+SpatialHash::SpatialHash(s_t cellSize) : mCellSize(cellSize), mNumPoints(0)
+{
+}
+
+//==============================================================================
+void SpatialHash::clear()
+{
+  // Dropping the whole map would free every bucket. Instead, empty them, and
+  // only sweep out the unused ones once they pile up.
+  if (mCells.size() > 4 * mNumPoints + 64)
+  {
+    mCells.clear();
+  }
+  else
+  {
+    for (auto& cell : mCells)
+    {
+      cell.second.clear();
+    }
+  }
+  mNumPoints = 0;
+}
+
+//==============================================================================
+void SpatialHash::insert(const Eigen::Vector3s& point, int index)
+{
+  // NaN positions are never within any distance of anything
+  if (!point.allFinite())
+    return;
+  mCells[getCell(point)].push_back(index);
+  mNumPoints++;
+}
+
+//==============================================================================
+/// This fills `out` with every index whose point could be within
+/// `cellSize` of `point`, and possibly a few more distant ones
+void SpatialHash::findNeighbors(
+    const Eigen::Vector3s& point, std::vector<int>& out) const
+{
+  out.clear();
+  if (!point.allFinite())
+    return;
+  appendCells(getCell(point), 1, out);
+}
+
+//==============================================================================
+/// This fills `out` with every index whose point could be within `radius`
+/// of `point`, and possibly a few more distant ones. If the radius covers
+/// more cells than we have filled, this just returns every point.
+void SpatialHash::findNeighborsWithin(
+    const Eigen::Vector3s& point, s_t radius, std::vector<int>& out) const
+{
+  out.clear();
+  if (!point.allFinite() || !(radius >= 0))
+    return;
+
+  // Work out the number of rings in floating point first, so huge (or
+  // infinite) radii can't overflow
+  s_t rings = std::max<s_t>(1, std::ceil(radius / mCellSize));
+  s_t side = 2 * rings + 1;
+  if (side * side * side > (s_t)mCells.size())
+  {
+    for (auto& cell : mCells)
+    {
+      out.insert(out.end(), cell.second.begin(), cell.second.end());
+    }
+    return;
+  }
+  appendCells(getCell(point), (long)rings, out);
+}
+
+//==============================================================================
+/// This returns the number of points inserted since the last clear()
+std::size_t SpatialHash::size() const
+{
+  return mNumPoints;
+}
+
+//==============================================================================
+bool SpatialHash::Cell::operator==(const Cell& other) const
+{
+  return x == other.x && y == other.y && z == other.z;
+}
+
+//==============================================================================
+std::size_t SpatialHash::CellHash::operator()(const Cell& cell) const
+{
+  std::size_t hash = std::hash<long>()(cell.x);
+  hash = hash * 31 + std::hash<long>()(cell.y);
+  hash = hash * 31 + std::hash<long>()(cell.z);
+  return hash;
+}
+
+//==============================================================================
+SpatialHash::Cell SpatialHash::getCell(const Eigen::Vector3s& point) const
+{
+  return Cell{(long)std::floor(point(0) / mCellSize),
+              (long)std::floor(point(1) / mCellSize),
+              (long)std::floor(point(2) / mCellSize)};
+}
+
+//==============================================================================
+/// This appends every index in the cells within `rings` of `center`
+void SpatialHash::appendCells(
+    const Cell& center, long rings, std::vector<int>& out) const
+{
+  for (long x = center.x - rings; x <= center.x + rings; x++)
+  {
+    for (long y = center.y - rings; y <= center.y + rings; y++)
+    {
+      for (long z = center.z - rings; z <= center.z + rings; z++)
+      {
+        auto cell = mCells.find(Cell{x, y, z});
+        if (cell != mCells.end())
+        {
+          out.insert(out.end(), cell->second.begin(), cell->second.end());
+        }
+      }
+    }
+  }
+}
+
+} // namespace math
+} // namespace dart
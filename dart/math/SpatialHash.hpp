@@ -0,0 +1,69 @@
+#ifndef MATH_SPATIAL_HASH_H_
+#define MATH_SPATIAL_HASH_H_
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This buckets points on a uniform grid, so that every point within
+/// `cellSize` of a query can be found by only looking at the 27 cells around
+/// it. Buckets keep their storage across clear() calls, since callers tend to
+/// rebuild this every frame with mostly the same cells.
+class SpatialHash
+{
+public:
+  SpatialHash(s_t cellSize);
+
+  void clear();
+
+  void insert(const Eigen::Vector3s& point, int index);
+
+  /// This fills `out` with every index whose point could be within
+  /// `cellSize` of `point`, and possibly a few more distant ones
+  void findNeighbors(const Eigen::Vector3s& point, std::vector<int>& out) const;
+
+  /// This fills `out` with every index whose point could be within `radius`
+  /// of `point`, and possibly a few more distant ones. If the radius covers
+  /// more cells than we have filled, this just returns every point.
+  void findNeighborsWithin(
+      const Eigen::Vector3s& point, s_t radius, std::vector<int>& out) const;
+
+  /// This returns the number of points inserted since the last clear()
+  std::size_t size() const;
+
+protected:
+  struct Cell
+  {
+    long x;
+    long y;
+    long z;
+
+    bool operator==(const Cell& other) const;
+  };
+
+  struct CellHash
+  {
+    std::size_t operator()(const Cell& cell) const;
+  };
+
+  Cell getCell(const Eigen::Vector3s& point) const;
+
+  /// This appends every index in the cells within `rings` of `center`
+  void appendCells(const Cell& center, long rings, std::vector<int>& out) const;
+
+  s_t mCellSize;
+  std::size_t mNumPoints;
+  std::unordered_map<Cell, std::vector<int>, CellHash> mCells;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,226 @@
+#include "dart/math/SphereTree.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace dart {
+namespace math {
+
+namespace {
+
+/// This returns the squared distance from `point` to the box [min, max]
+s_t squaredDistanceToBox(
+    const Eigen::Vector3s& point,
+    const Eigen::Vector3s& min,
+    const Eigen::Vector3s& max)
+{
+  return (point - point.cwiseMax(min).cwiseMin(max)).squaredNorm();
+}
+
+} // namespace
+
+//==============================================================================
+SphereTree::SphereTree(const std::vector<Eigen::Vector3s>& centers, s_t radius)
+  : SphereTree(centers, std::vector<s_t>(centers.size(), radius))
+{
+}
+
+//==============================================================================
+SphereTree::SphereTree(
+    const std::vector<Eigen::Vector3s>& centers, const std::vector<s_t>& radii)
+  : mCenters(centers), mRadii(radii), mOrder(centers.size())
+{
+  std::iota(mOrder.begin(), mOrder.end(), 0);
+  if (!mCenters.empty())
+  {
+    mNodes.reserve(2 * (mCenters.size() / LEAF_SIZE + 1));
+    build(0, mCenters.size());
+  }
+  // build() only shuffles mOrder, so put the spheres into tree order now
+  for (std::size_t i = 0; i < mOrder.size(); i++)
+  {
+    mCenters[i] = centers[mOrder[i]];
+    mRadii[i] = radii[mOrder[i]];
+  }
+  refit(Eigen::Vector3s::Ones());
+}
+
+//==============================================================================
+/// This recomputes every sphere and bounding sphere for the spheres as they
+/// were passed to the constructor, with their centers multiplied through by
+/// `scale` and their radii multiplied by its largest entry (so they still
+/// cover what they did under a non-uniform scale).
+void SphereTree::refit(const Eigen::Vector3s& scale)
+{
+  mScale = scale;
+  const s_t radiusScale = scale.cwiseAbs().maxCoeff();
+  mScaledCenters.resize(mCenters.size());
+  mScaledRadii.resize(mRadii.size());
+  for (std::size_t i = 0; i < mCenters.size(); i++)
+  {
+    mScaledCenters[i] = scale.cwiseProduct(mCenters[i]);
+    mScaledRadii[i] = mRadii[i] * radiusScale;
+  }
+
+  // Children come after their parents, so walking backwards visits every
+  // child before it's needed
+  for (int n = (int)mNodes.size() - 1; n >= 0; n--)
+  {
+    Node& node = mNodes[n];
+    if (node.left == -1)
+    {
+      Eigen::Vector3s min = mScaledCenters[node.begin];
+      Eigen::Vector3s max = mScaledCenters[node.begin];
+      for (int i = node.begin + 1; i < node.end; i++)
+      {
+        min = min.cwiseMin(mScaledCenters[i]);
+        max = max.cwiseMax(mScaledCenters[i]);
+      }
+      node.center = 0.5 * (min + max);
+      node.radius = 0.0;
+      for (int i = node.begin; i < node.end; i++)
+      {
+        node.radius = std::max(
+            node.radius,
+            (mScaledCenters[i] - node.center).norm() + mScaledRadii[i]);
+      }
+    }
+    else
+    {
+      // The smallest sphere around both children
+      const Node& a = mNodes[node.left];
+      const Node& b = mNodes[node.right];
+      const Eigen::Vector3s offset = b.center - a.center;
+      const s_t dist = offset.norm();
+      if (dist + b.radius <= a.radius)
+      {
+        node.center = a.center;
+        node.radius = a.radius;
+      }
+      else if (dist + a.radius <= b.radius)
+      {
+        node.center = b.center;
+        node.radius = b.radius;
+      }
+      else
+      {
+        node.radius = 0.5 * (dist + a.radius + b.radius);
+        node.center = a.center + offset * ((node.radius - a.radius) / dist);
+      }
+    }
+  }
+}
+
+//==============================================================================
+/// This returns the scale of the last refit(), which starts at one
+const Eigen::Vector3s& SphereTree::getScale() const
+{
+  return mScale;
+}
+
+//==============================================================================
+/// This appends (in tree order) the index of every sphere that overlaps the
+/// box [min, max] to `out`
+void SphereTree::findOverlapping(
+    const Eigen::Vector3s& min,
+    const Eigen::Vector3s& max,
+    std::vector<int>& out) const
+{
+  if (mNodes.empty())
+    return;
+  search(0, min, max, out);
+}
+
+//==============================================================================
+/// This returns the number of spheres
+int SphereTree::getNumSpheres() const
+{
+  return mCenters.size();
+}
+
+//==============================================================================
+/// This returns the (scaled) center of sphere `i`, in tree order
+const Eigen::Vector3s& SphereTree::getCenter(int i) const
+{
+  return mScaledCenters[i];
+}
+
+//==============================================================================
+/// This returns the (scaled) radius of sphere `i`, in tree order
+s_t SphereTree::getRadius(int i) const
+{
+  return mScaledRadii[i];
+}
+
+//==============================================================================
+/// This returns the index that sphere `i` (in tree order) was passed to the
+/// constructor at
+int SphereTree::getOriginalIndex(int i) const
+{
+  return mOrder[i];
+}
+
+//==============================================================================
+int SphereTree::build(int begin, int end)
+{
+  int index = mNodes.size();
+  mNodes.push_back(
+      Node{begin, end, -1, -1, Eigen::Vector3s::Zero(), (s_t)0.0});
+  if (end - begin <= LEAF_SIZE)
+    return index;
+
+  Eigen::Vector3s min = mCenters[mOrder[begin]];
+  Eigen::Vector3s max = mCenters[mOrder[begin]];
+  for (int i = begin + 1; i < end; i++)
+  {
+    min = min.cwiseMin(mCenters[mOrder[i]]);
+    max = max.cwiseMax(mCenters[mOrder[i]]);
+  }
+  int axis = 0;
+  (max - min).maxCoeff(&axis);
+
+  int mid = begin + (end - begin) / 2;
+  std::nth_element(
+      mOrder.begin() + begin,
+      mOrder.begin() + mid,
+      mOrder.begin() + end,
+      [this, axis](int a, int b) {
+        return mCenters[a](axis) < mCenters[b](axis);
+      });
+
+  // build() grows mNodes, so don't hold a reference across the recursion
+  int left = build(begin, mid);
+  int right = build(mid, end);
+  mNodes[index].left = left;
+  mNodes[index].right = right;
+  return index;
+}
+
+//==============================================================================
+void SphereTree::search(
+    int node,
+    const Eigen::Vector3s& min,
+    const Eigen::Vector3s& max,
+    std::vector<int>& out) const
+{
+  const Node& n = mNodes[node];
+  if (squaredDistanceToBox(n.center, min, max) > n.radius * n.radius)
+    return;
+  if (n.left == -1)
+  {
+    for (int i = n.begin; i < n.end; i++)
+    {
+      if (squaredDistanceToBox(mScaledCenters[i], min, max)
+          <= mScaledRadii[i] * mScaledRadii[i])
+      {
+        out.push_back(i);
+      }
+    }
+    return;
+  }
+  search(n.left, min, max, out);
+  search(n.right, min, max, out);
+}
+
+} // namespace math
+} // namespace dart
@@ -0,0 +1,101 @@
+#ifndef DART_MATH_SPHERE_TREE_HPP_
+#define DART_MATH_SPHERE_TREE_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a bounding sphere hierarchy over a set of spheres (usually the
+/// points of a point cloud, each inflated to a small radius), for finding
+/// which of them might touch a box without testing every one. The tree
+/// topology is built once. When the owner is rescaled, refit() just
+/// recomputes the bounding spheres bottom up, which is linear time and
+/// doesn't re-sort anything.
+class SphereTree
+{
+public:
+  /// Leaves hold at most this many spheres, which get scanned linearly
+  static constexpr int LEAF_SIZE = 8;
+
+  /// This builds the tree over spheres at `centers`, all of radius `radius`
+  SphereTree(const std::vector<Eigen::Vector3s>& centers, s_t radius);
+
+  /// This builds the tree over spheres at `centers`, with radii `radii`
+  SphereTree(
+      const std::vector<Eigen::Vector3s>& centers,
+      const std::vector<s_t>& radii);
+
+  /// This recomputes every sphere and bounding sphere for the spheres as
+  /// they were passed to the constructor, with their centers multiplied
+  /// through by `scale` and their radii multiplied by its largest entry (so
+  /// they still cover what they did under a non-uniform scale).
+  void refit(const Eigen::Vector3s& scale);
+
+  /// This returns the scale of the last refit(), which starts at one
+  const Eigen::Vector3s& getScale() const;
+
+  /// This appends (in tree order) the index of every sphere that overlaps
+  /// the box [min, max] to `out`
+  void findOverlapping(
+      const Eigen::Vector3s& min,
+      const Eigen::Vector3s& max,
+      std::vector<int>& out) const;
+
+  /// This returns the number of spheres
+  int getNumSpheres() const;
+
+  /// This returns the (scaled) center of sphere `i`, in tree order
+  const Eigen::Vector3s& getCenter(int i) const;
+
+  /// This returns the (scaled) radius of sphere `i`, in tree order
+  s_t getRadius(int i) const;
+
+  /// This returns the index that sphere `i` (in tree order) was passed to the
+  /// constructor at
+  int getOriginalIndex(int i) const;
+
+protected:
+  struct Node
+  {
+    /// The range of spheres under this node
+    int begin;
+    int end;
+    /// Child indices into mNodes, or -1 for a leaf
+    int left;
+    int right;
+    /// The bounding sphere, at the current scale
+    Eigen::Vector3s center;
+    s_t radius;
+  };
+
+  /// This builds the subtree over spheres [begin, end), and returns its index
+  int build(int begin, int end);
+
+  /// This descends from `node`, appending overlapping spheres to `out`
+  void search(
+      int node,
+      const Eigen::Vector3s& min,
+      const Eigen::Vector3s& max,
+      std::vector<int>& out) const;
+
+  // The spheres as they were passed in, in tree order
+  std::vector<Eigen::Vector3s> mCenters;
+  std::vector<s_t> mRadii;
+  std::vector<int> mOrder;
+  // The spheres at mScale
+  std::vector<Eigen::Vector3s> mScaledCenters;
+  std::vector<s_t> mScaledRadii;
+  Eigen::Vector3s mScale;
+  // Parents always come before their children
+  std::vector<Node> mNodes;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,433 @@
+#include "dart/math/SupportHull.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace dart {
+namespace math {
+
+namespace {
+
+struct HullFace
+{
+  int v[3];
+  Eigen::Vector3s normal;
+  s_t offset;
+  bool alive;
+};
+
+long long edgeKey(int a, int b)
+{
+  return ((long long)a << 32) | (unsigned int)b;
+}
+
+HullFace makeFace(
+    const std::vector<Eigen::Vector3s>& points, int a, int b, int c)
+{
+  HullFace face;
+  face.v[0] = a;
+  face.v[1] = b;
+  face.v[2] = c;
+  face.normal = (points[b] - points[a]).cross(points[c] - points[a]);
+  s_t norm = face.normal.norm();
+  if (norm > 0)
+    face.normal /= norm;
+  // A zero normal means a sliver face, which is never "visible", so it just
+  // gets carried along until a neighbor replaces it.
+  face.offset = face.normal.dot(points[a]);
+  face.alive = true;
+  return face;
+}
+
+s_t faceDistance(const HullFace& face, const Eigen::Vector3s& point)
+{
+  return face.normal.dot(point) - face.offset;
+}
+
+} // namespace
+
+//==============================================================================
+/// This builds the hull of `points`. Degenerate (flat or tiny) inputs fall
+/// back to keeping every distinct point, with no adjacency, and support
+/// queries on them do a linear scan.
+SupportHull::SupportHull(const std::vector<Eigen::Vector3s>& points)
+  : mSphereCenter(Eigen::Vector3s::Zero()),
+    mSphereRadius(0),
+    mBoxMin(Eigen::Vector3s::Zero()),
+    mBoxMax(Eigen::Vector3s::Zero())
+{
+  // Meshes often repeat vertices (once per face), so drop exact duplicates
+  std::vector<Eigen::Vector3s> unique = points;
+  auto lexicographic = [](const Eigen::Vector3s& a, const Eigen::Vector3s& b) {
+    if (a(0) != b(0))
+      return a(0) < b(0);
+    if (a(1) != b(1))
+      return a(1) < b(1);
+    return a(2) < b(2);
+  };
+  std::sort(unique.begin(), unique.end(), lexicographic);
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+  if (unique.empty())
+  {
+    return;
+  }
+
+  mBoxMin = unique[0];
+  mBoxMax = unique[0];
+  for (const Eigen::Vector3s& point : unique)
+  {
+    mBoxMin = mBoxMin.cwiseMin(point);
+    mBoxMax = mBoxMax.cwiseMax(point);
+  }
+  mSphereCenter = (mBoxMin + mBoxMax) / 2;
+  for (const Eigen::Vector3s& point : unique)
+  {
+    mSphereRadius = std::max(mSphereRadius, (point - mSphereCenter).norm());
+  }
+
+  if (!buildHull(unique))
+  {
+    mVertices = unique;
+    mNeighbors.clear();
+  }
+}
+
+//==============================================================================
+/// This tries to run incremental 3D hull construction on `points`, filling
+/// in mVertices and mNeighbors. Returns false on degenerate input.
+bool SupportHull::buildHull(const std::vector<Eigen::Vector3s>& points)
+{
+  int n = points.size();
+  if (n < 4)
+    return false;
+  s_t extent = (mBoxMax - mBoxMin).norm();
+  const s_t eps = extent * 1e-9;
+  if (!(eps > 0))
+    return false;
+
+  // 1. Find a non-degenerate starting tetrahedron
+  int axis = 0;
+  (mBoxMax - mBoxMin).maxCoeff(&axis);
+  int i0 = 0;
+  int i1 = 0;
+  for (int i = 0; i < n; i++)
+  {
+    if (points[i](axis) < points[i0](axis))
+      i0 = i;
+    if (points[i](axis) > points[i1](axis))
+      i1 = i;
+  }
+  Eigen::Vector3s lineDir = (points[i1] - points[i0]).normalized();
+  int i2 = -1;
+  s_t bestLineDist = eps;
+  for (int i = 0; i < n; i++)
+  {
+    s_t dist = (points[i] - points[i0]).cross(lineDir).norm();
+    if (dist > bestLineDist)
+    {
+      bestLineDist = dist;
+      i2 = i;
+    }
+  }
+  if (i2 == -1)
+    return false;
+  Eigen::Vector3s planeNormal
+      = (points[i1] - points[i0]).cross(points[i2] - points[i0]).normalized();
+  int i3 = -1;
+  s_t bestPlaneDist = eps;
+  for (int i = 0; i < n; i++)
+  {
+    s_t dist = std::abs(planeNormal.dot(points[i] - points[i0]));
+    if (dist > bestPlaneDist)
+    {
+      bestPlaneDist = dist;
+      i3 = i;
+    }
+  }
+  if (i3 == -1)
+    return false;
+  if (planeNormal.dot(points[i3] - points[i0]) > 0)
+    std::swap(i1, i2);
+
+  // 2. Grow the hull one point at a time. Faces are wound counter-clockwise
+  // seen from outside, and every directed edge maps to the face on its left.
+  std::vector<HullFace> faces;
+  std::unordered_map<long long, int> edgeToFace;
+  auto addFace = [&](int a, int b, int c) {
+    int index = faces.size();
+    faces.push_back(makeFace(points, a, b, c));
+    for (int k = 0; k < 3; k++)
+    {
+      long long key = edgeKey(faces[index].v[k], faces[index].v[(k + 1) % 3]);
+      if (!edgeToFace.emplace(key, index).second)
+        return false;
+    }
+    return true;
+  };
+  if (!addFace(i0, i1, i2) || !addFace(i0, i3, i1) || !addFace(i1, i3, i2)
+      || !addFace(i2, i3, i0))
+    return false;
+
+  // Every point outside the hull so far is parked on exactly one face that
+  // can see it (quickhull's "conflict lists"), so each step only has to
+  // re-check the points orphaned by the faces it replaces.
+  std::vector<std::vector<int>> outside(faces.size());
+  auto assignPoint = [&](int i, int firstFace) {
+    for (int f = firstFace; f < faces.size(); f++)
+    {
+      if (faces[f].alive && faceDistance(faces[f], points[i]) > eps)
+      {
+        outside[f].push_back(i);
+        return;
+      }
+    }
+    // Otherwise this point is inside the hull, and we can forget about it
+  };
+  for (int i = 0; i < n; i++)
+  {
+    if (i != i0 && i != i1 && i != i2 && i != i3)
+      assignPoint(i, 0);
+  }
+
+  std::vector<int> work = {0, 1, 2, 3};
+  std::vector<int> visitedStamp(faces.size(), -1);
+  std::vector<int> stack;
+  std::vector<int> visible;
+  std::vector<int> orphans;
+  std::vector<std::pair<int, int>> horizon;
+  while (!work.empty())
+  {
+    int seed = work.back();
+    work.pop_back();
+    if (!faces[seed].alive || outside[seed].empty())
+      continue;
+
+    // Adding the furthest point first keeps the faces well shaped
+    int i = outside[seed][0];
+    for (int candidate : outside[seed])
+    {
+      if (faceDistance(faces[seed], points[candidate])
+          > faceDistance(faces[seed], points[i]))
+        i = candidate;
+    }
+    const Eigen::Vector3s& point = points[i];
+
+    // Flood out the connected patch of faces that can see this point. Its
+    // boundary is the horizon we'll fan new faces out from.
+    visible.clear();
+    horizon.clear();
+    stack.clear();
+    stack.push_back(seed);
+    visitedStamp[seed] = i;
+    while (!stack.empty())
+    {
+      int f = stack.back();
+      stack.pop_back();
+      visible.push_back(f);
+      for (int k = 0; k < 3; k++)
+      {
+        int a = faces[f].v[k];
+        int b = faces[f].v[(k + 1) % 3];
+        auto neighbor = edgeToFace.find(edgeKey(b, a));
+        if (neighbor == edgeToFace.end())
+          return false;
+        int g = neighbor->second;
+        if (faceDistance(faces[g], point) > eps)
+        {
+          if (visitedStamp[g] != i)
+          {
+            visitedStamp[g] = i;
+            stack.push_back(g);
+          }
+        }
+        else
+        {
+          horizon.emplace_back(a, b);
+        }
+      }
+    }
+
+    orphans.clear();
+    for (int f : visible)
+    {
+      faces[f].alive = false;
+      for (int k = 0; k < 3; k++)
+      {
+        edgeToFace.erase(edgeKey(faces[f].v[k], faces[f].v[(k + 1) % 3]));
+      }
+      for (int orphan : outside[f])
+      {
+        if (orphan != i)
+          orphans.push_back(orphan);
+      }
+      std::vector<int>().swap(outside[f]);
+    }
+    int firstNewFace = faces.size();
+    for (auto& edge : horizon)
+    {
+      // If the visible patch wasn't a disk (which only happens through
+      // round-off on nearly coplanar input) we'd build a broken mesh, so bail
+      // out and let the caller fall back to a linear scan.
+      if (!addFace(edge.first, edge.second, i))
+        return false;
+    }
+    outside.resize(faces.size());
+    visitedStamp.resize(faces.size(), -1);
+    for (int orphan : orphans)
+    {
+      assignPoint(orphan, firstNewFace);
+    }
+    for (int f = firstNewFace; f < faces.size(); f++)
+    {
+      if (!outside[f].empty())
+        work.push_back(f);
+    }
+  }
+
+  // 3. Compact the surviving vertices, and read adjacency off the edges
+  std::vector<int> remap(n, -1);
+  for (const HullFace& face : faces)
+  {
+    if (!face.alive)
+      continue;
+    for (int k = 0; k < 3; k++)
+    {
+      if (remap[face.v[k]] == -1)
+      {
+        remap[face.v[k]] = mVertices.size();
+        mVertices.push_back(points[face.v[k]]);
+      }
+    }
+  }
+  mNeighbors.resize(mVertices.size());
+  for (const HullFace& face : faces)
+  {
+    if (!face.alive)
+      continue;
+    for (int k = 0; k < 3; k++)
+    {
+      // Each undirected edge shows up once in each direction, so this adds
+      // every neighbor exactly once
+      mNeighbors[remap[face.v[k]]].push_back(remap[face.v[(k + 1) % 3]]);
+    }
+  }
+  return true;
+}
+
+//==============================================================================
+/// This returns the index (into getVertices()) of the vertex furthest along
+/// `dir`. `hint` is where hill climbing starts, so passing the answer from
+/// the last query on a nearby direction makes this nearly O(1).
+int SupportHull::findSupport(const Eigen::Vector3s& dir, int hint) const
+{
+  if (mVertices.empty())
+    return -1;
+
+  if (mNeighbors.empty() || mVertices.size() <= LINEAR_SCAN_VERTICES)
+  {
+    int best = 0;
+    s_t bestDot = dir.dot(mVertices[0]);
+    for (int i = 1; i < mVertices.size(); i++)
+    {
+      s_t dot = dir.dot(mVertices[i]);
+      if (dot > bestDot)
+      {
+        bestDot = dot;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  // On a convex polytope, a vertex with no better neighbor is a global
+  // maximum. Strict improvement at every step guarantees termination.
+  int current = (hint >= 0 && hint < mVertices.size()) ? hint : 0;
+  s_t currentDot = dir.dot(mVertices[current]);
+  while (true)
+  {
+    int next = -1;
+    for (int neighbor : mNeighbors[current])
+    {
+      s_t dot = dir.dot(mVertices[neighbor]);
+      if (dot > currentDot)
+      {
+        currentDot = dot;
+        next = neighbor;
+      }
+    }
+    if (next == -1)
+      return current;
+    current = next;
+  }
+}
+
+//==============================================================================
+/// These are the hull vertices
+const std::vector<Eigen::Vector3s>& SupportHull::getVertices() const
+{
+  return mVertices;
+}
+
+//==============================================================================
+/// This is the list of hull neighbors for each vertex. This is empty if we
+/// fell back to a plain point list.
+const std::vector<std::vector<int>>& SupportHull::getNeighbors() const
+{
+  return mNeighbors;
+}
+
+//==============================================================================
+/// This returns true if we built a real hull with adjacency
+bool SupportHull::hasAdjacency() const
+{
+  return !mNeighbors.empty();
+}
+
+//==============================================================================
+/// This is the center of a sphere that contains every point
+const Eigen::Vector3s& SupportHull::getBoundingSphereCenter() const
+{
+  return mSphereCenter;
+}
+
+//==============================================================================
+/// This is the radius of a sphere that contains every point
+s_t SupportHull::getBoundingSphereRadius() const
+{
+  return mSphereRadius;
+}
+
+//==============================================================================
+/// This is the lower corner of the axis-aligned box around the points
+const Eigen::Vector3s& SupportHull::getBoxMin() const
+{
+  return mBoxMin;
+}
+
+//==============================================================================
+/// This is the upper corner of the axis-aligned box around the points
+const Eigen::Vector3s& SupportHull::getBoxMax() const
+{
+  return mBoxMax;
+}
+
+//==============================================================================
+/// This attaches the surface connectivity of the mesh the points came from, so
+/// that code holding the hull can also walk the mesh surface
+void SupportHull::setMeshAdjacency(
+    std::shared_ptr<const MeshAdjacency> adjacency)
+{
+  mMeshAdjacency = adjacency;
+}
+
+//==============================================================================
+/// This returns the connectivity of the mesh the points came from, or nullptr
+/// if there isn't any
+const MeshAdjacency* SupportHull::getMeshAdjacency() const
+{
+  return mMeshAdjacency.get();
+}
+
+} // namespace math
+} // namespace dart
@@ -0,0 +1,84 @@
+#ifndef DART_MATH_SUPPORT_HULL_HPP_
+#define DART_MATH_SUPPORT_HULL_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+#include "dart/math/MeshAdjacency.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a precomputed 3D convex hull of a point cloud, laid out for fast
+/// support-point queries (the furthest point along a direction), which is the
+/// inner loop of GJK / MPR. The hull vertices carry an adjacency table, so a
+/// query can hill-climb from the previous answer instead of scanning every
+/// point. This also keeps a bounding sphere and an axis-aligned box of the
+/// points, for cheap early-outs before running GJK at all.
+class SupportHull
+{
+public:
+  /// Below this many hull vertices, a linear scan beats hill climbing
+  static constexpr int LINEAR_SCAN_VERTICES = 32;
+
+  /// This builds the hull of `points`. Degenerate (flat or tiny) inputs fall
+  /// back to keeping every distinct point, with no adjacency, and support
+  /// queries on them do a linear scan.
+  SupportHull(const std::vector<Eigen::Vector3s>& points);
+
+  /// This returns the index (into getVertices()) of the vertex furthest along
+  /// `dir`. `hint` is where hill climbing starts, so passing the answer from
+  /// the last query on a nearby direction makes this nearly O(1).
+  int findSupport(const Eigen::Vector3s& dir, int hint = 0) const;
+
+  /// These are the hull vertices
+  const std::vector<Eigen::Vector3s>& getVertices() const;
+
+  /// This is the list of hull neighbors for each vertex. This is empty if we
+  /// fell back to a plain point list.
+  const std::vector<std::vector<int>>& getNeighbors() const;
+
+  /// This returns true if we built a real hull with adjacency
+  bool hasAdjacency() const;
+
+  /// This is the center of a sphere that contains every point
+  const Eigen::Vector3s& getBoundingSphereCenter() const;
+
+  /// This is the radius of a sphere that contains every point
+  s_t getBoundingSphereRadius() const;
+
+  /// This is the lower corner of the axis-aligned box around the points
+  const Eigen::Vector3s& getBoxMin() const;
+
+  /// This is the upper corner of the axis-aligned box around the points
+  const Eigen::Vector3s& getBoxMax() const;
+
+  /// This attaches the surface connectivity of the mesh the points came from,
+  /// so that code holding the hull can also walk the mesh surface
+  void setMeshAdjacency(std::shared_ptr<const MeshAdjacency> adjacency);
+
+  /// This returns the connectivity of the mesh the points came from, or
+  /// nullptr if there isn't any
+  const MeshAdjacency* getMeshAdjacency() const;
+
+protected:
+  /// This tries to run incremental 3D hull construction on `points`, filling
+  /// in mVertices and mNeighbors. Returns false on degenerate input.
+  bool buildHull(const std::vector<Eigen::Vector3s>& points);
+
+  std::vector<Eigen::Vector3s> mVertices;
+  std::vector<std::vector<int>> mNeighbors;
+  Eigen::Vector3s mSphereCenter;
+  s_t mSphereRadius;
+  Eigen::Vector3s mBoxMin;
+  Eigen::Vector3s mBoxMax;
+  std::shared_ptr<const MeshAdjacency> mMeshAdjacency;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,93 @@
+#include "dart/math/TriangleBvh.hpp"
+
+#include <cmath>
+
+namespace dart {
+namespace math {
+
+namespace {
+
+RayBvh buildTriangleBoxes(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3i>& triangles)
+{
+  std::vector<Eigen::Vector3s> mins(triangles.size());
+  std::vector<Eigen::Vector3s> maxs(triangles.size());
+  for (int i = 0; i < triangles.size(); i++)
+  {
+    const Eigen::Vector3s& a = vertices[triangles[i](0)];
+    const Eigen::Vector3s& b = vertices[triangles[i](1)];
+    const Eigen::Vector3s& c = vertices[triangles[i](2)];
+    mins[i] = a.cwiseMin(b).cwiseMin(c);
+    maxs[i] = a.cwiseMax(b).cwiseMax(c);
+  }
+  return RayBvh(mins, maxs);
+}
+
+} // namespace
+
+//==============================================================================
+TriangleBvh::TriangleBvh(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3i>& triangles)
+  : mVertices(vertices),
+    mTriangles(triangles),
+    mBvh(buildTriangleBoxes(vertices, triangles))
+{
+}
+
+//==============================================================================
+bool TriangleBvh::raycast(
+    const Eigen::Vector3s& origin,
+    const Eigen::Vector3s& dir,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal) const
+{
+  int hitTriangle = -1;
+  mBvh.raycast(origin, dir, maxT, [&](int i, s_t bestT) -> s_t {
+    // Moller-Trumbore, accepting either winding
+    const Eigen::Vector3s& a = mVertices[mTriangles[i](0)];
+    const Eigen::Vector3s edge1 = mVertices[mTriangles[i](1)] - a;
+    const Eigen::Vector3s edge2 = mVertices[mTriangles[i](2)] - a;
+    const Eigen::Vector3s p = dir.cross(edge2);
+    const s_t det = edge1.dot(p);
+    if (std::abs(det) < 1e-14)
+      return bestT;
+    const s_t invDet = 1.0 / det;
+    const Eigen::Vector3s s = origin - a;
+    const s_t u = s.dot(p) * invDet;
+    if (u < 0 || u > 1)
+      return bestT;
+    const Eigen::Vector3s q = s.cross(edge1);
+    const s_t v = dir.dot(q) * invDet;
+    if (v < 0 || u + v > 1)
+      return bestT;
+    const s_t hitT = edge2.dot(q) * invDet;
+    if (hitT < 0 || hitT > bestT)
+      return bestT;
+    hitTriangle = i;
+    t = hitT;
+    return hitT;
+  });
+
+  if (hitTriangle == -1)
+    return false;
+
+  const Eigen::Vector3s& a = mVertices[mTriangles[hitTriangle](0)];
+  const Eigen::Vector3s& b = mVertices[mTriangles[hitTriangle](1)];
+  const Eigen::Vector3s& c = mVertices[mTriangles[hitTriangle](2)];
+  normal = (b - a).cross(c - a).normalized();
+  if (normal.dot(dir) > 0)
+    normal = -normal;
+  return true;
+}
+
+//==============================================================================
+int TriangleBvh::getNumTriangles() const
+{
+  return mTriangles.size();
+}
+
+} // namespace math
+} // namespace dart
@@ -0,0 +1,49 @@
+#ifndef DART_MATH_TRIANGLE_BVH_HPP_
+#define DART_MATH_TRIANGLE_BVH_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+#include "dart/math/RayBvh.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a triangle soup (usually a mesh) with a RayBvh over its triangles,
+/// for finding where rays first hit the surface without testing every
+/// triangle.
+class TriangleBvh
+{
+public:
+  /// This builds the tree. Each entry of `triangles` holds three indices into
+  /// `vertices`.
+  TriangleBvh(
+      const std::vector<Eigen::Vector3s>& vertices,
+      const std::vector<Eigen::Vector3i>& triangles);
+
+  /// This finds the first triangle the segment `origin + t * dir`, for t in
+  /// [0, maxT], crosses. Triangles are double sided. On a hit, this returns
+  /// true and sets `t` and the unit `normal` of the triangle, flipped to face
+  /// back along the ray.
+  bool raycast(
+      const Eigen::Vector3s& origin,
+      const Eigen::Vector3s& dir,
+      s_t maxT,
+      s_t& t,
+      Eigen::Vector3s& normal) const;
+
+  /// This returns the number of triangles
+  int getNumTriangles() const;
+
+protected:
+  std::vector<Eigen::Vector3s> mVertices;
+  std::vector<Eigen::Vector3i> mTriangles;
+  RayBvh mBvh;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,117 @@
+#include "dart/math/VertexKdTree.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+VertexKdTree::VertexKdTree(const std::vector<Eigen::Vector3s>& points)
+  : mVertices(points)
+{
+  if (!mVertices.empty())
+  {
+    mNodes.reserve(2 * (mVertices.size() / LEAF_SIZE + 1));
+    build(0, mVertices.size());
+  }
+}
+
+//==============================================================================
+int VertexKdTree::findNearest(
+    const Eigen::Vector3s& point, const Eigen::Vector3s& scale) const
+{
+  if (mNodes.empty())
+    return -1;
+
+  // |scale .* v - point|^2 == sum_i scale_i^2 (v_i - point_i / scale_i)^2, so
+  // we can search the unscaled tree with a weighted metric
+  Eigen::Vector3s query = point.cwiseQuotient(scale);
+  Eigen::Vector3s weights = scale.cwiseProduct(scale);
+
+  int best = -1;
+  s_t bestDist = std::numeric_limits<s_t>::infinity();
+  search(0, query, weights, best, bestDist);
+  return best;
+}
+
+//==============================================================================
+const std::vector<Eigen::Vector3s>& VertexKdTree::getVertices() const
+{
+  return mVertices;
+}
+
+//==============================================================================
+int VertexKdTree::build(int begin, int end)
+{
+  int index = mNodes.size();
+  mNodes.push_back(Node{begin, end, 0, 0.0, -1, -1});
+  if (end - begin <= LEAF_SIZE)
+    return index;
+
+  Eigen::Vector3s min = mVertices[begin];
+  Eigen::Vector3s max = mVertices[begin];
+  for (int i = begin + 1; i < end; i++)
+  {
+    min = min.cwiseMin(mVertices[i]);
+    max = max.cwiseMax(mVertices[i]);
+  }
+  int axis = 0;
+  (max - min).maxCoeff(&axis);
+
+  int mid = begin + (end - begin) / 2;
+  std::nth_element(
+      mVertices.begin() + begin,
+      mVertices.begin() + mid,
+      mVertices.begin() + end,
+      [axis](const Eigen::Vector3s& a, const Eigen::Vector3s& b) {
+        return a(axis) < b(axis);
+      });
+
+  // Careful: the children reorder their ranges, and build() grows mNodes, so
+  // read the split and don't hold a reference across the recursion
+  mNodes[index].axis = axis;
+  mNodes[index].split = mVertices[mid](axis);
+  int left = build(begin, mid);
+  int right = build(mid, end);
+  mNodes[index].left = left;
+  mNodes[index].right = right;
+  return index;
+}
+
+//==============================================================================
+void VertexKdTree::search(
+    int node,
+    const Eigen::Vector3s& query,
+    const Eigen::Vector3s& weights,
+    int& best,
+    s_t& bestDist) const
+{
+  const Node& n = mNodes[node];
+  if (n.left == -1)
+  {
+    for (int i = n.begin; i < n.end; i++)
+    {
+      s_t dist = (mVertices[i] - query).cwiseAbs2().dot(weights);
+      if (dist < bestDist)
+      {
+        bestDist = dist;
+        best = i;
+      }
+    }
+    return;
+  }
+
+  s_t offset = query(n.axis) - n.split;
+  int nearChild = offset < 0 ? n.left : n.right;
+  int farChild = offset < 0 ? n.right : n.left;
+  search(nearChild, query, weights, best, bestDist);
+  // Only cross the split plane if it's closer than the best vertex so far
+  if (weights(n.axis) * offset * offset < bestDist)
+  {
+    search(farChild, query, weights, best, bestDist);
+  }
+}
+
+} // namespace math
+} // namespace dart
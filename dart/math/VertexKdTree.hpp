@@ -0,0 +1,68 @@
+#ifndef DART_MATH_VERTEX_KD_TREE_HPP_
+#define DART_MATH_VERTEX_KD_TREE_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a static 3D k-d tree over a point cloud (usually the vertices of a
+/// mesh), for nearest-vertex queries. Queries can pass a per-axis scale, which
+/// is applied to the vertices before measuring distance, so one tree built on
+/// the unscaled mesh keeps answering correctly as bodies are rescaled.
+class VertexKdTree
+{
+public:
+  /// Leaves hold at most this many vertices, which get scanned linearly
+  static constexpr int LEAF_SIZE = 8;
+
+  /// This builds the tree over `points`
+  VertexKdTree(const std::vector<Eigen::Vector3s>& points);
+
+  /// This returns the index (into getVertices()) of the vertex `v` that
+  /// minimizes |scale .* v - point|, or -1 if the tree is empty. Every entry
+  /// of `scale` must be non-zero.
+  int findNearest(
+      const Eigen::Vector3s& point,
+      const Eigen::Vector3s& scale = Eigen::Vector3s::Ones()) const;
+
+  /// These are the (unscaled) vertices, in the tree's own order
+  const std::vector<Eigen::Vector3s>& getVertices() const;
+
+protected:
+  struct Node
+  {
+    /// The range of mVertices under this node
+    int begin;
+    int end;
+    /// The split plane, for inner nodes
+    int axis;
+    s_t split;
+    /// Child indices into mNodes, or -1 for a leaf
+    int left;
+    int right;
+  };
+
+  /// This builds the subtree over mVertices[begin, end), and returns its index
+  int build(int begin, int end);
+
+  /// This descends from `node`, tightening `best` and `bestDist`
+  void search(
+      int node,
+      const Eigen::Vector3s& query,
+      const Eigen::Vector3s& weights,
+      int& best,
+      s_t& bestDist) const;
+
+  std::vector<Eigen::Vector3s> mVertices;
+  std::vector<Node> mNodes;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,525 @@
+#ifndef DART_MATH_DETAIL_FINITE_DIFFERENCE_IMPL_HPP_
+#define DART_MATH_DETAIL_FINITE_DIFFERENCE_IMPL_HPP_
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <Eigen/Dense>
+
+#include "dart/math/FiniteDifference.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+namespace detail {
+
+//==============================================================================
+template <class GetPerturbed, class T>
+void centralDifferenceColumns(
+    GetPerturbed& getPerturbed, T& result, s_t eps)
+{
+  using std::abs;
+
+  if (result.size() == 0)
+    return;
+
+  // Run central differences for every column of the result separately
+  for (int dof = 0; dof < result.cols(); dof++)
+  {
+    s_t epsPos = eps;
+    typename ColumnOf<T>::type perturbedPlus;
+    // Get perturbed result with smaller and smaller eps until valid
+    while (!getPerturbed(epsPos, dof, perturbedPlus))
+    {
+      epsPos *= 0.5;
+      if (abs(epsPos) <= 1e-20)
+        throw non_differentiable_point_exception();
+    }
+
+    s_t epsNeg = eps;
+    typename ColumnOf<T>::type perturbedMinus;
+    while (!getPerturbed(-epsNeg, dof, perturbedMinus))
+    {
+      epsNeg *= 0.5;
+      if (abs(epsPos) <= 1e-20)
+        throw non_differentiable_point_exception();
+    }
+
+    // if this point is reached, getPerturbed should have produced valid results
+    result.col(dof).noalias()
+        = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
+  }
+}
+
+//==============================================================================
+template <class GetPerturbed, class T>
+void centralDifferenceScalars(
+    GetPerturbed& getPerturbed, T& result, s_t eps)
+{
+  using std::abs;
+
+  if (result.size() == 0)
+    return;
+
+  // Run central differences for every entry of the result separately
+  for (int dof = 0; dof < result.size(); dof++)
+  {
+    s_t epsPos = eps;
+    s_t perturbedPlus;
+    // Get perturbed result with smaller and smaller eps until valid
+    while (!getPerturbed(epsPos, dof, perturbedPlus))
+    {
+      epsPos *= 0.5;
+      if (abs(epsPos) <= 1e-20)
+        throw non_differentiable_point_exception();
+    }
+
+    s_t epsNeg = eps;
+    s_t perturbedMinus;
+    while (!getPerturbed(-epsNeg, dof, perturbedMinus))
+    {
+      epsNeg *= 0.5;
+      if (abs(epsPos) <= 1e-20)
+        throw non_differentiable_point_exception();
+    }
+
+    // if this point is reached, getPerturbed should have produced valid results
+    result(dof) = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
+  }
+}
+
+//==============================================================================
+template <class GetPerturbed, class T>
+void centralDifferenceStatic(GetPerturbed& getPerturbed, T& result, s_t eps)
+{
+  using std::abs;
+
+  if (result.size() == 0)
+    return;
+
+  s_t epsPos = eps;
+  T perturbedPlus;
+  // Get perturbed result with smaller and smaller eps until valid
+  while (!getPerturbed(epsPos, perturbedPlus))
+  {
+    epsPos *= 0.5;
+    if (abs(epsPos) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  s_t epsNeg = eps;
+  T perturbedMinus;
+  while (!getPerturbed(-epsNeg, perturbedMinus))
+  {
+    epsNeg *= 0.5;
+    if (abs(epsPos) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  // if this point is reached, getPerturbed should have produced valid results
+  result = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
+}
+
+//==============================================================================
+template <class GetPerturbed>
+void centralDifferenceScalar(
+    GetPerturbed& getPerturbed, s_t& result, s_t eps)
+{
+  using std::abs;
+
+  s_t epsPos = eps;
+  s_t perturbedPlus;
+  // Get perturbed result with smaller and smaller eps until valid
+  while (!getPerturbed(epsPos, perturbedPlus))
+  {
+    epsPos *= 0.5;
+    if (abs(epsPos) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  s_t epsNeg = eps;
+  s_t perturbedMinus;
+  while (!getPerturbed(-epsNeg, perturbedMinus))
+  {
+    epsNeg *= 0.5;
+    if (abs(epsPos) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  // if this point is reached, getPerturbed should have produced valid results
+  result = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
+}
+
+//==============================================================================
+template <class GetPerturbed, class T>
+void riddersMethodColumns(GetPerturbed& getPerturbed, T& result, s_t eps)
+{
+  using std::abs;
+  using std::max;
+  using Column = typename ColumnOf<T>::type;
+
+  if (result.size() == 0)
+    return;
+
+  s_t originalStepSize = eps;
+  const s_t con = 1.4, con2 = (con * con);
+  const s_t safeThreshold = 2.0;
+  const int tabSize = 10;
+
+  // Run central differences for every column of the result separately
+  for (int dof = 0; dof < result.cols(); dof++)
+  {
+    // Neville tableau of finite difference results
+    std::array<std::array<Column, tabSize>, tabSize> tab;
+
+    // Get perturbed result with smaller and smaller eps until valid
+    // For Ridders we want the pos and neg epsilons to be the same.
+    Column perturbedPlus, perturbedMinus;
+    while (!getPerturbed(originalStepSize, dof, perturbedPlus)
+           || !getPerturbed(-originalStepSize, dof, perturbedMinus))
+    {
+      originalStepSize *= 0.5;
+      if (abs(originalStepSize) <= 1e-20)
+        throw non_differentiable_point_exception();
+    }
+
+    // if this point is reached, getPerturbed should have produced valid results
+    tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
+
+    s_t stepSize = originalStepSize;
+    s_t bestError = std::numeric_limits<s_t>::max();
+
+    // Iterate over smaller and smaller step sizes
+    for (int iTab = 1; iTab < tabSize; iTab++)
+    {
+      stepSize /= con;
+
+      if (!getPerturbed(stepSize, dof, perturbedPlus)
+          || !getPerturbed(-stepSize, dof, perturbedMinus))
+      {
+        throw ridders_invalid_state_exception();
+      }
+
+      tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
+
+      s_t fac = con2;
+      // Compute extrapolations of increasing orders, requiring no new
+      // evaluations
+      for (int jTab = 1; jTab <= iTab; jTab++)
+      {
+        tab[jTab][iTab] = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1])
+                          / (fac - 1.0);
+        fac = con2 * fac;
+        s_t currError = max(
+            (tab[jTab][iTab] - tab[jTab - 1][iTab]).array().abs().maxCoeff(),
+            (tab[jTab][iTab] - tab[jTab - 1][iTab - 1])
+                .array()
+                .abs()
+                .maxCoeff());
+        if (currError < bestError)
+        {
+          bestError = currError;
+          result.col(dof).noalias() = tab[jTab][iTab];
+        }
+      }
+
+      // If higher order is worse by a significant factor, quit early.
+      if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1]).array().abs().maxCoeff()
+          >= safeThreshold * bestError)
+      {
+        break;
+      }
+    }
+  }
+}
+
+//==============================================================================
+template <class GetPerturbed, class T>
+void riddersMethodScalars(GetPerturbed& getPerturbed, T& result, s_t eps)
+{
+  using std::abs;
+  using std::max;
+
+  if (result.size() == 0)
+    return;
+
+  s_t originalStepSize = eps;
+  const s_t con = 1.4, con2 = (con * con);
+  const s_t safeThreshold = 2.0;
+  const int tabSize = 10;
+
+  // Run central differences for every entry of the result separately
+  for (int dof = 0; dof < result.size(); dof++)
+  {
+    // Neville tableau of finite difference results
+    std::array<std::array<s_t, tabSize>, tabSize> tab;
+
+    // Get perturbed result with smaller and smaller eps until valid
+    // For Ridders we want the pos and neg epsilons to be the same.
+    s_t perturbedPlus, perturbedMinus;
+    while (!getPerturbed(originalStepSize, dof, perturbedPlus)
+           || !getPerturbed(-originalStepSize, dof, perturbedMinus))
+    {
+      originalStepSize *= 0.5;
+      if (abs(originalStepSize) <= 1e-20)
+        throw non_differentiable_point_exception();
+    }
+
+    // if this point is reached, getPerturbed should have produced valid results
+    tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
+
+    s_t stepSize = originalStepSize;
+    s_t bestError = std::numeric_limits<s_t>::max();
+
+    // Iterate over smaller and smaller step sizes
+    for (int iTab = 1; iTab < tabSize; iTab++)
+    {
+      stepSize /= con;
+
+      if (!getPerturbed(stepSize, dof, perturbedPlus)
+          || !getPerturbed(-stepSize, dof, perturbedMinus))
+      {
+        throw ridders_invalid_state_exception();
+      }
+
+      tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
+
+      s_t fac = con2;
+      // Compute extrapolations of increasing orders, requiring no new
+      // evaluations
+      for (int jTab = 1; jTab <= iTab; jTab++)
+      {
+        tab[jTab][iTab] = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1])
+                          / (fac - 1.0);
+        fac = con2 * fac;
+        s_t currError = max(
+            (tab[jTab][iTab] - tab[jTab - 1][iTab]),
+            (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]));
+        if (currError < bestError)
+        {
+          bestError = currError;
+          result(dof) = tab[jTab][iTab];
+        }
+      }
+
+      // If higher order is worse by a significant factor, quit early.
+      if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1])
+          >= safeThreshold * bestError)
+      {
+        break;
+      }
+    }
+  }
+}
+
+//==============================================================================
+template <class GetPerturbed, class T>
+void riddersMethodStatic(GetPerturbed& getPerturbed, T& result, s_t eps)
+{
+  using std::abs;
+  using std::max;
+
+  if (result.size() == 0)
+    return;
+
+  s_t originalStepSize = eps;
+  const s_t con = 1.4, con2 = (con * con);
+  const s_t safeThreshold = 2.0;
+  const int tabSize = 10;
+
+  // Neville tableau of finite difference results
+  std::array<std::array<T, tabSize>, tabSize> tab;
+
+  // Get perturbed result with smaller and smaller eps until valid
+  // For Ridders we want the pos and neg epsilons to be the same.
+  T perturbedPlus, perturbedMinus;
+  while (!getPerturbed(originalStepSize, perturbedPlus)
+         || !getPerturbed(-originalStepSize, perturbedMinus))
+  {
+    originalStepSize *= 0.5;
+    if (abs(originalStepSize) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  // if this point is reached, getPerturbed should have produced valid results
+  tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
+
+  s_t stepSize = originalStepSize;
+  s_t bestError = std::numeric_limits<s_t>::max();
+
+  // Iterate over smaller and smaller step sizes
+  for (int iTab = 1; iTab < tabSize; iTab++)
+  {
+    stepSize /= con;
+
+    if (!getPerturbed(stepSize, perturbedPlus)
+        || !getPerturbed(-stepSize, perturbedMinus))
+    {
+      throw ridders_invalid_state_exception();
+    }
+
+    tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
+
+    s_t fac = con2;
+    // Compute extrapolations of increasing orders, requiring no new
+    // evaluations
+    for (int jTab = 1; jTab <= iTab; jTab++)
+    {
+      tab[jTab][iTab]
+          = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1]) / (fac - 1.0);
+      fac = con2 * fac;
+      s_t currError = max(
+          (tab[jTab][iTab] - tab[jTab - 1][iTab]).array().abs().maxCoeff(),
+          (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]).array().abs().maxCoeff());
+      if (currError < bestError)
+      {
+        bestError = currError;
+        result = tab[jTab][iTab];
+      }
+    }
+
+    // If higher order is worse by a significant factor, quit early.
+    if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1]).array().abs().maxCoeff()
+        >= safeThreshold * bestError)
+    {
+      break;
+    }
+  }
+}
+
+//==============================================================================
+template <class GetPerturbed>
+void riddersMethodScalar(GetPerturbed& getPerturbed, s_t& result, s_t eps)
+{
+  using std::abs;
+  using std::max;
+
+  s_t originalStepSize = eps;
+  const s_t con = 1.4, con2 = (con * con);
+  const s_t safeThreshold = 2.0;
+  const int tabSize = 10;
+
+  // Neville tableau of finite difference results
+  std::array<std::array<s_t, tabSize>, tabSize> tab;
+
+  // Get perturbed result with smaller and smaller eps until valid
+  // For Ridders we want the pos and neg epsilons to be the same.
+  s_t perturbedPlus, perturbedMinus;
+  while (!getPerturbed(originalStepSize, perturbedPlus)
+         || !getPerturbed(-originalStepSize, perturbedMinus))
+  {
+    originalStepSize *= 0.5;
+    if (abs(originalStepSize) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  // if this point is reached, getPerturbed should have produced valid results
+  tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
+
+  s_t stepSize = originalStepSize;
+  s_t bestError = std::numeric_limits<s_t>::max();
+
+  // Iterate over smaller and smaller step sizes
+  for (int iTab = 1; iTab < tabSize; iTab++)
+  {
+    stepSize /= con;
+
+    if (!getPerturbed(stepSize, perturbedPlus)
+        || !getPerturbed(-stepSize, perturbedMinus))
+    {
+      throw ridders_invalid_state_exception();
+    }
+
+    tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
+
+    s_t fac = con2;
+    // Compute extrapolations of increasing orders, requiring no new
+    // evaluations
+    for (int jTab = 1; jTab <= iTab; jTab++)
+    {
+      tab[jTab][iTab]
+          = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1]) / (fac - 1.0);
+      fac = con2 * fac;
+      s_t currError = max(
+          (tab[jTab][iTab] - tab[jTab - 1][iTab]),
+          (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]));
+      if (currError < bestError)
+      {
+        bestError = currError;
+        result = tab[jTab][iTab];
+      }
+    }
+
+    // If higher order is worse by a significant factor, quit early.
+    if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1])
+        >= safeThreshold * bestError)
+    {
+      break;
+    }
+  }
+}
+
+} // namespace detail
+
+//==============================================================================
+template <class T, class GetPerturbed>
+typename std::enable_if<detail::IsPerturbation<
+    GetPerturbed,
+    s_t,
+    int,
+    typename detail::ColumnOf<T>::type&>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed, T& result, s_t eps, bool useRidders)
+{
+  if (useRidders)
+    detail::riddersMethodColumns(getPerturbed, result, eps);
+  else
+    detail::centralDifferenceColumns(getPerturbed, result, eps);
+}
+
+//==============================================================================
+template <class T, class GetPerturbed>
+typename std::enable_if<
+    detail::IsPerturbation<GetPerturbed, s_t, int, s_t&>::value
+    && std::is_class<typename detail::ColumnOf<T>::type>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed, T& result, s_t eps, bool useRidders)
+{
+  if (useRidders)
+    detail::riddersMethodScalars(getPerturbed, result, eps);
+  else
+    detail::centralDifferenceScalars(getPerturbed, result, eps);
+}
+
+//==============================================================================
+template <class T, class GetPerturbed>
+typename std::enable_if<
+    detail::IsPerturbation<GetPerturbed, s_t, T&>::value
+    && std::is_class<typename detail::ColumnOf<T>::type>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed, T& result, s_t eps, bool useRidders)
+{
+  if (useRidders)
+    detail::riddersMethodStatic(getPerturbed, result, eps);
+  else
+    detail::centralDifferenceStatic(getPerturbed, result, eps);
+}
+
+//==============================================================================
+template <class GetPerturbed>
+typename std::enable_if<
+    detail::IsPerturbation<GetPerturbed, s_t, s_t&>::value>::type
+finiteDifference(
+    GetPerturbed getPerturbed, s_t& result, s_t eps, bool useRidders)
+{
+  if (useRidders)
+    detail::riddersMethodScalar(getPerturbed, result, eps);
+  else
+    detail::centralDifferenceScalar(getPerturbed, result, eps);
+}
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,565 @@
+#ifndef DART_MATH_DETAIL_IK_SOLVER_IMPL_HPP_
+#define DART_MATH_DETAIL_IK_SOLVER_IMPL_HPP_
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/IKSolver.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+namespace detail {
+
+//==============================================================================
+/// This computes A = J^T J and g = J^T diff. If `sparsity` has an entry for
+/// every row of J, each row only contributes the products between its listed
+/// columns, which skips the (usually many) structural zeros.
+template <class JacType, class TargetType, class HessType, class PosType>
+void accumulateNormalEquations(
+    const JacType& J,
+    const TargetType& diff,
+    const std::vector<std::vector<int>>& sparsity,
+    HessType& A,
+    PosType& g)
+{
+  if ((int)sparsity.size() != J.rows())
+  {
+    A.noalias() = J.transpose() * J;
+    g.noalias() = J.transpose() * diff;
+    return;
+  }
+
+  A.setZero();
+  g.setZero();
+  for (int r = 0; r < J.rows(); r++)
+  {
+    const std::vector<int>& cols = sparsity[r];
+    for (int a = 0; a < cols.size(); a++)
+    {
+      const s_t ja = J(r, cols[a]);
+      if (ja == 0)
+        continue;
+      g(cols[a]) += ja * diff(r);
+      for (int b = a; b < cols.size(); b++)
+      {
+        A(cols[a], cols[b]) += ja * J(r, cols[b]);
+      }
+    }
+  }
+  // Only one triangle got filled in (up to the order of each row's columns),
+  // so mirror the sum of both halves
+  A = (A + A.transpose()).eval();
+  A.diagonal() *= 0.5;
+}
+
+//==============================================================================
+/// This is refineIK() when `config.levenbergMarquardt` is set. Each iteration
+/// solves (J^T J + mu I) delta = J^T diff, and keeps the step if it reduces
+/// the loss, adjusting mu by how well the linear model predicted that
+/// reduction. A rejected step only bumps mu and re-solves against the J^T J
+/// we already have, and an accepted step re-uses the Jacobian that came back
+/// with the trial evaluation, so every iteration costs exactly one eval().
+template <int Dofs, int Targets, class SetPosAndClamp, class Eval>
+IKResult refineIKLevenbergMarquardt(
+    const Eigen::VectorXs& initialPos,
+    int targetSize,
+    SetPosAndClamp& setPosAndClamp,
+    Eval& eval,
+    const IKConfig& config)
+{
+  using Pos = Eigen::Matrix<s_t, Dofs, 1>;
+  using Target = Eigen::Matrix<s_t, Targets, 1>;
+  using Jac = Eigen::Matrix<s_t, Targets, Dofs>;
+  using Hess = Eigen::Matrix<s_t, Dofs, Dofs>;
+
+  Pos pos = initialPos;
+  const int dofs = pos.size();
+
+  // Allocate these values once, to re-use in the inner loop
+  Target diff = Target::Zero(targetSize);
+  Jac J = Jac::Zero(targetSize, dofs);
+  Target trialDiff = Target::Zero(targetSize);
+  Jac trialJ = Jac::Zero(targetSize, dofs);
+  Hess A = Hess::Zero(dofs, dofs);
+  Hess damped = Hess::Zero(dofs, dofs);
+  Pos g = Pos::Zero(dofs);
+  Pos delta = Pos::Zero(dofs);
+
+  bool clamp = config.startClamped;
+  pos = setPosAndClamp(pos, clamp);
+  eval(diff, J);
+  s_t error = diff.squaredNorm();
+  accumulateNormalEquations(J, diff, config.jacobianSparsity, A, g);
+
+  s_t mu = std::max<s_t>(config.leastSquaresDamping, 1e-12)
+           * std::max<s_t>(A.diagonal().maxCoeff(), 1e-12);
+  s_t nu = 2.0;
+
+  for (int i = 0; i < config.maxStepCount; i++)
+  {
+    if (error < 1e-21)
+    {
+      if (config.logOutput)
+      {
+        std::cout << "Terminating LM IK search after " << i
+                  << " iterations with loss: " << error << std::endl;
+      }
+      break;
+    }
+
+    // Force clamping on the last 5 steps of IK, even if we wouldn't have
+    // otherwise clamped, so each run results in _something_ valid
+    if (!clamp && i >= config.maxStepCount - 5)
+    {
+      clamp = true;
+      pos = setPosAndClamp(pos, clamp);
+      eval(diff, J);
+      error = diff.squaredNorm();
+      accumulateNormalEquations(J, diff, config.jacobianSparsity, A, g);
+    }
+
+    damped = A;
+    damped.diagonal().array() += mu;
+    delta = damped.ldlt().solve(g);
+
+    // With the loss as |diff|^2, the linear model predicts the step -delta
+    // will reduce it by 2 g.delta - delta^T A delta = delta.(g + mu delta)
+    s_t predicted = delta.dot(g + mu * delta);
+
+    Pos trialPos = setPosAndClamp(pos - delta, clamp);
+    eval(trialDiff, trialJ);
+    s_t trialError = trialDiff.squaredNorm();
+    s_t actual = error - trialError;
+
+    if (config.logOutput)
+    {
+      std::cout << "LM IK iteration " << i << " mu: " << mu
+                << " clamp: " << clamp << " loss: " << trialError
+                << " change: " << -actual << std::endl;
+    }
+
+    if (actual > 0 && predicted > 0)
+    {
+      s_t rho = actual / predicted;
+      pos = trialPos;
+      diff.swap(trialDiff);
+      J.swap(trialJ);
+      error = trialError;
+      accumulateNormalEquations(J, diff, config.jacobianSparsity, A, g);
+      s_t fit = 2.0 * rho - 1.0;
+      mu *= std::max<s_t>(1.0 / 3.0, 1.0 - fit * fit * fit);
+      nu = 2.0;
+
+      if (actual < config.convergenceThreshold)
+      {
+        if (!clamp)
+        {
+          clamp = true;
+          pos = setPosAndClamp(pos, clamp);
+          eval(diff, J);
+          error = diff.squaredNorm();
+          accumulateNormalEquations(J, diff, config.jacobianSparsity, A, g);
+        }
+        else
+        {
+          if (config.logOutput)
+          {
+            std::cout << "Terminating LM IK search after " << i
+                      << " iterations with optimal loss: " << error
+                      << std::endl;
+          }
+          break;
+        }
+      }
+    }
+    else
+    {
+      // Put the state back where it was, and retry with more damping
+      setPosAndClamp(pos, clamp);
+      mu *= nu;
+      nu *= 2.0;
+      if (mu > 1e20 || delta.squaredNorm() < 1e-30)
+      {
+        if (config.logOutput)
+        {
+          std::cout << "Terminating LM IK search after " << i
+                    << " iterations because steps are vanishing, with loss: "
+                    << error << std::endl;
+        }
+        break;
+      }
+    }
+  }
+
+  if (config.logOutput)
+  {
+    std::cout << "Finished LM IK search with loss: " << error << std::endl;
+  }
+
+  IKResult result;
+  result.pos = pos;
+  result.loss = error;
+  result.clamped = clamp;
+
+  return result;
+}
+
+//==============================================================================
+/// This is the body of refineIK(). `Dofs` and `Targets` size the position,
+/// error, and Jacobian buffers, and can be left Eigen::Dynamic.
+template <int Dofs, int Targets, class SetPosAndClamp, class Eval>
+IKResult refineIK(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    SetPosAndClamp& setPosAndClamp,
+    Eval& eval,
+    const IKConfig& config)
+{
+  using Pos = Eigen::Matrix<s_t, Dofs, 1>;
+  using Target = Eigen::Matrix<s_t, Targets, 1>;
+  using Jac = Eigen::Matrix<s_t, Targets, Dofs>;
+  (void)upperBound;
+  (void)lowerBound;
+
+  if (config.levenbergMarquardt)
+  {
+    return refineIKLevenbergMarquardt<Dofs, Targets>(
+        initialPos, targetSize, setPosAndClamp, eval, config);
+  }
+
+    Pos pos = initialPos;
+
+  // Allocate these values once, to re-use in the inner loop
+  Target diff = Target::Zero(targetSize);
+  Jac J = Jac::Zero(targetSize, pos.size());
+
+  s_t lastError = std::numeric_limits<s_t>::infinity();
+  s_t lr = 1.0;
+  bool useTranspose = false;
+  bool clamp = config.startClamped;
+
+  pos = setPosAndClamp(pos, clamp);
+
+  Pos lastPos = pos;
+
+  for (int i = 0; i < config.maxStepCount; i++)
+  {
+    // Force clamping on the last 5 steps of IK, even if we wouldn't have
+    // otherwise clamped. This means that each run results in _something_
+    // valid, even if we hit our maxStepCount before we hit our convergence
+    // threshold.
+    if (i > config.maxStepCount - 5)
+    {
+      clamp = true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Get a current error
+    /////////////////////////////////////////////////////////////////////////////
+
+    eval(diff, J);
+    s_t currentError = diff.squaredNorm();
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Measure change from last timestep
+    /////////////////////////////////////////////////////////////////////////////
+
+    if (i > 0)
+    {
+      s_t errorChange = currentError - lastError;
+
+      if (config.logOutput)
+      {
+        std::cout << "IK "
+                  << " iteration " << i - 1
+                  << " step: " << (useTranspose ? "transpose" : "DLS")
+                  << " clamp: " << clamp << " lr: " << lr
+                  << " loss: " << currentError << " change: " << errorChange
+                  << std::endl;
+      }
+
+      if (currentError < 1e-21)
+      {
+        if (config.logOutput)
+        {
+          std::cout << "Terminating IK search after " << i
+                    << " iterations with loss: " << currentError << std::endl;
+        }
+        break;
+      }
+      if (errorChange > 0)
+      {
+        lr *= 0.5;
+        if (lr < 1e-4)
+        {
+          useTranspose = true;
+        }
+        else if (!config.dontExitTranspose)
+        {
+          useTranspose = false;
+        }
+
+        if (config.lineSearch)
+        {
+          pos = setPosAndClamp(lastPos, clamp);
+        }
+        if (lr < 1e-10)
+        {
+          if (config.logOutput)
+          {
+            std::cout << "Terminating IK search after " << i
+                      << " iterations because learning rate is vanishing, "
+                         "with loss: "
+                      << currentError << std::endl;
+          }
+          break;
+        }
+      }
+      else if (errorChange > -config.convergenceThreshold)
+      {
+        if (!useTranspose)
+        {
+          // Go ahead and tighten down the solution with the transpose as far
+          // as we can
+          if (lr > 5e-5)
+          {
+            lr = 5e-5;
+          }
+          useTranspose = true;
+        }
+        else
+        {
+          if (!clamp)
+          {
+            clamp = true;
+          }
+          else
+          {
+            // Terminate after we've reached the limit _and_ we're clamping
+            // properly
+            if (config.logOutput)
+            {
+              std::cout << "Terminating IK search after " << i
+                        << " iterations with optimal loss: " << currentError
+                        << std::endl;
+            }
+            break;
+          }
+        }
+      }
+      else
+      {
+        // Slowly grow LR while we're safely decreasing loss
+        lr *= 1.1;
+      }
+    }
+
+    lastError = currentError;
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Do the actual IK update
+    /////////////////////////////////////////////////////////////////////////////
+
+    Pos delta;
+    if (useTranspose)
+    {
+      delta = J.transpose() * diff;
+    }
+    else
+    {
+      // Do damped-least-squares
+      if (config.leastSquaresDamping == 0)
+      {
+        delta = J.completeOrthogonalDecomposition().solve(diff);
+      }
+      else
+      {
+        if (J.cols() < J.rows())
+        {
+          Eigen::Matrix<s_t, Targets, Targets> toInvert
+              = J * J.transpose()
+                + config.leastSquaresDamping
+                      * Eigen::Matrix<s_t, Targets, Targets>::Identity(
+                          J.rows(), J.rows());
+          delta = J.transpose() * toInvert.llt().solve(diff);
+        }
+        else
+        {
+          Eigen::Matrix<s_t, Dofs, Dofs> toInvert
+              = J.transpose() * J
+                + config.leastSquaresDamping
+                      * Eigen::Matrix<s_t, Dofs, Dofs>::Identity(
+                          J.cols(), J.cols());
+          delta = toInvert.llt().solve(J.transpose() * diff);
+        }
+      }
+    }
+    lastPos = pos;
+    pos = setPosAndClamp(pos - (lr * delta), clamp);
+  }
+
+  if (config.logOutput)
+  {
+    std::cout << "Finished IK search with loss: " << lastError << std::endl;
+  }
+
+  IKResult result;
+  result.pos = pos;
+  result.loss = lastError;
+  result.clamped = clamp;
+
+  return result;
+}
+
+
+//==============================================================================
+/// This is the body of solveIK()
+template <
+    int Dofs,
+    int Targets,
+    class SetPosAndClamp,
+    class Eval,
+    class GetRandomRestart>
+s_t solveIK(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    SetPosAndClamp& setPosAndClamp,
+    Eval& eval,
+    GetRandomRestart& getRandomRestart,
+    const IKConfig& config)
+{
+  using Pos = Eigen::Matrix<s_t, Dofs, 1>;
+
+  s_t bestError = std::numeric_limits<s_t>::infinity();
+  Pos bestResult = initialPos;
+
+  Pos pos = setPosAndClamp(initialPos, config.startClamped);
+
+  // For each of the restarts, only do 20 steps, to gauge which one seems most
+  // promising
+  for (int k = 0; k < config.maxRestarts; k++)
+  {
+    if (k > 0)
+    {
+      getRandomRestart(pos);
+      pos = setPosAndClamp(pos, true);
+      if (config.logOutput)
+      {
+        std::cout << "## IK random restart " << k << " [best = " << bestError
+                  << "]" << std::endl;
+      }
+    }
+
+    IKResult result = detail::refineIK<Dofs, Targets>(
+        pos,
+        upperBound,
+        lowerBound,
+        targetSize,
+        setPosAndClamp,
+        eval,
+        IKConfig(config).setMaxStepCount(20));
+
+    if (result.loss < bestError && result.clamped)
+    {
+      bestError = result.loss;
+      bestResult = result.pos;
+      if (result.loss <= config.lossLowerBound)
+      {
+        if (config.logOutput)
+        {
+          std::cout
+              << "Terminating random restarts early, because we found an loss "
+              << bestError << " <= " << config.lossLowerBound
+              << " that satisfies or exceeds the loss lower-bound we "
+                 "were expecting."
+              << std::endl;
+        }
+        break;
+      }
+    }
+  }
+
+  setPosAndClamp(bestResult, true);
+
+  // For the best restart, run the remainder of the steps to further refine the
+  // IK solution
+  IKResult result = detail::refineIK<Dofs, Targets>(
+      bestResult,
+      upperBound,
+      lowerBound,
+      targetSize,
+      setPosAndClamp,
+      eval,
+      config);
+
+  if (config.logOutput)
+  {
+    std::cout << "Finished IK search with loss: " << bestError << std::endl;
+  }
+  return bestError;
+}
+
+} // namespace detail
+
+//==============================================================================
+template <int Dofs, int Targets, class SetPosAndClamp, class Eval>
+IKResult refineIK(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    SetPosAndClamp setPosAndClamp,
+    Eval eval,
+    IKConfig config)
+{
+  return detail::refineIK<Dofs, Targets>(
+      initialPos,
+      upperBound,
+      lowerBound,
+      targetSize,
+      setPosAndClamp,
+      eval,
+      config);
+}
+
+//==============================================================================
+template <
+    int Dofs,
+    int Targets,
+    class SetPosAndClamp,
+    class Eval,
+    class GetRandomRestart>
+s_t solveIK(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    SetPosAndClamp setPosAndClamp,
+    Eval eval,
+    GetRandomRestart getRandomRestart,
+    IKConfig config)
+{
+  return detail::solveIK<Dofs, Targets>(
+      initialPos,
+      upperBound,
+      lowerBound,
+      targetSize,
+      setPosAndClamp,
+      eval,
+      getRandomRestart,
+      config);
+}
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef DART_MATH_DETAIL_LBFGSB_IMPL_HPP_
+#define DART_MATH_DETAIL_LBFGSB_IMPL_HPP_
+
+#include <limits>
+
+#include <Eigen/Dense>
+
+#include "dart/math/LBFGSB.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+template <typename ProblemT>
+LBFGSBResult LBFGSB::minimizeProblem(
+    ProblemT& problem,
+    const Eigen::Ref<const Eigen::VectorXs>& lower,
+    const Eigen::Ref<const Eigen::VectorXs>& upper)
+{
+  Eigen::VectorXs x = problem.flatten();
+  LBFGSBResult result = minimize(
+      [&problem](const Eigen::VectorXs& x, Eigen::VectorXs& grad) {
+        problem.unflatten(x);
+        grad = problem.getGradient();
+        return problem.getLoss();
+      },
+      x,
+      lower,
+      upper);
+  problem.unflatten(x);
+  return result;
+}
+
+//==============================================================================
+template <typename ProblemT>
+LBFGSBResult LBFGSB::minimizeProblem(ProblemT& problem)
+{
+  const int dim = problem.flatten().size();
+  return minimizeProblem(
+      problem,
+      Eigen::VectorXs::Constant(dim, -std::numeric_limits<s_t>::infinity()),
+      Eigen::VectorXs::Constant(dim, std::numeric_limits<s_t>::infinity()));
+}
+
+} // namespace math
+} // namespace dart
+
+#endif
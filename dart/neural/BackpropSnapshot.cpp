@@ -29,6 +29,32 @@ using namespace performance;
 namespace dart {
 namespace neural {
 
+namespace {
+
+/// This sets the world to a snapshot's timestep for as long as it's in scope,
+/// so snapshots of substeps (see World::stepAdaptive()) differentiate with the
+/// timestep they were actually taken with
+class ScopedTimeStep
+{
+public:
+  ScopedTimeStep(WorldPtr world, s_t timeStep)
+    : mWorld(world), mOldTimeStep(world->getTimeStep())
+  {
+    mWorld->setTimeStep(timeStep);
+  }
+
+  ~ScopedTimeStep()
+  {
+    mWorld->setTimeStep(mOldTimeStep);
+  }
+
+private:
+  WorldPtr mWorld;
+  s_t mOldTimeStep;
+};
+
+} // namespace
+
 //==============================================================================
 BackpropSnapshot::BackpropSnapshot(
     WorldPtr world,
@@ -39,6 +65,7 @@ BackpropSnapshot::BackpropSnapshot(
     Eigen::VectorXs preStepLCPCache)
   : mUseFDOverride(world->getUseFDOverride()),
     mSlowDebugResultsAgainstFD(world->getSlowDebugResultsAgainstFD()),
+    mImplicitSpringDamping(world->getImplicitSpringDamping()),
     mNumDOFs(0),
     mNumConstraintDim(0),
     mNumClamping(0),
@@ -102,9 +129,11 @@ BackpropSnapshot::BackpropSnapshot(
   mCachedVelVelDirty = true;
   mCachedForcePosDirty = true;
   mCachedForceVelDirty = true;
+  mCachedForceVelColsDirty = true;
   mCachedMassVelDirty = true;
   mCachedVelCDirty = true;
   mCachedPosCDirty = true;
+  mCachedJvpDirty = true;
 
   /*
   if (!areResultsStandardized())
@@ -117,6 +146,86 @@ BackpropSnapshot::BackpropSnapshot(
   */
 }
 
+//==============================================================================
+BackpropSnapshot::~BackpropSnapshot()
+{
+  if (mJacobianCacheBudget)
+  {
+    mJacobianCacheBudget->remove(this);
+  }
+}
+
+//==============================================================================
+/// This runs backprop() on several losses at once. Each column of
+/// `nextLossWrtPosition` and `nextLossWrtVelocity` is a separate
+/// nextTimestepLoss, and the matching columns of the outputs get filled in.
+/// Every column shares the same cached Jacobians (and the one factorization
+/// of the clamping LCP behind them), so this is much cheaper than calling
+/// backprop() once per column.
+void BackpropSnapshot::backpropBatch(
+    WorldPtr world,
+    const Eigen::MatrixXs& nextLossWrtPosition,
+    const Eigen::MatrixXs& nextLossWrtVelocity,
+    Eigen::MatrixXs& lossWrtPosition,
+    Eigen::MatrixXs& lossWrtVelocity,
+    Eigen::MatrixXs& lossWrtTorque,
+    Eigen::MatrixXs& lossWrtMass,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("BackpropSnapshot.backpropBatch");
+  }
+#endif
+
+  assert(nextLossWrtPosition.cols() == nextLossWrtVelocity.cols());
+
+  RestorableSnapshot snapshot(world);
+  ScopedTimeStep timeStep(world, mTimeStep);
+  world->setPositions(mPreStepPosition);
+  world->setVelocities(mPreStepVelocity);
+  world->setControlForces(mPreStepTorques);
+  world->setCachedLCPSolution(mPreStepLCPCache);
+
+  const Eigen::MatrixXs& posPos = getPosPosJacobian(world, thisLog);
+  const Eigen::MatrixXs& posVel = getPosVelJacobian(world, thisLog);
+  const Eigen::MatrixXs& velPos = getVelPosJacobian(world, thisLog);
+  const Eigen::MatrixXs& velVel = getVelVelJacobian(world, thisLog);
+  const Eigen::MatrixXs& forceVel = getControlForceVelJacobian(world, thisLog);
+  const Eigen::MatrixXs& massVel = getMassVelJacobian(world, thisLog);
+
+  lossWrtPosition = posPos.transpose() * nextLossWrtPosition
+                    + posVel.transpose() * nextLossWrtVelocity;
+  lossWrtVelocity = velPos.transpose() * nextLossWrtPosition
+                    + velVel.transpose() * nextLossWrtVelocity;
+  lossWrtTorque = forceVel.transpose() * nextLossWrtVelocity;
+  lossWrtMass = massVel.transpose() * nextLossWrtVelocity;
+
+  Eigen::VectorXs pos;
+  Eigen::VectorXs vel;
+  Eigen::VectorXs torque;
+  for (int i = 0; i < lossWrtPosition.cols(); i++)
+  {
+    pos = lossWrtPosition.col(i);
+    vel = lossWrtVelocity.col(i);
+    torque = lossWrtTorque.col(i);
+    clipLossGradientsToBounds(world, pos, vel, torque);
+    lossWrtPosition.col(i) = pos;
+    lossWrtVelocity.col(i) = vel;
+    lossWrtTorque.col(i) = torque;
+  }
+
+  snapshot.restore();
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 void BackpropSnapshot::backprop(
     WorldPtr world,
@@ -125,6 +234,7 @@ void BackpropSnapshot::backprop(
     PerformanceLog* perfLog,
     bool exploreAlternateStrategies)
 {
+  auto backpropStart = std::chrono::steady_clock::now();
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (perfLog != nullptr)
@@ -140,6 +250,7 @@ void BackpropSnapshot::backprop(
   // that implicit mass matrix computations work correctly.
 
   RestorableSnapshot snapshot(world);
+  ScopedTimeStep timeStep(world, mTimeStep);
   world->setPositions(mPreStepPosition);
   world->setVelocities(mPreStepVelocity);
   world->setControlForces(mPreStepTorques);
@@ -155,8 +266,9 @@ void BackpropSnapshot::backprop(
   // TODO(opt): remove me, as soon as it's faster to construct the Jacobians
   // using ConstrainedGroups directly. Currently it's redundant to construct
   // Jacobians _both_ in the ConstrainedGroups and in the BackpropSnapshot, so
-  // it's better overall to just use one.
-  if (exploreAlternateStrategies == false)
+  // it's better overall to just use one. The per-group backprop also assumes
+  // an explicit spring and damper update.
+  if (exploreAlternateStrategies == false || mImplicitSpringDamping)
   {
     const Eigen::MatrixXs& posPos = getPosPosJacobian(world, thisLog);
     const Eigen::MatrixXs& posVel = getPosVelJacobian(world, thisLog);
@@ -190,6 +302,10 @@ void BackpropSnapshot::backprop(
     }
 #endif
     snapshot.restore();
+    world->recordBackpropNanos(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - backpropStart)
+            .count());
     return;
   }
 
@@ -289,38 +405,41 @@ void BackpropSnapshot::backprop(
       std::size_t dofs = skel->getNumDofs();
 
       /////////////////////////////////////////////////////////////////
-      // Explicitly form the matrices
+      // Apply the transposed Jacobians without forming Minv
       /////////////////////////////////////////////////////////////////
 
-      Eigen::MatrixXs Minv = skel->getInvMassMatrix();
-
-      Eigen::MatrixXs forceVel = mTimeStep * Minv;
-      Eigen::MatrixXs velVel
-          = Eigen::MatrixXs::Identity(skel->getNumDofs(), skel->getNumDofs())
-            - mTimeStep * Minv * skel->getVelCJacobian();
-      Eigen::MatrixXs posVel = skel->getUnconstrainedVelJacobianWrt(
-          world->getTimeStep(), WithRespectTo::POSITION);
-      Eigen::MatrixXs posPos
-          = Eigen::MatrixXs::Identity(skel->getNumDofs(), skel->getNumDofs());
-      Eigen::MatrixXs velPos
-          = mTimeStep
-            * Eigen::MatrixXs::Identity(skel->getNumDofs(), skel->getNumDofs());
+      // force-vel = dt * Minv, and vel-vel = I - dt * Minv * dC/dv. Minv is
+      // symmetric, so both transposes only need Minv * lossWrtVelocity, which
+      // one articulated-body pass gives us in O(n).
+      Eigen::VectorXs nextLossWrtVel
+          = nextTimestepLoss.lossWrtVelocity.segment(dofCursorWorld, dofs);
+      Eigen::VectorXs nextLossWrtPos
+          = nextTimestepLoss.lossWrtPosition.segment(dofCursorWorld, dofs);
+      Eigen::VectorXs Minv_lossWrtVel
+          = skel->multiplyByImplicitInvMassMatrix(nextLossWrtVel);
+
+      // pos-vel = -dt * Minv * (d/dpos (M ddq) + d/dpos C) at the
+      // unconstrained ddq, which also only needs Minv * lossWrtVelocity once
+      // it's transposed. One fused pass gives both that and dC/dv.
+      Eigen::VectorXs f = skel->getControlForces()
+                          - skel->getCoriolisAndGravityForces()
+                          + skel->getExternalForces() - skel->getDampingForce()
+                          - skel->getSpringForce();
+      dynamics::Skeleton::DynamicsJacobians jacobians;
+      skel->computeDynamicsJacobians(
+          skel->multiplyByImplicitInvMassMatrix(f), jacobians);
 
       thisTimestepLoss.lossWrtTorque.segment(dofCursorWorld, dofs)
-          = forceVel.transpose()
-            * nextTimestepLoss.lossWrtVelocity.segment(dofCursorWorld, dofs);
+          = mTimeStep * Minv_lossWrtVel;
       thisTimestepLoss.lossWrtVelocity.segment(dofCursorWorld, dofs)
-          = velVel.transpose()
-                * nextTimestepLoss.lossWrtVelocity.segment(dofCursorWorld, dofs)
-            + velPos.transpose()
-                  * nextTimestepLoss.lossWrtPosition.segment(
-                      dofCursorWorld, dofs);
+          = nextLossWrtVel
+            - mTimeStep * (jacobians.dC_dv.transpose() * Minv_lossWrtVel)
+            + mTimeStep * nextLossWrtPos;
       thisTimestepLoss.lossWrtPosition.segment(dofCursorWorld, dofs)
-          = posVel.transpose()
-                * nextTimestepLoss.lossWrtVelocity.segment(dofCursorWorld, dofs)
-            + posPos.transpose()
-                  * nextTimestepLoss.lossWrtPosition.segment(
-                      dofCursorWorld, dofs);
+          = nextLossWrtPos
+            - world->getTimeStep()
+                  * ((jacobians.dMddq_dq + jacobians.dC_dq).transpose()
+                     * Minv_lossWrtVel);
 
       /*
 
@@ -367,6 +486,10 @@ void BackpropSnapshot::backprop(
 
   // Restore the old position and velocity values before we ran backprop
   snapshot.restore();
+  world->recordBackpropNanos(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - backpropStart)
+          .count());
 
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
   if (thisLog != nullptr)
@@ -547,6 +670,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getControlForceVelJacobian(
       }
     }
 
+    if (mImplicitSpringDamping && !mUseFDOverride)
+    {
+      mCachedForceVel
+          += getImplicitSpringDampingCorrection(world, WithRespectTo::FORCE);
+    }
+
     if (mSlowDebugResultsAgainstFD)
     {
       Eigen::MatrixXs bruteForce = finiteDifferenceForceVelJacobian(world);
@@ -555,6 +684,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getControlForceVelJacobian(
 
     // mCachedForceVel = getVelJacobianWrt(world, WithRespectTo::FORCE);
     mCachedForceVelDirty = false;
+    noteCacheFilled();
 
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (refreshLog != nullptr)
@@ -573,6 +703,88 @@ const Eigen::MatrixXs& BackpropSnapshot::getControlForceVelJacobian(
   return mCachedForceVel;
 }
 
+//==============================================================================
+const Eigen::MatrixXs& BackpropSnapshot::getControlForceVelJacobianCols(
+    WorldPtr world, const std::vector<int>& dofs, PerformanceLog* perfLog)
+{
+#ifndef NDEBUG
+  assert(
+      world->getPositions() == mPreStepPosition
+      && world->getVelocities() == mPreStepVelocity);
+#endif
+
+  if (!mCachedForceVelColsDirty && mCachedForceVelColsDofs == dofs)
+  {
+    return mCachedForceVelCols;
+  }
+
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog
+        = perfLog->startRun("BackpropSnapshot.getControlForceVelJacobianCols");
+  }
+#endif
+
+  int numCols = dofs.size();
+  if (!mCachedForceVelDirty || mUseFDOverride || mImplicitSpringDamping)
+  {
+    // We either already have every column, or have to finite difference them
+    // all anyways (or correct them for implicit springs, which mixes every
+    // column of Minv), so just select the ones we need
+    const Eigen::MatrixXs& forceVel
+        = getControlForceVelJacobian(world, thisLog);
+    mCachedForceVelCols.resize(mNumDOFs, numCols);
+    for (int i = 0; i < numCols; i++)
+    {
+      mCachedForceVelCols.col(i) = forceVel.col(dofs[i]);
+    }
+  }
+  else
+  {
+    // The force-vel Jacobian is K * (dt * Minv), for a K that doesn't depend
+    // on which force we're differentiating with respect to. That means we
+    // only ever need the columns of Minv for the DOFs in `dofs`.
+    Eigen::MatrixXs Minv = getInvMassMatrix(world);
+    Eigen::MatrixXs dtMinvCols(mNumDOFs, numCols);
+    for (int i = 0; i < numCols; i++)
+    {
+      dtMinvCols.col(i) = mTimeStep * Minv.col(dofs[i]);
+    }
+
+    Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
+    if (A_c.cols() == 0)
+    {
+      mCachedForceVelCols = dtMinvCols;
+    }
+    else
+    {
+      // This is getVelJacobianWrt(world, WithRespectTo::FORCE), multiplied
+      // through with only the columns we need
+      Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
+      Eigen::MatrixXs E = getUpperBoundMappingMatrix();
+      refreshJvpCache(world);
+      Eigen::MatrixXs dB
+          = getBounceDiagonals().asDiagonal() * -A_c.transpose() * dtMinvCols;
+      Eigen::MatrixXs dF_c = mCachedJvpQFactor.solve(dB);
+      mCachedForceVelCols = Minv * ((A_c + A_ub * E) * dF_c) + dtMinvCols;
+    }
+  }
+
+  mCachedForceVelColsDofs = dofs;
+  mCachedForceVelColsDirty = false;
+  noteCacheFilled();
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+  return mCachedForceVelCols;
+}
+
 //==============================================================================
 /// This computes and returns the whole mass-vel jacobian. For backprop, you
 /// don't actually need this matrix, you can compute backprop directly. This
@@ -614,6 +826,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getMassVelJacobian(
       mCachedMassVel = getVelJacobianWrt(world, world->getWrtMass().get());
     }
 
+    if (mImplicitSpringDamping && !mUseFDOverride)
+    {
+      mCachedMassVel += getImplicitSpringDampingCorrection(
+          world, world->getWrtMass().get());
+    }
+
     if (mSlowDebugResultsAgainstFD)
     {
       Eigen::MatrixXs bruteForce = finiteDifferenceMassVelJacobian(world);
@@ -621,6 +839,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getMassVelJacobian(
     }
 
     mCachedMassVelDirty = false;
+    noteCacheFilled();
 
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (refreshLog != nullptr)
@@ -734,6 +953,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelVelJacobian(
       }
     }
 
+    if (mImplicitSpringDamping && !mUseFDOverride)
+    {
+      mCachedVelVel
+          += getImplicitSpringDampingCorrection(world, WithRespectTo::VELOCITY);
+    }
+
     if (mSlowDebugResultsAgainstFD)
     {
       Eigen::MatrixXs bruteForce = finiteDifferenceVelVelJacobian(world);
@@ -741,6 +966,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelVelJacobian(
     }
 
     mCachedVelVelDirty = false;
+    noteCacheFilled();
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (refreshLog != nullptr)
     {
@@ -796,6 +1022,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getPosVelJacobian(
       mCachedPosVel = getVelJacobianWrt(world, WithRespectTo::POSITION);
     }
 
+    if (mImplicitSpringDamping && !mUseFDOverride)
+    {
+      mCachedPosVel
+          += getImplicitSpringDampingCorrection(world, WithRespectTo::POSITION);
+    }
+
     if (mSlowDebugResultsAgainstFD)
     {
       Eigen::MatrixXs bruteForce = finiteDifferencePosVelJacobian(world);
@@ -803,6 +1035,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getPosVelJacobian(
     }
 
     mCachedPosVelDirty = false;
+    noteCacheFilled();
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (refreshLog != nullptr)
     {
@@ -836,14 +1069,15 @@ Eigen::VectorXs BackpropSnapshot::getAnalyticalNextV(
   Eigen::MatrixXs E = getUpperBoundMappingMatrix();
   Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXs Minv = world->getInvMassMatrix();
+  MassMatrixOperator Minv(world);
   Eigen::VectorXs tau = world->getControlForces();
   Eigen::VectorXs C = world->getCoriolisAndGravityAndExternalForces();
   s_t dt = world->getTimeStep();
   Eigen::VectorXs f_c = estimateClampingConstraintImpulses(world, A_c, A_ub, E);
 
-  Eigen::VectorXs preSolveV = mPreStepVelocity + dt * Minv * (tau - C);
-  Eigen::VectorXs f_cDeltaV = Minv * A_c_ub_E * f_c;
+  Eigen::VectorXs preSolveV
+      = mPreStepVelocity + dt * Minv.multiplyByInverse(tau - C);
+  Eigen::VectorXs f_cDeltaV = Minv.multiplyByInverse(A_c_ub_E * f_c);
   Eigen::VectorXs postSolveV = preSolveV + f_cDeltaV;
   return postSolveV;
 
@@ -1106,6 +1340,99 @@ Eigen::MatrixXs BackpropSnapshot::getVelJacobianWrt(
   */
 }
 
+//==============================================================================
+Eigen::MatrixXs BackpropSnapshot::getImplicitSpringDampingCorrection(
+    simulation::WorldPtr world, WithRespectTo* wrt)
+{
+  s_t dt = world->getTimeStep();
+  int wrtDim = wrt->dim(world.get());
+
+  // Springs and dampers never couple skeletons, so (M + H)^-1 is block
+  // diagonal just like Minv
+  Eigen::VectorXs h = Eigen::VectorXs::Zero(mNumDOFs);
+  Eigen::VectorXs dynamicDofs = Eigen::VectorXs::Zero(mNumDOFs);
+  Eigen::MatrixXs augMinv = Eigen::MatrixXs::Zero(mNumDOFs, mNumDOFs);
+  int cursor = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    int dofs = skel->getNumDofs();
+    h.segment(cursor, dofs) = skel->getImplicitSpringDampingDiagonal(dt);
+    for (int j = 0; j < dofs; j++)
+    {
+      dynamicDofs(cursor + j) = skel->getDof(j)->getJoint()->isKinematic()
+                                    ? 0.0
+                                    : 1.0;
+    }
+    augMinv.block(cursor, cursor, dofs, dofs)
+        = skel->getImplicitSpringDampingMassMatrix(dt).ldlt().solve(
+            Eigen::MatrixXs::Identity(dofs, dofs));
+    cursor += dofs;
+  }
+  if (h.isZero(0))
+  {
+    return Eigen::MatrixXs::Zero(mNumDOFs, wrtDim);
+  }
+
+  Eigen::MatrixXs Minv = getInvMassMatrix(world);
+  Eigen::VectorXs tau = world->getControlForces();
+  Eigen::VectorXs C = world->getCoriolisAndGravityAndExternalForces();
+  Eigen::VectorXs ddamp = getDampingVector(world);
+  Eigen::VectorXs spring_stiffs = getSpringStiffVector(world);
+  Eigen::VectorXs p_rest = getRestPositions(world);
+  Eigen::VectorXs v_t = world->getVelocities();
+  Eigen::VectorXs p_t = world->getPositions();
+  Eigen::VectorXs f = tau - C - ddamp.cwiseProduct(v_t)
+                      - spring_stiffs.cwiseProduct(p_t - p_rest + dt * v_t);
+
+  // This is the explicit velocity change, delta = dt * Minv * f, and its
+  // Jacobian
+  Eigen::VectorXs delta = dt * (Minv * f);
+  Eigen::MatrixXs dDelta;
+  if (wrt == WithRespectTo::FORCE)
+  {
+    dDelta = dt * Minv;
+  }
+  else if (wrt == WithRespectTo::VELOCITY)
+  {
+    Eigen::MatrixXs dF = getJacobianOfC(world, wrt);
+    dF.diagonal() += ddamp + dt * spring_stiffs;
+    dDelta = -dt * Minv * dF;
+  }
+  else
+  {
+    Eigen::MatrixXs dF = getJacobianOfC(world, wrt);
+    if (wrt == WithRespectTo::POSITION)
+    {
+      dF.diagonal() += spring_stiffs;
+    }
+    dDelta = getJacobianOfMinv(world, dt * f, wrt) - dt * Minv * dF;
+  }
+
+  // The implicit step uses (M + H)^-1 M delta = delta - y instead of delta,
+  // where y = (M + H)^-1 H delta. M depends on position and mass, so for
+  // those we also pick up (M + H)^-1 dM/dwrt y.
+  Eigen::MatrixXs dPreLCPVel = -augMinv * (h.asDiagonal() * dDelta);
+  if (wrt != WithRespectTo::FORCE && wrt != WithRespectTo::VELOCITY)
+  {
+    Eigen::VectorXs y = augMinv * h.cwiseProduct(delta);
+    dPreLCPVel += augMinv
+                  * (dynamicDofs.asDiagonal() * getJacobianOfM(world, y, wrt));
+  }
+
+  // The velocity after the LCP depends on the velocity before it through
+  // S = I + Minv * A_c_ub_E * dF_c/dv. The explicit force-vel Jacobian is
+  // S * dt * Minv, which gets us S without building dF_c/dv separately.
+  Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
+  if (A_c.cols() == 0)
+  {
+    return dPreLCPVel;
+  }
+  Eigen::MatrixXs S = getVelJacobianWrt(world, WithRespectTo::FORCE)
+                      * getMassMatrix(world) / dt;
+  return S * dPreLCPVel;
+}
+
 //==============================================================================
 /// This computes and returns the whole wrt-pos jacobian. For backprop, you
 /// don't actually need this matrix, you can compute backprop directly. This
@@ -1208,6 +1535,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getBounceApproximationJacobian(
     // snapshot.restore();
 
     mCachedBounceApproximationDirty = false;
+    noteCacheFilled();
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (refreshLog != nullptr)
     {
@@ -1259,6 +1587,281 @@ Eigen::MatrixXs BackpropSnapshot::getActionJacobian(simulation::WorldPtr world)
   return actionJac;
 }
 
+//==============================================================================
+/// This computes the forward-mode (Jacobian-vector) product for this
+/// timestep. Given a perturbation of the pre-step positions, velocities and
+/// control forces, it returns the resulting perturbation of the post-step
+/// positions and velocities.
+void BackpropSnapshot::jvp(
+    simulation::WorldPtr world,
+    const Eigen::VectorXs& dPos,
+    const Eigen::VectorXs& dVel,
+    const Eigen::VectorXs& dForce,
+    Eigen::VectorXs& dNextPos,
+    Eigen::VectorXs& dNextVel,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("BackpropSnapshot.jvp");
+  }
+#endif
+
+  RestorableSnapshot snapshot(world);
+  ScopedTimeStep timeStep(world, mTimeStep);
+  world->setPositions(mPreStepPosition);
+  world->setVelocities(mPreStepVelocity);
+  world->setControlForces(mPreStepTorques);
+  world->setCachedLCPSolution(mPreStepLCPCache);
+
+  // The cached jvp factors assume an explicit spring and damper update
+  if (mUseFDOverride || mImplicitSpringDamping)
+  {
+    dNextPos = getPosPosJacobian(world, thisLog) * dPos
+               + getVelPosJacobian(world, thisLog) * dVel;
+    dNextVel = getPosVelJacobian(world, thisLog) * dPos
+               + getVelVelJacobian(world, thisLog) * dVel
+               + getControlForceVelJacobian(world, thisLog) * dForce;
+    snapshot.restore();
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+    if (thisLog != nullptr)
+    {
+      thisLog->end();
+    }
+#endif
+    return;
+  }
+
+  refreshJvpCache(world);
+
+  s_t dt = world->getTimeStep();
+  const math::BlockDiagonalMatrix& Minv = mCachedJvpInvMass;
+  const Eigen::MatrixXs& dC = getJacobianOfC(world, WithRespectTo::VELOCITY);
+  Eigen::VectorXs ddamp = getDampingVector(world);
+  Eigen::VectorXs spring_stiffs = getSpringStiffVector(world);
+
+  // This is the perturbation of the velocity before the LCP runs
+  dNextVel = dVel
+             + dt
+                   * (Minv
+                      * (dForce - dC * dVel - ddamp.cwiseProduct(dVel)
+                         - dt * spring_stiffs.cwiseProduct(dVel)));
+
+  // The clamping constraint forces respond to the perturbation of the
+  // pre-LCP relative velocities
+  if (mCachedJvpClamping.cols() > 0)
+  {
+    Eigen::VectorXs dB = mCachedJvpBounceDiagonals.cwiseProduct(
+        -(mCachedJvpClamping.transpose() * dNextVel));
+    Eigen::VectorXs dF_c = mCachedJvpQFactor.solve(dB);
+    dNextVel += mCachedJvpMassedClampingUpperBound * dF_c;
+  }
+
+  if (dPos.isZero())
+  {
+    dNextPos = getVelPosJacobian(world, thisLog) * dVel;
+  }
+  else
+  {
+    dNextPos = getPosPosJacobian(world, thisLog) * dPos
+               + getVelPosJacobian(world, thisLog) * dVel;
+    dNextVel += getPosVelJacobian(world, thisLog) * dPos;
+  }
+
+  snapshot.restore();
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This computes jvp() in the high-level RL API's space, and is equivalent to
+/// `getStateJacobian(world) * dState + getActionJacobian(world) * dAction`.
+Eigen::VectorXs BackpropSnapshot::jvpState(
+    simulation::WorldPtr world,
+    const Eigen::VectorXs& dState,
+    const Eigen::VectorXs& dAction,
+    PerformanceLog* perfLog)
+{
+  int dofs = world->getNumDofs();
+  Eigen::VectorXs dForce = Eigen::VectorXs::Zero(dofs);
+  std::vector<int> actionMapping = world->getActionSpace();
+  for (int i = 0; i < actionMapping.size(); i++)
+  {
+    if (actionMapping[i] < 0 || actionMapping[i] >= dofs)
+    {
+      std::cerr << "neural::BackpropSnapshot::jvpState() discovered an "
+                   "out-of-bounds element in the action state mapping. Element "
+                << i << " -> " << actionMapping[i] << " is out of bounds [0,"
+                << dofs << "). Ignoring." << std::endl;
+      continue;
+    }
+    dForce(actionMapping[i]) += dAction(i);
+  }
+
+  Eigen::VectorXs dNextPos;
+  Eigen::VectorXs dNextVel;
+  jvp(world,
+      dState.head(dofs),
+      dState.tail(dofs),
+      dForce,
+      dNextPos,
+      dNextVel,
+      perfLog);
+
+  Eigen::VectorXs dNextState(dofs * 2);
+  dNextState.head(dofs) = dNextPos;
+  dNextState.tail(dofs) = dNextVel;
+  return dNextState;
+}
+
+//==============================================================================
+/// This fills in the mCachedJvp* values, if they're dirty
+void BackpropSnapshot::refreshJvpCache(simulation::WorldPtr world)
+{
+  if (!mCachedJvpDirty)
+  {
+    return;
+  }
+
+  mCachedJvpInvMass = getBlockInvMassMatrix(world);
+  mCachedJvpClamping = getClampingConstraintMatrix(world);
+  if (mCachedJvpClamping.cols() > 0)
+  {
+    Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
+    Eigen::MatrixXs E = getUpperBoundMappingMatrix();
+    mCachedJvpMassedClampingUpperBound
+        = mCachedJvpInvMass * (mCachedJvpClamping + A_ub * E);
+    Eigen::MatrixXs Q
+        = mCachedJvpClamping.transpose() * mCachedJvpMassedClampingUpperBound;
+    Q.diagonal() += getConstraintForceMixingDiagonal();
+    mCachedJvpQFactor.compute(Q);
+    mCachedJvpBounceDiagonals = getBounceDiagonals();
+  }
+
+  mCachedJvpDirty = false;
+  noteCacheFilled();
+}
+
+//==============================================================================
+/// This puts this snapshot's cached Jacobians under a memory budget shared
+/// with other snapshots. When the budget overflows, the least recently used
+/// snapshots drop their caches and recompute them on demand. Pass nullptr to
+/// go back to caching everything forever (the default).
+void BackpropSnapshot::setJacobianCacheBudget(
+    std::shared_ptr<JacobianCacheBudget> budget)
+{
+  if (mJacobianCacheBudget == budget)
+  {
+    return;
+  }
+  if (mJacobianCacheBudget)
+  {
+    mJacobianCacheBudget->remove(this);
+  }
+  mJacobianCacheBudget = budget;
+  noteCacheFilled();
+}
+
+//==============================================================================
+/// This returns the number of bytes held by the cached Jacobians (and the
+/// cached jvp() factorization) right now.
+std::size_t BackpropSnapshot::getCachedJacobianBytes() const
+{
+  std::size_t entries = mCachedPosPos.size() + mCachedPosVel.size()
+                        + mCachedBounceApproximation.size()
+                        + mCachedVelPos.size() + mCachedVelVel.size()
+                        + mCachedForcePos.size() + mCachedForceVel.size()
+                        + mCachedForceVelCols.size()
+                        + mCachedMassVel.size() + mCachedPosC.size()
+                        + mCachedVelC.size();
+  for (int i = 0; i < mCachedJvpInvMass.getNumBlocks(); i++)
+  {
+    entries += mCachedJvpInvMass.getBlock(i).size();
+  }
+  entries += mCachedJvpClamping.size()
+             + mCachedJvpMassedClampingUpperBound.size()
+             + mCachedJvpBounceDiagonals.size();
+  // The factorization only gets computed when there's something clamping
+  if (!mCachedJvpDirty && mCachedJvpClamping.cols() > 0)
+  {
+    entries += mCachedJvpQFactor.matrixQTZ().size()
+               + mCachedJvpQFactor.hCoeffs().size()
+               + mCachedJvpQFactor.zCoeffs().size();
+  }
+  return entries * sizeof(s_t);
+}
+
+//==============================================================================
+/// This frees all the cached Jacobians. They're recomputed if they're ever
+/// asked for again, so this is safe to call once a backwards pass is done
+/// with this snapshot, to keep long trajectories from holding on to all
+/// their Jacobians at once. Any references returned from the Jacobian
+/// getters are invalid after this.
+void BackpropSnapshot::releaseCachedJacobians()
+{
+  freeCachedJacobians();
+  if (mJacobianCacheBudget)
+  {
+    mJacobianCacheBudget->remove(this);
+  }
+}
+
+//==============================================================================
+/// This frees the cached matrices and marks them all dirty, without telling
+/// the budget (which calls this itself when it evicts us).
+void BackpropSnapshot::freeCachedJacobians()
+{
+  // Assigning empty matrices (rather than resizing) actually hands the memory
+  // back
+  mCachedPosPos = Eigen::MatrixXs();
+  mCachedPosVel = Eigen::MatrixXs();
+  mCachedBounceApproximation = Eigen::MatrixXs();
+  mCachedVelPos = Eigen::MatrixXs();
+  mCachedVelVel = Eigen::MatrixXs();
+  mCachedForcePos = Eigen::MatrixXs();
+  mCachedForceVel = Eigen::MatrixXs();
+  mCachedForceVelCols = Eigen::MatrixXs();
+  mCachedMassVel = Eigen::MatrixXs();
+  mCachedPosC = Eigen::MatrixXs();
+  mCachedVelC = Eigen::MatrixXs();
+  mCachedJvpInvMass = math::BlockDiagonalMatrix();
+  mCachedJvpClamping = Eigen::MatrixXs();
+  mCachedJvpMassedClampingUpperBound = Eigen::MatrixXs();
+  mCachedJvpBounceDiagonals = Eigen::VectorXs();
+  mCachedJvpQFactor = Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>();
+
+  mCachedPosPosDirty = true;
+  mCachedPosVelDirty = true;
+  mCachedBounceApproximationDirty = true;
+  mCachedVelPosDirty = true;
+  mCachedVelVelDirty = true;
+  mCachedForcePosDirty = true;
+  mCachedForceVelDirty = true;
+  mCachedForceVelColsDirty = true;
+  mCachedMassVelDirty = true;
+  mCachedPosCDirty = true;
+  mCachedVelCDirty = true;
+  mCachedJvpDirty = true;
+}
+
+//==============================================================================
+/// This gets called after we fill in any of the caches, to report our new
+/// size to the budget (if there is one).
+void BackpropSnapshot::noteCacheFilled()
+{
+  if (mJacobianCacheBudget)
+  {
+    mJacobianCacheBudget->touch(this, getCachedJacobianBytes());
+  }
+}
+
 //==============================================================================
 const Eigen::MatrixXs& BackpropSnapshot::getPosPosJacobian(
     WorldPtr world, PerformanceLog* perfLog)
@@ -1302,7 +1905,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getPosPosJacobian(
       world->setCachedLCPSolution(mPreStepLCPCache);
       */
 
-      mCachedPosPos = world->getPosPosJacobian()
+      mCachedPosPos = world->getBlockPosPosJacobian()
                       * getBounceApproximationJacobian(world, thisLog);
 
       // snapshot.restore();
@@ -1317,6 +1920,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getPosPosJacobian(
     }
 
     mCachedPosPosDirty = false;
+    noteCacheFilled();
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (refreshLog != nullptr)
     {
@@ -1369,7 +1973,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelPosJacobian(
     }
     else
     {
-      mCachedVelPos = world->getVelPosJacobian()
+      mCachedVelPos = world->getBlockVelPosJacobian()
                       * getBounceApproximationJacobian(world, thisLog);
     }
 
@@ -1382,6 +1986,7 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelPosJacobian(
     }
 
     mCachedVelPosDirty = false;
+    noteCacheFilled();
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (refreshLog != nullptr)
     {
@@ -1522,14 +2127,22 @@ Eigen::MatrixXs BackpropSnapshot::getMassMatrix(
     WorldPtr world, bool forFiniteDifferencing)
 {
   return assembleBlockDiagonalMatrix(
-      world,
-      BackpropSnapshot::BlockDiagonalMatrixToAssemble::MASS,
-      forFiniteDifferencing);
+             world,
+             BackpropSnapshot::BlockDiagonalMatrixToAssemble::MASS,
+             forFiniteDifferencing)
+      .toDense();
 }
 
 //==============================================================================
 Eigen::MatrixXs BackpropSnapshot::getInvMassMatrix(
     WorldPtr world, bool forFiniteDifferencing)
+{
+  return getBlockInvMassMatrix(world, forFiniteDifferencing).toDense();
+}
+
+//==============================================================================
+math::BlockDiagonalMatrix BackpropSnapshot::getBlockInvMassMatrix(
+    WorldPtr world, bool forFiniteDifferencing)
 {
   return assembleBlockDiagonalMatrix(
       world,
@@ -1588,7 +2201,8 @@ Eigen::MatrixXs BackpropSnapshot::getClampingAMatrix()
 Eigen::MatrixXs BackpropSnapshot::getPosCJacobian(simulation::WorldPtr world)
 {
   return assembleBlockDiagonalMatrix(
-      world, BackpropSnapshot::BlockDiagonalMatrixToAssemble::POS_C);
+             world, BackpropSnapshot::BlockDiagonalMatrixToAssemble::POS_C)
+      .toDense();
 }
 
 //==============================================================================
@@ -2651,8 +3265,8 @@ Eigen::MatrixXs BackpropSnapshot::getProjectionIntoClampsMatrix(
         = getUpperBoundConstraintMatrixAt(world, world->getPositions());
     Eigen::MatrixXs E
         = getUpperBoundMappingMatrixAt(world, world->getPositions());
-    Eigen::MatrixXs Minv = getInvMassMatrix(world, true);
-    constraintForceToImpliedTorques = Minv * (A_c + (A_ub * E));
+    constraintForceToImpliedTorques
+        = MassMatrixOperator(world).multiplyByInverse(A_c + (A_ub * E));
 
     Eigen::MatrixXs forceToVel
         = A_c.eval().transpose() * constraintForceToImpliedTorques;
@@ -2688,17 +3302,7 @@ Eigen::MatrixXs BackpropSnapshot::getProjectionIntoClampsMatrix(
 Eigen::VectorXs BackpropSnapshot::implicitMultiplyByMassMatrix(
     simulation::WorldPtr world, const Eigen::VectorXs& x)
 {
-  Eigen::VectorXs result = x;
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
-  {
-    SkeletonPtr skel = world->getSkeleton(i);
-    std::size_t dofs = skel->getNumDofs();
-    result.segment(cursor, dofs)
-        = skel->multiplyByImplicitMassMatrix(x.segment(cursor, dofs));
-    cursor += dofs;
-  }
-  return result;
+  return MassMatrixOperator(world).multiply(x);
 }
 
 /// This return the result of Minv*x, without explicitly
@@ -2706,17 +3310,7 @@ Eigen::VectorXs BackpropSnapshot::implicitMultiplyByMassMatrix(
 Eigen::VectorXs BackpropSnapshot::implicitMultiplyByInvMassMatrix(
     simulation::WorldPtr world, const Eigen::VectorXs& x)
 {
-  Eigen::VectorXs result = x;
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
-  {
-    SkeletonPtr skel = world->getSkeleton(i);
-    std::size_t dofs = skel->getNumDofs();
-    result.segment(cursor, dofs)
-        = skel->multiplyByImplicitInvMassMatrix(x.segment(cursor, dofs));
-    cursor += dofs;
-  }
-  return result;
+  return MassMatrixOperator(world).multiplyByInverse(x);
 }
 
 //==============================================================================
@@ -2736,8 +3330,6 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfConstraintForce(
     int wrtDim = wrt->dim(world.get());
     return Eigen::MatrixXs::Zero(0, wrtDim);
   }
-  Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
-  Eigen::MatrixXs E = getUpperBoundMappingMatrix();
 
   /*
   RestorableSnapshot snapshot(world);
@@ -2747,13 +3339,11 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfConstraintForce(
   world->setCachedLCPSolution(mPreStepLCPCache);
   */
 
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
-  Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
-  Eigen::MatrixXs Q = A_c.transpose() * Minv * A_c_ub_E;
-  Q.diagonal() += getConstraintForceMixingDiagonal();
-
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfac
-      = Q.completeOrthogonalDecomposition();
+  // This is the same factorization of Q that jvp() uses, so every Jacobian on
+  // this snapshot shares a single factorization
+  refreshJvpCache(world);
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>& Qfac
+      = mCachedJvpQFactor;
 
   Eigen::MatrixXs dB = getJacobianOfLCPOffsetClampingSubset(world, wrt);
 
@@ -2919,11 +3509,14 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
   Eigen::MatrixXs E = getUpperBoundMappingMatrix();
   Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
-  Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
+  // The jvp() cache already has Minv in block diagonal form, and Minv times
+  // the clamping columns, so we never need to form the dense Minv here
+  refreshJvpCache(world);
+  const math::BlockDiagonalMatrix& Minv = mCachedJvpInvMass;
+  Eigen::MatrixXs Q = A_c.transpose() * mCachedJvpMassedClampingUpperBound;
   Q.diagonal() += getConstraintForceMixingDiagonal();
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfactored
-      = Q.completeOrthogonalDecomposition();
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>& Qfactored
+      = mCachedJvpQFactor;
 
   Eigen::VectorXs Qinv_b = Qfactored.solve(b);
 
@@ -2940,7 +3533,8 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
     {
 
 #define dQ(rhs)                                                                \
-  (getJacobianOfClampingConstraintsTranspose(world, Minv * A_c_ub_E * rhs)     \
+  (getJacobianOfClampingConstraintsTranspose(                                  \
+       world, mCachedJvpMassedClampingUpperBound * rhs)                        \
    + (A_c.transpose()                                                          \
       * (getJacobianOfMinv(world, A_c_ub_E * rhs, wrt)                         \
          + (Minv                                                               \
@@ -2948,12 +3542,13 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
                + getJacobianOfUpperBoundConstraints(world, E * rhs))))))
 
 #define dQT(rhs)                                                               \
-  ((getJacobianOfClampingConstraintsTranspose(world, Minv * A_c * rhs)         \
+  ((getJacobianOfClampingConstraintsTranspose(world, Minv * (A_c * rhs))       \
     + (A_c.transpose()                                                         \
        * (getJacobianOfMinv(world, A_c * rhs, wrt)                             \
           + (Minv * (getJacobianOfClampingConstraints(world, rhs))))))         \
    + (E.transpose()                                                            \
-      * (getJacobianOfUpperBoundConstraintsTranspose(world, Minv * A_c * rhs)  \
+      * (getJacobianOfUpperBoundConstraintsTranspose(                          \
+             world, Minv * (A_c * rhs))                                        \
          + A_ub.transpose()                                                    \
                * (getJacobianOfMinv(world, A_c * rhs, wrt)                     \
                   + (Minv                                                      \
@@ -2992,7 +3587,8 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
       // A_ub = 0 here
 
 #define dQ(rhs)                                                                \
-  (getJacobianOfClampingConstraintsTranspose(world, Minv * A_c * rhs)          \
+  (getJacobianOfClampingConstraintsTranspose(                                  \
+       world, mCachedJvpMassedClampingUpperBound * rhs)                        \
    + (A_c.transpose()                                                          \
       * (getJacobianOfMinv(world, A_c * rhs, wrt)                              \
          + (Minv * (getJacobianOfClampingConstraints(world, rhs))))))
@@ -3097,7 +3693,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfLCPOffsetClampingSubset(
   */
 
   s_t dt = world->getTimeStep();
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
+  math::BlockDiagonalMatrix Minv = getBlockInvMassMatrix(world);
   Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
   Eigen::MatrixXs dC = getJacobianOfC(world, wrt);
   Eigen::MatrixXs ddamp = getDampingVector(world).asDiagonal();
@@ -3109,7 +3705,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfLCPOffsetClampingSubset(
     return getBounceDiagonals().asDiagonal() * -A_c.transpose()
            * (Eigen::MatrixXs::Identity(
                   world->getNumDofs(), world->getNumDofs())
-              - dt * Minv * (dC + ddamp + dt * spring_stiffs));
+              - dt * (Minv * (dC + ddamp + dt * spring_stiffs)));
   }
   else if (wrt == WithRespectTo::FORCE)
   {
@@ -3230,21 +3826,16 @@ void BackpropSnapshot::computeLCPConstraintMatrixClampingSubset(
     const Eigen::MatrixXs& A_ub,
     const Eigen::MatrixXs& E)
 {
-  /*
-  int numClamping = A_c.cols();
-  for (int i = 0; i < numClamping; i++)
-  {
-    Q.col(i)
-        = A_c.transpose() * implicitMultiplyByInvMassMatrix(world, A_c.col(i));
-  }
-  */
+  // Q only has one column per clamping constraint, so it's much cheaper to
+  // push those columns through Minv implicitly than to form Minv
+  MassMatrixOperator Minv(world);
   if (A_ub.cols() > 0)
   {
-    Q = A_c.transpose() * getInvMassMatrix(world, true) * (A_c + A_ub * E);
+    Q = A_c.transpose() * Minv.multiplyByInverse(A_c + A_ub * E);
   }
   else
   {
-    Q = A_c.transpose() * getInvMassMatrix(world, true) * A_c;
+    Q = A_c.transpose() * Minv.multiplyByInverse(A_c);
   }
   Q.diagonal() += getConstraintForceMixingDiagonal();
 }
@@ -3439,6 +4030,26 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfMinv(
 
     return jac;
   }
+  else if (dynamic_cast<WithRespectToMass*>(wrt) != nullptr)
+  {
+    // Each skeleton's inertia only moves its own dofs, so the analytic
+    // per-skeleton blocks sit along the diagonal
+    Eigen::MatrixXs jac
+        = Eigen::MatrixXs::Zero(world->getNumDofs(), wrt->dim(world.get()));
+    int dofCursor = 0;
+    int wrtCursor = 0;
+    for (int i = 0; i < world->getNumSkeletons(); i++)
+    {
+      auto skel = world->getSkeleton(i);
+      int dofs = skel->getNumDofs();
+      int wrts = wrt->dim(skel.get());
+      jac.block(dofCursor, wrtCursor, dofs, wrts)
+          = skel->getJacobianOfMinv(tau.segment(dofCursor, dofs), wrt);
+      dofCursor += dofs;
+      wrtCursor += wrts;
+    }
+    return jac;
+  }
   else
   {
     return finiteDifferenceJacobianOfMinv(world, tau, wrt);
@@ -3463,6 +4074,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfC(
     {
       mCachedPosC = computeJacobianOfC(world, WithRespectTo::POSITION);
       mCachedPosCDirty = false;
+      noteCacheFilled();
     }
     return mCachedPosC;
   }
@@ -3472,6 +4084,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfC(
     {
       mCachedVelC = computeJacobianOfC(world, WithRespectTo::VELOCITY);
       mCachedVelCDirty = false;
+      noteCacheFilled();
     }
     return mCachedVelC;
   }
@@ -3672,7 +4285,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfClampingConstraints(
   assert(constraints.size() == f0.size());
   for (int i = 0; i < constraints.size(); i++)
   {
-    result += f0(i) * constraints[i]->getConstraintForcesJacobian(world);
+    constraints[i]->addScaledConstraintForcesJacobian(world, f0(i), result);
   }
 
   // snapshot.restore();
@@ -3701,7 +4314,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfClampingConstraintsTranspose(
   for (int i = 0; i < constraints.size(); i++)
   {
     result.row(i)
-        = constraints[i]->getConstraintForcesJacobian(world).transpose() * v0;
+        = constraints[i]->multiplyConstraintForcesJacobianTranspose(world, v0);
   }
 
   // snapshot.restore();
@@ -3721,7 +4334,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfUpperBoundConstraints(
   assert(constraints.size() == E_f0.size());
   for (int i = 0; i < constraints.size(); i++)
   {
-    result += E_f0(i) * constraints[i]->getConstraintForcesJacobian(world);
+    constraints[i]->addScaledConstraintForcesJacobian(world, E_f0(i), result);
   }
   return result;
 }
@@ -3740,7 +4353,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfUpperBoundConstraintsTranspose(
   for (int i = 0; i < constraints.size(); i++)
   {
     result.row(i)
-        = constraints[i]->getConstraintForcesJacobian(world).transpose() * v0;
+        = constraints[i]->multiplyConstraintForcesJacobianTranspose(world, v0);
   }
 
   return result;
@@ -4279,12 +4892,12 @@ Eigen::MatrixXs BackpropSnapshot::assembleMatrix(
   return matrix;
 }
 
-Eigen::MatrixXs BackpropSnapshot::assembleBlockDiagonalMatrix(
+math::BlockDiagonalMatrix BackpropSnapshot::assembleBlockDiagonalMatrix(
     simulation::WorldPtr world,
     BackpropSnapshot::BlockDiagonalMatrixToAssemble whichMatrix,
     bool forFiniteDifferencing)
 {
-  Eigen::MatrixXs J = Eigen::MatrixXs::Zero(mNumDOFs, mNumDOFs);
+  math::BlockDiagonalMatrix J;
 
   // If we're not finite differencing, then set the state of the world back to
   // what it was during the forward pass, so that implicit mass matrix
@@ -4298,35 +4911,29 @@ Eigen::MatrixXs BackpropSnapshot::assembleBlockDiagonalMatrix(
     world->setVelocities(mPreStepVelocity);
   }
 
-  std::size_t cursor = 0;
   for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
   {
-    std::size_t skelDOF = world->getSkeleton(i)->getNumDofs();
     if (whichMatrix == BackpropSnapshot::BlockDiagonalMatrixToAssemble::MASS)
     {
-      J.block(cursor, cursor, skelDOF, skelDOF)
-          = world->getSkeleton(i)->getMassMatrix();
+      J.addBlock(world->getSkeleton(i)->getMassMatrix());
     }
     else if (
         whichMatrix
         == BackpropSnapshot::BlockDiagonalMatrixToAssemble::INV_MASS)
     {
-      J.block(cursor, cursor, skelDOF, skelDOF)
-          = world->getSkeleton(i)->getInvMassMatrix();
+      J.addBlock(world->getSkeleton(i)->getInvMassMatrix());
     }
     else if (
         whichMatrix == BackpropSnapshot::BlockDiagonalMatrixToAssemble::POS_C)
     {
-      J.block(cursor, cursor, skelDOF, skelDOF)
-          = world->getSkeleton(i)->getJacobianOfC(WithRespectTo::POSITION);
+      J.addBlock(
+          world->getSkeleton(i)->getJacobianOfC(WithRespectTo::POSITION));
     }
     else if (
         whichMatrix == BackpropSnapshot::BlockDiagonalMatrixToAssemble::VEL_C)
     {
-      J.block(cursor, cursor, skelDOF, skelDOF)
-          = world->getSkeleton(i)->getVelCJacobian();
+      J.addBlock(world->getSkeleton(i)->getVelCJacobian());
     }
-    cursor += skelDOF;
   }
 
   // If we're not finite differencing, reset the position of the world to what
@@ -6,7 +6,10 @@
 
 #include <Eigen/Dense>
 
+#include "dart/math/BlockDiagonalMatrix.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
+#include "dart/neural/JacobianCacheBudget.hpp"
+#include "dart/neural/MassMatrixOperator.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/WithRespectTo.hpp"
@@ -22,6 +25,7 @@ namespace neural {
 class BackpropSnapshot
 {
   friend class MappedBackpropSnapshot;
+  friend class JacobianCacheBudget;
 
 public:
   /// This saves a snapshot from a forward pass, with all the info we need in
@@ -36,6 +40,8 @@ public:
       Eigen::VectorXs preConstraintVelocities,
       Eigen::VectorXs preStepLCPCache);
 
+  ~BackpropSnapshot();
+
   /// This computes the implicit backprop without forming intermediate
   /// Jacobians. It takes a LossGradient with the position and velocity vectors
   /// filled it, though the loss with respect to torque is ignored and can be
@@ -48,6 +54,22 @@ public:
       PerformanceLog* perfLog = nullptr,
       bool exploreAlternateStrategies = false);
 
+  /// This runs backprop() on several losses at once. Each column of
+  /// `nextLossWrtPosition` and `nextLossWrtVelocity` is a separate
+  /// nextTimestepLoss, and the matching columns of the outputs get filled in.
+  /// Every column shares the same cached Jacobians (and the one factorization
+  /// of the clamping LCP behind them), so this is much cheaper than calling
+  /// backprop() once per column.
+  void backpropBatch(
+      simulation::WorldPtr world,
+      const Eigen::MatrixXs& nextLossWrtPosition,
+      const Eigen::MatrixXs& nextLossWrtVelocity,
+      /* OUT */ Eigen::MatrixXs& lossWrtPosition,
+      /* OUT */ Eigen::MatrixXs& lossWrtVelocity,
+      /* OUT */ Eigen::MatrixXs& lossWrtTorque,
+      /* OUT */ Eigen::MatrixXs& lossWrtMass,
+      PerformanceLog* perfLog = nullptr);
+
   /// This computes backprop in the high-level RL API's space, use `state` and
   /// `action` as the primitives we're taking gradients wrt to.
   LossGradientHighLevelAPI backpropState(
@@ -82,6 +104,16 @@ public:
   const Eigen::MatrixXs& getControlForceVelJacobian(
       simulation::WorldPtr world, PerformanceLog* perfLog = nullptr);
 
+  /// This returns just the columns of getControlForceVelJacobian() for the
+  /// control forces in `dofs` (usually World::getActionSpace()), without
+  /// computing the columns for the other DOFs. For an under-actuated robot
+  /// this is much cheaper than the whole Jacobian. If the whole Jacobian is
+  /// already cached, this just copies the columns out of it.
+  const Eigen::MatrixXs& getControlForceVelJacobianCols(
+      simulation::WorldPtr world,
+      const std::vector<int>& dofs,
+      PerformanceLog* perfLog = nullptr);
+
   /// This computes and returns the whole mass-vel jacobian. For backprop, you
   /// don't actually need this matrix, you can compute backprop directly. This
   /// is here if you want access to the full Jacobian for some reason.
@@ -113,6 +145,32 @@ public:
   /// This returns the Jacobian for action_t -> state_{t+1}.
   Eigen::MatrixXs getActionJacobian(simulation::WorldPtr world);
 
+  /// This computes the forward-mode (Jacobian-vector) product for this
+  /// timestep. Given a perturbation of the pre-step positions, velocities and
+  /// control forces, it returns the resulting perturbation of the post-step
+  /// positions and velocities. The velocity and force terms are pushed through
+  /// a cached factorization of the clamping LCP, so this never forms the
+  /// vel-vel or force-vel Jacobians. The position terms still go through the
+  /// cached pos-pos, pos-vel and vel-pos Jacobians, and are skipped if `dPos`
+  /// is zero.
+  void jvp(
+      simulation::WorldPtr world,
+      const Eigen::VectorXs& dPos,
+      const Eigen::VectorXs& dVel,
+      const Eigen::VectorXs& dForce,
+      Eigen::VectorXs& dNextPos,
+      Eigen::VectorXs& dNextVel,
+      PerformanceLog* perfLog = nullptr);
+
+  /// This computes jvp() in the high-level RL API's space, and is equivalent
+  /// to `getStateJacobian(world) * dState + getActionJacobian(world) *
+  /// dAction`.
+  Eigen::VectorXs jvpState(
+      simulation::WorldPtr world,
+      const Eigen::VectorXs& dState,
+      const Eigen::VectorXs& dAction,
+      PerformanceLog* perfLog = nullptr);
+
   /// Returns a concatenated vector of all the Skeletons' position()'s in the
   /// World, in order in which the Skeletons appear in the World's
   /// getSkeleton(i) returns them, BEFORE the timestep.
@@ -189,6 +247,11 @@ public:
   Eigen::MatrixXs getInvMassMatrix(
       simulation::WorldPtr world, bool forFiniteDifferencing = false);
 
+  /// This is the same as getInvMassMatrix(), but it keeps each skeleton's
+  /// block separate, so products against it skip the off-diagonal zeros.
+  math::BlockDiagonalMatrix getBlockInvMassMatrix(
+      simulation::WorldPtr world, bool forFiniteDifferencing = false);
+
   /// This return the diagonal matrix representing Coefficients of damping
   Eigen::VectorXs getDampingVector(simulation::WorldPtr world);
 
@@ -295,6 +358,13 @@ public:
   Eigen::MatrixXs getVelJacobianWrt(
       simulation::WorldPtr world, WithRespectTo* wrt);
 
+  /// When the step treated joint springs and damping implicitly, the velocity
+  /// before the LCP is v + (M + H)^-1 M (v_explicit - v) instead of
+  /// v_explicit. This returns what that adds to the next-velocity Jacobian wrt
+  /// `wrt`, on top of the explicit one that getVelJacobianWrt() computes.
+  Eigen::MatrixXs getImplicitSpringDampingCorrection(
+      simulation::WorldPtr world, WithRespectTo* wrt);
+
   /// This computes and returns the whole wrt-pos jacobian. For backprop, you
   /// don't actually need this matrix, you can compute backprop directly. This
   /// is here if you want access to the full Jacobian for some reason.
@@ -652,6 +722,23 @@ public:
   void benchmarkJacobians(
       std::shared_ptr<simulation::World> world, int numSamples);
 
+  /// This puts this snapshot's cached Jacobians under a memory budget shared
+  /// with other snapshots. When the budget overflows, the least recently used
+  /// snapshots drop their caches and recompute them on demand. Pass nullptr to
+  /// go back to caching everything forever (the default).
+  void setJacobianCacheBudget(std::shared_ptr<JacobianCacheBudget> budget);
+
+  /// This returns the number of bytes held by the cached Jacobians (and the
+  /// cached jvp() factorization) right now.
+  std::size_t getCachedJacobianBytes() const;
+
+  /// This frees all the cached Jacobians. They're recomputed if they're ever
+  /// asked for again, so this is safe to call once a backwards pass is done
+  /// with this snapshot, to keep long trajectories from holding on to all
+  /// their Jacobians at once. Any references returned from the Jacobian
+  /// getters are invalid after this.
+  void releaseCachedJacobians();
+
 protected:
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
@@ -664,6 +751,11 @@ protected:
   /// instructions.
   bool mSlowDebugResultsAgainstFD;
 
+  /// This is true if the step integrated joint springs and damping implicitly
+  /// (see World::setImplicitSpringDamping()), so the Jacobians need
+  /// getImplicitSpringDampingCorrection() on top of the explicit ones.
+  bool mImplicitSpringDamping;
+
   /// This is the global timestep length. This is included here because it shows
   /// up as a constant in some of the matrices.
   s_t mTimeStep;
@@ -732,6 +824,9 @@ private:
   Eigen::MatrixXs mCachedForcePos;
   bool mCachedForceVelDirty;
   Eigen::MatrixXs mCachedForceVel;
+  bool mCachedForceVelColsDirty;
+  std::vector<int> mCachedForceVelColsDofs;
+  Eigen::MatrixXs mCachedForceVelCols;
   bool mCachedMassVelDirty;
   Eigen::MatrixXs mCachedMassVel;
   bool mCachedPosCDirty;
@@ -739,6 +834,31 @@ private:
   bool mCachedVelCDirty;
   Eigen::MatrixXs mCachedVelC;
 
+  /// These are the pieces of the clamping LCP that jvp() reuses across calls.
+  /// The analytical Jacobians share mCachedJvpQFactor too, so a snapshot only
+  /// ever factors Q once.
+  bool mCachedJvpDirty;
+  math::BlockDiagonalMatrix mCachedJvpInvMass;
+  Eigen::MatrixXs mCachedJvpClamping;
+  Eigen::MatrixXs mCachedJvpMassedClampingUpperBound;
+  Eigen::VectorXs mCachedJvpBounceDiagonals;
+  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> mCachedJvpQFactor;
+
+  /// This fills in the mCachedJvp* values, if they're dirty
+  void refreshJvpCache(simulation::WorldPtr world);
+
+  /// If we're on a memory budget, these are the other snapshots we share it
+  /// with
+  std::shared_ptr<JacobianCacheBudget> mJacobianCacheBudget;
+
+  /// This frees the cached matrices and marks them all dirty, without telling
+  /// the budget (which calls this itself when it evicts us).
+  void freeCachedJacobians();
+
+  /// This gets called after we fill in any of the caches, to report our new
+  /// size to the budget (if there is one).
+  void noteCacheFilled();
+
   Eigen::VectorXs scratch(simulation::WorldPtr world);
 
   enum MatrixToAssemble
@@ -761,7 +881,7 @@ private:
     VEL_C
   };
 
-  Eigen::MatrixXs assembleBlockDiagonalMatrix(
+  math::BlockDiagonalMatrix assembleBlockDiagonalMatrix(
       simulation::WorldPtr world,
       BlockDiagonalMatrixToAssemble whichMatrix,
       bool forFiniteDifferencing = false);
@@ -30,7 +30,9 @@ namespace neural {
 //==============================================================================
 ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
     constraint::ConstrainedGroup& group, s_t timeStep)
-  : mFinalized(false), mDeliberatelyIgnoreFriction(false)
+  : mFinalized(false),
+    mDeliberatelyIgnoreFriction(false),
+    mCachedQFactorDirty(true)
 {
   mTimeStep = timeStep;
   assert(mClampingConstraints.size() == 0);
@@ -69,7 +71,6 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
   mMassedImpulseTests.reserve(mNumConstraintDim);
 
   // Cache an inverse mass matrix for later use
-  mMinv = Eigen::MatrixXs::Zero(mNumDOFs, mNumDOFs);
   mPreStepTorques = Eigen::VectorXs::Zero(mNumDOFs);
   mPreStepVelocities = Eigen::VectorXs::Zero(mNumDOFs);
   mPreLCPVelocities = Eigen::VectorXs::Zero(mNumDOFs);
@@ -78,7 +79,7 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
   for (auto skel : skeletons)
   {
     int dofs = skel->getNumDofs();
-    mMinv.block(cursor, cursor, dofs, dofs) = skel->getInvMassMatrix();
+    mMinv.addBlock(skel->getInvMassMatrix());
     mPreStepTorques.segment(cursor, dofs) = skel->getControlForces();
     mPreLCPVelocities.segment(cursor, dofs) = skel->getVelocities();
     mPreStepVelocities.segment(cursor, dofs)
@@ -94,6 +95,7 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
 //==============================================================================
 ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
     int numDofs, int numConstraintDim, s_t timeStep)
+  : mCachedQFactorDirty(true)
 {
   mNumDOFs = numDofs;
   mNumConstraintDim = numConstraintDim;
@@ -194,6 +196,7 @@ void ConstrainedGroupGradientMatrices::registerLCPResults(
   mA = A;
   mConstraintForceMixingConstant = constraintForceMixingConstant;
   mDeliberatelyIgnoreFriction = deliberatelyIgnoreFriction;
+  mCachedQFactorDirty = true;
 }
 
 //==============================================================================
@@ -246,7 +249,7 @@ bool ConstrainedGroupGradientMatrices::opportunisticallyStandardizeResults(
   const Eigen::MatrixXs& E = getUpperBoundMappingMatrix();
   Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXs Q = A_c.transpose() * mMinv * A_c_ub_E;
+  Eigen::MatrixXs Q = A_c.transpose() * (mMinv * A_c_ub_E);
   Q.diagonal() += getConstraintForceMixingDiagonal();
   Eigen::VectorXs b = getClampingConstraintRelativeVels();
 
@@ -491,6 +494,8 @@ void ConstrainedGroupGradientMatrices::constructMatrices(
   // deduplicateConstraints();
 
   mContactConstraintMappings = mFIndex;
+  // The clamping set is about to change, so Q will too
+  mCachedQFactorDirty = true;
   // Group the constraints based on their solution values into three buckets:
   //
   // - "Clamping": These are constraints that have non-zero constraint forces
@@ -1191,35 +1196,31 @@ Eigen::VectorXs ConstrainedGroupGradientMatrices::getVelocities(WorldPtr world)
 }
 
 //==============================================================================
-Eigen::MatrixXs ConstrainedGroupGradientMatrices::getJointsPosPosJacobian(
+math::BlockDiagonalMatrix
+ConstrainedGroupGradientMatrices::getJointsPosPosJacobian(
     simulation::WorldPtr world)
 {
-  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(mNumDOFs, mNumDOFs);
-  int cursor = 0;
+  math::BlockDiagonalMatrix jac;
   for (std::size_t i = 0; i < mSkeletonNames.size(); i++)
   {
     SkeletonPtr skel = world->getSkeleton(mSkeletonNames[i]);
-    int dofs = skel->getNumDofs();
-    jac.block(cursor, cursor, dofs, dofs) = skel->getPosPosJac(
-        skel->getPositions(), skel->getVelocities(), mTimeStep);
-    cursor += dofs;
+    jac.addBlock(skel->getPosPosJac(
+        skel->getPositions(), skel->getVelocities(), mTimeStep));
   }
   return jac;
 }
 
 //==============================================================================
-Eigen::MatrixXs ConstrainedGroupGradientMatrices::getJointsVelPosJacobian(
+math::BlockDiagonalMatrix
+ConstrainedGroupGradientMatrices::getJointsVelPosJacobian(
     simulation::WorldPtr world)
 {
-  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(mNumDOFs, mNumDOFs);
-  int cursor = 0;
+  math::BlockDiagonalMatrix jac;
   for (std::size_t i = 0; i < mSkeletonNames.size(); i++)
   {
     SkeletonPtr skel = world->getSkeleton(mSkeletonNames[i]);
-    int dofs = skel->getNumDofs();
-    jac.block(cursor, cursor, dofs, dofs) = skel->getVelPosJac(
-        skel->getPositions(), skel->getVelocities(), mTimeStep);
-    cursor += dofs;
+    jac.addBlock(skel->getVelPosJac(
+        skel->getPositions(), skel->getVelocities(), mTimeStep));
   }
   return jac;
 }
@@ -1379,16 +1380,10 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getJacobianOfConstraintForce(
     int wrtDim = wrt->dim(world.get());
     return Eigen::MatrixXs::Zero(0, wrtDim);
   }
-  const Eigen::MatrixXs& A_ub = getUpperBoundConstraintMatrix();
-  const Eigen::MatrixXs& E = getUpperBoundMappingMatrix();
 
   Eigen::MatrixXs Minv = getInvMassMatrix(world);
-  Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
-  Eigen::MatrixXs Q = A_c.transpose() * Minv * A_c_ub_E;
-  Q.diagonal() += getConstraintForceMixingDiagonal();
-
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfac
-      = Q.completeOrthogonalDecomposition();
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>& Qfac
+      = getClampingQFactorization(Minv);
 
   Eigen::MatrixXs dB = getJacobianOfLCPOffsetClampingSubset(world, wrt);
 
@@ -1499,8 +1494,8 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::
   Eigen::MatrixXs Minv = getInvMassMatrix(world);
   Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
   Q.diagonal() += getConstraintForceMixingDiagonal();
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfactored
-      = Q.completeOrthogonalDecomposition();
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>& Qfactored
+      = getClampingQFactorization(Minv);
 
   Eigen::VectorXs Qinv_b = Qfactored.solve(b);
 
@@ -1860,10 +1855,9 @@ ConstrainedGroupGradientMatrices::getJacobianOfUpperBoundConstraintsTranspose(
       = Eigen::MatrixXs::Zero(mUpperBoundConstraints.size(), dofs);
   for (int i = 0; i < mUpperBoundConstraints.size(); i++)
   {
-    result.row(i) = mUpperBoundConstraints[i]
-                        ->getConstraintForcesJacobian(world)
-                        .transpose()
-                    * v0;
+    result.row(i)
+        = mUpperBoundConstraints[i]->multiplyConstraintForcesJacobianTranspose(
+            world, v0);
   }
 
   return result;
@@ -2297,6 +2291,30 @@ const Eigen::MatrixXs& ConstrainedGroupGradientMatrices::getClampingAMatrix()
   return mClampingAMatrix;
 }
 
+//==============================================================================
+/// This returns a factorization of the clamping LCP matrix
+/// Q = A_c^T Minv (A_c + A_ub E) + CFM. It's computed once and shared by
+/// every Jacobian (and every right hand side) on this group, and only gets
+/// refactored if the clamping set changes or Minv doesn't match.
+const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>&
+ConstrainedGroupGradientMatrices::getClampingQFactorization(
+    const Eigen::MatrixXs& Minv)
+{
+  if (mCachedQFactorDirty || mCachedQFactorMinv.rows() != Minv.rows()
+      || mCachedQFactorMinv != Minv)
+  {
+    const Eigen::MatrixXs& A_c = getClampingConstraintMatrix();
+    const Eigen::MatrixXs& A_ub = getUpperBoundConstraintMatrix();
+    const Eigen::MatrixXs& E = getUpperBoundMappingMatrix();
+    Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
+    Q.diagonal() += getConstraintForceMixingDiagonal();
+    mCachedQFactor.compute(Q);
+    mCachedQFactorMinv = Minv;
+    mCachedQFactorDirty = false;
+  }
+  return mCachedQFactor;
+}
+
 //==============================================================================
 const Eigen::VectorXs&
 ConstrainedGroupGradientMatrices::getClampingConstraintImpulses() const
@@ -2346,7 +2364,8 @@ const Eigen::VectorXs& ConstrainedGroupGradientMatrices::getPreLCPVelocity()
 
 //==============================================================================
 /// Returns the M^{-1} matrix from pre-step
-const Eigen::MatrixXs& ConstrainedGroupGradientMatrices::getMinv() const
+const math::BlockDiagonalMatrix& ConstrainedGroupGradientMatrices::getMinv()
+    const
 {
   return mMinv;
 }
@@ -9,6 +9,7 @@
 #include <Eigen/Dense>
 
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/BlockDiagonalMatrix.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -193,11 +194,13 @@ public:
   Eigen::VectorXs getPositions(simulation::WorldPtr world);
   /// This returns the block diagonal matrix where each skeleton's joints
   /// integration scheme is reflected.
-  Eigen::MatrixXs getJointsPosPosJacobian(simulation::WorldPtr world);
+  math::BlockDiagonalMatrix getJointsPosPosJacobian(
+      simulation::WorldPtr world);
 
   /// This returns the block diagonal matrix where each skeleton's joints
   /// integration scheme is reflected.
-  Eigen::MatrixXs getJointsVelPosJacobian(simulation::WorldPtr world);
+  math::BlockDiagonalMatrix getJointsVelPosJacobian(
+      simulation::WorldPtr world);
 
   /// This computes and returns the component of the pos-pos and pos-vel
   /// jacobians due to bounce approximation. For backprop, you don't actually
@@ -377,6 +380,13 @@ public:
   /// to clamping indices.
   const Eigen::MatrixXs& getClampingAMatrix() const;
 
+  /// This returns a factorization of the clamping LCP matrix
+  /// Q = A_c^T Minv (A_c + A_ub E) + CFM. It's computed once and shared by
+  /// every Jacobian (and every right hand side) on this group, and only gets
+  /// refactored if the clamping set changes or Minv doesn't match.
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>&
+  getClampingQFactorization(const Eigen::MatrixXs& Minv);
+
   /// Returns the constraint impulses along the clamping constraints
   const Eigen::VectorXs& getClampingConstraintImpulses() const;
 
@@ -396,7 +406,7 @@ public:
   const Eigen::VectorXs& getPreLCPVelocity() const;
 
   /// Returns the M^{-1} matrix from pre-step
-  const Eigen::MatrixXs& getMinv() const;
+  const math::BlockDiagonalMatrix& getMinv() const;
 
   /// Get the coriolis and gravity forces
   const Eigen::VectorXs getCoriolisAndGravityAndExternalForces(
@@ -521,8 +531,14 @@ public:
   /// to clamping indices.
   Eigen::MatrixXs mClampingAMatrix;
 
+  /// This is the cached result of getClampingQFactorization(), along with the
+  /// Minv it was computed from
+  bool mCachedQFactorDirty;
+  Eigen::MatrixXs mCachedQFactorMinv;
+  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> mCachedQFactor;
+
   /// This is the inverse mass matrix computed in the constuctor
-  Eigen::MatrixXs mMinv;
+  math::BlockDiagonalMatrix mMinv;
 
   /// These are the torques being applied, computed in the constuctor
   Eigen::VectorXs mPreStepTorques;
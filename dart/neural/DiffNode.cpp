@@ -1,5 +1,10 @@
 #include "dart/neural/DiffNode.hpp"
 
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/Mapping.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/World.hpp"
+
 using namespace dart;
 
 namespace dart {
@@ -10,10 +15,214 @@ DiffNode::DiffNode()
 {
 }
 
+//==============================================================================
+/// This creates a node holding `value`, which reads from the nodes at
+/// `inputs` on its tape
+DiffNode::DiffNode(const Eigen::VectorXs& value, std::vector<int> inputs)
+  : mInputs(std::move(inputs)),
+    mValue(value),
+    mGradient(Eigen::VectorXs::Zero(value.size()))
+{
+}
+
 //==============================================================================
 DiffNode::~DiffNode()
 {
 }
 
+//==============================================================================
+/// This returns the tape indices of the nodes that this node reads from
+const std::vector<int>& DiffNode::getInputs() const
+{
+  return mInputs;
+}
+
+//==============================================================================
+/// This returns the size of getValue()
+int DiffNode::getDim() const
+{
+  return mValue.size();
+}
+
+//==============================================================================
+/// This returns the value this node computed when it was recorded
+const Eigen::VectorXs& DiffNode::getValue() const
+{
+  return mValue;
+}
+
+//==============================================================================
+/// This returns the gradient of the tape's loss with respect to getValue(),
+/// as of the last DiffTape::backward()
+const Eigen::VectorXs& DiffNode::getGradient() const
+{
+  return mGradient;
+}
+
+//==============================================================================
+/// This takes getGradient(), and writes the gradient with respect to each
+/// input into `inputGradients`, which has one entry per input, already
+/// sized to match and zeroed.
+void DiffNode::backward(std::vector<Eigen::VectorXs>& /* inputGradients */)
+{
+  // Leaves have no inputs to pass gradient back to
+}
+
+//==============================================================================
+/// Nodes that touch shared state, like the World, return false here, and
+/// DiffTape::backward() never runs them at the same time as another node.
+bool DiffNode::isThreadSafe() const
+{
+  return true;
+}
+
+//==============================================================================
+/// This adds whatever the last backward() found the loss gradient with
+/// respect to the world's masses to be onto `lossWrtMass`. Most nodes don't
+/// depend on mass, so by default this does nothing.
+void DiffNode::accumulateLossWrtMass(
+    /* OUT */ Eigen::Ref<Eigen::VectorXs> /* lossWrtMass */) const
+{
+}
+
+//==============================================================================
+/// This sets `world` to `state` and `force`, and takes a step
+DiffForwardPassNode::DiffForwardPassNode(
+    std::shared_ptr<simulation::World> world,
+    int stateNode,
+    const Eigen::VectorXs& state,
+    int forceNode,
+    const Eigen::VectorXs& force)
+  : mWorld(world)
+{
+  const int dofs = world->getNumDofs();
+  assert(state.size() == 2 * dofs);
+  assert(force.size() == dofs);
+
+  mInputs.push_back(stateNode);
+  mInputs.push_back(forceNode);
+
+  world->setPositions(state.head(dofs));
+  world->setVelocities(state.tail(dofs));
+  world->setControlForces(force);
+  mSnapshot = forwardPass(world);
+
+  mValue = Eigen::VectorXs::Zero(2 * dofs);
+  world->getState(mValue);
+  mGradient = Eigen::VectorXs::Zero(2 * dofs);
+  mLossWrtMass = Eigen::VectorXs::Zero(world->getMassDims());
+}
+
+//==============================================================================
+void DiffForwardPassNode::backward(std::vector<Eigen::VectorXs>& inputGradients)
+{
+  const int dofs = mWorld->getNumDofs();
+
+  LossGradient nextTimestep;
+  nextTimestep.lossWrtPosition = mGradient.head(dofs);
+  nextTimestep.lossWrtVelocity = mGradient.tail(dofs);
+
+  LossGradient thisTimestep;
+  mSnapshot->backprop(mWorld, thisTimestep, nextTimestep);
+
+  inputGradients[0].head(dofs) = thisTimestep.lossWrtPosition;
+  inputGradients[0].tail(dofs) = thisTimestep.lossWrtVelocity;
+  inputGradients[1] = thisTimestep.lossWrtTorque;
+  if (thisTimestep.lossWrtMass.size() == mLossWrtMass.size())
+    mLossWrtMass = thisTimestep.lossWrtMass;
+}
+
+//==============================================================================
+/// The backprop uses the world, so these can't run in parallel
+bool DiffForwardPassNode::isThreadSafe() const
+{
+  return false;
+}
+
+//==============================================================================
+void DiffForwardPassNode::accumulateLossWrtMass(
+    /* OUT */ Eigen::Ref<Eigen::VectorXs> lossWrtMass) const
+{
+  lossWrtMass += mLossWrtMass;
+}
+
+//==============================================================================
+/// This returns the snapshot of the step this node took
+std::shared_ptr<BackpropSnapshot> DiffForwardPassNode::getSnapshot() const
+{
+  return mSnapshot;
+}
+
+//==============================================================================
+/// This sets `world` to `state`, and reads the mapped state off of it
+DiffMappingNode::DiffMappingNode(
+    std::shared_ptr<simulation::World> world,
+    std::shared_ptr<Mapping> mapping,
+    int stateNode,
+    const Eigen::VectorXs& state)
+{
+  const int dofs = world->getNumDofs();
+  assert(state.size() == 2 * dofs);
+
+  mInputs.push_back(stateNode);
+
+  world->setPositions(state.head(dofs));
+  world->setVelocities(state.tail(dofs));
+
+  const int posDim = mapping->getPosDim();
+  const int velDim = mapping->getVelDim();
+  mValue = Eigen::VectorXs::Zero(posDim + velDim);
+  mapping->getPositionsInPlace(world, mValue.head(posDim));
+  mapping->getVelocitiesInPlace(world, mValue.tail(velDim));
+  mGradient = Eigen::VectorXs::Zero(posDim + velDim);
+
+  mPosToMappedPos = mapping->getRealPosToMappedPosJac(world);
+  mPosToMappedVel = mapping->getRealPosToMappedVelJac(world);
+  mVelToMappedPos = mapping->getRealVelToMappedPosJac(world);
+  mVelToMappedVel = mapping->getRealVelToMappedVelJac(world);
+}
+
+//==============================================================================
+void DiffMappingNode::backward(std::vector<Eigen::VectorXs>& inputGradients)
+{
+  const int posDim = mPosToMappedPos.rows();
+  const int velDim = mVelToMappedVel.rows();
+  const int dofs = mPosToMappedPos.cols();
+
+  auto gradPos = mGradient.head(posDim);
+  auto gradVel = mGradient.tail(velDim);
+  inputGradients[0].head(dofs).noalias()
+      = mPosToMappedPos.transpose() * gradPos
+        + mPosToMappedVel.transpose() * gradVel;
+  inputGradients[0].tail(dofs).noalias()
+      = mVelToMappedPos.transpose() * gradPos
+        + mVelToMappedVel.transpose() * gradVel;
+}
+
+//==============================================================================
+DiffLossNode::DiffLossNode(
+    const DiffLossFn& loss,
+    std::vector<int> inputs,
+    const std::vector<Eigen::VectorXs>& inputValues)
+{
+  mInputs = std::move(inputs);
+  for (const Eigen::VectorXs& value : inputValues)
+  {
+    mLossGradients.push_back(Eigen::VectorXs::Zero(value.size()));
+  }
+  mValue = Eigen::VectorXs::Zero(1);
+  mValue(0) = loss(inputValues, mLossGradients);
+  mGradient = Eigen::VectorXs::Zero(1);
+}
+
+//==============================================================================
+void DiffLossNode::backward(std::vector<Eigen::VectorXs>& inputGradients)
+{
+  for (std::size_t i = 0; i < mLossGradients.size(); i++)
+  {
+    inputGradients[i] = mGradient(0) * mLossGradients[i];
+  }
+}
+
 } // namespace neural
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -1,24 +1,163 @@
 #ifndef DART_NEURAL_DIFF_NODE_HPP_
 #define DART_NEURAL_DIFF_NODE_HPP_
 
+#include <functional>
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <Eigen/Dense>
 
+#include "dart/math/MathTypes.hpp"
+
 namespace dart {
 
+namespace simulation {
+class World;
+}
+
 namespace neural {
 
+class BackpropSnapshot;
+class Mapping;
+
+/// This is one node of a DiffTape. It holds the value it computed when it was
+/// recorded, and the gradient of the tape's loss with respect to that value,
+/// which DiffTape::backward() fills in. The storage for both, and for the
+/// gradients this node passes back to its inputs, is allocated once when the
+/// node is recorded and reused on every backward sweep.
+///
+/// A plain DiffNode has no inputs, and is used for the leaves of the tape,
+/// like a starting state or a control force. Subclasses override backward()
+/// to pass their gradient back to their inputs.
 class DiffNode
 {
 public:
   DiffNode();
 
+  /// This creates a node holding `value`, which reads from the nodes at
+  /// `inputs` on its tape
+  DiffNode(const Eigen::VectorXs& value, std::vector<int> inputs = {});
+
   virtual ~DiffNode();
+
+  /// This returns the tape indices of the nodes that this node reads from
+  const std::vector<int>& getInputs() const;
+
+  /// This returns the size of getValue()
+  int getDim() const;
+
+  /// This returns the value this node computed when it was recorded
+  const Eigen::VectorXs& getValue() const;
+
+  /// This returns the gradient of the tape's loss with respect to getValue(),
+  /// as of the last DiffTape::backward()
+  const Eigen::VectorXs& getGradient() const;
+
+  /// This takes getGradient(), and writes the gradient with respect to each
+  /// input into `inputGradients`, which has one entry per input, already
+  /// sized to match and zeroed.
+  virtual void backward(std::vector<Eigen::VectorXs>& inputGradients);
+
+  /// Nodes that touch shared state, like the World, return false here, and
+  /// DiffTape::backward() never runs them at the same time as another node.
+  virtual bool isThreadSafe() const;
+
+  /// This adds whatever the last backward() found the loss gradient with
+  /// respect to the world's masses to be onto `lossWrtMass`. Most nodes don't
+  /// depend on mass, so by default this does nothing.
+  virtual void accumulateLossWrtMass(
+      /* OUT */ Eigen::Ref<Eigen::VectorXs> lossWrtMass) const;
+
+protected:
+  std::vector<int> mInputs;
+  Eigen::VectorXs mValue;
+  Eigen::VectorXs mGradient;
+  /// The scratch that backward() writes into, one entry per input
+  std::vector<Eigen::VectorXs> mInputGradients;
+
+  friend class DiffTape;
+};
+
+/// This steps the world forward by one timestep. It reads from a state node
+/// ([pos, vel], like World::getState()) and a control force node, and its
+/// value is the state after the step. The BackpropSnapshot from the step is
+/// kept, and backward() runs BackpropSnapshot::backprop() on it.
+class DiffForwardPassNode : public DiffNode
+{
+public:
+  /// This sets `world` to `state` and `force`, and takes a step
+  DiffForwardPassNode(
+      std::shared_ptr<simulation::World> world,
+      int stateNode,
+      const Eigen::VectorXs& state,
+      int forceNode,
+      const Eigen::VectorXs& force);
+
+  void backward(std::vector<Eigen::VectorXs>& inputGradients) override;
+
+  /// The backprop uses the world, so these can't run in parallel
+  bool isThreadSafe() const override;
+
+  void accumulateLossWrtMass(
+      /* OUT */ Eigen::Ref<Eigen::VectorXs> lossWrtMass) const override;
+
+  /// This returns the snapshot of the step this node took
+  std::shared_ptr<BackpropSnapshot> getSnapshot() const;
+
+protected:
+  std::shared_ptr<simulation::World> mWorld;
+  std::shared_ptr<BackpropSnapshot> mSnapshot;
+  Eigen::VectorXs mLossWrtMass;
+};
+
+/// This converts a world state node into a Mapping's space. Its value is
+/// [mapped pos, mapped vel]. The mapping's Jacobians are computed when the
+/// node is recorded, so backward() doesn't need the world and is thread-safe.
+class DiffMappingNode : public DiffNode
+{
+public:
+  /// This sets `world` to `state`, and reads the mapped state off of it
+  DiffMappingNode(
+      std::shared_ptr<simulation::World> world,
+      std::shared_ptr<Mapping> mapping,
+      int stateNode,
+      const Eigen::VectorXs& state);
+
+  void backward(std::vector<Eigen::VectorXs>& inputGradients) override;
+
+protected:
+  Eigen::MatrixXs mPosToMappedPos;
+  Eigen::MatrixXs mPosToMappedVel;
+  Eigen::MatrixXs mVelToMappedPos;
+  Eigen::MatrixXs mVelToMappedVel;
+};
+
+/// This is a loss over the values of some nodes. It gets the value of every
+/// input, writes the gradient of the loss with respect to each input into the
+/// (already sized and zeroed) `gradients`, and returns the loss.
+using DiffLossFn = std::function<s_t(
+    const std::vector<Eigen::VectorXs>& inputs,
+    /* OUT */ std::vector<Eigen::VectorXs>& gradients)>;
+
+/// This evaluates a DiffLossFn when it's recorded. Its value is the loss, as a
+/// vector of length 1, and the loss function's gradients are kept so that
+/// backward() is just a scale.
+class DiffLossNode : public DiffNode
+{
+public:
+  DiffLossNode(
+      const DiffLossFn& loss,
+      std::vector<int> inputs,
+      const std::vector<Eigen::VectorXs>& inputValues);
+
+  void backward(std::vector<Eigen::VectorXs>& inputGradients) override;
+
+protected:
+  std::vector<Eigen::VectorXs> mLossGradients;
 };
 
 } // namespace neural
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,262 @@
+#include "dart/neural/DiffTape.hpp"
+
+#include <algorithm>
+#include <future>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/neural/Mapping.hpp"
+#include "dart/simulation/World.hpp"
+
+using namespace dart;
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+DiffTape::DiffTape(std::shared_ptr<simulation::World> world)
+  : mWorld(world),
+    mLossWrtMass(Eigen::VectorXs::Zero(world->getMassDims())),
+    mLevelsDirty(false)
+{
+}
+
+//==============================================================================
+/// This reserves room for `numNodes` nodes, so recording doesn't reallocate
+void DiffTape::reserve(int numNodes)
+{
+  mNodes.reserve(numNodes);
+  mNodeLevels.reserve(numNodes);
+}
+
+//==============================================================================
+/// This drops every node, so the tape can be reused
+void DiffTape::clear()
+{
+  mNodes.clear();
+  mLossNodes.clear();
+  mLevels.clear();
+  mNodeLevels.clear();
+  mLevelsDirty = false;
+}
+
+//==============================================================================
+/// This records a leaf holding `value`, like a control force to optimize
+int DiffTape::addInput(const Eigen::VectorXs& value)
+{
+  return addNode(std::make_shared<DiffNode>(value));
+}
+
+//==============================================================================
+/// This records a leaf holding the world's current state, [pos, vel]
+int DiffTape::addWorldState()
+{
+  return addInput(mWorld->getState());
+}
+
+//==============================================================================
+/// This records a step of the world from the state at `stateNode`, with the
+/// control forces at `forceNode`. The new node's value is the next state.
+int DiffTape::addForwardPass(int stateNode, int forceNode)
+{
+  return addNode(std::make_shared<DiffForwardPassNode>(
+      mWorld, stateNode, getValue(stateNode), forceNode, getValue(forceNode)));
+}
+
+//==============================================================================
+/// This records the state at `stateNode` converted into `mapping`'s space,
+/// as [mapped pos, mapped vel]
+int DiffTape::addMapping(int stateNode, std::shared_ptr<Mapping> mapping)
+{
+  return addNode(std::make_shared<DiffMappingNode>(
+      mWorld, mapping, stateNode, getValue(stateNode)));
+}
+
+//==============================================================================
+/// This records a loss over the values of `inputs`. Every loss on the tape
+/// gets added together into getLoss().
+int DiffTape::addLoss(const std::vector<int>& inputs, const DiffLossFn& loss)
+{
+  std::vector<Eigen::VectorXs> inputValues;
+  inputValues.reserve(inputs.size());
+  for (int input : inputs)
+  {
+    inputValues.push_back(getValue(input));
+  }
+  int index
+      = addNode(std::make_shared<DiffLossNode>(loss, inputs, inputValues));
+  mLossNodes.push_back(index);
+  return index;
+}
+
+//==============================================================================
+/// This records a custom node. Its inputs must already be on the tape.
+int DiffTape::addNode(std::shared_ptr<DiffNode> node)
+{
+  node->mInputGradients.clear();
+  for (int input : node->mInputs)
+  {
+    assert(input >= 0 && input < static_cast<int>(mNodes.size()));
+    node->mInputGradients.push_back(
+        Eigen::VectorXs::Zero(mNodes[input]->getDim()));
+  }
+  if (node->mGradient.size() != node->mValue.size())
+  {
+    node->mGradient = Eigen::VectorXs::Zero(node->mValue.size());
+  }
+  mNodes.push_back(node);
+  mLevelsDirty = true;
+  return mNodes.size() - 1;
+}
+
+//==============================================================================
+/// This returns how many nodes have been recorded
+int DiffTape::getNumNodes() const
+{
+  return mNodes.size();
+}
+
+//==============================================================================
+/// This returns the node at `index`
+std::shared_ptr<DiffNode> DiffTape::getNode(int index) const
+{
+  return mNodes[index];
+}
+
+//==============================================================================
+/// This returns the value of the node at `index`
+const Eigen::VectorXs& DiffTape::getValue(int index) const
+{
+  return mNodes[index]->getValue();
+}
+
+//==============================================================================
+/// This returns the gradient of getLoss() with respect to the value of the
+/// node at `index`, as of the last backward()
+const Eigen::VectorXs& DiffTape::getGradient(int index) const
+{
+  return mNodes[index]->getGradient();
+}
+
+//==============================================================================
+/// This returns the sum of every loss on the tape
+s_t DiffTape::getLoss() const
+{
+  s_t loss = 0.0;
+  for (int index : mLossNodes)
+  {
+    loss += mNodes[index]->getValue()(0);
+  }
+  return loss;
+}
+
+//==============================================================================
+/// This returns the gradient of getLoss() with respect to the world's
+/// masses, as of the last backward()
+const Eigen::VectorXs& DiffTape::getLossWrtMass() const
+{
+  return mLossWrtMass;
+}
+
+//==============================================================================
+/// This computes the gradient of getLoss() with respect to every node on the
+/// tape. If `parallel` is false, every node runs on the calling thread.
+void DiffTape::backward(bool parallel)
+{
+  if (mLevelsDirty)
+  {
+    computeLevels();
+  }
+
+  for (std::shared_ptr<DiffNode>& node : mNodes)
+  {
+    node->mGradient.setZero();
+  }
+  for (int index : mLossNodes)
+  {
+    mNodes[index]->mGradient(0) = 1.0;
+  }
+  if (mLossWrtMass.size() != static_cast<int>(mWorld->getMassDims()))
+  {
+    mLossWrtMass = Eigen::VectorXs::Zero(mWorld->getMassDims());
+  }
+  else
+  {
+    mLossWrtMass.setZero();
+  }
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (const std::vector<int>& level : mLevels)
+  {
+    futures.clear();
+    for (int index : level)
+    {
+      DiffNode* node = mNodes[index].get();
+      // Nodes that no loss depends on have nothing to pass back, which skips
+      // the expensive backprop through steps past the last loss
+      if (node->mInputs.empty() || node->mGradient.isZero(0))
+        continue;
+      for (Eigen::VectorXs& inputGradient : node->mInputGradients)
+      {
+        inputGradient.setZero();
+      }
+      if (parallel && node->isThreadSafe())
+      {
+        futures.push_back(
+            pool.submit([node]() { node->backward(node->mInputGradients); }));
+      }
+      else
+      {
+        node->backward(node->mInputGradients);
+      }
+    }
+    pool.waitAll(futures);
+
+    // Nodes on the same level can share inputs, so the accumulation happens
+    // after they've all finished, on this thread
+    for (int index : level)
+    {
+      DiffNode* node = mNodes[index].get();
+      if (node->mInputs.empty() || node->mGradient.isZero(0))
+        continue;
+      for (std::size_t i = 0; i < node->mInputs.size(); i++)
+      {
+        mNodes[node->mInputs[i]]->mGradient += node->mInputGradients[i];
+      }
+      node->accumulateLossWrtMass(mLossWrtMass);
+    }
+  }
+}
+
+//==============================================================================
+/// This fills in mLevels from the inputs of each node
+void DiffTape::computeLevels()
+{
+  const int numNodes = mNodes.size();
+  mNodeLevels.assign(numNodes, 0);
+  int maxLevel = -1;
+  // Every node comes after its inputs, so by the time we reach a node in this
+  // reverse sweep every node that reads from it has already pushed its level
+  for (int i = numNodes - 1; i >= 0; i--)
+  {
+    maxLevel = std::max(maxLevel, mNodeLevels[i]);
+    for (int input : mNodes[i]->mInputs)
+    {
+      mNodeLevels[input] = std::max(mNodeLevels[input], mNodeLevels[i] + 1);
+    }
+  }
+
+  mLevels.resize(maxLevel + 1);
+  for (std::vector<int>& level : mLevels)
+  {
+    level.clear();
+  }
+  for (int i = numNodes - 1; i >= 0; i--)
+  {
+    mLevels[mNodeLevels[i]].push_back(i);
+  }
+  mLevelsDirty = false;
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,112 @@
+#ifndef DART_NEURAL_DIFF_TAPE_HPP_
+#define DART_NEURAL_DIFF_TAPE_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+#include "dart/neural/DiffNode.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+class Mapping;
+
+/// This records a computation over a World as a list of DiffNodes (steps,
+/// mappings and losses), and then runs reverse-mode differentiation over the
+/// whole thing in C++. This replaces stitching LossGradients together by hand
+/// to get gradients of a loss over a long rollout.
+///
+/// Nodes are evaluated eagerly as they're recorded, so every add*() call
+/// returns the new node's index, and the node's value is ready right away.
+/// Nodes can only read from nodes recorded before them, so the tape order is
+/// always a valid evaluation order.
+///
+/// backward() sweeps the tape in reverse. Nodes that don't depend on each
+/// other (for example, losses on different timesteps, or mappings of the
+/// same state) get their gradients computed in parallel on the global
+/// ThreadPool. Steps of the world always run one at a time.
+class DiffTape
+{
+public:
+  DiffTape(std::shared_ptr<simulation::World> world);
+
+  /// This reserves room for `numNodes` nodes, so recording doesn't reallocate
+  void reserve(int numNodes);
+
+  /// This drops every node, so the tape can be reused
+  void clear();
+
+  /// This records a leaf holding `value`, like a control force to optimize
+  int addInput(const Eigen::VectorXs& value);
+
+  /// This records a leaf holding the world's current state, [pos, vel]
+  int addWorldState();
+
+  /// This records a step of the world from the state at `stateNode`, with the
+  /// control forces at `forceNode`. The new node's value is the next state.
+  int addForwardPass(int stateNode, int forceNode);
+
+  /// This records the state at `stateNode` converted into `mapping`'s space,
+  /// as [mapped pos, mapped vel]
+  int addMapping(int stateNode, std::shared_ptr<Mapping> mapping);
+
+  /// This records a loss over the values of `inputs`. Every loss on the tape
+  /// gets added together into getLoss().
+  int addLoss(const std::vector<int>& inputs, const DiffLossFn& loss);
+
+  /// This records a custom node. Its inputs must already be on the tape.
+  int addNode(std::shared_ptr<DiffNode> node);
+
+  /// This returns how many nodes have been recorded
+  int getNumNodes() const;
+
+  /// This returns the node at `index`
+  std::shared_ptr<DiffNode> getNode(int index) const;
+
+  /// This returns the value of the node at `index`
+  const Eigen::VectorXs& getValue(int index) const;
+
+  /// This returns the gradient of getLoss() with respect to the value of the
+  /// node at `index`, as of the last backward()
+  const Eigen::VectorXs& getGradient(int index) const;
+
+  /// This returns the sum of every loss on the tape
+  s_t getLoss() const;
+
+  /// This returns the gradient of getLoss() with respect to the world's
+  /// masses, as of the last backward()
+  const Eigen::VectorXs& getLossWrtMass() const;
+
+  /// This computes the gradient of getLoss() with respect to every node on the
+  /// tape. If `parallel` is false, every node runs on the calling thread.
+  void backward(bool parallel = true);
+
+protected:
+  /// This fills in mLevels from the inputs of each node
+  void computeLevels();
+
+  std::shared_ptr<simulation::World> mWorld;
+  std::vector<std::shared_ptr<DiffNode>> mNodes;
+  std::vector<int> mLossNodes;
+  Eigen::VectorXs mLossWrtMass;
+
+  /// Each level holds nodes that only feed into nodes on earlier levels, so
+  /// every node on a level can run backward() at the same time. Level 0 has
+  /// the nodes that nothing reads from.
+  std::vector<std::vector<int>> mLevels;
+  std::vector<int> mNodeLevels;
+  bool mLevelsDirty;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
@@ -1,5 +1,7 @@
 #include "dart/neural/DifferentiableContactConstraint.hpp"
 
+#include <algorithm>
+
 #include "dart/collision/Contact.hpp"
 #include "dart/constraint/ConstraintBase.hpp"
 #include "dart/constraint/ContactConstraint.hpp"
@@ -34,6 +36,26 @@ DifferentiableContactConstraint::DifferentiableContactConstraint(
     // This needs to be explicitly copied, otherwise the memory is overwritten
     mContact = std::make_shared<collision::Contact>(
         mContactConstraint->getContact());
+
+    // Only the DOFs on the kinematic paths from the two bodies up to their
+    // roots can move the contact, so we collect those once up front and only
+    // ever visit them when building Jacobians.
+    const dynamics::BodyNode* bodies[2] = {mContactConstraint->getBodyNodeA(),
+                                           mContactConstraint->getBodyNodeB()};
+    for (const dynamics::BodyNode* body : bodies)
+    {
+      if (body == nullptr)
+        continue;
+      for (dynamics::DegreeOfFreedom* dof :
+           const_cast<dynamics::BodyNode*>(body)->getDependentDofs())
+      {
+        if (std::find(mDependentDofs.begin(), mDependentDofs.end(), dof)
+            == mDependentDofs.end())
+        {
+          mDependentDofs.push_back(dof);
+        }
+      }
+    }
   }
   for (auto skel : constraint->getSkeletons())
   {
@@ -246,15 +268,11 @@ Eigen::VectorXs DifferentiableContactConstraint::getConstraintForces(
   Eigen::Vector6s worldForce = getWorldForce();
 
   Eigen::VectorXs taus = Eigen::VectorXs::Zero(skel->getNumDofs());
-  for (int i = 0; i < skel->getNumDofs(); i++)
+  for (int i : getDependentDofIndices(skel))
   {
     auto dof = skel->getDof(i);
     s_t multiple = getControlForceMultiple(dof);
-    if (multiple == 0)
-    {
-      taus(i) = 0.0;
-    }
-    else
+    if (multiple != 0)
     {
       Eigen::Vector6s worldTwist = getWorldScrewAxisForForce(dof);
       taus(i) = worldTwist.dot(worldForce) * multiple;
@@ -1317,11 +1335,10 @@ DifferentiableContactConstraint::getContactPositionJacobian(
     std::shared_ptr<simulation::World> world)
 {
   math::LinearJacobian jac = math::LinearJacobian::Zero(3, world->getNumDofs());
-  int i = 0;
-  for (auto dof : world->getDofs())
+  std::vector<dynamics::DegreeOfFreedom*> dofs = world->getDofs();
+  for (int i : getDependentDofIndices(world.get()))
   {
-    jac.col(i) = getContactPositionGradient(dof);
-    i++;
+    jac.col(i) = getContactPositionGradient(dofs[i]);
   }
   return jac;
 }
@@ -1333,11 +1350,9 @@ DifferentiableContactConstraint::getContactPositionJacobian(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
   math::LinearJacobian jac = math::LinearJacobian::Zero(3, skel->getNumDofs());
-  int i = 0;
-  for (auto dof : skel->getDofs())
+  for (int i : getDependentDofIndices(skel))
   {
-    jac.col(i) = getContactPositionGradient(dof);
-    i++;
+    jac.col(i) = getContactPositionGradient(skel->getDof(i));
   }
   return jac;
 }
@@ -1349,13 +1364,11 @@ DifferentiableContactConstraint::getContactForceDirectionJacobian(
     std::shared_ptr<simulation::World> world)
 {
   math::LinearJacobian jac = math::LinearJacobian::Zero(3, world->getNumDofs());
-  int i = 0;
-  for (auto dof : world->getDofs())
+  std::vector<dynamics::DegreeOfFreedom*> dofs = world->getDofs();
+  for (int i : getDependentDofIndices(world.get()))
   {
-    jac.col(i) = getContactForceGradient(dof);
-    i++;
+    jac.col(i) = getContactForceGradient(dofs[i]);
   }
-  assert(i == jac.cols());
   return jac;
 }
 
@@ -1366,11 +1379,9 @@ DifferentiableContactConstraint::getContactForceDirectionJacobian(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
   math::LinearJacobian jac = math::LinearJacobian::Zero(3, skel->getNumDofs());
-  int i = 0;
-  for (auto dof : skel->getDofs())
+  for (int i : getDependentDofIndices(skel))
   {
-    jac.col(i) = getContactForceGradient(dof);
-    i++;
+    jac.col(i) = getContactForceGradient(skel->getDof(i));
   }
   return jac;
 }
@@ -1385,13 +1396,14 @@ math::Jacobian DifferentiableContactConstraint::getContactForceJacobian(
   math::LinearJacobian dirJac = getContactForceDirectionJacobian(world);
   math::Jacobian jac = math::Jacobian::Zero(6, world->getNumDofs());
 
-  // tau = pos cross dir
-  for (int i = 0; i < world->getNumDofs(); i++)
+  // Every other column of posJac and dirJac is zero
+  for (int i : getDependentDofIndices(world.get()))
   {
+    // tau = pos cross dir
     jac.block<3, 1>(0, i) = pos.cross(dirJac.col(i)) + posJac.col(i).cross(dir);
+    // f = dir
+    jac.block<3, 1>(3, i) = dirJac.col(i);
   }
-  // f = dir
-  jac.block(3, 0, 3, world->getNumDofs()) = dirJac;
 
   return jac;
 }
@@ -1497,8 +1509,11 @@ DifferentiableContactConstraint::getConstraintForcesJacobian(
     // Compute the same thing, but hopefully faster
     ////////////////////////////////////////////////////////////////////
 
+    // Only rows and columns for DOFs on the kinematic path to the contact
+    // bodies can be non-zero, so we only visit those
+    mWorldDependentDofIndices = getDependentDofIndices(world.get());
     mWorldConstraintJacCache = Eigen::MatrixXs::Zero(dim, dim);
-    for (int row = 0; row < dim; row++)
+    for (int row : mWorldDependentDofIndices)
     {
       s_t multiple = getControlForceMultiple(dofs[row]);
       if (multiple == 0.0)
@@ -1507,10 +1522,13 @@ DifferentiableContactConstraint::getConstraintForcesJacobian(
       Eigen::Vector6s axis = getWorldScrewAxisForForce(dofs[row]);
       // Eigen::Vector6s axisWorldTwist = getWorldScrewAxisForForce(dofs[row]);
 
-      // Each element [i] of this vector is the forceJac col(i) dotted with
-      // axis.
-      mWorldConstraintJacCache.row(row)
-          = multiple * forceJac.transpose() * axis;
+      // Each element [i] of this row is the forceJac col(i) dotted with axis.
+      // forceJac is zero outside of the dependent columns.
+      for (int col : mWorldDependentDofIndices)
+      {
+        mWorldConstraintJacCache(row, col)
+            = multiple * forceJac.col(col).dot(axis);
+      }
 
       dynamics::Joint* jointCursor = dofs[row]->getJoint();
 
@@ -1593,6 +1611,90 @@ DifferentiableContactConstraint::getConstraintForcesJacobian(
   return mWorldConstraintJacCache;
 }
 
+//==============================================================================
+/// This adds scale * getConstraintForcesJacobian(world) to result, only
+/// touching the rows and columns that can be non-zero.
+void DifferentiableContactConstraint::addScaledConstraintForcesJacobian(
+    std::shared_ptr<simulation::World> world,
+    s_t scale,
+    Eigen::MatrixXs& result)
+{
+  const Eigen::MatrixXs& jac = getConstraintForcesJacobian(world);
+  for (int col : mWorldDependentDofIndices)
+  {
+    for (int row : mWorldDependentDofIndices)
+    {
+      result(row, col) += scale * jac(row, col);
+    }
+  }
+}
+
+//==============================================================================
+/// This returns getConstraintForcesJacobian(world).transpose() * v, only
+/// touching the rows and columns that can be non-zero.
+Eigen::VectorXs
+DifferentiableContactConstraint::multiplyConstraintForcesJacobianTranspose(
+    std::shared_ptr<simulation::World> world, const Eigen::VectorXs& v)
+{
+  const Eigen::MatrixXs& jac = getConstraintForcesJacobian(world);
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(jac.cols());
+  for (int col : mWorldDependentDofIndices)
+  {
+    for (int row : mWorldDependentDofIndices)
+    {
+      result(col) += jac(row, col) * v(row);
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns the DOFs that can move this contact, which are the DOFs on
+/// the kinematic paths from the two contact bodies up to their roots.
+const std::vector<dynamics::DegreeOfFreedom*>&
+DifferentiableContactConstraint::getDependentDofs()
+{
+  return mDependentDofs;
+}
+
+//==============================================================================
+/// This returns the indices of getDependentDofs() in world, in ascending
+/// order. The DOFs are matched up by skeleton name, so this works on clones of
+/// the world this contact came from.
+std::vector<int> DifferentiableContactConstraint::getDependentDofIndices(
+    simulation::World* world)
+{
+  std::vector<int> indices;
+  indices.reserve(mDependentDofs.size());
+  for (dynamics::DegreeOfFreedom* dof : mDependentDofs)
+  {
+    dynamics::SkeletonPtr skel
+        = world->getSkeleton(dof->getSkeleton()->getName());
+    if (skel == nullptr)
+      continue;
+    indices.push_back(
+        world->getSkeletonDofOffset(skel) + dof->getIndexInSkeleton());
+  }
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
+//==============================================================================
+/// This returns the indices of getDependentDofs() that fall in skel, in
+/// ascending order.
+std::vector<int> DifferentiableContactConstraint::getDependentDofIndices(
+    std::shared_ptr<dynamics::Skeleton> skel)
+{
+  std::vector<int> indices;
+  for (dynamics::DegreeOfFreedom* dof : mDependentDofs)
+  {
+    if (dof->getSkeleton()->getName() == skel->getName())
+      indices.push_back(dof->getIndexInSkeleton());
+  }
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
 //==============================================================================
 /// This computes and returns the analytical Jacobian relating how changes in
 /// the positions of wrt's DOFs changes the constraint forces on skel.
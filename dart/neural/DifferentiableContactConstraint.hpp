@@ -219,6 +219,33 @@ public:
       std::shared_ptr<simulation::World> world,
       std::vector<std::shared_ptr<dynamics::Skeleton>> skels);
 
+  /// This adds scale * getConstraintForcesJacobian(world) to result, only
+  /// touching the rows and columns that can be non-zero.
+  void addScaledConstraintForcesJacobian(
+      std::shared_ptr<simulation::World> world,
+      s_t scale,
+      Eigen::MatrixXs& result);
+
+  /// This returns getConstraintForcesJacobian(world).transpose() * v, only
+  /// touching the rows and columns that can be non-zero.
+  Eigen::VectorXs multiplyConstraintForcesJacobianTranspose(
+      std::shared_ptr<simulation::World> world, const Eigen::VectorXs& v);
+
+  /// This returns the DOFs that can move this contact, which are the DOFs on
+  /// the kinematic paths from the two contact bodies up to their roots. Every
+  /// other column of the contact Jacobians, and every other row and column of
+  /// getConstraintForcesJacobian(), is zero.
+  const std::vector<dynamics::DegreeOfFreedom*>& getDependentDofs();
+
+  /// This returns the indices of getDependentDofs() in world, in ascending
+  /// order.
+  std::vector<int> getDependentDofIndices(simulation::World* world);
+
+  /// This returns the indices of getDependentDofs() that fall in skel, in
+  /// ascending order.
+  std::vector<int> getDependentDofIndices(
+      std::shared_ptr<dynamics::Skeleton> skel);
+
   /// This returns the skeletons that this contact constraint interacts with.
   const std::vector<std::shared_ptr<dynamics::Skeleton>>& getSkeletons();
 
@@ -395,6 +422,11 @@ protected:
 
   bool mWorldConstraintJacCacheDirty;
   Eigen::MatrixXs mWorldConstraintJacCache;
+  std::vector<int> mWorldDependentDofIndices;
+
+  /// The DOFs on the kinematic paths from the contact bodies to their roots.
+  /// This is empty for non-contact constraints, which never exert a force.
+  std::vector<dynamics::DegreeOfFreedom*> mDependentDofs;
 
   int mIndex;
 
@@ -0,0 +1,565 @@
+#include "dart/neural/FeatherstoneWorldBatch.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <future>
+
+#include "dart/common/Console.hpp"
+#include "dart/common/ThreadPool.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+FeatherstoneBatchConfig::FeatherstoneBatchConfig()
+{
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setTimeStep(s_t v)
+{
+  timeStep = v;
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setGravity(Eigen::Vector3s v)
+{
+  gravity = v;
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setGroundContact(bool v)
+{
+  groundContact = v;
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setGroundHeight(s_t v)
+{
+  groundHeight = v;
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setGroundNormal(
+    Eigen::Vector3s v)
+{
+  groundNormal = v.normalized();
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setFrictionCoeff(s_t v)
+{
+  frictionCoeff = v;
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setNumSolverIterations(int v)
+{
+  numSolverIterations = v;
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneBatchConfig& FeatherstoneBatchConfig::setErrorReduction(s_t v)
+{
+  errorReduction = v;
+  return *this;
+}
+
+//==============================================================================
+FeatherstoneWorldBatch::FeatherstoneWorldBatch(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    int numWorlds,
+    FeatherstoneBatchConfig config)
+  : mNumWorlds(numWorlds), mNumDofs(skel->getNumDofs()), mConfig(config)
+{
+  assert(numWorlds > 0);
+
+  dynamics::SimpleFeatherstone featherstone;
+  featherstone.populateFromSkeleton(skel);
+  if (mConfig.groundContact)
+    findContactPoints(skel);
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  const int numWorkers
+      = std::max(1, std::min(numWorlds, (int)pool.getNumThreads()));
+  mFeatherstones.resize(numWorkers, featherstone);
+}
+
+//==============================================================================
+/// This returns the number of worlds in the batch
+int FeatherstoneWorldBatch::getNumWorlds() const
+{
+  return mNumWorlds;
+}
+
+//==============================================================================
+/// This returns the number of DOFs in each world
+int FeatherstoneWorldBatch::getNumDofs() const
+{
+  return mNumDofs;
+}
+
+//==============================================================================
+/// This returns the size of a single world's state vector
+int FeatherstoneWorldBatch::getStateSize() const
+{
+  return mNumDofs * 2;
+}
+
+//==============================================================================
+/// This returns the size of a single world's action vector
+int FeatherstoneWorldBatch::getActionSize() const
+{
+  return mNumDofs;
+}
+
+//==============================================================================
+/// This returns the number of points on the skeleton we collide with the
+/// ground
+int FeatherstoneWorldBatch::getNumContactPoints() const
+{
+  return mContactPoints.size();
+}
+
+//==============================================================================
+const FeatherstoneBatchConfig& FeatherstoneWorldBatch::getConfig() const
+{
+  return mConfig;
+}
+
+//==============================================================================
+/// This steps every world in parallel, from column `i` of `states` with
+/// column `i` of `actions`, and writes the next states into `nextStates`.
+/// This does not record any gradient information, so it's the fastest
+/// option for pure rollouts. `nextStates` may be `states`.
+void FeatherstoneWorldBatch::step(
+    const Eigen::Ref<const Eigen::MatrixXs>& states,
+    const Eigen::Ref<const Eigen::MatrixXs>& actions,
+    Eigen::Ref<Eigen::MatrixXs> nextStates)
+{
+  assert(states.rows() == getStateSize() && states.cols() == mNumWorlds);
+  assert(actions.rows() == getActionSize() && actions.cols() == mNumWorlds);
+  assert(nextStates.rows() == getStateSize());
+  assert(nextStates.cols() == mNumWorlds);
+
+  forEachWorld([&](dynamics::SimpleFeatherstone& featherstone, int i) {
+    stepWorld(
+        featherstone,
+        states.col(i),
+        actions.col(i),
+        nextStates.col(i),
+        nullptr,
+        nullptr);
+  });
+}
+
+//==============================================================================
+/// This is the same as step(), but also records what backpropState()
+/// needs
+std::shared_ptr<FeatherstoneBatchTape> FeatherstoneWorldBatch::forwardPass(
+    const Eigen::Ref<const Eigen::MatrixXs>& states,
+    const Eigen::Ref<const Eigen::MatrixXs>& actions,
+    Eigen::Ref<Eigen::MatrixXs> nextStates)
+{
+  assert(states.rows() == getStateSize() && states.cols() == mNumWorlds);
+  assert(actions.rows() == getActionSize() && actions.cols() == mNumWorlds);
+  assert(nextStates.rows() == getStateSize());
+  assert(nextStates.cols() == mNumWorlds);
+
+  const int n = mNumDofs;
+  std::shared_ptr<FeatherstoneBatchTape> tape
+      = std::make_shared<FeatherstoneBatchTape>();
+  tape->numWorlds = mNumWorlds;
+  tape->numDofs = n;
+  tape->stateJacobians = Eigen::MatrixXs::Zero(2 * n, 2 * n * mNumWorlds);
+  tape->actionJacobians = Eigen::MatrixXs::Zero(2 * n, n * mNumWorlds);
+  tape->numContacts = Eigen::VectorXi::Zero(mNumWorlds);
+
+  forEachWorld([&](dynamics::SimpleFeatherstone& featherstone, int i) {
+    Eigen::MatrixXs stateJac;
+    Eigen::MatrixXs actionJac;
+    tape->numContacts(i) = stepWorld(
+        featherstone,
+        states.col(i),
+        actions.col(i),
+        nextStates.col(i),
+        &stateJac,
+        &actionJac);
+    tape->stateJacobians.middleCols(i * 2 * n, 2 * n) = stateJac;
+    tape->actionJacobians.middleCols(i * n, n) = actionJac;
+  });
+  return tape;
+}
+
+//==============================================================================
+/// This takes the loss gradient wrt each world's next state (one column per
+/// world), and writes the loss gradient wrt each world's state and action
+void FeatherstoneWorldBatch::backpropState(
+    const FeatherstoneBatchTape& tape,
+    const Eigen::Ref<const Eigen::MatrixXs>& lossWrtNextStates,
+    Eigen::Ref<Eigen::MatrixXs> lossWrtStates,
+    Eigen::Ref<Eigen::MatrixXs> lossWrtActions)
+{
+  const int n = tape.numDofs;
+  assert(tape.numWorlds == mNumWorlds && n == mNumDofs);
+  assert(lossWrtNextStates.rows() == 2 * n);
+  assert(lossWrtNextStates.cols() == mNumWorlds);
+
+  forEachWorld([&](dynamics::SimpleFeatherstone&, int i) {
+    lossWrtStates.col(i).noalias()
+        = tape.stateJacobians.middleCols(i * 2 * n, 2 * n).transpose()
+          * lossWrtNextStates.col(i);
+    lossWrtActions.col(i).noalias()
+        = tape.actionJacobians.middleCols(i * n, n).transpose()
+          * lossWrtNextStates.col(i);
+  });
+}
+
+//==============================================================================
+/// This finds the points on the skeleton's primitive collision shapes that
+/// can touch the ground
+void FeatherstoneWorldBatch::findContactPoints(
+    const std::shared_ptr<dynamics::Skeleton>& skel)
+{
+  for (int b = 0; b < skel->getNumBodyNodes(); b++)
+  {
+    dynamics::BodyNode* body = skel->getBodyNode(b);
+    if (body->getParentJoint()->getNumDofs() == 0)
+      continue;
+    const int index = body->getParentJoint()->getDof(0)->getIndexInSkeleton();
+
+    for (const dynamics::ShapeNode* shapeNode :
+         body->getShapeNodesWith<dynamics::CollisionAspect>())
+    {
+      const Eigen::Isometry3s& T = shapeNode->getRelativeTransform();
+      dynamics::ConstShapePtr shape = shapeNode->getShape();
+      if (shape->getType() == dynamics::SphereShape::getStaticType())
+      {
+        const auto* sphere
+            = static_cast<const dynamics::SphereShape*>(shape.get());
+        mContactPoints.push_back(
+            ContactPoint{index, T.translation(), sphere->getRadius()});
+      }
+      else if (shape->getType() == dynamics::CapsuleShape::getStaticType())
+      {
+        // Capsules run along their Z axis
+        const auto* capsule
+            = static_cast<const dynamics::CapsuleShape*>(shape.get());
+        const s_t halfHeight = capsule->getHeight() / 2;
+        for (int end = -1; end <= 1; end += 2)
+        {
+          mContactPoints.push_back(ContactPoint{
+              index,
+              T * Eigen::Vector3s(0, 0, end * halfHeight),
+              capsule->getRadius()});
+        }
+      }
+      else if (shape->getType() == dynamics::BoxShape::getStaticType())
+      {
+        const auto* box = static_cast<const dynamics::BoxShape*>(shape.get());
+        const Eigen::Vector3s halfSize = box->getSize() / 2;
+        for (int corner = 0; corner < 8; corner++)
+        {
+          Eigen::Vector3s point(
+              (corner & 1) ? halfSize(0) : -halfSize(0),
+              (corner & 2) ? halfSize(1) : -halfSize(1),
+              (corner & 4) ? halfSize(2) : -halfSize(2));
+          mContactPoints.push_back(ContactPoint{index, T * point, 0.0});
+        }
+      }
+      else
+      {
+        dtwarn << "[FeatherstoneWorldBatch] Ignoring the collision shape of "
+               << "type " << shape->getType() << " on body \""
+               << body->getName()
+               << "\". Only spheres, capsules and boxes touch the ground.\n";
+      }
+    }
+  }
+}
+
+//==============================================================================
+/// This gets the acceleration (forward dynamics, plus gravity) at `pos`,
+/// `vel` under `force`
+void FeatherstoneWorldBatch::freeAcceleration(
+    dynamics::SimpleFeatherstone& featherstone,
+    s_t* pos,
+    s_t* vel,
+    const s_t* force,
+    s_t* acc)
+{
+  Eigen::VectorXs totalForce(mNumDofs);
+  featherstone.gravityForces(pos, mConfig.gravity, totalForce.data());
+  totalForce += Eigen::Map<const Eigen::VectorXs>(force, mNumDofs);
+  featherstone.forwardDynamics(pos, vel, totalForce.data(), acc);
+}
+
+//==============================================================================
+/// This steps a single world. If `stateJac` and `actionJac` aren't null,
+/// this also fills them in, and returns the number of contacts.
+int FeatherstoneWorldBatch::stepWorld(
+    dynamics::SimpleFeatherstone& featherstone,
+    const Eigen::Ref<const Eigen::VectorXs>& state,
+    const Eigen::Ref<const Eigen::VectorXs>& action,
+    Eigen::Ref<Eigen::VectorXs> nextState,
+    Eigen::MatrixXs* stateJac,
+    Eigen::MatrixXs* actionJac)
+{
+  const int n = mNumDofs;
+  const s_t dt = mConfig.timeStep;
+  const bool recording = stateJac != nullptr && actionJac != nullptr;
+
+  // Copy out first, since `nextState` may alias `state`
+  Eigen::VectorXs pos = state.head(n);
+  Eigen::VectorXs vel = state.tail(n);
+  Eigen::VectorXs force = action;
+
+  // Smooth dynamics
+  Eigen::VectorXs acc(n);
+  freeAcceleration(
+      featherstone, pos.data(), vel.data(), force.data(), acc.data());
+  Eigen::VectorXs preContactVel = vel + dt * acc;
+
+  // Find the points below the ground, and their Jacobians. Each contact gets
+  // a normal row, then two tangent rows.
+  featherstone.updateWorldTransforms(pos.data());
+  const Eigen::Vector3s& normal = mConfig.groundNormal;
+  Eigen::Vector3s tangent1
+      = normal.cross(
+                std::abs(normal(0)) < 0.9 ? Eigen::Vector3s::UnitX()
+                                          : Eigen::Vector3s::UnitY())
+            .normalized();
+  Eigen::Vector3s tangent2 = normal.cross(tangent1);
+  std::vector<s_t> depths;
+  std::vector<Eigen::Vector3s> points;
+  std::vector<int> bodies;
+  for (const ContactPoint& contact : mContactPoints)
+  {
+    Eigen::Vector3s worldPoint
+        = featherstone.mScratchSpace[contact.body].worldTransform
+              * contact.localPoint
+          - contact.radius * normal;
+    s_t depth = normal.dot(worldPoint) - mConfig.groundHeight;
+    if (depth < 0)
+    {
+      depths.push_back(depth);
+      points.push_back(worldPoint);
+      bodies.push_back(contact.body);
+    }
+  }
+  const int numContacts = depths.size();
+
+  Eigen::MatrixXs J = Eigen::MatrixXs::Zero(3 * numContacts, n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    for (int j = bodies[c]; j != -1;
+         j = featherstone.mJointsAndBodies[j].parentIndex)
+    {
+      Eigen::Vector6s worldAxis = math::AdT(
+          featherstone.mScratchSpace[j].worldTransform,
+          featherstone.mJointsAndBodies[j].axis);
+      Eigen::Vector3s pointVel
+          = worldAxis.tail<3>() + worldAxis.head<3>().cross(points[c]);
+      J(3 * c, j) = normal.dot(pointVel);
+      J(3 * c + 1, j) = tangent1.dot(pointVel);
+      J(3 * c + 2, j) = tangent2.dot(pointVel);
+    }
+  }
+
+  Eigen::MatrixXs Minv;
+  if (numContacts > 0 || recording)
+  {
+    Eigen::MatrixXs M(n, n);
+    featherstone.massMatrix(pos.data(), M.data());
+    Minv = M.ldlt().solve(Eigen::MatrixXs::Identity(n, n));
+  }
+
+  // Projected Gauss-Seidel on the contact impulses
+  Eigen::VectorXs impulses = Eigen::VectorXs::Zero(3 * numContacts);
+  Eigen::VectorXs postContactVel = preContactVel;
+  if (numContacts > 0)
+  {
+    Eigen::MatrixXs MinvJt = Minv * J.transpose();
+    Eigen::MatrixXs A = J * MinvJt;
+    Eigen::VectorXs b = J * preContactVel;
+    for (int c = 0; c < numContacts; c++)
+    {
+      b(3 * c) += mConfig.errorReduction * depths[c] / dt;
+    }
+    for (int iter = 0; iter < mConfig.numSolverIterations; iter++)
+    {
+      for (int row = 0; row < 3 * numContacts; row++)
+      {
+        if (A(row, row) <= 0)
+          continue;
+        s_t residual = A.row(row).dot(impulses) + b(row);
+        s_t updated = impulses(row) - residual / A(row, row);
+        if (row % 3 == 0)
+        {
+          impulses(row) = std::max((s_t)0.0, updated);
+        }
+        else
+        {
+          s_t bound = mConfig.frictionCoeff * impulses(row - row % 3);
+          impulses(row) = std::max(-bound, std::min(bound, updated));
+        }
+      }
+    }
+    postContactVel += MinvJt * impulses;
+  }
+
+  nextState.head(n) = pos + dt * postContactVel;
+  nextState.tail(n) = postContactVel;
+
+  if (!recording)
+    return numContacts;
+
+  // The smooth dynamics, by central differences
+  const s_t eps = 1e-7;
+  Eigen::MatrixXs accWrtPos(n, n);
+  Eigen::MatrixXs accWrtVel(n, n);
+  Eigen::VectorXs accPlus(n);
+  Eigen::VectorXs accMinus(n);
+  for (int k = 0; k < n; k++)
+  {
+    Eigen::VectorXs perturbed = pos;
+    perturbed(k) += eps;
+    freeAcceleration(
+        featherstone,
+        perturbed.data(),
+        vel.data(),
+        force.data(),
+        accPlus.data());
+    perturbed(k) = pos(k) - eps;
+    freeAcceleration(
+        featherstone,
+        perturbed.data(),
+        vel.data(),
+        force.data(),
+        accMinus.data());
+    accWrtPos.col(k) = (accPlus - accMinus) / (2 * eps);
+
+    perturbed = vel;
+    perturbed(k) += eps;
+    freeAcceleration(
+        featherstone,
+        pos.data(),
+        perturbed.data(),
+        force.data(),
+        accPlus.data());
+    perturbed(k) = vel(k) - eps;
+    freeAcceleration(
+        featherstone,
+        pos.data(),
+        perturbed.data(),
+        force.data(),
+        accMinus.data());
+    accWrtVel.col(k) = (accPlus - accMinus) / (2 * eps);
+  }
+
+  // The adjoint of the contact solve. Pushing contacts hold their normal
+  // rows, and sticking ones their tangent rows as well. Holding those rows at
+  // their target velocity projects the pre-contact velocity with
+  //
+  //   P = I - Minv J^T (J Minv J^T)^-1 J
+  Eigen::MatrixXs P = Eigen::MatrixXs::Identity(n, n);
+  std::vector<int> clampingRows;
+  for (int c = 0; c < numContacts; c++)
+  {
+    const s_t normalImpulse = impulses(3 * c);
+    if (normalImpulse <= 1e-9)
+      continue;
+    clampingRows.push_back(3 * c);
+    const s_t bound = mConfig.frictionCoeff * normalImpulse;
+    for (int t = 1; t <= 2; t++)
+    {
+      if (std::abs(impulses(3 * c + t)) < bound - 1e-9)
+        clampingRows.push_back(3 * c + t);
+    }
+  }
+  if (!clampingRows.empty())
+  {
+    Eigen::MatrixXs Jc(clampingRows.size(), n);
+    for (int r = 0; r < clampingRows.size(); r++)
+    {
+      Jc.row(r) = J.row(clampingRows[r]);
+    }
+    Eigen::MatrixXs MinvJct = Minv * Jc.transpose();
+    // Boxes resting flat have redundant corners, so this can be singular
+    Eigen::MatrixXs Ac = Jc * MinvJct;
+    P -= MinvJct * Ac.completeOrthogonalDecomposition().solve(Jc);
+  }
+
+  Eigen::MatrixXs velWrtPos = dt * P * accWrtPos;
+  Eigen::MatrixXs velWrtVel
+      = P * (Eigen::MatrixXs::Identity(n, n) + dt * accWrtVel);
+  Eigen::MatrixXs velWrtForce = dt * P * Minv;
+
+  stateJac->resize(2 * n, 2 * n);
+  stateJac->block(0, 0, n, n)
+      = Eigen::MatrixXs::Identity(n, n) + dt * velWrtPos;
+  stateJac->block(0, n, n, n) = dt * velWrtVel;
+  stateJac->block(n, 0, n, n) = velWrtPos;
+  stateJac->block(n, n, n, n) = velWrtVel;
+
+  actionJac->resize(2 * n, n);
+  actionJac->block(0, 0, n, n) = dt * velWrtForce;
+  actionJac->block(n, 0, n, n) = velWrtForce;
+
+  return numContacts;
+}
+
+//==============================================================================
+/// This runs `fn(featherstone, i)` for every world `i`, spread across the
+/// global ThreadPool, with a separate SimpleFeatherstone (and so a separate
+/// scratch space) for each chunk of worlds
+void FeatherstoneWorldBatch::forEachWorld(
+    std::function<void(dynamics::SimpleFeatherstone&, int)> fn)
+{
+  const int numChunks = mFeatherstones.size();
+  auto runChunk = [&](int c, int start, int end) {
+    for (int i = start; i < end; i++)
+    {
+      fn(mFeatherstones[c], i);
+    }
+  };
+
+  if (numChunks == 1)
+  {
+    runChunk(0, 0, mNumWorlds);
+    return;
+  }
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (int c = 0; c < numChunks; c++)
+  {
+    int start = (mNumWorlds * c) / numChunks;
+    int end = (mNumWorlds * (c + 1)) / numChunks;
+    futures.push_back(pool.submit(runChunk, c, start, end));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+}
+
+} // namespace neural
+} // namespace dart
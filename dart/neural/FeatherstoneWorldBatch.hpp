@@ -0,0 +1,197 @@
+#ifndef DART_NEURAL_FEATHERSTONE_WORLD_BATCH_HPP_
+#define DART_NEURAL_FEATHERSTONE_WORLD_BATCH_HPP_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/dynamics/SimpleFeatherstone.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace dynamics {
+class Skeleton;
+}
+
+namespace neural {
+
+struct FeatherstoneBatchConfig
+{
+  FeatherstoneBatchConfig();
+
+  FeatherstoneBatchConfig& setTimeStep(s_t v);
+  FeatherstoneBatchConfig& setGravity(Eigen::Vector3s v);
+  FeatherstoneBatchConfig& setGroundContact(bool v);
+  FeatherstoneBatchConfig& setGroundHeight(s_t v);
+  FeatherstoneBatchConfig& setGroundNormal(Eigen::Vector3s v);
+  FeatherstoneBatchConfig& setFrictionCoeff(s_t v);
+  FeatherstoneBatchConfig& setNumSolverIterations(int v);
+  FeatherstoneBatchConfig& setErrorReduction(s_t v);
+
+  s_t timeStep = 0.01;
+  Eigen::Vector3s gravity = Eigen::Vector3s(0, -9.81, 0);
+  /// If this is false, the skeleton doesn't touch anything, and there's no
+  /// contact solve at all
+  bool groundContact = true;
+  /// The ground is the plane of points `p` with groundNormal.dot(p) ==
+  /// groundHeight
+  s_t groundHeight = 0.0;
+  Eigen::Vector3s groundNormal = Eigen::Vector3s::UnitY();
+  s_t frictionCoeff = 1.0;
+  /// The number of projected Gauss-Seidel sweeps per contact solve
+  int numSolverIterations = 30;
+  /// The fraction of any penetration we push back out in each step
+  s_t errorReduction = 0.2;
+};
+
+/// This records what FeatherstoneWorldBatch::forwardPass() needs to
+/// backpropagate a step. Block `i` of each matrix belongs to world `i`.
+struct FeatherstoneBatchTape
+{
+  int numWorlds;
+  int numDofs;
+  /// The Jacobian of the next state wrt the state, for each world, side by
+  /// side: (2 * numDofs) x (2 * numDofs * numWorlds)
+  Eigen::MatrixXs stateJacobians;
+  /// The Jacobian of the next state wrt the action, for each world, side by
+  /// side: (2 * numDofs) x (numDofs * numWorlds)
+  Eigen::MatrixXs actionJacobians;
+  /// The number of ground contacts each world had
+  Eigen::VectorXi numContacts;
+};
+
+/// This steps many copies of one fixed-topology skeleton at once, for
+/// reinforcement learning on simple robots (like the cartpole, half cheetah
+/// and jump worm examples), where WorldBatch spends most of its time in the
+/// general purpose machinery of World. This gives up that generality for
+/// throughput:
+///
+/// - The skeleton must have exactly one single-DOF joint per body (see
+///   SimpleFeatherstone), and its root joint's parent must be the world.
+/// - The only collisions are between the sphere, capsule and box shapes on
+///   the skeleton, and a ground plane. Self-collision, joint limits, damping,
+///   and springs are ignored.
+/// - Contacts are solved with projected Gauss-Seidel on impulses, with
+///   Coulomb friction and a penetration correction, and integration is
+///   semi-implicit Euler, like World::step().
+///
+/// The batch itself holds no state. States and actions are passed in as
+/// matrices with one column per world, laid out like WorldBatch: the state
+/// is positions then velocities, and the action is the force on every DOF.
+/// Worlds are stepped in parallel on the shared ThreadPool. The inputs and
+/// outputs are Eigen::Refs, so from Python, column-major buffers (like
+/// `tensor.numpy().T` for a contiguous (num_worlds, state_size) torch tensor)
+/// are read and written in place, without copies.
+///
+/// Gradients come from an adjoint of the contact solve. Contacts that end the
+/// step pushing (and, for friction, sticking) are treated as equality
+/// constraints on the post-contact velocity, which gives a projection whose
+/// transpose carries the loss gradient back through the solve. Sliding
+/// friction and the penetration correction are treated as constant forces,
+/// and the contact Jacobians as constant wrt position. The smooth dynamics
+/// are differentiated by central differences, which is cheap at the DOF
+/// counts this is meant for.
+class FeatherstoneWorldBatch
+{
+public:
+  FeatherstoneWorldBatch(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      int numWorlds,
+      FeatherstoneBatchConfig config = FeatherstoneBatchConfig());
+
+  /// This returns the number of worlds in the batch
+  int getNumWorlds() const;
+
+  /// This returns the number of DOFs in each world
+  int getNumDofs() const;
+
+  /// This returns the size of a single world's state vector
+  int getStateSize() const;
+
+  /// This returns the size of a single world's action vector
+  int getActionSize() const;
+
+  /// This returns the number of points on the skeleton we collide with the
+  /// ground
+  int getNumContactPoints() const;
+
+  const FeatherstoneBatchConfig& getConfig() const;
+
+  /// This steps every world in parallel, from column `i` of `states` with
+  /// column `i` of `actions`, and writes the next states into `nextStates`.
+  /// This does not record any gradient information, so it's the fastest
+  /// option for pure rollouts. `nextStates` may be `states`.
+  void step(
+      const Eigen::Ref<const Eigen::MatrixXs>& states,
+      const Eigen::Ref<const Eigen::MatrixXs>& actions,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> nextStates);
+
+  /// This is the same as step(), but also records what backpropState()
+  /// needs
+  std::shared_ptr<FeatherstoneBatchTape> forwardPass(
+      const Eigen::Ref<const Eigen::MatrixXs>& states,
+      const Eigen::Ref<const Eigen::MatrixXs>& actions,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> nextStates);
+
+  /// This takes the loss gradient wrt each world's next state (one column per
+  /// world), and writes the loss gradient wrt each world's state and action
+  void backpropState(
+      const FeatherstoneBatchTape& tape,
+      const Eigen::Ref<const Eigen::MatrixXs>& lossWrtNextStates,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> lossWrtStates,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> lossWrtActions);
+
+protected:
+  /// This is a point on one of the skeleton's bodies that collides with the
+  /// ground, with a radius around it
+  struct ContactPoint
+  {
+    int body;
+    Eigen::Vector3s localPoint;
+    s_t radius;
+  };
+
+  /// This finds the points on the skeleton's primitive collision shapes that
+  /// can touch the ground
+  void findContactPoints(const std::shared_ptr<dynamics::Skeleton>& skel);
+
+  /// This gets the acceleration (forward dynamics, plus gravity) at `pos`,
+  /// `vel` under `force`
+  void freeAcceleration(
+      dynamics::SimpleFeatherstone& featherstone,
+      s_t* pos,
+      s_t* vel,
+      const s_t* force,
+      /* OUT */ s_t* acc);
+
+  /// This steps a single world. If `stateJac` and `actionJac` aren't null,
+  /// this also fills them in, and returns the number of contacts.
+  int stepWorld(
+      dynamics::SimpleFeatherstone& featherstone,
+      const Eigen::Ref<const Eigen::VectorXs>& state,
+      const Eigen::Ref<const Eigen::VectorXs>& action,
+      /* OUT */ Eigen::Ref<Eigen::VectorXs> nextState,
+      /* OUT */ Eigen::MatrixXs* stateJac,
+      /* OUT */ Eigen::MatrixXs* actionJac);
+
+  /// This runs `fn(featherstone, i)` for every world `i`, spread across the
+  /// global ThreadPool, with a separate SimpleFeatherstone (and so a separate
+  /// scratch space) for each chunk of worlds
+  void forEachWorld(
+      std::function<void(dynamics::SimpleFeatherstone&, int)> fn);
+
+  int mNumWorlds;
+  int mNumDofs;
+  FeatherstoneBatchConfig mConfig;
+  std::vector<ContactPoint> mContactPoints;
+  // One per worker, so they each have their own scratch space
+  std::vector<dynamics::SimpleFeatherstone> mFeatherstones;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
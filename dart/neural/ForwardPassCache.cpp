@@ -0,0 +1,198 @@
+#include "dart/neural/ForwardPassCache.hpp"
+
+#include <functional>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Inertia.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+// Each body adds its 10 inertial parameters, its scale, and the external
+// force on it to the key
+static constexpr int VALUES_PER_BODY = 10 + 3 + 6;
+// The timestep, gravity, and the four contact settings of the World
+static constexpr int WORLD_VALUES = 1 + 3 + 4;
+
+//==============================================================================
+static void hashCombine(std::size_t& seed, std::size_t value)
+{
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+//==============================================================================
+bool ForwardPassCache::Key::operator==(const Key& other) const
+{
+  return hash == other.hash && skeletons == other.skeletons
+         && values.size() == other.values.size() && values == other.values;
+}
+
+//==============================================================================
+ForwardPassCache::ForwardPassCache(std::size_t maxEntries)
+  : mMaxEntries(maxEntries), mNumHits(0), mNumMisses(0)
+{
+}
+
+//==============================================================================
+/// This builds the key for stepping `world` from where it is now
+ForwardPassCache::Key ForwardPassCache::makeKey(simulation::World* world)
+{
+  const int dofs = world->getNumDofs();
+  const int numBodies = world->getNumBodyNodes();
+
+  Key key;
+  key.values.resize(3 * dofs + VALUES_PER_BODY * numBodies + WORLD_VALUES);
+  key.values.segment(0, dofs) = world->getPositions();
+  key.values.segment(dofs, dofs) = world->getVelocities();
+  key.values.segment(2 * dofs, dofs) = world->getControlForces();
+
+  int cursor = 3 * dofs;
+  key.skeletons.reserve(world->getNumSkeletons());
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    const dynamics::Skeleton* skel = world->getSkeletonRef(i).get();
+    key.skeletons.emplace_back(skel, skel->getVersion());
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+    {
+      const dynamics::BodyNode* body = skel->getBodyNode(j);
+      // Setting a mass or a center of mass doesn't bump the Skeleton's
+      // version, so the inertia has to be part of the key
+      const dynamics::Inertia& inertia = body->getInertia();
+      for (int p = 0; p < 10; p++)
+      {
+        key.values(cursor++) = inertia.getParameter(
+            static_cast<dynamics::Inertia::Param>(dynamics::Inertia::MASS + p));
+      }
+      key.values.segment<3>(cursor) = body->getScale();
+      cursor += 3;
+      key.values.segment<6>(cursor) = body->getExternalForceLocal();
+      cursor += 6;
+    }
+  }
+
+  key.values(cursor++) = world->getTimeStep();
+  key.values.segment<3>(cursor) = world->getGravity();
+  cursor += 3;
+  key.values(cursor++) = world->getPenetrationCorrectionEnabled() ? 1.0 : 0.0;
+  key.values(cursor++) = world->getContactClippingDepth();
+  key.values(cursor++) = world->getSpeculativeContactDistance();
+  key.values(cursor++) = world->getFallbackConstraintForceMixingConstant();
+  assert(cursor == key.values.size());
+
+  std::size_t hash = 0;
+  std::hash<double> hashValue;
+  for (int i = 0; i < key.values.size(); i++)
+  {
+    hashCombine(hash, hashValue(static_cast<double>(key.values(i))));
+  }
+  std::hash<const dynamics::Skeleton*> hashSkeleton;
+  for (const auto& pair : key.skeletons)
+  {
+    hashCombine(hash, hashSkeleton(pair.first));
+    hashCombine(hash, pair.second);
+  }
+  key.hash = hash;
+  return key;
+}
+
+//==============================================================================
+/// This returns the snapshot stored for `key`, or nullptr if there isn't
+/// one. A hit makes the entry the most recently used.
+std::shared_ptr<BackpropSnapshot> ForwardPassCache::find(const Key& key)
+{
+  auto it = mIndex.find(key.hash);
+  if (it == mIndex.end() || !(it->second->key == key))
+  {
+    mNumMisses++;
+    return nullptr;
+  }
+  mNumHits++;
+  mEntries.splice(mEntries.begin(), mEntries, it->second);
+  return it->second->snapshot;
+}
+
+//==============================================================================
+/// This stores `snapshot` for `key`, throwing out the least recently used
+/// entry if the cache is full
+void ForwardPassCache::insert(
+    const Key& key, std::shared_ptr<BackpropSnapshot> snapshot)
+{
+  if (mMaxEntries == 0)
+    return;
+
+  auto it = mIndex.find(key.hash);
+  if (it != mIndex.end())
+  {
+    it->second->key = key;
+    it->second->snapshot = snapshot;
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+    return;
+  }
+
+  mEntries.push_front(Entry{key, snapshot});
+  mIndex[key.hash] = mEntries.begin();
+  evict();
+}
+
+//==============================================================================
+/// This throws out every entry
+void ForwardPassCache::clear()
+{
+  mEntries.clear();
+  mIndex.clear();
+}
+
+//==============================================================================
+/// This sets how many snapshots the cache can hold, throwing out the least
+/// recently used ones if it's holding more than that
+void ForwardPassCache::setMaxEntries(std::size_t maxEntries)
+{
+  mMaxEntries = maxEntries;
+  evict();
+}
+
+//==============================================================================
+/// This returns how many snapshots the cache can hold
+std::size_t ForwardPassCache::getMaxEntries() const
+{
+  return mMaxEntries;
+}
+
+//==============================================================================
+/// This returns how many snapshots the cache is holding
+std::size_t ForwardPassCache::getNumEntries() const
+{
+  return mEntries.size();
+}
+
+//==============================================================================
+/// This returns the number of calls to find() that returned a snapshot
+long ForwardPassCache::getNumHits() const
+{
+  return mNumHits;
+}
+
+//==============================================================================
+/// This returns the number of calls to find() that returned nullptr
+long ForwardPassCache::getNumMisses() const
+{
+  return mNumMisses;
+}
+
+//==============================================================================
+/// This drops least recently used entries until there are at most
+/// mMaxEntries
+void ForwardPassCache::evict()
+{
+  while (mEntries.size() > mMaxEntries)
+  {
+    mIndex.erase(mEntries.back().key.hash);
+    mEntries.pop_back();
+  }
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,111 @@
+#ifndef DART_NEURAL_FORWARD_PASS_CACHE_HPP_
+#define DART_NEURAL_FORWARD_PASS_CACHE_HPP_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace dynamics {
+class Skeleton;
+}
+
+namespace neural {
+
+class BackpropSnapshot;
+
+/// This remembers the results of recent calls to forwardPass() on a World, so
+/// stepping from exactly the same inputs again (which line searches, IPOPT
+/// re-evaluations and finite differencing checks all do a lot) can hand back
+/// the old BackpropSnapshot instead of simulating and building a new one.
+///
+/// Entries are keyed on everything the step reads from: positions,
+/// velocities, control forces, external forces on each body, the timestep,
+/// gravity and the contact settings of the World, and the version of each
+/// Skeleton. The versions go up whenever anything about a Skeleton other than
+/// its state changes (masses, inertias, joint properties, shapes), so those
+/// invalidate old entries on their own. Anything else that changes how the
+/// World steps, like swapping out the collision detector, needs a clear().
+///
+/// The cache holds at most getMaxEntries() snapshots, and throws out the
+/// least recently used one to make room for a new one.
+class ForwardPassCache
+{
+public:
+  struct Key
+  {
+    Eigen::VectorXs values;
+    std::vector<std::pair<const dynamics::Skeleton*, std::size_t>> skeletons;
+    std::size_t hash;
+
+    bool operator==(const Key& other) const;
+  };
+
+  ForwardPassCache(std::size_t maxEntries);
+
+  /// This builds the key for stepping `world` from where it is now
+  static Key makeKey(simulation::World* world);
+
+  /// This returns the snapshot stored for `key`, or nullptr if there isn't
+  /// one. A hit makes the entry the most recently used.
+  std::shared_ptr<BackpropSnapshot> find(const Key& key);
+
+  /// This stores `snapshot` for `key`, throwing out the least recently used
+  /// entry if the cache is full
+  void insert(const Key& key, std::shared_ptr<BackpropSnapshot> snapshot);
+
+  /// This throws out every entry
+  void clear();
+
+  /// This sets how many snapshots the cache can hold, throwing out the least
+  /// recently used ones if it's holding more than that
+  void setMaxEntries(std::size_t maxEntries);
+
+  /// This returns how many snapshots the cache can hold
+  std::size_t getMaxEntries() const;
+
+  /// This returns how many snapshots the cache is holding
+  std::size_t getNumEntries() const;
+
+  /// This returns the number of calls to find() that returned a snapshot
+  long getNumHits() const;
+
+  /// This returns the number of calls to find() that returned nullptr
+  long getNumMisses() const;
+
+protected:
+  /// This drops least recently used entries until there are at most
+  /// mMaxEntries
+  void evict();
+
+  struct Entry
+  {
+    Key key;
+    std::shared_ptr<BackpropSnapshot> snapshot;
+  };
+
+  std::size_t mMaxEntries;
+  // Most recently used at the front
+  std::list<Entry> mEntries;
+  // Two keys with the same hash share a slot, and the newer one wins
+  std::unordered_map<std::size_t, std::list<Entry>::iterator> mIndex;
+  long mNumHits;
+  long mNumMisses;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
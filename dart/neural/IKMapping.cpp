@@ -15,7 +15,7 @@ namespace neural {
 
 //==============================================================================
 IKMapping::IKMapping(std::shared_ptr<simulation::World> world)
-  : mIKIterationLimit(100)
+  : mIKIterationLimit(100), mWarmStartEnabled(false)
 {
   mMassDim = world->getMassDims();
 }
@@ -39,6 +39,18 @@ int IKMapping::getIKIterationLimit()
   return mIKIterationLimit;
 }
 
+//==============================================================================
+void IKMapping::setWarmStartEnabled(bool enabled)
+{
+  mWarmStartEnabled = enabled;
+}
+
+//==============================================================================
+bool IKMapping::getWarmStartEnabled()
+{
+  return mWarmStartEnabled;
+}
+
 //==============================================================================
 void IKMapping::addSpatialBodyNode(dynamics::BodyNode* node)
 {
@@ -87,12 +99,27 @@ void IKMapping::setPositions(
     std::shared_ptr<simulation::World> world,
     const Eigen::Ref<Eigen::VectorXs>& positions)
 {
-  // Reset to 0, so that solutions are always deterministic even if IK is
-  // under/over specified
-  world->setPositions(Eigen::VectorXs::Zero(world->getNumDofs()));
+  Eigen::VectorXs initialPos = Eigen::VectorXs::Zero(world->getNumDofs());
+  if (mWarmStartEnabled)
+  {
+    // Start from wherever the world already is, which along a trajectory is
+    // the solution for the previous timestep
+    initialPos = world->getPositions();
+  }
+  else
+  {
+    // Reset to 0, so that solutions are always deterministic even if IK is
+    // under/over specified
+    world->setPositions(initialPos);
+  }
+
+  // Keep the last Jacobian the solver evaluated, so that if the solve ends
+  // where it was evaluated, getRealPosToMappedPosJac() can reuse it
+  Eigen::VectorXs lastJacPos;
+  Eigen::MatrixXs lastJac;
 
   math::solveIK(
-      Eigen::VectorXs::Zero(world->getNumDofs()),
+      initialPos,
       world->getPositionUpperLimits(),
       world->getPositionLowerLimits(),
       positions.size(),
@@ -105,10 +132,12 @@ void IKMapping::setPositions(
         }
         return pos;
       },
-      [this, world, positions](
+      [this, world, positions, &lastJacPos, &lastJac](
           Eigen::Ref<Eigen::VectorXs> diff, Eigen::Ref<Eigen::MatrixXs> J) {
         diff = getPositions(world) - positions;
         J = getPosJacobian(world);
+        lastJacPos = world->getPositions();
+        lastJac = J;
       },
       [](Eigen::Ref<Eigen::VectorXs> pos) {
         // Don't random restart here
@@ -116,6 +145,11 @@ void IKMapping::setPositions(
         assert(false);
       },
       math::IKConfig().setMaxStepCount(500).setMaxRestarts(1));
+
+  if (lastJacPos.size() > 0 && lastJacPos == world->getPositions())
+  {
+    cachePosJacobian(world, lastJacPos, lastJac);
+  }
 }
 
 //==============================================================================
@@ -260,7 +294,7 @@ void IKMapping::getMassesInPlace(
 Eigen::MatrixXs IKMapping::getRealPosToMappedPosJac(
     std::shared_ptr<simulation::World> world)
 {
-  Eigen::MatrixXs J = getPosJacobian(world);
+  Eigen::MatrixXs J = getCachedPosJacobian(world);
   if (world->getSlowDebugResultsAgainstFD())
   {
     equalsOrCrash(
@@ -419,11 +453,89 @@ Eigen::MatrixXs IKMapping::getPosJacobian(
 Eigen::MatrixXs IKMapping::getPosJacobianInverse(
     std::shared_ptr<simulation::World> world)
 {
-  Eigen::MatrixXs J = getPosJacobian(world);
+  Eigen::MatrixXs J = getCachedPosJacobian(world);
   // return math::clippedSingularsPinv(J);
   return J.completeOrthogonalDecomposition().pseudoInverse();
 }
 
+//==============================================================================
+/// This returns getPosJacobian(), reusing the last Jacobian we computed
+/// for this world if its positions and body scales haven't changed since.
+Eigen::MatrixXs IKMapping::getCachedPosJacobian(
+    std::shared_ptr<simulation::World> world)
+{
+  Eigen::VectorXs positions = world->getPositions();
+  Eigen::VectorXs scales = getWorldBodyScales(world);
+  {
+    std::lock_guard<std::mutex> lock(mPosJacobianCacheMutex);
+    auto it = mPosJacobianCache.find(world.get());
+    if (it != mPosJacobianCache.end())
+    {
+      const PosJacobianCache& cache = it->second;
+      // Entries can be added after we cached, which changes the rows
+      if (cache.world.lock() == world && cache.jac.rows() == getDim()
+          && cache.positions.size() == positions.size()
+          && cache.positions == positions
+          && cache.scales.size() == scales.size() && cache.scales == scales)
+      {
+        return cache.jac;
+      }
+    }
+  }
+
+  Eigen::MatrixXs jac = getPosJacobian(world);
+  cachePosJacobian(world, positions, jac);
+  return jac;
+}
+
+//==============================================================================
+/// This records a pos Jacobian for `world`, computed at `positions`, so
+/// that getCachedPosJacobian() can reuse it.
+void IKMapping::cachePosJacobian(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::VectorXs& positions,
+    const Eigen::MatrixXs& jac)
+{
+  PosJacobianCache cache;
+  cache.world = world;
+  cache.positions = positions;
+  cache.scales = getWorldBodyScales(world);
+  cache.jac = jac;
+
+  std::lock_guard<std::mutex> lock(mPosJacobianCacheMutex);
+  // Drop any worlds that have since been freed, so the cache doesn't grow
+  // with every temporary clone we're handed
+  for (auto it = mPosJacobianCache.begin(); it != mPosJacobianCache.end();)
+  {
+    if (it->second.world.expired())
+      it = mPosJacobianCache.erase(it);
+    else
+      it++;
+  }
+  mPosJacobianCache[world.get()] = cache;
+}
+
+//==============================================================================
+/// This concatenates the body scales of every skeleton in the world.
+Eigen::VectorXs IKMapping::getWorldBodyScales(
+    std::shared_ptr<simulation::World> world)
+{
+  int dim = 0;
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    dim += world->getSkeleton(i)->getNumBodyNodes() * 3;
+  }
+  Eigen::VectorXs scales = Eigen::VectorXs::Zero(dim);
+  int cursor = 0;
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    Eigen::VectorXs skelScales = world->getSkeleton(i)->getBodyScales();
+    scales.segment(cursor, skelScales.size()) = skelScales;
+    cursor += skelScales.size();
+  }
+  return scales;
+}
+
 /// Computes a Jacobian that transforms changes in joint vel to changes in
 /// IK body vels (expressed in log space).
 Eigen::MatrixXs IKMapping::getVelJacobian(
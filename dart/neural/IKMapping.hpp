@@ -2,8 +2,10 @@
 #define DART_NEURAL_IK_MAPPING_HPP_
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 
 #include <Eigen/Dense>
 
@@ -48,6 +50,14 @@ public:
   void setIKIterationLimit(int limit);
   int getIKIterationLimit();
 
+  /// If this is true, setPositions() starts its IK solve from the world's
+  /// current positions (usually the solution for the previous timestep)
+  /// rather than from zero. Along a trajectory this converges in a handful of
+  /// steps, but when the IK is under-specified the solution then depends on
+  /// where the world was before. Defaults to false.
+  void setWarmStartEnabled(bool enabled);
+  bool getWarmStartEnabled();
+
   /// This adds the spatial (6D) coordinates of a body node to the list,
   /// increasing Dim size by 6
   void addSpatialBodyNode(dynamics::BodyNode* node);
@@ -172,10 +182,45 @@ protected:
   Eigen::MatrixXs bruteForceJacobianOfJacVelWrtPosition(
       std::shared_ptr<simulation::World> world);
 
+  /// This returns getPosJacobian(), reusing the last Jacobian we computed
+  /// for this world if its positions and body scales haven't changed since.
+  /// This is safe to call from several threads, as long as each one uses its
+  /// own world.
+  Eigen::MatrixXs getCachedPosJacobian(
+      std::shared_ptr<simulation::World> world);
+
+  /// This records a pos Jacobian for `world`, computed at `positions`, so
+  /// that getCachedPosJacobian() can reuse it.
+  void cachePosJacobian(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::VectorXs& positions,
+      const Eigen::MatrixXs& jac);
+
+  /// This concatenates the body scales of every skeleton in the world, which
+  /// together with the positions determines the pos Jacobian.
+  Eigen::VectorXs getWorldBodyScales(std::shared_ptr<simulation::World> world);
+
+  struct PosJacobianCache
+  {
+    // This lets us tell a world that has been freed apart from a new one that
+    // happens to have been allocated at the same address.
+    std::weak_ptr<simulation::World> world;
+    Eigen::VectorXs positions;
+    Eigen::VectorXs scales;
+    Eigen::MatrixXs jac;
+  };
+
   std::vector<IKMappingEntry> mEntries;
 
   int mMassDim;
   int mIKIterationLimit;
+  bool mWarmStartEnabled;
+
+  // MultiShot shares a single mapping between all its parallel world clones,
+  // so the cache is kept per-world and guarded by a mutex.
+  std::unordered_map<const simulation::World*, PosJacobianCache>
+      mPosJacobianCache;
+  std::mutex mPosJacobianCacheMutex;
 };
 
 } // namespace neural
@@ -0,0 +1,104 @@
+#include "dart/neural/JacobianCacheBudget.hpp"
+
+#include "dart/neural/BackpropSnapshot.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+JacobianCacheBudget::JacobianCacheBudget(std::size_t maxBytes)
+  : mMaxBytes(maxBytes), mUsedBytes(0)
+{
+}
+
+//==============================================================================
+/// This sets the byte limit, and evicts immediately if we're over it
+void JacobianCacheBudget::setMaxBytes(std::size_t maxBytes)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mMaxBytes = maxBytes;
+  evictLocked(nullptr);
+}
+
+//==============================================================================
+/// This returns the byte limit, or 0 if there isn't one
+std::size_t JacobianCacheBudget::getMaxBytes() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mMaxBytes;
+}
+
+//==============================================================================
+/// This returns the total bytes currently cached by snapshots on this budget
+std::size_t JacobianCacheBudget::getUsedBytes() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mUsedBytes;
+}
+
+//==============================================================================
+/// This returns the number of snapshots currently holding caches
+int JacobianCacheBudget::getNumTrackedSnapshots() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLru.size();
+}
+
+//==============================================================================
+/// A snapshot calls this after it fills a cache, with its new total cache
+/// size. This marks it most recently used, then evicts other snapshots (least
+/// recently used first) until we're back under the limit.
+void JacobianCacheBudget::touch(BackpropSnapshot* snapshot, std::size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto found = mIndex.find(snapshot);
+  if (found != mIndex.end())
+  {
+    mUsedBytes -= found->second->second;
+    mLru.erase(found->second);
+  }
+  mLru.emplace_back(snapshot, bytes);
+  mIndex[snapshot] = std::prev(mLru.end());
+  mUsedBytes += bytes;
+  evictLocked(snapshot);
+}
+
+//==============================================================================
+/// A snapshot calls this when it frees its caches, or is destroyed
+void JacobianCacheBudget::remove(BackpropSnapshot* snapshot)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto found = mIndex.find(snapshot);
+  if (found == mIndex.end())
+    return;
+  mUsedBytes -= found->second->second;
+  mLru.erase(found->second);
+  mIndex.erase(found);
+}
+
+//==============================================================================
+/// This evicts LRU snapshots other than `keep` until we're under the limit.
+/// This must be called with mMutex held.
+void JacobianCacheBudget::evictLocked(BackpropSnapshot* keep)
+{
+  if (mMaxBytes == 0)
+    return;
+  auto it = mLru.begin();
+  while (mUsedBytes > mMaxBytes && it != mLru.end())
+  {
+    if (it->first == keep)
+    {
+      it++;
+      continue;
+    }
+    // Holding the lock here also keeps the victim's destructor (which calls
+    // remove()) from racing with us
+    it->first->freeCachedJacobians();
+    mUsedBytes -= it->second;
+    mIndex.erase(it->first);
+    it = mLru.erase(it);
+  }
+}
+
+} // namespace neural
+} // namespace dart
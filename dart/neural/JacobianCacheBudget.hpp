@@ -0,0 +1,73 @@
+#ifndef DART_NEURAL_JACOBIAN_CACHE_BUDGET_HPP_
+#define DART_NEURAL_JACOBIAN_CACHE_BUDGET_HPP_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace dart {
+namespace neural {
+
+class BackpropSnapshot;
+
+/// This caps the total memory that a set of BackpropSnapshots spend on their
+/// cached Jacobians. Every snapshot that shares a budget reports its cache
+/// size after it fills a cache, and if the total goes over the limit the
+/// least recently used snapshots drop their caches (they get recomputed on
+/// demand if they're asked for again).
+///
+/// Snapshots never evict themselves, so references returned by a snapshot's
+/// getters stay valid until a *different* snapshot on the same budget fills a
+/// cache. That means a budget should only be shared by snapshots that are used
+/// from one thread at a time, like the snapshots of a single trajectory.
+class JacobianCacheBudget
+{
+public:
+  /// A budget of 0 bytes means "unlimited", which just tracks usage
+  JacobianCacheBudget(std::size_t maxBytes = 0);
+
+  /// This sets the byte limit, and evicts immediately if we're over it
+  void setMaxBytes(std::size_t maxBytes);
+
+  /// This returns the byte limit, or 0 if there isn't one
+  std::size_t getMaxBytes() const;
+
+  /// This returns the total bytes currently cached by snapshots on this budget
+  std::size_t getUsedBytes() const;
+
+  /// This returns the number of snapshots currently holding caches
+  int getNumTrackedSnapshots() const;
+
+  /// A snapshot calls this after it fills a cache, with its new total cache
+  /// size. This marks it most recently used, then evicts other snapshots (least
+  /// recently used first) until we're back under the limit.
+  void touch(BackpropSnapshot* snapshot, std::size_t bytes);
+
+  /// A snapshot calls this when it frees its caches, or is destroyed
+  void remove(BackpropSnapshot* snapshot);
+
+protected:
+  /// This evicts LRU snapshots other than `keep` until we're under the limit.
+  /// This must be called with mMutex held.
+  void evictLocked(BackpropSnapshot* keep);
+
+  mutable std::mutex mMutex;
+  std::size_t mMaxBytes;
+  std::size_t mUsedBytes;
+  // Front is least recently used
+  std::list<std::pair<BackpropSnapshot*, std::size_t>> mLru;
+  std::unordered_map<
+      BackpropSnapshot*,
+      std::list<std::pair<BackpropSnapshot*, std::size_t>>::iterator>
+      mIndex;
+};
+
+using JacobianCacheBudgetPtr = std::shared_ptr<JacobianCacheBudget>;
+
+} // namespace neural
+} // namespace dart
+
+#endif
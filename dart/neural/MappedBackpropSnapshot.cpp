@@ -82,112 +82,154 @@ const Eigen::MatrixXs& MappedBackpropSnapshot::getMassVelJacobian(
 }
 
 //==============================================================================
-Eigen::MatrixXs MappedBackpropSnapshot::getPosMappedPosJacobian(
+const Eigen::MatrixXs& MappedBackpropSnapshot::getPosMappedPosJacobian(
     std::shared_ptr<simulation::World> world,
     const std::string& mapAfter,
     PerformanceLog* perfLog)
 {
+  auto cached = mCachedPosMappedPos.find(mapAfter);
+  if (cached != mCachedPosMappedPos.end())
+  {
+    return cached->second;
+  }
+
+  const PostStepMapping& post = getPostStepMapping(world, mapAfter);
   Eigen::MatrixXs jac
-      = mPostStepMappings[mapAfter].posInJacWrtPos
+      = post.posInJacWrtPos
             * mBackpropSnapshot->getPosPosJacobian(world, perfLog)
-        + mPostStepMappings[mapAfter].posInJacWrtVel
+        + post.posInJacWrtVel
               * mBackpropSnapshot->getPosVelJacobian(world, perfLog);
   if (world->getSlowDebugResultsAgainstFD())
   {
     Eigen::MatrixXs fd = finiteDifferencePosPosJacobian(world, mapAfter, 1);
     mBackpropSnapshot->equalsOrCrash(world, jac, fd, "pos->mapped pos");
   }
-  return jac;
+  return mCachedPosMappedPos[mapAfter] = jac;
 }
 
 //==============================================================================
-Eigen::MatrixXs MappedBackpropSnapshot::getPosMappedVelJacobian(
+const Eigen::MatrixXs& MappedBackpropSnapshot::getPosMappedVelJacobian(
     std::shared_ptr<simulation::World> world,
     const std::string& mapAfter,
     PerformanceLog* perfLog)
 {
+  auto cached = mCachedPosMappedVel.find(mapAfter);
+  if (cached != mCachedPosMappedVel.end())
+  {
+    return cached->second;
+  }
+
+  const PostStepMapping& post = getPostStepMapping(world, mapAfter);
   Eigen::MatrixXs jac
-      = mPostStepMappings[mapAfter].velInJacWrtPos
+      = post.velInJacWrtPos
             * mBackpropSnapshot->getPosPosJacobian(world, perfLog)
-        + mPostStepMappings[mapAfter].velInJacWrtVel
+        + post.velInJacWrtVel
               * mBackpropSnapshot->getPosVelJacobian(world, perfLog);
   if (world->getSlowDebugResultsAgainstFD())
   {
     Eigen::MatrixXs fd = finiteDifferencePosVelJacobian(world, mapAfter, 1);
     mBackpropSnapshot->equalsOrCrash(world, jac, fd, "pos->mapped vel");
   }
-  return jac;
+  return mCachedPosMappedVel[mapAfter] = jac;
 }
 
 //==============================================================================
-Eigen::MatrixXs MappedBackpropSnapshot::getVelMappedPosJacobian(
+const Eigen::MatrixXs& MappedBackpropSnapshot::getVelMappedPosJacobian(
     std::shared_ptr<simulation::World> world,
     const std::string& mapAfter,
     PerformanceLog* perfLog)
 {
+  auto cached = mCachedVelMappedPos.find(mapAfter);
+  if (cached != mCachedVelMappedPos.end())
+  {
+    return cached->second;
+  }
+
+  const PostStepMapping& post = getPostStepMapping(world, mapAfter);
   Eigen::MatrixXs jac
-      = mPostStepMappings[mapAfter].posInJacWrtPos
+      = post.posInJacWrtPos
             * mBackpropSnapshot->getVelPosJacobian(world, perfLog)
-        + mPostStepMappings[mapAfter].posInJacWrtVel
+        + post.posInJacWrtVel
               * mBackpropSnapshot->getVelVelJacobian(world, perfLog);
   if (world->getSlowDebugResultsAgainstFD())
   {
     Eigen::MatrixXs fd = finiteDifferenceVelPosJacobian(world, mapAfter, 1);
     mBackpropSnapshot->equalsOrCrash(world, jac, fd, "vel->mapped pos");
   }
-  return jac;
+  return mCachedVelMappedPos[mapAfter] = jac;
 }
 
 //==============================================================================
-Eigen::MatrixXs MappedBackpropSnapshot::getVelMappedVelJacobian(
+const Eigen::MatrixXs& MappedBackpropSnapshot::getVelMappedVelJacobian(
     std::shared_ptr<simulation::World> world,
     const std::string& mapAfter,
     PerformanceLog* perfLog)
 {
+  auto cached = mCachedVelMappedVel.find(mapAfter);
+  if (cached != mCachedVelMappedVel.end())
+  {
+    return cached->second;
+  }
+
+  const PostStepMapping& post = getPostStepMapping(world, mapAfter);
   Eigen::MatrixXs jac
-      = mPostStepMappings[mapAfter].velInJacWrtPos
+      = post.velInJacWrtPos
             * mBackpropSnapshot->getVelPosJacobian(world, perfLog)
-        + mPostStepMappings[mapAfter].velInJacWrtVel
+        + post.velInJacWrtVel
               * mBackpropSnapshot->getVelVelJacobian(world, perfLog);
   if (world->getSlowDebugResultsAgainstFD())
   {
     Eigen::MatrixXs fd = finiteDifferenceVelVelJacobian(world, mapAfter, 1);
     mBackpropSnapshot->equalsOrCrash(world, jac, fd, "vel->mapped vel");
   }
-  return jac;
+  return mCachedVelMappedVel[mapAfter] = jac;
 }
 
 //==============================================================================
-Eigen::MatrixXs MappedBackpropSnapshot::getControlForceMappedVelJacobian(
+const Eigen::MatrixXs& MappedBackpropSnapshot::getControlForceMappedVelJacobian(
     std::shared_ptr<simulation::World> world,
     const std::string& mapAfter,
     PerformanceLog* perfLog)
 {
+  auto cached = mCachedForceMappedVel.find(mapAfter);
+  if (cached != mCachedForceMappedVel.end())
+  {
+    return cached->second;
+  }
+
+  const PostStepMapping& post = getPostStepMapping(world, mapAfter);
   Eigen::MatrixXs jac
-      = mPostStepMappings[mapAfter].velInJacWrtVel
+      = post.velInJacWrtVel
         * mBackpropSnapshot->getControlForceVelJacobian(world, perfLog);
   if (world->getSlowDebugResultsAgainstFD())
   {
     Eigen::MatrixXs fd = finiteDifferenceForceVelJacobian(world, mapAfter, 1);
     mBackpropSnapshot->equalsOrCrash(world, jac, fd, "force->mapped vel");
   }
-  return jac;
+  return mCachedForceMappedVel[mapAfter] = jac;
 }
 
 //==============================================================================
-Eigen::MatrixXs MappedBackpropSnapshot::getMassMappedVelJacobian(
+const Eigen::MatrixXs& MappedBackpropSnapshot::getMassMappedVelJacobian(
     std::shared_ptr<simulation::World> world,
     const std::string& mapAfter,
     PerformanceLog* perfLog)
 {
-  Eigen::MatrixXs jac = mPostStepMappings[mapAfter].velInJacWrtVel
+  auto cached = mCachedMassMappedVel.find(mapAfter);
+  if (cached != mCachedMassMappedVel.end())
+  {
+    return cached->second;
+  }
+
+  const PostStepMapping& post = getPostStepMapping(world, mapAfter);
+  Eigen::MatrixXs jac = post.velInJacWrtVel
                         * mBackpropSnapshot->getMassVelJacobian(world, perfLog);
   if (world->getSlowDebugResultsAgainstFD())
   {
     Eigen::MatrixXs fd = finiteDifferenceForceVelJacobian(world, mapAfter, 1);
     mBackpropSnapshot->equalsOrCrash(world, jac, fd, "mass->mapped vel");
   }
-  return jac;
+  return mCachedMassMappedVel[mapAfter] = jac;
 }
 
 //==============================================================================
@@ -261,16 +303,13 @@ void MappedBackpropSnapshot::backprop(
       = Eigen::VectorXs::Zero(world->getNumDofs());
   for (auto pair : nextTimestepLosses)
   {
+    const PostStepMapping& post = getPostStepMapping(world, pair.first);
     nextTimestepRealLoss.lossWrtPosition
-        += mPostStepMappings[pair.first].posInJacWrtPos.transpose()
-               * pair.second.lossWrtPosition
-           + mPostStepMappings[pair.first].velInJacWrtPos.transpose()
-                 * pair.second.lossWrtVelocity;
+        += post.posInJacWrtPos.transpose() * pair.second.lossWrtPosition
+           + post.velInJacWrtPos.transpose() * pair.second.lossWrtVelocity;
     nextTimestepRealLoss.lossWrtVelocity
-        = mPostStepMappings[pair.first].posInJacWrtVel.transpose()
-              * pair.second.lossWrtPosition
-          + mPostStepMappings[pair.first].velInJacWrtVel.transpose()
-                * pair.second.lossWrtVelocity;
+        += post.posInJacWrtVel.transpose() * pair.second.lossWrtPosition
+           + post.velInJacWrtVel.transpose() * pair.second.lossWrtVelocity;
   }
   mBackpropSnapshot->backprop(
       world,
@@ -589,6 +628,24 @@ Eigen::MatrixXs MappedBackpropSnapshot::finiteDifferenceVelPosJacobian(
   return result;
 }
 
+//==============================================================================
+/// This returns the post-step mapping for `mapping`, computing its
+/// Jacobians first if nobody has asked for them yet.
+const PostStepMapping& MappedBackpropSnapshot::getPostStepMapping(
+    std::shared_ptr<simulation::World> world, const std::string& mapping)
+{
+  PostStepMapping& post = mPostStepMappings[mapping];
+  if (!post.jacobiansComputed)
+  {
+    RestorableSnapshot snapshot(world);
+    world->setPositions(mBackpropSnapshot->mPostStepPosition);
+    world->setVelocities(mBackpropSnapshot->mPostStepVelocity);
+    post.computeJacobians(world, mMappings[mapping]);
+    snapshot.restore();
+  }
+  return post;
+}
+
 //==============================================================================
 /// Returns the underlying BackpropSnapshot, without the mappings
 std::shared_ptr<BackpropSnapshot>
@@ -52,27 +52,41 @@ struct PreStepMapping
 struct PostStepMapping
 {
   Eigen::VectorXs pos;
+  Eigen::VectorXs vel;
+
+  // The Jacobians below are only needed for backprop, and some mappings
+  // (like IK) are expensive to differentiate, so they're left empty until
+  // MappedBackpropSnapshot::getPostStepMapping() first asks for them.
+  bool jacobiansComputed;
+
   Eigen::MatrixXs posInJacWrtPos;
   Eigen::MatrixXs posInJacWrtVel;
 
-  Eigen::VectorXs vel;
   Eigen::MatrixXs velInJacWrtPos;
   Eigen::MatrixXs velInJacWrtVel;
 
   PostStepMapping(
       std::shared_ptr<simulation::World> world,
       std::shared_ptr<Mapping> mapping)
+    : jacobiansComputed(false)
   {
     pos = mapping->getPositions(world);
+    vel = mapping->getVelocities(world);
+  }
+
+  /// This fills in the Jacobians. The world must be at its post-step state.
+  void computeJacobians(
+      std::shared_ptr<simulation::World> world,
+      std::shared_ptr<Mapping> mapping)
+  {
     posInJacWrtPos = mapping->getRealPosToMappedPosJac(world);
     posInJacWrtVel = mapping->getRealVelToMappedPosJac(world);
-
-    vel = mapping->getVelocities(world);
     velInJacWrtPos = mapping->getRealPosToMappedVelJac(world);
     velInJacWrtVel = mapping->getRealVelToMappedVelJac(world);
+    jacobiansComputed = true;
   }
 
-  PostStepMapping(){};
+  PostStepMapping() : jacobiansComputed(false){};
 };
 
 class MappedBackpropSnapshot
@@ -105,27 +119,29 @@ public:
       std::shared_ptr<simulation::World> world,
       PerformanceLog* perfLog = nullptr);
 
-  Eigen::MatrixXs getPosMappedPosJacobian(
+  /// These return the Jacobians of the step into the `mapAfter` space. Each
+  /// one is computed on first use and cached on the snapshot.
+  const Eigen::MatrixXs& getPosMappedPosJacobian(
       std::shared_ptr<simulation::World> world,
       const std::string& mapAfter,
       PerformanceLog* perfLog = nullptr);
-  Eigen::MatrixXs getPosMappedVelJacobian(
+  const Eigen::MatrixXs& getPosMappedVelJacobian(
       std::shared_ptr<simulation::World> world,
       const std::string& mapAfter,
       PerformanceLog* perfLog = nullptr);
-  Eigen::MatrixXs getVelMappedPosJacobian(
+  const Eigen::MatrixXs& getVelMappedPosJacobian(
       std::shared_ptr<simulation::World> world,
       const std::string& mapAfter,
       PerformanceLog* perfLog = nullptr);
-  Eigen::MatrixXs getVelMappedVelJacobian(
+  const Eigen::MatrixXs& getVelMappedVelJacobian(
       std::shared_ptr<simulation::World> world,
       const std::string& mapAfter,
       PerformanceLog* perfLog = nullptr);
-  Eigen::MatrixXs getControlForceMappedVelJacobian(
+  const Eigen::MatrixXs& getControlForceMappedVelJacobian(
       std::shared_ptr<simulation::World> world,
       const std::string& mapAfter,
       PerformanceLog* perfLog = nullptr);
-  Eigen::MatrixXs getMassMappedVelJacobian(
+  const Eigen::MatrixXs& getMassMappedVelJacobian(
       std::shared_ptr<simulation::World> world,
       const std::string& mapAfter,
       PerformanceLog* perfLog = nullptr);
@@ -212,11 +228,25 @@ public:
       bool useRidders = true);
 
 protected:
+  /// This returns the post-step mapping for `mapping`, computing its
+  /// Jacobians first if nobody has asked for them yet. That temporarily moves
+  /// `world` back to its post-step state.
+  const PostStepMapping& getPostStepMapping(
+      std::shared_ptr<simulation::World> world, const std::string& mapping);
+
   std::shared_ptr<BackpropSnapshot> mBackpropSnapshot;
   std::vector<std::string> mMappingsSet;
   std::unordered_map<std::string, std::shared_ptr<Mapping>> mMappings;
   std::unordered_map<std::string, PreStepMapping> mPreStepMappings;
   std::unordered_map<std::string, PostStepMapping> mPostStepMappings;
+
+  // Mapped Jacobians, keyed by mapAfter, filled in on first use
+  std::unordered_map<std::string, Eigen::MatrixXs> mCachedPosMappedPos;
+  std::unordered_map<std::string, Eigen::MatrixXs> mCachedPosMappedVel;
+  std::unordered_map<std::string, Eigen::MatrixXs> mCachedVelMappedPos;
+  std::unordered_map<std::string, Eigen::MatrixXs> mCachedVelMappedVel;
+  std::unordered_map<std::string, Eigen::MatrixXs> mCachedForceMappedVel;
+  std::unordered_map<std::string, Eigen::MatrixXs> mCachedMassMappedVel;
 };
 
 using MappedBackpropSnapshotPtr = std::shared_ptr<MappedBackpropSnapshot>;
@@ -0,0 +1,81 @@
+#include "dart/neural/MassMatrixOperator.hpp"
+
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+MassMatrixOperator::MassMatrixOperator(
+    std::shared_ptr<simulation::World> world)
+  : mDim(0)
+{
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    std::shared_ptr<dynamics::Skeleton> skel = world->getSkeleton(i);
+    mSkeletons.push_back(skel);
+    mOffsets.push_back(mDim);
+    mDim += skel->getNumDofs();
+  }
+}
+
+//==============================================================================
+/// This returns the number of rows (and columns) of the full matrix
+int MassMatrixOperator::rows() const
+{
+  return mDim;
+}
+
+//==============================================================================
+/// This returns the number of columns (and rows) of the full matrix
+int MassMatrixOperator::cols() const
+{
+  return mDim;
+}
+
+//==============================================================================
+/// This returns M*x, column by column, without forming M
+Eigen::MatrixXs MassMatrixOperator::multiply(const Eigen::MatrixXs& x) const
+{
+  assert(x.rows() == mDim);
+  Eigen::MatrixXs result(mDim, x.cols());
+  for (int i = 0; i < mSkeletons.size(); i++)
+  {
+    int dofs = mSkeletons[i]->getNumDofs();
+    if (dofs == 0)
+      continue;
+    for (int col = 0; col < x.cols(); col++)
+    {
+      result.block(mOffsets[i], col, dofs, 1)
+          = mSkeletons[i]->multiplyByImplicitMassMatrix(
+              x.block(mOffsets[i], col, dofs, 1));
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns Minv*x, column by column, without forming Minv
+Eigen::MatrixXs MassMatrixOperator::multiplyByInverse(
+    const Eigen::MatrixXs& x) const
+{
+  assert(x.rows() == mDim);
+  Eigen::MatrixXs result(mDim, x.cols());
+  for (int i = 0; i < mSkeletons.size(); i++)
+  {
+    int dofs = mSkeletons[i]->getNumDofs();
+    if (dofs == 0)
+      continue;
+    for (int col = 0; col < x.cols(); col++)
+    {
+      result.block(mOffsets[i], col, dofs, 1)
+          = mSkeletons[i]->multiplyByImplicitInvMassMatrix(
+              x.block(mOffsets[i], col, dofs, 1));
+    }
+  }
+  return result;
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,62 @@
+#ifndef DART_NEURAL_MASS_MATRIX_OPERATOR_HPP_
+#define DART_NEURAL_MASS_MATRIX_OPERATOR_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace dynamics {
+class Skeleton;
+}
+
+namespace neural {
+
+/// This is a matrix-free stand-in for a world's (block diagonal) mass matrix
+/// and its inverse. It applies M or Minv to vectors and thin matrices one
+/// Skeleton at a time, through the articulated-body passes in
+/// Skeleton::multiplyByImplicitMassMatrix() and
+/// Skeleton::multiplyByImplicitInvMassMatrix(), so neither matrix is ever
+/// formed. Each column costs O(n), where forming Minv costs O(n^2) and
+/// applying it costs another O(n^2) per column.
+///
+/// This reads the world's state at the moment it's applied, so the caller is
+/// responsible for putting the world at the right positions first. Applying
+/// the operator temporarily overwrites (and then restores) the accelerations
+/// or control forces of each Skeleton, so it's not safe to share a world
+/// across threads while it runs.
+class MassMatrixOperator
+{
+public:
+  MassMatrixOperator(std::shared_ptr<simulation::World> world);
+
+  /// This returns the number of rows (and columns) of the full matrix
+  int rows() const;
+
+  /// This returns the number of columns (and rows) of the full matrix
+  int cols() const;
+
+  /// This returns M*x, column by column, without forming M
+  Eigen::MatrixXs multiply(const Eigen::MatrixXs& x) const;
+
+  /// This returns Minv*x, column by column, without forming Minv
+  Eigen::MatrixXs multiplyByInverse(const Eigen::MatrixXs& x) const;
+
+protected:
+  std::vector<std::shared_ptr<dynamics::Skeleton>> mSkeletons;
+  std::vector<int> mOffsets;
+  int mDim;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
@@ -3,10 +3,12 @@
 #include <memory>
 #include <thread>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
+#include "dart/neural/ForwardPassCache.hpp"
 #include "dart/neural/MappedBackpropSnapshot.hpp"
 #include "dart/neural/Mapping.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
@@ -26,6 +28,24 @@ std::shared_ptr<ConstrainedGroupGradientMatrices> createGradientMatrices(
 std::shared_ptr<BackpropSnapshot> forwardPass(
     simulation::WorldPtr world, bool idempotent)
 {
+  // Sleeping Skeletons don't get stepped, and which ones are asleep isn't part
+  // of the cache key, so skip the cache when sleeping is on
+  std::shared_ptr<ForwardPassCache> cache = world->getForwardPassCache();
+  if (cache && world->getSleepingEnabled())
+    cache = nullptr;
+  ForwardPassCache::Key cacheKey;
+  if (cache)
+  {
+    cacheKey = ForwardPassCache::makeKey(world.get());
+    std::shared_ptr<BackpropSnapshot> cached = cache->find(cacheKey);
+    if (cached)
+    {
+      if (!idempotent)
+        world->replayStep(cached, true);
+      return cached;
+    }
+  }
+
   std::shared_ptr<RestorableSnapshot> restorableSnapshot;
   if (idempotent)
   {
@@ -62,9 +82,42 @@ std::shared_ptr<BackpropSnapshot> forwardPass(
   if (idempotent)
     restorableSnapshot->restore();
 
+  if (cache)
+    cache->insert(cacheKey, snapshot);
+
   return snapshot;
 }
 
+//==============================================================================
+/// This runs forwardPass() on the global common::ThreadPool, and returns a
+/// future for its snapshot. Don't read or change the world until the future
+/// is ready.
+std::future<std::shared_ptr<BackpropSnapshot>> forwardPassAsync(
+    simulation::WorldPtr world, bool idempotent)
+{
+  return common::ThreadPool::getGlobal().submit(
+      [world, idempotent]() { return forwardPass(world, idempotent); });
+}
+
+//==============================================================================
+std::vector<std::shared_ptr<BackpropSnapshot>> adaptiveForwardPass(
+    simulation::WorldPtr world, bool idempotent)
+{
+  std::shared_ptr<RestorableSnapshot> restorableSnapshot;
+  if (idempotent)
+  {
+    restorableSnapshot = std::make_shared<RestorableSnapshot>(world);
+  }
+
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots;
+  world->stepAdaptive(!idempotent, &snapshots);
+
+  if (idempotent)
+    restorableSnapshot->restore();
+
+  return snapshots;
+}
+
 //==============================================================================
 /// Takes a step in the world, and returns a mapped snapshot which can be used
 /// to backpropagate gradients and compute Jacobians in the mapped space
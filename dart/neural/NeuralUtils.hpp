@@ -1,6 +1,7 @@
 #ifndef DART_NEURAL_UTILS_HPP_
 #define DART_NEURAL_UTILS_HPP_
 
+#include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -47,10 +48,24 @@ std::shared_ptr<ConstrainedGroupGradientMatrices> createGradientMatrices(
     constraint::ConstrainedGroup& group, s_t timeStep);
 
 /// Takes a step in the world, and returns a backprop snapshot which can be used
-/// to backpropagate gradients and compute Jacobians
+/// to backpropagate gradients and compute Jacobians. If the world has a
+/// forward pass cache (see World::setForwardPassCacheSize()) and it's seen
+/// these inputs before, this returns the snapshot from then without
+/// simulating.
 std::shared_ptr<BackpropSnapshot> forwardPass(
     std::shared_ptr<simulation::World> world, bool idempotent = false);
 
+/// This runs forwardPass() on the global common::ThreadPool, and returns a
+/// future for its snapshot. Don't read or change the world until the future
+/// is ready.
+std::future<std::shared_ptr<BackpropSnapshot>> forwardPassAsync(
+    std::shared_ptr<simulation::World> world, bool idempotent = false);
+
+/// Takes a step in the world with World::stepAdaptive(), and returns a backprop
+/// snapshot for each substep it took, in order
+std::vector<std::shared_ptr<BackpropSnapshot>> adaptiveForwardPass(
+    std::shared_ptr<simulation::World> world, bool idempotent = false);
+
 /// Takes a step in the world, and returns a mapped snapshot which can be used
 /// to backpropagate gradients and compute Jacobians in the mapped space
 std::shared_ptr<MappedBackpropSnapshot> mappedForwardPass(
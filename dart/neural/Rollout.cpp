@@ -0,0 +1,109 @@
+#include "dart/neural/Rollout.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/neural/WorldStatePool.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+/// This runs `actions.cols()` steps of `world` from `startState`, using one
+/// column of `actions` per step, and then backpropagates the loss all the way
+/// back to the start, without leaving C++.
+RolloutGradient rolloutAndBackprop(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::VectorXs& startState,
+    const Eigen::MatrixXs& actions,
+    RolloutLossGradFn lossGrad,
+    int checkpointEvery)
+{
+  const int steps = actions.cols();
+  const int stateSize = world->getStateSize();
+  assert(startState.size() == stateSize);
+  assert(actions.rows() == world->getActionSize());
+
+  RolloutGradient result;
+  result.states = Eigen::MatrixXs(stateSize, steps);
+  result.lossWrtActions = Eigen::MatrixXs::Zero(actions.rows(), steps);
+  result.lossWrtMass = Eigen::VectorXs::Zero(world->getMassDims());
+  if (steps == 0)
+  {
+    world->setStateFrom(startState);
+    result.lossWrtStartState = Eigen::VectorXs::Zero(stateSize);
+    return result;
+  }
+
+  const bool checkpointing = checkpointEvery > 0 && checkpointEvery < steps;
+  const int segmentLength = checkpointing ? checkpointEvery : steps;
+  const int numSegments = (steps + segmentLength - 1) / segmentLength;
+
+  // This holds the snapshots for the segment we're backpropagating through.
+  // Without checkpointing that's the whole rollout.
+  std::vector<std::shared_ptr<BackpropSnapshot>> segment(segmentLength);
+  // Slots [0, numSegments) are the checkpoints (if we're checkpointing), and
+  // the last slot is the final state
+  const int finalSlot = checkpointing ? numSegments : 0;
+  WorldStatePool states(world, finalSlot + 1);
+
+  world->setStateFrom(startState);
+  for (int t = 0; t < steps; t++)
+  {
+    if (checkpointing && t % segmentLength == 0)
+      states.saveInto(t / segmentLength);
+    world->setAction(actions.col(t));
+    std::shared_ptr<BackpropSnapshot> snapshot = forwardPass(world);
+    if (!checkpointing)
+      segment[t] = snapshot;
+    world->getState(result.states.col(t));
+  }
+  states.saveInto(finalSlot);
+
+  Eigen::MatrixXs lossWrtStates = lossGrad(result.states);
+  assert(lossWrtStates.rows() == stateSize);
+  assert(lossWrtStates.cols() == steps);
+
+  // This is the gradient of the loss with respect to the state after the step
+  // we're currently backpropagating through
+  Eigen::VectorXs stateGrad = Eigen::VectorXs::Zero(stateSize);
+  for (int s = numSegments - 1; s >= 0; s--)
+  {
+    const int start = s * segmentLength;
+    const int end = std::min(steps, start + segmentLength);
+    if (checkpointing)
+    {
+      // Replay this segment from its checkpoint to get the snapshots back
+      states.restoreFrom(s);
+      for (int t = start; t < end; t++)
+      {
+        world->setAction(actions.col(t));
+        segment[t - start] = forwardPass(world);
+      }
+    }
+
+    for (int t = end - 1; t >= start; t--)
+    {
+      stateGrad += lossWrtStates.col(t);
+      LossGradientHighLevelAPI grad
+          = segment[t - start]->backpropState(world, stateGrad);
+      result.lossWrtActions.col(t) = grad.lossWrtAction;
+      if (grad.lossWrtMass.size() == result.lossWrtMass.size())
+        result.lossWrtMass += grad.lossWrtMass;
+      stateGrad = grad.lossWrtState;
+      // Let go of each snapshot as soon as we're done with it
+      segment[t - start].reset();
+    }
+  }
+  result.lossWrtStartState = stateGrad;
+
+  states.restoreFrom(finalSlot);
+  return result;
+}
+
+} // namespace neural
+} // namespace dart
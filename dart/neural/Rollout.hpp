@@ -0,0 +1,67 @@
+#ifndef DART_NEURAL_ROLLOUT_HPP_
+#define DART_NEURAL_ROLLOUT_HPP_
+
+#include <functional>
+#include <memory>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+struct RolloutGradient
+{
+  // The state after each step, one column per step
+  Eigen::MatrixXs states;
+  // The gradient of the loss with respect to the state we started from
+  Eigen::VectorXs lossWrtStartState;
+  // The gradient of the loss with respect to each step's action, one column
+  // per step
+  Eigen::MatrixXs lossWrtActions;
+  // The gradient of the loss with respect to the world's masses, summed over
+  // every step
+  Eigen::VectorXs lossWrtMass;
+};
+
+/// This is given the state after every step of a rollout, one column per
+/// step, and returns the gradient of the loss with respect to each of them
+/// (in the same shape)
+typedef std::function<Eigen::MatrixXs(const Eigen::MatrixXs& states)>
+    RolloutLossGradFn;
+
+/// This runs `actions.cols()` steps of `world` from `startState`, using one
+/// column of `actions` per step, and then backpropagates the loss all the way
+/// back to the start, without leaving C++. This is equivalent to calling
+/// forwardPass() once per step and then chaining backpropState() calls back
+/// through the snapshots in reverse, but skips the per-step overhead of doing
+/// that from Python.
+///
+/// Once the forward sweep is done, `lossGrad` is called once with every
+/// state, and returns dLoss/dState for each step.
+///
+/// By default every step's BackpropSnapshot is kept in memory until the
+/// backward sweep, so memory grows linearly with the number of steps. Passing
+/// `checkpointEvery` = k > 0 only keeps the world's state every k steps,
+/// and re-simulates each k step segment during the backward sweep, holding at
+/// most k snapshots at once. That costs one extra forward pass per step, and
+/// k = sqrt(steps) minimizes memory.
+///
+/// When this returns, `world` is left in the state after the final step.
+RolloutGradient rolloutAndBackprop(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::VectorXs& startState,
+    const Eigen::MatrixXs& actions,
+    RolloutLossGradFn lossGrad,
+    int checkpointEvery = 0);
+
+} // namespace neural
+} // namespace dart
+
+#endif
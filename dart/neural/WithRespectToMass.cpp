@@ -184,6 +184,56 @@ void WrtMassBodyNodyEntry::get(
   }
 }
 
+//==============================================================================
+void WrtMassBodyNodyEntry::getSpatialTensorGradients(
+    dynamics::Skeleton* skel, common::aligned_vector<Eigen::Matrix6s>& out)
+{
+  using Param = dynamics::Inertia::Param;
+
+  dynamics::BodyNode* node = skel->getBodyNode(linkName);
+  const dynamics::Inertia& inertia = node->getInertia();
+  out.clear();
+  if (type == INERTIA_MASS)
+  {
+    out.push_back(inertia.getSpatialTensorGradient(Param::MASS));
+  }
+  else if (type == INERTIA_COM)
+  {
+    out.push_back(inertia.getSpatialTensorGradient(Param::COM_X));
+    out.push_back(inertia.getSpatialTensorGradient(Param::COM_Y));
+    out.push_back(inertia.getSpatialTensorGradient(Param::COM_Z));
+  }
+  else if (type == INERTIA_COM_MU)
+  {
+    // The COM is mu * beta, so chain through each COM component
+    Eigen::Vector3s beta = node->getBeta();
+    out.push_back(
+        beta(0) * inertia.getSpatialTensorGradient(Param::COM_X)
+        + beta(1) * inertia.getSpatialTensorGradient(Param::COM_Y)
+        + beta(2) * inertia.getSpatialTensorGradient(Param::COM_Z));
+  }
+  else if (type == INERTIA_DIAGONAL)
+  {
+    out.push_back(inertia.getSpatialTensorGradient(Param::I_XX));
+    out.push_back(inertia.getSpatialTensorGradient(Param::I_YY));
+    out.push_back(inertia.getSpatialTensorGradient(Param::I_ZZ));
+  }
+  else if (type == INERTIA_OFF_DIAGONAL)
+  {
+    out.push_back(inertia.getSpatialTensorGradient(Param::I_XY));
+    out.push_back(inertia.getSpatialTensorGradient(Param::I_XZ));
+    out.push_back(inertia.getSpatialTensorGradient(Param::I_YZ));
+  }
+  else if (type == INERTIA_FULL)
+  {
+    for (int i = Param::MASS; i <= Param::I_YZ; i++)
+    {
+      out.push_back(inertia.getSpatialTensorGradient(static_cast<Param>(i)));
+    }
+  }
+  assert(static_cast<int>(out.size()) == dim());
+}
+
 //==============================================================================
 /// This registers that we'd like to keep track of this node's mass in this
 /// way in this differentiation
@@ -247,6 +297,14 @@ WrtMassBodyNodyEntry& WithRespectToMass::getNode(dynamics::BodyNode* node)
   throw std::runtime_error{"Execution should never reach this point"};
 }
 
+//==============================================================================
+/// This returns the entries registered for this skeleton
+std::vector<WrtMassBodyNodyEntry>& WithRespectToMass::getEntries(
+    dynamics::Skeleton* skel)
+{
+  return mEntries[skel->getName()];
+}
+
 //==============================================================================
 /// This returns this WRT from the world as a vector
 Eigen::VectorXs WithRespectToMass::get(simulation::World* world)
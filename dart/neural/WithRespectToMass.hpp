@@ -8,6 +8,8 @@
 
 #include <Eigen/Dense>
 
+#include "dart/common/Memory.hpp"
+#include "dart/math/MathTypes.hpp"
 #include "dart/neural/WithRespectTo.hpp"
 
 namespace dart {
@@ -44,6 +46,13 @@ struct WrtMassBodyNodyEntry
   void get(dynamics::Skeleton* skel, Eigen::Ref<Eigen::VectorXs> out);
 
   void set(dynamics::Skeleton* skel, const Eigen::Ref<Eigen::VectorXs>& val);
+
+  /// This fills `out` with the derivative of this node's spatial inertia
+  /// tensor with respect to each of the values we track, in the same order as
+  /// get() and set()
+  void getSpatialTensorGradients(
+      dynamics::Skeleton* skel,
+      common::aligned_vector<Eigen::Matrix6s>& out);
 };
 
 class WithRespectToMass : public WithRespectTo
@@ -63,6 +72,10 @@ public:
   /// assertion if this node doesn't exist
   WrtMassBodyNodyEntry& getNode(dynamics::BodyNode* node);
 
+  /// This returns the entries registered for this skeleton, in the order their
+  /// values appear in get(skel)
+  std::vector<WrtMassBodyNodyEntry>& getEntries(dynamics::Skeleton* skel);
+
   //////////////////////////////////////////////////////////////
   // Implement all the methods we need
   //////////////////////////////////////////////////////////////
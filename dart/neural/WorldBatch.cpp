@@ -0,0 +1,233 @@
+#include "dart/neural/WorldBatch.hpp"
+
+#include <cassert>
+#include <future>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+WorldBatch::WorldBatch(std::shared_ptr<simulation::World> world, int numWorlds)
+{
+  assert(numWorlds > 0);
+  mWorlds.reserve(numWorlds);
+  for (int i = 0; i < numWorlds; i++)
+  {
+    mWorlds.push_back(world->clone());
+  }
+}
+
+//==============================================================================
+/// This returns the number of worlds in the batch
+int WorldBatch::getNumWorlds() const
+{
+  return mWorlds.size();
+}
+
+//==============================================================================
+/// This returns one of the worlds in the batch
+std::shared_ptr<simulation::World> WorldBatch::getWorld(int index) const
+{
+  return mWorlds.at(index);
+}
+
+//==============================================================================
+/// This returns the size of a single world's state vector
+int WorldBatch::getStateSize() const
+{
+  return mWorlds[0]->getStateSize();
+}
+
+//==============================================================================
+/// This returns the size of a single world's action vector
+int WorldBatch::getActionSize() const
+{
+  return mWorlds[0]->getActionSize();
+}
+
+//==============================================================================
+/// This reads the current state of every world, one column per world
+Eigen::MatrixXs WorldBatch::getStates() const
+{
+  Eigen::MatrixXs states(getStateSize(), mWorlds.size());
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    states.col(i) = mWorlds[i]->getState();
+  }
+  return states;
+}
+
+//==============================================================================
+/// This sets the state of every world, one column per world
+void WorldBatch::setStates(const Eigen::MatrixXs& states)
+{
+  assert(states.rows() == getStateSize());
+  assert(states.cols() == mWorlds.size());
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    mWorlds[i]->setStateFrom(states.col(i));
+  }
+}
+
+//==============================================================================
+/// This sets the action of every world, one column per world
+void WorldBatch::setActions(const Eigen::MatrixXs& actions)
+{
+  assert(actions.rows() == getActionSize());
+  assert(actions.cols() == mWorlds.size());
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    mWorlds[i]->setAction(actions.col(i));
+  }
+}
+
+//==============================================================================
+/// This sets the states and actions, steps every world in parallel, and
+/// returns the stacked next states. This does not record any gradient
+/// information, so it's the fastest option for pure rollouts.
+Eigen::MatrixXs WorldBatch::step(
+    const Eigen::MatrixXs& states, const Eigen::MatrixXs& actions)
+{
+  assert(states.cols() == mWorlds.size());
+  assert(actions.cols() == mWorlds.size());
+
+  Eigen::MatrixXs nextStates(getStateSize(), mWorlds.size());
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    futures.push_back(pool.submit([this, i, &states, &actions, &nextStates]() {
+      std::shared_ptr<simulation::World>& world = mWorlds[i];
+      world->setStateFrom(states.col(i));
+      world->setAction(actions.col(i));
+      world->step();
+      nextStates.col(i) = world->getState();
+    }));
+  }
+  pool.waitAll(futures);
+
+  return nextStates;
+}
+
+//==============================================================================
+/// This is the batched version of neural::forwardPass(). It sets the states
+/// and actions, steps every world in parallel, and returns the stacked next
+/// states along with a BackpropSnapshot for each world.
+BatchForwardPassResult WorldBatch::forwardPass(
+    const Eigen::MatrixXs& states,
+    const Eigen::MatrixXs& actions,
+    bool idempotent)
+{
+  return runForwardPass(states, actions, nullptr, idempotent);
+}
+
+//==============================================================================
+/// This is the same as forwardPass(), but first sets the masses of every
+/// world as well, one column per world, so that the gradient with respect
+/// to mass is meaningful for each world
+BatchForwardPassResult WorldBatch::forwardPass(
+    const Eigen::MatrixXs& states,
+    const Eigen::MatrixXs& actions,
+    const Eigen::MatrixXs& masses,
+    bool idempotent)
+{
+  assert(masses.rows() == mWorlds[0]->getMassDims());
+  assert(masses.cols() == mWorlds.size());
+  return runForwardPass(states, actions, &masses, idempotent);
+}
+
+//==============================================================================
+/// This is the shared implementation of both forwardPass() variants.
+/// `masses` may be null, in which case every world keeps its masses.
+BatchForwardPassResult WorldBatch::runForwardPass(
+    const Eigen::MatrixXs& states,
+    const Eigen::MatrixXs& actions,
+    const Eigen::MatrixXs* masses,
+    bool idempotent)
+{
+  assert(states.cols() == mWorlds.size());
+  assert(actions.cols() == mWorlds.size());
+
+  BatchForwardPassResult result;
+  result.nextStates = Eigen::MatrixXs(getStateSize(), mWorlds.size());
+  result.snapshots.resize(mWorlds.size());
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    futures.push_back(pool.submit(
+        [this, i, &states, &actions, masses, &result, idempotent]() {
+          std::shared_ptr<simulation::World>& world = mWorlds[i];
+          if (masses != nullptr)
+            world->setMasses(masses->col(i));
+          world->setStateFrom(states.col(i));
+          world->setAction(actions.col(i));
+          result.snapshots[i] = neural::forwardPass(world, idempotent);
+          // For idempotent passes the world gets restored, so the next state
+          // has to come from the snapshot instead
+          result.nextStates.col(i).head(world->getNumDofs())
+              = result.snapshots[i]->getPostStepPosition();
+          result.nextStates.col(i).tail(world->getNumDofs())
+              = result.snapshots[i]->getPostStepVelocity();
+        }));
+  }
+  pool.waitAll(futures);
+
+  return result;
+}
+
+//==============================================================================
+/// This runs BackpropSnapshot::backpropState() for every world in parallel,
+/// given the snapshots from a previous call to forwardPass() and the loss
+/// gradient with respect to each world's next state (one column per world).
+BatchLossGradient WorldBatch::backpropState(
+    const std::vector<std::shared_ptr<BackpropSnapshot>>& snapshots,
+    const Eigen::MatrixXs& nextStatesLossGrad)
+{
+  assert(snapshots.size() == mWorlds.size());
+  assert(nextStatesLossGrad.cols() == mWorlds.size());
+
+  BatchLossGradient result;
+  result.lossWrtState = Eigen::MatrixXs(getStateSize(), mWorlds.size());
+  result.lossWrtAction = Eigen::MatrixXs(getActionSize(), mWorlds.size());
+  result.lossWrtMass
+      = Eigen::MatrixXs(mWorlds[0]->getMassDims(), mWorlds.size());
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    futures.push_back(
+        pool.submit([this, i, &snapshots, &nextStatesLossGrad, &result]() {
+          LossGradientHighLevelAPI grad = snapshots[i]->backpropState(
+              mWorlds[i], nextStatesLossGrad.col(i));
+          result.lossWrtState.col(i) = grad.lossWrtState;
+          result.lossWrtAction.col(i) = grad.lossWrtAction;
+          result.lossWrtMass.col(i) = grad.lossWrtMass;
+        }));
+  }
+  pool.waitAll(futures);
+
+  return result;
+}
+
+//==============================================================================
+/// This is the same as backpropState() on `forward.snapshots`, but saves
+/// callers from having to copy the snapshots out of the result, which is
+/// slow from Python for large batches
+BatchLossGradient WorldBatch::backpropState(
+    const BatchForwardPassResult& forward,
+    const Eigen::MatrixXs& nextStatesLossGrad)
+{
+  return backpropState(forward.snapshots, nextStatesLossGrad);
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,123 @@
+#ifndef DART_NEURAL_WORLD_BATCH_HPP_
+#define DART_NEURAL_WORLD_BATCH_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+class BackpropSnapshot;
+
+struct BatchForwardPassResult
+{
+  // One column per world, in the same order as the worlds in the batch
+  Eigen::MatrixXs nextStates;
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots;
+};
+
+struct BatchLossGradient
+{
+  // One column per world, in the same order as the worlds in the batch
+  Eigen::MatrixXs lossWrtState;
+  Eigen::MatrixXs lossWrtAction;
+  Eigen::MatrixXs lossWrtMass;
+};
+
+/// This holds a set of independent clones of a World, and steps all of them in
+/// parallel on the shared ThreadPool. It's meant for running many rollouts at
+/// once (for example, for reinforcement learning), where stepping worlds one
+/// at a time from Python is the bottleneck.
+///
+/// States and actions are passed around as matrices with one column per
+/// world.
+class WorldBatch
+{
+public:
+  /// This creates `numWorlds` clones of `world`. The original world is not
+  /// touched by the batch after construction.
+  WorldBatch(std::shared_ptr<simulation::World> world, int numWorlds);
+
+  /// This returns the number of worlds in the batch
+  int getNumWorlds() const;
+
+  /// This returns one of the worlds in the batch
+  std::shared_ptr<simulation::World> getWorld(int index) const;
+
+  /// This returns the size of a single world's state vector
+  int getStateSize() const;
+
+  /// This returns the size of a single world's action vector
+  int getActionSize() const;
+
+  /// This reads the current state of every world, one column per world
+  Eigen::MatrixXs getStates() const;
+
+  /// This sets the state of every world, one column per world
+  void setStates(const Eigen::MatrixXs& states);
+
+  /// This sets the action of every world, one column per world
+  void setActions(const Eigen::MatrixXs& actions);
+
+  /// This sets the states and actions, steps every world in parallel, and
+  /// returns the stacked next states. This does not record any gradient
+  /// information, so it's the fastest option for pure rollouts.
+  Eigen::MatrixXs step(
+      const Eigen::MatrixXs& states, const Eigen::MatrixXs& actions);
+
+  /// This is the batched version of neural::forwardPass(). It sets the states
+  /// and actions, steps every world in parallel, and returns the stacked next
+  /// states along with a BackpropSnapshot for each world.
+  BatchForwardPassResult forwardPass(
+      const Eigen::MatrixXs& states,
+      const Eigen::MatrixXs& actions,
+      bool idempotent = false);
+
+  /// This is the same as forwardPass(), but first sets the masses of every
+  /// world as well, one column per world, so that the gradient with respect
+  /// to mass is meaningful for each world
+  BatchForwardPassResult forwardPass(
+      const Eigen::MatrixXs& states,
+      const Eigen::MatrixXs& actions,
+      const Eigen::MatrixXs& masses,
+      bool idempotent = false);
+
+  /// This runs BackpropSnapshot::backpropState() for every world in parallel,
+  /// given the snapshots from a previous call to forwardPass() and the loss
+  /// gradient with respect to each world's next state (one column per world).
+  BatchLossGradient backpropState(
+      const std::vector<std::shared_ptr<BackpropSnapshot>>& snapshots,
+      const Eigen::MatrixXs& nextStatesLossGrad);
+
+  /// This is the same as backpropState() on `forward.snapshots`, but saves
+  /// callers from having to copy the snapshots out of the result, which is
+  /// slow from Python for large batches
+  BatchLossGradient backpropState(
+      const BatchForwardPassResult& forward,
+      const Eigen::MatrixXs& nextStatesLossGrad);
+
+protected:
+  /// This is the shared implementation of both forwardPass() variants.
+  /// `masses` may be null, in which case every world keeps its masses.
+  BatchForwardPassResult runForwardPass(
+      const Eigen::MatrixXs& states,
+      const Eigen::MatrixXs& actions,
+      const Eigen::MatrixXs* masses,
+      bool idempotent);
+
+  std::vector<std::shared_ptr<simulation::World>> mWorlds;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
@@ -0,0 +1,138 @@
+#include "dart/neural/WorldStatePool.hpp"
+
+#include <cassert>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+WorldStatePool::WorldStatePool(
+    std::shared_ptr<simulation::World> world, int numSlots)
+  : mWorld(world), mSlots(numSlots)
+{
+  int dofs = world->getNumDofs();
+  int bodies = world->getNumBodyNodes();
+  for (Slot& slot : mSlots)
+  {
+    slot.positions = Eigen::VectorXs::Zero(dofs);
+    slot.velocities = Eigen::VectorXs::Zero(dofs);
+    slot.accelerations = Eigen::VectorXs::Zero(dofs);
+    slot.controlForces = Eigen::VectorXs::Zero(dofs);
+    slot.masses = Eigen::VectorXs::Zero(bodies);
+    world->getCachedLCPSolutionInto(slot.lcpCache);
+  }
+}
+
+//==============================================================================
+int WorldStatePool::getNumSlots() const
+{
+  return mSlots.size();
+}
+
+//==============================================================================
+void WorldStatePool::saveInto(int slot)
+{
+  assert(slot >= 0 && slot < mSlots.size());
+  Slot& s = mSlots[slot];
+  assert(s.positions.size() == mWorld->getNumDofs());
+  assert(s.masses.size() == mWorld->getNumBodyNodes());
+
+  int dofCursor = 0;
+  int bodyCursor = 0;
+  for (std::size_t i = 0; i < mWorld->getNumSkeletons(); i++)
+  {
+    dynamics::Skeleton* skel = mWorld->getSkeleton(i).get();
+    for (std::size_t j = 0; j < skel->getNumDofs(); j++)
+    {
+      const dynamics::DegreeOfFreedom* dof = skel->getDof(j);
+      s.positions(dofCursor) = dof->getPosition();
+      s.velocities(dofCursor) = dof->getVelocity();
+      s.accelerations(dofCursor) = dof->getAcceleration();
+      s.controlForces(dofCursor) = dof->getControlForce();
+      dofCursor++;
+    }
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+    {
+      s.masses(bodyCursor++) = skel->getBodyNode(j)->getMass();
+    }
+  }
+  mWorld->getCachedLCPSolutionInto(s.lcpCache);
+}
+
+//==============================================================================
+void WorldStatePool::restoreFrom(int slot)
+{
+  assert(slot >= 0 && slot < mSlots.size());
+  const Slot& s = mSlots[slot];
+  assert(s.positions.size() == mWorld->getNumDofs());
+  assert(s.masses.size() == mWorld->getNumBodyNodes());
+
+  // Each setter here dirties the Skeleton's caches, so we skip the ones that
+  // wouldn't change anything
+  int dofCursor = 0;
+  int bodyCursor = 0;
+  for (std::size_t i = 0; i < mWorld->getNumSkeletons(); i++)
+  {
+    dynamics::Skeleton* skel = mWorld->getSkeleton(i).get();
+    for (std::size_t j = 0; j < skel->getNumDofs(); j++)
+    {
+      dynamics::DegreeOfFreedom* dof = skel->getDof(j);
+      if (dof->getPosition() != s.positions(dofCursor))
+        dof->setPosition(s.positions(dofCursor));
+      if (dof->getVelocity() != s.velocities(dofCursor))
+        dof->setVelocity(s.velocities(dofCursor));
+      if (dof->getAcceleration() != s.accelerations(dofCursor))
+        dof->setAcceleration(s.accelerations(dofCursor));
+      if (dof->getControlForce() != s.controlForces(dofCursor))
+        dof->setControlForce(s.controlForces(dofCursor));
+      dofCursor++;
+    }
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+    {
+      dynamics::BodyNode* body = skel->getBodyNode(j);
+      if (body->getMass() != s.masses(bodyCursor))
+        body->setMass(s.masses(bodyCursor));
+      bodyCursor++;
+    }
+  }
+  mWorld->setCachedLCPSolutionFrom(s.lcpCache);
+}
+
+//==============================================================================
+bool WorldStatePool::isPreserved(int slot)
+{
+  assert(slot >= 0 && slot < mSlots.size());
+  const Slot& s = mSlots[slot];
+
+  int dofCursor = 0;
+  int bodyCursor = 0;
+  for (std::size_t i = 0; i < mWorld->getNumSkeletons(); i++)
+  {
+    dynamics::Skeleton* skel = mWorld->getSkeleton(i).get();
+    for (std::size_t j = 0; j < skel->getNumDofs(); j++)
+    {
+      const dynamics::DegreeOfFreedom* dof = skel->getDof(j);
+      if (dof->getPosition() != s.positions(dofCursor)
+          || dof->getVelocity() != s.velocities(dofCursor)
+          || dof->getAcceleration() != s.accelerations(dofCursor)
+          || dof->getControlForce() != s.controlForces(dofCursor))
+        return false;
+      dofCursor++;
+    }
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); j++)
+    {
+      if (skel->getBodyNode(j)->getMass() != s.masses(bodyCursor++))
+        return false;
+    }
+  }
+  Eigen::VectorXs lcpCache = mWorld->getCachedLCPSolution();
+  return lcpCache.size() == s.lcpCache.size() && lcpCache == s.lcpCache;
+}
+
+} // namespace neural
+} // namespace dart
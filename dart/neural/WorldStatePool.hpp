@@ -0,0 +1,68 @@
+#ifndef DART_NEURAL_WORLD_STATE_POOL_HPP_
+#define DART_NEURAL_WORLD_STATE_POOL_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+/// This is a fixed number of slots that can each hold a copy of a world's
+/// state: positions, velocities, accelerations, control forces, link masses
+/// and the cached LCP solution. It's meant for code that saves and restores
+/// the same world over and over (finite differencing, line searches,
+/// checkpointed rollouts), where a RestorableSnapshot per save would allocate
+/// every time.
+///
+/// Every buffer is allocated up front, so saveInto() and restoreFrom() don't
+/// touch the heap (the cached LCP solution is the one exception, and it only
+/// reallocates when the number of constraints changes). restoreFrom() also
+/// only writes back the values that differ from the world's current ones, so
+/// Skeletons that didn't change keep their cached kinematics and dynamics.
+class WorldStatePool
+{
+public:
+  /// The slots are sized for the world as it is now, so the world shouldn't
+  /// gain or lose DOFs or BodyNodes while the pool is in use.
+  WorldStatePool(std::shared_ptr<simulation::World> world, int numSlots = 1);
+
+  /// This returns the number of slots
+  int getNumSlots() const;
+
+  /// This copies the world's current state into `slot`
+  void saveInto(int slot);
+
+  /// This sets the world back to the state saved in `slot`
+  void restoreFrom(int slot);
+
+  /// Returns true if the world is already in the state saved in `slot`
+  bool isPreserved(int slot);
+
+protected:
+  struct Slot
+  {
+    Eigen::VectorXs positions;
+    Eigen::VectorXs velocities;
+    Eigen::VectorXs accelerations;
+    Eigen::VectorXs controlForces;
+    Eigen::VectorXs masses;
+    Eigen::VectorXs lcpCache;
+  };
+
+  std::shared_ptr<simulation::World> mWorld;
+  std::vector<Slot> mSlots;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
@@ -1,26 +1,247 @@
 #include "dart/performance/PerformanceLog.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <deque>
 #include <iomanip>
 #include <iostream>
 #include <mutex>
-#include <random>
+#include <new>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #ifdef HAVE_PERF_UTILS
 #include <PerfUtils/Cycles.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 
 #include <assert.h>
 
+// The allocation hook replaces malloc() by forwarding to glibc's own
+// implementation, so it's only possible with glibc
+#if defined(DART_TRACK_ALLOCATIONS) && defined(__GLIBC__)
+#define DART_HAS_ALLOCATION_HOOK
+#endif
+
 namespace dart {
 namespace performance {
 
+namespace {
+
+/// This is how many runs fit in one of a thread's buffers. When a buffer
+/// fills up, the thread starts a new one.
+const int LOG_CHUNK_SIZE = 1024;
+
+/// This is one block of a thread's buffer of runs. Chunks are only ever
+/// written by the thread that created them.
+struct LogChunk
+{
+  LogChunk(int epoch)
+    : logs(static_cast<PerformanceLog*>(
+        ::operator new(sizeof(PerformanceLog) * LOG_CHUNK_SIZE))),
+      count(0),
+      epoch(epoch),
+      next(nullptr)
+  {
+  }
+
+  PerformanceLog* logs;
+  /// This is how many of the logs have been constructed. It's published with
+  /// release semantics after each one, so collect() can read it from
+  /// another thread.
+  std::atomic<int> count;
+  /// This is the initialize() generation the chunk was started in
+  int epoch;
+  LogChunk* next;
+};
+
+/// This is the head of a lock-free list of every chunk any thread has
+/// started
+std::atomic<LogChunk*> globalChunks(nullptr);
+
+/// This is bumped by initialize(), which retires every existing chunk
+std::atomic<int> globalEpoch(0);
+
+std::atomic<int> globalNextThreadIndex(0);
+
+/// This is the calling thread's buffer
+struct ThreadLogBuffer
+{
+  LogChunk* chunk = nullptr;
+  int threadIndex = -1;
+  int64_t nextId = 0;
+};
+thread_local ThreadLogBuffer threadLogBuffer;
+
+/// This is set by PerformanceLog::setHardwareCountersEnabled()
+std::atomic<bool> globalHardwareCountersEnabled(false);
+
+const unsigned int HARDWARE_COUNTER_MASK
+    = (1u << INSTRUCTIONS) | (1u << CACHE_MISSES) | (1u << BRANCH_MISSES);
+const unsigned int ALLOCATION_COUNTER_MASK
+    = (1u << ALLOCATIONS) | (1u << ALLOCATED_BYTES);
+
+#ifdef __linux__
+//==============================================================================
+/// This opens one counter for the calling thread, on any CPU, as part of the
+/// group led by `groupFd` (or as a new group, if that's -1)
+int openHardwareCounter(uint64_t config, int groupFd)
+{
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(
+      syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+#endif
+
+/// This is the calling thread's group of hardware counters, which is opened
+/// the first time the thread starts a run with counters enabled
+struct ThreadHardwareCounters
+{
+  ~ThreadHardwareCounters()
+  {
+#ifdef __linux__
+    for (int fd : fds)
+    {
+      if (fd != -1)
+        close(fd);
+    }
+#endif
+  }
+
+  /// This opens the counters if they haven't been tried yet, and returns
+  /// false if they aren't available
+  bool open()
+  {
+    if (tried)
+      return fds[0] != -1;
+    tried = true;
+#ifdef __linux__
+    fds[0] = openHardwareCounter(PERF_COUNT_HW_INSTRUCTIONS, -1);
+    if (fds[0] == -1)
+      return false;
+    fds[1] = openHardwareCounter(PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+    fds[2] = openHardwareCounter(PERF_COUNT_HW_BRANCH_MISSES, fds[0]);
+    if (fds[1] == -1 || fds[2] == -1)
+    {
+      for (int& fd : fds)
+      {
+        if (fd != -1)
+          close(fd);
+        fd = -1;
+      }
+      return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /// This reads the whole group at once into `counters`
+  bool read(PerformanceCounters& counters)
+  {
+    if (!open())
+      return false;
+#ifdef __linux__
+    // With PERF_FORMAT_GROUP, we get the number of counters followed by
+    // their values, in the order they were opened
+    uint64_t values[4];
+    if (::read(fds[0], values, sizeof(values)) != sizeof(values))
+      return false;
+    counters[INSTRUCTIONS] = values[1];
+    counters[CACHE_MISSES] = values[2];
+    counters[BRANCH_MISSES] = values[3];
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool tried = false;
+  int fds[3] = {-1, -1, -1};
+};
+thread_local ThreadHardwareCounters threadHardwareCounters;
+
+#ifdef DART_HAS_ALLOCATION_HOOK
+// These are bumped from inside malloc(), so they have to be plain TLS that
+// can be reached without allocating. The initial-exec model guarantees that,
+// even when DART is loaded with dlopen().
+__thread uint64_t threadAllocationCount
+    __attribute__((tls_model("initial-exec")))
+    = 0;
+__thread uint64_t threadAllocatedBytes
+    __attribute__((tls_model("initial-exec")))
+    = 0;
+#endif
+
+//==============================================================================
+/// This reads every counter that's turned on, for the calling thread, and
+/// returns a mask of which ones it read
+unsigned int readCounters(PerformanceCounters& counters)
+{
+  unsigned int mask = 0;
+  if (globalHardwareCountersEnabled.load(std::memory_order_relaxed)
+      && threadHardwareCounters.read(counters))
+  {
+    mask |= HARDWARE_COUNTER_MASK;
+  }
+#ifdef DART_HAS_ALLOCATION_HOOK
+  counters[ALLOCATIONS] = threadAllocationCount;
+  counters[ALLOCATED_BYTES] = threadAllocatedBytes;
+  mask |= ALLOCATION_COUNTER_MASK;
+#endif
+  return mask;
+}
+
+} // namespace
+
+//==============================================================================
+/// This returns a short human readable name for `counter`, like "cache
+/// misses"
+const char* getPerformanceCounterName(PerformanceCounter counter)
+{
+  switch (counter)
+  {
+    case INSTRUCTIONS:
+      return "instructions";
+    case CACHE_MISSES:
+      return "cache misses";
+    case BRANCH_MISSES:
+      return "branch misses";
+    case ALLOCATIONS:
+      return "allocations";
+    case ALLOCATED_BYTES:
+      return "allocated bytes";
+    default:
+      return "unknown";
+  }
+}
+
 std::unordered_map<std::string, int> PerformanceLog::globalPerfStringIndex;
 std::deque<PerformanceLog*> PerformanceLog::globalPerfLogsList;
+std::unordered_map<int64_t, PerformanceLog*>
+    PerformanceLog::globalPerfLogsById;
 std::unordered_map<int, std::string>
     PerformanceLog::globalPerfStringReverseIndex;
 std::mutex PerformanceLog::globalPerfLogListMutex;
@@ -28,8 +249,15 @@ std::mutex PerformanceLog::globalPerfLogListMutex;
 //==============================================================================
 void PerformanceLog::initialize()
 {
+  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
+  // We can't free the old chunks, because callers may still be holding
+  // PerformanceLog pointers into them (the same way the old logs were never
+  // freed). Instead, moving to a new epoch makes every thread start a fresh
+  // chunk, and makes collect() skip the old ones.
+  globalEpoch.fetch_add(1, std::memory_order_acq_rel);
   globalPerfStringIndex = std::unordered_map<std::string, int>(30);
   globalPerfLogsList = std::deque<PerformanceLog*>();
+  globalPerfLogsById = std::unordered_map<int64_t, PerformanceLog*>();
   globalPerfStringReverseIndex = std::unordered_map<int, std::string>(30);
 }
 
@@ -56,45 +284,134 @@ inline uint64_t getClock()
 {
 #ifdef HAVE_PERF_UTILS
   return PerfUtils::Cycles::rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
 #else
-  std::cout << "Trying to use PerformanceLog::getClock() on an unsupported architecture!" << std::endl;
-  return 0;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
 #endif
 }
 
+//==============================================================================
+/// This returns the wall clock, in nanoseconds, for converting getClock()
+/// readings to time
+inline int64_t getWallNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// These pair up a reading of getClock() with the wall clock, from when the
+// program started, so we can work out how fast getClock() ticks
+static const uint64_t calibrationStartClock = getClock();
+static const int64_t calibrationStartWallNanos = getWallNanos();
+
 //==============================================================================
 /// Default constructor
-PerformanceLog::PerformanceLog(int nameIndex, int parentId)
-  : mNameIndex(nameIndex),
-    mStartClock(getClock()),
+PerformanceLog::PerformanceLog(
+    char const* name, int64_t id, int64_t parentId, int threadIndex)
+  : mName(name),
+    mNameIndex(-1),
+    mStartClock(0),
     mEndClock(0),
-    mId(rand()),
-    mParentId(parentId)
+    mId(id),
+    mParentId(parentId),
+    mThreadIndex(threadIndex)
 {
+  // Read the counters before the clock, so the time it takes to read them
+  // doesn't count against the run
+  mCounterMask = readCounters(mCounters);
+  mStartClock = getClock();
 }
 
 //==============================================================================
-PerformanceLog* PerformanceLog::startRoot(char const* name)
+/// This constructs a new run in this thread's buffer, and returns it. The
+/// buffer only ever grows, so the pointer stays valid.
+PerformanceLog* PerformanceLog::allocate(char const* name, int64_t parentId)
 {
-  PerformanceLog* newRoot = new PerformanceLog(mapStringToIndex(name), -1);
-  // Serialize our access to the log list
-  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(newRoot);
-  return newRoot;
+  ThreadLogBuffer& buffer = threadLogBuffer;
+  if (buffer.threadIndex == -1)
+  {
+    buffer.threadIndex
+        = globalNextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+  }
+  int epoch = globalEpoch.load(std::memory_order_acquire);
+  if (buffer.chunk == nullptr || buffer.chunk->epoch != epoch
+      || buffer.chunk->count.load(std::memory_order_relaxed)
+             == LOG_CHUNK_SIZE)
+  {
+    LogChunk* chunk = new LogChunk(epoch);
+    chunk->next = globalChunks.load(std::memory_order_relaxed);
+    while (!globalChunks.compare_exchange_weak(
+        chunk->next,
+        chunk,
+        std::memory_order_release,
+        std::memory_order_relaxed))
+    {
+    }
+    buffer.chunk = chunk;
+  }
+
+  // Thread indices go in the high bits, so IDs are unique without any
+  // coordination between threads
+  int64_t id = (static_cast<int64_t>(buffer.threadIndex) << 40)
+               | buffer.nextId++;
+  LogChunk* chunk = buffer.chunk;
+  int index = chunk->count.load(std::memory_order_relaxed);
+  PerformanceLog* log = new (chunk->logs + index)
+      PerformanceLog(name, id, parentId, buffer.threadIndex);
+  chunk->count.store(index + 1, std::memory_order_release);
+  return log;
 }
 
 //==============================================================================
-/// This looks through all the PerformanceLogs in the system and builds a
-/// report
-std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
-PerformanceLog::finalize()
+/// This gathers every run since the last initialize() into
+/// globalPerfLogsList, and assigns each of them a name index.
+void PerformanceLog::collect()
 {
-  // First we need to set up the reverse index so we can rapidly look up strings
+  globalPerfLogsList.clear();
+  globalPerfLogsById.clear();
+  int epoch = globalEpoch.load(std::memory_order_acquire);
+  for (LogChunk* chunk = globalChunks.load(std::memory_order_acquire);
+       chunk != nullptr;
+       chunk = chunk->next)
+  {
+    if (chunk->epoch != epoch)
+      continue;
+    int count = chunk->count.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+      PerformanceLog* log = chunk->logs + i;
+      log->mNameIndex = mapStringToIndex(log->mName);
+      globalPerfLogsList.push_back(log);
+      globalPerfLogsById[log->mId] = log;
+    }
+  }
+
+  // Set up the reverse index so we can rapidly look up strings
   globalPerfStringReverseIndex.clear();
   for (auto pair : globalPerfStringIndex)
   {
     globalPerfStringReverseIndex[pair.second] = pair.first;
   }
+}
+
+//==============================================================================
+PerformanceLog* PerformanceLog::startRoot(char const* name)
+{
+  return allocate(name, -1);
+}
+
+//==============================================================================
+/// This looks through all the PerformanceLogs in the system and builds a
+/// report
+std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+PerformanceLog::finalize()
+{
+  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
+  collect();
 
   // Next we need to look through for all the root names:
   std::unordered_set<int> rootNameIds;
@@ -120,6 +437,93 @@ PerformanceLog::finalize()
   return rootLogs;
 }
 
+//==============================================================================
+/// This exports every finished run since the last initialize() in the
+/// Chrome trace event format, which you can load in chrome://tracing or
+/// https://ui.perfetto.dev. Every thread that recorded runs gets its own
+/// track, so you can see how parallel work overlapped.
+std::string PerformanceLog::toChromeTraceJson()
+{
+  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
+  collect();
+
+  s_t ticksPerMicro = getClockTicksPerSecond() / 1e6;
+
+  std::vector<PerformanceLog*> finished;
+  for (PerformanceLog* log : globalPerfLogsList)
+  {
+    if (log->mEndClock != 0)
+      finished.push_back(log);
+  }
+  std::sort(
+      finished.begin(),
+      finished.end(),
+      [](const PerformanceLog* a, const PerformanceLog* b) {
+        return a->mStartClock < b->mStartClock;
+      });
+  uint64_t origin = finished.empty() ? 0 : finished[0]->mStartClock;
+
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(3);
+  stream << "{\"traceEvents\":[";
+  for (int i = 0; i < finished.size(); i++)
+  {
+    PerformanceLog* log = finished[i];
+    if (i > 0)
+      stream << ",";
+    stream << "\n{\"name\":\"";
+    for (const char* c = log->mName; *c != '\0'; c++)
+    {
+      if (*c == '"' || *c == '\\')
+        stream << '\\';
+      stream << *c;
+    }
+    stream << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << log->mThreadIndex
+           << ",\"ts\":"
+           << static_cast<double>(
+                  (log->mStartClock - origin) / ticksPerMicro)
+           << ",\"dur\":"
+           << static_cast<double>(
+                  (log->mEndClock - log->mStartClock) / ticksPerMicro);
+    if (log->mCounterMask != 0)
+    {
+      stream << ",\"args\":{";
+      bool first = true;
+      for (int c = 0; c < NUM_PERFORMANCE_COUNTERS; c++)
+      {
+        if ((log->mCounterMask & (1u << c)) == 0)
+          continue;
+        if (!first)
+          stream << ",";
+        first = false;
+        stream << "\""
+               << getPerformanceCounterName(static_cast<PerformanceCounter>(c))
+               << "\":" << log->mCounters[c];
+      }
+      stream << "}";
+    }
+    stream << "}";
+  }
+  stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return stream.str();
+}
+
+//==============================================================================
+/// This measures how fast the clock behind every recorded duration ticks,
+/// against the wall clock, so that callers can convert runtimes to seconds
+s_t PerformanceLog::getClockTicksPerSecond()
+{
+  // If the program has barely started, wait a little so the estimate isn't
+  // all noise
+  if (getWallNanos() - calibrationStartWallNanos < 1000000)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return static_cast<s_t>(getClock() - calibrationStartClock)
+         / (static_cast<s_t>(getWallNanos() - calibrationStartWallNanos)
+            / 1e9);
+}
+
 //==============================================================================
 /// This checks if a given PerformanceLog object matches a stack of nameIds
 bool PerformanceLog::matches(std::vector<int> nameIdStack)
@@ -133,12 +537,10 @@ bool PerformanceLog::matches(std::vector<int> nameIdStack)
   std::vector<int> subStack = nameIdStack;
   subStack.pop_back();
   // Find parent and recurse
-  for (PerformanceLog* log : globalPerfLogsList)
+  auto parent = globalPerfLogsById.find(mParentId);
+  if (parent != globalPerfLogsById.end())
   {
-    if (log->mId == mParentId)
-    {
-      return log->matches(subStack);
-    }
+    return parent->second->matches(subStack);
   }
 
   return false;
@@ -150,11 +552,7 @@ bool PerformanceLog::matches(std::vector<int> nameIdStack)
 /// objects into something sensible.
 PerformanceLog* PerformanceLog::startRun(char const* name)
 {
-  PerformanceLog* log = new PerformanceLog(mapStringToIndex(name), mId);
-  // Serialize our access to the log list
-  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(log);
-  return log;
+  return allocate(name, mId);
 }
 
 //==============================================================================
@@ -163,6 +561,55 @@ PerformanceLog* PerformanceLog::startRun(char const* name)
 void PerformanceLog::end()
 {
   mEndClock = getClock();
+  if (mCounterMask == 0)
+    return;
+  // The counters are per-thread, so they're meaningless if we've moved
+  if (threadLogBuffer.threadIndex != mThreadIndex)
+  {
+    mCounterMask = 0;
+    return;
+  }
+  PerformanceCounters endCounters;
+  mCounterMask &= readCounters(endCounters);
+  for (int i = 0; i < NUM_PERFORMANCE_COUNTERS; i++)
+  {
+    mCounters[i] = endCounters[i] - mCounters[i];
+  }
+}
+
+//==============================================================================
+/// This turns on recording instructions, cache misses and branch misses
+/// for every run started afterwards, on every thread. Returns false if the
+/// counters aren't available here, in which case nothing changes.
+bool PerformanceLog::setHardwareCountersEnabled(bool enabled)
+{
+  if (enabled)
+  {
+    // If we can't open them on this thread, we won't be able to on any other
+    PerformanceCounters counters;
+    if (!threadHardwareCounters.read(counters))
+      return false;
+  }
+  globalHardwareCountersEnabled.store(enabled, std::memory_order_relaxed);
+  return true;
+}
+
+//==============================================================================
+/// Returns true if runs are recording hardware counters
+bool PerformanceLog::getHardwareCountersEnabled()
+{
+  return globalHardwareCountersEnabled.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+/// Returns true if DART was built with DART_TRACK_ALLOCATIONS
+bool PerformanceLog::isAllocationTrackingAvailable()
+{
+#ifdef DART_HAS_ALLOCATION_HOOK
+  return true;
+#else
+  return false;
+#endif
 }
 
 //==============================================================================
@@ -186,7 +633,7 @@ FinalizedPerformanceLog::recursivelyConstruct(std::vector<int> nameIdStack)
     if (rawLog->matches(nameIdStack))
     {
       uint64_t diff = rawLog->mEndClock - rawLog->mStartClock;
-      log->registerRun(diff);
+      log->registerRun(diff, rawLog->mCounters, rawLog->mCounterMask);
       selfIds.insert(rawLog->mId);
     }
   }
@@ -222,8 +669,9 @@ FinalizedPerformanceLog::recursivelyConstruct(std::vector<int> nameIdStack)
 
 //==============================================================================
 FinalizedPerformanceLog::FinalizedPerformanceLog(const std::string& name)
-  : mName(name)
+  : mName(name), mCounterMask(0)
 {
+  mCounterTotals.fill(0);
 }
 
 //==============================================================================
@@ -243,7 +691,28 @@ void FinalizedPerformanceLog::setChild(
 //==============================================================================
 void FinalizedPerformanceLog::registerRun(uint64_t duration)
 {
+  registerRun(duration, PerformanceCounters(), 0);
+}
+
+//==============================================================================
+/// This registers a run that also recorded the counters whose bits are set
+/// in `counterMask` (bit i is PerformanceCounter i)
+void FinalizedPerformanceLog::registerRun(
+    uint64_t duration,
+    const PerformanceCounters& counters,
+    unsigned int counterMask)
+{
+  // A counter only means something if every run recorded it
+  if (mRuns.empty())
+    mCounterMask = counterMask;
+  else
+    mCounterMask &= counterMask;
   mRuns.push_back(duration);
+  for (int i = 0; i < NUM_PERFORMANCE_COUNTERS; i++)
+  {
+    if (mCounterMask & (1u << i))
+      mCounterTotals[i] += counters[i];
+  }
 }
 
 //==============================================================================
@@ -270,6 +739,58 @@ uint64_t FinalizedPerformanceLog::getTotalRuntime()
   return sum;
 }
 
+//==============================================================================
+/// Returns the duration of every run, in clock ticks. Divide by
+/// PerformanceLog::getClockTicksPerSecond() to get seconds.
+const std::vector<uint64_t>& FinalizedPerformanceLog::getRuns() const
+{
+  return mRuns;
+}
+
+//==============================================================================
+const std::string& FinalizedPerformanceLog::getName() const
+{
+  return mName;
+}
+
+//==============================================================================
+/// Returns true if every run recorded `counter`
+bool FinalizedPerformanceLog::hasCounter(PerformanceCounter counter) const
+{
+  return (mCounterMask & (1u << counter)) != 0;
+}
+
+//==============================================================================
+/// Returns the sum of `counter` over every run, or 0 if !hasCounter()
+uint64_t FinalizedPerformanceLog::getTotalCounter(
+    PerformanceCounter counter) const
+{
+  return hasCounter(counter) ? mCounterTotals[counter] : 0;
+}
+
+//==============================================================================
+/// Returns the mean of `counter` per run, or 0 if !hasCounter()
+s_t FinalizedPerformanceLog::getMeanCounter(PerformanceCounter counter) const
+{
+  if (!hasCounter(counter) || mRuns.empty())
+    return 0.0;
+  return static_cast<s_t>(mCounterTotals[counter]) / mRuns.size();
+}
+
+//==============================================================================
+/// Returns the names of every child, which you can pass to getChild()
+std::vector<std::string> FinalizedPerformanceLog::getChildNames() const
+{
+  std::vector<std::string> names;
+  for (const auto& pair : mChildren)
+  {
+    if (pair.second)
+      names.push_back(pair.first);
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
 //==============================================================================
 /// This will print the results in human readable format, which we can pipe to
 /// a file or to std::out
@@ -307,7 +828,22 @@ void FinalizedPerformanceLog::recursivePrettyPrint(
 
   stream << (percentage * 100) << "%: " << mName << " (" << getNumRuns()
          << " runs at mean " << getMeanRuntime() << " cycles = " << totalCycles
-         << " total)\n";
+         << " total";
+  if (mCounterMask != 0)
+  {
+    stream << "; mean per run:";
+    bool first = true;
+    for (int c = 0; c < NUM_PERFORMANCE_COUNTERS; c++)
+    {
+      PerformanceCounter counter = static_cast<PerformanceCounter>(c);
+      if (!hasCounter(counter))
+        continue;
+      stream << (first ? " " : ", ") << getMeanCounter(counter) << " "
+             << getPerformanceCounterName(counter);
+      first = false;
+    }
+  }
+  stream << ")\n";
 
   for (auto pair : mChildren)
   {
@@ -317,4 +853,42 @@ void FinalizedPerformanceLog::recursivePrettyPrint(
 }
 
 } // namespace performance
-} // namespace dart
\ No newline at end of file
+} // namespace dart
+
+#ifdef DART_HAS_ALLOCATION_HOOK
+
+// This is the interposed allocator. Because these have the same names as the
+// C library's, the dynamic linker resolves every call to malloc() in the
+// process (including the ones inside operator new and Eigen) to these, which
+// count the allocation on the calling thread and forward to glibc.
+
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) noexcept
+{
+  dart::performance::threadAllocationCount++;
+  dart::performance::threadAllocatedBytes += size;
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+  dart::performance::threadAllocationCount++;
+  dart::performance::threadAllocatedBytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept
+{
+  dart::performance::threadAllocationCount++;
+  dart::performance::threadAllocatedBytes += size;
+  return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef DART_PERFORMANCE_LOG_HPP_
 #define DART_PERFORMANCE_LOG_HPP_
 
+#include <array>
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -17,6 +19,28 @@
 namespace dart {
 namespace performance {
 
+/// These are the optional counts a run can record on top of its clock ticks.
+/// The first three come from the CPU's hardware counters, and are only
+/// recorded after PerformanceLog::setHardwareCountersEnabled(true). The last
+/// two count heap allocations, and are only recorded when DART is built with
+/// DART_TRACK_ALLOCATIONS. Like durations, they include everything nested
+/// inside the run.
+enum PerformanceCounter
+{
+  INSTRUCTIONS = 0,
+  CACHE_MISSES,
+  BRANCH_MISSES,
+  ALLOCATIONS,
+  ALLOCATED_BYTES,
+  NUM_PERFORMANCE_COUNTERS
+};
+
+using PerformanceCounters = std::array<uint64_t, NUM_PERFORMANCE_COUNTERS>;
+
+/// This returns a short human readable name for `counter`, like "cache
+/// misses"
+const char* getPerformanceCounterName(PerformanceCounter counter);
+
 class FinalizedPerformanceLog
 {
 public:
@@ -34,12 +58,37 @@ public:
 
   void registerRun(uint64_t duration);
 
+  /// This registers a run that also recorded the counters whose bits are set
+  /// in `counterMask` (bit i is PerformanceCounter i)
+  void registerRun(
+      uint64_t duration,
+      const PerformanceCounters& counters,
+      unsigned int counterMask);
+
   int getNumRuns();
 
   s_t getMeanRuntime();
 
   uint64_t getTotalRuntime();
 
+  /// Returns the duration of every run, in clock ticks. Divide by
+  /// PerformanceLog::getClockTicksPerSecond() to get seconds.
+  const std::vector<uint64_t>& getRuns() const;
+
+  const std::string& getName() const;
+
+  /// Returns true if every run recorded `counter`
+  bool hasCounter(PerformanceCounter counter) const;
+
+  /// Returns the sum of `counter` over every run, or 0 if !hasCounter()
+  uint64_t getTotalCounter(PerformanceCounter counter) const;
+
+  /// Returns the mean of `counter` per run, or 0 if !hasCounter()
+  s_t getMeanCounter(PerformanceCounter counter) const;
+
+  /// Returns the names of every child, which you can pass to getChild()
+  std::vector<std::string> getChildNames() const;
+
   /// This will print the results in human readable format, which we can pipe to
   /// a file or to std::out
   std::string prettyPrint();
@@ -53,6 +102,9 @@ protected:
   std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
       mChildren;
   std::vector<uint64_t> mRuns;
+  PerformanceCounters mCounterTotals;
+  /// This has a bit set for each counter that every run recorded
+  unsigned int mCounterMask;
 
   /// This pretty prints to a stream
   void recursivePrettyPrint(
@@ -62,13 +114,23 @@ protected:
       std::stringstream& stream);
 };
 
+/// This records nested, named runs with cycle-accurate timestamps.
+///
+/// Recording is meant to be cheap enough to leave in hot paths. Each thread
+/// appends its runs to its own preallocated buffer, so startRun() and end()
+/// never take a lock or touch memory shared with other threads. The only
+/// synchronization is a lock-free push when a thread's buffer fills up. All
+/// the expensive work (interning names, rebuilding the tree) is deferred to
+/// finalize() and toChromeTraceJson(), which must not be called while other
+/// threads are still recording.
 class PerformanceLog
 {
   friend class FinalizedPerformanceLog;
 
 public:
   /// Default constructor
-  PerformanceLog(int nameIndex, int parentId);
+  PerformanceLog(
+      char const* name, int64_t id, int64_t parentId, int threadIndex);
 
   /// Disable the copy constructor
   // PerformanceLog(const PerformanceLog&) = delete;
@@ -83,6 +145,34 @@ public:
       unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
       finalize();
 
+  /// This exports every finished run since the last initialize() in the
+  /// Chrome trace event format, which you can load in chrome://tracing or
+  /// https://ui.perfetto.dev. Every thread that recorded runs gets its own
+  /// track, so you can see how parallel work overlapped.
+  static std::string toChromeTraceJson();
+
+  /// This measures how fast the clock behind every recorded duration ticks,
+  /// against the wall clock, so that callers can convert runtimes to seconds
+  static s_t getClockTicksPerSecond();
+
+  /// This turns on recording instructions, cache misses and branch misses
+  /// for every run started afterwards, on every thread. These come from
+  /// perf_event_open(), so they're only available on Linux, and only if
+  /// /proc/sys/kernel/perf_event_paranoid allows it. Reading them costs a
+  /// system call at the start and end of each run, which is why they're off
+  /// by default. Returns false if the counters aren't available here, in
+  /// which case nothing changes.
+  static bool setHardwareCountersEnabled(bool enabled);
+
+  /// Returns true if runs are recording hardware counters. See
+  /// setHardwareCountersEnabled().
+  static bool getHardwareCountersEnabled();
+
+  /// Returns true if DART was built with DART_TRACK_ALLOCATIONS, which
+  /// interposes malloc() so that every run counts the heap allocations made
+  /// on its thread while it was open
+  static bool isAllocationTrackingAvailable();
+
   /// This checks if a given PerformanceLog object matches a stack of nameIds
   bool matches(std::vector<int> nameIdStack);
 
@@ -100,7 +190,19 @@ public:
   static void initialize();
 
 protected:
-  /// Don't store a whole copy of the name, just a numerical key
+  /// This constructs a new run in this thread's buffer, and returns it. The
+  /// buffer only ever grows, so the pointer stays valid.
+  static PerformanceLog* allocate(char const* name, int64_t parentId);
+
+  /// This gathers every run since the last initialize() into
+  /// globalPerfLogsList, and assigns each of them a name index.
+  static void collect();
+
+  /// Don't store a whole copy of the name, just the pointer we were given.
+  /// Names are expected to be string literals.
+  char const* mName;
+
+  /// This is a numerical key for mName, which collect() fills in
   int mNameIndex;
 
   /// This is the clock at the start of our existence
@@ -110,16 +212,28 @@ protected:
   uint64_t mEndClock;
 
   /// This is the ID which we'll use to reassemble the graph after the fact
-  int mId;
+  int64_t mId;
 
   /// This is the parent's ID
-  int mParentId;
+  int64_t mParentId;
+
+  /// This is a small index for the thread that started this run
+  int mThreadIndex;
+
+  /// These are the counters when we started, and after end(), how much they
+  /// went up while we were running
+  PerformanceCounters mCounters;
+
+  /// This has bit i set if mCounters[i] was recorded
+  unsigned int mCounterMask;
 
   static int mapStringToIndex(const char* str);
 
   static std::unordered_map<std::string, int> globalPerfStringIndex;
   static std::deque<PerformanceLog*> globalPerfLogsList;
+  static std::unordered_map<int64_t, PerformanceLog*> globalPerfLogsById;
   static std::unordered_map<int, std::string> globalPerfStringReverseIndex;
+  /// This is only taken by initialize(), finalize() and toChromeTraceJson()
   static std::mutex globalPerfLogListMutex;
 };
 
@@ -1,49 +1,176 @@
 #include "dart/proto/SerializeEigen.hpp"
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
 namespace dart {
 namespace proto {
 
-void serializeVector(proto::VectorXs& proto, const Eigen::VectorXs& vec)
+namespace {
+
+bool isLittleEndian()
 {
-  proto.set_size(vec.size());
-  for (int i = 0; i < vec.size(); i++)
+  const uint16_t one = 1;
+  unsigned char firstByte;
+  std::memcpy(&firstByte, &one, 1);
+  return firstByte == 1;
+}
+
+/// This writes `count` values to `out` as raw little-endian doubles. When
+/// s_t is a double on a little-endian machine this is a single memcpy.
+void writeRawDoubles(char* out, const s_t* values, int count)
+{
+#ifndef DART_USE_ARBITRARY_PRECISION
+  if (isLittleEndian())
   {
-    proto.add_values(static_cast<double>(vec(i)));
+    std::memcpy(out, values, count * sizeof(double));
+    return;
+  }
+#endif
+  for (int i = 0; i < count; i++)
+  {
+    double value = static_cast<double>(values[i]);
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(double));
+    for (int b = 0; b < 8; b++)
+    {
+      out[i * 8 + b] = static_cast<char>((bits >> (8 * b)) & 0xff);
+    }
   }
 }
 
+/// This is the inverse of writeRawDoubles()
+void readRawDoubles(const char* in, s_t* values, int count)
+{
+#ifndef DART_USE_ARBITRARY_PRECISION
+  if (isLittleEndian())
+  {
+    std::memcpy(values, in, count * sizeof(double));
+    return;
+  }
+#endif
+  for (int i = 0; i < count; i++)
+  {
+    uint64_t bits = 0;
+    for (int b = 0; b < 8; b++)
+    {
+      bits |= static_cast<uint64_t>(static_cast<unsigned char>(in[i * 8 + b]))
+              << (8 * b);
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(double));
+    values[i] = static_cast<s_t>(value);
+  }
+}
+
+} // namespace
+
+void serializeVector(proto::VectorXs& proto, const Eigen::VectorXs& vec)
+{
+  proto.set_size(vec.size());
+  std::string* data = proto.mutable_data();
+  data->resize(vec.size() * sizeof(double));
+  writeRawDoubles(&(*data)[0], vec.data(), vec.size());
+}
+
 Eigen::VectorXs deserializeVector(const proto::VectorXs& proto)
 {
   Eigen::VectorXs recovered = Eigen::VectorXs::Zero(proto.size());
-  for (int i = 0; i < proto.size(); i++)
+  if (proto.data().size() == proto.size() * sizeof(double))
+  {
+    readRawDoubles(proto.data().data(), recovered.data(), proto.size());
+    return recovered;
+  }
+  for (int i = 0; i < proto.size() && i < proto.values_size(); i++)
   {
     recovered(i) = static_cast<s_t>(proto.values(i));
   }
   return recovered;
 }
 
-void serializeMatrix(proto::MatrixXs& proto, const Eigen::MatrixXs& mat)
+void serializeMatrix(
+    proto::MatrixXs& proto, const Eigen::Ref<const Eigen::MatrixXs>& mat)
 {
   proto.set_rows(mat.rows());
   proto.set_cols(mat.cols());
+  std::string* data = proto.mutable_data();
+  data->resize(mat.rows() * mat.cols() * sizeof(double));
+  // A Ref may be a block of a taller matrix, so copy a column at a time
+  for (int col = 0; col < mat.cols(); col++)
+  {
+    writeRawDoubles(
+        &(*data)[col * mat.rows() * sizeof(double)],
+        mat.col(col).data(),
+        mat.rows());
+  }
+}
+
+Eigen::MatrixXs deserializeMatrix(const proto::MatrixXs& proto)
+{
+  Eigen::MatrixXs recovered = Eigen::MatrixXs::Zero(proto.rows(), proto.cols());
+  int count = proto.rows() * proto.cols();
+  if (proto.data().size() == count * sizeof(double))
+  {
+    readRawDoubles(proto.data().data(), recovered.data(), count);
+    return recovered;
+  }
+  int cursor = 0;
+  for (int col = 0; col < proto.cols(); col++)
+  {
+    for (int row = 0; row < proto.rows() && cursor < proto.values_size();
+         row++)
+    {
+      recovered(row, col) = static_cast<s_t>(proto.values(cursor));
+      cursor++;
+    }
+  }
+  return recovered;
+}
+
+void serializeQuantizedMatrix(
+    proto::QuantizedMatrixXs& proto, const Eigen::MatrixXs& mat, s_t precision)
+{
+  const double step = static_cast<double>(precision);
+  proto.set_rows(mat.rows());
+  proto.set_cols(mat.cols());
+  proto.set_precision(step);
+  proto.mutable_deltas()->Reserve(mat.rows() * mat.cols());
+  // We delta against the value we'll actually decode, not the true value, so
+  // rounding errors never pile up along a row
+  std::vector<int64_t> last(mat.rows(), 0);
   for (int col = 0; col < mat.cols(); col++)
   {
     for (int row = 0; row < mat.rows(); row++)
     {
-      proto.add_values(static_cast<double>(mat(row, col)));
+      int64_t quantized
+          = std::llround(static_cast<double>(mat(row, col)) / step);
+      int64_t delta = quantized - last[row];
+      delta = std::max<int64_t>(
+          std::numeric_limits<int32_t>::min(),
+          std::min<int64_t>(std::numeric_limits<int32_t>::max(), delta));
+      proto.add_deltas(static_cast<int32_t>(delta));
+      last[row] += delta;
     }
   }
 }
 
-Eigen::MatrixXs deserializeMatrix(const proto::MatrixXs& proto)
+Eigen::MatrixXs deserializeQuantizedMatrix(
+    const proto::QuantizedMatrixXs& proto)
 {
   Eigen::MatrixXs recovered = Eigen::MatrixXs::Zero(proto.rows(), proto.cols());
+  std::vector<int64_t> last(proto.rows(), 0);
   int cursor = 0;
   for (int col = 0; col < proto.cols(); col++)
   {
     for (int row = 0; row < proto.rows(); row++)
     {
-      recovered(row, col) = static_cast<s_t>(proto.values(cursor));
+      last[row] += proto.deltas(cursor);
+      double value = static_cast<double>(last[row]) * proto.precision();
+      recovered(row, col) = static_cast<s_t>(value);
       cursor++;
     }
   }
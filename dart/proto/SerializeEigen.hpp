@@ -12,9 +12,20 @@ namespace proto {
 void serializeVector(proto::VectorXs& proto, const Eigen::VectorXs& vec);
 Eigen::VectorXs deserializeVector(const proto::VectorXs& proto);
 
-void serializeMatrix(proto::MatrixXs& proto, const Eigen::MatrixXs& mat);
+/// This takes a Ref so that blocks of columns (like a chunk of a rollout) can
+/// be written out without copying them into a fresh matrix first
+void serializeMatrix(
+    proto::MatrixXs& proto, const Eigen::Ref<const Eigen::MatrixXs>& mat);
 Eigen::MatrixXs deserializeMatrix(const proto::MatrixXs& proto);
 
+/// This rounds every value to the nearest multiple of `precision`, and writes
+/// out the differences between neighboring columns. Deltas too big to fit in
+/// 32 bits get clamped, so pick a `precision` that suits your value range.
+void serializeQuantizedMatrix(
+    proto::QuantizedMatrixXs& proto, const Eigen::MatrixXs& mat, s_t precision);
+Eigen::MatrixXs deserializeQuantizedMatrix(
+    const proto::QuantizedMatrixXs& proto);
+
 } // namespace proto
 } // namespace dart
 
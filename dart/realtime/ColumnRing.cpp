@@ -0,0 +1,180 @@
+#include "dart/realtime/ColumnRing.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace dart {
+namespace realtime {
+
+// This is how many columns a growable ring starts out with room for
+static const int INITIAL_GROWABLE_CAPACITY = 64;
+
+/// If `capacity` is 0 the ring grows (by doubling) whenever it fills up,
+/// so it never loses data. Otherwise it holds at most `capacity` columns,
+/// and pushing onto a full ring drops the oldest column.
+ColumnRing::ColumnRing(int rows, int capacity)
+  : mRows(rows),
+    mCapacity(capacity > 0 ? capacity : INITIAL_GROWABLE_CAPACITY),
+    mGrowable(capacity <= 0),
+    mHead(0),
+    mSize(0),
+    mValues(Eigen::MatrixXs::Zero(rows, 2 * mCapacity)),
+    mTimes(mCapacity, 0L),
+    mInterval(-1)
+{
+}
+
+/// This appends a column to the end of the ring
+void ColumnRing::push(long time, const Eigen::Ref<const Eigen::VectorXs>& value)
+{
+  assert(value.size() == mRows);
+  assert(mSize == 0 || time >= this->time(mSize - 1));
+
+  if (mSize == mCapacity)
+  {
+    if (mGrowable)
+      grow();
+    else
+      popFront(1);
+  }
+
+  if (mSize == 1)
+    mInterval = time - this->time(0);
+  else if (mSize > 1 && time - this->time(mSize - 1) != mInterval)
+    mInterval = -1;
+
+  int k = slot(mSize);
+  mValues.col(k) = value;
+  mValues.col(k + mCapacity) = value;
+  mTimes[k] = time;
+  mSize++;
+}
+
+/// This overwrites the value of an existing column
+void ColumnRing::set(int i, const Eigen::Ref<const Eigen::VectorXs>& value)
+{
+  assert(i >= 0 && i < mSize);
+  int k = slot(i);
+  mValues.col(k) = value;
+  mValues.col(k + mCapacity) = value;
+}
+
+/// This drops the `n` oldest columns
+void ColumnRing::popFront(int n)
+{
+  n = std::min(n, mSize);
+  mHead = (mHead + n) % mCapacity;
+  mSize -= n;
+  // Dropping columns off the front of an evenly spaced stream leaves it
+  // evenly spaced, but once we're down to one column there's no spacing left
+  if (mSize < 2)
+    mInterval = -1;
+}
+
+/// This drops every column
+void ColumnRing::clear()
+{
+  mHead = 0;
+  mSize = 0;
+  mInterval = -1;
+}
+
+/// This returns the number of columns in the ring
+int ColumnRing::size() const
+{
+  return mSize;
+}
+
+/// This returns the number of rows in every column
+int ColumnRing::rows() const
+{
+  return mRows;
+}
+
+/// This returns the timestamp of the `i`th oldest column
+long ColumnRing::time(int i) const
+{
+  assert(i >= 0 && i < mSize);
+  return mTimes[slot(i)];
+}
+
+/// This returns a zero-copy view of the `i`th oldest column
+Eigen::Ref<const Eigen::VectorXs> ColumnRing::col(int i) const
+{
+  assert(i >= 0 && i < mSize);
+  return mValues.col(slot(i));
+}
+
+/// This returns a zero-copy view of `n` consecutive columns, starting with
+/// the `i`th oldest
+Eigen::Ref<const Eigen::MatrixXs> ColumnRing::block(int i, int n) const
+{
+  assert(i >= 0 && n >= 0 && i + n <= mSize);
+  // The mirror copy means this never runs off the end of mValues, even when
+  // the run wraps around the end of the ring
+  return mValues.middleCols(slot(i), n);
+}
+
+/// This returns the number of columns with a timestamp <= `time`, which is
+/// also the index of the first column after `time`
+int ColumnRing::countAtOrBefore(long time) const
+{
+  if (mSize == 0 || time < this->time(0))
+    return 0;
+  if (mInterval > 0)
+  {
+    long index = (time - this->time(0)) / mInterval + 1;
+    return static_cast<int>(std::min<long>(index, mSize));
+  }
+  if (mInterval == 0)
+  {
+    // Every timestamp is the same, and we already know it's <= `time`
+    return mSize;
+  }
+  // Binary search for the first column after `time`
+  int lo = 0;
+  int hi = mSize;
+  while (lo < hi)
+  {
+    int mid = (lo + hi) / 2;
+    if (this->time(mid) <= time)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/// This returns the number of columns with a timestamp < `time`
+int ColumnRing::countBefore(long time) const
+{
+  return countAtOrBefore(time - 1);
+}
+
+/// This returns the physical slot (in [0, capacity)) of the `i`th oldest
+/// column
+int ColumnRing::slot(int i) const
+{
+  return (mHead + i) % mCapacity;
+}
+
+/// This doubles the capacity of a growable ring, keeping its contents
+void ColumnRing::grow()
+{
+  int newCapacity = 2 * mCapacity;
+  Eigen::MatrixXs newValues = Eigen::MatrixXs::Zero(mRows, 2 * newCapacity);
+  std::vector<long> newTimes(newCapacity, 0L);
+  newValues.leftCols(mSize) = block(0, mSize);
+  newValues.middleCols(newCapacity, mSize) = block(0, mSize);
+  for (int i = 0; i < mSize; i++)
+  {
+    newTimes[i] = time(i);
+  }
+  mValues = newValues;
+  mTimes = newTimes;
+  mCapacity = newCapacity;
+  mHead = 0;
+}
+
+} // namespace realtime
+} // namespace dart
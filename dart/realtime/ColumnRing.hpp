@@ -0,0 +1,92 @@
+#ifndef DART_REALTIME_COLUMN_RING
+#define DART_REALTIME_COLUMN_RING
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace realtime {
+
+/// This is a ring buffer of timestamped, fixed-size column vectors, which is
+/// the storage behind VectorLog, ObservationLog and ControlLog.
+///
+/// Every column is stored twice, `capacity` columns apart, so any run of
+/// consecutive columns is one contiguous block of memory. That lets block()
+/// hand out zero-copy views even when the run wraps around the end of the
+/// ring. Dropping old columns is O(1), and nothing allocates once the ring
+/// has reached its working size.
+///
+/// Timestamps must never decrease. While they've all been evenly spaced (a
+/// fixed-rate stream), timestamp lookups are computed directly in O(1).
+/// Irregular streams fall back to binary search.
+class ColumnRing
+{
+public:
+  /// If `capacity` is 0 the ring grows (by doubling) whenever it fills up,
+  /// so it never loses data. Otherwise it holds at most `capacity` columns,
+  /// and pushing onto a full ring drops the oldest column.
+  ColumnRing(int rows, int capacity = 0);
+
+  /// This appends a column to the end of the ring
+  void push(long time, const Eigen::Ref<const Eigen::VectorXs>& value);
+
+  /// This overwrites the value of an existing column
+  void set(int i, const Eigen::Ref<const Eigen::VectorXs>& value);
+
+  /// This drops the `n` oldest columns
+  void popFront(int n);
+
+  /// This drops every column
+  void clear();
+
+  /// This returns the number of columns in the ring
+  int size() const;
+
+  /// This returns the number of rows in every column
+  int rows() const;
+
+  /// This returns the timestamp of the `i`th oldest column
+  long time(int i) const;
+
+  /// This returns a zero-copy view of the `i`th oldest column
+  Eigen::Ref<const Eigen::VectorXs> col(int i) const;
+
+  /// This returns a zero-copy view of `n` consecutive columns, starting with
+  /// the `i`th oldest
+  Eigen::Ref<const Eigen::MatrixXs> block(int i, int n) const;
+
+  /// This returns the number of columns with a timestamp <= `time`, which is
+  /// also the index of the first column after `time`
+  int countAtOrBefore(long time) const;
+
+  /// This returns the number of columns with a timestamp < `time`
+  int countBefore(long time) const;
+
+protected:
+  /// This returns the physical slot (in [0, capacity)) of the `i`th oldest
+  /// column
+  int slot(int i) const;
+
+  /// This doubles the capacity of a growable ring, keeping its contents
+  void grow();
+
+  int mRows;
+  int mCapacity;
+  bool mGrowable;
+  int mHead;
+  int mSize;
+  /// This is `rows` x 2 * `capacity`, with column k mirrored at k + capacity
+  Eigen::MatrixXs mValues;
+  std::vector<long> mTimes;
+  /// This is the spacing between every pair of neighboring timestamps, or -1
+  /// if they haven't all been evenly spaced
+  long mInterval;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
@@ -4,7 +4,12 @@ namespace dart {
 namespace realtime {
 
 ControlLog::ControlLog(int dim, int millisPerStep)
-  : mDim(dim), mMillisPerStep(millisPerStep), mLogEnd(0L)
+  : mDim(dim),
+    mMillisPerStep(millisPerStep),
+    mLogStart(0L),
+    mLogEnd(0L),
+    mLog(dim),
+    mZero(Eigen::VectorXs::Zero(dim))
 {
 }
 
@@ -15,7 +20,7 @@ void ControlLog::record(long time, Eigen::VectorXs control)
   if (mLog.size() == 0)
   {
     mLogStart = time;
-    mLog.push_back(control);
+    mLog.push(time, control);
   }
   else
   {
@@ -33,18 +38,18 @@ void ControlLog::record(long time, Eigen::VectorXs control)
     // haven't had time to run a full timestep since our last recorded value
     if (steps == 0)
     {
-      mLog[mLog.size() - 1] = control;
+      mLog.set(mLog.size() - 1, control);
       return;
     }
     // Otherwise, we need to extend the last recorded force until just before
     // this timestep, on the assumption that the motors have been executing that
     // command until they were updated.
-    Eigen::VectorXs last = mLog[mLog.size() - 1];
+    Eigen::VectorXs last = mLog.col(mLog.size() - 1);
     for (int i = 0; i < steps - 1; i++)
     {
-      mLog.push_back(last);
+      mLog.push(logEnd + (i + 1) * mMillisPerStep, last);
     }
-    mLog.push_back(control);
+    mLog.push(logEnd + steps * mMillisPerStep, control);
   }
 }
 
@@ -54,22 +59,29 @@ long ControlLog::last()
 }
 
 Eigen::VectorXs ControlLog::get(long time)
+{
+  return getView(time);
+}
+
+/// This is a zero-copy version of get(). The view is invalidated by the next
+/// call to record(), discardBefore() or setMillisPerStep().
+Eigen::Ref<const Eigen::VectorXs> ControlLog::getView(long time) const
 {
   // If we haven't recorded anything yet, default to 0
   if (mLog.size() == 0)
   {
-    return Eigen::VectorXs::Zero(mDim);
+    return mZero;
   }
 
   int steps = (int)floor((s_t)(time - mLogStart) / mMillisPerStep);
   // If we're out of bounds in the past, extend our initial force
   if (steps <= 0)
-    return mLog[0];
+    return mLog.col(0);
   // If we're out of bounds in the future, extend our last force
   if (steps >= mLog.size())
-    return mLog[mLog.size() - 1];
+    return mLog.col(mLog.size() - 1);
   // Otherwise return the recorded force
-  return mLog[steps];
+  return mLog.col(steps);
 }
 
 void ControlLog::discardBefore(long time)
@@ -81,20 +93,15 @@ void ControlLog::discardBefore(long time)
   // known force
   if (discardSteps >= mLog.size())
   {
-    Eigen::VectorXs last = mLog[mLog.size() - 1];
+    Eigen::VectorXs last = mLog.col(mLog.size() - 1);
     mLog.clear();
-    mLog.push_back(last);
+    mLog.push(time, last);
     mLogStart = time;
     return;
   }
-  // Otherwise we're just snipping part of the log, so copy just the bit we care
-  // about, and throw away the rest
-  std::vector<Eigen::VectorXs> trimmedLog;
-  for (int i = discardSteps; i < mLog.size(); i++)
-  {
-    trimmedLog.push_back(mLog[i]);
-  }
-  mLog = trimmedLog;
+  // Otherwise we're just snipping part of the log, which just moves the front
+  // of the ring
+  mLog.popFront(discardSteps);
   mLogStart += discardSteps * mMillisPerStep;
 }
 
@@ -103,10 +110,11 @@ void ControlLog::setMillisPerStep(int newMillisPerStep)
   int duration = mLog.size() * mMillisPerStep;
   int newSteps = (int)ceil((s_t)duration / newMillisPerStep);
 
-  std::vector<Eigen::VectorXs> newLog;
+  ColumnRing newLog(mDim);
   for (int i = 0; i < newSteps; i++)
   {
-    newLog.push_back(get(mLogStart + i * newMillisPerStep));
+    long time = mLogStart + i * newMillisPerStep;
+    newLog.push(time, getView(time));
   }
 
   mMillisPerStep = newMillisPerStep;
@@ -114,4 +122,4 @@ void ControlLog::setMillisPerStep(int newMillisPerStep)
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
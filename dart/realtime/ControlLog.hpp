@@ -6,10 +6,14 @@
 #include <Eigen/Dense>
 
 #include "dart/math/MathTypes.hpp"
+#include "dart/realtime/ColumnRing.hpp"
 
 namespace dart {
 namespace realtime {
 
+/// This is a log of the control forces applied at each step, on a fixed
+/// millisPerStep grid. It's stored in a ColumnRing, so discarding old steps
+/// is O(1) and reads can return views without copying.
 class ControlLog
 {
 public:
@@ -21,6 +25,10 @@ public:
 
   Eigen::VectorXs get(long time);
 
+  /// This is a zero-copy version of get(). The view is invalidated by the next
+  /// call to record(), discardBefore() or setMillisPerStep().
+  Eigen::Ref<const Eigen::VectorXs> getView(long time) const;
+
   void discardBefore(long time);
 
   void setMillisPerStep(int millisPerStep);
@@ -30,7 +38,9 @@ protected:
   int mMillisPerStep;
   long mLogStart;
   long mLogEnd;
-  std::vector<Eigen::VectorXs> mLog;
+  ColumnRing mLog;
+  /// This is what getView() returns before we've recorded anything
+  Eigen::VectorXs mZero;
 };
 
 } // namespace realtime
@@ -0,0 +1,444 @@
+#include "dart/realtime/MPCHost.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/health_check_service_interface.h>
+
+#include "dart/proto/SerializeEigen.hpp"
+#include "dart/realtime/MPCLocal.hpp"
+#include "dart/realtime/MPCSampling.hpp"
+#include "dart/realtime/Millis.hpp"
+
+#include "signal.h"
+
+namespace dart {
+namespace realtime {
+
+/// This creates a host that replans on `numWorkers` threads. Zero or less
+/// means one worker per hardware thread.
+MPCHost::MPCHost(int numWorkers)
+  : mNumWorkers(numWorkers), mRunning(false), mNextId(0)
+{
+  if (mNumWorkers <= 0)
+  {
+    mNumWorkers = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+}
+
+MPCHost::~MPCHost()
+{
+  stop();
+}
+
+/// This adds a controller to the host, and returns its id. The host takes
+/// over replanning, so call startController() rather than start() on the
+/// controller itself. `deadlineMillis` is passed on to
+/// MPCLocal::setReplanningDeadlineMillis(), and 0 means no deadline.
+int MPCHost::addController(std::shared_ptr<MPCLocal> mpc, int deadlineMillis)
+{
+  std::shared_ptr<Controller> controller = std::make_shared<Controller>();
+  controller->mpc = mpc;
+  controller->optimizePlan
+      = [mpc](long startTime) { mpc->optimizePlan(startTime); };
+  controller->observeForce = [mpc](long time, Eigen::VectorXs force) {
+    mpc->mBuffer.manuallyRecordObservedForce(time, force);
+  };
+  controller->setDeadlineMillis
+      = [mpc](int millis) { mpc->setReplanningDeadlineMillis(millis); };
+  controller->deadlineMillis = deadlineMillis;
+  mpc->setReplanningDeadlineMillis(deadlineMillis);
+  return addController(controller);
+}
+
+/// This adds a sampling controller to the host, and returns its id.
+/// MPCSampling can't stop part way through a cycle, so here the deadline is
+/// only used to count overruns. Use MPCSampling::setNumSamples() to bound
+/// the cycle time instead.
+int MPCHost::addController(
+    std::shared_ptr<MPCSampling> mpc, int deadlineMillis)
+{
+  std::shared_ptr<Controller> controller = std::make_shared<Controller>();
+  controller->mpc = mpc;
+  controller->optimizePlan
+      = [mpc](long startTime) { mpc->optimizePlan(startTime); };
+  controller->observeForce = [mpc](long time, Eigen::VectorXs force) {
+    mpc->mBuffer.manuallyRecordObservedForce(time, force);
+  };
+  controller->setDeadlineMillis = [](int /* millis */) {};
+  controller->deadlineMillis = deadlineMillis;
+  return addController(controller);
+}
+
+/// This registers a controller, and returns its id
+int MPCHost::addController(std::shared_ptr<Controller> controller)
+{
+  controller->running = false;
+  controller->busy = false;
+  controller->lastScheduledTime = 0;
+  controller->millisInAdvanceToPlan = 0;
+  controller->numReplans = 0;
+  controller->numMissedDeadlines = 0;
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  int id = mNextId++;
+  mControllers[id] = controller;
+  return id;
+}
+
+/// This removes a controller from the host. If a worker is in the middle of
+/// replanning it, this waits for that to finish.
+void MPCHost::removeController(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  if (!controller)
+    return;
+  controller->running = false;
+  mChanged.wait(lock, [&]() { return !controller->busy; });
+  mControllers.erase(id);
+}
+
+/// This returns the controller with this id, or nullptr if there isn't one
+std::shared_ptr<MPC> MPCHost::getController(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  return controller ? controller->mpc : nullptr;
+}
+
+/// This returns how many controllers the host holds
+int MPCHost::getNumControllers()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mControllers.size();
+}
+
+/// This returns how many worker threads the host replans on
+int MPCHost::getNumWorkers()
+{
+  return mNumWorkers;
+}
+
+/// This sets the replanning deadline for one controller. 0 means no
+/// deadline.
+void MPCHost::setDeadlineMillis(int id, int millis)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  if (!controller)
+    return;
+  controller->deadlineMillis = millis;
+  controller->setDeadlineMillis(millis);
+}
+
+/// This returns the replanning deadline for one controller, or 0 if it has
+/// none
+int MPCHost::getDeadlineMillis(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  return controller ? controller->deadlineMillis : 0;
+}
+
+/// This lets the workers start replanning a controller
+void MPCHost::startController(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  if (!controller || controller->running)
+    return;
+  controller->running = true;
+  mChanged.notify_all();
+}
+
+/// This stops the workers replanning a controller. If a worker is in the
+/// middle of replanning it, this waits for that to finish.
+void MPCHost::stopController(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  if (!controller)
+    return;
+  controller->running = false;
+  mChanged.wait(lock, [&]() { return !controller->busy; });
+}
+
+/// This returns true if the workers are replanning this controller
+bool MPCHost::isControllerRunning(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  return controller && controller->running;
+}
+
+/// This returns how many times this controller has been replanned
+int MPCHost::getNumReplans(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  return controller ? controller->numReplans : 0;
+}
+
+/// This returns how many replans of this controller took longer than its
+/// deadline
+int MPCHost::getNumMissedDeadlines(int id)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::shared_ptr<Controller> controller = findController(id);
+  return controller ? controller->numMissedDeadlines : 0;
+}
+
+/// This starts the worker threads
+void MPCHost::start()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (mRunning)
+    return;
+  mRunning = true;
+  for (int i = 0; i < mNumWorkers; i++)
+  {
+    mWorkers.emplace_back(&MPCHost::workerLoop, this);
+  }
+}
+
+/// This stops the worker threads, waits for them to finish their current
+/// replans, and then returns
+void MPCHost::stop()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!mRunning)
+      return;
+    mRunning = false;
+    mChanged.notify_all();
+  }
+  for (std::thread& worker : mWorkers)
+  {
+    worker.join();
+  }
+  mWorkers.clear();
+}
+
+/// This launches a server for every controller on the specified port. This
+/// call blocks indefinitely, until the program is killed with Ctrl+C
+void MPCHost::serve(int port)
+{
+  std::string server_address("0.0.0.0:" + std::to_string(port));
+
+  grpc::EnableDefaultHealthCheckService(true);
+  grpc::ServerBuilder builder;
+  // Listen on the given address without any authentication mechanism.
+  builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+  // Every controller shares this one service, and requests get routed by
+  // their controllerId
+  RPCWrapperMPCHost wrapper(*this);
+
+  builder.RegisterService(&wrapper);
+  std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+  std::cout << "Server listening on " << server_address << " for "
+            << getNumControllers() << " controllers" << std::endl;
+
+  // Wait for the server to shutdown. Note that some other thread must be
+  // responsible for shutting down the server for this call to ever return.
+  server->Wait();
+}
+
+/// This returns the controller with this id, or nullptr if there isn't one.
+/// The caller must hold mMutex.
+std::shared_ptr<MPCHost::Controller> MPCHost::findController(int id)
+{
+  auto it = mControllers.find(id);
+  if (it == mControllers.end())
+    return nullptr;
+  return it->second;
+}
+
+/// This picks the controller a free worker should replan next, or nullptr if
+/// there's nothing to do. The caller must hold mMutex.
+std::shared_ptr<MPCHost::Controller> MPCHost::pickNextController()
+{
+  // Earliest deadline first, where a controller's deadline is the moment its
+  // plan buffer runs dry. A controller that just got replanned has a full
+  // buffer, so it goes to the back of the line, which keeps this fair.
+  std::shared_ptr<Controller> best = nullptr;
+  long bestRemaining = std::numeric_limits<long>::max();
+  for (auto& pair : mControllers)
+  {
+    const std::shared_ptr<Controller>& controller = pair.second;
+    if (!controller->running || controller->busy)
+      continue;
+    long remaining = controller->mpc->getRemainingPlanBufferMillis();
+    if (!best || remaining < bestRemaining
+        || (remaining == bestRemaining
+            && controller->lastScheduledTime < best->lastScheduledTime))
+    {
+      best = controller;
+      bestRemaining = remaining;
+    }
+  }
+  return best;
+}
+
+/// This is the function for each worker thread to run when we're live
+void MPCHost::workerLoop()
+{
+  // block signals in this thread and subsequently
+  // spawned threads, so they're guaranteed to go to the server thread
+  sigset_t sigset;
+  sigemptyset(&sigset);
+  sigaddset(&sigset, SIGINT);
+  sigaddset(&sigset, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (mRunning)
+  {
+    std::shared_ptr<Controller> controller = pickNextController();
+    if (!controller)
+    {
+      mChanged.wait(lock);
+      continue;
+    }
+    controller->busy = true;
+    long startTime = timeSinceEpochMillis();
+    controller->lastScheduledTime = startTime;
+    long millisInAdvanceToPlan = controller->millisInAdvanceToPlan;
+    lock.unlock();
+
+    controller->optimizePlan(startTime + millisInAdvanceToPlan);
+    long duration = timeSinceEpochMillis() - startTime;
+
+    lock.lock();
+    controller->busy = false;
+    controller->numReplans++;
+    if (controller->deadlineMillis > 0 && duration > controller->deadlineMillis)
+    {
+      controller->numMissedDeadlines++;
+    }
+    // Plan far enough ahead that the plan doesn't start in the past by the
+    // time we publish it, but not so far that errors build up. See
+    // MPCLocal::adjustPerformance().
+    controller->millisInAdvanceToPlan = std::min(200L, (long)(1.2 * duration));
+    mChanged.notify_all();
+  }
+}
+
+RPCWrapperMPCHost::RPCWrapperMPCHost(MPCHost& host) : mHost(host)
+{
+}
+
+/// Remotely start one controller running
+grpc::Status RPCWrapperMPCHost::Start(
+    grpc::ServerContext* /* context */,
+    const proto::MPCStartRequest* request,
+    proto::MPCStartReply* /* response */)
+{
+  if (!mHost.getController(request->controllerid()))
+  {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "No such controller");
+  }
+  mHost.startController(request->controllerid());
+  return grpc::Status::OK;
+}
+
+/// Remotely stop one controller running
+grpc::Status RPCWrapperMPCHost::Stop(
+    grpc::ServerContext* /* context */,
+    const proto::MPCStopRequest* request,
+    proto::MPCStopReply* /* response */)
+{
+  if (!mHost.getController(request->controllerid()))
+  {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "No such controller");
+  }
+  mHost.stopController(request->controllerid());
+  return grpc::Status::OK;
+}
+
+/// Remotely listen for replanning updates from one controller
+grpc::Status RPCWrapperMPCHost::ListenForUpdates(
+    grpc::ServerContext* context,
+    const proto::MPCListenForUpdatesRequest* request,
+    grpc::ServerWriter<proto::MPCListenForUpdatesReply>* writer)
+{
+  std::shared_ptr<MPC> mpc = mHost.getController(request->controllerid());
+  if (!mpc)
+  {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "No such controller");
+  }
+
+  // Unlike a single controller server, clients come and go while the host
+  // keeps running, so the listener has to stop writing once this call returns
+  struct Stream
+  {
+    std::mutex mutex;
+    bool open = true;
+  };
+  std::shared_ptr<Stream> stream = std::make_shared<Stream>();
+  auto write = streamPlanUpdates(
+      writer, static_cast<s_t>(request->quantizationprecision()));
+  mpc->registerReplanningListener(
+      [stream, write](
+          long startTime,
+          const trajectory::TrajectoryRollout* rollout,
+          long duration) {
+        std::unique_lock<std::mutex> lock(stream->mutex);
+        if (stream->open)
+          write(startTime, rollout, duration);
+      });
+
+  while (!context->IsCancelled())
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  std::unique_lock<std::mutex> lock(stream->mutex);
+  stream->open = false;
+  return grpc::Status::OK;
+}
+
+/// Remotely record the ground truth state of one controller's robot
+grpc::Status RPCWrapperMPCHost::RecordGroundTruthState(
+    grpc::ServerContext* /* context */,
+    const proto::MPCRecordGroundTruthStateRequest* request,
+    proto::MPCRecordGroundTruthStateReply* /* reply */)
+{
+  std::shared_ptr<MPC> mpc = mHost.getController(request->controllerid());
+  if (!mpc)
+  {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "No such controller");
+  }
+  mpc->recordGroundTruthState(
+      request->time(),
+      proto::deserializeVector(request->pos()),
+      proto::deserializeVector(request->vel()),
+      proto::deserializeVector(request->mass()));
+  return grpc::Status::OK;
+}
+
+/// Remotely record a force observed on one controller's robot
+grpc::Status RPCWrapperMPCHost::ObserveForce(
+    grpc::ServerContext* /* context */,
+    const proto::MPCObserveForceRequest* request,
+    proto::MPCObserveForceReply* /* reply */)
+{
+  std::shared_ptr<MPCHost::Controller> controller;
+  {
+    std::unique_lock<std::mutex> lock(mHost.mMutex);
+    controller = mHost.findController(request->controllerid());
+  }
+  if (!controller)
+  {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "No such controller");
+  }
+  controller->observeForce(
+      request->time(), proto::deserializeVector(request->force()));
+  return grpc::Status::OK;
+}
+
+} // namespace realtime
+} // namespace dart
@@ -0,0 +1,193 @@
+#ifndef DART_REALTIME_MPCHost
+#define DART_REALTIME_MPCHost
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/proto/MPC.grpc.pb.h"
+#include "dart/realtime/MPC.hpp"
+
+namespace dart {
+namespace realtime {
+
+class MPCLocal;
+class MPCSampling;
+
+/// This runs many MPC controllers (for example one per robot, or one per
+/// training episode) in a single process, on a fixed pool of worker threads,
+/// instead of giving every controller its own optimization thread. With more
+/// controllers than cores, per-controller threads just fight over the CPU, and
+/// the OS scheduler has no idea which controller is about to run out of plan.
+///
+/// Whenever a worker frees up, it replans the running controller whose plan
+/// buffer runs out soonest, breaking ties in favor of whichever has waited
+/// longest since it was last scheduled. A controller is never replanned by two
+/// workers at once. Each controller can have its own replanning deadline,
+/// which bounds how long a single replan can hold onto a worker.
+///
+/// serve() exposes every controller over a single gRPC endpoint, where the
+/// controllerId on each request picks the controller. MPCRemote can talk to
+/// one of them after MPCRemote::setControllerId().
+class MPCHost
+{
+public:
+  /// This creates a host that replans on `numWorkers` threads. Zero or less
+  /// means one worker per hardware thread.
+  MPCHost(int numWorkers = 0);
+
+  ~MPCHost();
+
+  /// This adds a controller to the host, and returns its id. The host takes
+  /// over replanning, so call startController() rather than start() on the
+  /// controller itself. `deadlineMillis` is passed on to
+  /// MPCLocal::setReplanningDeadlineMillis(), and 0 means no deadline.
+  int addController(std::shared_ptr<MPCLocal> mpc, int deadlineMillis = 0);
+
+  /// This adds a sampling controller to the host, and returns its id.
+  /// MPCSampling can't stop part way through a cycle, so here the deadline is
+  /// only used to count overruns. Use MPCSampling::setNumSamples() to bound
+  /// the cycle time instead.
+  int addController(std::shared_ptr<MPCSampling> mpc, int deadlineMillis = 0);
+
+  /// This removes a controller from the host. If a worker is in the middle of
+  /// replanning it, this waits for that to finish.
+  void removeController(int id);
+
+  /// This returns the controller with this id, or nullptr if there isn't one
+  std::shared_ptr<MPC> getController(int id);
+
+  /// This returns how many controllers the host holds
+  int getNumControllers();
+
+  /// This returns how many worker threads the host replans on
+  int getNumWorkers();
+
+  /// This sets the replanning deadline for one controller. 0 means no
+  /// deadline.
+  void setDeadlineMillis(int id, int millis);
+
+  /// This returns the replanning deadline for one controller, or 0 if it has
+  /// none
+  int getDeadlineMillis(int id);
+
+  /// This lets the workers start replanning a controller
+  void startController(int id);
+
+  /// This stops the workers replanning a controller. If a worker is in the
+  /// middle of replanning it, this waits for that to finish.
+  void stopController(int id);
+
+  /// This returns true if the workers are replanning this controller
+  bool isControllerRunning(int id);
+
+  /// This returns how many times this controller has been replanned
+  int getNumReplans(int id);
+
+  /// This returns how many replans of this controller took longer than its
+  /// deadline
+  int getNumMissedDeadlines(int id);
+
+  /// This starts the worker threads
+  void start();
+
+  /// This stops the worker threads, waits for them to finish their current
+  /// replans, and then returns
+  void stop();
+
+  /// This launches a server for every controller on the specified port. This
+  /// call blocks indefinitely, until the program is killed with Ctrl+C
+  void serve(int port);
+
+protected:
+  struct Controller
+  {
+    std::shared_ptr<MPC> mpc;
+    std::function<void(long)> optimizePlan;
+    std::function<void(long, Eigen::VectorXs)> observeForce;
+    std::function<void(int)> setDeadlineMillis;
+    int deadlineMillis;
+    bool running;
+    bool busy;
+    long lastScheduledTime;
+    long millisInAdvanceToPlan;
+    int numReplans;
+    int numMissedDeadlines;
+  };
+
+  /// This registers a controller, and returns its id
+  int addController(std::shared_ptr<Controller> controller);
+
+  /// This returns the controller with this id, or nullptr if there isn't one.
+  /// The caller must hold mMutex.
+  std::shared_ptr<Controller> findController(int id);
+
+  /// This picks the controller a free worker should replan next, or nullptr if
+  /// there's nothing to do. The caller must hold mMutex.
+  std::shared_ptr<Controller> pickNextController();
+
+  /// This is the function for each worker thread to run when we're live
+  void workerLoop();
+
+  int mNumWorkers;
+  bool mRunning;
+  int mNextId;
+  std::map<int, std::shared_ptr<Controller>> mControllers;
+  std::vector<std::thread> mWorkers;
+  std::mutex mMutex;
+  /// This gets notified whenever a controller might have become ready to
+  /// replan, or a replan finishes
+  std::condition_variable mChanged;
+
+  friend class RPCWrapperMPCHost;
+};
+
+class RPCWrapperMPCHost : public proto::MPCService::Service
+{
+public:
+  RPCWrapperMPCHost(MPCHost& host);
+
+  /// Remotely start one controller running
+  grpc::Status Start(
+      grpc::ServerContext* context,
+      const proto::MPCStartRequest* request,
+      proto::MPCStartReply* response) override;
+
+  /// Remotely stop one controller running
+  grpc::Status Stop(
+      grpc::ServerContext* context,
+      const proto::MPCStopRequest* request,
+      proto::MPCStopReply* response) override;
+
+  /// Remotely listen for replanning updates from one controller
+  grpc::Status ListenForUpdates(
+      grpc::ServerContext* context,
+      const proto::MPCListenForUpdatesRequest* request,
+      grpc::ServerWriter<proto::MPCListenForUpdatesReply>* writer) override;
+
+  /// Remotely record the ground truth state of one controller's robot
+  grpc::Status RecordGroundTruthState(
+      grpc::ServerContext* context,
+      const proto::MPCRecordGroundTruthStateRequest* request,
+      proto::MPCRecordGroundTruthStateReply* reply) override;
+
+  /// Remotely record a force observed on one controller's robot
+  grpc::Status ObserveForce(
+      grpc::ServerContext* context,
+      const proto::MPCObserveForceRequest* request,
+      proto::MPCObserveForceReply* reply) override;
+
+protected:
+  MPCHost& mHost;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
@@ -1,5 +1,8 @@
 #include "dart/realtime/MPCLocal.hpp"
 
+#include <vector>
+
+#include <google/protobuf/arena.h>
 #include <google/protobuf/arena_impl.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 #include <grpcpp/grpcpp.h>
@@ -38,6 +41,8 @@ MPCLocal::MPCLocal(
     mEnableLinesearch(true),
     mEnableOptimizationGuards(false),
     mRecordIterations(false),
+    mEnableWarmStart(true),
+    mReplanningDeadlineMillis(0),
     mPlanningHorizonMillis(planningHorizonMillis),
     mMillisPerStep(1000 * world->getTimeStep()),
     mSteps((int)ceil((s_t)planningHorizonMillis / mMillisPerStep)),
@@ -45,6 +50,7 @@ MPCLocal::MPCLocal(
     mMaxIterations(5),
     mMillisInAdvanceToPlan(0),
     mLastOptimizedTime(0L),
+    mReplanningDeadline(0L),
     mBuffer(RealTimeControlBuffer(world->getNumDofs(), mSteps, mMillisPerStep)),
     mSilent(false)
 {
@@ -59,6 +65,8 @@ MPCLocal::MPCLocal(const MPCLocal& mpc)
     mEnableLinesearch(mpc.mEnableLinesearch),
     mEnableOptimizationGuards(mpc.mEnableOptimizationGuards),
     mRecordIterations(mpc.mRecordIterations),
+    mEnableWarmStart(mpc.mEnableWarmStart),
+    mReplanningDeadlineMillis(mpc.mReplanningDeadlineMillis),
     mPlanningHorizonMillis(mpc.mPlanningHorizonMillis),
     mMillisPerStep(mpc.mMillisPerStep),
     mSteps(mpc.mSteps),
@@ -66,6 +74,7 @@ MPCLocal::MPCLocal(const MPCLocal& mpc)
     mMaxIterations(mpc.mMaxIterations),
     mMillisInAdvanceToPlan(mpc.mMillisInAdvanceToPlan),
     mLastOptimizedTime(mpc.mLastOptimizedTime),
+    mReplanningDeadline(0L),
     mBuffer(mpc.mBuffer),
     mSilent(mpc.mSilent)
 {
@@ -85,6 +94,10 @@ void MPCLocal::setLoss(std::shared_ptr<trajectory::LossFn> loss)
 void MPCLocal::setOptimizer(std::shared_ptr<trajectory::Optimizer> optimizer)
 {
   mOptimizer = optimizer;
+  if (mOptimizer)
+  {
+    registerDeadlineCallback(mOptimizer);
+  }
 }
 
 /// This returns the current optimizer that MPCLocal is using
@@ -167,6 +180,42 @@ void MPCLocal::setMaxIterations(int maxIters)
   mMaxIterations = maxIters;
 }
 
+/// This enables carrying the IPOPT multipliers over from one replanning solve
+/// to the next, shifted to follow the advanced horizon. Defaults to true. The
+/// planned forces themselves are always shifted forward as the starting point
+/// for the next solve.
+void MPCLocal::setEnableWarmStart(bool enabled)
+{
+  mEnableWarmStart = enabled;
+}
+
+/// This sets a wall-clock budget, in milliseconds, for each replanning solve.
+/// Once the budget runs out the optimizer stops at the end of its current
+/// iteration, and whatever plan it has at that point is published to the
+/// control buffer. Combine this with setEnableOptimizationGuards(true) to
+/// publish the best feasible plan found so far, rather than the last iterate.
+/// 0 (the default) means there is no deadline.
+void MPCLocal::setReplanningDeadlineMillis(int millis)
+{
+  mReplanningDeadlineMillis = millis;
+}
+
+/// This returns the wall-clock budget for each replanning solve, or 0 if there
+/// is no deadline.
+int MPCLocal::getReplanningDeadlineMillis()
+{
+  return mReplanningDeadlineMillis;
+}
+
+/// This lets the control buffer cache estimated world states, so that
+/// estimating the state at the start of each replan only has to simulate
+/// forward from the last state it settled on, rather than all the way from the
+/// last observation. Defaults to false.
+void MPCLocal::setEnableStateEstimateCache(bool enabled)
+{
+  mBuffer.setEnableStateCache(enabled);
+}
+
 /// This records the current state of the world based on some external sensing
 /// and inference. This resets the error in our model just assuming the world
 /// is exactly following our simulation.
@@ -219,6 +268,7 @@ void MPCLocal::optimizePlan(long startTime)
         ipoptOptimizer->setSilenceOutput(true);
       }
       mOptimizer = ipoptOptimizer;
+      registerDeadlineCallback(mOptimizer);
 
       createOpt->end();
     }
@@ -233,6 +283,11 @@ void MPCLocal::optimizePlan(long startTime)
     }
 
     PerformanceLog* optimizeTrack = log->startRun("Optimize");
+    mReplanningDeadline = 0L;
+    if (mReplanningDeadlineMillis > 0)
+    {
+      mReplanningDeadline = timeSinceEpochMillis() + mReplanningDeadlineMillis;
+    }
     //std::cout<<"MPC Optimization Start"<<std::endl;
     mSolution = mOptimizer->optimize(mProblem.get());
     //std::cout<<"MPC Optimization end"<<std::endl;
@@ -270,17 +325,37 @@ void MPCLocal::optimizePlan(long startTime)
     }
 
     long startComputeWallTime = timeSinceEpochMillis();
+    mReplanningDeadline = 0L;
+    if (mReplanningDeadlineMillis > 0)
+    {
+      mReplanningDeadline = startComputeWallTime + mReplanningDeadlineMillis;
+    }
 
     mBuffer.estimateWorldStateAt(
         worldClone, &mObservationLog, roundedStartTime);
 
-    mProblem->advanceSteps(
+    // This shifts the old plan forward in place, so the problem's current
+    // state is the primal warm start for the next solve
+    Eigen::VectorXi mapping = mProblem->advanceSteps(
         worldClone,
         worldClone->getPositions(),
         worldClone->getVelocities(),
         steps);
 
-    mSolution->reoptimize();
+    if (mSolution->canReoptimize())
+    {
+      if (mEnableWarmStart)
+      {
+        mSolution->shiftWarmStart(mapping);
+      }
+      mSolution->reoptimize();
+    }
+    else
+    {
+      // Optimizers other than IPOPT can't resume an old solve, but they still
+      // start from the shifted plan that's now in the problem
+      mSolution = mOptimizer->optimize(mProblem.get(), mSolution);
+    }
 
     // std::cout << "MPCLocal::optimizePlan() mBuffer.setControlForcePlan()" <<
     // std::endl;
@@ -416,6 +491,65 @@ void MPCLocal::serve(int port)
 /// Implements the gRPC API
 ///////////////////////////////////////////////////////////////////////
 
+/// This returns a replanning listener that streams every new plan to
+/// `writer`, quantized to `precision` if that's positive. This is shared by
+/// everything that serves MPCService.ListenForUpdates.
+std::function<void(long, const trajectory::TrajectoryRollout*, long)>
+streamPlanUpdates(
+    grpc::ServerWriter<proto::MPCListenForUpdatesReply>* writer,
+    s_t precision)
+{
+  // Each update is built in a fresh arena that starts out in `arenaBlock`,
+  // which grows to fit the biggest update so far, so steady-state replanning
+  // doesn't allocate while encoding
+  std::shared_ptr<std::vector<char>> arenaBlock
+      = std::make_shared<std::vector<char>>();
+  return [writer, precision, arenaBlock](
+      long startTime,
+      const trajectory::TrajectoryRollout* rollout,
+      long duration) {
+    std::size_t spaceAllocated = 0;
+    {
+      google::protobuf::ArenaOptions options;
+      if (!arenaBlock->empty())
+      {
+        options.initial_block = arenaBlock->data();
+        options.initial_block_size = arenaBlock->size();
+      }
+      google::protobuf::Arena arena(options);
+      proto::MPCListenForUpdatesReply* reply = google::protobuf::Arena::
+          CreateMessage<proto::MPCListenForUpdatesReply>(&arena);
+      if (precision > 0)
+      {
+        // Send just the identity mapping, quantized and delta encoded
+        proto::QuantizedTrajectoryRollout* quantized
+            = reply->mutable_quantizedrollout();
+        serializeQuantizedMatrix(
+            *quantized->mutable_pos(), rollout->getPosesConst(), precision);
+        serializeQuantizedMatrix(
+            *quantized->mutable_vel(), rollout->getVelsConst(), precision);
+        serializeQuantizedMatrix(
+            *quantized->mutable_force(),
+            rollout->getControlForcesConst(),
+            precision);
+        serializeVector(*quantized->mutable_mass(), rollout->getMassesConst());
+      }
+      else
+      {
+        rollout->serialize(*reply->mutable_rollout());
+      }
+      reply->set_starttime(startTime);
+      reply->set_replandurationmillis(duration);
+      writer->Write(*reply);
+      spaceAllocated = arena.SpaceAllocated();
+    }
+    if (spaceAllocated > arenaBlock->size())
+    {
+      arenaBlock->resize(spaceAllocated);
+    }
+  };
+}
+
 RPCWrapperMPCLocal::RPCWrapperMPCLocal(MPCLocal& local) : mLocal(local)
 {
 }
@@ -443,20 +577,11 @@ grpc::Status RPCWrapperMPCLocal::Stop(
 /// Remotely listen for replanning updates
 grpc::Status RPCWrapperMPCLocal::ListenForUpdates(
     grpc::ServerContext* /* context */,
-    const proto::MPCListenForUpdatesRequest* /* request */,
+    const proto::MPCListenForUpdatesRequest* request,
     grpc::ServerWriter<proto::MPCListenForUpdatesReply>* writer)
 {
-  proto::MPCListenForUpdatesReply reply;
-  mLocal.registerReplanningListener(
-      [&](long startTime,
-          const trajectory::TrajectoryRollout* rollout,
-          long duration) {
-        reply.mutable_rollout()->Clear();
-        rollout->serialize(*reply.mutable_rollout());
-        reply.set_starttime(startTime);
-        reply.set_replandurationmillis(duration);
-        writer->Write(reply);
-      });
+  mLocal.registerReplanningListener(streamPlanUpdates(
+      writer, static_cast<s_t>(request->quantizationprecision())));
 
   while (true)
   {
@@ -511,6 +636,21 @@ void MPCLocal::optimizationThreadLoop()
   }
 }
 
+/// This registers a callback on the optimizer that stops it once we've run
+/// past mReplanningDeadline
+void MPCLocal::registerDeadlineCallback(
+    std::shared_ptr<trajectory::Optimizer> optimizer)
+{
+  optimizer->registerIntermediateCallback(
+      [this](trajectory::Problem* /* problem */,
+             int /* step */,
+             s_t /* primal */,
+             s_t /* dual */) {
+        return mReplanningDeadline == 0
+               || timeSinceEpochMillis() < mReplanningDeadline;
+      });
+}
+
 bool MPCLocal::variableChange()
 {
   return mVarchange;
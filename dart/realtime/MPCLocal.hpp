@@ -1,6 +1,7 @@
 #ifndef DART_REALTIME_MPCLocal
 #define DART_REALTIME_MPCLocal
 
+#include <functional>
 #include <memory>
 #include <thread>
 
@@ -31,6 +32,7 @@ class MPCLocal final : public MPC
 {
 
   friend class MPCRemote;
+  friend class MPCHost;
 
 public:
   MPCLocal(
@@ -98,6 +100,30 @@ public:
   /// values observed during running.
   void setMaxIterations(int maxIters);
 
+  /// This enables carrying the IPOPT multipliers over from one replanning
+  /// solve to the next, shifted to follow the advanced horizon. Defaults to
+  /// true. The planned forces themselves are always shifted forward as the
+  /// starting point for the next solve.
+  void setEnableWarmStart(bool enabled);
+
+  /// This sets a wall-clock budget, in milliseconds, for each replanning
+  /// solve. Once the budget runs out the optimizer stops at the end of its
+  /// current iteration, and whatever plan it has at that point is published to
+  /// the control buffer. Combine this with setEnableOptimizationGuards(true) to
+  /// publish the best feasible plan found so far, rather than the last
+  /// iterate. 0 (the default) means there is no deadline.
+  void setReplanningDeadlineMillis(int millis);
+
+  /// This returns the wall-clock budget for each replanning solve, or 0 if
+  /// there is no deadline.
+  int getReplanningDeadlineMillis();
+
+  /// This lets the control buffer cache estimated world states, so that
+  /// estimating the state at the start of each replan only has to simulate
+  /// forward from the last state it settled on, rather than all the way from
+  /// the last observation. Defaults to false.
+  void setEnableStateEstimateCache(bool enabled);
+
   /// This records the current state of the world based on some external sensing
   /// and inference. This resets the error in our model just assuming the world
   /// is exactly following our simulation.
@@ -149,6 +175,11 @@ protected:
   /// This is the function for the optimization thread to run when we're live
   void optimizationThreadLoop();
 
+  /// This registers a callback on the optimizer that stops it once we've run
+  /// past mReplanningDeadline
+  void registerDeadlineCallback(
+      std::shared_ptr<trajectory::Optimizer> optimizer);
+
   bool mRunning;
   std::shared_ptr<simulation::World> mWorld;
   std::shared_ptr<trajectory::LossFn> mLoss;
@@ -158,6 +189,8 @@ protected:
   bool mEnableLinesearch;
   bool mEnableOptimizationGuards;
   bool mRecordIterations;
+  bool mEnableWarmStart;
+  int mReplanningDeadlineMillis;
 
   int mPlanningHorizonMillis;
   int mMillisPerStep;
@@ -166,6 +199,8 @@ protected:
   int mMaxIterations;
   int mMillisInAdvanceToPlan;
   long mLastOptimizedTime;
+  // The wall time at which the current solve has to stop, or 0 for no deadline
+  long mReplanningDeadline;
   RealTimeControlBuffer mBuffer;
   std::thread mOptimizationThread;
   bool mSilent;
@@ -225,6 +260,14 @@ protected:
   MPCLocal& mLocal;
 };
 
+/// This returns a replanning listener that streams every new plan to
+/// `writer`, quantized to `precision` if that's positive. This is shared by
+/// everything that serves MPCService.ListenForUpdates.
+std::function<void(long, const trajectory::TrajectoryRollout*, long)>
+streamPlanUpdates(
+    grpc::ServerWriter<proto::MPCListenForUpdatesReply>* writer,
+    s_t precision);
+
 } // namespace realtime
 } // namespace dart
 
@@ -21,19 +21,39 @@ MPCRemote::MPCRemote(
     mChannel(grpc::CreateChannel(
         host + ":" + std::to_string(port), grpc::InsecureChannelCredentials())),
     mStub(proto::MPCService::NewStub(mChannel)),
-    mBuffer(dofs, steps, millisPerStep)
+    mBuffer(dofs, steps, millisPerStep),
+    mPlanQuantization(0),
+    mControllerId(0),
+    mDofs(dofs),
+    mSteps(steps),
+    mMassDim(0)
 {
 }
 
 /// This forks the process, starts a server on another process, and connects
-/// to it
-MPCRemote::MPCRemote(MPCLocal& local, int /* ignored */)
+/// to it. If `useSharedMemory` is true, plans come back from the child
+/// process through a SharedMemoryPlanRing instead of a gRPC stream, which
+/// cuts plan-update latency from milliseconds to microseconds. Start, stop
+/// and state updates still go over gRPC.
+MPCRemote::MPCRemote(MPCLocal& local, int /* ignored */, bool useSharedMemory)
   : mRunning(false),
     mChannel(nullptr),
     mStub(nullptr),
     mBuffer(RealTimeControlBuffer(
-        local.mWorld->getNumDofs(), local.mSteps, local.mMillisPerStep))
+        local.mWorld->getNumDofs(), local.mSteps, local.mMillisPerStep)),
+    mPlanQuantization(0),
+    mControllerId(0),
+    mDofs(local.mWorld->getNumDofs()),
+    mSteps(local.mSteps),
+    mMassDim(local.mWorld->getMassDims())
 {
+  // The ring has to exist before we fork, so both processes map it
+  if (useSharedMemory)
+  {
+    mPlanRing = std::make_shared<SharedMemoryPlanRing>(
+        mDofs, mSteps, mMassDim);
+  }
+
   int port = (rand() % 2000) + 2000;
 
   int original_id = getpid();
@@ -56,6 +76,16 @@ MPCRemote::MPCRemote(MPCLocal& local, int /* ignored */)
         }
       }
     });
+    // Publish every plan straight into shared memory
+    if (mPlanRing)
+    {
+      std::shared_ptr<SharedMemoryPlanRing> ring = mPlanRing;
+      local.registerReplanningListener(
+          [ring](
+              long startTime,
+              const trajectory::TrajectoryRollout* rollout,
+              long duration) { ring->publish(startTime, duration, rollout); });
+    }
     // Start a server on this thread
     local.serve(port);
     // When we're done serving, kill this process
@@ -83,6 +113,24 @@ Eigen::VectorXs MPCRemote::getControlForce(long now)
   return mBuffer.getPlannedForce(now);
 }
 
+/// If this is positive, the server sends plans rounded to this precision
+/// and delta encoded along time (see QuantizedMatrixXs), which makes each
+/// plan update several times smaller over the network. Zero (the default)
+/// sends full precision plans. This should be called before start(), and
+/// does nothing in shared memory mode.
+void MPCRemote::setPlanQuantization(s_t precision)
+{
+  mPlanQuantization = precision;
+}
+
+/// This picks which controller we talk to, when the server is an MPCHost
+/// holding many of them. Defaults to 0. Servers with a single controller
+/// ignore this. This should be called before start().
+void MPCRemote::setControllerId(int id)
+{
+  mControllerId = id;
+}
+
 /// This returns how many millis we have left until we've run out of plan.
 /// This can be a negative number, if we've run past our plan.
 long MPCRemote::getRemainingPlanBufferMillis()
@@ -105,6 +153,7 @@ void MPCRemote::recordGroundTruthState(
   proto::serializeVector(*request.mutable_pos(), pos);
   proto::serializeVector(*request.mutable_vel(), vel);
   proto::serializeVector(*request.mutable_mass(), mass);
+  request.set_controllerid(mControllerId);
 
   proto::MPCRecordGroundTruthStateReply reply;
 
@@ -133,6 +182,7 @@ void MPCRemote::start()
 
   proto::MPCStartRequest request;
   request.set_clientclock(timeSinceEpochMillis());
+  request.set_controllerid(mControllerId);
 
   proto::MPCStartReply reply;
 
@@ -146,6 +196,13 @@ void MPCRemote::start()
               << status.error_message() << std::endl;
   }
 
+  if (mPlanRing)
+  {
+    mUpdateListenerThread
+        = std::thread(&MPCRemote::sharedMemoryListenerLoop, this);
+    return;
+  }
+
   // Start a thread to listen for updates
   mUpdateListenerThread = std::thread([&]() {
     // Context for the client. It could be used to convey extra information to
@@ -153,6 +210,9 @@ void MPCRemote::start()
     grpc::ClientContext context;
 
     proto::MPCListenForUpdatesRequest request;
+    request.set_quantizationprecision(
+        static_cast<double>(mPlanQuantization));
+    request.set_controllerid(mControllerId);
 
     // The actual RPC.
     std::unique_ptr<grpc::ClientReader<proto::MPCListenForUpdatesReply>> stream
@@ -161,26 +221,103 @@ void MPCRemote::start()
     proto::MPCListenForUpdatesReply reply;
     while (mRunning && stream->Read(&reply))
     {
-      trajectory::TrajectoryRolloutReal rollout
-          = trajectory::TrajectoryRollout::deserialize(reply.rollout());
-
-      mBuffer.setControlForcePlan(
-          reply.starttime(), timeSinceEpochMillis(), rollout.getControlForcesConst());
-
-      for (auto listener : mReplannedListeners)
+      if (reply.has_quantizedrollout())
+      {
+        const proto::QuantizedTrajectoryRollout& quantized
+            = reply.quantizedrollout();
+        std::unordered_map<std::string, Eigen::MatrixXs> pos;
+        std::unordered_map<std::string, Eigen::MatrixXs> vel;
+        std::unordered_map<std::string, Eigen::MatrixXs> force;
+        pos["identity"] = proto::deserializeQuantizedMatrix(quantized.pos());
+        vel["identity"] = proto::deserializeQuantizedMatrix(quantized.vel());
+        force["identity"]
+            = proto::deserializeQuantizedMatrix(quantized.force());
+        trajectory::TrajectoryRolloutReal rollout(
+            pos,
+            vel,
+            force,
+            proto::deserializeVector(quantized.mass()),
+            std::unordered_map<std::string, Eigen::MatrixXs>());
+        receivePlan(reply.starttime(), rollout, reply.replandurationmillis());
+      }
+      else
       {
-        listener(reply.starttime(), &rollout, reply.replandurationmillis());
+        trajectory::TrajectoryRolloutReal rollout
+            = trajectory::TrajectoryRollout::deserialize(reply.rollout());
+        receivePlan(reply.starttime(), rollout, reply.replandurationmillis());
       }
     }
   });
 }
 
+/// This handles a freshly received plan
+void MPCRemote::receivePlan(
+    long startTime,
+    const trajectory::TrajectoryRollout& rollout,
+    long replanDurationMillis)
+{
+  mBuffer.setControlForcePlan(
+      startTime, timeSinceEpochMillis(), rollout.getControlForcesConst());
+
+  for (auto listener : mReplannedListeners)
+  {
+    listener(startTime, &rollout, replanDurationMillis);
+  }
+}
+
+/// This is the loop the update listener thread runs in shared memory mode
+void MPCRemote::sharedMemoryListenerLoop()
+{
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  pos["identity"] = Eigen::MatrixXs::Zero(mDofs, mSteps);
+  vel["identity"] = Eigen::MatrixXs::Zero(mDofs, mSteps);
+  force["identity"] = Eigen::MatrixXs::Zero(mDofs, mSteps);
+  trajectory::TrajectoryRolloutReal rollout(
+      pos,
+      vel,
+      force,
+      Eigen::VectorXs::Zero(mMassDim),
+      std::unordered_map<std::string, Eigen::MatrixXs>());
+
+  unsigned long lastSeen = 0;
+  long startTime = 0;
+  long duration = 0;
+  while (mRunning)
+  {
+    // Copy straight into the rollout we hand to listeners, so nothing on this
+    // path allocates
+    if (mPlanRing->readLatest(
+            lastSeen,
+            startTime,
+            duration,
+            rollout.getPoses(),
+            rollout.getVels(),
+            rollout.getControlForces(),
+            rollout.getMasses()))
+    {
+      receivePlan(startTime, rollout, duration);
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+
 /// This stops our main thread, waits for it to finish, and then returns
 void MPCRemote::stop()
 {
   if (!mRunning)
     return;
   mRunning = false;
+  // The shared memory listener checks mRunning on every poll, so unlike the
+  // gRPC stream, it's safe to wait for it here
+  if (mPlanRing && mUpdateListenerThread.joinable())
+  {
+    mUpdateListenerThread.join();
+  }
 
   // Context for the client. It could be used to convey extra information to
   // the server and/or tweak certain RPC behaviors.
@@ -188,6 +325,7 @@ void MPCRemote::stop()
 
   proto::MPCStopRequest request;
   request.set_clientclock(timeSinceEpochMillis());
+  request.set_controllerid(mControllerId);
 
   proto::MPCStopReply reply;
 
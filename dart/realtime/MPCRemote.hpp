@@ -9,6 +9,7 @@
 #include "dart/realtime/MPC.hpp"
 #include "dart/realtime/MPCLocal.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
+#include "dart/realtime/SharedMemoryPlanRing.hpp"
 
 namespace grpc {
 class Channel;
@@ -30,8 +31,23 @@ public:
       int millisPerStep);
 
   /// This forks the process, starts a server on another process, and connects
-  /// to it
-  MPCRemote(MPCLocal& local, int ignored = 0);
+  /// to it. If `useSharedMemory` is true, plans come back from the child
+  /// process through a SharedMemoryPlanRing instead of a gRPC stream, which
+  /// cuts plan-update latency from milliseconds to microseconds. Start, stop
+  /// and state updates still go over gRPC.
+  MPCRemote(MPCLocal& local, int ignored = 0, bool useSharedMemory = false);
+
+  /// If this is positive, the server sends plans rounded to this precision
+  /// and delta encoded along time (see QuantizedMatrixXs), which makes each
+  /// plan update several times smaller over the network. Zero (the default)
+  /// sends full precision plans. This should be called before start(), and
+  /// does nothing in shared memory mode.
+  void setPlanQuantization(s_t precision);
+
+  /// This picks which controller we talk to, when the server is an MPCHost
+  /// holding many of them. Defaults to 0. Servers with a single controller
+  /// ignore this. This should be called before start().
+  void setControllerId(int id);
 
   /// This gets the force to apply to the world at this instant. If we haven't
   /// computed anything for this instant yet, this just returns 0s.
@@ -62,11 +78,28 @@ public:
           replanListener) override;
 
 protected:
+  /// This handles a freshly received plan
+  void receivePlan(
+      long startTime,
+      const trajectory::TrajectoryRollout& rollout,
+      long replanDurationMillis);
+
+  /// This is the loop the update listener thread runs in shared memory mode
+  void sharedMemoryListenerLoop();
+
   bool mRunning;
   std::shared_ptr<grpc::Channel> mChannel;
   std::unique_ptr<proto::MPCService::Stub> mStub;
   RealTimeControlBuffer mBuffer;
   std::thread mUpdateListenerThread;
+  s_t mPlanQuantization;
+  int mControllerId;
+
+  /// This is only set in shared memory mode
+  std::shared_ptr<SharedMemoryPlanRing> mPlanRing;
+  int mDofs;
+  int mSteps;
+  int mMassDim;
 
   // These are listeners that get called when we finish replanning
   std::vector<
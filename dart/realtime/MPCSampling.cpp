@@ -0,0 +1,458 @@
+#include "dart/realtime/MPCSampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/neural/WorldBatch.hpp"
+#include "dart/realtime/Millis.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/LossFn.hpp"
+#include "dart/trajectory/Optimizer.hpp"
+#include "dart/trajectory/SingleShot.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+
+#include "signal.h"
+
+namespace dart {
+
+using namespace trajectory;
+
+namespace realtime {
+
+MPCSampling::MPCSampling(
+    std::shared_ptr<simulation::World> world,
+    std::shared_ptr<trajectory::LossFn> loss,
+    int planningHorizonMillis)
+  : mRunning(false),
+    mWorld(world),
+    mLoss(loss),
+    mObservationLog(
+        timeSinceEpochMillis(),
+        world->getPositions(),
+        world->getVelocities(),
+        world->getMasses()),
+    mPlanningHorizonMillis(planningHorizonMillis),
+    mMillisPerStep(1000 * world->getTimeStep()),
+    mSteps((int)ceil((s_t)planningHorizonMillis / mMillisPerStep)),
+    mLastOptimizedTime(0L),
+    mBuffer(RealTimeControlBuffer(world->getNumDofs(), mSteps, mMillisPerStep)),
+    mSilent(false),
+    mNumSamples(128),
+    mNumIterations(1),
+    mNoiseStdDev(Eigen::VectorXs::Ones(world->getNumDofs())),
+    mSamplingMethod(SamplingMethod::MPPI),
+    mTemperature(1.0),
+    mEliteFraction(0.1),
+    mRandom(std::random_device{}()),
+    mPlan(Eigen::MatrixXs::Zero(world->getNumDofs(), mSteps)),
+    mEstimateWorld(world->clone())
+{
+}
+
+MPCSampling::~MPCSampling()
+{
+  stop();
+}
+
+/// This updates the loss function that we're going to move in real time to
+/// minimize
+void MPCSampling::setLoss(std::shared_ptr<trajectory::LossFn> loss)
+{
+  mLoss = loss;
+  // The refinement problem holds its own copy of the loss
+  mRefinementProblem = nullptr;
+}
+
+/// This sets how many perturbed plans get rolled out each iteration. The first
+/// one is always the unperturbed plan. Defaults to 128. This should be called
+/// before start().
+void MPCSampling::setNumSamples(int numSamples)
+{
+  mNumSamples = std::max(numSamples, 1);
+}
+
+/// This returns how many perturbed plans get rolled out each iteration
+int MPCSampling::getNumSamples()
+{
+  return mNumSamples;
+}
+
+/// This sets how many rounds of sampling happen each replanning cycle.
+/// Defaults to 1, which is usual for MPPI. CEM usually wants a few.
+void MPCSampling::setNumIterations(int numIterations)
+{
+  mNumIterations = std::max(numIterations, 1);
+}
+
+/// This sets the standard deviation of the Gaussian noise added to each
+/// control force, one entry per DOF. Defaults to 1.0 for every DOF.
+void MPCSampling::setNoiseStdDev(Eigen::VectorXs stdDev)
+{
+  assert(stdDev.size() == mWorld->getNumDofs());
+  mNoiseStdDev = stdDev;
+}
+
+/// This sets which sampling update we use. Defaults to MPPI.
+void MPCSampling::setSamplingMethod(SamplingMethod method)
+{
+  mSamplingMethod = method;
+}
+
+/// This sets the MPPI temperature. Lower values trust the best samples more.
+/// Defaults to 1.0.
+void MPCSampling::setTemperature(s_t temperature)
+{
+  mTemperature = temperature;
+}
+
+/// This sets the fraction of samples that count as elite for CEM. Defaults to
+/// 0.1.
+void MPCSampling::setEliteFraction(s_t fraction)
+{
+  mEliteFraction = fraction;
+}
+
+/// This seeds the random noise, so runs can be reproduced
+void MPCSampling::setSeed(unsigned int seed)
+{
+  mRandom.seed(seed);
+}
+
+/// This sets an optimizer to polish the sampled plan at the end of each cycle.
+/// Pass nullptr (the default) to skip refinement.
+void MPCSampling::setRefinementOptimizer(
+    std::shared_ptr<trajectory::Optimizer> optimizer)
+{
+  mRefinementOptimizer = optimizer;
+}
+
+/// This can completely silence log output
+void MPCSampling::setSilent(bool silent)
+{
+  mSilent = silent;
+}
+
+/// This returns the current plan, one column per timestep
+const Eigen::MatrixXs& MPCSampling::getPlan()
+{
+  return mPlan;
+}
+
+/// This gets the force to apply to the world at this instant. If we haven't
+/// computed anything for this instant yet, this just returns 0s.
+Eigen::VectorXs MPCSampling::getControlForce(long now)
+{
+  return mBuffer.getPlannedForce(now);
+}
+
+/// This returns how many millis we have left until we've run out of plan.
+/// This can be a negative number, if we've run past our plan.
+long MPCSampling::getRemainingPlanBufferMillis()
+{
+  return mBuffer.getPlanBufferMillisAfter(timeSinceEpochMillis());
+}
+
+/// This records the current state of the world based on some external sensing
+/// and inference. This resets the error in our model just assuming the world
+/// is exactly following our simulation.
+void MPCSampling::recordGroundTruthState(
+    long time, Eigen::VectorXs pos, Eigen::VectorXs vel, Eigen::VectorXs mass)
+{
+  mObservationLog.observe(time, pos, vel, mass);
+}
+
+/// This runs one replanning cycle for the plan starting at `startTime`, and
+/// hands the result to the control buffer
+void MPCSampling::optimizePlan(long startTime)
+{
+  // Like MPCLocal, we never let time go backwards
+  if (startTime < mLastOptimizedTime)
+  {
+    startTime = mLastOptimizedTime;
+  }
+
+  // Shift the last plan forward to start at the new time, holding the last
+  // force to fill in the end
+  long roundedStartTime = startTime;
+  if (mLastOptimizedTime != 0L)
+  {
+    int steps = static_cast<int>(
+        floor(static_cast<s_t>(startTime - mLastOptimizedTime) / mMillisPerStep));
+    roundedStartTime = mLastOptimizedTime + steps * mMillisPerStep;
+    if (steps >= mSteps)
+    {
+      mPlan.colwise() = mPlan.col(mSteps - 1).eval();
+    }
+    else if (steps > 0)
+    {
+      mPlan.leftCols(mSteps - steps)
+          = mPlan.rightCols(mSteps - steps).eval();
+      mPlan.rightCols(steps).colwise() = mPlan.col(mSteps - steps - 1).eval();
+    }
+  }
+
+  long startComputeWallTime = timeSinceEpochMillis();
+
+  mBuffer.estimateWorldStateAt(
+      mEstimateWorld, &mObservationLog, roundedStartTime);
+  const Eigen::VectorXs startPos = mEstimateWorld->getPositions();
+  const Eigen::VectorXs startVel = mEstimateWorld->getVelocities();
+
+  ensureSamplesAllocated();
+
+  const Eigen::VectorXs upperLimits = mWorld->getControlForceUpperLimits();
+  const Eigen::VectorXs lowerLimits = mWorld->getControlForceLowerLimits();
+  const int numElites = std::max(
+      1,
+      std::min(
+          mNumSamples,
+          static_cast<int>(std::round(mEliteFraction * mNumSamples))));
+  Eigen::VectorXs stdDev = mNoiseStdDev;
+  std::normal_distribution<double> normal(0.0, 1.0);
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+
+  for (int iteration = 0; iteration < mNumIterations; iteration++)
+  {
+    // The noise is drawn here, rather than in the rollouts, so a given seed
+    // always gives the same plans no matter how the rollouts get scheduled.
+    // Sample 0 is always the unperturbed plan, so a good plan doesn't get
+    // washed out by noise.
+    for (int i = 0; i < mNumSamples; i++)
+    {
+      Eigen::Ref<Eigen::MatrixXs> forces = mRollouts[i]->getControlForces();
+      forces = mPlan;
+      if (i == 0)
+        continue;
+      for (int t = 0; t < mSteps; t++)
+      {
+        for (int d = 0; d < forces.rows(); d++)
+        {
+          forces(d, t) = std::min(
+              upperLimits(d),
+              std::max(
+                  lowerLimits(d),
+                  forces(d, t) + stdDev(d) * (s_t)normal(mRandom)));
+        }
+      }
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(mNumSamples);
+    for (int i = 0; i < mNumSamples; i++)
+    {
+      futures.push_back(pool.submit([this, i, &startPos, &startVel]() {
+        rollout(
+            mSampleWorlds->getWorld(i).get(),
+            startPos,
+            startVel,
+            mRollouts[i].get());
+      }));
+    }
+    pool.waitAll(futures);
+
+    s_t bestLoss = std::numeric_limits<s_t>::infinity();
+    for (int i = 0; i < mNumSamples; i++)
+    {
+      mSampleLosses(i) = mLoss->getLoss(mRollouts[i].get());
+      if (!std::isfinite((double)mSampleLosses(i)))
+        mSampleLosses(i) = std::numeric_limits<s_t>::infinity();
+      bestLoss = std::min(bestLoss, mSampleLosses(i));
+    }
+    if (!std::isfinite((double)bestLoss))
+    {
+      // Every rollout blew up, so there's nothing to learn from this batch
+      continue;
+    }
+
+    if (mSamplingMethod == SamplingMethod::MPPI)
+    {
+      Eigen::MatrixXs weightedSum = Eigen::MatrixXs::Zero(mPlan.rows(), mSteps);
+      s_t totalWeight = 0.0;
+      for (int i = 0; i < mNumSamples; i++)
+      {
+        s_t weight = exp(-(mSampleLosses(i) - bestLoss) / mTemperature);
+        weightedSum += weight * mRollouts[i]->getControlForcesConst();
+        totalWeight += weight;
+      }
+      mPlan = weightedSum / totalWeight;
+    }
+    else
+    {
+      std::vector<int> order(mNumSamples);
+      for (int i = 0; i < mNumSamples; i++)
+        order[i] = i;
+      std::partial_sort(
+          order.begin(),
+          order.begin() + numElites,
+          order.end(),
+          [this](int a, int b) { return mSampleLosses(a) < mSampleLosses(b); });
+
+      mPlan.setZero();
+      for (int e = 0; e < numElites; e++)
+        mPlan += mRollouts[order[e]]->getControlForcesConst();
+      mPlan /= numElites;
+
+      // Refit the noise for the next iteration to the spread of the elites
+      Eigen::VectorXs variance = Eigen::VectorXs::Zero(mPlan.rows());
+      for (int e = 0; e < numElites; e++)
+      {
+        variance += (mRollouts[order[e]]->getControlForcesConst() - mPlan)
+                        .rowwise()
+                        .squaredNorm();
+      }
+      stdDev = (variance / (numElites * mSteps)).cwiseSqrt();
+    }
+  }
+
+  if (mRefinementOptimizer)
+  {
+    if (!mRefinementProblem)
+    {
+      mRefinementProblem = std::make_shared<SingleShot>(
+          mWorld->clone(), *mLoss.get(), mSteps, false);
+    }
+    mRefinementProblem->setStartPos(startPos);
+    mRefinementProblem->setStartVel(startVel);
+    mRefinementProblem->setControlForcesRaw(mPlan);
+    mRefinementOptimizer->optimize(mRefinementProblem.get());
+    mPlan = mRefinementProblem->getRolloutCache(mEstimateWorld)
+                ->getControlForcesConst();
+  }
+
+  mBuffer.setControlForcePlan(roundedStartTime, timeSinceEpochMillis(), mPlan);
+  mLastOptimizedTime = roundedStartTime;
+
+  long computeDurationWallTime = timeSinceEpochMillis() - startComputeWallTime;
+
+  if (mReplannedListeners.size() > 0)
+  {
+    mPlanRollout->getControlForces() = mPlan;
+    rollout(mEstimateWorld.get(), startPos, startVel, mPlanRollout.get());
+    for (auto listener : mReplannedListeners)
+    {
+      listener(startTime, mPlanRollout.get(), computeDurationWallTime);
+    }
+  }
+
+  if (!mSilent)
+  {
+    std::cout << "MPCSampling rolled out " << mNumSamples * mNumIterations
+              << " plans of " << mSteps << " steps in "
+              << computeDurationWallTime << "ms" << std::endl;
+  }
+}
+
+/// This starts our main thread and begins running optimizations
+void MPCSampling::start()
+{
+  if (mRunning)
+    return;
+  mRunning = true;
+  mOptimizationThread
+      = std::thread(&MPCSampling::optimizationThreadLoop, this);
+}
+
+/// This stops our main thread, waits for it to finish, and then returns
+void MPCSampling::stop()
+{
+  if (!mRunning)
+    return;
+  mRunning = false;
+  mOptimizationThread.join();
+}
+
+/// This registers a listener to get called when we finish replanning
+void MPCSampling::registerReplanningListener(
+    std::function<void(long, const trajectory::TrajectoryRollout*, long)>
+        replanListener)
+{
+  mReplannedListeners.push_back(replanListener);
+}
+
+/// This is the function for the optimization thread to run when we're live
+void MPCSampling::optimizationThreadLoop()
+{
+  // block signals in this thread and subsequently
+  // spawned threads, so they're guaranteed to go to the server thread
+  sigset_t sigset;
+  sigemptyset(&sigset);
+  sigaddset(&sigset, SIGINT);
+  sigaddset(&sigset, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
+
+  long millisInAdvanceToPlan = 0;
+  while (mRunning)
+  {
+    long startTime = timeSinceEpochMillis();
+    optimizePlan(startTime + millisInAdvanceToPlan);
+    long endTime = timeSinceEpochMillis();
+    // Plan far enough ahead that the plan doesn't start in the past by the
+    // time we publish it, but not so far that errors build up. See
+    // MPCLocal::adjustPerformance().
+    millisInAdvanceToPlan = std::min(200L, (long)(1.2 * (endTime - startTime)));
+  }
+}
+
+/// This (re)creates the world clones and rollout buffers, if the number of
+/// samples has changed since the last cycle
+void MPCSampling::ensureSamplesAllocated()
+{
+  if (mSampleWorlds && mSampleWorlds->getNumWorlds() == mNumSamples)
+    return;
+
+  mSampleWorlds = std::make_unique<neural::WorldBatch>(mWorld, mNumSamples);
+
+  const int dofs = mWorld->getNumDofs();
+  auto makeRollout = [&]() {
+    std::unordered_map<std::string, Eigen::MatrixXs> pos;
+    std::unordered_map<std::string, Eigen::MatrixXs> vel;
+    std::unordered_map<std::string, Eigen::MatrixXs> force;
+    pos["identity"] = Eigen::MatrixXs::Zero(dofs, mSteps);
+    vel["identity"] = Eigen::MatrixXs::Zero(dofs, mSteps);
+    force["identity"] = Eigen::MatrixXs::Zero(dofs, mSteps);
+    return std::make_unique<TrajectoryRolloutReal>(
+        pos,
+        vel,
+        force,
+        mWorld->getMasses(),
+        std::unordered_map<std::string, Eigen::MatrixXs>());
+  };
+  mRollouts.clear();
+  for (int i = 0; i < mNumSamples; i++)
+  {
+    mRollouts.push_back(makeRollout());
+  }
+  mPlanRollout = makeRollout();
+  mSampleLosses = Eigen::VectorXs::Zero(mNumSamples);
+}
+
+/// This rolls out the forces already in `result` on `world`, starting from
+/// `startPos` and `startVel`, filling in the poses and velocities
+void MPCSampling::rollout(
+    simulation::World* world,
+    const Eigen::VectorXs& startPos,
+    const Eigen::VectorXs& startVel,
+    trajectory::TrajectoryRolloutReal* result)
+{
+  world->setPositions(startPos);
+  world->setVelocities(startVel);
+  Eigen::Ref<Eigen::MatrixXs> poses = result->getPoses();
+  Eigen::Ref<Eigen::MatrixXs> vels = result->getVels();
+  const Eigen::Ref<const Eigen::MatrixXs> forces
+      = result->getControlForcesConst();
+  for (int t = 0; t < mSteps; t++)
+  {
+    world->setControlForces(forces.col(t));
+    world->step();
+    poses.col(t) = world->getPositions();
+    vels.col(t) = world->getVelocities();
+  }
+}
+
+} // namespace realtime
+} // namespace dart
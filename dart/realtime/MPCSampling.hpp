@@ -0,0 +1,216 @@
+#ifndef DART_REALTIME_MPCSampling
+#define DART_REALTIME_MPCSampling
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/realtime/MPC.hpp"
+#include "dart/realtime/ObservationLog.hpp"
+#include "dart/realtime/RealTimeControlBuffer.hpp"
+
+namespace dart {
+namespace simulation {
+class World;
+}
+
+namespace neural {
+class WorldBatch;
+}
+
+namespace trajectory {
+class LossFn;
+class Optimizer;
+class Problem;
+class TrajectoryRollout;
+class TrajectoryRolloutReal;
+} // namespace trajectory
+
+namespace realtime {
+
+/// This is a sampling-based alternative to MPCLocal. Rather than running a
+/// gradient-based optimizer on a single Problem, each replanning cycle rolls
+/// out a fixed number of randomly perturbed copies of the current plan, each
+/// on its own clone of the world, in parallel on the global ThreadPool. The
+/// plan is then moved towards the samples with the lowest loss, either by
+/// MPPI (an exponentially weighted average of every sample) or by CEM (an
+/// average of the best few samples, with the noise refit to their spread).
+///
+/// The work per cycle is always the same number of fixed-length rollouts, so
+/// replanning time is predictable and scales with the number of cores, and it
+/// doesn't need gradients through contact, which makes it a good fit for
+/// contact-rich tasks. A gradient-based optimizer can optionally polish the
+/// sampled plan with a few iterations at the end of each cycle.
+///
+/// Losses are evaluated on the planning thread, so the LossFn doesn't need to
+/// be thread-safe.
+class MPCSampling final : public MPC
+{
+  friend class MPCHost;
+
+public:
+  enum class SamplingMethod
+  {
+    /// Model Predictive Path Integral control: every sample is weighted by
+    /// exp(-(loss - bestLoss) / temperature)
+    MPPI,
+    /// Cross Entropy Method: the plan becomes the average of the elite
+    /// samples, and the noise for the next iteration is refit to them
+    CEM
+  };
+
+  MPCSampling(
+      std::shared_ptr<simulation::World> world,
+      std::shared_ptr<trajectory::LossFn> loss,
+      int planningHorizonMillis);
+
+  ~MPCSampling();
+
+  /// This updates the loss function that we're going to move in real time to
+  /// minimize
+  void setLoss(std::shared_ptr<trajectory::LossFn> loss);
+
+  /// This sets how many perturbed plans get rolled out each iteration. The
+  /// first one is always the unperturbed plan. Defaults to 128. This should be
+  /// called before start().
+  void setNumSamples(int numSamples);
+
+  /// This returns how many perturbed plans get rolled out each iteration
+  int getNumSamples();
+
+  /// This sets how many rounds of sampling happen each replanning cycle.
+  /// Defaults to 1, which is usual for MPPI. CEM usually wants a few.
+  void setNumIterations(int numIterations);
+
+  /// This sets the standard deviation of the Gaussian noise added to each
+  /// control force, one entry per DOF. Defaults to 1.0 for every DOF.
+  void setNoiseStdDev(Eigen::VectorXs stdDev);
+
+  /// This sets which sampling update we use. Defaults to MPPI.
+  void setSamplingMethod(SamplingMethod method);
+
+  /// This sets the MPPI temperature. Lower values trust the best samples more.
+  /// Defaults to 1.0.
+  void setTemperature(s_t temperature);
+
+  /// This sets the fraction of samples that count as elite for CEM. Defaults
+  /// to 0.1.
+  void setEliteFraction(s_t fraction);
+
+  /// This seeds the random noise, so runs can be reproduced
+  void setSeed(unsigned int seed);
+
+  /// This sets an optimizer to polish the sampled plan at the end of each
+  /// cycle. This should be a cheap one (say, an SGDOptimizer with an iteration
+  /// limit of a few steps), since it runs inside the replanning budget. Pass
+  /// nullptr (the default) to skip refinement.
+  void setRefinementOptimizer(std::shared_ptr<trajectory::Optimizer> optimizer);
+
+  /// This can completely silence log output
+  void setSilent(bool silent);
+
+  /// This returns the current plan, one column per timestep
+  const Eigen::MatrixXs& getPlan();
+
+  /// This gets the force to apply to the world at this instant. If we haven't
+  /// computed anything for this instant yet, this just returns 0s.
+  Eigen::VectorXs getControlForce(long now) override;
+
+  /// This returns how many millis we have left until we've run out of plan.
+  /// This can be a negative number, if we've run past our plan.
+  long getRemainingPlanBufferMillis() override;
+
+  /// This records the current state of the world based on some external sensing
+  /// and inference. This resets the error in our model just assuming the world
+  /// is exactly following our simulation.
+  void recordGroundTruthState(
+      long time,
+      Eigen::VectorXs pos,
+      Eigen::VectorXs vel,
+      Eigen::VectorXs mass) override;
+
+  /// This runs one replanning cycle for the plan starting at `startTime`, and
+  /// hands the result to the control buffer
+  void optimizePlan(long startTime);
+
+  /// This starts our main thread and begins running optimizations
+  void start() override;
+
+  /// This stops our main thread, waits for it to finish, and then returns
+  void stop() override;
+
+  /// This registers a listener to get called when we finish replanning
+  void registerReplanningListener(
+      std::function<void(long, const trajectory::TrajectoryRollout*, long)>
+          replanListener) override;
+
+protected:
+  /// This is the function for the optimization thread to run when we're live
+  void optimizationThreadLoop();
+
+  /// This (re)creates the world clones and rollout buffers, if the number of
+  /// samples has changed since the last cycle
+  void ensureSamplesAllocated();
+
+  /// This rolls out the forces already in `result` on `world`, starting from
+  /// `startPos` and `startVel`, filling in the poses and velocities
+  void rollout(
+      simulation::World* world,
+      const Eigen::VectorXs& startPos,
+      const Eigen::VectorXs& startVel,
+      trajectory::TrajectoryRolloutReal* result);
+
+  bool mRunning;
+  std::shared_ptr<simulation::World> mWorld;
+  std::shared_ptr<trajectory::LossFn> mLoss;
+  ObservationLog mObservationLog;
+
+  int mPlanningHorizonMillis;
+  int mMillisPerStep;
+  int mSteps;
+  long mLastOptimizedTime;
+  RealTimeControlBuffer mBuffer;
+  std::thread mOptimizationThread;
+  bool mSilent;
+
+  // Sampling settings
+  int mNumSamples;
+  int mNumIterations;
+  Eigen::VectorXs mNoiseStdDev;
+  SamplingMethod mSamplingMethod;
+  s_t mTemperature;
+  s_t mEliteFraction;
+  std::mt19937 mRandom;
+  std::shared_ptr<trajectory::Optimizer> mRefinementOptimizer;
+
+  /// The current plan, one column per timestep
+  Eigen::MatrixXs mPlan;
+
+  /// The world we estimate the current state on, and roll the final plan out
+  /// on for listeners
+  std::shared_ptr<simulation::World> mEstimateWorld;
+
+  /// One world clone per sample, and the buffers each sample gets rolled out
+  /// into. These are reused from cycle to cycle.
+  std::unique_ptr<neural::WorldBatch> mSampleWorlds;
+  std::vector<std::unique_ptr<trajectory::TrajectoryRolloutReal>> mRollouts;
+  std::unique_ptr<trajectory::TrajectoryRolloutReal> mPlanRollout;
+  Eigen::VectorXs mSampleLosses;
+
+  /// The problem the refinement optimizer works on, if there is one
+  std::shared_ptr<trajectory::Problem> mRefinementProblem;
+
+  // These are listeners that get called when we finish replanning
+  std::vector<
+      std::function<void(long, const trajectory::TrajectoryRollout*, long)>>
+      mReplannedListeners;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
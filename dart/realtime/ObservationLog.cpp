@@ -1,5 +1,6 @@
 #include "dart/realtime/ObservationLog.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include "dart/math/MathTypes.hpp"
@@ -17,9 +18,14 @@ ObservationLog::ObservationLog(
     Eigen::VectorXs initialPos,
     Eigen::VectorXs initialVel,
     Eigen::VectorXs initialMass)
-  : mDofs(initialPos.size()), mMassDim(initialMass.size()), mMass(initialMass)
+  : mDofs(initialPos.size()),
+    mMassDim(initialMass.size()),
+    mPoses(initialPos.size()),
+    mVels(initialVel.size()),
+    mMass(initialMass)
 {
-  mObservations.emplace_back(startTime, initialPos, initialVel);
+  mPoses.push(startTime, initialPos);
+  mVels.push(startTime, initialVel);
 }
 
 void ObservationLog::observe(
@@ -29,20 +35,37 @@ void ObservationLog::observe(
     // TODO(keenon): Support mass observations
     Eigen::VectorXs /* mass */)
 {
-  mObservations.emplace_back(time, pos, vel);
+  mPoses.push(time, pos);
+  mVels.push(time, vel);
 }
 
 Observation ObservationLog::getClosestObservationBefore(long time)
 {
-  for (int i = mObservations.size() - 1; i >= 0; i--)
+  Eigen::VectorXs pos = Eigen::VectorXs::Zero(mDofs);
+  Eigen::VectorXs vel = Eigen::VectorXs::Zero(mVels.rows());
+  long obsTime = getClosestObservationBefore(time, pos, vel);
+  return Observation(obsTime, pos, vel);
+}
+
+/// This is an allocation-free version of getClosestObservationBefore(). It
+/// copies the closest observation at or before `time` into `pos` and `vel`
+/// (which must already be the right size), and returns its timestamp.
+long ObservationLog::getClosestObservationBefore(
+    long time,
+    Eigen::Ref<Eigen::VectorXs> pos,
+    Eigen::Ref<Eigen::VectorXs> vel)
+{
+  int index = mPoses.countAtOrBefore(time) - 1;
+  if (index < 0)
   {
-    if (mObservations[i].time <= time)
-      return mObservations[i];
+    std::cout << "WARNING: Asked for an observation before our initialization. "
+                 "Returning our initialization"
+              << std::endl;
+    index = 0;
   }
-  std::cout << "WARNING: Asked for an observation before our initialization. "
-               "Returning our initialization"
-            << std::endl;
-  return mObservations[0];
+  pos = mPoses.col(index);
+  vel = mVels.col(index);
+  return mPoses.time(index);
 }
 
 Eigen::VectorXs ObservationLog::getMass()
@@ -52,25 +75,12 @@ Eigen::VectorXs ObservationLog::getMass()
 
 void ObservationLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
-    return;
-
-  std::vector<Observation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
-  {
-    newObservations.push_back(mObservations[i]);
-  }
-  mObservations = newObservations;
+  // Always hang on to the newest observation, so there's still something to
+  // estimate the current state from
+  int discard = std::min(mPoses.countBefore(time), mPoses.size() - 1);
+  mPoses.popFront(discard);
+  mVels.popFront(discard);
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
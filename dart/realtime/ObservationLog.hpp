@@ -6,6 +6,8 @@
 #include <Eigen/Dense>
 
 #include "dart/math/MathTypes.hpp"
+#include "dart/realtime/ColumnRing.hpp"
+
 namespace dart {
 namespace realtime {
 
@@ -35,14 +37,25 @@ public:
 
   Observation getClosestObservationBefore(long time);
 
+  /// This is an allocation-free version of getClosestObservationBefore(). It
+  /// copies the closest observation at or before `time` into `pos` and `vel`
+  /// (which must already be the right size), and returns its timestamp.
+  long getClosestObservationBefore(
+      long time,
+      Eigen::Ref<Eigen::VectorXs> pos,
+      Eigen::Ref<Eigen::VectorXs> vel);
+
   Eigen::VectorXs getMass();
 
+  /// This drops every observation before `time`, except that it always keeps
+  /// the newest one
   void discardBefore(long time);
 
 protected:
   int mDofs;
   int mMassDim;
-  std::vector<Observation> mObservations;
+  ColumnRing mPoses;
+  ColumnRing mVels;
   Eigen::VectorXs mMass;
 };
 
@@ -1,5 +1,6 @@
 #include "dart/realtime/RealTimeControlBuffer.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include "dart/simulation/World.hpp"
@@ -7,61 +8,88 @@
 namespace dart {
 namespace realtime {
 
+// This is how many applied forces we can queue up between calls to
+// estimateWorldStateAt(). At 1kHz this is just over 2 seconds.
+static const int APPLIED_FORCE_QUEUE_LENGTH = 2048;
+
+RealTimeControlBuffer::PlanFrame::PlanFrame(int forceDim, int steps)
+  : forces(Eigen::MatrixXs::Zero(forceDim, steps)), startedAt(0L), sequence(0)
+{
+}
+
+RealTimeControlBuffer::PlanFrame::PlanFrame(const PlanFrame& other)
+  : forces(other.forces),
+    startedAt(other.startedAt),
+    sequence(other.sequence.load())
+{
+}
+
 RealTimeControlBuffer::RealTimeControlBuffer(
     int forceDim, int steps, int millisPerStep)
   : mForceDim(forceDim),
     mNumSteps(steps),
     mMillisPerStep(millisPerStep),
     mActiveBuffer(UNINITIALIZED),
-    mBufA(Eigen::MatrixXs::Zero(forceDim, steps)),
-    mBufB(Eigen::MatrixXs::Zero(forceDim, steps)),
-    mControlLog(ControlLog(forceDim, millisPerStep))
+    mBufA(forceDim, steps),
+    mBufB(forceDim, steps),
+    mAppliedForces(
+        Eigen::MatrixXs::Zero(forceDim, APPLIED_FORCE_QUEUE_LENGTH)),
+    mAppliedForceTimes(APPLIED_FORCE_QUEUE_LENGTH, 0L),
+    mAppliedForcesWritten(0),
+    mAppliedForcesRead(0),
+    mControlLog(ControlLog(forceDim, millisPerStep)),
+    mStateCacheEnabled(false),
+    mCachedSteps(0),
+    mCachedObservationTime(0L)
+{
+}
+
+/// Copy constructor. This is not safe to call while other threads are using
+/// `other`.
+RealTimeControlBuffer::RealTimeControlBuffer(
+    const RealTimeControlBuffer& other)
+  : mForceDim(other.mForceDim),
+    mNumSteps(other.mNumSteps),
+    mMillisPerStep(other.mMillisPerStep),
+    mActiveBuffer(other.mActiveBuffer.load()),
+    mBufA(other.mBufA),
+    mBufB(other.mBufB),
+    mAppliedForces(other.mAppliedForces),
+    mAppliedForceTimes(other.mAppliedForceTimes),
+    mAppliedForcesWritten(other.mAppliedForcesWritten.load()),
+    mAppliedForcesRead(other.mAppliedForcesRead.load()),
+    mControlLog(other.mControlLog),
+    mStateCacheEnabled(other.mStateCacheEnabled),
+    mCachedSteps(other.mCachedSteps),
+    mCachedObservationTime(other.mCachedObservationTime),
+    mCachedObservationPos(other.mCachedObservationPos),
+    mCachedObservationVel(other.mCachedObservationVel),
+    mCachedMass(other.mCachedMass),
+    mCachedPos(other.mCachedPos),
+    mCachedVel(other.mCachedVel)
 {
 }
 
 /// Gets the force at a given timestep
 Eigen::VectorXs RealTimeControlBuffer::getPlannedForce(long time, bool dontLog)
 {
-  if (mActiveBuffer == UNINITIALIZED)
-  {
-    // Unitialized, default to no force
-    return Eigen::VectorXs::Zero(mForceDim);
-  }
-  int elapsed = time - mLastWroteBufferAt;
-  if (elapsed < 0)
-  {
-    // Asking for some time in the past, default to no force
-    return Eigen::VectorXs::Zero(mForceDim);
-  }
+  Eigen::VectorXs force = Eigen::VectorXs::Zero(mForceDim);
+  getPlannedForceInPlace(time, force, dontLog);
+  return force;
+}
 
-  int step = (int)floor((s_t)elapsed / mMillisPerStep);
-  if (step < mNumSteps)
-  {
-    if (mActiveBuffer == BUF_A)
-    {
-      if (!dontLog)
-        mControlLog.record(time, mBufA.col(step));
-      return mBufA.col(step);
-    }
-    else if (mActiveBuffer == BUF_B)
-    {
-      if (!dontLog)
-        mControlLog.record(time, mBufB.col(step));
-      return mBufB.col(step);
-    }
-    else
-      assert(false && "Should never reach this point");
-  }
-  else
+/// This is the same as getPlannedForce(), but writes into `forceOut` instead
+/// of returning a new vector. This never blocks or allocates, so it's safe to
+/// call from a hard real-time control loop.
+void RealTimeControlBuffer::getPlannedForceInPlace(
+    long time, Eigen::Ref<Eigen::VectorXs> forceOut, bool dontLog)
+{
+  // If there's no plan covering this time yet, we default to no force, and
+  // don't log anything
+  if (readPlannedForce(time, forceOut) && !dontLog)
   {
-    // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
-    Eigen::VectorXs oob = Eigen::VectorXs::Zero(mForceDim);
-    if (!dontLog)
-      mControlLog.record(time, oob);
-    return oob;
+    recordAppliedForce(time, forceOut);
   }
-  // The code should never reach here, but it's here to keep the compiler happy
-  throw std::runtime_error{"Execution should never reach this point"};
 }
 
 /// This gets planned forces starting at `start`, and continuing for the
@@ -71,50 +99,60 @@ Eigen::VectorXs RealTimeControlBuffer::getPlannedForce(long time, bool dontLog)
 void RealTimeControlBuffer::getPlannedForcesStartingAt(
     long start, Eigen::Ref<Eigen::MatrixXs> forcesOut)
 {
-  if (mActiveBuffer == UNINITIALIZED)
-  {
-    // Unitialized, default to 0
-    forcesOut.setZero();
-    return;
-  }
-  int elapsed = start - mLastWroteBufferAt;
-  if (elapsed < 0)
+  while (true)
   {
-    // Asking for some time in the past, default to 0
-    forcesOut.setZero();
-    return;
-  }
-  int startStep = (int)floor((s_t)elapsed / mMillisPerStep);
-  if (startStep < mNumSteps)
-  {
-    // Copy the appropriate block of our active buffer to the forcesOut block
-    if (mActiveBuffer == BUF_A)
+    BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_acquire);
+    if (active == UNINITIALIZED)
     {
-      forcesOut.block(0, 0, mForceDim, mNumSteps - startStep)
-          = mBufA.block(0, startStep, mForceDim, mNumSteps - startStep);
+      // Unitialized, default to 0
+      forcesOut.setZero();
+      return;
     }
-    else if (mActiveBuffer == BUF_B)
+    PlanFrame& frame = getFrame(active);
+    unsigned int sequence = frame.sequence.load(std::memory_order_acquire);
+    if (sequence % 2 == 1)
     {
-      forcesOut.block(0, 0, mForceDim, mNumSteps - startStep)
-          = mBufB.block(0, startStep, mForceDim, mNumSteps - startStep);
+      continue;
+    }
+
+    int elapsed = start - frame.startedAt;
+    int startStep = (int)floor((s_t)elapsed / mMillisPerStep);
+    if (elapsed < 0 || startStep >= mNumSteps)
+    {
+      // Asking for some time in the past, or past the end of our plan (MPC
+      // isn't keeping up!), default to 0
+      forcesOut.setZero();
     }
     else
-      assert(false && "Should never reach this point");
-    // Zero out the remainder of the forcesOut block
-    forcesOut.block(0, mNumSteps - startStep, mForceDim, startStep).setZero();
-  }
-  else
-  {
-    // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
-    forcesOut.setZero();
+    {
+      // Copy the appropriate block of our active buffer to the forcesOut block
+      forcesOut.block(0, 0, mForceDim, mNumSteps - startStep)
+          = frame.forces.block(0, startStep, mForceDim, mNumSteps - startStep);
+      // Zero out the remainder of the forcesOut block
+      forcesOut.block(0, mNumSteps - startStep, mForceDim, startStep)
+          .setZero();
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (frame.sequence.load(std::memory_order_relaxed) == sequence)
+    {
+      return;
+    }
   }
 }
 
 /// This swaps in a new buffer of forces. The assumption is that "startAt" is
 /// before "now", because we'll erase old data in this process.
 void RealTimeControlBuffer::setControlForcePlan(
-    long startAt, long now, Eigen::MatrixXs forces)
+    long startAt, long now, const Eigen::MatrixXs& forces)
 {
+  // We're the only thread that ever changes which buffer is active, so we
+  // don't need to worry about this changing under us
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_relaxed);
+  BufferSwitchEnum target = (active == BUF_A) ? BUF_B : BUF_A;
+  PlanFrame& next = getFrame(target);
+  int planSteps = std::min((int)forces.cols(), mNumSteps);
+
   if (startAt > now)
   {
     long padMillis = startAt - now;
@@ -125,79 +163,65 @@ void RealTimeControlBuffer::setControlForcePlan(
     {
       return;
     }
+
+    beginWrite(next);
+    next.startedAt = now;
+
     // Otherwise, we're going to copy part of the existing plan
-    int currentStep
-        = (int)floor((s_t)(now - mLastWroteBufferAt) / mMillisPerStep);
-    int remainingSteps = mNumSteps - currentStep;
-    mLastWroteBufferAt = now;
+    int remainingSteps = 0;
+    if (active != UNINITIALIZED)
+    {
+      int currentStep = (int)floor(
+          (s_t)(now - getFrame(active).startedAt) / mMillisPerStep);
+      remainingSteps = mNumSteps - currentStep;
+    }
 
     // If we've overflowed our old buffer, this is bad, but recoverable. We'll
     // just not copy anything from our old plan, since it's all in the past now
     // anyways.
-    if (remainingSteps < 0)
+    if (active != UNINITIALIZED && remainingSteps < 0)
     {
-      mBufA = forces;
-      mActiveBuffer = BUF_A;
+      next.forces.leftCols(planSteps) = forces.leftCols(planSteps);
+      next.forces.rightCols(mNumSteps - planSteps).setZero();
+      endWrite(next, target);
       return;
     }
 
     int copySteps = padSteps;
     int zeroSteps = 0;
     int useSteps = mNumSteps - padSteps;
-    if (padSteps > remainingSteps)
+    if (active == UNINITIALIZED)
+    {
+      copySteps = 0;
+      zeroSteps = padSteps;
+    }
+    else if (padSteps > remainingSteps)
     {
       copySteps = remainingSteps;
       zeroSteps = padSteps - remainingSteps;
-      useSteps = mNumSteps - padSteps;
     }
     assert(copySteps + zeroSteps + useSteps == mNumSteps);
 
-    if (mActiveBuffer == UNINITIALIZED)
-    {
-      mBufA.block(0, 0, mForceDim, copySteps).setZero();
-      mBufA.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufA.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_A;
-    }
-    else if (mActiveBuffer == BUF_B)
+    if (copySteps > 0)
     {
-      mBufA.block(0, 0, mForceDim, copySteps)
-          = mBufB.block(0, mNumSteps - copySteps, mForceDim, copySteps);
-      mBufA.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufA.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_A;
-    }
-    else if (mActiveBuffer == BUF_A)
-    {
-      mBufB.block(0, 0, mForceDim, copySteps)
-          = mBufA.block(0, mNumSteps - copySteps, mForceDim, copySteps);
-      mBufB.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufB.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_B;
+      next.forces.block(0, 0, mForceDim, copySteps)
+          = getFrame(active).forces.block(
+              0, mNumSteps - copySteps, mForceDim, copySteps);
     }
+    next.forces.block(0, copySteps, mForceDim, zeroSteps).setZero();
+    int usePlanSteps = std::min(useSteps, planSteps);
+    next.forces.block(0, copySteps + zeroSteps, mForceDim, usePlanSteps)
+        = forces.block(0, 0, mForceDim, usePlanSteps);
+    next.forces.rightCols(useSteps - usePlanSteps).setZero();
+    endWrite(next, target);
   }
   else
   {
-    mLastWroteBufferAt = startAt;
-    if (mActiveBuffer == UNINITIALIZED || mActiveBuffer == BUF_B)
-    {
-      mBufA = forces;
-      // Crucial for lock-free behavior: copy the buffer BEFORE setting the
-      // active buffer. Not a huge deal if we're a bit off here in the
-      // optimizer, but not ideal.
-      mActiveBuffer = BUF_A;
-    }
-    else
-    {
-      mBufB = forces;
-      // Crucial for lock-free behavior: copy the buffer BEFORE setting the
-      // active buffer. Not a huge deal if we're a bit off here in the
-      // optimizer, but not ideal.
-      mActiveBuffer = BUF_B;
-    }
+    beginWrite(next);
+    next.startedAt = startAt;
+    next.forces.leftCols(planSteps) = forces.leftCols(planSteps);
+    next.forces.rightCols(mNumSteps - planSteps).setZero();
+    endWrite(next, target);
   }
 }
 
@@ -207,6 +231,8 @@ void RealTimeControlBuffer::setControlForcePlan(
 void RealTimeControlBuffer::estimateWorldStateAt(
     std::shared_ptr<simulation::World> world, ObservationLog* log, long time)
 {
+  drainAppliedForces();
+
   Observation obs = log->getClosestObservationBefore(time);
   int elapsedSinceObservation = time - obs.time;
   if (elapsedSinceObservation < 0)
@@ -226,41 +252,96 @@ void RealTimeControlBuffer::estimateWorldStateAt(
             << stepsSinceObservation << std::endl;
   */
 
-  world->setPositions(obs.pos);
-  world->setVelocities(obs.vel);
-  world->setMasses(log->getMass());
-  for (int i = 0; i < stepsSinceObservation; i++)
+  Eigen::VectorXs mass = log->getMass();
+  long lastRecorded = mControlLog.last();
+
+  // A step's force can't change anymore once the control log has moved on to
+  // a later timestep, because the log only ever overwrites its last entry.
+  // This is how many steps after the observation were fully recorded.
+  int settledSteps = 0;
+  if (mStateCacheEnabled && lastRecorded > obs.time)
+  {
+    settledSteps = (int)floor((s_t)(lastRecorded - obs.time) / mMillisPerStep);
+    settledSteps = std::min(settledSteps, stepsSinceObservation);
+  }
+
+  int startStep = 0;
+  if (mStateCacheEnabled && mCachedSteps > 0
+      && mCachedSteps <= stepsSinceObservation
+      && mCachedObservationTime == obs.time && mCachedMass == mass
+      && mCachedObservationPos == obs.pos && mCachedObservationVel == obs.vel)
+  {
+    world->setPositions(mCachedPos);
+    world->setVelocities(mCachedVel);
+    startStep = mCachedSteps;
+  }
+  else
+  {
+    world->setPositions(obs.pos);
+    world->setVelocities(obs.vel);
+  }
+  world->setMasses(mass);
+
+  Eigen::VectorXs force = Eigen::VectorXs::Zero(mForceDim);
+  for (int i = startStep; i < stepsSinceObservation; i++)
   {
     long at = obs.time + i * mMillisPerStep;
     // In the future, project assuming planned forces
-    if (at > mControlLog.last())
+    if (at > lastRecorded)
     {
-      world->setControlForces(getPlannedForce(at, true));
+      getPlannedForceInPlace(at, force, true);
+      world->setControlForces(force);
     }
     // In the past, project using known forces read from the buffer
     else
     {
-      world->setControlForces(mControlLog.get(at));
+      force = mControlLog.getView(at);
+      world->setControlForces(force);
     }
     world->step();
+
+    if (i + 1 == settledSteps && settledSteps > startStep)
+    {
+      mCachedSteps = settledSteps;
+      mCachedObservationTime = obs.time;
+      mCachedObservationPos = obs.pos;
+      mCachedObservationVel = obs.vel;
+      mCachedMass = mass;
+      mCachedPos = world->getPositions();
+      mCachedVel = world->getVelocities();
+    }
   }
 }
 
+/// This turns on caching of estimated states. Once every force we replayed to
+/// reach a state has been fully recorded in the control log, that state can't
+/// change anymore, so we keep the latest one and later calls to
+/// estimateWorldStateAt() (for the same observation) only simulate forward from
+/// there, rather than from the observation. Defaults to false.
+void RealTimeControlBuffer::setEnableStateCache(bool enabled)
+{
+  mStateCacheEnabled = enabled;
+  mCachedSteps = 0;
+}
+
 /// This rescales the timestep size. This is useful because larger timesteps
 /// mean fewer time steps per real unit of time, and thus we can run our
 /// optimization slower and still keep up with real life.
 void RealTimeControlBuffer::setMillisPerStep(int newMillisPerStep)
 {
+  drainAppliedForces();
   mControlLog.setMillisPerStep(newMillisPerStep);
-  if (mActiveBuffer == BUF_A)
-  {
-    rescaleBuffer(mBufA, mMillisPerStep, newMillisPerStep);
-  }
-  else if (mActiveBuffer == BUF_B)
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_relaxed);
+  if (active != UNINITIALIZED)
   {
-    rescaleBuffer(mBufB, mMillisPerStep, newMillisPerStep);
+    PlanFrame& frame = getFrame(active);
+    beginWrite(frame);
+    rescaleBuffer(frame.forces, mMillisPerStep, newMillisPerStep);
+    endWrite(frame, active);
   }
   mMillisPerStep = newMillisPerStep;
+  // Cached states are counted in steps, so they're meaningless now
+  mCachedSteps = 0;
 }
 
 /// This changes the number of steps. Fewer steps mean we can compute a buffer
@@ -274,26 +355,31 @@ void RealTimeControlBuffer::setNumSteps(int newNumSteps)
   if (mNumSteps < minLen)
     minLen = mNumSteps;
 
-  if (mActiveBuffer == BUF_A)
-  {
-    newBuf.block(0, 0, mForceDim, minLen)
-        = mBufA.block(0, 0, mForceDim, minLen);
-  }
-  else if (mActiveBuffer == BUF_B)
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_relaxed);
+  if (active != UNINITIALIZED)
   {
     newBuf.block(0, 0, mForceDim, minLen)
-        = mBufB.block(0, 0, mForceDim, minLen);
+        = getFrame(active).forces.block(0, 0, mForceDim, minLen);
   }
 
-  mBufA = newBuf;
-  mBufB = newBuf;
+  // This reallocates both plans, so unlike setControlForcePlan() it isn't
+  // safe to call while the control thread is reading
+  mBufA.forces = newBuf;
+  mBufB.forces = newBuf;
+  mNumSteps = newNumSteps;
 }
 
 /// This returns the number of millis we have left in the plan after `time`.
 /// This can be a negative number.
 long RealTimeControlBuffer::getPlanBufferMillisAfter(long time)
 {
-  long planEnd = mLastWroteBufferAt + (mNumSteps * mMillisPerStep);
+  long startedAt = 0L;
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_acquire);
+  if (active != UNINITIALIZED)
+  {
+    startedAt = getFrame(active).startedAt;
+  }
+  long planEnd = startedAt + (mNumSteps * mMillisPerStep);
   return planEnd - time;
 }
 
@@ -302,7 +388,7 @@ long RealTimeControlBuffer::getPlanBufferMillisAfter(long time)
 void RealTimeControlBuffer::manuallyRecordObservedForce(
     long time, Eigen::VectorXs observation)
 {
-  mControlLog.record(time, observation);
+  recordAppliedForce(time, observation);
 }
 
 /// This is a helper to rescale the timestep size of a buffer while leaving
@@ -335,5 +421,120 @@ void RealTimeControlBuffer::rescaleBuffer(
   buf = newBuf;
 }
 
+/// This returns the plan for a buffer switch value
+RealTimeControlBuffer::PlanFrame& RealTimeControlBuffer::getFrame(
+    BufferSwitchEnum buffer)
+{
+  assert(buffer != UNINITIALIZED);
+  return buffer == BUF_B ? mBufB : mBufA;
+}
+
+/// This marks the start of a write to a plan
+void RealTimeControlBuffer::beginWrite(PlanFrame& frame)
+{
+  frame.sequence.fetch_add(1, std::memory_order_relaxed);
+  // Readers must see the odd sequence number before any of our writes
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+/// This marks the end of a write to a plan, and makes it the active plan
+void RealTimeControlBuffer::endWrite(PlanFrame& frame, BufferSwitchEnum buffer)
+{
+  frame.sequence.fetch_add(1, std::memory_order_release);
+  mActiveBuffer.store(buffer, std::memory_order_release);
+}
+
+/// This copies the force planned for `time` out of the active plan, without
+/// blocking. This returns false if there's no plan that covers `time` yet
+/// (we've never received a plan, or `time` is before the start of the current
+/// one). Times after the end of the plan get 0s, and return true.
+bool RealTimeControlBuffer::readPlannedForce(
+    long time, Eigen::Ref<Eigen::VectorXs> forceOut)
+{
+  while (true)
+  {
+    BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_acquire);
+    if (active == UNINITIALIZED)
+    {
+      // Unitialized, default to no force
+      forceOut.setZero();
+      return false;
+    }
+    PlanFrame& frame = getFrame(active);
+    unsigned int sequence = frame.sequence.load(std::memory_order_acquire);
+    if (sequence % 2 == 1)
+    {
+      // The writer only ever writes the inactive plan, so if this one is
+      // mid-write the switch has already flipped since we loaded it, and
+      // reloading it gets us the newest complete plan without waiting
+      continue;
+    }
+
+    bool covered = true;
+    int elapsed = time - frame.startedAt;
+    if (elapsed < 0)
+    {
+      // Asking for some time in the past, default to no force
+      forceOut.setZero();
+      covered = false;
+    }
+    else
+    {
+      int step = (int)floor((s_t)elapsed / mMillisPerStep);
+      if (step < mNumSteps)
+      {
+        forceOut = frame.forces.col(step);
+      }
+      else
+      {
+        // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
+        forceOut.setZero();
+      }
+    }
+
+    // If the sequence number moved while we were reading, the writer touched
+    // this plan under us, and we have to try again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (frame.sequence.load(std::memory_order_relaxed) == sequence)
+    {
+      return covered;
+    }
+  }
+}
+
+/// This queues a force that was applied to the real world, without blocking or
+/// allocating. If the queue is full (nobody has called estimateWorldStateAt()
+/// in a long time) the record is dropped.
+void RealTimeControlBuffer::recordAppliedForce(
+    long time, const Eigen::Ref<const Eigen::VectorXs>& force)
+{
+  unsigned long written = mAppliedForcesWritten.load(std::memory_order_relaxed);
+  unsigned long read = mAppliedForcesRead.load(std::memory_order_acquire);
+  if (written - read >= APPLIED_FORCE_QUEUE_LENGTH)
+  {
+    // The ControlLog holds the last force until the next record, so a dropped
+    // record costs us some accuracy, but nothing worse
+    return;
+  }
+  int slot = written % APPLIED_FORCE_QUEUE_LENGTH;
+  mAppliedForces.col(slot) = force;
+  mAppliedForceTimes[slot] = time;
+  mAppliedForcesWritten.store(written + 1, std::memory_order_release);
+}
+
+/// This moves all queued force records into mControlLog. This must only be
+/// called from the thread that writes plans.
+void RealTimeControlBuffer::drainAppliedForces()
+{
+  unsigned long read = mAppliedForcesRead.load(std::memory_order_relaxed);
+  unsigned long written = mAppliedForcesWritten.load(std::memory_order_acquire);
+  for (unsigned long i = read; i < written; i++)
+  {
+    int slot = i % APPLIED_FORCE_QUEUE_LENGTH;
+    mControlLog.record(mAppliedForceTimes[slot], mAppliedForces.col(slot));
+  }
+  mAppliedForcesRead.store(written, std::memory_order_release);
+}
+
 } // namespace realtime
 } // namespace dart
\ No newline at end of file
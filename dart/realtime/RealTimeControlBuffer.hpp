@@ -1,6 +1,7 @@
 #ifndef DART_REALTIME_BUFFER
 #define DART_REALTIME_BUFFER
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -24,16 +25,39 @@ enum BufferSwitchEnum
   BUF_B
 };
 
+/// This holds the current plan of control forces, which gets written by an
+/// optimization thread and read by a (much faster) control thread.
+///
+/// The control thread never blocks or allocates. We keep two pre-allocated
+/// plans, and the writer only ever writes into whichever one isn't active,
+/// then flips the active switch. Each plan is guarded by a sequence counter
+/// (a "seqlock"), so a reader that happens to race with a write simply retries
+/// its read instead of waiting. Forces that the control thread reads are
+/// pushed into a pre-allocated single-producer single-consumer queue, and only
+/// moved into the ControlLog (which does allocate) on the optimization thread.
+///
+/// setMillisPerStep() and setNumSteps() change the shape of the buffer, and
+/// must not be called while another thread is reading from it.
 class RealTimeControlBuffer
 {
 public:
   RealTimeControlBuffer(int forceDim, int steps, int millisPerStep);
 
+  /// Copy constructor. This is not safe to call while other threads are using
+  /// `other`.
+  RealTimeControlBuffer(const RealTimeControlBuffer& other);
+
   /// Gets the force at a given timestep. This HAS SIDE EFFECTS! We actually
   /// keep track of what forces were read, and assume that they're "immediately"
   /// applied to the real world after they're read.
   Eigen::VectorXs getPlannedForce(long time, bool dontLog = false);
 
+  /// This is the same as getPlannedForce(), but writes into `forceOut` instead
+  /// of returning a new vector. This never blocks or allocates, so it's safe to
+  /// call from a hard real-time control loop.
+  void getPlannedForceInPlace(
+      long time, Eigen::Ref<Eigen::VectorXs> forceOut, bool dontLog = false);
+
   /// This gets planned forces starting at `start`, and continuing for the
   /// length of our buffer size `mSteps`. This is useful for initializing MPC
   /// runs. It supports walking off the end of known future, and assumes 0
@@ -44,7 +68,8 @@ public:
   /// This swaps in a new buffer of forces. If "startAt" is after "now", this
   /// will copy enough of the current buffer into our updated buffer to keep the
   /// current trajectory.
-  void setControlForcePlan(long startAt, long now, Eigen::MatrixXs forces);
+  void setControlForcePlan(
+      long startAt, long now, const Eigen::MatrixXs& forces);
 
   /// This retrieves the state of the world at a given time, assuming that we've
   /// been applying forces from the buffer since the last state that we fully
@@ -52,6 +77,13 @@ public:
   void estimateWorldStateAt(
       std::shared_ptr<simulation::World> world, ObservationLog* log, long time);
 
+  /// This turns on caching of estimated states. Once every force we replayed
+  /// to reach a state has been fully recorded in the control log, that state
+  /// can't change anymore, so we keep the latest one and later calls to
+  /// estimateWorldStateAt() (for the same observation) only simulate forward
+  /// from there, rather than from the observation. Defaults to false.
+  void setEnableStateCache(bool enabled);
+
   /// This rescales the timestep size. This is useful because larger timesteps
   /// mean fewer time steps per real unit of time, and thus we can run our
   /// optimization slower and still keep up with real life.
@@ -71,6 +103,20 @@ public:
   void manuallyRecordObservedForce(long time, Eigen::VectorXs observation);
 
 protected:
+  /// This is a single pre-allocated plan. A writer bumps `sequence` to an odd
+  /// number before it touches the plan, and back to an even number when it's
+  /// done, so readers can detect (and retry) a read that raced with a write.
+  struct PlanFrame
+  {
+    PlanFrame(int forceDim, int steps);
+    PlanFrame(const PlanFrame& other);
+
+    Eigen::MatrixXs forces;
+    /// This is the time that the first column of `forces` applies to
+    long startedAt;
+    std::atomic<unsigned int> sequence;
+  };
+
   int mForceDim;
   int mNumSteps;
   int mMillisPerStep;
@@ -80,22 +126,63 @@ protected:
   void rescaleBuffer(
       Eigen::MatrixXs& buf, int oldMillisPerStep, int newMillisPerStep);
 
+  /// This returns the plan for a buffer switch value
+  PlanFrame& getFrame(BufferSwitchEnum buffer);
+
+  /// This marks the start of a write to a plan
+  void beginWrite(PlanFrame& frame);
+
+  /// This marks the end of a write to a plan, and makes it the active plan
+  void endWrite(PlanFrame& frame, BufferSwitchEnum buffer);
+
+  /// This copies the force planned for `time` out of the active plan, without
+  /// blocking. This returns false if there's no plan that covers `time` yet
+  /// (we've never received a plan, or `time` is before the start of the
+  /// current one). Times after the end of the plan get 0s, and return true.
+  bool readPlannedForce(long time, Eigen::Ref<Eigen::VectorXs> forceOut);
+
+  /// This queues a force that was applied to the real world, without blocking
+  /// or allocating. If the queue is full (nobody has called
+  /// estimateWorldStateAt() in a long time) the record is dropped.
+  void recordAppliedForce(
+      long time, const Eigen::Ref<const Eigen::VectorXs>& force);
+
+  /// This moves all queued force records into mControlLog. This must only be
+  /// called from the thread that writes plans.
+  void drainAppliedForces();
+
   /// This controls which of our buffers is currently active
-  BufferSwitchEnum mActiveBuffer;
+  std::atomic<BufferSwitchEnum> mActiveBuffer;
 
   /// This is the A buffer of forces
-  Eigen::MatrixXs mBufA;
+  PlanFrame mBufA;
 
   /// This is the B buffer of forces
-  Eigen::MatrixXs mBufB;
+  PlanFrame mBufB;
 
-  /// This is the time when the last buffer was written to
-  long mLastWroteBufferAt;
+  /// These hold forces the control thread has applied, waiting to be moved
+  /// into mControlLog. This is a ring buffer, indexed by the counters modulo
+  /// its length.
+  Eigen::MatrixXs mAppliedForces;
+  std::vector<long> mAppliedForceTimes;
+  std::atomic<unsigned long> mAppliedForcesWritten;
+  std::atomic<unsigned long> mAppliedForcesRead;
 
   /// This keeps a log of all the control outputs we send, so that we can get
   /// the current state on request, even if we last had an observation a while
   /// ago.
   ControlLog mControlLog;
+
+  /// This is the most recent state that estimateWorldStateAt() reached that
+  /// can't change anymore, along with the observation it was simulated from.
+  bool mStateCacheEnabled;
+  int mCachedSteps;
+  long mCachedObservationTime;
+  Eigen::VectorXs mCachedObservationPos;
+  Eigen::VectorXs mCachedObservationVel;
+  Eigen::VectorXs mCachedMass;
+  Eigen::VectorXs mCachedPos;
+  Eigen::VectorXs mCachedVel;
 };
 
 } // namespace realtime
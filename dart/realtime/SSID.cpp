@@ -1,12 +1,16 @@
 #include "dart/realtime/SSID.hpp"
 
+#include <algorithm>
+#include <future>
 #include <thread>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/realtime/Millis.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
 #include "dart/trajectory/TrajectoryRollout.hpp"
+#include "dart/utils/CSVParser.hpp"
 
 #include "signal.h"
 
@@ -16,6 +20,18 @@ using namespace trajectory;
 
 namespace realtime {
 
+// This is how many observations each queue can hold between drains. At 1kHz
+// this is just over 2 seconds.
+static const int OBSERVATION_QUEUE_LENGTH = 2048;
+
+SSID::ObservationQueue::ObservationQueue(int dim)
+  : values(Eigen::MatrixXs::Zero(dim, OBSERVATION_QUEUE_LENGTH)),
+    times(OBSERVATION_QUEUE_LENGTH, 0L),
+    written(0),
+    read(0)
+{
+}
+
 SSID::SSID(
     std::shared_ptr<simulation::World> world,
     std::shared_ptr<trajectory::LossFn> loss,
@@ -28,11 +44,15 @@ SSID::SSID(
     mPlanningHistoryMillis(planningHistoryMillis),
     mSensorDims(sensorDims),
     mControlLog(VectorLog(world->getNumDofs())),
+    mControlQueue(world->getNumDofs()),
+    mCustomProblem(false),
     mPlanningSteps(steps)
 {
   for(int i=0;i<mSensorDims.size();i++)
   {
     mSensorLogs.push_back(VectorLog(mSensorDims(i)));
+    mSensorQueues.push_back(std::unique_ptr<ObservationQueue>(
+        new ObservationQueue(mSensorDims(i))));
   }
   int dofs = world->getNumDofs();
   mInitialPosEstimator
@@ -84,6 +104,7 @@ std::shared_ptr<trajectory::Optimizer> SSID::getOptimizer()
 void SSID::setProblem(std::shared_ptr<trajectory::Problem> problem)
 {
   mProblem = problem;
+  mCustomProblem = true;
 }
 
 /// This registers a function that can be used to estimate the initial state
@@ -119,16 +140,174 @@ void SSID::registerControlsNow(Eigen::VectorXs controls)
 }
 
 /// This logs that the sensor output was a specific vector at a specific
-/// moment
+/// moment. This never blocks or allocates: the value goes into a
+/// pre-allocated lock-free queue, which inference drains later. Each
+/// sensor_id must only be registered from one thread at a time.
 void SSID::registerSensors(long now, Eigen::VectorXs sensors, int sensor_id)
 {
-  mSensorLogs[sensor_id].record(now, sensors);
+  pushObservation(*mSensorQueues[sensor_id].get(), now, sensors);
 }
 
-/// This logs that our controls were this value at this time
+/// This logs that our controls were this value at this time. Like
+/// registerSensors(), this never blocks, and must only be called from one
+/// thread at a time.
 void SSID::registerControls(long now, Eigen::VectorXs controls)
 {
-  mControlLog.record(now, controls);
+  pushObservation(mControlQueue, now, controls);
+}
+
+/// This queues an observation without blocking or allocating. If the queue
+/// is full (nobody has drained it in a long time) the record is dropped.
+void SSID::pushObservation(
+    ObservationQueue& queue,
+    long time,
+    const Eigen::Ref<const Eigen::VectorXs>& value)
+{
+  unsigned long written = queue.written.load(std::memory_order_relaxed);
+  unsigned long read = queue.read.load(std::memory_order_acquire);
+  if (written - read >= OBSERVATION_QUEUE_LENGTH)
+  {
+    return;
+  }
+  int slot = written % OBSERVATION_QUEUE_LENGTH;
+  queue.values.col(slot) = value;
+  queue.times[slot] = time;
+  queue.written.store(written + 1, std::memory_order_release);
+}
+
+/// This moves every queued observation into `log`
+void SSID::drainObservations(ObservationQueue& queue, VectorLog& log)
+{
+  unsigned long read = queue.read.load(std::memory_order_relaxed);
+  unsigned long written = queue.written.load(std::memory_order_acquire);
+  for (unsigned long i = read; i < written; i++)
+  {
+    int slot = i % OBSERVATION_QUEUE_LENGTH;
+    log.record(queue.times[slot], queue.values.col(slot));
+  }
+  queue.read.store(written, std::memory_order_release);
+}
+
+/// This moves everything registered so far into the logs. The caller must
+/// hold mLogReadMutex.
+void SSID::drainQueues()
+{
+  drainObservations(mControlQueue, mControlLog);
+  for (int i = 0; i < mSensorLogs.size(); i++)
+  {
+    drainObservations(*mSensorQueues[i].get(), mSensorLogs[i]);
+  }
+}
+
+/// This drains the queues, and reads the last `steps` + 1 controls, poses
+/// and velocities before `startTime`
+void SSID::readHistory(
+    long startTime,
+    int steps,
+    Eigen::MatrixXs& forceHistory,
+    Eigen::MatrixXs& poseHistory,
+    Eigen::MatrixXs& velHistory)
+{
+  std::lock_guard<std::mutex> guard(mLogReadMutex);
+  drainQueues();
+  forceHistory = mControlLog.getRecentValuesBefore(startTime, steps + 1);
+  poseHistory = mSensorLogs[0].getRecentValuesBefore(startTime, steps + 1);
+  velHistory = mSensorLogs[1].getRecentValuesBefore(startTime, steps + 1);
+}
+
+/// This pins the force history, and loads the sensor history and the
+/// estimated initial state, into `problem`
+void SSID::loadHistory(
+    trajectory::Problem* problem,
+    int steps,
+    const Eigen::MatrixXs& forceHistory,
+    const Eigen::MatrixXs& poseHistory,
+    const Eigen::MatrixXs& velHistory,
+    const Eigen::VectorXs& startPos,
+    const Eigen::VectorXs& startVel)
+{
+  for (int i = 0; i < steps; i++)
+  {
+    problem->pinForce(i, forceHistory.col(i));
+  }
+  problem->setMetadata("forces", forceHistory);
+  problem->setMetadata("sensors", poseHistory);
+  problem->setMetadata("velocities", velHistory);
+  problem->setStartPos(startPos);
+  problem->setStartVel(startVel);
+}
+
+/// This returns the loss for each column of `masses`. Without a custom
+/// problem, columns are spread over the global thread pool, where every
+/// worker gets its own world clone and its own SingleShot. A custom
+/// problem can't be copied, so it gets evaluated serially on mWorld.
+Eigen::VectorXs SSID::computeLossesAtMasses(
+    long startTime, int steps, const Eigen::MatrixXs& masses)
+{
+  Eigen::MatrixXs forceHistory;
+  Eigen::MatrixXs poseHistory;
+  Eigen::MatrixXs velHistory;
+  readHistory(startTime, steps, forceHistory, poseHistory, velHistory);
+  Eigen::VectorXs startPos = mInitialPosEstimator(poseHistory, startTime);
+  Eigen::VectorXs startVel = mInitialVelEstimator(velHistory, startTime);
+
+  int samples = masses.cols();
+  Eigen::VectorXs losses = Eigen::VectorXs::Zero(samples);
+
+  if (mCustomProblem)
+  {
+    loadHistory(
+        mProblem.get(),
+        steps,
+        forceHistory,
+        poseHistory,
+        velHistory,
+        startPos,
+        startVel);
+    for (int i = 0; i < samples; i++)
+    {
+      mWorld->setMasses(masses.col(i));
+      mProblem->resetDirty();
+      losses(i) = mProblem->getLoss(mWorld);
+    }
+    return losses;
+  }
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  int numWorkers = std::max(
+      1, std::min(samples, static_cast<int>(pool.getNumThreads())));
+  std::vector<std::future<void>> futures;
+  for (int w = 0; w < numWorkers; w++)
+  {
+    // Cloning happens here, on the calling thread, so no worker ever reads
+    // mWorld while another one is cloning it
+    std::shared_ptr<simulation::World> world = mWorld->clone();
+    std::shared_ptr<SingleShot> problem
+        = std::make_shared<SingleShot>(world, *mLoss.get(), steps, false);
+    loadHistory(
+        problem.get(),
+        steps,
+        forceHistory,
+        poseHistory,
+        velHistory,
+        startPos,
+        startVel);
+    auto task = [&masses, &losses, world, problem, samples, numWorkers, w]() {
+      for (int i = w; i < samples; i += numWorkers)
+      {
+        world->setMasses(masses.col(i));
+        problem->resetDirty();
+        losses(i) = problem->getLoss(world);
+      }
+    };
+    futures.push_back(pool.submit(task));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+  return losses;
 }
 
 /// This starts our main thread and begins running optimizations
@@ -167,34 +346,20 @@ void SSID::runInference(long startTime)
     mProblem = singleshot;
   }
   //std::cout<<"Problem Created"<<std::endl;
-  // Every turn, we need to pin all the forces
-  registerLock();
-  //Eigen::MatrixXs forceHistory = mControlLog.getValues(
-  //    startTime - mPlanningHistoryMillis, steps, millisPerStep);
-  Eigen::MatrixXs forceHistory = mControlLog.getRecentValuesBefore(
-    startTime, steps+1);
-  for (int i = 0; i < steps; i++)
-  {
-    mProblem->pinForce(i, forceHistory.col(i));
-  }
-  //std::cout<<"ForcePinned"<<std::endl;
-  // We also need to set all the sensor history into metadata
-
-  //Eigen::MatrixXs poseHistory = mSensorLogs[0].getValues(
-  //    startTime - mPlanningHistoryMillis, steps, millisPerStep);
-  //Eigen::MatrixXs velHistory = mSensorLogs[1].getValues(
-  //  startTime - mPlanningHistoryMillis, steps, millisPerStep
-  // );
-  Eigen::MatrixXs poseHistory = mSensorLogs[0].getRecentValuesBefore(startTime,steps+1);
-  Eigen::MatrixXs velHistory = mSensorLogs[1].getRecentValuesBefore(startTime,steps+1);
-  registerUnlock();
-  //std::cout<<"In SSID Force Hist: \n"<<forceHistory<<"\nPos Hist: \n"<<poseHistory<<"\nVel Hist: \n"<<velHistory<<std::endl;
-  mProblem->setMetadata("forces", forceHistory);
-  mProblem->setMetadata("sensors", poseHistory);
-  mProblem->setMetadata("velocities",velHistory);
-  mProblem->setStartPos(mInitialPosEstimator(poseHistory, startTime));
-  // TODO: Set initial velocity
-  mProblem->setStartVel(mInitialVelEstimator(velHistory, startTime));
+  // Every turn, we need to pin all the forces, and set all the sensor history
+  // into metadata
+  Eigen::MatrixXs forceHistory;
+  Eigen::MatrixXs poseHistory;
+  Eigen::MatrixXs velHistory;
+  readHistory(startTime, steps, forceHistory, poseHistory, velHistory);
+  loadHistory(
+      mProblem.get(),
+      steps,
+      forceHistory,
+      poseHistory,
+      velHistory,
+      mInitialPosEstimator(poseHistory, startTime),
+      mInitialVelEstimator(velHistory, startTime));
   // Then actually run the optimization
   //std::cout<<"Ready to Optimize"<<std::endl;
   mSolution = mOptimizer->optimize(mProblem.get());
@@ -221,56 +386,24 @@ Eigen::VectorXs SSID::runPlotting(long startTime, s_t upper, s_t lower,int sampl
   int steps = static_cast<int>(
       ceil(static_cast<s_t>(mPlanningHistoryMillis) / millisPerStep));
 
-  if (!mProblem)
-  {
-    std::shared_ptr<SingleShot> singleshot
-        = std::make_shared<SingleShot>(mWorld, *mLoss.get(), steps, false);
-    mProblem = singleshot;
-  }
-  
-  registerLock();
-  Eigen::MatrixXs forceHistory = mControlLog.getRecentValuesBefore(
-    startTime, steps+1);
-  for (int i = 0; i < steps; i++)
-  {
-    mProblem->pinForce(i, forceHistory.col(i));
-  }
-  
-  Eigen::MatrixXs poseHistory = mSensorLogs[0].getRecentValuesBefore(startTime,steps+1);
-  Eigen::MatrixXs velHistory = mSensorLogs[1].getRecentValuesBefore(startTime,steps+1);
-  
-  registerUnlock();
-  mProblem->setMetadata("forces", forceHistory);
-  mProblem->setMetadata("sensors", poseHistory);
-  mProblem->setMetadata("velocities",velHistory);
-  mProblem->setStartPos(mInitialPosEstimator(poseHistory, startTime));
-  mProblem->setStartVel(mInitialVelEstimator(velHistory, startTime));
-
-  Eigen::VectorXs losses;
+  Eigen::MatrixXs masses;
   if(upper != lower)
   {
-    losses = Eigen::VectorXs::Zero(samples);
+    masses = Eigen::MatrixXs::Zero(1, samples);
     s_t epsilon = (upper-lower)/samples;
     s_t probe = lower;
     for(int i=0;i<samples;i++)
     {
-      mWorld->setMasses(Eigen::Vector1s(probe));
-      mProblem->resetDirty();
-      s_t loss = mProblem->getLoss(mWorld);
-      losses(i) = loss;
+      masses(0, i) = probe;
       probe += epsilon;
     }
   }
   else
   {
-    losses = Eigen::VectorXs::Zero(1);
-    mWorld->setMasses(Eigen::Vector1s(lower));
-    mProblem->resetDirty();
-    s_t loss = mProblem->getLoss(mWorld);
-    losses(0) = loss;
+    masses = Eigen::MatrixXs::Constant(1, 1, lower);
   }
-  
-  return losses;
+
+  return computeLossesAtMasses(startTime, steps, masses);
 }
 
 
@@ -280,35 +413,6 @@ Eigen::MatrixXs SSID::runPlotting2D(long startTime, Eigen::Vector3s upper, Eigen
   int steps = static_cast<int>(
       ceil(static_cast<s_t>(mPlanningHistoryMillis) / millisPerStep));
 
-  if (!mProblem)
-  {
-    std::shared_ptr<SingleShot> singleshot
-        = std::make_shared<SingleShot>(mWorld, *mLoss.get(), steps, false);
-    mProblem = singleshot;
-  }
-  
-  registerLock();
-  Eigen::MatrixXs forceHistory = mControlLog.getRecentValuesBefore(
-    startTime, steps+1);
-  for (int i = 0; i < steps; i++)
-  {
-    mProblem->pinForce(i, forceHistory.col(i));
-  }
-  
-  Eigen::MatrixXs poseHistory = mSensorLogs[0].getRecentValuesBefore(startTime,steps+1);
-  Eigen::MatrixXs velHistory = mSensorLogs[1].getRecentValuesBefore(startTime,steps+1);
-  
-  registerUnlock();
-  mProblem->setMetadata("forces", forceHistory);
-  mProblem->setMetadata("sensors", poseHistory);
-  mProblem->setMetadata("velocities",velHistory);
-  mProblem->setStartPos(mInitialPosEstimator(poseHistory, startTime));
-  mProblem->setStartVel(mInitialVelEstimator(velHistory, startTime));
-
-  Eigen::MatrixXs losses = Eigen::MatrixXs::Zero(x_samples,y_samples);
-  
-  
-  
   Eigen::Vector3s probe = lower;
   assert(rest_dim < 3);
   size_t probe_dim_1;
@@ -332,30 +436,36 @@ Eigen::MatrixXs SSID::runPlotting2D(long startTime, Eigen::Vector3s upper, Eigen
   s_t x_epsilon = (upper(probe_dim_1)-lower(probe_dim_1))/x_samples;
   s_t y_epsilon = (upper(probe_dim_2)-lower(probe_dim_2))/y_samples;
 
+  // Lay the whole grid out first, one column per sample in row-major order,
+  // so it can be evaluated in parallel
+  Eigen::MatrixXs masses = Eigen::MatrixXs::Zero(3, x_samples * y_samples);
   for(int x_i=0;x_i<x_samples;x_i++)
   {
     probe(probe_dim_2) = lower(probe_dim_2);
     for(int y_i=0; y_i < y_samples; y_i++)
     {
-      mWorld->setMasses(probe);
-      mProblem->resetDirty();
-      losses(x_i,y_i) = mProblem->getLoss(mWorld);
+      masses.col(x_i * y_samples + y_i) = probe;
       probe(probe_dim_2) += y_epsilon;
     }
     probe(probe_dim_1) += x_epsilon;
   }
+
+  Eigen::VectorXs flatLosses = computeLossesAtMasses(startTime, steps, masses);
+  Eigen::MatrixXs losses = Eigen::MatrixXs::Zero(x_samples,y_samples);
+  for(int x_i=0;x_i<x_samples;x_i++)
+  {
+    for(int y_i=0; y_i < y_samples; y_i++)
+    {
+      losses(x_i,y_i) = flatLosses(x_i * y_samples + y_i);
+    }
+  }
   return losses;
 }
 
 void SSID::saveCSVMatrix(std::string filename, Eigen::MatrixXs matrix)
 {
-  const static Eigen::IOFormat CSVFormat(Eigen::FullPrecision, Eigen::DontAlignCols, ", ", "\n");
-  std::ofstream file(filename);
-  if (file.is_open())
-  {
-      file << matrix.format(CSVFormat);
-      file.close();
-  }
+  utils::CSVParser::CSVWriter writer(filename, ", ");
+  writer.writeMatrix(matrix);
 }
 
 /// This registers a listener to get called when we finish replanning
@@ -391,7 +501,13 @@ void SSID::optimizationThreadLoop()
  while(mRunning)
  {
    long startTime = timeSinceEpochMillis();
-   if(mControlLog.availableStepsBefore(startTime)>mPlanningSteps+1)
+   int availableSteps;
+   {
+     std::lock_guard<std::mutex> guard(mLogReadMutex);
+     drainQueues();
+     availableSteps = mControlLog.availableStepsBefore(startTime);
+   }
+   if(availableSteps>mPlanningSteps+1)
    {
      runInference(startTime);
    }
@@ -1,9 +1,11 @@
 #ifndef DART_REALTIME_SSID
 #define DART_REALTIME_SSID
 
+#include <atomic>
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 #include <Eigen/Dense>
 #include <iostream>
@@ -74,10 +76,14 @@ public:
   void registerControlsNow(Eigen::VectorXs sensors);
 
   /// This logs that the sensor output was a specific vector at a specific
-  /// moment
+  /// moment. This never blocks or allocates: the value goes into a
+  /// pre-allocated lock-free queue, which inference drains later. Each
+  /// sensor_id must only be registered from one thread at a time.
   void registerSensors(long now, Eigen::VectorXs sensors, int sensor_id);
 
-  /// This logs that our controls were this value at this time
+  /// This logs that our controls were this value at this time. Like
+  /// registerSensors(), this never blocks, and must only be called from one
+  /// thread at a time.
   void registerControls(long now, Eigen::VectorXs controls);
 
   /// This starts our main thread and begins running optimizations
@@ -89,8 +95,15 @@ public:
   /// This runs inference to find mutable values, starting at `startTime`
   void runInference(long startTime);
 
+  /// This evaluates the loss over `samples` evenly spaced masses from `lower`
+  /// to `upper`. Unless a custom problem was set with setProblem(), the
+  /// samples are spread over the global thread pool, each worker with its own
+  /// clone of the world.
   Eigen::VectorXs runPlotting(long startTime, s_t upper, s_t lower, int samples);
 
+  /// This evaluates the loss over an `x_samples` by `y_samples` grid of
+  /// masses, holding dimension `rest_dim` at `lower(rest_dim)`. This is
+  /// parallelized the same way as runPlotting().
   Eigen::MatrixXs runPlotting2D(long startTime, Eigen::Vector3s upper, Eigen::Vector3s lower, int x_samples, int y_samples, size_t rest_dim);
 
   void saveCSVMatrix(std::string filename, Eigen::MatrixXs matrix);
@@ -101,12 +114,67 @@ public:
           void(long, Eigen::VectorXs, Eigen::VectorXs, Eigen::VectorXs, long)>
           inferListener);
 
-  // wrapper for locking the buffer
+  // wrapper for locking the buffer. Registering sensors and controls is
+  // lock-free now, so SSID itself no longer takes this lock. These are only
+  // kept for callers that still use the lock for their own bookkeeping.
   void attachMutex(std::mutex &mutex_lock);
   void registerLock();
   void registerUnlock();
 
 protected:
+  /// This is a pre-allocated single-producer single-consumer ring buffer of
+  /// observations, indexed by the counters modulo its length.
+  struct ObservationQueue
+  {
+    ObservationQueue(int dim);
+
+    Eigen::MatrixXs values;
+    std::vector<long> times;
+    std::atomic<unsigned long> written;
+    std::atomic<unsigned long> read;
+  };
+
+  /// This queues an observation without blocking or allocating. If the queue
+  /// is full (nobody has drained it in a long time) the record is dropped.
+  static void pushObservation(
+      ObservationQueue& queue,
+      long time,
+      const Eigen::Ref<const Eigen::VectorXs>& value);
+
+  /// This moves every queued observation into `log`
+  static void drainObservations(ObservationQueue& queue, VectorLog& log);
+
+  /// This moves everything registered so far into the logs. The caller must
+  /// hold mLogReadMutex.
+  void drainQueues();
+
+  /// This drains the queues, and reads the last `steps` + 1 controls, poses
+  /// and velocities before `startTime`
+  void readHistory(
+      long startTime,
+      int steps,
+      Eigen::MatrixXs& forceHistory,
+      Eigen::MatrixXs& poseHistory,
+      Eigen::MatrixXs& velHistory);
+
+  /// This pins the force history, and loads the sensor history and the
+  /// estimated initial state, into `problem`
+  void loadHistory(
+      trajectory::Problem* problem,
+      int steps,
+      const Eigen::MatrixXs& forceHistory,
+      const Eigen::MatrixXs& poseHistory,
+      const Eigen::MatrixXs& velHistory,
+      const Eigen::VectorXs& startPos,
+      const Eigen::VectorXs& startVel);
+
+  /// This returns the loss for each column of `masses`. Without a custom
+  /// problem, columns are spread over the global thread pool, where every
+  /// worker gets its own world clone and its own SingleShot. A custom
+  /// problem can't be copied, so it gets evaluated serially on mWorld.
+  Eigen::VectorXs computeLossesAtMasses(
+      long startTime, int steps, const Eigen::MatrixXs& masses);
+
   /// This is the function for the optimization thread to run when we're live
   void optimizationThreadLoop();
 
@@ -119,6 +187,20 @@ protected:
   std::vector<VectorLog> mSensorLogs;
   VectorLog mControlLog;
 
+  /// These hold registered observations until inference moves them into the
+  /// logs above
+  std::vector<std::unique_ptr<ObservationQueue>> mSensorQueues;
+  ObservationQueue mControlQueue;
+
+  /// This keeps more than one reader (say, the optimization thread and a
+  /// plotting call) from draining the queues into the logs at once. Writers
+  /// never touch it.
+  std::mutex mLogReadMutex;
+
+  /// This is true if the problem came from setProblem(), rather than being
+  /// the default SingleShot we build ourselves
+  bool mCustomProblem;
+
   std::shared_ptr<trajectory::Optimizer> mOptimizer;
   std::shared_ptr<trajectory::Problem> mProblem;
   std::shared_ptr<trajectory::Solution> mSolution;
@@ -0,0 +1,207 @@
+#include "dart/realtime/SharedMemoryPlanRing.hpp"
+
+#include <new>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+#include "dart/trajectory/TrajectoryRollout.hpp"
+
+// The two processes only share memory, not an address space, so the atomics
+// in it have to work without any help from a process-local lock
+static_assert(
+    ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LONG_LOCK_FREE == 2,
+    "SharedMemoryPlanRing needs lock-free atomics");
+
+namespace dart {
+namespace realtime {
+
+namespace {
+
+/// This rounds `bytes` up to a multiple of the cache line size, so slots
+/// never share a cache line
+std::size_t roundUpToCacheLine(std::size_t bytes)
+{
+  const std::size_t line = 64;
+  return (bytes + line - 1) / line * line;
+}
+
+/// This copies a matrix into shared memory, column-major
+void copyOut(const Eigen::Ref<const Eigen::MatrixXs>& mat, double* out)
+{
+  for (int col = 0; col < mat.cols(); col++)
+  {
+    for (int row = 0; row < mat.rows(); row++)
+    {
+      *out = static_cast<double>(mat(row, col));
+      out++;
+    }
+  }
+}
+
+/// This copies a matrix back out of shared memory, column-major
+void copyIn(const double* in, Eigen::Ref<Eigen::MatrixXs> mat)
+{
+  for (int col = 0; col < mat.cols(); col++)
+  {
+    for (int row = 0; row < mat.rows(); row++)
+    {
+      mat(row, col) = static_cast<s_t>(*in);
+      in++;
+    }
+  }
+}
+
+} // namespace
+
+SharedMemoryPlanRing::SharedMemoryPlanRing(
+    int dofs, int steps, int massDim, int numSlots)
+  : mDofs(dofs), mSteps(steps), mMassDim(massDim), mNumSlots(numSlots)
+{
+  std::size_t numValues = 3 * dofs * steps + massDim;
+  mSlotBytes = roundUpToCacheLine(
+      sizeof(SlotHeader) + sizeof(double) * numValues);
+  std::size_t headerBytes
+      = roundUpToCacheLine(sizeof(std::atomic<unsigned long>));
+  mMappedBytes = headerBytes + mSlotBytes * numSlots;
+
+  // An anonymous shared mapping survives fork(), and gets unmapped by the OS
+  // once both processes are done with it
+  mMemory = mmap(
+      nullptr,
+      mMappedBytes,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_ANONYMOUS,
+      -1,
+      0);
+  if (mMemory == MAP_FAILED)
+  {
+    throw std::runtime_error(
+        "SharedMemoryPlanRing could not map shared memory");
+  }
+
+  mPublished = new (mMemory) std::atomic<unsigned long>(0);
+  for (int i = 0; i < numSlots; i++)
+  {
+    SlotHeader* slot = new (static_cast<char*>(mMemory) + headerBytes
+                            + mSlotBytes * i) SlotHeader();
+    slot->sequence.store(0);
+    slot->startTime = 0L;
+    slot->replanDurationMillis = 0L;
+  }
+}
+
+SharedMemoryPlanRing::~SharedMemoryPlanRing()
+{
+  munmap(mMemory, mMappedBytes);
+}
+
+/// This copies the "identity" mapping of `rollout` into the next slot, and
+/// publishes it. This must only be called from the one writer.
+void SharedMemoryPlanRing::publish(
+    long startTime,
+    long replanDurationMillis,
+    const trajectory::TrajectoryRollout* rollout)
+{
+  unsigned long published = mPublished->load(std::memory_order_relaxed);
+  int index = published % mNumSlots;
+  SlotHeader* slot = getSlot(index);
+  double* values = getSlotValues(index);
+
+  // Mark the slot as being written, before we touch any of it
+  unsigned int sequence = slot->sequence.load(std::memory_order_relaxed);
+  slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->startTime = startTime;
+  slot->replanDurationMillis = replanDurationMillis;
+  int matrixSize = mDofs * mSteps;
+  copyOut(rollout->getPosesConst().leftCols(mSteps), values);
+  copyOut(rollout->getVelsConst().leftCols(mSteps), values + matrixSize);
+  copyOut(
+      rollout->getControlForcesConst().leftCols(mSteps),
+      values + 2 * matrixSize);
+  copyOut(
+      rollout->getMassesConst().head(mMassDim), values + 3 * matrixSize);
+
+  slot->sequence.store(sequence + 2, std::memory_order_release);
+  mPublished->store(published + 1, std::memory_order_release);
+}
+
+/// This copies the latest published plan into the out parameters, if it's
+/// newer than `lastSeen`, and updates `lastSeen`. Returns false (and leaves
+/// the outputs alone) if nothing new has been published. The matrices must
+/// already be the right size. This must only be called from the one reader.
+bool SharedMemoryPlanRing::readLatest(
+    unsigned long& lastSeen,
+    long& startTime,
+    long& replanDurationMillis,
+    Eigen::Ref<Eigen::MatrixXs> pos,
+    Eigen::Ref<Eigen::MatrixXs> vel,
+    Eigen::Ref<Eigen::MatrixXs> force,
+    Eigen::Ref<Eigen::VectorXs> mass)
+{
+  while (true)
+  {
+    unsigned long published = mPublished->load(std::memory_order_acquire);
+    if (published == lastSeen)
+      return false;
+
+    int index = (published - 1) % mNumSlots;
+    SlotHeader* slot = getSlot(index);
+    const double* values = getSlotValues(index);
+
+    unsigned int sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence % 2 == 1)
+    {
+      // The writer has lapped us and is refilling this slot, so there must
+      // be a newer plan by the time it's done
+      continue;
+    }
+
+    long readStartTime = slot->startTime;
+    long readDuration = slot->replanDurationMillis;
+    int matrixSize = mDofs * mSteps;
+    copyIn(values, pos);
+    copyIn(values + matrixSize, vel);
+    copyIn(values + 2 * matrixSize, force);
+    copyIn(values + 3 * matrixSize, mass);
+
+    // If the sequence moved while we were copying, the writer got into this
+    // slot under us, and we have to try again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->sequence.load(std::memory_order_relaxed) != sequence)
+      continue;
+
+    startTime = readStartTime;
+    replanDurationMillis = readDuration;
+    lastSeen = published;
+    return true;
+  }
+}
+
+/// This returns how many plans have been published so far
+unsigned long SharedMemoryPlanRing::getNumPublished() const
+{
+  return mPublished->load(std::memory_order_acquire);
+}
+
+/// This returns the header of slot `i`
+SharedMemoryPlanRing::SlotHeader* SharedMemoryPlanRing::getSlot(int i)
+{
+  std::size_t headerBytes
+      = roundUpToCacheLine(sizeof(std::atomic<unsigned long>));
+  return reinterpret_cast<SlotHeader*>(
+      static_cast<char*>(mMemory) + headerBytes + mSlotBytes * i);
+}
+
+/// This returns the values stored in slot `i`, which are pos, vel, and force
+/// (each column-major), then mass
+double* SharedMemoryPlanRing::getSlotValues(int i)
+{
+  return reinterpret_cast<double*>(
+      reinterpret_cast<char*>(getSlot(i)) + sizeof(SlotHeader));
+}
+
+} // namespace realtime
+} // namespace dart
@@ -0,0 +1,94 @@
+#ifndef DART_REALTIME_SHARED_MEMORY_PLAN_RING
+#define DART_REALTIME_SHARED_MEMORY_PLAN_RING
+
+#include <atomic>
+#include <cstddef>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace trajectory {
+class TrajectoryRollout;
+}
+
+namespace realtime {
+
+/// This is a lock-free ring of pre-sized plan slots, living in memory that's
+/// shared across a fork(). It's how MPCRemote gets plans from an MPCLocal
+/// running in a child process on the same machine, without going through
+/// gRPC and protobuf serialization.
+///
+/// There must be exactly one writer (the planner) and one reader (the
+/// controller). The writer fills the slot after the last published one, and
+/// then bumps the published counter. Each slot is guarded by a sequence
+/// counter (a "seqlock"), so if the writer laps the reader mid-read, the
+/// reader notices and retries instead of returning a torn plan. Neither side
+/// ever blocks or allocates.
+///
+/// The ring has to be created before fork(), so both processes map the same
+/// memory.
+class SharedMemoryPlanRing
+{
+public:
+  SharedMemoryPlanRing(int dofs, int steps, int massDim, int numSlots = 4);
+
+  ~SharedMemoryPlanRing();
+
+  SharedMemoryPlanRing(const SharedMemoryPlanRing&) = delete;
+  SharedMemoryPlanRing& operator=(const SharedMemoryPlanRing&) = delete;
+
+  /// This copies the "identity" mapping of `rollout` into the next slot, and
+  /// publishes it. This must only be called from the one writer.
+  void publish(
+      long startTime,
+      long replanDurationMillis,
+      const trajectory::TrajectoryRollout* rollout);
+
+  /// This copies the latest published plan into the out parameters, if it's
+  /// newer than `lastSeen`, and updates `lastSeen`. Returns false (and leaves
+  /// the outputs alone) if nothing new has been published. The matrices must
+  /// already be the right size. This must only be called from the one reader.
+  bool readLatest(
+      unsigned long& lastSeen,
+      long& startTime,
+      long& replanDurationMillis,
+      Eigen::Ref<Eigen::MatrixXs> pos,
+      Eigen::Ref<Eigen::MatrixXs> vel,
+      Eigen::Ref<Eigen::MatrixXs> force,
+      Eigen::Ref<Eigen::VectorXs> mass);
+
+  /// This returns how many plans have been published so far
+  unsigned long getNumPublished() const;
+
+protected:
+  struct SlotHeader
+  {
+    std::atomic<unsigned int> sequence;
+    long startTime;
+    long replanDurationMillis;
+  };
+
+  /// This returns the header of slot `i`
+  SlotHeader* getSlot(int i);
+
+  /// This returns the values stored in slot `i`, which are pos, vel, and force
+  /// (each column-major), then mass
+  double* getSlotValues(int i);
+
+  int mDofs;
+  int mSteps;
+  int mMassDim;
+  int mNumSlots;
+  std::size_t mSlotBytes;
+  std::size_t mMappedBytes;
+  void* mMemory;
+  std::atomic<unsigned long>* mPublished;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
@@ -1,13 +1,30 @@
 #include "dart/realtime/Ticker.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include "dart/realtime/Millis.hpp"
 
 namespace dart {
 namespace realtime {
 
+constexpr int Ticker::JITTER_HISTOGRAM_BUCKETS;
+
 Ticker::Ticker(s_t secondsPerTick)
-  : mRunning(false), mSecondsPerTick(secondsPerTick)
+  : mRunning(false),
+    mSecondsPerTick(secondsPerTick),
+    mMainThread(nullptr),
+    mCpuAffinity(-1),
+    mRealtimePriority(false),
+    mSpinNanos(0)
 {
+  resetStats();
 }
 
 Ticker::~Ticker()
@@ -41,6 +58,7 @@ void Ticker::stop()
   mRunning = false;
   mMainThread->join();
   delete mMainThread;
+  mMainThread = nullptr;
 }
 
 void Ticker::toggle()
@@ -56,21 +74,200 @@ bool Ticker::isRunning()
   return mRunning;
 }
 
+/// This pins the tick thread to a CPU core when it starts. -1 (the
+/// default) leaves it wherever the OS puts it. This only works on Linux,
+/// and must be called before start().
+void Ticker::setCpuAffinity(int core)
+{
+  mCpuAffinity = core;
+}
+
+/// This asks the OS to run the tick thread with SCHED_FIFO real-time
+/// priority when it starts. This usually needs elevated privileges, and
+/// we just print a warning if the OS refuses. This only works on Linux,
+/// and must be called before start().
+void Ticker::setRealtimePriority(bool enabled)
+{
+  mRealtimePriority = enabled;
+}
+
+/// The OS scheduler often wakes sleeping threads tens of microseconds
+/// late. This makes the tick thread sleep until this many nanoseconds
+/// before each deadline, and then spin for the rest, which trades CPU time
+/// for lower jitter. Defaults to 0 (no spinning).
+void Ticker::setSpinNanos(long nanos)
+{
+  mSpinNanos = nanos;
+}
+
+/// This returns how many ticks have run since the last resetStats()
+long Ticker::getNumTicks()
+{
+  return mNumTicks.load();
+}
+
+/// This returns how many ticks didn't finish before the next one was due,
+/// since the last resetStats()
+long Ticker::getNumDeadlineMisses()
+{
+  return mNumDeadlineMisses.load();
+}
+
+/// This returns how many ticks were skipped entirely, because listeners
+/// overran by more than a whole period, since the last resetStats()
+long Ticker::getNumSkippedTicks()
+{
+  return mNumSkippedTicks.load();
+}
+
+/// This returns the jitter histogram. See JITTER_HISTOGRAM_BUCKETS for
+/// what each bucket counts.
+std::vector<long> Ticker::getJitterHistogram()
+{
+  std::vector<long> histogram;
+  for (const std::atomic<long>& bucket : mJitterHistogram)
+  {
+    histogram.push_back(bucket.load());
+  }
+  return histogram;
+}
+
+/// This returns the worst wakeup jitter seen since the last resetStats()
+long Ticker::getMaxJitterNanos()
+{
+  return mMaxJitterNanos.load();
+}
+
+/// This returns the average wakeup jitter since the last resetStats()
+s_t Ticker::getMeanJitterNanos()
+{
+  long ticks = mNumTicks.load();
+  if (ticks == 0)
+    return 0;
+  return static_cast<s_t>(mTotalJitterNanos.load()) / ticks;
+}
+
+/// This zeroes all the timing statistics. It's safe to call while running.
+void Ticker::resetStats()
+{
+  mNumTicks = 0;
+  mNumDeadlineMisses = 0;
+  mNumSkippedTicks = 0;
+  mTotalJitterNanos = 0;
+  mMaxJitterNanos = 0;
+  for (std::atomic<long>& bucket : mJitterHistogram)
+  {
+    bucket = 0;
+  }
+}
+
+/// This applies mCpuAffinity and mRealtimePriority to the calling thread
+void Ticker::configureThread()
+{
+#ifdef __linux__
+  if (mCpuAffinity >= 0)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(mCpuAffinity, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+    {
+      std::cout << "Ticker couldn't pin its thread to core " << mCpuAffinity
+                << std::endl;
+    }
+  }
+  if (mRealtimePriority)
+  {
+    sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    {
+      std::cout << "Ticker couldn't get real-time priority (this usually "
+                   "needs root, or CAP_SYS_NICE)"
+                << std::endl;
+    }
+  }
+#else
+  if (mCpuAffinity >= 0 || mRealtimePriority)
+  {
+    std::cout << "Ticker only supports CPU affinity and real-time priority "
+                 "on Linux"
+              << std::endl;
+  }
+#endif
+}
+
+/// This records the timing of a single tick
+void Ticker::recordTick(long jitterNanos, bool missedDeadline)
+{
+  mNumTicks++;
+  if (missedDeadline)
+    mNumDeadlineMisses++;
+  mTotalJitterNanos += jitterNanos;
+  long max = mMaxJitterNanos.load();
+  while (jitterNanos > max
+         && !mMaxJitterNanos.compare_exchange_weak(max, jitterNanos))
+  {
+  }
+
+  int bucket = 0;
+  long micros = jitterNanos / 1000;
+  while (micros > 0 && bucket < JITTER_HISTOGRAM_BUCKETS - 1)
+  {
+    micros >>= 1;
+    bucket++;
+  }
+  mJitterHistogram[bucket]++;
+}
+
 void Ticker::mainLoop()
 {
+  configureThread();
+
+  typedef std::chrono::steady_clock Clock;
+  const std::chrono::nanoseconds period(
+      static_cast<long>(round(mSecondsPerTick * 1e9)));
+  const std::chrono::nanoseconds spin(mSpinNanos);
+  Clock::time_point deadline = Clock::now();
   while (mRunning)
   {
-    int interval = (int)round(mSecondsPerTick * 1000);
-    auto x = std::chrono::steady_clock::now()
-             + std::chrono::milliseconds(interval);
-    long millis = timeSinceEpochMillis();
+    Clock::time_point wokeAt = Clock::now();
+    long jitterNanos = std::max(
+        0L,
+        static_cast<long>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                wokeAt - deadline)
+                .count()));
 
+    long millis = timeSinceEpochMillis();
     for (auto listener : mListeners)
       listener(millis);
 
-    std::this_thread::sleep_until(x);
+    // Scheduling off the last deadline, rather than off now, is what keeps
+    // us from drifting
+    deadline += period;
+    Clock::time_point finishedAt = Clock::now();
+    bool missedDeadline = finishedAt > deadline;
+    recordTick(jitterNanos, missedDeadline);
+    if (missedDeadline)
+    {
+      // Skip any ticks we're already a whole period past, rather than firing
+      // them back to back
+      long behind = (finishedAt - deadline) / period;
+      if (behind > 0)
+      {
+        deadline += behind * period;
+        mNumSkippedTicks += behind;
+      }
+    }
+
+    std::this_thread::sleep_until(deadline - spin);
+    while (Clock::now() < deadline)
+    {
+      // spin
+    }
   }
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -1,6 +1,9 @@
 #ifndef DART_TICKER
 #define DART_TICKER
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <thread>
 #include <vector>
@@ -10,9 +13,27 @@
 namespace dart {
 namespace realtime {
 
+/// This calls its listeners once every `secondsPerTick`, on its own thread.
+///
+/// Ticks are scheduled on an absolute steady_clock grid (tick k is due at
+/// start + k * period, to the nanosecond), rather than by sleeping for one
+/// period after each tick, so time spent in listeners and late wakeups don't
+/// add up into drift. If listeners overrun so badly that whole periods go by,
+/// the missed ticks are skipped (and counted) instead of fired in a burst.
+///
+/// While running, the Ticker keeps a histogram of wakeup jitter (how late
+/// each tick actually started) and counts deadline misses (ticks whose
+/// listeners didn't finish before the next tick was due). These can be read
+/// from any thread at any time.
 class Ticker
 {
 public:
+  /// This is the number of buckets in the jitter histogram. Bucket 0 counts
+  /// ticks that started less than 1us late, bucket i counts ticks that
+  /// started between 2^(i-1) and 2^i us late, and the last bucket counts
+  /// everything later than that.
+  static constexpr int JITTER_HISTOGRAM_BUCKETS = 20;
+
   Ticker(s_t secondsPerTick);
   ~Ticker();
   void registerTickListener(std::function<void(long)> listener);
@@ -24,16 +45,75 @@ public:
   void toggle();
   bool isRunning();
 
+  /// This pins the tick thread to a CPU core when it starts. -1 (the
+  /// default) leaves it wherever the OS puts it. This only works on Linux,
+  /// and must be called before start().
+  void setCpuAffinity(int core);
+
+  /// This asks the OS to run the tick thread with SCHED_FIFO real-time
+  /// priority when it starts. This usually needs elevated privileges, and
+  /// we just print a warning if the OS refuses. This only works on Linux,
+  /// and must be called before start().
+  void setRealtimePriority(bool enabled);
+
+  /// The OS scheduler often wakes sleeping threads tens of microseconds
+  /// late. This makes the tick thread sleep until this many nanoseconds
+  /// before each deadline, and then spin for the rest, which trades CPU time
+  /// for lower jitter. Defaults to 0 (no spinning).
+  void setSpinNanos(long nanos);
+
+  /// This returns how many ticks have run since the last resetStats()
+  long getNumTicks();
+
+  /// This returns how many ticks didn't finish before the next one was due,
+  /// since the last resetStats()
+  long getNumDeadlineMisses();
+
+  /// This returns how many ticks were skipped entirely, because listeners
+  /// overran by more than a whole period, since the last resetStats()
+  long getNumSkippedTicks();
+
+  /// This returns the jitter histogram. See JITTER_HISTOGRAM_BUCKETS for
+  /// what each bucket counts.
+  std::vector<long> getJitterHistogram();
+
+  /// This returns the worst wakeup jitter seen since the last resetStats()
+  long getMaxJitterNanos();
+
+  /// This returns the average wakeup jitter since the last resetStats()
+  s_t getMeanJitterNanos();
+
+  /// This zeroes all the timing statistics. It's safe to call while running.
+  void resetStats();
+
 protected:
   void mainLoop();
-  bool mRunning;
+
+  /// This applies mCpuAffinity and mRealtimePriority to the calling thread
+  void configureThread();
+
+  /// This records the timing of a single tick
+  void recordTick(long jitterNanos, bool missedDeadline);
+
+  std::atomic<bool> mRunning;
 
   s_t mSecondsPerTick;
   std::thread* mMainThread;
   std::vector<std::function<void(long)>> mListeners;
+
+  int mCpuAffinity;
+  bool mRealtimePriority;
+  long mSpinNanos;
+
+  std::atomic<long> mNumTicks;
+  std::atomic<long> mNumDeadlineMisses;
+  std::atomic<long> mNumSkippedTicks;
+  std::atomic<long> mTotalJitterNanos;
+  std::atomic<long> mMaxJitterNanos;
+  std::array<std::atomic<long>, JITTER_HISTOGRAM_BUCKETS> mJitterHistogram;
 };
 
 } // namespace realtime
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,7 @@
 #include "dart/realtime/VectorLog.hpp"
 
+#include <algorithm>
+
 namespace dart {
 namespace realtime {
 
@@ -8,7 +10,11 @@ VectorObservation::VectorObservation(long time, Eigen::VectorXs value)
 {
 }
 
-VectorLog::VectorLog(int dim) : mDim(dim), mStartTime(0L)
+/// By default the log grows to hold everything it's given, until
+/// discardBefore() drops it. A non-zero `capacity` caps it at that many
+/// observations, dropping the oldest ones as new ones come in.
+VectorLog::VectorLog(int dim, int capacity)
+  : mDim(dim), mStartTime(0L), mObservations(dim, capacity)
 {
 }
 
@@ -17,7 +23,7 @@ void VectorLog::record(long time, Eigen::VectorXs val)
   if (mObservations.size() == 0)
     mStartTime = time;
   assert(val.size() == mDim);
-  mObservations.emplace_back(time, val);
+  mObservations.push(time, val);
 }
 
 // start = current - mInferenceHorizon
@@ -27,10 +33,16 @@ Eigen::MatrixXs VectorLog::getValues(long start, int steps, long millisPerStep)
 
   Eigen::VectorXs cursorValue = Eigen::VectorXs::Zero(mDim);
   int cursorStep = 0;
-  for (const VectorObservation& obs : mObservations)
+  // Observations at or before (start - millisPerStep) land before step 0, so
+  // only the last of them matters (it's the value we'd start the cursor at).
+  // Skip straight to it, instead of working through the whole history.
+  int first = std::max(
+      mObservations.countAtOrBefore(start - millisPerStep) - 1, 0);
+  for (int i = first; i < mObservations.size(); i++)
   {
+    long time = mObservations.time(i);
     int step = static_cast<int>(
-        ceil(static_cast<s_t>(obs.time - start) / millisPerStep));
+        ceil(static_cast<s_t>(time - start) / millisPerStep));
     if (step > steps - 1)
       break;
     if (step >= cursorStep)
@@ -42,13 +54,13 @@ Eigen::MatrixXs VectorLog::getValues(long start, int steps, long millisPerStep)
         cursorStep++;
       }
       // Set the current value to the current state
-      cursorValue = obs.value;
+      cursorValue = mObservations.col(i);
       observations.col(step) = cursorValue;
       assert(cursorStep == step);
     }
     else
     {
-      cursorValue = obs.value;
+      cursorValue = mObservations.col(i);
     }
   }
   // Sweep the last cursor value forward to the end of the block
@@ -64,36 +76,33 @@ Eigen::MatrixXs VectorLog::getValues(long start, int steps, long millisPerStep)
 // Assmue there are enough data prior to a particular time stamp
 Eigen::MatrixXs VectorLog::getRecentValuesBefore(long time, int steps)
 {
-  Eigen::MatrixXs observations = Eigen::MatrixXs::Zero(mDim,steps);
-  int cnt = 0;
-  for(int i=mObservations.size()-1;i>=0;i--)
-  {
-    if(mObservations[i].time<time)
-    {
-      cnt++;
-      observations.col(steps-cnt) = mObservations[i].value;
-      if(cnt >= steps)
-        break;
-    }
-  }
+  Eigen::MatrixXs observations = Eigen::MatrixXs::Zero(mDim, steps);
+  Eigen::Ref<const Eigen::MatrixXs> recent
+      = getRecentValuesBeforeView(time, steps);
+  observations.rightCols(recent.cols()) = recent;
   return observations;
 }
 
+/// This is a zero-copy version of getRecentValuesBefore(). It returns a
+/// view of the (up to) `steps` most recent values strictly before `time`,
+/// oldest first. Unlike getRecentValuesBefore(), this isn't padded with
+/// zeros out to `steps` columns if there isn't enough history. The view is
+/// invalidated by the next call to record() or discardBefore().
+Eigen::Ref<const Eigen::MatrixXs> VectorLog::getRecentValuesBeforeView(
+    long time, int steps) const
+{
+  int end = mObservations.countBefore(time);
+  int count = std::min(end, std::max(steps, 0));
+  return mObservations.block(end - count, count);
+}
+
 int VectorLog::availableStepsBefore(long time)
 {
-  if(time - mStartTime<0)
+  if (time - mStartTime < 0)
   {
     return -1;
   }
-  for(int i= mObservations.size();i>0;i--)
-  {
-    if(mObservations[i-1].time<time)
-    {
-      return i;
-    }
-  }
-  // Should not reach here just to make compiler happy
-  return 0;
+  return mObservations.countBefore(time);
 }
 
 long VectorLog::availableHistoryBefore(long time)
@@ -103,25 +112,8 @@ long VectorLog::availableHistoryBefore(long time)
 
 void VectorLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
-    return;
-
-  std::vector<VectorObservation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
-  {
-    newObservations.push_back(mObservations[i]);
-  }
-  mObservations = newObservations;
+  mObservations.popFront(mObservations.countBefore(time));
 }
 
 } // namespace realtime
-} // namespace dart
\ No newline at end of file
+} // namespace dart
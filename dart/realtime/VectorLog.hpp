@@ -6,6 +6,7 @@
 #include <Eigen/Dense>
 
 #include "dart/math/MathTypes.hpp"
+#include "dart/realtime/ColumnRing.hpp"
 
 namespace dart {
 namespace realtime {
@@ -18,10 +19,16 @@ struct VectorObservation
   VectorObservation(long time, Eigen::VectorXs value);
 };
 
+/// This is a log of timestamped vectors (sensor readings, or applied forces).
+/// The values live in a ColumnRing, so looking up a time (and discarding old
+/// values) doesn't scan the whole log.
 class VectorLog
 {
 public:
-  VectorLog(int dim);
+  /// By default the log grows to hold everything it's given, until
+  /// discardBefore() drops it. A non-zero `capacity` caps it at that many
+  /// observations, dropping the oldest ones as new ones come in.
+  VectorLog(int dim, int capacity = 0);
 
   void record(long time, Eigen::VectorXs val);
 
@@ -29,6 +36,14 @@ public:
 
   Eigen::MatrixXs getRecentValuesBefore(long time, int steps);
 
+  /// This is a zero-copy version of getRecentValuesBefore(). It returns a
+  /// view of the (up to) `steps` most recent values strictly before `time`,
+  /// oldest first. Unlike getRecentValuesBefore(), this isn't padded with
+  /// zeros out to `steps` columns if there isn't enough history. The view is
+  /// invalidated by the next call to record() or discardBefore().
+  Eigen::Ref<const Eigen::MatrixXs> getRecentValuesBeforeView(
+      long time, int steps) const;
+
   void discardBefore(long time);
 
   long availableHistoryBefore(long time);
@@ -38,7 +53,7 @@ public:
 protected:
   int mDim;
   long mStartTime;
-  std::vector<VectorObservation> mObservations;
+  ColumnRing mObservations;
 };
 
 } // namespace realtime
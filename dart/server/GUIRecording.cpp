@@ -1,10 +1,14 @@
 #include "dart/server/GUIRecording.hpp"
 
+#include <cassert>
+#include <cstdint>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
 
 #include "stdio.h"
+
+#include "dart/common/Console.hpp"
 // #include <google/protobuf/io/coded_stream.h>
 // #include <google/protobuf/io/zero_copy_stream_impl.h>
 
@@ -25,59 +29,102 @@ class TrajectoryRollout;
 namespace server {
 
 GUIRecording::GUIRecording()
+  : mStreamFile(nullptr), mStreamIndexFile(nullptr), mStreamEnd(0)
 {
 }
 
 GUIRecording::~GUIRecording()
 {
+  closeStream();
 }
 
 void GUIRecording::saveFrame()
 {
-  mFrames.push_back(flushJson());
+  std::string frame = flushJson();
+
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
+  if (mStreamFile != nullptr)
+  {
+    appendStreamedFrame(frame);
+  }
+  else
+  {
+    mFrames.push_back(frame);
+  }
 }
 
 int GUIRecording::getNumFrames()
 {
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
+  if (mStreamFile != nullptr)
+  {
+    return mFrameOffsets.size();
+  }
   return mFrames.size();
 }
 
 std::string GUIRecording::getFramesJson(int startFrame)
 {
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
   std::stringstream stream;
-  for (int i = startFrame; i < mFrames.size(); i++)
+  int numFrames = getNumFrames();
+  for (int i = startFrame; i < numFrames; i++)
   {
-    stream << mFrames[i];
+    stream << getFrameJson(i);
   }
   return stream.str();
 }
 
 std::string GUIRecording::getFrameJson(int frame)
 {
-  if (frame < 0 || frame >= mFrames.size())
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
+  if (frame < 0 || frame >= getNumFrames())
     return "";
+  if (mStreamFile != nullptr)
+    return readStreamedFrame(frame);
   return mFrames[frame];
 }
 
 void GUIRecording::writeFramesJson(const std::string& path, int startFrame)
 {
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
+  if (startFrame < 0)
+    startFrame = 0;
+  if (mStreamFile != nullptr && path == mStreamPath)
+  {
+    // Opening the stream file for writing would truncate it out from under us
+    if (startFrame == 0)
+    {
+      fflush(mStreamFile);
+      fflush(mStreamIndexFile);
+    }
+    else
+    {
+      dterr << "GUIRecording::writeFramesJson() can't write a partial "
+               "recording over the file it's streaming to, \""
+            << path << "\"" << std::endl;
+    }
+    return;
+  }
+
   std::cout << "Saving GUI Recording to file \"" << path << "\"..."
             << std::endl;
 
   FILE* file = fopen(path.c_str(), "wb");
-  if (startFrame < 0)
-    startFrame = 0;
-  for (int i = startFrame; i < mFrames.size(); i++)
+  int numFrames = getNumFrames();
+  for (int i = startFrame; i < numFrames; i++)
   {
     if (i % 50 == 0)
     {
-      std::cout << "> Writing frame " << i << "/" << mFrames.size()
-                << std::endl;
+      std::cout << "> Writing frame " << i << "/" << numFrames << std::endl;
     }
-    int size = mFrames[i].size();
+    // When streaming, this reads one frame at a time back off disk, so we
+    // never hold more than one frame in memory
+    std::string frame = getFrameJson(i);
+    int size = frame.size();
     assert(sizeof(int) == 4);
     fwrite(&size, 4, 1, file);
-    fwrite(mFrames[i].c_str(), mFrames[i].size(), 1, file);
+    fwrite(frame.c_str(), frame.size(), 1, file);
   }
   fclose(file);
 
@@ -89,12 +136,155 @@ void GUIRecording::writeFrameJson(const std::string& path, int frame)
 {
   std::ofstream jsonFile;
   jsonFile.open(path);
-  if (frame < 0 || frame >= mFrames.size())
-    jsonFile << "";
-  else
-    jsonFile << mFrames[frame];
+  jsonFile << getFrameJson(frame);
   jsonFile.close();
 }
 
+/// This switches the recording over to streaming frames to a file, instead of
+/// keeping them in memory. Frames are appended in the same size-prefixed
+/// format as writeFramesJson(), so the file can be opened by the web viewer
+/// directly, and the byte offset of each frame is appended to a
+/// `path + ".index"` file alongside it. Only the offsets stay in memory, and
+/// getFrameJson() seeks to read a single frame back. Any frames already
+/// recorded in memory are moved to the file first. If `append` is true and the
+/// file already exists, this picks up where that recording left off. Returns
+/// false if the file can't be opened.
+bool GUIRecording::streamToFile(const std::string& path, bool append)
+{
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
+  if (mStreamFile != nullptr)
+  {
+    dterr << "GUIRecording::streamToFile() called while already streaming to "
+             "\""
+          << mStreamPath << "\". Ignoring." << std::endl;
+    return false;
+  }
+
+  mFrameOffsets.clear();
+  mStreamEnd = 0;
+
+  FILE* file = append ? fopen(path.c_str(), "r+b") : nullptr;
+  if (file != nullptr)
+  {
+    // Walk the size headers to find every frame. This only reads 4 bytes per
+    // frame, and stops at a truncated last frame (for example if we crashed
+    // while writing it), which then gets overwritten.
+    fseek(file, 0, SEEK_END);
+    long end = ftell(file);
+    long cursor = 0;
+    while (cursor + 4 <= end)
+    {
+      int size = 0;
+      fseek(file, cursor, SEEK_SET);
+      if (fread(&size, 4, 1, file) != 1 || size < 0
+          || cursor + 4 + size > end)
+      {
+        break;
+      }
+      mFrameOffsets.push_back(cursor);
+      cursor += 4 + size;
+    }
+    mStreamEnd = cursor;
+  }
+  else
+  {
+    file = fopen(path.c_str(), "w+b");
+  }
+  if (file == nullptr)
+  {
+    dterr << "GUIRecording::streamToFile() couldn't open \"" << path << "\""
+          << std::endl;
+    return false;
+  }
+
+  // We rewrite the whole index, since it's small and may be stale
+  FILE* indexFile = fopen((path + ".index").c_str(), "wb");
+  if (indexFile == nullptr)
+  {
+    dterr << "GUIRecording::streamToFile() couldn't open \"" << path
+          << ".index\"" << std::endl;
+    fclose(file);
+    mFrameOffsets.clear();
+    return false;
+  }
+  for (long offset : mFrameOffsets)
+  {
+    int64_t offset64 = offset;
+    fwrite(&offset64, sizeof(int64_t), 1, indexFile);
+  }
+
+  mStreamFile = file;
+  mStreamIndexFile = indexFile;
+  mStreamPath = path;
+
+  // Move anything we've already recorded in memory over to the file
+  std::vector<std::string> frames;
+  frames.swap(mFrames);
+  for (std::string& frame : frames)
+  {
+    appendStreamedFrame(frame);
+  }
+  return true;
+}
+
+/// This returns true if frames are being streamed to a file
+bool GUIRecording::isStreaming()
+{
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
+  return mStreamFile != nullptr;
+}
+
+/// This flushes and closes the stream file, and goes back to recording in
+/// memory. Frames that were streamed stay in the file, and are dropped from
+/// this recording.
+void GUIRecording::closeStream()
+{
+  const std::lock_guard<std::recursive_mutex> lock(mStreamMutex);
+  if (mStreamFile == nullptr)
+    return;
+  fclose(mStreamFile);
+  fclose(mStreamIndexFile);
+  mStreamFile = nullptr;
+  mStreamIndexFile = nullptr;
+  mStreamPath = "";
+  mFrameOffsets.clear();
+  mStreamEnd = 0;
+}
+
+/// This appends a frame to the end of the stream file, and its offset to the
+/// index
+void GUIRecording::appendStreamedFrame(const std::string& frame)
+{
+  int size = frame.size();
+  assert(sizeof(int) == 4);
+  // Reads move the file cursor, so always seek back to the end
+  fseek(mStreamFile, mStreamEnd, SEEK_SET);
+  fwrite(&size, 4, 1, mStreamFile);
+  fwrite(frame.c_str(), frame.size(), 1, mStreamFile);
+
+  int64_t offset64 = mStreamEnd;
+  fwrite(&offset64, sizeof(int64_t), 1, mStreamIndexFile);
+
+  mFrameOffsets.push_back(mStreamEnd);
+  mStreamEnd += 4 + size;
+}
+
+/// This reads a single frame back out of the stream file
+std::string GUIRecording::readStreamedFrame(int frame)
+{
+  int size = 0;
+  fseek(mStreamFile, mFrameOffsets[frame], SEEK_SET);
+  if (fread(&size, 4, 1, mStreamFile) != 1)
+  {
+    return "";
+  }
+  std::string result(size, '\0');
+  if (size > 0 && fread(&result[0], size, 1, mStreamFile) != 1)
+  {
+    return "";
+  }
+  return result;
+}
+
 } // namespace server
 } // namespace dart
\ No newline at end of file
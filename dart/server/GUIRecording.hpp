@@ -2,6 +2,7 @@
 #define DART_GUI_RECORDING
 
 #include <condition_variable>
+#include <cstdio>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -52,8 +53,42 @@ public:
 
   void writeFrameJson(const std::string& path, int frame);
 
+  /// This switches the recording over to streaming frames to a file, instead
+  /// of keeping them in memory. Frames are appended in the same size-prefixed
+  /// format as writeFramesJson(), so the file can be opened by the web viewer
+  /// directly, and the byte offset of each frame is appended to a
+  /// `path + ".index"` file alongside it. Only the offsets stay in memory, and
+  /// getFrameJson() seeks to read a single frame back. Any frames already
+  /// recorded in memory are moved to the file first. If `append` is true and
+  /// the file already exists, this picks up where that recording left off.
+  /// Returns false if the file can't be opened.
+  bool streamToFile(const std::string& path, bool append = false);
+
+  /// This returns true if frames are being streamed to a file
+  bool isStreaming();
+
+  /// This flushes and closes the stream file, and goes back to recording in
+  /// memory. Frames that were streamed stay in the file, and are dropped
+  /// from this recording.
+  void closeStream();
+
 protected:
+  /// This appends a frame to the end of the stream file, and its offset to
+  /// the index
+  void appendStreamedFrame(const std::string& frame);
+
+  /// This reads a single frame back out of the stream file
+  std::string readStreamedFrame(int frame);
+
   std::vector<std::string> mFrames;
+
+  // Only used while streaming to a file
+  std::recursive_mutex mStreamMutex;
+  std::string mStreamPath;
+  FILE* mStreamFile;
+  FILE* mStreamIndexFile;
+  std::vector<long> mFrameOffsets;
+  long mStreamEnd;
 };
 
 } // namespace server
@@ -1,7 +1,11 @@
 #include "dart/server/GUIStateMachine.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 
 #include <assimp/scene.h>
@@ -29,7 +33,275 @@
 namespace dart {
 namespace server {
 
-GUIStateMachine::GUIStateMachine() : mMessagesQueued(0)
+namespace {
+
+/// This folds raw bytes into a 64 bit FNV-1a hash, which is plenty to tell GUI
+/// assets apart
+void hashBytes(uint64_t& hash, const void* data, std::size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+}
+
+/// This hashes a value as the float that gets sent over the wire, so hashes
+/// don't depend on the scalar type we were built with
+void hashFloat(uint64_t& hash, s_t value)
+{
+  float f = (float)(double)value;
+  hashBytes(hash, &f, sizeof(f));
+}
+
+void hashInt(uint64_t& hash, int value)
+{
+  int32_t i = value;
+  hashBytes(hash, &i, sizeof(i));
+}
+
+std::string hashToString(uint64_t hash)
+{
+  std::stringstream stream;
+  stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return stream.str();
+}
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+/// This hashes everything about a mesh's geometry that we send to the client
+std::string hashMeshGeometry(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3s>& vertexNormals,
+    const std::vector<Eigen::Vector3i>& faces,
+    const std::vector<Eigen::Vector2s>& uv)
+{
+  uint64_t hash = FNV_OFFSET_BASIS;
+  // Include the sizes, so different splits of the same numbers don't collide
+  hashInt(hash, vertices.size());
+  hashInt(hash, vertexNormals.size());
+  hashInt(hash, faces.size());
+  hashInt(hash, uv.size());
+  for (const Eigen::Vector3s& vertex : vertices)
+    for (int i = 0; i < 3; i++)
+      hashFloat(hash, vertex(i));
+  for (const Eigen::Vector3s& normal : vertexNormals)
+    for (int i = 0; i < 3; i++)
+      hashFloat(hash, normal(i));
+  for (const Eigen::Vector3i& face : faces)
+    for (int i = 0; i < 3; i++)
+      hashInt(hash, face(i));
+  for (const Eigen::Vector2s& coord : uv)
+    for (int i = 0; i < 2; i++)
+      hashFloat(hash, coord(i));
+  return hashToString(hash);
+}
+
+std::string hashString(const std::string& str)
+{
+  uint64_t hash = FNV_OFFSET_BASIS;
+  hashBytes(hash, str.data(), str.size());
+  return hashToString(hash);
+}
+
+/// This rounds a value to an integer multiple of `precision`. We clamp to half
+/// the int range, so that deltas between two quantized values can't overflow.
+int quantize(s_t value, s_t precision)
+{
+  const double limit = (double)((1 << 30) - 1);
+  double quantized = std::round((double)(value / precision));
+  return (int)std::max(-limit, std::min(limit, quantized));
+}
+
+/// This returns true if any coefficient differs by more than `epsilon`. With
+/// an epsilon of zero, this is the same as `a != b`.
+bool changedBeyond(
+    const Eigen::Ref<const Eigen::VectorXs>& a,
+    const Eigen::Ref<const Eigen::VectorXs>& b,
+    s_t epsilon)
+{
+  for (int i = 0; i < a.size(); i++)
+  {
+    s_t diff = a(i) - b(i);
+    if (diff > epsilon || diff < -epsilon)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// This is the key renderSkeleton() uses for a shape
+std::string getShapeName(
+    const std::string& prefix,
+    const dynamics::Skeleton* skel,
+    const dynamics::BodyNode* node,
+    int shapeIndex)
+{
+  std::stringstream shapeNameStream;
+  shapeNameStream << prefix << "_";
+  shapeNameStream << skel->getName();
+  shapeNameStream << "_";
+  shapeNameStream << node->getName();
+  shapeNameStream << "_";
+  shapeNameStream << shapeIndex;
+  return shapeNameStream.str();
+}
+
+/// This appends the geometry of an ASSIMP mesh to the given buffers, offsetting
+/// its face indices by the number of vertices already there
+void appendAssimpGeometry(
+    const aiMesh* m,
+    std::vector<Eigen::Vector3s>& vertices,
+    std::vector<Eigen::Vector3s>& vertexNormals,
+    std::vector<Eigen::Vector3i>& faces,
+    std::vector<Eigen::Vector2s>& uv)
+{
+  int offset = vertices.size();
+  for (int j = 0; j < m->mNumVertices; j++)
+  {
+    vertices.emplace_back(
+        m->mVertices[j][0], m->mVertices[j][1], m->mVertices[j][2]);
+    if (m->mNormals != nullptr)
+    {
+      vertexNormals.emplace_back(
+          m->mNormals[j][0], m->mNormals[j][1], m->mNormals[j][2]);
+    }
+    if (m->mNumUVComponents[0] >= 2)
+    {
+      uv.emplace_back(m->mTextureCoords[0][j][0], m->mTextureCoords[0][j][1]);
+    }
+  }
+  for (int k = 0; k < m->mNumFaces; k++)
+  {
+    assert(m->mFaces[k].mNumIndices == 3);
+    faces.emplace_back(
+        offset + m->mFaces[k].mIndices[0],
+        offset + m->mFaces[k].mIndices[1],
+        offset + m->mFaces[k].mIndices[2]);
+  }
+}
+
+/// This returns the SkeletonTemplateShape type code for a shape, or -1 if the
+/// web GUI can't draw it
+int getTemplateShapeType(dynamics::Shape* shape)
+{
+  if (shape->getType() == "BoxShape")
+    return 0;
+  if (shape->getType() == "SphereShape")
+    return 1;
+  if (shape->getType() == "EllipsoidShape"
+      && dynamic_cast<dynamics::EllipsoidShape*>(shape)->isSphere())
+    return 1;
+  if (shape->getType() == "CapsuleShape")
+    return 2;
+  if (shape->getType() == "MeshShape")
+    return 3;
+  return -1;
+}
+
+/// This picks the indices of `targetPoints` points that best preserve the shape
+/// of a curve, using Largest-Triangle-Three-Buckets. The first and last points
+/// are always kept.
+std::vector<int> decimateLTTB(
+    const std::vector<s_t>& xs, const std::vector<s_t>& ys, int targetPoints)
+{
+  int n = std::min(xs.size(), ys.size());
+  std::vector<int> indices;
+  if (targetPoints >= n || targetPoints < 3)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      indices.push_back(i);
+    }
+    return indices;
+  }
+
+  indices.reserve(targetPoints);
+  indices.push_back(0);
+  double bucketSize = (double)(n - 2) / (targetPoints - 2);
+  int last = 0;
+  for (int bucket = 0; bucket < targetPoints - 2; bucket++)
+  {
+    int start = (int)std::floor(bucket * bucketSize) + 1;
+    int end = std::min((int)std::floor((bucket + 1) * bucketSize) + 1, n - 1);
+    int nextEnd = std::min((int)std::floor((bucket + 2) * bucketSize) + 1, n);
+
+    // The third corner of the triangle is the average of the next bucket
+    s_t avgX = 0;
+    s_t avgY = 0;
+    for (int i = end; i < nextEnd; i++)
+    {
+      avgX += xs[i];
+      avgY += ys[i];
+    }
+    avgX /= (nextEnd - end);
+    avgY /= (nextEnd - end);
+
+    int best = start;
+    s_t bestArea = -1;
+    for (int i = start; i < end; i++)
+    {
+      s_t area = (xs[last] - avgX) * (ys[i] - ys[last])
+                 - (xs[last] - xs[i]) * (avgY - ys[last]);
+      if (area < 0)
+        area = -area;
+      if (area > bestArea)
+      {
+        bestArea = area;
+        best = i;
+      }
+    }
+    indices.push_back(best);
+    last = best;
+  }
+  indices.push_back(n - 1);
+  return indices;
+}
+
+/// This returns the shapes of a skeleton that renderSkeletonInstanced() draws,
+/// in the order they appear in a template
+std::vector<dynamics::ShapeNode*> getTemplateShapeNodes(
+    const dynamics::Skeleton* skel)
+{
+  std::vector<dynamics::ShapeNode*> shapeNodes;
+  for (int j = 0; j < skel->getNumBodyNodes(); j++)
+  {
+    const dynamics::BodyNode* node = skel->getBodyNode(j);
+    if (node == nullptr)
+      continue;
+    for (int k = 0; k < node->getNumShapeNodes(); k++)
+    {
+      dynamics::ShapeNode* shapeNode
+          = const_cast<dynamics::ShapeNode*>(node->getShapeNode(k));
+      if (!shapeNode->hasVisualAspect())
+        continue;
+      dynamics::Shape* shape = shapeNode->getShape().get();
+      if (shape == nullptr || getTemplateShapeType(shape) == -1)
+        continue;
+      const dynamics::VisualAspect* visual = shapeNode->getVisualAspect();
+      if (visual == nullptr || visual->isHidden())
+        continue;
+      shapeNodes.push_back(shapeNode);
+    }
+  }
+  return shapeNodes;
+}
+
+} // namespace
+
+GUIStateMachine::GUIStateMachine()
+  : mMessagesQueued(0),
+    mQuantizeTransforms(false),
+    mPositionPrecision(1e-4),
+    mRotationPrecision(1e-4),
+    mTransformKeyframePending(true),
+    mSentPositionPrecision(0),
+    mSentRotationPrecision(0),
+    mPositionEpsilon(0),
+    mRotationEpsilon(0),
+    mColorEpsilon(0)
 {
 }
 
@@ -48,14 +320,30 @@ std::string GUIStateMachine::getCurrentStateAsJson()
   {
     encodeCreateBox(list, pair.second);
   }
-  for (auto pair : mTextures)
+  // Each distinct texture and mesh asset only needs to go to the new client
+  // once, no matter how many keys share it
+  std::unordered_set<std::string> sentTextures;
+  for (auto& pair : mTextures)
+  {
+    encodeCreateTexture(
+        list, pair.second, sentTextures.insert(pair.second.hash).second);
+  }
+  for (auto& pair : mMeshAssets)
   {
-    encodeCreateTexture(list, pair.second);
+    encodeCreateMeshAsset(list, pair.second);
   }
-  for (auto pair : mMeshes)
+  for (auto& pair : mMeshes)
   {
     encodeCreateMesh(list, pair.second);
   }
+  for (auto& pair : mSkeletonTemplates)
+  {
+    encodeCreateSkeletonTemplate(list, pair.second);
+  }
+  for (auto& pair : mSkeletonInstances)
+  {
+    encodeSetSkeletonInstance(list, pair.second);
+  }
   for (auto pair : mSpheres)
   {
     encodeCreateSphere(list, pair.second);
@@ -93,7 +381,10 @@ std::string GUIStateMachine::getCurrentStateAsJson()
     encodeCreateRichPlot(list, pair.second);
     for (auto dataPair : pair.second.data)
     {
-      encodeSetRichPlotData(list, pair.second.key, dataPair.second);
+      encodeSetRichPlotData(
+          list,
+          pair.second.key,
+          decimateRichPlotData(pair.second, dataPair.second));
     }
   }
   for (auto key : mMouseInteractionEnabled)
@@ -109,15 +400,99 @@ std::string GUIStateMachine::flushJson()
 {
   const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
 
+  deltaEncodeTransforms(mCommandList);
   mCommandList.SerializeToString(&mCommandListOutputBuffer);
 
   // Reset
   mMessagesQueued = 0;
   mCommandList.Clear();
+  mPendingUpdates.clear();
 
   return mCommandListOutputBuffer;
 }
 
+/// This switches setObjectPosition() and setObjectRotation() over to sending
+/// batched SetObjectTransforms commands. Values are rounded to multiples of the
+/// given precisions, and each one is sent as the change since the last value
+/// sent for that object, which is much smaller on the wire than raw floats when
+/// streaming many skeletons. Clients must decode the stream in order, so this
+/// is meant for live streams rather than recordings that get scrubbed through.
+void GUIStateMachine::setQuantizeTransforms(
+    bool quantize, s_t positionPrecision, s_t rotationPrecision)
+{
+  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+
+  // Batches already queued keep the precision they were quantized with, and
+  // deltaEncodeTransforms() starts a keyframe when the precision changes
+  mQuantizeTransforms = quantize;
+  mPositionPrecision = positionPrecision;
+  mRotationPrecision = rotationPrecision;
+}
+
+/// This makes the next batch of quantized transforms a keyframe, which clients
+/// can decode without having seen any previous batches. Call this when a new
+/// client connects.
+void GUIStateMachine::resetTransformDeltas()
+{
+  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+
+  mTransformKeyframePending = true;
+}
+
+/// This sets how far a shape has to move, turn (in each euler angle) or change
+/// color before renderWorld() and renderSkeleton() send an update for it.
+/// Changes smaller than these accumulate until they cross the threshold. The
+/// defaults of 0 send every change.
+void GUIStateMachine::setUpdateThresholds(
+    s_t positionEpsilon, s_t rotationEpsilon, s_t colorEpsilon)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  mPositionEpsilon = positionEpsilon;
+  mRotationEpsilon = rotationEpsilon;
+  mColorEpsilon = colorEpsilon;
+}
+
+/// This marks an object as static. renderWorld() and renderSkeleton() still
+/// create it, but never send updates for it afterwards, which saves
+/// re-checking (and re-sending) geometry like the ground every frame.
+void GUIStateMachine::setObjectStatic(const std::string& key, bool isStatic)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  if (isStatic)
+    mStaticObjects.insert(key);
+  else
+    mStaticObjects.erase(key);
+}
+
+/// This marks every shape in a skeleton, as named by renderSkeleton() with the
+/// same prefix, as static. See setObjectStatic().
+void GUIStateMachine::setSkeletonStatic(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const std::string& prefix,
+    bool isStatic)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  for (int j = 0; j < skel->getNumBodyNodes(); j++)
+  {
+    dynamics::BodyNode* node = skel->getBodyNode(j);
+    for (int k = 0; k < node->getNumShapeNodes(); k++)
+    {
+      setObjectStatic(getShapeName(prefix, skel.get(), node, k), isStatic);
+    }
+  }
+}
+
+/// This returns true if an object has been marked static
+bool GUIStateMachine::isObjectStatic(const std::string& key)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  return mStaticObjects.count(key) > 0;
+}
+
 /// This is a high-level command that creates/updates all the shapes in a
 /// world by calling the lower-level commands
 void GUIStateMachine::renderWorld(
@@ -136,7 +511,22 @@ void GUIStateMachine::renderWorld(
   }
 
   const collision::CollisionResult& result = world->getLastCollisionResult();
-  deleteObjectsByPrefix(prefix + "__contact_");
+  // Contact lines are re-rendered every frame, but usually don't change, so
+  // only send the ones that did, and delete the ones we don't need any more
+  std::string contactPrefix = prefix + "__contact_";
+  std::unordered_set<std::string> contactLines;
+  auto renderContactLine = [&](const std::string& key,
+                               const std::vector<Eigen::Vector3s>& points,
+                               const Eigen::Vector4s& color) {
+    contactLines.insert(key);
+    auto it = mLines.find(key);
+    if (it != mLines.end() && it->second.points == points
+        && it->second.color == color && it->second.layer == layer)
+    {
+      return;
+    }
+    createLine(key, points, color, layer);
+  };
   if (renderForces)
   {
     for (int i = 0; i < result.getNumContacts(); i++)
@@ -146,21 +536,32 @@ void GUIStateMachine::renderWorld(
       std::vector<Eigen::Vector3s> points;
       points.push_back(contact.point);
       points.push_back(contact.point + (contact.normal * scale));
-      createLine(
-          prefix + "__contact_" + std::to_string(i) + "_a",
+      renderContactLine(
+          contactPrefix + std::to_string(i) + "_a",
           points,
-          Eigen::Vector4s(1.0, 0.5, 0.5, 1.0),
-          layer);
+          Eigen::Vector4s(1.0, 0.5, 0.5, 1.0));
       std::vector<Eigen::Vector3s> pointsB;
       pointsB.push_back(contact.point);
       pointsB.push_back(contact.point - (contact.normal * scale));
-      createLine(
-          prefix + "__contact_" + std::to_string(i) + "_b",
+      renderContactLine(
+          contactPrefix + std::to_string(i) + "_b",
           pointsB,
-          Eigen::Vector4s(0, 1, 0, 1.0),
-          layer);
+          Eigen::Vector4s(0, 1, 0, 1.0));
+    }
+  }
+  std::vector<std::string> staleLines;
+  for (auto& pair : mLines)
+  {
+    if (pair.first.compare(0, contactPrefix.size(), contactPrefix) == 0
+        && contactLines.count(pair.first) == 0)
+    {
+      staleLines.push_back(pair.first);
     }
   }
+  for (std::string& key : staleLines)
+  {
+    deleteObject(key);
+  }
 }
 
 /// This is a high-level command that creates a basis
@@ -212,11 +613,30 @@ void GUIStateMachine::renderSkeleton(
     const std::string& prefix,
     Eigen::Vector4s overrideColor,
     const std::string& layer)
+{
+  // Compute every shape's world transform in one pass down the tree, instead
+  // of asking each ShapeNode for its own
+  std::vector<const dynamics::ShapeNode*> shapeNodes;
+  common::aligned_vector<Eigen::Isometry3s> shapeTransforms;
+  skel->getShapeNodeWorldTransforms(shapeNodes, shapeTransforms);
+  renderSkeletonShapes(skel, prefix, overrideColor, layer, shapeTransforms);
+}
+
+/// This does the work of renderSkeleton(), with the world transform of every
+/// ShapeNode already worked out
+void GUIStateMachine::renderSkeletonShapes(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const std::string& prefix,
+    const Eigen::Vector4s& overrideColor,
+    const std::string& layer,
+    const common::aligned_vector<Eigen::Isometry3s>& shapeTransforms)
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
   bool useOriginalColor = overrideColor == -1 * Eigen::Vector4s::Ones();
 
+  std::size_t shapeIndex = 0;
+
   for (int j = 0; j < skel->getNumBodyNodes(); j++)
   {
     dynamics::BodyNode* node = skel->getBodyNode(j);
@@ -232,15 +652,10 @@ void GUIStateMachine::renderSkeleton(
     {
       dynamics::ShapeNode* shapeNode = node->getShapeNode(k);
       dynamics::Shape* shape = shapeNode->getShape().get();
+      assert(shapeIndex < shapeTransforms.size());
+      const Eigen::Isometry3s& T = shapeTransforms[shapeIndex++];
 
-      std::stringstream shapeNameStream;
-      shapeNameStream << prefix << "_";
-      shapeNameStream << skel->getName();
-      shapeNameStream << "_";
-      shapeNameStream << node->getName();
-      shapeNameStream << "_";
-      shapeNameStream << k;
-      std::string shapeName = shapeNameStream.str();
+      std::string shapeName = getShapeName(prefix, skel.get(), node, k);
 
       if (!shapeNode->hasVisualAspect())
         continue;
@@ -270,8 +685,8 @@ void GUIStateMachine::renderSkeleton(
             createBox(
                 shapeName,
                 boxShape->getSize(),
-                shapeNode->getWorldTransform().translation(),
-                math::matrixToEulerXYZ(shapeNode->getWorldTransform().linear()),
+                T.translation(),
+                math::matrixToEulerXYZ(T.linear()),
                 useOriginalColor ? visual->getRGBA() : overrideColor,
                 layer,
                 visual->getCastShadows(),
@@ -285,8 +700,8 @@ void GUIStateMachine::renderSkeleton(
                 shapeName,
                 meshShape->getMesh(),
                 meshShape->getMeshPath(),
-                shapeNode->getWorldTransform().translation(),
-                math::matrixToEulerXYZ(shapeNode->getWorldTransform().linear()),
+                T.translation(),
+                math::matrixToEulerXYZ(T.linear()),
                 meshShape->getScale(),
                 useOriginalColor ? visual->getRGBA() : overrideColor,
                 layer,
@@ -300,7 +715,7 @@ void GUIStateMachine::renderSkeleton(
             createSphere(
                 shapeName,
                 sphereShape->getRadius(),
-                shapeNode->getWorldTransform().translation(),
+                T.translation(),
                 useOriginalColor ? visual->getRGBA() : overrideColor,
                 layer,
                 visual->getCastShadows(),
@@ -314,8 +729,8 @@ void GUIStateMachine::renderSkeleton(
                 shapeName,
                 capsuleShape->getRadius(),
                 capsuleShape->getHeight(),
-                shapeNode->getWorldTransform().translation(),
-                math::matrixToEulerXYZ(shapeNode->getWorldTransform().linear()),
+                T.translation(),
+                math::matrixToEulerXYZ(T.linear()),
                 useOriginalColor ? visual->getRGBA() : overrideColor,
                 layer,
                 visual->getCastShadows(),
@@ -330,7 +745,7 @@ void GUIStateMachine::renderSkeleton(
             createSphere(
                 shapeName,
                 sphereShape->getRadii()[0],
-                shapeNode->getWorldTransform().translation(),
+                T.translation(),
                 useOriginalColor ? visual->getRGBA() : overrideColor,
                 layer,
                 visual->getCastShadows(),
@@ -350,7 +765,7 @@ void GUIStateMachine::renderSkeleton(
           setObjectTooltip(shapeName, node->getName());
         }
       }
-      else
+      else if (mStaticObjects.count(shapeName) == 0)
       {
         // Otherwise, we just need to send updates for anything that changed
         if (visual->isHidden())
@@ -359,9 +774,9 @@ void GUIStateMachine::renderSkeleton(
         }
         else
         {
-          Eigen::Vector3s pos = shapeNode->getWorldTransform().translation();
+          Eigen::Vector3s pos = T.translation();
           Eigen::Vector3s euler
-              = math::matrixToEulerXYZ(shapeNode->getWorldTransform().linear());
+              = math::matrixToEulerXYZ(T.linear());
           Eigen::Vector4s color
               = useOriginalColor ? visual->getRGBA() : overrideColor;
           // std::cout << "Color " << shapeName << ":" << color << std::endl;
@@ -404,11 +819,13 @@ void GUIStateMachine::renderSkeleton(
 
           if (getObjectScale(shapeName) != scale)
             setObjectScale(shapeName, scale);
-          if (getObjectPosition(shapeName) != pos)
+          if (changedBeyond(
+                  getObjectPosition(shapeName), pos, mPositionEpsilon))
             setObjectPosition(shapeName, pos);
-          if (getObjectRotation(shapeName) != euler)
+          if (changedBeyond(
+                  getObjectRotation(shapeName), euler, mRotationEpsilon))
             setObjectRotation(shapeName, euler);
-          if (getObjectColor(shapeName) != color)
+          if (changedBeyond(getObjectColor(shapeName), color, mColorEpsilon))
             setObjectColor(shapeName, color);
         }
       }
@@ -416,6 +833,114 @@ void GUIStateMachine::renderSkeleton(
   }
 }
 
+/// This is a high-level command like renderSkeleton(), for drawing many copies
+/// of identical skeletons, which share geometry and are drawn with instancing
+void GUIStateMachine::renderSkeletonInstanced(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const std::string& templateKey,
+    const std::string& instanceKey,
+    Eigen::Vector4s overrideColor,
+    const std::string& layer)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  skel->applyDeferredScales();
+
+  if (mSkeletonTemplates.find(templateKey) == mSkeletonTemplates.end())
+  {
+    createSkeletonTemplate(skel, templateKey, layer);
+  }
+  const SkeletonTemplate& skeletonTemplate = mSkeletonTemplates[templateKey];
+
+  std::vector<dynamics::ShapeNode*> shapeNodes
+      = getTemplateShapeNodes(skel.get());
+  if (shapeNodes.size() != skeletonTemplate.shapes.size())
+  {
+    dterr << "[GUIStateMachine.renderSkeletonInstanced()] Skeleton \""
+          << skel->getName() << "\" has " << shapeNodes.size()
+          << " visible shapes, but the template \"" << templateKey
+          << "\" has " << skeletonTemplate.shapes.size()
+          << ". Every skeleton rendered with the same template must have the "
+             "same shapes. Ignoring this update.\n";
+    return;
+  }
+
+  // The template's shapes are a subset of all the ShapeNodes, in the same
+  // order, so we can pick their transforms out of one pass down the tree
+  std::vector<const dynamics::ShapeNode*> allShapeNodes;
+  common::aligned_vector<Eigen::Isometry3s> allTransforms;
+  skel->getShapeNodeWorldTransforms(allShapeNodes, allTransforms);
+
+  Eigen::VectorXs transforms = Eigen::VectorXs::Zero(shapeNodes.size() * 6);
+  std::size_t cursor = 0;
+  for (int i = 0; i < shapeNodes.size(); i++)
+  {
+    while (allShapeNodes[cursor] != shapeNodes[i])
+      cursor++;
+    const Eigen::Isometry3s& T = allTransforms[cursor];
+    transforms.segment<3>(i * 6) = T.translation();
+    transforms.segment<3>(i * 6 + 3) = math::matrixToEulerXYZ(T.linear());
+  }
+
+  auto existing = mSkeletonInstances.find(instanceKey);
+  if (existing != mSkeletonInstances.end()
+      && existing->second.templateKey == templateKey
+      && !changedBeyond(existing->second.color, overrideColor, mColorEpsilon))
+  {
+    bool changed = false;
+    for (int i = 0; i < shapeNodes.size() && !changed; i++)
+    {
+      changed = changedBeyond(
+                    existing->second.transforms.segment<3>(i * 6),
+                    transforms.segment<3>(i * 6),
+                    mPositionEpsilon)
+                || changedBeyond(
+                    existing->second.transforms.segment<3>(i * 6 + 3),
+                    transforms.segment<3>(i * 6 + 3),
+                    mRotationEpsilon);
+    }
+    if (!changed)
+      return;
+  }
+
+  SkeletonInstance& instance = mSkeletonInstances[instanceKey];
+  instance.key = instanceKey;
+  instance.templateKey = templateKey;
+  instance.transforms = transforms;
+  instance.color = overrideColor;
+
+  queueCommand([this, instanceKey](proto::CommandList& list) {
+    SkeletonInstance& instance = mSkeletonInstances[instanceKey];
+    // If we've already queued an update for this copy since the last flush,
+    // and it's still the same shape, just overwrite it
+    int& pendingCommand = mPendingUpdates[instanceKey].instanceCommand;
+    if (pendingCommand != -1)
+    {
+      proto::SetSkeletonInstance* command
+          = list.mutable_command(pendingCommand)->mutable_skeleton_instance();
+      if (command->template_key() == getStringCode(instance.templateKey)
+          && command->transform_size() == instance.transforms.size())
+      {
+        for (int i = 0; i < instance.transforms.size(); i++)
+        {
+          command->set_transform(i, instance.transforms(i));
+        }
+        command->clear_color();
+        if (instance.color != -1 * Eigen::Vector4s::Ones())
+        {
+          for (int i = 0; i < 4; i++)
+          {
+            command->add_color(instance.color(i));
+          }
+        }
+        return;
+      }
+    }
+    encodeSetSkeletonInstance(list, instance);
+    pendingCommand = list.command_size() - 1;
+  });
+}
+
 /// This is a high-level command that renders a given trajectory as a bunch of
 /// lines in the world, one per body
 void GUIStateMachine::renderTrajectoryLines(
@@ -557,6 +1082,7 @@ void GUIStateMachine::clear()
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
   queueCommand([&](proto::CommandList& list) {
+    mPendingUpdates.clear();
     proto::Command* command = list.add_command();
     command->mutable_clear_all()->set_dummy(true);
   });
@@ -566,6 +1092,10 @@ void GUIStateMachine::clear()
   mCapsules.clear();
   mLines.clear();
   mMeshes.clear();
+  mMeshAssets.clear();
+  mSentMeshAssets.clear();
+  mSkeletonTemplates.clear();
+  mSkeletonInstances.clear();
   mText.clear();
   mButtons.clear();
   mSliders.clear();
@@ -622,6 +1152,7 @@ void GUIStateMachine::createBox(
   box.receiveShadows = receiveShadows;
 
   queueCommand([this, key](proto::CommandList& list) {
+    mPendingUpdates.erase(key);
     encodeCreateBox(list, mBoxes[key]);
   });
 }
@@ -648,6 +1179,7 @@ void GUIStateMachine::createSphere(
   sphere.receiveShadows = receiveShadows;
 
   queueCommand([this, key](proto::CommandList& list) {
+    mPendingUpdates.erase(key);
     encodeCreateSphere(list, mSpheres[key]);
   });
 }
@@ -678,6 +1210,7 @@ void GUIStateMachine::createCapsule(
   capsule.receiveShadows = receiveShadows;
 
   queueCommand([this, key](proto::CommandList& list) {
+    mPendingUpdates.erase(key);
     encodeCreateCapsule(list, mCapsules[key]);
   });
 }
@@ -698,6 +1231,7 @@ void GUIStateMachine::createLine(
   line.layer = layer;
 
   queueCommand([this, key](proto::CommandList& list) {
+    mPendingUpdates.erase(key);
     encodeCreateLine(list, mLines[key]);
   });
 }
@@ -722,12 +1256,18 @@ void GUIStateMachine::createMesh(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  std::string hash = retainMeshAsset(vertices, vertexNormals, faces, uv);
+
+  // If we're replacing an existing mesh, let go of its old geometry
+  auto meshIt = mMeshes.find(key);
+  if (meshIt != mMeshes.end())
+  {
+    releaseMeshAsset(meshIt->second.asset);
+  }
+
   Mesh& mesh = mMeshes[key];
   mesh.key = key;
-  mesh.vertices = vertices;
-  mesh.vertexNormals = vertexNormals;
-  mesh.faces = faces;
-  mesh.uv = uv;
+  mesh.asset = hash;
   mesh.textures = textures;
   mesh.textureStartIndices = textureStartIndices;
   mesh.pos = pos;
@@ -739,7 +1279,13 @@ void GUIStateMachine::createMesh(
   mesh.receiveShadows = receiveShadows;
 
   queueCommand([this, key](proto::CommandList& list) {
-    encodeCreateMesh(list, mMeshes[key]);
+    mPendingUpdates.erase(key);
+    Mesh& mesh = mMeshes[key];
+    if (mSentMeshAssets.insert(mesh.asset).second)
+    {
+      encodeCreateMeshAsset(list, mMeshAssets[mesh.asset]);
+    }
+    encodeCreateMesh(list, mesh);
   });
 }
 
@@ -799,33 +1345,7 @@ void GUIStateMachine::createMeshASSIMP(
       }
     }
 
-    for (int j = 0; j < m->mNumVertices; j++)
-    {
-      vertices.emplace_back(
-          m->mVertices[j][0], m->mVertices[j][1], m->mVertices[j][2]);
-      if (m->mNormals != nullptr)
-      {
-        vertexNormals.emplace_back(
-            m->mNormals[j][0], m->mNormals[j][1], m->mNormals[j][2]);
-      }
-      if (m->mNumUVComponents[0] >= 2)
-      {
-        uv.emplace_back(m->mTextureCoords[0][j][0], m->mTextureCoords[0][j][1]);
-      }
-      /*
-      if (m->mNumUVComponents[0] == 2 && m->mTextureCoords[0][j][0])
-      {
-      }
-      */
-    }
-    for (int k = 0; k < m->mNumFaces; k++)
-    {
-      assert(m->mFaces[k].mNumIndices == 3);
-      faces.emplace_back(
-          m->mFaces[k].mIndices[0],
-          m->mFaces[k].mIndices[1],
-          m->mFaces[k].mIndices[2]);
-    }
+    appendAssimpGeometry(m, vertices, vertexNormals, faces, uv);
   }
 
   createMesh(
@@ -878,11 +1398,14 @@ void GUIStateMachine::createTexture(
   Texture tex;
   tex.key = key;
   tex.base64 = base64;
+  tex.hash = hashString(base64);
 
   mTextures[key] = tex;
 
   queueCommand([this, key](proto::CommandList& list) {
-    encodeCreateTexture(list, mTextures[key]);
+    Texture& texture = mTextures[key];
+    encodeCreateTexture(
+        list, texture, mSentTextureHashes.insert(texture.hash).second);
   });
 }
 
@@ -917,6 +1440,8 @@ bool GUIStateMachine::hasObject(const std::string& key)
     return true;
   if (mMeshes.find(key) != mMeshes.end())
     return true;
+  if (mSkeletonInstances.find(key) != mSkeletonInstances.end())
+    return true;
   return false;
 }
 
@@ -1010,11 +1535,7 @@ void GUIStateMachine::setObjectPosition(
   }
 
   queueCommand([&](proto::CommandList& list) {
-    proto::Command* command = list.add_command();
-    command->mutable_set_object_position()->set_key(getStringCode(key));
-    command->mutable_set_object_position()->add_data(pos(0));
-    command->mutable_set_object_position()->add_data(pos(1));
-    command->mutable_set_object_position()->add_data(pos(2));
+    encodeTransform(list, key, pos, true);
   });
 }
 
@@ -1038,11 +1559,7 @@ void GUIStateMachine::setObjectRotation(
   }
 
   queueCommand([&](proto::CommandList& list) {
-    proto::Command* command = list.add_command();
-    command->mutable_set_object_rotation()->set_key(getStringCode(key));
-    command->mutable_set_object_rotation()->add_data(euler(0));
-    command->mutable_set_object_rotation()->add_data(euler(1));
-    command->mutable_set_object_rotation()->add_data(euler(2));
+    encodeTransform(list, key, euler, false);
   });
 }
 
@@ -1074,6 +1591,23 @@ void GUIStateMachine::setObjectColor(
   }
 
   queueCommand([&](proto::CommandList& list) {
+    // If we've already queued a color for this object since the last flush,
+    // just overwrite it
+    int& pendingCommand = mPendingUpdates[key].colorCommand;
+    if (pendingCommand != -1)
+    {
+      google::protobuf::RepeatedField<float>* data
+          = list.mutable_command(pendingCommand)
+                ->mutable_set_object_color()
+                ->mutable_data();
+      for (int i = 0; i < 4; i++)
+      {
+        data->Set(i, color(i));
+      }
+      return;
+    }
+    pendingCommand = list.command_size();
+
     proto::Command* command = list.add_command();
     command->mutable_set_object_color()->set_key(getStringCode(key));
     command->mutable_set_object_color()->add_data(color(0));
@@ -1104,6 +1638,23 @@ void GUIStateMachine::setObjectScale(
   }
 
   queueCommand([&](proto::CommandList& list) {
+    // If we've already queued a scale for this object since the last flush,
+    // just overwrite it
+    int& pendingCommand = mPendingUpdates[key].scaleCommand;
+    if (pendingCommand != -1)
+    {
+      google::protobuf::RepeatedField<float>* data
+          = list.mutable_command(pendingCommand)
+                ->mutable_set_object_scale()
+                ->mutable_data();
+      for (int i = 0; i < 3; i++)
+      {
+        data->Set(i, scale(i));
+      }
+      return;
+    }
+    pendingCommand = list.command_size();
+
     proto::Command* command = list.add_command();
     command->mutable_set_object_scale()->set_key(getStringCode(key));
     command->mutable_set_object_scale()->add_data(scale(0));
@@ -1164,11 +1715,18 @@ void GUIStateMachine::deleteObject(const std::string& key)
   mBoxes.erase(key);
   mSpheres.erase(key);
   mLines.erase(key);
-  mMeshes.erase(key);
+  auto meshIt = mMeshes.find(key);
+  if (meshIt != mMeshes.end())
+  {
+    releaseMeshAsset(meshIt->second.asset);
+    mMeshes.erase(meshIt);
+  }
   mCapsules.erase(key);
+  mSkeletonInstances.erase(key);
   mTooltips.erase(key);
 
   queueCommand([&](proto::CommandList& list) {
+    mPendingUpdates.erase(key);
     proto::Command* command = list.add_command();
     command->mutable_delete_object()->set_key(getStringCode(key));
   });
@@ -1611,6 +2169,69 @@ void GUIStateMachine::setRichPlotData(
   }
 }
 
+/// This appends points to a data stream for a rich plot, and only sends the
+/// new points to the client, until the client's copy gets more than twice as
+/// long as the plot is wide. Then we send a fresh decimated copy instead.
+void GUIStateMachine::appendRichPlotData(
+    const std::string& key,
+    const std::string& name,
+    const std::string& color,
+    const std::string& type,
+    const std::vector<s_t>& xs,
+    const std::vector<s_t>& ys)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  if (mRichPlots.find(key) == mRichPlots.end())
+  {
+    std::cout << "Tried to appendRichPlotData() for a key (" << key
+              << ") that doesn't exist as a RichPlot object. Call "
+                 "createRichPlot() first."
+              << std::endl;
+    return;
+  }
+
+  RichPlot& plot = mRichPlots[key];
+  bool isNew = plot.data.find(name) == plot.data.end();
+  RichPlotData& data = plot.data[name];
+  if (isNew || !data.streamed)
+  {
+    data.name = name;
+    data.color = color;
+    data.type = type;
+    data.streamed = true;
+    data.sentPoints = 0;
+    isNew = true;
+  }
+  int numPoints = std::min(xs.size(), ys.size());
+  data.xs.insert(data.xs.end(), xs.begin(), xs.begin() + numPoints);
+  data.ys.insert(data.ys.end(), ys.begin(), ys.begin() + numPoints);
+
+  int targetPoints = std::max(plot.size(0), 3);
+  if (isNew || data.sentPoints + numPoints > 2 * targetPoints)
+  {
+    RichPlotData decimated = decimateRichPlotData(plot, data);
+    data.sentPoints = decimated.xs.size();
+    queueCommand([this, key, decimated](proto::CommandList& list) {
+      encodeSetRichPlotData(list, key, decimated);
+    });
+  }
+  else
+  {
+    data.sentPoints += numPoints;
+    queueCommand([&](proto::CommandList& list) {
+      proto::Command* command = list.add_command();
+      command->mutable_append_rich_plot_data()->set_key(getStringCode(key));
+      command->mutable_append_rich_plot_data()->set_name(name);
+      for (int i = 0; i < numPoints; i++)
+      {
+        command->mutable_append_rich_plot_data()->add_xs(xs[i]);
+        command->mutable_append_rich_plot_data()->add_ys(ys[i]);
+      }
+    });
+  }
+}
+
 /// This sets the plot bounds for a rich plot object
 void GUIStateMachine::setRichPlotBounds(
     const std::string& key, s_t minX, s_t maxX, s_t minY, s_t maxY)
@@ -1759,6 +2380,200 @@ void GUIStateMachine::queueCommand(
   mMessagesQueued++;
 }
 
+/// This queues a position or rotation for an object. If we've already queued
+/// one since the last flush, this just overwrites it with the new value, so
+/// objects that get updated many times between flushes cost one update.
+void GUIStateMachine::encodeTransform(
+    proto::CommandList& list,
+    const std::string& key,
+    const Eigen::Vector3s& value,
+    bool isPosition)
+{
+  PendingUpdate& pending = mPendingUpdates[key];
+  int& pendingCommand
+      = isPosition ? pending.positionCommand : pending.rotationCommand;
+  int& pendingEntry
+      = isPosition ? pending.positionEntry : pending.rotationEntry;
+
+  if (pendingCommand != -1)
+  {
+    proto::Command* command = list.mutable_command(pendingCommand);
+    if (command->has_set_object_transforms())
+    {
+      proto::SetObjectTransforms* batch
+          = command->mutable_set_object_transforms();
+      for (int i = 0; i < 3; i++)
+      {
+        if (isPosition)
+        {
+          batch->set_position(
+              pendingEntry * 3 + i,
+              quantize(value(i), batch->position_precision()));
+        }
+        else
+        {
+          batch->set_rotation(
+              pendingEntry * 3 + i,
+              quantize(value(i), batch->rotation_precision()));
+        }
+      }
+    }
+    else
+    {
+      google::protobuf::RepeatedField<float>* data
+          = isPosition ? command->mutable_set_object_position()->mutable_data()
+                       : command->mutable_set_object_rotation()->mutable_data();
+      for (int i = 0; i < 3; i++)
+      {
+        data->Set(i, value(i));
+      }
+    }
+    return;
+  }
+
+  if (mQuantizeTransforms)
+  {
+    pendingEntry = encodeQuantizedTransform(
+        list, getStringCode(key), value, isPosition);
+  }
+  else if (isPosition)
+  {
+    proto::Command* command = list.add_command();
+    command->mutable_set_object_position()->set_key(getStringCode(key));
+    command->mutable_set_object_position()->add_data(value(0));
+    command->mutable_set_object_position()->add_data(value(1));
+    command->mutable_set_object_position()->add_data(value(2));
+  }
+  else
+  {
+    proto::Command* command = list.add_command();
+    command->mutable_set_object_rotation()->set_key(getStringCode(key));
+    command->mutable_set_object_rotation()->add_data(value(0));
+    command->mutable_set_object_rotation()->add_data(value(1));
+    command->mutable_set_object_rotation()->add_data(value(2));
+  }
+  pendingCommand = list.command_size() - 1;
+}
+
+/// This appends a quantized position or rotation to the SetObjectTransforms
+/// batch at the end of the list, starting a new batch if the last command is
+/// something else. Values are stored as absolute quantized numbers here, and
+/// get delta encoded by deltaEncodeTransforms() when we flush. This returns
+/// the index of the new entry within the batch.
+int GUIStateMachine::encodeQuantizedTransform(
+    proto::CommandList& list,
+    int key,
+    const Eigen::Vector3s& value,
+    bool isPosition)
+{
+  proto::SetObjectTransforms* batch = nullptr;
+  int numCommands = list.command_size();
+  if (numCommands > 0
+      && list.command(numCommands - 1).has_set_object_transforms())
+  {
+    proto::SetObjectTransforms* last = list.mutable_command(numCommands - 1)
+                                           ->mutable_set_object_transforms();
+    if (last->position_precision() == (float)mPositionPrecision
+        && last->rotation_precision() == (float)mRotationPrecision)
+    {
+      batch = last;
+    }
+  }
+  if (batch == nullptr)
+  {
+    batch = list.add_command()->mutable_set_object_transforms();
+    batch->set_position_precision((float)mPositionPrecision);
+    batch->set_rotation_precision((float)mRotationPrecision);
+  }
+
+  s_t precision = isPosition ? mPositionPrecision : mRotationPrecision;
+  for (int i = 0; i < 3; i++)
+  {
+    if (isPosition)
+    {
+      batch->add_position(quantize(value(i), precision));
+    }
+    else
+    {
+      batch->add_rotation(quantize(value(i), precision));
+    }
+  }
+  if (isPosition)
+  {
+    batch->add_position_key(key);
+    return batch->position_key_size() - 1;
+  }
+  else
+  {
+    batch->add_rotation_key(key);
+    return batch->rotation_key_size() - 1;
+  }
+}
+
+/// This rewrites every SetObjectTransforms batch in the list, in order, as
+/// differences from the last values we sent.
+void GUIStateMachine::deltaEncodeTransforms(proto::CommandList& list)
+{
+  for (int c = 0; c < list.command_size(); c++)
+  {
+    if (!list.command(c).has_set_object_transforms())
+    {
+      continue;
+    }
+    proto::SetObjectTransforms* batch
+        = list.mutable_command(c)->mutable_set_object_transforms();
+
+    // A keyframe resets every object's history to zero, on both ends. We need
+    // one for new clients, and whenever the precision changes, since the old
+    // history is in different units.
+    if (mTransformKeyframePending
+        || batch->position_precision() != mSentPositionPrecision
+        || batch->rotation_precision() != mSentRotationPrecision)
+    {
+      batch->set_keyframe(true);
+      mLastSentPositions.clear();
+      mLastSentRotations.clear();
+      mTransformKeyframePending = false;
+      mSentPositionPrecision = batch->position_precision();
+      mSentRotationPrecision = batch->rotation_precision();
+    }
+
+    int lastKey = 0;
+    for (int i = 0; i < batch->position_key_size(); i++)
+    {
+      int key = batch->position_key(i);
+      batch->set_position_key(i, key - lastKey);
+      lastKey = key;
+
+      Eigen::Vector3i& sent = mLastSentPositions.emplace(
+          key, Eigen::Vector3i::Zero()).first->second;
+      for (int j = 0; j < 3; j++)
+      {
+        int quantized = batch->position(i * 3 + j);
+        batch->set_position(i * 3 + j, quantized - sent(j));
+        sent(j) = quantized;
+      }
+    }
+
+    lastKey = 0;
+    for (int i = 0; i < batch->rotation_key_size(); i++)
+    {
+      int key = batch->rotation_key(i);
+      batch->set_rotation_key(i, key - lastKey);
+      lastKey = key;
+
+      Eigen::Vector3i& sent = mLastSentRotations.emplace(
+          key, Eigen::Vector3i::Zero()).first->second;
+      for (int j = 0; j < 3; j++)
+      {
+        int quantized = batch->rotation(i * 3 + j);
+        batch->set_rotation(i * 3 + j, quantized - sent(j));
+        sent(j) = quantized;
+      }
+    }
+  }
+}
+
 void GUIStateMachine::encodeSetFramesPerSecond(
     proto::CommandList& list, int framesPerSecond)
 {
@@ -1877,29 +2692,7 @@ void GUIStateMachine::encodeCreateMesh(proto::CommandList& list, Mesh& mesh)
   proto::Command* command = list.add_command();
   command->mutable_mesh()->set_key(getStringCode(mesh.key));
   command->mutable_mesh()->set_layer(getStringCode(mesh.layer));
-  for (Eigen::Vector3s& vertex : mesh.vertices)
-  {
-    command->mutable_mesh()->add_vertex(vertex(0));
-    command->mutable_mesh()->add_vertex(vertex(1));
-    command->mutable_mesh()->add_vertex(vertex(2));
-  }
-  for (Eigen::Vector3s& normal : mesh.vertexNormals)
-  {
-    command->mutable_mesh()->add_vertex_normal(normal(0));
-    command->mutable_mesh()->add_vertex_normal(normal(1));
-    command->mutable_mesh()->add_vertex_normal(normal(2));
-  }
-  for (Eigen::Vector3i& face : mesh.faces)
-  {
-    command->mutable_mesh()->add_face(face(0));
-    command->mutable_mesh()->add_face(face(1));
-    command->mutable_mesh()->add_face(face(2));
-  }
-  for (Eigen::Vector2s& uv : mesh.uv)
-  {
-    command->mutable_mesh()->add_uv(uv(0));
-    command->mutable_mesh()->add_uv(uv(1));
-  }
+  command->mutable_mesh()->set_asset(mesh.asset);
   for (int i = 0; i < mesh.textures.size(); i++)
   {
     command->mutable_mesh()->add_texture(getStringCode(mesh.textures[i]));
@@ -1922,6 +2715,200 @@ void GUIStateMachine::encodeCreateMesh(proto::CommandList& list, Mesh& mesh)
   command->mutable_mesh()->set_receive_shadows(mesh.receiveShadows);
 }
 
+void GUIStateMachine::encodeCreateMeshAsset(
+    proto::CommandList& list, MeshAsset& asset)
+{
+  proto::Command* command = list.add_command();
+  proto::CreateMeshAsset* meshAsset = command->mutable_mesh_asset();
+  meshAsset->set_hash(asset.hash);
+  for (Eigen::Vector3s& vertex : asset.vertices)
+  {
+    meshAsset->add_vertex(vertex(0));
+    meshAsset->add_vertex(vertex(1));
+    meshAsset->add_vertex(vertex(2));
+  }
+  for (Eigen::Vector3s& normal : asset.vertexNormals)
+  {
+    meshAsset->add_vertex_normal(normal(0));
+    meshAsset->add_vertex_normal(normal(1));
+    meshAsset->add_vertex_normal(normal(2));
+  }
+  for (Eigen::Vector3i& face : asset.faces)
+  {
+    meshAsset->add_face(face(0));
+    meshAsset->add_face(face(1));
+    meshAsset->add_face(face(2));
+  }
+  for (Eigen::Vector2s& uv : asset.uv)
+  {
+    meshAsset->add_uv(uv(0));
+    meshAsset->add_uv(uv(1));
+  }
+}
+
+void GUIStateMachine::encodeCreateSkeletonTemplate(
+    proto::CommandList& list, SkeletonTemplate& skeletonTemplate)
+{
+  proto::Command* command = list.add_command();
+  proto::CreateSkeletonTemplate* templateProto
+      = command->mutable_skeleton_template();
+  templateProto->set_key(getStringCode(skeletonTemplate.key));
+  templateProto->set_layer(getStringCode(skeletonTemplate.layer));
+  for (SkeletonTemplateShape& shape : skeletonTemplate.shapes)
+  {
+    proto::SkeletonTemplateShape* shapeProto = templateProto->add_shape();
+    shapeProto->set_type(shape.type);
+    shapeProto->add_size(shape.size(0));
+    shapeProto->add_size(shape.size(1));
+    shapeProto->add_size(shape.size(2));
+    shapeProto->set_asset(shape.asset);
+    shapeProto->add_color(shape.color(0));
+    shapeProto->add_color(shape.color(1));
+    shapeProto->add_color(shape.color(2));
+    shapeProto->add_color(shape.color(3));
+    shapeProto->set_cast_shadows(shape.castShadows);
+    shapeProto->set_receive_shadows(shape.receiveShadows);
+  }
+}
+
+void GUIStateMachine::encodeSetSkeletonInstance(
+    proto::CommandList& list, SkeletonInstance& instance)
+{
+  proto::Command* command = list.add_command();
+  proto::SetSkeletonInstance* instanceProto
+      = command->mutable_skeleton_instance();
+  instanceProto->set_key(getStringCode(instance.key));
+  instanceProto->set_template_key(getStringCode(instance.templateKey));
+  for (int i = 0; i < instance.transforms.size(); i++)
+  {
+    instanceProto->add_transform(instance.transforms(i));
+  }
+  if (instance.color != -1 * Eigen::Vector4s::Ones())
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      instanceProto->add_color(instance.color(i));
+    }
+  }
+}
+
+std::string GUIStateMachine::retainMeshAsset(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3s>& vertexNormals,
+    const std::vector<Eigen::Vector3i>& faces,
+    const std::vector<Eigen::Vector2s>& uv)
+{
+  std::string hash = hashMeshGeometry(vertices, vertexNormals, faces, uv);
+  auto assetIt = mMeshAssets.find(hash);
+  if (assetIt == mMeshAssets.end())
+  {
+    MeshAsset& asset = mMeshAssets[hash];
+    asset.hash = hash;
+    asset.vertices = vertices;
+    asset.vertexNormals = vertexNormals;
+    asset.faces = faces;
+    asset.uv = uv;
+    asset.refCount = 1;
+  }
+  else
+  {
+    assetIt->second.refCount++;
+  }
+  return hash;
+}
+
+void GUIStateMachine::createSkeletonTemplate(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const std::string& templateKey,
+    const std::string& layer)
+{
+  SkeletonTemplate& skeletonTemplate = mSkeletonTemplates[templateKey];
+  skeletonTemplate.key = templateKey;
+  skeletonTemplate.layer = layer;
+
+  for (dynamics::ShapeNode* shapeNode : getTemplateShapeNodes(skel.get()))
+  {
+    dynamics::Shape* shape = shapeNode->getShape().get();
+    dynamics::VisualAspect* visual = shapeNode->getVisualAspect();
+
+    SkeletonTemplateShape templateShape;
+    templateShape.type = getTemplateShapeType(shape);
+    templateShape.size = Eigen::Vector3s::Ones();
+    templateShape.color = visual->getRGBA();
+    templateShape.castShadows = visual->getCastShadows();
+    templateShape.receiveShadows = visual->getReceiveShadows();
+
+    if (shape->getType() == "BoxShape")
+    {
+      templateShape.size = dynamic_cast<dynamics::BoxShape*>(shape)->getSize();
+    }
+    else if (shape->getType() == "SphereShape")
+    {
+      templateShape.size(0)
+          = dynamic_cast<dynamics::SphereShape*>(shape)->getRadius();
+    }
+    else if (shape->getType() == "EllipsoidShape")
+    {
+      templateShape.size(0)
+          = dynamic_cast<dynamics::EllipsoidShape*>(shape)->getRadii()[0];
+    }
+    else if (shape->getType() == "CapsuleShape")
+    {
+      dynamics::CapsuleShape* capsuleShape
+          = dynamic_cast<dynamics::CapsuleShape*>(shape);
+      templateShape.size(0) = capsuleShape->getRadius();
+      templateShape.size(1) = capsuleShape->getHeight();
+    }
+    else if (shape->getType() == "MeshShape")
+    {
+      // Templates only carry flat colors, so we drop any textures here
+      dynamics::MeshShape* meshShape
+          = dynamic_cast<dynamics::MeshShape*>(shape);
+      templateShape.size = meshShape->getScale();
+
+      std::vector<Eigen::Vector3s> vertices;
+      std::vector<Eigen::Vector3s> vertexNormals;
+      std::vector<Eigen::Vector3i> faces;
+      std::vector<Eigen::Vector2s> uv;
+      const aiScene* mesh = meshShape->getMesh();
+      for (int i = 0; mesh != nullptr && i < mesh->mNumMeshes; i++)
+      {
+        appendAssimpGeometry(
+            mesh->mMeshes[i], vertices, vertexNormals, faces, uv);
+      }
+      templateShape.asset = retainMeshAsset(vertices, vertexNormals, faces, uv);
+    }
+    skeletonTemplate.shapes.push_back(templateShape);
+  }
+
+  queueCommand([this, templateKey](proto::CommandList& list) {
+    SkeletonTemplate& skeletonTemplate = mSkeletonTemplates[templateKey];
+    for (SkeletonTemplateShape& shape : skeletonTemplate.shapes)
+    {
+      if (shape.type == 3 && mSentMeshAssets.insert(shape.asset).second)
+      {
+        encodeCreateMeshAsset(list, mMeshAssets[shape.asset]);
+      }
+    }
+    encodeCreateSkeletonTemplate(list, skeletonTemplate);
+  });
+}
+
+void GUIStateMachine::releaseMeshAsset(const std::string& hash)
+{
+  auto it = mMeshAssets.find(hash);
+  if (it == mMeshAssets.end())
+    return;
+  it->second.refCount--;
+  if (it->second.refCount <= 0)
+  {
+    mMeshAssets.erase(it);
+    // Clients may still have it cached, but we can't count on that, so send it
+    // again if it comes back
+    mSentMeshAssets.erase(hash);
+  }
+}
+
 void GUIStateMachine::encodeSetTooltip(
     proto::CommandList& list, Tooltip& tooltip)
 {
@@ -1931,11 +2918,14 @@ void GUIStateMachine::encodeSetTooltip(
 }
 
 void GUIStateMachine::encodeCreateTexture(
-    proto::CommandList& list, Texture& texture)
+    proto::CommandList& list, Texture& texture, bool includeData)
 {
   proto::Command* command = list.add_command();
   command->mutable_texture()->set_key(getStringCode(texture.key));
-  command->mutable_texture()->set_base64(texture.base64);
+  command->mutable_texture()->set_hash(texture.hash);
+  // If the client already has a texture with this hash, it'll reuse that
+  if (includeData)
+    command->mutable_texture()->set_base64(texture.base64);
 }
 
 void GUIStateMachine::encodeEnableMouseInteraction(
@@ -2061,5 +3051,24 @@ void GUIStateMachine::encodeSetRichPlotData(
   }
 }
 
+GUIStateMachine::RichPlotData GUIStateMachine::decimateRichPlotData(
+    const RichPlot& plot, const RichPlotData& data)
+{
+  if (!data.streamed)
+    return data;
+
+  RichPlotData decimated;
+  decimated.name = data.name;
+  decimated.color = data.color;
+  decimated.type = data.type;
+  decimated.streamed = true;
+  for (int i : decimateLTTB(data.xs, data.ys, std::max(plot.size(0), 3)))
+  {
+    decimated.xs.push_back(data.xs[i]);
+    decimated.ys.push_back(data.ys[i]);
+  }
+  return decimated;
+}
+
 } // namespace server
 } // namespace dart
\ No newline at end of file
@@ -18,6 +18,7 @@
 #include <assimp/cimport.h>
 #include <assimp/postprocess.h>
 
+#include "dart/common/Memory.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/MeshShape.hpp"
 #include "dart/proto/GUI.pb.h"
@@ -53,6 +54,45 @@ public:
   /// This formats the latest set of commands as JSON, and clears the buffer
   std::string flushJson();
 
+  /// This switches setObjectPosition() and setObjectRotation() over to sending
+  /// batched SetObjectTransforms commands. Values are rounded to multiples of
+  /// the given precisions, and each one is sent as the change since the last
+  /// value sent for that object, which is much smaller on the wire than raw
+  /// floats when streaming many skeletons. Clients must decode the stream in
+  /// order, so this is meant for live streams rather than recordings that get
+  /// scrubbed through.
+  void setQuantizeTransforms(
+      bool quantize,
+      s_t positionPrecision = 1e-4,
+      s_t rotationPrecision = 1e-4);
+
+  /// This makes the next batch of quantized transforms a keyframe, which
+  /// clients can decode without having seen any previous batches. Call this
+  /// when a new client connects.
+  void resetTransformDeltas();
+
+  /// This sets how far a shape has to move, turn (in each euler angle) or
+  /// change color before renderWorld() and renderSkeleton() send an update
+  /// for it. Changes smaller than these accumulate until they cross the
+  /// threshold. The defaults of 0 send every change.
+  void setUpdateThresholds(
+      s_t positionEpsilon, s_t rotationEpsilon, s_t colorEpsilon);
+
+  /// This marks an object as static. renderWorld() and renderSkeleton() still
+  /// create it, but never send updates for it afterwards, which saves
+  /// re-checking (and re-sending) geometry like the ground every frame.
+  void setObjectStatic(const std::string& key, bool isStatic = true);
+
+  /// This marks every shape in a skeleton, as named by renderSkeleton() with
+  /// the same prefix, as static. See setObjectStatic().
+  void setSkeletonStatic(
+      const std::shared_ptr<dynamics::Skeleton>& skel,
+      const std::string& prefix = "skel",
+      bool isStatic = true);
+
+  /// This returns true if an object has been marked static
+  bool isObjectStatic(const std::string& key);
+
   /// This is a high-level command that creates/updates all the shapes in a
   /// world by calling the lower-level commands
   void renderWorld(
@@ -78,6 +118,20 @@ public:
       Eigen::Vector4s overrideColor = -1 * Eigen::Vector4s::Ones(),
       const std::string& layer = "");
 
+  /// This is a high-level command like renderSkeleton(), for drawing many
+  /// copies of identical skeletons. All the copies rendered with the same
+  /// `templateKey` share geometry, which is sent once, and each update to a
+  /// copy is a single packed array of shape transforms. The client draws them
+  /// with instancing. The template is built from the first skeleton rendered
+  /// with a given `templateKey`, so every skeleton using it must have the same
+  /// shapes. Deleting `instanceKey` removes the copy.
+  void renderSkeletonInstanced(
+      const std::shared_ptr<dynamics::Skeleton>& skel,
+      const std::string& templateKey,
+      const std::string& instanceKey,
+      Eigen::Vector4s overrideColor = -1 * Eigen::Vector4s::Ones(),
+      const std::string& layer = "");
+
   /// This is a high-level command that renders a given trajectory as a
   /// bunch of lines in the world, one per body
   void renderTrajectoryLines(
@@ -363,6 +417,19 @@ public:
       const std::vector<s_t>& xs,
       const std::vector<s_t>& ys);
 
+  /// This appends points to a data stream for a rich plot, creating the stream
+  /// if it doesn't exist yet, and only sends the new points to the client.
+  /// Long streams get decimated down to about one point per pixel of the plot's
+  /// width, so a live plot costs the same bandwidth no matter how much history
+  /// it has. `color` and `type` are only used when creating the stream.
+  void appendRichPlotData(
+      const std::string& key,
+      const std::string& name,
+      const std::string& color,
+      const std::string& type,
+      const std::vector<s_t>& xs,
+      const std::vector<s_t>& ys);
+
   /// This sets a single data stream for a rich plot
   void setRichPlotBounds(
       const std::string& key, s_t minX, s_t maxX, s_t minY, s_t maxY);
@@ -391,8 +458,37 @@ protected:
   int mMessagesQueued;
   proto::CommandList mCommandList;
   std::string mCommandListOutputBuffer;
+  // Settings and per-object history for quantized transform batches
+  bool mQuantizeTransforms;
+  s_t mPositionPrecision;
+  s_t mRotationPrecision;
+  bool mTransformKeyframePending;
+  float mSentPositionPrecision;
+  float mSentRotationPrecision;
+  std::unordered_map<int, Eigen::Vector3i> mLastSentPositions;
+  std::unordered_map<int, Eigen::Vector3i> mLastSentRotations;
+
+  // This is where in mCommandList we've already queued updates for each
+  // object since the last flush, so newer values can overwrite them in place.
+  // The entries index into SetObjectTransforms batches, when we're quantizing.
+  struct PendingUpdate
+  {
+    int positionCommand = -1;
+    int positionEntry = -1;
+    int rotationCommand = -1;
+    int rotationEntry = -1;
+    int colorCommand = -1;
+    int scaleCommand = -1;
+    int instanceCommand = -1;
+  };
+  std::unordered_map<std::string, PendingUpdate> mPendingUpdates;
   // This is a list of all the objects with mouse interaction enabled
   std::unordered_set<std::string> mMouseInteractionEnabled;
+  // Dirty tracking for renderWorld() and renderSkeleton()
+  s_t mPositionEpsilon;
+  s_t mRotationEpsilon;
+  s_t mColorEpsilon;
+  std::unordered_set<std::string> mStaticObjects;
 
   std::unordered_map<std::string, int> mStringCodes;
   std::unordered_map<int, std::string> mCodeStrings;
@@ -462,10 +558,8 @@ protected:
   {
     std::string key;
     std::string layer;
-    std::vector<Eigen::Vector3s> vertices;
-    std::vector<Eigen::Vector3s> vertexNormals;
-    std::vector<Eigen::Vector3i> faces;
-    std::vector<Eigen::Vector2s> uv;
+    // The content hash of the MeshAsset holding our geometry
+    std::string asset;
     std::vector<std::string> textures;
     std::vector<int> textureStartIndices;
     Eigen::Vector3s pos;
@@ -477,12 +571,62 @@ protected:
   };
   std::unordered_map<std::string, Mesh> mMeshes;
 
+  // Mesh geometry is stored (and sent) once per distinct content hash, so
+  // identical meshes under many keys, like the same bone geometry on several
+  // skeletons, share one copy
+  struct MeshAsset
+  {
+    std::string hash;
+    std::vector<Eigen::Vector3s> vertices;
+    std::vector<Eigen::Vector3s> vertexNormals;
+    std::vector<Eigen::Vector3i> faces;
+    std::vector<Eigen::Vector2s> uv;
+    // The number of entries in mMeshes and template shapes that use this asset
+    int refCount;
+  };
+  std::unordered_map<std::string, MeshAsset> mMeshAssets;
+  // The assets we've already written into the live command stream
+  std::unordered_set<std::string> mSentMeshAssets;
+
+  struct SkeletonTemplateShape
+  {
+    // 0 for a box, 1 for a sphere, 2 for a capsule, 3 for a mesh
+    int type;
+    Eigen::Vector3s size;
+    // For meshes, the content hash of the MeshAsset holding the geometry
+    std::string asset;
+    Eigen::Vector4s color;
+    bool castShadows;
+    bool receiveShadows;
+  };
+  struct SkeletonTemplate
+  {
+    std::string key;
+    std::string layer;
+    std::vector<SkeletonTemplateShape> shapes;
+  };
+  std::unordered_map<std::string, SkeletonTemplate> mSkeletonTemplates;
+
+  struct SkeletonInstance
+  {
+    std::string key;
+    std::string templateKey;
+    // The position and euler angles of each shape in the template, 6 per shape
+    Eigen::VectorXs transforms;
+    // All -1 to use the template's colors
+    Eigen::Vector4s color;
+  };
+  std::unordered_map<std::string, SkeletonInstance> mSkeletonInstances;
+
   struct Texture
   {
     std::string key;
     std::string base64;
+    std::string hash;
   };
   std::unordered_map<std::string, Texture> mTextures;
+  // The texture hashes we've already written into the live command stream
+  std::unordered_set<std::string> mSentTextureHashes;
 
   struct Text
   {
@@ -543,6 +687,10 @@ protected:
     std::vector<s_t> ys;
     std::vector<s_t> xs;
     std::string type;
+    // True if this was built with appendRichPlotData(), so we can decimate it
+    bool streamed = false;
+    // The number of points the client holds for a streamed line
+    int sentPoints = 0;
   };
   struct RichPlot
   {
@@ -563,6 +711,30 @@ protected:
 
   void queueCommand(std::function<void(proto::CommandList&)> writeCommand);
 
+  /// This queues a position or rotation for an object. If we've already queued
+  /// one since the last flush, this just overwrites it with the new value, so
+  /// objects that get updated many times between flushes cost one update.
+  void encodeTransform(
+      proto::CommandList& list,
+      const std::string& key,
+      const Eigen::Vector3s& value,
+      bool isPosition);
+
+  /// This appends a quantized position or rotation to the SetObjectTransforms
+  /// batch at the end of the list, starting a new batch if the last command
+  /// is something else. Values are stored as absolute quantized numbers here,
+  /// and get delta encoded by deltaEncodeTransforms() when we flush. This
+  /// returns the index of the new entry within the batch.
+  int encodeQuantizedTransform(
+      proto::CommandList& list,
+      int key,
+      const Eigen::Vector3s& value,
+      bool isPosition);
+
+  /// This rewrites every SetObjectTransforms batch in the list, in order, as
+  /// differences from the last values we sent.
+  void deltaEncodeTransforms(proto::CommandList& list);
+
   void encodeSetFramesPerSecond(proto::CommandList& list, int framesPerSecond);
   void encodeCreateLayer(proto::CommandList& list, Layer& layer);
   void encodeCreateBox(proto::CommandList& list, Box& box);
@@ -570,8 +742,43 @@ protected:
   void encodeCreateCapsule(proto::CommandList& list, Capsule& capsule);
   void encodeCreateLine(proto::CommandList& list, Line& line);
   void encodeCreateMesh(proto::CommandList& list, Mesh& mesh);
+  void encodeCreateMeshAsset(proto::CommandList& list, MeshAsset& asset);
+  void encodeCreateSkeletonTemplate(
+      proto::CommandList& list, SkeletonTemplate& skeletonTemplate);
+  void encodeSetSkeletonInstance(
+      proto::CommandList& list, SkeletonInstance& instance);
   void encodeSetTooltip(proto::CommandList& list, Tooltip& tooltip);
-  void encodeCreateTexture(proto::CommandList& list, Texture& texture);
+  void encodeCreateTexture(
+      proto::CommandList& list, Texture& texture, bool includeData = true);
+
+  /// This adds a reference to the mesh asset with this geometry, creating it
+  /// if it doesn't exist yet, and returns its hash
+  std::string retainMeshAsset(
+      const std::vector<Eigen::Vector3s>& vertices,
+      const std::vector<Eigen::Vector3s>& vertexNormals,
+      const std::vector<Eigen::Vector3i>& faces,
+      const std::vector<Eigen::Vector2s>& uv);
+
+  /// This does the work of renderSkeleton(), with the world transform of every
+  /// ShapeNode already worked out, in the order of
+  /// Skeleton::getShapeNodeWorldTransforms()
+  void renderSkeletonShapes(
+      const std::shared_ptr<dynamics::Skeleton>& skel,
+      const std::string& prefix,
+      const Eigen::Vector4s& overrideColor,
+      const std::string& layer,
+      const common::aligned_vector<Eigen::Isometry3s>& shapeTransforms);
+
+  /// This builds a template out of the visual shapes of a skeleton, for
+  /// renderSkeletonInstanced()
+  void createSkeletonTemplate(
+      const std::shared_ptr<dynamics::Skeleton>& skel,
+      const std::string& templateKey,
+      const std::string& layer);
+
+  /// This drops a reference to a mesh asset, and forgets the asset if nothing
+  /// uses it anymore
+  void releaseMeshAsset(const std::string& hash);
   void encodeEnableMouseInteraction(
       proto::CommandList& list, const std::string& key);
   void encodeCreateText(proto::CommandList& list, Text& text);
@@ -583,6 +790,11 @@ protected:
       proto::CommandList& list,
       const std::string& plotKey,
       const RichPlotData& data);
+
+  /// This returns the points of a line we should actually send, which for a
+  /// streamed line is decimated to about the width of the plot in pixels
+  RichPlotData decimateRichPlotData(
+      const RichPlot& plot, const RichPlotData& data);
 };
 
 } // namespace server
@@ -1,5 +1,6 @@
 #include "dart/server/GUIWebsocketServer.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <sstream>
@@ -18,6 +19,7 @@
 #include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/dynamics/SphereShape.hpp"
+#include "dart/external/lodepng/lodepng.h"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/server/RawJsonUtils.hpp"
@@ -31,12 +33,38 @@ GUIWebsocketServer::GUIWebsocketServer()
   : mPort(-1),
     mServing(false),
     mStartingServer(false),
-    mScreenSize(Eigen::Vector2i(680, 420))
+    mScreenSize(Eigen::Vector2i(680, 420)),
+    mServer(nullptr),
+    mBinaryFrames(false),
+    mDeflateFrames(false),
+    mPoseWriteIndex(0),
+    mPoseReadIndex(1),
+    mPoseSharedIndex(2),
+    mParent(nullptr),
+    mFlushIntervalMs(20)
 {
 }
 
+/// This creates a session called `name`, which sends through `parent`'s
+/// server
+GUIWebsocketServer::GUIWebsocketServer(
+    GUIWebsocketServer* parent, const std::string& name)
+  : GUIWebsocketServer()
+{
+  mParent = parent;
+  mSessionName = name;
+}
+
 GUIWebsocketServer::~GUIWebsocketServer()
 {
+  {
+    // Sessions can outlive us, but they have nothing to send through anymore
+    const std::lock_guard<std::mutex> lock(this->mSessionsMutex);
+    for (auto& pair : mSessions)
+    {
+      pair.second->mParent = nullptr;
+    }
+  }
   {
     const std::unique_lock<std::mutex> lock(this->mServingMutex);
     if (!mServing)
@@ -57,6 +85,14 @@ GUIWebsocketServer::~GUIWebsocketServer()
 /// This is a non-blocking call to start a websocket server on a given port
 void GUIWebsocketServer::serve(int port)
 {
+  if (mParent != nullptr)
+  {
+    dterr << "GUIWebsocketServer::serve() was called on the session \""
+          << mSessionName
+          << "\", which is served by its server. Ignoring request."
+          << std::endl;
+    return;
+  }
   mPort = port;
   // Register signal and signal handler
   {
@@ -73,45 +109,20 @@ void GUIWebsocketServer::serve(int port)
     mStartingServer = true;
   }
   mServer = new WebsocketServer();
+  // Our messages are deltas, so a client that falls behind can't just skip a
+  // few. Instead we throw away its backlog and send it a fresh snapshot.
+  mServer->setSlowClientPolicy(WebsocketServer::SlowClientPolicy::RESYNC);
+  mServer->resync([this](ClientConnection conn) {
+    withSession(
+        conn, [conn](GUIWebsocketServer& session) { session.onResync(conn); });
+  });
 
   // Register our network callbacks, ensuring the logic is run on the main
-  // thread's event loop
+  // thread's event loop. Each one gets handed to the session the client is
+  // viewing.
   mServer->connect([this](ClientConnection conn) {
-    {
-      // We don't need high throughput, so run everything through a global mutex
-      // to avoid data races
-      const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-
-      // Send a hello message to the client
-      // mServer->send(conn) seems to break, cause conn appears to get cleaned
-      // up in race conditions (it's a weak pointer)
-
-      std::string jsonStr = getCurrentStateAsJson();
-      try
-      {
-        mServer->send(conn, base64_encode(jsonStr));
-      }
-      catch (...)
-      {
-        dterr << "GUIWebsocketServer caught an error broadcasting message \""
-              << jsonStr << "\"" << std::endl;
-      }
-      // mServer->broadcast("{\"type\": 1}");
-      /*
-      mServer->broadcast(
-          "{\"type\": \"init\", \"world\": " + mWorld->toJson() + "}");
-      */
-    }
-
-    // Don't hold the globalMutex when calling connection listeners, because
-    // that can lead to deadlocks if the connection listeners call out to Python
-    // (which tries to grab the GIL) while other Python code (holding the GIL)
-    // tries to grab the globalMutex.
-
-    for (auto listener : mConnectionListeners)
-    {
-      listener();
-    }
+    withSession(
+        conn, [conn](GUIWebsocketServer& session) { session.onConnect(conn); });
   });
 
   mServer->disconnect([this](ClientConnection /* conn */) {
@@ -119,74 +130,10 @@ void GUIWebsocketServer::serve(int port)
     std::clog << "There are now " << mServer->numConnections()
               << " open connections." << std::endl;
   });
-  mServer->message([this](
-                       ClientConnection /* conn */, const Json::Value& args) {
-    if (args["type"].asString() == "keydown")
-    {
-      std::string key = args["key"].asString();
-      {
-        const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-        this->mKeysDown.insert(key);
-      }
-      for (auto listener : this->mKeydownListeners)
-      {
-        listener(key);
-      }
-    }
-    else if (args["type"].asString() == "keyup")
-    {
-      std::string key = args["key"].asString();
-      {
-        const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-        this->mKeysDown.erase(key);
-      }
-      for (auto listener : this->mKeyupListeners)
-      {
-        listener(key);
-      }
-    }
-    else if (args["type"].asString() == "button_click")
-    {
-      std::string key = this->getCodeString(args["key"].asInt());
-      if (mButtons.find(key) != mButtons.end())
-      {
-        mButtons[key].onClick();
-      }
-    }
-    else if (args["type"].asString() == "slider_set_value")
-    {
-      std::string key = this->getCodeString(args["key"].asInt());
-      s_t value = static_cast<s_t>(args["value"].asDouble());
-      if (mSliders.find(key) != mSliders.end())
-      {
-        mSliders[key].value = value;
-        mSliders[key].onChange(value);
-      }
-    }
-    else if (args["type"].asString() == "screen_resize")
-    {
-      Eigen::Vector2i size
-          = Eigen::Vector2i(args["size"][0].asInt(), args["size"][1].asInt());
-      mScreenSize = size;
-
-      for (auto handler : mScreenResizeListeners)
-      {
-        handler(size);
-      }
-    }
-    else if (args["type"].asString() == "drag")
-    {
-      std::string key = args["key"].asString();
-      Eigen::Vector3s pos = Eigen::Vector3s(
-          static_cast<s_t>(args["pos"][0].asDouble()),
-          static_cast<s_t>(args["pos"][1].asDouble()),
-          static_cast<s_t>(args["pos"][2].asDouble()));
-
-      for (auto handler : mDragListeners[key])
-      {
-        handler(pos);
-      }
-    }
+  mServer->message([this](ClientConnection conn, const Json::Value& args) {
+    withSession(conn, [&args](GUIWebsocketServer& session) {
+      session.onMessage(args);
+    });
   });
 
   // unblock signals in this thread
@@ -302,17 +249,335 @@ void GUIWebsocketServer::stopServing()
 /// Returns true if we're serving
 bool GUIWebsocketServer::isServing()
 {
+  GUIWebsocketServer* parent = mParent;
+  if (parent != nullptr)
+    return parent->isServing();
   return mServing;
 }
 
-/// This flushes at a fixed framerate, not too fast to overwhelm the web GUI
+/// This flushes the server and all of its sessions, each at its own
+/// framerate, not too fast to overwhelm the web GUI
 void GUIWebsocketServer::flushThread()
 {
   while (mServing)
   {
-    flush();
-    // limit to sending updates at 50fps
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::chrono::steady_clock::time_point now
+        = std::chrono::steady_clock::now();
+    // Don't sleep for so long that stopServing() has to wait on us
+    std::chrono::steady_clock::time_point wake
+        = now + std::chrono::milliseconds(100);
+
+    flushIfDue(now, wake);
+    {
+      const std::lock_guard<std::mutex> lock(this->mSessionsMutex);
+      for (auto& pair : mSessions)
+      {
+        mFlushSessions.push_back(pair.second);
+      }
+    }
+    for (auto& session : mFlushSessions)
+    {
+      session->flushIfDue(now, wake);
+    }
+    // Let go of the sessions, so closed ones can be freed
+    mFlushSessions.clear();
+
+    std::this_thread::sleep_until(wake);
+  }
+}
+
+/// This is called from the flush thread. If it's time for this session to
+/// flush, this draws and sends its queued commands. Either way, it pulls
+/// `wake` in to when this session next needs to flush.
+void GUIWebsocketServer::flushIfDue(
+    std::chrono::steady_clock::time_point now,
+    std::chrono::steady_clock::time_point& wake)
+{
+  if (now >= mNextFlush)
+  {
+    if (getNumViewers() > 0)
+    {
+      renderPublishedPoses();
+      flush();
+    }
+    else if (mMessagesQueued > 0)
+    {
+      // Nobody is watching, so throw the changes away instead of letting them
+      // pile up. A new viewer gets the full state when it connects. Published
+      // poses stay where they are until then.
+      flushJson();
+    }
+    mNextFlush = now + std::chrono::milliseconds(mFlushIntervalMs.load());
+  }
+  wake = std::min(wake, mNextFlush);
+}
+
+/// This returns the session called `name`, creating it if it doesn't exist
+/// yet. Clients connected to ws://<host>:<port>/<name> see its state.
+/// Sessions outlive calls to serve() and stopServing(), and stay around
+/// until closeSession().
+std::shared_ptr<GUIWebsocketServer> GUIWebsocketServer::getSession(
+    const std::string& name)
+{
+  GUIWebsocketServer* parent = mParent;
+  if (parent != nullptr)
+    return parent->getSession(name);
+  if (name.empty())
+  {
+    dterr << "GUIWebsocketServer::getSession() needs a non-empty name. The "
+             "session \"\" is the server itself."
+          << std::endl;
+    return nullptr;
+  }
+
+  const std::lock_guard<std::mutex> lock(this->mSessionsMutex);
+  std::shared_ptr<GUIWebsocketServer>& session = mSessions[name];
+  if (!session)
+  {
+    // Viewers that connected before now were shown an empty scene, which is
+    // exactly the state of a new session, so there's nothing to send them
+    session = std::shared_ptr<GUIWebsocketServer>(
+        new GUIWebsocketServer(this, name));
+  }
+  return session;
+}
+
+/// Returns true if there's a session called `name`
+bool GUIWebsocketServer::hasSession(const std::string& name)
+{
+  GUIWebsocketServer* parent = mParent;
+  if (parent != nullptr)
+    return parent->hasSession(name);
+
+  const std::lock_guard<std::mutex> lock(this->mSessionsMutex);
+  return mSessions.find(name) != mSessions.end();
+}
+
+/// This removes the session called `name`. Its viewers stay connected, but
+/// they won't get any more updates.
+void GUIWebsocketServer::closeSession(const std::string& name)
+{
+  GUIWebsocketServer* parent = mParent;
+  if (parent != nullptr)
+  {
+    parent->closeSession(name);
+    return;
+  }
+
+  const std::lock_guard<std::mutex> lock(this->mSessionsMutex);
+  auto it = mSessions.find(name);
+  if (it == mSessions.end())
+    return;
+  it->second->mParent = nullptr;
+  mSessions.erase(it);
+}
+
+/// This returns the names of all the sessions on this server
+std::vector<std::string> GUIWebsocketServer::getSessionNames()
+{
+  GUIWebsocketServer* parent = mParent;
+  if (parent != nullptr)
+    return parent->getSessionNames();
+
+  const std::lock_guard<std::mutex> lock(this->mSessionsMutex);
+  std::vector<std::string> names;
+  names.reserve(mSessions.size());
+  for (auto& pair : mSessions)
+  {
+    names.push_back(pair.first);
+  }
+  return names;
+}
+
+/// This returns the name of this session, which is "" for the server itself
+const std::string& GUIWebsocketServer::getSessionName() const
+{
+  return mSessionName;
+}
+
+/// This sets how often the flush thread sends this session's changes to its
+/// viewers. This defaults to every 20ms (50fps), and dashboards that are
+/// mostly idle can set it much higher.
+void GUIWebsocketServer::setFlushInterval(int milliseconds)
+{
+  mFlushIntervalMs = std::max(milliseconds, 1);
+}
+
+/// This returns how often the flush thread sends this session's changes,
+/// in milliseconds
+int GUIWebsocketServer::getFlushInterval() const
+{
+  return mFlushIntervalMs.load();
+}
+
+/// This returns the number of clients viewing this session
+std::size_t GUIWebsocketServer::getNumViewers()
+{
+  WebsocketServer* server = getServer();
+  if (server == nullptr)
+    return 0;
+  return server->numConnections(mSessionName);
+}
+
+/// This returns the WebsocketServer this session sends through, or nullptr
+/// if there isn't one running
+WebsocketServer* GUIWebsocketServer::getServer()
+{
+  GUIWebsocketServer* parent = mParent;
+  if (parent != nullptr)
+    return parent->mServer;
+  return mServer;
+}
+
+/// This runs `fn` on the session that `conn` is viewing, if it exists
+void GUIWebsocketServer::withSession(
+    ClientConnection conn, const std::function<void(GUIWebsocketServer&)>& fn)
+{
+  std::string name = mServer->getSession(conn);
+  if (name.empty())
+  {
+    fn(*this);
+    return;
+  }
+
+  std::shared_ptr<GUIWebsocketServer> session;
+  {
+    const std::lock_guard<std::mutex> lock(this->mSessionsMutex);
+    auto it = mSessions.find(name);
+    if (it != mSessions.end())
+      session = it->second;
+  }
+  // Clients can connect to a session before it's been created. They'll start
+  // getting updates once it is.
+  if (session)
+    fn(*session);
+}
+
+/// This sends the full state of this session to a new viewer, and calls the
+/// connection listeners
+void GUIWebsocketServer::onConnect(ClientConnection conn)
+{
+  {
+    // We don't need high throughput, so run everything through a global mutex
+    // to avoid data races
+    const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+    // Send a hello message to the client
+    // mServer->send(conn) seems to break, cause conn appears to get cleaned
+    // up in race conditions (it's a weak pointer)
+
+    std::string jsonStr = getCurrentStateAsJson();
+    try
+    {
+      sendCommandList(jsonStr, &conn);
+    }
+    catch (...)
+    {
+      dterr << "GUIWebsocketServer caught an error broadcasting message \""
+            << jsonStr << "\"" << std::endl;
+    }
+    // The new client has no history to decode deltas against
+    resetTransformDeltas();
+  }
+
+  // Don't hold the globalMutex when calling connection listeners, because
+  // that can lead to deadlocks if the connection listeners call out to Python
+  // (which tries to grab the GIL) while other Python code (holding the GIL)
+  // tries to grab the globalMutex.
+
+  for (auto listener : mConnectionListeners)
+  {
+    listener();
+  }
+}
+
+/// This sends the full state of this session to a viewer that fell too far
+/// behind
+void GUIWebsocketServer::onResync(ClientConnection conn)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+  std::string jsonStr = getCurrentStateAsJson();
+  try
+  {
+    sendCommandList(jsonStr, &conn);
+  }
+  catch (...)
+  {
+    dterr << "GUIWebsocketServer caught an error resyncing a slow client"
+          << std::endl;
+  }
+  // The client has no history to decode deltas against
+  resetTransformDeltas();
+}
+
+/// This handles an event sent by a viewer of this session
+void GUIWebsocketServer::onMessage(const Json::Value& args)
+{
+  if (args["type"].asString() == "keydown")
+  {
+    std::string key = args["key"].asString();
+    {
+      const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+      this->mKeysDown.insert(key);
+    }
+    for (auto listener : this->mKeydownListeners)
+    {
+      listener(key);
+    }
+  }
+  else if (args["type"].asString() == "keyup")
+  {
+    std::string key = args["key"].asString();
+    {
+      const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+      this->mKeysDown.erase(key);
+    }
+    for (auto listener : this->mKeyupListeners)
+    {
+      listener(key);
+    }
+  }
+  else if (args["type"].asString() == "button_click")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    if (mButtons.find(key) != mButtons.end())
+    {
+      mButtons[key].onClick();
+    }
+  }
+  else if (args["type"].asString() == "slider_set_value")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    s_t value = static_cast<s_t>(args["value"].asDouble());
+    if (mSliders.find(key) != mSliders.end())
+    {
+      mSliders[key].value = value;
+      mSliders[key].onChange(value);
+    }
+  }
+  else if (args["type"].asString() == "screen_resize")
+  {
+    Eigen::Vector2i size
+        = Eigen::Vector2i(args["size"][0].asInt(), args["size"][1].asInt());
+    mScreenSize = size;
+
+    for (auto handler : mScreenResizeListeners)
+    {
+      handler(size);
+    }
+  }
+  else if (args["type"].asString() == "drag")
+  {
+    std::string key = args["key"].asString();
+    Eigen::Vector3s pos = Eigen::Vector3s(
+        static_cast<s_t>(args["pos"][0].asDouble()),
+        static_cast<s_t>(args["pos"][1].asDouble()),
+        static_cast<s_t>(args["pos"][2].asDouble()));
+
+    for (auto handler : mDragListeners[key])
+    {
+      handler(pos);
+    }
   }
 }
 
@@ -322,6 +587,12 @@ void GUIWebsocketServer::flushThread()
 void GUIWebsocketServer::blockWhileServing(
     std::function<void()> checkForSignals)
 {
+  GUIWebsocketServer* parent = mParent;
+  if (parent != nullptr)
+  {
+    parent->blockWhileServing(checkForSignals);
+    return;
+  }
   std::unique_lock<std::mutex> lock(this->mServingMutex);
   if (!mServing && !mStartingServer)
     return;
@@ -389,12 +660,12 @@ bool GUIWebsocketServer::isKeyDown(const std::string& key) const
 /// This sends the current list of commands to the web GUI
 void GUIWebsocketServer::flush()
 {
-  if (mServing && mMessagesQueued > 0)
+  if (isServing() && mMessagesQueued > 0)
   {
     std::string json = flushJson();
     try
     {
-      mServer->broadcast(base64_encode(json));
+      sendCommandList(json);
     }
     catch (...)
     {
@@ -404,6 +675,74 @@ void GUIWebsocketServer::flush()
   }
 }
 
+/// This sends messages as raw protobuf bytes in binary websocket frames,
+/// instead of base64 text. Each binary frame starts with a one byte header: 0
+/// for a plain CommandList, 1 for a zlib deflated one. Only web clients built
+/// from this version onwards can read binary frames.
+void GUIWebsocketServer::setBinaryFrames(bool binary)
+{
+  mBinaryFrames = binary;
+}
+
+/// When sending binary frames, this deflates every message that shrinks from
+/// it. This trades server CPU for less bandwidth, which pays off when streaming
+/// to a remote browser.
+void GUIWebsocketServer::setDeflateFrames(bool deflate)
+{
+  mDeflateFrames = deflate;
+}
+
+/// This sends a serialized CommandList to one client, or to everyone if `conn`
+/// is null, in whichever framing we've been configured to use
+void GUIWebsocketServer::sendCommandList(
+    const std::string& serialized, ClientConnection* conn)
+{
+  WebsocketServer* server = getServer();
+  if (server == nullptr)
+    return;
+
+  if (!mBinaryFrames)
+  {
+    if (conn != nullptr)
+      server->send(*conn, base64_encode(serialized));
+    else
+      server->broadcastToSession(mSessionName, base64_encode(serialized));
+    return;
+  }
+
+  std::string frame;
+  if (mDeflateFrames)
+  {
+    std::vector<unsigned char> deflated;
+    LodePNGCompressSettings settings;
+    lodepng_compress_settings_init(&settings);
+    // Favor speed, since we're compressing on every flush
+    settings.lazymatching = 0;
+    unsigned error = lodepng::compress(
+        deflated,
+        reinterpret_cast<const unsigned char*>(serialized.data()),
+        serialized.size(),
+        settings);
+    if (!error && deflated.size() < serialized.size())
+    {
+      frame.reserve(deflated.size() + 1);
+      frame.push_back((char)1);
+      frame.append(deflated.begin(), deflated.end());
+    }
+  }
+  if (frame.empty())
+  {
+    frame.reserve(serialized.size() + 1);
+    frame.push_back((char)0);
+    frame.append(serialized);
+  }
+
+  if (conn != nullptr)
+    server->sendBinary(*conn, frame);
+  else
+    server->broadcastBinaryToSession(mSessionName, frame);
+}
+
 /// This completely resets the web GUI, deleting all objects, UI elements, and
 /// listeners
 void GUIWebsocketServer::clear()
@@ -446,5 +785,102 @@ void GUIWebsocketServer::registerScreenResizeListener(
   mScreenResizeListeners.push_back(listener);
 }
 
+/// This sets up `world` to get drawn from the flush thread, instead of from the
+/// simulation thread. Once this is set, the simulation loop only needs to call
+/// publishWorldPoses() after each step.
+void GUIWebsocketServer::renderWorldAsync(
+    const std::shared_ptr<simulation::World>& world,
+    const std::string& prefix,
+    const std::string& layer)
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->mAsyncRenderMutex);
+    mAsyncWorld = world;
+    mAsyncPrefix = prefix;
+    mAsyncLayer = layer;
+    // Forget any poses that were published for the last world
+    mPoseSharedIndex.fetch_and(POSE_INDEX_MASK);
+  }
+  mPublishedWorld = world;
+}
+
+/// This copies the world transform of every body into a spare buffer, and
+/// hands it to the flush thread without taking any locks
+void GUIWebsocketServer::publishWorldPoses()
+{
+  if (!mPublishedWorld)
+    return;
+
+  PoseSnapshot& snapshot = mPoseSnapshots[mPoseWriteIndex];
+  mPublishedWorld->getBodyWorldTransforms(snapshot.bodyTransforms);
+  // Swap our finished snapshot with the shared one. If the flush thread never
+  // took the last poses we published, we get them back to overwrite next time.
+  mPoseWriteIndex = mPoseSharedIndex.exchange(
+                        mPoseWriteIndex | POSE_FRESH, std::memory_order_acq_rel)
+                    & POSE_INDEX_MASK;
+}
+
+/// This stops drawing the world passed to renderWorldAsync()
+void GUIWebsocketServer::stopRenderingAsync()
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->mAsyncRenderMutex);
+    mAsyncWorld = nullptr;
+    mPoseSharedIndex.fetch_and(POSE_INDEX_MASK);
+  }
+  mPublishedWorld = nullptr;
+}
+
+/// This is called from the flush thread, and draws the newest poses passed to
+/// publishWorldPoses(), if there are any we haven't drawn yet
+void GUIWebsocketServer::renderPublishedPoses()
+{
+  const std::lock_guard<std::mutex> lock(this->mAsyncRenderMutex);
+  if (!mAsyncWorld
+      || (mPoseSharedIndex.load(std::memory_order_relaxed) & POSE_FRESH) == 0)
+  {
+    return;
+  }
+
+  mPoseReadIndex
+      = mPoseSharedIndex.exchange(mPoseReadIndex, std::memory_order_acq_rel)
+        & POSE_INDEX_MASK;
+  const common::aligned_vector<Eigen::Isometry3s>& bodyTransforms
+      = mPoseSnapshots[mPoseReadIndex].bodyTransforms;
+
+  std::size_t bodyIndex = 0;
+  for (std::size_t i = 0; i < mAsyncWorld->getNumSkeletons(); i++)
+  {
+    const std::shared_ptr<dynamics::Skeleton>& skel
+        = mAsyncWorld->getSkeletonRef(i);
+    const std::size_t numBodies = skel->getNumBodyNodes();
+    if (bodyIndex + numBodies > bodyTransforms.size())
+    {
+      // The world must have changed since these poses were published
+      return;
+    }
+
+    mAsyncShapeTransforms.clear();
+    for (std::size_t j = 0; j < numBodies; j++)
+    {
+      const dynamics::BodyNode* body = skel->getBodyNode(j);
+      const Eigen::Isometry3s& T_body = bodyTransforms[bodyIndex + j];
+      for (std::size_t k = 0; k < body->getNumShapeNodes(); k++)
+      {
+        mAsyncShapeTransforms.push_back(
+            T_body * body->getShapeNode(k)->getRelativeTransform());
+      }
+    }
+    bodyIndex += numBodies;
+
+    renderSkeletonShapes(
+        skel,
+        mAsyncPrefix,
+        Eigen::Vector4s::Ones() * -1,
+        mAsyncLayer,
+        mAsyncShapeTransforms);
+  }
+}
+
 } // namespace server
 } // namespace dart
\ No newline at end of file
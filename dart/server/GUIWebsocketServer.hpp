@@ -1,8 +1,11 @@
 #ifndef DART_GUI_SERVER
 #define DART_GUI_SERVER
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <sstream>
@@ -18,6 +21,7 @@
 #include <assimp/cimport.h>
 #include <assimp/postprocess.h>
 
+#include "dart/common/Memory.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/MeshShape.hpp"
 #include "dart/server/GUIStateMachine.hpp"
@@ -39,6 +43,17 @@ class TrajectoryRollout;
 
 namespace server {
 
+/// This serves a GUIStateMachine to web clients over a websocket.
+///
+/// One server can also host many independent sessions, each with its own
+/// GUI state, listeners and flush rate, which is how a single port can show
+/// hundreds of jobs to different viewers. getSession() returns a session as
+/// another GUIWebsocketServer, which can be drawn to like any other. Clients
+/// pick a session with the path they connect to, so
+/// ws://localhost:8070/job-17 views the session "job-17", and connecting to
+/// the root path views the server's own state. Every session shares the one
+/// networking thread and the one flush thread of the server, and a session
+/// with no viewers doesn't render anything or send anything.
 class GUIWebsocketServer : public GUIStateMachine
 {
 public:
@@ -56,9 +71,41 @@ public:
   /// Returns true if we're serving
   bool isServing();
 
-  /// This flushes at a fixed framerate, not too fast to overwhelm the web GUI
+  /// This flushes the server and all of its sessions, each at its own
+  /// framerate, not too fast to overwhelm the web GUI
   void flushThread();
 
+  /// This returns the session called `name`, creating it if it doesn't exist
+  /// yet. Clients connected to ws://<host>:<port>/<name> see its state.
+  /// Sessions outlive calls to serve() and stopServing(), and stay around
+  /// until closeSession().
+  std::shared_ptr<GUIWebsocketServer> getSession(const std::string& name);
+
+  /// Returns true if there's a session called `name`
+  bool hasSession(const std::string& name);
+
+  /// This removes the session called `name`. Its viewers stay connected, but
+  /// they won't get any more updates.
+  void closeSession(const std::string& name);
+
+  /// This returns the names of all the sessions on this server
+  std::vector<std::string> getSessionNames();
+
+  /// This returns the name of this session, which is "" for the server itself
+  const std::string& getSessionName() const;
+
+  /// This sets how often the flush thread sends this session's changes to its
+  /// viewers. This defaults to every 20ms (50fps), and dashboards that are
+  /// mostly idle can set it much higher.
+  void setFlushInterval(int milliseconds);
+
+  /// This returns how often the flush thread sends this session's changes,
+  /// in milliseconds
+  int getFlushInterval() const;
+
+  /// This returns the number of clients viewing this session
+  std::size_t getNumViewers();
+
   /// This sleeps until we're done serving, without busy-waiting in a loop. It
   /// wakes up occassionally to call the `checkForSignals` callback, where you
   /// can throw an exception to shut down the program.
@@ -88,6 +135,17 @@ public:
   /// This sends the current list of commands to the web GUI
   void flush();
 
+  /// This sends messages as raw protobuf bytes in binary websocket frames,
+  /// instead of base64 text. Each binary frame starts with a one byte header:
+  /// 0 for a plain CommandList, 1 for a zlib deflated one. Only web clients
+  /// built from this version onwards can read binary frames.
+  void setBinaryFrames(bool binary);
+
+  /// When sending binary frames, this deflates every message that shrinks from
+  /// it. This trades server CPU for less bandwidth, which pays off when
+  /// streaming to a remote browser.
+  void setDeflateFrames(bool deflate);
+
   /// This completely resets the web GUI, deleting all objects, UI elements, and
   /// listeners
   void clear() override;
@@ -105,7 +163,66 @@ public:
   void registerScreenResizeListener(
       std::function<void(Eigen::Vector2i)> listener);
 
+  /// This sets up `world` to get drawn from the flush thread, instead of from
+  /// the simulation thread. Once this is set, the simulation loop only needs
+  /// to call publishWorldPoses() after each step. The flush thread turns the
+  /// most recent poses into GUI commands at its own framerate, like
+  /// renderWorld() (but without contact forces), and skips any poses that
+  /// were overwritten before it got to them.
+  ///
+  /// This and stopRenderingAsync() should be called from the same thread as
+  /// publishWorldPoses(). The flush thread still reads the shapes and visual
+  /// aspects of `world` while drawing, so skeletons and shapes shouldn't be
+  /// added or removed while this is on.
+  void renderWorldAsync(
+      const std::shared_ptr<simulation::World>& world,
+      const std::string& prefix = "world",
+      const std::string& layer = "");
+
+  /// This copies the world transform of every body in the world passed to
+  /// renderWorldAsync() into a spare buffer, and hands it to the flush
+  /// thread. This never takes a lock or waits on the flush thread, and once
+  /// the buffers have grown to fit the world it doesn't allocate either, so
+  /// it's cheap enough to call on every step. This does nothing if
+  /// renderWorldAsync() hasn't been called.
+  void publishWorldPoses();
+
+  /// This stops drawing the world passed to renderWorldAsync(). Objects that
+  /// were already drawn stay where they are.
+  void stopRenderingAsync();
+
 protected:
+  /// This creates a session called `name`, which sends through `parent`'s
+  /// server
+  GUIWebsocketServer(GUIWebsocketServer* parent, const std::string& name);
+
+  /// This returns the WebsocketServer this session sends through, or nullptr
+  /// if there isn't one running
+  WebsocketServer* getServer();
+
+  /// This runs `fn` on the session that `conn` is viewing, if it exists
+  void withSession(
+      ClientConnection conn,
+      const std::function<void(GUIWebsocketServer&)>& fn);
+
+  /// This sends the full state of this session to a new viewer, and calls
+  /// the connection listeners
+  void onConnect(ClientConnection conn);
+
+  /// This sends the full state of this session to a viewer that fell too far
+  /// behind
+  void onResync(ClientConnection conn);
+
+  /// This handles an event sent by a viewer of this session
+  void onMessage(const Json::Value& args);
+
+  /// This is called from the flush thread. If it's time for this session to
+  /// flush, this draws and sends its queued commands. Either way, it pulls
+  /// `wake` in to when this session next needs to flush.
+  void flushIfDue(
+      std::chrono::steady_clock::time_point now,
+      std::chrono::steady_clock::time_point& wake);
+
   int mPort;
   bool mServing;
   bool mStartingServer;
@@ -116,6 +233,42 @@ protected:
   WebsocketServer* mServer;
   std::mutex mServingMutex;
   std::condition_variable mServingConditionValue;
+  bool mBinaryFrames;
+  bool mDeflateFrames;
+
+  /// This sends a serialized CommandList to one client, or to everyone if
+  /// `conn` is null, in whichever framing we've been configured to use
+  void sendCommandList(
+      const std::string& serialized, ClientConnection* conn = nullptr);
+
+  /// This is called from the flush thread, and draws the newest poses passed
+  /// to publishWorldPoses(), if there are any we haven't drawn yet
+  void renderPublishedPoses();
+
+  // Poses handed from publishWorldPoses() to the flush thread. The three
+  // snapshots form a triple buffer: the simulation thread owns
+  // mPoseWriteIndex and the flush thread owns mPoseReadIndex, and they swap
+  // with whichever one is in mPoseSharedIndex. POSE_FRESH gets set in
+  // mPoseSharedIndex when the simulation thread swaps in new poses, and
+  // cleared when the flush thread takes them.
+  static constexpr int POSE_INDEX_MASK = 3;
+  static constexpr int POSE_FRESH = 4;
+  struct PoseSnapshot
+  {
+    common::aligned_vector<Eigen::Isometry3s> bodyTransforms;
+  };
+  PoseSnapshot mPoseSnapshots[3];
+  int mPoseWriteIndex;
+  int mPoseReadIndex;
+  std::atomic<int> mPoseSharedIndex;
+  // This is only touched by the simulation thread
+  std::shared_ptr<simulation::World> mPublishedWorld;
+  // This protects the settings the flush thread draws with
+  std::mutex mAsyncRenderMutex;
+  std::shared_ptr<simulation::World> mAsyncWorld;
+  std::string mAsyncPrefix;
+  std::string mAsyncLayer;
+  common::aligned_vector<Eigen::Isometry3s> mAsyncShapeTransforms;
 
   // Listeners
   std::vector<std::function<void()>> mConnectionListeners;
@@ -130,6 +283,19 @@ protected:
   std::vector<std::function<void(Eigen::Vector2i)>> mScreenResizeListeners;
   // This is a list of all the objects with mouse interaction enabled
   std::unordered_set<std::string> mMouseInteractionEnabled;
+
+  // Sessions. mParent is null for the server itself, and gets cleared on a
+  // session when it's closed or its server goes away.
+  std::atomic<GUIWebsocketServer*> mParent;
+  std::string mSessionName;
+  std::mutex mSessionsMutex;
+  std::map<std::string, std::shared_ptr<GUIWebsocketServer>> mSessions;
+  // This is only touched by the flush thread, and is kept around so the flush
+  // thread doesn't allocate on every frame
+  std::vector<std::shared_ptr<GUIWebsocketServer>> mFlushSessions;
+  std::atomic<int> mFlushIntervalMs;
+  // This is only touched by the flush thread
+  std::chrono::steady_clock::time_point mNextFlush;
 };
 
 } // namespace server
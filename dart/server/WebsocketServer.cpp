@@ -1,8 +1,10 @@
 #include "WebsocketServer.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <iostream>
+#include <utility>
 
 #include <websocketpp/logger/levels.hpp>
 
@@ -29,7 +31,25 @@ string WebsocketServer::stringifyJson(const Json::Value& val)
   return Json::writeString(wbuilder, val);
 }
 
-WebsocketServer::WebsocketServer() : mRunning(false)
+string WebsocketServer::sessionFromResource(const string& resource)
+{
+  string session = resource.substr(0, resource.find('?'));
+  size_t begin = session.find_first_not_of('/');
+  if (begin == string::npos)
+    return "";
+  size_t end = session.find_last_not_of('/');
+  return session.substr(begin, end - begin + 1);
+}
+
+WebsocketServer::WebsocketServer()
+  : mRunning(false),
+    mSignalSet(nullptr),
+    mMaxQueuedMessages(256),
+    mMaxBufferedBytes(1 << 20),
+    mSlowClientPolicy(SlowClientPolicy::DROP_OLDEST),
+    mDrainScheduled(false),
+    mNumDroppedMessages(0),
+    mDrainTimer(eventLoop)
 {
   // Wire up our event handlers
   this->endpoint.set_open_handler(
@@ -111,6 +131,62 @@ size_t WebsocketServer::numConnections()
   return this->openConnections.size();
 }
 
+size_t WebsocketServer::numConnections(const string& session)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  auto it = this->sessionConnectionCounts.find(session);
+  if (it == this->sessionConnectionCounts.end())
+    return 0;
+  return it->second;
+}
+
+vector<ClientConnection> WebsocketServer::getConnections(const string& session)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  vector<ClientConnection> connections;
+  for (auto& pair : this->outboundQueues)
+  {
+    if (pair.second.session == session)
+      connections.push_back(pair.first);
+  }
+  return connections;
+}
+
+string WebsocketServer::getSession(ClientConnection conn)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  auto it = this->outboundQueues.find(conn);
+  if (it == this->outboundQueues.end())
+    return "";
+  return it->second.session;
+}
+
+void WebsocketServer::setMaxQueuedMessages(size_t maxQueuedMessages)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  mMaxQueuedMessages = std::max<size_t>(maxQueuedMessages, 1);
+}
+
+void WebsocketServer::setMaxBufferedBytes(size_t maxBufferedBytes)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  mMaxBufferedBytes = maxBufferedBytes;
+}
+
+void WebsocketServer::setSlowClientPolicy(SlowClientPolicy policy)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  mSlowClientPolicy = policy;
+}
+
+long WebsocketServer::numDroppedMessages()
+{
+  return mNumDroppedMessages.load();
+}
+
 void WebsocketServer::sendJsonObject(
     ClientConnection conn,
     const string& messageType,
@@ -120,62 +196,269 @@ void WebsocketServer::sendJsonObject(
   Json::Value messageData = arguments;
   messageData[MESSAGE_FIELD] = messageType;
 
-  // Send the JSON data to the client (will happen on the networking thread's
-  // event loop)
-  this->endpoint.send(
-      conn,
-      WebsocketServer::stringifyJson(messageData),
+  this->enqueue(
+      &conn,
+      std::make_shared<const string>(
+          WebsocketServer::stringifyJson(messageData)),
       websocketpp::frame::opcode::text);
 }
 
 // Sends a raw text message to a specific client
 void WebsocketServer::send(ClientConnection conn, const string& message)
 {
-  // Send the message data to the client (will happen on the networking thread's
-  // event loop)
-  try
+  this->enqueue(
+      &conn,
+      std::make_shared<const string>(message),
+      websocketpp::frame::opcode::text);
+}
+
+// Sends a raw binary message to a specific client
+void WebsocketServer::sendBinary(ClientConnection conn, const string& message)
+{
+  this->enqueue(
+      &conn,
+      std::make_shared<const string>(message),
+      websocketpp::frame::opcode::binary);
+}
+
+void WebsocketServer::broadcastJsonObject(
+    const string& messageType, const Json::Value& arguments)
+{
+  // Copy the argument values, and bundle the message type into the object
+  Json::Value messageData = arguments;
+  messageData[MESSAGE_FIELD] = messageType;
+
+  this->enqueue(
+      nullptr,
+      std::make_shared<const string>(
+          WebsocketServer::stringifyJson(messageData)),
+      websocketpp::frame::opcode::text);
+}
+
+// Broadcast a raw text message to all clients
+void WebsocketServer::broadcast(const string& message)
+{
+  this->enqueue(
+      nullptr,
+      std::make_shared<const string>(message),
+      websocketpp::frame::opcode::text);
+}
+
+// Broadcast a raw binary message to all clients
+void WebsocketServer::broadcastBinary(const string& message)
+{
+  this->enqueue(
+      nullptr,
+      std::make_shared<const string>(message),
+      websocketpp::frame::opcode::binary);
+}
+
+// Broadcast a raw text message to the clients connected to a session
+void WebsocketServer::broadcastToSession(
+    const string& session, const string& message)
+{
+  this->enqueue(
+      nullptr,
+      std::make_shared<const string>(message),
+      websocketpp::frame::opcode::text,
+      &session);
+}
+
+// Broadcast a raw binary message to the clients connected to a session
+void WebsocketServer::broadcastBinaryToSession(
+    const string& session, const string& message)
+{
+  this->enqueue(
+      nullptr,
+      std::make_shared<const string>(message),
+      websocketpp::frame::opcode::binary,
+      &session);
+}
+
+void WebsocketServer::enqueue(
+    ClientConnection* conn,
+    std::shared_ptr<const string> payload,
+    websocketpp::frame::opcode::value opcode,
+    const string* session)
+{
+  vector<ClientConnection> needResync;
   {
-    this->endpoint.send(conn, message, websocketpp::frame::opcode::text);
+    // Prevent concurrent access to the list of open connections from multiple
+    // threads
+    std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+    if (conn != nullptr)
+    {
+      auto it = this->outboundQueues.find(*conn);
+      // If the client has already disconnected, there's nothing to do
+      if (it == this->outboundQueues.end())
+        return;
+      if (this->pushMessage(it->second, payload, opcode))
+        needResync.push_back(it->first);
+    }
+    else
+    {
+      for (auto& pair : this->outboundQueues)
+      {
+        // Clients waiting on a resync would only get deltas they can't apply
+        if (pair.second.awaitingResync)
+          continue;
+        if (session != nullptr && pair.second.session != *session)
+          continue;
+        if (this->pushMessage(pair.second, payload, opcode))
+          needResync.push_back(pair.first);
+      }
+    }
   }
-  catch (websocketpp::exception const& e)
+
+  // Run the resync handlers on the networking thread, so they can take their
+  // own locks without worrying about the caller's
+  for (auto resyncConn : needResync)
   {
-    dterr << e.what() << std::endl;
-    dterr << "Exception thrown from endpoint.send(). Continuing." << std::endl;
+    this->eventLoop.post([this, resyncConn]() {
+      for (auto handler : this->resyncHandlers)
+      {
+        handler(resyncConn);
+      }
+      std::lock_guard<std::mutex> lock(this->connectionListMutex);
+      auto it = this->outboundQueues.find(resyncConn);
+      if (it != this->outboundQueues.end())
+        it->second.awaitingResync = false;
+    });
   }
-  catch (...)
+
+  this->scheduleDrain();
+}
+
+bool WebsocketServer::pushMessage(
+    OutboundQueue& queue,
+    const std::shared_ptr<const string>& payload,
+    websocketpp::frame::opcode::value opcode)
+{
+  if (queue.messages.size() >= mMaxQueuedMessages)
   {
-    dterr << "Hit unknown error in endpoint.send(). Continuing." << std::endl;
+    switch (mSlowClientPolicy)
+    {
+      case SlowClientPolicy::DROP_OLDEST:
+        queue.messages.pop_front();
+        mNumDroppedMessages++;
+        break;
+      case SlowClientPolicy::DROP_NEWEST:
+        mNumDroppedMessages++;
+        return false;
+      case SlowClientPolicy::RESYNC:
+        // The new message goes too, since it's a delta on top of the ones
+        // we're dropping. The resync snapshot will cover it.
+        mNumDroppedMessages += queue.messages.size() + 1;
+        queue.messages.clear();
+        queue.awaitingResync = true;
+        return true;
+    }
   }
+  queue.messages.push_back(OutboundMessage{payload, opcode});
+  return false;
 }
 
-void WebsocketServer::broadcastJsonObject(
-    const string& messageType, const Json::Value& arguments)
+void WebsocketServer::releaseSession(const string& session)
 {
-  // Prevent concurrent access to the list of open connections from multiple
-  // threads
-  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  auto it = this->sessionConnectionCounts.find(session);
+  if (it == this->sessionConnectionCounts.end())
+    return;
+  if (--it->second == 0)
+    this->sessionConnectionCounts.erase(it);
+}
 
-  for (auto conn : this->openConnections)
+void WebsocketServer::scheduleDrain()
+{
+  if (!mDrainScheduled.exchange(true))
   {
-    this->sendJsonObject(conn, messageType, arguments);
+    this->eventLoop.post([this]() { this->drainQueues(); });
   }
 }
 
-// Broadcast a raw text message to all clients
-void WebsocketServer::broadcast(const string& message)
+void WebsocketServer::drainQueues()
 {
-  // Prevent concurrent access to the list of open connections from multiple
-  // threads
-  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  mDrainScheduled = false;
 
-  for (auto conn : this->openConnections)
+  vector<std::pair<ClientConnection, OutboundMessage>> toSend;
+  bool pending = false;
   {
-    this->send(conn, message);
+    // Prevent concurrent access to the list of open connections from multiple
+    // threads
+    std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+    for (auto& pair : this->outboundQueues)
+    {
+      std::deque<OutboundMessage>& messages = pair.second.messages;
+      if (messages.empty())
+        continue;
+
+      websocketpp::lib::error_code error;
+      auto con = this->endpoint.get_con_from_hdl(pair.first, error);
+      if (error || !con)
+      {
+        messages.clear();
+        continue;
+      }
+
+      // Leave messages in our queue, where the slow client policy can get at
+      // them, rather than piling them up in the socket layer's unbounded one
+      size_t buffered = con->get_buffered_amount();
+      while (!messages.empty() && buffered < mMaxBufferedBytes)
+      {
+        buffered += messages.front().payload->size();
+        toSend.emplace_back(pair.first, std::move(messages.front()));
+        messages.pop_front();
+      }
+      if (!messages.empty())
+        pending = true;
+    }
+  }
+
+  for (auto& pair : toSend)
+  {
+    this->transmit(pair.first, *pair.second.payload, pair.second.opcode);
+  }
+
+  // There's no callback for when a client's socket buffer drains, so poll
+  if (pending)
+  {
+    mDrainTimer.expires_from_now(std::chrono::milliseconds(5));
+    mDrainTimer.async_wait([this](const asio::error_code& error) {
+      if (!error)
+        this->drainQueues();
+    });
+  }
+}
+
+void WebsocketServer::transmit(
+    ClientConnection conn,
+    const string& message,
+    websocketpp::frame::opcode::value opcode)
+{
+  try
+  {
+    this->endpoint.send(conn, message, opcode);
+  }
+  catch (websocketpp::exception const& e)
+  {
+    dterr << e.what() << std::endl;
+    dterr << "Exception thrown from endpoint.send(). Continuing." << std::endl;
+  }
+  catch (...)
+  {
+    dterr << "Hit unknown error in endpoint.send(). Continuing." << std::endl;
   }
 }
 
 void WebsocketServer::onOpen(ClientConnection conn)
 {
+  string session;
+  websocketpp::lib::error_code error;
+  auto con = this->endpoint.get_con_from_hdl(conn, error);
+  if (!error && con)
+    session = WebsocketServer::sessionFromResource(con->get_resource());
+
   {
     // Prevent concurrent access to the list of open connections from multiple
     // threads
@@ -183,6 +466,9 @@ void WebsocketServer::onOpen(ClientConnection conn)
 
     // Add the connection handle to our list of open connections
     this->openConnections.push_back(conn);
+    this->outboundQueues[conn] = OutboundQueue();
+    this->outboundQueues[conn].session = session;
+    this->sessionConnectionCounts[session]++;
   }
 
   // Invoke any registered handlers
@@ -225,6 +511,28 @@ void WebsocketServer::onClose(ClientConnection conn)
     // Truncate the connections vector to erase the removed elements
     this->openConnections.resize(
         std::distance(openConnections.begin(), newEnd));
+
+    // Drop anything we were still holding for this client, and any other
+    // clients that have gone away
+    auto closed = this->outboundQueues.find(conn);
+    if (closed != this->outboundQueues.end())
+    {
+      this->releaseSession(closed->second.session);
+      this->outboundQueues.erase(closed);
+    }
+    for (auto it = this->outboundQueues.begin();
+         it != this->outboundQueues.end();)
+    {
+      if (it->first.expired())
+      {
+        this->releaseSession(it->second.session);
+        it = this->outboundQueues.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
   }
 
   // Invoke any registered handlers
@@ -4,12 +4,16 @@
 // We need to define this when using the Asio library without Boost
 #define ASIO_STANDALONE
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
+#include <asio/steady_timer.hpp>
 #include <json/json.h>
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
@@ -23,6 +27,19 @@ typedef websocketpp::connection_hdl ClientConnection;
 class WebsocketServer
 {
 public:
+  // What to do with a new message when a client's outbound queue is full
+  enum class SlowClientPolicy
+  {
+    // Drop the oldest queued message to make room for the new one
+    DROP_OLDEST,
+    // Drop the new message, and keep what's already queued
+    DROP_NEWEST,
+    // Drop everything queued for the client, skip it for broadcasts until the
+    // resync handlers have run, and let them send it a fresh snapshot. Use this
+    // when messages are deltas that can't be dropped one at a time.
+    RESYNC
+  };
+
   WebsocketServer();
   bool run(int port);
   void stop();
@@ -30,6 +47,19 @@ public:
   // Returns the number of currently connected clients
   size_t numConnections();
 
+  // Clients pick a session with the path they connect to, so
+  // ws://localhost:8070/job-17 joins the session "job-17". Connecting to the
+  // root path joins the session "".
+
+  // Returns the number of clients connected to a session
+  size_t numConnections(const string& session);
+
+  // Returns the clients connected to a session
+  vector<ClientConnection> getConnections(const string& session);
+
+  // Returns the session a client connected to, or "" if it's gone
+  string getSession(ClientConnection conn);
+
   // Registers a callback for when a client connects
   template <typename CallbackTy>
   void connect(CallbackTy handler)
@@ -57,9 +87,35 @@ public:
         [this, handler]() { this->messageHandlers.push_back(handler); });
   }
 
+  // Registers a callback for when a client fell too far behind under the
+  // RESYNC policy, and needs a fresh snapshot sent to it
+  template <typename CallbackTy>
+  void resync(CallbackTy handler)
+  {
+    // Make sure we only access the handlers list from the networking thread
+    this->eventLoop.post(
+        [this, handler]() { this->resyncHandlers.push_back(handler); });
+  }
+
+  // Sets how many messages can wait in each client's outbound queue before
+  // the slow client policy kicks in
+  void setMaxQueuedMessages(size_t maxQueuedMessages);
+
+  // Sets how many bytes we let the socket layer hold for each client before we
+  // start holding messages back in that client's outbound queue
+  void setMaxBufferedBytes(size_t maxBufferedBytes);
+
+  // Sets what to do when a client's outbound queue is full
+  void setSlowClientPolicy(SlowClientPolicy policy);
+
+  // Returns the number of messages dropped because clients were too slow
+  long numDroppedMessages();
+
+  // None of the send or broadcast methods below block on the network. They
+  // push the message onto each client's bounded outbound queue, and the
+  // queues are drained on the thread that called WebsocketServer::run().
+
   // Sends a message to an individual client
-  //(Note: the data transmission will take place on the thread that called
-  // WebsocketServer::run())
   void sendJsonObject(
       ClientConnection conn,
       const string& messageType,
@@ -68,23 +124,88 @@ public:
   // Sends a raw text message to a specific client
   void send(ClientConnection conn, const string& message);
 
-  // Sends a message to all connected clients
-  //(Note: the data transmission will take place on the thread that called
-  // WebsocketServer::run())
+  // Sends a raw binary message to a specific client
+  void sendBinary(ClientConnection conn, const string& message);
+
+  // Sends a message to all connected clients. The JSON is only stringified
+  // once, no matter how many clients there are.
   void broadcastJsonObject(
       const string& messageType, const Json::Value& arguments);
 
   // Broadcast a raw text message to all clients
   void broadcast(const string& message);
 
+  // Broadcast a raw binary message to all clients
+  void broadcastBinary(const string& message);
+
+  // Broadcast a raw text message to the clients connected to a session
+  void broadcastToSession(const string& session, const string& message);
+
+  // Broadcast a raw binary message to the clients connected to a session
+  void broadcastBinaryToSession(const string& session, const string& message);
+
 protected:
   static Json::Value parseJson(const string& json);
   static string stringifyJson(const Json::Value& val);
 
+  // Turns the path a client connected to into a session name, by trimming
+  // slashes and dropping any query string
+  static string sessionFromResource(const string& resource);
+
   void onOpen(ClientConnection conn);
   void onClose(ClientConnection conn);
   void onMessage(ClientConnection conn, WebsocketEndpoint::message_ptr msg);
 
+  struct OutboundMessage
+  {
+    // This is shared between every client a message was broadcast to
+    std::shared_ptr<const string> payload;
+    websocketpp::frame::opcode::value opcode;
+  };
+
+  struct OutboundQueue
+  {
+    std::deque<OutboundMessage> messages;
+    // Under the RESYNC policy, this is true from when we dropped the backlog
+    // until the resync handlers have run
+    bool awaitingResync = false;
+    // The session this client connected to
+    string session;
+  };
+
+  // Pushes a message onto one client's queue (or all of them, if `conn` is
+  // null, or all of those in `session`, if that isn't null), and schedules a
+  // drain on the networking thread
+  void enqueue(
+      ClientConnection* conn,
+      std::shared_ptr<const string> payload,
+      websocketpp::frame::opcode::value opcode,
+      const string* session = nullptr);
+
+  // Pushes a message onto a single queue, applying the slow client policy.
+  // Returns true if the client needs a resync. Must hold connectionListMutex.
+  bool pushMessage(
+      OutboundQueue& queue,
+      const std::shared_ptr<const string>& payload,
+      websocketpp::frame::opcode::value opcode);
+
+  // Drops a client from the count for its session. Must hold
+  // connectionListMutex.
+  void releaseSession(const string& session);
+
+  // Schedules drainQueues() on the networking thread, if it isn't already
+  void scheduleDrain();
+
+  // Hands queued messages to the socket layer, for every client that isn't
+  // already holding too many unsent bytes. Runs on the networking thread.
+  void drainQueues();
+
+  // Hands a single message to the socket layer. Runs on the networking thread.
+  void transmit(
+      ClientConnection conn,
+      const string& message,
+      websocketpp::frame::opcode::value opcode);
+
   bool mRunning;
 
 public:
@@ -93,11 +214,26 @@ public:
 protected:
   WebsocketEndpoint endpoint;
   vector<ClientConnection> openConnections;
+  // This is guarded by connectionListMutex too
+  map<ClientConnection, OutboundQueue, std::owner_less<ClientConnection>>
+      outboundQueues;
+  // The number of clients connected to each session, so looking up how many
+  // viewers a session has doesn't scan every connection. This is guarded by
+  // connectionListMutex too.
+  map<string, size_t> sessionConnectionCounts;
   std::mutex connectionListMutex;
   asio::signal_set* mSignalSet;
 
+  size_t mMaxQueuedMessages;
+  size_t mMaxBufferedBytes;
+  SlowClientPolicy mSlowClientPolicy;
+  std::atomic<bool> mDrainScheduled;
+  std::atomic<long> mNumDroppedMessages;
+  asio::steady_timer mDrainTimer;
+
   vector<std::function<void(ClientConnection)>> connectHandlers;
   vector<std::function<void(ClientConnection)>> disconnectHandlers;
+  vector<std::function<void(ClientConnection)>> resyncHandlers;
   vector<std::function<void(ClientConnection, const Json::Value&)>>
       messageHandlers;
 };
@@ -38,15 +38,169 @@
 
 #include "dart/simulation/Recording.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
+#include <sys/stat.h>
+#include <sys/types.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define DART_RECORDING_USE_MMAP
+#endif
+
+#include "dart/common/Console.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 
 namespace dart {
 namespace simulation {
 
+namespace {
+
+/// The file starts with these 4 bytes, then a uint32 version, a uint32 count
+/// of skeletons, and a uint32 count of DOFs for each skeleton, padded to 8
+/// bytes. After that come the chunks, each of which is a uint32 frame count,
+/// a uint32 stride, a uint64 contact count, the positions (doubles), the
+/// contact starts (uint32s, padded to 8 bytes), and the contacts (doubles).
+const char RECORDING_MAGIC[4] = {'N', 'R', 'E', 'C'};
+const uint32_t RECORDING_VERSION = 1;
+const std::size_t CHUNK_HEADER_BYTES = 16;
+
+std::size_t alignTo8(std::size_t _bytes)
+{
+  return (_bytes + 7) & ~static_cast<std::size_t>(7);
+}
+
+std::size_t getHeaderBytes(std::size_t _numSkeletons)
+{
+  return alignTo8(12 + 4 * _numSkeletons);
+}
+
+std::size_t getContactStartsBytes(int _numFrames)
+{
+  return alignTo8(4 * (static_cast<std::size_t>(_numFrames) + 1));
+}
+
+void writeHeader(std::ostream& _out, const std::vector<int>& _dofs)
+{
+  _out.write(RECORDING_MAGIC, 4);
+  uint32_t version = RECORDING_VERSION;
+  uint32_t numSkeletons = _dofs.size();
+  _out.write(reinterpret_cast<const char*>(&version), 4);
+  _out.write(reinterpret_cast<const char*>(&numSkeletons), 4);
+  for (int dofs : _dofs)
+  {
+    uint32_t value = dofs;
+    _out.write(reinterpret_cast<const char*>(&value), 4);
+  }
+  const char zeros[8] = {0};
+  std::size_t written = 12 + 4 * _dofs.size();
+  _out.write(zeros, getHeaderBytes(_dofs.size()) - written);
+}
+
+/// This writes a chunk, and returns the number of bytes written
+std::size_t writeChunk(
+    std::ostream& _out,
+    int _numFrames,
+    int _stride,
+    const double* _positions,
+    const uint32_t* _contactStarts,
+    const double* _contacts)
+{
+  uint32_t numFrames = _numFrames;
+  uint32_t stride = _stride;
+  uint64_t numContacts = _contactStarts[_numFrames];
+  _out.write(reinterpret_cast<const char*>(&numFrames), 4);
+  _out.write(reinterpret_cast<const char*>(&stride), 4);
+  _out.write(reinterpret_cast<const char*>(&numContacts), 8);
+
+  std::size_t positionsBytes
+      = sizeof(double) * static_cast<std::size_t>(_numFrames) * _stride;
+  _out.write(reinterpret_cast<const char*>(_positions), positionsBytes);
+
+  std::size_t startsBytes = 4 * (static_cast<std::size_t>(_numFrames) + 1);
+  _out.write(reinterpret_cast<const char*>(_contactStarts), startsBytes);
+  const char zeros[8] = {0};
+  _out.write(zeros, getContactStartsBytes(_numFrames) - startsBytes);
+
+  std::size_t contactsBytes = sizeof(double) * 6 * numContacts;
+  _out.write(reinterpret_cast<const char*>(_contacts), contactsBytes);
+
+  return CHUNK_HEADER_BYTES + positionsBytes
+         + getContactStartsBytes(_numFrames) + contactsBytes;
+}
+
+} // namespace
+
+//==============================================================================
+/// The bytes of a recording file, either memory-mapped or, where we can't map
+/// files, read into memory we own
+struct Recording::MappedFile
+{
+  MappedFile() : mapped(nullptr), size(0)
+  {
+  }
+
+  ~MappedFile()
+  {
+#ifdef DART_RECORDING_USE_MMAP
+    if (mapped != nullptr)
+      munmap(mapped, size);
+#endif
+  }
+
+  MappedFile(const MappedFile& _other) = delete;
+  MappedFile& operator=(const MappedFile& _other) = delete;
+
+  const char* data() const
+  {
+    return mapped != nullptr ? static_cast<const char*>(mapped)
+                             : reinterpret_cast<const char*>(owned.data());
+  }
+
+  static std::shared_ptr<MappedFile> open(const std::string& _path)
+  {
+    struct stat info;
+    if (stat(_path.c_str(), &info) != 0)
+      return nullptr;
+
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    file->size = info.st_size;
+    if (file->size == 0)
+      return file;
+#ifdef DART_RECORDING_USE_MMAP
+    const int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return nullptr;
+    void* mapped = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (mapped == MAP_FAILED)
+      return nullptr;
+    file->mapped = mapped;
+#else
+    // Doubles, so the chunks inside stay aligned
+    file->owned.resize((file->size + 7) / 8);
+    std::ifstream in(_path, std::ios::binary);
+    if (!in.read(reinterpret_cast<char*>(file->owned.data()), file->size))
+      return nullptr;
+#endif
+    return file;
+  }
+
+  void* mapped;
+  std::vector<double> owned;
+  std::size_t size;
+};
+
 //==============================================================================
 Recording::Recording(const std::vector<dynamics::SkeletonPtr>& _skeletons)
+  : mNumFrames(0), mSpillSize(0)
 {
   for (std::size_t i = 0; i < _skeletons.size(); i++)
     mNumGenCoordsForSkeletons.push_back(_skeletons[i]->getNumDofs());
@@ -54,6 +208,7 @@ Recording::Recording(const std::vector<dynamics::SkeletonPtr>& _skeletons)
 
 //==============================================================================
 Recording::Recording(const std::vector<int>& _skelDofs)
+  : mNumFrames(0), mSpillSize(0)
 {
   for (std::size_t i = 0; i < _skelDofs.size(); i++)
     mNumGenCoordsForSkeletons.push_back(_skelDofs[i]);
@@ -67,7 +222,7 @@ Recording::~Recording()
 //==============================================================================
 int Recording::getNumFrames() const
 {
-  return mBakedStates.size();
+  return mNumFrames;
 }
 
 //==============================================================================
@@ -85,10 +240,9 @@ int Recording::getNumDofs(int _skelIdx) const
 //==============================================================================
 int Recording::getNumContacts(int _frameIdx) const
 {
-  int totalDofs = 0;
-  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return (mBakedStates[_frameIdx].size() - totalDofs) / 6;
+  int numContacts;
+  getContactsData(_frameIdx, numContacts);
+  return numContacts;
 }
 
 //==============================================================================
@@ -97,7 +251,12 @@ Eigen::VectorXs Recording::getConfig(int _frameIdx, int _skelIdx) const
   int index = 0;
   for (int i = 0; i < _skelIdx; i++)
     index += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(index, getNumDofs(_skelIdx));
+  int stride;
+  const double* positions = getPositionsData(_frameIdx, stride);
+  assert(index + getNumDofs(_skelIdx) <= stride);
+  return Eigen::Map<const Eigen::VectorXd>(
+             positions + index, getNumDofs(_skelIdx))
+      .cast<s_t>();
 }
 
 //==============================================================================
@@ -106,36 +265,90 @@ s_t Recording::getGenCoord(int _frameIdx, int _skelIdx, int _dofIdx) const
   int index = 0;
   for (int i = 0; i < _skelIdx; i++)
     index += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx][index + _dofIdx];
+  int stride;
+  const double* positions = getPositionsData(_frameIdx, stride);
+  assert(index + _dofIdx < stride);
+  return positions[index + _dofIdx];
 }
 
 //==============================================================================
 Eigen::Vector3s Recording::getContactPoint(int _frameIdx, int _contactIdx) const
 {
-  int totalDofs = 0;
-  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(totalDofs + _contactIdx * 6, 3);
+  int numContacts;
+  const double* contacts = getContactsData(_frameIdx, numContacts);
+  assert(_contactIdx < numContacts);
+  return Eigen::Map<const Eigen::Vector3d>(contacts + _contactIdx * 6)
+      .cast<s_t>();
 }
 
 //==============================================================================
 Eigen::Vector3s Recording::getContactForce(int _frameIdx, int _contactIdx) const
 {
-  int totalDofs = 0;
-  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(totalDofs + _contactIdx * 6 + 3, 3);
+  int numContacts;
+  const double* contacts = getContactsData(_frameIdx, numContacts);
+  assert(_contactIdx < numContacts);
+  return Eigen::Map<const Eigen::Vector3d>(contacts + _contactIdx * 6 + 3)
+      .cast<s_t>();
 }
 
 //==============================================================================
 void Recording::clear() {
-  mBakedStates.clear();
+  mChunks.clear();
+  mNumFrames = 0;
+  mFile = nullptr;
+  mFilePath = "";
+  if (!mSpillPath.empty())
+  {
+    // Start the spill file over, with just a header
+    std::string spillPath = mSpillPath;
+    mSpillPath = "";
+    setSpillFile(spillPath);
+  }
 }
 
 //==============================================================================
 void Recording::addState(const Eigen::VectorXs& _state)
 {
-  mBakedStates.push_back(_state);
+  int stride = 0;
+  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
+    stride += mNumGenCoordsForSkeletons[i];
+  assert(_state.size() >= stride && (_state.size() - stride) % 6 == 0);
+
+  // Start a new chunk if the last one is full, or was recorded with a
+  // different set of skeletons
+  if (mChunks.empty() || mChunks.back().inFile
+      || mChunks.back().numFrames >= FRAMES_PER_CHUNK
+      || mChunks.back().stride != stride)
+  {
+    if (!mChunks.empty() && !mChunks.back().inFile && !mSpillPath.empty())
+      spillChunk(mChunks.back());
+
+    Chunk chunk;
+    chunk.firstFrame = mNumFrames;
+    chunk.numFrames = 0;
+    chunk.stride = stride;
+    chunk.inFile = false;
+    chunk.positionsOffset = 0;
+    chunk.contactStartsOffset = 0;
+    chunk.contactsOffset = 0;
+    chunk.positions.reserve(
+        static_cast<std::size_t>(FRAMES_PER_CHUNK) * stride);
+    chunk.contactStarts.reserve(FRAMES_PER_CHUNK + 1);
+    chunk.contactStarts.push_back(0);
+    mChunks.push_back(std::move(chunk));
+  }
+
+  Chunk& chunk = mChunks.back();
+  for (int i = 0; i < stride; i++)
+    chunk.positions.push_back(static_cast<double>(_state(i)));
+  for (int i = stride; i < _state.size(); i++)
+    chunk.contacts.push_back(static_cast<double>(_state(i)));
+  chunk.contactStarts.push_back(chunk.contacts.size() / 6);
+  chunk.numFrames++;
+  mNumFrames++;
+
+  if (chunk.numFrames >= FRAMES_PER_CHUNK && !mSpillPath.empty())
+    spillChunk(chunk);
 }
 
 //==============================================================================
@@ -147,6 +360,371 @@ void Recording::updateNumGenCoords(
     mNumGenCoordsForSkeletons.push_back(_skeletons[i]->getNumDofs());
 }
 
+//==============================================================================
+bool Recording::save(const std::string& _path) const
+{
+  if (!mSpillPath.empty() && _path == mSpillPath)
+  {
+    dterr << "[Recording::save] Can't overwrite the spill file " << _path
+          << ", which this recording is still appending to.\n";
+    return false;
+  }
+
+  // Write to a temporary file and rename it over _path, so that anybody who
+  // has _path mapped (including us) keeps seeing the old contents
+  std::string tempPath = _path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+      dterr << "[Recording::save] Couldn't open " << tempPath
+            << " for writing.\n";
+      return false;
+    }
+    writeHeader(out, mNumGenCoordsForSkeletons);
+    for (const Chunk& chunk : mChunks)
+    {
+      if (chunk.inFile)
+      {
+        const char* data = mFile->data();
+        writeChunk(
+            out,
+            chunk.numFrames,
+            chunk.stride,
+            reinterpret_cast<const double*>(data + chunk.positionsOffset),
+            reinterpret_cast<const uint32_t*>(
+                data + chunk.contactStartsOffset),
+            reinterpret_cast<const double*>(data + chunk.contactsOffset));
+      }
+      else
+      {
+        writeChunk(
+            out,
+            chunk.numFrames,
+            chunk.stride,
+            chunk.positions.data(),
+            chunk.contactStarts.data(),
+            chunk.contacts.data());
+      }
+    }
+    if (!out)
+    {
+      dterr << "[Recording::save] Failed writing " << tempPath << ".\n";
+      return false;
+    }
+  }
+  if (std::rename(tempPath.c_str(), _path.c_str()) != 0)
+  {
+    dterr << "[Recording::save] Couldn't move " << tempPath << " to " << _path
+          << ".\n";
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+std::shared_ptr<Recording> Recording::load(const std::string& _path)
+{
+  std::shared_ptr<MappedFile> file = MappedFile::open(_path);
+  if (!file || file->size < 12
+      || std::memcmp(file->data(), RECORDING_MAGIC, 4) != 0)
+  {
+    dterr << "[Recording::load] " << _path
+          << " isn't a recording written by Recording::save().\n";
+    return nullptr;
+  }
+
+  const char* data = file->data();
+  uint32_t version;
+  uint32_t numSkeletons;
+  std::memcpy(&version, data + 4, 4);
+  std::memcpy(&numSkeletons, data + 8, 4);
+  if (version != RECORDING_VERSION
+      || getHeaderBytes(numSkeletons) > file->size)
+  {
+    dterr << "[Recording::load] " << _path
+          << " has an unsupported version or a truncated header.\n";
+    return nullptr;
+  }
+  std::vector<int> dofs(numSkeletons);
+  for (uint32_t i = 0; i < numSkeletons; i++)
+  {
+    uint32_t value;
+    std::memcpy(&value, data + 12 + 4 * i, 4);
+    dofs[i] = value;
+  }
+
+  std::shared_ptr<Recording> recording = std::make_shared<Recording>(dofs);
+  std::size_t offset = getHeaderBytes(numSkeletons);
+  while (offset + CHUNK_HEADER_BYTES <= file->size)
+  {
+    uint32_t numFrames;
+    uint32_t stride;
+    uint64_t numContacts;
+    std::memcpy(&numFrames, data + offset, 4);
+    std::memcpy(&stride, data + offset + 4, 4);
+    std::memcpy(&numContacts, data + offset + 8, 8);
+
+    Chunk chunk;
+    chunk.firstFrame = recording->mNumFrames;
+    chunk.numFrames = numFrames;
+    chunk.stride = stride;
+    chunk.inFile = true;
+    chunk.positionsOffset = offset + CHUNK_HEADER_BYTES;
+    chunk.contactStartsOffset
+        = chunk.positionsOffset
+          + sizeof(double) * static_cast<std::size_t>(numFrames) * stride;
+    chunk.contactsOffset
+        = chunk.contactStartsOffset + getContactStartsBytes(numFrames);
+    offset = chunk.contactsOffset + sizeof(double) * 6 * numContacts;
+    if (offset > file->size)
+    {
+      dterr << "[Recording::load] " << _path
+            << " ends partway through a chunk. Keeping the "
+            << recording->mNumFrames << " frames before it.\n";
+      break;
+    }
+
+    recording->mNumFrames += numFrames;
+    recording->mChunks.push_back(std::move(chunk));
+  }
+
+  recording->mFile = file;
+  recording->mFilePath = _path;
+  return recording;
+}
+
+//==============================================================================
+bool Recording::setSpillFile(const std::string& _path)
+{
+  if (_path == mFilePath && mFile)
+  {
+    // Keep appending to the file we were loaded from. Only whole chunks were
+    // read from it, so it ends right after the last one.
+    uint32_t numSkeletons;
+    std::memcpy(&numSkeletons, mFile->data() + 8, 4);
+    std::size_t end = getHeaderBytes(numSkeletons);
+    for (const Chunk& chunk : mChunks)
+    {
+      if (chunk.inFile)
+      {
+        const uint32_t* starts = reinterpret_cast<const uint32_t*>(
+            mFile->data() + chunk.contactStartsOffset);
+        end = chunk.contactsOffset
+              + sizeof(double) * 6 * static_cast<std::size_t>(
+                    starts[chunk.numFrames]);
+      }
+    }
+    if (end != mFile->size)
+    {
+      dterr << "[Recording::setSpillFile] " << _path
+            << " has trailing bytes after its last chunk, so it can't be "
+               "appended to.\n";
+      return false;
+    }
+    mSpillPath = _path;
+    mSpillSize = end;
+  }
+  else
+  {
+    // Write out a fresh file, with every finished chunk we have so far
+    {
+      std::ofstream out(_path, std::ios::binary | std::ios::trunc);
+      if (!out)
+      {
+        dterr << "[Recording::setSpillFile] Couldn't open " << _path
+              << " for writing.\n";
+        return false;
+      }
+      writeHeader(out, mNumGenCoordsForSkeletons);
+    }
+    mSpillPath = _path;
+    mSpillSize = getHeaderBytes(mNumGenCoordsForSkeletons.size());
+
+    // Chunks already in another file have to be copied over, so pull them
+    // back into memory first. We move them one at a time, so this only ever
+    // holds one extra chunk.
+    std::shared_ptr<MappedFile> oldFile = mFile;
+    if (!remapSpillFile())
+    {
+      mSpillPath = "";
+      return false;
+    }
+    bool spilling = true;
+    for (std::size_t i = 0; i < mChunks.size(); i++)
+    {
+      Chunk& chunk = mChunks[i];
+      if (i == mChunks.size() - 1 && !chunk.inFile)
+        break;
+      if (chunk.inFile)
+      {
+        const char* data = oldFile->data();
+        const double* positions
+            = reinterpret_cast<const double*>(data + chunk.positionsOffset);
+        const uint32_t* starts = reinterpret_cast<const uint32_t*>(
+            data + chunk.contactStartsOffset);
+        const double* contacts
+            = reinterpret_cast<const double*>(data + chunk.contactsOffset);
+        chunk.positions.assign(
+            positions,
+            positions
+                + static_cast<std::size_t>(chunk.numFrames) * chunk.stride);
+        chunk.contactStarts.assign(starts, starts + chunk.numFrames + 1);
+        chunk.contacts.assign(
+            contacts, contacts + 6 * static_cast<std::size_t>(
+                                     starts[chunk.numFrames]));
+        chunk.inFile = false;
+      }
+      // If spilling fails partway, the rest of the chunks just stay in memory
+      if (spilling)
+        spilling = spillChunk(chunk);
+    }
+    if (!spilling)
+    {
+      mSpillPath = "";
+      return false;
+    }
+  }
+
+  // The open chunk may already be full, if it was filled before we had a
+  // spill file
+  if (!mChunks.empty() && !mChunks.back().inFile
+      && mChunks.back().numFrames >= FRAMES_PER_CHUNK)
+  {
+    return spillChunk(mChunks.back());
+  }
+  return true;
+}
+
+//==============================================================================
+int Recording::getNumFramesInMemory() const
+{
+  int numFrames = 0;
+  for (const Chunk& chunk : mChunks)
+  {
+    if (!chunk.inFile)
+      numFrames += chunk.numFrames;
+  }
+  return numFrames;
+}
+
+//==============================================================================
+const Recording::Chunk& Recording::getChunk(int _frameIdx) const
+{
+  assert(_frameIdx >= 0 && _frameIdx < mNumFrames);
+  auto it = std::upper_bound(
+      mChunks.begin(),
+      mChunks.end(),
+      _frameIdx,
+      [](int frame, const Chunk& chunk) { return frame < chunk.firstFrame; });
+  return *(it - 1);
+}
+
+//==============================================================================
+const double* Recording::getPositionsData(int _frameIdx, int& _stride) const
+{
+  const Chunk& chunk = getChunk(_frameIdx);
+  _stride = chunk.stride;
+  const std::size_t offset
+      = static_cast<std::size_t>(_frameIdx - chunk.firstFrame) * chunk.stride;
+  if (chunk.inFile)
+  {
+    return reinterpret_cast<const double*>(
+               mFile->data() + chunk.positionsOffset)
+           + offset;
+  }
+  return chunk.positions.data() + offset;
+}
+
+//==============================================================================
+const double* Recording::getContactsData(
+    int _frameIdx, int& _numContacts) const
+{
+  const Chunk& chunk = getChunk(_frameIdx);
+  const int local = _frameIdx - chunk.firstFrame;
+  const uint32_t* starts;
+  const double* contacts;
+  if (chunk.inFile)
+  {
+    starts = reinterpret_cast<const uint32_t*>(
+        mFile->data() + chunk.contactStartsOffset);
+    contacts = reinterpret_cast<const double*>(
+        mFile->data() + chunk.contactsOffset);
+  }
+  else
+  {
+    starts = chunk.contactStarts.data();
+    contacts = chunk.contacts.data();
+  }
+  _numContacts = starts[local + 1] - starts[local];
+  return contacts + 6 * static_cast<std::size_t>(starts[local]);
+}
+
+//==============================================================================
+bool Recording::spillChunk(Chunk& _chunk)
+{
+  assert(!_chunk.inFile);
+  std::size_t start = mSpillSize;
+  {
+    std::ofstream out(mSpillPath, std::ios::binary | std::ios::app);
+    if (!out)
+    {
+      dterr << "[Recording] Couldn't append to spill file " << mSpillPath
+            << ", keeping frames in memory.\n";
+      return false;
+    }
+    mSpillSize += writeChunk(
+        out,
+        _chunk.numFrames,
+        _chunk.stride,
+        _chunk.positions.data(),
+        _chunk.contactStarts.data(),
+        _chunk.contacts.data());
+    if (!out)
+    {
+      dterr << "[Recording] Failed writing spill file " << mSpillPath
+            << ", keeping frames in memory.\n";
+      mSpillSize = start;
+      return false;
+    }
+  }
+
+  std::shared_ptr<MappedFile> oldFile = mFile;
+  if (!remapSpillFile())
+  {
+    mFile = oldFile;
+    return false;
+  }
+
+  _chunk.inFile = true;
+  _chunk.positionsOffset = start + CHUNK_HEADER_BYTES;
+  _chunk.contactStartsOffset
+      = _chunk.positionsOffset
+        + sizeof(double) * static_cast<std::size_t>(_chunk.numFrames)
+              * _chunk.stride;
+  _chunk.contactsOffset
+      = _chunk.contactStartsOffset + getContactStartsBytes(_chunk.numFrames);
+  // Actually give the memory back, rather than just clearing
+  std::vector<double>().swap(_chunk.positions);
+  std::vector<uint32_t>().swap(_chunk.contactStarts);
+  std::vector<double>().swap(_chunk.contacts);
+  return true;
+}
+
+//==============================================================================
+bool Recording::remapSpillFile()
+{
+  std::shared_ptr<MappedFile> file = MappedFile::open(mSpillPath);
+  if (!file || file->size != mSpillSize)
+  {
+    dterr << "[Recording] Couldn't map spill file " << mSpillPath << ".\n";
+    return false;
+  }
+  mFile = file;
+  mFilePath = mSpillPath;
+  return true;
+}
+
 }  // namespace simulation
 }  // namespace dart
-
@@ -39,6 +39,9 @@
 #ifndef DART_SIMULATION_RECORDING_HPP_
 #define DART_SIMULATION_RECORDING_HPP_
 
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -54,9 +57,19 @@ class Skeleton;
 namespace simulation {
 
 /// \brief class Recording
+///
+/// Frames are stored in chunks of FRAMES_PER_CHUNK. Each chunk holds one
+/// contiguous array of generalized coordinates (the same stride for every
+/// frame) and a separate stream of contacts, so recording doesn't allocate per
+/// frame and never copies frames it already has. Recordings can be written to
+/// disk with save() and memory-mapped back with load(), and setSpillFile()
+/// moves each finished chunk out to disk as the recording grows.
 class Recording
 {
 public:
+  /// \brief Number of frames in each chunk
+  static constexpr int FRAMES_PER_CHUNK = 1024;
+
   /// \brief Create Recording with a list of skeletons
   explicit Recording(const std::vector<dynamics::SkeletonPtr>& _skeletons);
 
@@ -98,18 +111,100 @@ public:
   /// \brief Clear the saved histories
   void clear();  
 
-  /// \brief Add state
+  /// \brief Add state. This is the generalized coordinates of every skeleton,
+  /// followed by a (point, force) 6-vector for each contact.
   void addState(const Eigen::VectorXs& _state);
 
   /// \brief Update list for number of generalized coordinates
   void updateNumGenCoords(const std::vector<dynamics::SkeletonPtr>& _skeletons);
 
+  /// \brief Write every frame to _path, in native byte order, so that load()
+  /// can map it straight back into memory. This returns false if the file
+  /// can't be written, or if _path is our spill file.
+  bool save(const std::string& _path) const;
+
+  /// \brief Open a file written by save() or setSpillFile(). The file is
+  /// memory-mapped where the platform supports it, so frames are only paged
+  /// in as they're read. New frames can still be added to the result. This
+  /// returns nullptr if the file can't be read.
+  static std::shared_ptr<Recording> load(const std::string& _path);
+
+  /// \brief From now on, append each chunk to _path as soon as it fills up,
+  /// and read it back from a memory map instead of keeping it in RAM. Any
+  /// finished chunks we already have are written out first. If _path is the
+  /// file this recording was loaded from, new chunks are appended to it. This
+  /// returns false if the file can't be written.
+  bool setSpillFile(const std::string& _path);
+
+  /// \brief Get the number of frames held in memory, rather than read from a
+  /// file
+  int getNumFramesInMemory() const;
+
 private:
-  /// \brief Baked states
-  std::vector<Eigen::VectorXs> mBakedStates;
+  struct MappedFile;
+
+  struct Chunk
+  {
+    /// \brief Index of the first frame in this chunk
+    int firstFrame;
+
+    int numFrames;
+
+    /// \brief Number of generalized coordinates stored for each frame
+    int stride;
+
+    /// \brief If true, this chunk's arrays live in mFile at these byte
+    /// offsets, rather than in the vectors below
+    bool inFile;
+    std::size_t positionsOffset;
+    std::size_t contactStartsOffset;
+    std::size_t contactsOffset;
+
+    /// \brief numFrames * stride generalized coordinates
+    std::vector<double> positions;
+
+    /// \brief Index of each frame's first contact in `contacts`, plus one
+    /// past the last contact
+    std::vector<uint32_t> contactStarts;
+
+    /// \brief A (point, force) 6-vector for each contact
+    std::vector<double> contacts;
+  };
+
+  /// \brief Find the chunk holding _frameIdx
+  const Chunk& getChunk(int _frameIdx) const;
+
+  /// \brief Get the generalized coordinates at _frameIdx
+  const double* getPositionsData(int _frameIdx, int& _stride) const;
+
+  /// \brief Get the contacts at _frameIdx
+  const double* getContactsData(int _frameIdx, int& _numContacts) const;
+
+  /// \brief Append _chunk to mSpillPath, and read it from there from now on
+  bool spillChunk(Chunk& _chunk);
+
+  /// \brief Map mSpillPath again, after it has grown
+  bool remapSpillFile();
+
+  /// \brief Chunks, in order of frames
+  std::vector<Chunk> mChunks;
+
+  int mNumFrames;
 
   /// \brief Number of generalized coordinates for skeletons
   std::vector<int> mNumGenCoordsForSkeletons;
+
+  /// \brief The file that chunks with `inFile` are read from
+  std::shared_ptr<MappedFile> mFile;
+
+  /// \brief The path of mFile
+  std::string mFilePath;
+
+  /// \brief If not empty, full chunks get appended to this file
+  std::string mSpillPath;
+
+  /// \brief The size of mSpillPath, in bytes
+  std::size_t mSpillSize;
 };
 
 }  // namespace simulation
@@ -0,0 +1,65 @@
+#include "dart/simulation/StepStats.hpp"
+
+#include "dart/constraint/ConstraintSolver.hpp"
+
+namespace dart {
+namespace simulation {
+
+constexpr int StepStats::HISTOGRAM_BUCKETS;
+
+//==============================================================================
+StepStats::StepStats()
+{
+  reset();
+}
+
+//==============================================================================
+/// This clears every counter
+void StepStats::reset()
+{
+  numSteps = 0;
+  lastStepNanos = 0;
+  lastCollisionNanos = 0;
+  lastConstraintNanos = 0;
+  lastIntegrationNanos = 0;
+  lastNumContacts = 0;
+  lastNumConstrainedGroups = 0;
+  lastLcpSize = 0;
+  lastLcpIterations = 0;
+  lastLcpSolvesByPath.assign(
+      constraint::ConstraintSolver::NUM_LCP_SOLVE_PATHS, 0);
+  totalStepNanos = 0;
+  maxStepNanos = 0;
+  totalCollisionNanos = 0;
+  totalConstraintNanos = 0;
+  totalIntegrationNanos = 0;
+  totalContacts = 0;
+  maxLcpSize = 0;
+  totalLcpIterations = 0;
+  numLcpSolvesByPath.assign(
+      constraint::ConstraintSolver::NUM_LCP_SOLVE_PATHS, 0);
+  numBackprops = 0;
+  lastBackpropNanos = 0;
+  totalBackpropNanos = 0;
+  stepNanosHistogram.assign(HISTOGRAM_BUCKETS, 0);
+  collisionNanosHistogram.assign(HISTOGRAM_BUCKETS, 0);
+  integrationNanosHistogram.assign(HISTOGRAM_BUCKETS, 0);
+  backpropNanosHistogram.assign(HISTOGRAM_BUCKETS, 0);
+}
+
+//==============================================================================
+/// This adds a duration to one of the histograms
+void StepStats::recordDuration(std::vector<long>& histogram, long nanos)
+{
+  long micros = nanos / 1000;
+  int bucket = 0;
+  while (micros >= 2 && bucket < HISTOGRAM_BUCKETS - 1)
+  {
+    micros /= 2;
+    bucket++;
+  }
+  histogram[bucket]++;
+}
+
+} // namespace simulation
+} // namespace dart
@@ -0,0 +1,79 @@
+#ifndef DART_SIMULATION_STEP_STATS_HPP_
+#define DART_SIMULATION_STEP_STATS_HPP_
+
+#include <vector>
+
+namespace dart {
+namespace simulation {
+
+/// These are always-on counters for what World::step() has been spending its
+/// time on. They're cheap enough to leave running in production (a handful
+/// of clock reads per step), and are meant to answer "why was that step
+/// slow?" without rebuilding with PerformanceLog hooks.
+///
+/// Fields named "last" describe the most recent step, and everything else
+/// accumulates since the World was created (or resetStepStats() was called).
+/// All durations are in nanoseconds.
+struct StepStats
+{
+  /// Duration histograms have this many buckets. Bucket 0 counts durations
+  /// under 2 microseconds, bucket i counts durations in [2^i, 2^(i+1))
+  /// microseconds, and the last bucket counts everything longer.
+  static constexpr int HISTOGRAM_BUCKETS = 20;
+
+  StepStats();
+
+  /// This clears every counter
+  void reset();
+
+  /// This adds a duration to one of the histograms
+  static void recordDuration(std::vector<long>& histogram, long nanos);
+
+  long numSteps;
+
+  /// This is the time for the whole step
+  long lastStepNanos;
+  /// This is the time spent in collision detection
+  long lastCollisionNanos;
+  /// This is the time spent in the constraint engine, including collision
+  /// detection and the LCP solves
+  long lastConstraintNanos;
+  /// This is the time spent integrating velocities and positions
+  long lastIntegrationNanos;
+  int lastNumContacts;
+  int lastNumConstrainedGroups;
+  /// This is the summed dimension of every constrained group's LCP
+  int lastLcpSize;
+  /// This counts iterations of iterative LCP solvers (like PGS). Direct
+  /// solvers (like Dantzig) don't contribute.
+  int lastLcpIterations;
+  /// This is how many constrained groups were solved along each of
+  /// constraint::ConstraintSolver::LcpSolvePath
+  std::vector<int> lastLcpSolvesByPath;
+
+  long totalStepNanos;
+  long maxStepNanos;
+  long totalCollisionNanos;
+  long totalConstraintNanos;
+  long totalIntegrationNanos;
+  long totalContacts;
+  int maxLcpSize;
+  long totalLcpIterations;
+  std::vector<long> numLcpSolvesByPath;
+
+  /// These are backprop calls through BackpropSnapshot::backprop() on this
+  /// World
+  long numBackprops;
+  long lastBackpropNanos;
+  long totalBackpropNanos;
+
+  std::vector<long> stepNanosHistogram;
+  std::vector<long> collisionNanosHistogram;
+  std::vector<long> integrationNanosHistogram;
+  std::vector<long> backpropNanosHistogram;
+};
+
+} // namespace simulation
+} // namespace dart
+
+#endif
@@ -39,23 +39,54 @@
 #include "dart/simulation/World.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "dart/collision/CollisionDetector.hpp"
 #include "dart/collision/CollisionGroup.hpp"
+#include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/CollisionResult.hpp"
 #include "dart/common/Console.hpp"
+#include "dart/common/LocalResourceRetriever.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/constraint/BoxedLcpConstraintSolver.hpp"
 #include "dart/constraint/ConstrainedGroup.hpp"
+#include "dart/constraint/ContactConstraint.hpp"
+#include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/CylinderShape.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/EllipsoidShape.hpp"
+#include "dart/dynamics/EulerFreeJoint.hpp"
+#include "dart/dynamics/EulerJoint.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/PlanarJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/ScrewJoint.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/dynamics/TranslationalJoint.hpp"
+#include "dart/dynamics/TranslationalJoint2D.hpp"
+#include "dart/dynamics/UniversalJoint.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
+#include "dart/neural/ForwardPassCache.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
+#include "dart/proto/SerializeEigen.hpp"
+#include "dart/proto/World.pb.h"
 #include "dart/server/RawJsonUtils.hpp"
 
 namespace dart {
@@ -82,8 +113,17 @@ World::World(const std::string& _name)
     mParallelVelocityAndPositionUpdates(
         true), // TODO(keenon): We should fix our backprop to somehow achieve
                // the best of both worlds here
+    mParallelSkeletonUpdates(false),
+    mImplicitSpringDamping(false),
     mFallbackConstraintForceMixingConstant(1e-4),
     mContactClippingDepth(0.03),
+    mSpeculativeContactDistance(0.0),
+    mSleepingEnabled(false),
+    mSleepVelocityThreshold(1e-3),
+    mSleepStepThreshold(30),
+    mMaxSubsteps(1),
+    mSubstepPenetrationThreshold(0.005),
+    mSubstepVelocityChangeThreshold(0.5),
     mPenetrationCorrectionEnabled(false),
     mWrtMass(std::make_shared<neural::WithRespectToMass>()),
     mUseFDOverride(false),
@@ -120,9 +160,19 @@ WorldPtr World::clone() const
   worldClone->setFallbackConstraintForceMixingConstant(
       mFallbackConstraintForceMixingConstant);
   worldClone->setContactClippingDepth(mContactClippingDepth);
+  worldClone->setSpeculativeContactDistance(mSpeculativeContactDistance);
+  worldClone->setSleepingEnabled(mSleepingEnabled);
+  worldClone->setSleepVelocityThreshold(mSleepVelocityThreshold);
+  worldClone->setSleepStepThreshold(mSleepStepThreshold);
+  worldClone->setMaxSubsteps(mMaxSubsteps);
+  worldClone->setSubstepPenetrationThreshold(mSubstepPenetrationThreshold);
+  worldClone->setSubstepVelocityChangeThreshold(
+      mSubstepVelocityChangeThreshold);
   worldClone->setPenetrationCorrectionEnabled(mPenetrationCorrectionEnabled);
   worldClone->setParallelVelocityAndPositionUpdates(
       mParallelVelocityAndPositionUpdates);
+  worldClone->setParallelSkeletonUpdates(mParallelSkeletonUpdates);
+  worldClone->setImplicitSpringDamping(mImplicitSpringDamping);
 
   // Copy the WithRespectToMass pointer, so we have the same object
   worldClone->mWrtMass = mWrtMass;
@@ -131,16 +181,25 @@ WorldPtr World::clone() const
   worldClone->getConstraintSolver()->setCollisionDetector(
       cd->cloneWithoutCollisionObjects());
 
-  // Clone and add each Skeleton
+  // Clone and add each Skeleton. cloneSkeleton() already carries over every
+  // link's inertia and beta, and the cloned ShapeNodes point at the same Shape
+  // objects as the originals, so mesh data (and any cached support hulls) is
+  // shared between clones rather than copied.
   for (std::size_t i = 0; i < mSkeletons.size(); ++i)
   {
+    worldClone->addSkeleton(mSkeletons[i]->cloneSkeleton());
 
-    dart::dynamics::SkeletonPtr cloned_skel = mSkeletons[i]->cloneSkeleton();
-    cloned_skel->setLinkMasses(mSkeletons[i]->getLinkMasses());
-    cloned_skel->setLinkCOMs(mSkeletons[i]->getLinkCOMs());
-    cloned_skel->setLinkMOIs(mSkeletons[i]->getLinkMOIs());
-    cloned_skel->setLinkBetas(mSkeletons[i]->getLinkBetas());
-    worldClone->addSkeleton(cloned_skel);
+    // Carry over the sleeping state, so the clone steps exactly like we would
+    const dynamics::Skeleton* original = mSkeletons[i].get();
+    const dynamics::Skeleton* copy = worldClone->mSkeletons[i].get();
+    auto resting = mSleepRestingSteps.find(original);
+    if (resting != mSleepRestingSteps.end())
+      worldClone->mSleepRestingSteps[copy] = resting->second;
+    if (mSleepingSkeletons.count(original))
+    {
+      worldClone->mSkeletons[i]->setMobile(false);
+      worldClone->mSleepingSkeletons.insert(copy);
+    }
   }
 
   // Clone and add each SimpleFrame
@@ -207,48 +266,316 @@ void World::reset()
 void World::integrateVelocities()
 {
   // Integrate velocity for unconstrained skeletons
+  forEachMobileSkeleton([this](dynamics::Skeleton* skel) {
+    skel->computeForwardDynamics();
+    if (mImplicitSpringDamping)
+      skel->applyImplicitSpringDamping(mTimeStep);
+    skel->integrateVelocities(mTimeStep);
+  });
+}
+
+//==============================================================================
+void World::forEachMobileSkeleton(
+    const std::function<void(dynamics::Skeleton*)>& fn)
+{
+  std::vector<dynamics::Skeleton*> mobile;
+  mobile.reserve(mSkeletons.size());
   for (auto& skel : mSkeletons)
   {
-    if (!skel->isMobile())
-      continue;
+    if (skel->isMobile())
+      mobile.push_back(skel.get());
+  }
 
-    skel->computeForwardDynamics();
-    skel->integrateVelocities(mTimeStep);
+  if (!mParallelSkeletonUpdates || mobile.size() < 2)
+  {
+    for (dynamics::Skeleton* skel : mobile)
+      fn(skel);
+    return;
+  }
+
+  // Skeletons don't share any kinematic or dynamic caches, so each one can be
+  // updated on its own thread. Chunk them so we submit at most one task per
+  // worker.
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  int numSkels = mobile.size();
+  int numTasks
+      = std::min(numSkels, std::max(1, (int)pool.getNumThreads()));
+  std::vector<std::future<void>> futures;
+  for (int t = 0; t < numTasks; t++)
+  {
+    auto task = [&fn, &mobile, numSkels, numTasks, t]() {
+      for (int i = t; i < numSkels; i += numTasks)
+      {
+        fn(mobile[i]);
+      }
+    };
+    futures.push_back(pool.submit(task));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
   }
 }
 
+//==============================================================================
+static long nanosSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
 //==============================================================================
 void World::step(bool _resetCommand)
 {
-  Eigen::VectorXs initialVelocity = getVelocities();
+  auto stepStart = std::chrono::steady_clock::now();
 
-  // Integrate velocity for unconstrained skeletons
-  for (auto& skel : mSkeletons)
-  {
-    if (!skel->isMobile())
-      continue;
+  // This only reallocates when the number of DOFs changes
+  if (mSleepingEnabled)
+    wakeSkeletonsWithInputs();
 
-    skel->computeForwardDynamics();
-    skel->integrateVelocities(mTimeStep);
-  }
+  mStepInitialVelocity.resize(mDofs);
+  getVelocities(mStepInitialVelocity);
+
+  // Integrate velocity for unconstrained skeletons
+  auto integrationStart = std::chrono::steady_clock::now();
+  integrateVelocities();
+  long integrationNanos = nanosSince(integrationStart);
 
   // Record the unconstrained velocities, cause we need them for backprop
   if (mConstraintSolver->getGradientEnabled())
   {
-    mLastPreConstraintVelocity = getVelocities();
+    mLastPreConstraintVelocity.resize(mDofs);
+    getVelocities(mLastPreConstraintVelocity);
   }
 
   // Detect activated constraints and compute constraint impulses
   mConstraintSolver->setPenetrationCorrectionEnabled(
       mPenetrationCorrectionEnabled);
   mConstraintSolver->setContactClippingDepth(mContactClippingDepth);
+  mConstraintSolver->setSpeculativeContactDistance(
+      mSpeculativeContactDistance);
   mConstraintSolver->setFallbackConstraintForceMixingConstant(
       mFallbackConstraintForceMixingConstant);
+  long lcpSolvesBefore[constraint::ConstraintSolver::NUM_LCP_SOLVE_PATHS];
+  for (int i = 0; i < constraint::ConstraintSolver::NUM_LCP_SOLVE_PATHS; i++)
+  {
+    lcpSolvesBefore[i] = mConstraintSolver->getNumLcpSolves(
+        static_cast<constraint::ConstraintSolver::LcpSolvePath>(i));
+  }
+  long lcpIterationsBefore = mConstraintSolver->getNumLcpIterations();
+  auto constraintStart = std::chrono::steady_clock::now();
   runConstraintEngine(_resetCommand);
-  integratePositions(initialVelocity);
+  long constraintNanos = nanosSince(constraintStart);
+
+  integrationStart = std::chrono::steady_clock::now();
+  integratePositions(mStepInitialVelocity);
+  integrationNanos += nanosSince(integrationStart);
+
+  if (mSleepingEnabled)
+    updateSleepingSkeletons();
 
   mTime += mTimeStep;
   mFrame++;
+
+  // Record the step stats. This is all just reading counters, so it's cheap
+  // enough to leave on all the time.
+  StepStats& stats = mStepStats;
+  stats.numSteps++;
+  stats.lastStepNanos = nanosSince(stepStart);
+  stats.lastCollisionNanos = mConstraintSolver->getLastCollisionNanos();
+  stats.lastConstraintNanos = constraintNanos;
+  stats.lastIntegrationNanos = integrationNanos;
+  stats.lastNumContacts
+      = mConstraintSolver->getLastCollisionResult().getNumContacts();
+  const std::vector<constraint::ConstrainedGroup>& groups
+      = mConstraintSolver->getConstrainedGroups();
+  stats.lastNumConstrainedGroups = groups.size();
+  stats.lastLcpSize = 0;
+  for (const constraint::ConstrainedGroup& group : groups)
+  {
+    stats.lastLcpSize += group.getTotalDimension();
+  }
+  stats.lastLcpIterations
+      = mConstraintSolver->getNumLcpIterations() - lcpIterationsBefore;
+  for (int i = 0; i < constraint::ConstraintSolver::NUM_LCP_SOLVE_PATHS; i++)
+  {
+    stats.lastLcpSolvesByPath[i]
+        = mConstraintSolver->getNumLcpSolves(
+              static_cast<constraint::ConstraintSolver::LcpSolvePath>(i))
+          - lcpSolvesBefore[i];
+    stats.numLcpSolvesByPath[i] += stats.lastLcpSolvesByPath[i];
+  }
+
+  stats.totalStepNanos += stats.lastStepNanos;
+  stats.maxStepNanos = std::max(stats.maxStepNanos, stats.lastStepNanos);
+  stats.totalCollisionNanos += stats.lastCollisionNanos;
+  stats.totalConstraintNanos += stats.lastConstraintNanos;
+  stats.totalIntegrationNanos += stats.lastIntegrationNanos;
+  stats.totalContacts += stats.lastNumContacts;
+  stats.maxLcpSize = std::max(stats.maxLcpSize, stats.lastLcpSize);
+  stats.totalLcpIterations += stats.lastLcpIterations;
+  StepStats::recordDuration(stats.stepNanosHistogram, stats.lastStepNanos);
+  StepStats::recordDuration(
+      stats.collisionNanosHistogram, stats.lastCollisionNanos);
+  StepStats::recordDuration(
+      stats.integrationNanosHistogram, stats.lastIntegrationNanos);
+}
+
+//==============================================================================
+/// This runs step(_resetCommand) on the global common::ThreadPool, and
+/// returns a future that's ready once the step is done (and rethrows
+/// anything the step threw). This lets the caller do other work, like
+/// running a policy, while the World steps. The World must be owned by a
+/// shared_ptr, which the task holds on to until it's done. Don't read or
+/// change the World until the future is ready.
+std::future<void> World::stepAsync(bool _resetCommand)
+{
+  std::shared_ptr<World> self = shared_from_this();
+  return common::ThreadPool::getGlobal().submit(
+      [self, _resetCommand]() { self->step(_resetCommand); });
+}
+
+//==============================================================================
+int World::stepAdaptive(
+    bool _resetCommand,
+    std::vector<std::shared_ptr<neural::BackpropSnapshot>>* snapshots)
+{
+  if (snapshots != nullptr)
+    snapshots->clear();
+  if (mMaxSubsteps <= 1)
+  {
+    stepAndRecord(_resetCommand, snapshots);
+    return 1;
+  }
+
+  // Take the whole step first, holding on to the commands in case we have to
+  // take it again
+  neural::RestorableSnapshot preStep(shared_from_this());
+  s_t preStepTime = mTime;
+  int preStepFrame = mFrame;
+  stepAndRecord(false, snapshots);
+
+  int substeps = getSubstepsForLastStep();
+  if (substeps <= 1)
+  {
+    if (_resetCommand)
+      clearCommands();
+    return 1;
+  }
+
+  preStep.restore();
+  mTime = preStepTime;
+  mFrame = preStepFrame;
+  if (snapshots != nullptr)
+    snapshots->clear();
+
+  s_t timeStep = mTimeStep;
+  setTimeStep(timeStep / substeps);
+  for (int i = 0; i < substeps; i++)
+  {
+    stepAndRecord(_resetCommand && i == substeps - 1, snapshots);
+  }
+  setTimeStep(timeStep);
+
+  // The substeps add up to one step, though not always exactly in floating
+  // point, so count it as one step
+  mTime = preStepTime + timeStep;
+  mFrame = preStepFrame + 1;
+  return substeps;
+}
+
+//==============================================================================
+int World::getSubstepsForLastStep()
+{
+  if (mMaxSubsteps <= 1)
+    return 1;
+
+  // Bounces are the impacts we most need to resolve, so they get the most
+  // substeps we'll take
+  for (const constraint::ConstrainedGroup& group :
+       mConstraintSolver->getConstrainedGroups())
+  {
+    for (std::size_t i = 0; i < group.getNumConstraints(); i++)
+    {
+      std::shared_ptr<const constraint::ContactConstraint> contact
+          = std::dynamic_pointer_cast<const constraint::ContactConstraint>(
+              group.getConstraint(i));
+      if (contact && contact->didBounce())
+        return mMaxSubsteps;
+    }
+  }
+
+  // This is how many times over its threshold the worst sign of an impact is
+  s_t severity = 0.0;
+  if (mSubstepPenetrationThreshold > 0)
+  {
+    const collision::CollisionResult& result
+        = mConstraintSolver->getLastCollisionResult();
+    for (std::size_t i = 0; i < result.getNumContacts(); i++)
+    {
+      severity = std::max(
+          severity,
+          result.getContact(i).penetrationDepth
+              / mSubstepPenetrationThreshold);
+    }
+  }
+  if (mSubstepVelocityChangeThreshold > 0 && mDofs > 0
+      && mStepInitialVelocity.size() == mDofs)
+  {
+    severity = std::max(
+        severity,
+        (getVelocities() - mStepInitialVelocity).cwiseAbs().maxCoeff()
+            / mSubstepVelocityChangeThreshold);
+  }
+
+  int substeps = 1;
+  while (substeps < mMaxSubsteps && substeps < severity)
+  {
+    substeps++;
+  }
+  return substeps;
+}
+
+//==============================================================================
+void World::stepAndRecord(
+    bool _resetCommand,
+    std::vector<std::shared_ptr<neural::BackpropSnapshot>>* snapshots)
+{
+  if (snapshots == nullptr)
+  {
+    step(_resetCommand);
+    return;
+  }
+
+  Eigen::VectorXs preStepPosition = getPositions();
+  Eigen::VectorXs preStepVelocity = getVelocities();
+  Eigen::VectorXs preStepTorques = getControlForces();
+  Eigen::VectorXs preStepLCPCache = getCachedLCPSolution();
+
+  bool oldGradientEnabled = mConstraintSolver->getGradientEnabled();
+  mConstraintSolver->setGradientEnabled(true);
+  step(_resetCommand);
+  mConstraintSolver->setGradientEnabled(oldGradientEnabled);
+
+  snapshots->push_back(std::make_shared<neural::BackpropSnapshot>(
+      shared_from_this(),
+      preStepPosition,
+      preStepVelocity,
+      preStepTorques,
+      getLastPreConstraintVelocity(),
+      preStepLCPCache));
+}
+
+//==============================================================================
+void World::clearCommands()
+{
+  forEachMobileSkeleton([](dynamics::Skeleton* skel) {
+    skel->clearInternalForces();
+    skel->clearExternalForces();
+    skel->resetCommands();
+  });
 }
 
 //==============================================================================
@@ -281,11 +608,7 @@ void World::replaceConstraintEngineFn(const constraintEngineFnType& engineFn)
 void World::integrateVelocitiesFromImpulses(bool _resetCommand)
 {
   // Compute velocity changes given constraint impulses
-  for (auto& skel : mSkeletons)
-  {
-    if (!skel->isMobile())
-      continue;
-
+  forEachMobileSkeleton([_resetCommand](dynamics::Skeleton* skel) {
     if (skel->isImpulseApplied())
     {
       skel->computeImpulseForwardDynamics();
@@ -298,20 +621,27 @@ void World::integrateVelocitiesFromImpulses(bool _resetCommand)
       skel->clearExternalForces();
       skel->resetCommands();
     }
-  }
+  });
 }
 
 //==============================================================================
-void World::integratePositions(Eigen::VectorXs initialVelocity)
+void World::integratePositions(const Eigen::VectorXs& initialVelocity)
 {
   int cursor = 0;
   for (auto& skel : mSkeletons)
   {
+    int dofs = skel->getNumDofs();
+    // Sleeping Skeletons have zero velocity, so there's nothing to integrate
+    if (!mSleepingSkeletons.empty() && mSleepingSkeletons.count(skel.get()))
+    {
+      cursor += dofs;
+      continue;
+    }
+
     if (mParallelVelocityAndPositionUpdates)
     {
       // <Nimble>: This is an easier way to compute gradients for. We update
       // p_t+1 using v_t, instead of v_t+1
-      int dofs = skel->getNumDofs();
       skel->setPositions(skel->integratePositionsExplicit(
           skel->getPositions(),
           initialVelocity.segment(cursor, dofs),
@@ -354,6 +684,30 @@ bool World::getParallelVelocityAndPositionUpdates()
   return mParallelVelocityAndPositionUpdates;
 }
 
+//==============================================================================
+void World::setParallelSkeletonUpdates(bool enable)
+{
+  mParallelSkeletonUpdates = enable;
+}
+
+//==============================================================================
+bool World::getParallelSkeletonUpdates()
+{
+  return mParallelSkeletonUpdates;
+}
+
+//==============================================================================
+void World::setImplicitSpringDamping(bool enable)
+{
+  mImplicitSpringDamping = enable;
+}
+
+//==============================================================================
+bool World::getImplicitSpringDamping()
+{
+  return mImplicitSpringDamping;
+}
+
 //==============================================================================
 void World::setPenetrationCorrectionEnabled(bool enable)
 {
@@ -390,6 +744,234 @@ s_t World::getContactClippingDepth()
   return mContactClippingDepth;
 }
 
+//==============================================================================
+void World::setSpeculativeContactDistance(s_t distance)
+{
+  mSpeculativeContactDistance = distance;
+}
+
+//==============================================================================
+s_t World::getSpeculativeContactDistance()
+{
+  return mSpeculativeContactDistance;
+}
+
+//==============================================================================
+void World::setSleepingEnabled(bool enable)
+{
+  mSleepingEnabled = enable;
+  if (!enable)
+  {
+    wakeAllSkeletons();
+    mSleepRestingSteps.clear();
+  }
+}
+
+//==============================================================================
+bool World::getSleepingEnabled()
+{
+  return mSleepingEnabled;
+}
+
+//==============================================================================
+void World::setSleepVelocityThreshold(s_t threshold)
+{
+  mSleepVelocityThreshold = threshold;
+}
+
+//==============================================================================
+s_t World::getSleepVelocityThreshold()
+{
+  return mSleepVelocityThreshold;
+}
+
+//==============================================================================
+void World::setSleepStepThreshold(int steps)
+{
+  mSleepStepThreshold = steps;
+}
+
+//==============================================================================
+int World::getSleepStepThreshold()
+{
+  return mSleepStepThreshold;
+}
+
+//==============================================================================
+bool World::isSleeping(const dynamics::SkeletonPtr& skel) const
+{
+  return mSleepingSkeletons.count(skel.get()) > 0;
+}
+
+//==============================================================================
+void World::wakeSkeleton(const dynamics::SkeletonPtr& skel)
+{
+  wakeSleepingSkeleton(skel.get());
+}
+
+//==============================================================================
+void World::wakeAllSkeletons()
+{
+  for (auto& skel : mSkeletons)
+    wakeSleepingSkeleton(skel.get());
+}
+
+//==============================================================================
+void World::setMaxSubsteps(int substeps)
+{
+  mMaxSubsteps = std::max(substeps, 1);
+}
+
+//==============================================================================
+int World::getMaxSubsteps()
+{
+  return mMaxSubsteps;
+}
+
+//==============================================================================
+void World::setSubstepPenetrationThreshold(s_t depth)
+{
+  mSubstepPenetrationThreshold = depth;
+}
+
+//==============================================================================
+s_t World::getSubstepPenetrationThreshold()
+{
+  return mSubstepPenetrationThreshold;
+}
+
+//==============================================================================
+void World::setSubstepVelocityChangeThreshold(s_t change)
+{
+  mSubstepVelocityChangeThreshold = change;
+}
+
+//==============================================================================
+s_t World::getSubstepVelocityChangeThreshold()
+{
+  return mSubstepVelocityChangeThreshold;
+}
+
+//==============================================================================
+void World::wakeSleepingSkeleton(const dynamics::Skeleton* skel)
+{
+  mSleepRestingSteps[skel] = 0;
+  if (mSleepingSkeletons.erase(skel) == 0)
+    return;
+  for (auto& candidate : mSkeletons)
+  {
+    if (candidate.get() == skel)
+    {
+      candidate->setMobile(true);
+      return;
+    }
+  }
+}
+
+//==============================================================================
+void World::wakeSkeletonsWithInputs()
+{
+  if (mSleepingSkeletons.empty())
+    return;
+  for (auto& skel : mSkeletons)
+  {
+    if (!mSleepingSkeletons.count(skel.get()))
+      continue;
+    // Anything the user did to a sleeper since the last step wakes it up
+    if (!skel->getControlForces().isZero()
+        || !skel->getExternalForces().isZero()
+        || !skel->getVelocities().isZero())
+    {
+      wakeSleepingSkeleton(skel.get());
+    }
+  }
+}
+
+//==============================================================================
+void World::updateSleepingSkeletons()
+{
+  // Only awake mobile Skeletons and sleepers take part in islands. Skeletons
+  // the user made immobile (like the ground) are static forever, so they
+  // never connect two islands together.
+  std::unordered_map<const dynamics::Skeleton*, int> indices;
+  std::vector<int> parent;
+  for (auto& skel : mSkeletons)
+  {
+    if (skel->isMobile() || mSleepingSkeletons.count(skel.get()))
+    {
+      indices[skel.get()] = parent.size();
+      parent.push_back(parent.size());
+    }
+  }
+  auto find = [&parent](int i) {
+    while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+
+  const collision::CollisionResult& result
+      = mConstraintSolver->getLastCollisionResult();
+  for (std::size_t i = 0; i < result.getNumContacts(); ++i)
+  {
+    const collision::Contact& contact = result.getContact(i);
+    const dynamics::ShapeNode* node1
+        = contact.collisionObject1->getShapeFrame()->asShapeNode();
+    const dynamics::ShapeNode* node2
+        = contact.collisionObject2->getShapeFrame()->asShapeNode();
+    if (node1 == nullptr || node2 == nullptr)
+      continue;
+    auto a = indices.find(node1->getSkeleton().get());
+    auto b = indices.find(node2->getSkeleton().get());
+    if (a == indices.end() || b == indices.end())
+      continue;
+    parent[find(a->second)] = find(b->second);
+  }
+
+  // Count resting steps for every awake Skeleton
+  std::vector<bool> islandRested(parent.size(), true);
+  for (auto& skel : mSkeletons)
+  {
+    auto index = indices.find(skel.get());
+    if (index == indices.end())
+      continue;
+    int island = find(index->second);
+    if (mSleepingSkeletons.count(skel.get()))
+      continue;
+    int& resting = mSleepRestingSteps[skel.get()];
+    if (skel->getNumDofs() == 0
+        || skel->getVelocities().cwiseAbs().maxCoeff()
+               <= mSleepVelocityThreshold)
+      resting++;
+    else
+      resting = 0;
+    if (resting < mSleepStepThreshold)
+      islandRested[island] = false;
+  }
+
+  // Whole islands go to sleep, or wake up, together
+  for (auto& skel : mSkeletons)
+  {
+    auto index = indices.find(skel.get());
+    if (index == indices.end())
+      continue;
+    int island = find(index->second);
+    bool sleeping = mSleepingSkeletons.count(skel.get()) > 0;
+    if (islandRested[island] && !sleeping)
+    {
+      skel->setVelocities(Eigen::VectorXs::Zero(skel->getNumDofs()));
+      skel->setMobile(false);
+      mSleepingSkeletons.insert(skel.get());
+    }
+    else if (!islandRested[island] && sleeping)
+    {
+      wakeSleepingSkeleton(skel.get());
+    }
+  }
+}
+
 //==============================================================================
 std::shared_ptr<neural::WithRespectToMass> World::getWrtMass()
 {
@@ -523,77 +1105,969 @@ std::string World::positionsToJson()
     }
   }
 
-  json << "}";
-
-  return json.str();
-}
-
-//==============================================================================
-/// This returns the colors as a JSON blob that can be rendered if we
-/// already have the original world loaded. Good for real-time viewing.
-std::string World::colorsToJson()
-{
-  std::stringstream json;
+  json << "}";
+
+  return json.str();
+}
+
+//==============================================================================
+static void appendUint32(std::string& out, std::uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+//==============================================================================
+static void appendInt16(std::string& out, std::int16_t value)
+{
+  std::uint16_t bits = static_cast<std::uint16_t>(value);
+  out.push_back(static_cast<char>(bits & 0xff));
+  out.push_back(static_cast<char>(bits >> 8));
+}
+
+//==============================================================================
+static void appendFloat32(std::string& out, s_t value)
+{
+  float f = static_cast<float>(static_cast<double>(value));
+  std::uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  appendUint32(out, bits);
+}
+
+//==============================================================================
+/// This rounds `value / step` to the nearest integer in [-limit, limit]
+static long quantize(s_t value, double step, long limit)
+{
+  double scaled = std::round(static_cast<double>(value) / step);
+  if (!(scaled > -limit))
+    return -limit;
+  if (scaled > limit)
+    return limit;
+  return static_cast<long>(scaled);
+}
+
+//==============================================================================
+/// The layout is little endian:
+///
+///   char[4]   "NWSB"
+///   uint8     format version, currently 1
+///   uint8     flags: bit 0 if quantized, bit 1 if there are colors
+///   uint16    reserved, 0
+///   uint32    number of shapes
+///   float32   position precision, only if quantized
+///
+/// followed by one record per shape:
+///
+///   float32[3] position, float32[3] angle          if not quantized
+///   int32[3] position / precision,
+///   int16[3] angle / pi * 32767                     if quantized
+///   uint8[3] color in [0, 255]                      if there are colors
+std::string World::positionsToBinary(s_t positionPrecision, bool includeColors)
+{
+  const bool quantized = positionPrecision > 0;
+  const double precision = static_cast<double>(positionPrecision);
+  const long maxInt32 = 2147483647L;
+  const long maxInt16 = 32767L;
+
+  std::vector<dynamics::BodyNode*> bodies = getAllBodyNodes();
+  std::uint32_t numShapes = 0;
+  for (dynamics::BodyNode* bodyNode : bodies)
+  {
+    numShapes += bodyNode->getNumShapeNodesWith<dynamics::VisualAspect>();
+  }
+
+  std::string out;
+  std::size_t recordSize
+      = (quantized ? 18 : 24) + (includeColors ? 3 : 0);
+  out.reserve(16 + numShapes * recordSize);
+  out.append("NWSB", 4);
+  out.push_back(1);
+  out.push_back(
+      static_cast<char>((quantized ? 1 : 0) | (includeColors ? 2 : 0)));
+  out.push_back(0);
+  out.push_back(0);
+  appendUint32(out, numShapes);
+  if (quantized)
+    appendFloat32(out, positionPrecision);
+
+  for (dynamics::BodyNode* bodyNode : bodies)
+  {
+    for (std::size_t j = 0; j < bodyNode->getNumShapeNodes(); j++)
+    {
+      dynamics::ShapeNode* shape = bodyNode->getShapeNode(j);
+      if (!shape->has<dynamics::VisualAspect>())
+        continue;
+      const Eigen::Isometry3s& transform = shape->getWorldTransform();
+      Eigen::Vector3s angle = math::matrixToEulerXYZ(transform.linear());
+      for (int k = 0; k < 3; k++)
+      {
+        if (quantized)
+          appendUint32(
+              out,
+              static_cast<std::uint32_t>(quantize(
+                  transform.translation()(k), precision, maxInt32)));
+        else
+          appendFloat32(out, transform.translation()(k));
+      }
+      for (int k = 0; k < 3; k++)
+      {
+        if (quantized)
+          appendInt16(
+              out,
+              static_cast<std::int16_t>(
+                  quantize(angle(k), M_PI / maxInt16, maxInt16)));
+        else
+          appendFloat32(out, angle(k));
+      }
+      if (includeColors)
+      {
+        const Eigen::Vector3s& color
+            = shape->getVisualAspect(false)->getColor();
+        for (int k = 0; k < 3; k++)
+        {
+          out.push_back(static_cast<char>(
+              std::max(0L, quantize(color(k), 1.0 / 255, 255))));
+        }
+      }
+    }
+  }
+
+  return out;
+}
+
+//==============================================================================
+/// This returns the colors as a JSON blob that can be rendered if we
+/// already have the original world loaded. Good for real-time viewing.
+std::string World::colorsToJson()
+{
+  std::stringstream json;
+
+  json << "{";
+
+  std::vector<dynamics::BodyNode*> bodies = getAllBodyNodes();
+  for (int i = 0; i < bodies.size(); i++)
+  {
+    auto bodyNode = bodies[i];
+    auto skel = bodyNode->getSkeleton();
+    /*
+    // A BodyNode with two child shapes gets rendered like this:
+    {
+      "skel.node1": [
+        [0, 0, 0],
+        [1, 1, 1]
+      ]
+    }
+    */
+    std::string name = skel->getName() + "." + bodyNode->getName();
+    json << "\"" << name << "\": [";
+
+    const std::vector<dynamics::ShapeNode*> visualShapeNodes
+        = bodyNode->getShapeNodesWith<dynamics::VisualAspect>();
+    for (int j = 0; j < visualShapeNodes.size(); j++)
+    {
+      auto shape = visualShapeNodes[j];
+      dynamics::VisualAspect* visual = shape->getVisualAspect(false);
+      if (j > 0)
+        json << ",";
+      vec3ToJson(json, visual->getColor());
+    }
+
+    json << "]";
+
+    if (i < bodies.size() - 1)
+    {
+      json << ",";
+    }
+  }
+
+  json << "}";
+
+  return json.str();
+}
+
+//==============================================================================
+/// This gets the cached LCP solution, which is useful to be able to get/set
+/// because it can effect the forward solutions of physics problems because of
+/// our optimistic LCP-stabilization-to-acceptance approach.
+Eigen::VectorXs World::getCachedLCPSolution()
+{
+  return mConstraintSolver->getCachedLCPSolution();
+}
+
+//==============================================================================
+/// This gets the cached LCP solution, which is useful to be able to get/set
+/// because it can effect the forward solutions of physics problems because of
+/// our optimistic LCP-stabilization-to-acceptance approach.
+void World::setCachedLCPSolution(Eigen::VectorXs X)
+{
+  mConstraintSolver->setCachedLCPSolution(X);
+}
+
+//==============================================================================
+void World::getCachedLCPSolutionInto(Eigen::VectorXs& out)
+{
+  mConstraintSolver->getCachedLCPSolutionInto(out);
+}
+
+//==============================================================================
+void World::setCachedLCPSolutionFrom(const Eigen::Ref<const Eigen::VectorXs>& X)
+{
+  mConstraintSolver->setCachedLCPSolutionFrom(X);
+}
+
+namespace {
+
+//==============================================================================
+void serializeTransform(proto::MatrixXs& proto, const Eigen::Isometry3s& T)
+{
+  proto::serializeMatrix(proto, T.matrix());
+}
+
+//==============================================================================
+Eigen::Isometry3s deserializeTransform(const proto::MatrixXs& proto)
+{
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  Eigen::MatrixXs mat = proto::deserializeMatrix(proto);
+  if (mat.rows() == 4 && mat.cols() == 4)
+    T.matrix() = mat;
+  return T;
+}
+
+//==============================================================================
+/// This reads one value per DOF off of `joint` using `getter`
+void serializeDofValues(
+    proto::VectorXs& proto,
+    const dynamics::Joint* joint,
+    s_t (dynamics::Joint::*getter)(std::size_t) const)
+{
+  Eigen::VectorXs values(joint->getNumDofs());
+  for (std::size_t i = 0; i < joint->getNumDofs(); i++)
+    values(i) = (joint->*getter)(i);
+  proto::serializeVector(proto, values);
+}
+
+//==============================================================================
+/// This is the inverse of serializeDofValues(). Values of the wrong length are
+/// ignored, so fields missing from the proto leave the defaults alone.
+void deserializeDofValues(
+    const proto::VectorXs& proto,
+    dynamics::Joint* joint,
+    void (dynamics::Joint::*setter)(std::size_t, s_t))
+{
+  Eigen::VectorXs values = proto::deserializeVector(proto);
+  if (values.size() != static_cast<int>(joint->getNumDofs()))
+    return;
+  for (std::size_t i = 0; i < joint->getNumDofs(); i++)
+    (joint->*setter)(i, values(i));
+}
+
+//==============================================================================
+/// This returns false if we don't know how to write out this joint type
+bool serializeJoint(proto::WorldJoint& proto, const dynamics::Joint* joint)
+{
+  const std::string& type = joint->getType();
+  proto.set_type(type);
+  proto.set_name(joint->getName());
+  serializeTransform(
+      *proto.mutable_transformfromparentbodynode(),
+      joint->getTransformFromParentBodyNode());
+  serializeTransform(
+      *proto.mutable_transformfromchildbodynode(),
+      joint->getTransformFromChildBodyNode());
+  proto.set_actuatortype(static_cast<int>(joint->getActuatorType()));
+  proto.set_positionlimitenforced(joint->isPositionLimitEnforced());
+  for (std::size_t i = 0; i < joint->getNumDofs(); i++)
+    proto.add_dofnames(joint->getDofName(i));
+
+  using dynamics::Joint;
+  serializeDofValues(*proto.mutable_positions(), joint, &Joint::getPosition);
+  serializeDofValues(*proto.mutable_velocities(), joint, &Joint::getVelocity);
+  serializeDofValues(
+      *proto.mutable_controlforces(), joint, &Joint::getControlForce);
+  serializeDofValues(
+      *proto.mutable_positionlowerlimits(),
+      joint,
+      &Joint::getPositionLowerLimit);
+  serializeDofValues(
+      *proto.mutable_positionupperlimits(),
+      joint,
+      &Joint::getPositionUpperLimit);
+  serializeDofValues(
+      *proto.mutable_velocitylowerlimits(),
+      joint,
+      &Joint::getVelocityLowerLimit);
+  serializeDofValues(
+      *proto.mutable_velocityupperlimits(),
+      joint,
+      &Joint::getVelocityUpperLimit);
+  serializeDofValues(
+      *proto.mutable_controlforcelowerlimits(),
+      joint,
+      &Joint::getControlForceLowerLimit);
+  serializeDofValues(
+      *proto.mutable_controlforceupperlimits(),
+      joint,
+      &Joint::getControlForceUpperLimit);
+  serializeDofValues(
+      *proto.mutable_springstiffnesses(), joint, &Joint::getSpringStiffness);
+  serializeDofValues(
+      *proto.mutable_restpositions(), joint, &Joint::getRestPosition);
+  serializeDofValues(
+      *proto.mutable_dampingcoefficients(),
+      joint,
+      &Joint::getDampingCoefficient);
+  serializeDofValues(
+      *proto.mutable_coulombfrictions(), joint, &Joint::getCoulombFriction);
+
+  if (type == dynamics::RevoluteJoint::getStaticType())
+  {
+    proto::serializeVector(
+        *proto.mutable_axis1(),
+        static_cast<const dynamics::RevoluteJoint*>(joint)->getAxis());
+  }
+  else if (type == dynamics::PrismaticJoint::getStaticType())
+  {
+    proto::serializeVector(
+        *proto.mutable_axis1(),
+        static_cast<const dynamics::PrismaticJoint*>(joint)->getAxis());
+  }
+  else if (type == dynamics::ScrewJoint::getStaticType())
+  {
+    auto screw = static_cast<const dynamics::ScrewJoint*>(joint);
+    proto::serializeVector(*proto.mutable_axis1(), screw->getAxis());
+    proto.set_pitch(static_cast<double>(screw->getPitch()));
+  }
+  else if (type == dynamics::UniversalJoint::getStaticType())
+  {
+    auto universal = static_cast<const dynamics::UniversalJoint*>(joint);
+    proto::serializeVector(*proto.mutable_axis1(), universal->getAxis1());
+    proto::serializeVector(*proto.mutable_axis2(), universal->getAxis2());
+  }
+  else if (type == dynamics::EulerJoint::getStaticType())
+  {
+    auto euler = static_cast<const dynamics::EulerJoint*>(joint);
+    proto.set_axisorder(static_cast<int>(euler->getAxisOrder()));
+    proto::serializeVector(
+        *proto.mutable_flipaxismap(), euler->getFlipAxisMap());
+  }
+  else if (type == dynamics::EulerFreeJoint::getStaticType())
+  {
+    auto euler = static_cast<const dynamics::EulerFreeJoint*>(joint);
+    proto.set_axisorder(static_cast<int>(euler->getAxisOrder()));
+    proto::serializeVector(
+        *proto.mutable_flipaxismap(), euler->getFlipAxisMap());
+  }
+  else if (type == dynamics::PlanarJoint::getStaticType())
+  {
+    auto planar = static_cast<const dynamics::PlanarJoint*>(joint);
+    proto.set_planetype(static_cast<int>(planar->getPlaneType()));
+    proto::serializeVector(
+        *proto.mutable_axis1(), planar->getTranslationalAxis1());
+    proto::serializeVector(
+        *proto.mutable_axis2(), planar->getTranslationalAxis2());
+  }
+  else if (type == dynamics::TranslationalJoint2D::getStaticType())
+  {
+    auto planar = static_cast<const dynamics::TranslationalJoint2D*>(joint);
+    proto.set_planetype(static_cast<int>(planar->getPlaneType()));
+    proto::serializeVector(
+        *proto.mutable_axis1(), planar->getTranslationalAxis1());
+    proto::serializeVector(
+        *proto.mutable_axis2(), planar->getTranslationalAxis2());
+  }
+  else if (
+      type != dynamics::WeldJoint::getStaticType()
+      && type != dynamics::BallJoint::getStaticType()
+      && type != dynamics::FreeJoint::getStaticType()
+      && type != dynamics::TranslationalJoint::getStaticType())
+  {
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+/// This sets the plane on a PlanarJoint or a TranslationalJoint2D
+template <typename JointType>
+void deserializePlane(JointType* joint, const proto::WorldJoint& proto)
+{
+  switch (static_cast<dynamics::detail::PlaneType>(proto.planetype()))
+  {
+    case dynamics::detail::PlaneType::XY:
+      joint->setXYPlane(false);
+      break;
+    case dynamics::detail::PlaneType::YZ:
+      joint->setYZPlane(false);
+      break;
+    case dynamics::detail::PlaneType::ZX:
+      joint->setZXPlane(false);
+      break;
+    case dynamics::detail::PlaneType::ARBITRARY:
+      joint->setArbitraryPlane(
+          proto::deserializeVector(proto.axis1()),
+          proto::deserializeVector(proto.axis2()),
+          false);
+      break;
+  }
+}
+
+//==============================================================================
+template <typename JointType>
+std::pair<dynamics::Joint*, dynamics::BodyNode*> createJointAndBodyNodePair(
+    const dynamics::SkeletonPtr& skel, dynamics::BodyNode* parent)
+{
+  auto pair = skel->createJointAndBodyNodePair<JointType>(parent);
+  return std::make_pair(pair.first, pair.second);
+}
+
+//==============================================================================
+/// This creates the joint described by `proto`, along with its child
+/// BodyNode. This returns a pair of nullptrs if the joint type isn't one we
+/// know how to create.
+std::pair<dynamics::Joint*, dynamics::BodyNode*> deserializeJoint(
+    const proto::WorldJoint& proto,
+    const dynamics::SkeletonPtr& skel,
+    dynamics::BodyNode* parent)
+{
+  using namespace dynamics;
+
+  const std::string& type = proto.type();
+  std::pair<Joint*, BodyNode*> pair(nullptr, nullptr);
+  if (type == RevoluteJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<RevoluteJoint>(skel, parent);
+    static_cast<RevoluteJoint*>(pair.first)
+        ->setAxis(proto::deserializeVector(proto.axis1()));
+  }
+  else if (type == PrismaticJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<PrismaticJoint>(skel, parent);
+    static_cast<PrismaticJoint*>(pair.first)
+        ->setAxis(proto::deserializeVector(proto.axis1()));
+  }
+  else if (type == ScrewJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<ScrewJoint>(skel, parent);
+    auto screw = static_cast<ScrewJoint*>(pair.first);
+    screw->setAxis(proto::deserializeVector(proto.axis1()));
+    screw->setPitch(proto.pitch());
+  }
+  else if (type == UniversalJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<UniversalJoint>(skel, parent);
+    auto universal = static_cast<UniversalJoint*>(pair.first);
+    universal->setAxis1(proto::deserializeVector(proto.axis1()));
+    universal->setAxis2(proto::deserializeVector(proto.axis2()));
+  }
+  else if (type == EulerJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<EulerJoint>(skel, parent);
+    auto euler = static_cast<EulerJoint*>(pair.first);
+    euler->setAxisOrder(
+        static_cast<EulerJoint::AxisOrder>(proto.axisorder()), false);
+    euler->setFlipAxisMap(proto::deserializeVector(proto.flipaxismap()));
+  }
+  else if (type == EulerFreeJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<EulerFreeJoint>(skel, parent);
+    auto euler = static_cast<EulerFreeJoint*>(pair.first);
+    euler->setAxisOrder(
+        static_cast<EulerJoint::AxisOrder>(proto.axisorder()), false);
+    euler->setFlipAxisMap(proto::deserializeVector(proto.flipaxismap()));
+  }
+  else if (type == PlanarJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<PlanarJoint>(skel, parent);
+    deserializePlane(static_cast<PlanarJoint*>(pair.first), proto);
+  }
+  else if (type == TranslationalJoint2D::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<TranslationalJoint2D>(skel, parent);
+    deserializePlane(static_cast<TranslationalJoint2D*>(pair.first), proto);
+  }
+  else if (type == WeldJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<WeldJoint>(skel, parent);
+  }
+  else if (type == BallJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<BallJoint>(skel, parent);
+  }
+  else if (type == FreeJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<FreeJoint>(skel, parent);
+  }
+  else if (type == TranslationalJoint::getStaticType())
+  {
+    pair = createJointAndBodyNodePair<TranslationalJoint>(skel, parent);
+  }
+  else
+  {
+    return pair;
+  }
+
+  Joint* joint = pair.first;
+  joint->setName(proto.name());
+  joint->setTransformFromParentBodyNode(
+      deserializeTransform(proto.transformfromparentbodynode()));
+  joint->setTransformFromChildBodyNode(
+      deserializeTransform(proto.transformfromchildbodynode()));
+  joint->setActuatorType(static_cast<Joint::ActuatorType>(proto.actuatortype()));
+  joint->setPositionLimitEnforced(proto.positionlimitenforced());
+  for (int i = 0; i < proto.dofnames_size()
+                  && i < static_cast<int>(joint->getNumDofs());
+       i++)
+  {
+    joint->setDofName(i, proto.dofnames(i));
+  }
+
+  deserializeDofValues(
+      proto.positionlowerlimits(), joint, &Joint::setPositionLowerLimit);
+  deserializeDofValues(
+      proto.positionupperlimits(), joint, &Joint::setPositionUpperLimit);
+  deserializeDofValues(
+      proto.velocitylowerlimits(), joint, &Joint::setVelocityLowerLimit);
+  deserializeDofValues(
+      proto.velocityupperlimits(), joint, &Joint::setVelocityUpperLimit);
+  deserializeDofValues(
+      proto.controlforcelowerlimits(),
+      joint,
+      &Joint::setControlForceLowerLimit);
+  deserializeDofValues(
+      proto.controlforceupperlimits(),
+      joint,
+      &Joint::setControlForceUpperLimit);
+  deserializeDofValues(
+      proto.springstiffnesses(), joint, &Joint::setSpringStiffness);
+  deserializeDofValues(proto.restpositions(), joint, &Joint::setRestPosition);
+  deserializeDofValues(
+      proto.dampingcoefficients(), joint, &Joint::setDampingCoefficient);
+  deserializeDofValues(
+      proto.coulombfrictions(), joint, &Joint::setCoulombFriction);
+  deserializeDofValues(proto.positions(), joint, &Joint::setPosition);
+  deserializeDofValues(proto.velocities(), joint, &Joint::setVelocity);
+  deserializeDofValues(proto.controlforces(), joint, &Joint::setControlForce);
+
+  return pair;
+}
+
+//==============================================================================
+/// This returns false if we don't know how to write out this shape
+bool serializeShape(proto::WorldShape& proto, const dynamics::Shape* shape)
+{
+  const std::string& type = shape->getType();
+  if (type == dynamics::BoxShape::getStaticType())
+  {
+    proto.set_type(proto::WorldShape::BOX);
+    proto::serializeVector(
+        *proto.mutable_size(),
+        static_cast<const dynamics::BoxShape*>(shape)->getSize());
+  }
+  else if (type == dynamics::SphereShape::getStaticType())
+  {
+    proto.set_type(proto::WorldShape::SPHERE);
+    proto.set_radius(static_cast<double>(
+        static_cast<const dynamics::SphereShape*>(shape)->getRadius()));
+  }
+  else if (type == dynamics::EllipsoidShape::getStaticType())
+  {
+    proto.set_type(proto::WorldShape::ELLIPSOID);
+    proto::serializeVector(
+        *proto.mutable_size(),
+        static_cast<const dynamics::EllipsoidShape*>(shape)->getDiameters());
+  }
+  else if (type == dynamics::CapsuleShape::getStaticType())
+  {
+    auto capsule = static_cast<const dynamics::CapsuleShape*>(shape);
+    proto.set_type(proto::WorldShape::CAPSULE);
+    proto.set_radius(static_cast<double>(capsule->getRadius()));
+    proto.set_height(static_cast<double>(capsule->getHeight()));
+  }
+  else if (type == dynamics::CylinderShape::getStaticType())
+  {
+    auto cylinder = static_cast<const dynamics::CylinderShape*>(shape);
+    proto.set_type(proto::WorldShape::CYLINDER);
+    proto.set_radius(static_cast<double>(cylinder->getRadius()));
+    proto.set_height(static_cast<double>(cylinder->getHeight()));
+  }
+  else if (type == dynamics::MeshShape::getStaticType())
+  {
+    auto mesh = static_cast<const dynamics::MeshShape*>(shape);
+    // A mesh that was built in memory has no URI to load it back from
+    if (mesh->getMeshUri().empty())
+      return false;
+    proto.set_type(proto::WorldShape::MESH);
+    proto.set_meshuri(mesh->getMeshUri());
+    proto::serializeVector(*proto.mutable_size(), mesh->getScale());
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+/// This returns nullptr if a mesh fails to load
+dynamics::ShapePtr deserializeShape(
+    const proto::WorldShape& proto,
+    const common::ResourceRetrieverPtr& retriever)
+{
+  switch (proto.type())
+  {
+    case proto::WorldShape::BOX:
+      return std::make_shared<dynamics::BoxShape>(
+          proto::deserializeVector(proto.size()));
+    case proto::WorldShape::SPHERE:
+      return std::make_shared<dynamics::SphereShape>(proto.radius());
+    case proto::WorldShape::ELLIPSOID:
+      return std::make_shared<dynamics::EllipsoidShape>(
+          proto::deserializeVector(proto.size()));
+    case proto::WorldShape::CAPSULE:
+      return std::make_shared<dynamics::CapsuleShape>(
+          proto.radius(), proto.height());
+    case proto::WorldShape::CYLINDER:
+      return std::make_shared<dynamics::CylinderShape>(
+          proto.radius(), proto.height());
+    case proto::WorldShape::MESH:
+    {
+      std::shared_ptr<dynamics::SharedMeshWrapper> model
+          = dynamics::MeshShape::loadMesh(proto.meshuri(), retriever);
+      if (!model)
+        return nullptr;
+      return std::make_shared<dynamics::MeshShape>(
+          proto::deserializeVector(proto.size()),
+          model,
+          proto.meshuri(),
+          retriever);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+} // namespace
+
+//==============================================================================
+/// This writes the world out to a protobuf: every Skeleton (joints, inertia,
+/// shapes, limits and the current state), the solver settings, the action
+/// space and the cached LCP solution. Shapes that several ShapeNodes share
+/// are only written once, and meshes are written as a URI, not as geometry.
+void World::serialize(proto::World& proto) const
+{
+  proto.set_name(mName);
+  proto::serializeVector(*proto.mutable_gravity(), mGravity);
+  proto.set_timestep(static_cast<double>(mTimeStep));
+  proto.set_time(static_cast<double>(mTime));
+
+  std::unordered_map<const dynamics::Shape*, int> shapeIndices;
+  for (const dynamics::SkeletonPtr& skel : mSkeletons)
+  {
+    if (skel->getNumSoftBodyNodes() > 0)
+    {
+      dtwarn << "[World::serialize] Skeleton [" << skel->getName()
+             << "] has soft bodies, which will be written out as rigid "
+             << "bodies.\n";
+    }
+
+    proto::WorldSkeleton* skelProto = proto.add_skeletons();
+    skelProto->set_name(skel->getName());
+    skelProto->set_mobile(skel->isMobile());
+    skelProto->set_selfcollisioncheck(skel->getSelfCollisionCheck());
+    skelProto->set_adjacentbodycheck(skel->getAdjacentBodyCheck());
+
+    for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+    {
+      dynamics::BodyNode* body = skel->getBodyNode(i);
+      proto::WorldBodyNode* bodyProto = skelProto->add_bodynodes();
+      bodyProto->set_name(body->getName());
+      const dynamics::BodyNode* parent = body->getParentBodyNode();
+      bodyProto->set_parent(
+          parent == nullptr ? -1 : static_cast<int>(parent->getIndexInSkeleton()));
+      if (!serializeJoint(*bodyProto->mutable_joint(), body->getParentJoint()))
+      {
+        dtwarn << "[World::serialize] Joint ["
+               << body->getParentJoint()->getName() << "] in Skeleton ["
+               << skel->getName() << "] is a "
+               << body->getParentJoint()->getType()
+               << ", which can't be serialized. World::deserialize() will "
+               << "fail on this world.\n";
+      }
+
+      bodyProto->set_mass(static_cast<double>(body->getMass()));
+      proto::serializeVector(*bodyProto->mutable_localcom(), body->getLocalCOM());
+      Eigen::VectorXs moment = Eigen::VectorXs::Zero(6);
+      body->getMomentOfInertia(
+          moment(0), moment(1), moment(2), moment(3), moment(4), moment(5));
+      proto::serializeVector(*bodyProto->mutable_momentofinertia(), moment);
+      proto::serializeVector(*bodyProto->mutable_beta(), body->getBeta());
+      bodyProto->set_gravitymode(body->getGravityMode());
+      bodyProto->set_frictioncoeff(
+          static_cast<double>(body->getFrictionCoeff()));
+      bodyProto->set_restitutioncoeff(
+          static_cast<double>(body->getRestitutionCoeff()));
+
+      for (const dynamics::ShapeNode* shapeNode : body->getShapeNodes())
+      {
+        const dynamics::Shape* shape = shapeNode->getShape().get();
+        auto existing = shapeIndices.find(shape);
+        int shapeIndex;
+        if (existing != shapeIndices.end())
+        {
+          shapeIndex = existing->second;
+        }
+        else
+        {
+          proto::WorldShape shapeProto;
+          if (!serializeShape(shapeProto, shape))
+          {
+            dtwarn << "[World::serialize] Skipping ShapeNode ["
+                   << shapeNode->getName() << "], because its "
+                   << shape->getType() << " can't be serialized.\n";
+            continue;
+          }
+          shapeIndex = proto.shapes_size();
+          *proto.add_shapes() = shapeProto;
+          shapeIndices[shape] = shapeIndex;
+        }
+
+        proto::WorldShapeNode* shapeNodeProto = bodyProto->add_shapenodes();
+        shapeNodeProto->set_name(shapeNode->getName());
+        shapeNodeProto->set_shape(shapeIndex);
+        serializeTransform(
+            *shapeNodeProto->mutable_relativetransform(),
+            shapeNode->getRelativeTransform());
+        if (const dynamics::VisualAspect* visual = shapeNode->getVisualAspect())
+        {
+          shapeNodeProto->set_hasvisualaspect(true);
+          proto::serializeVector(
+              *shapeNodeProto->mutable_rgba(), visual->getRGBA());
+          shapeNodeProto->set_hidden(visual->getHidden());
+        }
+        if (const dynamics::CollisionAspect* collision
+            = shapeNode->getCollisionAspect())
+        {
+          shapeNodeProto->set_hascollisionaspect(true);
+          shapeNodeProto->set_collidable(collision->getCollidable());
+        }
+        if (const dynamics::DynamicsAspect* dynamicsAspect
+            = shapeNode->getDynamicsAspect())
+        {
+          shapeNodeProto->set_hasdynamicsaspect(true);
+          shapeNodeProto->set_frictioncoeff(
+              static_cast<double>(dynamicsAspect->getFrictionCoeff()));
+          shapeNodeProto->set_restitutioncoeff(
+              static_cast<double>(dynamicsAspect->getRestitutionCoeff()));
+        }
+      }
+    }
+  }
+
+  for (int index : mActionSpace)
+    proto.add_actionspace(index);
+  proto::serializeVector(
+      *proto.mutable_cachedlcpsolution(),
+      mConstraintSolver->getCachedLCPSolution());
 
-  json << "{";
+  proto.set_fallbackconstraintforcemixingconstant(
+      static_cast<double>(mFallbackConstraintForceMixingConstant));
+  proto.set_contactclippingdepth(static_cast<double>(mContactClippingDepth));
+  proto.set_speculativecontactdistance(
+      static_cast<double>(mSpeculativeContactDistance));
+  proto.set_penetrationcorrectionenabled(mPenetrationCorrectionEnabled);
+  proto.set_parallelvelocityandpositionupdates(
+      mParallelVelocityAndPositionUpdates);
+  proto.set_parallelskeletonupdates(mParallelSkeletonUpdates);
+  proto.set_implicitspringdamping(mImplicitSpringDamping);
+  proto.set_sleepingenabled(mSleepingEnabled);
+  proto.set_sleepvelocitythreshold(
+      static_cast<double>(mSleepVelocityThreshold));
+  proto.set_sleepstepthreshold(mSleepStepThreshold);
+  proto.set_maxsubsteps(mMaxSubsteps);
+  proto.set_substeppenetrationthreshold(
+      static_cast<double>(mSubstepPenetrationThreshold));
+  proto.set_substepvelocitychangethreshold(
+      static_cast<double>(mSubstepVelocityChangeThreshold));
+  proto.set_collisiondetector(
+      mConstraintSolver->getCollisionDetector()->getType());
+}
+
+//==============================================================================
+/// This writes the world out as compact binary, using serialize(). This is
+/// much faster to build and load than a skeleton file, so it's the way to
+/// ship a world to another process.
+std::string World::serialize() const
+{
+  proto::World proto;
+  serialize(proto);
+  return proto.SerializeAsString();
+}
+
+//==============================================================================
+/// This decodes a world written by serialize(). Meshes get loaded through
+/// the MeshCache with `retriever` (or a LocalResourceRetriever if that's
+/// nullptr), so deserializing the same world many times in one process only
+/// imports each mesh file once.
+std::shared_ptr<World> World::deserialize(
+    const proto::World& proto, const common::ResourceRetrieverPtr& retriever)
+{
+  common::ResourceRetrieverPtr meshRetriever = retriever;
+  if (!meshRetriever)
+    meshRetriever = std::make_shared<common::LocalResourceRetriever>();
+
+  std::shared_ptr<World> world = World::create(proto.name());
+  world->setGravity(proto::deserializeVector(proto.gravity()));
+  world->setTimeStep(proto.timestep());
+
+  if (!proto.collisiondetector().empty()
+      && proto.collisiondetector()
+             != world->getConstraintSolver()->getCollisionDetector()->getType())
+  {
+    auto detector = collision::CollisionDetector::getFactory()->create(
+        proto.collisiondetector());
+    if (detector)
+      world->getConstraintSolver()->setCollisionDetector(detector);
+    else
+      dtwarn << "[World::deserialize] Unknown collision detector ["
+             << proto.collisiondetector() << "]. Using the default.\n";
+  }
 
-  std::vector<dynamics::BodyNode*> bodies = getAllBodyNodes();
-  for (int i = 0; i < bodies.size(); i++)
+  std::vector<dynamics::ShapePtr> shapes;
+  shapes.reserve(proto.shapes_size());
+  for (const proto::WorldShape& shapeProto : proto.shapes())
   {
-    auto bodyNode = bodies[i];
-    auto skel = bodyNode->getSkeleton();
-    /*
-    // A BodyNode with two child shapes gets rendered like this:
+    shapes.push_back(deserializeShape(shapeProto, meshRetriever));
+    if (!shapes.back())
     {
-      "skel.node1": [
-        [0, 0, 0],
-        [1, 1, 1]
-      ]
+      dtwarn << "[World::deserialize] Failed to load mesh ["
+             << shapeProto.meshuri() << "]. Skipping the ShapeNodes that use "
+             << "it.\n";
     }
-    */
-    std::string name = skel->getName() + "." + bodyNode->getName();
-    json << "\"" << name << "\": [";
+  }
 
-    const std::vector<dynamics::ShapeNode*> visualShapeNodes
-        = bodyNode->getShapeNodesWith<dynamics::VisualAspect>();
-    for (int j = 0; j < visualShapeNodes.size(); j++)
+  for (const proto::WorldSkeleton& skelProto : proto.skeletons())
+  {
+    dynamics::SkeletonPtr skel = dynamics::Skeleton::create(skelProto.name());
+    std::vector<dynamics::BodyNode*> bodies;
+    bodies.reserve(skelProto.bodynodes_size());
+    for (const proto::WorldBodyNode& bodyProto : skelProto.bodynodes())
     {
-      auto shape = visualShapeNodes[j];
-      dynamics::VisualAspect* visual = shape->getVisualAspect(false);
-      if (j > 0)
-        json << ",";
-      vec3ToJson(json, visual->getColor());
+      if (bodyProto.parent() >= static_cast<int>(bodies.size()))
+      {
+        dterr << "[World::deserialize] BodyNode [" << bodyProto.name()
+              << "] comes before its parent.\n";
+        return nullptr;
+      }
+      dynamics::BodyNode* parent
+          = bodyProto.parent() < 0 ? nullptr : bodies[bodyProto.parent()];
+      dynamics::BodyNode* body
+          = deserializeJoint(bodyProto.joint(), skel, parent).second;
+      if (body == nullptr)
+      {
+        dterr << "[World::deserialize] Unsupported joint type ["
+              << bodyProto.joint().type() << "] on BodyNode ["
+              << bodyProto.name() << "].\n";
+        return nullptr;
+      }
+      bodies.push_back(body);
+
+      body->setName(bodyProto.name());
+      body->setMass(bodyProto.mass());
+      body->setLocalCOM(proto::deserializeVector(bodyProto.localcom()));
+      Eigen::VectorXs moment
+          = proto::deserializeVector(bodyProto.momentofinertia());
+      if (moment.size() == 6)
+      {
+        body->setMomentOfInertia(
+            moment(0), moment(1), moment(2), moment(3), moment(4), moment(5));
+      }
+      Eigen::VectorXs beta = proto::deserializeVector(bodyProto.beta());
+      if (beta.size() == 3)
+        body->setBeta(beta);
+      body->setGravityMode(bodyProto.gravitymode());
+      body->setFrictionCoeff(bodyProto.frictioncoeff());
+      body->setRestitutionCoeff(bodyProto.restitutioncoeff());
+
+      for (const proto::WorldShapeNode& shapeNodeProto : bodyProto.shapenodes())
+      {
+        if (shapeNodeProto.shape() < 0
+            || shapeNodeProto.shape() >= static_cast<int>(shapes.size())
+            || !shapes[shapeNodeProto.shape()])
+          continue;
+
+        dynamics::ShapeNode* shapeNode = body->createShapeNode(
+            shapes[shapeNodeProto.shape()], shapeNodeProto.name());
+        shapeNode->setRelativeTransform(
+            deserializeTransform(shapeNodeProto.relativetransform()));
+        if (shapeNodeProto.hasvisualaspect())
+        {
+          dynamics::VisualAspect* visual = shapeNode->createVisualAspect();
+          visual->setRGBA(proto::deserializeVector(shapeNodeProto.rgba()));
+          visual->setHidden(shapeNodeProto.hidden());
+        }
+        if (shapeNodeProto.hascollisionaspect())
+        {
+          shapeNode->createCollisionAspect()->setCollidable(
+              shapeNodeProto.collidable());
+        }
+        if (shapeNodeProto.hasdynamicsaspect())
+        {
+          dynamics::DynamicsAspect* dynamicsAspect
+              = shapeNode->createDynamicsAspect();
+          dynamicsAspect->setFrictionCoeff(shapeNodeProto.frictioncoeff());
+          dynamicsAspect->setRestitutionCoeff(
+              shapeNodeProto.restitutioncoeff());
+        }
+      }
     }
 
-    json << "]";
-
-    if (i < bodies.size() - 1)
-    {
-      json << ",";
-    }
+    skel->setMobile(skelProto.mobile());
+    skel->setSelfCollisionCheck(skelProto.selfcollisioncheck());
+    skel->setAdjacentBodyCheck(skelProto.adjacentbodycheck());
+    world->addSkeleton(skel);
   }
 
-  json << "}";
+  std::vector<int> actionSpace(
+      proto.actionspace().begin(), proto.actionspace().end());
+  world->setActionSpace(actionSpace);
+  world->setCachedLCPSolution(
+      proto::deserializeVector(proto.cachedlcpsolution()));
+  world->setTime(proto.time());
 
-  return json.str();
-}
+  world->setFallbackConstraintForceMixingConstant(
+      proto.fallbackconstraintforcemixingconstant());
+  world->setContactClippingDepth(proto.contactclippingdepth());
+  world->setSpeculativeContactDistance(proto.speculativecontactdistance());
+  world->setPenetrationCorrectionEnabled(proto.penetrationcorrectionenabled());
+  world->setParallelVelocityAndPositionUpdates(
+      proto.parallelvelocityandpositionupdates());
+  world->setParallelSkeletonUpdates(proto.parallelskeletonupdates());
+  world->setImplicitSpringDamping(proto.implicitspringdamping());
+  world->setSleepingEnabled(proto.sleepingenabled());
+  world->setSleepVelocityThreshold(proto.sleepvelocitythreshold());
+  world->setSleepStepThreshold(proto.sleepstepthreshold());
+  world->setMaxSubsteps(proto.maxsubsteps());
+  world->setSubstepPenetrationThreshold(proto.substeppenetrationthreshold());
+  world->setSubstepVelocityChangeThreshold(
+      proto.substepvelocitychangethreshold());
 
-//==============================================================================
-/// This gets the cached LCP solution, which is useful to be able to get/set
-/// because it can effect the forward solutions of physics problems because of
-/// our optimistic LCP-stabilization-to-acceptance approach.
-Eigen::VectorXs World::getCachedLCPSolution()
-{
-  return mConstraintSolver->getCachedLCPSolution();
+  return world;
 }
 
 //==============================================================================
-/// This gets the cached LCP solution, which is useful to be able to get/set
-/// because it can effect the forward solutions of physics problems because of
-/// our optimistic LCP-stabilization-to-acceptance approach.
-void World::setCachedLCPSolution(Eigen::VectorXs X)
+/// This decodes a world from the binary returned by serialize()
+std::shared_ptr<World> World::deserialize(
+    const std::string& bytes, const common::ResourceRetrieverPtr& retriever)
 {
-  mConstraintSolver->setCachedLCPSolution(X);
+  proto::World proto;
+  if (!proto.ParseFromString(bytes))
+  {
+    dterr << "[World::deserialize] Failed to parse the serialized world.\n";
+    return nullptr;
+  }
+  return deserialize(proto, retriever);
 }
 
 //==============================================================================
@@ -737,6 +2211,49 @@ dynamics::BodyNode* World::getBodyNodeByIndex(size_t index)
   return nodes[index];
 }
 
+//==============================================================================
+void World::getBodyWorldTransforms(
+    common::aligned_vector<Eigen::Isometry3s>& transforms) const
+{
+  std::size_t numBodies = 0;
+  for (const dynamics::SkeletonPtr& skel : mSkeletons)
+    numBodies += skel->getNumBodyNodes();
+
+  transforms.clear();
+  transforms.reserve(numBodies);
+  for (const dynamics::SkeletonPtr& skel : mSkeletons)
+  {
+    for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+      transforms.push_back(skel->getBodyNode(i)->getWorldTransform());
+  }
+}
+
+//==============================================================================
+void World::getShapeFrameWorldTransforms(
+    std::vector<const dynamics::ShapeFrame*>& shapeFrames,
+    common::aligned_vector<Eigen::Isometry3s>& transforms) const
+{
+  shapeFrames.clear();
+  transforms.clear();
+
+  std::vector<const dynamics::ShapeNode*> skelShapeNodes;
+  common::aligned_vector<Eigen::Isometry3s> skelTransforms;
+  for (const dynamics::SkeletonPtr& skel : mSkeletons)
+  {
+    skel->getShapeNodeWorldTransforms(skelShapeNodes, skelTransforms);
+    shapeFrames.insert(
+        shapeFrames.end(), skelShapeNodes.begin(), skelShapeNodes.end());
+    transforms.insert(
+        transforms.end(), skelTransforms.begin(), skelTransforms.end());
+  }
+
+  for (const dynamics::SimpleFramePtr& frame : mSimpleFrames)
+  {
+    shapeFrames.push_back(frame.get());
+    transforms.push_back(frame->getWorldTransform());
+  }
+}
+
 //==============================================================================
 std::size_t World::getNumSkeletons() const
 {
@@ -830,6 +2347,10 @@ void World::removeSkeleton(const dynamics::SkeletonPtr& _skeleton)
   // Remove _skeleton from constraint handler.
   mConstraintSolver->removeSkeleton(_skeleton);
 
+  // Don't leave a removed Skeleton asleep (and so immobile)
+  wakeSleepingSkeleton(_skeleton.get());
+  mSleepRestingSteps.erase(_skeleton.get());
+
   // Remove _skeleton from mSkeletons
   mSkeletons.erase(
       remove(mSkeletons.begin(), mSkeletons.end(), _skeleton),
@@ -1205,6 +2726,42 @@ Eigen::VectorXs World::getVelocities()
   return velocities;
 }
 
+//==============================================================================
+/// This writes the positions of all the skeletons into `out`, which must
+/// already be getNumDofs() long. Unlike getPositions(), this doesn't
+/// allocate.
+void World::getPositions(Eigen::Ref<Eigen::VectorXs> out)
+{
+  assert(out.size() == mDofs);
+  std::size_t cursor = 0;
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    std::size_t dofs = mSkeletons[i]->getNumDofs();
+    for (std::size_t j = 0; j < dofs; j++)
+    {
+      out(cursor++) = mSkeletons[i]->getDof(j)->getPosition();
+    }
+  }
+}
+
+//==============================================================================
+/// This writes the velocities of all the skeletons into `out`, which must
+/// already be getNumDofs() long. Unlike getVelocities(), this doesn't
+/// allocate.
+void World::getVelocities(Eigen::Ref<Eigen::VectorXs> out)
+{
+  assert(out.size() == mDofs);
+  std::size_t cursor = 0;
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    std::size_t dofs = mSkeletons[i]->getNumDofs();
+    for (std::size_t j = 0; j < dofs; j++)
+    {
+      out(cursor++) = mSkeletons[i]->getDof(j)->getVelocity();
+    }
+  }
+}
+
 //==============================================================================
 Eigen::VectorXs World::getAccelerations()
 {
@@ -1610,29 +3167,33 @@ Eigen::VectorXs World::getCoriolisAndGravityAndExternalForces()
 //==============================================================================
 Eigen::MatrixXs World::getMassMatrix()
 {
-  Eigen::MatrixXs massMatrix = Eigen::MatrixXs::Zero(mDofs, mDofs);
-  std::size_t cursor = 0;
+  return getBlockMassMatrix().toDense();
+}
+
+//==============================================================================
+Eigen::MatrixXs World::getInvMassMatrix()
+{
+  return getBlockInvMassMatrix().toDense();
+}
+
+//==============================================================================
+math::BlockDiagonalMatrix World::getBlockMassMatrix()
+{
+  math::BlockDiagonalMatrix massMatrix;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
-    std::size_t dofs = mSkeletons[i]->getNumDofs();
-    massMatrix.block(cursor, cursor, dofs, dofs)
-        = mSkeletons[i]->getMassMatrix();
-    cursor += dofs;
+    massMatrix.addBlock(mSkeletons[i]->getMassMatrix());
   }
   return massMatrix;
 }
 
 //==============================================================================
-Eigen::MatrixXs World::getInvMassMatrix()
+math::BlockDiagonalMatrix World::getBlockInvMassMatrix()
 {
-  Eigen::MatrixXs invMassMatrix = Eigen::MatrixXs::Zero(mDofs, mDofs);
-  std::size_t cursor = 0;
+  math::BlockDiagonalMatrix invMassMatrix;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
-    std::size_t dofs = mSkeletons[i]->getNumDofs();
-    invMassMatrix.block(cursor, cursor, dofs, dofs)
-        = mSkeletons[i]->getInvMassMatrix();
-    cursor += dofs;
+    invMassMatrix.addBlock(mSkeletons[i]->getInvMassMatrix());
   }
   return invMassMatrix;
 }
@@ -1683,6 +3244,44 @@ Eigen::VectorXs World::getState()
   return state;
 }
 
+//==============================================================================
+/// This writes [pos, vel] into `out`, which must already be getStateSize()
+/// long. Unlike getState(), this doesn't allocate.
+void World::getState(Eigen::Ref<Eigen::VectorXs> out)
+{
+  assert(out.size() == 2 * mDofs);
+  getPositions(out.head(mDofs));
+  getVelocities(out.tail(mDofs));
+}
+
+//==============================================================================
+/// This is the same as setState(), but reads `state` in place rather than
+/// taking a copy, so it can set the state straight from a caller's buffer
+/// (like a numpy array) without allocating.
+void World::setStateFrom(const Eigen::Ref<const Eigen::VectorXs>& state)
+{
+  int dofs = getNumDofs();
+  if (state.size() != 2 * dofs)
+  {
+    std::cerr << "World::setStateFrom() called with a vector of incorrect "
+              << "size (" << state.size() << ") instead of getStateSize() ("
+              << getStateSize() << "). Ignoring call." << std::endl;
+    return;
+  }
+  std::size_t cursor = 0;
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    std::size_t skelDofs = mSkeletons[i]->getNumDofs();
+    for (std::size_t j = 0; j < skelDofs; j++)
+    {
+      dynamics::DegreeOfFreedom* dof = mSkeletons[i]->getDof(j);
+      dof->setPosition(state(cursor));
+      dof->setVelocity(state(dofs + cursor));
+      cursor++;
+    }
+  }
+}
+
 //==============================================================================
 // The action dim is given by the size of the action mapping. This defaults to a
 // 1-1 map onto control forces, but can be configured to be just a subset of the
@@ -1842,41 +3441,131 @@ std::shared_ptr<neural::BackpropSnapshot> World::getCachedBackpropSnapshot()
   return mCachedSnapshotPtr;
 }
 
+//==============================================================================
+/// This turns on memoizing neural::forwardPass() on this World. The
+/// BackpropSnapshots of up to `maxEntries` recent steps are kept, and
+/// stepping from the same inputs again hands back the old snapshot instead
+/// of simulating. Passing 0 turns this off and frees the snapshots.
+void World::setForwardPassCacheSize(std::size_t maxEntries)
+{
+  if (maxEntries == 0)
+  {
+    mForwardPassCache = nullptr;
+  }
+  else if (mForwardPassCache == nullptr)
+  {
+    mForwardPassCache = std::make_shared<neural::ForwardPassCache>(maxEntries);
+  }
+  else
+  {
+    mForwardPassCache->setMaxEntries(maxEntries);
+  }
+}
+
+//==============================================================================
+/// This returns the cache set up by setForwardPassCacheSize(), or nullptr if
+/// it's off
+std::shared_ptr<neural::ForwardPassCache> World::getForwardPassCache()
+{
+  return mForwardPassCache;
+}
+
+//==============================================================================
+/// This throws out everything in the forward pass cache
+void World::clearForwardPassCache()
+{
+  if (mForwardPassCache)
+    mForwardPassCache->clear();
+}
+
+//==============================================================================
+/// This moves the World to the end of the step recorded in `snapshot`, as if
+/// step(_resetCommand) had just run from the snapshot's pre-step state
+void World::replayStep(
+    const std::shared_ptr<neural::BackpropSnapshot>& snapshot,
+    bool _resetCommand)
+{
+  setPositions(snapshot->getPostStepPosition());
+  setVelocities(snapshot->getPostStepVelocity());
+  if (_resetCommand)
+  {
+    for (auto& skel : mSkeletons)
+    {
+      skel->clearInternalForces();
+      skel->clearExternalForces();
+      skel->resetCommands();
+    }
+  }
+  mTime += mTimeStep;
+  mFrame++;
+}
+
 //==============================================================================
 // This returns the Jacobian for state_t -> state_{t+1}.
 Eigen::MatrixXs World::getStateJacobian()
 {
-  std::shared_ptr<neural::BackpropSnapshot> snapshot
-      = getCachedBackpropSnapshot();
   int dofs = getNumDofs();
-  Eigen::MatrixXs stateJac = Eigen::MatrixXs::Zero(2 * dofs, 2 * dofs);
-  WorldPtr sharedThis = shared_from_this();
-  stateJac.block(0, 0, dofs, dofs) = snapshot->getPosPosJacobian(sharedThis);
-  stateJac.block(dofs, 0, dofs, dofs) = snapshot->getPosVelJacobian(sharedThis);
-  stateJac.block(0, dofs, dofs, dofs) = snapshot->getVelPosJacobian(sharedThis);
-  stateJac.block(dofs, dofs, dofs, dofs)
-      = snapshot->getVelVelJacobian(sharedThis);
+  Eigen::MatrixXs stateJac(2 * dofs, 2 * dofs);
+  getStateJacobian(stateJac);
   return stateJac;
 }
 
 //==============================================================================
 // This returns the Jacobian for action_t -> state_{t+1}.
 Eigen::MatrixXs World::getActionJacobian()
+{
+  int dofs = getNumDofs();
+  Eigen::MatrixXs actionJac(2 * dofs, mActionSpace.size());
+  getActionJacobian(actionJac);
+  return actionJac;
+}
+
+//==============================================================================
+void World::getStateJacobian(Eigen::Ref<Eigen::MatrixXs> out)
+{
+  int dofs = getNumDofs();
+  assert(out.rows() == 2 * dofs && out.cols() == 2 * dofs);
+  StateJacobianBlocks blocks = getStateJacobianBlocks();
+  out.block(0, 0, dofs, dofs) = blocks.posPos;
+  out.block(dofs, 0, dofs, dofs) = blocks.posVel;
+  out.block(0, dofs, dofs, dofs) = blocks.velPos;
+  out.block(dofs, dofs, dofs, dofs) = blocks.velVel;
+}
+
+//==============================================================================
+void World::getActionJacobian(Eigen::Ref<Eigen::MatrixXs> out)
+{
+  int dofs = getNumDofs();
+  assert(out.rows() == 2 * dofs && out.cols() == (int)mActionSpace.size());
+  out.topRows(dofs).setZero();
+  getActionVelJacobian(out.bottomRows(dofs));
+}
+
+//==============================================================================
+void World::getActionVelJacobian(Eigen::Ref<Eigen::MatrixXs> out)
 {
   std::shared_ptr<neural::BackpropSnapshot> snapshot
       = getCachedBackpropSnapshot();
-  int dofs = getNumDofs();
-  WorldPtr sharedThis = shared_from_this();
-  const Eigen::MatrixXs& forceVelJac
-      = snapshot->getControlForceVelJacobian(sharedThis);
+  assert(
+      out.rows() == getNumDofs() && out.cols() == (int)mActionSpace.size());
+  // Only the columns for DOFs in the action space get computed
+  out = snapshot->getControlForceVelJacobianCols(
+      shared_from_this(), mActionSpace);
+}
 
-  int actionDim = mActionSpace.size();
-  Eigen::MatrixXs actionJac = Eigen::MatrixXs::Zero(2 * dofs, actionDim);
-  for (int i = 0; i < actionDim; i++)
-  {
-    actionJac.block(dofs, i, dofs, 1) = forceVelJac.col(mActionSpace[i]);
-  }
-  return actionJac;
+//==============================================================================
+World::StateJacobianBlocks World::getStateJacobianBlocks()
+{
+  std::shared_ptr<neural::BackpropSnapshot> snapshot
+      = getCachedBackpropSnapshot();
+  WorldPtr sharedThis = shared_from_this();
+  // Each of these fills a cache on the snapshot the first time it's called,
+  // and the snapshot is kept alive by the returned struct
+  const Eigen::MatrixXs& posPos = snapshot->getPosPosJacobian(sharedThis);
+  const Eigen::MatrixXs& posVel = snapshot->getPosVelJacobian(sharedThis);
+  const Eigen::MatrixXs& velPos = snapshot->getVelPosJacobian(sharedThis);
+  const Eigen::MatrixXs& velVel = snapshot->getVelVelJacobian(sharedThis);
+  return StateJacobianBlocks{snapshot, posPos, posVel, velPos, velVel};
 }
 
 //==============================================================================
@@ -2008,10 +3697,32 @@ const constraint::ConstraintSolver* World::getConstraintSolver() const
   return mConstraintSolver.get();
 }
 
+//==============================================================================
+const StepStats& World::getStepStats() const
+{
+  return mStepStats;
+}
+
+//==============================================================================
+void World::resetStepStats()
+{
+  mStepStats.reset();
+}
+
+//==============================================================================
+void World::recordBackpropNanos(long nanos)
+{
+  mStepStats.numBackprops++;
+  mStepStats.lastBackpropNanos = nanos;
+  mStepStats.totalBackpropNanos += nanos;
+  StepStats::recordDuration(mStepStats.backpropNanosHistogram, nanos);
+}
+
 //==============================================================================
 void World::bake()
 {
-  const auto collisionResult = getConstraintSolver()->getLastCollisionResult();
+  const auto& collisionResult
+      = getConstraintSolver()->getLastCollisionResult();
   const auto nContacts = static_cast<int>(collisionResult.getNumContacts());
   const auto nSkeletons = getNumSkeletons();
 
@@ -2051,16 +3762,7 @@ const Eigen::VectorXs& World::getLastPreConstraintVelocity() const
 /// complicated function to integrate to the next position.
 Eigen::MatrixXs World::getPosPosJacobian() const
 {
-  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(mDofs, mDofs);
-  int cursor = 0;
-  for (auto& skel : mSkeletons)
-  {
-    int dofs = skel->getNumDofs();
-    jac.block(cursor, cursor, dofs, dofs) = skel->getPosPosJac(
-        skel->getPositions(), skel->getVelocities(), mTimeStep);
-    cursor += dofs;
-  }
-  return jac;
+  return getBlockPosPosJacobian().toDense();
 }
 
 /// This gets the Jacobian relating how changing our current velocity will
@@ -2070,14 +3772,29 @@ Eigen::MatrixXs World::getPosPosJacobian() const
 /// actually use a complicated function to integrate to the next position.
 Eigen::MatrixXs World::getVelPosJacobian() const
 {
-  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(mDofs, mDofs);
-  int cursor = 0;
+  return getBlockVelPosJacobian().toDense();
+}
+
+//==============================================================================
+math::BlockDiagonalMatrix World::getBlockPosPosJacobian() const
+{
+  math::BlockDiagonalMatrix jac;
   for (auto& skel : mSkeletons)
   {
-    int dofs = skel->getNumDofs();
-    jac.block(cursor, cursor, dofs, dofs) = skel->getVelPosJac(
-        skel->getPositions(), skel->getVelocities(), mTimeStep);
-    cursor += dofs;
+    jac.addBlock(skel->getPosPosJac(
+        skel->getPositions(), skel->getVelocities(), mTimeStep));
+  }
+  return jac;
+}
+
+//==============================================================================
+math::BlockDiagonalMatrix World::getBlockVelPosJacobian() const
+{
+  math::BlockDiagonalMatrix jac;
+  for (auto& skel : mSkeletons)
+  {
+    jac.addBlock(skel->getVelPosJac(
+        skel->getPositions(), skel->getVelocities(), mTimeStep));
   }
   return jac;
 }
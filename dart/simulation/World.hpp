@@ -39,23 +39,30 @@
 #ifndef DART_SIMULATION_WORLD_HPP_
 #define DART_SIMULATION_WORLD_HPP_
 
+#include <functional>
+#include <future>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <Eigen/Dense>
 
 #include "dart/collision/CollisionOption.hpp"
 #include "dart/common/NameManager.hpp"
+#include "dart/common/ResourceRetriever.hpp"
 #include "dart/common/SmartPointer.hpp"
 #include "dart/common/Subject.hpp"
 #include "dart/common/Timer.hpp"
 #include "dart/constraint/SmartPointer.hpp"
 #include "dart/dynamics/SimpleFrame.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/BlockDiagonalMatrix.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
 #include "dart/simulation/Recording.hpp"
 #include "dart/simulation/SmartPointer.hpp"
+#include "dart/simulation/StepStats.hpp"
 
 namespace dart {
 
@@ -79,8 +86,13 @@ class CollisionResult;
 namespace neural {
 class WithRespectToMass;
 class BackpropSnapshot;
+class ForwardPassCache;
 } // namespace neural
 
+namespace proto {
+class World;
+} // namespace proto
+
 namespace simulation {
 
 DART_COMMON_DECLARE_SHARED_WEAK(World)
@@ -162,6 +174,20 @@ public:
 
   dynamics::BodyNode* getBodyNodeByIndex(size_t index);
 
+  /// This fills `transforms` with the world transform of every BodyNode in
+  /// this world, in the same order as getAllBodyNodes(). See
+  /// Skeleton::getBodyWorldTransforms().
+  void getBodyWorldTransforms(
+      common::aligned_vector<Eigen::Isometry3s>& transforms) const;
+
+  /// This fills `transforms` with the world transform of every ShapeFrame in
+  /// this world: the ShapeNodes of each skeleton in order (see
+  /// Skeleton::getShapeNodeWorldTransforms()), followed by the SimpleFrames.
+  /// `shapeFrames` gets the ShapeFrame that each transform belongs to.
+  void getShapeFrameWorldTransforms(
+      std::vector<const dynamics::ShapeFrame*>& shapeFrames,
+      common::aligned_vector<Eigen::Isometry3s>& transforms) const;
+
   /// Get the number of skeletons
   std::size_t getNumSkeletons() const;
 
@@ -236,6 +262,16 @@ public:
   /// as a single vector
   Eigen::VectorXs getVelocities();
 
+  /// This writes the positions of all the skeletons into `out`, which must
+  /// already be getNumDofs() long. Unlike getPositions(), this doesn't
+  /// allocate.
+  void getPositions(Eigen::Ref<Eigen::VectorXs> out);
+
+  /// This writes the velocities of all the skeletons into `out`, which must
+  /// already be getNumDofs() long. Unlike getVelocities(), this doesn't
+  /// allocate.
+  void getVelocities(Eigen::Ref<Eigen::VectorXs> out);
+
   /// Gets the acceleration of all the skeletons in the world concatenated
   /// together as a single vector
   Eigen::VectorXs getAccelerations();
@@ -385,6 +421,14 @@ public:
   /// block-diagonal concatenation of each skeleton's inverse mass matrix.
   Eigen::MatrixXs getInvMassMatrix();
 
+  /// This is the same as getMassMatrix(), but it keeps each skeleton's block
+  /// separate instead of filling in a dense world-sized matrix.
+  math::BlockDiagonalMatrix getBlockMassMatrix();
+
+  /// This is the same as getInvMassMatrix(), but it keeps each skeleton's
+  /// block separate instead of filling in a dense world-sized matrix.
+  math::BlockDiagonalMatrix getBlockInvMassMatrix();
+
   void clampPositionsToLimits();
   //--------------------------------------------------------------------------
   // High Level ("Reinforcement Learning style") API
@@ -405,6 +449,15 @@ public:
   // This return the concatenation of [pos, vel]
   Eigen::VectorXs getState();
 
+  /// This writes [pos, vel] into `out`, which must already be getStateSize()
+  /// long. Unlike getState(), this doesn't allocate.
+  void getState(Eigen::Ref<Eigen::VectorXs> out);
+
+  /// This is the same as setState(), but reads `state` in place rather than
+  /// taking a copy, so it can set the state straight from a caller's buffer
+  /// (like a numpy array) without allocating.
+  void setStateFrom(const Eigen::Ref<const Eigen::VectorXs>& state);
+
   // The action dim is given by the size of the action mapping. This defaults to
   // a 1-1 map onto control forces, but can be configured to be just a subset of
   // the control forces, if there are several DOFs that are uncontrolled.
@@ -437,9 +490,68 @@ public:
   // This returns the Jacobian for action_t -> state_{t+1}.
   Eigen::MatrixXs getActionJacobian();
 
+  /// This writes the Jacobian for state_t -> state_{t+1} into `out`, which
+  /// must already be getStateSize() x getStateSize(). Unlike
+  /// getStateJacobian(), this doesn't allocate, so controllers that need the
+  /// Jacobian every step can keep reusing one buffer.
+  void getStateJacobian(Eigen::Ref<Eigen::MatrixXs> out);
+
+  /// This writes the Jacobian for action_t -> state_{t+1} into `out`, which
+  /// must already be getStateSize() x getActionSize(). The position rows are
+  /// always zero, see getActionVelJacobian() to skip them.
+  void getActionJacobian(Eigen::Ref<Eigen::MatrixXs> out);
+
+  /// This writes just the velocity rows of getActionJacobian() (the only rows
+  /// that can be non-zero) into `out`, which must already be getNumDofs() x
+  /// getActionSize().
+  void getActionVelJacobian(Eigen::Ref<Eigen::MatrixXs> out);
+
+  /// The four blocks of getStateJacobian(), left where the cached
+  /// BackpropSnapshot computed them rather than being copied into one
+  /// 2n x 2n matrix. Holding on to this keeps the snapshot alive.
+  struct StateJacobianBlocks
+  {
+    std::shared_ptr<neural::BackpropSnapshot> snapshot;
+    /// d pos_{t+1} / d pos_t
+    const Eigen::MatrixXs& posPos;
+    /// d vel_{t+1} / d pos_t
+    const Eigen::MatrixXs& posVel;
+    /// d pos_{t+1} / d vel_t
+    const Eigen::MatrixXs& velPos;
+    /// d vel_{t+1} / d vel_t
+    const Eigen::MatrixXs& velVel;
+  };
+
+  /// This returns the blocks of the Jacobian for state_t -> state_{t+1},
+  /// without assembling or copying them
+  StateJacobianBlocks getStateJacobianBlocks();
+
   Eigen::MatrixXs finiteDifferenceStateJacobian();
   Eigen::MatrixXs finiteDifferenceActionJacobian();
 
+  /// This turns on memoizing neural::forwardPass() on this World. The
+  /// BackpropSnapshots of up to `maxEntries` recent steps are kept, and
+  /// stepping from the same inputs again hands back the old snapshot instead
+  /// of simulating. Passing 0 turns this off and frees the snapshots. See
+  /// neural::ForwardPassCache for what counts as the same inputs.
+  void setForwardPassCacheSize(std::size_t maxEntries);
+
+  /// This returns the cache set up by setForwardPassCacheSize(), or nullptr
+  /// if it's off
+  std::shared_ptr<neural::ForwardPassCache> getForwardPassCache();
+
+  /// This throws out everything in the forward pass cache. Call this after
+  /// changing anything that isn't part of the cache's key, like the collision
+  /// detector or joint damping.
+  void clearForwardPassCache();
+
+  /// This moves the World to the end of the step recorded in `snapshot`, as
+  /// if step(_resetCommand) had just run from the snapshot's pre-step state.
+  /// This is how a cached forward pass skips the simulation.
+  void replayStep(
+      const std::shared_ptr<neural::BackpropSnapshot>& snapshot,
+      bool _resetCommand = true);
+
   //--------------------------------------------------------------------------
   // Collision checking
   //--------------------------------------------------------------------------
@@ -476,6 +588,35 @@ public:
   /// command after simulation step.
   void step(bool _resetCommand = true);
 
+  /// This runs step(_resetCommand) on the global common::ThreadPool, and
+  /// returns a future that's ready once the step is done (and rethrows
+  /// anything the step threw). This lets the caller do other work, like
+  /// running a policy, while the World steps. The World must be owned by a
+  /// shared_ptr, which the task holds on to until it's done. Don't read or
+  /// change the World until the future is ready.
+  std::future<void> stepAsync(bool _resetCommand = true);
+
+  /// This advances by getTimeStep() like step(), but if the step turns out to
+  /// have an impact in it (see getSubstepsForLastStep()) then it's rolled
+  /// back and retaken as that many equal substeps. Steps without impacts cost
+  /// a single step(), and steps with them cost one extra. This returns the
+  /// number of substeps that were kept.
+  ///
+  /// If `snapshots` isn't null, it's filled with one BackpropSnapshot per kept
+  /// substep, in order. Each one backprops with its own substep's timestep, so
+  /// they chain exactly like the snapshots of consecutive step() calls.
+  int stepAdaptive(
+      bool _resetCommand = true,
+      std::vector<std::shared_ptr<neural::BackpropSnapshot>>* snapshots
+      = nullptr);
+
+  /// This looks at the step that just finished, and returns how many substeps
+  /// it should have been split into, between 1 and getMaxSubsteps(). This
+  /// grows with the deepest contact penetration and the largest change in any
+  /// DOF velocity, relative to their thresholds, and any contact that bounced
+  /// asks for the maximum.
+  int getSubstepsForLastStep();
+
   /// Integrate non-constraint forces.
   void integrateVelocities();
 
@@ -493,7 +634,7 @@ public:
   void integrateVelocitiesFromImpulses(bool _resetCommand = true);
 
   /// Integrate positions.
-  void integratePositions(Eigen::VectorXs initialVelocity);
+  void integratePositions(const Eigen::VectorXs& initialVelocity);
 
   /// Set current time
   void setTime(s_t _time);
@@ -523,6 +664,17 @@ public:
   /// Get the constraint solver
   const constraint::ConstraintSolver* getConstraintSolver() const;
 
+  /// This returns the always-on counters for what step() (and backprop
+  /// through this World) has been spending its time on
+  const StepStats& getStepStats() const;
+
+  /// This zeros all the counters returned by getStepStats()
+  void resetStepStats();
+
+  /// This records how long a backprop through a step of this World took.
+  /// BackpropSnapshot::backprop() calls this.
+  void recordBackpropNanos(long nanos);
+
   /// Bake simulated current state and store it into mRecording
   void bake();
 
@@ -551,6 +703,14 @@ public:
   /// actually use a complicated function to integrate to the next position.
   Eigen::MatrixXs getVelPosJacobian() const;
 
+  /// This is the same as getPosPosJacobian(), but it keeps each skeleton's
+  /// block separate instead of filling in a dense world-sized matrix.
+  math::BlockDiagonalMatrix getBlockPosPosJacobian() const;
+
+  /// This is the same as getVelPosJacobian(), but it keeps each skeleton's
+  /// block separate instead of filling in a dense world-sized matrix.
+  math::BlockDiagonalMatrix getBlockVelPosJacobian() const;
+
   /// True if we want to update p_{t+1} as f(p_t, v_t), rather than the old
   /// f(p_t, v_{t+1}). This makes it much easier to reason about
   /// backpropagation, but it can introduce simulation instability in some
@@ -559,6 +719,24 @@ public:
 
   bool getParallelVelocityAndPositionUpdates();
 
+  /// False by default. If true, the per-skeleton forward dynamics and velocity
+  /// updates in step() are spread across the global ThreadPool, one skeleton
+  /// per task. This only pays off for worlds with several mobile skeletons.
+  /// Unlike setParallelVelocityAndPositionUpdates(), this doesn't change the
+  /// result of a step.
+  void setParallelSkeletonUpdates(bool enable);
+
+  bool getParallelSkeletonUpdates();
+
+  /// False by default. If true, step() integrates joint springs and damping
+  /// implicitly (see Skeleton::applyImplicitSpringDamping()) instead of
+  /// semi-explicitly. Stiff springs and heavy damping then stay stable at
+  /// much larger timesteps. Snapshots taken from these steps differentiate
+  /// the implicit update.
+  void setImplicitSpringDamping(bool enable);
+
+  bool getImplicitSpringDamping();
+
   /// True by default. Sets whether or not to apply artifical "penetration
   /// correction" forces to objects that inter-penetrate.
   void setPenetrationCorrectionEnabled(bool enable);
@@ -590,6 +768,77 @@ public:
   /// impossibly deep inter-penetration during multiple shooting optimization.
   s_t getContactClippingDepth();
 
+  /// Shapes that are separated by less than this distance get a speculative
+  /// contact, which lets them close the gap during a timestep but no more.
+  /// This keeps fast moving objects from tunneling through thin geometry at
+  /// large timesteps. Zero (the default) turns speculative contacts off.
+  void setSpeculativeContactDistance(s_t distance);
+
+  /// Shapes that are separated by less than this distance get a speculative
+  /// contact, which lets them close the gap during a timestep but no more.
+  s_t getSpeculativeContactDistance();
+
+  /// When sleeping is enabled, groups of Skeletons touching each other
+  /// ("islands") that have all stayed below the sleep velocity threshold for
+  /// the sleep step threshold worth of timesteps get put to sleep. A sleeping
+  /// Skeleton is treated as immobile, so it skips forward dynamics,
+  /// integration, and contact solving against other static objects, until a
+  /// force, a velocity, or a contact with a moving Skeleton wakes it back up.
+  /// This is off by default, because sleeping bodies look static to gradients.
+  void setSleepingEnabled(bool enable);
+
+  /// Returns true if resting Skeletons get put to sleep
+  bool getSleepingEnabled();
+
+  /// A Skeleton counts as resting on a timestep if no velocity on any of its
+  /// DOFs is larger than this.
+  void setSleepVelocityThreshold(s_t threshold);
+
+  /// A Skeleton counts as resting on a timestep if no velocity on any of its
+  /// DOFs is larger than this.
+  s_t getSleepVelocityThreshold();
+
+  /// This is how many timesteps in a row a whole island has to be resting
+  /// before it gets put to sleep.
+  void setSleepStepThreshold(int steps);
+
+  /// This is how many timesteps in a row a whole island has to be resting
+  /// before it gets put to sleep.
+  int getSleepStepThreshold();
+
+  /// Returns true if this Skeleton has been put to sleep
+  bool isSleeping(const dynamics::SkeletonPtr& skel) const;
+
+  /// This wakes up a sleeping Skeleton, and resets its resting count. Anything
+  /// still asleep in the same island wakes up on the next timestep.
+  void wakeSkeleton(const dynamics::SkeletonPtr& skel);
+
+  /// This wakes up every sleeping Skeleton in the world
+  void wakeAllSkeletons();
+
+  /// This is the most substeps stepAdaptive() will split a step into. It's 1
+  /// by default, which means stepAdaptive() is just step().
+  void setMaxSubsteps(int substeps);
+
+  /// This is the most substeps stepAdaptive() will split a step into.
+  int getMaxSubsteps();
+
+  /// A step gets one more substep for every multiple of this depth that its
+  /// deepest contact penetrates.
+  void setSubstepPenetrationThreshold(s_t depth);
+
+  /// A step gets one more substep for every multiple of this depth that its
+  /// deepest contact penetrates.
+  s_t getSubstepPenetrationThreshold();
+
+  /// A step gets one more substep for every multiple of this that any DOF
+  /// velocity changes by over the step.
+  void setSubstepVelocityChangeThreshold(s_t change);
+
+  /// A step gets one more substep for every multiple of this that any DOF
+  /// velocity changes by over the step.
+  s_t getSubstepVelocityChangeThreshold();
+
   /// This returns the object that we're using to keep track of which objects in
   /// the world need gradients through which kinds of mass.
   std::shared_ptr<neural::WithRespectToMass> getWrtMass();
@@ -605,6 +854,47 @@ public:
   /// already have the original world loaded. Good for real-time viewing.
   std::string colorsToJson();
 
+  /// This packs the world transform of every visual shape into a compact
+  /// binary blob, which is much cheaper than positionsToJson() to build and to
+  /// parse, so it's fine to call every step. Shapes come in the same order as
+  /// in toJson() (every BodyNode from getAllBodyNodes(), then each of its
+  /// visual shapes), and javascript/src/WorldSnapshot.ts decodes the result.
+  ///
+  /// If `positionPrecision` is zero, positions and XYZ Euler angles are sent
+  /// as float32. Otherwise, positions are rounded to the nearest multiple of
+  /// `positionPrecision` and sent as int32, and angles are sent as int16. If
+  /// `includeColors` is true, each shape also carries its color as 3 bytes.
+  std::string positionsToBinary(
+      s_t positionPrecision = 0.0, bool includeColors = false);
+
+  /// This writes the world out to a protobuf: every Skeleton (joints, inertia,
+  /// shapes, limits and the current state), the solver settings, the action
+  /// space and the cached LCP solution. Shapes that several ShapeNodes share
+  /// are only written once, and meshes are written as a URI, not as geometry.
+  ///
+  /// SimpleFrames, soft body meshes, mimic joint links, scale groups and which
+  /// skeletons are asleep aren't written out. CustomJoints can't be written at
+  /// all, so this warns about them, and deserialize() will fail on the result.
+  void serialize(proto::World& proto) const;
+
+  /// This writes the world out as compact binary, using serialize(). This is
+  /// much faster to build and load than a skeleton file, so it's the way to
+  /// ship a world to another process.
+  std::string serialize() const;
+
+  /// This decodes a world written by serialize(). Meshes get loaded through
+  /// the MeshCache with `retriever` (or a LocalResourceRetriever if that's
+  /// nullptr), so deserializing the same world many times in one process only
+  /// imports each mesh file once.
+  static std::shared_ptr<World> deserialize(
+      const proto::World& proto,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This decodes a world from the binary returned by serialize()
+  static std::shared_ptr<World> deserialize(
+      const std::string& bytes,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
   /// This gets the cached LCP solution, which is useful to be able to get/set
   /// because it can effect the forward solutions of physics problems because of
   /// our optimistic LCP-stabilization-to-acceptance approach.
@@ -615,6 +905,14 @@ public:
   /// our optimistic LCP-stabilization-to-acceptance approach.
   void setCachedLCPSolution(Eigen::VectorXs X);
 
+  /// This copies the cached LCP solution into `out`. Unlike
+  /// getCachedLCPSolution(), this only allocates if `out` is the wrong size.
+  void getCachedLCPSolutionInto(Eigen::VectorXs& out);
+
+  /// This sets the cached LCP solution. Unlike setCachedLCPSolution(), this
+  /// doesn't copy `X` first.
+  void setCachedLCPSolutionFrom(const Eigen::Ref<const Eigen::VectorXs>& X);
+
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
   /// bug in the analytical Jacobians that's causing learning to not converge.
@@ -651,6 +949,21 @@ protected:
   /// Register when a SimpleFrame's name is changed
   void handleSimpleFrameNameChange(const dynamics::Entity* _entity);
 
+  /// Run fn on every mobile Skeleton, spread across the global ThreadPool if
+  /// mParallelSkeletonUpdates is set. This blocks until every call is done.
+  void forEachMobileSkeleton(
+      const std::function<void(dynamics::Skeleton*)>& fn);
+
+  /// This calls step(), and if `snapshots` isn't null it also records a
+  /// BackpropSnapshot of the step, the way neural::forwardPass() does
+  void stepAndRecord(
+      bool _resetCommand,
+      std::vector<std::shared_ptr<neural::BackpropSnapshot>>* snapshots);
+
+  /// This clears the forces and commands on every mobile Skeleton, which is
+  /// what step(true) does at the end of a step
+  void clearCommands();
+
   /// Name of this World
   std::string mName;
 
@@ -712,6 +1025,14 @@ protected:
   /// timestep, before we solved the LCP for constraints
   Eigen::VectorXs mLastPreConstraintVelocity;
 
+  /// This holds the velocities at the start of the current step(). It's kept
+  /// around between steps so that step() can reuse its buffer instead of
+  /// allocating a fresh one every time.
+  Eigen::VectorXs mStepInitialVelocity;
+
+  /// These are the counters behind getStepStats()
+  StepStats mStepStats;
+
   /// Constraint engine which solves for constraint impulses and integrates
   /// velocities according to the given impulses.
   constraintEngineFnType mConstraintEngineFn;
@@ -722,6 +1043,14 @@ protected:
   /// environments. True by default.
   bool mParallelVelocityAndPositionUpdates;
 
+  /// True if we want to run the per-skeleton dynamics updates on the global
+  /// ThreadPool. False by default.
+  bool mParallelSkeletonUpdates;
+
+  /// True if step() treats joint springs and damping implicitly. False by
+  /// default.
+  bool mImplicitSpringDamping;
+
   /// True if we want to enable artificial penetration correction forces
   bool mPenetrationCorrectionEnabled;
 
@@ -743,6 +1072,46 @@ protected:
   /// impossibly deep inter-penetration during multiple shooting optimization.
   s_t mContactClippingDepth;
 
+  /// Shapes that are separated by less than this distance get a speculative
+  /// contact
+  s_t mSpeculativeContactDistance;
+
+  /// This wakes up any sleeping Skeletons that have been given forces or
+  /// velocities since the last timestep.
+  void wakeSkeletonsWithInputs();
+
+  /// This groups Skeletons into islands through the last timestep's contacts,
+  /// and then puts to sleep (or wakes up) whole islands at a time.
+  void updateSleepingSkeletons();
+
+  /// This makes a sleeping Skeleton mobile again, and resets its resting
+  /// count
+  void wakeSleepingSkeleton(const dynamics::Skeleton* skel);
+
+  /// If true, resting islands get put to sleep
+  bool mSleepingEnabled;
+
+  /// Skeletons with no DOF velocity larger than this count as resting
+  s_t mSleepVelocityThreshold;
+
+  /// How many resting timesteps in a row put an island to sleep
+  int mSleepStepThreshold;
+
+  /// The most substeps stepAdaptive() splits a step into
+  int mMaxSubsteps;
+
+  /// Each multiple of this contact depth adds a substep
+  s_t mSubstepPenetrationThreshold;
+
+  /// Each multiple of this change in velocity adds a substep
+  s_t mSubstepVelocityChangeThreshold;
+
+  /// How many timesteps in a row each awake Skeleton has been resting
+  std::unordered_map<const dynamics::Skeleton*, int> mSleepRestingSteps;
+
+  /// The Skeletons we've put to sleep (and made immobile)
+  std::unordered_set<const dynamics::Skeleton*> mSleepingSkeletons;
+
   //--------------------------------------------------------------------------
   // Signals
   //--------------------------------------------------------------------------
@@ -768,6 +1137,8 @@ protected:
   Eigen::VectorXs mCachedSnapshotVel;
   Eigen::VectorXs mCachedSnapshotForce;
 
+  std::shared_ptr<neural::ForwardPassCache> mForwardPassCache;
+
 public:
   //--------------------------------------------------------------------------
   // Slot registers
@@ -1,5 +1,7 @@
 #include "dart/trajectory/IPOptOptimizer.hpp"
 
+#include <algorithm>
+#include <iostream>
 #include <vector>
 
 #include <coin/IpIpoptApplication.hpp>
@@ -33,7 +35,11 @@ IPOptOptimizer::IPOptOptimizer()
     mSuppressOutput(false),
     mSilenceOutput(false),
     mDisableLinesearch(false),
-    mRecordIterations(true)
+    mRecordIterations(true),
+    mRecordingPolicy(IterationRecordingPolicy::ALL),
+    mRecordingPolicyN(1),
+    mGaussNewtonHessian(false),
+    mUseLBFGSB(false)
 {
 }
 
@@ -41,6 +47,11 @@ IPOptOptimizer::IPOptOptimizer()
 std::shared_ptr<Solution> IPOptOptimizer::optimize(
     Problem* shot, std::shared_ptr<Solution> reuseRecord)
 {
+  if (mUseLBFGSB && shot->getConstraintDim() == 0)
+  {
+    return optimizeWithLBFGSB(shot, reuseRecord);
+  }
+
   // Create an instance of the IpoptApplication
   //
   // We are using the factory, since this allows us to compile this
@@ -55,8 +66,11 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       "linear_solver",
       "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
 
+  bool gaussNewtonHessian
+      = mGaussNewtonHessian && shot->getNumLeastSquaresResiduals() > 0;
   app->Options()->SetStringValue(
-      "hessian_approximation", "limited-memory"); // limited-memory, exacty
+      "hessian_approximation",
+      gaussNewtonHessian ? "exact" : "limited-memory");
 
   /*
   app->Options()->SetStringValue(
@@ -101,6 +115,9 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       = reuseRecord ? reuseRecord : std::make_shared<Solution>();
   if (mRecordPerfLog)
     record->startPerfLog();
+  record->setIterationRecordingPolicy(mRecordingPolicy, mRecordingPolicyN);
+  if (mStreamPath != "")
+    record->setIterationStreamPath(mStreamPath);
 
   // Initialize the IpoptApplication and process the options
   Ipopt::ApplicationReturnStatus status;
@@ -123,7 +140,8 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       mRecoverBest,
       mRecordFullDebugInfo,
       mSuppressOutput && !mSilenceOutput,
-      mRecordIterations);
+      mRecordIterations,
+      gaussNewtonHessian);
   for (auto& callback : mIntermediateCallbacks)
   {
     problem->registerIntermediateCallback(callback);
@@ -153,6 +171,78 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
   return record;
 }
 
+//==============================================================================
+/// This solves an unconstrained `shot` with mLBFGSB, using the same
+/// iteration limit, tolerance and LBFGS history length we'd give IPOPT
+std::shared_ptr<Solution> IPOptOptimizer::optimizeWithLBFGSB(
+    Problem* shot, std::shared_ptr<Solution> reuseRecord)
+{
+  std::shared_ptr<Solution> record
+      = reuseRecord ? reuseRecord : std::make_shared<Solution>();
+  if (mRecordPerfLog)
+    record->startPerfLog();
+  record->setIterationRecordingPolicy(mRecordingPolicy, mRecordingPolicyN);
+  if (mStreamPath != "")
+    record->setIterationStreamPath(mStreamPath);
+
+  int n = shot->getFlatProblemDim(shot->mWorld);
+  Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs lower = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs upper = Eigen::VectorXs::Zero(n);
+  shot->getInitialGuess(shot->mWorld, x);
+  shot->getLowerBounds(shot->mWorld, lower);
+  shot->getUpperBounds(shot->mWorld, upper);
+
+  mLBFGSB.setConfig(math::LBFGSBConfig()
+                        .setMaxIterations(mIterationLimit)
+                        .setHistoryLength(std::max(mLBFGSHistoryLength, 1))
+                        .setGradientTolerance(mTolerance)
+                        .setLogOutput(!mSuppressOutput && !mSilenceOutput));
+  mLBFGSB.setIterationCallback(
+      [this, shot, record](int iter, s_t loss, const Eigen::VectorXs&) {
+        // The accepted step is always the last one we evaluated, so the
+        // World and rollout cache are already up to date
+        if (mRecordIterations)
+        {
+          record->registerIteration(
+              iter, shot->getRolloutCache(shot->mWorld), loss, 0.0);
+        }
+        bool allCallbacksReturnedTrue = true;
+        for (auto& callback : mIntermediateCallbacks)
+        {
+          if (!callback(shot, iter, loss, 0.0))
+          {
+            allCallbacksReturnedTrue = false;
+          }
+        }
+        return allCallbacksReturnedTrue;
+      });
+
+  math::LBFGSBResult result = mLBFGSB.minimize(
+      [shot](const Eigen::VectorXs& x, Eigen::VectorXs& grad) {
+        shot->unflatten(shot->mWorld, x);
+        s_t loss = shot->getLoss(shot->mWorld);
+        shot->backpropGradient(shot->mWorld, grad);
+        return loss;
+      },
+      x,
+      lower,
+      upper);
+  mLBFGSB.setIterationCallback(nullptr);
+  // If the last line search failed, the World is still at a rejected step
+  shot->unflatten(shot->mWorld, x);
+
+  if (!mSilenceOutput)
+  {
+    std::cout << "*** L-BFGS-B stopped after " << result.iterations
+              << " iterations, with a final loss of " << result.loss << '.'
+              << std::endl;
+  }
+
+  record->setSuccess(result.converged());
+  return record;
+}
+
 //==============================================================================
 void IPOptOptimizer::setIterationLimit(int iterationLimit)
 {
@@ -225,5 +315,37 @@ void IPOptOptimizer::setRecordIterations(bool recordIterations)
   mRecordIterations = recordIterations;
 }
 
+//==============================================================================
+void IPOptOptimizer::setIterationRecordingPolicy(
+    IterationRecordingPolicy policy, int n)
+{
+  mRecordingPolicy = policy;
+  mRecordingPolicyN = n;
+}
+
+//==============================================================================
+void IPOptOptimizer::setIterationStreamPath(const std::string& path)
+{
+  mStreamPath = path;
+}
+
+//==============================================================================
+/// If true, and the problem has least-squares residuals registered with
+/// Problem::addLeastSquaresResidual(), this gives IPOPT the Gauss-Newton
+/// Hessian of the loss instead of using LBFGS
+void IPOptOptimizer::setGaussNewtonHessian(bool gaussNewtonHessian)
+{
+  mGaussNewtonHessian = gaussNewtonHessian;
+}
+
+//==============================================================================
+/// If true, problems with no constraints (only bounds) get solved in-process
+/// by math::LBFGSB instead of by IPOPT, which skips IPOPT's setup costs on
+/// small problems. Problems with constraints still go to IPOPT.
+void IPOptOptimizer::setUseLBFGSB(bool useLBFGSB)
+{
+  mUseLBFGSB = useLBFGSB;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <coin/IpIpoptApplication.hpp>
 #include <coin/IpTNLP.hpp>
 
+#include "dart/math/LBFGSB.hpp"
 #include "dart/trajectory/Optimizer.hpp"
 #include "dart/trajectory/Problem.hpp"
 #include "dart/trajectory/Solution.hpp"
@@ -61,7 +62,30 @@ public:
 
   void setRecordIterations(bool recordIterations);
 
+  /// This sets how much iteration history the Solution we return keeps around.
+  /// See Solution::setIterationRecordingPolicy().
+  void setIterationRecordingPolicy(IterationRecordingPolicy policy, int n = 1);
+
+  /// This sets where the Solution streams iterations to, if we're using
+  /// IterationRecordingPolicy::STREAM_TO_DISK
+  void setIterationStreamPath(const std::string& path);
+
+  /// If true, and the problem has least-squares residuals registered with
+  /// Problem::addLeastSquaresResidual(), this gives IPOPT the Gauss-Newton
+  /// Hessian of the loss instead of using LBFGS
+  void setGaussNewtonHessian(bool gaussNewtonHessian);
+
+  /// If true, problems with no constraints (only bounds) get solved in-process
+  /// by math::LBFGSB instead of by IPOPT, which skips IPOPT's setup costs on
+  /// small problems. Problems with constraints still go to IPOPT.
+  void setUseLBFGSB(bool useLBFGSB);
+
 protected:
+  /// This solves an unconstrained `shot` with mLBFGSB, using the same
+  /// iteration limit, tolerance and LBFGS history length we'd give IPOPT
+  std::shared_ptr<Solution> optimizeWithLBFGSB(
+      Problem* shot, std::shared_ptr<Solution> reuseRecord);
+
   int mIterationLimit;
   s_t mTolerance;
   int mLBFGSHistoryLength;
@@ -74,6 +98,13 @@ protected:
   bool mSilenceOutput;
   bool mDisableLinesearch;
   bool mRecordIterations;
+  IterationRecordingPolicy mRecordingPolicy;
+  int mRecordingPolicyN;
+  std::string mStreamPath;
+  bool mGaussNewtonHessian;
+  bool mUseLBFGSB;
+  // This keeps its workspace between calls to optimize()
+  math::LBFGSB mLBFGSB;
 };
 
 } // namespace trajectory
@@ -33,12 +33,14 @@ IPOptShotWrapper::IPOptShotWrapper(
     bool recoverBest,
     bool recordFullDebugInfo,
     bool printIterations,
-    bool recordIterations)
+    bool recordIterations,
+    bool gaussNewtonHessian)
   : mWrapped(wrapped),
     mRecord(record),
     mRecoverBest(recoverBest),
     mRecordFullDebugInfo(recordFullDebugInfo),
     mRecordIterations(recordIterations),
+    mGaussNewtonHessian(gaussNewtonHessian),
     mBestIter(-1),
     mBestFeasibleObjectiveValue(std::numeric_limits<double>::infinity()),
     mBestFeasibleState(Eigen::VectorXd::Zero(0)),
@@ -81,7 +83,14 @@ bool IPOptShotWrapper::get_nlp_info(
   nnz_jac_g = mWrapped->getNumberNonZeroJacobian(mWrapped->mWorld);
 
   // Set the number of entries in the Hessian
-  nnz_h_lag = n * n;
+  if (mGaussNewtonHessian)
+  {
+    nnz_h_lag = mWrapped->getNumberNonZeroHessian(mWrapped->mWorld);
+  }
+  else
+  {
+    nnz_h_lag = n * n;
+  }
 
   // use the C style indexing (0-based)
   index_style = Ipopt::TNLP::C_STYLE;
@@ -206,8 +215,18 @@ bool IPOptShotWrapper::get_starting_point(
   {
     Eigen::Map<Eigen::VectorXd> zU_vec(z_U, n);
     Eigen::Map<Eigen::VectorXd> zL_vec(z_L, n);
-    zU_vec = mSaved_zU;
-    zL_vec = mSaved_zL;
+    // If we've never finished a solve there's nothing saved yet, so we start
+    // from zero and let IPOPT push the multipliers away from the bounds
+    if (mSaved_zU.size() == n && mSaved_zL.size() == n)
+    {
+      zU_vec = mSaved_zU;
+      zL_vec = mSaved_zL;
+    }
+    else
+    {
+      zU_vec.setZero();
+      zL_vec.setZero();
+    }
     /*
     std::cout << "Initializing lower/upper bounds for z is not supported yet. "
               << "Ignored here.\n";
@@ -219,7 +238,14 @@ bool IPOptShotWrapper::get_starting_point(
   if (init_lambda)
   {
     Eigen::Map<Eigen::VectorXd> lambda_vec(lambda, m);
-    lambda_vec = mSaved_lambda;
+    if (mSaved_lambda.size() == m)
+    {
+      lambda_vec = mSaved_lambda;
+    }
+    else
+    {
+      lambda_vec.setZero();
+    }
     /*
     std::cout << "Initializing lambda is not supported yet. "
               << "Ignored here.\n";
@@ -258,13 +284,7 @@ bool IPOptShotWrapper::eval_f(
   assert(_n == mWrapped->getFlatProblemDim(mWrapped->mWorld));
   if (_new_x && _n > 0)
   {
-    Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
-#ifdef DART_USE_ARBITRARY_PRECISION
-    Eigen::VectorXs flat_s = flat.cast<s_t>();
-    mWrapped->unflatten(mWrapped->mWorld, flat_s, perflog);
-#else
-    mWrapped->unflatten(mWrapped->mWorld, flat, perflog);
-#endif
+    unflattenX(_n, _x, perflog);
   }
   _obj_value
       = static_cast<double>(mWrapped->getLoss(mWrapped->mWorld, perflog));
@@ -318,19 +338,13 @@ bool IPOptShotWrapper::eval_grad_f(
   assert(_n == mWrapped->getFlatProblemDim(mWrapped->mWorld));
   if (_new_x && _n > 0)
   {
-    Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
-#ifdef DART_USE_ARBITRARY_PRECISION
-    Eigen::VectorXs flat_s = flat.cast<s_t>();
-    mWrapped->unflatten(mWrapped->mWorld, flat_s, perflog);
-#else
-    mWrapped->unflatten(mWrapped->mWorld, flat, perflog);
-#endif
+    unflattenX(_n, _x, perflog);
   }
   Eigen::Map<Eigen::VectorXd> grad(_grad_f, _n);
 #ifdef DART_USE_ARBITRARY_PRECISION
-  Eigen::VectorXs grad_s(_n);
-  mWrapped->backpropGradient(mWrapped->mWorld, grad_s, perflog);
-  grad = grad_s.cast<double>();
+  mOutScratch.resize(_n);
+  mWrapped->backpropGradient(mWrapped->mWorld, mOutScratch, perflog);
+  grad = mOutScratch.cast<double>();
 #else
   mWrapped->backpropGradient(mWrapped->mWorld, grad, perflog);
 #endif
@@ -392,19 +406,13 @@ bool IPOptShotWrapper::eval_g(
   assert(_m == mWrapped->getConstraintDim());
   if (_new_x && _n > 0)
   {
-    Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
-#ifdef DART_USE_ARBITRARY_PRECISION
-    Eigen::VectorXs flat_s = flat.cast<s_t>();
-    mWrapped->unflatten(mWrapped->mWorld, flat_s, perflog);
-#else
-    mWrapped->unflatten(mWrapped->mWorld, flat, perflog);
-#endif
+    unflattenX(_n, _x, perflog);
   }
   Eigen::Map<Eigen::VectorXd> constraints(_g, _m);
 #ifdef DART_USE_ARBITRARY_PRECISION
-  Eigen::VectorXs constraints_s(_m);
-  mWrapped->computeConstraints(mWrapped->mWorld, constraints_s, perflog);
-  constraints = constraints_s.cast<double>();
+  mOutScratch.resize(_m);
+  mWrapped->computeConstraints(mWrapped->mWorld, mOutScratch, perflog);
+  constraints = mOutScratch.cast<double>();
 #else
   mWrapped->computeConstraints(mWrapped->mWorld, constraints, perflog);
 #endif
@@ -502,19 +510,13 @@ bool IPOptShotWrapper::eval_jac_g(
   {
     if (_new_x && _n > 0)
     {
-      Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
-#ifdef DART_USE_ARBITRARY_PRECISION
-      Eigen::VectorXs flat_s = flat.cast<s_t>();
-      mWrapped->unflatten(mWrapped->mWorld, flat_s, perflog);
-#else
-      mWrapped->unflatten(mWrapped->mWorld, flat, perflog);
-#endif
+      unflattenX(_n, _x, perflog);
     }
     Eigen::Map<Eigen::VectorXd> sparse(_values, _nnzj);
 #ifdef DART_USE_ARBITRARY_PRECISION
-    Eigen::VectorXs sparse_s(_nnzj);
-    mWrapped->getSparseJacobian(mWrapped->mWorld, sparse_s, perflog);
-    sparse = sparse_s.cast<double>();
+    mOutScratch.resize(_nnzj);
+    mWrapped->getSparseJacobian(mWrapped->mWorld, mOutScratch, perflog);
+    sparse = mOutScratch.cast<double>();
 #else
     mWrapped->getSparseJacobian(mWrapped->mWorld, sparse, perflog);
 #endif
@@ -569,36 +571,70 @@ bool IPOptShotWrapper::eval_jac_g(
 
 //==============================================================================
 bool IPOptShotWrapper::eval_h(
-    Ipopt::Index /* _n */,
-    const Ipopt::Number* /* _x */,
-    bool /* _new_x */,
-    Ipopt::Number /* _obj_factor */,
+    Ipopt::Index _n,
+    const Ipopt::Number* _x,
+    bool _new_x,
+    Ipopt::Number _obj_factor,
     Ipopt::Index /* _m */,
     const Ipopt::Number* /* _lambda */,
     bool /* _new_lambda */,
-    Ipopt::Index /* _nele_hess */,
-    Ipopt::Index* /* _iRow */,
-    Ipopt::Index* /* _jCol */,
-    Ipopt::Number* /* _values */)
+    Ipopt::Index _nele_hess,
+    Ipopt::Index* _iRow,
+    Ipopt::Index* _jCol,
+    Ipopt::Number* _values)
 {
-  // TODO(JS): Not implemented yet.
-  std::cout << "[IPOptShotWrapper::eval_h] Not implemented yet.\n";
+  // Without Gauss-Newton, IPOPT is running LBFGS and should never ask
+  if (!mGaussNewtonHessian)
+  {
+    std::cout << "[IPOptShotWrapper::eval_h] Not implemented yet.\n";
+    return false;
+  }
 
-  /*
-  return TNLP::eval_h(
-      _n,
-      _x,
-      _new_x,
-      _obj_factor,
-      _m,
-      _lambda,
-      _new_lambda,
-      _nele_hess,
-      _iRow,
-      _jCol,
-      _values);
-      */
-  return false;
+  PerformanceLog* perflog = nullptr;
+#ifdef LOG_PERFORMANCE_IPOPT
+  if (mRecord->getPerfLog() != nullptr)
+  {
+    perflog = mRecord->getPerfLog()->startRun("IPOptShotWrapper.eval_h");
+  }
+#endif
+
+  if (nullptr == _values)
+  {
+    // return the structure of the lower triangle of the Hessian
+    assert(_nele_hess == mWrapped->getNumberNonZeroHessian(mWrapped->mWorld));
+    Eigen::Map<Eigen::VectorXi> rows(_iRow, _nele_hess);
+    Eigen::Map<Eigen::VectorXi> cols(_jCol, _nele_hess);
+    mWrapped->getHessianSparsityStructure(
+        mWrapped->mWorld, rows, cols, perflog);
+  }
+  else
+  {
+    if (_new_x && _n > 0)
+    {
+      unflattenX(_n, _x, perflog);
+    }
+    // The constraints are treated as linear, so the multipliers drop out and
+    // we only need the (scaled) curvature of the loss
+    Eigen::Map<Eigen::VectorXd> sparse(_values, _nele_hess);
+#ifdef DART_USE_ARBITRARY_PRECISION
+    mOutScratch.resize(_nele_hess);
+    mWrapped->getSparseGaussNewtonHessian(
+        mWrapped->mWorld, mOutScratch, perflog);
+    sparse = mOutScratch.cast<double>() * _obj_factor;
+#else
+    mWrapped->getSparseGaussNewtonHessian(mWrapped->mWorld, sparse, perflog);
+    sparse *= _obj_factor;
+#endif
+  }
+
+#ifdef LOG_PERFORMANCE_IPOPT
+  if (perflog != nullptr)
+  {
+    perflog->end();
+  }
+#endif
+
+  return true;
 }
 
 //==============================================================================
@@ -773,6 +809,32 @@ void IPOptShotWrapper::prep_for_reoptimize()
   mBestIter = -1;
 }
 
+/// This gets called after the wrapped problem has been shifted in time (for
+/// example by Problem::advanceSteps()), to move the saved bound multipliers
+/// along with the primal variables they belong to. `mapping` gives, for each
+/// new flat index, the old flat index its value came from. The constraint
+/// multipliers are left where they are, because the knot constraints don't
+/// move when the horizon advances.
+void IPOptShotWrapper::shift_multipliers(const Eigen::VectorXi& mapping)
+{
+  if (mSaved_zL.size() == mapping.size())
+  {
+    Eigen::VectorXd oldZL = mSaved_zL;
+    for (int i = 0; i < mapping.size(); i++)
+    {
+      mSaved_zL(i) = oldZL(mapping(i));
+    }
+  }
+  if (mSaved_zU.size() == mapping.size())
+  {
+    Eigen::VectorXd oldZU = mSaved_zU;
+    for (int i = 0; i < mapping.size(); i++)
+    {
+      mSaved_zU(i) = oldZU(mapping(i));
+    }
+  }
+}
+
 /// This records a single call of eval_f(). If this returns false, then we
 /// need to terminate this call to eval_f().
 bool IPOptShotWrapper::can_eval_f(bool new_x)
@@ -839,5 +901,19 @@ void IPOptShotWrapper::registerIntermediateCallback(
   mIntermediateCallbacks.push_back(callback);
 }
 
+/// This loads IPOPT's x into the wrapped problem. With doubles the problem
+/// reads straight out of IPOPT's array, without copying it first.
+void IPOptShotWrapper::unflattenX(
+    Ipopt::Index n, const Ipopt::Number* x, PerformanceLog* log)
+{
+  Eigen::Map<const Eigen::VectorXd> flat(x, n);
+#ifdef DART_USE_ARBITRARY_PRECISION
+  mFlatScratch = flat.cast<s_t>();
+  mWrapped->unflatten(mWrapped->mWorld, mFlatScratch, log);
+#else
+  mWrapped->unflatten(mWrapped->mWorld, flat, log);
+#endif
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
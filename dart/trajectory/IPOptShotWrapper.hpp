@@ -36,7 +36,8 @@ public:
       bool recoverBest = true,
       bool recordFullDebugInfo = false,
       bool printIterations = false,
-      bool recordIterations = true);
+      bool recordIterations = true,
+      bool gaussNewtonHessian = false);
 
   /// Destructor
   ~IPOptShotWrapper();
@@ -157,6 +158,14 @@ public:
   /// This gets called when we're about to repoptimize, to let us reset values.
   void prep_for_reoptimize();
 
+  /// This gets called after the wrapped problem has been shifted in time (for
+  /// example by Problem::advanceSteps()), to move the saved bound multipliers
+  /// along with the primal variables they belong to. `mapping` gives, for each
+  /// new flat index, the old flat index its value came from. The constraint
+  /// multipliers are left where they are, because the knot constraints don't
+  /// move when the horizon advances.
+  void shift_multipliers(const Eigen::VectorXi& mapping);
+
   /// This records a single call of eval_f(). If this returns false, then we
   /// need to terminate this call to eval_f().
   bool can_eval_f(bool new_x);
@@ -188,11 +197,18 @@ public:
           callback);
 
 private:
+  /// This loads IPOPT's x into the wrapped problem. With doubles the problem
+  /// reads straight out of IPOPT's array, without copying it first.
+  void unflattenX(Ipopt::Index n, const Ipopt::Number* x, PerformanceLog* log);
+
   Problem* mWrapped;
   std::shared_ptr<Solution> mRecord;
   bool mRecoverBest;
   bool mRecordFullDebugInfo;
   bool mRecordIterations;
+  // If true, we give IPOPT the Gauss-Newton Hessian of the loss, instead of
+  // leaving it to build up an LBFGS approximation
+  bool mGaussNewtonHessian;
   int mBestIter;
   double mBestFeasibleObjectiveValue;
   Eigen::VectorXd mBestFeasibleState;
@@ -209,6 +225,13 @@ private:
   Eigen::VectorXd mSaved_zL;
   Eigen::VectorXd mSaved_lambda;
 
+#ifdef DART_USE_ARBITRARY_PRECISION
+  // IPOPT only speaks doubles, so values get converted through these. They're
+  // kept around so the callbacks don't reallocate them every time.
+  Eigen::VectorXs mFlatScratch;
+  Eigen::VectorXs mOutScratch;
+#endif
+
   std::vector<std::function<bool(Problem* problem, int, s_t primal, s_t dual)>>
       mIntermediateCallbacks;
 };
@@ -1,5 +1,10 @@
 #include "dart/trajectory/LossFn.hpp"
 
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include "dart/common/ThreadPool.hpp"
 #include "dart/utils/tl_optional.hpp"
 
 #define LOG_PERFORMANCE_LOSS_FN
@@ -14,7 +19,12 @@ LossFn::LossFn()
   : mLoss(tl::nullopt),
     mLossAndGrad(tl::nullopt),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
-    mUpperBound(std::numeric_limits<s_t>::infinity())
+    mUpperBound(std::numeric_limits<s_t>::infinity()),
+    mTimestepLoss(tl::nullopt),
+    mTimestepLossAndGrad(tl::nullopt),
+    mStartTime(0),
+    mEndTime(0),
+    mParallelOperationsEnabled(false)
 {
 }
 
@@ -23,7 +33,12 @@ LossFn::LossFn(TrajectoryLossFn loss)
   : mLoss(loss),
     mLossAndGrad(tl::nullopt),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
-    mUpperBound(std::numeric_limits<s_t>::infinity())
+    mUpperBound(std::numeric_limits<s_t>::infinity()),
+    mTimestepLoss(tl::nullopt),
+    mTimestepLossAndGrad(tl::nullopt),
+    mStartTime(0),
+    mEndTime(0),
+    mParallelOperationsEnabled(false)
 {
 }
 
@@ -32,7 +47,12 @@ LossFn::LossFn(TrajectoryLossFn loss, TrajectoryLossFnAndGrad lossAndGrad)
   : mLoss(loss),
     mLossAndGrad(lossAndGrad),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
-    mUpperBound(std::numeric_limits<s_t>::infinity())
+    mUpperBound(std::numeric_limits<s_t>::infinity()),
+    mTimestepLoss(tl::nullopt),
+    mTimestepLossAndGrad(tl::nullopt),
+    mStartTime(0),
+    mEndTime(0),
+    mParallelOperationsEnabled(false)
 {
 }
 
@@ -55,7 +75,11 @@ s_t LossFn::getLoss(
 
   s_t loss = 0.0;
 
-  if (mLoss)
+  if (mTimestepLoss)
+  {
+    loss = getTimestepLoss(rollout);
+  }
+  else if (mLoss)
   {
     loss = mLoss.value()(rollout);
   }
@@ -86,7 +110,11 @@ s_t LossFn::getLossAndGradient(
 
   s_t loss = 0.0;
 
-  if (mLossAndGrad)
+  if (mTimestepLoss)
+  {
+    loss = getTimestepLossAndGradient(rollout, gradWrtRollout);
+  }
+  else if (mLossAndGrad)
   {
     loss = mLossAndGrad.value()(rollout, gradWrtRollout);
   }
@@ -218,5 +246,214 @@ void LossFn::setUpperBound(s_t upperBound)
   mUpperBound = upperBound;
 }
 
+//==============================================================================
+/// This returns true if this loss is a sum of independent per-timestep
+/// terms over [getStartTime(), getEndTime()), in which case it can't
+/// depend on anything outside that window.
+bool LossFn::isTimestepSeparable() const
+{
+  return mTimestepLoss.has_value();
+}
+
+//==============================================================================
+/// This is the first timestep a separable loss reads
+int LossFn::getStartTime() const
+{
+  return mStartTime;
+}
+
+//==============================================================================
+/// This is one past the last timestep a separable loss reads
+int LossFn::getEndTime() const
+{
+  return mEndTime;
+}
+
+//==============================================================================
+/// This turns on evaluating the terms of a separable loss in parallel on
+/// the global thread pool. Only turn this on if the term functions are
+/// thread-safe (which rules out Python callbacks).
+void LossFn::setParallelOperationsEnabled(bool enabled)
+{
+  mParallelOperationsEnabled = enabled;
+}
+
+//==============================================================================
+/// This sums the timestep terms over the window
+s_t LossFn::getTimestepLoss(const TrajectoryRollout* rollout)
+{
+  int steps = rollout->getPosesConst().cols();
+  int start = std::max(mStartTime, 0);
+  int end = std::min(mEndTime, steps);
+
+  auto sumRange = [this, rollout](int from, int to) {
+    s_t sum = 0.0;
+    for (int t = from; t < to; t++)
+    {
+      const TrajectoryRolloutConstRef timestep = rollout->sliceConst(t, 1);
+      sum += mTimestepLoss.value()(&timestep, t);
+    }
+    return sum;
+  };
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  int numChunks = std::min<int>(pool.getNumThreads(), end - start);
+  if (!mParallelOperationsEnabled || numChunks <= 1)
+  {
+    return sumRange(start, end);
+  }
+
+  std::vector<std::future<s_t>> futures;
+  for (int i = 0; i < numChunks; i++)
+  {
+    int from = start + (end - start) * i / numChunks;
+    int to = start + (end - start) * (i + 1) / numChunks;
+    futures.push_back(pool.submit(sumRange, from, to));
+  }
+  pool.waitAll(futures);
+  // Sum in a fixed order, so the result doesn't depend on scheduling
+  s_t loss = 0.0;
+  for (std::future<s_t>& future : futures)
+  {
+    loss += future.get();
+  }
+  return loss;
+}
+
+//==============================================================================
+/// This sums the timestep terms over the window, and fills in the gradient,
+/// which is zero outside the window
+s_t LossFn::getTimestepLossAndGradient(
+    const TrajectoryRollout* rollout,
+    /* OUT */ TrajectoryRollout* gradWrtRollout)
+{
+  gradWrtRollout->getMasses().setZero();
+  for (std::string key : gradWrtRollout->getMappings())
+  {
+    gradWrtRollout->getPoses(key).setZero();
+    gradWrtRollout->getVels(key).setZero();
+    gradWrtRollout->getControlForces(key).setZero();
+  }
+
+  int steps = rollout->getPosesConst().cols();
+  int start = std::max(mStartTime, 0);
+  int end = std::min(mEndTime, steps);
+  int massDim = rollout->getMassesConst().size();
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  int numChunks = std::min<int>(pool.getNumThreads(), end - start);
+  if (!mParallelOperationsEnabled || numChunks <= 1)
+  {
+    Eigen::VectorXs gradWrtMass = Eigen::VectorXs::Zero(massDim);
+    s_t loss = accumulateTimestepLossAndGradient(
+        rollout, start, end, gradWrtRollout, gradWrtMass);
+    gradWrtRollout->getMasses() = gradWrtMass;
+    return loss;
+  }
+
+  // Every chunk writes its own columns of the gradient, but the mass gradient
+  // is shared, so each chunk sums into its own copy of that
+  std::vector<Eigen::VectorXs> gradWrtMasses(
+      numChunks, Eigen::VectorXs::Zero(massDim));
+  std::vector<std::future<s_t>> futures;
+  for (int i = 0; i < numChunks; i++)
+  {
+    int from = start + (end - start) * i / numChunks;
+    int to = start + (end - start) * (i + 1) / numChunks;
+    Eigen::VectorXs* gradWrtMass = &gradWrtMasses[i];
+    futures.push_back(pool.submit([=]() {
+      return accumulateTimestepLossAndGradient(
+          rollout, from, to, gradWrtRollout, *gradWrtMass);
+    }));
+  }
+  pool.waitAll(futures);
+  s_t loss = 0.0;
+  for (int i = 0; i < numChunks; i++)
+  {
+    loss += futures[i].get();
+    gradWrtRollout->getMasses() += gradWrtMasses[i];
+  }
+  return loss;
+}
+
+//==============================================================================
+/// This scores the timesteps in [start, end), writing their columns of the
+/// gradient and adding their mass gradients into `gradWrtMass`. Different
+/// ranges touch disjoint columns, so they can run concurrently.
+s_t LossFn::accumulateTimestepLossAndGradient(
+    const TrajectoryRollout* rollout,
+    int start,
+    int end,
+    /* OUT */ TrajectoryRollout* gradWrtRollout,
+    /* OUT */ Eigen::VectorXs& gradWrtMass)
+{
+  if (start >= end)
+  {
+    return 0.0;
+  }
+
+  // This gets reused as scratch space for every step in the range
+  const TrajectoryRolloutConstRef firstTimestep = rollout->sliceConst(start, 1);
+  TrajectoryRolloutReal gradWrtTimestep(&firstTimestep);
+
+  s_t loss = 0.0;
+  for (int t = start; t < end; t++)
+  {
+    const TrajectoryRolloutConstRef timestep = rollout->sliceConst(t, 1);
+    gradWrtTimestep.setZero();
+    if (mTimestepLossAndGrad)
+    {
+      loss += mTimestepLossAndGrad.value()(&timestep, t, &gradWrtTimestep);
+    }
+    else
+    {
+      // Reuse the whole-rollout finite differencing, but only on this step
+      TimestepLossTerm term = mTimestepLoss.value();
+      LossFn stepLoss([&term, t](const TrajectoryRollout* step) {
+        return term(step, t);
+      });
+      loss += stepLoss.getLossAndGradient(&timestep, &gradWrtTimestep);
+    }
+
+    gradWrtMass += gradWrtTimestep.getMassesConst();
+    for (std::string key : gradWrtRollout->getMappings())
+    {
+      gradWrtRollout->getPoses(key).col(t)
+          = gradWrtTimestep.getPosesConst(key).col(0);
+      gradWrtRollout->getVels(key).col(t)
+          = gradWrtTimestep.getVelsConst(key).col(0);
+      gradWrtRollout->getControlForces(key).col(t)
+          = gradWrtTimestep.getControlForcesConst(key).col(0);
+    }
+  }
+  return loss;
+}
+
+//==============================================================================
+/// Gradients of `loss` get taken by finite differencing each timestep on
+/// its own, which is far cheaper than differencing the whole rollout
+TimestepLossFn::TimestepLossFn(
+    TimestepLossTerm loss, int startTime, int endTime)
+  : LossFn()
+{
+  mTimestepLoss = loss;
+  mStartTime = startTime;
+  mEndTime = endTime;
+}
+
+//==============================================================================
+TimestepLossFn::TimestepLossFn(
+    TimestepLossTerm loss,
+    TimestepLossTermAndGrad lossAndGrad,
+    int startTime,
+    int endTime)
+  : LossFn()
+{
+  mTimestepLoss = loss;
+  mTimestepLossAndGrad = lossAndGrad;
+  mStartTime = startTime;
+  mEndTime = endTime;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -24,6 +24,19 @@ typedef std::function<s_t(
     /* OUT */ TrajectoryRollout* gradWrtRollout)>
     TrajectoryLossFnAndGrad;
 
+/// This scores a single timestep. `timestep` is a one-step slice of the
+/// rollout, and `time` is the index of that step in the full rollout.
+typedef std::function<s_t(const TrajectoryRollout* timestep, int time)>
+    TimestepLossTerm;
+
+/// This scores a single timestep, and writes the gradient into
+/// `gradWrtTimestep`, which is a zeroed one-step rollout.
+typedef std::function<s_t(
+    const TrajectoryRollout* timestep,
+    int time,
+    /* OUT */ TrajectoryRollout* gradWrtTimestep)>
+    TimestepLossTermAndGrad;
+
 class LossFn
 {
 public:
@@ -59,7 +72,43 @@ public:
   /// it's allowed to reach
   void setUpperBound(s_t upperBound);
 
+  /// This returns true if this loss is a sum of independent per-timestep
+  /// terms over [getStartTime(), getEndTime()), in which case it can't
+  /// depend on anything outside that window.
+  bool isTimestepSeparable() const;
+
+  /// This is the first timestep a separable loss reads
+  int getStartTime() const;
+
+  /// This is one past the last timestep a separable loss reads
+  int getEndTime() const;
+
+  /// This turns on evaluating the terms of a separable loss in parallel on
+  /// the global thread pool. Only turn this on if the term functions are
+  /// thread-safe (which rules out Python callbacks).
+  void setParallelOperationsEnabled(bool enabled);
+
 protected:
+  /// This sums the timestep terms over the window
+  s_t getTimestepLoss(const TrajectoryRollout* rollout);
+
+  /// This sums the timestep terms over the window, and fills in the gradient,
+  /// which is zero outside the window
+  s_t getTimestepLossAndGradient(
+      const TrajectoryRollout* rollout,
+      /* OUT */ TrajectoryRollout* gradWrtRollout);
+
+  /// This scores the timesteps in [start, end), writing their columns of the
+  /// gradient and adding their mass gradients into `gradWrtMass`. Different
+  /// ranges touch disjoint columns, so they can run concurrently.
+  s_t accumulateTimestepLossAndGradient(
+      const TrajectoryRollout* rollout,
+      int start,
+      int end,
+      /* OUT */ TrajectoryRollout* gradWrtRollout,
+      /* OUT */ Eigen::VectorXs& gradWrtMass);
+
+
   tl::optional<TrajectoryLossFn> mLoss;
   tl::optional<TrajectoryLossFnAndGrad> mLossAndGrad;
   // If this loss function is being used as a constraint, this is the lower
@@ -68,6 +117,33 @@ protected:
   // If this loss function is being used as a constraint, this is the upper
   // bound it's allowed to reach
   s_t mUpperBound;
+  // If this is a separable loss, these are the per-timestep terms, and the
+  // window [mStartTime, mEndTime) they're summed over
+  tl::optional<TimestepLossTerm> mTimestepLoss;
+  tl::optional<TimestepLossTermAndGrad> mTimestepLossAndGrad;
+  int mStartTime;
+  int mEndTime;
+  bool mParallelOperationsEnabled;
+};
+
+/// This is a loss that's a sum of independent terms, one per timestep, over
+/// the window [startTime, endTime). Declaring the window lets a Problem
+/// report only the Jacobian columns that can actually affect those steps.
+///
+/// All the state lives in LossFn, so it's safe to pass one of these anywhere
+/// that takes a LossFn by value.
+class TimestepLossFn : public LossFn
+{
+public:
+  /// Gradients of `loss` get taken by finite differencing each timestep on
+  /// its own, which is far cheaper than differencing the whole rollout
+  TimestepLossFn(TimestepLossTerm loss, int startTime, int endTime);
+
+  TimestepLossFn(
+      TimestepLossTerm loss,
+      TimestepLossTermAndGrad lossAndGrad,
+      int startTime,
+      int endTime);
 };
 
 } // namespace trajectory
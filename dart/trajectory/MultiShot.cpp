@@ -1,8 +1,11 @@
 #include "dart/trajectory/MultiShot.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <future>
 #include <vector>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -45,6 +48,7 @@ MultiShot::MultiShot(
     stepsRemaining -= shot;
     isFirst = false;
   }
+  mShotCosts.resize(mShots.size(), 0.0);
 }
 
 //==============================================================================
@@ -63,12 +67,488 @@ void MultiShot::setParallelOperationsEnabled(bool enabled)
     // call this (at least prior to Eigen 3.3)
     Eigen::initParallel();
 
+    // Shots within a single callback run concurrently, but there's no point
+    // keeping more clones around than there are workers to run them. The
+    // clones persist across optimizer iterations, so this is the only place
+    // we pay for them.
+    std::size_t numWorlds = std::min(
+        mShots.size(), common::ThreadPool::getGlobal().getNumThreads());
+    numWorlds = std::max(numWorlds, (std::size_t)1);
     mParallelWorlds.clear();
-    for (int i = 0; i < mShots.size(); i++)
+    for (std::size_t i = 0; i < numWorlds; i++)
     {
       mParallelWorlds.push_back(mWorld->clone());
     }
   }
+  else
+  {
+    mParallelWorlds.clear();
+  }
+}
+
+//==============================================================================
+/// This returns the number of world clones that parallel operations are
+/// spread across. This is 0 when parallel operations are disabled.
+int MultiShot::getNumParallelWorlds() const
+{
+  return mParallelWorlds.size();
+}
+
+//==============================================================================
+/// This returns the world clone that `shot` is bound to when parallel
+/// operations are enabled
+std::shared_ptr<simulation::World> MultiShot::getParallelWorld(int shot)
+{
+  return mParallelWorlds[shot % mParallelWorlds.size()];
+}
+
+//==============================================================================
+/// This runs `perShot(shot, world)` for every shot from `firstShot` to the
+/// end, spread across the persistent world clones. Each clone gets its shots
+/// in order inside a single pool task, so a clone is never used by two
+/// threads at once. This blocks until every shot is done.
+void MultiShot::runShotsInParallel(
+    int firstShot,
+    const std::function<void(int, std::shared_ptr<simulation::World>)>&
+        perShot)
+{
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  std::vector<std::vector<int>> schedule = scheduleShots(firstShot);
+  for (int w = 0; w < schedule.size(); w++)
+  {
+    std::shared_ptr<simulation::World> world = mParallelWorlds[w];
+    const std::vector<int>& shots = schedule[w];
+    auto task = [this, &perShot, &shots, world]() {
+      for (int i : shots)
+      {
+        auto start = std::chrono::steady_clock::now();
+        perShot(i, world);
+        std::chrono::duration<double> elapsed
+            = std::chrono::steady_clock::now() - start;
+        // Only this task ever runs shot `i`, so this write doesn't race
+        mShotCosts[i] = mShotCosts[i] > 0
+                            ? 0.5 * (mShotCosts[i] + elapsed.count())
+                            : elapsed.count();
+      }
+    };
+    futures.push_back(pool.submit(task));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+}
+
+//==============================================================================
+/// This splits the shots from `firstShot` to the end across the world
+/// clones, so that each clone gets roughly the same total cost. This is the
+/// greedy longest-first rule: hand out the most expensive shots first, each
+/// to the least loaded clone. Shots that haven't been timed yet are costed by
+/// their length, at the average per-step time of the shots that have.
+/// When the ThreadPool is in deterministic mode, this ignores the timings and
+/// deals shots out round robin, so each shot always lands on the same clone
+/// (and sees the same warm starts) from run to run.
+std::vector<std::vector<int>> MultiShot::scheduleShots(int firstShot) const
+{
+  int numShots = mShots.size();
+  if (common::ThreadPool::isDeterministic())
+  {
+    std::vector<std::vector<int>> schedule(mParallelWorlds.size());
+    for (int i = firstShot; i < numShots; i++)
+    {
+      schedule[i % mParallelWorlds.size()].push_back(i);
+    }
+    return schedule;
+  }
+
+  double timedSeconds = 0.0;
+  int timedSteps = 0;
+  for (int i = firstShot; i < numShots; i++)
+  {
+    if (mShotCosts[i] > 0)
+    {
+      timedSeconds += mShotCosts[i];
+      timedSteps += mShots[i]->getNumSteps();
+    }
+  }
+  double secondsPerStep = timedSteps > 0 ? timedSeconds / timedSteps : 1.0;
+
+  std::vector<std::pair<double, int>> costs;
+  for (int i = firstShot; i < numShots; i++)
+  {
+    double cost = mShotCosts[i] > 0 ? mShotCosts[i]
+                                    : secondsPerStep * mShots[i]->getNumSteps();
+    costs.emplace_back(-cost, i);
+  }
+  std::sort(costs.begin(), costs.end());
+
+  std::vector<std::vector<int>> schedule(mParallelWorlds.size());
+  std::vector<double> loads(mParallelWorlds.size(), 0.0);
+  for (std::pair<double, int>& cost : costs)
+  {
+    int w = std::min_element(loads.begin(), loads.end()) - loads.begin();
+    schedule[w].push_back(cost.second);
+    loads[w] -= cost.first;
+  }
+  // Each clone still walks its shots in time order
+  for (std::vector<int>& shots : schedule)
+  {
+    std::sort(shots.begin(), shots.end());
+  }
+  return schedule;
+}
+
+//==============================================================================
+/// This returns the number of timesteps in each shot, in order
+std::vector<int> MultiShot::getShotLengths() const
+{
+  std::vector<int> lengths;
+  for (const std::shared_ptr<SingleShot>& shot : mShots)
+  {
+    lengths.push_back(shot->getNumSteps());
+  }
+  return lengths;
+}
+
+//==============================================================================
+/// This re-partitions the trajectory into shots of the given lengths, which
+/// must sum to the number of steps. Forces and pinned forces carry over
+/// unchanged. Knots that already existed keep their state, and new knots
+/// start from wherever the old shot they land in had rolled out to. This
+/// changes the size of the flat problem.
+void MultiShot::setShotLengths(
+    std::shared_ptr<simulation::World> world, const std::vector<int>& lengths)
+{
+  int totalSteps = 0;
+  for (int length : lengths)
+  {
+    if (length <= 0)
+    {
+      std::cout << "ERROR: MultiShot::setShotLengths() got a shot of length "
+                << length << ", ignoring" << std::endl;
+      return;
+    }
+    totalSteps += length;
+  }
+  if (totalSteps != mSteps)
+  {
+    std::cout << "ERROR: MultiShot::setShotLengths() got shot lengths that "
+                 "sum to "
+              << totalSteps << ", but the trajectory has " << mSteps
+              << " steps, ignoring" << std::endl;
+    return;
+  }
+
+  // Lay the current plan out along one timeline, so we can cut it back up at
+  // the new knots
+  int dofs = world->getNumDofs();
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Zero(dofs, mSteps);
+  Eigen::MatrixXs pinnedForces = Eigen::MatrixXs::Zero(dofs, mSteps);
+  std::vector<bool> pinned;
+  std::vector<int> oldStarts;
+  int cursor = 0;
+  for (const std::shared_ptr<SingleShot>& shot : mShots)
+  {
+    int steps = shot->getNumSteps();
+    forces.block(0, cursor, dofs, steps) = shot->getControlForcesRaw();
+    for (int t = 0; t < steps; t++)
+    {
+      pinned.push_back(shot->isForcePinned(t));
+      pinnedForces.col(cursor + t) = shot->getPinnedForce(t);
+    }
+    oldStarts.push_back(cursor);
+    cursor += steps;
+  }
+
+  std::vector<std::shared_ptr<SingleShot>> shots;
+  LossFn zeroLoss = LossFn();
+  int oldShot = 0;
+  cursor = 0;
+  for (int i = 0; i < lengths.size(); i++)
+  {
+    while (oldShot + 1 < oldStarts.size() && oldStarts[oldShot + 1] <= cursor)
+    {
+      oldShot++;
+    }
+    int offset = cursor - oldStarts[oldShot];
+
+    std::shared_ptr<SingleShot> shot = std::make_shared<SingleShot>(
+        world, zeroLoss, lengths[i], i > 0 || mTuneStartingState);
+    for (auto pair : mMappings)
+    {
+      shot->addMapping(pair.first, pair.second);
+    }
+    if (offset == 0)
+    {
+      shot->setStartPos(mShots[oldShot]->getStartPos());
+      shot->setStartVel(mShots[oldShot]->getStartVel());
+    }
+    else
+    {
+      MappedBackpropSnapshotPtr snapshot
+          = mShots[oldShot]->getSnapshots(world)[offset - 1];
+      shot->setStartPos(snapshot->getPostStepPosition("identity"));
+      shot->setStartVel(snapshot->getPostStepVelocity("identity"));
+    }
+    shot->setControlForcesRaw(forces.block(0, cursor, dofs, lengths[i]));
+    for (int t = 0; t < lengths[i]; t++)
+    {
+      if (pinned[cursor + t])
+      {
+        shot->pinForce(t, pinnedForces.col(cursor + t));
+      }
+    }
+    shots.push_back(shot);
+    cursor += lengths[i];
+  }
+
+  mShots = shots;
+  mShotCosts.assign(mShots.size(), 0.0);
+  mRolloutCacheDirty = true;
+  // The flat problem layout changed, so cached Jacobian structure is stale
+  // even if its overall size happens to match
+  mJacobianStructureShape.clear();
+  mSparseJacobianShape.clear();
+  if (mParallelOperationsEnabled)
+  {
+    setParallelOperationsEnabled(true);
+  }
+}
+
+//==============================================================================
+/// This re-partitions the trajectory based on how the current plan behaves.
+/// Shots with a knot defect at their end above `splitDefect`, or where the
+/// number of contacts changes partway through, get split in two (at the
+/// contact change, if there is one). Neighbouring smooth shots whose knot
+/// defect is below `mergeDefect` get merged, up to `maxShotLength`. Shots are
+/// never split below `minShotLength`. This returns true if the shots changed.
+bool MultiShot::adaptShots(
+    std::shared_ptr<simulation::World> world,
+    s_t splitDefect,
+    s_t mergeDefect,
+    int minShotLength,
+    int maxShotLength,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("MultiShot.adaptShots");
+  }
+#endif
+
+  int numShots = mShots.size();
+  // The defect at the knot after each shot (0 after the last one), and the
+  // first step inside each shot where the number of contacts changes (-1 if
+  // it never does)
+  std::vector<s_t> defects(numShots, 0.0);
+  std::vector<int> contactEvents(numShots, -1);
+  auto measureShot = [&](int i, std::shared_ptr<simulation::World> w) {
+    std::vector<MappedBackpropSnapshotPtr> snapshots
+        = mShots[i]->getSnapshots(w, thisLog);
+    for (int t = 1; t < snapshots.size(); t++)
+    {
+      if (snapshots[t]->getUnderlyingSnapshot()->getNumContacts()
+          != snapshots[t - 1]->getUnderlyingSnapshot()->getNumContacts())
+      {
+        contactEvents[i] = t;
+        break;
+      }
+    }
+    if (i + 1 < numShots)
+    {
+      defects[i] = (mShots[i]->getFinalState(w, thisLog)
+                    - mShots[i + 1]->getStartState())
+                       .norm();
+    }
+  };
+  if (mParallelOperationsEnabled)
+  {
+    runShotsInParallel(0, measureShot);
+  }
+  else
+  {
+    for (int i = 0; i < numShots; i++)
+    {
+      measureShot(i, world);
+    }
+  }
+
+  // Split pass. Shots that needed splitting (whether or not they were long
+  // enough to) are locked, so the merge pass won't undo it.
+  std::vector<int> lengths;
+  std::vector<bool> locked;
+  std::vector<s_t> defectsAfter;
+  for (int i = 0; i < numShots; i++)
+  {
+    int steps = mShots[i]->getNumSteps();
+    bool rough = defects[i] > splitDefect || contactEvents[i] != -1;
+    if (rough && steps >= 2 * minShotLength)
+    {
+      int cut = steps / 2;
+      if (contactEvents[i] != -1)
+      {
+        cut = std::min(
+            std::max(contactEvents[i], minShotLength), steps - minShotLength);
+      }
+      lengths.push_back(cut);
+      locked.push_back(true);
+      defectsAfter.push_back(0.0);
+      lengths.push_back(steps - cut);
+      locked.push_back(true);
+      defectsAfter.push_back(defects[i]);
+    }
+    else
+    {
+      lengths.push_back(steps);
+      locked.push_back(rough);
+      defectsAfter.push_back(defects[i]);
+    }
+  }
+
+  // Merge pass
+  std::vector<int> newLengths;
+  bool previousMergeable = false;
+  s_t previousDefect = 0.0;
+  for (int j = 0; j < lengths.size(); j++)
+  {
+    if (previousMergeable && !locked[j] && previousDefect < mergeDefect
+        && newLengths.back() + lengths[j] <= maxShotLength)
+    {
+      newLengths.back() += lengths[j];
+    }
+    else
+    {
+      newLengths.push_back(lengths[j]);
+    }
+    previousMergeable = !locked[j];
+    previousDefect = defectsAfter[j];
+  }
+
+  bool changed = newLengths != getShotLengths();
+  if (changed)
+  {
+    setShotLengths(world, newLengths);
+  }
+
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return changed;
+}
+
+//==============================================================================
+/// This moves the knots toward the states a single serial rollout of the
+/// current forces would pass through, using parareal iterations. This
+/// returns the number of rounds run.
+int MultiShot::pararealInitializeKnots(
+    std::shared_ptr<simulation::World> world,
+    PararealConfig config,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("MultiShot.pararealInitializeKnots");
+  }
+#endif
+
+  const int numShots = mShots.size();
+  const int dofs = world->getNumDofs();
+  assert(getRepresentationStateSize() == 2 * dofs);
+
+  // U is the knot at the start of each shot, F the fine (real) rollout of
+  // each shot from its knot, and G the coarse one
+  Eigen::MatrixXs U(2 * dofs, numShots);
+  Eigen::MatrixXs F(2 * dofs, numShots);
+  Eigen::MatrixXs G(2 * dofs, numShots);
+  for (int i = 0; i < numShots; i++)
+  {
+    U.col(i) = mShots[i]->getStartState();
+  }
+
+  bool firstRound = true;
+  auto solveShot = [&](int i, std::shared_ptr<simulation::World> w) {
+    // The end of the last shot isn't a knot
+    if (i + 1 == numShots)
+      return;
+    mShots[i]->getFinalState(w, F.col(i), thisLog);
+    if (firstRound)
+    {
+      Eigen::VectorXs state = U.col(i);
+      Parareal::coarsePropagate(
+          w, state, mShots[i]->getControlForcesRaw(), config.coarseStepFactor);
+      G.col(i) = state;
+    }
+  };
+
+  // Knots before `exact` (and the first one) have no defect
+  int exact = 0;
+  int rounds = 0;
+  const int maxIterations = std::max(1, config.maxIterations);
+  while (exact + 1 < numShots && rounds < maxIterations)
+  {
+    if (mParallelOperationsEnabled)
+    {
+      runShotsInParallel(exact, solveShot);
+    }
+    else
+    {
+      for (int i = exact; i < numShots; i++)
+      {
+        solveShot(i, world);
+      }
+    }
+    firstRound = false;
+    rounds++;
+
+    // Serial correction sweep. Shot `exact` started from a true state, so
+    // the knot after it is now true as well.
+    s_t maxCorrection
+        = (F.col(exact) - U.col(exact + 1)).lpNorm<Eigen::Infinity>();
+    U.col(exact + 1) = F.col(exact);
+    for (int i = exact + 1; i + 1 < numShots; i++)
+    {
+      Eigen::VectorXs state = U.col(i);
+      Parareal::coarsePropagate(
+          world,
+          state,
+          mShots[i]->getControlForcesRaw(),
+          config.coarseStepFactor);
+      Eigen::VectorXs corrected = state + F.col(i) - G.col(i);
+      G.col(i) = state;
+      maxCorrection = std::max(
+          maxCorrection, (corrected - U.col(i + 1)).lpNorm<Eigen::Infinity>());
+      U.col(i + 1) = corrected;
+    }
+    for (int i = exact + 1; i < numShots; i++)
+    {
+      mShots[i]->setStartPos(U.col(i).head(dofs));
+      mShots[i]->setStartVel(U.col(i).tail(dofs));
+      mShots[i]->resetDirty();
+    }
+    mRolloutCacheDirty = true;
+    exact++;
+    if (maxCorrection <= config.tolerance)
+      break;
+  }
+
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return rounds;
 }
 
 //==============================================================================
@@ -151,6 +631,47 @@ int MultiShot::getFlatDynamicProblemDim(
   return sum;
 }
 
+//==============================================================================
+/// This finds the contiguous range of dynamic dims that the rollout over
+/// timesteps [startTime, endTime) can depend on. Anything outside it has a
+/// structurally zero Jacobian for a loss confined to that window.
+void MultiShot::getDynamicDimRangeForTimesteps(
+    std::shared_ptr<simulation::World> world,
+    int startTime,
+    int endTime,
+    /* OUT */ int& firstDim,
+    /* OUT */ int& numDims) const
+{
+  // Each shot restarts from its own knot point, so only the shots that
+  // overlap the window matter. Those are adjacent, so their dims are too.
+  int first = -1;
+  int last = -1;
+  int timeCursor = 0;
+  int dimCursor = 0;
+  for (const std::shared_ptr<SingleShot>& shot : mShots)
+  {
+    int steps = shot->getNumSteps();
+    int shotFirst = 0;
+    int shotNum = 0;
+    shot->getDynamicDimRangeForTimesteps(
+        world,
+        startTime - timeCursor,
+        endTime - timeCursor,
+        shotFirst,
+        shotNum);
+    if (shotNum > 0)
+    {
+      if (first == -1)
+        first = dimCursor + shotFirst;
+      last = dimCursor + shotFirst + shotNum;
+    }
+    timeCursor += steps;
+    dimCursor += shot->getFlatDynamicProblemDim(world);
+  }
+  firstDim = first == -1 ? 0 : first;
+  numDims = first == -1 ? 0 : last - first;
+}
+
 //==============================================================================
 /// Returns the length of the knot-point constraint vector
 int MultiShot::getConstraintDim() const
@@ -182,31 +703,17 @@ void MultiShot::computeConstraints(
 
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
-    for (int i = 1; i < mShots.size(); i++)
-    {
-      futures.push_back(std::async(
-          &MultiShot::asyncPartComputeConstraints,
-          this,
-          i,
-          mParallelWorlds[i],
-          constraints,
-          cursor,
-          thisLog));
-      cursor += getRepresentationStateSize();
-    }
-    for (int i = 0; i < futures.size(); i++)
-    {
-      futures[i].wait();
-    }
+    int stateDim = getRepresentationStateSize();
+    runShotsInParallel(1, [&](int i, std::shared_ptr<simulation::World> w) {
+      asyncPartComputeConstraints(
+          i, w, constraints, cursor + (i - 1) * stateDim, thisLog);
+    });
   }
   else
   {
     for (int i = 1; i < mShots.size(); i++)
     {
-      constraints.segment(cursor, getRepresentationStateSize())
-          = mShots[i - 1]->getFinalState(world, thisLog)
-            - mShots[i]->getStartState();
+      asyncPartComputeConstraints(i, world, constraints, cursor, thisLog);
       cursor += getRepresentationStateSize();
     }
   }
@@ -229,9 +736,14 @@ void MultiShot::asyncPartComputeConstraints(
     int cursor,
     PerformanceLog* log)
 {
-  constraints.segment(cursor, getRepresentationStateSize())
-      = mShots[index - 1]->getFinalState(world, log)
-        - mShots[index]->getStartState();
+  // Write the final state straight into the constraint vector, and subtract
+  // the next shot's start state in place, so this doesn't allocate
+  int dofs = world->getNumDofs();
+  Eigen::Ref<Eigen::VectorXs> knot
+      = constraints.segment(cursor, getRepresentationStateSize());
+  mShots[index - 1]->getFinalState(world, knot, log);
+  knot.segment(0, dofs) -= mShots[index]->mStartPos;
+  knot.segment(dofs, dofs) -= mShots[index]->mStartVel;
 }
 
 //==============================================================================
@@ -299,7 +811,7 @@ void MultiShot::unflatten(
     std::shared_ptr<SingleShot>& shot = mShots[i];
     int dim = shot->getFlatDynamicProblemDim(world);
     shot->unflatten(
-        mParallelOperationsEnabled ? mParallelWorlds[i] : world,
+        mParallelOperationsEnabled ? getParallelWorld(i) : world,
         flatStatic,
         flatDynamic.segment(cursor, dim),
         thisLog);
@@ -512,23 +1024,25 @@ void MultiShot::backpropJacobian(
   int stateDim = getRepresentationStateSize();
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<int> rowCursors;
+    std::vector<int> colCursors;
     for (int i = 1; i < mShots.size(); i++)
     {
-      int dynamicDim = mShots[i - 1]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropJacobian,
-          this,
+      rowCursors.push_back(rowCursor);
+      colCursors.push_back(colCursor);
+      colCursor += mShots[i - 1]->getFlatDynamicProblemDim(world);
+      rowCursor += stateDim;
+    }
+    runShotsInParallel(1, [&](int i, std::shared_ptr<simulation::World> w) {
+      asyncPartBackpropJacobian(
           i,
-          mParallelWorlds[i],
+          w,
           jacStatic,
           jacDynamic,
-          rowCursor,
-          colCursor,
-          thisLog));
-      colCursor += dynamicDim;
-      rowCursor += stateDim;
-    }
+          rowCursors[i - 1],
+          colCursors[i - 1],
+          thisLog);
+    });
   }
   else
   {
@@ -754,79 +1268,40 @@ void MultiShot::getSparseJacobian(
   }
 #endif
 
-  int cursorStatic = Problem::getNumberNonZeroJacobianStatic(world);
-  int cursorDynamic = Problem::getNumberNonZeroJacobianDynamic(world);
+  updateSparseJacobianCursors(world);
 
   Problem::getSparseJacobian(
       world,
-      sparseStatic.segment(0, cursorStatic),
-      sparseDynamic.segment(0, cursorDynamic),
+      sparseStatic.segment(0, mSparseJacobianShape[0]),
+      sparseDynamic.segment(0, mSparseJacobianShape[1]),
       thisLog);
 
-  int stateDim = getRepresentationStateSize();
-
+  // Each knot point writes straight into its own block of the output
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
-    for (int i = 1; i < mShots.size(); i++)
-    {
-      int dimStatic = mShots[i - 1]->getFlatStaticProblemDim(world);
-      int dimDynamic = mShots[i - 1]->getFlatDynamicProblemDim(world);
-
-      futures.push_back(std::async(
-          &MultiShot::asyncPartGetSparseJacobian,
-          this,
+    runShotsInParallel(1, [&](int i, std::shared_ptr<simulation::World> w) {
+      asyncPartGetSparseJacobian(
           i,
-          mParallelWorlds[i],
+          w,
           sparseStatic,
           sparseDynamic,
-          cursorStatic,
-          cursorDynamic,
-          thisLog));
-
-      cursorDynamic += (dimDynamic + 1) * stateDim;
-      cursorStatic += dimStatic * stateDim;
-    }
-    for (int i = 0; i < futures.size(); i++)
-    {
-      futures[i].wait();
-    }
+          mSparseJacobianStaticCursors[i - 1],
+          mSparseJacobianDynamicCursors[i - 1],
+          thisLog);
+    });
   }
   else
   {
-    Eigen::VectorXs neg = Eigen::VectorXs::Ones(stateDim) * -1;
     for (int i = 1; i < mShots.size(); i++)
     {
-      int dimStatic = mShots[i - 1]->getFlatStaticProblemDim(world);
-      int dimDynamic = mShots[i - 1]->getFlatDynamicProblemDim(world);
-
-      // Get the dense Jacobians for static and dynamic regions
-      Eigen::MatrixXs jacStatic = Eigen::MatrixXs::Zero(stateDim, dimStatic);
-      Eigen::MatrixXs jacDynamic = Eigen::MatrixXs::Zero(stateDim, dimDynamic);
-      mShots[i - 1]->backpropJacobianOfFinalState(
-          world, jacStatic, jacDynamic, thisLog);
-
-      // Copy over the static Jacobian to the global static region (this will
-      // overwrite the same region a bunch of times)
-
-      for (int row = 0; row < stateDim; row++)
-      {
-        sparseStatic.segment(cursorStatic, dimStatic) = jacStatic.row(row);
-        cursorStatic += dimStatic;
-      }
-
-      // Copy over the dynamic Jacobian to a unique spot in the dynamic region
-
-      for (int col = 0; col < dimDynamic; col++)
-      {
-        sparseDynamic.segment(cursorDynamic, stateDim) = jacDynamic.col(col);
-        cursorDynamic += stateDim;
-      }
-      // This is the negative identity at the end of our segment in the dynamic
-      // region
-      sparseDynamic.segment(cursorDynamic, stateDim) = neg;
-
-      cursorDynamic += stateDim;
+      asyncPartGetSparseJacobian(
+          i,
+          world,
+          sparseStatic,
+          sparseDynamic,
+          mSparseJacobianStaticCursors[i - 1],
+          mSparseJacobianDynamicCursors[i - 1],
+          thisLog);
     }
   }
 
@@ -838,6 +1313,37 @@ void MultiShot::getSparseJacobian(
 #endif
 }
 
+//==============================================================================
+/// This recomputes where each knot point's block starts in the sparse
+/// Jacobian, if the shape of the problem changed since we last did
+void MultiShot::updateSparseJacobianCursors(
+    std::shared_ptr<simulation::World> world)
+{
+  int cursorStatic = Problem::getNumberNonZeroJacobianStatic(world);
+  int cursorDynamic = Problem::getNumberNonZeroJacobianDynamic(world);
+  int stateDim = getRepresentationStateSize();
+  std::vector<int> shape{cursorStatic,
+                         cursorDynamic,
+                         stateDim,
+                         getFlatStaticProblemDim(world),
+                         getFlatDynamicProblemDim(world)};
+  if (shape == mSparseJacobianShape)
+    return;
+
+  mSparseJacobianStaticCursors.clear();
+  mSparseJacobianDynamicCursors.clear();
+  for (int i = 1; i < mShots.size(); i++)
+  {
+    int dimStatic = mShots[i - 1]->getFlatStaticProblemDim(world);
+    int dimDynamic = mShots[i - 1]->getFlatDynamicProblemDim(world);
+    mSparseJacobianStaticCursors.push_back(cursorStatic);
+    mSparseJacobianDynamicCursors.push_back(cursorDynamic);
+    cursorDynamic += (dimDynamic + 1) * stateDim;
+    cursorStatic += dimStatic * stateDim;
+  }
+  mSparseJacobianShape = shape;
+}
+
 //==============================================================================
 /// This writes the Jacobian to a sparse vector
 void MultiShot::asyncPartGetSparseJacobian(
@@ -854,11 +1360,17 @@ void MultiShot::asyncPartGetSparseJacobian(
   int dimStatic = mShots[index - 1]->getFlatStaticProblemDim(world);
   int dimDynamic = mShots[index - 1]->getFlatDynamicProblemDim(world);
 
-  // Get the dense Jacobians for static and dynamic regions
+  // The dynamic block is stored column by column, which is exactly the layout
+  // of a column-major (stateDim x dimDynamic) matrix, so the shot can write
+  // its Jacobian straight into the output. The static block is stored row by
+  // row, so it needs a scratch matrix, but it's usually empty.
+  Eigen::Map<Eigen::MatrixXs> jacDynamic(
+      sparseDynamic.data() + cursorDynamic, stateDim, dimDynamic);
+  jacDynamic.setZero();
   Eigen::MatrixXs jacStatic = Eigen::MatrixXs::Zero(stateDim, dimStatic);
-  Eigen::MatrixXs jacDynamic = Eigen::MatrixXs::Zero(stateDim, dimDynamic);
   mShots[index - 1]->backpropJacobianOfFinalState(
       world, jacStatic, jacDynamic, log);
+  cursorDynamic += stateDim * dimDynamic;
 
   // Copy over the static Jacobian
 
@@ -868,16 +1380,8 @@ void MultiShot::asyncPartGetSparseJacobian(
     cursorStatic += dimStatic;
   }
 
-  // Copy over the dynamic Jacobian
-
-  for (int col = 0; col < dimDynamic; col++)
-  {
-    sparseDynamic.segment(cursorDynamic, stateDim) = jacDynamic.col(col);
-    cursorDynamic += stateDim;
-  }
   // This is the negative identity at the end
-  Eigen::VectorXs neg = Eigen::VectorXs::Ones(stateDim) * -1;
-  sparseDynamic.segment(cursorDynamic, stateDim) = neg;
+  sparseDynamic.segment(cursorDynamic, stateDim).setConstant(-1);
   cursorDynamic += stateDim;
 }
 
@@ -930,25 +1434,16 @@ void MultiShot::getStates(
   {
     if (mParallelOperationsEnabled)
     {
-      std::vector<std::future<void>> futures;
+      std::vector<int> cursors;
       for (int i = 0; i < mShots.size(); i++)
       {
-        int steps = mShots[i]->getNumSteps();
-        futures.push_back(std::async(
-            &MultiShot::asyncPartGetStates,
-            this,
-            i,
-            mParallelWorlds[i],
-            rollout,
-            cursor,
-            steps,
-            thisLog));
-        cursor += steps;
-      }
-      for (int i = 0; i < futures.size(); i++)
-      {
-        futures[i].wait();
+        cursors.push_back(cursor);
+        cursor += mShots[i]->getNumSteps();
       }
+      runShotsInParallel(0, [&](int i, std::shared_ptr<simulation::World> w) {
+        asyncPartGetStates(
+            i, w, rollout, cursors[i], mShots[i]->getNumSteps(), thisLog);
+      });
     }
     else
     {
@@ -1064,8 +1559,13 @@ void MultiShot::setControlForcesRaw(Eigen::MatrixXs forces, PerformanceLog* log)
 
 //==============================================================================
 /// This moves the trajectory forward in time, setting the starting point to
-/// the new given starting point, and shifting the forces over by `steps`,
-/// padding the remainder with 0s
+/// the new given starting point, and shifting the forces over by `steps`. The
+/// forces are shifted across the whole horizon, so the head of each shot
+/// moves into the tail of the shot before it, and only the end of the last
+/// shot is extrapolated (by holding the last planned force). This returns, for
+/// every index in the new flat problem vector, the index in the old flat vector
+/// that its value was taken from, so that callers can shift multipliers along
+/// with the primal variables.
 Eigen::VectorXi MultiShot::advanceSteps(
     std::shared_ptr<simulation::World> world,
     Eigen::VectorXs startPos,
@@ -1073,16 +1573,44 @@ Eigen::VectorXi MultiShot::advanceSteps(
     int steps)
 {
   Eigen::VectorXi mapping = Eigen::VectorXi::Zero(getFlatProblemDim(world));
+  for (int i = 0; i < mapping.size(); i++)
+  {
+    mapping(i) = i;
+  }
 
   RestorableSnapshot snapshot(world);
 
   const TrajectoryRollout* rollout = getRolloutCache(world);
+  // Advancing the shots dirties the rollout cache, so keep our own copy of the
+  // old plan
+  Eigen::MatrixXs oldForces = rollout->getControlForcesConst();
+  int totalSteps = oldForces.cols();
+  int forceDim = oldForces.rows();
+
+  // This is the index in the flat problem vector of the first force entry for
+  // each timestep. The layout doesn't change when we advance, so it's valid
+  // for both the old and new flat vectors.
+  std::vector<int> flatForceIndex;
+  flatForceIndex.reserve(totalSteps);
+  int flatCursor = getFlatStaticProblemDim(world)
+                   + Problem::getFlatDynamicProblemDim(world);
 
   int cursor = 0;
   for (int i = 0; i < mShots.size(); i++)
   {
     int len = mShots[i]->getNumSteps();
 
+    int forceStart = flatCursor;
+    if (mShots[i]->mTuneStartingState)
+    {
+      forceStart += world->getNumDofs() * 2;
+    }
+    for (int j = 0; j < len; j++)
+    {
+      flatForceIndex.push_back(forceStart + j * forceDim);
+    }
+    flatCursor += mShots[i]->getFlatDynamicProblemDim(world);
+
     // The first shot is a special case, we assume that it's getting its
     // projection of current state from a more reliable source than our
     // simulator. For all subsequent shots, though, simulate forward from the
@@ -1099,9 +1627,9 @@ Eigen::VectorXi MultiShot::advanceSteps(
       for (int j = 0; j < steps; j++)
       {
         int t = cursor + j;
-        if (t < rollout->getControlForcesConst().cols())
+        if (t < totalSteps)
         {
-          world->setControlForces(rollout->getControlForcesConst().col(t));
+          world->setControlForces(oldForces.col(t));
         }
         else
         {
@@ -1117,6 +1645,28 @@ Eigen::VectorXi MultiShot::advanceSteps(
   }
   snapshot.restore();
 
+  // Each shot only shifted its own forces, so now shift the whole horizon at
+  // once, which carries forces across shot boundaries
+  if (totalSteps > 0 && steps > 0)
+  {
+    Eigen::MatrixXs newForces = Eigen::MatrixXs::Zero(forceDim, totalSteps);
+    for (int t = 0; t < totalSteps; t++)
+    {
+      int source = std::min(t + steps, totalSteps - 1);
+      newForces.col(t) = oldForces.col(source);
+      for (int j = 0; j < forceDim; j++)
+      {
+        mapping(flatForceIndex[t] + j) = flatForceIndex[source] + j;
+      }
+    }
+    setControlForcesRaw(newForces);
+    for (int i = 0; i < mShots.size(); i++)
+    {
+      mShots[i]->resetDirty();
+    }
+  }
+  mRolloutCacheDirty = true;
+
   return mapping;
 }
 
@@ -1244,40 +1794,39 @@ void MultiShot::backpropGradientWrt(
   int cursorSteps = 0;
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
-    Eigen::VectorXs gradStaticScratch
-        = Eigen::VectorXs::Zero(gradStatic.size() * mShots.size());
+    int staticDim = gradStatic.size();
+    mGradStaticScratch.resize(staticDim * mShots.size());
+    mGradDimCursors.resize(mShots.size());
+    mGradStepCursors.resize(mShots.size());
     for (int i = 0; i < mShots.size(); i++)
     {
-      int steps = mShots[i]->getNumSteps();
-      int dynamicDim = mShots[i]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropGradientWrt,
-          this,
+      mGradDimCursors[i] = cursorDynamicDims;
+      mGradStepCursors[i] = cursorSteps;
+      cursorSteps += mShots[i]->getNumSteps();
+      cursorDynamicDims += mShots[i]->getFlatDynamicProblemDim(world);
+    }
+    runShotsInParallel(0, [&](int i, std::shared_ptr<simulation::World> w) {
+      asyncPartBackpropGradientWrt(
           i,
-          mParallelWorlds[i],
+          w,
           gradWrtRollout,
-          gradStaticScratch.segment(i * gradStatic.size(), gradStatic.size()),
+          mGradStaticScratch.segment(i * staticDim, staticDim),
           gradDynamic,
-          cursorDynamicDims,
-          cursorSteps,
-          thisLog));
-      cursorSteps += steps;
-      cursorDynamicDims += dynamicDim;
-    }
+          mGradDimCursors[i],
+          mGradStepCursors[i],
+          thisLog);
+    });
+    // Sum in shot order, so the result doesn't depend on scheduling
     gradStatic.setZero();
-    for (int i = 0; i < futures.size(); i++)
+    for (int i = 0; i < mShots.size(); i++)
     {
-      futures[i].wait();
-      gradStatic += gradStaticScratch.segment(
-          i * gradStatic.size(), gradStatic.size());
+      gradStatic += mGradStaticScratch.segment(i * staticDim, staticDim);
     }
   }
   else
   {
     gradStatic.setZero();
-    Eigen::VectorXs gradStaticScratch
-        = Eigen::VectorXs::Zero(gradStatic.size());
+    mGradStaticScratch.resize(gradStatic.size());
     for (int i = 0; i < mShots.size(); i++)
     {
       int steps = mShots[i]->getNumSteps();
@@ -1287,10 +1836,10 @@ void MultiShot::backpropGradientWrt(
       mShots[i]->backpropGradientWrt(
           world,
           &slice,
-          gradStaticScratch,
+          mGradStaticScratch,
           gradDynamic.segment(cursorDynamicDims, dynamicDim),
           thisLog);
-      gradStatic += gradStaticScratch;
+      gradStatic += mGradStaticScratch;
       cursorSteps += steps;
       cursorDynamicDims += dynamicDim;
     }
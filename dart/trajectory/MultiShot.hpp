@@ -1,6 +1,7 @@
 #ifndef DART_NEURAL_MULTI_SHOT_HPP_
 #define DART_NEURAL_MULTI_SHOT_HPP_
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -9,6 +10,7 @@
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
+#include "dart/trajectory/Parareal.hpp"
 #include "dart/trajectory/Problem.hpp"
 #include "dart/trajectory/SingleShot.hpp"
 #include "dart/trajectory/TrajectoryConstants.hpp"
@@ -61,6 +63,16 @@ public:
   int getFlatDynamicProblemDim(
       std::shared_ptr<simulation::World> world) const override;
 
+  /// This finds the contiguous range of dynamic dims that the rollout over
+  /// timesteps [startTime, endTime) can depend on. Anything outside it has a
+  /// structurally zero Jacobian for a loss confined to that window.
+  void getDynamicDimRangeForTimesteps(
+      std::shared_ptr<simulation::World> world,
+      int startTime,
+      int endTime,
+      /* OUT */ int& firstDim,
+      /* OUT */ int& numDims) const override;
+
   /// Returns the length of the knot-point constraint vector
   int getConstraintDim() const override;
 
@@ -196,8 +208,12 @@ public:
       Eigen::MatrixXs forces, PerformanceLog* log = nullptr) override;
 
   /// This moves the trajectory forward in time, setting the starting point to
-  /// the new given starting point, and shifting the forces over by `steps`,
-  /// padding the remainder with 0s
+  /// the new given starting point, and shifting the forces over by `steps`.
+  /// The tail that falls off the end of the old plan is extrapolated by
+  /// holding the last planned force. This returns, for every index in the new
+  /// flat problem vector, the index in the old flat vector that its value was
+  /// taken from, so that callers can shift multipliers along with the primal
+  /// variables.
   Eigen::VectorXi advanceSteps(
       std::shared_ptr<simulation::World> world,
       Eigen::VectorXs startPos,
@@ -274,15 +290,101 @@ public:
       std::shared_ptr<simulation::World> world,
       PerformanceLog* log = nullptr) override;
 
+  /// This returns the number of world clones that parallel operations are
+  /// spread across. This is 0 when parallel operations are disabled.
+  int getNumParallelWorlds() const;
+
+  /// This returns the number of timesteps in each shot, in order
+  std::vector<int> getShotLengths() const;
+
+  /// This re-partitions the trajectory into shots of the given lengths, which
+  /// must sum to the number of steps. Forces and pinned forces carry over
+  /// unchanged. Knots that already existed keep their state, and new knots
+  /// start from wherever the old shot they land in had rolled out to. This
+  /// changes the size of the flat problem.
+  void setShotLengths(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<int>& lengths);
+
+  /// This re-partitions the trajectory based on how the current plan
+  /// behaves. Shots with a knot defect at their end above `splitDefect`, or
+  /// where the number of contacts changes partway through, get split in two
+  /// (at the contact change, if there is one). Neighbouring smooth shots
+  /// whose knot defect is below `mergeDefect` get merged, up to
+  /// `maxShotLength`. Shots are never split below `minShotLength`. This
+  /// returns true if the shots changed.
+  bool adaptShots(
+      std::shared_ptr<simulation::World> world,
+      s_t splitDefect,
+      s_t mergeDefect,
+      int minShotLength,
+      int maxShotLength,
+      PerformanceLog* log = nullptr);
+
+  /// This moves the knots toward the states a single serial rollout of the
+  /// current forces would pass through, using parareal iterations: every
+  /// shot is unrolled in parallel from its knot, and then the knots are
+  /// corrected serially using a cheap coarse rollout of each shot (at
+  /// `config.coarseStepFactor` times the timestep). After `k` rounds, the
+  /// first `k` knots have no defect, and the rest usually have much smaller
+  /// ones. This is a good way to initialize the knots of a long trajectory
+  /// before optimizing, without paying for a serial rollout. It only works on
+  /// the "identity" representation, and `config.numSlices` is ignored (the
+  /// shots are the slices). This returns the number of rounds run.
+  int pararealInitializeKnots(
+      std::shared_ptr<simulation::World> world,
+      PararealConfig config = PararealConfig(),
+      PerformanceLog* log = nullptr);
+
   //////////////////////////////////////////////////////////////////////////////
   // For Testing
   //////////////////////////////////////////////////////////////////////////////
 
 private:
+  /// This returns the world clone that `shot` is bound to when parallel
+  /// operations are enabled
+  std::shared_ptr<simulation::World> getParallelWorld(int shot);
+
+  /// This runs `perShot(shot, world)` for every shot from `firstShot` to the
+  /// end, spread across the persistent world clones. Each clone gets its
+  /// shots in order inside a single pool task, so a clone is never used by
+  /// two threads at once. This blocks until every shot is done.
+  void runShotsInParallel(
+      int firstShot,
+      const std::function<void(int, std::shared_ptr<simulation::World>)>&
+          perShot);
+
+  /// This splits the shots from `firstShot` to the end across the world
+  /// clones, so that each clone gets roughly the same total cost
+  std::vector<std::vector<int>> scheduleShots(int firstShot) const;
+
   std::vector<std::shared_ptr<SingleShot>> mShots;
+  // One clone per pool worker (or per shot, if there are fewer shots), which
+  // live as long as parallel operations stay enabled. Static values get
+  // written to clone `i % mParallelWorlds.size()` when unflattening shot `i`,
+  // which reaches every clone, so any shot can run on any clone.
   std::vector<simulation::WorldPtr> mParallelWorlds;
+  // The last measured wall time for each shot in runShotsInParallel(), or 0
+  // if that shot hasn't been timed yet
+  std::vector<double> mShotCosts;
   int mShotLength;
   bool mParallelOperationsEnabled;
+
+  /// This recomputes where each knot point's block starts in the sparse
+  /// Jacobian, if the shape of the problem changed since we last did
+  void updateSparseJacobianCursors(std::shared_ptr<simulation::World> world);
+
+  // Where each knot point's block starts in the static and dynamic parts of
+  // the sparse Jacobian, and the problem shape those offsets were built for
+  std::vector<int> mSparseJacobianShape;
+  std::vector<int> mSparseJacobianStaticCursors;
+  std::vector<int> mSparseJacobianDynamicCursors;
+
+  // Scratch space for backpropGradientWrt(), which gets called on every
+  // gradient evaluation, so it's kept around rather than reallocated
+  Eigen::VectorXs mGradStaticScratch;
+  std::vector<int> mGradDimCursors;
+  std::vector<int> mGradStepCursors;
 };
 
 } // namespace trajectory
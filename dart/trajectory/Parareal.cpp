@@ -0,0 +1,258 @@
+#include "dart/trajectory/Parareal.hpp"
+
+#include <algorithm>
+#include <future>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace trajectory {
+
+//==============================================================================
+PararealConfig::PararealConfig()
+{
+}
+
+//==============================================================================
+PararealConfig& PararealConfig::setNumSlices(int v)
+{
+  numSlices = v;
+  return *this;
+}
+
+//==============================================================================
+PararealConfig& PararealConfig::setCoarseStepFactor(int v)
+{
+  coarseStepFactor = v;
+  return *this;
+}
+
+//==============================================================================
+PararealConfig& PararealConfig::setMaxIterations(int v)
+{
+  maxIterations = v;
+  return *this;
+}
+
+//==============================================================================
+PararealConfig& PararealConfig::setTolerance(s_t v)
+{
+  tolerance = v;
+  return *this;
+}
+
+//==============================================================================
+Parareal::Parareal(
+    std::shared_ptr<simulation::World> world, PararealConfig config)
+  : mWorld(world), mConfig(config)
+{
+}
+
+//==============================================================================
+void Parareal::setConfig(PararealConfig config)
+{
+  mConfig = config;
+}
+
+//==============================================================================
+const PararealConfig& Parareal::getConfig() const
+{
+  return mConfig;
+}
+
+//==============================================================================
+/// This rolls out `forces.cols()` steps of the world from (startPos,
+/// startVel), applying column `i` of `forces` as the control forces for step
+/// `i`. The world passed to the constructor is left unchanged.
+PararealResult Parareal::rollout(
+    const Eigen::Ref<const Eigen::VectorXs>& startPos,
+    const Eigen::Ref<const Eigen::VectorXs>& startVel,
+    const Eigen::Ref<const Eigen::MatrixXs>& forces)
+{
+  const int dofs = mWorld->getNumDofs();
+  const int steps = forces.cols();
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+
+  PararealResult result;
+  result.poses = Eigen::MatrixXs::Zero(dofs, steps);
+  result.vels = Eigen::MatrixXs::Zero(dofs, steps);
+  result.iterations = 0;
+  result.maxCorrection = 0.0;
+  result.converged = true;
+  if (steps == 0)
+    return result;
+
+  int numSlices = mConfig.numSlices > 0 ? mConfig.numSlices
+                                        : (int)pool.getNumThreads();
+  numSlices = std::max(1, std::min(numSlices, steps));
+  ensureClones(std::min(numSlices, (int)pool.getNumThreads()));
+  const int numClones = std::min(numSlices, (int)mClones.size());
+
+  // Slice `n` covers steps [bounds[n], bounds[n + 1])
+  std::vector<int> bounds(numSlices + 1);
+  for (int n = 0; n <= numSlices; n++)
+    bounds[n] = (int)(((long long)n * steps) / numSlices);
+
+  // U holds the state at each slice boundary, G the coarse prediction from
+  // each boundary to the next, and F the fine one
+  Eigen::MatrixXs U(2 * dofs, numSlices + 1);
+  Eigen::MatrixXs G(2 * dofs, numSlices);
+  Eigen::MatrixXs F(2 * dofs, numSlices);
+  U.col(0).head(dofs) = startPos;
+  U.col(0).tail(dofs) = startVel;
+  Eigen::VectorXs state(2 * dofs);
+  for (int n = 0; n < numSlices; n++)
+  {
+    state = U.col(n);
+    coarsePropagate(
+        mClones[0],
+        state,
+        forces.middleCols(bounds[n], bounds[n + 1] - bounds[n]),
+        mConfig.coarseStepFactor);
+    G.col(n) = state;
+    U.col(n + 1) = state;
+  }
+
+  // Slices before `exact` started from the true state, and their fine
+  // results are already final
+  int exact = 0;
+  const int maxIterations = std::max(1, mConfig.maxIterations);
+  while (exact < numSlices && result.iterations < maxIterations)
+  {
+    // Fine solves, in parallel
+    std::vector<std::future<void>> futures;
+    for (int c = 0; c < numClones; c++)
+    {
+      std::shared_ptr<simulation::World> clone = mClones[c];
+      auto task = [&, clone, c]() {
+        Eigen::VectorXs sliceState(2 * dofs);
+        for (int n = exact + c; n < numSlices; n += numClones)
+        {
+          const int len = bounds[n + 1] - bounds[n];
+          sliceState = U.col(n);
+          // Each slice writes to its own columns, so these don't race
+          finePropagate(
+              clone,
+              sliceState,
+              forces.middleCols(bounds[n], len),
+              result.poses.middleCols(bounds[n], len),
+              result.vels.middleCols(bounds[n], len));
+          F.col(n) = sliceState;
+        }
+      };
+      futures.push_back(pool.submit(task));
+    }
+    pool.waitAll(futures);
+    for (std::future<void>& future : futures)
+    {
+      future.get();
+    }
+    result.iterations++;
+
+    // Serial correction sweep. The slice at `exact` just got a fine solve
+    // from a true state, so the boundary after it is now true as well.
+    result.maxCorrection
+        = (F.col(exact) - U.col(exact + 1)).lpNorm<Eigen::Infinity>();
+    U.col(exact + 1) = F.col(exact);
+    for (int n = exact + 1; n < numSlices; n++)
+    {
+      state = U.col(n);
+      coarsePropagate(
+          mClones[0],
+          state,
+          forces.middleCols(bounds[n], bounds[n + 1] - bounds[n]),
+          mConfig.coarseStepFactor);
+      Eigen::VectorXs corrected = state + F.col(n) - G.col(n);
+      G.col(n) = state;
+      result.maxCorrection = std::max(
+          result.maxCorrection,
+          (corrected - U.col(n + 1)).lpNorm<Eigen::Infinity>());
+      U.col(n + 1) = corrected;
+    }
+    exact++;
+    if (result.maxCorrection <= mConfig.tolerance)
+      break;
+  }
+
+  result.converged = exact == numSlices
+                     || result.maxCorrection <= mConfig.tolerance;
+  return result;
+}
+
+//==============================================================================
+/// This is the coarse predictor. It steps `world` from the (pos, vel) `state`
+/// across all the steps in `forces`, taking one step of `factor` timesteps
+/// (and the average of their forces) at a time, and writes the final state
+/// back into `state`. The world is restored afterwards.
+void Parareal::coarsePropagate(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXs> state,
+    const Eigen::Ref<const Eigen::MatrixXs>& forces,
+    int factor)
+{
+  const int dofs = world->getNumDofs();
+  const int steps = forces.cols();
+  factor = std::max(1, factor);
+  const s_t dt = world->getTimeStep();
+
+  neural::RestorableSnapshot snapshot(world);
+  world->setPositions(state.head(dofs));
+  world->setVelocities(state.tail(dofs));
+  for (int t = 0; t < steps; t += factor)
+  {
+    // The last chunk can be short, and gets a correspondingly short step
+    const int chunk = std::min(factor, steps - t);
+    world->setTimeStep(dt * chunk);
+    world->setControlForces(forces.middleCols(t, chunk).rowwise().mean());
+    world->step();
+  }
+  world->setTimeStep(dt);
+  state.head(dofs) = world->getPositions();
+  state.tail(dofs) = world->getVelocities();
+  snapshot.restore();
+}
+
+//==============================================================================
+/// This is the fine solve. It steps `world` from the (pos, vel) `state`
+/// across all the steps in `forces` at the world's own timestep, records the
+/// state after each step into `poses` and `vels`, and writes the final state
+/// back into `state`. The world is restored afterwards.
+void Parareal::finePropagate(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXs> state,
+    const Eigen::Ref<const Eigen::MatrixXs>& forces,
+    Eigen::Ref<Eigen::MatrixXs> poses,
+    Eigen::Ref<Eigen::MatrixXs> vels)
+{
+  const int dofs = world->getNumDofs();
+  const int steps = forces.cols();
+
+  neural::RestorableSnapshot snapshot(world);
+  world->setPositions(state.head(dofs));
+  world->setVelocities(state.tail(dofs));
+  for (int t = 0; t < steps; t++)
+  {
+    world->setControlForces(forces.col(t));
+    world->step();
+    poses.col(t) = world->getPositions();
+    vels.col(t) = world->getVelocities();
+  }
+  state.head(dofs) = world->getPositions();
+  state.tail(dofs) = world->getVelocities();
+  snapshot.restore();
+}
+
+//==============================================================================
+/// This makes sure we have at least `count` world clones
+void Parareal::ensureClones(int count)
+{
+  while (mClones.size() < std::max(1, count))
+  {
+    mClones.push_back(mWorld->clone());
+  }
+}
+
+} // namespace trajectory
+} // namespace dart
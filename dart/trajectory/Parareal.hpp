@@ -0,0 +1,125 @@
+#ifndef DART_TRAJECTORY_PARAREAL_HPP_
+#define DART_TRAJECTORY_PARAREAL_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace trajectory {
+
+struct PararealConfig
+{
+  PararealConfig();
+
+  PararealConfig& setNumSlices(int v);
+  PararealConfig& setCoarseStepFactor(int v);
+  PararealConfig& setMaxIterations(int v);
+  PararealConfig& setTolerance(s_t v);
+
+  /// The number of time slices the rollout is cut into. 0 means one slice
+  /// per thread in the global ThreadPool.
+  int numSlices = 0;
+  /// The coarse predictor takes one step for every this many fine steps
+  int coarseStepFactor = 8;
+  /// We give up after this many rounds of fine solves, and return the
+  /// rollout as it stands
+  int maxIterations = 5;
+  /// We stop once no slice boundary state moves by more than this (in the
+  /// max-norm) in a round
+  s_t tolerance = 1e-8;
+};
+
+struct PararealResult
+{
+  /// Column `i` is the position after step `i`, like TrajectoryRollout
+  Eigen::MatrixXs poses;
+  /// Column `i` is the velocity after step `i`, like TrajectoryRollout
+  Eigen::MatrixXs vels;
+  /// The number of rounds of fine solves we ran
+  int iterations;
+  /// The largest change to a slice boundary state in the last round
+  s_t maxCorrection;
+  /// This is true if we stopped because the boundaries stopped moving
+  bool converged;
+};
+
+/// This runs long rollouts in parallel across time, with the parareal
+/// scheme. The rollout is cut into slices. A cheap coarse predictor (the same
+/// world, stepped with a timestep `coarseStepFactor` times larger) sweeps
+/// serially across the slices to guess the state at each slice boundary, and
+/// then every slice is stepped at the real timestep in parallel, each on its
+/// own world clone, starting from its guessed boundary. The boundaries are
+/// then corrected serially with
+///
+///   U[n+1] = G(U_new[n]) + F(U_old[n]) - G(U_old[n])
+///
+/// where F is the fine solve and G is the coarse one, and we repeat until the
+/// boundaries stop moving. After round `k`, the first `k` slices are exact,
+/// so this can't take more rounds than there are slices, and fine solves for
+/// slices that are already exact get skipped.
+///
+/// This only produces states. Code that needs snapshots for gradients should
+/// still unroll normally, but can start from these states.
+class Parareal
+{
+public:
+  Parareal(
+      std::shared_ptr<simulation::World> world,
+      PararealConfig config = PararealConfig());
+
+  void setConfig(PararealConfig config);
+
+  const PararealConfig& getConfig() const;
+
+  /// This rolls out `forces.cols()` steps of the world from (startPos,
+  /// startVel), applying column `i` of `forces` as the control forces for
+  /// step `i`. The world passed to the constructor is left unchanged.
+  PararealResult rollout(
+      const Eigen::Ref<const Eigen::VectorXs>& startPos,
+      const Eigen::Ref<const Eigen::VectorXs>& startVel,
+      const Eigen::Ref<const Eigen::MatrixXs>& forces);
+
+  /// This is the coarse predictor. It steps `world` from the (pos, vel)
+  /// `state` across all the steps in `forces`, taking one step of `factor`
+  /// timesteps (and the average of their forces) at a time, and writes the
+  /// final state back into `state`. The world is restored afterwards.
+  static void coarsePropagate(
+      std::shared_ptr<simulation::World> world,
+      /* IN/OUT */ Eigen::Ref<Eigen::VectorXs> state,
+      const Eigen::Ref<const Eigen::MatrixXs>& forces,
+      int factor);
+
+  /// This is the fine solve. It steps `world` from the (pos, vel) `state`
+  /// across all the steps in `forces` at the world's own timestep, records
+  /// the state after each step into `poses` and `vels`, and writes the final
+  /// state back into `state`. The world is restored afterwards.
+  static void finePropagate(
+      std::shared_ptr<simulation::World> world,
+      /* IN/OUT */ Eigen::Ref<Eigen::VectorXs> state,
+      const Eigen::Ref<const Eigen::MatrixXs>& forces,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> poses,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> vels);
+
+protected:
+  /// This makes sure we have at least `count` world clones
+  void ensureClones(int count);
+
+  std::shared_ptr<simulation::World> mWorld;
+  PararealConfig mConfig;
+  // Slice `n` runs on clone `n % mClones.size()`
+  std::vector<std::shared_ptr<simulation::World>> mClones;
+};
+
+} // namespace trajectory
+} // namespace dart
+
+#endif
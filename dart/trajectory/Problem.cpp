@@ -49,6 +49,23 @@ void Problem::setLoss(LossFn loss)
 void Problem::addConstraint(LossFn loss)
 {
   mConstraints.push_back(loss);
+  mJacobianStructureShape.clear();
+}
+
+//==============================================================================
+/// For a loss of the form sum_i r_i^2, this adds one of the residuals r_i.
+/// These don't change the loss itself (that's still whatever setLoss() got),
+/// they're only used to build a Gauss-Newton approximation of its Hessian.
+void Problem::addLeastSquaresResidual(LossFn residual)
+{
+  mLeastSquaresResiduals.push_back(residual);
+}
+
+//==============================================================================
+/// This returns the number of residuals from addLeastSquaresResidual()
+int Problem::getNumLeastSquaresResiduals() const
+{
+  return mLeastSquaresResiduals.size();
 }
 
 //==============================================================================
@@ -155,6 +172,22 @@ int Problem::getFlatDynamicProblemDim(
   return 0;
 }
 
+//==============================================================================
+/// This finds the contiguous range of dynamic dims that the rollout over
+/// timesteps [startTime, endTime) can depend on. Anything outside it has a
+/// structurally zero Jacobian for a loss confined to that window.
+void Problem::getDynamicDimRangeForTimesteps(
+    std::shared_ptr<simulation::World> world,
+    int /* startTime */,
+    int /* endTime */,
+    /* OUT */ int& firstDim,
+    /* OUT */ int& numDims) const
+{
+  // Without knowing how our dims are laid out in time, assume everything
+  firstDim = 0;
+  numDims = getFlatDynamicProblemDim(world);
+}
+
 //==============================================================================
 /// This copies a shot down into a single flat vector
 void Problem::flatten(
@@ -566,11 +599,42 @@ int Problem::getNumberNonZeroJacobianStatic(
 int Problem::getNumberNonZeroJacobianDynamic(
     std::shared_ptr<simulation::World> world)
 {
-  return mConstraints.size() * getFlatDynamicProblemDim(world);
+  int nnzj = 0;
+  for (int i = 0; i < mConstraints.size(); i++)
+  {
+    int firstDim = 0;
+    int numDims = 0;
+    getLossFnDynamicDimRange(world, mConstraints[i], firstDim, numDims);
+    nnzj += numDims;
+  }
+  return nnzj;
 }
 
 //==============================================================================
-/// This gets the structure of the non-zero entries in the Jacobian
+/// This gets the dynamic dims that `loss` can depend on. This is
+/// everything, unless the loss is separable over a time window.
+void Problem::getLossFnDynamicDimRange(
+    std::shared_ptr<simulation::World> world,
+    const LossFn& loss,
+    /* OUT */ int& firstDim,
+    /* OUT */ int& numDims) const
+{
+  if (loss.isTimestepSeparable())
+  {
+    getDynamicDimRangeForTimesteps(
+        world, loss.getStartTime(), loss.getEndTime(), firstDim, numDims);
+  }
+  else
+  {
+    firstDim = 0;
+    numDims = getFlatDynamicProblemDim(world);
+  }
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the Jacobian. This is
+/// only rebuilt when the shape of the problem changes, so repeated solves of
+/// the same problem (like MPC) just copy it out.
 void Problem::getJacobianSparsityStructure(
     std::shared_ptr<simulation::World> world,
     Eigen::Ref<Eigen::VectorXi> rows,
@@ -582,17 +646,35 @@ void Problem::getJacobianSparsityStructure(
   assert(
       nnzjStatic + nnzjDynamic == rows.size()
       && nnzjStatic + nnzjDynamic == cols.size());
-  getJacobianSparsityStructureStatic(
-      world, rows.segment(0, nnzjStatic), cols.segment(0, nnzjStatic), log);
-  getJacobianSparsityStructureDynamic(
-      world,
-      rows.segment(nnzjStatic, nnzjDynamic),
-      cols.segment(nnzjStatic, nnzjDynamic),
-      log);
-  // Bump all the dynamic elements over by `staticCols`
+
   int staticCols = getFlatStaticProblemDim(world);
-  cols.segment(nnzjStatic, nnzjDynamic)
-      += Eigen::VectorXi::Ones(nnzjDynamic) * staticCols;
+  std::vector<int> shape{staticCols,
+                         getFlatDynamicProblemDim(world),
+                         getConstraintDim(),
+                         nnzjStatic,
+                         nnzjDynamic};
+  if (shape != mJacobianStructureShape)
+  {
+    mJacobianStructureRows.resize(nnzjStatic + nnzjDynamic);
+    mJacobianStructureCols.resize(nnzjStatic + nnzjDynamic);
+    getJacobianSparsityStructureStatic(
+        world,
+        mJacobianStructureRows.segment(0, nnzjStatic),
+        mJacobianStructureCols.segment(0, nnzjStatic),
+        log);
+    getJacobianSparsityStructureDynamic(
+        world,
+        mJacobianStructureRows.segment(nnzjStatic, nnzjDynamic),
+        mJacobianStructureCols.segment(nnzjStatic, nnzjDynamic),
+        log);
+    // Bump all the dynamic elements over by `staticCols`
+    mJacobianStructureCols.segment(nnzjStatic, nnzjDynamic)
+        += Eigen::VectorXi::Ones(nnzjDynamic) * staticCols;
+    mJacobianStructureShape = shape;
+  }
+
+  rows = mJacobianStructureRows;
+  cols = mJacobianStructureCols;
 }
 
 //==============================================================================
@@ -617,7 +699,10 @@ void Problem::getJacobianSparsityStructureDynamic(
   // Do row-major ordering
   for (int j = 0; j < mConstraints.size(); j++)
   {
-    for (int i = 0; i < getFlatDynamicProblemDim(world); i++)
+    int firstDim = 0;
+    int numDims = 0;
+    getLossFnDynamicDimRange(world, mConstraints[j], firstDim, numDims);
+    for (int i = firstDim; i < firstDim + numDims; i++)
     {
       rows(cursor) = j;
       cols(cursor) = i;
@@ -701,20 +786,41 @@ void Problem::getSparseJacobian(
   int cursorStatic = 0;
   int nStatic = getFlatStaticProblemDim(world);
   int nDynamic = getFlatDynamicProblemDim(world);
+  Eigen::VectorXs gradDynamic;
   for (int i = 0; i < mConstraints.size(); i++)
   {
     mConstraints[i].getLossAndGradient(
         getRolloutCache(world, thisLog),
         /* OUT */ getGradientWrtRolloutCache(world, thisLog),
         thisLog);
-    backpropGradientWrt(
-        world,
-        getGradientWrtRolloutCache(world, thisLog),
-        /* OUT */ sparseStatic.segment(cursorStatic, nStatic),
-        /* OUT */ sparseDynamic.segment(cursorDynamic, nDynamic),
-        thisLog);
+    int firstDim = 0;
+    int numDims = 0;
+    getLossFnDynamicDimRange(world, mConstraints[i], firstDim, numDims);
+    if (numDims == nDynamic)
+    {
+      backpropGradientWrt(
+          world,
+          getGradientWrtRolloutCache(world, thisLog),
+          /* OUT */ sparseStatic.segment(cursorStatic, nStatic),
+          /* OUT */ sparseDynamic.segment(cursorDynamic, nDynamic),
+          thisLog);
+    }
+    else
+    {
+      // Backprop still produces the whole dynamic gradient, so we need some
+      // scratch space to keep just the part inside this constraint's window
+      gradDynamic.resize(nDynamic);
+      backpropGradientWrt(
+          world,
+          getGradientWrtRolloutCache(world, thisLog),
+          /* OUT */ sparseStatic.segment(cursorStatic, nStatic),
+          /* OUT */ gradDynamic,
+          thisLog);
+      sparseDynamic.segment(cursorDynamic, numDims)
+          = gradDynamic.segment(firstDim, numDims);
+    }
     cursorStatic += nStatic;
-    cursorDynamic += nDynamic;
+    cursorDynamic += numDims;
   }
 
   assert(cursorStatic == sparseStatic.size());
@@ -745,6 +851,196 @@ void Problem::getSparseJacobian(
       log);
 }
 
+//==============================================================================
+/// For each dynamic dim, this returns the first dynamic dim it shares a
+/// least-squares residual with, or -1 if no residual depends on it. That's
+/// the first column of its row in the lower triangle of the Hessian.
+std::vector<int> Problem::getHessianDynamicRowStarts(
+    std::shared_ptr<simulation::World> world) const
+{
+  std::vector<int> rowStarts(getFlatDynamicProblemDim(world), -1);
+  for (const LossFn& residual : mLeastSquaresResiduals)
+  {
+    int firstDim = 0;
+    int numDims = 0;
+    getLossFnDynamicDimRange(world, residual, firstDim, numDims);
+    for (int i = firstDim; i < firstDim + numDims; i++)
+    {
+      if (rowStarts[i] == -1 || rowStarts[i] > firstDim)
+        rowStarts[i] = firstDim;
+    }
+  }
+  return rowStarts;
+}
+
+//==============================================================================
+/// This gets the number of non-zero entries in the lower triangle of the
+/// Gauss-Newton Hessian of the loss
+int Problem::getNumberNonZeroHessian(std::shared_ptr<simulation::World> world)
+{
+  if (mLeastSquaresResiduals.size() == 0)
+    return 0;
+
+  int staticDim = getFlatStaticProblemDim(world);
+  int nnzh = (staticDim * (staticDim + 1)) / 2;
+  std::vector<int> rowStarts = getHessianDynamicRowStarts(world);
+  for (int i = 0; i < rowStarts.size(); i++)
+  {
+    if (rowStarts[i] != -1)
+      nnzh += staticDim + (i - rowStarts[i] + 1);
+  }
+  return nnzh;
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the lower triangle of
+/// the Gauss-Newton Hessian of the loss. Static dims touch every residual,
+/// but dynamic dims only meet other dynamic dims if some residual that's
+/// separable over a time window depends on both.
+void Problem::getHessianSparsityStructure(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXi> rows,
+    Eigen::Ref<Eigen::VectorXi> cols,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("Problem.getHessianSparsityStructure");
+  }
+#endif
+
+  assert(rows.size() == getNumberNonZeroHessian(world));
+  assert(cols.size() == getNumberNonZeroHessian(world));
+
+  int cursor = 0;
+  if (mLeastSquaresResiduals.size() > 0)
+  {
+    // Do row-major ordering, over the lower triangle
+    int staticDim = getFlatStaticProblemDim(world);
+    for (int row = 0; row < staticDim; row++)
+    {
+      for (int col = 0; col <= row; col++)
+      {
+        rows(cursor) = row;
+        cols(cursor) = col;
+        cursor++;
+      }
+    }
+    std::vector<int> rowStarts = getHessianDynamicRowStarts(world);
+    for (int i = 0; i < rowStarts.size(); i++)
+    {
+      if (rowStarts[i] == -1)
+        continue;
+      int row = staticDim + i;
+      for (int col = 0; col < staticDim; col++)
+      {
+        rows(cursor) = row;
+        cols(cursor) = col;
+        cursor++;
+      }
+      for (int col = staticDim + rowStarts[i]; col <= row; col++)
+      {
+        rows(cursor) = row;
+        cols(cursor) = col;
+        cursor++;
+      }
+    }
+  }
+  assert(cursor == rows.size());
+
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This writes the lower triangle of the Gauss-Newton Hessian of the loss,
+/// 2 * J^T * J where J is the Jacobian of the least-squares residuals, to a
+/// sparse vector in the order of getHessianSparsityStructure()
+void Problem::getSparseGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXs> sparse,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("Problem.getSparseGaussNewtonHessian");
+  }
+#endif
+
+  assert(sparse.size() == getNumberNonZeroHessian(world));
+
+  if (mLeastSquaresResiduals.size() > 0)
+  {
+    int staticDim = getFlatStaticProblemDim(world);
+    int dynamicDim = getFlatDynamicProblemDim(world);
+
+    // Each residual's gradient is one row of J. We keep J column-major, so
+    // each entry of J^T * J is a dot product of two contiguous columns.
+    Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(
+        mLeastSquaresResiduals.size(), staticDim + dynamicDim);
+    Eigen::VectorXs gradStatic = Eigen::VectorXs::Zero(staticDim);
+    Eigen::VectorXs gradDynamic = Eigen::VectorXs::Zero(dynamicDim);
+    for (int i = 0; i < mLeastSquaresResiduals.size(); i++)
+    {
+      mLeastSquaresResiduals[i].getLossAndGradient(
+          getRolloutCache(world, thisLog),
+          /* OUT */ getGradientWrtRolloutCache(world, thisLog),
+          thisLog);
+      backpropGradientWrt(
+          world,
+          getGradientWrtRolloutCache(world, thisLog),
+          /* OUT */ gradStatic,
+          /* OUT */ gradDynamic,
+          thisLog);
+      jac.block(i, 0, 1, staticDim) = gradStatic.transpose();
+      jac.block(i, staticDim, 1, dynamicDim) = gradDynamic.transpose();
+    }
+
+    int cursor = 0;
+    for (int row = 0; row < staticDim; row++)
+    {
+      for (int col = 0; col <= row; col++)
+      {
+        sparse(cursor) = 2 * jac.col(row).dot(jac.col(col));
+        cursor++;
+      }
+    }
+    std::vector<int> rowStarts = getHessianDynamicRowStarts(world);
+    for (int i = 0; i < rowStarts.size(); i++)
+    {
+      if (rowStarts[i] == -1)
+        continue;
+      int row = staticDim + i;
+      for (int col = 0; col < staticDim; col++)
+      {
+        sparse(cursor) = 2 * jac.col(row).dot(jac.col(col));
+        cursor++;
+      }
+      for (int col = staticDim + rowStarts[i]; col <= row; col++)
+      {
+        sparse(cursor) = 2 * jac.col(row).dot(jac.col(col));
+        cursor++;
+      }
+    }
+    assert(cursor == sparse.size());
+  }
+
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This computes the gradient in the flat problem space, automatically
 /// computing the gradients of the loss function as part of the call
@@ -997,6 +1293,28 @@ Eigen::VectorXi Problem::updateWithForces(
   return mapping;
 }
 
+//==============================================================================
+/// This recomputes the rollout cache, and clears the gradient cache. If the
+/// problem still has the same shape, this reuses the existing rollouts rather
+/// than allocating new ones.
+void Problem::refreshRolloutCache(
+    std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  if (!mRolloutCache || !mRolloutCache->resetForProblem(this))
+  {
+    mRolloutCache = std::make_shared<TrajectoryRolloutReal>(this);
+  }
+  getStates(
+      world,
+      /* OUT */ mRolloutCache.get(),
+      log);
+  if (!mGradWrtRolloutCache || !mGradWrtRolloutCache->resetForProblem(this))
+  {
+    mGradWrtRolloutCache = std::make_shared<TrajectoryRolloutReal>(this);
+  }
+  mRolloutCacheDirty = false;
+}
+
 //==============================================================================
 const TrajectoryRollout* Problem::getRolloutCache(
     std::shared_ptr<simulation::World> world,
@@ -1013,13 +1331,7 @@ const TrajectoryRollout* Problem::getRolloutCache(
 
   if (mRolloutCacheDirty)
   {
-    mRolloutCache = std::make_shared<TrajectoryRolloutReal>(this);
-    getStates(
-        world,
-        /* OUT */ mRolloutCache.get(),
-        thisLog);
-    mGradWrtRolloutCache = std::make_shared<TrajectoryRolloutReal>(this);
-    mRolloutCacheDirty = false;
+    refreshRolloutCache(world, thisLog);
   }
 
 #ifdef LOG_PERFORMANCE_PROBLEM
@@ -1048,13 +1360,7 @@ TrajectoryRollout* Problem::getGradientWrtRolloutCache(
 
   if (mRolloutCacheDirty)
   {
-    mRolloutCache = std::make_shared<TrajectoryRolloutReal>(this);
-    getStates(
-        world,
-        /* OUT */ mRolloutCache.get(),
-        thisLog);
-    mGradWrtRolloutCache = std::make_shared<TrajectoryRolloutReal>(this);
-    mRolloutCacheDirty = false;
+    refreshRolloutCache(world, thisLog);
   }
 
 #ifdef LOG_PERFORMANCE_PROBLEM
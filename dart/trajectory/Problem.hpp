@@ -30,6 +30,7 @@ class Problem
 public:
   friend class IPOptShotWrapper;
   friend class SGDOptimizer;
+  friend class IPOptOptimizer;
 
   /// Default constructor
   Problem(std::shared_ptr<simulation::World> world, LossFn loss, int steps);
@@ -50,6 +51,14 @@ public:
   /// Add a custom constraint function to the trajectory
   void addConstraint(LossFn loss);
 
+  /// For a loss of the form sum_i r_i^2, this adds one of the residuals r_i.
+  /// These don't change the loss itself (that's still whatever setLoss() got),
+  /// they're only used to build a Gauss-Newton approximation of its Hessian.
+  void addLeastSquaresResidual(LossFn residual);
+
+  /// This returns the number of residuals from addLeastSquaresResidual()
+  int getNumLeastSquaresResiduals() const;
+
   /// Register constant metadata, which will be passed along to the loss
   /// function, but will not be backpropagated into.
   void setMetadata(std::string key, Eigen::MatrixXs value);
@@ -102,6 +111,16 @@ public:
   virtual int getFlatDynamicProblemDim(
       std::shared_ptr<simulation::World> world) const;
 
+  /// This finds the contiguous range of dynamic dims that the rollout over
+  /// timesteps [startTime, endTime) can depend on. Anything outside it has a
+  /// structurally zero Jacobian for a loss confined to that window.
+  virtual void getDynamicDimRangeForTimesteps(
+      std::shared_ptr<simulation::World> world,
+      int startTime,
+      int endTime,
+      /* OUT */ int& firstDim,
+      /* OUT */ int& numDims) const;
+
   /// Returns the length of the knot-point constraint vector
   virtual int getConstraintDim() const;
 
@@ -209,8 +228,12 @@ public:
       = 0;
 
   /// This moves the trajectory forward in time, setting the starting point to
-  /// the new given starting point, and shifting the forces over by `steps`,
-  /// padding the remainder with 0s
+  /// the new given starting point, and shifting the forces over by `steps`.
+  /// The tail that falls off the end of the old plan is extrapolated by
+  /// holding the last planned force. This returns, for every index in the new
+  /// flat problem vector, the index in the old flat vector that its value was
+  /// taken from, so that callers can shift multipliers along with the primal
+  /// variables.
   virtual Eigen::VectorXi advanceSteps(
       std::shared_ptr<simulation::World> world,
       Eigen::VectorXs startPos,
@@ -292,6 +315,28 @@ public:
       Eigen::Ref<Eigen::VectorXs> sparse,
       PerformanceLog* log = nullptr);
 
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Gauss-Newton Hessian of the loss
+  int getNumberNonZeroHessian(std::shared_ptr<simulation::World> world);
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Gauss-Newton Hessian of the loss. Static dims touch every residual,
+  /// but dynamic dims only meet other dynamic dims if some residual that's
+  /// separable over a time window depends on both.
+  void getHessianSparsityStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr);
+
+  /// This writes the lower triangle of the Gauss-Newton Hessian of the loss,
+  /// 2 * J^T * J where J is the Jacobian of the least-squares residuals, to a
+  /// sparse vector in the order of getHessianSparsityStructure()
+  void getSparseGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXs> sparse,
+      PerformanceLog* log = nullptr);
+
   /// This returns the snapshots from a fresh unroll
   virtual std::vector<neural::MappedBackpropSnapshotPtr> getSnapshots(
       std::shared_ptr<simulation::World> world, PerformanceLog* log = nullptr)
@@ -414,6 +459,20 @@ protected:
       Eigen::Ref<Eigen::VectorXi> cols,
       PerformanceLog* log = nullptr);
 
+  /// This gets the dynamic dims that `loss` can depend on. This is
+  /// everything, unless the loss is separable over a time window.
+  void getLossFnDynamicDimRange(
+      std::shared_ptr<simulation::World> world,
+      const LossFn& loss,
+      /* OUT */ int& firstDim,
+      /* OUT */ int& numDims) const;
+
+  /// For each dynamic dim, this returns the first dynamic dim it shares a
+  /// least-squares residual with, or -1 if no residual depends on it. That's
+  /// the first column of its row in the lower triangle of the Hessian.
+  std::vector<int> getHessianDynamicRowStarts(
+      std::shared_ptr<simulation::World> world) const;
+
   /// This gets the structure of the non-zero entries in the Jacobian
   virtual void getJacobianSparsityStructureDynamic(
       std::shared_ptr<simulation::World> world,
@@ -440,17 +499,29 @@ protected:
       = 0;
 
 protected:
+  /// This recomputes the rollout cache, and clears the gradient cache. If the
+  /// problem still has the same shape, this reuses the existing rollouts
+  /// rather than allocating new ones.
+  void refreshRolloutCache(
+      std::shared_ptr<simulation::World> world, PerformanceLog* log);
+
   std::shared_ptr<simulation::World> mWorld;
   LossFn mLoss;
   int mSteps;
   bool mTuneStartingState;
   bool mExploreAlternateStrategies;
   std::vector<LossFn> mConstraints;
+  std::vector<LossFn> mLeastSquaresResiduals;
   std::unordered_map<std::string, std::shared_ptr<neural::Mapping>> mMappings;
   bool mRolloutCacheDirty;
   std::shared_ptr<TrajectoryRolloutReal> mRolloutCache;
   std::shared_ptr<TrajectoryRolloutReal> mGradWrtRolloutCache;
   std::unordered_map<std::string, Eigen::MatrixXs> mMetadata;
+  // The Jacobian sparsity structure only depends on the shape of the
+  // problem, so we keep the last one we built along with the shape it's for
+  std::vector<int> mJacobianStructureShape;
+  Eigen::VectorXi mJacobianStructureRows;
+  Eigen::VectorXi mJacobianStructureCols;
 };
 
 } // namespace trajectory
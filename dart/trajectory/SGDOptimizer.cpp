@@ -1,7 +1,10 @@
 #include "dart/trajectory/SGDOptimizer.hpp"
 
+#include <future>
 #include <vector>
 
+#include "dart/common/ThreadPool.hpp"
+
 #define LOG_PERFORMANCE_SGD
 
 using namespace dart;
@@ -11,9 +14,18 @@ using namespace performance;
 namespace dart {
 namespace trajectory {
 
+// This keeps Adam from dividing by zero on dimensions with no gradient
+static const s_t ADAM_EPSILON = 1e-8;
+
 //==============================================================================
 SGDOptimizer::SGDOptimizer()
-  : mIterationLimit(100), mTolerance(0), mLearningRate(1e-2)
+  : mIterationLimit(100),
+    mTolerance(0),
+    mLearningRate(1e-2),
+    mMomentum(0),
+    mAdamEnabled(false),
+    mAdamBeta1(0.9),
+    mAdamBeta2(0.999)
 {
 }
 
@@ -27,23 +39,51 @@ std::shared_ptr<Solution> SGDOptimizer::optimize(
   int n = shot->getFlatProblemDim(shot->mWorld);
   Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
   Eigen::VectorXs grad = Eigen::VectorXs::Zero(n);
+  // With momentum this is the velocity, and with Adam it's the first moment
+  Eigen::VectorXs firstMoment = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs secondMoment = Eigen::VectorXs::Zero(n);
+  s_t beta1Power = 1.0;
+  s_t beta2Power = 1.0;
   shot->flatten(shot->mWorld, x);
-  s_t loss = shot->getLoss(shot->mWorld);
+  bool batched = !mBatchProblems.empty();
+  s_t loss = 0;
 
   for (int i = 0; i < mIterationLimit; i++)
   {
-    s_t newLoss = shot->getLoss(shot->mWorld);
+    s_t newLoss = batched ? getBatchLossAndGradient(x, i, grad)
+                          : shot->getLoss(shot->mWorld);
     s_t improvement = loss - newLoss;
-    if (improvement > 0 && improvement < mTolerance)
+    if (i > 0 && improvement > 0 && improvement < mTolerance)
     {
       std::cout << "Improvement less than tolerance, converged." << std::endl;
       break;
     }
     loss = newLoss;
     std::cout << "Iter " << i << ": " << newLoss << std::endl;
-    shot->getGradientWrtRolloutCache(shot->mWorld);
-    shot->backpropGradient(shot->mWorld, grad);
-    x -= grad * mLearningRate;
+    if (!batched)
+    {
+      shot->getGradientWrtRolloutCache(shot->mWorld);
+      shot->backpropGradient(shot->mWorld, grad);
+    }
+
+    if (mAdamEnabled)
+    {
+      firstMoment = mAdamBeta1 * firstMoment + (1 - mAdamBeta1) * grad;
+      secondMoment = mAdamBeta2 * secondMoment
+                     + (1 - mAdamBeta2) * grad.cwiseProduct(grad);
+      // Correct for the moments starting out biased towards 0
+      beta1Power *= mAdamBeta1;
+      beta2Power *= mAdamBeta2;
+      Eigen::VectorXs m = firstMoment / (1 - beta1Power);
+      Eigen::VectorXs v = secondMoment / (1 - beta2Power);
+      x -= mLearningRate
+           * (m.array() / (v.array().sqrt() + ADAM_EPSILON)).matrix();
+    }
+    else
+    {
+      firstMoment = mMomentum * firstMoment + grad;
+      x -= firstMoment * mLearningRate;
+    }
     shot->unflatten(shot->mWorld, x);
 
     for (auto callback : mIntermediateCallbacks)
@@ -73,5 +113,102 @@ void SGDOptimizer::setLearningRate(s_t learningRate)
   mLearningRate = learningRate;
 }
 
+//==============================================================================
+/// This sets the heavy-ball momentum on the gradient steps. 0 (the
+/// default) is plain gradient descent. This is ignored if Adam is enabled.
+void SGDOptimizer::setMomentum(s_t momentum)
+{
+  mMomentum = momentum;
+}
+
+//==============================================================================
+/// If true, steps are scaled per-dimension with Adam, instead of taking
+/// plain (or momentum) gradient steps.
+void SGDOptimizer::setAdamEnabled(bool enabled)
+{
+  mAdamEnabled = enabled;
+}
+
+//==============================================================================
+/// This sets the decay rates for Adam's moment estimates. The defaults are
+/// 0.9 and 0.999.
+void SGDOptimizer::setAdamBetas(s_t beta1, s_t beta2)
+{
+  mAdamBeta1 = beta1;
+  mAdamBeta2 = beta2;
+}
+
+//==============================================================================
+/// This enables mini-batching. Instead of stepping on the gradient of the
+/// problem passed to optimize(), every iteration copies the current
+/// solution into each of these problems, evaluates all their gradients in
+/// parallel, and steps on the average. Each problem must have the same flat
+/// dimension as the one being optimized, and must own its own world (for
+/// example, a clone) so that they can run concurrently. Pass an empty list
+/// to go back to full-batch steps.
+void SGDOptimizer::setBatchProblems(
+    std::vector<std::shared_ptr<Problem>> problems)
+{
+  if (!problems.empty())
+  {
+    // Before using Eigen in a multi-threaded environment, we need to explicitly
+    // call this (at least prior to Eigen 3.3)
+    Eigen::initParallel();
+  }
+  mBatchProblems = problems;
+}
+
+//==============================================================================
+/// This sets the perturbation applied to each batch problem before every
+/// gradient evaluation. This is only used if there are batch problems.
+void SGDOptimizer::setBatchPerturbation(BatchPerturbation perturbation)
+{
+  mBatchPerturbation = perturbation;
+}
+
+//==============================================================================
+/// This copies `x` into every batch problem, perturbs them, and evaluates
+/// them all in parallel. It writes the average gradient to `grad`, and
+/// returns the average loss.
+s_t SGDOptimizer::getBatchLossAndGradient(
+    const Eigen::VectorXs& x,
+    int iteration,
+    /* OUT */ Eigen::Ref<Eigen::VectorXs> grad)
+{
+  int numSamples = mBatchProblems.size();
+  Eigen::VectorXs losses = Eigen::VectorXs::Zero(numSamples);
+  Eigen::MatrixXs grads = Eigen::MatrixXs::Zero(grad.size(), numSamples);
+
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  for (int k = 0; k < numSamples; k++)
+  {
+    // Every problem owns its world, and writes only its own column, so
+    // these don't share any mutable state
+    auto task = [this, &x, &losses, &grads, iteration, k]() {
+      Problem* problem = mBatchProblems[k].get();
+      std::shared_ptr<simulation::World> world = problem->mWorld;
+      problem->unflatten(world, x);
+      if (mBatchPerturbation)
+      {
+        mBatchPerturbation(problem, world, k, iteration);
+      }
+      losses(k) = problem->getLoss(world);
+      problem->getGradientWrtRolloutCache(world);
+      problem->backpropGradient(world, grads.col(k));
+    };
+    futures.push_back(pool.submit(task));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+  {
+    future.get();
+  }
+
+  // Average in sample order, so the result doesn't depend on scheduling
+  grad = grads.rowwise().sum() / numSamples;
+  return losses.sum() / numSamples;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -28,6 +28,19 @@ namespace trajectory {
 class SGDOptimizer : public Optimizer
 {
 public:
+  /// This gets called on every batch problem, right before we evaluate its
+  /// gradient on each iteration. It's how you randomize the domain: perturb
+  /// the masses on `world`, shift the start state of `problem`, etc. Batch
+  /// problems aren't reset between iterations, so this should set values
+  /// outright rather than nudging them. The arguments are (problem, world,
+  /// sample index, iteration).
+  typedef std::function<void(
+      Problem* problem,
+      std::shared_ptr<simulation::World> world,
+      int sample,
+      int iteration)>
+      BatchPerturbation;
+
   SGDOptimizer();
 
   virtual ~SGDOptimizer() = default;
@@ -41,10 +54,49 @@ public:
 
   void setLearningRate(s_t learningRate);
 
+  /// This sets the heavy-ball momentum on the gradient steps. 0 (the
+  /// default) is plain gradient descent. This is ignored if Adam is enabled.
+  void setMomentum(s_t momentum);
+
+  /// If true, steps are scaled per-dimension with Adam, instead of taking
+  /// plain (or momentum) gradient steps.
+  void setAdamEnabled(bool enabled);
+
+  /// This sets the decay rates for Adam's moment estimates. The defaults are
+  /// 0.9 and 0.999.
+  void setAdamBetas(s_t beta1, s_t beta2);
+
+  /// This enables mini-batching. Instead of stepping on the gradient of the
+  /// problem passed to optimize(), every iteration copies the current
+  /// solution into each of these problems, evaluates all their gradients in
+  /// parallel, and steps on the average. Each problem must have the same flat
+  /// dimension as the one being optimized, and must own its own world (for
+  /// example, a clone) so that they can run concurrently. Pass an empty list
+  /// to go back to full-batch steps.
+  void setBatchProblems(std::vector<std::shared_ptr<Problem>> problems);
+
+  /// This sets the perturbation applied to each batch problem before every
+  /// gradient evaluation. This is only used if there are batch problems.
+  void setBatchPerturbation(BatchPerturbation perturbation);
+
 protected:
+  /// This copies `x` into every batch problem, perturbs them, and evaluates
+  /// them all in parallel. It writes the average gradient to `grad`, and
+  /// returns the average loss.
+  s_t getBatchLossAndGradient(
+      const Eigen::VectorXs& x,
+      int iteration,
+      /* OUT */ Eigen::Ref<Eigen::VectorXs> grad);
+
   int mIterationLimit;
   s_t mTolerance;
   s_t mLearningRate;
+  s_t mMomentum;
+  bool mAdamEnabled;
+  s_t mAdamBeta1;
+  s_t mAdamBeta2;
+  std::vector<std::shared_ptr<Problem>> mBatchProblems;
+  BatchPerturbation mBatchPerturbation;
 };
 
 } // namespace trajectory
@@ -1,5 +1,6 @@
 #include "dart/trajectory/SingleShot.hpp"
 
+#include <algorithm>
 #include <vector>
 
 #include "dart/dynamics/Skeleton.hpp"
@@ -64,6 +65,13 @@ Eigen::Ref<Eigen::VectorXs> SingleShot::getPinnedForce(int time)
   return mPinnedForces.col(time);
 }
 
+//==============================================================================
+/// This returns true if the force at this timestep has been pinned
+bool SingleShot::isForcePinned(int time) const
+{
+  return mForcesPinned[time];
+}
+
 //==============================================================================
 /// Returns the length of the flattened problem state
 int SingleShot::getFlatDynamicProblemDim(
@@ -76,6 +84,30 @@ int SingleShot::getFlatDynamicProblemDim(
   return mSteps * dofs;
 }
 
+//==============================================================================
+/// This finds the contiguous range of dynamic dims that the rollout over
+/// timesteps [startTime, endTime) can depend on. Anything outside it has a
+/// structurally zero Jacobian for a loss confined to that window.
+void SingleShot::getDynamicDimRangeForTimesteps(
+    std::shared_ptr<simulation::World> world,
+    int startTime,
+    int endTime,
+    /* OUT */ int& firstDim,
+    /* OUT */ int& numDims) const
+{
+  firstDim = 0;
+  numDims = 0;
+  endTime = std::min(endTime, mSteps);
+  if (std::max(startTime, 0) >= endTime)
+    return;
+  // The state at step t depends on the starting state, and the forces up to
+  // and including step t, which are laid out in time order
+  int dofs = mWorld->getNumDofs();
+  numDims = Problem::getFlatDynamicProblemDim(world) + endTime * dofs;
+  if (mTuneStartingState)
+    numDims += dofs * 2;
+}
+
 //==============================================================================
 int SingleShot::getConstraintDim() const
 {
@@ -379,8 +411,8 @@ void SingleShot::backpropJacobianOfFinalState(
 
   Problem::initializeStaticJacobianOfFinalState(world, jacStatic, thisLog);
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  const std::vector<MappedBackpropSnapshotPtr>& snapshots
+      = getSnapshotsCache(world, thisLog);
 
   int posDim = world->getNumDofs();
   int velDim = world->getNumDofs();
@@ -562,8 +594,8 @@ void SingleShot::backpropGradientWrt(
   _unused(staticDims);
   assert(gradDynamic.size() == dynamicDims);
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  const std::vector<MappedBackpropSnapshotPtr>& snapshots
+      = getSnapshotsCache(world, thisLog);
   assert(snapshots.size() == mSteps);
 
   LossGradient nextTimestep;
@@ -630,10 +662,58 @@ void SingleShot::backpropGradientWrt(
 #endif
 }
 
+//==============================================================================
+/// This caps the memory that this shot's snapshots spend caching Jacobians,
+/// in bytes. Over the cap, the least recently used snapshots drop their
+/// Jacobians and recompute them if they're needed again. Backprop walks the
+/// snapshots in reverse, so on long trajectories this keeps memory bounded
+/// at the cost of recomputing Jacobians if several backwards passes are run
+/// on the same rollout. 0 (the default) means no cap.
+void SingleShot::setJacobianCacheBudget(std::size_t maxBytes)
+{
+  if (maxBytes == 0)
+  {
+    mJacobianCacheBudget = nullptr;
+  }
+  else if (mJacobianCacheBudget)
+  {
+    mJacobianCacheBudget->setMaxBytes(maxBytes);
+    return;
+  }
+  else
+  {
+    mJacobianCacheBudget
+        = std::make_shared<neural::JacobianCacheBudget>(maxBytes);
+  }
+  for (MappedBackpropSnapshotPtr& snapshot : mSnapshotsCache)
+  {
+    snapshot->getUnderlyingSnapshot()->setJacobianCacheBudget(
+        mJacobianCacheBudget);
+  }
+}
+
+//==============================================================================
+/// This returns the budget set by setJacobianCacheBudget(), or nullptr if
+/// there isn't one.
+std::shared_ptr<neural::JacobianCacheBudget>
+SingleShot::getJacobianCacheBudget()
+{
+  return mJacobianCacheBudget;
+}
+
 //==============================================================================
 /// This returns the snapshots from a fresh unroll
 std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
     std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  return getSnapshotsCache(world, log);
+}
+
+//==============================================================================
+/// This unrolls the shot if anything has changed since the last unroll, and
+/// returns the cached snapshots without copying them
+const std::vector<MappedBackpropSnapshotPtr>& SingleShot::getSnapshotsCache(
+    std::shared_ptr<simulation::World> world, PerformanceLog* log)
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
@@ -664,6 +744,11 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
     {
       world->setControlForces(mForces.col(i));
       mSnapshotsCache.push_back(mappedForwardPass(world, mMappings));
+      if (mJacobianCacheBudget)
+      {
+        mSnapshotsCache.back()->getUnderlyingSnapshot()->setJacobianCacheBudget(
+            mJacobianCacheBudget);
+      }
     }
 
     snapshot.restore();
@@ -701,8 +786,8 @@ void SingleShot::getStates(
   }
 #endif
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  const std::vector<MappedBackpropSnapshotPtr>& snapshots
+      = getSnapshotsCache(world, thisLog);
 
   for (std::string key : rollout->getMappings())
   {
@@ -785,10 +870,20 @@ void SingleShot::setControlForcesRaw(
 #endif
 }
 
+//==============================================================================
+/// This returns the raw forces in this trajectory, one column per timestep
+const Eigen::MatrixXs& SingleShot::getControlForcesRaw() const
+{
+  return mForces;
+}
+
 //==============================================================================
 /// This moves the trajectory forward in time, setting the starting point to
-/// the new given starting point, and shifting the forces over by `steps`,
-/// padding the remainder with 0s
+/// the new given starting point, and shifting the forces over by `steps`. The
+/// tail that falls off the end of the old plan is extrapolated by holding the
+/// last planned force. This returns, for every index in the new flat problem
+/// vector, the index in the old flat vector that its value was taken from, so
+/// that callers can shift multipliers along with the primal variables.
 Eigen::VectorXi SingleShot::advanceSteps(
     std::shared_ptr<simulation::World> world,
     Eigen::VectorXs startPos,
@@ -796,15 +891,37 @@ Eigen::VectorXi SingleShot::advanceSteps(
     int steps)
 {
   Eigen::VectorXi mapping = Eigen::VectorXi::Zero(getFlatProblemDim(world));
+  for (int i = 0; i < mapping.size(); i++)
+  {
+    mapping(i) = i;
+  }
 
   mStartPos = startPos;
   mStartVel = startVel;
 
-  Eigen::MatrixXs newForces = Eigen::MatrixXs::Zero(mForces.rows(), mSteps);
-  if (steps < mSteps)
+  if (mSteps == 0 || steps <= 0)
   {
-    newForces.block(0, 0, mForces.rows(), mSteps - steps)
-        = mForces.block(0, steps, mForces.rows(), mSteps - steps);
+    return mapping;
+  }
+
+  int forceDim = mForces.rows();
+  int forceCursor = getFlatStaticProblemDim(world)
+                    + Problem::getFlatDynamicProblemDim(world);
+  if (mTuneStartingState)
+  {
+    forceCursor += world->getNumDofs() * 2;
+  }
+
+  Eigen::MatrixXs newForces = Eigen::MatrixXs::Zero(forceDim, mSteps);
+  for (int i = 0; i < mSteps; i++)
+  {
+    int source = std::min(i + steps, mSteps - 1);
+    newForces.col(i) = mForces.col(source);
+    for (int j = 0; j < forceDim; j++)
+    {
+      mapping(forceCursor + i * forceDim + j)
+          = forceCursor + source * forceDim + j;
+    }
   }
   mForces = newForces;
 
@@ -855,6 +972,19 @@ void SingleShot::setStartVel(Eigen::VectorXs startVel)
 /// the end of the shot
 Eigen::VectorXs SingleShot::getFinalState(
     std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  Eigen::VectorXs state = Eigen::VectorXs::Zero(getRepresentationStateSize());
+  getFinalState(world, state, log);
+  return state;
+}
+
+//==============================================================================
+/// This unrolls the shot, and writes the (pos, vel) state concatenated at the
+/// end of the shot into `state`, without allocating
+void SingleShot::getFinalState(
+    std::shared_ptr<simulation::World> world,
+    /* OUT */ Eigen::Ref<Eigen::VectorXs> state,
+    PerformanceLog* log)
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
@@ -864,10 +994,10 @@ Eigen::VectorXs SingleShot::getFinalState(
   }
 #endif
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  const std::vector<MappedBackpropSnapshotPtr>& snapshots
+      = getSnapshotsCache(world, thisLog);
 
-  Eigen::VectorXs state = Eigen::VectorXs::Zero(getRepresentationStateSize());
+  assert(state.size() == getRepresentationStateSize());
   state.segment(0, world->getNumDofs())
       = snapshots[snapshots.size() - 1]->getPostStepPosition("identity");
   state.segment(world->getNumDofs(), world->getNumDofs())
@@ -879,7 +1009,6 @@ Eigen::VectorXs SingleShot::getFinalState(
     thisLog->end();
   }
 #endif
-  return state;
 }
 
 //==============================================================================
@@ -925,8 +1054,8 @@ std::string SingleShot::getFlatDimName(
 TimestepJacobians SingleShot::backpropStartStateJacobians(
     std::shared_ptr<simulation::World> world, bool useFdJacs)
 {
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, nullptr);
+  const std::vector<MappedBackpropSnapshotPtr>& snapshots
+      = getSnapshotsCache(world, nullptr);
 
   int posDim = world->getNumDofs();
   int velDim = world->getNumDofs();
@@ -42,10 +42,23 @@ public:
   /// This returns the pinned force value at this timestep.
   Eigen::Ref<Eigen::VectorXs> getPinnedForce(int time) override;
 
+  /// This returns true if the force at this timestep has been pinned
+  bool isForcePinned(int time) const;
+
   /// Returns the length of the flattened problem state
   int getFlatDynamicProblemDim(
       std::shared_ptr<simulation::World> world) const override;
 
+  /// This finds the contiguous range of dynamic dims that the rollout over
+  /// timesteps [startTime, endTime) can depend on. Anything outside it has a
+  /// structurally zero Jacobian for a loss confined to that window.
+  void getDynamicDimRangeForTimesteps(
+      std::shared_ptr<simulation::World> world,
+      int startTime,
+      int endTime,
+      /* OUT */ int& firstDim,
+      /* OUT */ int& numDims) const override;
+
   /// Returns the length of the knot-point constraint vector
   int getConstraintDim() const override;
 
@@ -116,6 +129,18 @@ public:
       std::shared_ptr<simulation::World> world,
       PerformanceLog* log = nullptr) override;
 
+  /// This caps the memory that this shot's snapshots spend caching Jacobians,
+  /// in bytes. Over the cap, the least recently used snapshots drop their
+  /// Jacobians and recompute them if they're needed again. Backprop walks the
+  /// snapshots in reverse, so on long trajectories this keeps memory bounded
+  /// at the cost of recomputing Jacobians if several backwards passes are run
+  /// on the same rollout. 0 (the default) means no cap.
+  void setJacobianCacheBudget(std::size_t maxBytes);
+
+  /// This returns the budget set by setJacobianCacheBudget(), or nullptr if
+  /// there isn't one.
+  std::shared_ptr<neural::JacobianCacheBudget> getJacobianCacheBudget();
+
   /// This populates the passed in matrices with the values from this trajectory
   void getStates(
       std::shared_ptr<simulation::World> world,
@@ -133,9 +158,16 @@ public:
   void setControlForcesRaw(
       Eigen::MatrixXs forces, PerformanceLog* log = nullptr) override;
 
+  /// This returns the raw forces in this trajectory, one column per timestep
+  const Eigen::MatrixXs& getControlForcesRaw() const;
+
   /// This moves the trajectory forward in time, setting the starting point to
-  /// the new given starting point, and shifting the forces over by `steps`,
-  /// padding the remainder with 0s
+  /// the new given starting point, and shifting the forces over by `steps`.
+  /// The tail that falls off the end of the old plan is extrapolated by
+  /// holding the last planned force. This returns, for every index in the new
+  /// flat problem vector, the index in the old flat vector that its value was
+  /// taken from, so that callers can shift multipliers along with the primal
+  /// variables.
   Eigen::VectorXi advanceSteps(
       std::shared_ptr<simulation::World> world,
       Eigen::VectorXs startPos,
@@ -166,6 +198,13 @@ public:
       std::shared_ptr<simulation::World> world,
       PerformanceLog* log = nullptr) override;
 
+  /// This unrolls the shot, and writes the (pos, vel) state concatenated at
+  /// the end of the shot into `state`, without allocating
+  void getFinalState(
+      std::shared_ptr<simulation::World> world,
+      /* OUT */ Eigen::Ref<Eigen::VectorXs> state,
+      PerformanceLog* log = nullptr);
+
   /// This returns the debugging name of a given DOF
   std::string getFlatDimName(
       std::shared_ptr<simulation::World> world, int dim) override;
@@ -190,6 +229,12 @@ public:
   TimestepJacobians finiteDifferenceStartStateJacobians(
       std::shared_ptr<simulation::World> world, s_t EPS);
 
+protected:
+  /// This unrolls the shot if anything has changed since the last unroll, and
+  /// returns the cached snapshots without copying them
+  const std::vector<neural::MappedBackpropSnapshotPtr>& getSnapshotsCache(
+      std::shared_ptr<simulation::World> world, PerformanceLog* log = nullptr);
+
 private:
   Eigen::VectorXs mStartPos;
   Eigen::VectorXs mStartVel;
@@ -199,6 +244,7 @@ private:
 
   bool mSnapshotsCacheDirty;
   std::vector<neural::MappedBackpropSnapshotPtr> mSnapshotsCache;
+  std::shared_ptr<neural::JacobianCacheBudget> mJacobianCacheBudget;
 };
 
 } // namespace trajectory
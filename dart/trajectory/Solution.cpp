@@ -1,5 +1,7 @@
 #include "dart/trajectory/Solution.hpp"
 
+#include <algorithm>
+#include <iostream>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
@@ -8,9 +10,13 @@
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/proto/SerializeEigen.hpp"
 #include "dart/server/RawJsonUtils.hpp"
 #include "dart/simulation/World.hpp"
 
+#include <google/protobuf/arena.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
 using namespace Ipopt;
 
 using namespace dart;
@@ -19,8 +25,150 @@ namespace dart {
 namespace trajectory {
 
 //==============================================================================
-Solution::Solution() : mSuccess(false), mPerfLog(nullptr)
+Solution::Solution()
+  : mSuccess(false),
+    mRecordingPolicy(IterationRecordingPolicy::ALL),
+    mRecordingPolicyN(1),
+    mNumRegisteredIterations(0),
+    mNumRegisteredXs(0),
+    mNumRegisteredLosses(0),
+    mNumRegisteredGradients(0),
+    mNumRegisteredConstraintValues(0),
+    mNumRegisteredSparseJacobians(0),
+    mPerfLog(nullptr)
+{
+}
+
+//==============================================================================
+Solution::~Solution()
+{
+  if (mStream.is_open())
+  {
+    mStream.close();
+  }
+}
+
+//==============================================================================
+/// This sets how many iterations we hold onto. `n` is the N for LAST_N, and
+/// the k for EVERY_KTH, and is ignored by the other policies.
+void Solution::setIterationRecordingPolicy(
+    IterationRecordingPolicy policy, int n)
+{
+  mRecordingPolicy = policy;
+  mRecordingPolicyN = std::max(n, 1);
+}
+
+//==============================================================================
+/// This returns the current recording policy
+IterationRecordingPolicy Solution::getIterationRecordingPolicy() const
+{
+  return mRecordingPolicy;
+}
+
+//==============================================================================
+/// This sets the file that STREAM_TO_DISK writes to
+void Solution::setIterationStreamPath(const std::string& path)
+{
+  if (mStream.is_open())
+  {
+    mStream.close();
+  }
+  mStreamPath = path;
+}
+
+//==============================================================================
+/// This returns the total number of iterations that were registered,
+/// including the ones we've since dropped from memory
+int Solution::getNumRegisteredIterations() const
+{
+  return mNumRegisteredIterations;
+}
+
+//==============================================================================
+template <typename T>
+void Solution::recordBounded(
+    std::vector<T>& history, int& counter, const T& value)
+{
+  const int seen = counter++;
+  switch (mRecordingPolicy)
+  {
+    case IterationRecordingPolicy::ALL:
+      history.push_back(value);
+      break;
+    case IterationRecordingPolicy::LAST_N:
+      history.push_back(value);
+      if (static_cast<int>(history.size()) > mRecordingPolicyN)
+      {
+        history.erase(
+            history.begin(),
+            history.begin() + (history.size() - mRecordingPolicyN));
+      }
+      break;
+    case IterationRecordingPolicy::EVERY_KTH:
+      if (seen % mRecordingPolicyN == 0)
+      {
+        history.push_back(value);
+      }
+      break;
+    case IterationRecordingPolicy::BEST:
+    case IterationRecordingPolicy::STREAM_TO_DISK:
+      history.clear();
+      history.push_back(value);
+      break;
+  }
+}
+
+//==============================================================================
+/// This writes a single iteration out to mStream
+void Solution::streamIteration(
+    int index,
+    const TrajectoryRollout* rollout,
+    s_t loss,
+    s_t constraintViolation)
 {
+  if (mStreamPath == "")
+  {
+    std::cout << "Solution::streamIteration() called with no stream path set! "
+                 "Call setIterationStreamPath() before optimizing."
+              << std::endl;
+    return;
+  }
+  if (!mStream.is_open())
+  {
+    mStream.open(
+        mStreamPath, std::ios::out | std::ios::binary | std::ios::trunc);
+  }
+
+  std::size_t spaceAllocated = 0;
+  {
+    google::protobuf::ArenaOptions options;
+    if (!mStreamArenaBlock.empty())
+    {
+      options.initial_block = mStreamArenaBlock.data();
+      options.initial_block_size = mStreamArenaBlock.size();
+    }
+    google::protobuf::Arena arena(options);
+    proto::TrajectoryRollout* message
+        = google::protobuf::Arena::CreateMessage<proto::TrajectoryRollout>(
+            &arena);
+    rollout->serialize(*message);
+    auto& metadata = *message->mutable_metadata();
+    proto::serializeMatrix(
+        metadata["index"], Eigen::MatrixXs::Constant(1, 1, (s_t)index));
+    proto::serializeMatrix(
+        metadata["loss"], Eigen::MatrixXs::Constant(1, 1, loss));
+    proto::serializeMatrix(
+        metadata["constraintViolation"],
+        Eigen::MatrixXs::Constant(1, 1, constraintViolation));
+    google::protobuf::util::SerializeDelimitedToOstream(*message, &mStream);
+    spaceAllocated = arena.SpaceAllocated();
+  }
+  if (spaceAllocated > mStreamArenaBlock.size())
+  {
+    mStreamArenaBlock.resize(spaceAllocated);
+  }
+  // Flush so that a crash mid-optimization still leaves a readable history
+  mStream.flush();
 }
 
 //==============================================================================
@@ -88,6 +236,35 @@ void Solution::registerForReoptimization(
   mIpoptProblem = ipoptProblem;
 }
 
+//==============================================================================
+/// This returns true if this solution came from IPOPT, and still holds onto
+/// the IPOPT problem, so that reoptimize() can be called.
+bool Solution::canReoptimize()
+{
+  return IsValid(mIpopt) && IsValid(mIpoptProblem);
+}
+
+//==============================================================================
+/// This shifts the IPOPT warm start to follow a problem that has been
+/// advanced in time. Call this with the mapping returned by
+/// Problem::advanceSteps(), before calling reoptimize(). The primal warm start
+/// comes from the (already shifted) problem itself, this moves the bound
+/// multipliers to match and tells IPOPT to start from the saved multipliers
+/// instead of re-initializing them.
+void Solution::shiftWarmStart(const Eigen::VectorXi& mapping)
+{
+  if (!canReoptimize())
+  {
+    return;
+  }
+  mIpoptProblem->shift_multipliers(mapping);
+  mIpopt->Options()->SetStringValue("warm_start_init_point", "yes");
+  // The defaults push a warm start well away from the bounds, which throws
+  // away most of what we carried over from the last solve
+  mIpopt->Options()->SetNumericValue("warm_start_bound_push", 1e-6);
+  mIpopt->Options()->SetNumericValue("warm_start_mult_bound_push", 1e-6);
+}
+
 //==============================================================================
 /// This will attempt to run another round of optimization.
 void Solution::reoptimize()
@@ -129,7 +306,41 @@ void Solution::registerIteration(
     s_t loss,
     s_t constraintViolation)
 {
-  mSteps.emplace_back(index, rollout, loss, constraintViolation);
+  const int seen = mNumRegisteredIterations++;
+  switch (mRecordingPolicy)
+  {
+    case IterationRecordingPolicy::ALL:
+      mSteps.emplace_back(index, rollout, loss, constraintViolation);
+      break;
+    case IterationRecordingPolicy::LAST_N:
+      mSteps.emplace_back(index, rollout, loss, constraintViolation);
+      if (static_cast<int>(mSteps.size()) > mRecordingPolicyN)
+      {
+        mSteps.erase(
+            mSteps.begin(),
+            mSteps.begin() + (mSteps.size() - mRecordingPolicyN));
+      }
+      break;
+    case IterationRecordingPolicy::EVERY_KTH:
+      if (seen % mRecordingPolicyN == 0)
+      {
+        mSteps.emplace_back(index, rollout, loss, constraintViolation);
+      }
+      break;
+    case IterationRecordingPolicy::BEST:
+      // Only pay for copying the rollout if this is actually an improvement
+      if (mSteps.empty() || loss < mSteps[0].loss)
+      {
+        mSteps.clear();
+        mSteps.emplace_back(index, rollout, loss, constraintViolation);
+      }
+      break;
+    case IterationRecordingPolicy::STREAM_TO_DISK:
+      streamIteration(index, rollout, loss, constraintViolation);
+      mSteps.clear();
+      mSteps.emplace_back(index, rollout, loss, constraintViolation);
+      break;
+  }
 }
 
 //==============================================================================
@@ -137,7 +348,7 @@ void Solution::registerIteration(
 /// x that we receive during optimization
 void Solution::registerX(Eigen::VectorXs x)
 {
-  mXs.push_back(x);
+  recordBounded(mXs, mNumRegisteredXs, x);
 }
 
 //==============================================================================
@@ -145,7 +356,7 @@ void Solution::registerX(Eigen::VectorXs x)
 /// loss evaluation that we produce during optimization
 void Solution::registerLoss(s_t loss)
 {
-  mLosses.push_back(loss);
+  recordBounded(mLosses, mNumRegisteredLosses, loss);
 }
 
 //==============================================================================
@@ -153,7 +364,7 @@ void Solution::registerLoss(s_t loss)
 /// gradient that we produce during optimization
 void Solution::registerGradient(Eigen::VectorXs grad)
 {
-  mGradients.push_back(grad);
+  recordBounded(mGradients, mNumRegisteredGradients, grad);
 }
 
 //==============================================================================
@@ -161,7 +372,7 @@ void Solution::registerGradient(Eigen::VectorXs grad)
 /// constraint value that we produce during optimization
 void Solution::registerConstraintValues(Eigen::VectorXs g)
 {
-  mConstraintValues.push_back(g);
+  recordBounded(mConstraintValues, mNumRegisteredConstraintValues, g);
 }
 
 //==============================================================================
@@ -169,7 +380,7 @@ void Solution::registerConstraintValues(Eigen::VectorXs g)
 /// jacobian that we produce during optimization
 void Solution::registerSparseJac(Eigen::VectorXs jac)
 {
-  mSparseJacobians.push_back(jac);
+  recordBounded(mSparseJacobians, mNumRegisteredSparseJacobians, jac);
 }
 
 //==============================================================================
@@ -1,6 +1,7 @@
 #ifndef DART_TRAJECTORY_OPTIMIZATION_RECORD_HPP_
 #define DART_TRAJECTORY_OPTIMIZATION_RECORD_HPP_
 
+#include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
@@ -44,11 +45,51 @@ struct OptimizationStep
   }
 };
 
+/// This controls how much iteration history a Solution holds onto. Long
+/// optimizations (or a long-lived MPC loop that keeps re-optimizing into the
+/// same Solution) will otherwise grow without bound.
+enum class IterationRecordingPolicy
+{
+  /// Keep every iteration in memory (the default)
+  ALL,
+  /// Keep only the most recent N iterations in memory
+  LAST_N,
+  /// Keep only every k-th iteration in memory
+  EVERY_KTH,
+  /// Keep only the iteration with the lowest loss in memory
+  BEST,
+  /// Write every iteration to disk as length-delimited proto::TrajectoryRollout
+  /// messages, and only keep the most recent iteration in memory
+  STREAM_TO_DISK
+};
+
 class Solution
 {
 public:
   Solution();
 
+  ~Solution();
+
+  /// This sets how many iterations we hold onto. `n` is the N for LAST_N, and
+  /// the k for EVERY_KTH, and is ignored by the other policies. The full debug
+  /// info (xs, losses, gradients, etc) is trimmed the same way by LAST_N and
+  /// EVERY_KTH, and only keeps the most recent entry under BEST and
+  /// STREAM_TO_DISK.
+  void setIterationRecordingPolicy(IterationRecordingPolicy policy, int n = 1);
+
+  /// This returns the current recording policy
+  IterationRecordingPolicy getIterationRecordingPolicy() const;
+
+  /// This sets the file that STREAM_TO_DISK writes to. The file is truncated
+  /// the first time we write to it. Each iteration is written as a
+  /// length-delimited proto::TrajectoryRollout, with "index", "loss" and
+  /// "constraintViolation" stored as 1x1 matrices in the metadata.
+  void setIterationStreamPath(const std::string& path);
+
+  /// This returns the total number of iterations that were registered,
+  /// including the ones we've since dropped from memory
+  int getNumRegisteredIterations() const;
+
   /// After optimization, register whether IPOPT thought it was a success
   void setSuccess(bool success);
 
@@ -122,11 +163,48 @@ public:
       SmartPtr<Ipopt::IpoptApplication> ipopt,
       SmartPtr<trajectory::IPOptShotWrapper> ipoptProblem);
 
+  /// This returns true if this solution came from IPOPT, and still holds onto
+  /// the IPOPT problem, so that reoptimize() can be called.
+  bool canReoptimize();
+
+  /// This shifts the IPOPT warm start to follow a problem that has been
+  /// advanced in time. Call this with the mapping returned by
+  /// Problem::advanceSteps(), before calling reoptimize(). The primal warm
+  /// start comes from the (already shifted) problem itself, this moves the
+  /// bound multipliers to match and tells IPOPT to start from the saved
+  /// multipliers instead of re-initializing them.
+  void shiftWarmStart(const Eigen::VectorXi& mapping);
+
   /// This will attempt to run another round of optimization.
   void reoptimize();
 
 protected:
+  /// This appends `value` to `history`, dropping old entries according to the
+  /// recording policy. `counter` counts every value ever offered to `history`.
+  template <typename T>
+  void recordBounded(std::vector<T>& history, int& counter, const T& value);
+
+  /// This writes a single iteration out to mStream
+  void streamIteration(
+      int index,
+      const TrajectoryRollout* rollout,
+      s_t loss,
+      s_t constraintViolation);
+
   bool mSuccess;
+  IterationRecordingPolicy mRecordingPolicy;
+  int mRecordingPolicyN;
+  int mNumRegisteredIterations;
+  std::string mStreamPath;
+  std::ofstream mStream;
+  // Each streamed iteration is encoded in an arena that starts out in this
+  // block, which grows to fit the biggest iteration so far
+  std::vector<char> mStreamArenaBlock;
+  int mNumRegisteredXs;
+  int mNumRegisteredLosses;
+  int mNumRegisteredGradients;
+  int mNumRegisteredConstraintValues;
+  int mNumRegisteredSparseJacobians;
   std::vector<OptimizationStep> mSteps;
   performance::PerformanceLog* mPerfLog;
   std::vector<Eigen::VectorXs> mXs;
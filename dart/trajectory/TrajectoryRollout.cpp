@@ -1,6 +1,13 @@
 #include "dart/trajectory/TrajectoryRollout.hpp"
 
+#include <algorithm>
+#include <iostream>
 #include <sstream>
+#include <vector>
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
 
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -173,6 +180,187 @@ TrajectoryRolloutReal TrajectoryRollout::deserialize(
   return recovered;
 }
 
+//==============================================================================
+/// This writes us to `output` as a length-delimited
+/// proto::TrajectoryRolloutHeader, followed by length-delimited
+/// proto::TrajectoryRolloutChunks of at most `chunkSteps` timesteps each.
+/// Returns false if the stream failed.
+bool TrajectoryRollout::serializeToStream(
+    std::ostream& output, int chunkSteps) const
+{
+  chunkSteps = std::max(chunkSteps, 1);
+  int steps = getPosesConst().cols();
+
+  proto::TrajectoryRolloutHeader header;
+  header.set_steps(steps);
+  for (const std::string& mapping : getMappings())
+  {
+    (*header.mutable_posdims())[mapping] = getPosesConst(mapping).rows();
+    (*header.mutable_veldims())[mapping] = getVelsConst(mapping).rows();
+    (*header.mutable_forcedims())[mapping]
+        = getControlForcesConst(mapping).rows();
+  }
+  proto::serializeVector(*header.mutable_mass(), getMassesConst());
+  for (auto& pair : getMetadataMap())
+  {
+    proto::serializeMatrix(
+        (*header.mutable_metadata())[pair.first], pair.second);
+  }
+  if (!google::protobuf::util::SerializeDelimitedToOstream(header, &output))
+  {
+    return false;
+  }
+
+  // Each chunk gets a fresh arena that starts out in `arenaBlock`, which
+  // grows to fit the biggest chunk so far, so after the first chunk encoding
+  // doesn't go to the heap
+  std::vector<char> arenaBlock;
+  for (int start = 0; start < steps; start += chunkSteps)
+  {
+    int len = std::min(chunkSteps, steps - start);
+    std::size_t spaceAllocated = 0;
+    {
+      google::protobuf::ArenaOptions options;
+      if (!arenaBlock.empty())
+      {
+        options.initial_block = arenaBlock.data();
+        options.initial_block_size = arenaBlock.size();
+      }
+      google::protobuf::Arena arena(options);
+      proto::TrajectoryRolloutChunk* chunk = google::protobuf::Arena::
+          CreateMessage<proto::TrajectoryRolloutChunk>(&arena);
+      chunk->set_start(start);
+      for (const std::string& mapping : getMappings())
+      {
+        proto::serializeMatrix(
+            (*chunk->mutable_pos())[mapping],
+            getPosesConst(mapping).middleCols(start, len));
+        proto::serializeMatrix(
+            (*chunk->mutable_vel())[mapping],
+            getVelsConst(mapping).middleCols(start, len));
+        proto::serializeMatrix(
+            (*chunk->mutable_force())[mapping],
+            getControlForcesConst(mapping).middleCols(start, len));
+      }
+      if (!google::protobuf::util::SerializeDelimitedToOstream(
+              *chunk, &output))
+      {
+        return false;
+      }
+      spaceAllocated = arena.SpaceAllocated();
+    }
+    if (spaceAllocated > arenaBlock.size())
+    {
+      arenaBlock.resize(spaceAllocated);
+    }
+  }
+  return output.good();
+}
+
+//==============================================================================
+/// This decodes a rollout written by serializeToStream(). If the stream is
+/// truncated, any timesteps that never arrived are left as zeros.
+TrajectoryRolloutReal TrajectoryRollout::deserializeFromStream(
+    std::istream& input)
+{
+  google::protobuf::io::IstreamInputStream zeroCopyInput(&input);
+  bool cleanEof = false;
+
+  proto::TrajectoryRolloutHeader header;
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  std::unordered_map<std::string, Eigen::MatrixXs> metadata;
+  if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+          &header, &zeroCopyInput, &cleanEof))
+  {
+    std::cout << "ERROR: TrajectoryRollout::deserializeFromStream() couldn't "
+                 "read a header, returning an empty rollout"
+              << std::endl;
+    return TrajectoryRolloutReal(
+        pos, vel, force, Eigen::VectorXs::Zero(0), metadata);
+  }
+
+  int steps = header.steps();
+  for (auto& pair : header.posdims())
+  {
+    pos[pair.first] = Eigen::MatrixXs::Zero(pair.second, steps);
+  }
+  for (auto& pair : header.veldims())
+  {
+    vel[pair.first] = Eigen::MatrixXs::Zero(pair.second, steps);
+  }
+  for (auto& pair : header.forcedims())
+  {
+    force[pair.first] = Eigen::MatrixXs::Zero(pair.second, steps);
+  }
+  for (auto& pair : header.metadata())
+  {
+    metadata[pair.first] = proto::deserializeMatrix(pair.second);
+  }
+
+  // This copies the columns in a chunk into place, skipping any that don't
+  // match the shape the header promised
+  auto copyChunk =
+      [steps](
+          std::unordered_map<std::string, Eigen::MatrixXs>& dest,
+          const google::protobuf::Map<std::string, proto::MatrixXs>& chunk,
+          int start) {
+        for (auto& pair : chunk)
+        {
+          auto it = dest.find(pair.first);
+          if (it == dest.end() || start < 0
+              || pair.second.rows() != it->second.rows()
+              || start + pair.second.cols() > steps)
+          {
+            continue;
+          }
+          it->second.middleCols(start, pair.second.cols())
+              = proto::deserializeMatrix(pair.second);
+        }
+      };
+
+  // As in serializeToStream(), every chunk's arena reuses `arenaBlock`
+  std::vector<char> arenaBlock;
+  while (true)
+  {
+    std::size_t spaceAllocated = 0;
+    {
+      google::protobuf::ArenaOptions options;
+      if (!arenaBlock.empty())
+      {
+        options.initial_block = arenaBlock.data();
+        options.initial_block_size = arenaBlock.size();
+      }
+      google::protobuf::Arena arena(options);
+      proto::TrajectoryRolloutChunk* chunk = google::protobuf::Arena::
+          CreateMessage<proto::TrajectoryRolloutChunk>(&arena);
+      if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+              chunk, &zeroCopyInput, &cleanEof))
+      {
+        if (!cleanEof)
+        {
+          std::cout << "ERROR: TrajectoryRollout::deserializeFromStream() "
+                       "hit a truncated chunk, keeping what came before it"
+                    << std::endl;
+        }
+        break;
+      }
+      copyChunk(pos, chunk->pos(), chunk->start());
+      copyChunk(vel, chunk->vel(), chunk->start());
+      copyChunk(force, chunk->force(), chunk->start());
+      spaceAllocated = arena.SpaceAllocated();
+    }
+    if (spaceAllocated > arenaBlock.size())
+    {
+      arenaBlock.resize(spaceAllocated);
+    }
+  }
+
+  return TrajectoryRolloutReal(
+      pos, vel, force, proto::deserializeVector(header.mass()), metadata);
+}
+
 //==============================================================================
 /// This creates a rollout from forces over time
 TrajectoryRolloutReal TrajectoryRollout::fromForces(
@@ -243,6 +431,120 @@ TrajectoryRolloutReal TrajectoryRollout::fromPoses(
   return TrajectoryRolloutReal(pos, vel, force, mass, metadata);
 }
 
+namespace {
+
+/// No thread keeps more than this many spare buffers around
+const std::size_t MAX_POOLED_BUFFERS = 16;
+
+/// This is set once this thread's pool has been destroyed, so rollouts that
+/// outlive it (like statics) just free their buffers instead. This is trivially
+/// destructible, so it's safe to read at any point in the thread's life.
+thread_local bool tRolloutBufferPoolDestroyed = false;
+
+struct RolloutBufferPool
+{
+  ~RolloutBufferPool()
+  {
+    tRolloutBufferPoolDestroyed = true;
+  }
+
+  std::vector<std::vector<s_t>> buffers;
+};
+
+RolloutBufferPool& getRolloutBufferPool()
+{
+  thread_local RolloutBufferPool pool;
+  return pool;
+}
+
+/// This returns a zeroed buffer of `size`, reusing the smallest pooled buffer
+/// that's big enough, if there is one
+std::vector<s_t> acquireRolloutBuffer(std::size_t size)
+{
+  std::vector<s_t> buffer;
+  if (!tRolloutBufferPoolDestroyed)
+  {
+    auto& buffers = getRolloutBufferPool().buffers;
+    int best = -1;
+    for (int i = 0; i < buffers.size(); i++)
+    {
+      if (buffers[i].capacity() >= size
+          && (best == -1
+              || buffers[i].capacity() < buffers[best].capacity()))
+      {
+        best = i;
+      }
+    }
+    if (best != -1)
+    {
+      buffer.swap(buffers[best]);
+      buffers[best].swap(buffers.back());
+      buffers.pop_back();
+    }
+  }
+  buffer.assign(size, 0.0);
+  return buffer;
+}
+
+/// This hands a buffer we're done with back to the pool
+void releaseRolloutBuffer(std::vector<s_t>& buffer)
+{
+  if (buffer.capacity() == 0 || tRolloutBufferPoolDestroyed)
+    return;
+  auto& buffers = getRolloutBufferPool().buffers;
+  if (buffers.size() < MAX_POOLED_BUFFERS)
+  {
+    buffers.emplace_back();
+    buffers.back().swap(buffer);
+  }
+  std::vector<s_t>().swap(buffer);
+}
+
+/// This lays out blocks of the given dimensions back to back, in the order of
+/// `mappings`, followed by the masses
+std::shared_ptr<TrajectoryRolloutLayout> createRolloutLayout(
+    const std::vector<std::string>& mappings,
+    const std::vector<TrajectoryRolloutLayout::MappingBlocks>& shapes,
+    int massDim)
+{
+  std::shared_ptr<TrajectoryRolloutLayout> layout
+      = std::make_shared<TrajectoryRolloutLayout>();
+  layout->mappings = mappings;
+  int cursor = 0;
+  auto place = [&](TrajectoryRolloutLayout::Block block) {
+    block.offset = cursor;
+    cursor += block.rows * block.cols;
+    return block;
+  };
+  for (int i = 0; i < mappings.size(); i++)
+  {
+    TrajectoryRolloutLayout::MappingBlocks blocks;
+    blocks.pos = place(shapes[i].pos);
+    blocks.vel = place(shapes[i].vel);
+    blocks.force = place(shapes[i].force);
+    layout->blocks[mappings[i]] = blocks;
+  }
+  layout->mass = place(TrajectoryRolloutLayout::Block{0, massDim, 1});
+  layout->size = cursor;
+  return layout;
+}
+
+/// This is the layout of a moved-from rollout, which has nothing in it
+std::shared_ptr<const TrajectoryRolloutLayout> getEmptyRolloutLayout()
+{
+  static std::shared_ptr<const TrajectoryRolloutLayout> empty
+      = createRolloutLayout({}, {}, 0);
+  return empty;
+}
+
+/// This is a shorthand for a block of the given shape, not yet placed
+TrajectoryRolloutLayout::Block shapeOf(int rows, int cols)
+{
+  return TrajectoryRolloutLayout::Block{0, rows, cols};
+}
+
+} // namespace
+
 //==============================================================================
 TrajectoryRolloutReal::TrajectoryRolloutReal(
     const std::unordered_map<std::string, std::shared_ptr<neural::Mapping>>
@@ -252,15 +554,18 @@ TrajectoryRolloutReal::TrajectoryRolloutReal(
     const std::unordered_map<std::string, Eigen::MatrixXs> metadata)
   : mMetadata(metadata)
 {
+  std::vector<std::string> names;
+  std::vector<TrajectoryRolloutLayout::MappingBlocks> shapes;
   for (auto pair : mappings)
   {
-    mPoses[pair.first] = Eigen::MatrixXs::Zero(pair.second->getPosDim(), steps);
-    mVels[pair.first] = Eigen::MatrixXs::Zero(pair.second->getVelDim(), steps);
-    mForces[pair.first]
-        = Eigen::MatrixXs::Zero(pair.second->getControlForceDim(), steps);
-    mMappings.push_back(pair.first);
+    names.push_back(pair.first);
+    shapes.push_back(TrajectoryRolloutLayout::MappingBlocks{
+        shapeOf(pair.second->getPosDim(), steps),
+        shapeOf(pair.second->getVelDim(), steps),
+        shapeOf(pair.second->getControlForceDim(), steps)});
   }
-  mMasses = Eigen::VectorXs::Zero(massDim);
+  mLayout = createRolloutLayout(names, shapes, massDim);
+  mData = acquireRolloutBuffer(mLayout->size);
 }
 
 //==============================================================================
@@ -273,6 +578,17 @@ TrajectoryRolloutReal::TrajectoryRolloutReal(Problem* shot)
 {
 }
 
+//==============================================================================
+/// This creates a rollout with the given layout, without filling in any
+/// values
+TrajectoryRolloutReal::TrajectoryRolloutReal(
+    std::shared_ptr<const TrajectoryRolloutLayout> layout,
+    const std::unordered_map<std::string, Eigen::MatrixXs>& metadata)
+  : mLayout(layout), mMetadata(metadata)
+{
+  mData = acquireRolloutBuffer(mLayout->size);
+}
+
 //==============================================================================
 /// Raw constructor
 TrajectoryRolloutReal::TrajectoryRolloutReal(
@@ -281,18 +597,27 @@ TrajectoryRolloutReal::TrajectoryRolloutReal(
     const std::unordered_map<std::string, Eigen::MatrixXs> force,
     const Eigen::VectorXs mass,
     const std::unordered_map<std::string, Eigen::MatrixXs> metadata)
-  : mMasses(mass)
 {
+  std::vector<std::string> names;
+  std::vector<TrajectoryRolloutLayout::MappingBlocks> shapes;
   for (auto pair : pos)
   {
-    mMappings.push_back(pair.first);
+    const std::string& mapping = pair.first;
+    names.push_back(mapping);
+    shapes.push_back(TrajectoryRolloutLayout::MappingBlocks{
+        shapeOf(pos.at(mapping).rows(), pos.at(mapping).cols()),
+        shapeOf(vel.at(mapping).rows(), vel.at(mapping).cols()),
+        shapeOf(force.at(mapping).rows(), force.at(mapping).cols())});
   }
-  for (const std::string& mapping : mMappings)
+  mLayout = createRolloutLayout(names, shapes, mass.size());
+  mData = acquireRolloutBuffer(mLayout->size);
+  for (const std::string& mapping : names)
   {
-    mPoses[mapping] = pos.at(mapping);
-    mVels[mapping] = vel.at(mapping);
-    mForces[mapping] = force.at(mapping);
+    getPoses(mapping) = pos.at(mapping);
+    getVels(mapping) = vel.at(mapping);
+    getControlForces(mapping) = force.at(mapping);
   }
+  getMasses() = mass;
   for (auto pair : metadata)
   {
     mMetadata[pair.first] = pair.second;
@@ -302,77 +627,226 @@ TrajectoryRolloutReal::TrajectoryRolloutReal(
 //==============================================================================
 const std::vector<std::string>& TrajectoryRolloutReal::getMappings() const
 {
-  return mMappings;
+  return mLayout->mappings;
 }
 
 //==============================================================================
 /// Deep copy constructor
 TrajectoryRolloutReal::TrajectoryRolloutReal(const TrajectoryRollout* copy)
 {
-  mMappings = copy->getMappings();
-  for (std::string key : copy->getMappings())
+  const TrajectoryRolloutReal* real
+      = dynamic_cast<const TrajectoryRolloutReal*>(copy);
+  if (real != nullptr)
+  {
+    // Same layout, so this is one flat copy
+    mLayout = real->mLayout;
+    mData = acquireRolloutBuffer(mLayout->size);
+    std::copy(real->mData.begin(), real->mData.end(), mData.begin());
+    mMetadata = real->mMetadata;
+    return;
+  }
+
+  std::vector<std::string> names = copy->getMappings();
+  std::vector<TrajectoryRolloutLayout::MappingBlocks> shapes;
+  for (const std::string& key : names)
   {
-    mPoses[key] = copy->getPosesConst(key);
-    mVels[key] = copy->getVelsConst(key);
-    mForces[key] = copy->getControlForcesConst(key);
+    shapes.push_back(TrajectoryRolloutLayout::MappingBlocks{
+        shapeOf(
+            copy->getPosesConst(key).rows(), copy->getPosesConst(key).cols()),
+        shapeOf(copy->getVelsConst(key).rows(), copy->getVelsConst(key).cols()),
+        shapeOf(
+            copy->getControlForcesConst(key).rows(),
+            copy->getControlForcesConst(key).cols())});
   }
-  mMasses = copy->getMassesConst();
+  mLayout = createRolloutLayout(names, shapes, copy->getMassesConst().size());
+  mData = acquireRolloutBuffer(mLayout->size);
+  for (const std::string& key : names)
+  {
+    getPoses(key) = copy->getPosesConst(key);
+    getVels(key) = copy->getVelsConst(key);
+    getControlForces(key) = copy->getControlForcesConst(key);
+  }
+  getMasses() = copy->getMassesConst();
   mMetadata = copy->getMetadataMap();
 }
 
+//==============================================================================
+TrajectoryRolloutReal::TrajectoryRolloutReal(const TrajectoryRolloutReal& other)
+  : TrajectoryRolloutReal(static_cast<const TrajectoryRollout*>(&other))
+{
+}
+
+//==============================================================================
+TrajectoryRolloutReal::TrajectoryRolloutReal(TrajectoryRolloutReal&& other)
+  : mLayout(std::move(other.mLayout)),
+    mData(std::move(other.mData)),
+    mMetadata(std::move(other.mMetadata))
+{
+  // Leave `other` as a valid rollout with no mappings, so its data pointer
+  // never gets used
+  other.mLayout = getEmptyRolloutLayout();
+  other.mData.clear();
+}
+
+//==============================================================================
+TrajectoryRolloutReal& TrajectoryRolloutReal::operator=(
+    const TrajectoryRolloutReal& other)
+{
+  if (this == &other)
+    return *this;
+  if (mData.size() != other.mData.size())
+  {
+    releaseRolloutBuffer(mData);
+    mData = acquireRolloutBuffer(other.mData.size());
+  }
+  std::copy(other.mData.begin(), other.mData.end(), mData.begin());
+  mLayout = other.mLayout;
+  mMetadata = other.mMetadata;
+  return *this;
+}
+
+//==============================================================================
+TrajectoryRolloutReal& TrajectoryRolloutReal::operator=(
+    TrajectoryRolloutReal&& other)
+{
+  if (this == &other)
+    return *this;
+  mData.swap(other.mData);
+  std::swap(mLayout, other.mLayout);
+  mMetadata.swap(other.mMetadata);
+  return *this;
+}
+
+//==============================================================================
+TrajectoryRolloutReal::~TrajectoryRolloutReal()
+{
+  releaseRolloutBuffer(mData);
+}
+
+//==============================================================================
+/// If this rollout already has the shape that `shot` needs, this zeroes it,
+/// refreshes its metadata from `shot`, and returns true. Otherwise it leaves
+/// this alone and returns false. This lets a Problem recycle its cached
+/// rollouts instead of re-allocating them on every iteration.
+bool TrajectoryRolloutReal::resetForProblem(Problem* shot)
+{
+  const auto& mappings = shot->getMappings();
+  const int steps = shot->getNumSteps();
+  if (mappings.size() != mLayout->mappings.size()
+      || mLayout->mass.rows != shot->getMassDims())
+    return false;
+  for (const auto& pair : mappings)
+  {
+    auto blocks = mLayout->blocks.find(pair.first);
+    if (blocks == mLayout->blocks.end()
+        || blocks->second.pos.rows != pair.second->getPosDim()
+        || blocks->second.vel.rows != pair.second->getVelDim()
+        || blocks->second.force.rows != pair.second->getControlForceDim()
+        || blocks->second.pos.cols != steps || blocks->second.vel.cols != steps
+        || blocks->second.force.cols != steps)
+      return false;
+  }
+  setZero();
+  mMetadata = shot->getMetadataMap();
+  return true;
+}
+
+//==============================================================================
+/// This sets every pose, vel, force and mass to zero
+void TrajectoryRolloutReal::setZero()
+{
+  std::fill(mData.begin(), mData.end(), 0.0);
+}
+
+//==============================================================================
+/// This returns how many buffers are sitting in this thread's pool, waiting to
+/// be reused by the next rollout that gets created. This is mostly useful for
+/// testing.
+std::size_t TrajectoryRolloutReal::getNumPooledBuffers()
+{
+  if (tRolloutBufferPoolDestroyed)
+    return 0;
+  return getRolloutBufferPool().buffers.size();
+}
+
+//==============================================================================
+Eigen::Map<Eigen::MatrixXs> TrajectoryRolloutReal::mapBlock(
+    const TrajectoryRolloutLayout::Block& block)
+{
+  return Eigen::Map<Eigen::MatrixXs>(
+      mData.data() + block.offset, block.rows, block.cols);
+}
+
+//==============================================================================
+Eigen::Map<const Eigen::MatrixXs> TrajectoryRolloutReal::mapBlockConst(
+    const TrajectoryRolloutLayout::Block& block) const
+{
+  return Eigen::Map<const Eigen::MatrixXs>(
+      mData.data() + block.offset, block.rows, block.cols);
+}
+
+//==============================================================================
+const TrajectoryRolloutLayout::MappingBlocks& TrajectoryRolloutReal::getBlocks(
+    const std::string& mapping) const
+{
+  return mLayout->blocks.at(mapping);
+}
+
 //==============================================================================
 Eigen::Ref<Eigen::MatrixXs> TrajectoryRolloutReal::getPoses(
     const std::string& mapping)
 {
-  return mPoses.at(mapping);
+  return mapBlock(getBlocks(mapping).pos);
 }
 
 //==============================================================================
 Eigen::Ref<Eigen::MatrixXs> TrajectoryRolloutReal::getVels(
     const std::string& mapping)
 {
-  return mVels.at(mapping);
+  return mapBlock(getBlocks(mapping).vel);
 }
 
 //==============================================================================
 Eigen::Ref<Eigen::MatrixXs> TrajectoryRolloutReal::getControlForces(
     const std::string& mapping)
 {
-  return mForces.at(mapping);
+  return mapBlock(getBlocks(mapping).force);
 }
 
 //==============================================================================
 Eigen::Ref<Eigen::VectorXs> TrajectoryRolloutReal::getMasses()
 {
-  return mMasses;
+  return Eigen::Map<Eigen::VectorXs>(
+      mData.data() + mLayout->mass.offset, mLayout->mass.rows);
 }
 
 //==============================================================================
 const Eigen::Ref<const Eigen::MatrixXs> TrajectoryRolloutReal::getPosesConst(
     const std::string& mapping) const
 {
-  return mPoses.at(mapping);
+  return mapBlockConst(getBlocks(mapping).pos);
 }
 
 //==============================================================================
 const Eigen::Ref<const Eigen::MatrixXs> TrajectoryRolloutReal::getVelsConst(
     const std::string& mapping) const
 {
-  return mVels.at(mapping);
+  return mapBlockConst(getBlocks(mapping).vel);
 }
 
 //==============================================================================
 const Eigen::Ref<const Eigen::MatrixXs> TrajectoryRolloutReal::getControlForcesConst(
     const std::string& mapping) const
 {
-  return mForces.at(mapping);
+  return mapBlockConst(getBlocks(mapping).force);
 }
 
 //==============================================================================
 const Eigen::Ref<const Eigen::VectorXs> TrajectoryRolloutReal::getMassesConst()
     const
 {
-  return mMasses;
+  return Eigen::Map<const Eigen::VectorXs>(
+      mData.data() + mLayout->mass.offset, mLayout->mass.rows);
 }
 
 //==============================================================================
@@ -597,5 +1071,53 @@ void TrajectoryRolloutConstRef::setMetadata(
   assert(false && "It should be impossible to get a mutable reference from a TrajectorRolloutConstRef");
 }
 
+//==============================================================================
+CompactTrajectoryRollout::CompactTrajectoryRollout(
+    const TrajectoryRollout* rollout)
+{
+  const TrajectoryRolloutReal* real
+      = dynamic_cast<const TrajectoryRolloutReal*>(rollout);
+  std::unique_ptr<TrajectoryRolloutReal> copy;
+  if (real == nullptr)
+  {
+    // Refs and slices don't have a flat buffer, so lay them out in one first
+    copy = std::make_unique<TrajectoryRolloutReal>(rollout);
+    real = copy.get();
+  }
+  mLayout = real->mLayout;
+  mData.resize(real->mData.size());
+  for (std::size_t i = 0; i < mData.size(); i++)
+  {
+    mData[i] = static_cast<float>(real->mData[i]);
+  }
+  mMetadata = real->mMetadata;
+}
+
+//==============================================================================
+/// This expands a full precision copy of the rollout
+TrajectoryRolloutReal CompactTrajectoryRollout::toRollout() const
+{
+  TrajectoryRolloutReal result(mLayout, mMetadata);
+  for (std::size_t i = 0; i < mData.size(); i++)
+  {
+    result.mData[i] = mData[i];
+  }
+  return result;
+}
+
+//==============================================================================
+const std::vector<std::string>& CompactTrajectoryRollout::getMappings() const
+{
+  return mLayout->mappings;
+}
+
+//==============================================================================
+/// This returns the number of bytes used to store the poses, vels, forces and
+/// masses
+std::size_t CompactTrajectoryRollout::bytes() const
+{
+  return mData.size() * sizeof(float);
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef DART_TRAJECTORY_ROLLOUT_HPP_
 #define DART_TRAJECTORY_ROLLOUT_HPP_
 
+#include <iosfwd>
 #include <memory>
 #include <optional>
 #include <string>
@@ -78,6 +79,16 @@ public:
   static TrajectoryRolloutReal deserialize(
       const proto::TrajectoryRollout& proto);
 
+  /// This writes us to `output` as a length-delimited
+  /// proto::TrajectoryRolloutHeader, followed by length-delimited
+  /// proto::TrajectoryRolloutChunks of at most `chunkSteps` timesteps each.
+  /// Returns false if the stream failed.
+  bool serializeToStream(std::ostream& output, int chunkSteps = 256) const;
+
+  /// This decodes a rollout written by serializeToStream(). If the stream is
+  /// truncated, any timesteps that never arrived are left as zeros.
+  static TrajectoryRolloutReal deserializeFromStream(std::istream& input);
+
   /// This creates a rollout from forces over time
   static TrajectoryRolloutReal fromForces(
       std::shared_ptr<simulation::World> world,
@@ -91,6 +102,31 @@ public:
       std::vector<Eigen::VectorXs> poses);
 };
 
+/// This describes where each mapping's poses, vels and forces live in the
+/// single contiguous buffer of a TrajectoryRolloutReal. It never changes once
+/// it's built, so copies of a rollout just share it.
+struct TrajectoryRolloutLayout
+{
+  struct Block
+  {
+    int offset;
+    int rows;
+    int cols;
+  };
+
+  struct MappingBlocks
+  {
+    Block pos;
+    Block vel;
+    Block force;
+  };
+
+  std::vector<std::string> mappings;
+  std::unordered_map<std::string, MappingBlocks> blocks;
+  Block mass;
+  int size;
+};
+
 class TrajectoryRolloutReal : public TrajectoryRollout
 {
 public:
@@ -116,6 +152,25 @@ public:
       const Eigen::VectorXs mass,
       const std::unordered_map<std::string, Eigen::MatrixXs> metadata);
 
+  TrajectoryRolloutReal(const TrajectoryRolloutReal& other);
+
+  TrajectoryRolloutReal(TrajectoryRolloutReal&& other);
+
+  TrajectoryRolloutReal& operator=(const TrajectoryRolloutReal& other);
+
+  TrajectoryRolloutReal& operator=(TrajectoryRolloutReal&& other);
+
+  ~TrajectoryRolloutReal();
+
+  /// If this rollout already has the shape that `shot` needs, this zeroes it,
+  /// refreshes its metadata from `shot`, and returns true. Otherwise it
+  /// leaves this alone and returns false. This lets a Problem recycle its
+  /// cached rollouts instead of re-allocating them on every iteration.
+  bool resetForProblem(Problem* shot);
+
+  /// This sets every pose, vel, force and mass to zero
+  void setZero();
+
   const std::vector<std::string>& getMappings() const override;
   Eigen::Ref<Eigen::MatrixXs> getPoses(
       const std::string& mapping = "identity") override;
@@ -138,13 +193,39 @@ public:
   virtual void setMetadata(
       const std::string& key, Eigen::MatrixXs value) override;
 
+  /// This returns how many buffers are sitting in this thread's pool, waiting
+  /// to be reused by the next rollout that gets created. This is mostly
+  /// useful for testing.
+  static std::size_t getNumPooledBuffers();
+
 protected:
-  std::unordered_map<std::string, Eigen::MatrixXs> mPoses;
-  std::unordered_map<std::string, Eigen::MatrixXs> mVels;
-  std::unordered_map<std::string, Eigen::MatrixXs> mForces;
-  Eigen::VectorXs mMasses;
+  friend class CompactTrajectoryRollout;
+
+  /// This creates a rollout with the given layout, without filling in any
+  /// values
+  TrajectoryRolloutReal(
+      std::shared_ptr<const TrajectoryRolloutLayout> layout,
+      const std::unordered_map<std::string, Eigen::MatrixXs>& metadata);
+
+  /// This returns a view of `block` in our buffer
+  Eigen::Map<Eigen::MatrixXs> mapBlock(
+      const TrajectoryRolloutLayout::Block& block);
+
+  /// This returns a const view of `block` in our buffer
+  Eigen::Map<const Eigen::MatrixXs> mapBlockConst(
+      const TrajectoryRolloutLayout::Block& block) const;
+
+  /// This looks up the blocks for `mapping`, throwing std::out_of_range if we
+  /// don't have that mapping
+  const TrajectoryRolloutLayout::MappingBlocks& getBlocks(
+      const std::string& mapping) const;
+
+  std::shared_ptr<const TrajectoryRolloutLayout> mLayout;
+  // Every pose, vel, force and mass lives in here, laid out by mLayout. This
+  // comes from (and goes back to) a thread-local pool, so rollouts that get
+  // created and destroyed every iteration don't hit the heap.
+  std::vector<s_t> mData;
   std::unordered_map<std::string, Eigen::MatrixXs> mMetadata;
-  std::vector<std::string> mMappings;
 };
 
 class TrajectoryRolloutRef : public TrajectoryRollout
@@ -216,6 +297,31 @@ protected:
   int mLen;
 };
 
+/// This is a storage-only, single precision snapshot of a rollout, for holding
+/// on to lots of them (for example, a dataset of recorded plans). It shares
+/// the rollout's layout, and stores every pose, vel, force and mass as a
+/// float, so it takes half the memory. There's no math on it directly: expand
+/// it back out with toRollout() first. Metadata is kept in full precision.
+class CompactTrajectoryRollout
+{
+public:
+  CompactTrajectoryRollout(const TrajectoryRollout* rollout);
+
+  /// This expands a full precision copy of the rollout
+  TrajectoryRolloutReal toRollout() const;
+
+  const std::vector<std::string>& getMappings() const;
+
+  /// This returns the number of bytes used to store the poses, vels, forces
+  /// and masses
+  std::size_t bytes() const;
+
+protected:
+  std::shared_ptr<const TrajectoryRolloutLayout> mLayout;
+  std::vector<float> mData;
+  std::unordered_map<std::string, Eigen::MatrixXs> mMetadata;
+};
+
 } // namespace trajectory
 } // namespace dart
 
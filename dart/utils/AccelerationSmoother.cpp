@@ -1,6 +1,8 @@
 #include "AccelerationSmoother.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 namespace dart {
 namespace utils {
@@ -11,6 +13,10 @@ namespace utils {
  *
  * The alpha value will determine how much smoothing to apply. A value of 0
  * corresponds to no smoothing.
+ *
+ * The system we factor is banded (each timestep only couples to the 3 on
+ * either side of it), so this stores it sparse and factors it with a sparse
+ * LDLT. Both memory and time are linear in the number of timesteps.
  */
 AccelerationSmoother::AccelerationSmoother(int timesteps, s_t alpha)
   : mTimesteps(timesteps), mAlpha(alpha)
@@ -25,14 +31,27 @@ AccelerationSmoother::AccelerationSmoother(int timesteps, s_t alpha)
   stamp *= mAlpha;
   mPosMap = stamp * 2;
 
-  mB = Eigen::MatrixXs::Zero(mTimesteps, mTimesteps);
+  std::vector<Eigen::Triplet<s_t>> entries;
+  entries.reserve(16 * std::max(0, mTimesteps - 3) + mTimesteps);
   for (int i = 0; i < mTimesteps - 3; i++)
   {
-    mB.block<4, 4>(i, i) += stamp;
+    for (int row = 0; row < 4; row++)
+    {
+      for (int col = 0; col < 4; col++)
+      {
+        entries.emplace_back(i + row, i + col, stamp(row, col));
+      }
+    }
+  }
+  for (int i = 0; i < mTimesteps; i++)
+  {
+    entries.emplace_back(i, i, 1.0);
   }
-  mB += Eigen::MatrixXs::Identity(mTimesteps, mTimesteps);
+  // Duplicate entries get summed, which is exactly the overlapping stamps
+  mB.resize(mTimesteps, mTimesteps);
+  mB.setFromTriplets(entries.begin(), entries.end());
 
-  mFactoredB = Eigen::HouseholderQR<Eigen::MatrixXs>(mB);
+  mFactoredB.compute(mB);
 };
 
 /**
@@ -42,29 +61,23 @@ AccelerationSmoother::AccelerationSmoother(int timesteps, s_t alpha)
  *
  * This method assumes that the `series` matrix has `mTimesteps` number of
  * columns, and each column represents a complete joint configuration at that
- * timestep.
+ * timestep. All the rows get solved together, in a single pass over the
+ * factorization.
  */
 Eigen::MatrixXs AccelerationSmoother::smooth(Eigen::MatrixXs series)
 {
   assert(series.cols() == mTimesteps);
 
-  Eigen::MatrixXs smoothed
-      = Eigen::MatrixXs::Zero(series.rows(), mTimesteps - 3);
-
-  for (int row = 0; row < series.rows(); row++)
+  // Each column of `c` is the right hand side for one row of `series`
+  Eigen::MatrixXs c = Eigen::MatrixXs::Zero(mTimesteps, series.rows());
+  for (int i = 0; i < mTimesteps - 3; i++)
   {
-    Eigen::VectorXs c = Eigen::VectorXs::Zero(mTimesteps);
-    for (int i = 0; i < mTimesteps - 3; i++)
-    {
-      c.segment<4>(i) += mPosMap * series.block<1, 4>(row, i).transpose();
-    }
-    // Eigen::VectorXs deltas = mB.completeOrthogonalDecomposition().solve(c);
-    Eigen::VectorXs deltas = mFactoredB.solve(c);
-    smoothed.row(row) = series.block(row, 0, 1, mTimesteps - 3)
-                        - deltas.segment(0, mTimesteps - 3).transpose();
+    c.middleRows<4>(i) += mPosMap * series.middleCols<4>(i).transpose();
   }
+  Eigen::MatrixXs deltas = mFactoredB.solve(c);
 
-  return smoothed;
+  return series.leftCols(mTimesteps - 3)
+         - deltas.topRows(mTimesteps - 3).transpose();
 };
 
 /**
@@ -88,11 +101,9 @@ s_t AccelerationSmoother::getLoss(
   {
     c.segment<4>(i) += mPosMap * series.segment<4>(i);
   }
-  Eigen::MatrixXs BminusI
-      = mB - Eigen::MatrixXs::Identity(mTimesteps, mTimesteps);
-  s_t matrix_score = (deltas.transpose() * mB * deltas)(0)
-                     + (series.transpose() * BminusI * series)(0)
-                     + c.dot(deltas);
+  // This is series^T (B - I) series, without forming B - I
+  s_t seriesScore = series.dot(mB * series) - series.squaredNorm();
+  s_t matrix_score = deltas.dot(mB * deltas) + seriesScore + c.dot(deltas);
   // s_t matrix_score = series.transpose() * BminusI * series;
 
   ///////////////////////////////////////////////////////////////////
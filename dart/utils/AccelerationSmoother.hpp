@@ -1,6 +1,9 @@
 #ifndef UTILS_PATH_SMOOTHER
 #define UTILS_PATH_SMOOTHER
 
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseCore>
+
 #include "dart/math/MathTypes.hpp"
 
 namespace dart {
@@ -15,6 +18,10 @@ public:
    *
    * The alpha value will determine how much smoothing to apply. A value of 0
    * corresponds to no smoothing.
+   *
+   * The system we factor is banded (each timestep only couples to the 3 on
+   * either side of it), so this stores it sparse and factors it with a sparse
+   * LDLT. Both memory and time are linear in the number of timesteps.
    */
   AccelerationSmoother(int timesteps, s_t alpha);
 
@@ -26,7 +33,8 @@ public:
    *
    * This method assumes that the `series` matrix has `mTimesteps` number of
    * columns, and each column represents a complete joint configuration at that
-   * timestep.
+   * timestep. All the rows get solved together, in a single pass over the
+   * factorization.
    */
   Eigen::MatrixXs smooth(Eigen::MatrixXs series);
 
@@ -47,8 +55,14 @@ private:
   int mTimesteps;
   s_t mAlpha;
   Eigen::Matrix4s mPosMap;
-  Eigen::MatrixXs mB;
-  Eigen::HouseholderQR<Eigen::MatrixXs> mFactoredB;
+  Eigen::SparseMatrix<s_t> mB;
+  // The natural ordering is already optimal for a banded matrix, so there's no
+  // point paying for a fill-reducing reordering
+  Eigen::SimplicialLDLT<
+      Eigen::SparseMatrix<s_t>,
+      Eigen::Lower,
+      Eigen::NaturalOrdering<int>>
+      mFactoredB;
 };
 
 } // namespace utils
@@ -1,5 +1,19 @@
 #include "dart/utils/CSVParser.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <limits>
+
+#if defined(__has_include)
+#if __has_include(<charconv>) && __cplusplus >= 201703L
+#include <charconv>
+#endif
+#endif
+
+#include "dart/common/Console.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/common/Uri.hpp"
 #include "dart/math/MathTypes.hpp"
 #include "dart/math/SimmSpline.hpp"
@@ -91,6 +105,575 @@ std::vector<std::map<std::string, std::string>> parseFile(
   return values;
 };
 
+namespace {
+
+//==============================================================================
+/// Parses a number out of [begin, end), ignoring surrounding whitespace.
+/// Returns NaN if the field isn't a number.
+s_t parseNumber(const char* begin, const char* end)
+{
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    begin++;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+    end--;
+  if (begin == end)
+    return std::numeric_limits<s_t>::quiet_NaN();
+
+  double value;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  // from_chars doesn't accept a leading "+", which strtod does
+  if (*begin == '+')
+    begin++;
+  std::from_chars_result result = std::from_chars(begin, end, value);
+  if (result.ec != std::errc() || result.ptr != end)
+    return std::numeric_limits<s_t>::quiet_NaN();
+#else
+  // strtod needs a terminated string, and fields are short
+  char field[64];
+  std::size_t length = static_cast<std::size_t>(end - begin);
+  if (length >= sizeof(field))
+    return std::numeric_limits<s_t>::quiet_NaN();
+  std::memcpy(field, begin, length);
+  field[length] = '\0';
+  char* parsedEnd;
+  value = std::strtod(field, &parsedEnd);
+  if (parsedEnd != field + length)
+    return std::numeric_limits<s_t>::quiet_NaN();
+#endif
+  return static_cast<s_t>(value);
+}
+
+//==============================================================================
+/// Parses every non-empty line in [begin, end), appending the fields at
+/// columnIndices to out (one row of columnIndices.size() values per line)
+void parseLines(
+    const char* begin,
+    const char* end,
+    const std::vector<int>& columnIndices,
+    std::vector<s_t>& out)
+{
+  std::vector<std::pair<const char*, const char*>> fields;
+  while (begin < end)
+  {
+    const char* lineEnd = static_cast<const char*>(
+        std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+    if (lineEnd == nullptr)
+      lineEnd = end;
+    const char* next = lineEnd == end ? end : lineEnd + 1;
+    if (lineEnd > begin && lineEnd[-1] == '\r')
+      lineEnd--;
+
+    if (lineEnd > begin)
+    {
+      fields.clear();
+      const char* fieldStart = begin;
+      for (const char* c = begin; c < lineEnd; c++)
+      {
+        if (*c == ',')
+        {
+          fields.emplace_back(fieldStart, c);
+          fieldStart = c + 1;
+        }
+      }
+      fields.emplace_back(fieldStart, lineEnd);
+
+      for (int index : columnIndices)
+      {
+        if (index >= 0 && index < static_cast<int>(fields.size()))
+          out.push_back(parseNumber(fields[index].first, fields[index].second));
+        else
+          out.push_back(std::numeric_limits<s_t>::quiet_NaN());
+      }
+    }
+    begin = next;
+  }
+}
+
+//==============================================================================
+/// Copies row-major values into a matrix with `cols` columns
+Eigen::MatrixXs toMatrix(const std::vector<s_t>& values, int cols)
+{
+  if (cols == 0)
+    return Eigen::MatrixXs::Zero(0, 0);
+  const int rows = static_cast<int>(values.size()) / cols;
+  return Eigen::Map<const Eigen::Matrix<
+      s_t,
+      Eigen::Dynamic,
+      Eigen::Dynamic,
+      Eigen::RowMajor>>(values.data(), rows, cols);
+}
+
+//==============================================================================
+/// Splits the lines in [begin, end) into numThreads pieces and parses them on
+/// the global thread pool
+Eigen::MatrixXs parseLinesInParallel(
+    const char* begin,
+    const char* end,
+    const std::vector<int>& columnIndices,
+    int numThreads)
+{
+  std::vector<const char*> cuts;
+  cuts.push_back(begin);
+  const std::size_t pieceBytes
+      = static_cast<std::size_t>(end - begin) / numThreads + 1;
+  while (static_cast<int>(cuts.size()) < numThreads)
+  {
+    const char* cut = cuts.back() + pieceBytes;
+    if (cut >= end)
+      break;
+    const char* lineEnd = static_cast<const char*>(
+        std::memchr(cut, '\n', static_cast<std::size_t>(end - cut)));
+    if (lineEnd == nullptr)
+      break;
+    cuts.push_back(lineEnd + 1);
+  }
+  cuts.push_back(end);
+
+  const std::size_t numPieces = cuts.size() - 1;
+  std::vector<std::vector<s_t>> pieces(numPieces);
+  common::ThreadPool& pool = common::ThreadPool::getGlobal();
+  std::vector<std::future<void>> futures;
+  futures.reserve(numPieces);
+  for (std::size_t i = 0; i < numPieces; i++)
+  {
+    const char* pieceBegin = cuts[i];
+    const char* pieceEnd = cuts[i + 1];
+    std::vector<s_t>* piece = &pieces[i];
+    futures.push_back(
+        pool.submit([pieceBegin, pieceEnd, piece, &columnIndices] {
+          parseLines(pieceBegin, pieceEnd, columnIndices, *piece);
+        }));
+  }
+  pool.waitAll(futures);
+  for (std::future<void>& future : futures)
+    future.get();
+
+  std::size_t total = 0;
+  for (const std::vector<s_t>& piece : pieces)
+    total += piece.size();
+  std::vector<s_t> values;
+  values.reserve(total);
+  for (const std::vector<s_t>& piece : pieces)
+    values.insert(values.end(), piece.begin(), piece.end());
+  return toMatrix(values, static_cast<int>(columnIndices.size()));
+}
+
+//==============================================================================
+/// Returns the end of the first line in [begin, end), not counting "\r\n"
+const char* findLineEnd(const char* begin, const char* end)
+{
+  const char* lineEnd = static_cast<const char*>(
+      std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+  return lineEnd == nullptr ? end : lineEnd;
+}
+
+//==============================================================================
+/// Returns the number of comma separated fields in [begin, end)
+int countFields(const char* begin, const char* end)
+{
+  if (end > begin && end[-1] == '\r')
+    end--;
+  return 1 + static_cast<int>(std::count(begin, end, ','));
+}
+
+//==============================================================================
+/// Looks up each of columns in the header, warning about missing ones
+std::vector<int> findColumns(
+    const std::vector<std::string>& columnNames,
+    const std::vector<std::string>& columns,
+    const common::Uri& uri)
+{
+  std::vector<int> indices;
+  for (const std::string& column : columns)
+  {
+    auto it = std::find(columnNames.begin(), columnNames.end(), column);
+    if (it == columnNames.end())
+    {
+      dtwarn << "[CSVParser::parseColumns] Column \"" << column
+             << "\" does not appear in " << uri.toString()
+             << ", it will be filled with NaN.\n";
+      indices.push_back(-1);
+    }
+    else
+    {
+      indices.push_back(static_cast<int>(it - columnNames.begin()));
+    }
+  }
+  return indices;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+Eigen::MatrixXs parseColumns(
+    const common::Uri& uri,
+    const std::vector<std::string>& columns,
+    const common::ResourceRetrieverPtr& nullOrRetriever,
+    int numThreads)
+{
+  if (numThreads <= 1)
+  {
+    CSVReader reader(uri, true, nullOrRetriever);
+    if (!reader.isOpen())
+      return Eigen::MatrixXs::Zero(0, static_cast<int>(columns.size()));
+    const std::vector<int> indices
+        = findColumns(reader.getColumnNames(), columns, uri);
+
+    std::vector<s_t> values;
+    std::vector<s_t> row(columns.size());
+    while (reader.readRow(indices, row.data()))
+      values.insert(values.end(), row.begin(), row.end());
+    if (columns.empty())
+      return Eigen::MatrixXs::Zero(0, 0);
+    return toMatrix(values, static_cast<int>(columns.size()));
+  }
+
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+  const std::string content = retriever->readAll(uri);
+  const char* begin = content.data();
+  const char* end = begin + content.size();
+
+  const char* headerEnd = findLineEnd(begin, end);
+  std::vector<std::string> columnNames;
+  const char* nameEnd = headerEnd;
+  if (nameEnd > begin && nameEnd[-1] == '\r')
+    nameEnd--;
+  const char* fieldStart = begin;
+  for (const char* c = begin; c <= nameEnd; c++)
+  {
+    if (c == nameEnd || *c == ',')
+    {
+      columnNames.emplace_back(fieldStart, c);
+      fieldStart = c + 1;
+    }
+  }
+  const std::vector<int> indices = findColumns(columnNames, columns, uri);
+  const char* bodyBegin = headerEnd == end ? end : headerEnd + 1;
+  return parseLinesInParallel(bodyBegin, end, indices, numThreads);
+}
+
+//==============================================================================
+Eigen::MatrixXs parseMatrix(
+    const common::Uri& uri,
+    const common::ResourceRetrieverPtr& nullOrRetriever,
+    int numThreads)
+{
+  if (numThreads <= 1)
+  {
+    CSVReader reader(uri, false, nullOrRetriever);
+    std::vector<std::string> fields;
+    if (!reader.isOpen() || !reader.readRow(fields))
+      return Eigen::MatrixXs::Zero(0, 0);
+
+    std::vector<int> indices(fields.size());
+    for (std::size_t i = 0; i < indices.size(); i++)
+      indices[i] = static_cast<int>(i);
+    std::vector<s_t> values;
+    values.reserve(fields.size());
+    for (const std::string& field : fields)
+      values.push_back(parseNumber(field.data(), field.data() + field.size()));
+
+    std::vector<s_t> row(indices.size());
+    while (reader.readRow(indices, row.data()))
+      values.insert(values.end(), row.begin(), row.end());
+    return toMatrix(values, static_cast<int>(indices.size()));
+  }
+
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+  const std::string content = retriever->readAll(uri);
+  const char* begin = content.data();
+  const char* end = begin + content.size();
+
+  // Skip leading blank lines, to find the first row that has fields in it
+  while (begin < end && (*begin == '\n' || *begin == '\r'))
+    begin++;
+  if (begin == end)
+    return Eigen::MatrixXs::Zero(0, 0);
+
+  std::vector<int> indices(countFields(begin, findLineEnd(begin, end)));
+  for (std::size_t i = 0; i < indices.size(); i++)
+    indices[i] = static_cast<int>(i);
+  return parseLinesInParallel(begin, end, indices, numThreads);
+}
+
+//==============================================================================
+CSVReader::CSVReader(
+    const common::Uri& uri,
+    bool hasHeader,
+    const common::ResourceRetrieverPtr& nullOrRetriever,
+    std::size_t chunkBytes)
+  : mBuffer(std::max<std::size_t>(chunkBytes, 64)),
+    mBegin(0),
+    mEnd(0),
+    mExhausted(false)
+{
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+  mResource = retriever->retrieve(uri);
+  if (!mResource)
+  {
+    dtwarn << "[CSVReader] Failed to open " << uri.toString() << "\n";
+    mExhausted = true;
+    return;
+  }
+  if (hasHeader)
+    readRow(mColumnNames);
+}
+
+//==============================================================================
+bool CSVReader::isOpen() const
+{
+  return mResource != nullptr;
+}
+
+//==============================================================================
+const std::vector<std::string>& CSVReader::getColumnNames() const
+{
+  return mColumnNames;
+}
+
+//==============================================================================
+int CSVReader::getColumnIndex(const std::string& name) const
+{
+  auto it = std::find(mColumnNames.begin(), mColumnNames.end(), name);
+  if (it == mColumnNames.end())
+    return -1;
+  return static_cast<int>(it - mColumnNames.begin());
+}
+
+//==============================================================================
+bool CSVReader::readRow(std::vector<std::string>& fields)
+{
+  const char* begin;
+  const char* end;
+  if (!nextLine(begin, end))
+    return false;
+  splitLine(begin, end);
+  fields.clear();
+  for (const auto& field : mFields)
+    fields.emplace_back(field.first, field.second);
+  return true;
+}
+
+//==============================================================================
+bool CSVReader::readRow(const std::vector<int>& columnIndices, s_t* out)
+{
+  const char* begin;
+  const char* end;
+  if (!nextLine(begin, end))
+    return false;
+  splitLine(begin, end);
+  for (std::size_t i = 0; i < columnIndices.size(); i++)
+  {
+    const int index = columnIndices[i];
+    if (index >= 0 && index < static_cast<int>(mFields.size()))
+      out[i] = parseNumber(mFields[index].first, mFields[index].second);
+    else
+      out[i] = std::numeric_limits<s_t>::quiet_NaN();
+  }
+  return true;
+}
+
+//==============================================================================
+bool CSVReader::nextLine(const char*& begin, const char*& end)
+{
+  while (true)
+  {
+    const char* data = mBuffer.data();
+    const char* lineEnd = static_cast<const char*>(
+        std::memchr(data + mBegin, '\n', mEnd - mBegin));
+
+    if (lineEnd == nullptr && !mExhausted)
+    {
+      // Move the partial line to the front, growing the buffer if the line
+      // doesn't fit in it, then read in the next chunk behind it
+      if (mBegin > 0)
+      {
+        std::memmove(mBuffer.data(), data + mBegin, mEnd - mBegin);
+        mEnd -= mBegin;
+        mBegin = 0;
+      }
+      if (mEnd == mBuffer.size())
+        mBuffer.resize(mBuffer.size() * 2);
+      const std::size_t read
+          = mResource->read(mBuffer.data() + mEnd, 1, mBuffer.size() - mEnd);
+      if (read == 0)
+        mExhausted = true;
+      mEnd += read;
+      continue;
+    }
+
+    if (lineEnd == nullptr)
+    {
+      // The last line of the file doesn't need a trailing newline
+      if (mBegin == mEnd)
+        return false;
+      lineEnd = data + mEnd;
+    }
+
+    begin = data + mBegin;
+    end = lineEnd;
+    mBegin = std::min(static_cast<std::size_t>(lineEnd - data) + 1, mEnd);
+    if (end > begin && end[-1] == '\r')
+      end--;
+    if (end > begin)
+      return true;
+  }
+}
+
+//==============================================================================
+void CSVReader::splitLine(const char* begin, const char* end)
+{
+  mFields.clear();
+  const char* fieldStart = begin;
+  for (const char* c = begin; c < end; c++)
+  {
+    if (*c == ',')
+    {
+      mFields.emplace_back(fieldStart, c);
+      fieldStart = c + 1;
+    }
+  }
+  mFields.emplace_back(fieldStart, end);
+}
+
+//==============================================================================
+CSVWriter::CSVWriter(
+    const std::string& path,
+    const std::string& separator,
+    std::size_t bufferBytes)
+  : mFile(std::fopen(path.c_str(), "wb")),
+    mSeparator(separator),
+    mBuffer(std::max<std::size_t>(bufferBytes, 64)),
+    mSize(0),
+    mRowStarted(false)
+{
+  if (mFile == nullptr)
+  {
+    dtwarn << "[CSVWriter] Failed to open " << path << " for writing\n";
+  }
+}
+
+//==============================================================================
+CSVWriter::~CSVWriter()
+{
+  close();
+}
+
+//==============================================================================
+bool CSVWriter::isOpen() const
+{
+  return mFile != nullptr;
+}
+
+//==============================================================================
+CSVWriter& CSVWriter::writeField(const std::string& value)
+{
+  startField();
+  append(value.data(), value.size());
+  return *this;
+}
+
+//==============================================================================
+CSVWriter& CSVWriter::writeField(s_t value)
+{
+  startField();
+  const double asDouble = static_cast<double>(value);
+  char text[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  // The shortest representation that parses back to exactly asDouble
+  std::to_chars_result result
+      = std::to_chars(text, text + sizeof(text), asDouble);
+  append(text, static_cast<std::size_t>(result.ptr - text));
+#else
+  int length = std::snprintf(text, sizeof(text), "%.17g", asDouble);
+  append(text, static_cast<std::size_t>(length));
+#endif
+  return *this;
+}
+
+//==============================================================================
+CSVWriter& CSVWriter::writeField(int value)
+{
+  startField();
+  char text[16];
+  int length = std::snprintf(text, sizeof(text), "%d", value);
+  append(text, static_cast<std::size_t>(length));
+  return *this;
+}
+
+//==============================================================================
+CSVWriter& CSVWriter::endRow()
+{
+  append("\n", 1);
+  mRowStarted = false;
+  return *this;
+}
+
+//==============================================================================
+CSVWriter& CSVWriter::writeMatrix(
+    const Eigen::Ref<const Eigen::MatrixXs>& matrix)
+{
+  for (int row = 0; row < matrix.rows(); row++)
+  {
+    for (int col = 0; col < matrix.cols(); col++)
+      writeField(matrix(row, col));
+    endRow();
+  }
+  return *this;
+}
+
+//==============================================================================
+void CSVWriter::flush()
+{
+  if (mFile == nullptr)
+    return;
+  if (mSize > 0)
+    std::fwrite(mBuffer.data(), 1, mSize, mFile);
+  mSize = 0;
+  std::fflush(mFile);
+}
+
+//==============================================================================
+void CSVWriter::close()
+{
+  if (mFile == nullptr)
+    return;
+  flush();
+  std::fclose(mFile);
+  mFile = nullptr;
+}
+
+//==============================================================================
+void CSVWriter::append(const char* data, std::size_t size)
+{
+  if (mFile == nullptr)
+    return;
+  if (mSize + size > mBuffer.size())
+  {
+    std::fwrite(mBuffer.data(), 1, mSize, mFile);
+    mSize = 0;
+    // Anything that wouldn't fit in an empty buffer goes straight out
+    if (size > mBuffer.size())
+    {
+      std::fwrite(data, 1, size, mFile);
+      return;
+    }
+  }
+  std::memcpy(mBuffer.data() + mSize, data, size);
+  mSize += size;
+}
+
+//==============================================================================
+void CSVWriter::startField()
+{
+  if (mRowStarted)
+    append(mSeparator.data(), mSeparator.size());
+  mRowStarted = true;
+}
+
 } // namespace CSVParser
 
 } // namespace utils
@@ -1,12 +1,16 @@
 #ifndef DART_UTILS_CSVPARSER_HPP_
 #define DART_UTILS_CSVPARSER_HPP_
 
+#include <cstdio>
 #include <map>
 #include <string>
 #include <vector>
 
+#include <Eigen/Dense>
+
 #include "dart/common/LocalResourceRetriever.hpp"
 #include "dart/common/Uri.hpp"
+#include "dart/math/MathTypes.hpp"
 #include "dart/simulation/World.hpp"
 
 namespace dart {
@@ -20,6 +24,128 @@ std::vector<std::map<std::string, std::string>> parseFile(
     const common::Uri& uri,
     const common::ResourceRetrieverPtr& retriever = nullptr);
 
+/// Parses the named columns of a CSV file straight into a matrix, with one
+/// row per data row and one column per entry in `columns`. Columns that don't
+/// appear in the header, and fields that aren't numbers, come back as NaN.
+///
+/// With numThreads <= 1 the file is streamed a chunk at a time. Otherwise the
+/// file is read whole, split into numThreads pieces on line boundaries, and
+/// the pieces are parsed on the global thread pool.
+Eigen::MatrixXs parseColumns(
+    const common::Uri& uri,
+    const std::vector<std::string>& columns,
+    const common::ResourceRetrieverPtr& retriever = nullptr,
+    int numThreads = 1);
+
+/// Parses a CSV of numbers with no header row (like the ones written by
+/// CSVWriter::writeMatrix()) into a matrix. The number of columns comes from
+/// the first row: longer rows are truncated, and shorter ones padded with NaN.
+Eigen::MatrixXs parseMatrix(
+    const common::Uri& uri,
+    const common::ResourceRetrieverPtr& retriever = nullptr,
+    int numThreads = 1);
+
+/// Streams the rows of a CSV file a chunk at a time, so large exports never
+/// have to be held in memory all at once. Fields are split on commas, and the
+/// "\r" of Windows line endings is dropped.
+class CSVReader
+{
+public:
+  /// Opens uri, and reads the first row as the header if hasHeader is true
+  CSVReader(
+      const common::Uri& uri,
+      bool hasHeader = true,
+      const common::ResourceRetrieverPtr& retriever = nullptr,
+      std::size_t chunkBytes = 1 << 20);
+
+  /// Returns false if the file couldn't be retrieved
+  bool isOpen() const;
+
+  /// Returns the fields of the header row, or an empty list if there isn't one
+  const std::vector<std::string>& getColumnNames() const;
+
+  /// Returns the index of the named column in the header, or -1 if it's missing
+  int getColumnIndex(const std::string& name) const;
+
+  /// Reads the next row into fields. Returns false once the file is exhausted.
+  bool readRow(std::vector<std::string>& fields);
+
+  /// Reads the next row, parsing the field at each of columnIndices into the
+  /// matching entry of out (which must have room for columnIndices.size()
+  /// values). Missing and non-numeric fields are NaN. Returns false once the
+  /// file is exhausted.
+  bool readRow(const std::vector<int>& columnIndices, s_t* out);
+
+protected:
+  /// Finds the next non-empty line, refilling the buffer as needed. The
+  /// returned range stays valid until the next call.
+  bool nextLine(const char*& begin, const char*& end);
+
+  /// Splits [begin, end) on commas into mFields
+  void splitLine(const char* begin, const char* end);
+
+  common::ResourcePtr mResource;
+  std::vector<char> mBuffer;
+  std::size_t mBegin;
+  std::size_t mEnd;
+  bool mExhausted;
+  std::vector<std::string> mColumnNames;
+  std::vector<std::pair<const char*, const char*>> mFields;
+};
+
+/// Writes CSV files through a large in-memory buffer, formatting numbers
+/// directly into it rather than going through iostreams. Floating point values
+/// are written with enough digits to round trip exactly.
+class CSVWriter
+{
+public:
+  CSVWriter(
+      const std::string& path,
+      const std::string& separator = ",",
+      std::size_t bufferBytes = 1 << 16);
+
+  /// Flushes anything still buffered and closes the file
+  ~CSVWriter();
+
+  CSVWriter(const CSVWriter&) = delete;
+  CSVWriter& operator=(const CSVWriter&) = delete;
+
+  /// Returns false if the file couldn't be opened
+  bool isOpen() const;
+
+  /// Appends a field to the current row
+  CSVWriter& writeField(const std::string& value);
+
+  /// Appends a field to the current row
+  CSVWriter& writeField(s_t value);
+
+  /// Appends a field to the current row
+  CSVWriter& writeField(int value);
+
+  /// Ends the current row
+  CSVWriter& endRow();
+
+  /// Writes each row of matrix as a row of the file
+  CSVWriter& writeMatrix(const Eigen::Ref<const Eigen::MatrixXs>& matrix);
+
+  /// Writes out anything that's buffered
+  void flush();
+
+  /// Flushes and closes the file. Later writes are ignored.
+  void close();
+
+protected:
+  void append(const char* data, std::size_t size);
+
+  void startField();
+
+  std::FILE* mFile;
+  std::string mSeparator;
+  std::vector<char> mBuffer;
+  std::size_t mSize;
+  bool mRowStarted;
+};
+
 } // namespace CSVParser
 
 } // namespace utils
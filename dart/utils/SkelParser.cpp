@@ -41,6 +41,7 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/dart/DARTCollisionDetector.hpp"
+#include "dart/common/CachedResourceRetriever.hpp"
 #include "dart/common/Console.hpp"
 #include "dart/config.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
@@ -2564,7 +2565,9 @@ common::ResourceRetrieverPtr getRetriever(
   {
     auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
     newRetriever->addSchemaRetriever(
-        "file", std::make_shared<common::LocalResourceRetriever>());
+        "file",
+        std::make_shared<common::CachedResourceRetriever>(
+            std::make_shared<common::LocalResourceRetriever>()));
     newRetriever->addSchemaRetriever("dart", DartResourceRetriever::create());
     return newRetriever;
   }
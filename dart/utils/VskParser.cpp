@@ -65,6 +65,11 @@ struct VskData
   ParameterMap       parameterMap;
   BodyNodeColorMap   bodyNodeColorMap;
   VskParser::Options options;
+
+  /// The segment of the last marker that was read. Markers come grouped by
+  /// segment, so this lets most of them skip the name lookup in the Skeleton.
+  std::string        lastMarkerSegment;
+  dynamics::BodyNode* lastMarkerBodyNode = nullptr;
 };
 
 const s_t vsk_scale = 1.0e-3;
@@ -842,7 +847,13 @@ bool readMarker(const tinyxml2::XMLElement* markerEle,
   // if (hasAttribute(markerEle, "RADIUS"))
   //   radius = getAttributeDouble(markerEle, "RADIUS");
 
-  dynamics::BodyNode* bodyNode = skel->getBodyNode(segment);
+  dynamics::BodyNode* bodyNode = vskData.lastMarkerBodyNode;
+  if (!bodyNode || segment != vskData.lastMarkerSegment)
+  {
+    bodyNode = skel->getBodyNode(segment);
+    vskData.lastMarkerSegment = segment;
+    vskData.lastMarkerBodyNode = bodyNode;
+  }
   if (!bodyNode)
   {
     dtwarn << "[VskParser::readMarker] Failed to create a Marker ["
@@ -21,13 +21,30 @@ using namespace dynamics;
 namespace utils {
 namespace amc {
 
+namespace {
+
+/// The frames from ReadAnimation() are stored back to back, which is already
+/// the layout of a column-major (dofs x frames) matrix
+Eigen::MatrixXs toPoseMatrix(
+    const ::Library::Skeleton& amcSkel, const std::vector<double>& animation)
+{
+  if (amcSkel.frame_size <= 0)
+    return Eigen::MatrixXs::Zero(0, 0);
+  const int frames = animation.size() / amcSkel.frame_size;
+  return Eigen::Map<const Eigen::MatrixXd>(
+             animation.data(), amcSkel.frame_size, frames)
+      .cast<s_t>();
+}
+
+} // namespace
+
 std::pair<std::shared_ptr<dynamics::Skeleton>, Eigen::MatrixXs>
 AMCParser::loadAMC(const std::string& asfPath, const std::string& amcPath)
 {
   ::Library::Skeleton amcSkel;
   ::ReadSkeleton(asfPath, amcSkel);
   std::vector<double> amcAnimation;
-  ::ReadAnimation(amcPath, amcSkel, amcAnimation);
+  ::ReadAnimationParallel(amcPath, amcSkel, amcAnimation);
 
   std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create("name");
 
@@ -62,11 +79,23 @@ AMCParser::loadAMC(const std::string& asfPath, const std::string& amcPath)
     nodes.push_back(linkPair.second);
   }
 
-  Eigen::MatrixXs animation = Eigen::MatrixXs::Zero(10, 10);
+  Eigen::MatrixXs animation = toPoseMatrix(amcSkel, amcAnimation);
   return std::pair<std::shared_ptr<dynamics::Skeleton>, Eigen::MatrixXs>(
       skel, animation);
 }
 
+Eigen::MatrixXs AMCParser::loadAMCPoses(
+    const std::string& asfPath, const std::string& amcPath, int numThreads)
+{
+  ::Library::Skeleton amcSkel;
+  if (!::ReadSkeleton(asfPath, amcSkel))
+    return Eigen::MatrixXs::Zero(0, 0);
+  std::vector<double> amcAnimation;
+  if (!::ReadAnimationParallel(amcPath, amcSkel, amcAnimation, numThreads))
+    return Eigen::MatrixXs::Zero(0, 0);
+  return toPoseMatrix(amcSkel, amcAnimation);
+}
+
 } // namespace amc
 } // namespace utils
 } // namespace dart
\ No newline at end of file
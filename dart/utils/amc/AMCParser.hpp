@@ -19,8 +19,19 @@ namespace amc {
 class AMCParser
 {
 public:
+  /// Loads the skeleton in asfPath, along with the motion in amcPath as a
+  /// (dofs x frames) matrix
   std::pair<std::shared_ptr<dynamics::Skeleton>, Eigen::MatrixXs> loadAMC(
       const std::string& asfPath, const std::string& amcPath);
+
+  /// Loads just the motion in amcPath as a (dofs x frames) matrix. The frames
+  /// are split into blocks that are tokenized in parallel, which is much
+  /// faster for long recordings. numThreads <= 0 uses every worker in the
+  /// global thread pool. Returns a 0x0 matrix if either file fails to parse.
+  Eigen::MatrixXs loadAMCPoses(
+      const std::string& asfPath,
+      const std::string& amcPath,
+      int numThreads = 0);
 };
 
 } // namespace amc
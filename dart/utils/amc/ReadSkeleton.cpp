@@ -2,13 +2,17 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <set>
 
 #include <arpa/inet.h>
 #include <assert.h>
 
+#include "dart/common/ThreadPool.hpp"
 #include "dart/utils/amc/Reader.hpp"
 
 using namespace Library;
@@ -391,6 +395,281 @@ bool ReadAnimation(
   return true;
 }
 
+namespace {
+
+// Bone names sorted for binary search, so tokens can be looked up straight
+// out of the file buffer without building a string for each one
+class AmcBoneLookup
+{
+public:
+  explicit AmcBoneLookup(Skeleton const& on)
+  {
+    for (unsigned int b = 0; b < on.bones.size(); ++b)
+    {
+      sorted.push_back(make_pair(on.bones[b].name, (int)b));
+    }
+    std::sort(sorted.begin(), sorted.end());
+  }
+
+  // returns the index of the bone named [begin, end), or -1
+  int find(const char* begin, const char* end) const
+  {
+    const size_t length = end - begin;
+    auto it = std::lower_bound(
+        sorted.begin(),
+        sorted.end(),
+        0,
+        [begin, length](const pair<string, int>& bone, int) {
+          return bone.first.compare(0, string::npos, begin, length) < 0;
+        });
+    if (it != sorted.end()
+        && it->first.compare(0, string::npos, begin, length) == 0)
+    {
+      return it->second;
+    }
+    return -1;
+  }
+
+private:
+  vector<pair<string, int>> sorted;
+};
+
+// returns the end of the line starting at begin, ignoring any comment
+const char* amc_line_end(const char* begin, const char* end, const char** next)
+{
+  const char* newline = (const char*)memchr(begin, '\n', end - begin);
+  *next = newline ? newline + 1 : end;
+  const char* line_end = newline ? newline : end;
+  const char* comment = (const char*)memchr(begin, '#', line_end - begin);
+  return comment ? comment : line_end;
+}
+
+inline bool amc_is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Parses up to 'count' numbers from [begin, end) into 'into', returning how
+// many there were, or count + 1 if there were too many
+int amc_read_numbers(const char* begin, const char* end, double* into, int count)
+{
+  int read = 0;
+  while (true)
+  {
+    while (begin < end && amc_is_space(*begin))
+      ++begin;
+    if (begin == end)
+      return read;
+    char* number_end;
+    double info = strtod(begin, &number_end);
+    if (number_end == begin || number_end > end)
+      return read;
+    if (read == count)
+      return count + 1;
+    into[read++] = info;
+    begin = number_end;
+  }
+}
+
+// Parses frames [first, last) of an .amc file, whose frame number lines start
+// at frame_starts, into positions. Returns an error message, or "" on success.
+string parse_amc_frames(
+    const vector<const char*>& frame_starts,
+    const char* file_end,
+    int first,
+    int last,
+    Skeleton const& on,
+    AmcBoneLookup const& bones,
+    double* positions)
+{
+  std::ostringstream error;
+  for (int frame = first; frame < last; ++frame)
+  {
+    const char* begin = frame_starts[frame];
+    const char* end = frame + 1 < (int)frame_starts.size()
+                          ? frame_starts[frame + 1]
+                          : file_end;
+    double* frame_positions = positions + (size_t)frame * on.frame_size;
+    int dof_read = 0;
+
+    // skip the frame number line
+    const char* next;
+    amc_line_end(begin, end, &next);
+    begin = next;
+
+    while (begin < end)
+    {
+      const char* line_end = amc_line_end(begin, end, &next);
+      const char* tok = begin;
+      while (tok < line_end && amc_is_space(*tok))
+        ++tok;
+      const char* tok_end = tok;
+      while (tok_end < line_end && !amc_is_space(*tok_end))
+        ++tok_end;
+      begin = next;
+      if (tok == tok_end || *tok == ':')
+        continue;
+
+      if (tok_end - tok == 4 && memcmp(tok, "root", 4) == 0)
+      {
+        int read = amc_read_numbers(tok_end, line_end, frame_positions, 6);
+        if (read != 6)
+        {
+          error << "We read " << read << " things but were expecting " << 6
+                << " things for root, in frame " << frame << ".";
+          return error.str();
+        }
+        for (int i = 0; i < read; ++i)
+        {
+          if (on.order[i] != tolower(on.order[i]))
+          {
+            frame_positions[i] *= on.length;
+          }
+          else if (!on.ang_is_deg)
+          {
+            frame_positions[i] *= 180.0 / M_PI;
+          }
+        }
+        dof_read += read;
+      }
+      else
+      {
+        int b = bones.find(tok, tok_end);
+        if (b < 0)
+        {
+          error << "We got '" << string(tok, tok_end)
+                << "' which doesn't appear to be a bone name, in frame "
+                << frame << ".";
+          return error.str();
+        }
+        const int expected = on.bones[b].dof.size();
+        int read = amc_read_numbers(
+            tok_end,
+            line_end,
+            frame_positions + on.bones[b].frame_offset,
+            expected);
+        if (read != expected)
+        {
+          error << "We read " << read << " things but were expecting "
+                << expected << " things for bone " << on.bones[b].name
+                << ", in frame " << frame << ".";
+          return error.str();
+        }
+        dof_read += read;
+      }
+    }
+
+    // like ReadAnimation(), the last frame in the file is allowed to be short
+    if (frame + 1 < (int)frame_starts.size() && dof_read != on.frame_size)
+    {
+      error << "We read only " << dof_read << " of the total "
+            << on.frame_size << " things we wanted, in frame " << frame << ".";
+      return error.str();
+    }
+  }
+  return "";
+}
+
+} // namespace
+
+bool ReadAnimationParallel(
+    string filename,
+    Skeleton const& on,
+    vector<double>& positions,
+    int numThreads)
+{
+  if (filename.size() < 4 || filename.substr(filename.size() - 4, 4) != ".amc")
+  {
+    return ReadAnimation(filename, on, positions);
+  }
+
+  positions.clear();
+
+  ifstream file(filename.c_str(), std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  string content;
+  file.seekg(0, std::ios::end);
+  content.resize((size_t)file.tellg());
+  file.seekg(0, std::ios::beg);
+  if (!file.read(&content[0], content.size()))
+  {
+    return false;
+  }
+  const char* data = content.data();
+  const char* file_end = data + content.size();
+
+  // Find where every frame starts. This is a quick scan over line starts, and
+  // all the real tokenizing happens per block of frames below.
+  vector<const char*> frame_starts;
+  const char* begin = data;
+  while (begin < file_end)
+  {
+    const char* next;
+    const char* line_end = amc_line_end(begin, file_end, &next);
+    const char* tok = begin;
+    while (tok < line_end && amc_is_space(*tok))
+      ++tok;
+    if (tok < line_end && *tok != ':')
+    {
+      if (isdigit((unsigned char)*tok))
+      {
+        frame_starts.push_back(begin);
+      }
+      else if (frame_starts.empty())
+      {
+        cerr << "We started getting bone data outside a frame." << endl;
+        return false;
+      }
+    }
+    begin = next;
+  }
+
+  const int frames = frame_starts.size();
+  positions.assign((size_t)frames * on.frame_size, 0.0);
+  if (frames == 0)
+  {
+    return true;
+  }
+
+  AmcBoneLookup bones(on);
+  dart::common::ThreadPool& pool = dart::common::ThreadPool::getGlobal();
+  if (numThreads <= 0)
+  {
+    numThreads = pool.getNumThreads();
+  }
+  const int blocks = std::max(1, std::min(numThreads, frames));
+  vector<std::future<string>> errors;
+  for (int block = 0; block < blocks; ++block)
+  {
+    const int first = (int)((long)frames * block / blocks);
+    const int last = (int)((long)frames * (block + 1) / blocks);
+    errors.push_back(pool.submit([&, first, last] {
+      return parse_amc_frames(
+          frame_starts, file_end, first, last, on, bones, positions.data());
+    }));
+  }
+  pool.waitAll(errors);
+
+  bool ok = true;
+  for (std::future<string>& error : errors)
+  {
+    string message = error.get();
+    if (ok && !message.empty())
+    {
+      cerr << message << endl;
+      ok = false;
+    }
+  }
+  if (!ok)
+  {
+    positions.clear();
+  }
+  return ok;
+}
+
 class OrderTokenPattern : public Reader::BasePattern
 {
 public:
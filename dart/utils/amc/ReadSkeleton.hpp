@@ -17,6 +17,15 @@ bool ReadSkeletonV(string filename, Library::Skeleton& into);
 // though):
 bool ReadAnimation(
     string filename, Library::Skeleton const& on, vector<double>& positions);
+// read 'amc' file format, with the frames split into blocks that are parsed
+// in parallel on the global thread pool (numThreads <= 0 uses every worker).
+// Unlike ReadAnimation this doesn't look for a '.bmc' next to the file, and
+// other formats are passed straight to ReadAnimation:
+bool ReadAnimationParallel(
+    string filename,
+    Library::Skeleton const& on,
+    vector<double>& positions,
+    int numThreads = 0);
 // read the 'bmc' binary format (somewhat faster, probably):
 bool ReadAnimationBin(
     string filename, Library::Skeleton const& on, vector<double>& positions);
@@ -42,6 +42,7 @@
 #include <Eigen/StdVector>
 #include <tinyxml2.h>
 
+#include "dart/common/CachedResourceRetriever.hpp"
 #include "dart/common/Console.hpp"
 #include "dart/common/LocalResourceRetriever.hpp"
 #include "dart/common/ResourceRetriever.hpp"
@@ -1526,7 +1527,9 @@ common::ResourceRetrieverPtr getRetriever(
   {
     auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
     newRetriever->addSchemaRetriever(
-        "file", std::make_shared<common::LocalResourceRetriever>());
+        "file",
+        std::make_shared<common::CachedResourceRetriever>(
+            std::make_shared<common::LocalResourceRetriever>()));
     newRetriever->addSchemaRetriever("dart", DartResourceRetriever::create());
 
     return newRetriever;
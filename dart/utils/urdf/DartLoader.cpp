@@ -39,6 +39,7 @@
 #include <urdf_parser/urdf_parser.h>
 #include <urdf_world/world.h>
 
+#include "dart/common/CachedResourceRetriever.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/CylinderShape.hpp"
@@ -64,10 +65,14 @@ using ModelInterfacePtr = urdf_shared_ptr<urdf::ModelInterface>;
 
 DartLoader::DartLoader()
   : mLocalRetriever(new common::LocalResourceRetriever),
-    mPackageRetriever(new utils::PackageResourceRetriever(mLocalRetriever)),
+    mPackageRetriever(new utils::PackageResourceRetriever(
+        std::make_shared<common::CachedResourceRetriever>(mLocalRetriever))),
     mRetriever(new utils::CompositeResourceRetriever)
 {
-  mRetriever->addSchemaRetriever("file", mLocalRetriever);
+  // Package URIs resolve to local files, so both paths share one cache
+  mRetriever->addSchemaRetriever(
+      "file",
+      std::make_shared<common::CachedResourceRetriever>(mLocalRetriever));
   mRetriever->addSchemaRetriever("package", mPackageRetriever);
   mRetriever->addSchemaRetriever("dart", DartResourceRetriever::create());
 }
@@ -1,3 +1,6 @@
 #! /bin/bash
 
+# Regenerates src/proto/GUI.ts. Run this whenever dart/proto/GUI.proto changes,
+# and commit the result with the .proto change. Needs protoc and protoc-gen-ts.
+cd "$(dirname "$0")"
 protoc --proto_path=../dart/proto --ts_out=src/proto ../dart/proto/GUI.proto
\ No newline at end of file
@@ -0,0 +1,188 @@
+#!/usr/bin/env node
+/**
+ * This renders GUIRecording files to MP4 videos without a browser window, by
+ * playing each recording back frame by frame in headless Chrome and piping
+ * the frames to ffmpeg. Several recordings get rendered at once, each in its
+ * own browser, so the whole batch can use every core.
+ *
+ * Build the page first with `npm run build-headless`, and then run:
+ *
+ *   node render_videos.js [options] recording1.bin recording2.bin ...
+ *
+ * Options:
+ *   --out DIR       Where to write the videos (default: current directory).
+ *                   Each video is named after its recording.
+ *   --list FILE     Also render every recording listed in FILE, one per line
+ *   --workers N     How many recordings to render at once (default: one per
+ *                   CPU)
+ *   --width W       Video width in pixels (default: 1280)
+ *   --height H      Video height in pixels (default: 720)
+ *   --ffmpeg PATH   The ffmpeg binary to use (default: ffmpeg)
+ *
+ * Recordings streamed to disk with GUIRecording::streamToFile() are in the
+ * same format, so they can be rendered directly.
+ */
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+const { spawn } = require("child_process");
+const puppeteer = require("puppeteer");
+
+const PAGE_PATH = path.join(__dirname, "dist", "headless", "index.html");
+
+function parseArgs(argv) {
+  const options = {
+    out: ".",
+    workers: os.cpus().length,
+    width: 1280,
+    height: 720,
+    ffmpeg: "ffmpeg",
+    recordings: [],
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    if (arg === "--out") options.out = argv[++i];
+    else if (arg === "--workers") options.workers = parseInt(argv[++i]);
+    else if (arg === "--width") options.width = parseInt(argv[++i]);
+    else if (arg === "--height") options.height = parseInt(argv[++i]);
+    else if (arg === "--ffmpeg") options.ffmpeg = argv[++i];
+    else if (arg === "--list") {
+      fs.readFileSync(argv[++i], "utf8")
+        .split("\n")
+        .map((line) => line.trim())
+        .filter((line) => line.length > 0)
+        .forEach((line) => options.recordings.push(line));
+    }
+    else options.recordings.push(arg);
+  }
+  return options;
+}
+
+/**
+ * This renders a single recording to `outputPath`, on a page that's already
+ * loaded the headless viewer.
+ */
+async function renderRecording(page, recordingPath, outputPath, options) {
+  const base64 = fs.readFileSync(recordingPath).toString("base64");
+  const numFrames = await page.evaluate(
+    (bytes) => window.nimbleHeadless.setRecording(bytes),
+    base64
+  );
+  if (numFrames === 0) {
+    throw new Error("the recording has no frames");
+  }
+
+  // The framerate gets set by a command on the first frame, so we need to
+  // render that before we can start the encoder
+  let png = await page.evaluate(() => window.nimbleHeadless.renderFrame(0));
+  const fps = await page.evaluate(() =>
+    window.nimbleHeadless.getFramesPerSecond()
+  );
+
+  const ffmpeg = spawn(
+    options.ffmpeg,
+    [
+      "-y",
+      "-loglevel", "error",
+      "-f", "image2pipe",
+      "-framerate", String(fps),
+      "-c:v", "png",
+      "-i", "-",
+      // x264 needs even dimensions
+      "-vf", "pad=ceil(iw/2)*2:ceil(ih/2)*2",
+      "-c:v", "libx264",
+      "-pix_fmt", "yuv420p",
+      outputPath,
+    ],
+    { stdio: ["pipe", "inherit", "inherit"] }
+  );
+  const finished = new Promise((resolve, reject) => {
+    ffmpeg.on("error", reject);
+    ffmpeg.on("close", (code) => {
+      if (code === 0) resolve();
+      else reject(new Error("ffmpeg exited with code " + code));
+    });
+  });
+  // If ffmpeg dies, the close handler above reports it
+  ffmpeg.stdin.on("error", () => {});
+
+  const writeFrame = async (dataUrl) => {
+    const bytes = Buffer.from(dataUrl.slice(dataUrl.indexOf(",") + 1), "base64");
+    if (!ffmpeg.stdin.write(bytes)) {
+      await new Promise((resolve) => ffmpeg.stdin.once("drain", resolve));
+    }
+  };
+
+  await writeFrame(png);
+  for (let i = 1; i < numFrames; i++) {
+    png = await page.evaluate(
+      (frame) => window.nimbleHeadless.renderFrame(frame),
+      i
+    );
+    await writeFrame(png);
+  }
+  ffmpeg.stdin.end();
+  await finished;
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  if (options.recordings.length === 0) {
+    console.error("Usage: node render_videos.js [options] recording1.bin ...");
+    process.exit(1);
+  }
+  if (!fs.existsSync(PAGE_PATH)) {
+    console.error(
+      "Couldn't find " + PAGE_PATH + ". Run `npm run build-headless` first."
+    );
+    process.exit(1);
+  }
+  fs.mkdirSync(options.out, { recursive: true });
+
+  const queue = options.recordings.slice();
+  const total = queue.length;
+  let done = 0;
+  let failures = 0;
+
+  const worker = async () => {
+    // Each worker gets its own browser, since tabs in one browser all share a
+    // single GPU process, which would serialize the rendering
+    const browser = await puppeteer.launch({
+      headless: true,
+      args: ["--use-gl=swiftshader", "--enable-webgl", "--ignore-gpu-blocklist"],
+    });
+    try {
+      const page = await browser.newPage();
+      await page.setViewport({ width: options.width, height: options.height });
+      await page.goto("file://" + PAGE_PATH);
+      await page.waitForFunction(() => window.nimbleHeadless != null);
+
+      while (queue.length > 0) {
+        const recordingPath = queue.shift();
+        const name = path.basename(recordingPath, path.extname(recordingPath));
+        const outputPath = path.join(options.out, name + ".mp4");
+        try {
+          await renderRecording(page, recordingPath, outputPath, options);
+          done++;
+          console.log("[" + (done + failures) + "/" + total + "] " + outputPath);
+        } catch (e) {
+          failures++;
+          console.error(
+            "[" + (done + failures) + "/" + total + "] Failed to render " +
+              recordingPath + ": " + e.message
+          );
+        }
+      }
+    } finally {
+      await browser.close();
+    }
+  };
+
+  const numWorkers = Math.max(1, Math.min(options.workers, total));
+  await Promise.all(Array.from({ length: numWorkers }, worker));
+
+  console.log("Rendered " + done + " videos, " + failures + " failed.");
+  process.exit(failures > 0 ? 1 : 0);
+}
+
+main();
@@ -0,0 +1,100 @@
+import NimbleView from "./NimbleView";
+import {dart} from './proto/GUI';
+
+/**
+ * This is a stripped down version of NimbleStandalone, with no playback
+ * controls or loading bars, for rendering recordings frame by frame without a
+ * person watching. It's driven by `render_videos.js`, which steps it through
+ * every frame in order and grabs the canvas after each one.
+ */
+class NimbleHeadless {
+  view: NimbleView;
+  rawBytes: Uint8Array;
+  framePointers: number[];
+  lastFrame: number;
+  msPerFrame: number;
+
+  constructor(container: HTMLElement) {
+    this.view = new NimbleView(container, true);
+    this.rawBytes = new Uint8Array(0);
+    this.framePointers = [];
+    this.lastFrame = -1;
+    this.msPerFrame = 20.0;
+  }
+
+  /**
+   * This replaces the recording we're rendering, and clears out whatever was
+   * in the scene from the last one.
+   *
+   * @param base64 The recording file, as written by GUIRecording, in base64
+   * @returns The number of frames in the recording
+   */
+  setRecording = (base64: string) => {
+    const binary = atob(base64);
+    this.rawBytes = new Uint8Array(binary.length);
+    for (let i = 0; i < binary.length; i++) {
+      this.rawBytes[i] = binary.charCodeAt(i);
+    }
+
+    this.framePointers = [];
+    let cursor = 0;
+    const sizes = new DataView(this.rawBytes.buffer);
+    while (cursor + 4 <= this.rawBytes.length) {
+      this.framePointers.push(cursor);
+      cursor += 4 + sizes.getUint32(cursor, true);
+    }
+
+    this.view.clear();
+    this.lastFrame = -1;
+    this.msPerFrame = 20.0;
+    return this.framePointers.length;
+  };
+
+  getRecordingFrame = (index: number) => {
+    const cursor: number = this.framePointers[index];
+    const size = new DataView(this.rawBytes.buffer).getUint32(cursor, true);
+    return dart.proto.CommandList.deserialize(
+      this.rawBytes.buffer.slice(cursor + 4, cursor + 4 + size)
+    );
+  };
+
+  handleCommand = (command: dart.proto.Command) => {
+    if (command.set_frames_per_second) {
+      this.msPerFrame = 1000.0 / command.set_frames_per_second.framesPerSecond;
+    }
+    else {
+      this.view.handleCommand(command);
+    }
+  };
+
+  /**
+   * This plays every command up to and including `frame`, renders the scene,
+   * and returns the canvas as a PNG data URL. Unlike NimbleStandalone, this
+   * never skips frames, so the result doesn't depend on timing.
+   */
+  renderFrame = (frame: number) => {
+    if (frame < this.lastFrame) {
+      this.view.clear();
+      this.lastFrame = -1;
+    }
+    for (let i = this.lastFrame + 1; i <= frame; i++) {
+      this.getRecordingFrame(i).command.forEach(this.handleCommand);
+    }
+    this.lastFrame = frame;
+
+    this.view.render();
+    // This needs to happen in the same task as the render, before the browser
+    // gets a chance to clear the drawing buffer
+    return this.view.view.renderer.domElement.toDataURL("image/png");
+  };
+
+  /**
+   * This returns the framerate the recording asked for, which is only known
+   * once the frame setting it has been rendered
+   */
+  getFramesPerSecond = () => {
+    return 1000.0 / this.msPerFrame;
+  };
+}
+
+export default NimbleHeadless;
@@ -5,10 +5,22 @@ class DARTRemote {
   url: string;
   view: NimbleView;
   socket: WebSocket | null;
+  // Binary frames can be deflated, and inflating is async, so we chain every
+  // incoming message on this promise to handle them in the order they arrived
+  messageQueue: Promise<void>;
+  // The last quantized values received for each object, for decoding
+  // SetObjectTransforms deltas. We ignore deltas until we've seen a keyframe.
+  lastPositions: Map<number, number[]>;
+  lastRotations: Map<number, number[]>;
+  seenTransformKeyframe: boolean;
 
   constructor(url: string, view: NimbleView) {
     this.url = url;
     this.view = view;
+    this.messageQueue = Promise.resolve();
+    this.lastPositions = new Map();
+    this.lastRotations = new Map();
+    this.seenTransformKeyframe = false;
 
     this.trySocket();
 
@@ -96,17 +108,73 @@ class DARTRemote {
         },
         command.slider.layer
       );
+    }
+    else if (command.set_object_transforms != null) {
+      this.handleTransforms(command.set_object_transforms);
     } else {
       // Otherwise, the command doesn't require any interactive callbacks, so NimbleView can handle it directly.
       this.view.handleCommand(command);
     }
   };
 
+  /**
+   * This decodes a batch of quantized, delta encoded transforms, and applies
+   * them to the view. This has to see every batch in order since the last
+   * keyframe, which the server guarantees for a live socket.
+   */
+  handleTransforms = (transforms: dart.proto.SetObjectTransforms) => {
+    if (transforms.keyframe) {
+      this.lastPositions.clear();
+      this.lastRotations.clear();
+      this.seenTransformKeyframe = true;
+    }
+    if (!this.seenTransformKeyframe) {
+      return;
+    }
+
+    const decode = (keys: number[], values: number[], precision: number, last: Map<number, number[]>, apply: (key: number, value: number[]) => void) => {
+      let key = 0;
+      for (let i = 0; i < keys.length; i++) {
+        key += keys[i];
+        let quantized = last.get(key);
+        if (quantized == null) {
+          quantized = [0, 0, 0];
+          last.set(key, quantized);
+        }
+        for (let j = 0; j < 3; j++) {
+          quantized[j] += values[i * 3 + j];
+        }
+        apply(key, [quantized[0] * precision, quantized[1] * precision, quantized[2] * precision]);
+      }
+    };
+    decode(transforms.position_key, transforms.position, transforms.position_precision, this.lastPositions, this.view.setObjectPos);
+    decode(transforms.rotation_key, transforms.rotation, transforms.rotation_precision, this.lastRotations, this.view.setObjectRotation);
+  };
+
+  /**
+   * This reads a CommandList out of a websocket message. Text messages are
+   * base64, and binary ones start with a header byte, which is 1 if the rest
+   * is deflated.
+   */
+  decodeMessage = (data: string | ArrayBuffer): Promise<dart.proto.CommandList> => {
+    if (typeof data === "string") {
+      return Promise.resolve(dart.proto.CommandList.deserialize(data as any));
+    }
+    const bytes = new Uint8Array(data);
+    const body = bytes.subarray(1);
+    if (bytes[0] === 1) {
+      const stream = new Blob([body]).stream().pipeThrough(new (window as any).DecompressionStream("deflate"));
+      return new Response(stream).arrayBuffer().then((inflated: ArrayBuffer) => dart.proto.CommandList.deserialize(new Uint8Array(inflated)));
+    }
+    return Promise.resolve(dart.proto.CommandList.deserialize(body));
+  };
+
   /**
    * This attempts to connect a socket to the backend.
    */
   trySocket = () => {
     this.socket = new WebSocket(this.url);
+    this.socket.binaryType = "arraybuffer";
 
     // Connection opened
     this.socket.addEventListener("open", (event) => {
@@ -114,20 +182,21 @@ class DARTRemote {
       // Clear the view on a reconnect, the socket will broadcast us new data
       this.view.setConnected(true);
       this.view.clear();
+      // The server will send a keyframe before any more deltas
+      this.seenTransformKeyframe = false;
     });
 
     // Listen for messages
     this.socket.addEventListener("message", (event) => {
-      try {
-        const list: dart.proto.CommandList = dart.proto.CommandList.deserialize(event.data);
+      this.messageQueue = this.messageQueue.then(() => this.decodeMessage(event.data)).then((list: dart.proto.CommandList) => {
         list.command.forEach(this.handleCommand);
         this.view.render();
-      } catch (e) {
+      }).catch((e) => {
         console.error(
           "Something went wrong on command:\n\n" + event.data + "\n\n",
           e
         );
-      }
+      });
     });
 
     this.socket.addEventListener("close", () => {
@@ -34,6 +34,161 @@ type Button = {
   label: string;
 };
 
+type MeshAsset = {
+  vertices: number[][];
+  vertexNormals: number[][];
+  faces: number[][];
+  uvs: number[][];
+};
+
+/**
+ * This unpacks the flat arrays we get over the wire into per-vertex arrays
+ */
+function decodeMeshGeometry(
+  vertex: number[],
+  vertexNormal: number[],
+  face: number[],
+  uv: number[]
+): MeshAsset {
+  const vertices: number[][] = [];
+  const vertexNormals: number[][] = [];
+  for (let i = 0; i < vertex.length; i++) {
+    if (i % 3 == 0) {
+      vertices.push([]);
+      vertexNormals.push([]);
+    }
+    vertices[vertices.length-1].push(vertex[i]);
+    vertexNormals[vertexNormals.length-1].push(vertexNormal[i]);
+  }
+  const faces: number[][] = [];
+  for (let i = 0; i < face.length; i++) {
+    if (i % 3 == 0) {
+      faces.push([]);
+    }
+    faces[faces.length-1].push(face[i]);
+  }
+  const uvs: number[][] = [];
+  for (let i = 0; i < uv.length; i++) {
+    if (i % 2 == 0) {
+      uvs.push([]);
+    }
+    uvs[uvs.length-1].push(uv[i]);
+  }
+  return { vertices, vertexNormals, faces, uvs };
+}
+
+/**
+ * This builds renderable geometry out of per-vertex arrays, in scene units
+ */
+function createMeshGeometry(
+  vertices: number[][],
+  vertexNormals: number[][],
+  faces: number[][],
+  uv: number[][]
+): THREE.BufferGeometry {
+  const meshPoints = [];
+  const rawUVs = [];
+  const rawNormals = [];
+
+  for (let i = 0; i < faces.length; i++) {
+    for (let j = 0; j < 3; j++) {
+      let vertexIndex = faces[i][j];
+      meshPoints.push(
+        new THREE.Vector3(
+          vertices[vertexIndex][0] * SCALE_FACTOR,
+          vertices[vertexIndex][1] * SCALE_FACTOR,
+          vertices[vertexIndex][2] * SCALE_FACTOR
+        )
+      );
+      if (uv != null && uv.length > vertexIndex) {
+        rawUVs.push(uv[vertexIndex][0]);
+        rawUVs.push(uv[vertexIndex][1]);
+      }
+      if (vertexNormals != null && vertexNormals.length > vertexIndex) {
+        rawNormals.push(vertexNormals[vertexIndex][0]);
+        rawNormals.push(vertexNormals[vertexIndex][1]);
+        rawNormals.push(vertexNormals[vertexIndex][2]);
+      }
+    }
+  }
+
+  const meshGeometry = new THREE.BufferGeometry().setFromPoints(meshPoints);
+  if (rawUVs.length > 0) {
+    meshGeometry.setAttribute(
+      "uv",
+      new THREE.BufferAttribute(new Float32Array(rawUVs), 2)
+    );
+  }
+  if (rawNormals.length > 0) {
+    meshGeometry.setAttribute(
+      "normal",
+      new THREE.BufferAttribute(new Float32Array(rawNormals), 3)
+    );
+  } else {
+    meshGeometry.computeVertexNormals();
+  }
+  meshGeometry.computeBoundingBox();
+  return meshGeometry;
+}
+
+/**
+ * This builds a capsule along the Z axis, in scene units
+ */
+function createCapsuleGeometry(radius: number, height: number): THREE.BufferGeometry {
+  const NUM_SPHERE_SEGMENTS = 18;
+  const geometry = new CapsuleBufferGeometry(
+    radius * SCALE_FACTOR,
+    radius * SCALE_FACTOR,
+    height * SCALE_FACTOR,
+    NUM_SPHERE_SEGMENTS,
+    1,
+    NUM_SPHERE_SEGMENTS,
+    NUM_SPHERE_SEGMENTS
+  );
+
+  // By default, this extends the capsule along the Y axis, we want the Z axis instead
+  const vertexArray: Float32Array = geometry.getAttribute("position")
+    .array as Float32Array;
+  for (var i = 0; i < vertexArray.length / 3; i++) {
+    const index = i * 3;
+    const swapY = vertexArray[index + 1];
+    vertexArray[index + 1] = -vertexArray[index + 2];
+    vertexArray[index + 2] = swapY;
+  }
+  geometry.computeVertexNormals();
+  return geometry;
+}
+
+/**
+ * A skeleton template is drawn as one InstancedMesh per shape, per distinct
+ * color override, so every copy of the skeleton with the same colors is a
+ * single draw call per shape.
+ */
+type SkeletonInstanceBatch = {
+  meshes: THREE.InstancedMesh[];
+  materials: THREE.MeshLambertMaterial[];
+  // The instance key drawn in each slot of the meshes
+  instanceKeys: number[];
+};
+
+type SkeletonTemplate = {
+  group: THREE.Group;
+  geometries: THREE.BufferGeometry[];
+  // Geometries we made for this template, as opposed to shared ones
+  ownedGeometries: THREE.BufferGeometry[];
+  scales: THREE.Vector3[];
+  colors: number[][];
+  castShadows: boolean[];
+  receiveShadows: boolean[];
+  batches: Map<string, SkeletonInstanceBatch>;
+};
+
+type SkeletonInstance = {
+  templateKey: number;
+  batchKey: string;
+  slot: number;
+};
+
 class Layer {
   view: DARTView;
   shown: boolean;
@@ -131,6 +286,12 @@ class DARTView {
   objectColors: Map<number, number[]>;
   keys: Map<THREE.Object3D, number>;
   textures: Map<number, THREE.Texture>;
+  // These are keyed by content hash, and survive clearing the scene, so assets
+  // shared between many objects (or sent again later) only get decoded once
+  texturesByHash: Map<string, THREE.Texture>;
+  meshAssets: Map<string, MeshAsset>;
+  skeletonTemplates: Map<number, SkeletonTemplate>;
+  skeletonInstances: Map<number, SkeletonInstance>;
   disposeHandlers: Map<number, () => void>;
   objectType: Map<number, string>;
 
@@ -169,6 +330,10 @@ class DARTView {
     this.keys = new Map();
     this.disposeHandlers = new Map();
     this.textures = new Map();
+    this.texturesByHash = new Map();
+    this.meshAssets = new Map();
+    this.skeletonTemplates = new Map();
+    this.skeletonInstances = new Map();
     this.uiElements = new Map();
     this.objectType = new Map();
     this.dragListeners = [];
@@ -458,31 +623,55 @@ class DARTView {
         command.line.layer
       );
     }
+    else if (command.mesh_asset != null) {
+      this.meshAssets.set(
+        command.mesh_asset.hash,
+        decodeMeshGeometry(
+          command.mesh_asset.vertex,
+          command.mesh_asset.vertex_normal,
+          command.mesh_asset.face,
+          command.mesh_asset.uv
+        )
+      );
+    }
+    else if (command.skeleton_template != null) {
+      this.createSkeletonTemplate(
+        command.skeleton_template.key,
+        command.skeleton_template.shape,
+        command.skeleton_template.layer
+      );
+    }
+    else if (command.skeleton_instance != null) {
+      this.setSkeletonInstance(
+        command.skeleton_instance.key,
+        command.skeleton_instance.template_key,
+        command.skeleton_instance.transform,
+        command.skeleton_instance.color
+      );
+    }
     else if (command.mesh != null) {
-      const vertices: number[][] = [];
-      const vertexNormals: number[][] = [];
-      for (let i = 0; i < command.mesh.vertex.length; i++) {
-        if (i % 3 == 0) {
-          vertices.push([]);
-          vertexNormals.push([]);
+      // Newer servers send geometry once as a mesh_asset, and refer to it by
+      // hash. Older ones send it inline with every mesh.
+      let geometry: MeshAsset | undefined = undefined;
+      if (command.mesh.asset != null && command.mesh.asset.length > 0) {
+        geometry = this.meshAssets.get(command.mesh.asset);
+        if (geometry == null) {
+          console.error("Got a mesh referring to unknown asset " + command.mesh.asset);
+          return;
         }
-        vertices[vertices.length-1].push(command.mesh.vertex[i]);
-        vertexNormals[vertexNormals.length-1].push(command.mesh.vertex_normal[i]);
       }
-      const faces: number[][] = [];
-      for (let i = 0; i < command.mesh.face.length; i++) {
-        if (i % 3 == 0) {
-          faces.push([]);
-        }
-        faces[faces.length-1].push(command.mesh.face[i]);
-      }
-      const uvs: number[][] = [];
-      for (let i = 0; i < command.mesh.uv.length; i++) {
-        if (i % 2 == 0) {
-          uvs.push([]);
-        }
-        uvs[uvs.length-1].push(command.mesh.uv[i]);
+      else {
+        geometry = decodeMeshGeometry(
+          command.mesh.vertex,
+          command.mesh.vertex_normal,
+          command.mesh.face,
+          command.mesh.uv
+        );
       }
+      const vertices = geometry.vertices;
+      const vertexNormals = geometry.vertexNormals;
+      const faces = geometry.faces;
+      const uvs = geometry.uvs;
       const texture_starts: {
         key: number,
         start: number
@@ -515,7 +704,7 @@ class DARTView {
       );
     }
     else if (command.texture != null) {
-      this.createTexture(command.texture.key, command.texture.base64);
+      this.createTexture(command.texture.key, command.texture.base64, command.texture.hash);
     }
     else if (command.set_object_position != null) {
       const data = command.set_object_position.data;
@@ -603,6 +792,14 @@ class DARTView {
         command.set_rich_plot_data.plot_type as any
       );
     }
+    else if (command.append_rich_plot_data != null) {
+      this.appendRichPlotData(
+        command.append_rich_plot_data.key,
+        command.append_rich_plot_data.name,
+        command.append_rich_plot_data.xs,
+        command.append_rich_plot_data.ys
+      );
+    }
     else if (command.set_rich_plot_bounds != null) {
       const minX = command.set_rich_plot_bounds.bounds[0];
       const maxX = command.set_rich_plot_bounds.bounds[1];
@@ -864,27 +1061,7 @@ class DARTView {
       material.transparent = true;
       material.opacity = color[3];
     }
-    const NUM_SPHERE_SEGMENTS = 18;
-    const geometry = new CapsuleBufferGeometry(
-      radius * SCALE_FACTOR,
-      radius * SCALE_FACTOR,
-      height * SCALE_FACTOR,
-      NUM_SPHERE_SEGMENTS,
-      1,
-      NUM_SPHERE_SEGMENTS,
-      NUM_SPHERE_SEGMENTS
-    );
-
-    // By default, this extends the capsule along the Y axis, we want the Z axis instead
-    const vertexArray: Float32Array = geometry.getAttribute("position")
-      .array as Float32Array;
-    for (var i = 0; i < vertexArray.length / 3; i++) {
-      const index = i * 3;
-      const swapY = vertexArray[index + 1];
-      vertexArray[index + 1] = -vertexArray[index + 2];
-      vertexArray[index + 2] = swapY;
-    }
-    geometry.computeVertexNormals();
+    const geometry = createCapsuleGeometry(radius, height);
 
     const mesh = new THREE.Mesh(geometry, material);
     mesh.position.x = pos[0] * SCALE_FACTOR;
@@ -899,7 +1076,7 @@ class DARTView {
     this.objects.set(key, mesh);
     this.disposeHandlers.set(key, () => {
       material.dispose();
-      (geometry as any).dispose();
+      geometry.dispose();
     });
     this.keys.set(mesh, key);
 
@@ -993,10 +1170,22 @@ class DARTView {
   /**
    * This loads a texture from a Base64 string encoding of it
    */
-  createTexture = (key: number, base64: string) => {
-    if (!this.textures.has(key)) {
-      this.textures.set(key, new THREE.TextureLoader().load(base64));
+  createTexture = (key: number, base64: string, hash?: string) => {
+    if (this.textures.has(key)) return;
+    // An empty base64 means the server already sent us this texture under
+    // another key
+    let texture = (hash != null && hash.length > 0) ? this.texturesByHash.get(hash) : undefined;
+    if (texture == null) {
+      if (base64 == null || base64.length == 0) {
+        console.error("Got a texture referring to unknown hash " + hash);
+        return;
+      }
+      texture = new THREE.TextureLoader().load(base64);
+      if (hash != null && hash.length > 0) {
+        this.texturesByHash.set(hash, texture);
+      }
     }
+    this.textures.set(key, texture);
   };
 
   /**
@@ -1052,48 +1241,7 @@ class DARTView {
         meshMaterial.opacity = color[3];
       }
 
-      const meshPoints = [];
-      const rawUVs = [];
-      const rawNormals = [];
-
-      for (let i = 0; i < faces.length; i++) {
-        for (let j = 0; j < 3; j++) {
-          let vertexIndex = faces[i][j];
-          meshPoints.push(
-            new THREE.Vector3(
-              vertices[vertexIndex][0] * SCALE_FACTOR,
-              vertices[vertexIndex][1] * SCALE_FACTOR,
-              vertices[vertexIndex][2] * SCALE_FACTOR
-            )
-          );
-          if (uv != null && uv.length > vertexIndex) {
-            rawUVs.push(uv[vertexIndex][0]);
-            rawUVs.push(uv[vertexIndex][1]);
-          }
-          if (vertexNormals != null && vertexNormals.length > vertexIndex) {
-            rawNormals.push(vertexNormals[vertexIndex][0]);
-            rawNormals.push(vertexNormals[vertexIndex][1]);
-            rawNormals.push(vertexNormals[vertexIndex][2]);
-          }
-        }
-      }
-
-      const meshGeometry = new THREE.BufferGeometry().setFromPoints(meshPoints);
-      if (rawUVs.length > 0) {
-        meshGeometry.setAttribute(
-          "uv",
-          new THREE.BufferAttribute(new Float32Array(rawUVs), 2)
-        );
-      }
-      if (rawNormals.length > 0) {
-        meshGeometry.setAttribute(
-          "normal",
-          new THREE.BufferAttribute(new Float32Array(rawNormals), 3)
-        );
-      } else {
-        meshGeometry.computeVertexNormals();
-      }
-      meshGeometry.computeBoundingBox();
+      const meshGeometry = createMeshGeometry(vertices, vertexNormals, faces, uv);
 
       const mesh = new THREE.Mesh(meshGeometry, meshMaterial);
       mesh.position.x = pos[0] * SCALE_FACTOR;
@@ -1121,6 +1269,215 @@ class DARTView {
     }
   };
 
+  /**
+   * This registers the shapes of a skeleton, which copies placed with
+   * setSkeletonInstance() then share
+   *
+   * Must call render() to see results!
+   */
+  createSkeletonTemplate = (
+    key: number,
+    shapes: dart.proto.SkeletonTemplateShape[],
+    layer: number | undefined
+  ) => {
+    if (this.objects.has(key)) {
+      this.deleteObject(key);
+    }
+    const template: SkeletonTemplate = {
+      group: new THREE.Group(),
+      geometries: [],
+      ownedGeometries: [],
+      scales: [],
+      colors: [],
+      castShadows: [],
+      receiveShadows: [],
+      batches: new Map(),
+    };
+    for (let i = 0; i < shapes.length; i++) {
+      const shape = shapes[i];
+      const size = shape.size;
+      let geometry: THREE.BufferGeometry | undefined = undefined;
+      let scale = new THREE.Vector3(1, 1, 1);
+      if (shape.type == 0) {
+        geometry = new THREE.BoxBufferGeometry(SCALE_FACTOR, SCALE_FACTOR, SCALE_FACTOR);
+        template.ownedGeometries.push(geometry);
+        scale.set(size[0], size[1], size[2]);
+      }
+      else if (shape.type == 1) {
+        geometry = this.sphereGeometry;
+        scale.set(size[0], size[0], size[0]);
+      }
+      else if (shape.type == 2) {
+        geometry = createCapsuleGeometry(size[0], size[1]);
+        template.ownedGeometries.push(geometry);
+      }
+      else {
+        const asset = this.meshAssets.get(shape.asset);
+        if (asset == null) {
+          console.error("Got a skeleton template referring to unknown asset " + shape.asset);
+          geometry = new THREE.BufferGeometry();
+        }
+        else {
+          geometry = createMeshGeometry(asset.vertices, asset.vertexNormals, asset.faces, asset.uvs);
+        }
+        template.ownedGeometries.push(geometry);
+        scale.set(size[0], size[1], size[2]);
+      }
+      template.geometries.push(geometry);
+      template.scales.push(scale);
+      template.colors.push(shape.color);
+      template.castShadows.push(shape.cast_shadows === true);
+      template.receiveShadows.push(shape.receive_shadows === true);
+    }
+
+    this.skeletonTemplates.set(key, template);
+    this.objects.set(key, template.group);
+    this.disposeHandlers.set(key, () => {
+      template.batches.forEach((batch) => {
+        batch.materials.forEach((material) => material.dispose());
+        batch.instanceKeys.forEach((instanceKey) => this.skeletonInstances.delete(instanceKey));
+      });
+      template.ownedGeometries.forEach((geometry) => geometry.dispose());
+      this.skeletonTemplates.delete(key);
+    });
+    this.view.add(key, template.group);
+
+    if (layer != null && this.layers.has(layer)) {
+      this.layers.get(layer).addObject(key);
+    }
+  };
+
+  /**
+   * This creates or moves one copy of a skeleton template. `transform` holds
+   * the position and euler angles of each of the template's shapes, in order.
+   *
+   * Must call render() to see results!
+   */
+  setSkeletonInstance = (
+    key: number,
+    templateKey: number,
+    transform: number[],
+    color: number[]
+  ) => {
+    const template = this.skeletonTemplates.get(templateKey);
+    if (template == null) {
+      console.error("Got a skeleton instance referring to unknown template " + templateKey);
+      return;
+    }
+    const batchKey = color != null && color.length >= 4 ? color.join(",") : "";
+
+    let instance = this.skeletonInstances.get(key);
+    if (instance != null && (instance.templateKey != templateKey || instance.batchKey != batchKey)) {
+      this.deleteSkeletonInstance(key);
+      instance = undefined;
+    }
+
+    let batch = template.batches.get(batchKey);
+    if (batch == null) {
+      batch = { meshes: [], materials: [], instanceKeys: [] };
+      for (let i = 0; i < template.geometries.length; i++) {
+        const shapeColor = batchKey == "" ? template.colors[i] : color;
+        const material = new THREE.MeshLambertMaterial({
+          color: new THREE.Color(shapeColor[0], shapeColor[1], shapeColor[2]),
+        });
+        if (shapeColor.length > 3 && shapeColor[3] < 1.0) {
+          material.transparent = true;
+          material.opacity = shapeColor[3];
+        }
+        batch.materials.push(material);
+        batch.meshes.push(this._createInstancedMesh(template, i, material, 8));
+      }
+      template.batches.set(batchKey, batch);
+    }
+
+    if (instance == null) {
+      const slot = batch.instanceKeys.length;
+      batch.instanceKeys.push(key);
+      instance = { templateKey, batchKey, slot };
+      this.skeletonInstances.set(key, instance);
+      // Grow the meshes if we're out of room
+      for (let i = 0; i < batch.meshes.length; i++) {
+        let mesh = batch.meshes[i];
+        if (slot >= mesh.instanceMatrix.count) {
+          const bigger = this._createInstancedMesh(template, i, batch.materials[i], mesh.instanceMatrix.count * 2);
+          (bigger.instanceMatrix.array as Float32Array).set(mesh.instanceMatrix.array as Float32Array);
+          template.group.remove(mesh);
+          batch.meshes[i] = bigger;
+          mesh = bigger;
+        }
+        mesh.count = batch.instanceKeys.length;
+      }
+    }
+
+    const matrix = new THREE.Matrix4();
+    const position = new THREE.Vector3();
+    const quaternion = new THREE.Quaternion();
+    const euler = new THREE.Euler();
+    for (let i = 0; i < batch.meshes.length; i++) {
+      position.set(
+        transform[i * 6] * SCALE_FACTOR,
+        transform[i * 6 + 1] * SCALE_FACTOR,
+        transform[i * 6 + 2] * SCALE_FACTOR
+      );
+      euler.set(transform[i * 6 + 3], transform[i * 6 + 4], transform[i * 6 + 5]);
+      quaternion.setFromEuler(euler);
+      matrix.compose(position, quaternion, template.scales[i]);
+      batch.meshes[i].setMatrixAt(instance.slot, matrix);
+      batch.meshes[i].instanceMatrix.needsUpdate = true;
+    }
+  };
+
+  /**
+   * This removes one copy of a skeleton template, by moving the last copy in
+   * its batch into its slot
+   *
+   * Must call render() to see results!
+   */
+  deleteSkeletonInstance = (key: number) => {
+    const instance = this.skeletonInstances.get(key);
+    if (instance == null) return;
+    this.skeletonInstances.delete(key);
+    const template = this.skeletonTemplates.get(instance.templateKey);
+    if (template == null) return;
+    const batch = template.batches.get(instance.batchKey);
+    if (batch == null) return;
+
+    const last = batch.instanceKeys.length - 1;
+    const matrix = new THREE.Matrix4();
+    for (let i = 0; i < batch.meshes.length; i++) {
+      const mesh = batch.meshes[i];
+      if (instance.slot != last) {
+        mesh.getMatrixAt(last, matrix);
+        mesh.setMatrixAt(instance.slot, matrix);
+        mesh.instanceMatrix.needsUpdate = true;
+      }
+      mesh.count = last;
+    }
+    if (instance.slot != last) {
+      const movedKey = batch.instanceKeys[last];
+      batch.instanceKeys[instance.slot] = movedKey;
+      this.skeletonInstances.get(movedKey).slot = instance.slot;
+    }
+    batch.instanceKeys.pop();
+  };
+
+  _createInstancedMesh = (
+    template: SkeletonTemplate,
+    shapeIndex: number,
+    material: THREE.MeshLambertMaterial,
+    capacity: number
+  ) => {
+    const mesh = new THREE.InstancedMesh(template.geometries[shapeIndex], material, capacity);
+    mesh.instanceMatrix.setUsage(THREE.DynamicDrawUsage);
+    mesh.count = 0;
+    // The geometry's bounds don't account for where the instances are
+    mesh.frustumCulled = false;
+    mesh.castShadow = template.castShadows[shapeIndex];
+    mesh.receiveShadow = template.receiveShadows[shapeIndex];
+    template.group.add(mesh);
+    return mesh;
+  };
+
   /**
    * Moves an object.
    *
@@ -1218,9 +1575,13 @@ class DARTView {
   /**
    * Removes an object from the scene, if it exists.
    *
-   * @param key The key of the object (box, sphere, line, mesh) to be removed
+   * @param key The key of the object (box, sphere, line, mesh, skeleton template or instance) to be removed
    */
   deleteObject = (key: number) => {
+    if (this.skeletonInstances.has(key)) {
+      this.deleteSkeletonInstance(key);
+      return;
+    }
     const obj = this.objects.get(key);
     if (obj) {
       this.view.remove(key);
@@ -1447,6 +1808,19 @@ class DARTView {
     }
   };
 
+  appendRichPlotData = (
+    key: number,
+    dataName: string,
+    xs: number[],
+    ys: number[]
+  ) => {
+    const element = this.uiElements.get(key);
+    if (element != null && element.type === 'rich_plot') {
+      const richPlot: RichPlot = element as RichPlot;
+      richPlot.appendLineData(dataName, xs, ys);
+    }
+  };
+
   /**
    * This sets the bounds for a rich plot. If there is no rich plot at "key", then this is a no-op.
    * 
@@ -0,0 +1,79 @@
+/**
+ * One shape's world transform (and maybe color) out of a binary world
+ * snapshot. Shapes come in the same order as in World::toJson(): every body,
+ * then each of its visual shapes.
+ */
+export type ShapeTransform = {
+  pos: number[];
+  angle: number[];
+  color?: number[];
+};
+
+const MAGIC = "NWSB";
+const VERSION = 1;
+const FLAG_QUANTIZED = 1;
+const FLAG_COLORS = 2;
+const INT16_MAX = 32767;
+
+/**
+ * This decodes the output of World::positionsToBinary(). See the comment on
+ * that method in World.cpp for the layout.
+ */
+export function decodeWorldSnapshot(data: ArrayBuffer): ShapeTransform[] {
+  const view = new DataView(data);
+  for (let i = 0; i < MAGIC.length; i++) {
+    if (view.getUint8(i) !== MAGIC.charCodeAt(i)) {
+      throw new Error("Not a binary world snapshot");
+    }
+  }
+  const version = view.getUint8(4);
+  if (version !== VERSION) {
+    throw new Error("Unsupported binary world snapshot version " + version);
+  }
+  const flags = view.getUint8(5);
+  const quantized = (flags & FLAG_QUANTIZED) !== 0;
+  const hasColors = (flags & FLAG_COLORS) !== 0;
+  const numShapes = view.getUint32(8, true);
+  let cursor = 12;
+  let precision = 0;
+  if (quantized) {
+    precision = view.getFloat32(cursor, true);
+    cursor += 4;
+  }
+
+  const shapes: ShapeTransform[] = new Array(numShapes);
+  for (let i = 0; i < numShapes; i++) {
+    const pos = [0, 0, 0];
+    const angle = [0, 0, 0];
+    if (quantized) {
+      for (let k = 0; k < 3; k++) {
+        pos[k] = view.getInt32(cursor, true) * precision;
+        cursor += 4;
+      }
+      for (let k = 0; k < 3; k++) {
+        angle[k] = (view.getInt16(cursor, true) * Math.PI) / INT16_MAX;
+        cursor += 2;
+      }
+    } else {
+      for (let k = 0; k < 3; k++) {
+        pos[k] = view.getFloat32(cursor, true);
+        cursor += 4;
+      }
+      for (let k = 0; k < 3; k++) {
+        angle[k] = view.getFloat32(cursor, true);
+        cursor += 4;
+      }
+    }
+    const shape: ShapeTransform = { pos, angle };
+    if (hasColors) {
+      shape.color = [
+        view.getUint8(cursor) / 255,
+        view.getUint8(cursor + 1) / 255,
+        view.getUint8(cursor + 2) / 255,
+      ];
+      cursor += 3;
+    }
+    shapes[i] = shape;
+  }
+  return shapes;
+}
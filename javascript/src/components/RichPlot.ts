@@ -215,6 +215,24 @@ class RichPlot {
     this.redraw();
   }
 
+  /**
+   * This adds points to the end of an existing line. Points for a line that doesn't exist yet are ignored.
+   * 
+   * @param name 
+   * @param xs 
+   * @param ys 
+   */
+  appendLineData = (
+    name: string,
+    xs: number[],
+    ys: number[]) => {
+    const line = this.lines.get(name);
+    if (line == null) return;
+    line.xs = line.xs.concat(xs);
+    line.ys = line.ys.concat(ys);
+    this.redraw();
+  }
+
   /**
    * This sets the bounds that the plot can operate in
    * 
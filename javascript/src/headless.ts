@@ -0,0 +1,11 @@
+import NimbleHeadless from './NimbleHeadless';
+
+// The canvas is sized to the window, so `render_videos.js` sets the video
+// resolution through the page's viewport
+const container = document.createElement("div");
+container.style.width = "100vw";
+container.style.height = "100vh";
+document.body.appendChild(container);
+document.body.style.margin = "0";
+
+(window as any).nimbleHeadless = new NimbleHeadless(container);
@@ -73,7 +73,7 @@ export namespace dart.proto {
         }
     }
     export class Command extends pb_1.Message {
-        #one_of_decls = [[31, 16, 1, 2, 9, 10, 11, 3, 4, 5, 6, 7, 8, 32, 33, 18, 12, 13, 14, 15, 29, 17, 30, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28]];
+        #one_of_decls = [[31, 16, 1, 2, 9, 10, 11, 3, 35, 36, 37, 4, 5, 6, 34, 7, 8, 32, 33, 18, 12, 13, 14, 15, 29, 17, 38, 30, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28]];
         constructor(data?: any[] | ({} & (({
             set_frames_per_second?: SetFramesPerSecond;
             clear_all?: never;
@@ -83,9 +83,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -97,6 +101,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -117,9 +122,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -131,6 +140,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -151,9 +161,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -165,6 +179,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -185,9 +200,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -199,6 +218,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -219,9 +239,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -233,6 +257,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -253,9 +278,13 @@ export namespace dart.proto {
             capsule?: CreateCapsule;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -267,6 +296,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -287,9 +317,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: CreateLine;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -301,6 +335,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -321,9 +356,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: CreateMesh;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -335,6 +374,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -355,9 +395,130 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: CreateMeshAsset;
+            skeleton_template?: never;
+            skeleton_instance?: never;
+            texture?: never;
+            set_object_position?: never;
+            set_object_rotation?: never;
+            set_object_transforms?: never;
+            set_object_color?: never;
+            set_object_scale?: never;
+            set_object_tooltip?: never;
+            delete_object_tooltip?: never;
+            enable_mouse_interaction?: never;
+            text?: never;
+            button?: never;
+            slider?: never;
+            plot?: never;
+            rich_plot?: never;
+            set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
+            set_rich_plot_bounds?: never;
+            set_ui_elem_pos?: never;
+            set_ui_elem_size?: never;
+            delete_ui_elem?: never;
+            delete_object?: never;
+            set_text_contents?: never;
+            set_button_label?: never;
+            set_slider_value?: never;
+            set_slider_min?: never;
+            set_slider_max?: never;
+            set_plot_data?: never;
+        } | {
+            set_frames_per_second?: never;
+            clear_all?: never;
+            layer?: never;
+            box?: never;
+            sphere?: never;
+            capsule?: never;
+            line?: never;
+            mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: CreateSkeletonTemplate;
+            skeleton_instance?: never;
+            texture?: never;
+            set_object_position?: never;
+            set_object_rotation?: never;
+            set_object_transforms?: never;
+            set_object_color?: never;
+            set_object_scale?: never;
+            set_object_tooltip?: never;
+            delete_object_tooltip?: never;
+            enable_mouse_interaction?: never;
+            text?: never;
+            button?: never;
+            slider?: never;
+            plot?: never;
+            rich_plot?: never;
+            set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
+            set_rich_plot_bounds?: never;
+            set_ui_elem_pos?: never;
+            set_ui_elem_size?: never;
+            delete_ui_elem?: never;
+            delete_object?: never;
+            set_text_contents?: never;
+            set_button_label?: never;
+            set_slider_value?: never;
+            set_slider_min?: never;
+            set_slider_max?: never;
+            set_plot_data?: never;
+        } | {
+            set_frames_per_second?: never;
+            clear_all?: never;
+            layer?: never;
+            box?: never;
+            sphere?: never;
+            capsule?: never;
+            line?: never;
+            mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: SetSkeletonInstance;
+            texture?: never;
+            set_object_position?: never;
+            set_object_rotation?: never;
+            set_object_transforms?: never;
+            set_object_color?: never;
+            set_object_scale?: never;
+            set_object_tooltip?: never;
+            delete_object_tooltip?: never;
+            enable_mouse_interaction?: never;
+            text?: never;
+            button?: never;
+            slider?: never;
+            plot?: never;
+            rich_plot?: never;
+            set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
+            set_rich_plot_bounds?: never;
+            set_ui_elem_pos?: never;
+            set_ui_elem_size?: never;
+            delete_ui_elem?: never;
+            delete_object?: never;
+            set_text_contents?: never;
+            set_button_label?: never;
+            set_slider_value?: never;
+            set_slider_min?: never;
+            set_slider_max?: never;
+            set_plot_data?: never;
+        } | {
+            set_frames_per_second?: never;
+            clear_all?: never;
+            layer?: never;
+            box?: never;
+            sphere?: never;
+            capsule?: never;
+            line?: never;
+            mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: CreateTexture;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -369,6 +530,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -389,9 +551,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: SetObjectPosition;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -403,6 +569,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -423,9 +590,52 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: SetObjectRotation;
+            set_object_transforms?: never;
+            set_object_color?: never;
+            set_object_scale?: never;
+            set_object_tooltip?: never;
+            delete_object_tooltip?: never;
+            enable_mouse_interaction?: never;
+            text?: never;
+            button?: never;
+            slider?: never;
+            plot?: never;
+            rich_plot?: never;
+            set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
+            set_rich_plot_bounds?: never;
+            set_ui_elem_pos?: never;
+            set_ui_elem_size?: never;
+            delete_ui_elem?: never;
+            delete_object?: never;
+            set_text_contents?: never;
+            set_button_label?: never;
+            set_slider_value?: never;
+            set_slider_min?: never;
+            set_slider_max?: never;
+            set_plot_data?: never;
+        } | {
+            set_frames_per_second?: never;
+            clear_all?: never;
+            layer?: never;
+            box?: never;
+            sphere?: never;
+            capsule?: never;
+            line?: never;
+            mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
+            texture?: never;
+            set_object_position?: never;
+            set_object_rotation?: never;
+            set_object_transforms?: SetObjectTransforms;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -437,6 +647,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -457,9 +668,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: SetObjectColor;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -471,6 +686,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -491,9 +707,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: SetObjectScale;
             set_object_tooltip?: never;
@@ -505,6 +725,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -525,9 +746,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: SetObjectTooltip;
@@ -539,6 +764,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -559,9 +785,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -573,6 +803,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -593,9 +824,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -607,6 +842,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -627,9 +863,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -641,6 +881,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -661,9 +902,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -675,6 +920,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -695,9 +941,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -709,6 +959,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -729,9 +980,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -743,6 +998,7 @@ export namespace dart.proto {
             plot?: CreatePlot;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -763,9 +1019,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -777,6 +1037,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: CreateRichPlot;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -797,9 +1058,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -811,6 +1076,46 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: SetRichPlotData;
+            append_rich_plot_data?: never;
+            set_rich_plot_bounds?: never;
+            set_ui_elem_pos?: never;
+            set_ui_elem_size?: never;
+            delete_ui_elem?: never;
+            delete_object?: never;
+            set_text_contents?: never;
+            set_button_label?: never;
+            set_slider_value?: never;
+            set_slider_min?: never;
+            set_slider_max?: never;
+            set_plot_data?: never;
+        } | {
+            set_frames_per_second?: never;
+            clear_all?: never;
+            layer?: never;
+            box?: never;
+            sphere?: never;
+            capsule?: never;
+            line?: never;
+            mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
+            texture?: never;
+            set_object_position?: never;
+            set_object_rotation?: never;
+            set_object_transforms?: never;
+            set_object_color?: never;
+            set_object_scale?: never;
+            set_object_tooltip?: never;
+            delete_object_tooltip?: never;
+            enable_mouse_interaction?: never;
+            text?: never;
+            button?: never;
+            slider?: never;
+            plot?: never;
+            rich_plot?: never;
+            set_rich_plot_data?: never;
+            append_rich_plot_data?: AppendRichPlotData;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -831,9 +1136,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -845,6 +1154,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: SetRichPlotBounds;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -865,9 +1175,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -879,6 +1193,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: SetUIElemPos;
             set_ui_elem_size?: never;
@@ -899,9 +1214,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -913,6 +1232,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: SetUIElemSize;
@@ -933,9 +1253,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -947,6 +1271,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -967,9 +1292,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -981,6 +1310,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -1001,9 +1331,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -1015,6 +1349,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -1035,9 +1370,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -1049,6 +1388,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -1069,9 +1409,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -1083,6 +1427,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -1103,9 +1448,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -1117,6 +1466,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -1137,9 +1487,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -1151,6 +1505,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -1171,9 +1526,13 @@ export namespace dart.proto {
             capsule?: never;
             line?: never;
             mesh?: never;
+            mesh_asset?: never;
+            skeleton_template?: never;
+            skeleton_instance?: never;
             texture?: never;
             set_object_position?: never;
             set_object_rotation?: never;
+            set_object_transforms?: never;
             set_object_color?: never;
             set_object_scale?: never;
             set_object_tooltip?: never;
@@ -1185,6 +1544,7 @@ export namespace dart.proto {
             plot?: never;
             rich_plot?: never;
             set_rich_plot_data?: never;
+            append_rich_plot_data?: never;
             set_rich_plot_bounds?: never;
             set_ui_elem_pos?: never;
             set_ui_elem_size?: never;
@@ -1224,6 +1584,15 @@ export namespace dart.proto {
                 if ("mesh" in data && data.mesh != undefined) {
                     this.mesh = data.mesh;
                 }
+                if ("mesh_asset" in data && data.mesh_asset != undefined) {
+                    this.mesh_asset = data.mesh_asset;
+                }
+                if ("skeleton_template" in data && data.skeleton_template != undefined) {
+                    this.skeleton_template = data.skeleton_template;
+                }
+                if ("skeleton_instance" in data && data.skeleton_instance != undefined) {
+                    this.skeleton_instance = data.skeleton_instance;
+                }
                 if ("texture" in data && data.texture != undefined) {
                     this.texture = data.texture;
                 }
@@ -1233,6 +1602,9 @@ export namespace dart.proto {
                 if ("set_object_rotation" in data && data.set_object_rotation != undefined) {
                     this.set_object_rotation = data.set_object_rotation;
                 }
+                if ("set_object_transforms" in data && data.set_object_transforms != undefined) {
+                    this.set_object_transforms = data.set_object_transforms;
+                }
                 if ("set_object_color" in data && data.set_object_color != undefined) {
                     this.set_object_color = data.set_object_color;
                 }
@@ -1266,6 +1638,9 @@ export namespace dart.proto {
                 if ("set_rich_plot_data" in data && data.set_rich_plot_data != undefined) {
                     this.set_rich_plot_data = data.set_rich_plot_data;
                 }
+                if ("append_rich_plot_data" in data && data.append_rich_plot_data != undefined) {
+                    this.append_rich_plot_data = data.append_rich_plot_data;
+                }
                 if ("set_rich_plot_bounds" in data && data.set_rich_plot_bounds != undefined) {
                     this.set_rich_plot_bounds = data.set_rich_plot_bounds;
                 }
@@ -1349,6 +1724,24 @@ export namespace dart.proto {
         set mesh(value: CreateMesh) {
             pb_1.Message.setOneofWrapperField(this, 3, this.#one_of_decls[0], value);
         }
+        get mesh_asset() {
+            return pb_1.Message.getWrapperField(this, CreateMeshAsset, 35) as CreateMeshAsset;
+        }
+        set mesh_asset(value: CreateMeshAsset) {
+            pb_1.Message.setOneofWrapperField(this, 35, this.#one_of_decls[0], value);
+        }
+        get skeleton_template() {
+            return pb_1.Message.getWrapperField(this, CreateSkeletonTemplate, 36) as CreateSkeletonTemplate;
+        }
+        set skeleton_template(value: CreateSkeletonTemplate) {
+            pb_1.Message.setOneofWrapperField(this, 36, this.#one_of_decls[0], value);
+        }
+        get skeleton_instance() {
+            return pb_1.Message.getWrapperField(this, SetSkeletonInstance, 37) as SetSkeletonInstance;
+        }
+        set skeleton_instance(value: SetSkeletonInstance) {
+            pb_1.Message.setOneofWrapperField(this, 37, this.#one_of_decls[0], value);
+        }
         get texture() {
             return pb_1.Message.getWrapperField(this, CreateTexture, 4) as CreateTexture;
         }
@@ -1367,6 +1760,12 @@ export namespace dart.proto {
         set set_object_rotation(value: SetObjectRotation) {
             pb_1.Message.setOneofWrapperField(this, 6, this.#one_of_decls[0], value);
         }
+        get set_object_transforms() {
+            return pb_1.Message.getWrapperField(this, SetObjectTransforms, 34) as SetObjectTransforms;
+        }
+        set set_object_transforms(value: SetObjectTransforms) {
+            pb_1.Message.setOneofWrapperField(this, 34, this.#one_of_decls[0], value);
+        }
         get set_object_color() {
             return pb_1.Message.getWrapperField(this, SetObjectColor, 7) as SetObjectColor;
         }
@@ -1433,6 +1832,12 @@ export namespace dart.proto {
         set set_rich_plot_data(value: SetRichPlotData) {
             pb_1.Message.setOneofWrapperField(this, 17, this.#one_of_decls[0], value);
         }
+        get append_rich_plot_data() {
+            return pb_1.Message.getWrapperField(this, AppendRichPlotData, 38) as AppendRichPlotData;
+        }
+        set append_rich_plot_data(value: AppendRichPlotData) {
+            pb_1.Message.setOneofWrapperField(this, 38, this.#one_of_decls[0], value);
+        }
         get set_rich_plot_bounds() {
             return pb_1.Message.getWrapperField(this, SetRichPlotBounds, 30) as SetRichPlotBounds;
         }
@@ -1501,7 +1906,7 @@ export namespace dart.proto {
         }
         get command() {
             const cases: {
-                [index: number]: "none" | "set_frames_per_second" | "clear_all" | "layer" | "box" | "sphere" | "capsule" | "line" | "mesh" | "texture" | "set_object_position" | "set_object_rotation" | "set_object_color" | "set_object_scale" | "set_object_tooltip" | "delete_object_tooltip" | "enable_mouse_interaction" | "text" | "button" | "slider" | "plot" | "rich_plot" | "set_rich_plot_data" | "set_rich_plot_bounds" | "set_ui_elem_pos" | "set_ui_elem_size" | "delete_ui_elem" | "delete_object" | "set_text_contents" | "set_button_label" | "set_slider_value" | "set_slider_min" | "set_slider_max" | "set_plot_data";
+                [index: number]: "none" | "set_frames_per_second" | "clear_all" | "layer" | "box" | "sphere" | "capsule" | "line" | "mesh" | "mesh_asset" | "skeleton_template" | "skeleton_instance" | "texture" | "set_object_position" | "set_object_rotation" | "set_object_transforms" | "set_object_color" | "set_object_scale" | "set_object_tooltip" | "delete_object_tooltip" | "enable_mouse_interaction" | "text" | "button" | "slider" | "plot" | "rich_plot" | "set_rich_plot_data" | "append_rich_plot_data" | "set_rich_plot_bounds" | "set_ui_elem_pos" | "set_ui_elem_size" | "delete_ui_elem" | "delete_object" | "set_text_contents" | "set_button_label" | "set_slider_value" | "set_slider_min" | "set_slider_max" | "set_plot_data";
             } = {
                 0: "none",
                 31: "set_frames_per_second",
@@ -1512,9 +1917,13 @@ export namespace dart.proto {
                 10: "capsule",
                 11: "line",
                 3: "mesh",
+                35: "mesh_asset",
+                36: "skeleton_template",
+                37: "skeleton_instance",
                 4: "texture",
                 5: "set_object_position",
                 6: "set_object_rotation",
+                34: "set_object_transforms",
                 7: "set_object_color",
                 8: "set_object_scale",
                 32: "set_object_tooltip",
@@ -1526,6 +1935,7 @@ export namespace dart.proto {
                 15: "plot",
                 29: "rich_plot",
                 17: "set_rich_plot_data",
+                38: "append_rich_plot_data",
                 30: "set_rich_plot_bounds",
                 19: "set_ui_elem_pos",
                 20: "set_ui_elem_size",
@@ -1538,7 +1948,7 @@ export namespace dart.proto {
                 27: "set_slider_max",
                 28: "set_plot_data"
             };
-            return cases[pb_1.Message.computeOneofCase(this, [31, 16, 1, 2, 9, 10, 11, 3, 4, 5, 6, 7, 8, 32, 33, 18, 12, 13, 14, 15, 29, 17, 30, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28])];
+            return cases[pb_1.Message.computeOneofCase(this, [31, 16, 1, 2, 9, 10, 11, 3, 35, 36, 37, 4, 5, 6, 34, 7, 8, 32, 33, 18, 12, 13, 14, 15, 29, 17, 38, 30, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28])];
         }
         static fromObject(data: {
             set_frames_per_second?: ReturnType<typeof SetFramesPerSecond.prototype.toObject>;
@@ -1549,9 +1959,13 @@ export namespace dart.proto {
             capsule?: ReturnType<typeof CreateCapsule.prototype.toObject>;
             line?: ReturnType<typeof CreateLine.prototype.toObject>;
             mesh?: ReturnType<typeof CreateMesh.prototype.toObject>;
+            mesh_asset?: ReturnType<typeof CreateMeshAsset.prototype.toObject>;
+            skeleton_template?: ReturnType<typeof CreateSkeletonTemplate.prototype.toObject>;
+            skeleton_instance?: ReturnType<typeof SetSkeletonInstance.prototype.toObject>;
             texture?: ReturnType<typeof CreateTexture.prototype.toObject>;
             set_object_position?: ReturnType<typeof SetObjectPosition.prototype.toObject>;
             set_object_rotation?: ReturnType<typeof SetObjectRotation.prototype.toObject>;
+            set_object_transforms?: ReturnType<typeof SetObjectTransforms.prototype.toObject>;
             set_object_color?: ReturnType<typeof SetObjectColor.prototype.toObject>;
             set_object_scale?: ReturnType<typeof SetObjectScale.prototype.toObject>;
             set_object_tooltip?: ReturnType<typeof SetObjectTooltip.prototype.toObject>;
@@ -1563,6 +1977,7 @@ export namespace dart.proto {
             plot?: ReturnType<typeof CreatePlot.prototype.toObject>;
             rich_plot?: ReturnType<typeof CreateRichPlot.prototype.toObject>;
             set_rich_plot_data?: ReturnType<typeof SetRichPlotData.prototype.toObject>;
+            append_rich_plot_data?: ReturnType<typeof AppendRichPlotData.prototype.toObject>;
             set_rich_plot_bounds?: ReturnType<typeof SetRichPlotBounds.prototype.toObject>;
             set_ui_elem_pos?: ReturnType<typeof SetUIElemPos.prototype.toObject>;
             set_ui_elem_size?: ReturnType<typeof SetUIElemSize.prototype.toObject>;
@@ -1600,6 +2015,15 @@ export namespace dart.proto {
             if (data.mesh != null) {
                 message.mesh = CreateMesh.fromObject(data.mesh);
             }
+            if (data.mesh_asset != null) {
+                message.mesh_asset = CreateMeshAsset.fromObject(data.mesh_asset);
+            }
+            if (data.skeleton_template != null) {
+                message.skeleton_template = CreateSkeletonTemplate.fromObject(data.skeleton_template);
+            }
+            if (data.skeleton_instance != null) {
+                message.skeleton_instance = SetSkeletonInstance.fromObject(data.skeleton_instance);
+            }
             if (data.texture != null) {
                 message.texture = CreateTexture.fromObject(data.texture);
             }
@@ -1609,6 +2033,9 @@ export namespace dart.proto {
             if (data.set_object_rotation != null) {
                 message.set_object_rotation = SetObjectRotation.fromObject(data.set_object_rotation);
             }
+            if (data.set_object_transforms != null) {
+                message.set_object_transforms = SetObjectTransforms.fromObject(data.set_object_transforms);
+            }
             if (data.set_object_color != null) {
                 message.set_object_color = SetObjectColor.fromObject(data.set_object_color);
             }
@@ -1642,6 +2069,9 @@ export namespace dart.proto {
             if (data.set_rich_plot_data != null) {
                 message.set_rich_plot_data = SetRichPlotData.fromObject(data.set_rich_plot_data);
             }
+            if (data.append_rich_plot_data != null) {
+                message.append_rich_plot_data = AppendRichPlotData.fromObject(data.append_rich_plot_data);
+            }
             if (data.set_rich_plot_bounds != null) {
                 message.set_rich_plot_bounds = SetRichPlotBounds.fromObject(data.set_rich_plot_bounds);
             }
@@ -1687,9 +2117,13 @@ export namespace dart.proto {
                 capsule?: ReturnType<typeof CreateCapsule.prototype.toObject>;
                 line?: ReturnType<typeof CreateLine.prototype.toObject>;
                 mesh?: ReturnType<typeof CreateMesh.prototype.toObject>;
+                mesh_asset?: ReturnType<typeof CreateMeshAsset.prototype.toObject>;
+                skeleton_template?: ReturnType<typeof CreateSkeletonTemplate.prototype.toObject>;
+                skeleton_instance?: ReturnType<typeof SetSkeletonInstance.prototype.toObject>;
                 texture?: ReturnType<typeof CreateTexture.prototype.toObject>;
                 set_object_position?: ReturnType<typeof SetObjectPosition.prototype.toObject>;
                 set_object_rotation?: ReturnType<typeof SetObjectRotation.prototype.toObject>;
+                set_object_transforms?: ReturnType<typeof SetObjectTransforms.prototype.toObject>;
                 set_object_color?: ReturnType<typeof SetObjectColor.prototype.toObject>;
                 set_object_scale?: ReturnType<typeof SetObjectScale.prototype.toObject>;
                 set_object_tooltip?: ReturnType<typeof SetObjectTooltip.prototype.toObject>;
@@ -1701,6 +2135,7 @@ export namespace dart.proto {
                 plot?: ReturnType<typeof CreatePlot.prototype.toObject>;
                 rich_plot?: ReturnType<typeof CreateRichPlot.prototype.toObject>;
                 set_rich_plot_data?: ReturnType<typeof SetRichPlotData.prototype.toObject>;
+                append_rich_plot_data?: ReturnType<typeof AppendRichPlotData.prototype.toObject>;
                 set_rich_plot_bounds?: ReturnType<typeof SetRichPlotBounds.prototype.toObject>;
                 set_ui_elem_pos?: ReturnType<typeof SetUIElemPos.prototype.toObject>;
                 set_ui_elem_size?: ReturnType<typeof SetUIElemSize.prototype.toObject>;
@@ -1737,6 +2172,15 @@ export namespace dart.proto {
             if (this.mesh != null) {
                 data.mesh = this.mesh.toObject();
             }
+            if (this.mesh_asset != null) {
+                data.mesh_asset = this.mesh_asset.toObject();
+            }
+            if (this.skeleton_template != null) {
+                data.skeleton_template = this.skeleton_template.toObject();
+            }
+            if (this.skeleton_instance != null) {
+                data.skeleton_instance = this.skeleton_instance.toObject();
+            }
             if (this.texture != null) {
                 data.texture = this.texture.toObject();
             }
@@ -1746,6 +2190,9 @@ export namespace dart.proto {
             if (this.set_object_rotation != null) {
                 data.set_object_rotation = this.set_object_rotation.toObject();
             }
+            if (this.set_object_transforms != null) {
+                data.set_object_transforms = this.set_object_transforms.toObject();
+            }
             if (this.set_object_color != null) {
                 data.set_object_color = this.set_object_color.toObject();
             }
@@ -1779,6 +2226,9 @@ export namespace dart.proto {
             if (this.set_rich_plot_data != null) {
                 data.set_rich_plot_data = this.set_rich_plot_data.toObject();
             }
+            if (this.append_rich_plot_data != null) {
+                data.append_rich_plot_data = this.append_rich_plot_data.toObject();
+            }
             if (this.set_rich_plot_bounds != null) {
                 data.set_rich_plot_bounds = this.set_rich_plot_bounds.toObject();
             }
@@ -1834,12 +2284,20 @@ export namespace dart.proto {
                 writer.writeMessage(11, this.line, () => this.line.serialize(writer));
             if (this.mesh !== undefined)
                 writer.writeMessage(3, this.mesh, () => this.mesh.serialize(writer));
+            if (this.mesh_asset !== undefined)
+                writer.writeMessage(35, this.mesh_asset, () => this.mesh_asset.serialize(writer));
+            if (this.skeleton_template !== undefined)
+                writer.writeMessage(36, this.skeleton_template, () => this.skeleton_template.serialize(writer));
+            if (this.skeleton_instance !== undefined)
+                writer.writeMessage(37, this.skeleton_instance, () => this.skeleton_instance.serialize(writer));
             if (this.texture !== undefined)
                 writer.writeMessage(4, this.texture, () => this.texture.serialize(writer));
             if (this.set_object_position !== undefined)
                 writer.writeMessage(5, this.set_object_position, () => this.set_object_position.serialize(writer));
             if (this.set_object_rotation !== undefined)
                 writer.writeMessage(6, this.set_object_rotation, () => this.set_object_rotation.serialize(writer));
+            if (this.set_object_transforms !== undefined)
+                writer.writeMessage(34, this.set_object_transforms, () => this.set_object_transforms.serialize(writer));
             if (this.set_object_color !== undefined)
                 writer.writeMessage(7, this.set_object_color, () => this.set_object_color.serialize(writer));
             if (this.set_object_scale !== undefined)
@@ -1862,6 +2320,8 @@ export namespace dart.proto {
                 writer.writeMessage(29, this.rich_plot, () => this.rich_plot.serialize(writer));
             if (this.set_rich_plot_data !== undefined)
                 writer.writeMessage(17, this.set_rich_plot_data, () => this.set_rich_plot_data.serialize(writer));
+            if (this.append_rich_plot_data !== undefined)
+                writer.writeMessage(38, this.append_rich_plot_data, () => this.append_rich_plot_data.serialize(writer));
             if (this.set_rich_plot_bounds !== undefined)
                 writer.writeMessage(30, this.set_rich_plot_bounds, () => this.set_rich_plot_bounds.serialize(writer));
             if (this.set_ui_elem_pos !== undefined)
@@ -1917,6 +2377,15 @@ export namespace dart.proto {
                     case 3:
                         reader.readMessage(message.mesh, () => message.mesh = CreateMesh.deserialize(reader));
                         break;
+                    case 35:
+                        reader.readMessage(message.mesh_asset, () => message.mesh_asset = CreateMeshAsset.deserialize(reader));
+                        break;
+                    case 36:
+                        reader.readMessage(message.skeleton_template, () => message.skeleton_template = CreateSkeletonTemplate.deserialize(reader));
+                        break;
+                    case 37:
+                        reader.readMessage(message.skeleton_instance, () => message.skeleton_instance = SetSkeletonInstance.deserialize(reader));
+                        break;
                     case 4:
                         reader.readMessage(message.texture, () => message.texture = CreateTexture.deserialize(reader));
                         break;
@@ -1926,6 +2395,9 @@ export namespace dart.proto {
                     case 6:
                         reader.readMessage(message.set_object_rotation, () => message.set_object_rotation = SetObjectRotation.deserialize(reader));
                         break;
+                    case 34:
+                        reader.readMessage(message.set_object_transforms, () => message.set_object_transforms = SetObjectTransforms.deserialize(reader));
+                        break;
                     case 7:
                         reader.readMessage(message.set_object_color, () => message.set_object_color = SetObjectColor.deserialize(reader));
                         break;
@@ -1959,6 +2431,9 @@ export namespace dart.proto {
                     case 17:
                         reader.readMessage(message.set_rich_plot_data, () => message.set_rich_plot_data = SetRichPlotData.deserialize(reader));
                         break;
+                    case 38:
+                        reader.readMessage(message.append_rich_plot_data, () => message.append_rich_plot_data = AppendRichPlotData.deserialize(reader));
+                        break;
                     case 30:
                         reader.readMessage(message.set_rich_plot_bounds, () => message.set_rich_plot_bounds = SetRichPlotBounds.deserialize(reader));
                         break;
@@ -2901,6 +3376,7 @@ export namespace dart.proto {
             layer?: number;
             cast_shadows?: boolean;
             receive_shadows?: boolean;
+            asset?: string;
         }) {
             super();
             pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [2, 3, 4, 5, 6, 7, 8], this.#one_of_decls);
@@ -2938,6 +3414,9 @@ export namespace dart.proto {
                 if ("receive_shadows" in data && data.receive_shadows != undefined) {
                     this.receive_shadows = data.receive_shadows;
                 }
+                if ("asset" in data && data.asset != undefined) {
+                    this.asset = data.asset;
+                }
             }
         }
         get key() {
@@ -3006,6 +3485,12 @@ export namespace dart.proto {
         set receive_shadows(value: boolean) {
             pb_1.Message.setField(this, 11, value);
         }
+        get asset() {
+            return pb_1.Message.getField(this, 12) as string;
+        }
+        set asset(value: string) {
+            pb_1.Message.setField(this, 12, value);
+        }
         static fromObject(data: {
             key?: number;
             vertex?: number[];
@@ -3018,6 +3503,7 @@ export namespace dart.proto {
             layer?: number;
             cast_shadows?: boolean;
             receive_shadows?: boolean;
+            asset?: string;
         }) {
             const message = new CreateMesh({});
             if (data.key != null) {
@@ -3053,6 +3539,9 @@ export namespace dart.proto {
             if (data.receive_shadows != null) {
                 message.receive_shadows = data.receive_shadows;
             }
+            if (data.asset != null) {
+                message.asset = data.asset;
+            }
             return message;
         }
         toObject() {
@@ -3068,6 +3557,7 @@ export namespace dart.proto {
                 layer?: number;
                 cast_shadows?: boolean;
                 receive_shadows?: boolean;
+                asset?: string;
             } = {};
             if (this.key != null) {
                 data.key = this.key;
@@ -3102,6 +3592,9 @@ export namespace dart.proto {
             if (this.receive_shadows != null) {
                 data.receive_shadows = this.receive_shadows;
             }
+            if (this.asset != null) {
+                data.asset = this.asset;
+            }
             return data;
         }
         serialize(): Uint8Array;
@@ -3130,6 +3623,8 @@ export namespace dart.proto {
                 writer.writeBool(10, this.cast_shadows);
             if (this.receive_shadows !== undefined)
                 writer.writeBool(11, this.receive_shadows);
+            if (typeof this.asset === "string" && this.asset.length)
+                writer.writeString(12, this.asset);
             if (!w)
                 return writer.getResultBuffer();
         }
@@ -3172,6 +3667,9 @@ export namespace dart.proto {
                     case 11:
                         message.receive_shadows = reader.readBool();
                         break;
+                    case 12:
+                        message.asset = reader.readString();
+                        break;
                     default: reader.skipField();
                 }
             }
@@ -3184,52 +3682,657 @@ export namespace dart.proto {
             return CreateMesh.deserialize(bytes);
         }
     }
-    export class CreateTexture extends pb_1.Message {
+    export class CreateMeshAsset extends pb_1.Message {
         #one_of_decls = [];
         constructor(data?: any[] | {
-            key?: number;
-            base64?: string;
+            hash?: string;
+            vertex?: number[];
+            vertex_normal?: number[];
+            face?: number[];
+            uv?: number[];
         }) {
             super();
-            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [], this.#one_of_decls);
+            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [2, 3, 4, 5], this.#one_of_decls);
             if (!Array.isArray(data) && typeof data == "object") {
-                if ("key" in data && data.key != undefined) {
-                    this.key = data.key;
+                if ("hash" in data && data.hash != undefined) {
+                    this.hash = data.hash;
                 }
-                if ("base64" in data && data.base64 != undefined) {
-                    this.base64 = data.base64;
+                if ("vertex" in data && data.vertex != undefined) {
+                    this.vertex = data.vertex;
+                }
+                if ("vertex_normal" in data && data.vertex_normal != undefined) {
+                    this.vertex_normal = data.vertex_normal;
+                }
+                if ("face" in data && data.face != undefined) {
+                    this.face = data.face;
+                }
+                if ("uv" in data && data.uv != undefined) {
+                    this.uv = data.uv;
                 }
             }
         }
-        get key() {
-            return pb_1.Message.getField(this, 1) as number;
+        get hash() {
+            return pb_1.Message.getField(this, 1) as string;
         }
-        set key(value: number) {
+        set hash(value: string) {
             pb_1.Message.setField(this, 1, value);
         }
-        get base64() {
-            return pb_1.Message.getField(this, 2) as string;
+        get vertex() {
+            return pb_1.Message.getField(this, 2) as number[];
         }
-        set base64(value: string) {
+        set vertex(value: number[]) {
             pb_1.Message.setField(this, 2, value);
         }
-        static fromObject(data: {
-            key?: number;
-            base64?: string;
-        }) {
-            const message = new CreateTexture({});
-            if (data.key != null) {
-                message.key = data.key;
-            }
-            if (data.base64 != null) {
-                message.base64 = data.base64;
-            }
-            return message;
+        get vertex_normal() {
+            return pb_1.Message.getField(this, 3) as number[];
         }
-        toObject() {
-            const data: {
-                key?: number;
+        set vertex_normal(value: number[]) {
+            pb_1.Message.setField(this, 3, value);
+        }
+        get face() {
+            return pb_1.Message.getField(this, 4) as number[];
+        }
+        set face(value: number[]) {
+            pb_1.Message.setField(this, 4, value);
+        }
+        get uv() {
+            return pb_1.Message.getField(this, 5) as number[];
+        }
+        set uv(value: number[]) {
+            pb_1.Message.setField(this, 5, value);
+        }
+        static fromObject(data: {
+            hash?: string;
+            vertex?: number[];
+            vertex_normal?: number[];
+            face?: number[];
+            uv?: number[];
+        }) {
+            const message = new CreateMeshAsset({});
+            if (data.hash != null) {
+                message.hash = data.hash;
+            }
+            if (data.vertex != null) {
+                message.vertex = data.vertex;
+            }
+            if (data.vertex_normal != null) {
+                message.vertex_normal = data.vertex_normal;
+            }
+            if (data.face != null) {
+                message.face = data.face;
+            }
+            if (data.uv != null) {
+                message.uv = data.uv;
+            }
+            return message;
+        }
+        toObject() {
+            const data: {
+                hash?: string;
+                vertex?: number[];
+                vertex_normal?: number[];
+                face?: number[];
+                uv?: number[];
+            } = {};
+            if (this.hash != null) {
+                data.hash = this.hash;
+            }
+            if (this.vertex != null) {
+                data.vertex = this.vertex;
+            }
+            if (this.vertex_normal != null) {
+                data.vertex_normal = this.vertex_normal;
+            }
+            if (this.face != null) {
+                data.face = this.face;
+            }
+            if (this.uv != null) {
+                data.uv = this.uv;
+            }
+            return data;
+        }
+        serialize(): Uint8Array;
+        serialize(w: pb_1.BinaryWriter): void;
+        serialize(w?: pb_1.BinaryWriter): Uint8Array | void {
+            const writer = w || new pb_1.BinaryWriter();
+            if (typeof this.hash === "string" && this.hash.length)
+                writer.writeString(1, this.hash);
+            if (this.vertex !== undefined)
+                writer.writePackedFloat(2, this.vertex);
+            if (this.vertex_normal !== undefined)
+                writer.writePackedFloat(3, this.vertex_normal);
+            if (this.face !== undefined)
+                writer.writePackedInt32(4, this.face);
+            if (this.uv !== undefined)
+                writer.writePackedFloat(5, this.uv);
+            if (!w)
+                return writer.getResultBuffer();
+        }
+        static deserialize(bytes: Uint8Array | pb_1.BinaryReader): CreateMeshAsset {
+            const reader = bytes instanceof pb_1.BinaryReader ? bytes : new pb_1.BinaryReader(bytes), message = new CreateMeshAsset();
+            while (reader.nextField()) {
+                if (reader.isEndGroup())
+                    break;
+                switch (reader.getFieldNumber()) {
+                    case 1:
+                        message.hash = reader.readString();
+                        break;
+                    case 2:
+                        message.vertex = reader.readPackedFloat();
+                        break;
+                    case 3:
+                        message.vertex_normal = reader.readPackedFloat();
+                        break;
+                    case 4:
+                        message.face = reader.readPackedInt32();
+                        break;
+                    case 5:
+                        message.uv = reader.readPackedFloat();
+                        break;
+                    default: reader.skipField();
+                }
+            }
+            return message;
+        }
+        serializeBinary(): Uint8Array {
+            return this.serialize();
+        }
+        static deserializeBinary(bytes: Uint8Array): CreateMeshAsset {
+            return CreateMeshAsset.deserialize(bytes);
+        }
+    }
+    export class CreateSkeletonTemplate extends pb_1.Message {
+        #one_of_decls = [];
+        constructor(data?: any[] | {
+            key?: number;
+            shape?: SkeletonTemplateShape[];
+            layer?: number;
+        }) {
+            super();
+            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [2], this.#one_of_decls);
+            if (!Array.isArray(data) && typeof data == "object") {
+                if ("key" in data && data.key != undefined) {
+                    this.key = data.key;
+                }
+                if ("shape" in data && data.shape != undefined) {
+                    this.shape = data.shape;
+                }
+                if ("layer" in data && data.layer != undefined) {
+                    this.layer = data.layer;
+                }
+            }
+        }
+        get key() {
+            return pb_1.Message.getField(this, 1) as number;
+        }
+        set key(value: number) {
+            pb_1.Message.setField(this, 1, value);
+        }
+        get shape() {
+            return pb_1.Message.getRepeatedWrapperField(this, SkeletonTemplateShape, 2) as SkeletonTemplateShape[];
+        }
+        set shape(value: SkeletonTemplateShape[]) {
+            pb_1.Message.setRepeatedWrapperField(this, 2, value);
+        }
+        get layer() {
+            return pb_1.Message.getField(this, 3) as number;
+        }
+        set layer(value: number) {
+            pb_1.Message.setField(this, 3, value);
+        }
+        static fromObject(data: {
+            key?: number;
+            shape?: ReturnType<typeof SkeletonTemplateShape.prototype.toObject>[];
+            layer?: number;
+        }) {
+            const message = new CreateSkeletonTemplate({});
+            if (data.key != null) {
+                message.key = data.key;
+            }
+            if (data.shape != null) {
+                message.shape = data.shape.map(item => SkeletonTemplateShape.fromObject(item));
+            }
+            if (data.layer != null) {
+                message.layer = data.layer;
+            }
+            return message;
+        }
+        toObject() {
+            const data: {
+                key?: number;
+                shape?: ReturnType<typeof SkeletonTemplateShape.prototype.toObject>[];
+                layer?: number;
+            } = {};
+            if (this.key != null) {
+                data.key = this.key;
+            }
+            if (this.shape != null) {
+                data.shape = this.shape.map((item: SkeletonTemplateShape) => item.toObject());
+            }
+            if (this.layer != null) {
+                data.layer = this.layer;
+            }
+            return data;
+        }
+        serialize(): Uint8Array;
+        serialize(w: pb_1.BinaryWriter): void;
+        serialize(w?: pb_1.BinaryWriter): Uint8Array | void {
+            const writer = w || new pb_1.BinaryWriter();
+            if (this.key !== undefined)
+                writer.writeInt32(1, this.key);
+            if (this.shape !== undefined)
+                writer.writeRepeatedMessage(2, this.shape, (item: SkeletonTemplateShape) => item.serialize(writer));
+            if (this.layer !== undefined)
+                writer.writeInt32(3, this.layer);
+            if (!w)
+                return writer.getResultBuffer();
+        }
+        static deserialize(bytes: Uint8Array | pb_1.BinaryReader): CreateSkeletonTemplate {
+            const reader = bytes instanceof pb_1.BinaryReader ? bytes : new pb_1.BinaryReader(bytes), message = new CreateSkeletonTemplate();
+            while (reader.nextField()) {
+                if (reader.isEndGroup())
+                    break;
+                switch (reader.getFieldNumber()) {
+                    case 1:
+                        message.key = reader.readInt32();
+                        break;
+                    case 2:
+                        reader.readMessage(message.shape, () => pb_1.Message.addToRepeatedWrapperField(message, 2, SkeletonTemplateShape.deserialize(reader), SkeletonTemplateShape));
+                        break;
+                    case 3:
+                        message.layer = reader.readInt32();
+                        break;
+                    default: reader.skipField();
+                }
+            }
+            return message;
+        }
+        serializeBinary(): Uint8Array {
+            return this.serialize();
+        }
+        static deserializeBinary(bytes: Uint8Array): CreateSkeletonTemplate {
+            return CreateSkeletonTemplate.deserialize(bytes);
+        }
+    }
+    export class SkeletonTemplateShape extends pb_1.Message {
+        #one_of_decls = [];
+        constructor(data?: any[] | {
+            type?: number;
+            size?: number[];
+            asset?: string;
+            color?: number[];
+            cast_shadows?: boolean;
+            receive_shadows?: boolean;
+        }) {
+            super();
+            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [2, 4], this.#one_of_decls);
+            if (!Array.isArray(data) && typeof data == "object") {
+                if ("type" in data && data.type != undefined) {
+                    this.type = data.type;
+                }
+                if ("size" in data && data.size != undefined) {
+                    this.size = data.size;
+                }
+                if ("asset" in data && data.asset != undefined) {
+                    this.asset = data.asset;
+                }
+                if ("color" in data && data.color != undefined) {
+                    this.color = data.color;
+                }
+                if ("cast_shadows" in data && data.cast_shadows != undefined) {
+                    this.cast_shadows = data.cast_shadows;
+                }
+                if ("receive_shadows" in data && data.receive_shadows != undefined) {
+                    this.receive_shadows = data.receive_shadows;
+                }
+            }
+        }
+        get type() {
+            return pb_1.Message.getField(this, 1) as number;
+        }
+        set type(value: number) {
+            pb_1.Message.setField(this, 1, value);
+        }
+        get size() {
+            return pb_1.Message.getField(this, 2) as number[];
+        }
+        set size(value: number[]) {
+            pb_1.Message.setField(this, 2, value);
+        }
+        get asset() {
+            return pb_1.Message.getField(this, 3) as string;
+        }
+        set asset(value: string) {
+            pb_1.Message.setField(this, 3, value);
+        }
+        get color() {
+            return pb_1.Message.getField(this, 4) as number[];
+        }
+        set color(value: number[]) {
+            pb_1.Message.setField(this, 4, value);
+        }
+        get cast_shadows() {
+            return pb_1.Message.getField(this, 5) as boolean;
+        }
+        set cast_shadows(value: boolean) {
+            pb_1.Message.setField(this, 5, value);
+        }
+        get receive_shadows() {
+            return pb_1.Message.getField(this, 6) as boolean;
+        }
+        set receive_shadows(value: boolean) {
+            pb_1.Message.setField(this, 6, value);
+        }
+        static fromObject(data: {
+            type?: number;
+            size?: number[];
+            asset?: string;
+            color?: number[];
+            cast_shadows?: boolean;
+            receive_shadows?: boolean;
+        }) {
+            const message = new SkeletonTemplateShape({});
+            if (data.type != null) {
+                message.type = data.type;
+            }
+            if (data.size != null) {
+                message.size = data.size;
+            }
+            if (data.asset != null) {
+                message.asset = data.asset;
+            }
+            if (data.color != null) {
+                message.color = data.color;
+            }
+            if (data.cast_shadows != null) {
+                message.cast_shadows = data.cast_shadows;
+            }
+            if (data.receive_shadows != null) {
+                message.receive_shadows = data.receive_shadows;
+            }
+            return message;
+        }
+        toObject() {
+            const data: {
+                type?: number;
+                size?: number[];
+                asset?: string;
+                color?: number[];
+                cast_shadows?: boolean;
+                receive_shadows?: boolean;
+            } = {};
+            if (this.type != null) {
+                data.type = this.type;
+            }
+            if (this.size != null) {
+                data.size = this.size;
+            }
+            if (this.asset != null) {
+                data.asset = this.asset;
+            }
+            if (this.color != null) {
+                data.color = this.color;
+            }
+            if (this.cast_shadows != null) {
+                data.cast_shadows = this.cast_shadows;
+            }
+            if (this.receive_shadows != null) {
+                data.receive_shadows = this.receive_shadows;
+            }
+            return data;
+        }
+        serialize(): Uint8Array;
+        serialize(w: pb_1.BinaryWriter): void;
+        serialize(w?: pb_1.BinaryWriter): Uint8Array | void {
+            const writer = w || new pb_1.BinaryWriter();
+            if (this.type !== undefined)
+                writer.writeInt32(1, this.type);
+            if (this.size !== undefined)
+                writer.writePackedFloat(2, this.size);
+            if (typeof this.asset === "string" && this.asset.length)
+                writer.writeString(3, this.asset);
+            if (this.color !== undefined)
+                writer.writePackedFloat(4, this.color);
+            if (this.cast_shadows !== undefined)
+                writer.writeBool(5, this.cast_shadows);
+            if (this.receive_shadows !== undefined)
+                writer.writeBool(6, this.receive_shadows);
+            if (!w)
+                return writer.getResultBuffer();
+        }
+        static deserialize(bytes: Uint8Array | pb_1.BinaryReader): SkeletonTemplateShape {
+            const reader = bytes instanceof pb_1.BinaryReader ? bytes : new pb_1.BinaryReader(bytes), message = new SkeletonTemplateShape();
+            while (reader.nextField()) {
+                if (reader.isEndGroup())
+                    break;
+                switch (reader.getFieldNumber()) {
+                    case 1:
+                        message.type = reader.readInt32();
+                        break;
+                    case 2:
+                        message.size = reader.readPackedFloat();
+                        break;
+                    case 3:
+                        message.asset = reader.readString();
+                        break;
+                    case 4:
+                        message.color = reader.readPackedFloat();
+                        break;
+                    case 5:
+                        message.cast_shadows = reader.readBool();
+                        break;
+                    case 6:
+                        message.receive_shadows = reader.readBool();
+                        break;
+                    default: reader.skipField();
+                }
+            }
+            return message;
+        }
+        serializeBinary(): Uint8Array {
+            return this.serialize();
+        }
+        static deserializeBinary(bytes: Uint8Array): SkeletonTemplateShape {
+            return SkeletonTemplateShape.deserialize(bytes);
+        }
+    }
+    export class SetSkeletonInstance extends pb_1.Message {
+        #one_of_decls = [];
+        constructor(data?: any[] | {
+            key?: number;
+            template_key?: number;
+            transform?: number[];
+            color?: number[];
+        }) {
+            super();
+            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [3, 4], this.#one_of_decls);
+            if (!Array.isArray(data) && typeof data == "object") {
+                if ("key" in data && data.key != undefined) {
+                    this.key = data.key;
+                }
+                if ("template_key" in data && data.template_key != undefined) {
+                    this.template_key = data.template_key;
+                }
+                if ("transform" in data && data.transform != undefined) {
+                    this.transform = data.transform;
+                }
+                if ("color" in data && data.color != undefined) {
+                    this.color = data.color;
+                }
+            }
+        }
+        get key() {
+            return pb_1.Message.getField(this, 1) as number;
+        }
+        set key(value: number) {
+            pb_1.Message.setField(this, 1, value);
+        }
+        get template_key() {
+            return pb_1.Message.getField(this, 2) as number;
+        }
+        set template_key(value: number) {
+            pb_1.Message.setField(this, 2, value);
+        }
+        get transform() {
+            return pb_1.Message.getField(this, 3) as number[];
+        }
+        set transform(value: number[]) {
+            pb_1.Message.setField(this, 3, value);
+        }
+        get color() {
+            return pb_1.Message.getField(this, 4) as number[];
+        }
+        set color(value: number[]) {
+            pb_1.Message.setField(this, 4, value);
+        }
+        static fromObject(data: {
+            key?: number;
+            template_key?: number;
+            transform?: number[];
+            color?: number[];
+        }) {
+            const message = new SetSkeletonInstance({});
+            if (data.key != null) {
+                message.key = data.key;
+            }
+            if (data.template_key != null) {
+                message.template_key = data.template_key;
+            }
+            if (data.transform != null) {
+                message.transform = data.transform;
+            }
+            if (data.color != null) {
+                message.color = data.color;
+            }
+            return message;
+        }
+        toObject() {
+            const data: {
+                key?: number;
+                template_key?: number;
+                transform?: number[];
+                color?: number[];
+            } = {};
+            if (this.key != null) {
+                data.key = this.key;
+            }
+            if (this.template_key != null) {
+                data.template_key = this.template_key;
+            }
+            if (this.transform != null) {
+                data.transform = this.transform;
+            }
+            if (this.color != null) {
+                data.color = this.color;
+            }
+            return data;
+        }
+        serialize(): Uint8Array;
+        serialize(w: pb_1.BinaryWriter): void;
+        serialize(w?: pb_1.BinaryWriter): Uint8Array | void {
+            const writer = w || new pb_1.BinaryWriter();
+            if (this.key !== undefined)
+                writer.writeInt32(1, this.key);
+            if (this.template_key !== undefined)
+                writer.writeInt32(2, this.template_key);
+            if (this.transform !== undefined)
+                writer.writePackedFloat(3, this.transform);
+            if (this.color !== undefined)
+                writer.writePackedFloat(4, this.color);
+            if (!w)
+                return writer.getResultBuffer();
+        }
+        static deserialize(bytes: Uint8Array | pb_1.BinaryReader): SetSkeletonInstance {
+            const reader = bytes instanceof pb_1.BinaryReader ? bytes : new pb_1.BinaryReader(bytes), message = new SetSkeletonInstance();
+            while (reader.nextField()) {
+                if (reader.isEndGroup())
+                    break;
+                switch (reader.getFieldNumber()) {
+                    case 1:
+                        message.key = reader.readInt32();
+                        break;
+                    case 2:
+                        message.template_key = reader.readInt32();
+                        break;
+                    case 3:
+                        message.transform = reader.readPackedFloat();
+                        break;
+                    case 4:
+                        message.color = reader.readPackedFloat();
+                        break;
+                    default: reader.skipField();
+                }
+            }
+            return message;
+        }
+        serializeBinary(): Uint8Array {
+            return this.serialize();
+        }
+        static deserializeBinary(bytes: Uint8Array): SetSkeletonInstance {
+            return SetSkeletonInstance.deserialize(bytes);
+        }
+    }
+    export class CreateTexture extends pb_1.Message {
+        #one_of_decls = [];
+        constructor(data?: any[] | {
+            key?: number;
+            base64?: string;
+            hash?: string;
+        }) {
+            super();
+            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [], this.#one_of_decls);
+            if (!Array.isArray(data) && typeof data == "object") {
+                if ("key" in data && data.key != undefined) {
+                    this.key = data.key;
+                }
+                if ("base64" in data && data.base64 != undefined) {
+                    this.base64 = data.base64;
+                }
+                if ("hash" in data && data.hash != undefined) {
+                    this.hash = data.hash;
+                }
+            }
+        }
+        get key() {
+            return pb_1.Message.getField(this, 1) as number;
+        }
+        set key(value: number) {
+            pb_1.Message.setField(this, 1, value);
+        }
+        get base64() {
+            return pb_1.Message.getField(this, 2) as string;
+        }
+        set base64(value: string) {
+            pb_1.Message.setField(this, 2, value);
+        }
+        get hash() {
+            return pb_1.Message.getField(this, 3) as string;
+        }
+        set hash(value: string) {
+            pb_1.Message.setField(this, 3, value);
+        }
+        static fromObject(data: {
+            key?: number;
+            base64?: string;
+            hash?: string;
+        }) {
+            const message = new CreateTexture({});
+            if (data.key != null) {
+                message.key = data.key;
+            }
+            if (data.base64 != null) {
+                message.base64 = data.base64;
+            }
+            if (data.hash != null) {
+                message.hash = data.hash;
+            }
+            return message;
+        }
+        toObject() {
+            const data: {
+                key?: number;
                 base64?: string;
+                hash?: string;
             } = {};
             if (this.key != null) {
                 data.key = this.key;
@@ -3237,6 +4340,9 @@ export namespace dart.proto {
             if (this.base64 != null) {
                 data.base64 = this.base64;
             }
+            if (this.hash != null) {
+                data.hash = this.hash;
+            }
             return data;
         }
         serialize(): Uint8Array;
@@ -3247,6 +4353,8 @@ export namespace dart.proto {
                 writer.writeInt32(1, this.key);
             if (typeof this.base64 === "string" && this.base64.length)
                 writer.writeString(2, this.base64);
+            if (typeof this.hash === "string" && this.hash.length)
+                writer.writeString(3, this.hash);
             if (!w)
                 return writer.getResultBuffer();
         }
@@ -3262,6 +4370,9 @@ export namespace dart.proto {
                     case 2:
                         message.base64 = reader.readString();
                         break;
+                    case 3:
+                        message.hash = reader.readString();
+                        break;
                     default: reader.skipField();
                 }
             }
@@ -3454,6 +4565,211 @@ export namespace dart.proto {
             return SetObjectRotation.deserialize(bytes);
         }
     }
+    export class SetObjectTransforms extends pb_1.Message {
+        #one_of_decls = [];
+        constructor(data?: any[] | {
+            keyframe?: boolean;
+            position_precision?: number;
+            rotation_precision?: number;
+            position_key?: number[];
+            position?: number[];
+            rotation_key?: number[];
+            rotation?: number[];
+        }) {
+            super();
+            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [4, 5, 6, 7], this.#one_of_decls);
+            if (!Array.isArray(data) && typeof data == "object") {
+                if ("keyframe" in data && data.keyframe != undefined) {
+                    this.keyframe = data.keyframe;
+                }
+                if ("position_precision" in data && data.position_precision != undefined) {
+                    this.position_precision = data.position_precision;
+                }
+                if ("rotation_precision" in data && data.rotation_precision != undefined) {
+                    this.rotation_precision = data.rotation_precision;
+                }
+                if ("position_key" in data && data.position_key != undefined) {
+                    this.position_key = data.position_key;
+                }
+                if ("position" in data && data.position != undefined) {
+                    this.position = data.position;
+                }
+                if ("rotation_key" in data && data.rotation_key != undefined) {
+                    this.rotation_key = data.rotation_key;
+                }
+                if ("rotation" in data && data.rotation != undefined) {
+                    this.rotation = data.rotation;
+                }
+            }
+        }
+        get keyframe() {
+            return pb_1.Message.getField(this, 1) as boolean;
+        }
+        set keyframe(value: boolean) {
+            pb_1.Message.setField(this, 1, value);
+        }
+        get position_precision() {
+            return pb_1.Message.getField(this, 2) as number;
+        }
+        set position_precision(value: number) {
+            pb_1.Message.setField(this, 2, value);
+        }
+        get rotation_precision() {
+            return pb_1.Message.getField(this, 3) as number;
+        }
+        set rotation_precision(value: number) {
+            pb_1.Message.setField(this, 3, value);
+        }
+        get position_key() {
+            return pb_1.Message.getField(this, 4) as number[];
+        }
+        set position_key(value: number[]) {
+            pb_1.Message.setField(this, 4, value);
+        }
+        get position() {
+            return pb_1.Message.getField(this, 5) as number[];
+        }
+        set position(value: number[]) {
+            pb_1.Message.setField(this, 5, value);
+        }
+        get rotation_key() {
+            return pb_1.Message.getField(this, 6) as number[];
+        }
+        set rotation_key(value: number[]) {
+            pb_1.Message.setField(this, 6, value);
+        }
+        get rotation() {
+            return pb_1.Message.getField(this, 7) as number[];
+        }
+        set rotation(value: number[]) {
+            pb_1.Message.setField(this, 7, value);
+        }
+        static fromObject(data: {
+            keyframe?: boolean;
+            position_precision?: number;
+            rotation_precision?: number;
+            position_key?: number[];
+            position?: number[];
+            rotation_key?: number[];
+            rotation?: number[];
+        }) {
+            const message = new SetObjectTransforms({});
+            if (data.keyframe != null) {
+                message.keyframe = data.keyframe;
+            }
+            if (data.position_precision != null) {
+                message.position_precision = data.position_precision;
+            }
+            if (data.rotation_precision != null) {
+                message.rotation_precision = data.rotation_precision;
+            }
+            if (data.position_key != null) {
+                message.position_key = data.position_key;
+            }
+            if (data.position != null) {
+                message.position = data.position;
+            }
+            if (data.rotation_key != null) {
+                message.rotation_key = data.rotation_key;
+            }
+            if (data.rotation != null) {
+                message.rotation = data.rotation;
+            }
+            return message;
+        }
+        toObject() {
+            const data: {
+                keyframe?: boolean;
+                position_precision?: number;
+                rotation_precision?: number;
+                position_key?: number[];
+                position?: number[];
+                rotation_key?: number[];
+                rotation?: number[];
+            } = {};
+            if (this.keyframe != null) {
+                data.keyframe = this.keyframe;
+            }
+            if (this.position_precision != null) {
+                data.position_precision = this.position_precision;
+            }
+            if (this.rotation_precision != null) {
+                data.rotation_precision = this.rotation_precision;
+            }
+            if (this.position_key != null) {
+                data.position_key = this.position_key;
+            }
+            if (this.position != null) {
+                data.position = this.position;
+            }
+            if (this.rotation_key != null) {
+                data.rotation_key = this.rotation_key;
+            }
+            if (this.rotation != null) {
+                data.rotation = this.rotation;
+            }
+            return data;
+        }
+        serialize(): Uint8Array;
+        serialize(w: pb_1.BinaryWriter): void;
+        serialize(w?: pb_1.BinaryWriter): Uint8Array | void {
+            const writer = w || new pb_1.BinaryWriter();
+            if (this.keyframe !== undefined)
+                writer.writeBool(1, this.keyframe);
+            if (this.position_precision !== undefined)
+                writer.writeFloat(2, this.position_precision);
+            if (this.rotation_precision !== undefined)
+                writer.writeFloat(3, this.rotation_precision);
+            if (this.position_key !== undefined)
+                writer.writePackedSint32(4, this.position_key);
+            if (this.position !== undefined)
+                writer.writePackedSint32(5, this.position);
+            if (this.rotation_key !== undefined)
+                writer.writePackedSint32(6, this.rotation_key);
+            if (this.rotation !== undefined)
+                writer.writePackedSint32(7, this.rotation);
+            if (!w)
+                return writer.getResultBuffer();
+        }
+        static deserialize(bytes: Uint8Array | pb_1.BinaryReader): SetObjectTransforms {
+            const reader = bytes instanceof pb_1.BinaryReader ? bytes : new pb_1.BinaryReader(bytes), message = new SetObjectTransforms();
+            while (reader.nextField()) {
+                if (reader.isEndGroup())
+                    break;
+                switch (reader.getFieldNumber()) {
+                    case 1:
+                        message.keyframe = reader.readBool();
+                        break;
+                    case 2:
+                        message.position_precision = reader.readFloat();
+                        break;
+                    case 3:
+                        message.rotation_precision = reader.readFloat();
+                        break;
+                    case 4:
+                        message.position_key = reader.readPackedSint32();
+                        break;
+                    case 5:
+                        message.position = reader.readPackedSint32();
+                        break;
+                    case 6:
+                        message.rotation_key = reader.readPackedSint32();
+                        break;
+                    case 7:
+                        message.rotation = reader.readPackedSint32();
+                        break;
+                    default: reader.skipField();
+                }
+            }
+            return message;
+        }
+        serializeBinary(): Uint8Array {
+            return this.serialize();
+        }
+        static deserializeBinary(bytes: Uint8Array): SetObjectTransforms {
+            return SetObjectTransforms.deserialize(bytes);
+        }
+    }
     export class SetObjectColor extends pb_1.Message {
         #one_of_decls = [];
         constructor(data?: any[] | {
@@ -4904,6 +6220,142 @@ export namespace dart.proto {
             return SetRichPlotData.deserialize(bytes);
         }
     }
+    export class AppendRichPlotData extends pb_1.Message {
+        #one_of_decls = [];
+        constructor(data?: any[] | {
+            key?: number;
+            name?: string;
+            xs?: number[];
+            ys?: number[];
+        }) {
+            super();
+            pb_1.Message.initialize(this, Array.isArray(data) ? data : [], 0, -1, [3, 4], this.#one_of_decls);
+            if (!Array.isArray(data) && typeof data == "object") {
+                if ("key" in data && data.key != undefined) {
+                    this.key = data.key;
+                }
+                if ("name" in data && data.name != undefined) {
+                    this.name = data.name;
+                }
+                if ("xs" in data && data.xs != undefined) {
+                    this.xs = data.xs;
+                }
+                if ("ys" in data && data.ys != undefined) {
+                    this.ys = data.ys;
+                }
+            }
+        }
+        get key() {
+            return pb_1.Message.getField(this, 1) as number;
+        }
+        set key(value: number) {
+            pb_1.Message.setField(this, 1, value);
+        }
+        get name() {
+            return pb_1.Message.getField(this, 2) as string;
+        }
+        set name(value: string) {
+            pb_1.Message.setField(this, 2, value);
+        }
+        get xs() {
+            return pb_1.Message.getField(this, 3) as number[];
+        }
+        set xs(value: number[]) {
+            pb_1.Message.setField(this, 3, value);
+        }
+        get ys() {
+            return pb_1.Message.getField(this, 4) as number[];
+        }
+        set ys(value: number[]) {
+            pb_1.Message.setField(this, 4, value);
+        }
+        static fromObject(data: {
+            key?: number;
+            name?: string;
+            xs?: number[];
+            ys?: number[];
+        }) {
+            const message = new AppendRichPlotData({});
+            if (data.key != null) {
+                message.key = data.key;
+            }
+            if (data.name != null) {
+                message.name = data.name;
+            }
+            if (data.xs != null) {
+                message.xs = data.xs;
+            }
+            if (data.ys != null) {
+                message.ys = data.ys;
+            }
+            return message;
+        }
+        toObject() {
+            const data: {
+                key?: number;
+                name?: string;
+                xs?: number[];
+                ys?: number[];
+            } = {};
+            if (this.key != null) {
+                data.key = this.key;
+            }
+            if (this.name != null) {
+                data.name = this.name;
+            }
+            if (this.xs != null) {
+                data.xs = this.xs;
+            }
+            if (this.ys != null) {
+                data.ys = this.ys;
+            }
+            return data;
+        }
+        serialize(): Uint8Array;
+        serialize(w: pb_1.BinaryWriter): void;
+        serialize(w?: pb_1.BinaryWriter): Uint8Array | void {
+            const writer = w || new pb_1.BinaryWriter();
+            if (this.key !== undefined)
+                writer.writeInt32(1, this.key);
+            if (typeof this.name === "string" && this.name.length)
+                writer.writeString(2, this.name);
+            if (this.xs !== undefined)
+                writer.writePackedFloat(3, this.xs);
+            if (this.ys !== undefined)
+                writer.writePackedFloat(4, this.ys);
+            if (!w)
+                return writer.getResultBuffer();
+        }
+        static deserialize(bytes: Uint8Array | pb_1.BinaryReader): AppendRichPlotData {
+            const reader = bytes instanceof pb_1.BinaryReader ? bytes : new pb_1.BinaryReader(bytes), message = new AppendRichPlotData();
+            while (reader.nextField()) {
+                if (reader.isEndGroup())
+                    break;
+                switch (reader.getFieldNumber()) {
+                    case 1:
+                        message.key = reader.readInt32();
+                        break;
+                    case 2:
+                        message.name = reader.readString();
+                        break;
+                    case 3:
+                        message.xs = reader.readPackedFloat();
+                        break;
+                    case 4:
+                        message.ys = reader.readPackedFloat();
+                        break;
+                    default: reader.skipField();
+                }
+            }
+            return message;
+        }
+        serializeBinary(): Uint8Array {
+            return this.serialize();
+        }
+        static deserializeBinary(bytes: Uint8Array): AppendRichPlotData {
+            return AppendRichPlotData.deserialize(bytes);
+        }
+    }
     export class SetRichPlotBounds extends pb_1.Message {
         #one_of_decls = [];
         constructor(data?: any[] | {
@@ -0,0 +1,45 @@
+const path = require("path");
+const HtmlWebpackPlugin = require("html-webpack-plugin");
+
+/// This builds the page that `render_videos.js` loads into headless Chrome
+module.exports = {
+  entry: {
+    headless: "./src/headless.ts"
+  },
+  module: {
+    rules: [
+      {
+        test: /\.(js|ts)$/,
+        exclude: /node_modules/,
+        use: ["babel-loader"],
+      },
+      {
+        test: /\.s[ac]ss$/i,
+        use: [
+          // Creates `style` nodes from JS strings
+          "style-loader",
+          // Translates CSS into CommonJS
+          "css-loader",
+          // Compiles Sass to CSS
+          "sass-loader",
+        ],
+      },
+      {
+        test: /\.txt$/i,
+        use: "raw-loader",
+      },
+    ],
+  },
+  resolve: {
+    extensions: ["*", ".ts", ".js"],
+  },
+  output: {
+    path: path.join(__dirname, "dist", "headless"),
+    filename: "[name].js",
+  },
+  plugins: [
+    new HtmlWebpackPlugin({
+      template: path.join(__dirname, "src", "index.html")
+    })
+  ],
+};
@@ -89,6 +89,10 @@ void Anthropometrics(py::module& m)
           "measure",
           &dart::biomechanics::Anthropometrics::measure,
           ::py::arg("skel"))
+      .def(
+          "measureVector",
+          &dart::biomechanics::Anthropometrics::measureVector,
+          ::py::arg("skel"))
       .def(
           "getPDF",
           &dart::biomechanics::Anthropometrics::getPDF,
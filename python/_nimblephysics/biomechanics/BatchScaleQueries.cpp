@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <memory>
+
+#include <Eigen/Dense>
+#include <dart/biomechanics/Anthropometrics.hpp>
+#include <dart/biomechanics/BatchScaleQueries.hpp>
+#include <dart/dynamics/Skeleton.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void BatchScaleQueries(py::module& m)
+{
+  ::py::class_<dart::biomechanics::BatchScaleQueryResult>(
+      m, "BatchScaleQueryResult")
+      .def_readwrite(
+          "values", &dart::biomechanics::BatchScaleQueryResult::values)
+      .def_readwrite(
+          "gradWrtBodyScales",
+          &dart::biomechanics::BatchScaleQueryResult::gradWrtBodyScales)
+      .def_readwrite(
+          "gradWrtPoses",
+          &dart::biomechanics::BatchScaleQueryResult::gradWrtPoses)
+      .def_readwrite(
+          "gradWrtMarkers",
+          &dart::biomechanics::BatchScaleQueryResult::gradWrtMarkers);
+
+  ::py::class_<
+      dart::biomechanics::BatchScaleQueries,
+      std::shared_ptr<dart::biomechanics::BatchScaleQueries>>(
+      m, "BatchScaleQueries")
+      .def(
+          ::py::init<std::shared_ptr<dynamics::Skeleton>>(),
+          ::py::arg("skel"))
+      .def(
+          "getHeights",
+          &dart::biomechanics::BatchScaleQueries::getHeights,
+          ::py::arg("bodyScales"),
+          ::py::arg("poses"),
+          ::py::arg("up") = Eigen::Vector3s::UnitY(),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getLowestPoints",
+          &dart::biomechanics::BatchScaleQueries::getLowestPoints,
+          ::py::arg("bodyScales"),
+          ::py::arg("poses"),
+          ::py::arg("up") = Eigen::Vector3s::UnitY(),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getAnthropometricLogPDFs",
+          &dart::biomechanics::BatchScaleQueries::getAnthropometricLogPDFs,
+          ::py::arg("anthro"),
+          ::py::arg("bodyScales"),
+          ::py::arg("normalized") = true,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getMarkerDistsToNearestVertex",
+          &dart::biomechanics::BatchScaleQueries::getMarkerDistsToNearestVertex,
+          ::py::arg("bodyName"),
+          ::py::arg("markerOffsets"),
+          ::py::arg("bodyScales"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getSkeleton", &dart::biomechanics::BatchScaleQueries::getSkeleton)
+      .def(
+          "resetClones", &dart::biomechanics::BatchScaleQueries::resetClones);
+}
+
+} // namespace python
+} // namespace dart
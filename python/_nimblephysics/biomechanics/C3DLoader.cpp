@@ -49,6 +49,8 @@ void C3DLoader(py::module& m)
       .def_readwrite(
           "framesPerSecond", &dart::biomechanics::C3D::framesPerSecond)
       .def_readwrite("markers", &dart::biomechanics::C3D::markers)
+      .def_readwrite(
+          "markerTrajectories", &dart::biomechanics::C3D::markerTrajectories)
       .def_readwrite(
           "markerTimesteps", &dart::biomechanics::C3D::markerTimesteps)
       .def_readwrite("forcePlates", &dart::biomechanics::C3D::forcePlates)
@@ -58,20 +60,37 @@ void C3DLoader(py::module& m)
           &dart::biomechanics::C3D::shuffledMarkersMatrix)
       .def_readwrite(
           "shuffledMarkersMatrixMask",
-          &dart::biomechanics::C3D::shuffledMarkersMatrixMask);
+          &dart::biomechanics::C3D::shuffledMarkersMatrixMask)
+      .def(
+          "compactShuffledMarkers",
+          &dart::biomechanics::C3D::compactShuffledMarkers)
+      .def(
+          "getShuffledMarkersMatrix",
+          &dart::biomechanics::C3D::getShuffledMarkersMatrix)
+      .def(
+          "getShuffledMarkersMatrixMask",
+          &dart::biomechanics::C3D::getShuffledMarkersMatrixMask);
 
   ::py::class_<dart::biomechanics::C3DLoader>(m, "C3DLoader")
       .def_static(
-          "loadC3D", &dart::biomechanics::C3DLoader::loadC3D, ::py::arg("uri"))
+          "loadC3D",
+          &dart::biomechanics::C3DLoader::loadC3D,
+          ::py::arg("uri"),
+          ::py::arg("startFrame") = 0,
+          ::py::arg("numFrames") = -1,
+          ::py::arg("fixupFlips") = false,
+          ::py::call_guard<py::gil_scoped_release>())
       .def_static(
           "fixupMarkerFlips",
           &dart::biomechanics::C3DLoader::fixupMarkerFlips,
-          ::py::arg("c3d"))
+          ::py::arg("c3d"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def_static(
           "debugToGUI",
           &dart::biomechanics::C3DLoader::debugToGUI,
           ::py::arg("file"),
-          ::py::arg("server"));
+          ::py::arg("server"),
+          ::py::call_guard<py::gil_scoped_release>());
 }
 
 } // namespace python
@@ -72,6 +72,19 @@ void IKErrorReport(py::module& m)
           ::py::arg("markers"),
           ::py::arg("poses"),
           ::py::arg("observations"))
+      .def(
+          ::py::init<
+              std::shared_ptr<dynamics::Skeleton>,
+              dynamics::MarkerMap,
+              std::vector<std::string>>(),
+          ::py::arg("skeleton"),
+          ::py::arg("markers"),
+          ::py::arg("markerNames"))
+      .def(
+          "addTimesteps",
+          &dart::biomechanics::IKErrorReport::addTimesteps,
+          ::py::arg("poses"),
+          ::py::arg("observations"))
       .def(
           "printReport",
           &dart::biomechanics::IKErrorReport::printReport,
@@ -80,6 +93,15 @@ void IKErrorReport(py::module& m)
           "saveCSVMarkerErrorReport",
           &dart::biomechanics::IKErrorReport::saveCSVMarkerErrorReport,
           ::py::arg("path"))
+      .def(
+          "startStreamingCSVMarkerErrorReport",
+          &dart::biomechanics::IKErrorReport::
+              startStreamingCSVMarkerErrorReport,
+          ::py::arg("path"))
+      .def(
+          "finishStreamingCSVMarkerErrorReport",
+          &dart::biomechanics::IKErrorReport::
+              finishStreamingCSVMarkerErrorReport)
       .def(
           "getSortedMarkerRMSE",
           &dart::biomechanics::IKErrorReport::getSortedMarkerRMSE)
@@ -66,6 +66,11 @@ void LilypadSolver(py::module& m)
           &dart::biomechanics::LilypadSolver::process,
           ::py::arg("poses"),
           ::py::arg("startTime") = 0)
+      .def(
+          "processAppendedFrames",
+          &dart::biomechanics::LilypadSolver::processAppendedFrames,
+          ::py::arg("newPoses"))
+      .def("getNumCells", &dart::biomechanics::LilypadSolver::getNumCells)
       .def(
           "setVerticalVelThreshold",
           &dart::biomechanics::LilypadSolver::setVerticalVelThreshold,
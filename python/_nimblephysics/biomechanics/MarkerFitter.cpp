@@ -32,6 +32,7 @@
 
 #include <Eigen/Dense>
 #include <dart/biomechanics/MarkerFitter.hpp>
+#include <dart/biomechanics/MarkerFitterRemote.hpp>
 #include <dart/dynamics/BodyNode.hpp>
 #include <dart/dynamics/Skeleton.hpp>
 #include <pybind11/eigen.h>
@@ -214,6 +215,32 @@ void MarkerFitter(py::module& m)
           ::py::arg("jointAdjacentMarkers"),
           ::py::arg("jointWeights"));
 
+  ::py::class_<
+      dart::biomechanics::TrajectoryFitDispatcher,
+      std::shared_ptr<dart::biomechanics::TrajectoryFitDispatcher>>(
+      m, "TrajectoryFitDispatcher");
+
+  ::py::class_<
+      dart::biomechanics::MarkerFitterRemote,
+      dart::biomechanics::TrajectoryFitDispatcher,
+      std::shared_ptr<dart::biomechanics::MarkerFitterRemote>>(
+      m, "MarkerFitterRemote")
+      .def(
+          ::py::init([](const std::vector<std::string>& workerAddresses,
+                        const std::string& osimPath) {
+            return std::make_shared<dart::biomechanics::MarkerFitterRemote>(
+                workerAddresses, common::Uri(osimPath));
+          }),
+          ::py::arg("workerAddresses"),
+          ::py::arg("osimPath"));
+
+  ::py::class_<dart::biomechanics::MarkerFitterWorker>(m, "MarkerFitterWorker")
+      .def_static(
+          "serve",
+          &dart::biomechanics::MarkerFitterWorker::serve,
+          ::py::arg("port"),
+          ::py::call_guard<::py::gil_scoped_release>());
+
   ::py::class_<
       dart::biomechanics::MarkerFitter,
       std::shared_ptr<dart::biomechanics::MarkerFitter>>(m, "MarkerFitter")
@@ -235,6 +262,14 @@ void MarkerFitter(py::module& m)
           "setInitialIKMaxRestarts",
           &dart::biomechanics::MarkerFitter::setInitialIKMaxRestarts,
           ::py::arg("starts"))
+      .def(
+          "setUseTemporalWarmStart",
+          &dart::biomechanics::MarkerFitter::setUseTemporalWarmStart,
+          ::py::arg("useWarmStart"))
+      .def(
+          "setUseLevenbergMarquardtIK",
+          &dart::biomechanics::MarkerFitter::setUseLevenbergMarquardtIK,
+          ::py::arg("useLevenbergMarquardt"))
       .def(
           "setMaxMarkerOffset",
           &dart::biomechanics::MarkerFitter::setMaxMarkerOffset,
@@ -243,6 +278,24 @@ void MarkerFitter(py::module& m)
           "setIterationLimit",
           &dart::biomechanics::MarkerFitter::setIterationLimit,
           ::py::arg("iters"))
+      .def(
+          "setUseGaussNewtonHessian",
+          &dart::biomechanics::MarkerFitter::setUseGaussNewtonHessian,
+          ::py::arg("useGaussNewtonHessian"))
+      .def(
+          "setParallelizeTrials",
+          &dart::biomechanics::MarkerFitter::setParallelizeTrials,
+          ::py::arg("parallelizeTrials"))
+      .def(
+          "setBilevelWindow",
+          &dart::biomechanics::MarkerFitter::setBilevelWindow,
+          ::py::arg("windowSize"),
+          ::py::arg("windowOverlap"),
+          ::py::arg("numRounds") = 2)
+      .def(
+          "setTrajectoryFitDispatcher",
+          &dart::biomechanics::MarkerFitter::setTrajectoryFitDispatcher,
+          ::py::arg("dispatcher"))
       .def(
           "setAnthropometricPrior",
           &dart::biomechanics::MarkerFitter::setAnthropometricPrior,
@@ -266,36 +319,52 @@ void MarkerFitter(py::module& m)
           &dart::biomechanics::MarkerFitter::getInitialization,
           ::py::arg("markerObservations"),
           ::py::arg("newClip"),
-          ::py::arg("params") = dart::biomechanics::InitialMarkerFitParams())
+          ::py::arg("params") = dart::biomechanics::InitialMarkerFitParams(),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "findJointCenters",
           &dart::biomechanics::MarkerFitter::findJointCenters,
           ::py::arg("initializations"),
           ::py::arg("newClip"),
-          ::py::arg("markerObservations"))
+          ::py::arg("markerObservations"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "optimizeBilevel",
           &dart::biomechanics::MarkerFitter::optimizeBilevel,
           ::py::arg("markerObservations"),
           ::py::arg("initialization"),
           ::py::arg("numSamples"),
-          ::py::arg("applyInnerProblemGradientConstraints") = true)
+          ::py::arg("applyInnerProblemGradientConstraints") = true,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "optimizeBilevelWindowed",
+          &dart::biomechanics::MarkerFitter::optimizeBilevelWindowed,
+          ::py::arg("markerObservations"),
+          ::py::arg("initialization"),
+          ::py::arg("samplesPerWindow"),
+          ::py::arg("windowSize"),
+          ::py::arg("windowOverlap"),
+          ::py::arg("numRounds") = 2,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "generateDataErrorsReport",
           &dart::biomechanics::MarkerFitter::generateDataErrorsReport,
-          ::py::arg("markerObservations"))
+          ::py::arg("markerObservations"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "checkForFlippedMarkers",
           &dart::biomechanics::MarkerFitter::checkForFlippedMarkers,
           ::py::arg("markerObservations"),
           ::py::arg("init"),
-          ::py::arg("report"))
+          ::py::arg("report"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runMultiTrialKinematicsPipeline",
           &dart::biomechanics::MarkerFitter::runMultiTrialKinematicsPipeline,
           ::py::arg("markerTrials"),
           ::py::arg("params"),
-          ::py::arg("numSamples") = 50)
+          ::py::arg("numSamples") = 50,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runKinematicsPipeline",
           &dart::biomechanics::MarkerFitter::runKinematicsPipeline,
@@ -303,12 +372,14 @@ void MarkerFitter(py::module& m)
           ::py::arg("newClip"),
           ::py::arg("params"),
           ::py::arg("numSamples") = 20,
-          ::py::arg("skipFinalIK") = false)
+          ::py::arg("skipFinalIK") = false,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runPrescaledPipeline",
           &dart::biomechanics::MarkerFitter::runPrescaledPipeline,
           ::py::arg("markerObservations"),
-          ::py::arg("params"))
+          ::py::arg("params"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setMinJointVarianceCutoff",
           &dart::biomechanics::MarkerFitter::setMinJointVarianceCutoff,
@@ -358,6 +429,10 @@ void MarkerFitter(py::module& m)
           "setTrackingMarkerDefaultWeight",
           &dart::biomechanics::MarkerFitter::setTrackingMarkerDefaultWeight,
           ::py::arg("weight"))
+      .def(
+          "setUseLBFGSBForJointFits",
+          &dart::biomechanics::MarkerFitter::setUseLBFGSBForJointFits,
+          ::py::arg("useLBFGSB"))
       .def(
           "debugTrajectoryAndMarkersToGUI",
           &dart::biomechanics::MarkerFitter::debugTrajectoryAndMarkersToGUI,
@@ -366,7 +441,8 @@ void MarkerFitter(py::module& m)
           ::py::arg("markerObservations"),
           ::py::arg("forcePlates") = nullptr,
           ::py::arg("goldOsim") = nullptr,
-          ::py::arg("goldPoses") = Eigen::MatrixXs::Zero(0, 0))
+          ::py::arg("goldPoses") = Eigen::MatrixXs::Zero(0, 0),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "saveTrajectoryAndMarkersToGUI",
           &dart::biomechanics::MarkerFitter::saveTrajectoryAndMarkersToGUI,
@@ -376,7 +452,8 @@ void MarkerFitter(py::module& m)
           ::py::arg("frameRate"),
           ::py::arg("forcePlates") = nullptr,
           ::py::arg("goldOsim") = nullptr,
-          ::py::arg("goldPoses") = Eigen::MatrixXs::Zero(0, 0))
+          ::py::arg("goldPoses") = Eigen::MatrixXs::Zero(0, 0),
+          ::py::call_guard<py::gil_scoped_release>())
       .def_static(
           "pickSubset",
           &dart::biomechanics::MarkerFitter::pickSubset,
@@ -37,6 +37,9 @@ void MarkerLabeller(py::module& m)
           &dart::biomechanics::MarkerTrace::mBodyClosestPointDistance);
 
   ::py::class_<dart::biomechanics::LabelledMarkers>(m, "LabelledMarkers")
+      .def_readwrite(
+          "markerTrajectories",
+          &dart::biomechanics::LabelledMarkers::markerTrajectories)
       .def_readwrite(
           "markerObservations",
           &dart::biomechanics::LabelledMarkers::markerObservations)
@@ -60,7 +63,8 @@ void MarkerLabeller(py::module& m)
           "labelPointClouds",
           &dart::biomechanics::MarkerLabeller::labelPointClouds,
           ::py::arg("pointClouds"),
-          ::py::arg("mergeMarkersThreshold") = 0.01)
+          ::py::arg("mergeMarkersThreshold") = 0.01,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "matchUpJointToSkeletonJoint",
           &dart::biomechanics::MarkerLabeller::matchUpJointToSkeletonJoint,
@@ -68,9 +72,30 @@ void MarkerLabeller(py::module& m)
           ::py::arg("skeletonJointName"))
       .def(
           "evaluate",
-          &dart::biomechanics::MarkerLabeller::evaluate,
+          +[](dart::biomechanics::MarkerLabeller* self,
+              const std::map<std::string,
+                             std::pair<std::string, Eigen::Vector3s>>&
+                  markerOffsets,
+              const std::vector<std::map<std::string, Eigen::Vector3s>>&
+                  labeledPointClouds) {
+            self->evaluate(markerOffsets, labeledPointClouds);
+          },
+          ::py::arg("markerOffsets"),
+          ::py::arg("labeledPointClouds"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "evaluate",
+          +[](dart::biomechanics::MarkerLabeller* self,
+              const std::map<std::string,
+                             std::pair<std::string, Eigen::Vector3s>>&
+                  markerOffsets,
+              const dart::biomechanics::MarkerTrajectories&
+                  labeledPointClouds) {
+            self->evaluate(markerOffsets, labeledPointClouds);
+          },
           ::py::arg("markerOffsets"),
-          ::py::arg("labeledPointClouds"));
+          ::py::arg("labeledPointClouds"),
+          ::py::call_guard<py::gil_scoped_release>());
 
   ::py::class_<
       dart::biomechanics::MarkerLabellerMock,
@@ -84,6 +109,17 @@ void MarkerLabeller(py::module& m)
   ::py::class_<
       dart::biomechanics::NeuralMarkerLabeller,
       dart::biomechanics::MarkerLabeller>(m, "NeuralMarkerLabeller")
+      // This goes first, so that calls with only a predictor fall through to
+      // the per-frame constructor below
+      .def(
+          ::py::init<
+              dart::biomechanics::NeuralMarkerLabeller::
+                  BatchedJointCenterPredictor,
+              const std::vector<std::string>&,
+              int>(),
+          ::py::arg("batchedJointCenterPredictor"),
+          ::py::arg("jointNames"),
+          ::py::arg("maxBatchSize") = 0)
       .def(
           ::py::init<
               std::function<std::vector<std::map<std::string, Eigen::Vector3s>>(
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Eigen/Dense>
+#include <dart/biomechanics/MarkerTrajectories.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void MarkerTrajectories(py::module& m)
+{
+  ::py::class_<dart::biomechanics::MarkerTrajectories>(m, "MarkerTrajectories")
+      .def(::py::init<>())
+      .def(
+          ::py::init<const std::vector<std::string>&, int>(),
+          ::py::arg("markerNames"),
+          ::py::arg("numFrames"))
+      .def_static(
+          "fromFrameMaps",
+          &dart::biomechanics::MarkerTrajectories::fromFrameMaps,
+          ::py::arg("frames"))
+      .def(
+          "toFrameMaps",
+          &dart::biomechanics::MarkerTrajectories::toFrameMaps)
+      .def(
+          "getNumFrames",
+          &dart::biomechanics::MarkerTrajectories::getNumFrames)
+      .def(
+          "getNumMarkers",
+          &dart::biomechanics::MarkerTrajectories::getNumMarkers)
+      .def(
+          "getMarkerNames",
+          &dart::biomechanics::MarkerTrajectories::getMarkerNames)
+      .def(
+          "getMarkerIndex",
+          &dart::biomechanics::MarkerTrajectories::getMarkerIndex,
+          ::py::arg("name"))
+      .def(
+          "isVisible",
+          &dart::biomechanics::MarkerTrajectories::isVisible,
+          ::py::arg("frame"),
+          ::py::arg("marker"))
+      .def(
+          "getNumVisible",
+          &dart::biomechanics::MarkerTrajectories::getNumVisible,
+          ::py::arg("frame"))
+      .def(
+          "getPosition",
+          &dart::biomechanics::MarkerTrajectories::getPosition,
+          ::py::arg("frame"),
+          ::py::arg("marker"))
+      .def(
+          "setPosition",
+          &dart::biomechanics::MarkerTrajectories::setPosition,
+          ::py::arg("frame"),
+          ::py::arg("marker"),
+          ::py::arg("position"))
+      .def(
+          "setHidden",
+          &dart::biomechanics::MarkerTrajectories::setHidden,
+          ::py::arg("frame"),
+          ::py::arg("marker"))
+      .def(
+          "getPositions",
+          +[](const dart::biomechanics::MarkerTrajectories* self)
+              -> Eigen::MatrixXs { return self->getPositions(); })
+      .def(
+          "getFramePositions",
+          +[](const dart::biomechanics::MarkerTrajectories* self,
+              int frame) -> Eigen::MatrixXs {
+            return self->getFramePositions(frame);
+          },
+          ::py::arg("frame"));
+}
+
+} // namespace python
+} // namespace dart
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <memory>
+
+#include <dart/biomechanics/OpenSimBatchExporter.hpp>
+#include <dart/dynamics/Skeleton.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void OpenSimBatchExporter(py::module& m)
+{
+  ::py::class_<dart::biomechanics::OpenSimExportTrial>(m, "OpenSimExportTrial")
+      .def(::py::init<>())
+      .def_readwrite("name", &dart::biomechanics::OpenSimExportTrial::name)
+      .def_readwrite(
+          "timestamps", &dart::biomechanics::OpenSimExportTrial::timestamps)
+      .def_readwrite("poses", &dart::biomechanics::OpenSimExportTrial::poses)
+      .def_readwrite(
+          "forcePlates", &dart::biomechanics::OpenSimExportTrial::forcePlates)
+      .def_readwrite(
+          "markerTimesteps",
+          &dart::biomechanics::OpenSimExportTrial::markerTimesteps);
+
+  ::py::class_<
+      dart::biomechanics::OpenSimBatchExporter,
+      std::shared_ptr<dart::biomechanics::OpenSimBatchExporter>>(
+      m, "OpenSimBatchExporter")
+      .def(
+          ::py::init([](const common::Uri& uri) {
+            return std::make_shared<dart::biomechanics::OpenSimBatchExporter>(
+                uri);
+          }),
+          ::py::arg("inputPath"))
+      .def("isValid", &dart::biomechanics::OpenSimBatchExporter::isValid)
+      .def(
+          "saveMovedMarkers",
+          &dart::biomechanics::OpenSimBatchExporter::saveMovedMarkers,
+          ::py::arg("bodyScales"),
+          ::py::arg("markerOffsets"),
+          ::py::arg("outputPath"))
+      .def(
+          "saveJustMarkers",
+          &dart::biomechanics::OpenSimBatchExporter::saveJustMarkers,
+          ::py::arg("bodyScales"),
+          ::py::arg("markerOffsets"),
+          ::py::arg("outputPath"))
+      .def(
+          "saveTrials",
+          &dart::biomechanics::OpenSimBatchExporter::saveTrials,
+          ::py::arg("skel"),
+          ::py::arg("markerNames"),
+          ::py::arg("modelFileName"),
+          ::py::arg("trials"),
+          ::py::arg("outputFolder"),
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
@@ -70,9 +70,14 @@ void OpenSimParser(py::module& m)
 
   ::py::class_<dart::biomechanics::OpenSimMot>(m, "OpenSimMot")
       .def_readwrite("poses", &dart::biomechanics::OpenSimMot::poses)
-      .def_readwrite("timestamps", &dart::biomechanics::OpenSimMot::timestamps);
+      .def_readwrite("timestamps", &dart::biomechanics::OpenSimMot::timestamps)
+      .def("compactPoses", &dart::biomechanics::OpenSimMot::compactPoses)
+      .def("getPoses", &dart::biomechanics::OpenSimMot::getPoses);
 
   ::py::class_<dart::biomechanics::OpenSimTRC>(m, "OpenSimTRC")
+      .def_readwrite(
+          "markerTrajectories",
+          &dart::biomechanics::OpenSimTRC::markerTrajectories)
       .def_readwrite(
           "markerTimesteps", &dart::biomechanics::OpenSimTRC::markerTimesteps)
       .def_readwrite(
@@ -101,7 +106,24 @@ void OpenSimParser(py::module& m)
       +[](const std::string& path) {
         return dart::biomechanics::OpenSimParser::parseOsim(path);
       },
-      ::py::arg("path"));
+      ::py::arg("path"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "parseOsimUncached",
+      +[](const std::string& path) {
+        return dart::biomechanics::OpenSimParser::parseOsimUncached(path);
+      },
+      ::py::arg("path"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "setParseCacheEnabled",
+      &dart::biomechanics::OpenSimParser::setParseCacheEnabled,
+      ::py::arg("enabled"));
+
+  sm.def(
+      "clearParseCache", &dart::biomechanics::OpenSimParser::clearParseCache);
 
   sm.def(
       "saveOsimScalingXMLFile",
@@ -245,7 +267,8 @@ void OpenSimParser(py::module& m)
       +[](const std::string& path) {
         return dart::biomechanics::OpenSimParser::loadTRC(path);
       },
-      ::py::arg("path"));
+      ::py::arg("path"),
+      ::py::call_guard<py::gil_scoped_release>());
 
   sm.def(
       "loadGRF",
@@ -254,7 +277,8 @@ void OpenSimParser(py::module& m)
             path, targetFramesPerSecond);
       },
       ::py::arg("path"),
-      ::py::arg("targetFramesPerSecond") = 100);
+      ::py::arg("targetFramesPerSecond") = 100,
+      ::py::call_guard<py::gil_scoped_release>());
 
   sm.def(
       "saveTRC",
@@ -267,7 +291,8 @@ void OpenSimParser(py::module& m)
       },
       ::py::arg("path"),
       ::py::arg("timestamps"),
-      ::py::arg("markerTimestamps"));
+      ::py::arg("markerTimestamps"),
+      ::py::call_guard<py::gil_scoped_release>());
 
   sm.def(
       "loadMot",
@@ -275,7 +300,8 @@ void OpenSimParser(py::module& m)
         return dart::biomechanics::OpenSimParser::loadMot(skel, path);
       },
       ::py::arg("skel"),
-      ::py::arg("path"));
+      ::py::arg("path"),
+      ::py::call_guard<py::gil_scoped_release>());
 
   sm.def(
       "loadMotAtLowestMarkerRMSERotation",
@@ -287,7 +313,8 @@ void OpenSimParser(py::module& m)
       },
       ::py::arg("osim"),
       ::py::arg("path"),
-      ::py::arg("c3d"));
+      ::py::arg("c3d"),
+      ::py::call_guard<py::gil_scoped_release>());
 
   sm.def(
       "saveMot",
@@ -301,7 +328,8 @@ void OpenSimParser(py::module& m)
       ::py::arg("skel"),
       ::py::arg("path"),
       ::py::arg("timestamps"),
-      ::py::arg("poses"));
+      ::py::arg("poses"),
+      ::py::call_guard<py::gil_scoped_release>());
 
   sm.def(
       "saveGRFMot",
@@ -313,13 +341,79 @@ void OpenSimParser(py::module& m)
       },
       ::py::arg("outputPath"),
       ::py::arg("timestamps"),
-      ::py::arg("forcePlates"));
+      ::py::arg("forcePlates"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "saveTRCBinary",
+      +[](const std::string& outputPath,
+          const dart::biomechanics::OpenSimTRC& trc) {
+        return dart::biomechanics::OpenSimParser::saveTRCBinary(
+            outputPath, trc);
+      },
+      ::py::arg("outputPath"),
+      ::py::arg("trc"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "loadTRCBinary",
+      +[](const std::string& path) {
+        return dart::biomechanics::OpenSimParser::loadTRCBinary(path);
+      },
+      ::py::arg("path"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "saveMotBinary",
+      +[](std::shared_ptr<dynamics::Skeleton> skel,
+          const std::string& outputPath,
+          const std::vector<double>& timestamps,
+          const Eigen::MatrixXs& poses) {
+        return dart::biomechanics::OpenSimParser::saveMotBinary(
+            skel, outputPath, timestamps, poses);
+      },
+      ::py::arg("skel"),
+      ::py::arg("outputPath"),
+      ::py::arg("timestamps"),
+      ::py::arg("poses"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "loadMotBinary",
+      +[](std::shared_ptr<dynamics::Skeleton> skel, const std::string& path) {
+        return dart::biomechanics::OpenSimParser::loadMotBinary(skel, path);
+      },
+      ::py::arg("skel"),
+      ::py::arg("path"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "saveGRFBinary",
+      +[](const std::string& outputPath,
+          const std::vector<double>& timestamps,
+          const std::vector<biomechanics::ForcePlate> forcePlates) {
+        return dart::biomechanics::OpenSimParser::saveGRFBinary(
+            outputPath, timestamps, forcePlates);
+      },
+      ::py::arg("outputPath"),
+      ::py::arg("timestamps"),
+      ::py::arg("forcePlates"),
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "loadGRFBinary",
+      +[](const std::string& path) {
+        return dart::biomechanics::OpenSimParser::loadGRFBinary(path);
+      },
+      ::py::arg("path"),
+      ::py::call_guard<py::gil_scoped_release>());
 
   sm.def(
       "getScaleAndMarkerOffsets",
       &dart::biomechanics::OpenSimParser::getScaleAndMarkerOffsets,
       ::py::arg("standardSkeleton"),
-      ::py::arg("scaledSkeleton"));
+      ::py::arg("scaledSkeleton"),
+      ::py::call_guard<py::gil_scoped_release>());
 }
 
 } // namespace python
@@ -60,6 +60,10 @@ void SkeletonConverter(py::module& m)
           &dart::biomechanics::SkeletonConverter::linkJoints,
           ::py::arg("sourceJoint"),
           ::py::arg("targetJoint"))
+      .def(
+          "setUseLevenbergMarquardt",
+          &dart::biomechanics::SkeletonConverter::setUseLevenbergMarquardt,
+          ::py::arg("useLevenbergMarquardt"))
       .def(
           "rescaleAndPrepTarget",
           &dart::biomechanics::SkeletonConverter::rescaleAndPrepTarget,
@@ -77,7 +81,8 @@ void SkeletonConverter(py::module& m)
           ::py::arg("maxStepCount") = 100,
           ::py::arg("leastSquaresDamping") = 0.01,
           ::py::arg("lineSearch") = true,
-          ::py::arg("logOutput") = false)
+          ::py::arg("logOutput") = false,
+          ::py::arg("maxRestarts") = 1)
       .def(
           "fitTargetToSource",
           &dart::biomechanics::SkeletonConverter::fitTargetToSource,
@@ -96,6 +101,18 @@ void SkeletonConverter(py::module& m)
           ::py::arg("leastSquaresDamping") = 0.01,
           ::py::arg("lineSearch") = true,
           ::py::arg("logIKOutput") = false)
+      .def(
+          "convertMotionParallel",
+          &dart::biomechanics::SkeletonConverter::convertMotionParallel,
+          ::py::arg("targetMotion"),
+          ::py::arg("numChunks") = 0,
+          ::py::arg("regressionRatio") = 2.0,
+          ::py::arg("maxRestarts") = 5,
+          ::py::arg("convergenceThreshold") = 1e-7,
+          ::py::arg("maxStepCount") = 100,
+          ::py::arg("leastSquaresDamping") = 0.01,
+          ::py::arg("lineSearch") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getSourceJointWorldPositions",
           &dart::biomechanics::SkeletonConverter::getSourceJointWorldPositions)
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Eigen/Dense>
+#include <dart/biomechanics/StreamingMarkerFitter.hpp>
+#include <dart/dynamics/BodyNode.hpp>
+#include <dart/dynamics/Skeleton.hpp>
+#include <dart/server/GUIWebsocketServer.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void StreamingMarkerFitter(py::module& m)
+{
+  ::py::class_<dart::biomechanics::StreamingFrame>(m, "StreamingFrame")
+      .def_readonly("time", &dart::biomechanics::StreamingFrame::time)
+      .def_readonly("pose", &dart::biomechanics::StreamingFrame::pose)
+      .def_readonly(
+          "pointLabels", &dart::biomechanics::StreamingFrame::pointLabels)
+      .def_readonly(
+          "markerObservations",
+          &dart::biomechanics::StreamingFrame::markerObservations)
+      .def_readonly(
+          "rmsMarkerError", &dart::biomechanics::StreamingFrame::rmsMarkerError)
+      .def_readonly(
+          "solveSeconds", &dart::biomechanics::StreamingFrame::solveSeconds);
+
+  ::py::class_<dart::biomechanics::StreamingMarkerFitter>(
+      m, "StreamingMarkerFitter")
+      .def(
+          ::py::init<
+              std::shared_ptr<dynamics::Skeleton>,
+              dynamics::MarkerMap,
+              s_t,
+              int>(),
+          ::py::arg("skeleton"),
+          ::py::arg("markers"),
+          ::py::arg("mergeDistance") = 0.01,
+          ::py::arg("mergeFrames") = 5)
+      .def(
+          "setLabelDistance",
+          &dart::biomechanics::StreamingMarkerFitter::setLabelDistance,
+          ::py::arg("distance"))
+      .def(
+          "setMaxIKStepsPerFrame",
+          &dart::biomechanics::StreamingMarkerFitter::setMaxIKStepsPerFrame,
+          ::py::arg("steps"))
+      .def(
+          "setUseLevenbergMarquardt",
+          &dart::biomechanics::StreamingMarkerFitter::setUseLevenbergMarquardt,
+          ::py::arg("useLevenbergMarquardt"))
+      .def(
+          "setGUIServer",
+          &dart::biomechanics::StreamingMarkerFitter::setGUIServer,
+          ::py::arg("server"),
+          ::py::arg("prefix") = "live_")
+      .def(
+          "setFrameCallback",
+          &dart::biomechanics::StreamingMarkerFitter::setFrameCallback,
+          ::py::arg("callback"))
+      .def(
+          "reset",
+          &dart::biomechanics::StreamingMarkerFitter::reset,
+          ::py::arg("pose"))
+      .def(
+          "observePointCloud",
+          &dart::biomechanics::StreamingMarkerFitter::observePointCloud,
+          ::py::arg("pointCloud"))
+      .def(
+          "observeLabelledMarkers",
+          &dart::biomechanics::StreamingMarkerFitter::observeLabelledMarkers,
+          ::py::arg("markerObservations"))
+      .def("getPose", &dart::biomechanics::StreamingMarkerFitter::getPose);
+}
+
+} // namespace python
+} // namespace dart
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Eigen/Dense>
+#include <dart/biomechanics/StreamingMarkerFitter.hpp>
+#include <dart/dynamics/BodyNode.hpp>
+#include <dart/dynamics/Skeleton.hpp>
+#include <dart/server/GUIWebsocketServer.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <Eigen/Dense>
+#include <dart/biomechanics/SubjectOnDisk.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void SubjectOnDisk(py::module& m)
+{
+  ::py::class_<dart::biomechanics::SubjectOnDiskTrial>(m, "SubjectOnDiskTrial")
+      .def(::py::init<>())
+      .def_readwrite("name", &dart::biomechanics::SubjectOnDiskTrial::name)
+      .def_readwrite(
+          "timestep", &dart::biomechanics::SubjectOnDiskTrial::timestep)
+      .def_readwrite("poses", &dart::biomechanics::SubjectOnDiskTrial::poses)
+      .def_readwrite(
+          "velocities", &dart::biomechanics::SubjectOnDiskTrial::velocities)
+      .def_readwrite(
+          "accelerations",
+          &dart::biomechanics::SubjectOnDiskTrial::accelerations)
+      .def_readwrite(
+          "forcePlates", &dart::biomechanics::SubjectOnDiskTrial::forcePlates)
+      .def_readwrite(
+          "markerRMSErrors",
+          &dart::biomechanics::SubjectOnDiskTrial::markerRMSErrors);
+
+  ::py::class_<dart::biomechanics::SubjectOnDiskFrames>(
+      m, "SubjectOnDiskFrames")
+      .def_readonly(
+          "startFrame", &dart::biomechanics::SubjectOnDiskFrames::startFrame)
+      .def_readonly("poses", &dart::biomechanics::SubjectOnDiskFrames::poses)
+      .def_readonly(
+          "velocities", &dart::biomechanics::SubjectOnDiskFrames::velocities)
+      .def_readonly(
+          "accelerations",
+          &dart::biomechanics::SubjectOnDiskFrames::accelerations)
+      .def_readonly(
+          "grfForces", &dart::biomechanics::SubjectOnDiskFrames::grfForces)
+      .def_readonly(
+          "grfCentersOfPressure",
+          &dart::biomechanics::SubjectOnDiskFrames::grfCentersOfPressure)
+      .def_readonly(
+          "grfMoments", &dart::biomechanics::SubjectOnDiskFrames::grfMoments)
+      .def_readonly(
+          "markerRMSErrors",
+          &dart::biomechanics::SubjectOnDiskFrames::markerRMSErrors);
+
+  ::py::class_<
+      dart::biomechanics::SubjectOnDisk,
+      std::shared_ptr<dart::biomechanics::SubjectOnDisk>>(m, "SubjectOnDisk")
+      .def_static(
+          "writeSubject",
+          [](const std::string& outputPath,
+             const std::string& osimPath,
+             const Eigen::VectorXs& bodyScales,
+             const std::map<std::string, Eigen::Vector3s>& markerOffsets,
+             const std::vector<dart::biomechanics::SubjectOnDiskTrial>&
+                 trials) {
+            return dart::biomechanics::SubjectOnDisk::writeSubject(
+                outputPath,
+                common::Uri::createFromStringOrPath(osimPath),
+                bodyScales,
+                markerOffsets,
+                trials);
+          },
+          ::py::arg("outputPath"),
+          ::py::arg("osimPath"),
+          ::py::arg("bodyScales"),
+          ::py::arg("markerOffsets"),
+          ::py::arg("trials"))
+      .def_static(
+          "load",
+          &dart::biomechanics::SubjectOnDisk::load,
+          ::py::arg("path"))
+      .def(
+          "readOpenSimFile",
+          &dart::biomechanics::SubjectOnDisk::readOpenSimFile)
+      .def(
+          "getOsimFileContents",
+          &dart::biomechanics::SubjectOnDisk::getOsimFileContents)
+      .def("getNumDofs", &dart::biomechanics::SubjectOnDisk::getNumDofs)
+      .def("getDofNames", &dart::biomechanics::SubjectOnDisk::getDofNames)
+      .def("getBodyScales", &dart::biomechanics::SubjectOnDisk::getBodyScales)
+      .def(
+          "getMarkerOffsets",
+          &dart::biomechanics::SubjectOnDisk::getMarkerOffsets)
+      .def("getNumTrials", &dart::biomechanics::SubjectOnDisk::getNumTrials)
+      .def(
+          "getTrialName",
+          &dart::biomechanics::SubjectOnDisk::getTrialName,
+          ::py::arg("trial"))
+      .def(
+          "getTrialTimestep",
+          &dart::biomechanics::SubjectOnDisk::getTrialTimestep,
+          ::py::arg("trial"))
+      .def(
+          "getTrialLength",
+          &dart::biomechanics::SubjectOnDisk::getTrialLength,
+          ::py::arg("trial"))
+      .def(
+          "getTrialNumForcePlates",
+          &dart::biomechanics::SubjectOnDisk::getTrialNumForcePlates,
+          ::py::arg("trial"))
+      .def(
+          "readFrames",
+          &dart::biomechanics::SubjectOnDisk::readFrames,
+          ::py::arg("trial"),
+          ::py::arg("startFrame"),
+          ::py::arg("numFrames"));
+}
+
+} // namespace python
+} // namespace dart
@@ -41,12 +41,17 @@ namespace dart {
 namespace python {
 
 void ForcePlate(py::module& sm);
+void MarkerTrajectories(py::module& sm);
 void LilypadSolver(py::module& sm);
 void BatchGaitInverseDynamics(py::module& sm);
 void OpenSimParser(py::module& sm);
+void OpenSimBatchExporter(py::module& sm);
+void BatchScaleQueries(py::module& sm);
 void SkeletonConverter(py::module& sm);
 void MarkerFitter(py::module& sm);
 void MarkerLabeller(py::module& sm);
+void StreamingMarkerFitter(py::module& sm);
+void SubjectOnDisk(py::module& sm);
 void IKErrorReport(py::module& sm);
 void Anthropometrics(py::module& sm);
 void C3DLoader(py::module& sm);
@@ -60,12 +65,17 @@ void dart_biomechanics(py::module& m)
         "dynamics and (eventually) mocap support and muscle estimation.";
 
   ForcePlate(sm);
+  MarkerTrajectories(sm);
   LilypadSolver(sm);
   BatchGaitInverseDynamics(sm);
   OpenSimParser(sm);
+  OpenSimBatchExporter(sm);
+  BatchScaleQueries(sm);
   SkeletonConverter(sm);
   MarkerFitter(sm);
   MarkerLabeller(sm);
+  StreamingMarkerFitter(sm);
+  SubjectOnDisk(sm);
   IKErrorReport(sm);
   Anthropometrics(sm);
   C3DLoader(sm);
@@ -32,6 +32,7 @@
 
 #include <dart/collision/CollisionDetector.hpp>
 #include <dart/collision/CollisionGroup.hpp>
+#include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 
 namespace py = pybind11;
@@ -187,6 +188,12 @@ void CollisionGroup(py::module& m)
           ::py::arg("to"),
           ::py::arg("option"),
           ::py::arg("result"))
+      .def(
+          "raycastBatch",
+          &dart::collision::CollisionGroup::raycastBatch,
+          ::py::arg("origins"),
+          ::py::arg("directions"),
+          ::py::arg("numThreads") = 0)
       .def(
           "setAutomaticUpdate",
           +[](dart::collision::CollisionGroup* self) {
@@ -42,6 +42,7 @@ void Contact(py::module& sm);
 
 void CollisionOption(py::module& sm);
 void CollisionResult(py::module& sm);
+void RaycastBatchResult(py::module& sm);
 
 void CollisionDetector(py::module& sm);
 void DARTCollisionDetector(py::module& sm);
@@ -57,6 +58,7 @@ void dart_collision(py::module& m)
 
   CollisionOption(sm);
   CollisionResult(sm);
+  RaycastBatchResult(sm);
 
   CollisionDetector(sm);
   DARTCollisionDetector(sm);
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dart/common/Pipeline.hpp>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+namespace {
+
+// Items get moved between stage threads without the GIL, so we hold them by
+// a shared_ptr, which only touches the Python refcount when it's freed
+using PyPipelineItem = std::shared_ptr<py::object>;
+
+PyPipelineItem wrapPipelineItem(py::object object)
+{
+  return PyPipelineItem(new py::object(std::move(object)), [](py::object* o) {
+    py::gil_scoped_acquire gil;
+    delete o;
+  });
+}
+
+py::list unwrapPipelineItems(const std::vector<PyPipelineItem>& items)
+{
+  py::list list;
+  for (const PyPipelineItem& item : items)
+  {
+    list.append(*item);
+  }
+  return list;
+}
+
+// This makes sure a pipeline that's garbage collected while running doesn't
+// deadlock, with its workers waiting on the GIL we're holding
+class PyPipeline : public dart::common::Pipeline<PyPipelineItem>
+{
+public:
+  ~PyPipeline()
+  {
+    if (isRunning())
+    {
+      py::gil_scoped_release release;
+      finish();
+    }
+  }
+};
+
+} // namespace
+
+void Pipeline(py::module& m)
+{
+  ::py::class_<dart::common::PipelineStageStats>(m, "PipelineStageStats")
+      .def_readonly("name", &dart::common::PipelineStageStats::name)
+      .def_readonly("numWorkers", &dart::common::PipelineStageStats::numWorkers)
+      .def_readonly(
+          "queueCapacity", &dart::common::PipelineStageStats::queueCapacity)
+      .def_readonly(
+          "itemsProcessed", &dart::common::PipelineStageStats::itemsProcessed)
+      .def_readonly(
+          "itemsFailed", &dart::common::PipelineStageStats::itemsFailed)
+      .def_readonly(
+          "busySeconds", &dart::common::PipelineStageStats::busySeconds)
+      .def_readonly(
+          "waitingForInputSeconds",
+          &dart::common::PipelineStageStats::waitingForInputSeconds)
+      .def_readonly(
+          "waitingForOutputSeconds",
+          &dart::common::PipelineStageStats::waitingForOutputSeconds)
+      .def_readonly(
+          "maxQueueDepth", &dart::common::PipelineStageStats::maxQueueDepth)
+      .def_readonly(
+          "itemsPerSecond", &dart::common::PipelineStageStats::itemsPerSecond)
+      .def_readonly(
+          "utilization", &dart::common::PipelineStageStats::utilization);
+
+  ::py::class_<dart::common::PipelineFailure>(m, "PipelineFailure")
+      .def_readonly("index", &dart::common::PipelineFailure::index)
+      .def_readonly("stage", &dart::common::PipelineFailure::stage)
+      .def_readonly("message", &dart::common::PipelineFailure::message);
+
+  ::py::class_<PyPipeline>(
+      m,
+      "Pipeline",
+      "This runs items through a series of stages, each with its own worker "
+      "threads and a bounded queue in front of it, so that (for example) the "
+      "next trial's C3D file loads while this trial is being fit. Each stage "
+      "is a function that takes the item, and returns either None (if it "
+      "edited the item in place) or the item to hand to the next stage. "
+      "Stages hold the GIL while they run Python code, so they overlap when "
+      "they spend their time in nimblephysics calls that release it, like "
+      "file loading and MarkerFitter.")
+      .def(::py::init<>())
+      .def(
+          "addStage",
+          +[](PyPipeline* self,
+              const std::string& name,
+              py::function fn,
+              int numWorkers,
+              int queueCapacity) -> PyPipeline* {
+            self->addStage(
+                name,
+                [fn](PyPipelineItem& item) {
+                  std::string error;
+                  {
+                    py::gil_scoped_acquire gil;
+                    try
+                    {
+                      py::object result = fn(*item);
+                      if (!result.is_none())
+                        *item = result;
+                    }
+                    catch (py::error_already_set& e)
+                    {
+                      error = e.what();
+                    }
+                  }
+                  if (!error.empty())
+                    throw std::runtime_error(error);
+                },
+                numWorkers,
+                queueCapacity);
+            return self;
+          },
+          ::py::arg("name"),
+          ::py::arg("fn"),
+          ::py::arg("numWorkers") = 1,
+          ::py::arg("queueCapacity") = 2,
+          ::py::return_value_policy::reference_internal)
+      .def("getNumStages", &PyPipeline::getNumStages)
+      .def(
+          "start",
+          &PyPipeline::start,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "push",
+          +[](PyPipeline* self, py::object item) -> int {
+            PyPipelineItem wrapped = wrapPipelineItem(item);
+            py::gil_scoped_release release;
+            return self->push(std::move(wrapped));
+          },
+          ::py::arg("item"))
+      .def(
+          "finish",
+          +[](PyPipeline* self) -> py::list {
+            std::vector<PyPipelineItem> results;
+            {
+              py::gil_scoped_release release;
+              results = self->finish();
+            }
+            return unwrapPipelineItems(results);
+          })
+      .def(
+          "run",
+          +[](PyPipeline* self, py::list items) -> py::list {
+            std::vector<PyPipelineItem> wrapped;
+            for (py::handle item : items)
+            {
+              wrapped.push_back(
+                  wrapPipelineItem(py::reinterpret_borrow<py::object>(item)));
+            }
+            std::vector<PyPipelineItem> results;
+            {
+              py::gil_scoped_release release;
+              results = self->run(std::move(wrapped));
+            }
+            return unwrapPipelineItems(results);
+          },
+          ::py::arg("items"))
+      .def("isRunning", &PyPipeline::isRunning)
+      .def("getStageStats", &PyPipeline::getStageStats)
+      .def("getFailures", &PyPipeline::getFailures);
+}
+
+} // namespace python
+} // namespace dart
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/common/ThreadPool.hpp>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void ThreadPool(py::module& m)
+{
+  m.def(
+      "setNumThreads",
+      +[](std::size_t numThreads) {
+        dart::common::ThreadPool::setGlobalNumThreads(numThreads);
+      },
+      ::py::arg("numThreads"),
+      "Set the number of workers in the thread pool shared by all of "
+      "nimblephysics. Passing 0 picks the default, which is the "
+      "DART_NUM_THREADS environment variable if it's set, or the number of "
+      "hardware threads otherwise.");
+  m.def(
+      "getNumThreads",
+      +[]() -> std::size_t {
+        return dart::common::ThreadPool::getGlobal().getNumThreads();
+      },
+      "Get the number of workers in the thread pool shared by all of "
+      "nimblephysics.");
+  m.def(
+      "setDeterministic",
+      +[](bool deterministic) {
+        dart::common::ThreadPool::setDeterministic(deterministic);
+      },
+      ::py::arg("deterministic"),
+      "Turn deterministic parallel mode on or off. In deterministic mode, "
+      "parallel work gives bit-identical results from run to run: each task "
+      "draws random numbers from its own seeded generator, CCD collision "
+      "checks don't warm start, and work is split up in a fixed way. Results "
+      "are reproducible for a fixed number of threads.");
+  m.def(
+      "isDeterministic",
+      +[]() -> bool { return dart::common::ThreadPool::isDeterministic(); },
+      "Returns true if deterministic parallel mode is on.");
+}
+
+} // namespace python
+} // namespace dart
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/constraint/AdmmBoxedLcpSolver.hpp>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void AdmmBoxedLcpSolver(py::module& m)
+{
+  ::py::class_<dart::constraint::AdmmBoxedLcpSolver::Option>(
+      m, "AdmmBoxedLcpSolverOption")
+      .def(::py::init<>())
+      .def(::py::init<int>(), ::py::arg("maxIteration"))
+      .def(
+          ::py::init<int, s_t>(),
+          ::py::arg("maxIteration"),
+          ::py::arg("rho"))
+      .def(
+          ::py::init<int, s_t, s_t, s_t, s_t, bool, bool>(),
+          ::py::arg("maxIteration"),
+          ::py::arg("rho"),
+          ::py::arg("sigma"),
+          ::py::arg("relaxation"),
+          ::py::arg("tolerance"),
+          ::py::arg("warmStart"),
+          ::py::arg("polish"))
+      .def_readwrite(
+          "mMaxIteration",
+          &dart::constraint::AdmmBoxedLcpSolver::Option::mMaxIteration)
+      .def_readwrite(
+          "mRho", &dart::constraint::AdmmBoxedLcpSolver::Option::mRho)
+      .def_readwrite(
+          "mSigma", &dart::constraint::AdmmBoxedLcpSolver::Option::mSigma)
+      .def_readwrite(
+          "mRelaxation",
+          &dart::constraint::AdmmBoxedLcpSolver::Option::mRelaxation)
+      .def_readwrite(
+          "mTolerance",
+          &dart::constraint::AdmmBoxedLcpSolver::Option::mTolerance)
+      .def_readwrite(
+          "mWarmStart",
+          &dart::constraint::AdmmBoxedLcpSolver::Option::mWarmStart)
+      .def_readwrite(
+          "mPolish", &dart::constraint::AdmmBoxedLcpSolver::Option::mPolish);
+
+  ::py::class_<
+      dart::constraint::AdmmBoxedLcpSolver,
+      dart::constraint::BoxedLcpSolver,
+      std::shared_ptr<dart::constraint::AdmmBoxedLcpSolver>>(
+      m, "AdmmBoxedLcpSolver")
+      .def(::py::init<>())
+      .def(
+          "getType",
+          +[](const dart::constraint::AdmmBoxedLcpSolver* self)
+              -> const std::string& { return self->getType(); },
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "setOption",
+          +[](dart::constraint::AdmmBoxedLcpSolver* self,
+              const dart::constraint::AdmmBoxedLcpSolver::Option& option) {
+            self->setOption(option);
+          },
+          ::py::arg("option"))
+      .def(
+          "getOption",
+          +[](dart::constraint::AdmmBoxedLcpSolver* self)
+              -> const dart::constraint::AdmmBoxedLcpSolver::Option& {
+            return self->getOption();
+          })
+      .def(
+          "getNumFactorizations",
+          +[](const dart::constraint::AdmmBoxedLcpSolver* self) -> long {
+            return self->getNumFactorizations();
+          })
+      .def_static(
+          "getStaticType",
+          +[]() -> const std::string& {
+            return dart::constraint::AdmmBoxedLcpSolver::getStaticType();
+          },
+          ::py::return_value_policy::reference_internal);
+}
+
+} // namespace python
+} // namespace dart
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/constraint/BlockJacobiBoxedLcpSolver.hpp>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void BlockJacobiBoxedLcpSolver(py::module& m)
+{
+  ::py::class_<dart::constraint::BlockJacobiBoxedLcpSolver::Option>(
+      m, "BlockJacobiBoxedLcpSolverOption")
+      .def(::py::init<>())
+      .def(::py::init<int>(), ::py::arg("maxBlockSize"))
+      .def(
+          ::py::init<int, int>(),
+          ::py::arg("maxBlockSize"),
+          ::py::arg("maxIteration"))
+      .def(
+          ::py::init<int, int, s_t>(),
+          ::py::arg("maxBlockSize"),
+          ::py::arg("maxIteration"),
+          ::py::arg("relativeDeltaXTolerance"))
+      .def(
+          ::py::init<int, int, s_t, s_t>(),
+          ::py::arg("maxBlockSize"),
+          ::py::arg("maxIteration"),
+          ::py::arg("relativeDeltaXTolerance"),
+          ::py::arg("relaxation"))
+      .def_readwrite(
+          "mMaxBlockSize",
+          &dart::constraint::BlockJacobiBoxedLcpSolver::Option::mMaxBlockSize)
+      .def_readwrite(
+          "mMaxIteration",
+          &dart::constraint::BlockJacobiBoxedLcpSolver::Option::mMaxIteration)
+      .def_readwrite(
+          "mRelativeDeltaXTolerance",
+          &dart::constraint::BlockJacobiBoxedLcpSolver::Option::
+              mRelativeDeltaXTolerance)
+      .def_readwrite(
+          "mRelaxation",
+          &dart::constraint::BlockJacobiBoxedLcpSolver::Option::mRelaxation);
+
+  ::py::class_<
+      dart::constraint::BlockJacobiBoxedLcpSolver,
+      dart::constraint::BoxedLcpSolver,
+      std::shared_ptr<dart::constraint::BlockJacobiBoxedLcpSolver>>(
+      m, "BlockJacobiBoxedLcpSolver")
+      .def(::py::init<>())
+      .def(
+          "getType",
+          +[](const dart::constraint::BlockJacobiBoxedLcpSolver* self)
+              -> const std::string& { return self->getType(); },
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "setOption",
+          +[](dart::constraint::BlockJacobiBoxedLcpSolver* self,
+              const dart::constraint::BlockJacobiBoxedLcpSolver::Option&
+                  option) { self->setOption(option); },
+          ::py::arg("option"))
+      .def(
+          "getOption",
+          +[](dart::constraint::BlockJacobiBoxedLcpSolver* self)
+              -> const dart::constraint::BlockJacobiBoxedLcpSolver::Option& {
+            return self->getOption();
+          })
+      .def_static(
+          "getStaticType",
+          +[]() -> const std::string& {
+            return dart::constraint::BlockJacobiBoxedLcpSolver::
+                getStaticType();
+          },
+          ::py::return_value_policy::reference_internal);
+}
+
+} // namespace python
+} // namespace dart
@@ -43,6 +43,32 @@ namespace python {
 
 void BoxedLcpConstraintSolver(py::module& m)
 {
+  ::py::class_<
+      dart::constraint::BoxedLcpConstraintSolver::AdaptiveSelectionOption>(
+      m, "BoxedLcpAdaptiveSelectionOption")
+      .def(
+          ::py::init<bool, int, s_t, int>(),
+          ::py::arg("enabled") = false,
+          ::py::arg("maxPrimaryDimension") = 120,
+          ::py::arg("maxPrimaryDiagonalRatio") = 1e10,
+          ::py::arg("maxBackoffSolves") = 16)
+      .def_readwrite(
+          "mEnabled",
+          &dart::constraint::BoxedLcpConstraintSolver::AdaptiveSelectionOption::
+              mEnabled)
+      .def_readwrite(
+          "mMaxPrimaryDimension",
+          &dart::constraint::BoxedLcpConstraintSolver::AdaptiveSelectionOption::
+              mMaxPrimaryDimension)
+      .def_readwrite(
+          "mMaxPrimaryDiagonalRatio",
+          &dart::constraint::BoxedLcpConstraintSolver::AdaptiveSelectionOption::
+              mMaxPrimaryDiagonalRatio)
+      .def_readwrite(
+          "mMaxBackoffSolves",
+          &dart::constraint::BoxedLcpConstraintSolver::AdaptiveSelectionOption::
+              mMaxBackoffSolves);
+
   ::py::class_<
       dart::constraint::BoxedLcpConstraintSolver,
       dart::constraint::ConstraintSolver,
@@ -77,6 +103,66 @@ void BoxedLcpConstraintSolver(py::module& m)
           +[](dart::constraint::BoxedLcpConstraintSolver* self) {
             return self->makeHyperAccurateAndVerySlow();
           })
+      .def(
+          "setWarmStartContactTolerance",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self,
+              s_t tolerance) { self->setWarmStartContactTolerance(tolerance); },
+          ::py::arg("tolerance"))
+      .def(
+          "getWarmStartContactTolerance",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> s_t {
+            return self->getWarmStartContactTolerance();
+          })
+      .def(
+          "setActiveSetWarmStart",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self, bool enabled) {
+            self->setActiveSetWarmStart(enabled);
+          },
+          ::py::arg("enabled"))
+      .def(
+          "getActiveSetWarmStart",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> bool {
+            return self->getActiveSetWarmStart();
+          })
+      .def(
+          "setMixedPrecision",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self, bool enabled) {
+            self->setMixedPrecision(enabled);
+          },
+          ::py::arg("enabled"))
+      .def(
+          "getMixedPrecision",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> bool {
+            return self->getMixedPrecision();
+          })
+      .def(
+          "setAdaptiveSelectionOption",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self,
+              const dart::constraint::BoxedLcpConstraintSolver::
+                  AdaptiveSelectionOption& option) {
+            self->setAdaptiveSelectionOption(option);
+          },
+          ::py::arg("option"))
+      .def(
+          "getAdaptiveSelectionOption",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) {
+            return self->getAdaptiveSelectionOption();
+          })
+      .def(
+          "getNumPrimarySolverSkips",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> long {
+            return self->getNumPrimarySolverSkips();
+          })
+      .def(
+          "getNumSecondarySolverSkips",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> long {
+            return self->getNumSecondarySolverSkips();
+          })
+      .def(
+          "clearWorkspaces",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self) {
+            self->clearWorkspaces();
+          })
       .def(
           "buildLcpInputs",
           +[](dart::constraint::BoxedLcpConstraintSolver* self,
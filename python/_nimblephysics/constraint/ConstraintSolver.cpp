@@ -170,6 +170,23 @@ void ConstraintSolver(py::module& m)
           +[](dart::constraint::ConstraintSolver* self, s_t depth) -> void {
             return self->setContactClippingDepth(depth);
           })
+      .def(
+          "setSpeculativeContactDistance",
+          +[](dart::constraint::ConstraintSolver* self, s_t distance) -> void {
+            return self->setSpeculativeContactDistance(distance);
+          },
+          ::py::arg("distance"))
+      .def(
+          "setParallelConstrainedGroups",
+          +[](dart::constraint::ConstraintSolver* self, bool parallel) -> void {
+            self->setParallelConstrainedGroups(parallel);
+          },
+          ::py::arg("parallel"))
+      .def(
+          "getParallelConstrainedGroups",
+          +[](const dart::constraint::ConstraintSolver* self) -> bool {
+            return self->getParallelConstrainedGroups();
+          })
       .def(
           "updateConstraints",
           +[](dart::constraint::ConstraintSolver* self) {
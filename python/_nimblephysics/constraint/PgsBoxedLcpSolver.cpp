@@ -82,7 +82,16 @@ void PgsBoxedLcpSolver(py::module& m)
       .def_readwrite(
           "mRandomizeConstraintOrder",
           &dart::constraint::PgsBoxedLcpSolver::Option::
-              mRandomizeConstraintOrder);
+              mRandomizeConstraintOrder)
+      .def_readwrite(
+          "mRelaxation",
+          &dart::constraint::PgsBoxedLcpSolver::Option::mRelaxation)
+      .def_readwrite(
+          "mGroupFrictionRows",
+          &dart::constraint::PgsBoxedLcpSolver::Option::mGroupFrictionRows)
+      .def_readwrite(
+          "mParallelColoring",
+          &dart::constraint::PgsBoxedLcpSolver::Option::mParallelColoring);
 
   ::py::class_<
       dart::constraint::PgsBoxedLcpSolver,
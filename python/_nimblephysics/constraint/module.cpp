@@ -45,6 +45,8 @@ void JointCoulombFrictionConstraint(py::module& sm);
 void BoxedLcpSolver(py::module& sm);
 void DantzigBoxedLcpSolver(py::module& sm);
 void PgsBoxedLcpSolver(py::module& sm);
+void BlockJacobiBoxedLcpSolver(py::module& sm);
+void AdmmBoxedLcpSolver(py::module& sm);
 
 void ConstraintSolver(py::module& sm);
 void BoxedLcpConstraintSolver(py::module& sm);
@@ -68,6 +70,8 @@ void dart_constraint(py::module& m)
   BoxedLcpSolver(sm);
   DantzigBoxedLcpSolver(sm);
   PgsBoxedLcpSolver(sm);
+  BlockJacobiBoxedLcpSolver(sm);
+  AdmmBoxedLcpSolver(sm);
 
   ConstraintSolver(sm);
   BoxedLcpConstraintSolver(sm);
@@ -37,6 +37,7 @@
 #include <dart/dynamics/CylinderShape.hpp>
 #include <dart/dynamics/EllipsoidShape.hpp>
 #include <dart/dynamics/LineSegmentShape.hpp>
+#include <dart/dynamics/MeshCache.hpp>
 #include <dart/dynamics/MeshShape.hpp>
 #include <dart/dynamics/MultiSphereConvexHullShape.hpp>
 #include <dart/dynamics/PlaneShape.hpp>
@@ -452,6 +453,29 @@ void Shape(py::module& m)
       .value("SHAPE_COLOR", dart::dynamics::MeshShape::ColorMode::SHAPE_COLOR)
       .export_values();
 
+  ::py::class_<dart::dynamics::MeshCache>(m, "MeshCache")
+      .def_static(
+          "getGlobal",
+          &dart::dynamics::MeshCache::getGlobal,
+          ::py::return_value_policy::reference)
+      .def(
+          "setEnabled",
+          &dart::dynamics::MeshCache::setEnabled,
+          ::py::arg("enabled"))
+      .def("isEnabled", &dart::dynamics::MeshCache::isEnabled)
+      .def(
+          "setDiskCacheDirectory",
+          &dart::dynamics::MeshCache::setDiskCacheDirectory,
+          ::py::arg("directory"))
+      .def(
+          "getDiskCacheDirectory",
+          &dart::dynamics::MeshCache::getDiskCacheDirectory)
+      .def("clear", &dart::dynamics::MeshCache::clear)
+      .def("getNumMeshes", &dart::dynamics::MeshCache::getNumMeshes)
+      .def("getNumHits", &dart::dynamics::MeshCache::getNumHits)
+      .def("getNumDiskHits", &dart::dynamics::MeshCache::getNumDiskHits)
+      .def("getNumImports", &dart::dynamics::MeshCache::getNumImports);
+
   ::py::class_<
       dart::dynamics::ArrowShape,
       dart::dynamics::MeshShape,
@@ -260,6 +260,26 @@ void ShapeFrame(py::module& m)
           +[](const dart::dynamics::CollisionAspect* self) -> bool {
             return self->getCollidable();
           })
+      .def(
+          "setCollisionLayers",
+          +[](dart::dynamics::CollisionAspect* self,
+              const std::uint32_t& value) { self->setCollisionLayers(value); },
+          ::py::arg("value"))
+      .def(
+          "getCollisionLayers",
+          +[](const dart::dynamics::CollisionAspect* self) -> std::uint32_t {
+            return self->getCollisionLayers();
+          })
+      .def(
+          "setCollisionMask",
+          +[](dart::dynamics::CollisionAspect* self,
+              const std::uint32_t& value) { self->setCollisionMask(value); },
+          ::py::arg("value"))
+      .def(
+          "getCollisionMask",
+          +[](const dart::dynamics::CollisionAspect* self) -> std::uint32_t {
+            return self->getCollisionMask();
+          })
       .def(
           "isCollidable",
           +[](const dart::dynamics::CollisionAspect* self) -> bool {
@@ -32,6 +32,7 @@
 
 #include <dart/dynamics/BallJoint.hpp>
 #include <dart/dynamics/BodyNode.hpp>
+#include <dart/dynamics/CompiledSkeleton.hpp>
 #include <dart/dynamics/EulerJoint.hpp>
 #include <dart/dynamics/FreeJoint.hpp>
 #include <dart/dynamics/PlanarJoint.hpp>
@@ -424,6 +425,30 @@ void Skeleton(py::module& m)
           +[](const dart::dynamics::Skeleton* self) -> bool {
             return self->isEnabledAdjacentBodyCheck();
           })
+      .def(
+          "areBodyNodesAdjacent",
+          &dart::dynamics::Skeleton::areBodyNodesAdjacent,
+          ::py::arg("i"),
+          ::py::arg("j"))
+      .def(
+          "computeSelfCollisionPairs",
+          &dart::dynamics::Skeleton::computeSelfCollisionPairs,
+          ::py::arg("numSamples") = 1000,
+          ::py::arg("margin") = 0.05)
+      .def(
+          "clearSelfCollisionPairs",
+          &dart::dynamics::Skeleton::clearSelfCollisionPairs)
+      .def(
+          "hasSelfCollisionPairs",
+          &dart::dynamics::Skeleton::hasSelfCollisionPairs)
+      .def(
+          "canBodyNodesSelfCollide",
+          &dart::dynamics::Skeleton::canBodyNodesSelfCollide,
+          ::py::arg("i"),
+          ::py::arg("j"))
+      .def(
+          "getSelfCollisionPairs",
+          &dart::dynamics::Skeleton::getSelfCollisionPairs)
       .def(
           "setMobile",
           +[](dart::dynamics::Skeleton* self, bool _isMobile) -> void {
@@ -733,6 +758,20 @@ void Skeleton(py::module& m)
           "getGradientOfLowestPointWrtJoints",
           &dart::dynamics::Skeleton::getGradientOfLowestPointWrtJoints,
           ::py::arg("up") = Eigen::Vector3s::UnitY())
+      .def(
+          "getDistToClosestVerticesToMarkers",
+          &dart::dynamics::Skeleton::getDistToClosestVerticesToMarkers,
+          ::py::arg("markers"))
+      .def(
+          "getGradientOfDistToClosestVerticesToMarkersWrtMarkers",
+          &dart::dynamics::Skeleton::
+              getGradientOfDistToClosestVerticesToMarkersWrtMarkers,
+          ::py::arg("markers"))
+      .def(
+          "getGradientOfDistToClosestVerticesToMarkersWrtBodyScales",
+          &dart::dynamics::Skeleton::
+              getGradientOfDistToClosestVerticesToMarkersWrtBodyScales,
+          ::py::arg("markers"))
       .def("getRandomPose", &dart::dynamics::Skeleton::getRandomPose)
       .def(
           "getRandomPoseForJoints",
@@ -793,6 +832,40 @@ void Skeleton(py::module& m)
           "setBodyScales",
           &dart::dynamics::Skeleton::setBodyScales,
           ::py::arg("scales"))
+      .def(
+          "setDeferScaleUpdates",
+          &dart::dynamics::Skeleton::setDeferScaleUpdates,
+          ::py::arg("defer"))
+      .def(
+          "getDeferScaleUpdates",
+          &dart::dynamics::Skeleton::getDeferScaleUpdates)
+      .def(
+          "applyDeferredScales",
+          &dart::dynamics::Skeleton::applyDeferredScales)
+      .def(
+          "setParallelDynamics",
+          &dart::dynamics::Skeleton::setParallelDynamics,
+          ::py::arg("parallel"))
+      .def(
+          "getParallelDynamics",
+          &dart::dynamics::Skeleton::getParallelDynamics)
+      .def(
+          "setCompactStorage",
+          &dart::dynamics::Skeleton::setCompactStorage,
+          ::py::arg("compact"))
+      .def(
+          "getCompactStorage",
+          &dart::dynamics::Skeleton::getCompactStorage)
+      .def(
+          "setCompiledDynamicsEnabled",
+          &dart::dynamics::Skeleton::setCompiledDynamicsEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getCompiledDynamicsEnabled",
+          &dart::dynamics::Skeleton::getCompiledDynamicsEnabled)
+      .def(
+          "getCompiledDynamics",
+          &dart::dynamics::Skeleton::getCompiledDynamics)
       .def(
           "clampPositionsToLimits",
           &dart::dynamics::Skeleton::clampPositionsToLimits)
@@ -859,6 +932,17 @@ void Skeleton(py::module& m)
           &dart::dynamics::Skeleton::
               getJointWorldPositionsJacobianWrtJointPositions,
           ::py::arg("joints"))
+      .def(
+          "getJointWorldPositionsBatch",
+          &dart::dynamics::Skeleton::getJointWorldPositionsBatch,
+          ::py::arg("joints"),
+          ::py::arg("poses"))
+      .def(
+          "getJointWorldPositionsJacobianWrtJointPositionsBatch",
+          &dart::dynamics::Skeleton::
+              getJointWorldPositionsJacobianWrtJointPositionsBatch,
+          ::py::arg("joints"),
+          ::py::arg("poses"))
       .def(
           "getJointWorldPositionsJacobianWrtBodyScales",
           &dart::dynamics::Skeleton::
@@ -868,6 +952,17 @@ void Skeleton(py::module& m)
           "getMarkerWorldPositions",
           &dart::dynamics::Skeleton::getMarkerWorldPositions,
           ::py::arg("markers"))
+      .def(
+          "getMarkerWorldPositionsBatch",
+          &dart::dynamics::Skeleton::getMarkerWorldPositionsBatch,
+          ::py::arg("markers"),
+          ::py::arg("poses"))
+      .def(
+          "getMarkerWorldPositionsJacobianWrtJointPositionsBatch",
+          &dart::dynamics::Skeleton::
+              getMarkerWorldPositionsJacobianWrtJointPositionsBatch,
+          ::py::arg("markers"),
+          ::py::arg("poses"))
       .def(
           "getMarkerMapWorldPositions",
           &dart::dynamics::Skeleton::getMarkerMapWorldPositions,
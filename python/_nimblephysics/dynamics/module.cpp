@@ -76,6 +76,9 @@ void Linkage(py::module& sm);
 void Chain(py::module& sm);
 void Skeleton(py::module& sm);
 
+void PoseResampler(py::module& sm);
+void CompiledSkeleton(py::module& sm);
+
 void dart_dynamics(py::module& m)
 {
   auto sm = m.def_submodule("dynamics");
@@ -118,6 +121,9 @@ void dart_dynamics(py::module& m)
   Linkage(sm);
   Chain(sm);
   Skeleton(sm);
+
+  PoseResampler(sm);
+  CompiledSkeleton(sm);
 }
 
 } // namespace python
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/neural/DiffNode.hpp>
+#include <dart/neural/DiffTape.hpp>
+#include <dart/neural/Mapping.hpp>
+#include <dart/simulation/World.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void DiffTape(py::module& m)
+{
+  ::py::class_<dart::neural::DiffNode, std::shared_ptr<dart::neural::DiffNode>>(
+      m, "DiffNode")
+      .def("getInputs", &dart::neural::DiffNode::getInputs)
+      .def("getDim", &dart::neural::DiffNode::getDim)
+      .def("getValue", &dart::neural::DiffNode::getValue)
+      .def("getGradient", &dart::neural::DiffNode::getGradient);
+
+  ::py::class_<dart::neural::DiffTape, std::shared_ptr<dart::neural::DiffTape>>(
+      m, "DiffTape")
+      .def(
+          ::py::init<std::shared_ptr<dart::simulation::World>>(),
+          ::py::arg("world"))
+      .def(
+          "reserve", &dart::neural::DiffTape::reserve, ::py::arg("numNodes"))
+      .def("clear", &dart::neural::DiffTape::clear)
+      .def("addInput", &dart::neural::DiffTape::addInput, ::py::arg("value"))
+      .def("addWorldState", &dart::neural::DiffTape::addWorldState)
+      .def(
+          "addForwardPass",
+          &dart::neural::DiffTape::addForwardPass,
+          ::py::arg("stateNode"),
+          ::py::arg("forceNode"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "addMapping",
+          &dart::neural::DiffTape::addMapping,
+          ::py::arg("stateNode"),
+          ::py::arg("mapping"))
+      // The Python loss returns (loss, [gradient wrt each input]), rather than
+      // filling in a list, since lists get copied on the way in from Python
+      .def(
+          "addLoss",
+          +[](dart::neural::DiffTape* self,
+              const std::vector<int>& inputs,
+              std::function<std::pair<s_t, std::vector<Eigen::VectorXs>>(
+                  const std::vector<Eigen::VectorXs>&)> loss) -> int {
+            return self->addLoss(
+                inputs,
+                [loss](
+                    const std::vector<Eigen::VectorXs>& values,
+                    std::vector<Eigen::VectorXs>& gradients) -> s_t {
+                  std::pair<s_t, std::vector<Eigen::VectorXs>> result
+                      = loss(values);
+                  for (std::size_t i = 0;
+                       i < gradients.size() && i < result.second.size();
+                       i++)
+                  {
+                    gradients[i] = result.second[i];
+                  }
+                  return result.first;
+                });
+          },
+          ::py::arg("inputs"),
+          ::py::arg("loss"))
+      .def("getNumNodes", &dart::neural::DiffTape::getNumNodes)
+      .def("getNode", &dart::neural::DiffTape::getNode, ::py::arg("index"))
+      .def("getValue", &dart::neural::DiffTape::getValue, ::py::arg("index"))
+      .def(
+          "getGradient",
+          &dart::neural::DiffTape::getGradient,
+          ::py::arg("index"))
+      .def("getLoss", &dart::neural::DiffTape::getLoss)
+      .def("getLossWrtMass", &dart::neural::DiffTape::getLossWrtMass)
+      .def(
+          "backward",
+          &dart::neural::DiffTape::backward,
+          ::py::arg("parallel") = true,
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
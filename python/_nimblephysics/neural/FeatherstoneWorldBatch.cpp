@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <memory>
+
+#include <dart/dynamics/Skeleton.hpp>
+#include <dart/neural/FeatherstoneWorldBatch.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void FeatherstoneWorldBatch(py::module& m)
+{
+  ::py::class_<dart::neural::FeatherstoneBatchConfig>(
+      m, "FeatherstoneBatchConfig")
+      .def(::py::init<>())
+      .def(
+          "setTimeStep",
+          &dart::neural::FeatherstoneBatchConfig::setTimeStep,
+          ::py::arg("v"))
+      .def(
+          "setGravity",
+          &dart::neural::FeatherstoneBatchConfig::setGravity,
+          ::py::arg("v"))
+      .def(
+          "setGroundContact",
+          &dart::neural::FeatherstoneBatchConfig::setGroundContact,
+          ::py::arg("v"))
+      .def(
+          "setGroundHeight",
+          &dart::neural::FeatherstoneBatchConfig::setGroundHeight,
+          ::py::arg("v"))
+      .def(
+          "setGroundNormal",
+          &dart::neural::FeatherstoneBatchConfig::setGroundNormal,
+          ::py::arg("v"))
+      .def(
+          "setFrictionCoeff",
+          &dart::neural::FeatherstoneBatchConfig::setFrictionCoeff,
+          ::py::arg("v"))
+      .def(
+          "setNumSolverIterations",
+          &dart::neural::FeatherstoneBatchConfig::setNumSolverIterations,
+          ::py::arg("v"))
+      .def(
+          "setErrorReduction",
+          &dart::neural::FeatherstoneBatchConfig::setErrorReduction,
+          ::py::arg("v"))
+      .def_readwrite(
+          "timeStep", &dart::neural::FeatherstoneBatchConfig::timeStep)
+      .def_readwrite(
+          "gravity", &dart::neural::FeatherstoneBatchConfig::gravity)
+      .def_readwrite(
+          "groundContact",
+          &dart::neural::FeatherstoneBatchConfig::groundContact)
+      .def_readwrite(
+          "groundHeight", &dart::neural::FeatherstoneBatchConfig::groundHeight)
+      .def_readwrite(
+          "groundNormal", &dart::neural::FeatherstoneBatchConfig::groundNormal)
+      .def_readwrite(
+          "frictionCoeff",
+          &dart::neural::FeatherstoneBatchConfig::frictionCoeff)
+      .def_readwrite(
+          "numSolverIterations",
+          &dart::neural::FeatherstoneBatchConfig::numSolverIterations)
+      .def_readwrite(
+          "errorReduction",
+          &dart::neural::FeatherstoneBatchConfig::errorReduction);
+
+  ::py::class_<
+      dart::neural::FeatherstoneBatchTape,
+      std::shared_ptr<dart::neural::FeatherstoneBatchTape>>(
+      m, "FeatherstoneBatchTape")
+      .def_readonly(
+          "numWorlds", &dart::neural::FeatherstoneBatchTape::numWorlds)
+      .def_readonly("numDofs", &dart::neural::FeatherstoneBatchTape::numDofs)
+      .def_readonly(
+          "stateJacobians",
+          &dart::neural::FeatherstoneBatchTape::stateJacobians)
+      .def_readonly(
+          "actionJacobians",
+          &dart::neural::FeatherstoneBatchTape::actionJacobians)
+      .def_readonly(
+          "numContacts", &dart::neural::FeatherstoneBatchTape::numContacts);
+
+  // The output arguments are Eigen::Refs, so they have to be writeable
+  // float64 arrays in column-major order (like `tensor.numpy().T` for a
+  // contiguous torch tensor), which then get written in place
+  ::py::class_<
+      dart::neural::FeatherstoneWorldBatch,
+      std::shared_ptr<dart::neural::FeatherstoneWorldBatch>>(
+      m, "FeatherstoneWorldBatch")
+      .def(
+          ::py::init<
+              std::shared_ptr<dart::dynamics::Skeleton>,
+              int,
+              dart::neural::FeatherstoneBatchConfig>(),
+          ::py::arg("skel"),
+          ::py::arg("numWorlds"),
+          ::py::arg("config") = dart::neural::FeatherstoneBatchConfig())
+      .def(
+          "getNumWorlds", &dart::neural::FeatherstoneWorldBatch::getNumWorlds)
+      .def("getNumDofs", &dart::neural::FeatherstoneWorldBatch::getNumDofs)
+      .def(
+          "getStateSize", &dart::neural::FeatherstoneWorldBatch::getStateSize)
+      .def(
+          "getActionSize",
+          &dart::neural::FeatherstoneWorldBatch::getActionSize)
+      .def(
+          "getNumContactPoints",
+          &dart::neural::FeatherstoneWorldBatch::getNumContactPoints)
+      .def("getConfig", &dart::neural::FeatherstoneWorldBatch::getConfig)
+      .def(
+          "step",
+          &dart::neural::FeatherstoneWorldBatch::step,
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("nextStates").noconvert(),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "forwardPass",
+          &dart::neural::FeatherstoneWorldBatch::forwardPass,
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("nextStates").noconvert(),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "backpropState",
+          &dart::neural::FeatherstoneWorldBatch::backpropState,
+          ::py::arg("tape"),
+          ::py::arg("lossWrtNextStates"),
+          ::py::arg("lossWrtStates").noconvert(),
+          ::py::arg("lossWrtActions").noconvert(),
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
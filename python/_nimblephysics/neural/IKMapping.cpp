@@ -63,7 +63,17 @@ void IKMapping(py::module& m)
           "addAngularBodyNode",
           &dart::neural::IKMapping::addAngularBodyNode,
           "This adds the angular (3D) coordinates of a body node to the "
-          "mapping, increasing the dimension of the mapped space by 3");
+          "mapping, increasing the dimension of the mapped space by 3")
+      .def(
+          "setWarmStartEnabled",
+          &dart::neural::IKMapping::setWarmStartEnabled,
+          ::py::arg("enabled"),
+          "If this is true, setPositions() starts its IK solve from the "
+          "world's current positions (usually the solution for the previous "
+          "timestep) rather than from zero. Defaults to false.")
+      .def(
+          "getWarmStartEnabled",
+          &dart::neural::IKMapping::getWarmStartEnabled);
 }
 
 } // namespace python
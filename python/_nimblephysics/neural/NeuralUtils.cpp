@@ -35,6 +35,9 @@
 #include <dart/neural/MappedBackpropSnapshot.hpp>
 #include <dart/neural/Mapping.hpp>
 #include <dart/neural/NeuralUtils.hpp>
+#include <dart/performance/PerformanceLog.hpp>
+#include <chrono>
+#include <future>
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -93,15 +96,68 @@ void NeuralUtils(py::module& m)
 
   m.def(
       "forwardPass",
-      &dart::neural::forwardPass,
+      +[](std::shared_ptr<dart::simulation::World> world,
+          bool idempotent,
+          dart::performance::PerformanceLog* perfLog)
+          -> std::shared_ptr<dart::neural::BackpropSnapshot> {
+        // This times the step from inside the binding, so the log only sees
+        // native time, not the cost of calling in from Python
+        dart::performance::PerformanceLog* thisLog
+            = perfLog == nullptr ? nullptr : perfLog->startRun("forwardPass");
+        std::shared_ptr<dart::neural::BackpropSnapshot> snapshot
+            = dart::neural::forwardPass(world, idempotent);
+        if (thisLog != nullptr)
+          thisLog->end();
+        return snapshot;
+      },
+      ::py::arg("world"),
+      ::py::arg("idempotent") = false,
+      ::py::arg("perfLog") = nullptr,
+      ::py::call_guard<py::gil_scoped_release>());
+
+  // This mirrors concurrent.futures.Future, so it can be waited on the same
+  // way. Waiting releases the GIL.
+  using SnapshotFuture
+      = std::shared_future<std::shared_ptr<dart::neural::BackpropSnapshot>>;
+  ::py::class_<SnapshotFuture>(m, "ForwardPassFuture")
+      .def(
+          "done",
+          +[](const SnapshotFuture& self) -> bool {
+            return self.wait_for(std::chrono::seconds(0))
+                   == std::future_status::ready;
+          })
+      .def(
+          "wait",
+          +[](const SnapshotFuture& self) -> void { self.wait(); },
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "result",
+          +[](const SnapshotFuture& self)
+              -> std::shared_ptr<dart::neural::BackpropSnapshot> {
+            return self.get();
+          },
+          ::py::call_guard<py::gil_scoped_release>());
+  m.def(
+      "forwardPassAsync",
+      +[](std::shared_ptr<dart::simulation::World> world,
+          bool idempotent) -> SnapshotFuture {
+        return dart::neural::forwardPassAsync(world, idempotent).share();
+      },
       ::py::arg("world"),
       ::py::arg("idempotent") = false);
+  m.def(
+      "adaptiveForwardPass",
+      &dart::neural::adaptiveForwardPass,
+      ::py::arg("world"),
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "mappedForwardPass",
       &dart::neural::mappedForwardPass,
       ::py::arg("world"),
       ::py::arg("mappings"),
-      ::py::arg("idempotent") = false);
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "convertJointSpaceToWorldSpace",
       &dart::neural::convertJointSpaceToWorldSpace,
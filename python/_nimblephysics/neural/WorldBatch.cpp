@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/neural/BackpropSnapshot.hpp>
+#include <dart/neural/WorldBatch.hpp>
+#include <dart/simulation/World.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void WorldBatch(py::module& m)
+{
+  ::py::class_<dart::neural::BatchForwardPassResult>(
+      m, "BatchForwardPassResult")
+      .def_readwrite(
+          "nextStates", &dart::neural::BatchForwardPassResult::nextStates)
+      .def_readwrite(
+          "snapshots", &dart::neural::BatchForwardPassResult::snapshots);
+
+  ::py::class_<dart::neural::BatchLossGradient>(m, "BatchLossGradient")
+      .def_readwrite(
+          "lossWrtState", &dart::neural::BatchLossGradient::lossWrtState)
+      .def_readwrite(
+          "lossWrtAction", &dart::neural::BatchLossGradient::lossWrtAction)
+      .def_readwrite(
+          "lossWrtMass", &dart::neural::BatchLossGradient::lossWrtMass);
+
+  ::py::class_<
+      dart::neural::WorldBatch,
+      std::shared_ptr<dart::neural::WorldBatch>>(m, "WorldBatch")
+      .def(
+          ::py::init<std::shared_ptr<dart::simulation::World>, int>(),
+          ::py::arg("world"),
+          ::py::arg("numWorlds"))
+      .def("getNumWorlds", &dart::neural::WorldBatch::getNumWorlds)
+      .def(
+          "getWorld",
+          &dart::neural::WorldBatch::getWorld,
+          ::py::arg("index"))
+      .def("getStateSize", &dart::neural::WorldBatch::getStateSize)
+      .def("getActionSize", &dart::neural::WorldBatch::getActionSize)
+      .def("getStates", &dart::neural::WorldBatch::getStates)
+      .def(
+          "setStates",
+          &dart::neural::WorldBatch::setStates,
+          ::py::arg("states"))
+      .def(
+          "setActions",
+          &dart::neural::WorldBatch::setActions,
+          ::py::arg("actions"))
+      .def(
+          "step",
+          &dart::neural::WorldBatch::step,
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::call_guard<py::gil_scoped_release>())
+      // The masses overload goes first, because pybind11 will happily turn a
+      // 1x1 array into a bool
+      .def(
+          "forwardPass",
+          +[](dart::neural::WorldBatch* self,
+              const Eigen::MatrixXs& states,
+              const Eigen::MatrixXs& actions,
+              const Eigen::MatrixXs& masses,
+              bool idempotent) -> dart::neural::BatchForwardPassResult {
+            return self->forwardPass(states, actions, masses, idempotent);
+          },
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("masses"),
+          ::py::arg("idempotent") = false,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "forwardPass",
+          +[](dart::neural::WorldBatch* self,
+              const Eigen::MatrixXs& states,
+              const Eigen::MatrixXs& actions,
+              bool idempotent) -> dart::neural::BatchForwardPassResult {
+            return self->forwardPass(states, actions, idempotent);
+          },
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("idempotent") = false,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "backpropState",
+          +[](dart::neural::WorldBatch* self,
+              const dart::neural::BatchForwardPassResult& forward,
+              const Eigen::MatrixXs& nextStatesLossGrad)
+              -> dart::neural::BatchLossGradient {
+            return self->backpropState(forward, nextStatesLossGrad);
+          },
+          ::py::arg("forward"),
+          ::py::arg("nextStatesLossGrad"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "backpropState",
+          +[](dart::neural::WorldBatch* self,
+              const std::vector<std::shared_ptr<dart::neural::BackpropSnapshot>>&
+                  snapshots,
+              const Eigen::MatrixXs& nextStatesLossGrad)
+              -> dart::neural::BatchLossGradient {
+            return self->backpropState(snapshots, nextStatesLossGrad);
+          },
+          ::py::arg("snapshots"),
+          ::py::arg("nextStatesLossGrad"),
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
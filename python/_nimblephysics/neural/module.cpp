@@ -47,6 +47,11 @@ void IdentityMapping(py::module& sm);
 void BackpropSnapshot(py::module& sm);
 void MappedBackpropSnapshot(py::module& sm);
 void WithRespectToMass(py::module& sm);
+void WorldBatch(py::module& sm);
+void FeatherstoneWorldBatch(py::module& sm);
+void Rollout(py::module& sm);
+void DiffTape(py::module& sm);
+void ForwardPassCache(py::module& sm);
 
 void dart_neural(py::module& m)
 {
@@ -63,6 +68,11 @@ void dart_neural(py::module& m)
   BackpropSnapshot(sm);
   MappedBackpropSnapshot(sm);
   WithRespectToMass(sm);
+  WorldBatch(sm);
+  FeatherstoneWorldBatch(sm);
+  Rollout(sm);
+  DiffTape(sm);
+  ForwardPassCache(sm);
 }
 
 } // namespace python
@@ -31,6 +31,10 @@
  */
 
 #include <dart/performance/PerformanceLog.hpp>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
@@ -41,14 +45,64 @@ namespace py = pybind11;
 namespace dart {
 namespace python {
 
+namespace {
+
+/// PerformanceLog only keeps a pointer to the name it's given, expecting a
+/// string literal, so names coming from Python need to live forever
+char const* internName(const std::string& name)
+{
+  static std::mutex mutex;
+  static std::unordered_set<std::string> names;
+  const std::lock_guard<std::mutex> lock(mutex);
+  return names.insert(name).first->c_str();
+}
+
+} // namespace
+
 void PerformanceLog(py::module& m)
 {
+  ::py::enum_<dart::performance::PerformanceCounter>(m, "PerformanceCounter")
+      .value("INSTRUCTIONS", dart::performance::INSTRUCTIONS)
+      .value("CACHE_MISSES", dart::performance::CACHE_MISSES)
+      .value("BRANCH_MISSES", dart::performance::BRANCH_MISSES)
+      .value("ALLOCATIONS", dart::performance::ALLOCATIONS)
+      .value("ALLOCATED_BYTES", dart::performance::ALLOCATED_BYTES);
+
   ::py::class_<dart::performance::FinalizedPerformanceLog>(
       m, "FinalizedPerformanceLog")
       .def(
           "prettyPrint",
           &dart::performance::FinalizedPerformanceLog::prettyPrint)
-      .def("toJson", &dart::performance::FinalizedPerformanceLog::toJson);
+      .def("toJson", &dart::performance::FinalizedPerformanceLog::toJson)
+      .def("getName", &dart::performance::FinalizedPerformanceLog::getName)
+      .def(
+          "getChild",
+          &dart::performance::FinalizedPerformanceLog::getChild,
+          ::py::arg("name"))
+      .def(
+          "getChildNames",
+          &dart::performance::FinalizedPerformanceLog::getChildNames)
+      .def(
+          "getNumRuns", &dart::performance::FinalizedPerformanceLog::getNumRuns)
+      .def(
+          "getMeanRuntime",
+          &dart::performance::FinalizedPerformanceLog::getMeanRuntime)
+      .def(
+          "getTotalRuntime",
+          &dart::performance::FinalizedPerformanceLog::getTotalRuntime)
+      .def("getRuns", &dart::performance::FinalizedPerformanceLog::getRuns)
+      .def(
+          "hasCounter",
+          &dart::performance::FinalizedPerformanceLog::hasCounter,
+          ::py::arg("counter"))
+      .def(
+          "getTotalCounter",
+          &dart::performance::FinalizedPerformanceLog::getTotalCounter,
+          ::py::arg("counter"))
+      .def(
+          "getMeanCounter",
+          &dart::performance::FinalizedPerformanceLog::getMeanCounter,
+          ::py::arg("counter"));
 
   ::py::class_<dart::performance::PerformanceLog>(m, "PerformanceLog")
       .def(
@@ -58,7 +112,42 @@ void PerformanceLog(py::module& m)
                   std::string,
                   std::shared_ptr<dart::performance::FinalizedPerformanceLog>> {
             return self->finalize();
-          });
+          })
+      .def_static(
+          "startRoot",
+          +[](const std::string& name) -> dart::performance::PerformanceLog* {
+            return dart::performance::PerformanceLog::startRoot(
+                internName(name));
+          },
+          ::py::arg("name"),
+          ::py::return_value_policy::reference)
+      .def(
+          "startRun",
+          +[](dart::performance::PerformanceLog* self,
+              const std::string& name) -> dart::performance::PerformanceLog* {
+            return self->startRun(internName(name));
+          },
+          ::py::arg("name"),
+          ::py::return_value_policy::reference)
+      .def("end", &dart::performance::PerformanceLog::end)
+      .def_static(
+          "initialize", &dart::performance::PerformanceLog::initialize)
+      .def_static(
+          "toChromeTraceJson",
+          &dart::performance::PerformanceLog::toChromeTraceJson)
+      .def_static(
+          "getClockTicksPerSecond",
+          &dart::performance::PerformanceLog::getClockTicksPerSecond)
+      .def_static(
+          "setHardwareCountersEnabled",
+          &dart::performance::PerformanceLog::setHardwareCountersEnabled,
+          ::py::arg("enabled"))
+      .def_static(
+          "getHardwareCountersEnabled",
+          &dart::performance::PerformanceLog::getHardwareCountersEnabled)
+      .def_static(
+          "isAllocationTrackingAvailable",
+          &dart::performance::PerformanceLog::isAllocationTrackingAvailable);
 }
 
 } // namespace python
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/realtime/MPC.hpp>
+#include <dart/realtime/MPCHost.hpp>
+#include <dart/realtime/MPCLocal.hpp>
+#include <dart/realtime/MPCSampling.hpp>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void MPCHost(py::module& m)
+{
+  ::py::class_<
+      dart::realtime::MPCHost,
+      std::shared_ptr<dart::realtime::MPCHost>>(m, "MPCHost")
+      .def(::py::init<int>(), ::py::arg("numWorkers") = 0)
+      .def(
+          "addController",
+          +[](dart::realtime::MPCHost* self,
+              std::shared_ptr<dart::realtime::MPCLocal> mpc,
+              int deadlineMillis) -> int {
+            return self->addController(mpc, deadlineMillis);
+          },
+          ::py::arg("mpc"),
+          ::py::arg("deadlineMillis") = 0)
+      .def(
+          "addController",
+          +[](dart::realtime::MPCHost* self,
+              std::shared_ptr<dart::realtime::MPCSampling> mpc,
+              int deadlineMillis) -> int {
+            return self->addController(mpc, deadlineMillis);
+          },
+          ::py::arg("mpc"),
+          ::py::arg("deadlineMillis") = 0)
+      .def(
+          "removeController",
+          &dart::realtime::MPCHost::removeController,
+          ::py::arg("id"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getController",
+          &dart::realtime::MPCHost::getController,
+          ::py::arg("id"))
+      .def("getNumControllers", &dart::realtime::MPCHost::getNumControllers)
+      .def("getNumWorkers", &dart::realtime::MPCHost::getNumWorkers)
+      .def(
+          "setDeadlineMillis",
+          &dart::realtime::MPCHost::setDeadlineMillis,
+          ::py::arg("id"),
+          ::py::arg("millis"))
+      .def(
+          "getDeadlineMillis",
+          &dart::realtime::MPCHost::getDeadlineMillis,
+          ::py::arg("id"))
+      .def(
+          "startController",
+          &dart::realtime::MPCHost::startController,
+          ::py::arg("id"))
+      .def(
+          "stopController",
+          &dart::realtime::MPCHost::stopController,
+          ::py::arg("id"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "isControllerRunning",
+          &dart::realtime::MPCHost::isControllerRunning,
+          ::py::arg("id"))
+      .def(
+          "getNumReplans",
+          &dart::realtime::MPCHost::getNumReplans,
+          ::py::arg("id"))
+      .def(
+          "getNumMissedDeadlines",
+          &dart::realtime::MPCHost::getNumMissedDeadlines,
+          ::py::arg("id"))
+      .def("start", &dart::realtime::MPCHost::start)
+      .def(
+          "stop",
+          &dart::realtime::MPCHost::stop,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "serve",
+          &dart::realtime::MPCHost::serve,
+          ::py::arg("port"),
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
@@ -94,6 +94,21 @@ void MPCLocal(py::module& m)
           "setMaxIterations",
           &dart::realtime::MPCLocal::setMaxIterations,
           ::py::arg("maxIterations"))
+      .def(
+          "setEnableWarmStart",
+          &dart::realtime::MPCLocal::setEnableWarmStart,
+          ::py::arg("enabled"))
+      .def(
+          "setReplanningDeadlineMillis",
+          &dart::realtime::MPCLocal::setReplanningDeadlineMillis,
+          ::py::arg("millis"))
+      .def(
+          "getReplanningDeadlineMillis",
+          &dart::realtime::MPCLocal::getReplanningDeadlineMillis)
+      .def(
+          "setEnableStateEstimateCache",
+          &dart::realtime::MPCLocal::setEnableStateEstimateCache,
+          ::py::arg("enabled"))
       .def(
           "recordGroundTruthState",
           &dart::realtime::MPCLocal::recordGroundTruthState,
@@ -59,9 +59,18 @@ void MPCRemote(py::module& m)
           ::py::arg("steps"),
           ::py::arg("millisPerStep"))
       .def(
-          ::py::init<dart::realtime::MPCLocal&, int>(),
+          ::py::init<dart::realtime::MPCLocal&, int, bool>(),
           ::py::arg("local"),
-          ::py::arg("ignored") = 0)
+          ::py::arg("ignored") = 0,
+          ::py::arg("useSharedMemory") = false)
+      .def(
+          "setPlanQuantization",
+          &dart::realtime::MPCRemote::setPlanQuantization,
+          ::py::arg("precision"))
+      .def(
+          "setControllerId",
+          &dart::realtime::MPCRemote::setControllerId,
+          ::py::arg("id"))
       .def(
           "getRemainingPlanBufferMillis",
           &dart::realtime::MPCRemote::getRemainingPlanBufferMillis)
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/realtime/MPC.hpp>
+#include <dart/realtime/MPCSampling.hpp>
+#include <dart/simulation/World.hpp>
+#include <dart/trajectory/LossFn.hpp>
+#include <dart/trajectory/Optimizer.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void MPCSampling(py::module& m)
+{
+  ::py::class_<
+      dart::realtime::MPCSampling,
+      dart::realtime::MPC,
+      std::shared_ptr<dart::realtime::MPCSampling>>
+      mpcSampling(m, "MPCSampling");
+
+  ::py::enum_<dart::realtime::MPCSampling::SamplingMethod>(
+      mpcSampling, "SamplingMethod")
+      .value("MPPI", dart::realtime::MPCSampling::SamplingMethod::MPPI)
+      .value("CEM", dart::realtime::MPCSampling::SamplingMethod::CEM);
+
+  mpcSampling
+      .def(
+          ::py::init<
+              std::shared_ptr<dart::simulation::World>,
+              std::shared_ptr<dart::trajectory::LossFn>,
+              int>(),
+          ::py::arg("world"),
+          ::py::arg("loss"),
+          ::py::arg("planningHorizonMillis"))
+      .def("setLoss", &dart::realtime::MPCSampling::setLoss, ::py::arg("loss"))
+      .def(
+          "setNumSamples",
+          &dart::realtime::MPCSampling::setNumSamples,
+          ::py::arg("numSamples"))
+      .def("getNumSamples", &dart::realtime::MPCSampling::getNumSamples)
+      .def(
+          "setNumIterations",
+          &dart::realtime::MPCSampling::setNumIterations,
+          ::py::arg("numIterations"))
+      .def(
+          "setNoiseStdDev",
+          &dart::realtime::MPCSampling::setNoiseStdDev,
+          ::py::arg("stdDev"))
+      .def(
+          "setSamplingMethod",
+          &dart::realtime::MPCSampling::setSamplingMethod,
+          ::py::arg("method"))
+      .def(
+          "setTemperature",
+          &dart::realtime::MPCSampling::setTemperature,
+          ::py::arg("temperature"))
+      .def(
+          "setEliteFraction",
+          &dart::realtime::MPCSampling::setEliteFraction,
+          ::py::arg("fraction"))
+      .def("setSeed", &dart::realtime::MPCSampling::setSeed, ::py::arg("seed"))
+      .def(
+          "setRefinementOptimizer",
+          &dart::realtime::MPCSampling::setRefinementOptimizer,
+          ::py::arg("optimizer"))
+      .def(
+          "setSilent",
+          &dart::realtime::MPCSampling::setSilent,
+          ::py::arg("silent"))
+      .def("getPlan", &dart::realtime::MPCSampling::getPlan)
+      .def(
+          "getRemainingPlanBufferMillis",
+          &dart::realtime::MPCSampling::getRemainingPlanBufferMillis)
+      .def(
+          "recordGroundTruthState",
+          &dart::realtime::MPCSampling::recordGroundTruthState,
+          ::py::arg("time"),
+          ::py::arg("pos"),
+          ::py::arg("vel"),
+          ::py::arg("mass"))
+      .def(
+          "recordGroundTruthStateNow",
+          &dart::realtime::MPCSampling::recordGroundTruthStateNow,
+          ::py::arg("pos"),
+          ::py::arg("vel"),
+          ::py::arg("mass"))
+      .def(
+          "optimizePlan",
+          &dart::realtime::MPCSampling::optimizePlan,
+          ::py::arg("now"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def("start", &dart::realtime::MPCSampling::start)
+      .def("stop", &dart::realtime::MPCSampling::stop)
+      .def(
+          "registerReplaningListener",
+          &dart::realtime::MPCSampling::registerReplanningListener,
+          ::py::arg("replanListener"));
+}
+
+} // namespace python
+} // namespace dart
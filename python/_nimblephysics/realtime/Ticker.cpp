@@ -4,6 +4,7 @@
 #include <dart/realtime/Ticker.hpp>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -55,7 +56,28 @@ void Ticker(py::module& m)
           &dart::realtime::Ticker::start,
           ::py::call_guard<py::gil_scoped_release>())
       .def("stop", &dart::realtime::Ticker::stop)
-      .def("clear", &dart::realtime::Ticker::clear);
+      .def("clear", &dart::realtime::Ticker::clear)
+      .def(
+          "setCpuAffinity",
+          &dart::realtime::Ticker::setCpuAffinity,
+          ::py::arg("core"))
+      .def(
+          "setRealtimePriority",
+          &dart::realtime::Ticker::setRealtimePriority,
+          ::py::arg("enabled"))
+      .def(
+          "setSpinNanos",
+          &dart::realtime::Ticker::setSpinNanos,
+          ::py::arg("nanos"))
+      .def("getNumTicks", &dart::realtime::Ticker::getNumTicks)
+      .def(
+          "getNumDeadlineMisses",
+          &dart::realtime::Ticker::getNumDeadlineMisses)
+      .def("getNumSkippedTicks", &dart::realtime::Ticker::getNumSkippedTicks)
+      .def("getJitterHistogram", &dart::realtime::Ticker::getJitterHistogram)
+      .def("getMaxJitterNanos", &dart::realtime::Ticker::getMaxJitterNanos)
+      .def("getMeanJitterNanos", &dart::realtime::Ticker::getMeanJitterNanos)
+      .def("resetStats", &dart::realtime::Ticker::resetStats);
 }
 
 } // namespace python
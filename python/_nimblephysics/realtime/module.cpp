@@ -40,6 +40,8 @@ namespace dart {
 namespace python {
 
 void MPCLocal(py::module& sm);
+void MPCSampling(py::module& sm);
+void MPCHost(py::module& sm);
 void MPCRemote(py::module& sm);
 void MPC(py::module& sm);
 void Ticker(py::module& sm);
@@ -54,6 +56,8 @@ void dart_realtime(py::module& m)
 
   MPC(sm);
   MPCLocal(sm);
+  MPCSampling(sm);
+  MPCHost(sm);
   MPCRemote(sm);
   Ticker(sm);
 }
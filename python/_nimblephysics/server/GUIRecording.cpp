@@ -69,7 +69,14 @@ void GUIRecording(py::module& m)
           "writeFrameJson",
           &dart::server::GUIRecording::writeFrameJson,
           ::py::arg("path"),
-          ::py::arg("frame"));
+          ::py::arg("frame"))
+      .def(
+          "streamToFile",
+          &dart::server::GUIRecording::streamToFile,
+          ::py::arg("path"),
+          ::py::arg("append") = false)
+      .def("isStreaming", &dart::server::GUIRecording::isStreaming)
+      .def("closeStream", &dart::server::GUIRecording::closeStream);
 }
 
 } // namespace python
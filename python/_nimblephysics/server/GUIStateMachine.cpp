@@ -50,6 +50,36 @@ void GUIStateMachine(py::module& m)
       std::shared_ptr<dart::server::GUIStateMachine>>(m, "GUIStateMachine")
       .def(::py::init<>())
       .def("clear", &dart::server::GUIStateMachine::clear)
+      .def(
+          "setQuantizeTransforms",
+          &dart::server::GUIStateMachine::setQuantizeTransforms,
+          ::py::arg("quantize"),
+          ::py::arg("positionPrecision") = 1e-4,
+          ::py::arg("rotationPrecision") = 1e-4)
+      .def(
+          "resetTransformDeltas",
+          &dart::server::GUIStateMachine::resetTransformDeltas)
+      .def(
+          "setUpdateThresholds",
+          &dart::server::GUIStateMachine::setUpdateThresholds,
+          ::py::arg("positionEpsilon"),
+          ::py::arg("rotationEpsilon"),
+          ::py::arg("colorEpsilon"))
+      .def(
+          "setObjectStatic",
+          &dart::server::GUIStateMachine::setObjectStatic,
+          ::py::arg("key"),
+          ::py::arg("isStatic") = true)
+      .def(
+          "setSkeletonStatic",
+          &dart::server::GUIStateMachine::setSkeletonStatic,
+          ::py::arg("skel"),
+          ::py::arg("prefix") = "skel",
+          ::py::arg("isStatic") = true)
+      .def(
+          "isObjectStatic",
+          &dart::server::GUIStateMachine::isObjectStatic,
+          ::py::arg("key"))
       .def(
           "setFramesPerSecond",
           &dart::server::GUIStateMachine::setFramesPerSecond,
@@ -248,6 +278,15 @@ void GUIStateMachine(py::module& m)
           ::py::arg("plotType"),
           ::py::arg("xs"),
           ::py::arg("ys"))
+      .def(
+          "appendRichPlotData",
+          &dart::server::GUIStateMachine::appendRichPlotData,
+          ::py::arg("key"),
+          ::py::arg("name"),
+          ::py::arg("color"),
+          ::py::arg("plotType"),
+          ::py::arg("xs"),
+          ::py::arg("ys"))
       .def(
           "setRichPlotBounds",
           &dart::server::GUIStateMachine::setRichPlotBounds,
@@ -282,6 +321,15 @@ void GUIStateMachine(py::module& m)
           ::py::arg("overrideColor") = -1 * Eigen::Vector4s::Ones(),
           ::py::arg("layer") = "",
           ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "renderSkeletonInstanced",
+          &dart::server::GUIStateMachine::renderSkeletonInstanced,
+          ::py::arg("skeleton"),
+          ::py::arg("templateKey"),
+          ::py::arg("instanceKey"),
+          ::py::arg("overrideColor") = -1 * Eigen::Vector4s::Ones(),
+          ::py::arg("layer") = "",
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "renderTrajectoryLines",
           &dart::server::GUIStateMachine::renderTrajectoryLines,
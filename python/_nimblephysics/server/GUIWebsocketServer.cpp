@@ -73,6 +73,32 @@ void GUIWebsocketServer(py::module& m)
           },
           ::py::call_guard<py::gil_scoped_release>())
       .def("isServing", &dart::server::GUIWebsocketServer::isServing)
+      .def(
+          "getSession",
+          &dart::server::GUIWebsocketServer::getSession,
+          ::py::arg("name"))
+      .def(
+          "hasSession",
+          &dart::server::GUIWebsocketServer::hasSession,
+          ::py::arg("name"))
+      .def(
+          "closeSession",
+          &dart::server::GUIWebsocketServer::closeSession,
+          ::py::arg("name"))
+      .def(
+          "getSessionNames",
+          &dart::server::GUIWebsocketServer::getSessionNames)
+      .def(
+          "getSessionName",
+          &dart::server::GUIWebsocketServer::getSessionName)
+      .def(
+          "setFlushInterval",
+          &dart::server::GUIWebsocketServer::setFlushInterval,
+          ::py::arg("milliseconds"))
+      .def(
+          "getFlushInterval",
+          &dart::server::GUIWebsocketServer::getFlushInterval)
+      .def("getNumViewers", &dart::server::GUIWebsocketServer::getNumViewers)
       .def("getScreenSize", &dart::server::GUIWebsocketServer::getScreenSize)
       .def("getKeysDown", &dart::server::GUIWebsocketServer::getKeysDown)
       .def(
@@ -81,6 +107,26 @@ void GUIWebsocketServer(py::module& m)
           ::py::arg("key"))
       .def("clear", &dart::server::GUIWebsocketServer::clear)
       .def("flush", &dart::server::GUIWebsocketServer::flush)
+      .def(
+          "setBinaryFrames",
+          &dart::server::GUIWebsocketServer::setBinaryFrames,
+          ::py::arg("binary"))
+      .def(
+          "setDeflateFrames",
+          &dart::server::GUIWebsocketServer::setDeflateFrames,
+          ::py::arg("deflate"))
+      .def(
+          "renderWorldAsync",
+          &dart::server::GUIWebsocketServer::renderWorldAsync,
+          ::py::arg("world"),
+          ::py::arg("prefix") = "world",
+          ::py::arg("layer") = "")
+      .def(
+          "publishWorldPoses",
+          &dart::server::GUIWebsocketServer::publishWorldPoses)
+      .def(
+          "stopRenderingAsync",
+          &dart::server::GUIWebsocketServer::stopRenderingAsync)
       .def(
           "registerConnectionListener",
           &dart::server::GUIWebsocketServer::registerConnectionListener,
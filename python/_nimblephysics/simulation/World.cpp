@@ -33,12 +33,17 @@
 #include <dart/collision/CollisionResult.hpp>
 #include <dart/constraint/ConstraintSolver.hpp>
 #include <dart/dynamics/Skeleton.hpp>
+#include <dart/neural/ForwardPassCache.hpp>
 #include <dart/neural/WithRespectToMass.hpp>
+#include <dart/performance/PerformanceLog.hpp>
 #include <dart/simulation/World.hpp>
 #include <dart/utils/UniversalLoader.hpp>
+#include <chrono>
+#include <future>
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -47,6 +52,59 @@ namespace python {
 
 void World(py::module& m)
 {
+  // This mirrors concurrent.futures.Future, so it can be waited on the same
+  // way. Waiting releases the GIL.
+  ::py::class_<std::shared_future<void>>(m, "StepFuture")
+      .def(
+          "done",
+          +[](const std::shared_future<void>& self) -> bool {
+            return self.wait_for(std::chrono::seconds(0))
+                   == std::future_status::ready;
+          })
+      .def(
+          "wait",
+          +[](const std::shared_future<void>& self) -> void { self.wait(); },
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "result",
+          +[](const std::shared_future<void>& self) -> void { self.get(); },
+          ::py::call_guard<py::gil_scoped_release>());
+
+  using dart::simulation::StepStats;
+  ::py::class_<StepStats>(m, "StepStats")
+      .def(::py::init<>())
+      .def("reset", &StepStats::reset)
+      .def_readonly("numSteps", &StepStats::numSteps)
+      .def_readonly("lastStepNanos", &StepStats::lastStepNanos)
+      .def_readonly("lastCollisionNanos", &StepStats::lastCollisionNanos)
+      .def_readonly("lastConstraintNanos", &StepStats::lastConstraintNanos)
+      .def_readonly("lastIntegrationNanos", &StepStats::lastIntegrationNanos)
+      .def_readonly("lastNumContacts", &StepStats::lastNumContacts)
+      .def_readonly(
+          "lastNumConstrainedGroups", &StepStats::lastNumConstrainedGroups)
+      .def_readonly("lastLcpSize", &StepStats::lastLcpSize)
+      .def_readonly("lastLcpIterations", &StepStats::lastLcpIterations)
+      .def_readonly("lastLcpSolvesByPath", &StepStats::lastLcpSolvesByPath)
+      .def_readonly("totalStepNanos", &StepStats::totalStepNanos)
+      .def_readonly("maxStepNanos", &StepStats::maxStepNanos)
+      .def_readonly("totalCollisionNanos", &StepStats::totalCollisionNanos)
+      .def_readonly("totalConstraintNanos", &StepStats::totalConstraintNanos)
+      .def_readonly("totalIntegrationNanos", &StepStats::totalIntegrationNanos)
+      .def_readonly("totalContacts", &StepStats::totalContacts)
+      .def_readonly("maxLcpSize", &StepStats::maxLcpSize)
+      .def_readonly("totalLcpIterations", &StepStats::totalLcpIterations)
+      .def_readonly("numLcpSolvesByPath", &StepStats::numLcpSolvesByPath)
+      .def_readonly("numBackprops", &StepStats::numBackprops)
+      .def_readonly("lastBackpropNanos", &StepStats::lastBackpropNanos)
+      .def_readonly("totalBackpropNanos", &StepStats::totalBackpropNanos)
+      .def_readonly("stepNanosHistogram", &StepStats::stepNanosHistogram)
+      .def_readonly(
+          "collisionNanosHistogram", &StepStats::collisionNanosHistogram)
+      .def_readonly(
+          "integrationNanosHistogram", &StepStats::integrationNanosHistogram)
+      .def_readonly(
+          "backpropNanosHistogram", &StepStats::backpropNanosHistogram);
+
   ::py::class_<
       dart::simulation::World,
       std::shared_ptr<dart::simulation::World>>(m, "World")
@@ -65,6 +123,31 @@ void World(py::module& m)
               -> std::shared_ptr<dart::simulation::World> {
             return self->clone();
           })
+      .def(
+          "serialize",
+          +[](const dart::simulation::World* self) -> ::py::bytes {
+            return ::py::bytes(self->serialize());
+          })
+      .def_static(
+          "deserialize",
+          +[](const std::string& bytes)
+              -> std::shared_ptr<dart::simulation::World> {
+            return dart::simulation::World::deserialize(bytes);
+          },
+          ::py::arg("bytes"))
+      .def(::py::pickle(
+          +[](const dart::simulation::World* self) -> ::py::bytes {
+            return ::py::bytes(self->serialize());
+          },
+          +[](const ::py::bytes& bytes)
+              -> std::shared_ptr<dart::simulation::World> {
+            std::shared_ptr<dart::simulation::World> world
+                = dart::simulation::World::deserialize(
+                    static_cast<std::string>(bytes));
+            if (!world)
+              throw std::runtime_error("Failed to unpickle a World");
+            return world;
+          }))
       .def(
           "setName",
           +[](dart::simulation::World* self, const std::string& _newName)
@@ -252,13 +335,49 @@ void World(py::module& m)
           +[](dart::simulation::World* self) -> void { return self->reset(); })
       .def(
           "step",
-          +[](dart::simulation::World* self) -> void { return self->step(); })
+          +[](dart::simulation::World* self) -> void { return self->step(); },
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "step",
           +[](dart::simulation::World* self, bool _resetCommand) -> void {
             return self->step(_resetCommand);
           },
-          ::py::arg("resetCommand"))
+          ::py::arg("resetCommand"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "stepAsync",
+          +[](dart::simulation::World* self,
+              bool _resetCommand) -> std::shared_future<void> {
+            return self->stepAsync(_resetCommand).share();
+          },
+          ::py::arg("resetCommand") = true)
+      .def(
+          "stepAdaptive",
+          +[](dart::simulation::World* self, bool _resetCommand) -> int {
+            return self->stepAdaptive(_resetCommand);
+          },
+          ::py::arg("resetCommand") = true,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getSubstepsForLastStep",
+          &dart::simulation::World::getSubstepsForLastStep)
+      .def(
+          "step",
+          +[](dart::simulation::World* self,
+              dart::performance::PerformanceLog* perfLog,
+              bool _resetCommand) -> void {
+            // This times the step from inside the binding, so the log only
+            // sees native time, not the cost of calling in from Python
+            dart::performance::PerformanceLog* thisLog
+                = perfLog == nullptr ? nullptr
+                                     : perfLog->startRun("World.step");
+            self->step(_resetCommand);
+            if (thisLog != nullptr)
+              thisLog->end();
+          },
+          ::py::arg("perfLog"),
+          ::py::arg("resetCommand") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "integratePositions",
           +[](dart::simulation::World* self, Eigen::VectorXs initialVelocity)
@@ -292,6 +411,11 @@ void World(py::module& m)
             return self->getConstraintSolver();
           },
           ::py::return_value_policy::reference_internal)
+      .def(
+          "getStepStats",
+          &dart::simulation::World::getStepStats,
+          ::py::return_value_policy::reference_internal)
+      .def("resetStepStats", &dart::simulation::World::resetStepStats)
       .def(
           "runConstraintEngine",
           +[](dart::simulation::World* self, bool _resetCommand) -> void {
@@ -332,6 +456,16 @@ void World(py::module& m)
           +[](dart::simulation::World* self) -> Eigen::VectorXs {
             return self->getVelocities();
           })
+      .def(
+          "getPositionsInto",
+          +[](dart::simulation::World* self, Eigen::Ref<Eigen::VectorXs> out)
+              -> void { self->getPositions(out); },
+          ::py::arg("out"))
+      .def(
+          "getVelocitiesInto",
+          +[](dart::simulation::World* self, Eigen::Ref<Eigen::VectorXs> out)
+              -> void { self->getVelocities(out); },
+          ::py::arg("out"))
       .def(
           "getControlForces",
           +[](dart::simulation::World* self) -> Eigen::VectorXs {
@@ -456,6 +590,20 @@ void World(py::module& m)
           "setParallelVelocityAndPositionUpdates",
           &dart::simulation::World::setParallelVelocityAndPositionUpdates,
           ::py::arg("enabled"))
+      .def(
+          "getParallelSkeletonUpdates",
+          &dart::simulation::World::getParallelSkeletonUpdates)
+      .def(
+          "setParallelSkeletonUpdates",
+          &dart::simulation::World::setParallelSkeletonUpdates,
+          ::py::arg("enabled"))
+      .def(
+          "getImplicitSpringDamping",
+          &dart::simulation::World::getImplicitSpringDamping)
+      .def(
+          "setImplicitSpringDamping",
+          &dart::simulation::World::setImplicitSpringDamping,
+          ::py::arg("enabled"))
       .def(
           "getPenetrationCorrectionEnabled",
           &dart::simulation::World::getPenetrationCorrectionEnabled)
@@ -466,6 +614,60 @@ void World(py::module& m)
       .def(
           "getContactClippingDepth",
           &dart::simulation::World::getContactClippingDepth)
+      .def(
+          "setSpeculativeContactDistance",
+          &dart::simulation::World::setSpeculativeContactDistance,
+          ::py::arg("distance"))
+      .def(
+          "getSpeculativeContactDistance",
+          &dart::simulation::World::getSpeculativeContactDistance)
+      .def(
+          "setSleepingEnabled",
+          &dart::simulation::World::setSleepingEnabled,
+          ::py::arg("enable"))
+      .def("getSleepingEnabled", &dart::simulation::World::getSleepingEnabled)
+      .def(
+          "setSleepVelocityThreshold",
+          &dart::simulation::World::setSleepVelocityThreshold,
+          ::py::arg("threshold"))
+      .def(
+          "getSleepVelocityThreshold",
+          &dart::simulation::World::getSleepVelocityThreshold)
+      .def(
+          "setSleepStepThreshold",
+          &dart::simulation::World::setSleepStepThreshold,
+          ::py::arg("steps"))
+      .def(
+          "getSleepStepThreshold",
+          &dart::simulation::World::getSleepStepThreshold)
+      .def(
+          "setMaxSubsteps",
+          &dart::simulation::World::setMaxSubsteps,
+          ::py::arg("substeps"))
+      .def("getMaxSubsteps", &dart::simulation::World::getMaxSubsteps)
+      .def(
+          "setSubstepPenetrationThreshold",
+          &dart::simulation::World::setSubstepPenetrationThreshold,
+          ::py::arg("depth"))
+      .def(
+          "getSubstepPenetrationThreshold",
+          &dart::simulation::World::getSubstepPenetrationThreshold)
+      .def(
+          "setSubstepVelocityChangeThreshold",
+          &dart::simulation::World::setSubstepVelocityChangeThreshold,
+          ::py::arg("change"))
+      .def(
+          "getSubstepVelocityChangeThreshold",
+          &dart::simulation::World::getSubstepVelocityChangeThreshold)
+      .def(
+          "isSleeping",
+          &dart::simulation::World::isSleeping,
+          ::py::arg("skeleton"))
+      .def(
+          "wakeSkeleton",
+          &dart::simulation::World::wakeSkeleton,
+          ::py::arg("skeleton"))
+      .def("wakeAllSkeletons", &dart::simulation::World::wakeAllSkeletons)
       .def(
           "getFallbackConstraintForceMixingConstant",
           &dart::simulation::World::getFallbackConstraintForceMixingConstant)
@@ -477,11 +679,31 @@ void World(py::module& m)
       .def("toJson", &dart::simulation::World::toJson)
       .def("positionsToJson", &dart::simulation::World::positionsToJson)
       .def("colorsToJson", &dart::simulation::World::colorsToJson)
+      .def(
+          "positionsToBinary",
+          +[](dart::simulation::World* self,
+              s_t positionPrecision,
+              bool includeColors) -> ::py::bytes {
+            return ::py::bytes(
+                self->positionsToBinary(positionPrecision, includeColors));
+          },
+          ::py::arg("positionPrecision") = 0.0,
+          ::py::arg("includeColors") = false)
       .def(
           "setUseFDOverride",
           &dart::simulation::World::setUseFDOverride,
           ::py::arg("useFDOverride"))
       .def("getUseFDOverride", &dart::simulation::World::getUseFDOverride)
+      .def(
+          "setForwardPassCacheSize",
+          &dart::simulation::World::setForwardPassCacheSize,
+          ::py::arg("maxEntries"))
+      .def(
+          "getForwardPassCache",
+          &dart::simulation::World::getForwardPassCache)
+      .def(
+          "clearForwardPassCache",
+          &dart::simulation::World::clearForwardPassCache)
       .def(
           "getCachedLCPSolution",
           &dart::simulation::World::getCachedLCPSolution)
@@ -498,7 +720,23 @@ void World(py::module& m)
           &dart::simulation::World::setSlowDebugResultsAgainstFD)
       .def("getStateSize", &dart::simulation::World::getStateSize)
       .def("setState", &dart::simulation::World::setState, ::py::arg("state"))
-      .def("getState", &dart::simulation::World::getState)
+      .def(
+          "getState",
+          +[](dart::simulation::World* self) -> Eigen::VectorXs {
+            return self->getState();
+          })
+      .def(
+          "getStateInto",
+          +[](dart::simulation::World* self, Eigen::Ref<Eigen::VectorXs> out)
+              -> void { self->getState(out); },
+          ::py::arg("out"))
+      .def(
+          "setStateFrom",
+          +[](dart::simulation::World* self,
+              Eigen::Ref<const Eigen::VectorXs> state) -> void {
+            self->setStateFrom(state);
+          },
+          ::py::arg("state"))
       .def("getActionSize", &dart::simulation::World::getActionSize)
       .def(
           "setAction", &dart::simulation::World::setAction, ::py::arg("action"))
@@ -516,8 +754,31 @@ void World(py::module& m)
           "addDofToActionSpace",
           &dart::simulation::World::addDofToActionSpace,
           ::py::arg("dofIndex"))
-      .def("getStateJacobian", &dart::simulation::World::getStateJacobian)
-      .def("getActionJacobian", &dart::simulation::World::getActionJacobian)
+      .def(
+          "getStateJacobian",
+          +[](dart::simulation::World* self) -> Eigen::MatrixXs {
+            return self->getStateJacobian();
+          })
+      .def(
+          "getStateJacobianInto",
+          +[](dart::simulation::World* self, Eigen::Ref<Eigen::MatrixXs> out)
+              -> void { self->getStateJacobian(out); },
+          ::py::arg("out"))
+      .def(
+          "getActionJacobian",
+          +[](dart::simulation::World* self) -> Eigen::MatrixXs {
+            return self->getActionJacobian();
+          })
+      .def(
+          "getActionJacobianInto",
+          +[](dart::simulation::World* self, Eigen::Ref<Eigen::MatrixXs> out)
+              -> void { self->getActionJacobian(out); },
+          ::py::arg("out"))
+      .def(
+          "getActionVelJacobianInto",
+          +[](dart::simulation::World* self, Eigen::Ref<Eigen::MatrixXs> out)
+              -> void { self->getActionVelJacobian(out); },
+          ::py::arg("out"))
       .def_readonly("onNameChanged", &dart::simulation::World::onNameChanged);
 }
 
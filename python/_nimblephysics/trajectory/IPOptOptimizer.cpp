@@ -96,7 +96,24 @@ void IPOptOptimizer(py::module& m)
       .def(
           "setRecordIterations",
           &dart::trajectory::IPOptOptimizer::setRecordIterations,
-          ::py::arg("recordIterations") = true);
+          ::py::arg("recordIterations") = true)
+      .def(
+          "setIterationRecordingPolicy",
+          &dart::trajectory::IPOptOptimizer::setIterationRecordingPolicy,
+          ::py::arg("policy"),
+          ::py::arg("n") = 1)
+      .def(
+          "setIterationStreamPath",
+          &dart::trajectory::IPOptOptimizer::setIterationStreamPath,
+          ::py::arg("path"))
+      .def(
+          "setGaussNewtonHessian",
+          &dart::trajectory::IPOptOptimizer::setGaussNewtonHessian,
+          ::py::arg("gaussNewtonHessian") = true)
+      .def(
+          "setUseLBFGSB",
+          &dart::trajectory::IPOptOptimizer::setUseLBFGSB,
+          ::py::arg("useLBFGSB") = true);
   /*
   .def(
       "registerIntermediateCallback",
@@ -75,7 +75,36 @@ void LossFn(py::module& m)
           "setLowerBound",
           &dart::trajectory::LossFn::setLowerBound,
           ::py::arg("lowerBound"))
-      .def("getLowerBound", &dart::trajectory::LossFn::getLowerBound);
+      .def("getLowerBound", &dart::trajectory::LossFn::getLowerBound)
+      .def(
+          "isTimestepSeparable",
+          &dart::trajectory::LossFn::isTimestepSeparable)
+      .def("getStartTime", &dart::trajectory::LossFn::getStartTime)
+      .def("getEndTime", &dart::trajectory::LossFn::getEndTime)
+      .def(
+          "setParallelOperationsEnabled",
+          &dart::trajectory::LossFn::setParallelOperationsEnabled,
+          ::py::arg("enabled"));
+
+  ::py::class_<
+      dart::trajectory::TimestepLossFn,
+      dart::trajectory::LossFn,
+      std::shared_ptr<dart::trajectory::TimestepLossFn>>(m, "TimestepLossFn")
+      .def(
+          ::py::init<dart::trajectory::TimestepLossTerm, int, int>(),
+          ::py::arg("loss"),
+          ::py::arg("startTime"),
+          ::py::arg("endTime"))
+      .def(
+          ::py::init<
+              dart::trajectory::TimestepLossTerm,
+              dart::trajectory::TimestepLossTermAndGrad,
+              int,
+              int>(),
+          ::py::arg("loss"),
+          ::py::arg("lossFnAndGrad"),
+          ::py::arg("startTime"),
+          ::py::arg("endTime"));
 }
 
 } // namespace python
@@ -35,6 +35,7 @@
 #include <dart/trajectory/MultiShot.hpp>
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -60,7 +61,41 @@ void MultiShot(py::module& m)
       .def(
           "setParallelOperationsEnabled",
           &dart::trajectory::MultiShot::setParallelOperationsEnabled,
-          ::py::arg("enabled"));
+          ::py::arg("enabled"))
+      .def(
+          "getNumParallelWorlds",
+          &dart::trajectory::MultiShot::getNumParallelWorlds)
+      .def("getShotLengths", &dart::trajectory::MultiShot::getShotLengths)
+      .def(
+          "setShotLengths",
+          &dart::trajectory::MultiShot::setShotLengths,
+          ::py::arg("world"),
+          ::py::arg("lengths"))
+      .def(
+          "adaptShots",
+          [](dart::trajectory::MultiShot* self,
+             std::shared_ptr<dart::simulation::World> world,
+             s_t splitDefect,
+             s_t mergeDefect,
+             int minShotLength,
+             int maxShotLength) -> bool {
+            return self->adaptShots(
+                world, splitDefect, mergeDefect, minShotLength, maxShotLength);
+          },
+          ::py::arg("world"),
+          ::py::arg("splitDefect"),
+          ::py::arg("mergeDefect"),
+          ::py::arg("minShotLength"),
+          ::py::arg("maxShotLength"))
+      .def(
+          "pararealInitializeKnots",
+          [](dart::trajectory::MultiShot* self,
+             std::shared_ptr<dart::simulation::World> world,
+             dart::trajectory::PararealConfig config) -> int {
+            return self->pararealInitializeKnots(world, config);
+          },
+          ::py::arg("world"),
+          ::py::arg("config") = dart::trajectory::PararealConfig());
 }
 
 } // namespace python
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/simulation/World.hpp>
+#include <dart/trajectory/Parareal.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void Parareal(py::module& m)
+{
+  ::py::class_<dart::trajectory::PararealConfig>(m, "PararealConfig")
+      .def(::py::init<>())
+      .def(
+          "setNumSlices",
+          &dart::trajectory::PararealConfig::setNumSlices,
+          ::py::arg("v"))
+      .def(
+          "setCoarseStepFactor",
+          &dart::trajectory::PararealConfig::setCoarseStepFactor,
+          ::py::arg("v"))
+      .def(
+          "setMaxIterations",
+          &dart::trajectory::PararealConfig::setMaxIterations,
+          ::py::arg("v"))
+      .def(
+          "setTolerance",
+          &dart::trajectory::PararealConfig::setTolerance,
+          ::py::arg("v"))
+      .def_readwrite(
+          "numSlices", &dart::trajectory::PararealConfig::numSlices)
+      .def_readwrite(
+          "coarseStepFactor",
+          &dart::trajectory::PararealConfig::coarseStepFactor)
+      .def_readwrite(
+          "maxIterations", &dart::trajectory::PararealConfig::maxIterations)
+      .def_readwrite(
+          "tolerance", &dart::trajectory::PararealConfig::tolerance);
+
+  ::py::class_<dart::trajectory::PararealResult>(m, "PararealResult")
+      .def_readonly("poses", &dart::trajectory::PararealResult::poses)
+      .def_readonly("vels", &dart::trajectory::PararealResult::vels)
+      .def_readonly("iterations", &dart::trajectory::PararealResult::iterations)
+      .def_readonly(
+          "maxCorrection", &dart::trajectory::PararealResult::maxCorrection)
+      .def_readonly("converged", &dart::trajectory::PararealResult::converged);
+
+  ::py::class_<
+      dart::trajectory::Parareal,
+      std::shared_ptr<dart::trajectory::Parareal>>(m, "Parareal")
+      .def(
+          ::py::init<
+              std::shared_ptr<dart::simulation::World>,
+              dart::trajectory::PararealConfig>(),
+          ::py::arg("world"),
+          ::py::arg("config") = dart::trajectory::PararealConfig())
+      .def(
+          "setConfig",
+          &dart::trajectory::Parareal::setConfig,
+          ::py::arg("config"))
+      .def("getConfig", &dart::trajectory::Parareal::getConfig)
+      .def(
+          "rollout",
+          +[](dart::trajectory::Parareal* self,
+              Eigen::VectorXs startPos,
+              Eigen::VectorXs startVel,
+              Eigen::MatrixXs forces) {
+            return self->rollout(startPos, startVel, forces);
+          },
+          ::py::arg("startPos"),
+          ::py::arg("startVel"),
+          ::py::arg("forces"),
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
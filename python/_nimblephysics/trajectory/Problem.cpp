@@ -239,6 +239,10 @@ void Problem(py::module& m)
           "addConstraint",
           &dart::trajectory::Problem::addConstraint,
           ::py::arg("constraint"))
+      .def(
+          "addLeastSquaresResidual",
+          &dart::trajectory::Problem::addLeastSquaresResidual,
+          ::py::arg("residual"))
       .def(
           "pinForce",
           &dart::trajectory::Problem::pinForce,
@@ -279,7 +283,8 @@ void Problem(py::module& m)
           "getFinalState",
           &dart::trajectory::Problem::getFinalState,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def("getNumSteps", &dart::trajectory::Problem::getNumSteps)
       .def(
           "getFlatDimName",
@@ -290,7 +295,8 @@ void Problem(py::module& m)
           "getLoss",
           &dart::trajectory::Problem::getLoss,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getRolloutCache",
           &dart::trajectory::Problem::getRolloutCache,
@@ -38,6 +38,7 @@
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -68,7 +69,28 @@ void SGDOptimizer(py::module& m)
       .def(
           "setLearningRate",
           &dart::trajectory::SGDOptimizer::setLearningRate,
-          ::py::arg("learningRate") = 0.1);
+          ::py::arg("learningRate") = 0.1)
+      .def(
+          "setMomentum",
+          &dart::trajectory::SGDOptimizer::setMomentum,
+          ::py::arg("momentum"))
+      .def(
+          "setAdamEnabled",
+          &dart::trajectory::SGDOptimizer::setAdamEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "setAdamBetas",
+          &dart::trajectory::SGDOptimizer::setAdamBetas,
+          ::py::arg("beta1") = 0.9,
+          ::py::arg("beta2") = 0.999)
+      .def(
+          "setBatchProblems",
+          &dart::trajectory::SGDOptimizer::setBatchProblems,
+          ::py::arg("problems"))
+      .def(
+          "setBatchPerturbation",
+          &dart::trajectory::SGDOptimizer::setBatchPerturbation,
+          ::py::arg("perturbation"));
   /*
   .def(
       "registerIntermediateCallback",
@@ -54,7 +54,11 @@ void SingleShot(py::module& m)
           ::py::arg("world"),
           ::py::arg("loss"),
           ::py::arg("steps"),
-          ::py::arg("tuneStartingState") = false);
+          ::py::arg("tuneStartingState") = false)
+      .def(
+          "setJacobianCacheBudget",
+          &dart::trajectory::SingleShot::setJacobianCacheBudget,
+          ::py::arg("maxBytes"));
 }
 
 } // namespace python
@@ -42,11 +42,37 @@ namespace python {
 
 void Solution(py::module& m)
 {
+  ::py::enum_<dart::trajectory::IterationRecordingPolicy>(
+      m, "IterationRecordingPolicy")
+      .value("ALL", dart::trajectory::IterationRecordingPolicy::ALL)
+      .value("LAST_N", dart::trajectory::IterationRecordingPolicy::LAST_N)
+      .value("EVERY_KTH", dart::trajectory::IterationRecordingPolicy::EVERY_KTH)
+      .value("BEST", dart::trajectory::IterationRecordingPolicy::BEST)
+      .value(
+          "STREAM_TO_DISK",
+          dart::trajectory::IterationRecordingPolicy::STREAM_TO_DISK)
+      .export_values();
+
   ::py::class_<
       dart::trajectory::Solution,
       std::shared_ptr<dart::trajectory::Solution>>(m, "Solution")
       .def("toJson", &dart::trajectory::Solution::toJson, ::py::arg("world"))
       .def("getNumSteps", &dart::trajectory::Solution::getNumSteps)
+      .def(
+          "setIterationRecordingPolicy",
+          &dart::trajectory::Solution::setIterationRecordingPolicy,
+          ::py::arg("policy"),
+          ::py::arg("n") = 1)
+      .def(
+          "getIterationRecordingPolicy",
+          &dart::trajectory::Solution::getIterationRecordingPolicy)
+      .def(
+          "setIterationStreamPath",
+          &dart::trajectory::Solution::setIterationStreamPath,
+          ::py::arg("path"))
+      .def(
+          "getNumRegisteredIterations",
+          &dart::trajectory::Solution::getNumRegisteredIterations)
       .def(
           "getStep",
           &dart::trajectory::Solution::getStep,
@@ -56,6 +82,11 @@ void Solution(py::module& m)
           "getPerfLog",
           &dart::trajectory::Solution::getPerfLog,
           ::py::return_value_policy::reference)
+      .def("canReoptimize", &dart::trajectory::Solution::canReoptimize)
+      .def(
+          "shiftWarmStart",
+          &dart::trajectory::Solution::shiftWarmStart,
+          ::py::arg("mapping"))
       .def("reoptimize", &dart::trajectory::Solution::reoptimize);
 
   ::py::class_<dart::trajectory::OptimizationStep>(m, "OptimizationStep")
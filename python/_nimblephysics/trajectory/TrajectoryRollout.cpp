@@ -57,16 +57,22 @@ void TrajectoryRollout(py::module& m)
       .def(
           "getPoses",
           &dart::trajectory::TrajectoryRollout::getPoses,
-          ::py::arg("mapping") = "identity")
+          ::py::arg("mapping") = "identity",
+          ::py::return_value_policy::reference_internal)
       .def(
           "getVels",
           &dart::trajectory::TrajectoryRollout::getVels,
-          ::py::arg("mapping") = "identity")
+          ::py::arg("mapping") = "identity",
+          ::py::return_value_policy::reference_internal)
       .def(
           "getControlForces",
           &dart::trajectory::TrajectoryRollout::getControlForces,
-          ::py::arg("mapping") = "identity")
-      .def("getMasses", &dart::trajectory::TrajectoryRollout::getMasses)
+          ::py::arg("mapping") = "identity",
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "getMasses",
+          &dart::trajectory::TrajectoryRollout::getMasses,
+          ::py::return_value_policy::reference_internal)
       .def(
           "toJson",
           &dart::trajectory::TrajectoryRollout::toJson,
@@ -75,6 +81,26 @@ void TrajectoryRollout(py::module& m)
           "copy",
           &dart::trajectory::TrajectoryRollout::copy,
           ::py::return_value_policy::automatic);
+
+  ::py::class_<dart::trajectory::CompactTrajectoryRollout>(
+      m, "CompactTrajectoryRollout")
+      .def(
+          ::py::init<const dart::trajectory::TrajectoryRollout*>(),
+          ::py::arg("rollout"))
+      .def(
+          "toRollout",
+          // TrajectoryRolloutReal isn't bound on its own, so hand it back the
+          // same way copy() does
+          [](const dart::trajectory::CompactTrajectoryRollout& self)
+              -> dart::trajectory::TrajectoryRollout* {
+            return new dart::trajectory::TrajectoryRolloutReal(
+                self.toRollout());
+          },
+          ::py::return_value_policy::automatic)
+      .def(
+          "getMappings",
+          &dart::trajectory::CompactTrajectoryRollout::getMappings)
+      .def("bytes", &dart::trajectory::CompactTrajectoryRollout::bytes);
 }
 
 } // namespace python
@@ -45,6 +45,7 @@ void SGDOptimizer(py::module& sm);
 void LossFn(py::module& sm);
 void Problem(py::module& sm);
 void MultiShot(py::module& sm);
+void Parareal(py::module& sm);
 void SingleShot(py::module& sm);
 void TrajectoryRollout(py::module& sm);
 void Solution(py::module& sm);
@@ -62,6 +63,7 @@ void dart_trajectory(py::module& m)
   SGDOptimizer(sm);
   LossFn(sm);
   Problem(sm);
+  Parareal(sm);
   MultiShot(sm);
   SingleShot(sm);
   TrajectoryRollout(sm);
@@ -1,9 +1,9 @@
 from nimblephysics_libs._nimblephysics import *
-from .timestep import timestep
-from .get_height import get_height
-from .get_lowest_point import get_lowest_point
-from .get_anthropometric_log_pdf import get_anthropometric_log_pdf
-from .get_marker_dist_to_nearest_vertex import get_marker_dist_to_nearest_vertex
+from .timestep import timestep, batch_timestep, featherstone_batch_timestep
+from .get_height import get_height, batch_get_height
+from .get_lowest_point import get_lowest_point, batch_get_lowest_point
+from .get_anthropometric_log_pdf import get_anthropometric_log_pdf, batch_get_anthropometric_log_pdf
+from .get_marker_dist_to_nearest_vertex import get_marker_dist_to_nearest_vertex, batch_get_marker_dist_to_nearest_vertex
 from .native_trajectory_support import *
 from .gui_server import NimbleGUI
 from .mapping import map_to_pos, map_to_vel
@@ -83,3 +83,76 @@ def get_anthropometric_log_pdf(
   bodyScalesTensor: torch.Tensor = torch.cat(bodyScalesArr, dim=0)
 
   return GetAnthropometricLogPDF.apply(skel, anthro, bodyNames, bodyScalesTensor)
+
+
+class BatchGetAnthropometricLogPDF(torch.autograd.Function):
+  """
+  This implements GetAnthropometricLogPDF on a whole batch of body scales at
+  once. The batch is evaluated in parallel in C++, each thread on its own
+  clone of the skeleton, so the skeleton itself is never modified.
+  """
+
+  @staticmethod
+  def forward(ctx, queries, anthro, bodyNames, bodyScales):
+    """
+    queries: nimble.biomechanics.BatchScaleQueries
+    anthro: nimble.biomechanics.Anthropometrics
+    bodyNames: List[str]
+    bodyScales: torch.Tensor, shape (batch_size, len(bodyNames), 3)
+    -> torch.Tensor, shape (batch_size,)
+    """
+    skel: nimble.dynamics.Skeleton = queries.getSkeleton()
+    indices: List[int] = [skel.getBodyNode(
+        body).getIndexInSkeleton() for body in bodyNames]
+    scales: np.ndarray = bodyScales.detach().numpy()
+
+    # Bodies we weren't passed keep the skeleton's current scales
+    fullScales: np.ndarray = np.tile(
+        skel.getBodyScales(), (scales.shape[0], 1))
+    for i in range(len(indices)):
+      fullScales[:, indices[i]*3:(indices[i]+1)*3] = scales[:, i, :]
+
+    result: nimble.biomechanics.BatchScaleQueryResult = queries.getAnthropometricLogPDFs(
+        anthro, fullScales, False)
+    ctx.pdfGrad = result.gradWrtBodyScales
+    ctx.indices = indices
+
+    return torch.tensor(result.values)
+
+  @staticmethod
+  def backward(ctx, grad_pdfs):
+    pdfGrad: np.ndarray = ctx.pdfGrad
+    indices: List[int] = ctx.indices
+
+    lossWrtPDFs: np.ndarray = grad_pdfs.detach().numpy()[:, np.newaxis]
+    lossWrtBodyScales: torch.Tensor = torch.zeros(
+        (pdfGrad.shape[0], len(indices), 3), dtype=torch.float64)
+    for i in range(len(indices)):
+      lossWrtBodyScales[:, i, :] = torch.from_numpy(
+          pdfGrad[:, indices[i]*3:(indices[i]+1)*3] * lossWrtPDFs)
+
+    return (
+        None,
+        None,
+        None,
+        lossWrtBodyScales
+    )
+
+
+def batch_get_anthropometric_log_pdf(
+        queries: nimble.biomechanics.BatchScaleQueries,
+        anthro: nimble.biomechanics.Anthropometrics,
+        bodyScales: Dict[str, torch.Tensor]) -> torch.Tensor:
+  """
+  This gets the anthropometric log PDF for every row of the `bodyScales`
+  tensors, which are each shaped (batch_size, 3).
+  """
+  bodyNames: List[str] = []
+  bodyScalesArr: List[torch.Tensor] = []
+  for name in bodyScales:
+    bodyNames.append(name)
+    bodyScalesArr.append(bodyScales[name])
+  bodyScalesTensor: torch.Tensor = torch.stack(bodyScalesArr, dim=1)
+
+  return BatchGetAnthropometricLogPDF.apply(  # type: ignore
+      queries, anthro, bodyNames, bodyScalesTensor)
@@ -82,3 +82,77 @@ def get_height(skel: nimble.dynamics.Skeleton, position: np.ndarray,
   bodyScalesTensor: torch.Tensor = torch.cat(bodyScalesArr, dim=0)
 
   return GetHeightLayer.apply(skel, position, bodyNames, bodyScalesTensor)  # type: ignore
+
+
+class BatchGetHeightLayer(torch.autograd.Function):
+  """
+  This implements GetHeightLayer on a whole batch of body scales at once. The
+  batch is evaluated in parallel in C++, each thread on its own clone of the
+  skeleton, so the skeleton itself is never modified.
+  """
+
+  @staticmethod
+  def forward(ctx, queries, positions, bodyNames, bodyScales):
+    """
+    queries: nimble.biomechanics.BatchScaleQueries
+    positions: torch.Tensor, shape (batch_size, num_dofs) or (num_dofs,)
+    bodyNames: List[str]
+    bodyScales: torch.Tensor, shape (batch_size, len(bodyNames), 3)
+    -> torch.Tensor, shape (batch_size,)
+    """
+    skel: nimble.dynamics.Skeleton = queries.getSkeleton()
+    indices: List[int] = [skel.getBodyNode(
+        body).getIndexInSkeleton() for body in bodyNames]
+    scales: np.ndarray = bodyScales.detach().numpy()
+
+    # Bodies we weren't passed keep the skeleton's current scales
+    fullScales: np.ndarray = np.tile(
+        skel.getBodyScales(), (scales.shape[0], 1))
+    for i in range(len(indices)):
+      fullScales[:, indices[i]*3:(indices[i]+1)*3] = scales[:, i, :]
+
+    result: nimble.biomechanics.BatchScaleQueryResult = queries.getHeights(
+        fullScales, np.atleast_2d(positions.detach().numpy()))
+    ctx.gradWrtBodyScales = result.gradWrtBodyScales
+    ctx.indices = indices
+
+    return torch.tensor(result.values)
+
+  @staticmethod
+  def backward(ctx, grad_heights):
+    gradWrtBodyScales: np.ndarray = ctx.gradWrtBodyScales
+    indices: List[int] = ctx.indices
+
+    lossWrtHeights: np.ndarray = grad_heights.detach().numpy()
+    lossWrtBodyScales: torch.Tensor = torch.zeros(
+        (gradWrtBodyScales.shape[0], len(indices), 3), dtype=torch.float64)
+    for i in range(len(indices)):
+      lossWrtBodyScales[:, i, :] = torch.from_numpy(
+          gradWrtBodyScales[:, indices[i]*3:(indices[i]+1)*3] *
+          lossWrtHeights[:, np.newaxis])
+
+    return (
+        None,
+        None,
+        None,
+        lossWrtBodyScales
+    )
+
+
+def batch_get_height(queries: nimble.biomechanics.BatchScaleQueries,
+                     positions: torch.Tensor,
+                     bodyScales: Dict[str, torch.Tensor]) -> torch.Tensor:
+  """
+  This gets the height of the skeleton for every row of the `bodyScales`
+  tensors, which are each shaped (batch_size, 3). `positions` is either one
+  pose per row, or a single pose used for every row.
+  """
+  bodyNames: List[str] = []
+  bodyScalesArr: List[torch.Tensor] = []
+  for name in bodyScales:
+    bodyNames.append(name)
+    bodyScalesArr.append(bodyScales[name])
+  bodyScalesTensor: torch.Tensor = torch.stack(bodyScalesArr, dim=1)
+
+  return BatchGetHeightLayer.apply(  # type: ignore
+      queries, positions, bodyNames, bodyScalesTensor)
@@ -97,3 +97,81 @@ def get_lowest_point(skel: nimble.dynamics.Skeleton, position: torch.Tensor,
   bodyScalesTensor: torch.Tensor = torch.cat(bodyScalesArr, dim=0)
 
   return GetLowestPointLayer.apply(skel, position, bodyNames, bodyScalesTensor)  # type: ignore
+
+
+class BatchGetLowestPointLayer(torch.autograd.Function):
+  """
+  This implements GetLowestPointLayer on a whole batch of body scales and
+  positions at once. The batch is evaluated in parallel in C++, each thread on
+  its own clone of the skeleton, so the skeleton itself is never modified.
+  """
+
+  @staticmethod
+  def forward(ctx, queries, positions, bodyNames, bodyScales):
+    """
+    queries: nimble.biomechanics.BatchScaleQueries
+    positions: torch.Tensor, shape (batch_size, num_dofs)
+    bodyNames: List[str]
+    bodyScales: torch.Tensor, shape (batch_size, len(bodyNames), 3)
+    -> torch.Tensor, shape (batch_size,)
+    """
+    skel: nimble.dynamics.Skeleton = queries.getSkeleton()
+    indices: List[int] = [skel.getBodyNode(
+        body).getIndexInSkeleton() for body in bodyNames]
+    scales: np.ndarray = bodyScales.detach().numpy()
+
+    # Bodies we weren't passed keep the skeleton's current scales
+    fullScales: np.ndarray = np.tile(
+        skel.getBodyScales(), (scales.shape[0], 1))
+    for i in range(len(indices)):
+      fullScales[:, indices[i]*3:(indices[i]+1)*3] = scales[:, i, :]
+
+    result: nimble.biomechanics.BatchScaleQueryResult = queries.getLowestPoints(
+        fullScales, positions.detach().numpy())
+    ctx.gradWrtBodyScales = result.gradWrtBodyScales
+    ctx.gradWrtPoses = result.gradWrtPoses
+    ctx.indices = indices
+
+    return torch.tensor(result.values)
+
+  @staticmethod
+  def backward(ctx, grad_lowest_points):
+    gradWrtBodyScales: np.ndarray = ctx.gradWrtBodyScales
+    gradWrtPoses: np.ndarray = ctx.gradWrtPoses
+    indices: List[int] = ctx.indices
+
+    lossWrtLowestPoints: np.ndarray = grad_lowest_points.detach().numpy()[
+        :, np.newaxis]
+    lossWrtPos: torch.Tensor = torch.from_numpy(
+        gradWrtPoses * lossWrtLowestPoints)
+    lossWrtBodyScales: torch.Tensor = torch.zeros(
+        (gradWrtBodyScales.shape[0], len(indices), 3), dtype=torch.float64)
+    for i in range(len(indices)):
+      lossWrtBodyScales[:, i, :] = torch.from_numpy(
+          gradWrtBodyScales[:, indices[i]*3:(indices[i]+1)*3] *
+          lossWrtLowestPoints)
+
+    return (
+        None,
+        lossWrtPos,
+        None,
+        lossWrtBodyScales
+    )
+
+
+def batch_get_lowest_point(queries: nimble.biomechanics.BatchScaleQueries,
+                           positions: torch.Tensor,
+                           bodyScales: Dict[str, torch.Tensor]) -> torch.Tensor:
+  """
+  This gets the lowest point on the skeleton for every row of `positions`,
+  and of the `bodyScales` tensors, which are each shaped (batch_size, 3).
+  """
+  bodyNames: List[str] = []
+  bodyScalesArr: List[torch.Tensor] = []
+  for name in bodyScales:
+    bodyNames.append(name)
+    bodyScalesArr.append(bodyScales[name])
+  bodyScalesTensor: torch.Tensor = torch.stack(bodyScalesArr, dim=1)
+
+  return BatchGetLowestPointLayer.apply(  # type: ignore
+      queries, positions, bodyNames, bodyScalesTensor)
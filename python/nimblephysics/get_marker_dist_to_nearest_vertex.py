@@ -59,8 +59,8 @@ class GetMarkerDistLayer(torch.autograd.Function):
 
     return (
         None,
-        lossWrtBodyScale,
-        lossWrtMarkerOffset
+        lossWrtMarkerOffset,
+        lossWrtBodyScale
     )
 
 
@@ -70,3 +70,57 @@ def get_marker_dist_to_nearest_vertex(
   This gets the distance between the marker and 
   """
   return GetMarkerDistLayer.apply(bodyNode, markerOffset, bodyScale)  # type: ignore
+
+
+class BatchGetMarkerDistLayer(torch.autograd.Function):
+  """
+  This implements GetMarkerDistLayer on a whole batch of marker offsets and
+  body scales at once. The batch is evaluated in parallel in C++, each thread
+  on its own clone of the skeleton, so the body itself is never modified.
+  """
+
+  @staticmethod
+  def forward(ctx, queries, bodyName, markerOffsets, bodyScales):
+    """
+    queries: nimble.biomechanics.BatchScaleQueries
+    bodyName: str
+    markerOffsets: torch.Tensor, shape (batch_size, 3)
+    bodyScales: torch.Tensor, shape (batch_size, 3)
+    -> torch.Tensor, shape (batch_size,)
+    """
+    result: nimble.biomechanics.BatchScaleQueryResult = queries.getMarkerDistsToNearestVertex(
+        bodyName, markerOffsets.detach().numpy(), bodyScales.detach().numpy())
+    ctx.scaleGrad = result.gradWrtBodyScales
+    ctx.offsetGrad = result.gradWrtMarkers
+
+    return torch.tensor(result.values)
+
+  @staticmethod
+  def backward(ctx, grad_dists):
+    scaleGrad: np.ndarray = ctx.scaleGrad
+    offsetGrad: np.ndarray = ctx.offsetGrad
+
+    lossWrtDists: np.ndarray = grad_dists.detach().numpy()[:, np.newaxis]
+
+    lossWrtBodyScales: torch.Tensor = torch.from_numpy(scaleGrad * lossWrtDists)
+    lossWrtMarkerOffsets: torch.Tensor = torch.from_numpy(
+        offsetGrad * lossWrtDists)
+
+    return (
+        None,
+        None,
+        lossWrtMarkerOffsets,
+        lossWrtBodyScales
+    )
+
+
+def batch_get_marker_dist_to_nearest_vertex(
+        queries: nimble.biomechanics.BatchScaleQueries, bodyName: str,
+        markerOffsets: torch.Tensor, bodyScales: torch.Tensor) -> torch.Tensor:
+  """
+  This gets the distance between the marker and the nearest vertex on the body
+  named `bodyName`, for every row of `markerOffsets` and `bodyScales`, which
+  are each shaped (batch_size, 3).
+  """
+  return BatchGetMarkerDistLayer.apply(  # type: ignore
+      queries, bodyName, markerOffsets, bodyScales)
@@ -28,7 +28,9 @@ class TimestepLayer(torch.autograd.Function):
     -> torch.Tensor
     """
 
-    world.setState(state.detach().numpy())
+    # setStateFrom() reads the tensor's memory in place, and getState()
+    # hands back a fresh array that torch can take over without copying
+    world.setStateFrom(state.detach().numpy())
     world.setAction(action.detach().numpy())
     ctx.use_mass = mass is not None
     if ctx.use_mass:
@@ -37,7 +39,7 @@ class TimestepLayer(torch.autograd.Function):
     ctx.backprop_snapshot = backprop_snapshot
     ctx.world = world
 
-    return torch.tensor(world.getState())
+    return torch.from_numpy(world.getState())
 
   @staticmethod
   def backward(ctx, grad_state):
@@ -67,3 +69,123 @@ def timestep(world: nimble.simulation.World, state: torch.Tensor,
   in order to do a backwards pass.
   """
   return TimestepLayer.apply(world, state, action, mass)  # type: ignore
+
+
+class BatchTimestepLayer(torch.autograd.Function):
+  """
+  This implements a differentiable timestep on every world in a
+  nimble.neural.WorldBatch at once, as a PyTorch layer. All the worlds are
+  stepped in parallel in C++, so this is much faster than calling
+  TimestepLayer in a Python loop.
+  """
+
+  @staticmethod
+  def forward(ctx, world_batch, states, actions, masses):
+    """
+    world_batch: nimble.neural.WorldBatch
+    states: torch.Tensor, shape (num_worlds, state_size)
+    actions: torch.Tensor, shape (num_worlds, action_size)
+    masses: Optional[torch.Tensor], shape (num_worlds, mass_dims)
+    -> torch.Tensor, shape (num_worlds, state_size)
+    """
+
+    # WorldBatch works with one column per world
+    ctx.use_mass = masses is not None
+    if ctx.use_mass:
+      result: nimble.neural.BatchForwardPassResult = world_batch.forwardPass(
+          states.detach().numpy().T, actions.detach().numpy().T,
+          masses.detach().numpy().T)
+    else:
+      result = world_batch.forwardPass(
+          states.detach().numpy().T, actions.detach().numpy().T)
+    # We hold on to the whole native result, rather than pulling the
+    # snapshots out into a Python list, which is slow for big batches
+    ctx.result = result
+    ctx.world_batch = world_batch
+
+    return torch.tensor(result.nextStates.T)
+
+  @staticmethod
+  def backward(ctx, grad_states):
+    world_batch: nimble.neural.WorldBatch = ctx.world_batch
+    grads: nimble.neural.BatchLossGradient = world_batch.backpropState(
+        ctx.result, grad_states.detach().numpy().T)
+
+    return (
+        None,
+        torch.tensor(grads.lossWrtState.T, dtype=torch.float64),
+        torch.tensor(grads.lossWrtAction.T, dtype=torch.float64),
+        torch.tensor(grads.lossWrtMass.T, dtype=torch.float64)
+        if ctx.use_mass else None
+    )
+
+
+def batch_timestep(world_batch: nimble.neural.WorldBatch, states: torch.Tensor,
+    actions: torch.Tensor, masses: Optional[torch.Tensor] = None
+    ) -> torch.Tensor:
+  """
+  This steps every world in `world_batch` in parallel, with one row of
+  `states` and `actions` (and optionally `masses`) per world, storing
+  information needed in order to do a backwards pass.
+  """
+  return BatchTimestepLayer.apply(  # type: ignore
+      world_batch, states, actions, masses)
+
+
+class FeatherstoneBatchTimestepLayer(torch.autograd.Function):
+  """
+  This implements a differentiable timestep on every world in a
+  nimble.neural.FeatherstoneWorldBatch at once, as a PyTorch layer. The
+  native side reads the inputs and writes the outputs through the tensors'
+  own memory, so nothing gets copied on the way in or out.
+  """
+
+  @staticmethod
+  def forward(ctx, world_batch, states, actions):
+    """
+    world_batch: nimble.neural.FeatherstoneWorldBatch
+    states: torch.Tensor, shape (num_worlds, state_size)
+    actions: torch.Tensor, shape (num_worlds, action_size)
+    -> torch.Tensor, shape (num_worlds, state_size)
+    """
+
+    # A contiguous (num_worlds, size) tensor, transposed, is exactly the
+    # column-major (size, num_worlds) matrix the batch works with
+    states = states.detach().to(torch.float64).contiguous()
+    actions = actions.detach().to(torch.float64).contiguous()
+    next_states = torch.empty_like(states)
+    tape: nimble.neural.FeatherstoneBatchTape = world_batch.forwardPass(
+        states.numpy().T, actions.numpy().T, next_states.numpy().T)
+    ctx.tape = tape
+    ctx.world_batch = world_batch
+    ctx.action_shape = actions.shape
+
+    return next_states
+
+  @staticmethod
+  def backward(ctx, grad_states):
+    world_batch: nimble.neural.FeatherstoneWorldBatch = ctx.world_batch
+    grad_states = grad_states.detach().to(torch.float64).contiguous()
+    loss_wrt_states = torch.empty_like(grad_states)
+    loss_wrt_actions = torch.empty(ctx.action_shape, dtype=torch.float64)
+    world_batch.backpropState(
+        ctx.tape, grad_states.numpy().T, loss_wrt_states.numpy().T,
+        loss_wrt_actions.numpy().T)
+
+    return (
+        None,
+        loss_wrt_states,
+        loss_wrt_actions
+    )
+
+
+def featherstone_batch_timestep(
+        world_batch: nimble.neural.FeatherstoneWorldBatch, states: torch.Tensor,
+        actions: torch.Tensor) -> torch.Tensor:
+  """
+  This steps every world in `world_batch` in parallel, with one row of
+  `states` and `actions` per world, storing information needed in order to do
+  a backwards pass.
+  """
+  return FeatherstoneBatchTimestepLayer.apply(  # type: ignore
+      world_batch, states, actions)
@@ -9,7 +9,8 @@ import os
 from typing import Dict
 
 
-def main():
+def createWorld() -> dart.simulation.World:
+  """This builds Atlas standing on the ground"""
   world = dart.simulation.World()
   world.setGravity([0, -9.81, 0])
   # world.setSlowDebugResultsAgainstFD(True)
@@ -22,7 +23,11 @@ def main():
       os.path.dirname(__file__), "../../data/sdf/atlas/ground.urdf"))
   floorBody: dart.dynamics.BodyNode = ground.getBodyNode(0)
   floorBody.getShapeNode(0).getVisualAspect().setCastShadows(False)
+  return world
+
 
+def main():
+  world = createWorld()
   snapshot: dart.neural.BackpropSnapshot = dart.neural.forwardPass(world)
   snapshot.benchmarkJacobians(world, 2)
 
@@ -2,7 +2,8 @@ import numpy as np
 import nimblephysics as dart
 
 
-def main():
+def createWorld() -> dart.simulation.World:
+  """This builds a three link catapult, in contact with a projectile"""
   world = dart.simulation.World()
   world.setGravity([0, -9.81, 0])
 
@@ -112,6 +113,11 @@ def main():
   projectile.setPosition(1, 0.0)
   catapult.setPosition(2, 0.65)
 
+  return world
+
+
+def main():
+  world = createWorld()
   world.step()
 
   snapshot: dart.neural.BackpropSnapshot = dart.neural.forwardPass(world)
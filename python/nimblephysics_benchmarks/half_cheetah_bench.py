@@ -4,7 +4,8 @@ import nimblephysics as dart
 import os
 
 
-def main():
+def createWorld() -> dart.simulation.World:
+  """This builds the half cheetah, resting on the floor"""
   world: dart.simulation.World = dart.simulation.World.loadFrom(os.path.join(
       os.path.dirname(__file__), "../../data/skel/half_cheetah.skel"))
 
@@ -19,6 +20,11 @@ def main():
   cheetah.setPosition(2, 0.03)
   cheetah.setPosition(1, -0.1)
 
+  return world
+
+
+def main():
+  world = createWorld()
   world.step()
 
   snapshot: dart.neural.BackpropSnapshot = dart.neural.forwardPass(world)
@@ -0,0 +1,197 @@
+"""
+This runs the scenes from the *_bench.py scripts through a fixed set of
+workloads, and reports throughput with its variance across repeats.
+
+Every native call the harness makes is timed from inside the binding with a
+PerformanceLog, so the wall clock time measured in Python can be split into
+the time spent in C++ and the time spent crossing the binding (argument
+conversion, releasing the GIL, wrapping results, and the Python loop itself).
+
+Usage:
+  python3 harness.py
+  python3 harness.py --scenes jump_worm catapult --workloads step --repeats 10
+  python3 harness.py --json results.json
+"""
+import argparse
+import importlib
+import json
+import os
+import statistics
+import sys
+import time
+from typing import Callable, Dict, List
+
+import numpy as np
+import nimblephysics as dart
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+# Maps each scene name to the module that builds it with createWorld()
+SCENES: Dict[str, str] = {
+    'atlas': 'atlas_bench',
+    'catapult': 'catapult_bench',
+    'half_cheetah': 'half_cheetah_bench',
+    'jump_worm': 'jump_worm_bench',
+}
+
+ROOT_LOG_NAME = 'harness'
+
+
+def stepWorkload(world: dart.simulation.World,
+                 perfLog: dart.performance.PerformanceLog):
+  world.step(perfLog=perfLog)
+
+
+def forwardPassWorkload(world: dart.simulation.World,
+                        perfLog: dart.performance.PerformanceLog):
+  dart.neural.forwardPass(world, perfLog=perfLog)
+
+
+def backpropWorkload(world: dart.simulation.World,
+                     perfLog: dart.performance.PerformanceLog):
+  snapshot: dart.neural.BackpropSnapshot = dart.neural.forwardPass(
+      world, perfLog=perfLog)
+  snapshot.backpropState(
+      world, np.ones(world.getStateSize()), perfLog=perfLog)
+
+
+# Each workload advances the world by one timestep per call. The unit is what
+# we call one timestep's worth of work when reporting throughput.
+WORKLOADS: Dict[str, Callable] = {
+    'step': stepWorkload,
+    'forwardPass': forwardPassWorkload,
+    'backprop': backpropWorkload,
+}
+UNITS: Dict[str, str] = {
+    'step': 'steps/s',
+    'forwardPass': 'steps/s',
+    'backprop': 'frames/s',
+}
+
+
+def timeRepeat(world: dart.simulation.World, workload: Callable,
+               steps: int, ticksPerSecond: float) -> Dict[str, float]:
+  """
+  This runs `steps` timesteps of `workload`, and returns the wall clock time
+  along with the part of it that was spent in native code
+  """
+  dart.performance.PerformanceLog.initialize()
+  root = dart.performance.PerformanceLog.startRoot(ROOT_LOG_NAME)
+  start = time.perf_counter()
+  for _ in range(steps):
+    workload(world, root)
+  wall = time.perf_counter() - start
+  root.end()
+
+  finalized = dart.performance.PerformanceLog.finalize()[ROOT_LOG_NAME]
+  nativeTicks: Dict[str, int] = {}
+  for name in finalized.getChildNames():
+    nativeTicks[name] = finalized.getChild(name).getTotalRuntime()
+  native = sum(nativeTicks.values()) / ticksPerSecond
+  return {
+      'wall': wall,
+      'native': native,
+      'breakdown': {name: ticks / ticksPerSecond
+                    for name, ticks in nativeTicks.items()},
+  }
+
+
+def summarize(values: List[float]) -> Dict[str, float]:
+  return {
+      'mean': statistics.mean(values),
+      'stdev': statistics.stdev(values) if len(values) > 1 else 0.0,
+      'min': min(values),
+      'max': max(values),
+  }
+
+
+def runBenchmark(scene: str, workloadName: str, steps: int, repeats: int,
+                 warmup: int, ticksPerSecond: float) -> Dict:
+  world: dart.simulation.World = importlib.import_module(
+      SCENES[scene]).createWorld()
+  workload = WORKLOADS[workloadName]
+  initialState = world.getState()
+
+  # Every repeat starts from the same state, so they all do the same work
+  for _ in range(warmup):
+    world.setState(initialState)
+    timeRepeat(world, workload, steps, ticksPerSecond)
+
+  runs = []
+  for _ in range(repeats):
+    world.setState(initialState)
+    runs.append(timeRepeat(world, workload, steps, ticksPerSecond))
+
+  breakdown: Dict[str, List[float]] = {}
+  for run in runs:
+    for name, seconds in run['breakdown'].items():
+      breakdown.setdefault(name, []).append(seconds / steps * 1e6)
+
+  return {
+      'scene': scene,
+      'workload': workloadName,
+      'unit': UNITS[workloadName],
+      'steps': steps,
+      'repeats': repeats,
+      'throughput': summarize([steps / run['wall'] for run in runs]),
+      'nativeThroughput': summarize([steps / run['native'] for run in runs]),
+      'overheadMicrosPerStep': summarize(
+          [(run['wall'] - run['native']) / steps * 1e6 for run in runs]),
+      'overheadFraction': summarize(
+          [(run['wall'] - run['native']) / run['wall'] for run in runs]),
+      'nativeMicrosPerStep': {name: summarize(values)
+                              for name, values in breakdown.items()},
+  }
+
+
+def printResult(result: Dict):
+  throughput = result['throughput']
+  native = result['nativeThroughput']
+  overhead = result['overheadMicrosPerStep']
+  print('%s/%s: %.1f +- %.1f %s (native %.1f +- %.1f), '
+        'binding overhead %.1f +- %.1f us/step (%.1f%%)' % (
+            result['scene'], result['workload'],
+            throughput['mean'], throughput['stdev'], result['unit'],
+            native['mean'], native['stdev'],
+            overhead['mean'], overhead['stdev'],
+            result['overheadFraction']['mean'] * 100))
+  for name, micros in sorted(result['nativeMicrosPerStep'].items()):
+    print('    %s: %.1f +- %.1f us/step' % (
+        name, micros['mean'], micros['stdev']))
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description='Benchmark Nimble from Python, separating binding overhead '
+      'from native time')
+  parser.add_argument('--scenes', nargs='+', choices=sorted(SCENES.keys()),
+                      default=sorted(SCENES.keys()))
+  parser.add_argument('--workloads', nargs='+',
+                      choices=sorted(WORKLOADS.keys()),
+                      default=['step', 'forwardPass', 'backprop'])
+  parser.add_argument('--steps', type=int, default=100,
+                      help='timesteps per repeat')
+  parser.add_argument('--repeats', type=int, default=5)
+  parser.add_argument('--warmup', type=int, default=1,
+                      help='untimed repeats to run first')
+  parser.add_argument('--json', type=str, default=None,
+                      help='also write the results to this file')
+  args = parser.parse_args()
+
+  ticksPerSecond = dart.performance.PerformanceLog.getClockTicksPerSecond()
+  results = []
+  for scene in args.scenes:
+    for workloadName in args.workloads:
+      result = runBenchmark(scene, workloadName, args.steps, args.repeats,
+                            args.warmup, ticksPerSecond)
+      printResult(result)
+      results.append(result)
+
+  if args.json is not None:
+    with open(args.json, 'w') as f:
+      json.dump({'clockTicksPerSecond': ticksPerSecond,
+                 'results': results}, f, indent=2)
+
+
+if __name__ == "__main__":
+  main()
@@ -2,7 +2,8 @@ import numpy as np
 import nimblephysics as dart
 
 
-def main():
+def createWorld() -> dart.simulation.World:
+  """This builds the 2D jump worm, pressed into the floor"""
   world = dart.simulation.World()
   world.setGravity([0, -9.81, 0])
 
@@ -79,6 +80,11 @@ def main():
   # Do a benchmark
 
   jumpworm.setPosition(1, -0.14)
+  return world
+
+
+def main():
+  world = createWorld()
   world.step()
 
   snapshot: dart.neural.BackpropSnapshot = dart.neural.forwardPass(world)
@@ -0,0 +1,461 @@
+// This file was generated by dart::dynamics::CompiledSkeletonDynamics::generateSource() for the
+// Skeleton "compiled_dynamics_test". Don't edit it by hand, regenerate it instead.
+
+#include "dart/dynamics/detail/CompiledSkeletonKernels.hpp"
+
+namespace {
+
+using namespace dart::dynamics::compiled;
+using dart::dynamics::Skeleton;
+
+class CompiledSkeletonTestDynamics final : public dart::dynamics::CompiledSkeletonDynamics
+{
+public:
+  std::string getSignature() const override
+  {
+    return "v1;-1,FreeJoint,6,6,0;0,RevoluteJoint,1,1,6;1,BallJoint,5,3,7;0,WeldJoint,0,0,0";
+  }
+
+  void computeMassMatrix(
+      const Skeleton* skel, Eigen::MatrixXs& M) const override
+  {
+    Bodies b;
+    load(skel, b, false, nullptr);
+    M.setZero();
+
+    // The inertia of each body and everything below it
+    Eigen::Matrix6s I0 = *b.b0.G;
+    Eigen::Matrix6s I1 = *b.b1.G;
+    Eigen::Matrix6s I2 = *b.b2.G;
+    Eigen::Matrix6s I3 = *b.b3.G;
+    I0 += moveInertiaToParent(b.b3, I3);
+    I1 += moveInertiaToParent(b.b2, I2);
+    I0 += moveInertiaToParent(b.b1, I1);
+
+    {
+      Eigen::Matrix<s_t, 6, 6> F = I0 * b.b0.S;
+      M.block<6, 6>(0, 0).noalias() = b.b0.S.transpose() * F;
+    }
+    {
+      Eigen::Matrix<s_t, 6, 1> F = I1 * b.b1.S;
+      M.block<1, 1>(6, 6).noalias() = b.b1.S.transpose() * F;
+      moveForcesToParent(b.b1, F);
+      M.block<6, 1>(0, 6).noalias() = b.b0.S.transpose() * F;
+    }
+    {
+      Eigen::Matrix<s_t, 6, 3> F = I2 * b.b2.S;
+      M.block<3, 3>(7, 7).noalias() = b.b2.S.transpose() * F;
+      moveForcesToParent(b.b2, F);
+      M.block<1, 3>(6, 7).noalias() = b.b1.S.transpose() * F;
+      moveForcesToParent(b.b1, F);
+      M.block<6, 3>(0, 7).noalias() = b.b0.S.transpose() * F;
+    }
+    M.triangularView<Eigen::StrictlyLower>() = M.transpose();
+  }
+
+  void computeCoriolisAndGravityForces(
+      const Skeleton* skel, Eigen::VectorXs& Cg) const override
+  {
+    Bodies b;
+    load(skel, b, true, nullptr);
+    rnea(b, skel->getGravity(), Cg);
+  }
+
+  void computeInverseDynamics(
+      const Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      Eigen::VectorXs& tau) const override
+  {
+    Bodies b;
+    load(skel, b, true, &ddq);
+    rnea(b, skel->getGravity(), tau);
+  }
+
+  void computeJacobianOfID(
+      const Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      bool withBiasForces,
+      bool wrtVelocity,
+      Eigen::MatrixXs& J) const override
+  {
+    J.setZero();
+    // M * ddq doesn't depend on the velocities
+    if (wrtVelocity && !withBiasForces)
+      return;
+    Bodies b;
+    load(skel, b, withBiasForces, &ddq);
+    Eigen::VectorXs tau(J.rows());
+    rnea(
+        b,
+        withBiasForces ? skel->getGravity() : Eigen::Vector3s::Zero().eval(),
+        tau);
+    if (wrtVelocity)
+      tangentsWrtVelocities(b, J);
+    else
+      tangentsWrtPositions(b, J);
+  }
+
+private:
+  struct Bodies
+  {
+    // BodyNode (Joint), a FreeJoint
+    Body<6> b0;
+    // BodyNode(1) (Joint(1)), a RevoluteJoint
+    Body<1> b1;
+    // BodyNode(2) (Joint(2)), a BallJoint
+    Body<3> b2;
+    // BodyNode(3) (Joint(3)), a WeldJoint
+    Body<0> b3;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  static void load(
+      const Skeleton* skel,
+      Bodies& b,
+      bool withVelocity,
+      const Eigen::VectorXs* ddq)
+  {
+    loadBody<dart::math::SE3Space>(
+        skel, 0, 0, withVelocity, ddq, b.b0);
+    loadBody<dart::math::R1Space>(
+        skel, 1, 6, withVelocity, ddq, b.b1);
+    loadBody<dart::math::SO3Space>(
+        skel, 2, 7, withVelocity, ddq, b.b2);
+    loadWeldBody(skel, 3, b.b3);
+  }
+
+  static void rnea(
+      Bodies& b, const Eigen::Vector3s& gravity, Eigen::VectorXs& tau)
+  {
+    forwardRoot(b.b0, gravity);
+    forward(b.b1, b.b0);
+    forward(b.b2, b.b1);
+    forward(b.b3, b.b0);
+    backward(b.b3, b.b0);
+    project(b.b2, 7, tau);
+    backward(b.b2, b.b1);
+    project(b.b1, 6, tau);
+    backward(b.b1, b.b0);
+    project(b.b0, 0, tau);
+  }
+
+  static void tangentsWrtPositions(Bodies& b, Eigen::MatrixXs& J)
+  {
+    // Position 0: BodyNode (Joint), DOF 0
+    tangentStart(b.b0);
+    tangentOwnPosition(b.b0, 0, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 0);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 0);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, true, J, 0);
+
+    // Position 1: BodyNode (Joint), DOF 1
+    tangentStart(b.b0);
+    tangentOwnPosition(b.b0, 1, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 1);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 1);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, true, J, 1);
+
+    // Position 2: BodyNode (Joint), DOF 2
+    tangentStart(b.b0);
+    tangentOwnPosition(b.b0, 2, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 2);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 2);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, true, J, 2);
+
+    // Position 3: BodyNode (Joint), DOF 3
+    tangentStart(b.b0);
+    tangentOwnPosition(b.b0, 3, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 3);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 3);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, true, J, 3);
+
+    // Position 4: BodyNode (Joint), DOF 4
+    tangentStart(b.b0);
+    tangentOwnPosition(b.b0, 4, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 4);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 4);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, true, J, 4);
+
+    // Position 5: BodyNode (Joint), DOF 5
+    tangentStart(b.b0);
+    tangentOwnPosition(b.b0, 5, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 5);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 5);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, true, J, 5);
+
+    // Position 6: BodyNode(1) (Joint(1)), DOF 0
+    b.b0.tF.setZero();
+    tangentStart(b.b1);
+    tangentOwnPosition(b.b1, 0, true);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, false, J, 6);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 6);
+    tangentBackward(b.b1, b.b0, 0);
+    tangentProject(b.b0, 0, false, J, 6);
+
+    // Position 7: BodyNode(2) (Joint(2)), DOF 0
+    b.b1.tF.setZero();
+    b.b0.tF.setZero();
+    tangentStart(b.b2);
+    tangentOwnPosition(b.b2, 0, false);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, true, J, 7);
+    tangentBackward(b.b2, b.b1, 0);
+    tangentProject(b.b1, 6, false, J, 7);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 7);
+
+    // Position 8: BodyNode(2) (Joint(2)), DOF 1
+    b.b1.tF.setZero();
+    b.b0.tF.setZero();
+    tangentStart(b.b2);
+    tangentOwnPosition(b.b2, 1, false);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, true, J, 8);
+    tangentBackward(b.b2, b.b1, 1);
+    tangentProject(b.b1, 6, false, J, 8);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 8);
+
+    // Position 9: BodyNode(2) (Joint(2)), DOF 2
+    b.b1.tF.setZero();
+    b.b0.tF.setZero();
+    tangentStart(b.b2);
+    tangentOwnPosition(b.b2, 2, false);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, true, J, 9);
+    tangentBackward(b.b2, b.b1, 2);
+    tangentProject(b.b1, 6, false, J, 9);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 9);
+  }
+
+  static void tangentsWrtVelocities(Bodies& b, Eigen::MatrixXs& J)
+  {
+    // Velocity 0: BodyNode (Joint), DOF 0
+    tangentStart(b.b0);
+    tangentOwnVelocity(b.b0, 0, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 0);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 0);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 0);
+
+    // Velocity 1: BodyNode (Joint), DOF 1
+    tangentStart(b.b0);
+    tangentOwnVelocity(b.b0, 1, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 1);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 1);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 1);
+
+    // Velocity 2: BodyNode (Joint), DOF 2
+    tangentStart(b.b0);
+    tangentOwnVelocity(b.b0, 2, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 2);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 2);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 2);
+
+    // Velocity 3: BodyNode (Joint), DOF 3
+    tangentStart(b.b0);
+    tangentOwnVelocity(b.b0, 3, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 3);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 3);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 3);
+
+    // Velocity 4: BodyNode (Joint), DOF 4
+    tangentStart(b.b0);
+    tangentOwnVelocity(b.b0, 4, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 4);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 4);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 4);
+
+    // Velocity 5: BodyNode (Joint), DOF 5
+    tangentStart(b.b0);
+    tangentOwnVelocity(b.b0, 5, false);
+    finishTangent(b.b0);
+    tangentForward(b.b1, b.b0);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentForward(b.b3, b.b0);
+    finishTangent(b.b3);
+    tangentBackward(b.b3, b.b0, -1);
+    tangentProject(b.b2, 7, false, J, 5);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 5);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 5);
+
+    // Velocity 6: BodyNode(1) (Joint(1)), DOF 0
+    b.b0.tF.setZero();
+    tangentStart(b.b1);
+    tangentOwnVelocity(b.b1, 0, true);
+    finishTangent(b.b1);
+    tangentForward(b.b2, b.b1);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, false, J, 6);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 6);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 6);
+
+    // Velocity 7: BodyNode(2) (Joint(2)), DOF 0
+    b.b1.tF.setZero();
+    b.b0.tF.setZero();
+    tangentStart(b.b2);
+    tangentOwnVelocity(b.b2, 0, false);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, false, J, 7);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 7);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 7);
+
+    // Velocity 8: BodyNode(2) (Joint(2)), DOF 1
+    b.b1.tF.setZero();
+    b.b0.tF.setZero();
+    tangentStart(b.b2);
+    tangentOwnVelocity(b.b2, 1, false);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, false, J, 8);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 8);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 8);
+
+    // Velocity 9: BodyNode(2) (Joint(2)), DOF 2
+    b.b1.tF.setZero();
+    b.b0.tF.setZero();
+    tangentStart(b.b2);
+    tangentOwnVelocity(b.b2, 2, false);
+    finishTangent(b.b2);
+    tangentProject(b.b2, 7, false, J, 9);
+    tangentBackward(b.b2, b.b1, -1);
+    tangentProject(b.b1, 6, false, J, 9);
+    tangentBackward(b.b1, b.b0, -1);
+    tangentProject(b.b0, 0, false, J, 9);
+  }
+};
+
+struct CompiledSkeletonTestDynamicsRegistrar
+{
+  CompiledSkeletonTestDynamicsRegistrar()
+  {
+    dart::dynamics::CompiledSkeletonDynamics::registerDynamics(
+        std::make_shared<CompiledSkeletonTestDynamics>());
+  }
+} registerCompiledSkeletonTestDynamics;
+
+} // namespace
@@ -2263,9 +2263,33 @@ bool verifyForceVelJacobian(WorldPtr world, VectorXs proposedVelocities)
               << std::endl;
   }
 
+  // Computing a subset of the columns first, before the whole Jacobian is
+  // cached, should give exactly the same columns
+  std::vector<int> someDofs;
+  for (int i = world->getNumDofs() - 1; i >= 0; i -= 2)
+  {
+    someDofs.push_back(i);
+  }
+  MatrixXs someCols
+      = classicPtr->getControlForceVelJacobianCols(world, someDofs);
+
   MatrixXs analytical = classicPtr->getControlForceVelJacobian(world);
   MatrixXs bruteForce = classicPtr->finiteDifferenceForceVelJacobian(world);
 
+  for (int i = 0; i < someDofs.size(); i++)
+  {
+    if (!equals(
+            MatrixXs(someCols.col(i)),
+            MatrixXs(analytical.col(someDofs[i])),
+            1e-10))
+    {
+      std::cout << "getControlForceVelJacobianCols() disagrees with "
+                   "getControlForceVelJacobian() on column "
+                << someDofs[i] << std::endl;
+      return false;
+    }
+  }
+
   // Atlas runs at 1.5e-8 error
   if (!equals(analytical, bruteForce, 1e-8))
   {
@@ -3053,6 +3077,162 @@ bool verifyAnalyticalBackprop(WorldPtr world)
   return true;
 }
 
+bool verifyAnalyticalJvp(WorldPtr world)
+{
+  neural::BackpropSnapshotPtr classicPtr = neural::forwardPass(world, true);
+
+  if (!classicPtr)
+  {
+    std::cout << "verifyAnalyticalJvp forwardPass returned a null "
+                 "BackpropSnapshotPtr!"
+              << std::endl;
+    return false;
+  }
+
+  RestorableSnapshot snapshot(world);
+  world->setPositions(classicPtr->getPreStepPosition());
+  world->setVelocities(classicPtr->getPreStepVelocity());
+
+  Eigen::MatrixXs stateJac = classicPtr->getStateJacobian(world);
+  Eigen::MatrixXs actionJac = classicPtr->getActionJacobian(world);
+
+  for (int trial = 0; trial < 3; trial++)
+  {
+    VectorXs dState = VectorXs::Random(world->getNumDofs() * 2);
+    VectorXs dAction = VectorXs::Random(world->getActionSize());
+    // Exercise the branch that skips the position Jacobians
+    if (trial == 0)
+    {
+      dState.head(world->getNumDofs()).setZero();
+    }
+
+    VectorXs jvp = classicPtr->jvpState(world, dState, dAction);
+    VectorXs bruteForce = stateJac * dState + actionJac * dAction;
+
+    if (!equals(jvp, bruteForce, 1e-8))
+    {
+      std::cout << "Got a bad JVP on trial " << trial << "!" << std::endl;
+      std::cout << "Analytical:" << std::endl << jvp << std::endl;
+      std::cout << "Brute force:" << std::endl << bruteForce << std::endl;
+      std::cout << "Diff:" << std::endl << jvp - bruteForce << std::endl;
+      snapshot.restore();
+      return false;
+    }
+  }
+
+  snapshot.restore();
+  return true;
+}
+
+bool verifyBackpropBatch(WorldPtr world)
+{
+  RestorableSnapshot snapshot(world);
+  neural::BackpropSnapshotPtr classicPtr = neural::forwardPass(world, true);
+  int dofs = world->getNumDofs();
+  Eigen::MatrixXs nextPos = Eigen::MatrixXs::Random(dofs, 3);
+  Eigen::MatrixXs nextVel = Eigen::MatrixXs::Random(dofs, 3);
+
+  Eigen::MatrixXs lossWrtPos;
+  Eigen::MatrixXs lossWrtVel;
+  Eigen::MatrixXs lossWrtTorque;
+  Eigen::MatrixXs lossWrtMass;
+  classicPtr->backpropBatch(
+      world,
+      nextPos,
+      nextVel,
+      lossWrtPos,
+      lossWrtVel,
+      lossWrtTorque,
+      lossWrtMass);
+
+  for (int i = 0; i < 3; i++)
+  {
+    LossGradient nextTimestepLoss;
+    nextTimestepLoss.lossWrtPosition = nextPos.col(i);
+    nextTimestepLoss.lossWrtVelocity = nextVel.col(i);
+    LossGradient thisTimestepLoss;
+    classicPtr->backprop(world, thisTimestepLoss, nextTimestepLoss);
+
+    Eigen::VectorXs pos = lossWrtPos.col(i);
+    Eigen::VectorXs vel = lossWrtVel.col(i);
+    Eigen::VectorXs torque = lossWrtTorque.col(i);
+    Eigen::VectorXs mass = lossWrtMass.col(i);
+    if (!equals(pos, thisTimestepLoss.lossWrtPosition, 1e-10)
+        || !equals(vel, thisTimestepLoss.lossWrtVelocity, 1e-10)
+        || !equals(torque, thisTimestepLoss.lossWrtTorque, 1e-10)
+        || !equals(mass, thisTimestepLoss.lossWrtMass, 1e-10))
+    {
+      std::cout << "backpropBatch() column " << i
+                << " doesn't match backprop()!" << std::endl;
+      snapshot.restore();
+      return false;
+    }
+  }
+  snapshot.restore();
+  return true;
+}
+
+bool verifyJacobianCacheBudget(WorldPtr world)
+{
+  RestorableSnapshot snapshot(world);
+  neural::BackpropSnapshotPtr first = neural::forwardPass(world, true);
+  snapshot.restore();
+  neural::BackpropSnapshotPtr second = neural::forwardPass(world, true);
+  snapshot.restore();
+  world->setPositions(first->getPreStepPosition());
+  world->setVelocities(first->getPreStepVelocity());
+
+  Eigen::MatrixXs velVel = first->getVelVelJacobian(world);
+  Eigen::MatrixXs posPos = first->getPosPosJacobian(world);
+  std::size_t bytes = first->getCachedJacobianBytes();
+  if (bytes == 0)
+  {
+    // Nothing to cache, so nothing to evict
+    snapshot.restore();
+    return true;
+  }
+
+  // Leave room for exactly one snapshot's caches
+  std::shared_ptr<neural::JacobianCacheBudget> budget
+      = std::make_shared<neural::JacobianCacheBudget>(bytes);
+  first->setJacobianCacheBudget(budget);
+  second->setJacobianCacheBudget(budget);
+  second->getVelVelJacobian(world);
+  second->getPosPosJacobian(world);
+  if (first->getCachedJacobianBytes() != 0 || budget->getUsedBytes() > bytes)
+  {
+    std::cout << "JacobianCacheBudget didn't evict the least recently used "
+                 "snapshot!"
+              << std::endl;
+    snapshot.restore();
+    return false;
+  }
+
+  // The evicted Jacobians should come back exactly as they were
+  if (!equals(first->getVelVelJacobian(world), velVel, 0)
+      || !equals(first->getPosPosJacobian(world), posPos, 0))
+  {
+    std::cout << "Recomputed Jacobians don't match the originals after "
+                 "eviction!"
+              << std::endl;
+    snapshot.restore();
+    return false;
+  }
+
+  first->releaseCachedJacobians();
+  if (first->getCachedJacobianBytes() != 0
+      || budget->getUsedBytes() != second->getCachedJacobianBytes())
+  {
+    std::cout << "releaseCachedJacobians() didn't free the caches!"
+              << std::endl;
+    snapshot.restore();
+    return false;
+  }
+
+  snapshot.restore();
+  return true;
+}
+
 LossGradient computeBruteForceGradient(
     WorldPtr world, std::size_t timesteps, std::function<s_t(WorldPtr)> loss)
 {
@@ -4075,10 +4255,31 @@ bool verifyRandomIKMapping(WorldPtr world)
          && verifyMapping(world, mapping);
 }
 
+bool verifyWarmStartIKMapping(WorldPtr world)
+{
+  std::shared_ptr<IKMapping> mapping = std::make_shared<IKMapping>(world);
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    for (dynamics::BodyNode* node : world->getSkeleton(i)->getBodyNodes())
+      mapping->addLinearBodyNode(node);
+  }
+  mapping->setIKIterationLimit(-1);
+  mapping->setWarmStartEnabled(true);
+  // The pos Jacobian after an IK solve comes out of the cache, so this also
+  // checks that against finite differencing
+  return verifyMappingSetGet(world, mapping, MappingTestComponent::POSITION)
+         && verifyMappingIntoJacobian(
+             world,
+             mapping,
+             MappingTestComponent::POSITION,
+             MappingTestComponent::POSITION);
+}
+
 bool verifyIKMapping(WorldPtr world)
 {
   return verifyLinearIKMapping(world) && verifyAngularIKMapping(world)
-         && verifySpatialIKMapping(world) && verifyRandomIKMapping(world);
+         && verifySpatialIKMapping(world) && verifyRandomIKMapping(world)
+         && verifyWarmStartIKMapping(world);
 }
 
 bool verifyIdentityMapping(WorldPtr world)
@@ -4676,6 +4877,70 @@ bool verifySkeletonMarkerJacobians(
     return false;
   }
 
+  Eigen::VectorXs goal = skel->getMarkerWorldPositions(markers)
+                         + Eigen::VectorXs::Random(markers.size() * 3);
+
+  Eigen::VectorXs jointDirection = Eigen::VectorXs::Random(skel->getNumDofs());
+  Eigen::VectorXs jointHvp
+      = skel->getMarkerWorldPositionDiffToGoalHessianVectorProductWrtJointPos(
+          markers, goal, jointDirection);
+  Eigen::VectorXs jointHvp_fd
+      = skel->finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtJointPos(
+          markers, goal, jointDirection);
+  if (!equals(jointHvp, jointHvp_fd, THRESHOLD))
+  {
+    std::cout << "Error on Hessian-vector product wrt joint positions"
+              << std::endl
+              << "Analytical:" << std::endl
+              << jointHvp << std::endl
+              << "FD:" << std::endl
+              << jointHvp_fd << std::endl
+              << "Diff:" << std::endl
+              << jointHvp - jointHvp_fd << std::endl;
+    return false;
+  }
+
+  Eigen::VectorXs scaleDirection
+      = Eigen::VectorXs::Random(skel->getNumBodyNodes() * 3);
+  Eigen::VectorXs scaleHvp
+      = skel->getMarkerWorldPositionDiffToGoalHessianVectorProductWrtBodyScales(
+          markers, scaleDirection);
+  Eigen::VectorXs scaleHvp_fd
+      = skel->finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtBodyScales(
+          markers, goal, scaleDirection);
+  if (!equals(scaleHvp, scaleHvp_fd, THRESHOLD))
+  {
+    std::cout << "Error on Hessian-vector product wrt body scales"
+              << std::endl
+              << "Analytical:" << std::endl
+              << scaleHvp << std::endl
+              << "FD:" << std::endl
+              << scaleHvp_fd << std::endl
+              << "Diff:" << std::endl
+              << scaleHvp - scaleHvp_fd << std::endl;
+    return false;
+  }
+
+  Eigen::VectorXs markerDirection = Eigen::VectorXs::Random(markers.size() * 3);
+  Eigen::VectorXs markerHvp
+      = skel->getMarkerWorldPositionDiffToGoalHessianVectorProductWrtMarkerOffsets(
+          markers, markerDirection);
+  Eigen::VectorXs markerHvp_fd
+      = skel->finiteDifferenceMarkerWorldPositionDiffToGoalHessianVectorProductWrtMarkerOffsets(
+          markers, goal, markerDirection);
+  if (!equals(markerHvp, markerHvp_fd, THRESHOLD))
+  {
+    std::cout << "Error on Hessian-vector product wrt marker offsets"
+              << std::endl
+              << "Analytical:" << std::endl
+              << markerHvp << std::endl
+              << "FD:" << std::endl
+              << markerHvp_fd << std::endl
+              << "Diff:" << std::endl
+              << markerHvp - markerHvp_fd << std::endl;
+    return false;
+  }
+
   return true;
 }
 
@@ -6357,6 +6622,29 @@ bool verifyAnalyticalA_cJacobian(WorldPtr world)
       return false;
     }
 
+    // Check that the sparse products agree with the dense Jacobian
+    Eigen::VectorXs v = Eigen::VectorXs::Random(world->getNumDofs());
+    Eigen::VectorXs sparseTransposeProduct
+        = constraints[i]->multiplyConstraintForcesJacobianTranspose(world, v);
+    if (!equals(sparseTransposeProduct, analytical.transpose() * v, 1e-12))
+    {
+      std::cout << "Sparse constraint forces Jac^T * v doesn't match dense"
+                << std::endl;
+      return false;
+    }
+    Eigen::MatrixXs sparseSum
+        = Eigen::MatrixXs::Ones(world->getNumDofs(), world->getNumDofs());
+    constraints[i]->addScaledConstraintForcesJacobian(world, 2.0, sparseSum);
+    Eigen::MatrixXs denseSum
+        = Eigen::MatrixXs::Ones(world->getNumDofs(), world->getNumDofs())
+          + 2.0 * analytical;
+    if (!equals(sparseSum, denseSum, 1e-12))
+    {
+      std::cout << "Sparse scaled constraint forces Jac doesn't match dense"
+                << std::endl;
+      return false;
+    }
+
     // Check that the skeleton-by-skeleton computation works
 
     int col = 0;
@@ -6953,6 +7241,44 @@ bool verifyJacobiansWrt(WorldPtr world, WithRespectTo* wrt)
          && verifyPosJacobianWrt(world, wrt);
 }
 
+bool verifyInertiaIDJacobians(WorldPtr world, WithRespectTo* wrt)
+{
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    auto skel = world->getSkeleton(i);
+    if (wrt->dim(skel.get()) == 0)
+      continue;
+
+    Eigen::VectorXs x = Eigen::VectorXs::Random(skel->getNumDofs());
+    Eigen::MatrixXs analyticalM = skel->getJacobianOfM(x, wrt);
+    Eigen::MatrixXs bruteForceM = skel->finiteDifferenceJacobianOfM(x, wrt);
+    if (!equals(analyticalM, bruteForceM, 1e-7))
+    {
+      std::cout << "Error on skeleton " << skel->getName()
+                << " with the inertia Jacobian of M*x" << std::endl;
+      std::cout << "Analytical: " << std::endl << analyticalM << std::endl;
+      std::cout << "Brute force: " << std::endl << bruteForceM << std::endl;
+      std::cout << "Diff: " << std::endl
+                << (analyticalM - bruteForceM) << std::endl;
+      return false;
+    }
+
+    Eigen::MatrixXs analyticalC = skel->getJacobianOfC(wrt);
+    Eigen::MatrixXs bruteForceC = skel->finiteDifferenceJacobianOfC(wrt);
+    if (!equals(analyticalC, bruteForceC, 1e-7))
+    {
+      std::cout << "Error on skeleton " << skel->getName()
+                << " with the inertia Jacobian of C" << std::endl;
+      std::cout << "Analytical: " << std::endl << analyticalC << std::endl;
+      std::cout << "Brute force: " << std::endl << bruteForceC << std::endl;
+      std::cout << "Diff: " << std::endl
+                << (analyticalC - bruteForceC) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
 bool verifyWrtMass(WorldPtr world)
 {
   WithRespectToMass massMapping = WithRespectToMass();
@@ -6971,6 +7297,31 @@ bool verifyWrtMass(WorldPtr world)
     }
   }
 
+  if (!verifyInertiaIDJacobians(world, &massMapping))
+  {
+    return false;
+  }
+
+  WithRespectToMass fullInertiaMapping = WithRespectToMass();
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    auto skel = world->getSkeleton(i);
+    if (skel->isMobile() && skel->getNumDofs() > 0)
+    {
+      for (int j = 0; j < skel->getNumBodyNodes(); j++)
+      {
+        Eigen::VectorXs lowerBound = Eigen::VectorXs::Ones(10) * -1000;
+        Eigen::VectorXs upperBound = Eigen::VectorXs::Ones(10) * 1000;
+        fullInertiaMapping.registerNode(
+            skel->getBodyNode(j), INERTIA_FULL, upperBound, lowerBound);
+      }
+    }
+  }
+  if (!verifyInertiaIDJacobians(world, &fullInertiaMapping))
+  {
+    return false;
+  }
+
   // return verifyScratch(world, &massMapping);
   // TODO: re-enable me later
   return true;
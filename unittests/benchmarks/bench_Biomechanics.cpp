@@ -0,0 +1,163 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <benchmark/benchmark.h>
+
+#include "dart/biomechanics/C3DLoader.hpp"
+#include "dart/biomechanics/MarkerFitter.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/dynamics/MeshCache.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+namespace {
+
+const std::string kGaitC3D = "dart://sample/c3d/JA1Gait35.c3d";
+const std::string kKneeOsim
+    = "dart://sample/osim/ComplexKnee/gait2392_frontHingeKnee_dem.osim";
+const std::string kKneeC3D = "dart://sample/osim/ComplexKnee/2022_01_0403.c3d";
+
+/// This loads the ComplexKnee model and the first `numFrames` of its trial,
+/// ready to hand to a MarkerFitter
+struct KneeTrial
+{
+  KneeTrial(int numFrames)
+  {
+    model = OpenSimParser::parseOsim(kKneeOsim);
+    model.skeleton->autogroupSymmetricSuffixes();
+    model.skeleton->zeroTranslationInCustomFunctions();
+    c3d = C3DLoader::loadC3D(kKneeC3D, 0, numFrames);
+    C3DLoader::fixupMarkerFlips(&c3d);
+    newClip = std::vector<bool>(c3d.markerTimesteps.size(), false);
+  }
+
+  /// This makes a fitter with a small iteration budget, so the benchmarks
+  /// measure the cost of each stage rather than how long it takes to converge
+  std::shared_ptr<MarkerFitter> createFitter()
+  {
+    std::shared_ptr<MarkerFitter> fitter = std::make_shared<MarkerFitter>(
+        model.skeleton, model.markersMap);
+    fitter->setInitialIKSatisfactoryLoss(0.005);
+    fitter->setInitialIKMaxRestarts(10);
+    fitter->setIterationLimit(20);
+    fitter->setTrackingMarkers(model.trackingMarkers);
+    return fitter;
+  }
+
+  OpenSimFile model;
+  C3D c3d;
+  std::vector<bool> newClip;
+};
+
+} // namespace
+
+//==============================================================================
+static void BM_C3DLoader_LoadC3D(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    C3D c3d = C3DLoader::loadC3D(kGaitC3D);
+    benchmark::DoNotOptimize(c3d.markerTimesteps.data());
+  }
+}
+BENCHMARK(BM_C3DLoader_LoadC3D)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+static void BM_C3DLoader_FixupMarkerFlips(benchmark::State& state)
+{
+  C3D original = C3DLoader::loadC3D(kGaitC3D);
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    C3D c3d = original;
+    state.ResumeTiming();
+    C3DLoader::fixupMarkerFlips(&c3d);
+  }
+}
+BENCHMARK(BM_C3DLoader_FixupMarkerFlips)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+/// Arg 0 parses with the global MeshCache disabled (every mesh goes through
+/// Assimp), Arg 1 parses with it enabled and already warm
+static void BM_OpenSimParser_ParseOsim(benchmark::State& state)
+{
+  dynamics::MeshCache& cache = dynamics::MeshCache::getGlobal();
+  bool wasEnabled = cache.isEnabled();
+  cache.setEnabled(state.range(0) != 0);
+  OpenSimParser::parseOsim(kKneeOsim);
+  for (auto _ : state)
+  {
+    OpenSimFile file = OpenSimParser::parseOsim(kKneeOsim);
+    benchmark::DoNotOptimize(file.skeleton.get());
+  }
+  cache.setEnabled(wasEnabled);
+}
+BENCHMARK(BM_OpenSimParser_ParseOsim)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+/// The first stage of the kinematics pipeline: multithreaded IK with joint
+/// center and body scale estimation
+static void BM_MarkerFitter_GetInitialization(benchmark::State& state)
+{
+  KneeTrial trial(state.range(0));
+  std::shared_ptr<MarkerFitter> fitter = trial.createFitter();
+  for (auto _ : state)
+  {
+    MarkerInitialization init = fitter->getInitialization(
+        trial.c3d.markerTimesteps, trial.newClip, InitialMarkerFitParams());
+    benchmark::DoNotOptimize(init.poses.data());
+  }
+}
+BENCHMARK(BM_MarkerFitter_GetInitialization)
+    ->Arg(50)
+    ->Arg(200)
+    ->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+/// Just the joint center and axis finding stage of the pipeline
+static void BM_MarkerFitter_RunJointsPipeline(benchmark::State& state)
+{
+  KneeTrial trial(state.range(0));
+  std::shared_ptr<MarkerFitter> fitter = trial.createFitter();
+  for (auto _ : state)
+  {
+    MarkerInitialization init = fitter->runJointsPipeline(
+        trial.c3d.markerTimesteps, InitialMarkerFitParams());
+    benchmark::DoNotOptimize(init.poses.data());
+  }
+}
+BENCHMARK(BM_MarkerFitter_RunJointsPipeline)
+    ->Arg(50)
+    ->Arg(200)
+    ->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+/// The whole kinematics pipeline, including the bilevel scaling optimization
+/// (capped at a small iteration limit) and the final IK pass
+static void BM_MarkerFitter_RunKinematicsPipeline(benchmark::State& state)
+{
+  KneeTrial trial(state.range(0));
+  std::shared_ptr<MarkerFitter> fitter = trial.createFitter();
+  for (auto _ : state)
+  {
+    MarkerInitialization init = fitter->runKinematicsPipeline(
+        trial.c3d.markerTimesteps,
+        trial.newClip,
+        InitialMarkerFitParams(),
+        20);
+    benchmark::DoNotOptimize(init.poses.data());
+  }
+}
+BENCHMARK(BM_MarkerFitter_RunKinematicsPipeline)
+    ->Arg(50)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(3);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,216 @@
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/DifferentiableContactConstraint.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/simulation/World.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+
+// Each of these lands a different shape on a box, so the contacts cover a
+// different mix of DofContactType cases
+enum ContactShape
+{
+  BOX_ON_BOX = 0,     // FACE / VERTEX / EDGE_A / EDGE_B
+  SPHERE_ON_BOX = 1,  // SPHERE_TO_BOX / BOX_TO_SPHERE
+  CAPSULE_ON_BOX = 2, // PIPE_TO_VERTEX / PIPE_TO_EDGE / VERTEX_TO_PIPE / ...
+};
+
+struct ContactScene
+{
+  WorldPtr world;
+  neural::BackpropSnapshotPtr snapshot;
+  std::vector<std::shared_ptr<neural::DifferentiableContactConstraint>>
+      constraints;
+};
+
+ContactScene createContactScene(int shapeType)
+{
+  ContactScene scene;
+  scene.world = World::create();
+  scene.world->setPenetrationCorrectionEnabled(false);
+
+  SkeletonPtr ground = Skeleton::create("ground");
+  auto groundPair = ground->createJointAndBodyNodePair<WeldJoint>();
+  groundPair.second
+      ->createShapeNodeWith<VisualAspect, CollisionAspect, DynamicsAspect>(
+          std::make_shared<BoxShape>(Eigen::Vector3s(10.0, 1.0, 10.0)));
+  scene.world->addSkeleton(ground);
+
+  SkeletonPtr body = Skeleton::create("body");
+  auto bodyPair = body->createJointAndBodyNodePair<FreeJoint>();
+  ShapePtr shape;
+  if (shapeType == SPHERE_ON_BOX)
+  {
+    shape = std::make_shared<SphereShape>(0.5);
+  }
+  else if (shapeType == CAPSULE_ON_BOX)
+  {
+    shape = std::make_shared<CapsuleShape>(0.25, 1.0);
+  }
+  else
+  {
+    shape = std::make_shared<BoxShape>(Eigen::Vector3s(0.5, 0.5, 0.5));
+  }
+  bodyPair.second
+      ->createShapeNodeWith<VisualAspect, CollisionAspect, DynamicsAspect>(
+          shape);
+  bodyPair.second->setFrictionCoeff(0.5);
+  scene.world->addSkeleton(body);
+
+  // Tilt the body a little so it lands on an edge or a vertex rather than
+  // perfectly flat, and push it slightly into the ground
+  Eigen::Vector6s pos = Eigen::Vector6s::Zero();
+  pos.head<3>() = Eigen::Vector3s(0.1, 0.2, 0.3);
+  if (shapeType == SPHERE_ON_BOX)
+  {
+    pos(4) = 0.999;
+  }
+  else if (shapeType == CAPSULE_ON_BOX)
+  {
+    pos(4) = 0.74;
+  }
+  else
+  {
+    pos(4) = 0.8;
+  }
+  body->setPositions(pos);
+  body->setVelocities(Eigen::Vector6s::Unit(4) * -0.1);
+
+  neural::RestorableSnapshot restore(scene.world);
+  scene.snapshot = neural::forwardPass(scene.world, true);
+  restore.restore();
+  scene.constraints = scene.snapshot->getClampingConstraints();
+  return scene;
+}
+
+static void BM_ContactForcesJacobian_Analytical(benchmark::State& state)
+{
+  ContactScene scene = createContactScene(state.range(0));
+  // This overload skips the per-constraint cache, so we're timing the real
+  // computation on every iteration
+  std::vector<SkeletonPtr> skels;
+  for (int i = 0; i < scene.world->getNumSkeletons(); i++)
+  {
+    skels.push_back(scene.world->getSkeleton(i));
+  }
+  while (state.KeepRunning())
+  {
+    for (auto& constraint : scene.constraints)
+    {
+      benchmark::DoNotOptimize(
+          constraint->getConstraintForcesJacobian(scene.world, skels));
+    }
+  }
+  state.counters["contacts"] = scene.constraints.size();
+}
+BENCHMARK(BM_ContactForcesJacobian_Analytical)
+    ->Arg(BOX_ON_BOX)
+    ->Arg(SPHERE_ON_BOX)
+    ->Arg(CAPSULE_ON_BOX);
+
+static void BM_ContactForcesJacobian_BruteForce(benchmark::State& state)
+{
+  ContactScene scene = createContactScene(state.range(0));
+  while (state.KeepRunning())
+  {
+    for (auto& constraint : scene.constraints)
+    {
+      benchmark::DoNotOptimize(
+          constraint->bruteForceConstraintForcesJacobian(scene.world));
+    }
+  }
+  state.counters["contacts"] = scene.constraints.size();
+}
+BENCHMARK(BM_ContactForcesJacobian_BruteForce)
+    ->Arg(BOX_ON_BOX)
+    ->Arg(SPHERE_ON_BOX)
+    ->Arg(CAPSULE_ON_BOX);
+
+static void BM_ContactForceJacobian_Analytical(benchmark::State& state)
+{
+  ContactScene scene = createContactScene(state.range(0));
+  while (state.KeepRunning())
+  {
+    for (auto& constraint : scene.constraints)
+    {
+      benchmark::DoNotOptimize(
+          constraint->getContactForceJacobian(scene.world));
+    }
+  }
+  state.counters["contacts"] = scene.constraints.size();
+}
+BENCHMARK(BM_ContactForceJacobian_Analytical)
+    ->Arg(BOX_ON_BOX)
+    ->Arg(SPHERE_ON_BOX)
+    ->Arg(CAPSULE_ON_BOX);
+
+static void BM_ContactForceJacobian_BruteForce(benchmark::State& state)
+{
+  ContactScene scene = createContactScene(state.range(0));
+  while (state.KeepRunning())
+  {
+    for (auto& constraint : scene.constraints)
+    {
+      benchmark::DoNotOptimize(
+          constraint->bruteForceContactForceJacobian(scene.world));
+    }
+  }
+  state.counters["contacts"] = scene.constraints.size();
+}
+BENCHMARK(BM_ContactForceJacobian_BruteForce)
+    ->Arg(BOX_ON_BOX)
+    ->Arg(SPHERE_ON_BOX)
+    ->Arg(CAPSULE_ON_BOX);
+
+static void BM_ContactPositionJacobian_Analytical(benchmark::State& state)
+{
+  ContactScene scene = createContactScene(state.range(0));
+  while (state.KeepRunning())
+  {
+    for (auto& constraint : scene.constraints)
+    {
+      benchmark::DoNotOptimize(
+          constraint->getContactPositionJacobian(scene.world));
+    }
+  }
+  state.counters["contacts"] = scene.constraints.size();
+}
+BENCHMARK(BM_ContactPositionJacobian_Analytical)
+    ->Arg(BOX_ON_BOX)
+    ->Arg(SPHERE_ON_BOX)
+    ->Arg(CAPSULE_ON_BOX);
+
+static void BM_ContactPositionJacobian_BruteForce(benchmark::State& state)
+{
+  ContactScene scene = createContactScene(state.range(0));
+  while (state.KeepRunning())
+  {
+    for (auto& constraint : scene.constraints)
+    {
+      benchmark::DoNotOptimize(
+          constraint->bruteForceContactPositionJacobian(scene.world));
+    }
+  }
+  state.counters["contacts"] = scene.constraints.size();
+}
+BENCHMARK(BM_ContactPositionJacobian_BruteForce)
+    ->Arg(BOX_ON_BOX)
+    ->Arg(SPHERE_ON_BOX)
+    ->Arg(CAPSULE_ON_BOX);
+
+BENCHMARK_MAIN();
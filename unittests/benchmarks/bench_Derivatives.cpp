@@ -387,4 +387,52 @@ static void BM_Jacobian_Of_Minv_q_Analytical_ID(benchmark::State& state)
 // Register the function as a benchmark
 BENCHMARK(BM_Jacobian_Of_Minv_q_Analytical_ID);
 
+static void BM_Dynamics_Jacobians_Separate(benchmark::State& state)
+{
+  common::Uri uri = "dart://sample/skel/test/tree_structure_root_free.skel";
+  WorldPtr world = utils::SkelParser::readWorld(uri);
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  dynamics::SkeletonPtr skel = world->getSkeleton(0);
+  const int dof = static_cast<int>(skel->getNumDofs());
+  skel->setPositions(Eigen::VectorXs::Random(dof));
+  skel->setVelocities(Eigen::VectorXs::Random(dof));
+  Eigen::VectorXs x = Eigen::VectorXs::Random(dof);
+
+  while (state.KeepRunning())
+  {
+    Eigen::MatrixXs dMddq_dq
+        = skel->getJacobianOfM(x, neural::WithRespectTo::POSITION);
+    Eigen::MatrixXs dC_dq
+        = skel->getJacobianOfC(neural::WithRespectTo::POSITION);
+    Eigen::MatrixXs dC_dv
+        = skel->getJacobianOfC(neural::WithRespectTo::VELOCITY);
+    benchmark::DoNotOptimize(dMddq_dq);
+    benchmark::DoNotOptimize(dC_dq);
+    benchmark::DoNotOptimize(dC_dv);
+  }
+}
+// Register the function as a benchmark
+BENCHMARK(BM_Dynamics_Jacobians_Separate);
+
+static void BM_Dynamics_Jacobians_Fused(benchmark::State& state)
+{
+  common::Uri uri = "dart://sample/skel/test/tree_structure_root_free.skel";
+  WorldPtr world = utils::SkelParser::readWorld(uri);
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  dynamics::SkeletonPtr skel = world->getSkeleton(0);
+  const int dof = static_cast<int>(skel->getNumDofs());
+  skel->setPositions(Eigen::VectorXs::Random(dof));
+  skel->setVelocities(Eigen::VectorXs::Random(dof));
+  Eigen::VectorXs x = Eigen::VectorXs::Random(dof);
+
+  dynamics::Skeleton::DynamicsJacobians jacobians;
+  while (state.KeepRunning())
+  {
+    skel->computeDynamicsJacobians(x, jacobians);
+    benchmark::DoNotOptimize(jacobians);
+  }
+}
+// Register the function as a benchmark
+BENCHMARK(BM_Dynamics_Jacobians_Fused);
+
 BENCHMARK_MAIN();
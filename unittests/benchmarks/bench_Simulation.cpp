@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include <Eigen/Dense>
+#include <benchmark/benchmark.h>
+
+#include "dart/collision/CollisionGroup.hpp"
+#include "dart/collision/CollisionOption.hpp"
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/LossFn.hpp"
+#include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+
+namespace {
+
+/// This makes a world with `numBoxes` free boxes sitting in a row on a fixed
+/// floor, each pressed slightly into it, so every box is in contact
+WorldPtr createBoxesWorld(int numBoxes)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  world->setPenetrationCorrectionEnabled(false);
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3s floorOffset = Eigen::Isometry3s::Identity();
+  floorOffset.translation() = Eigen::Vector3s(0, -0.25, 0);
+  floorPair.first->setTransformFromParentBodyNode(floorOffset);
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      std::make_shared<BoxShape>(
+          Eigen::Vector3s(0.3 * numBoxes + 1.0, 0.5, 1.0)));
+  world->addSkeleton(floor);
+
+  for (int i = 0; i < numBoxes; i++)
+  {
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<FreeJoint*, BodyNode*> boxPair
+        = box->createJointAndBodyNodePair<FreeJoint>(nullptr);
+    boxPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3s(0.1, 0.1, 0.1)));
+    world->addSkeleton(box);
+
+    Eigen::Vector6s pos = Eigen::Vector6s::Zero();
+    pos(3) = 0.3 * (i - 0.5 * (numBoxes - 1));
+    pos(4) = 0.05 - 1e-3;
+    box->setPositions(pos);
+  }
+
+  return world;
+}
+
+/// This makes a planar chain of `numLinks` revolute links, which is the kind
+/// of arm we run trajectory optimization on
+WorldPtr createChainWorld(int numLinks)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr chain = Skeleton::create("chain");
+  BodyNode* parent = nullptr;
+  for (int i = 0; i < numLinks; i++)
+  {
+    std::pair<RevoluteJoint*, BodyNode*> pair
+        = chain->createJointAndBodyNodePair<RevoluteJoint>(parent);
+    pair.first->setAxis(Eigen::Vector3s::UnitZ());
+    pair.first->setControlForceUpperLimit(0, 100.0);
+    pair.first->setControlForceLowerLimit(0, -100.0);
+    pair.first->setVelocityUpperLimit(0, 100.0);
+    pair.first->setVelocityLowerLimit(0, -100.0);
+    pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3s(0.05, 0.25, 0.05)));
+    Eigen::Isometry3s childOffset = Eigen::Isometry3s::Identity();
+    childOffset.translation() = Eigen::Vector3s(0, -0.125, 0);
+    pair.first->setTransformFromChildBodyNode(childOffset);
+    if (parent != nullptr)
+    {
+      Eigen::Isometry3s parentOffset = Eigen::Isometry3s::Identity();
+      parentOffset.translation() = Eigen::Vector3s(0, -0.125, 0);
+      pair.first->setTransformFromParentBodyNode(parentOffset);
+    }
+    pair.first->setPosition(0, 0.3);
+    parent = pair.second;
+  }
+  world->addSkeleton(chain);
+
+  return world;
+}
+
+} // namespace
+
+//==============================================================================
+static void BM_World_Step_Contacts(benchmark::State& state)
+{
+  WorldPtr world = createBoxesWorld(state.range(0));
+  Eigen::VectorXs startPos = world->getPositions();
+  Eigen::VectorXs startVel = world->getVelocities();
+  for (auto _ : state)
+  {
+    world->setPositions(startPos);
+    world->setVelocities(startVel);
+    world->step();
+  }
+}
+BENCHMARK(BM_World_Step_Contacts)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+//==============================================================================
+static void BM_ForwardPass_Backprop(benchmark::State& state)
+{
+  WorldPtr world = createBoxesWorld(state.range(0));
+  Eigen::VectorXs startPos = world->getPositions();
+  Eigen::VectorXs startVel = world->getVelocities();
+  int dofs = world->getNumDofs();
+
+  neural::LossGradient nextTimestepLoss;
+  nextTimestepLoss.lossWrtPosition = Eigen::VectorXs::Ones(dofs);
+  nextTimestepLoss.lossWrtVelocity = Eigen::VectorXs::Ones(dofs);
+  nextTimestepLoss.lossWrtTorque = Eigen::VectorXs::Zero(dofs);
+  nextTimestepLoss.lossWrtMass = Eigen::VectorXs::Zero(world->getMassDims());
+  for (auto _ : state)
+  {
+    world->setPositions(startPos);
+    world->setVelocities(startVel);
+    std::shared_ptr<neural::BackpropSnapshot> snapshot
+        = neural::forwardPass(world, false);
+    neural::LossGradient thisTimestepLoss;
+    snapshot->backprop(world, thisTimestepLoss, nextTimestepLoss);
+    benchmark::DoNotOptimize(thisTimestepLoss.lossWrtPosition.data());
+  }
+}
+BENCHMARK(BM_ForwardPass_Backprop)->Arg(1)->Arg(4)->Arg(16);
+
+//==============================================================================
+/// This collides a grid of overlapping spheres, so broadphase and narrowphase
+/// both scale with the body count
+static void BM_DARTCollisionDetector_Collide(benchmark::State& state)
+{
+  const int numBodies = state.range(0);
+  std::shared_ptr<collision::DARTCollisionDetector> detector
+      = collision::DARTCollisionDetector::create();
+  std::unique_ptr<collision::CollisionGroup> group
+      = detector->createCollisionGroup();
+
+  SkeletonPtr skel = Skeleton::create("spheres");
+  std::shared_ptr<SphereShape> sphere = std::make_shared<SphereShape>(0.06);
+  const int side = std::max(1, (int)std::ceil(std::sqrt((s_t)numBodies)));
+  for (int i = 0; i < numBodies; i++)
+  {
+    std::pair<FreeJoint*, BodyNode*> pair
+        = skel->createJointAndBodyNodePair<FreeJoint>(nullptr);
+    ShapeNode* node
+        = pair.second->createShapeNodeWith<CollisionAspect>(sphere);
+    Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+    T.translation() = Eigen::Vector3s(0.1 * (i % side), 0.1 * (i / side), 0);
+    pair.first->setTransform(T);
+    group->addShapeFrame(node);
+  }
+
+  collision::CollisionOption option(true, 1000u, nullptr);
+  collision::CollisionResult result;
+  for (auto _ : state)
+  {
+    result.clear();
+    group->collide(option, &result);
+    benchmark::DoNotOptimize(result.getNumContacts());
+  }
+  state.counters["contacts"] = result.getNumContacts();
+}
+BENCHMARK(BM_DARTCollisionDetector_Collide)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256);
+
+//==============================================================================
+static void BM_MultiShot_BackpropGradient(benchmark::State& state)
+{
+  WorldPtr world = createChainWorld(state.range(0));
+  trajectory::LossFn loss(
+      [](const trajectory::TrajectoryRollout* rollout) -> s_t {
+        const Eigen::Ref<const Eigen::MatrixXs> poses
+            = rollout->getPosesConst("identity");
+        return poses.col(poses.cols() - 1).squaredNorm();
+      });
+
+  const int steps = 40;
+  const int shotLength = 10;
+  trajectory::MultiShot shot(world, loss, steps, shotLength, false);
+  Eigen::VectorXs grad = Eigen::VectorXs::Zero(shot.getFlatProblemDim(world));
+  for (auto _ : state)
+  {
+    shot.backpropGradient(world, grad);
+    benchmark::DoNotOptimize(grad.data());
+  }
+}
+BENCHMARK(BM_MultiShot_BackpropGradient)
+    ->Arg(2)
+    ->Arg(5)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
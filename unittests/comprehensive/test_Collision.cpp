@@ -869,6 +869,22 @@ void testFilter(const std::shared_ptr<CollisionDetector>& cd)
   EXPECT_FALSE(group->collide(option));
   bodyNodeFilter->removeAllBodyNodePairsFromBlackList();
   EXPECT_TRUE(group->collide(option));
+
+  // The adjacency bitset the filter reads should match the joints
+  EXPECT_TRUE(skel->areBodyNodesAdjacent(0, 1));
+  EXPECT_TRUE(skel->areBodyNodesAdjacent(1, 0));
+  EXPECT_FALSE(skel->areBodyNodesAdjacent(0, 0));
+
+  // Test collision layers, which apply with or without a filter
+  auto* aspect0 = body0->getShapeNode(0)->getCollisionAspect();
+  auto* aspect1 = body1->getShapeNode(0)->getCollisionAspect();
+  aspect0->setCollisionLayers(0x2u);
+  aspect1->setCollisionMask(~0x2u);
+  EXPECT_FALSE(group->collide());
+  EXPECT_FALSE(group->collide(option));
+  aspect1->setCollisionMask(0x2u);
+  EXPECT_TRUE(group->collide());
+  EXPECT_TRUE(group->collide(option));
 }
 
 //==============================================================================
@@ -1072,4 +1088,577 @@ TEST_F(Collision, Factory)
   EXPECT_TRUE(!collision::CollisionDetector::getFactory()->canCreate("ode"));
 #endif
 }
-#endif
\ No newline at end of file
+#endif
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, BroadphaseMatchesBruteForce)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // Scatter a bunch of spheres in a small volume, so that some of them overlap
+  std::vector<SimpleFramePtr> frames;
+  std::vector<s_t> radii;
+  auto group = cd->createCollisionGroup();
+  auto groupA = cd->createCollisionGroup();
+  auto groupB = cd->createCollisionGroup();
+  srand(42);
+  for (int i = 0; i < 60; i++)
+  {
+    s_t radius = 0.05 + 0.1 * (s_t)rand() / RAND_MAX;
+    auto frame = SimpleFrame::createShared(Frame::World());
+    frame->setShape(std::make_shared<SphereShape>(radius));
+    frame->setTranslation(Eigen::Vector3s::Random() * 1.5);
+    group->addShapeFrame(frame.get());
+    if (i % 2 == 0)
+      groupA->addShapeFrame(frame.get());
+    else
+      groupB->addShapeFrame(frame.get());
+    frames.push_back(frame);
+    radii.push_back(radius);
+  }
+
+  for (int trial = 0; trial < 3; trial++)
+  {
+    // Each overlapping sphere pair produces exactly one contact
+    std::size_t expectedAll = 0;
+    std::size_t expectedAB = 0;
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+      for (std::size_t j = i + 1; j < frames.size(); j++)
+      {
+        s_t dist = (frames[i]->getWorldTransform().translation()
+                    - frames[j]->getWorldTransform().translation())
+                       .norm();
+        if (dist < radii[i] + radii[j])
+        {
+          expectedAll++;
+          if (i % 2 != j % 2)
+            expectedAB++;
+        }
+      }
+    }
+
+    collision::CollisionOption option;
+    collision::CollisionResult result;
+    group->collide(option, &result);
+    EXPECT_EQ(result.getNumContacts(), expectedAll);
+
+    result.clear();
+    groupA->collide(groupB.get(), option, &result);
+    EXPECT_EQ(result.getNumContacts(), expectedAB);
+
+    // Move everything a little bit, to exercise the incremental re-sort
+    for (auto& frame : frames)
+      frame->setTranslation(
+          frame->getWorldTransform().translation()
+          + Eigen::Vector3s::Random() * 0.2);
+  }
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, DARTDropsRepeatedContacts)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // Two identical spheres in the same place both touch a third sphere, so both
+  // pairs report exactly the same contact point
+  auto groupA = cd->createCollisionGroup();
+  auto groupB = cd->createCollisionGroup();
+  std::vector<SimpleFramePtr> frames;
+  for (int i = 0; i < 2; i++)
+  {
+    auto frame = SimpleFrame::createShared(Frame::World());
+    frame->setShape(std::make_shared<SphereShape>(0.5));
+    groupA->addShapeFrame(frame.get());
+    frames.push_back(frame);
+  }
+  auto other = SimpleFrame::createShared(Frame::World());
+  other->setShape(std::make_shared<SphereShape>(0.5));
+  other->setTranslation(Eigen::Vector3s(0.9, 0, 0));
+  groupB->addShapeFrame(other.get());
+
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+  groupA->collide(groupB.get(), option, &result);
+  EXPECT_EQ(result.getNumContacts(), 1u);
+
+  // Once the spheres separate, each pair gets its own contact again
+  frames[1]->setTranslation(Eigen::Vector3s(0, 0.1, 0));
+  result.clear();
+  groupA->collide(groupB.get(), option, &result);
+  EXPECT_EQ(result.getNumContacts(), 2u);
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, DARTHeightmapContacts)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // A large terrain that rises along +X with a slope of 0.5. Only the cells
+  // under each object should ever get looked at.
+  const std::size_t size = 500;
+  std::vector<s_t> heights(size * size);
+  for (std::size_t row = 0; row < size; row++)
+  {
+    for (std::size_t col = 0; col < size; col++)
+    {
+      heights[row * size + col] = 0.05 * col;
+    }
+  }
+  auto terrainShape = std::make_shared<HeightmapShaped>();
+  terrainShape->setHeightField(size, size, heights);
+  terrainShape->setScale(Eigen::Vector3s(0.1, 0.1, 1.0));
+  auto terrain = SimpleFrame::createShared(Frame::World());
+  terrain->setShape(terrainShape);
+
+  // The surface passes through z = 0 at the middle column, x = -0.05
+  const s_t x0 = -0.5 * (size - 1) * 0.1;
+  auto surfaceHeight = [&](s_t x) { return 0.5 * (x - x0); };
+  const Eigen::Vector3s normal = Eigen::Vector3s(-0.5, 0, 1).normalized();
+
+  auto object = SimpleFrame::createShared(Frame::World());
+  auto group = cd->createCollisionGroup(terrain.get(), object.get());
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+
+  auto expectContactsAlongNormal = [&]() {
+    EXPECT_GT(result.getNumContacts(), 0u);
+    for (std::size_t i = 0; i < result.getNumContacts(); i++)
+    {
+      const Contact& contact = result.getContact(i);
+      EXPECT_NEAR(std::abs(contact.normal.dot(normal)), 1.0, 1e-2);
+      EXPECT_GE(contact.penetrationDepth, 0.0);
+      EXPECT_LT(contact.penetrationDepth, 0.02);
+    }
+  };
+
+  // A sphere sunk 0.01 into the slope
+  object->setShape(std::make_shared<SphereShape>(0.1));
+  Eigen::Vector3s onSurface(0.33, 0.21, surfaceHeight(0.33));
+  object->setTranslation(onSurface + normal * 0.09);
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  expectContactsAlongNormal();
+
+  // ... but not once it's lifted off
+  object->setTranslation(onSurface + normal * 0.11);
+  result.clear();
+  EXPECT_FALSE(group->collide(option, &result));
+  EXPECT_EQ(result.getNumContacts(), 0u);
+
+  // A box, tilted to sit flat on the slope, spanning several cells
+  object->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(0.3, 0.3, 0.2)));
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.linear() = Eigen::Quaternion<s_t>::FromTwoVectors(
+                   Eigen::Vector3s::UnitZ(), normal)
+                   .toRotationMatrix();
+  onSurface = Eigen::Vector3s(-1.23, 2.05, surfaceHeight(-1.23));
+  T.translation() = onSurface + normal * 0.095;
+  object->setTransform(T);
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  expectContactsAlongNormal();
+
+  // A capsule lying across the slope
+  object->setShape(std::make_shared<CapsuleShape>(0.05, 0.3));
+  T.linear() = Eigen::AngleAxis_s(0.5 * M_PI, Eigen::Vector3s::UnitX())
+                   .toRotationMatrix();
+  onSurface = Eigen::Vector3s(2.4, -0.7, surfaceHeight(2.4));
+  T.translation() = onSurface + normal * 0.045;
+  object->setTransform(T);
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  expectContactsAlongNormal();
+
+  // Nothing collides out past the edge of the terrain
+  object->setShape(std::make_shared<SphereShape>(0.1));
+  object->setTranslation(Eigen::Vector3s(-x0 + 1.0, 0, 0));
+  result.clear();
+  EXPECT_FALSE(group->collide(option, &result));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, DARTPointCloudContacts)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // A flat 200 x 200 scan of the z = 0 plane, with points 2cm apart that each
+  // collide as a sphere of radius 1cm
+  auto cloudShape = std::make_shared<PointCloudShape>(0.02);
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 200; i++)
+  {
+    for (int j = 0; j < 200; j++)
+    {
+      points.emplace_back(0.02 * (i - 100), 0.02 * (j - 100), 0.0);
+    }
+  }
+  cloudShape->setPoint(points);
+  auto cloud = SimpleFrame::createShared(Frame::World());
+  cloud->setShape(cloudShape);
+
+  auto object = SimpleFrame::createShared(Frame::World());
+  auto group = cd->createCollisionGroup(cloud.get(), object.get());
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+
+  auto expectVerticalContacts = [&]() {
+    EXPECT_GT(result.getNumContacts(), 0u);
+    for (std::size_t i = 0; i < result.getNumContacts(); i++)
+    {
+      const Contact& contact = result.getContact(i);
+      EXPECT_GE(contact.penetrationDepth, 0.0);
+      EXPECT_LT(contact.penetrationDepth, 0.02);
+      EXPECT_LT(contact.point(2), 0.02);
+    }
+  };
+
+  // A sphere resting on the scan, right over a point
+  object->setShape(std::make_shared<SphereShape>(0.1));
+  object->setTranslation(Eigen::Vector3s(0.2, -0.4, 0.105));
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  expectVerticalContacts();
+
+  // ... but not once it's lifted off
+  object->setTranslation(Eigen::Vector3s(0.2, -0.4, 0.12));
+  result.clear();
+  EXPECT_FALSE(group->collide(option, &result));
+
+  // A box sunk slightly into the scan touches many points
+  object->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(0.2, 0.2, 0.2)));
+  object->setTranslation(Eigen::Vector3s(-0.5, 0.3, 0.105));
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_GT(result.getNumContacts(), 4u);
+  expectVerticalContacts();
+
+  // A capsule lying across the scan
+  object->setShape(std::make_shared<CapsuleShape>(0.05, 0.3));
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.linear() = Eigen::AngleAxis_s(0.5 * M_PI, Eigen::Vector3s::UnitX())
+                   .toRotationMatrix();
+  T.translation() = Eigen::Vector3s(0.7, 0.1, 0.055);
+  object->setTransform(T);
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  expectVerticalContacts();
+
+  // Nothing collides out past the edge of the scan
+  object->setShape(std::make_shared<SphereShape>(0.1));
+  object->setTranslation(Eigen::Vector3s(3.0, 0, 0));
+  result.clear();
+  EXPECT_FALSE(group->collide(option, &result));
+
+  // Scaling the scan up refits its tree, and the points move with it
+  std::shared_ptr<const math::SphereTree> tree = cloudShape->getSphereTree();
+  cloudShape->setScale(Eigen::Vector3s::Constant(2.0));
+  std::shared_ptr<const math::SphereTree> refit = cloudShape->getSphereTree();
+  EXPECT_NE(tree, refit);
+  EXPECT_EQ(tree->getNumSpheres(), refit->getNumSpheres());
+  EXPECT_TRUE(
+      equals(refit->getScale(), Eigen::Vector3s(Eigen::Vector3s::Constant(2))));
+  EXPECT_EQ(refit, cloudShape->getSphereTree());
+  object->setTranslation(Eigen::Vector3s(3.0, 0, 0.115));
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  expectVerticalContacts();
+  object->setTranslation(Eigen::Vector3s(3.0, 0, 0.125));
+  result.clear();
+  EXPECT_FALSE(group->collide(option, &result));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, DARTMultiSphereContacts)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  auto ground = SimpleFrame::createShared(Frame::World());
+  ground->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(2, 2, 0.2)));
+  ground->setTranslation(Eigen::Vector3s(0, 0, -0.1));
+
+  // A pill made of two spheres, lying along X
+  MultiSphereConvexHullShape::Spheres spheres;
+  spheres.emplace_back(0.05, Eigen::Vector3s(-0.1, 0, 0));
+  spheres.emplace_back(0.05, Eigen::Vector3s(0.1, 0, 0));
+  auto pill = SimpleFrame::createShared(Frame::World());
+  pill->setShape(std::make_shared<MultiSphereConvexHullShape>(spheres));
+
+  auto group = cd->createCollisionGroup(ground.get(), pill.get());
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+
+  pill->setTranslation(Eigen::Vector3s(0.3, 0.2, 0.045));
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_GT(result.getNumContacts(), 0u);
+  for (std::size_t i = 0; i < result.getNumContacts(); i++)
+  {
+    const Contact& contact = result.getContact(i);
+    EXPECT_NEAR(std::abs(contact.normal(2)), 1.0, 1e-3);
+    EXPECT_NEAR(contact.point(2), 0.0, 0.01);
+    EXPECT_NEAR(contact.penetrationDepth, 0.005, 1e-3);
+  }
+
+  pill->setTranslation(Eigen::Vector3s(0.3, 0.2, 0.06));
+  result.clear();
+  EXPECT_FALSE(group->collide(option, &result));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, DARTSignedDistance)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  auto sphere = SimpleFrame::createShared(Frame::World());
+  sphere->setShape(std::make_shared<SphereShape>(0.5));
+
+  auto box = SimpleFrame::createShared(Frame::World());
+  box->setShape(std::make_shared<BoxShape>(Eigen::Vector3s::Ones()));
+  box->setTranslation(Eigen::Vector3s(2.0, 0.0, 0.0));
+
+  auto capsule = SimpleFrame::createShared(Frame::World());
+  capsule->setShape(std::make_shared<CapsuleShape>(0.2, 1.0));
+  capsule->setTranslation(Eigen::Vector3s(0.0, 3.0, 0.0));
+
+  auto group = cd->createCollisionGroup(sphere.get(), box.get(), capsule.get());
+
+  // The sphere and the box face are the closest pair
+  collision::DistanceOption option(true, -std::numeric_limits<double>::max());
+  collision::DistanceResult result;
+  double dist = group->distance(option, &result);
+  EXPECT_NEAR(dist, 1.0, 1e-8);
+  EXPECT_NEAR(result.unclampedMinDistance, 1.0, 1e-8);
+  EXPECT_TRUE(result.found());
+  EXPECT_TRUE(equals(
+      result.nearestPoint1, Eigen::Vector3s(0.5, 0.0, 0.0), (s_t)1e-8));
+  EXPECT_TRUE(equals(
+      result.nearestPoint2, Eigen::Vector3s(1.5, 0.0, 0.0), (s_t)1e-8));
+
+  // The lower bound clamps the result
+  option.distanceLowerBound = 2.0;
+  dist = group->distance(option, &result);
+  EXPECT_NEAR(dist, 2.0, 1e-8);
+  EXPECT_NEAR(result.unclampedMinDistance, 1.0, 1e-8);
+  EXPECT_TRUE(result.isMinDistanceClamped());
+
+  // Group-group queries only look at pairs across the groups
+  auto groupA = cd->createCollisionGroup(sphere.get());
+  auto groupB = cd->createCollisionGroup(capsule.get());
+  option.distanceLowerBound = -std::numeric_limits<double>::max();
+  dist = groupA->distance(groupB.get(), option, &result);
+  EXPECT_NEAR(dist, 3.0 - 0.2 - 0.5, 1e-8);
+  EXPECT_TRUE(equals(
+      result.nearestPoint2, Eigen::Vector3s(0.0, 2.8, 0.0), (s_t)1e-8));
+
+  // Box to capsule, where the nearest box feature is an edge
+  auto groupC = cd->createCollisionGroup(box.get());
+  dist = groupC->distance(groupB.get(), option, &result);
+  EXPECT_NEAR(dist, std::sqrt(1.5 * 1.5 + 2.5 * 2.5) - 0.2, 1e-8);
+
+  // Overlapping spheres give a negative distance
+  auto other = SimpleFrame::createShared(Frame::World());
+  other->setShape(std::make_shared<SphereShape>(0.5));
+  other->setTranslation(Eigen::Vector3s(0.8, 0.0, 0.0));
+  group->addShapeFrame(other.get());
+  dist = group->distance(option, &result);
+  EXPECT_NEAR(dist, -0.2, 1e-8);
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, SelfCollisionPairs)
+{
+  // body1 swings around the root 3 units out, so it can never reach body0,
+  // but body2 hangs right next to body1
+  auto skel = Skeleton::create();
+  auto shape = std::make_shared<BoxShape>(Eigen::Vector3s(1, 1, 1));
+  auto* body0 = skel->createJointAndBodyNodePair<WeldJoint>(nullptr).second;
+  body0->createShapeNodeWith<VisualAspect, CollisionAspect>(shape);
+  auto pair1 = body0->createChildJointAndBodyNodePair<RevoluteJoint>();
+  Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+  offset.translation() = Eigen::Vector3s(3, 0, 0);
+  pair1.first->setAxis(Eigen::Vector3s::UnitZ());
+  pair1.first->setTransformFromChildBodyNode(offset.inverse());
+  pair1.first->setPositionLowerLimit(0, -1.0);
+  pair1.first->setPositionUpperLimit(0, 1.0);
+  auto* body1 = pair1.second;
+  body1->createShapeNodeWith<VisualAspect, CollisionAspect>(shape);
+  auto pair2 = body1->createChildJointAndBodyNodePair<WeldJoint>();
+  offset.translation() = Eigen::Vector3s(0.5, 0, 0);
+  pair2.first->setTransformFromParentBodyNode(offset);
+  auto* body2 = pair2.second;
+  body2->createShapeNodeWith<VisualAspect, CollisionAspect>(shape);
+
+  EXPECT_FALSE(skel->hasSelfCollisionPairs());
+  EXPECT_TRUE(skel->canBodyNodesSelfCollide(0, 1));
+  EXPECT_EQ(skel->getSelfCollisionPairs().size(), 3u);
+
+  skel->computeSelfCollisionPairs(200);
+  EXPECT_TRUE(skel->hasSelfCollisionPairs());
+  EXPECT_FALSE(skel->canBodyNodesSelfCollide(0, 1));
+  EXPECT_FALSE(skel->canBodyNodesSelfCollide(0, 2));
+  EXPECT_TRUE(skel->canBodyNodesSelfCollide(1, 2));
+  EXPECT_TRUE(skel->canBodyNodesSelfCollide(2, 1));
+  ASSERT_EQ(skel->getSelfCollisionPairs().size(), 1u);
+  EXPECT_EQ(skel->getSelfCollisionPairs()[0].first, 1u);
+  EXPECT_EQ(skel->getSelfCollisionPairs()[0].second, 2u);
+
+  // Clones keep the pairs, and structural changes drop them
+  auto clone = skel->cloneSkeleton();
+  EXPECT_TRUE(clone->hasSelfCollisionPairs());
+  EXPECT_FALSE(clone->canBodyNodesSelfCollide(0, 1));
+  clone->getBodyNode(2)->remove();
+  EXPECT_FALSE(clone->hasSelfCollisionPairs());
+
+  // The filter still lets the pair that can touch collide
+  auto world = std::make_shared<simulation::World>();
+  world->getConstraintSolver()->setCollisionDetector(
+      DARTCollisionDetector::create());
+  world->addSkeleton(skel);
+  skel->enableSelfCollisionCheck();
+  skel->enableAdjacentBodyCheck();
+  auto group = world->getConstraintSolver()->getCollisionGroup();
+  collision::CollisionOption option;
+  option.collisionFilter = std::make_shared<BodyNodeCollisionFilter>();
+  EXPECT_TRUE(group->collide(option));
+  // Blacklisting that pair leaves nothing that can collide
+  std::static_pointer_cast<BodyNodeCollisionFilter>(option.collisionFilter)
+      ->addBodyNodePairToBlackList(body1, body2);
+  EXPECT_FALSE(group->collide(option));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, BroadphaseRefitsMovedObjects)
+{
+  auto cd = DARTCollisionDetector::create();
+  auto group = cd->createCollisionGroup();
+
+  auto staticFrame = SimpleFrame::createShared(Frame::World());
+  staticFrame->setShape(std::make_shared<SphereShape>(0.5));
+  group->addShapeFrame(staticFrame.get());
+
+  auto sphere = std::make_shared<SphereShape>(0.5);
+  auto movingFrame = SimpleFrame::createShared(Frame::World());
+  movingFrame->setShape(sphere);
+  movingFrame->setTranslation(Eigen::Vector3s(2.0, 0, 0));
+  group->addShapeFrame(movingFrame.get());
+
+  collision::CollisionOption option;
+  EXPECT_FALSE(group->collide(option));
+
+  // Reading the transform doesn't change the version, but moving does
+  const std::size_t staticVersion = staticFrame->getTransformVersion();
+  const std::size_t movingVersion = movingFrame->getTransformVersion();
+  staticFrame->getWorldTransform();
+  EXPECT_EQ(staticFrame->getTransformVersion(), staticVersion);
+  movingFrame->setTranslation(Eigen::Vector3s(0.8, 0, 0));
+  EXPECT_NE(movingFrame->getTransformVersion(), movingVersion);
+
+  // The moved object gets refit, and the static one keeps its AABB
+  EXPECT_TRUE(group->collide(option));
+  EXPECT_EQ(staticFrame->getTransformVersion(), staticVersion);
+
+  movingFrame->setTranslation(Eigen::Vector3s(1.5, 0, 0));
+  EXPECT_FALSE(group->collide(option));
+
+  // Growing the shape without moving the frame also needs a refit
+  sphere->setRadius(1.2);
+  EXPECT_TRUE(group->collide(option));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, BoundingSphereCullKeepsPrimitiveContacts)
+{
+  auto cd = DARTCollisionDetector::create();
+  auto group = cd->createCollisionGroup();
+
+  // A box turned 45 degrees has an AABB that reaches well past the box
+  // itself, so this pair gets through the broadphase, but the bounding spheres
+  // are far enough apart to skip the narrowphase
+  auto box = std::make_shared<BoxShape>(Eigen::Vector3s::Ones());
+  auto frame1 = SimpleFrame::createShared(Frame::World());
+  frame1->setShape(box);
+  auto frame2 = SimpleFrame::createShared(Frame::World());
+  frame2->setShape(box);
+  frame2->setRotation(
+      Eigen::AngleAxis_s(0.25 * M_PI, Eigen::Vector3s::UnitZ()).matrix());
+  frame2->setTranslation(Eigen::Vector3s(1.2, 1.2, 0.5));
+  group->addShapeFrame(frame1.get());
+  group->addShapeFrame(frame2.get());
+
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+  EXPECT_FALSE(group->collide(option, &result));
+
+  // Any overlap still needs to get through to the narrowphase, including
+  // between a box and a capsule that only touch near the box's corner
+  frame2->setTranslation(Eigen::Vector3s(0.8, 0.8, 0.5));
+  EXPECT_TRUE(group->collide(option, &result));
+
+  auto capsuleFrame = SimpleFrame::createShared(Frame::World());
+  capsuleFrame->setShape(std::make_shared<CapsuleShape>(0.1, 1.0));
+  capsuleFrame->setTranslation(Eigen::Vector3s(-0.55, -0.55, -0.9));
+  auto capsuleGroup = cd->createCollisionGroup(capsuleFrame.get());
+  auto boxGroup = cd->createCollisionGroup(frame1.get());
+  result.clear();
+  EXPECT_TRUE(boxGroup->collide(capsuleGroup.get(), option, &result));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, CollisionResultTracksCollidingObjects)
+{
+  auto cd = DARTCollisionDetector::create();
+  auto group = cd->createCollisionGroup();
+
+  auto box = std::make_shared<BoxShape>(Eigen::Vector3s::Ones());
+  auto frame1 = SimpleFrame::createShared(Frame::World());
+  frame1->setShape(box);
+  auto frame2 = SimpleFrame::createShared(Frame::World());
+  frame2->setShape(box);
+  frame2->setTranslation(Eigen::Vector3s(0.9, 0.0, 0.0));
+  auto frame3 = SimpleFrame::createShared(Frame::World());
+  frame3->setShape(box);
+  frame3->setTranslation(Eigen::Vector3s(5.0, 0.0, 0.0));
+  group->addShapeFrame(frame1.get());
+  group->addShapeFrame(frame2.get());
+  group->addShapeFrame(frame3.get());
+
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+  result.reserve(16);
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_TRUE(result.inCollision(frame1.get()));
+  EXPECT_TRUE(result.inCollision(frame2.get()));
+  EXPECT_FALSE(result.inCollision(frame3.get()));
+  EXPECT_EQ(result.getCollidingShapeFrames().size(), 2u);
+
+  // Clearing the result should forget the old colliding objects, and then
+  // the next query should pick up the new ones
+  result.clear();
+  EXPECT_FALSE(result.inCollision(frame1.get()));
+  EXPECT_TRUE(result.getCollidingShapeFrames().empty());
+
+  frame2->setTranslation(Eigen::Vector3s(5.0, 0.5, 0.0));
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_FALSE(result.inCollision(frame1.get()));
+  EXPECT_TRUE(result.inCollision(frame2.get()));
+  EXPECT_TRUE(result.inCollision(frame3.get()));
+}
+#endif
@@ -36,7 +36,14 @@
 
 #include <gtest/gtest.h>
 
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/DiffNode.hpp"
+#include "dart/neural/DiffTape.hpp"
+#include "dart/neural/IdentityMapping.hpp"
+#include "dart/simulation/World.hpp"
 
 #include "GradientTestUtils.hpp"
 #include "TestHelpers.hpp"
@@ -56,4 +63,103 @@ TEST(DIFF_GRAPHS, BASIC)
 {
   DiffNode node = DiffNode();
 }
+#endif
+
+/// This records a few steps of a double pendulum on `tape`, with a loss on
+/// the final state and on every force, and returns the indices of the force
+/// nodes
+std::vector<int> recordPendulumRollout(
+    std::shared_ptr<simulation::World> world,
+    DiffTape& tape,
+    const Eigen::MatrixXs& forces)
+{
+  std::vector<int> forceNodes;
+  int state = tape.addWorldState();
+  for (int t = 0; t < forces.cols(); t++)
+  {
+    int force = tape.addInput(forces.col(t));
+    forceNodes.push_back(force);
+    tape.addLoss(
+        {force},
+        [](const std::vector<Eigen::VectorXs>& inputs,
+           std::vector<Eigen::VectorXs>& gradients) -> s_t {
+          gradients[0] = 0.02 * inputs[0];
+          return 0.01 * inputs[0].squaredNorm();
+        });
+    state = tape.addForwardPass(state, force);
+  }
+  int mapped = tape.addMapping(state, std::make_shared<IdentityMapping>(world));
+  tape.addLoss(
+      {mapped},
+      [](const std::vector<Eigen::VectorXs>& inputs,
+         std::vector<Eigen::VectorXs>& gradients) -> s_t {
+        gradients[0] = 2 * inputs[0];
+        return inputs[0].squaredNorm();
+      });
+  return forceNodes;
+}
+
+#ifdef ALL_TESTS
+TEST(DIFF_GRAPHS, TAPE_MATCHES_FINITE_DIFFERENCES)
+{
+  std::shared_ptr<simulation::World> world = simulation::World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  std::shared_ptr<dynamics::Skeleton> pendulum
+      = dynamics::Skeleton::create("pendulum");
+  dynamics::BodyNode* parent = nullptr;
+  for (int i = 0; i < 2; i++)
+  {
+    auto pair = pendulum->createJointAndBodyNodePair<dynamics::RevoluteJoint>(
+        parent);
+    pair.first->setAxis(Eigen::Vector3s::UnitZ());
+    Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+    offset.translation() = Eigen::Vector3s(0, -0.5, 0);
+    if (parent != nullptr)
+      pair.first->setTransformFromParentBodyNode(offset);
+    pair.second->setMass(1.0);
+    pair.second->createShapeNodeWith<VisualAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3s(0.1, 0.5, 0.1)));
+    parent = pair.second;
+  }
+  world->addSkeleton(pendulum);
+  world->setPositions(Eigen::Vector2s(0.3, -0.2));
+  Eigen::VectorXs startState = world->getState();
+
+  const int steps = 8;
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Random(2, steps);
+
+  DiffTape tape(world);
+  tape.reserve(4 * steps + 3);
+  std::vector<int> forceNodes = recordPendulumRollout(world, tape, forces);
+  tape.backward();
+
+  // Running the sweep on one thread should give exactly the same result
+  std::vector<Eigen::VectorXs> parallelGrads;
+  for (int node : forceNodes)
+    parallelGrads.push_back(tape.getGradient(node));
+  tape.backward(false);
+  for (int t = 0; t < steps; t++)
+    EXPECT_TRUE(equals(parallelGrads[t], tape.getGradient(forceNodes[t]), 0));
+
+  const s_t eps = 1e-7;
+  for (int t = 0; t < steps; t++)
+  {
+    for (int d = 0; d < 2; d++)
+    {
+      Eigen::MatrixXs perturbed = forces;
+      perturbed(d, t) += eps;
+      world->setState(startState);
+      DiffTape plus(world);
+      recordPendulumRollout(world, plus, perturbed);
+
+      perturbed(d, t) -= 2 * eps;
+      world->setState(startState);
+      DiffTape minus(world);
+      recordPendulumRollout(world, minus, perturbed);
+
+      s_t fd = (plus.getLoss() - minus.getLoss()) / (2 * eps);
+      EXPECT_NEAR(fd, tape.getGradient(forceNodes[t])(d), 1e-5);
+    }
+  }
+}
 #endif
\ No newline at end of file
@@ -606,6 +606,23 @@ x);
                           .isZero());
         }
 
+        // Test that the fused pass agrees with the separate ones
+        {
+          Eigen::VectorXs x = Eigen::VectorXs::Random(dof);
+          dynamics::Skeleton::DynamicsJacobians jacobians;
+          skel->computeDynamicsJacobians(x, jacobians);
+          Eigen::MatrixXs DMX_Dq
+              = skel->getJacobianOfM(x, neural::WithRespectTo::POSITION);
+          Eigen::MatrixXs DC_Dq
+              = skel->getJacobianOfC(neural::WithRespectTo::POSITION);
+          Eigen::MatrixXs DC_Dv
+              = skel->getJacobianOfC(neural::WithRespectTo::VELOCITY);
+          EXPECT_TRUE(equals(jacobians.dMddq_dq, DMX_Dq, 1e-10));
+          EXPECT_TRUE(equals(jacobians.dC_dq, DC_Dq, 1e-10));
+          EXPECT_TRUE(equals(jacobians.dC_dv, DC_Dv, 1e-10));
+          EXPECT_TRUE(equals(skel->getAccelerations(), ddq, 0));
+        }
+
         // Test derivative of forward dynamics w.r.t. position
         {
           Eigen::MatrixXs DFD_Dq_numerical = skel->finiteDifferenceJacobianOfFD(
@@ -9,7 +9,10 @@
 #include <gtest/gtest.h>
 
 #include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIRecording.hpp"
 
@@ -117,3 +120,360 @@ TEST(RECORDING, GUI_SERVER)
   // recording.saveFramesJson("./atlas_recording.json");
 }
 #endif
+
+TEST(RECORDING, QUANTIZED_TRANSFORMS_ROUND_TRIP)
+{
+  GUIRecording recording;
+  recording.setQuantizeTransforms(true, 1e-3, 1e-3);
+  Eigen::Vector3s zero = Eigen::Vector3s::Zero();
+  recording.createBox("a", Eigen::Vector3s::Ones(), zero, zero);
+  recording.createBox("b", Eigen::Vector3s::Ones(), zero, zero);
+  recording.saveFrame();
+
+  std::vector<Eigen::Vector3s> truthA;
+  std::vector<Eigen::Vector3s> truthB;
+  for (int i = 0; i < 5; i++)
+  {
+    truthA.push_back(Eigen::Vector3s::Random());
+    truthB.push_back(Eigen::Vector3s::Random());
+    recording.setObjectPosition("a", truthA.back());
+    recording.setObjectRotation("a", truthB.back());
+    recording.setObjectPosition("b", truthB.back());
+    recording.saveFrame();
+  }
+
+  // Decode the frames the same way the web client does
+  std::map<int, Eigen::Vector3i> positions;
+  std::map<int, Eigen::Vector3i> rotations;
+  int keyA = recording.getStringCode("a");
+  int keyB = recording.getStringCode("b");
+  for (int i = 0; i < 5; i++)
+  {
+    proto::CommandList list;
+    list.ParseFromString(recording.getFrameJson(i + 1));
+    ASSERT_EQ(list.command_size(), 1);
+    ASSERT_TRUE(list.command(0).has_set_object_transforms());
+    const proto::SetObjectTransforms& batch
+        = list.command(0).set_object_transforms();
+    EXPECT_EQ(batch.keyframe(), i == 0);
+    ASSERT_EQ(batch.position_key_size(), 2);
+    ASSERT_EQ(batch.rotation_key_size(), 1);
+
+    int key = 0;
+    for (int j = 0; j < batch.position_key_size(); j++)
+    {
+      key += batch.position_key(j);
+      Eigen::Vector3i& last
+          = positions.emplace(key, Eigen::Vector3i::Zero()).first->second;
+      for (int k = 0; k < 3; k++)
+      {
+        last(k) += batch.position(j * 3 + k);
+      }
+    }
+    key = batch.rotation_key(0);
+    Eigen::Vector3i& lastRotation
+        = rotations.emplace(key, Eigen::Vector3i::Zero()).first->second;
+    for (int k = 0; k < 3; k++)
+    {
+      lastRotation(k) += batch.rotation(k);
+    }
+
+    s_t precision = batch.position_precision();
+    EXPECT_TRUE(
+        ((positions[keyA].cast<s_t>() * precision) - truthA[i]).norm() < 2e-3);
+    EXPECT_TRUE(
+        ((positions[keyB].cast<s_t>() * precision) - truthB[i]).norm() < 2e-3);
+    EXPECT_TRUE(
+        ((rotations[keyA].cast<s_t>() * precision) - truthB[i]).norm() < 2e-3);
+  }
+}
+
+TEST(RECORDING, COALESCE_UPDATES_BETWEEN_FLUSHES)
+{
+  GUIRecording recording;
+  Eigen::Vector3s zero = Eigen::Vector3s::Zero();
+  recording.createBox("a", Eigen::Vector3s::Ones(), zero, zero);
+  recording.saveFrame();
+
+  Eigen::Vector3s pos = Eigen::Vector3s::Zero();
+  for (int i = 0; i < 10; i++)
+  {
+    pos = Eigen::Vector3s::Random();
+    recording.setObjectPosition("a", pos);
+    recording.setObjectColor("a", Eigen::Vector4s::Ones() * i / 10.0);
+  }
+  recording.saveFrame();
+
+  proto::CommandList list;
+  list.ParseFromString(recording.getFrameJson(1));
+  ASSERT_EQ(list.command_size(), 2);
+  ASSERT_TRUE(list.command(0).has_set_object_position());
+  EXPECT_FLOAT_EQ(list.command(0).set_object_position().data(0), pos(0));
+  EXPECT_FLOAT_EQ(list.command(0).set_object_position().data(2), pos(2));
+  ASSERT_TRUE(list.command(1).has_set_object_color());
+  EXPECT_FLOAT_EQ(list.command(1).set_object_color().data(0), 0.9);
+
+  // Deleting and re-creating an object mustn't let older updates jump ahead
+  // of the new creation
+  recording.setObjectPosition("a", zero);
+  recording.deleteObject("a");
+  recording.createBox("a", Eigen::Vector3s::Ones(), zero, zero);
+  recording.setObjectPosition("a", pos);
+  recording.saveFrame();
+  list.ParseFromString(recording.getFrameJson(2));
+  ASSERT_EQ(list.command_size(), 4);
+  ASSERT_TRUE(list.command(3).has_set_object_position());
+  EXPECT_FLOAT_EQ(list.command(3).set_object_position().data(0), pos(0));
+}
+
+TEST(RECORDING, STREAM_TO_FILE)
+{
+  std::string path = "./test_gui_recording_stream.bin";
+  Eigen::Vector3s zero = Eigen::Vector3s::Zero();
+
+  std::vector<std::string> expected;
+  {
+    GUIRecording recording;
+    recording.createBox("a", Eigen::Vector3s::Ones(), zero, zero);
+    recording.saveFrame();
+    expected.push_back(recording.getFrameJson(0));
+
+    // Frames recorded before we start streaming get moved to the file
+    ASSERT_TRUE(recording.streamToFile(path));
+    EXPECT_TRUE(recording.isStreaming());
+    EXPECT_EQ(recording.getNumFrames(), 1);
+    for (int i = 0; i < 20; i++)
+    {
+      recording.setObjectPosition("a", Eigen::Vector3s::Random());
+      recording.saveFrame();
+      expected.push_back(recording.getFrameJson(i + 1));
+    }
+    EXPECT_EQ(recording.getNumFrames(), 21);
+    // Random access doesn't depend on the order we read in
+    EXPECT_EQ(recording.getFrameJson(3), expected[3]);
+    EXPECT_EQ(recording.getFrameJson(0), expected[0]);
+    EXPECT_EQ(recording.getFrameJson(20), expected[20]);
+  }
+
+  // Re-open the file and keep appending to it
+  GUIRecording recording;
+  ASSERT_TRUE(recording.streamToFile(path, true));
+  EXPECT_EQ(recording.getNumFrames(), 21);
+  recording.createBox("b", Eigen::Vector3s::Ones(), zero, zero);
+  recording.saveFrame();
+  EXPECT_EQ(recording.getNumFrames(), 22);
+  for (int i = 0; i < expected.size(); i++)
+  {
+    EXPECT_EQ(recording.getFrameJson(i), expected[i]);
+  }
+
+  // The index holds the offset of every frame
+  recording.closeStream();
+  std::ifstream index(path + ".index", std::ios::binary | std::ios::ate);
+  EXPECT_EQ((int)index.tellg(), 22 * (int)sizeof(int64_t));
+  index.close();
+
+  std::remove(path.c_str());
+  std::remove((path + ".index").c_str());
+}
+
+TEST(RECORDING, DEDUPLICATE_MESH_ASSETS)
+{
+  GUIRecording recording;
+  Eigen::Vector3s zero = Eigen::Vector3s::Zero();
+  std::vector<Eigen::Vector3s> vertices;
+  vertices.push_back(Eigen::Vector3s(0, 0, 0));
+  vertices.push_back(Eigen::Vector3s(1, 0, 0));
+  vertices.push_back(Eigen::Vector3s(0, 1, 0));
+  std::vector<Eigen::Vector3i> faces;
+  faces.push_back(Eigen::Vector3i(0, 1, 2));
+  std::vector<Eigen::Vector3s> normals;
+  std::vector<Eigen::Vector2s> uv;
+  std::vector<std::string> textures;
+  std::vector<int> textureStarts;
+
+  // The same geometry under two keys should only be sent once
+  recording.createTexture("tex_a", "data:image/png;base64, AAAA");
+  recording.createTexture("tex_b", "data:image/png;base64, AAAA");
+  recording.createMesh(
+      "a", vertices, normals, faces, uv, textures, textureStarts, zero, zero);
+  recording.createMesh(
+      "b", vertices, normals, faces, uv, textures, textureStarts, zero, zero);
+  recording.saveFrame();
+
+  proto::CommandList list;
+  list.ParseFromString(recording.getFrameJson(0));
+  ASSERT_EQ(list.command_size(), 5);
+  ASSERT_TRUE(list.command(0).has_texture());
+  ASSERT_TRUE(list.command(1).has_texture());
+  EXPECT_EQ(list.command(0).texture().hash(), list.command(1).texture().hash());
+  EXPECT_NE(list.command(0).texture().base64(), "");
+  EXPECT_EQ(list.command(1).texture().base64(), "");
+  ASSERT_TRUE(list.command(2).has_mesh_asset());
+  EXPECT_EQ(list.command(2).mesh_asset().vertex_size(), 9);
+  ASSERT_TRUE(list.command(3).has_mesh());
+  ASSERT_TRUE(list.command(4).has_mesh());
+  EXPECT_EQ(list.command(3).mesh().asset(), list.command(2).mesh_asset().hash());
+  EXPECT_EQ(list.command(4).mesh().asset(), list.command(2).mesh_asset().hash());
+  EXPECT_EQ(list.command(3).mesh().vertex_size(), 0);
+
+  // A new client also only gets the shared data once
+  list.ParseFromString(recording.getCurrentStateAsJson());
+  int numAssets = 0;
+  int numTexturesWithData = 0;
+  for (int i = 0; i < list.command_size(); i++)
+  {
+    if (list.command(i).has_mesh_asset())
+      numAssets++;
+    if (list.command(i).has_texture()
+        && list.command(i).texture().base64() != "")
+      numTexturesWithData++;
+  }
+  EXPECT_EQ(numAssets, 1);
+  EXPECT_EQ(numTexturesWithData, 1);
+
+  // Once nothing uses an asset, it gets sent again if it comes back
+  recording.deleteObject("a");
+  recording.deleteObject("b");
+  recording.createMesh(
+      "c", vertices, normals, faces, uv, textures, textureStarts, zero, zero);
+  recording.saveFrame();
+  list.ParseFromString(recording.getFrameJson(1));
+  ASSERT_EQ(list.command_size(), 4);
+  EXPECT_TRUE(list.command(2).has_mesh_asset());
+  EXPECT_TRUE(list.command(3).has_mesh());
+}
+
+TEST(RECORDING, INSTANCED_SKELETONS)
+{
+  GUIRecording recording;
+
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create("box");
+  auto pair = skel->createJointAndBodyNodePair<dynamics::FreeJoint>();
+  pair.second->createShapeNodeWith<VisualAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3s(1.0, 2.0, 3.0)));
+  pair.second->createShapeNodeWith<VisualAspect>(
+      std::make_shared<SphereShape>(0.5));
+  std::shared_ptr<dynamics::Skeleton> copy = skel->cloneSkeleton();
+
+  // The template only gets sent once, and each copy is a single command
+  recording.renderSkeletonInstanced(skel, "template", "a");
+  copy->setPositions(Eigen::VectorXs::Ones(copy->getNumDofs()));
+  recording.renderSkeletonInstanced(copy, "template", "b");
+  recording.saveFrame();
+
+  proto::CommandList list;
+  list.ParseFromString(recording.getFrameJson(0));
+  ASSERT_EQ(list.command_size(), 3);
+  ASSERT_TRUE(list.command(0).has_skeleton_template());
+  EXPECT_EQ(list.command(0).skeleton_template().shape_size(), 2);
+  EXPECT_EQ(list.command(0).skeleton_template().shape(0).type(), 0);
+  EXPECT_EQ(list.command(0).skeleton_template().shape(1).type(), 1);
+  ASSERT_TRUE(list.command(1).has_skeleton_instance());
+  ASSERT_TRUE(list.command(2).has_skeleton_instance());
+  EXPECT_EQ(list.command(1).skeleton_instance().transform_size(), 12);
+  EXPECT_EQ(
+      list.command(1).skeleton_instance().template_key(),
+      list.command(0).skeleton_template().key());
+  EXPECT_NE(
+      list.command(1).skeleton_instance().key(),
+      list.command(2).skeleton_instance().key());
+  EXPECT_EQ(
+      list.command(2).skeleton_instance().transform(0),
+      (float)(double)copy->getBodyNode(0)
+          ->getShapeNode(0)
+          ->getWorldTransform()
+          .translation()(0));
+
+  // Updates within a frame overwrite each other, and unchanged copies send
+  // nothing
+  copy->setPositions(Eigen::VectorXs::Zero(copy->getNumDofs()));
+  recording.renderSkeletonInstanced(skel, "template", "a");
+  recording.renderSkeletonInstanced(copy, "template", "b");
+  copy->setPositions(Eigen::VectorXs::Ones(copy->getNumDofs()) * 2);
+  recording.renderSkeletonInstanced(copy, "template", "b");
+  recording.saveFrame();
+  list.ParseFromString(recording.getFrameJson(1));
+  ASSERT_EQ(list.command_size(), 1);
+  EXPECT_TRUE(list.command(0).has_skeleton_instance());
+
+  // A new client gets the template and both copies
+  list.ParseFromString(recording.getCurrentStateAsJson());
+  int numTemplates = 0;
+  int numInstances = 0;
+  for (int i = 0; i < list.command_size(); i++)
+  {
+    if (list.command(i).has_skeleton_template())
+      numTemplates++;
+    if (list.command(i).has_skeleton_instance())
+      numInstances++;
+  }
+  EXPECT_EQ(numTemplates, 1);
+  EXPECT_EQ(numInstances, 2);
+
+  recording.deleteObject("b");
+  EXPECT_FALSE(recording.hasObject("b"));
+  EXPECT_TRUE(recording.hasObject("a"));
+}
+
+TEST(RECORDING, APPEND_RICH_PLOT_DATA)
+{
+  GUIRecording recording;
+  recording.createRichPlot(
+      "plot",
+      Eigen::Vector2i(0, 0),
+      Eigen::Vector2i(100, 100),
+      0,
+      1,
+      0,
+      1,
+      "Loss",
+      "Iteration",
+      "Loss");
+  recording.saveFrame();
+
+  // The first append creates the line, and later ones only send new points
+  std::vector<s_t> xs;
+  std::vector<s_t> ys;
+  xs.push_back(0);
+  ys.push_back(1);
+  recording.appendRichPlotData("plot", "loss", "red", "line", xs, ys);
+  xs[0] = 1;
+  ys[0] = 0.5;
+  recording.appendRichPlotData("plot", "loss", "red", "line", xs, ys);
+  recording.saveFrame();
+
+  proto::CommandList list;
+  list.ParseFromString(recording.getFrameJson(1));
+  ASSERT_EQ(list.command_size(), 2);
+  ASSERT_TRUE(list.command(0).has_set_rich_plot_data());
+  EXPECT_EQ(list.command(0).set_rich_plot_data().xs_size(), 1);
+  ASSERT_TRUE(list.command(1).has_append_rich_plot_data());
+  EXPECT_EQ(list.command(1).append_rich_plot_data().xs_size(), 1);
+  EXPECT_EQ(list.command(1).append_rich_plot_data().name(), "loss");
+
+  // A long history never costs more than about twice the plot's width
+  for (int i = 2; i < 10000; i++)
+  {
+    xs[0] = i;
+    ys[0] = 1.0 / i;
+    recording.appendRichPlotData("plot", "loss", "red", "line", xs, ys);
+    recording.saveFrame();
+    list.ParseFromString(recording.getFrameJson(i));
+    ASSERT_EQ(list.command_size(), 1);
+    if (list.command(0).has_set_rich_plot_data())
+    {
+      EXPECT_LE(list.command(0).set_rich_plot_data().xs_size(), 100);
+    }
+  }
+
+  list.ParseFromString(recording.getCurrentStateAsJson());
+  for (int i = 0; i < list.command_size(); i++)
+  {
+    if (list.command(i).has_set_rich_plot_data())
+    {
+      EXPECT_EQ(list.command(i).set_rich_plot_data().xs_size(), 100);
+      EXPECT_EQ(list.command(i).set_rich_plot_data().xs(99), 9999);
+    }
+  }
+}
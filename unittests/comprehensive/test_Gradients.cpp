@@ -293,6 +293,9 @@ void testBlockWithFrictionCoeff(s_t frictionCoeff, s_t mass)
   EXPECT_TRUE(verifyAnalyticalJacobians(world));
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
+  EXPECT_TRUE(verifyBackpropBatch(world));
+  EXPECT_TRUE(verifyJacobianCacheBudget(world));
   EXPECT_TRUE(verifyWrtMass(world));
 }
 
@@ -428,6 +431,7 @@ void testSphereStack()
   EXPECT_TRUE(verifyAnalyticalJacobians(world));
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
   EXPECT_TRUE(verifyWrtMass(world));
 }
 
@@ -568,6 +572,7 @@ void testTwoBlocks(
 
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
   EXPECT_TRUE(verifyWrtMass(world));
 }
 
@@ -676,6 +681,9 @@ void testBouncingBlockWithFrictionCoeff(s_t frictionCoeff, s_t mass)
 
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
+  EXPECT_TRUE(verifyBackpropBatch(world));
+  EXPECT_TRUE(verifyJacobianCacheBudget(world));
 }
 
 #ifdef ALL_TESTS
@@ -799,6 +807,7 @@ void testReversePendulumSledWithFrictionCoeff(s_t frictionCoeff)
   EXPECT_TRUE(verifyAnalyticalJacobians(world));
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
   EXPECT_TRUE(verifyWrtMass(world));
 }
 
@@ -1034,6 +1043,7 @@ void testMultigroup(int numGroups)
 
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
 }
 
 #ifdef ALL_TESTS
@@ -1211,6 +1221,7 @@ void testRobotArm(
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalJacobians(world));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
   EXPECT_TRUE(verifyWrtMass(world));
 
   // while (server.isServing())
@@ -1308,6 +1319,9 @@ void testCartpole(s_t rotationRadians)
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyWrtMass(world));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
+  EXPECT_TRUE(verifyBackpropBatch(world));
+  EXPECT_TRUE(verifyJacobianCacheBudget(world));
   EXPECT_TRUE(verifyGradientBackprop(world, 20, [](WorldPtr world) {
     Eigen::VectorXs pos = world->getPositions();
     Eigen::VectorXs vel = world->getVelocities();
@@ -1334,6 +1348,7 @@ TEST(GRADIENTS, EMPTY_WORLD)
   VectorXs worldVel = world->getVelocities();
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
 }
 
 TEST(GRADIENTS, EMPTY_SKELETON)
@@ -1344,6 +1359,7 @@ TEST(GRADIENTS, EMPTY_SKELETON)
   VectorXs worldVel = world->getVelocities();
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
 }
 #endif
 
@@ -1679,6 +1695,9 @@ void testFreeBlockWithFrictionCoeff(
   EXPECT_TRUE(verifyAnalyticalJacobians(world));
   EXPECT_TRUE(verifyVelGradients(world, worldVel));
   EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyAnalyticalJvp(world));
+  EXPECT_TRUE(verifyBackpropBatch(world));
+  EXPECT_TRUE(verifyJacobianCacheBudget(world));
   EXPECT_TRUE(verifyWrtMass(world));
   EXPECT_TRUE(verifyPosGradients(world, 1, 1e-8));
 }
@@ -582,6 +582,69 @@ TEST(MetaSkeleton, Group)
     EXPECT_EQ(group->getDof(i), dofs[i]);
 }
 
+//==============================================================================
+void checkGroupJacobians(const GroupPtr& group, const SkeletonPtr& skel)
+{
+  for(std::size_t i=0; i < skel->getNumBodyNodes(); ++i)
+  {
+    const BodyNode* bn = skel->getBodyNode(i);
+    const math::Jacobian J_skel = skel->getWorldJacobian(bn);
+    const math::Jacobian J_group = group->getWorldJacobian(bn);
+    ASSERT_EQ(J_group.cols(), static_cast<int>(group->getNumDofs()));
+
+    for(std::size_t j=0; j < group->getNumDofs(); ++j)
+    {
+      const DegreeOfFreedom* dof = group->getDof(j);
+      EXPECT_TRUE(
+          equals(J_group.col(j), J_skel.col(skel->getIndexOf(dof)), 1e-12));
+    }
+  }
+
+  math::LinearJacobian J_com = math::LinearJacobian::Zero(3, group->getNumDofs());
+  s_t totalMass = 0.0;
+  for(std::size_t i=0; i < group->getNumBodyNodes(); ++i)
+  {
+    const BodyNode* bn = group->getBodyNode(i);
+    const math::LinearJacobian J_bn = bn->getLinearJacobian(bn->getLocalCOM());
+    totalMass += bn->getMass();
+    for(std::size_t j=0; j < bn->getNumDependentDofs(); ++j)
+    {
+      std::size_t index = group->getIndexOf(bn->getDependentDof(j), false);
+      if(index != INVALID_INDEX)
+        J_com.col(index) += bn->getMass() * J_bn.col(j);
+    }
+  }
+  J_com /= totalMass;
+  EXPECT_TRUE(equals(group->getCOMLinearJacobian(), J_com, 1e-12));
+}
+
+//==============================================================================
+TEST(MetaSkeleton, GroupJacobiansFollowMembershipChanges)
+{
+  SkeletonPtr skel = constructLinkageTestSkeleton();
+  Eigen::VectorXs q = Eigen::VectorXs::Random(skel->getNumDofs());
+  skel->setPositions(q);
+
+  // Take every other DegreeOfFreedom, so the columns get shuffled around
+  GroupPtr group = Group::create("jacobian_group");
+  for(std::size_t i=0; i < skel->getNumBodyNodes(); ++i)
+    group->addBodyNode(skel->getBodyNode(i), false);
+  const std::size_t nDofs = skel->getNumDofs();
+  for(std::size_t i=0; i < nDofs; i += 2)
+    group->addDof(skel->getDof(nDofs-1-i), false, false);
+
+  checkGroupJacobians(group, skel);
+  // Calling again uses the cached column maps
+  checkGroupJacobians(group, skel);
+
+  // Dropping a DegreeOfFreedom re-indexes the ones after it
+  group->removeDof(group->getDof(0), false, false);
+  checkGroupJacobians(group, skel);
+
+  group->addDof(skel->getDof(0), false, false);
+  checkGroupJacobians(group, skel);
+}
+
 //==============================================================================
 TEST(MetaSkeleton, LockSkeletonMutexesWithLockGuard)
 {
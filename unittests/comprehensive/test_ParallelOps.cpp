@@ -39,6 +39,7 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
+#include "dart/common/ThreadPool.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -52,6 +53,8 @@
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
+#include "dart/neural/WorldBatch.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
@@ -413,6 +416,11 @@ TEST(TRAJECTORY, JUMP_WORM)
   MultiShot shot2(world, lossFn, 200, 20, false);
   shot2.setParallelOperationsEnabled(true);
   shot2.addMapping("ik", ikMap);
+  // The 10 shots share at most one world clone per pool worker
+  EXPECT_GE(shot2.getNumParallelWorlds(), 1);
+  EXPECT_LE(
+      shot2.getNumParallelWorlds(),
+      (int)common::ThreadPool::getGlobal().getNumThreads());
 
   IPOptOptimizer optimizer = IPOptOptimizer();
 
@@ -820,4 +828,184 @@ TEST(TRAJECTORY, JUMP_WORM)
       std::cout << "Off on force-vel Jac at step " << i << std::endl;
     }
   }
-}
\ No newline at end of file
+}
+TEST(WORLD_BATCH, MATCHES_SERIAL_FORWARD_PASS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  pair.second->setMass(2.0);
+  pair.first->setControlForceUpperLimit(0, 100.0);
+  pair.first->setControlForceLowerLimit(0, -100.0);
+  pair.first->setControlForceUpperLimit(1, 100.0);
+  pair.first->setControlForceLowerLimit(1, -100.0);
+  world->addSkeleton(box);
+
+  const int NUM_WORLDS = 8;
+  WorldBatch batch(world, NUM_WORLDS);
+  EXPECT_EQ(batch.getNumWorlds(), NUM_WORLDS);
+  EXPECT_EQ(batch.getStateSize(), world->getStateSize());
+  EXPECT_EQ(batch.getActionSize(), world->getActionSize());
+
+  Eigen::MatrixXs states
+      = Eigen::MatrixXs::Random(world->getStateSize(), NUM_WORLDS);
+  Eigen::MatrixXs actions
+      = Eigen::MatrixXs::Random(world->getActionSize(), NUM_WORLDS);
+  Eigen::MatrixXs lossGrads
+      = Eigen::MatrixXs::Random(world->getStateSize(), NUM_WORLDS);
+
+  BatchForwardPassResult result = batch.forwardPass(states, actions);
+  ASSERT_EQ(result.snapshots.size(), NUM_WORLDS);
+  EXPECT_TRUE(equals(result.nextStates, batch.getStates(), 0.0));
+
+  BatchLossGradient grads = batch.backpropState(result.snapshots, lossGrads);
+
+  // The batch should be exactly equivalent to stepping clones one at a time
+  for (int i = 0; i < NUM_WORLDS; i++)
+  {
+    WorldPtr serial = world->clone();
+    serial->setState(states.col(i));
+    serial->setAction(actions.col(i));
+    std::shared_ptr<BackpropSnapshot> snapshot = neural::forwardPass(serial);
+    Eigen::VectorXs nextState = serial->getState();
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(result.nextStates.col(i)), nextState, 0.0));
+
+    LossGradientHighLevelAPI grad
+        = snapshot->backpropState(serial, lossGrads.col(i));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(grads.lossWrtState.col(i)), grad.lossWrtState, 0.0));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(grads.lossWrtAction.col(i)), grad.lossWrtAction, 0.0));
+  }
+
+  // Plain stepping should give the same next states as the forward pass
+  Eigen::MatrixXs stepped = batch.step(states, actions);
+  EXPECT_TRUE(equals(stepped, result.nextStates, 1e-12));
+}
+
+TEST(WORLD_BATCH, PER_WORLD_MASSES)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  pair.second->setMass(2.0);
+  pair.first->setControlForceUpperLimit(0, 100.0);
+  pair.first->setControlForceLowerLimit(0, -100.0);
+  pair.first->setControlForceUpperLimit(1, 100.0);
+  pair.first->setControlForceLowerLimit(1, -100.0);
+  world->addSkeleton(box);
+  world->tuneMass(
+      pair.second,
+      WrtMassBodyNodeEntryType::INERTIA_MASS,
+      Eigen::VectorXs::Ones(1) * 5.0,
+      Eigen::VectorXs::Ones(1) * 0.2);
+
+  const int NUM_WORLDS = 4;
+  WorldBatch batch(world, NUM_WORLDS);
+  Eigen::MatrixXs states
+      = Eigen::MatrixXs::Random(world->getStateSize(), NUM_WORLDS);
+  Eigen::MatrixXs actions
+      = Eigen::MatrixXs::Random(world->getActionSize(), NUM_WORLDS);
+  Eigen::MatrixXs masses(1, NUM_WORLDS);
+  masses << 0.5, 1.0, 2.0, 4.0;
+  Eigen::MatrixXs lossGrads
+      = Eigen::MatrixXs::Random(world->getStateSize(), NUM_WORLDS);
+
+  BatchForwardPassResult result = batch.forwardPass(states, actions, masses);
+  BatchLossGradient grads = batch.backpropState(result, lossGrads);
+  ASSERT_EQ(grads.lossWrtMass.rows(), 1);
+  ASSERT_EQ(grads.lossWrtMass.cols(), NUM_WORLDS);
+
+  for (int i = 0; i < NUM_WORLDS; i++)
+  {
+    WorldPtr serial = world->clone();
+    serial->setMasses(masses.col(i));
+    serial->setState(states.col(i));
+    serial->setAction(actions.col(i));
+    std::shared_ptr<BackpropSnapshot> snapshot = neural::forwardPass(serial);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(result.nextStates.col(i)), serial->getState(), 0.0));
+
+    LossGradientHighLevelAPI grad
+        = snapshot->backpropState(serial, lossGrads.col(i));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(grads.lossWrtState.col(i)), grad.lossWrtState, 0.0));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(grads.lossWrtMass.col(i)), grad.lossWrtMass, 0.0));
+  }
+}
+
+WorldPtr createSeparatedBoxes(int numBoxes)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3s(100.0, 1.0, 100.0)));
+  world->addSkeleton(floor);
+
+  for (int i = 0; i < numBoxes; i++)
+  {
+    // Boxes are spaced far enough apart that each one ends up in its own
+    // constrained group
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<FreeJoint*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<FreeJoint>(nullptr);
+    pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3s(0.5, 0.5, 0.5)));
+    pair.second->setFrictionCoeff(0.5);
+    box->setPosition(3, -10.0 + 3.0 * i);
+    box->setPosition(4, 0.749);
+    box->setVelocity(3, 0.1 * i);
+    world->addSkeleton(box);
+  }
+  return world;
+}
+
+TEST(CONSTRAINED_GROUPS, PARALLEL_MATCHES_SERIAL)
+{
+  WorldPtr serial = createSeparatedBoxes(6);
+  WorldPtr parallel = createSeparatedBoxes(6);
+  parallel->getConstraintSolver()->setParallelConstrainedGroups(true);
+
+  // Gradients off
+  for (int i = 0; i < 20; i++)
+  {
+    serial->step();
+    parallel->step();
+    EXPECT_EQ(
+        serial->getConstraintSolver()->getNumConstrainedGroups(),
+        parallel->getConstraintSolver()->getNumConstrainedGroups());
+    EXPECT_TRUE(equals(serial->getState(), parallel->getState(), 0.0));
+  }
+  EXPECT_EQ(parallel->getConstraintSolver()->getNumConstrainedGroups(), 6);
+
+  // Gradients on, which also builds the gradient matrices in parallel
+  for (int i = 0; i < 5; i++)
+  {
+    std::shared_ptr<BackpropSnapshot> serialSnapshot
+        = neural::forwardPass(serial);
+    std::shared_ptr<BackpropSnapshot> parallelSnapshot
+        = neural::forwardPass(parallel);
+    EXPECT_TRUE(equals(serial->getState(), parallel->getState(), 1e-10));
+    EXPECT_TRUE(equals(
+        serialSnapshot->getVelVelJacobian(serial),
+        parallelSnapshot->getVelVelJacobian(parallel),
+        1e-10));
+  }
+}
@@ -32,6 +32,7 @@
 
 #include <chrono>
 #include <iostream>
+#include <sstream>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -97,6 +98,57 @@ TEST(PROTO, SERIALIZE_MATRIX)
   EXPECT_TRUE(equals(original, recovered, 0.0));
 }
 
+TEST(PROTO, DESERIALIZE_LEGACY_MATRIX)
+{
+  // Messages written before `data` existed only have `values`
+  Eigen::MatrixXs original = Eigen::MatrixXs::Random(3, 4);
+  proto::MatrixXs proto;
+  proto.set_rows(original.rows());
+  proto.set_cols(original.cols());
+  for (int col = 0; col < original.cols(); col++)
+  {
+    for (int row = 0; row < original.rows(); row++)
+    {
+      proto.add_values(static_cast<double>(original(row, col)));
+    }
+  }
+  EXPECT_TRUE(equals(original, deserializeMatrix(proto), 0.0));
+
+  // Blocks of a bigger matrix serialize the same as a copy of that block
+  Eigen::MatrixXs big = Eigen::MatrixXs::Random(3, 10);
+  proto::MatrixXs block;
+  serializeMatrix(block, big.middleCols(2, 4));
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(big.middleCols(2, 4)), deserializeMatrix(block), 0.0));
+}
+
+TEST(PROTO, SERIALIZE_QUANTIZED_MATRIX)
+{
+  // A smooth trajectory, which is what quantization is designed for
+  Eigen::MatrixXs original = Eigen::MatrixXs::Zero(4, 50);
+  for (int col = 0; col < original.cols(); col++)
+  {
+    for (int row = 0; row < original.rows(); row++)
+    {
+      original(row, col) = 3.0 * sin(0.1 * col + row) - row;
+    }
+  }
+  const s_t precision = 1e-4;
+  proto::QuantizedMatrixXs quantized;
+  serializeQuantizedMatrix(quantized, original, precision);
+  Eigen::MatrixXs recovered = deserializeQuantizedMatrix(quantized);
+
+  EXPECT_EQ(recovered.rows(), original.rows());
+  EXPECT_EQ(recovered.cols(), original.cols());
+  // Rounding errors shouldn't accumulate along a row
+  EXPECT_LE(
+      (original - recovered).cwiseAbs().maxCoeff(), precision / 2 + 1e-12);
+
+  proto::MatrixXs full;
+  serializeMatrix(full, original);
+  EXPECT_LT(quantized.ByteSizeLong() * 3, full.ByteSizeLong());
+}
+
 TEST(PROTO, SERIALIZE_ROLLOUT)
 {
   int dofs = 5;
@@ -156,4 +208,49 @@ TEST(PROTO, SERIALIZE_ROLLOUT)
       equals(rollout.getMetadata("2"), recovered.getMetadata("2"), 0.0));
   EXPECT_TRUE(
       equals(rollout.getMetadata("3"), recovered.getMetadata("3"), 0.0));
-}
\ No newline at end of file
+}
+
+TEST(PROTO, SERIALIZE_ROLLOUT_STREAM)
+{
+  int dofs = 3;
+  int steps = 25;
+
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  Eigen::VectorXs mass = Eigen::VectorXs::Random(dofs);
+  std::unordered_map<std::string, Eigen::MatrixXs> metadata;
+
+  pos["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  pos["mapped"] = Eigen::MatrixXs::Random(dofs + 1, steps);
+  vel["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  vel["mapped"] = Eigen::MatrixXs::Random(dofs + 1, steps);
+  force["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  force["mapped"] = Eigen::MatrixXs::Random(dofs + 1, steps);
+  metadata["1"] = Eigen::MatrixXs::Random(2, 2);
+
+  TrajectoryRolloutReal rollout
+      = TrajectoryRolloutReal(pos, vel, force, mass, metadata);
+
+  // A chunk size that doesn't divide the steps evenly, so the last chunk is
+  // short
+  std::stringstream stream;
+  EXPECT_TRUE(rollout.serializeToStream(stream, 7));
+  TrajectoryRolloutReal recovered
+      = trajectory::TrajectoryRollout::deserializeFromStream(stream);
+
+  EXPECT_TRUE(equals(rollout.getMassesConst(), recovered.getMassesConst()));
+  for (std::string mapping : {"identity", "mapped"})
+  {
+    EXPECT_TRUE(equals(
+        rollout.getPosesConst(mapping), recovered.getPosesConst(mapping), 0.0));
+    EXPECT_TRUE(equals(
+        rollout.getVelsConst(mapping), recovered.getVelsConst(mapping), 0.0));
+    EXPECT_TRUE(equals(
+        rollout.getControlForcesConst(mapping),
+        recovered.getControlForcesConst(mapping),
+        0.0));
+  }
+  EXPECT_TRUE(
+      equals(rollout.getMetadata("1"), recovered.getMetadata("1"), 0.0));
+}
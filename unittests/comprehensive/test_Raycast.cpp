@@ -41,20 +41,24 @@
 using namespace dart;
 
 //==============================================================================
-void testBasicInterface(const std::shared_ptr<CollisionDetector>& cd)
+bool supportsRaycast(const std::shared_ptr<CollisionDetector>& cd)
 {
 #if HAVE_BULLET
-  if (cd->getType() != collision::BulletCollisionDetector::getStaticType())
+  if (cd->getType() == collision::BulletCollisionDetector::getStaticType())
+    return true;
+#endif
+  return cd->getType() == DARTCollisionDetector::getStaticType();
+}
+
+//==============================================================================
+void testBasicInterface(const std::shared_ptr<CollisionDetector>& cd)
+{
+  if (!supportsRaycast(cd))
   {
-    dtwarn << "Aborting test: distance check is not supported by "
-           << cd->getType() << ".\n";
+    dtwarn << "Aborting test: raycast is not supported by " << cd->getType()
+           << ".\n";
     return;
   }
-#else
-  dtwarn << "Aborting test: distance check is not supported by "
-         << cd->getType() << ".\n";
-  return;
-#endif
 
   auto simpleFrame1 = SimpleFrame::createShared(Frame::World());
 
@@ -130,18 +134,12 @@ TEST(Distance, testBasicInterface)
 //==============================================================================
 void testOptions(const std::shared_ptr<CollisionDetector>& cd)
 {
-#if HAVE_BULLET
-  if (cd->getType() != collision::BulletCollisionDetector::getStaticType())
+  if (!supportsRaycast(cd))
   {
-    dtwarn << "Aborting test: distance check is not supported by "
-           << cd->getType() << ".\n";
+    dtwarn << "Aborting test: raycast is not supported by " << cd->getType()
+           << ".\n";
     return;
   }
-#else
-  dtwarn << "Aborting test: distance check is not supported by "
-         << cd->getType() << ".\n";
-  return;
-#endif
 
   auto simpleFrame1 = SimpleFrame::createShared(Frame::World());
   auto shape1 = std::make_shared<SphereShape>(1.0);
@@ -208,3 +206,58 @@ TEST(Distance, testOptions)
   auto dart = DARTCollisionDetector::create();
   testOptions(dart);
 }
+
+//==============================================================================
+TEST(Raycast, BATCH_MATCHES_SINGLE_RAYS)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  std::vector<std::shared_ptr<SimpleFrame>> frames;
+  std::vector<ShapePtr> shapes;
+  shapes.push_back(std::make_shared<SphereShape>(0.5));
+  shapes.push_back(std::make_shared<BoxShape>(Eigen::Vector3s(0.4, 0.8, 1.2)));
+  shapes.push_back(std::make_shared<CapsuleShape>(0.3, 0.9));
+  shapes.push_back(
+      std::make_shared<EllipsoidShape>(Eigen::Vector3s(0.6, 1.0, 1.4)));
+  auto group = cd->createCollisionGroup();
+  srand(42);
+  for (int i = 0; i < 40; i++)
+  {
+    auto frame = SimpleFrame::createShared(Frame::World());
+    frame->setShape(shapes[i % shapes.size()]);
+    Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+    T.translation() = Eigen::Vector3s::Random() * 4;
+    T.linear() = math::expMapRot(Eigen::Vector3s::Random());
+    frame->setTransform(T);
+    group->addShapeFrame(frame.get());
+    frames.push_back(frame);
+  }
+
+  const int numRays = 1000;
+  Eigen::MatrixXs origins = Eigen::MatrixXs::Random(3, numRays) * 6;
+  Eigen::MatrixXs directions = Eigen::MatrixXs::Random(3, numRays) * 10;
+  collision::RaycastBatchResult batch
+      = group->raycastBatch(origins, directions);
+  ASSERT_EQ(numRays, batch.mDistances.size());
+
+  int numHits = 0;
+  for (int i = 0; i < numRays; i++)
+  {
+    collision::RaycastResult result;
+    group->raycast(
+        origins.col(i),
+        origins.col(i) + directions.col(i),
+        collision::RaycastOption(),
+        &result);
+    EXPECT_EQ(result.hasHit(), batch.hasHit(i));
+    if (!result.hasHit() || !batch.hasHit(i))
+      continue;
+    numHits++;
+    const RayHit& hit = result.mRayHits[0];
+    EXPECT_NEAR(
+        hit.mFraction * directions.col(i).norm(), batch.mDistances(i), 1e-10);
+    EXPECT_TRUE(equals(hit.mNormal, Eigen::Vector3s(batch.mNormals.col(i))));
+    EXPECT_EQ(hit.mCollisionObject, batch.mCollisionObjects[i]);
+  }
+  EXPECT_GT(numHits, 0);
+}
@@ -42,8 +42,11 @@
 
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/realtime/MPC.hpp"
+#include "dart/realtime/MPCHost.hpp"
 #include "dart/realtime/MPCLocal.hpp"
 #include "dart/realtime/MPCRemote.hpp"
+#include "dart/realtime/MPCSampling.hpp"
+#include "dart/realtime/Millis.hpp"
 #include "dart/realtime/SSID.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -1411,4 +1414,135 @@ TEST(REALTIME, CARTPOLE_COM_PLOT)
     solutionMat.row(i) = solutions[i];
   }
   ssid.saveCSVMatrix("/workspaces/nimblephysics/dart/realtime/saved_data/raw_data/Solutions.csv",solutionMat);
-}
\ No newline at end of file
+}
+
+#ifdef ALL_TESTS
+TEST(REALTIME, SLED_MPC_SAMPLING)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  world->setTimeStep(1.0 / 100);
+
+  SkeletonPtr sled = Skeleton::create("sled");
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3s(1, 0, 0));
+  sledPair.second->setMass(1.0);
+  world->addSkeleton(sled);
+  sled->setControlForceUpperLimit(0, 20);
+  sled->setControlForceLowerLimit(0, -20);
+
+  s_t goalX = 1.0;
+  TrajectoryLossFn loss = [&goalX](const TrajectoryRollout* rollout) {
+    int steps = rollout->getPosesConst().cols();
+    s_t sum = 0.0;
+    for (int i = 0; i < steps; i++)
+    {
+      s_t xPos = rollout->getPosesConst()(0, i);
+      sum += (goalX - xPos) * (goalX - xPos);
+    }
+    return sum;
+  };
+  std::shared_ptr<LossFn> lossFn = std::make_shared<LossFn>(loss);
+
+  for (auto method : {MPCSampling::SamplingMethod::MPPI,
+                      MPCSampling::SamplingMethod::CEM})
+  {
+    MPCSampling mpc(world, lossFn, 500);
+    mpc.setSilent(true);
+    mpc.setSeed(42);
+    mpc.setNumSamples(64);
+    mpc.setNoiseStdDev(Eigen::VectorXs::Ones(1) * 5.0);
+    mpc.setTemperature(0.1);
+    mpc.setSamplingMethod(method);
+    if (method == MPCSampling::SamplingMethod::CEM)
+      mpc.setNumIterations(3);
+
+    std::vector<s_t> losses;
+    mpc.registerReplanningListener(
+        [&](long, const TrajectoryRollout* rollout, long) {
+          losses.push_back(lossFn->getLoss(rollout));
+        });
+
+    // Replanning for the same instant just keeps improving the same plan
+    long now = timeSinceEpochMillis();
+    for (int i = 0; i < 5; i++)
+    {
+      mpc.optimizePlan(now);
+    }
+
+    ASSERT_EQ(losses.size(), 5);
+    // The zero plan leaves the sled at 0 for all 50 steps
+    EXPECT_LT(losses.back(), 0.5 * 50 * goalX * goalX);
+    EXPECT_LT(losses.back(), losses[0]);
+    EXPECT_TRUE(mpc.getControlForce(now).allFinite());
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, MPC_HOST_SHARES_WORKERS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  world->setTimeStep(1.0 / 100);
+
+  SkeletonPtr sled = Skeleton::create("sled");
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3s(1, 0, 0));
+  sledPair.second->setMass(1.0);
+  world->addSkeleton(sled);
+  sled->setControlForceUpperLimit(0, 20);
+  sled->setControlForceLowerLimit(0, -20);
+
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return (rollout->getPosesConst().array() - 1.0).square().sum();
+  };
+  std::shared_ptr<LossFn> lossFn = std::make_shared<LossFn>(loss);
+
+  // Three controllers on a single worker have to take turns
+  MPCHost host(1);
+  std::vector<int> ids;
+  for (int i = 0; i < 3; i++)
+  {
+    std::shared_ptr<MPCSampling> mpc
+        = std::make_shared<MPCSampling>(world->clone(), lossFn, 500);
+    mpc->setSilent(true);
+    mpc->setSeed(i);
+    mpc->setNumSamples(16);
+    ids.push_back(host.addController(mpc, 1000));
+  }
+  EXPECT_EQ(host.getNumControllers(), 3);
+  EXPECT_EQ(host.getDeadlineMillis(ids[1]), 1000);
+
+  host.start();
+  for (int id : ids)
+  {
+    host.startController(id);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  for (int id : ids)
+  {
+    host.stopController(id);
+  }
+  host.stop();
+
+  // Whoever has the least plan left goes next, so nobody gets starved
+  int minReplans = host.getNumReplans(ids[0]);
+  int maxReplans = host.getNumReplans(ids[0]);
+  for (int id : ids)
+  {
+    EXPECT_FALSE(host.isControllerRunning(id));
+    EXPECT_EQ(host.getNumMissedDeadlines(id), 0);
+    minReplans = std::min(minReplans, host.getNumReplans(id));
+    maxReplans = std::max(maxReplans, host.getNumReplans(id));
+  }
+  EXPECT_GT(minReplans, 0);
+  EXPECT_LE(maxReplans - minReplans, 1);
+
+  host.removeController(ids[0]);
+  EXPECT_EQ(host.getNumControllers(), 2);
+  EXPECT_EQ(host.getController(ids[0]), nullptr);
+}
+#endif
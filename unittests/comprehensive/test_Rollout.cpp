@@ -0,0 +1,255 @@
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/TranslationalJoint2D.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/ForwardPassCache.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/neural/Rollout.hpp"
+#include "dart/neural/WorldStatePool.hpp"
+#include "dart/simulation/World.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+using namespace neural;
+
+/// This makes a 2D box that falls onto a floor, so the rollout goes through
+/// contact
+WorldPtr createFallingBox()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3s(0.1, 0.1, 0.1)));
+  pair.first->setControlForceUpperLimit(0, 100.0);
+  pair.first->setControlForceLowerLimit(0, -100.0);
+  pair.first->setControlForceUpperLimit(1, 100.0);
+  pair.first->setControlForceLowerLimit(1, -100.0);
+  world->addSkeleton(box);
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3s floorOffset = Eigen::Isometry3s::Identity();
+  floorOffset.translation() = Eigen::Vector3s(0, -0.1, 0);
+  floorPair.first->setTransformFromParentBodyNode(floorOffset);
+  floorPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3s(2.0, 0.1, 1.0)));
+  world->addSkeleton(floor);
+
+  return world;
+}
+
+/// The loss is the sum of squared states, so dLoss/dState = 2 * state
+Eigen::MatrixXs squaredStatesGrad(const Eigen::MatrixXs& states)
+{
+  return 2 * states;
+}
+
+//==============================================================================
+TEST(ROLLOUT, MATCHES_STEP_BY_STEP_BACKPROP)
+{
+  WorldPtr world = createFallingBox();
+  const int steps = 20;
+  Eigen::VectorXs startState = Eigen::VectorXs::Zero(world->getStateSize());
+  startState(1) = 0.02;
+  Eigen::MatrixXs actions
+      = Eigen::MatrixXs::Random(world->getActionSize(), steps);
+
+  RolloutGradient fused = rolloutAndBackprop(
+      world, startState, actions, squaredStatesGrad);
+
+  // Do the same thing one step at a time
+  WorldPtr serial = createFallingBox();
+  serial->setState(startState);
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots;
+  Eigen::MatrixXs states(serial->getStateSize(), steps);
+  for (int t = 0; t < steps; t++)
+  {
+    serial->setAction(actions.col(t));
+    snapshots.push_back(neural::forwardPass(serial));
+    states.col(t) = serial->getState();
+  }
+  EXPECT_TRUE(equals(fused.states, states, 0));
+  EXPECT_TRUE(equals(world->getState(), serial->getState(), 0));
+
+  Eigen::MatrixXs lossWrtStates = squaredStatesGrad(states);
+  Eigen::VectorXs stateGrad = Eigen::VectorXs::Zero(serial->getStateSize());
+  for (int t = steps - 1; t >= 0; t--)
+  {
+    stateGrad += lossWrtStates.col(t);
+    LossGradientHighLevelAPI grad
+        = snapshots[t]->backpropState(serial, stateGrad);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(fused.lossWrtActions.col(t)),
+        grad.lossWrtAction,
+        1e-12));
+    stateGrad = grad.lossWrtState;
+  }
+  EXPECT_TRUE(equals(fused.lossWrtStartState, stateGrad, 1e-12));
+}
+
+//==============================================================================
+TEST(ROLLOUT, CHECKPOINTING_MATCHES_FULL_STORAGE)
+{
+  const int steps = 23;
+  Eigen::MatrixXs actions
+      = Eigen::MatrixXs::Random(createFallingBox()->getActionSize(), steps);
+
+  WorldPtr world = createFallingBox();
+  Eigen::VectorXs startState = Eigen::VectorXs::Zero(world->getStateSize());
+  startState(1) = 0.02;
+  RolloutGradient full = rolloutAndBackprop(
+      world, startState, actions, squaredStatesGrad);
+
+  // 5 doesn't divide 23, so the last segment is a short one
+  for (int checkpointEvery : {1, 5, 23})
+  {
+    WorldPtr checkpointed = createFallingBox();
+    RolloutGradient grad = rolloutAndBackprop(
+        checkpointed, startState, actions, squaredStatesGrad, checkpointEvery);
+    EXPECT_TRUE(equals(grad.states, full.states, 0));
+    EXPECT_TRUE(equals(grad.lossWrtActions, full.lossWrtActions, 1e-12));
+    EXPECT_TRUE(equals(grad.lossWrtStartState, full.lossWrtStartState, 1e-12));
+    EXPECT_TRUE(equals(checkpointed->getState(), world->getState(), 0));
+  }
+}
+
+//==============================================================================
+TEST(ROLLOUT, WORLD_STATE_POOL_RESTORES_STATE)
+{
+  WorldPtr world = createFallingBox();
+  Eigen::VectorXs startState = Eigen::VectorXs::Zero(world->getStateSize());
+  startState(1) = 0.02;
+  world->setState(startState);
+  world->setControlForces(Eigen::VectorXs::Ones(world->getNumDofs()));
+
+  WorldStatePool pool(world, 2);
+  EXPECT_EQ(pool.getNumSlots(), 2);
+  pool.saveInto(0);
+  Eigen::VectorXs masses = world->getLinkMasses();
+  Eigen::VectorXs forces = world->getControlForces();
+
+  // Land on the floor, so there's a cached LCP solution, and change the mass
+  for (int i = 0; i < 10; i++)
+  {
+    world->step();
+  }
+  world->getSkeleton(0)->getBodyNode(0)->setMass(2.0);
+  pool.saveInto(1);
+  Eigen::VectorXs landedState = world->getState();
+  Eigen::VectorXs landedLCPCache = world->getCachedLCPSolution();
+  EXPECT_FALSE(pool.isPreserved(0));
+  EXPECT_TRUE(pool.isPreserved(1));
+
+  pool.restoreFrom(0);
+  EXPECT_TRUE(pool.isPreserved(0));
+  EXPECT_TRUE(equals(world->getState(), startState, 0));
+  EXPECT_TRUE(equals(world->getLinkMasses(), masses, 0));
+  EXPECT_TRUE(equals(world->getControlForces(), forces, 0));
+
+  pool.restoreFrom(1);
+  EXPECT_TRUE(equals(world->getState(), landedState, 0));
+  EXPECT_TRUE(equals(world->getCachedLCPSolution(), landedLCPCache, 0));
+  EXPECT_EQ(world->getSkeleton(0)->getBodyNode(0)->getMass(), 2.0);
+}
+
+//==============================================================================
+TEST(ROLLOUT, FORWARD_PASS_CACHE)
+{
+  WorldPtr world = createFallingBox();
+  world->setForwardPassCacheSize(2);
+  std::shared_ptr<ForwardPassCache> cache = world->getForwardPassCache();
+  ASSERT_TRUE(cache != nullptr);
+
+  Eigen::VectorXs startState = Eigen::VectorXs::Zero(world->getStateSize());
+  startState(1) = 0.02;
+  world->setState(startState);
+  world->setControlForces(Eigen::VectorXs::Ones(world->getNumDofs()));
+
+  std::shared_ptr<BackpropSnapshot> first = forwardPass(world, true);
+  std::shared_ptr<BackpropSnapshot> second = forwardPass(world, true);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(cache->getNumHits(), 1);
+  EXPECT_EQ(cache->getNumMisses(), 1);
+
+  // Changing the mass has to miss, even though the state is the same
+  world->getSkeleton(0)->getBodyNode(0)->setMass(2.0);
+  std::shared_ptr<BackpropSnapshot> heavier = forwardPass(world, true);
+  EXPECT_NE(first, heavier);
+  EXPECT_EQ(cache->getNumMisses(), 2);
+  world->getSkeleton(0)->getBodyNode(0)->setMass(1.0);
+
+  // A hit that isn't idempotent leaves the world where a real step would
+  WorldPtr uncached = createFallingBox();
+  uncached->setState(startState);
+  uncached->setControlForces(Eigen::VectorXs::Ones(world->getNumDofs()));
+  forwardPass(uncached, false);
+  std::shared_ptr<BackpropSnapshot> replayed = forwardPass(world, false);
+  EXPECT_EQ(first, replayed);
+  EXPECT_TRUE(equals(world->getState(), uncached->getState(), 0));
+  EXPECT_TRUE(
+      equals(world->getControlForces(), uncached->getControlForces(), 0));
+  EXPECT_EQ(world->getTime(), uncached->getTime());
+  EXPECT_EQ(world->getSimFrames(), uncached->getSimFrames());
+
+  // The least recently used entry goes first
+  EXPECT_EQ(cache->getNumEntries(), 2u);
+  forwardPass(world, true);
+  EXPECT_EQ(cache->getNumEntries(), 2u);
+  world->setState(startState);
+  world->setControlForces(Eigen::VectorXs::Ones(world->getNumDofs()));
+  forwardPass(world, true);
+  EXPECT_EQ(cache->getNumHits(), 3);
+  EXPECT_EQ(cache->getNumMisses(), 3);
+
+  world->setForwardPassCacheSize(0);
+  EXPECT_TRUE(world->getForwardPassCache() == nullptr);
+}
+
+TEST(ROLLOUT, ASYNC_STEPS_MATCH_SYNC)
+{
+  WorldPtr sync = createFallingBox();
+  WorldPtr async = createFallingBox();
+  Eigen::VectorXs startState = Eigen::VectorXs::Zero(sync->getStateSize());
+  startState(1) = 0.02;
+  for (WorldPtr world : {sync, async})
+  {
+    world->setState(startState);
+    world->setControlForces(Eigen::VectorXs::Ones(world->getNumDofs()));
+  }
+
+  std::shared_ptr<BackpropSnapshot> syncSnapshot = forwardPass(sync, false);
+  std::future<std::shared_ptr<BackpropSnapshot>> future
+      = forwardPassAsync(async, false);
+  std::shared_ptr<BackpropSnapshot> asyncSnapshot = future.get();
+  ASSERT_TRUE(asyncSnapshot != nullptr);
+  EXPECT_TRUE(equals(
+      syncSnapshot->getPostStepPosition(),
+      asyncSnapshot->getPostStepPosition(),
+      0));
+  EXPECT_TRUE(equals(sync->getState(), async->getState(), 0));
+
+  for (int i = 0; i < 5; i++)
+  {
+    sync->step();
+    async->stepAsync().get();
+  }
+  EXPECT_TRUE(equals(sync->getState(), async->getState(), 0));
+  EXPECT_EQ(sync->getSimFrames(), async->getSimFrames());
+}
@@ -5,13 +5,16 @@
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/SimpleFeatherstone.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
+#include "dart/neural/FeatherstoneWorldBatch.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
@@ -142,6 +145,220 @@ TEST(FEATHERSTONE, LINK_5)
 }
 #endif
 
+void verifySkeletonMassAndInverseDynamics(SkeletonPtr skel)
+{
+  skel->setGravity(Eigen::Vector3s::Zero());
+
+  dynamics::SimpleFeatherstone simple;
+  simple.populateFromSkeleton(skel);
+  const int n = simple.len();
+
+  for (int j = 0; j < 10; j++)
+  {
+    Eigen::VectorXs pos = Eigen::VectorXs::Random(n);
+    Eigen::VectorXs vel = Eigen::VectorXs::Random(n);
+    Eigen::VectorXs accel = Eigen::VectorXs::Random(n);
+    skel->setPositions(pos);
+    skel->setVelocities(vel);
+
+    Eigen::MatrixXs simpleMassMatrix = Eigen::MatrixXs::Zero(n, n);
+    simple.massMatrix(pos.data(), simpleMassMatrix.data());
+    EXPECT_TRUE(equals(simpleMassMatrix, skel->getMassMatrix(), 1e-10));
+
+    Eigen::VectorXs simpleCoriolis = Eigen::VectorXs::Zero(n);
+    simple.coriolisForces(pos.data(), vel.data(), simpleCoriolis.data());
+    EXPECT_TRUE(equals(simpleCoriolis, skel->getCoriolisForces(), 1e-10));
+
+    Eigen::VectorXs simpleForces = Eigen::VectorXs::Zero(n);
+    simple.inverseDynamics(
+        pos.data(), vel.data(), accel.data(), simpleForces.data());
+    EXPECT_TRUE(equals(
+        simpleForces,
+        Eigen::VectorXs(skel->getMassMatrix() * accel + simpleCoriolis),
+        1e-10));
+
+    // The specialized joint kernels should agree with the general screw one
+    dynamics::SimpleFeatherstone screwOnly = simple;
+    for (auto& jointAndBody : screwOnly.mJointsAndBodies)
+    {
+      jointAndBody.jointType = dynamics::SCREW;
+    }
+    Eigen::VectorXs specialized = Eigen::VectorXs::Zero(n);
+    Eigen::VectorXs generic = Eigen::VectorXs::Zero(n);
+    simple.forwardDynamics(
+        pos.data(), vel.data(), simpleForces.data(), specialized.data());
+    screwOnly.forwardDynamics(
+        pos.data(), vel.data(), simpleForces.data(), generic.data());
+    EXPECT_TRUE(equals(specialized, generic, 1e-12));
+    EXPECT_TRUE(equals(specialized, accel, 1e-8));
+  }
+}
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, MASS_MATRIX_AND_INVERSE_DYNAMICS)
+{
+  verifySkeletonMassAndInverseDynamics(createMultiarmRobot(5, 0.2));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, GRAVITY_FORCES)
+{
+  SkeletonPtr skel = createMultiarmRobot(5, 0.2);
+  skel->setGravity(Eigen::Vector3s(0.3, -9.81, 1.2));
+
+  dynamics::SimpleFeatherstone simple;
+  simple.populateFromSkeleton(skel);
+  const int n = simple.len();
+
+  for (int j = 0; j < 10; j++)
+  {
+    Eigen::VectorXs pos = Eigen::VectorXs::Random(n);
+    skel->setPositions(pos);
+
+    Eigen::VectorXs simpleGravity = Eigen::VectorXs::Zero(n);
+    simple.gravityForces(pos.data(), skel->getGravity(), simpleGravity.data());
+    // DART keeps gravity on the same side of the equations of motion as the
+    // mass matrix, and we keep it with the applied forces
+    EXPECT_TRUE(equals(
+        simpleGravity, Eigen::VectorXs(-skel->getGravityForces()), 1e-10));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE_BATCH, MATCHES_WORLD_WITHOUT_CONTACT)
+{
+  SkeletonPtr skel = createMultiarmRobot(5, 0.2);
+  std::shared_ptr<World> world = World::create();
+  world->addSkeleton(skel);
+  world->setTimeStep(0.005);
+  const int n = skel->getNumDofs();
+  const int numWorlds = 4;
+
+  FeatherstoneWorldBatch batch(
+      skel,
+      numWorlds,
+      FeatherstoneBatchConfig()
+          .setTimeStep(world->getTimeStep())
+          .setGravity(world->getGravity())
+          .setGroundContact(false));
+  EXPECT_EQ(batch.getStateSize(), world->getStateSize());
+
+  Eigen::MatrixXs states = Eigen::MatrixXs::Random(2 * n, numWorlds);
+  Eigen::MatrixXs actions = Eigen::MatrixXs::Random(n, numWorlds);
+  Eigen::MatrixXs nextStates = Eigen::MatrixXs::Zero(2 * n, numWorlds);
+  batch.step(states, actions, nextStates);
+
+  for (int i = 0; i < numWorlds; i++)
+  {
+    world->setState(states.col(i));
+    world->setControlForces(actions.col(i));
+    world->step();
+    EXPECT_TRUE(
+        equals(Eigen::VectorXs(nextStates.col(i)), world->getState(), 1e-8));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE_BATCH, GRADIENTS)
+{
+  SkeletonPtr skel = createMultiarmRobot(3, 0.2);
+  const int n = skel->getNumDofs();
+  const int numWorlds = 3;
+  FeatherstoneWorldBatch batch(
+      skel, numWorlds, FeatherstoneBatchConfig().setGroundContact(false));
+
+  Eigen::MatrixXs states = Eigen::MatrixXs::Random(2 * n, numWorlds);
+  Eigen::MatrixXs actions = Eigen::MatrixXs::Random(n, numWorlds);
+  Eigen::MatrixXs nextStates(2 * n, numWorlds);
+  std::shared_ptr<FeatherstoneBatchTape> tape
+      = batch.forwardPass(states, actions, nextStates);
+
+  // Check the recorded Jacobians against central differences of step()
+  const s_t eps = 1e-6;
+  Eigen::MatrixXs plus(2 * n, numWorlds);
+  Eigen::MatrixXs minus(2 * n, numWorlds);
+  for (int k = 0; k < 2 * n; k++)
+  {
+    Eigen::MatrixXs perturbed = states;
+    perturbed.row(k).array() += eps;
+    batch.step(perturbed, actions, plus);
+    perturbed.row(k).array() -= 2 * eps;
+    batch.step(perturbed, actions, minus);
+    for (int i = 0; i < numWorlds; i++)
+    {
+      Eigen::VectorXs bruteForce = (plus.col(i) - minus.col(i)) / (2 * eps);
+      EXPECT_TRUE(equals(
+          Eigen::VectorXs(tape->stateJacobians.col(i * 2 * n + k)),
+          bruteForce,
+          1e-6));
+    }
+  }
+  for (int k = 0; k < n; k++)
+  {
+    Eigen::MatrixXs perturbed = actions;
+    perturbed.row(k).array() += eps;
+    batch.step(states, perturbed, plus);
+    perturbed.row(k).array() -= 2 * eps;
+    batch.step(states, perturbed, minus);
+    for (int i = 0; i < numWorlds; i++)
+    {
+      Eigen::VectorXs bruteForce = (plus.col(i) - minus.col(i)) / (2 * eps);
+      EXPECT_TRUE(equals(
+          Eigen::VectorXs(tape->actionJacobians.col(i * n + k)),
+          bruteForce,
+          1e-6));
+    }
+  }
+
+  Eigen::MatrixXs lossWrtNextStates = Eigen::MatrixXs::Random(2 * n, numWorlds);
+  Eigen::MatrixXs lossWrtStates(2 * n, numWorlds);
+  Eigen::MatrixXs lossWrtActions(n, numWorlds);
+  batch.backpropState(
+      *tape, lossWrtNextStates, lossWrtStates, lossWrtActions);
+  for (int i = 0; i < numWorlds; i++)
+  {
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(lossWrtActions.col(i)),
+        Eigen::VectorXs(
+            tape->actionJacobians.middleCols(i * n, n).transpose()
+            * lossWrtNextStates.col(i)),
+        1e-12));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE_BATCH, BALL_RESTS_ON_GROUND)
+{
+  SkeletonPtr skel = Skeleton::create();
+  auto pair = skel->createJointAndBodyNodePair<PrismaticJoint>();
+  pair.first->setAxis(Eigen::Vector3s::UnitY());
+  pair.second->createShapeNodeWith<CollisionAspect>(
+      std::make_shared<SphereShape>(0.1));
+
+  const int numWorlds = 3;
+  FeatherstoneWorldBatch batch(skel, numWorlds);
+  EXPECT_EQ(batch.getNumContactPoints(), 1);
+
+  Eigen::MatrixXs states(2, numWorlds);
+  states << 1.0, 0.5, 0.05, 0.0, -1.0, 0.0;
+  Eigen::MatrixXs actions = Eigen::MatrixXs::Zero(1, numWorlds);
+  for (int t = 0; t < 500; t++)
+  {
+    // The next states can overwrite the states in place
+    batch.step(states, actions, states);
+  }
+  for (int i = 0; i < numWorlds; i++)
+  {
+    EXPECT_NEAR(states(0, i), 0.1, 1e-3);
+    EXPECT_NEAR(states(1, i), 0.0, 1e-3);
+  }
+}
+#endif
+
 /*
 template <class ConfigSpaceT>
 void GenericJoint<ConfigSpaceT>::addChildArtInertiaImplicitToDynamic(
@@ -30,18 +30,24 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <sstream>
 
 #include <gtest/gtest.h>
 
 #include "dart/common/sub_ptr.hpp"
+#include "dart/config.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/CompiledSkeleton.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/utils/SkelParser.hpp"
 
+#include "CompiledSkeletonTestDynamics.hpp"
 #include "TestHelpers.hpp"
 
 using namespace dart;
@@ -1050,4 +1056,485 @@ TEST(Skeleton, MultiTreeRobotImplicitMass)
   boxBody->setMass(2);
 
   EXPECT_TRUE(verifyImplicitMass(multiRootRobot));
-}
\ No newline at end of file
+}
+
+TEST(Skeleton, PartialMassMatrixUpdate)
+{
+  SkeletonPtr skel = createThreeLinkRobot(
+      Vector3s::Ones(),
+      DOF_PITCH,
+      Vector3s::Ones(),
+      DOF_ROLL,
+      Vector3s::Ones(),
+      DOF_YAW);
+
+  // Give the middle link a second child, so the tree branches
+  BodyNode* middle = skel->getBodyNode(1);
+  std::pair<RevoluteJoint*, BodyNode*> branch
+      = skel->createJointAndBodyNodePair<RevoluteJoint>(middle);
+  branch.first->setAxis(Vector3s::UnitX());
+  Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+  offset.translation() = Vector3s(0.3, 0.5, 0);
+  branch.first->setTransformFromParentBodyNode(offset);
+  branch.second->setMass(0.7);
+
+  // And a separate tree
+  std::pair<TranslationalJoint2D*, BodyNode*> box
+      = skel->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  box.first->setXYPlane();
+  box.second->setMass(2);
+
+  skel->setPositions(VectorXs::Random(skel->getNumDofs()));
+  skel->getMassMatrix();
+
+  for (int iter = 0; iter < 3; iter++)
+  {
+    for (std::size_t i = 0; i < skel->getNumDofs(); i++)
+    {
+      // Moving one DOF should only recompute part of its tree
+      skel->getDof(i)->setPosition(skel->getDof(i)->getPosition() + 0.3);
+      const Eigen::MatrixXs partial = skel->getMassMatrix();
+
+      for (std::size_t tree = 0; tree < skel->getNumTrees(); tree++)
+        skel->dirtyArticulatedInertia(tree);
+      const Eigen::MatrixXs full = skel->getMassMatrix();
+
+      EXPECT_TRUE(equals(partial, full, 1e-12));
+    }
+  }
+}
+
+//==============================================================================
+TEST(Skeleton, MixedJointDispatch)
+{
+  // A branching tree with every kind of joint the dispatch table batches on,
+  // several of them on the same level
+  SkeletonPtr skel = Skeleton::create();
+  BodyNode* root
+      = skel->createJointAndBodyNodePair<FreeJoint>(nullptr).second;
+  BodyNode* ball = skel->createJointAndBodyNodePair<BallJoint>(root).second;
+  BodyNode* revolute
+      = skel->createJointAndBodyNodePair<RevoluteJoint>(root).second;
+  BodyNode* weld = skel->createJointAndBodyNodePair<WeldJoint>(root).second;
+  skel->createJointAndBodyNodePair<UniversalJoint>(ball);
+  skel->createJointAndBodyNodePair<EulerJoint>(revolute);
+  skel->createJointAndBodyNodePair<PrismaticJoint>(weld);
+  skel->createJointAndBodyNodePair<RevoluteJoint>(weld);
+
+  Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+  offset.translation() = Vector3s(0.1, 0.4, -0.2);
+  for (std::size_t i = 1; i < skel->getNumBodyNodes(); i++)
+    skel->getJoint(i)->setTransformFromParentBodyNode(offset);
+  for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    skel->getBodyNode(i)->setMass(1.0 + 0.1 * i);
+    skel->getBodyNode(i)->setLocalCOM(Vector3s(0.05 * i, 0.1, 0));
+  }
+
+  skel->setPositions(VectorXs::Random(skel->getNumDofs()));
+  skel->setVelocities(VectorXs::Random(skel->getNumDofs()));
+  VectorXs tau = VectorXs::Random(skel->getNumDofs());
+  skel->setControlForces(tau);
+
+  // Forward dynamics should agree with the mass matrix and bias forces, which
+  // don't go through the dispatch table
+  skel->computeForwardDynamics();
+  VectorXs ddq = skel->getAccelerations();
+  VectorXs expected = skel->getInvMassMatrix()
+                      * (tau - skel->getCoriolisAndGravityForces());
+  EXPECT_TRUE(equals(ddq, expected, 1e-8));
+
+  // And inverse dynamics should recover the forces we started with
+  skel->computeInverseDynamics();
+  EXPECT_TRUE(equals(skel->getControlForces(), tau, 1e-8));
+}
+
+//==============================================================================
+TEST(Skeleton, ParallelDynamicsMatchesSequential)
+{
+  // Wide enough that the second and third levels get split over threads
+  SkeletonPtr skel = Skeleton::create();
+  BodyNode* root
+      = skel->createJointAndBodyNodePair<FreeJoint>(nullptr).second;
+  Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+  for (int i = 0; i < 64; i++)
+  {
+    offset.translation() = Vector3s(0.01 * i, 0.2, -0.1);
+    auto finger = skel->createJointAndBodyNodePair<RevoluteJoint>(root);
+    finger.first->setTransformFromParentBodyNode(offset);
+    finger.first->setAxis(Vector3s(1, 0.1 * (i % 5), 0).normalized());
+    finger.second->setMass(0.5 + 0.01 * i);
+    std::pair<Joint*, BodyNode*> tip;
+    if (i % 2 == 0)
+      tip = skel->createJointAndBodyNodePair<BallJoint>(finger.second);
+    else
+      tip = skel->createJointAndBodyNodePair<PrismaticJoint>(finger.second);
+    tip.first->setTransformFromParentBodyNode(offset);
+    tip.second->setLocalCOM(Vector3s(0, 0.05, 0));
+  }
+
+  skel->setPositions(VectorXs::Random(skel->getNumDofs()));
+  skel->setVelocities(VectorXs::Random(skel->getNumDofs()));
+  skel->setControlForces(VectorXs::Random(skel->getNumDofs()));
+
+  skel->setParallelDynamics(false);
+  skel->computeForwardDynamics();
+  VectorXs sequentialAcc = skel->getAccelerations();
+  VectorXs sequentialCg = skel->getCoriolisAndGravityForces();
+  skel->computeInverseDynamics();
+  VectorXs sequentialForces = skel->getControlForces();
+
+  // Move away and back, so everything gets recomputed
+  VectorXs pos = skel->getPositions();
+  skel->setPositions(VectorXs::Zero(skel->getNumDofs()));
+  skel->setPositions(pos);
+  skel->setAccelerations(VectorXs::Zero(skel->getNumDofs()));
+  skel->setControlForces(sequentialForces);
+
+  skel->setParallelDynamics(true);
+  skel->computeForwardDynamics();
+  EXPECT_TRUE(equals(skel->getAccelerations(), sequentialAcc, 0));
+  EXPECT_TRUE(equals(skel->getCoriolisAndGravityForces(), sequentialCg, 0));
+  skel->setAccelerations(sequentialAcc);
+  skel->computeInverseDynamics();
+  EXPECT_TRUE(equals(skel->getControlForces(), sequentialForces, 0));
+}
+
+//==============================================================================
+TEST(Skeleton, CompactStorageMatchesHeap)
+{
+  SkeletonPtr skel = Skeleton::create();
+  BodyNode* root
+      = skel->createJointAndBodyNodePair<FreeJoint>(nullptr).second;
+  Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+  offset.translation() = Vector3s(0.1, 0.3, -0.2);
+  BodyNode* parent = root;
+  for (int i = 0; i < 6; i++)
+  {
+    std::pair<Joint*, BodyNode*> child;
+    if (i % 2 == 0)
+      child = skel->createJointAndBodyNodePair<BallJoint>(parent);
+    else
+      child = skel->createJointAndBodyNodePair<RevoluteJoint>(parent);
+    child.first->setTransformFromParentBodyNode(offset);
+    child.second->setMass(0.5 + 0.1 * i);
+    parent = child.second;
+  }
+  EXPECT_FALSE(skel->getCompactStorage());
+
+  skel->setCompactStorage(true);
+  SkeletonPtr compact = skel->cloneSkeleton();
+  skel->setCompactStorage(false);
+  EXPECT_TRUE(compact->getCompactStorage());
+  EXPECT_FALSE(skel->cloneSkeleton()->getCompactStorage());
+
+  // Every BodyNode and Joint comes after the ones created before it
+  for (std::size_t i = 1; i < compact->getNumBodyNodes(); i++)
+  {
+    EXPECT_LT(
+        (const char*)compact->getBodyNode(i - 1),
+        (const char*)compact->getJoint(i));
+    EXPECT_LT(
+        (const char*)compact->getJoint(i),
+        (const char*)compact->getBodyNode(i));
+  }
+
+  // New bodies go into the arena too
+  compact->createJointAndBodyNodePair<RevoluteJoint>(
+      compact->getBodyNode(compact->getNumBodyNodes() - 1));
+  skel->createJointAndBodyNodePair<RevoluteJoint>(
+      skel->getBodyNode(skel->getNumBodyNodes() - 1));
+  EXPECT_LT(
+      (const char*)compact->getBodyNode(compact->getNumBodyNodes() - 2),
+      (const char*)compact->getBodyNode(compact->getNumBodyNodes() - 1));
+
+  VectorXs pos = VectorXs::Random(skel->getNumDofs());
+  VectorXs vel = VectorXs::Random(skel->getNumDofs());
+  VectorXs tau = VectorXs::Random(skel->getNumDofs());
+  for (SkeletonPtr s : {skel, compact})
+  {
+    s->setPositions(pos);
+    s->setVelocities(vel);
+    s->setControlForces(tau);
+    s->computeForwardDynamics();
+  }
+  EXPECT_TRUE(equals(compact->getAccelerations(), skel->getAccelerations(), 0));
+  EXPECT_TRUE(equals(compact->getMassMatrix(), skel->getMassMatrix(), 0));
+
+  // BodyNodes can outlive the arena's Skeleton by moving somewhere else
+  SkeletonPtr other = Skeleton::create();
+  compact->getBodyNode(3)->moveTo(other, nullptr);
+  compact.reset();
+  EXPECT_EQ(other->getNumBodyNodes(), 5u);
+  other->setPositions(VectorXs::Zero(other->getNumDofs()));
+  other->computeForwardDynamics();
+}
+
+//==============================================================================
+TEST(Skeleton, BatchedWorldTransforms)
+{
+  SkeletonPtr skel = Skeleton::create();
+  BodyNode* root
+      = skel->createJointAndBodyNodePair<FreeJoint>(nullptr).second;
+  BodyNode* left = skel->createJointAndBodyNodePair<BallJoint>(root).second;
+  BodyNode* right
+      = skel->createJointAndBodyNodePair<RevoluteJoint>(root).second;
+  skel->createJointAndBodyNodePair<RevoluteJoint>(left);
+
+  Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+  offset.translation() = Vector3s(0.1, 0.4, -0.2);
+  for (std::size_t i = 1; i < skel->getNumBodyNodes(); i++)
+    skel->getJoint(i)->setTransformFromParentBodyNode(offset);
+
+  // Bodies with no shapes, one shape, and two shapes
+  auto box = std::make_shared<BoxShape>(Vector3s(0.1, 0.2, 0.3));
+  root->createShapeNodeWith<VisualAspect>(box)->setRelativeTranslation(
+      Vector3s(0, 0.5, 0));
+  right->createShapeNodeWith<VisualAspect>(box)->setRelativeTranslation(
+      Vector3s(0.2, 0, 0));
+  right->createShapeNodeWith<VisualAspect>(box)->setRelativeRotation(
+      math::expMapRot(Vector3s(0.3, -0.1, 0.2)));
+
+  skel->setPositions(VectorXs::Random(skel->getNumDofs()));
+
+  common::aligned_vector<Eigen::Isometry3s> bodyTransforms;
+  skel->getBodyWorldTransforms(bodyTransforms);
+  ASSERT_EQ(bodyTransforms.size(), skel->getNumBodyNodes());
+  for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    EXPECT_TRUE(equals(
+        bodyTransforms[i].matrix(),
+        skel->getBodyNode(i)->getWorldTransform().matrix(),
+        1e-12));
+  }
+
+  std::vector<const ShapeNode*> shapeNodes;
+  common::aligned_vector<Eigen::Isometry3s> shapeTransforms;
+  skel->getShapeNodeWorldTransforms(shapeNodes, shapeTransforms);
+  ASSERT_EQ(shapeNodes.size(), 3u);
+  ASSERT_EQ(shapeTransforms.size(), 3u);
+  EXPECT_EQ(shapeNodes[0], root->getShapeNode(0));
+  EXPECT_EQ(shapeNodes[1], right->getShapeNode(0));
+  EXPECT_EQ(shapeNodes[2], right->getShapeNode(1));
+  for (std::size_t i = 0; i < shapeNodes.size(); i++)
+  {
+    EXPECT_TRUE(equals(
+        shapeTransforms[i].matrix(),
+        shapeNodes[i]->getWorldTransform().matrix(),
+        1e-12));
+  }
+}
+
+//==============================================================================
+/// Stands in for generated code, so the test can tell when it gets used
+class FakeCompiledDynamics : public CompiledSkeletonDynamics
+{
+public:
+  FakeCompiledDynamics(const std::string& signature) : mSignature(signature)
+  {
+  }
+
+  std::string getSignature() const override
+  {
+    return mSignature;
+  }
+
+  void computeMassMatrix(const Skeleton*, MatrixXs& M) const override
+  {
+    M.setIdentity();
+    M *= 7.0;
+  }
+
+  void computeCoriolisAndGravityForces(
+      const Skeleton*, VectorXs& Cg) const override
+  {
+    Cg.setConstant(3.0);
+  }
+
+  void computeInverseDynamics(
+      const Skeleton*, const VectorXs& ddq, VectorXs& tau) const override
+  {
+    tau = 7.0 * ddq + VectorXs::Constant(ddq.size(), 3.0);
+  }
+
+  void computeJacobianOfID(
+      const Skeleton*,
+      const VectorXs&,
+      bool,
+      bool,
+      MatrixXs& J) const override
+  {
+    J.setConstant(5.0);
+  }
+
+private:
+  std::string mSignature;
+};
+
+//==============================================================================
+TEST(Skeleton, CompiledDynamicsDispatch)
+{
+  SkeletonPtr skel = Skeleton::create();
+  BodyNode* root
+      = skel->createJointAndBodyNodePair<FreeJoint>(nullptr).second;
+  BodyNode* arm = skel->createJointAndBodyNodePair<RevoluteJoint>(root).second;
+  skel->createJointAndBodyNodePair<BallJoint>(arm);
+  skel->createJointAndBodyNodePair<WeldJoint>(root);
+
+  const std::string signature
+      = CompiledSkeletonDynamics::getSignature(skel.get());
+  ASSERT_FALSE(signature.empty());
+
+  const std::string source
+      = CompiledSkeletonDynamics::generateSource(skel.get(), "TestDynamics");
+  EXPECT_NE(source.find("class TestDynamics"), std::string::npos);
+  EXPECT_NE(source.find(signature), std::string::npos);
+
+  // Same joint types, but a different tree, gets a different signature
+  SkeletonPtr other = Skeleton::create();
+  root = other->createJointAndBodyNodePair<FreeJoint>(nullptr).second;
+  other->createJointAndBodyNodePair<RevoluteJoint>(root);
+  other->createJointAndBodyNodePair<BallJoint>(root);
+  other->createJointAndBodyNodePair<WeldJoint>(root);
+  EXPECT_NE(CompiledSkeletonDynamics::getSignature(other.get()), signature);
+
+  CompiledSkeletonDynamics::registerDynamics(
+      std::make_shared<FakeCompiledDynamics>(signature));
+  EXPECT_NE(skel->getCompiledDynamics(), nullptr);
+  EXPECT_EQ(other->getCompiledDynamics(), nullptr);
+
+  const std::size_t dofs = skel->getNumDofs();
+  const MatrixXs fakeM = 7.0 * MatrixXs::Identity(dofs, dofs);
+  skel->setPositions(VectorXs::Random(dofs));
+  EXPECT_TRUE(equals(skel->getMassMatrix(), fakeM, 0));
+  const VectorXs fakeCg = VectorXs::Constant(dofs, 3.0);
+  EXPECT_TRUE(equals(skel->getCoriolisAndGravityForces(), fakeCg, 0));
+  const MatrixXs fakeJ = MatrixXs::Constant(dofs, dofs, 5.0);
+  EXPECT_TRUE(equals(
+      skel->getJacobianOfC(neural::WithRespectTo::VELOCITY), fakeJ, 0));
+
+  skel->setCompiledDynamicsEnabled(false);
+  EXPECT_EQ(skel->getCompiledDynamics(), nullptr);
+  EXPECT_FALSE(equals(skel->getMassMatrix(), fakeM, 0));
+  skel->setCompiledDynamicsEnabled(true);
+
+  // Changing the structure means looking the Skeleton up again
+  skel->createJointAndBodyNodePair<RevoluteJoint>(arm);
+  EXPECT_EQ(skel->getCompiledDynamics(), nullptr);
+
+  CompiledSkeletonDynamics::clearRegistry();
+  EXPECT_EQ(CompiledSkeletonDynamics::find(signature), nullptr);
+}
+
+//==============================================================================
+/// Builds the Skeleton that CompiledSkeletonTestDynamics.hpp was generated
+/// from, with joint offsets and inertias that don't line up with any axes
+SkeletonPtr createCompiledDynamicsTestSkeleton()
+{
+  SkeletonPtr skel = Skeleton::create("compiled_dynamics_test");
+
+  auto rootPair = skel->createJointAndBodyNodePair<FreeJoint>(nullptr);
+  BodyNode* root = rootPair.second;
+  root->setInertia(dynamics::Inertia(
+      3.0, 0.05, -0.02, 0.1, 0.4, 0.3, 0.5, 0.01, -0.02, 0.03));
+
+  auto armPair = skel->createJointAndBodyNodePair<RevoluteJoint>(root);
+  RevoluteJoint* elbow = armPair.first;
+  BodyNode* arm = armPair.second;
+  elbow->setAxis(Eigen::Vector3s(0.3, 1.0, -0.2).normalized());
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0.1, 0.4, -0.05);
+  T.linear() = math::eulerXYZToMatrix(Eigen::Vector3s(0.2, -0.3, 0.5));
+  elbow->setTransformFromParentBodyNode(T);
+  T.translation() = Eigen::Vector3s(0.0, -0.2, 0.03);
+  T.linear() = math::eulerXYZToMatrix(Eigen::Vector3s(-0.1, 0.4, 0.1));
+  elbow->setTransformFromChildBodyNode(T);
+  arm->setInertia(dynamics::Inertia(
+      1.5, 0.02, 0.2, -0.01, 0.1, 0.05, 0.12, 0.005, 0.0, -0.01));
+
+  auto handPair = skel->createJointAndBodyNodePair<BallJoint>(arm);
+  BallJoint* wrist = handPair.first;
+  BodyNode* hand = handPair.second;
+  T.translation() = Eigen::Vector3s(-0.05, 0.35, 0.02);
+  T.linear() = math::eulerXYZToMatrix(Eigen::Vector3s(0.3, 0.1, -0.2));
+  wrist->setTransformFromParentBodyNode(T);
+  hand->setInertia(dynamics::Inertia(
+      0.7, 0.01, 0.08, 0.02, 0.03, 0.02, 0.04, -0.002, 0.001, 0.003));
+
+  auto headPair = skel->createJointAndBodyNodePair<WeldJoint>(root);
+  WeldJoint* neck = headPair.first;
+  BodyNode* head = headPair.second;
+  T.translation() = Eigen::Vector3s(0.0, 0.3, 0.1);
+  T.linear() = math::eulerXYZToMatrix(Eigen::Vector3s(0.0, 0.2, 0.3));
+  neck->setTransformFromParentBodyNode(T);
+  head->setInertia(dynamics::Inertia(
+      1.2, -0.03, 0.1, 0.0, 0.06, 0.07, 0.05, 0.0, 0.004, -0.002));
+
+  return skel;
+}
+
+//==============================================================================
+TEST(Skeleton, CompiledDynamicsMatchesGeneric)
+{
+  SkeletonPtr skel = createCompiledDynamicsTestSkeleton();
+  const std::size_t dofs = skel->getNumDofs();
+  ASSERT_EQ(dofs, 10u);
+
+  // The checked in file has to be what generateSource() writes today, or
+  // this would be testing stale code
+  const std::string source = CompiledSkeletonDynamics::generateSource(
+      skel.get(), "CompiledSkeletonTestDynamics");
+  std::ifstream file(
+      DART_ROOT_PATH "unittests/CompiledSkeletonTestDynamics.hpp");
+  ASSERT_TRUE(file.good());
+  std::stringstream checkedIn;
+  checkedIn << file.rdbuf();
+  EXPECT_EQ(checkedIn.str(), source)
+      << "Regenerate unittests/CompiledSkeletonTestDynamics.hpp from "
+         "createCompiledDynamicsTestSkeleton()";
+
+  // Registering it by hand makes sure nothing an earlier test did to the
+  // registry gets in the way
+  CompiledSkeletonDynamics::registerDynamics(
+      std::make_shared<CompiledSkeletonTestDynamics>());
+  ASSERT_NE(skel->getCompiledDynamics(), nullptr);
+
+  VectorXs pos(dofs);
+  pos << 0.3, -0.2, 0.5, 0.1, 0.7, -0.4, 0.8, -0.6, 0.25, 0.4;
+  VectorXs vel(dofs);
+  vel << -0.5, 0.4, 0.9, 1.2, -0.3, 0.6, 1.1, 0.7, -0.8, 0.35;
+  VectorXs ddq(dofs);
+  ddq << 0.2, -0.7, 0.4, 1.5, 0.3, -0.9, -0.4, 0.6, 1.0, -0.2;
+  skel->setPositions(pos);
+  skel->setVelocities(vel);
+  skel->setGravity(Eigen::Vector3s(0.4, -9.81, 0.7));
+
+  auto compare = [&](const char* name, std::function<MatrixXs()> compute) {
+    skel->setCompiledDynamicsEnabled(true);
+    const MatrixXs compiled = compute();
+    skel->setCompiledDynamicsEnabled(false);
+    const MatrixXs generic = compute();
+    skel->setCompiledDynamicsEnabled(true);
+    EXPECT_TRUE(equals(compiled, generic, 1e-10))
+        << name << " doesn't match the generic path.\nCompiled:\n"
+        << compiled << "\nGeneric:\n"
+        << generic << "\nDiff:\n"
+        << compiled - generic;
+  };
+
+  compare("M", [&]() -> MatrixXs { return skel->getMassMatrix(); });
+  compare("Cg", [&]() -> MatrixXs {
+    return skel->getCoriolisAndGravityForces();
+  });
+  compare("dC/dq", [&]() -> MatrixXs {
+    return skel->getJacobianOfC(neural::WithRespectTo::POSITION);
+  });
+  compare("dC/dv", [&]() -> MatrixXs {
+    return skel->getJacobianOfC(neural::WithRespectTo::VELOCITY);
+  });
+  compare("dM/dq", [&]() -> MatrixXs {
+    return skel->getJacobianOfM(ddq, neural::WithRespectTo::POSITION);
+  });
+
+  CompiledSkeletonDynamics::clearRegistry();
+}
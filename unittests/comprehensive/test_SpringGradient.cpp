@@ -780,3 +780,51 @@ TEST(GRADIENTS, FREE_BLOCK_ON_GROUND_SLIPPING_FRICTION_INITIAL_VELOCITY)
   testFreeBlockWithFrictionCoeff(0.5, 1, true);
 }
 #endif
+
+#ifdef ALL_TESTS
+TEST(GRADIENTS, IMPLICIT_SPRING_DAMPING_ARM)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  world->setTimeStep(0.01);
+  world->setImplicitSpringDamping(true);
+
+  // These springs and dampers are too stiff for the semi-explicit update at
+  // this timestep
+  SkeletonPtr arm = Skeleton::create("arm");
+  BodyNode* parent = nullptr;
+  for (int i = 0; i < 3; i++)
+  {
+    std::pair<RevoluteJoint*, BodyNode*> jointPair
+        = arm->createJointAndBodyNodePair<RevoluteJoint>(parent);
+    if (parent != nullptr)
+    {
+      Eigen::Isometry3s armOffset = Eigen::Isometry3s::Identity();
+      armOffset.translation() = Eigen::Vector3s(0, 1.0, 0);
+      jointPair.first->setTransformFromParentBodyNode(armOffset);
+    }
+    jointPair.first->setSpringStiffness(0, 1e4);
+    jointPair.first->setDampingCoefficient(0, 50);
+    jointPair.first->setRestPosition(0, 0.5);
+    jointPair.second->setMass(1.0);
+    parent = jointPair.second;
+  }
+  arm->setPositions(Eigen::VectorXs::Ones(3) * 0.2);
+  arm->setVelocities(Eigen::VectorXs::Ones(3) * 0.1);
+  world->addSkeleton(arm);
+
+  Eigen::VectorXs worldVel = world->getVelocities();
+  EXPECT_TRUE(verifyVelGradients(world, worldVel));
+  EXPECT_TRUE(verifyAnalyticalJacobians(world));
+  EXPECT_TRUE(verifyAnalyticalBackprop(world));
+  EXPECT_TRUE(verifyWrtMass(world));
+
+  for (int i = 0; i < 200; i++)
+  {
+    world->step();
+  }
+  EXPECT_TRUE(world->getVelocities().norm() < 10);
+  EXPECT_TRUE(
+      (world->getPositions() - Eigen::VectorXs::Ones(3) * 0.5).norm() < 0.1);
+}
+#endif
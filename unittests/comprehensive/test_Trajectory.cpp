@@ -55,7 +55,9 @@
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/Parareal.hpp"
 #include "dart/trajectory/Problem.hpp"
+#include "dart/trajectory/SGDOptimizer.hpp"
 #include "dart/trajectory/SingleShot.hpp"
 #include "dart/trajectory/Solution.hpp"
 #include "dart/trajectory/TrajectoryConstants.hpp"
@@ -1426,4 +1428,540 @@ TEST(TRAJECTORY, REOPTIMIZATION)
     record->reoptimize();
   }
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, ADVANCE_STEPS_SHIFTS_ACROSS_SHOTS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  world->addSkeleton(box);
+
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getControlForcesConst().squaredNorm();
+  };
+  LossFn lossFn(loss);
+
+  const int steps = 12;
+  const int advance = 3;
+  MultiShot shot(world, lossFn, steps, 4, false);
+
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Zero(world->getNumDofs(), steps);
+  for (int t = 0; t < steps; t++)
+  {
+    forces.col(t).setConstant(t + 1);
+  }
+  shot.setControlForcesRaw(forces);
+
+  Problem& problem = shot;
+  int dim = shot.getFlatProblemDim(world);
+  Eigen::VectorXs oldFlat = Eigen::VectorXs::Zero(dim);
+  problem.flatten(world, oldFlat);
+
+  Eigen::VectorXi mapping = shot.advanceSteps(
+      world, world->getPositions(), world->getVelocities(), advance);
+  EXPECT_EQ(dim, mapping.size());
+
+  // Forces should move across shot boundaries, and the tail should hold the
+  // last planned force rather than dropping to zero
+  Eigen::MatrixXs shifted
+      = shot.getRolloutCache(world)->getControlForcesConst();
+  for (int t = 0; t < steps; t++)
+  {
+    s_t expected = std::min(t + advance, steps - 1) + 1;
+    EXPECT_EQ(expected, shifted(0, t));
+    EXPECT_EQ(expected, shifted(1, t));
+  }
+
+  // Every force entry in the new flat vector should be found at the index the
+  // mapping points to in the old one
+  Eigen::VectorXs newFlat = Eigen::VectorXs::Zero(dim);
+  problem.flatten(world, newFlat);
+  for (int i = 0; i < dim; i++)
+  {
+    if (mapping(i) != i)
+    {
+      EXPECT_EQ(oldFlat(mapping(i)), newFlat(i));
+    }
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, ADAPT_SHOT_LENGTHS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  world->addSkeleton(box);
+
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getControlForcesConst().squaredNorm();
+  };
+  LossFn lossFn(loss);
+
+  const int steps = 12;
+  MultiShot shot(world, lossFn, steps, 4, false);
+  shot.pinForce(5, Eigen::Vector2s(3, 4));
+
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Zero(world->getNumDofs(), steps);
+  for (int t = 0; t < steps; t++)
+  {
+    forces.col(t).setConstant(t + 1);
+  }
+  shot.setControlForcesRaw(forces);
+  Eigen::MatrixXs oldPoses = shot.getRolloutCache(world)->getPosesConst();
+
+  // Splitting inside a shot should start the new knot where the old shot had
+  // rolled out to, and keep the knot that already existed at step 8
+  shot.setShotLengths(world, {2, 6, 4});
+  EXPECT_EQ(std::vector<int>({2, 6, 4}), shot.getShotLengths());
+  EXPECT_EQ(
+      world->getNumDofs() * (steps + 2 * 2), shot.getFlatProblemDim(world));
+  EXPECT_TRUE(
+      forces == shot.getRolloutCache(world)->getControlForcesConst());
+  EXPECT_TRUE(Eigen::Vector2s(3, 4) == shot.getPinnedForce(5));
+  Eigen::MatrixXs newPoses = shot.getRolloutCache(world)->getPosesConst();
+  EXPECT_TRUE(equals(oldPoses.block(0, 0, 2, 4), newPoses.block(0, 0, 2, 4)));
+  EXPECT_TRUE(equals(oldPoses.block(0, 8, 2, 4), newPoses.block(0, 8, 2, 4)));
+
+  // Only the knot at step 8 still has a defect (the box is falling, but that
+  // knot starts at rest), so only the shot ending there gets split
+  EXPECT_TRUE(shot.adaptShots(world, 1e-3, 0.0, 1, steps));
+  EXPECT_EQ(std::vector<int>({2, 3, 3, 4}), shot.getShotLengths());
+
+  // A huge merge threshold collapses everything back into as few shots as
+  // the max length allows
+  EXPECT_TRUE(shot.adaptShots(world, 1e9, 1e9, 1, 8));
+  EXPECT_EQ(std::vector<int>({8, 4}), shot.getShotLengths());
+  EXPECT_FALSE(shot.adaptShots(world, 1e9, 1e9, 1, 8));
+
+  // Parallel scheduling should give the same constraint values
+  Eigen::VectorXs serial = Eigen::VectorXs::Zero(shot.getConstraintDim());
+  shot.computeConstraints(world, serial);
+  shot.setParallelOperationsEnabled(true);
+  Eigen::VectorXs parallel = Eigen::VectorXs::Zero(shot.getConstraintDim());
+  shot.computeConstraints(world, parallel);
+  EXPECT_TRUE(equals(serial, parallel));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, PARAREAL_ROLLOUT)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  world->addSkeleton(box);
+
+  const int steps = 40;
+  const int dofs = world->getNumDofs();
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Zero(dofs, steps);
+  for (int t = 0; t < steps; t++)
+  {
+    forces(0, t) = sin(0.3 * t);
+    forces(1, t) = cos(0.2 * t);
+  }
+  Eigen::VectorXs startPos = Eigen::Vector2s(0.1, 0.2);
+  Eigen::VectorXs startVel = Eigen::Vector2s(-0.3, 0.4);
+
+  // The plain serial rollout
+  Eigen::VectorXs state(2 * dofs);
+  state << startPos, startVel;
+  Eigen::MatrixXs poses(dofs, steps);
+  Eigen::MatrixXs vels(dofs, steps);
+  Parareal::finePropagate(world, state, forces, poses, vels);
+
+  // Enough rounds to make every slice exact
+  Parareal parareal(
+      world,
+      PararealConfig().setNumSlices(4).setCoarseStepFactor(4).setTolerance(
+          0.0));
+  PararealResult result = parareal.rollout(startPos, startVel, forces);
+  EXPECT_TRUE(result.converged);
+  EXPECT_LE(result.iterations, 4);
+  EXPECT_TRUE(equals(poses, result.poses, 1e-12));
+  EXPECT_TRUE(equals(vels, result.vels, 1e-12));
+  // The world we handed in is untouched
+  EXPECT_TRUE(world->getPositions().isZero());
+
+  // Parareal on the knots of a MultiShot should close the defects, and leave
+  // the knots where the serial rollout goes
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getControlForcesConst().squaredNorm();
+  };
+  LossFn lossFn(loss);
+  world->setPositions(startPos);
+  world->setVelocities(startVel);
+  MultiShot shot(world, lossFn, steps, 10, false);
+  shot.setControlForcesRaw(forces);
+  shot.setParallelOperationsEnabled(true);
+  Eigen::VectorXs defects = Eigen::VectorXs::Zero(shot.getConstraintDim());
+  shot.computeConstraints(world, defects);
+  EXPECT_GT(defects.norm(), 1e-3);
+
+  int rounds = shot.pararealInitializeKnots(
+      world, PararealConfig().setMaxIterations(10).setTolerance(0.0));
+  EXPECT_LE(rounds, 3);
+  shot.computeConstraints(world, defects);
+  EXPECT_LT(defects.norm(), 1e-10);
+  Eigen::MatrixXs knotPoses = shot.getRolloutCache(world)->getPosesConst();
+  EXPECT_TRUE(equals(poses, knotPoses, 1e-10));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, ROLLOUT_POOLED_STORAGE)
+{
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  std::unordered_map<std::string, Eigen::MatrixXs> metadata;
+  pos["identity"] = Eigen::MatrixXs::Random(3, 10);
+  vel["identity"] = Eigen::MatrixXs::Random(3, 10);
+  force["identity"] = Eigen::MatrixXs::Random(3, 10);
+  pos["mapped"] = Eigen::MatrixXs::Random(2, 10);
+  vel["mapped"] = Eigen::MatrixXs::Random(2, 10);
+  force["mapped"] = Eigen::MatrixXs::Random(1, 10);
+  Eigen::VectorXs mass = Eigen::VectorXs::Random(4);
+
+  TrajectoryRolloutReal rollout(pos, vel, force, mass, metadata);
+  EXPECT_TRUE(rollout.getPosesConst("mapped") == pos["mapped"]);
+  EXPECT_TRUE(rollout.getControlForcesConst("mapped") == force["mapped"]);
+  EXPECT_TRUE(rollout.getMassesConst() == mass);
+
+  // Writing through a slice lands in the underlying rollout
+  TrajectoryRolloutRef slice = rollout.slice(2, 3);
+  slice.getVels("identity").setConstant(7.0);
+  EXPECT_EQ(rollout.getVelsConst("identity")(1, 3), 7.0);
+  EXPECT_EQ(rollout.getVelsConst("identity")(1, 5), vel["identity"](1, 5));
+
+  // Copies are deep
+  TrajectoryRollout* copy = rollout.copy();
+  copy->getPoses("identity").setZero();
+  EXPECT_TRUE(rollout.getPosesConst("identity") == pos["identity"]);
+
+  // Freed buffers go back to the pool, and the next rollout takes one
+  std::size_t pooled = TrajectoryRolloutReal::getNumPooledBuffers();
+  delete copy;
+  EXPECT_EQ(TrajectoryRolloutReal::getNumPooledBuffers(), pooled + 1);
+  TrajectoryRolloutReal another(&rollout);
+  EXPECT_EQ(TrajectoryRolloutReal::getNumPooledBuffers(), pooled);
+  EXPECT_TRUE(
+      another.getVelsConst("identity") == rollout.getVelsConst("identity"));
+
+  // Moving hands over the buffer without copying it
+  const s_t* data = another.getPosesConst("mapped").data();
+  TrajectoryRolloutReal moved(std::move(another));
+  EXPECT_EQ(moved.getPosesConst("mapped").data(), data);
+  EXPECT_EQ(another.getMappings().size(), 0);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, TIMESTEP_LOSS_SPARSITY)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  world->addSkeleton(box);
+
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getControlForcesConst().squaredNorm();
+  };
+  TimestepLossTerm term = [](const TrajectoryRollout* timestep, int time) {
+    return timestep->getPosesConst().squaredNorm()
+           + time * timestep->getControlForcesConst().squaredNorm();
+  };
+  TimestepLossTermAndGrad termAndGrad
+      = [](const TrajectoryRollout* timestep,
+           int time,
+           TrajectoryRollout* gradWrtTimestep) {
+          gradWrtTimestep->getPoses() = 2 * timestep->getPosesConst();
+          gradWrtTimestep->getControlForces()
+              = 2 * time * timestep->getControlForcesConst();
+          return timestep->getPosesConst().squaredNorm()
+                 + time * timestep->getControlForcesConst().squaredNorm();
+        };
+
+  const int steps = 12;
+  TimestepLossFn analytical(term, termAndGrad, 5, 8);
+  TimestepLossFn numerical(term, 5, 8);
+  EXPECT_TRUE(analytical.isTimestepSeparable());
+
+  MultiShot shot(world, LossFn(loss), steps, 4, false);
+  shot.addConstraint(analytical);
+  srand(42);
+  shot.setControlForcesRaw(
+      Eigen::MatrixXs::Random(world->getNumDofs(), steps));
+
+  // The window only overlaps the second and third shots, so the first
+  // shot's dims shouldn't show up in the constraint rows
+  int firstDim = 0;
+  int numDims = 0;
+  shot.getDynamicDimRangeForTimesteps(world, 5, 8, firstDim, numDims);
+  int shotDim = shot.getFlatDynamicProblemDim(world) / 3;
+  EXPECT_EQ(shotDim, firstDim);
+  EXPECT_LT(numDims, 2 * shotDim);
+  EXPECT_TRUE(verifySparseJacobian(world, shot));
+
+  // The window sum and gradient should match, whether the terms run in
+  // parallel or not, and whether the gradient is analytical or not
+  const TrajectoryRollout* rollout = shot.getRolloutCache(world);
+  s_t expected = 0.0;
+  for (int t = 5; t < 8; t++)
+  {
+    expected += rollout->getPosesConst().col(t).squaredNorm()
+                + t * rollout->getControlForcesConst().col(t).squaredNorm();
+  }
+  EXPECT_NEAR(expected, analytical.getLoss(rollout), 1e-12);
+
+  TrajectoryRolloutReal grad(rollout);
+  analytical.getLossAndGradient(rollout, &grad);
+  analytical.setParallelOperationsEnabled(true);
+  TrajectoryRolloutReal gradParallel(rollout);
+  EXPECT_NEAR(
+      expected, analytical.getLossAndGradient(rollout, &gradParallel), 1e-12);
+  TrajectoryRolloutReal gradNumerical(rollout);
+  numerical.getLossAndGradient(rollout, &gradNumerical);
+
+  EXPECT_TRUE(grad.getPosesConst() == gradParallel.getPosesConst());
+  EXPECT_TRUE(
+      grad.getControlForcesConst() == gradParallel.getControlForcesConst());
+  EXPECT_EQ(0.0, grad.getPosesConst().col(4).squaredNorm());
+  EXPECT_EQ(0.0, grad.getPosesConst().col(8).squaredNorm());
+  Eigen::MatrixXs posGrad = grad.getPosesConst();
+  Eigen::MatrixXs posGradNumerical = gradNumerical.getPosesConst();
+  EXPECT_TRUE(equals(posGrad, posGradNumerical, 1e-6));
+  Eigen::MatrixXs forceGrad = grad.getControlForcesConst();
+  Eigen::MatrixXs forceGradNumerical = gradNumerical.getControlForcesConst();
+  EXPECT_TRUE(equals(forceGrad, forceGradNumerical, 1e-6));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, GAUSS_NEWTON_HESSIAN)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  world->addSkeleton(box);
+
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    Eigen::MatrixXs poses = rollout->getPosesConst();
+    return poses.squaredNorm();
+  };
+
+  const int steps = 12;
+  MultiShot shot(world, LossFn(loss), steps, 4, false);
+  srand(42);
+  shot.setControlForcesRaw(
+      Eigen::MatrixXs::Random(world->getNumDofs(), steps));
+
+  // One residual per (timestep, dof), matching the loss above. Registering
+  // the same residuals as constraints gives us their dense Jacobian.
+  MultiShot reference(world, LossFn(loss), steps, 4, false);
+  reference.setControlForcesRaw(
+      shot.getRolloutCache(world)->getControlForcesConst());
+  for (int t = 0; t < steps; t++)
+  {
+    for (int dof = 0; dof < world->getNumDofs(); dof++)
+    {
+      TimestepLossTerm residual
+          = [dof](const TrajectoryRollout* timestep, int /* time */) {
+              return timestep->getPosesConst()(dof, 0);
+            };
+      shot.addLeastSquaresResidual(TimestepLossFn(residual, t, t + 1));
+      reference.addConstraint(TimestepLossFn(residual, t, t + 1));
+    }
+  }
+  EXPECT_EQ(steps * world->getNumDofs(), shot.getNumLeastSquaresResiduals());
+
+  int n = shot.getFlatProblemDim(world);
+  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(reference.getConstraintDim(), n);
+  reference.Problem::backpropJacobian(world, jac);
+  jac = jac.topRows(shot.getNumLeastSquaresResiduals()).eval();
+  Eigen::MatrixXs expected = 2 * jac.transpose() * jac;
+
+  int nnzh = shot.getNumberNonZeroHessian(world);
+  EXPECT_LT(nnzh, (n * (n + 1)) / 2);
+  Eigen::VectorXi rows = Eigen::VectorXi::Zero(nnzh);
+  Eigen::VectorXi cols = Eigen::VectorXi::Zero(nnzh);
+  shot.getHessianSparsityStructure(world, rows, cols);
+  Eigen::VectorXs values = Eigen::VectorXs::Zero(nnzh);
+  shot.getSparseGaussNewtonHessian(world, values);
+
+  Eigen::MatrixXs recovered = Eigen::MatrixXs::Zero(n, n);
+  for (int i = 0; i < nnzh; i++)
+  {
+    EXPECT_LE(cols(i), rows(i));
+    recovered(rows(i), cols(i)) = values(i);
+  }
+  Eigen::MatrixXs expectedLower = expected.triangularView<Eigen::Lower>();
+  EXPECT_TRUE(equals(expectedLower, recovered, 1e-12));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, SGD_BATCH)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s::Zero());
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<PrismaticJoint*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<PrismaticJoint>();
+  std::shared_ptr<BoxShape> shape(new BoxShape(Eigen::Vector3s(0.1, 0.1, 0.1)));
+  pair.second->createShapeNodeWith<VisualAspect>(shape);
+  world->addSkeleton(box);
+
+  // Push the box to end up at x = 1
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    const Eigen::Ref<const Eigen::MatrixXs> poses
+        = rollout->getPosesConst("identity");
+    s_t error = poses(0, poses.cols() - 1) - 1.0;
+    return error * error;
+  };
+  int steps = 10;
+
+  // A batch of unperturbed copies averages to the full-batch gradient
+  SingleShot fullBatch(world, LossFn(loss), steps, false);
+  SGDOptimizer fullOptimizer;
+  fullOptimizer.setIterationLimit(5);
+  fullOptimizer.setMomentum(0.5);
+  fullOptimizer.optimize(&fullBatch);
+
+  SingleShot batched(world, LossFn(loss), steps, false);
+  std::vector<std::shared_ptr<Problem>> batch;
+  for (int i = 0; i < 3; i++)
+  {
+    batch.push_back(std::make_shared<SingleShot>(
+        world->clone(), LossFn(loss), steps, false));
+  }
+  SGDOptimizer batchOptimizer;
+  batchOptimizer.setIterationLimit(5);
+  batchOptimizer.setMomentum(0.5);
+  batchOptimizer.setBatchProblems(batch);
+  batchOptimizer.optimize(&batched);
+
+  int n = fullBatch.getFlatProblemDim(world);
+  Eigen::VectorXs fullX = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs batchX = Eigen::VectorXs::Zero(n);
+  static_cast<Problem&>(fullBatch).flatten(world, fullX);
+  static_cast<Problem&>(batched).flatten(world, batchX);
+  EXPECT_TRUE(equals(fullX, batchX, 1e-10));
+
+  // Adam, over a batch with randomized starting velocities, still makes
+  // progress
+  SingleShot randomized(world, LossFn(loss), steps, false);
+  s_t startLoss = randomized.getLoss(world);
+  SGDOptimizer adamOptimizer;
+  adamOptimizer.setIterationLimit(20);
+  adamOptimizer.setAdamEnabled(true);
+  adamOptimizer.setLearningRate(0.1);
+  adamOptimizer.setBatchProblems(batch);
+  adamOptimizer.setBatchPerturbation(
+      [](Problem* problem, std::shared_ptr<World>, int sample, int) {
+        problem->setStartVel(Eigen::VectorXs::Ones(1) * 0.1 * sample);
+      });
+  adamOptimizer.optimize(&randomized);
+  EXPECT_LT(randomized.getLoss(world), startLoss);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, SOLUTION_RECORDING_POLICIES)
+{
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  pos["identity"] = Eigen::MatrixXs::Random(2, 5);
+  vel["identity"] = Eigen::MatrixXs::Random(2, 5);
+  force["identity"] = Eigen::MatrixXs::Random(2, 5);
+  TrajectoryRolloutReal rollout(
+      pos,
+      vel,
+      force,
+      Eigen::VectorXs::Zero(0),
+      std::unordered_map<std::string, Eigen::MatrixXs>());
+
+  // Losses go down and then back up, so the best is in the middle
+  std::vector<s_t> losses = {5.0, 4.0, 1.0, 3.0, 6.0, 7.0, 8.0};
+
+  Solution all;
+  Solution lastN;
+  lastN.setIterationRecordingPolicy(IterationRecordingPolicy::LAST_N, 3);
+  Solution everyKth;
+  everyKth.setIterationRecordingPolicy(IterationRecordingPolicy::EVERY_KTH, 3);
+  Solution best;
+  best.setIterationRecordingPolicy(IterationRecordingPolicy::BEST);
+  for (int i = 0; i < (int)losses.size(); i++)
+  {
+    for (Solution* solution : {&all, &lastN, &everyKth, &best})
+    {
+      solution->registerIteration(i, &rollout, losses[i], 0.0);
+      solution->registerX(Eigen::VectorXs::Ones(2) * i);
+    }
+  }
+
+  EXPECT_EQ(all.getNumSteps(), 7);
+  EXPECT_EQ(all.getXs().size(), 7);
+
+  EXPECT_EQ(lastN.getNumSteps(), 3);
+  EXPECT_EQ(lastN.getStep(0).index, 4);
+  EXPECT_EQ(lastN.getStep(2).index, 6);
+  EXPECT_EQ(lastN.getXs().size(), 3);
+  EXPECT_EQ(lastN.getXs()[0](0), 4);
+
+  EXPECT_EQ(everyKth.getNumSteps(), 3);
+  EXPECT_EQ(everyKth.getStep(0).index, 0);
+  EXPECT_EQ(everyKth.getStep(1).index, 3);
+  EXPECT_EQ(everyKth.getStep(2).index, 6);
+
+  EXPECT_EQ(best.getNumSteps(), 1);
+  EXPECT_EQ(best.getStep(0).index, 2);
+  EXPECT_EQ(best.getStep(0).loss, 1.0);
+
+  for (Solution* solution : {&all, &lastN, &everyKth, &best})
+  {
+    EXPECT_EQ(solution->getNumRegisteredIterations(), 7);
+    Eigen::MatrixXs recordedPos
+        = solution->getStep(0).rollout->getPosesConst("identity");
+    EXPECT_TRUE(equals(recordedPos, pos["identity"]));
+  }
+}
+#endif
@@ -30,6 +30,7 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstring>
 #include <iostream>
 #include <gtest/gtest.h>
 #include "TestHelpers.hpp"
@@ -37,13 +38,19 @@
 #include "dart/math/Geometry.hpp"
 #include "dart/utils/SkelParser.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
 #include "dart/collision/collision.hpp"
 #if HAVE_BULLET
   #include "dart/collision/bullet/bullet.hpp"
 #endif
 #include "dart/simulation/World.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/constraint/BallJointConstraint.hpp"
 #include "dart/constraint/BoxedLcpConstraintSolver.hpp"
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
@@ -317,6 +324,465 @@ TEST(World, ValidatingClones)
   }
 }
 
+//==============================================================================
+TEST(World, ClonesKeepInertiaAndShareShapes)
+{
+  dart::simulation::WorldPtr world
+      = utils::SkelParser::readWorld("dart://sample/skel/test/chainwhipa.skel");
+  dart::dynamics::SkeletonPtr skel = world->getSkeleton(0);
+  for (std::size_t i = 0; i < skel->getNumBodyNodes(); ++i)
+  {
+    BodyNode* body = skel->getBodyNode(i);
+    body->setMass(1.0 + 0.1 * i);
+    body->setLocalCOM(Eigen::Vector3s(0.01 * i, -0.02, 0.03));
+    body->setMomentOfInertia(0.1, 0.2, 0.3 + 0.01 * i, 0.001, 0.002, 0.003);
+    body->setBeta(Eigen::Vector3s(0.5, 0.6 + 0.01 * i, 0.7));
+  }
+
+  dart::simulation::WorldPtr clone = world->clone();
+  dart::dynamics::SkeletonPtr skelClone = clone->getSkeleton(0);
+
+  EXPECT_TRUE(equals(skel->getLinkMasses(), skelClone->getLinkMasses(), 0));
+  EXPECT_TRUE(equals(skel->getLinkCOMs(), skelClone->getLinkCOMs(), 0));
+  EXPECT_TRUE(equals(skel->getLinkMOIs(), skelClone->getLinkMOIs(), 0));
+  EXPECT_TRUE(equals(skel->getLinkBetas(), skelClone->getLinkBetas(), 0));
+
+  // The clone's ShapeNodes should point at the same Shapes, so mesh data is
+  // never duplicated
+  for (std::size_t i = 0; i < skel->getNumBodyNodes(); ++i)
+  {
+    BodyNode* body = skel->getBodyNode(i);
+    BodyNode* bodyClone = skelClone->getBodyNode(i);
+    ASSERT_EQ(body->getNumShapeNodes(), bodyClone->getNumShapeNodes());
+    for (std::size_t j = 0; j < body->getNumShapeNodes(); ++j)
+    {
+      EXPECT_EQ(
+          body->getShapeNode(j)->getShape(),
+          bodyClone->getShapeNode(j)->getShape());
+    }
+  }
+}
+
+//==============================================================================
+TEST(World, SerializedWorldsStepIdentically)
+{
+  dart::simulation::WorldPtr world
+      = utils::SkelParser::readWorld("dart://sample/skel/test/chainwhipa.skel");
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setVelocities(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setTimeStep(0.002);
+  world->setContactClippingDepth(0.05);
+
+  std::string bytes = world->serialize();
+  dart::simulation::WorldPtr copy = World::deserialize(bytes);
+  ASSERT_TRUE(copy != nullptr);
+
+  EXPECT_EQ(world->getNumSkeletons(), copy->getNumSkeletons());
+  EXPECT_EQ(world->getTimeStep(), copy->getTimeStep());
+  EXPECT_EQ(world->getContactClippingDepth(), copy->getContactClippingDepth());
+  EXPECT_EQ(world->getActionSpace(), copy->getActionSpace());
+  EXPECT_TRUE(equals(world->getState(), copy->getState(), 0));
+  EXPECT_TRUE(equals(world->getLinkMasses(), copy->getLinkMasses(), 0));
+  EXPECT_TRUE(equals(world->getLinkMOIs(), copy->getLinkMOIs(), 0));
+  EXPECT_TRUE(equals(
+      world->getPositionUpperLimits(), copy->getPositionUpperLimits(), 0));
+  for (std::size_t i = 0; i < world->getNumSkeletons(); ++i)
+  {
+    SkeletonPtr skel = world->getSkeleton(i);
+    SkeletonPtr skelCopy = copy->getSkeleton(i);
+    ASSERT_EQ(skel->getNumBodyNodes(), skelCopy->getNumBodyNodes());
+    for (std::size_t j = 0; j < skel->getNumBodyNodes(); ++j)
+    {
+      EXPECT_EQ(
+          skel->getBodyNode(j)->getNumShapeNodes(),
+          skelCopy->getBodyNode(j)->getNumShapeNodes());
+    }
+  }
+
+  for (int i = 0; i < 20; i++)
+  {
+    world->step();
+    copy->step();
+  }
+  EXPECT_TRUE(equals(world->getState(), copy->getState(), 1e-12));
+}
+
+//==============================================================================
+TEST(World, InPlaceStateGettersMatch)
+{
+  dart::simulation::WorldPtr world
+      = utils::SkelParser::readWorld("dart://sample/skel/test/chainwhipa.skel");
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setVelocities(Eigen::VectorXs::Random(world->getNumDofs()));
+
+  Eigen::VectorXs positions(world->getNumDofs());
+  Eigen::VectorXs velocities(world->getNumDofs());
+  world->getPositions(positions);
+  world->getVelocities(velocities);
+  EXPECT_TRUE(equals(world->getPositions(), positions, 0));
+  EXPECT_TRUE(equals(world->getVelocities(), velocities, 0));
+}
+
+//==============================================================================
+TEST(World, InPlaceStateMatches)
+{
+  dart::simulation::WorldPtr world
+      = utils::SkelParser::readWorld("dart://sample/skel/test/chainwhipa.skel");
+  Eigen::VectorXs target = Eigen::VectorXs::Random(world->getStateSize());
+  world->setStateFrom(target);
+  EXPECT_TRUE(equals(world->getState(), target, 0));
+
+  Eigen::VectorXs state = Eigen::VectorXs::Zero(world->getStateSize());
+  world->getState(state);
+  EXPECT_TRUE(equals(target, state, 0));
+
+  // Columns of a bigger matrix are read in place too
+  Eigen::MatrixXs columns = Eigen::MatrixXs::Random(world->getStateSize(), 2);
+  world->setStateFrom(columns.col(1));
+  EXPECT_TRUE(equals(world->getState(), Eigen::VectorXs(columns.col(1)), 0));
+}
+
+//==============================================================================
+/// This drops a small, fast ball onto a thin slab, with a timestep large
+/// enough that the ball passes all the way through the slab in one step, and
+/// returns the height of the ball after a few steps
+s_t dropFastBallOnThinSlab(s_t speculativeContactDistance)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s::Zero());
+  world->setTimeStep(0.01);
+  world->setSpeculativeContactDistance(speculativeContactDistance);
+
+  SkeletonPtr ball = Skeleton::create("ball");
+  std::pair<PrismaticJoint*, BodyNode*> pairBall
+      = ball->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  PrismaticJoint* ballJoint = pairBall.first;
+  BodyNode* ballBody = pairBall.second;
+  ballJoint->setAxis(Eigen::Vector3s::UnitY());
+  std::shared_ptr<SphereShape> sphereShape(new SphereShape(0.05));
+  ballBody->createShapeNodeWith<VisualAspect, CollisionAspect>(sphereShape);
+  ballBody->setFrictionCoeff(0.0);
+  ballJoint->setPosition(0, 0.2);
+  ballJoint->setVelocity(0, -20.0);
+  world->addSkeleton(ball);
+
+  SkeletonPtr slab = Skeleton::create("slab");
+  std::pair<WeldJoint*, BodyNode*> pairSlab
+      = slab->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(10.0, 0.02, 10.0)));
+  pairSlab.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      boxShape);
+  world->addSkeleton(slab);
+
+  for (int i = 0; i < 3; i++)
+  {
+    world->step();
+  }
+  return ballJoint->getPosition(0);
+}
+
+//==============================================================================
+TEST(World, SpeculativeContactsStopTunneling)
+{
+  // The ball moves 0.2 per step, which carries it straight through the 0.02
+  // thick slab without ever registering a meaningful contact
+  EXPECT_LT(dropFastBallOnThinSlab(0.0), -0.01);
+
+  // With a speculative margin the ball should stop on top of the slab, where
+  // its center is one radius above the top face
+  s_t height = dropFastBallOnThinSlab(0.5);
+  EXPECT_GT(height, 0.06 - 1e-3);
+  EXPECT_LT(height, 0.06 + 1e-3);
+}
+
+//==============================================================================
+TEST(World, RestingSkeletonsFallAsleepAndWake)
+{
+  WorldPtr world = World::create();
+  world->setTimeStep(0.01);
+  world->setSleepingEnabled(true);
+  world->setSleepStepThreshold(10);
+
+  // A box sitting (just barely penetrating) on a thin fixed slab
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<PrismaticJoint*, BodyNode*> pairBox
+      = box->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  PrismaticJoint* boxJoint = pairBox.first;
+  boxJoint->setAxis(Eigen::Vector3s::UnitY());
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(0.1, 0.1, 0.1)));
+  pairBox.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      boxShape);
+  boxJoint->setPosition(0, 0.059);
+  world->addSkeleton(box);
+
+  SkeletonPtr slab = Skeleton::create("slab");
+  std::pair<WeldJoint*, BodyNode*> pairSlab
+      = slab->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  std::shared_ptr<BoxShape> slabShape(
+      new BoxShape(Eigen::Vector3s(10.0, 0.02, 10.0)));
+  pairSlab.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      slabShape);
+  world->addSkeleton(slab);
+
+  for (int i = 0; i < 30; i++)
+  {
+    world->step();
+  }
+  EXPECT_TRUE(world->isSleeping(box));
+  EXPECT_FALSE(box->isMobile());
+  // The slab was never mobile, so it isn't "asleep"
+  EXPECT_FALSE(world->isSleeping(slab));
+  s_t restingHeight = boxJoint->getPosition(0);
+
+  // Sleeping bodies stay put
+  world->step();
+  EXPECT_EQ(boxJoint->getPosition(0), restingHeight);
+
+  // Shoving the box upwards wakes it up, and it moves again
+  boxJoint->setControlForce(0, 100.0);
+  world->step();
+  EXPECT_FALSE(world->isSleeping(box));
+  EXPECT_TRUE(box->isMobile());
+  world->step();
+  EXPECT_GT(boxJoint->getPosition(0), restingHeight);
+
+  // Turning sleeping off leaves nothing asleep
+  world->setSleepingEnabled(false);
+  EXPECT_FALSE(world->isSleeping(box));
+}
+
+//==============================================================================
+TEST(World, AdaptiveStepsSubstepImpacts)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s::Zero());
+  world->setTimeStep(0.01);
+  world->setMaxSubsteps(8);
+
+  // A ball one step away from hitting a thin fixed slab
+  SkeletonPtr ball = Skeleton::create("ball");
+  std::pair<PrismaticJoint*, BodyNode*> pairBall
+      = ball->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  PrismaticJoint* ballJoint = pairBall.first;
+  ballJoint->setAxis(Eigen::Vector3s::UnitY());
+  std::shared_ptr<SphereShape> sphereShape(new SphereShape(0.05));
+  pairBall.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      sphereShape);
+  pairBall.second->setFrictionCoeff(0.0);
+  ballJoint->setPosition(0, 0.071);
+  ballJoint->setVelocity(0, -2.0);
+  world->addSkeleton(ball);
+
+  SkeletonPtr slab = Skeleton::create("slab");
+  std::pair<WeldJoint*, BodyNode*> pairSlab
+      = slab->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(10.0, 0.02, 10.0)));
+  pairSlab.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      boxShape);
+  world->addSkeleton(slab);
+
+  WorldPtr fixedWorld = world->clone();
+  // The setting should survive cloning
+  EXPECT_EQ(fixedWorld->getMaxSubsteps(), 8);
+
+  // Free flight takes the whole step at once, exactly like step()
+  std::vector<std::shared_ptr<neural::BackpropSnapshot>> snapshots;
+  EXPECT_EQ(world->stepAdaptive(true, &snapshots), 1);
+  fixedWorld->step();
+  EXPECT_EQ(snapshots.size(), 1);
+  EXPECT_TRUE(world->getPositions() == fixedWorld->getPositions());
+  EXPECT_TRUE(world->getVelocities() == fixedWorld->getVelocities());
+
+  // Hitting the slab gets split into substeps, which still add up to one step
+  s_t time = world->getTime();
+  int substeps = world->stepAdaptive(true, &snapshots);
+  EXPECT_GT(substeps, 1);
+  EXPECT_EQ(snapshots.size(), substeps);
+  EXPECT_NEAR(world->getTime(), time + 0.01, 1e-12);
+  EXPECT_EQ(world->getTimeStep(), 0.01);
+
+  // The substep snapshots chain into each other, and into the world
+  for (int i = 0; i + 1 < substeps; i++)
+  {
+    EXPECT_TRUE(equals(
+        snapshots[i]->getPostStepPosition(),
+        snapshots[i + 1]->getPreStepPosition(),
+        0));
+    EXPECT_TRUE(equals(
+        snapshots[i]->getPostStepVelocity(),
+        snapshots[i + 1]->getPreStepVelocity(),
+        0));
+  }
+  EXPECT_TRUE(
+      equals(snapshots.back()->getPostStepPosition(), world->getPositions(), 0));
+}
+
+//==============================================================================
+/// This reads a little endian value out of a positionsToBinary() blob
+template <typename T>
+T readBinary(const std::string& blob, std::size_t offset)
+{
+  T value;
+  std::memcpy(&value, blob.data() + offset, sizeof(T));
+  return value;
+}
+
+//==============================================================================
+TEST(World, PositionsToBinaryMatchesTransforms)
+{
+  WorldPtr world = World::create();
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<FreeJoint*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<FreeJoint>(nullptr);
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(0.1, 0.2, 0.3)));
+  ShapeNode* shapeNode
+      = pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+          boxShape);
+  shapeNode->getVisualAspect()->setColor(Eigen::Vector3s(1.0, 0.5, 0.0));
+  Eigen::Vector6s pos;
+  pos << 0.1, -0.2, 0.3, 1.5, -2.5, 3.5;
+  pair.first->setPositions(pos);
+  world->addSkeleton(box);
+
+  const Eigen::Isometry3s& transform = shapeNode->getWorldTransform();
+  Eigen::Vector3s angle = math::matrixToEulerXYZ(transform.linear());
+
+  std::string blob = world->positionsToBinary();
+  ASSERT_EQ(blob.size(), 12 + 24);
+  EXPECT_EQ(blob.substr(0, 4), "NWSB");
+  EXPECT_EQ(blob[4], 1);
+  EXPECT_EQ(blob[5], 0);
+  EXPECT_EQ(readBinary<std::uint32_t>(blob, 8), 1);
+  for (int k = 0; k < 3; k++)
+  {
+    EXPECT_NEAR(
+        readBinary<float>(blob, 12 + 4 * k), transform.translation()(k), 1e-6);
+    EXPECT_NEAR(readBinary<float>(blob, 24 + 4 * k), angle(k), 1e-6);
+  }
+
+  // Quantized, with colors
+  blob = world->positionsToBinary(1e-3, true);
+  ASSERT_EQ(blob.size(), 16 + 18 + 3);
+  EXPECT_EQ(blob[5], 3);
+  EXPECT_NEAR(readBinary<float>(blob, 12), 1e-3, 1e-9);
+  for (int k = 0; k < 3; k++)
+  {
+    EXPECT_NEAR(
+        readBinary<std::int32_t>(blob, 16 + 4 * k) * 1e-3,
+        transform.translation()(k),
+        1e-3);
+    EXPECT_NEAR(
+        readBinary<std::int16_t>(blob, 28 + 2 * k) * M_PI / 32767,
+        angle(k),
+        1e-3);
+  }
+  EXPECT_EQ(static_cast<unsigned char>(blob[34]), 255);
+  EXPECT_EQ(static_cast<unsigned char>(blob[35]), 128);
+  EXPECT_EQ(static_cast<unsigned char>(blob[36]), 0);
+}
+
+//==============================================================================
+TEST(World, ParallelSkeletonUpdatesMatchSequential)
+{
+  WorldPtr world = utils::SkelParser::readWorld(
+      "dart://sample/skel/test/serial_chain_revolute_joint.skel");
+  ASSERT_TRUE(world != nullptr);
+  SkeletonPtr original = world->getSkeleton(0);
+  for (int i = 0; i < 7; i++)
+  {
+    SkeletonPtr copy = original->cloneSkeleton(
+        original->getName() + "_" + std::to_string(i));
+    world->addSkeleton(copy);
+  }
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setVelocities(Eigen::VectorXs::Random(world->getNumDofs()));
+
+  WorldPtr parallelWorld = world->clone();
+  parallelWorld->setParallelSkeletonUpdates(true);
+  EXPECT_TRUE(parallelWorld->getParallelSkeletonUpdates());
+  EXPECT_FALSE(world->getParallelSkeletonUpdates());
+  // The setting should survive cloning
+  EXPECT_TRUE(parallelWorld->clone()->getParallelSkeletonUpdates());
+
+  for (int i = 0; i < 20; i++)
+  {
+    world->step();
+    parallelWorld->step();
+  }
+
+  // Each skeleton does exactly the same math either way, so these should match
+  // to the bit
+  EXPECT_TRUE(world->getPositions() == parallelWorld->getPositions());
+  EXPECT_TRUE(world->getVelocities() == parallelWorld->getVelocities());
+}
+
+//==============================================================================
+TEST(World, StepStatsCountContactsAndSolves)
+{
+  WorldPtr world = World::create();
+  world->setTimeStep(0.01);
+
+  // A box resting (just barely penetrating) on a thin fixed slab
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<PrismaticJoint*, BodyNode*> pairBox
+      = box->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  PrismaticJoint* boxJoint = pairBox.first;
+  boxJoint->setAxis(Eigen::Vector3s::UnitY());
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(0.1, 0.1, 0.1)));
+  pairBox.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      boxShape);
+  boxJoint->setPosition(0, 0.059);
+  world->addSkeleton(box);
+
+  SkeletonPtr slab = Skeleton::create("slab");
+  std::pair<WeldJoint*, BodyNode*> pairSlab
+      = slab->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  std::shared_ptr<BoxShape> slabShape(
+      new BoxShape(Eigen::Vector3s(10.0, 0.02, 10.0)));
+  pairSlab.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      slabShape);
+  world->addSkeleton(slab);
+
+  EXPECT_EQ(world->getStepStats().numSteps, 0);
+  const int numSteps = 5;
+  for (int i = 0; i < numSteps; i++)
+  {
+    world->step();
+  }
+
+  const StepStats& stats = world->getStepStats();
+  EXPECT_EQ(stats.numSteps, numSteps);
+  EXPECT_GT(stats.lastNumContacts, 0);
+  EXPECT_EQ(stats.lastNumConstrainedGroups, 1);
+  EXPECT_GT(stats.lastLcpSize, 0);
+  EXPECT_GE(stats.totalStepNanos, stats.totalConstraintNanos);
+  EXPECT_GE(stats.totalConstraintNanos, stats.totalCollisionNanos);
+  EXPECT_GE(stats.maxStepNanos, stats.lastStepNanos);
+
+  // Every step solved exactly one constrained group, along some path
+  long numSolves = 0;
+  for (long solves : stats.numLcpSolvesByPath)
+  {
+    numSolves += solves;
+  }
+  EXPECT_EQ(numSolves, numSteps);
+  long numHistogramSteps = 0;
+  for (long count : stats.stepNanosHistogram)
+  {
+    numHistogramSteps += count;
+  }
+  EXPECT_EQ(numHistogramSteps, numSteps);
+
+  world->resetStepStats();
+  EXPECT_EQ(world->getStepStats().numSteps, 0);
+  EXPECT_EQ(world->getStepStats().totalContacts, 0);
+}
+
 //==============================================================================
 simulation::WorldPtr createWorld()
 {
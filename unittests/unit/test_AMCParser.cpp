@@ -30,6 +30,7 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <fstream>
 #include <iostream>
 #include <memory>
 
@@ -37,6 +38,7 @@
 
 #include "dart/server/GUIWebsocketServer.hpp"
 #include "dart/utils/amc/AMCParser.hpp"
+#include "dart/utils/amc/ReadSkeleton.hpp"
 
 #include "TestHelpers.hpp"
 
@@ -64,3 +66,91 @@ TEST(AMC_PARSER, READ)
   // TODO: This test is WIP
   EXPECT_TRUE(true);
 }
+
+TEST(AMC_PARSER, PARALLEL_POSES_MATCH_SERIAL)
+{
+  const std::string asfPath = "/tmp/test_AMCParser.asf";
+  const std::string amcPath = "/tmp/test_AMCParser.amc";
+
+  std::ofstream asf(asfPath);
+  asf
+      << ":version 1.10\n"
+      << ":name test\n"
+      << ":units\n"
+      << "  mass 1.0\n"
+      << "  length 0.45\n"
+      << "  angle deg\n"
+      << ":documentation\n"
+      << "  test skeleton\n"
+      << ":root\n"
+      << "   order TX TY TZ RX RY RZ\n"
+      << "   axis XYZ\n"
+      << "   position 0 0 0\n"
+      << "   orientation 0 0 0\n"
+      << ":bonedata\n"
+      << "  begin\n"
+      << "     id 1\n"
+      << "     name lhipjoint\n"
+      << "     direction 0.6 -0.7 0.3\n"
+      << "     length 2.4\n"
+      << "     axis 0 0 0  XYZ\n"
+      << "  end\n"
+      << "  begin\n"
+      << "     id 2\n"
+      << "     name lfemur\n"
+      << "     direction 0.3 -0.9 0\n"
+      << "     length 7.1\n"
+      << "     axis 0 0 20  XYZ\n"
+      << "    dof rx ry rz\n"
+      << "    limits (-160.0 20.0)\n"
+      << "           (-70.0 70.0)\n"
+      << "           (-60.0 70.0)\n"
+      << "  end\n"
+      << "  begin\n"
+      << "     id 3\n"
+      << "     name ltibia\n"
+      << "     direction 0.3 -0.9 0\n"
+      << "     length 7.5\n"
+      << "     axis 0 0 20  XYZ\n"
+      << "    dof rx\n"
+      << "    limits (-10.0 170.0)\n"
+      << "  end\n"
+      << ":hierarchy\n"
+      << "  begin\n"
+      << "    root lhipjoint\n"
+      << "    lhipjoint lfemur\n"
+      << "    lfemur ltibia\n"
+      << "  end\n";
+  asf.close();
+
+  std::ofstream amc(amcPath);
+  amc << "# generated\n:FULLY-SPECIFIED\n:DEGREES\n";
+  for (int frame = 1; frame <= 100; frame++)
+  {
+    amc << frame << "\n";
+    amc << "root";
+    for (int i = 0; i < 6; i++)
+      amc << " " << (frame * 0.5 + i);
+    amc << "\r\n";
+    amc << "lfemur " << frame << " " << -frame << " 0.25 # comment\n";
+    amc << "  ltibia " << (frame * 1.5) << "\n";
+  }
+  amc.close();
+
+  ::Library::Skeleton skel;
+  ASSERT_TRUE(::ReadSkeleton(asfPath, skel));
+  std::vector<double> serial;
+  ASSERT_TRUE(::ReadAnimation(amcPath, skel, serial));
+
+  AMCParser parser;
+  for (int numThreads : {1, 3})
+  {
+    Eigen::MatrixXs poses = parser.loadAMCPoses(asfPath, amcPath, numThreads);
+    ASSERT_EQ(skel.frame_size, poses.rows());
+    ASSERT_EQ(100, poses.cols());
+    for (int i = 0; i < poses.size(); i++)
+    {
+      EXPECT_EQ(serial[i], poses.data()[i]);
+    }
+  }
+}
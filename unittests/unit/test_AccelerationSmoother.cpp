@@ -35,4 +35,56 @@ TEST(ACCEL_SMOOTHER, BASIC)
   smoother.debugTimeSeries(smoothed.row(0));
 
   EXPECT_EQ(smoothed.cols(), timesteps - 3);
-}
\ No newline at end of file
+}
+TEST(ACCEL_SMOOTHER, MATCHES_DENSE_SOLVE)
+{
+  int dofs = 3;
+  int timesteps = 40;
+  s_t alpha = 0.5;
+  Eigen::MatrixXs data = Eigen::MatrixXs::Random(dofs, timesteps);
+
+  AccelerationSmoother smoother(timesteps, alpha);
+  Eigen::MatrixXs smoothed = smoother.smooth(data);
+
+  // Build and solve the same system densely, one row at a time
+  Eigen::Matrix4s stamp;
+  // clang-format off
+  stamp <<  1, -3,  3, -1,
+           -3,  9, -9,  3,
+            3, -9,  9, -3,
+           -1,  3, -3,  1;
+  // clang-format on
+  stamp *= alpha;
+  Eigen::MatrixXs B = Eigen::MatrixXs::Identity(timesteps, timesteps);
+  for (int i = 0; i < timesteps - 3; i++)
+  {
+    B.block<4, 4>(i, i) += stamp;
+  }
+  for (int row = 0; row < dofs; row++)
+  {
+    Eigen::VectorXs c = Eigen::VectorXs::Zero(timesteps);
+    for (int i = 0; i < timesteps - 3; i++)
+    {
+      c.segment<4>(i) += 2 * stamp * data.block<1, 4>(row, i).transpose();
+    }
+    Eigen::VectorXs deltas = B.householderQr().solve(c);
+    Eigen::VectorXs expected = data.row(row).head(timesteps - 3).transpose()
+                               - deltas.head(timesteps - 3);
+    EXPECT_TRUE(
+        equals(Eigen::VectorXs(smoothed.row(row).transpose()), expected, 1e-9));
+  }
+}
+
+TEST(ACCEL_SMOOTHER, LONG_SERIES)
+{
+  // This would need 80GB for a dense system, and should be quick when banded
+  int dofs = 2;
+  int timesteps = 100000;
+  Eigen::MatrixXs data = Eigen::MatrixXs::Random(dofs, timesteps);
+
+  AccelerationSmoother smoother(timesteps, 0.05);
+  Eigen::MatrixXs smoothed = smoother.smooth(data);
+
+  EXPECT_EQ(smoothed.cols(), timesteps - 3);
+  EXPECT_TRUE(smoothed.allFinite());
+}
@@ -57,6 +57,7 @@ TEST(ANTHROPOMETRICS, LOAD)
   compare.col(1) = mu;
   compare.col(2) = x - mu;
   std::cout << "x - mu - diff" << std::endl << compare << std::endl;
+  EXPECT_TRUE(equals(result->measureVector(skel), x, 1e-12));
 
   std::cout << "Initial log PDF: " << result->getLogPDF(skel) << std::endl;
 
@@ -101,6 +102,84 @@ TEST(ANTHROPOMETRICS, LOAD)
 }
 // #endif
 
+TEST(ANTHROPOMETRICS, CACHED_MEASUREMENTS_MATCH_FK)
+{
+  OpenSimFile file = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  std::shared_ptr<dynamics::Skeleton> skel = file.skeleton;
+  Eigen::VectorXs zeroPose = Eigen::VectorXs::Zero(skel->getNumDofs());
+
+  std::vector<AnthroMetric> metrics;
+  metrics.emplace_back(
+      "thigh",
+      zeroPose,
+      "femur_r",
+      Eigen::Vector3s(0, 0.1, 0),
+      "tibia_r",
+      Eigen::Vector3s(0, -0.2, 0.05));
+  metrics.emplace_back(
+      "height",
+      zeroPose,
+      "torso",
+      Eigen::Vector3s(0, 0.4, 0),
+      "calcn_l",
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::UnitY());
+  // This one has no BodyPose, so it gets measured in the current pose
+  metrics.emplace_back(
+      "reach",
+      Eigen::VectorXs::Zero(0),
+      "pelvis",
+      Eigen::Vector3s::Zero(),
+      "hand_r",
+      Eigen::Vector3s(0.01, 0, 0));
+  Anthropometrics anthro;
+  for (AnthroMetric& metric : metrics)
+  {
+    anthro.addMetric(
+        metric.name,
+        metric.bodyPose,
+        metric.bodyA,
+        metric.offsetA,
+        metric.bodyB,
+        metric.offsetB,
+        metric.axis);
+  }
+
+  Eigen::VectorXs originalScales = skel->getBodyScales();
+  Eigen::VectorXs pose = Eigen::VectorXs::Random(skel->getNumDofs());
+  skel->setPositions(pose);
+  for (int trial = 0; trial < 5; trial++)
+  {
+    // The metrics get linearized at the first scales we see, so they should
+    // hold up at any other scales
+    skel->setBodyScales(
+        originalScales
+        + 0.2 * Eigen::VectorXs::Random(originalScales.size()));
+
+    std::map<std::string, s_t> measured = anthro.measure(skel);
+    EXPECT_EQ(skel->getPositions(), pose);
+
+    for (AnthroMetric& metric : metrics)
+    {
+      anthro.setSkelToMetricPose(skel, metric);
+      std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerA(
+          skel->getBodyNode(metric.bodyA), metric.offsetA);
+      std::pair<dynamics::BodyNode*, Eigen::Vector3s> markerB(
+          skel->getBodyNode(metric.bodyB), metric.offsetB);
+      s_t expected
+          = metric.axis == Eigen::Vector3s::Zero()
+                ? skel->getDistanceInWorldSpace(markerA, markerB)
+                : skel->getDistanceAlongAxis(markerA, markerB, metric.axis);
+      EXPECT_NEAR(
+          static_cast<double>(measured[metric.name]),
+          static_cast<double>(expected),
+          1e-10);
+      skel->setPositions(pose);
+    }
+  }
+}
+
 #ifdef BLOCKING_GUI_TEST
 // #ifdef ALL_TESTS
 TEST(ANTHROPOMETRICS, GUI)
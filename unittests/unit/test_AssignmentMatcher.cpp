@@ -161,4 +161,123 @@ TEST(C3D, MAPPING_STR_MORE_TARGET)
     std::string t = std::to_string(mapVec[i]);
     EXPECT_EQ(mapStr[s], t);
   }
-}
\ No newline at end of file
+}
+namespace {
+
+/// This finds the best total weight of any assignment by trying them all
+s_t bruteForceBestWeight(
+    const Eigen::MatrixXs& weights,
+    const Eigen::MatrixXi& allowed,
+    int row,
+    std::vector<bool>& colUsed)
+{
+  if (row == weights.rows())
+    return 0.0;
+  // Leave this row unassigned
+  s_t best = bruteForceBestWeight(weights, allowed, row + 1, colUsed);
+  for (int col = 0; col < weights.cols(); col++)
+  {
+    if (allowed(row, col) && !colUsed[col])
+    {
+      colUsed[col] = true;
+      best = std::max(
+          best,
+          weights(row, col)
+              + bruteForceBestWeight(weights, allowed, row + 1, colUsed));
+      colUsed[col] = false;
+    }
+  }
+  return best;
+}
+
+} // namespace
+
+TEST(C3D, SPARSE_MATCHES_BRUTE_FORCE)
+{
+  srand(42);
+  for (int trial = 0; trial < 200; trial++)
+  {
+    int numRows = 1 + rand() % 6;
+    int numCols = 1 + rand() % 6;
+    Eigen::MatrixXs weights = Eigen::MatrixXs::Random(numRows, numCols);
+    Eigen::MatrixXi allowed = Eigen::MatrixXi::Zero(numRows, numCols);
+    std::vector<math::AssignmentMatcher::Edge> edges;
+    for (int i = 0; i < numRows; i++)
+    {
+      for (int j = 0; j < numCols; j++)
+      {
+        if (rand() % 2 == 0)
+        {
+          allowed(i, j) = 1;
+          edges.push_back(math::AssignmentMatcher::Edge{i, j, weights(i, j)});
+        }
+      }
+    }
+
+    Eigen::VectorXs prices;
+    Eigen::VectorXi map = math::AssignmentMatcher::assignRowsToColumnsSparse(
+        numRows, numCols, edges, &prices);
+    EXPECT_EQ(prices.size(), numCols);
+
+    s_t total = 0.0;
+    std::vector<bool> colUsed(numCols, false);
+    for (int i = 0; i < numRows; i++)
+    {
+      if (map(i) == -1)
+        continue;
+      EXPECT_EQ(allowed(i, map(i)), 1);
+      EXPECT_FALSE(colUsed[map(i)]);
+      colUsed[map(i)] = true;
+      total += weights(i, map(i));
+    }
+    std::fill(colUsed.begin(), colUsed.end(), false);
+    EXPECT_NEAR(
+        total, bruteForceBestWeight(weights, allowed, 0, colUsed), 1e-6);
+
+    // Warm starting from the last prices on a perturbed problem should still
+    // land on the optimum
+    for (auto& edge : edges)
+    {
+      edge.weight += 0.01 * ((s_t)rand() / RAND_MAX - 0.5);
+      weights(edge.row, edge.col) = edge.weight;
+    }
+    map = math::AssignmentMatcher::assignRowsToColumnsSparse(
+        numRows, numCols, edges, &prices);
+    total = 0.0;
+    for (int i = 0; i < numRows; i++)
+    {
+      if (map(i) != -1)
+        total += weights(i, map(i));
+    }
+    EXPECT_NEAR(
+        total, bruteForceBestWeight(weights, allowed, 0, colUsed), 1e-6);
+  }
+}
+
+TEST(C3D, SPARSE_MAPPING_STR)
+{
+  std::vector<std::string> source = {"a", "b", "c"};
+  std::vector<std::string> target = {"x", "y", "z"};
+
+  // Greedily taking a->x would leave b with nothing
+  std::map<std::string, std::string> map
+      = math::AssignmentMatcher::assignKeysToKeysSparse(
+          source, target, [&](std::string s) {
+            std::vector<std::pair<std::string, double>> candidates;
+            if (s == "a")
+            {
+              candidates.emplace_back("x", 1.0);
+              candidates.emplace_back("y", 0.9);
+            }
+            else if (s == "b")
+            {
+              candidates.emplace_back("x", 0.8);
+            }
+            return candidates;
+          });
+
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map["a"], "y");
+  EXPECT_EQ(map["b"], "x");
+  EXPECT_EQ(map.count("c"), 0);
+}
@@ -6,6 +6,7 @@
 #include <gtest/gtest.h>
 #include <math.h>
 
+#include "dart/biomechanics/C3DForcePlatforms.hpp"
 #include "dart/biomechanics/C3DLoader.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/common/LocalResourceRetriever.hpp"
@@ -60,6 +61,39 @@ TEST(C3D, COMPARE_TO_TRC)
   }
 }
 
+TEST(C3D, LOAD_FRAME_RANGE_AND_FIXUP)
+{
+  biomechanics::C3D full
+      = biomechanics::C3DLoader::loadC3D("dart://sample/c3d/JA1Gait35.c3d");
+  biomechanics::C3D range = biomechanics::C3DLoader::loadC3D(
+      "dart://sample/c3d/JA1Gait35.c3d", 10, 300);
+
+  ASSERT_EQ(range.markerTrajectories.getNumFrames(), 300);
+  EXPECT_EQ(range.timestamps.size(), 300);
+  EXPECT_NEAR(range.timestamps[0], full.timestamps[10], 1e-12);
+  for (int t = 0; t < range.markerTrajectories.getNumFrames(); t++)
+  {
+    for (int i = 0; i < range.markerTrajectories.getNumMarkers(); i++)
+    {
+      EXPECT_EQ(
+          range.markerTrajectories.isVisible(t, i),
+          full.markerTrajectories.isVisible(t + 10, i));
+    }
+  }
+
+  // Fixing flips during the load should match fixing them afterwards
+  biomechanics::C3DLoader::fixupMarkerFlips(&full);
+  biomechanics::C3D fixed = biomechanics::C3DLoader::loadC3D(
+      "dart://sample/c3d/JA1Gait35.c3d", 0, -1, true);
+  EXPECT_EQ(
+      fixed.markerTrajectories.getNumFrames(),
+      full.markerTrajectories.getNumFrames());
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(fixed.markerTrajectories.getPositions()),
+      Eigen::MatrixXs(full.markerTrajectories.getPositions()),
+      1e-9));
+}
+
 #ifdef ALL_TESTS
 TEST(C3D, LOAD)
 {
@@ -74,4 +108,71 @@ TEST(C3D, LOAD)
   server->renderBasis(1.0);
   biomechanics::C3DLoader::debugToGUI(c3d, server);
 }
-#endif
\ No newline at end of file
+#endif
+TEST(C3D, FORCE_PLATFORMS_RESAMPLED)
+{
+  std::string path = utils::DartResourceRetriever::create()->getFilePath(
+      "dart://sample/c3d/JA1Gait35.c3d");
+  ezc3d::c3d data(path);
+  int samplesPerFrame = data.header().nbAnalogByFrame();
+  biomechanics::ForcePlatforms platforms(data, 0);
+  ASSERT_GT(platforms.forcePlatforms().size(), 0);
+
+  for (const biomechanics::ForcePlatform& platform :
+       platforms.forcePlatforms())
+  {
+    const std::vector<Eigen::Vector3s>& forces = platform.forces();
+    const std::vector<Eigen::Vector3s>& frameForces = platform.frameForces();
+    EXPECT_EQ(frameForces.size(), data.header().nbFrames());
+    EXPECT_EQ(platform.frameCoP().size(), frameForces.size());
+
+    // The filter has unit gain at DC, so resampling shouldn't change the
+    // total impulse by more than what leaks off the ends of the trial
+    Eigen::Vector3s impulse = Eigen::Vector3s::Zero();
+    for (const Eigen::Vector3s& force : forces)
+    {
+      impulse += force;
+    }
+    Eigen::Vector3s frameImpulse = Eigen::Vector3s::Zero();
+    for (const Eigen::Vector3s& force : frameForces)
+    {
+      frameImpulse += force * samplesPerFrame;
+    }
+    EXPECT_LE(
+        (impulse - frameImpulse).norm(), 0.01 * impulse.norm() + 1e-6);
+  }
+}
+
+TEST(C3D, FIXUP_LONG_FLIP)
+{
+  // Two markers walk past each other, and from frame 700 on, the labels are
+  // swapped. Every swapped frame should be caught, even across the chunks
+  // that get unflipped in parallel.
+  int numFrames = 3000;
+  std::vector<std::string> names;
+  names.push_back("A");
+  names.push_back("B");
+  names.push_back("C");
+  biomechanics::MarkerTrajectories truth(names, numFrames);
+  for (int t = 0; t < numFrames; t++)
+  {
+    s_t x = t * 0.001;
+    truth.setPosition(t, 0, Eigen::Vector3s(x, 0, 0));
+    truth.setPosition(t, 1, Eigen::Vector3s(x, 0.2, 0));
+    truth.setPosition(t, 2, Eigen::Vector3s(x, 0.1, 0.5));
+  }
+
+  biomechanics::C3D c3d;
+  c3d.markerTrajectories = truth;
+  for (int t = 700; t < numFrames; t++)
+  {
+    c3d.markerTrajectories.swapMarkers(t, 0, 1);
+  }
+  biomechanics::C3DLoader::fixupMarkerFlips(&c3d);
+
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(c3d.markerTrajectories.getPositions()),
+      Eigen::MatrixXs(truth.getPositions()),
+      1e-12));
+  EXPECT_EQ(c3d.markerTimesteps.size(), numFrames);
+}
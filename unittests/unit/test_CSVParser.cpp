@@ -56,3 +56,64 @@ TEST(CSVParser, BASICS)
     }
   }
 }
+
+//==============================================================================
+TEST(CSVParser, WRITE_AND_PARSE_MATRIX)
+{
+  Eigen::MatrixXs matrix = Eigen::MatrixXs::Random(50, 7);
+  matrix(3, 2) = 1e-300;
+  matrix(4, 5) = -12345.678;
+
+  const std::string path = "/tmp/test_CSVParser_matrix.csv";
+  {
+    CSVParser::CSVWriter writer(path, ", ", 128);
+    ASSERT_TRUE(writer.isOpen());
+    writer.writeMatrix(matrix);
+  }
+
+  // The writer round trips exactly, whether the file is streamed through a
+  // tiny chunk buffer or split across threads
+  EXPECT_EQ(matrix, CSVParser::parseMatrix(path));
+  EXPECT_EQ(matrix, CSVParser::parseMatrix(path, nullptr, 4));
+}
+
+//==============================================================================
+TEST(CSVParser, PARSE_COLUMNS)
+{
+  const std::string path = "/tmp/test_CSVParser_columns.csv";
+  {
+    CSVParser::CSVWriter writer(path);
+    writer.writeField("time").writeField("x").writeField("label").endRow();
+    for (int i = 0; i < 100; i++)
+    {
+      writer.writeField(i * 0.01)
+          .writeField(i)
+          .writeField("row" + std::to_string(i))
+          .endRow();
+    }
+  }
+
+  CSVParser::CSVReader reader(path, true, nullptr, 64);
+  ASSERT_TRUE(reader.isOpen());
+  EXPECT_EQ(1, reader.getColumnIndex("x"));
+  EXPECT_EQ(-1, reader.getColumnIndex("y"));
+  std::vector<std::string> fields;
+  ASSERT_TRUE(reader.readRow(fields));
+  ASSERT_EQ(3, fields.size());
+  EXPECT_EQ("row0", fields[2]);
+
+  for (int numThreads : {1, 3})
+  {
+    Eigen::MatrixXs columns = CSVParser::parseColumns(
+        path, {"x", "missing", "label", "time"}, nullptr, numThreads);
+    ASSERT_EQ(100, columns.rows());
+    ASSERT_EQ(4, columns.cols());
+    for (int i = 0; i < 100; i++)
+    {
+      EXPECT_EQ(i, columns(i, 0));
+      EXPECT_TRUE(std::isnan(columns(i, 1)));
+      EXPECT_TRUE(std::isnan(columns(i, 2)));
+      EXPECT_EQ(i * 0.01, columns(i, 3));
+    }
+  }
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "dart/common/CachedResourceRetriever.hpp"
+#include "dart/common/LocalResourceRetriever.hpp"
+#include "TestHelpers.hpp"
+
+using dart::common::CachedResourceRetriever;
+using dart::common::LocalResourceRetriever;
+using dart::common::Resource;
+
+namespace {
+
+std::shared_ptr<CachedResourceRetriever> createRetriever()
+{
+  return std::make_shared<CachedResourceRetriever>(
+      std::make_shared<LocalResourceRetriever>());
+}
+
+} // anonymous namespace
+
+TEST(CachedResourceRetriever, retrieve_PathDoesNotExist_ReturnsNull)
+{
+  CachedResourceRetriever::clearCache();
+  auto retriever = createRetriever();
+  EXPECT_FALSE(retriever->exists(DART_DATA_PATH "does/not/exist"));
+  EXPECT_EQ(nullptr, retriever->retrieve(DART_DATA_PATH "does/not/exist"));
+  EXPECT_EQ(0u, CachedResourceRetriever::getCachedBytes());
+}
+
+TEST(CachedResourceRetriever, readAll_SharedAcrossRetrievers)
+{
+  CachedResourceRetriever::clearCache();
+  const std::string content = "Hello World";
+
+  auto first = createRetriever();
+  EXPECT_EQ(content, first->readAll(DART_DATA_PATH "test/hello_world.txt"));
+  EXPECT_EQ(content.size(), CachedResourceRetriever::getCachedBytes());
+
+  // A second retriever (like one built by another parser) hits the same entry
+  auto second = createRetriever();
+  EXPECT_TRUE(second->exists(DART_DATA_PATH "test/hello_world.txt"));
+  EXPECT_EQ(content, second->readAll(DART_DATA_PATH "test/hello_world.txt"));
+  EXPECT_EQ(content.size(), CachedResourceRetriever::getCachedBytes());
+
+  CachedResourceRetriever::clearCache();
+  EXPECT_EQ(0u, CachedResourceRetriever::getCachedBytes());
+}
+
+TEST(CachedResourceRetriever, setMaxCacheBytes_Evicts)
+{
+  CachedResourceRetriever::clearCache();
+  const std::size_t oldMax = CachedResourceRetriever::getMaxCacheBytes();
+  auto retriever = createRetriever();
+
+  CachedResourceRetriever::setMaxCacheBytes(4);
+  auto resource = retriever->retrieve(DART_DATA_PATH "test/hello_world.txt");
+  ASSERT_TRUE(resource != nullptr);
+  // Too big to cache, but still retrieved
+  EXPECT_EQ(0u, CachedResourceRetriever::getCachedBytes());
+  EXPECT_EQ("Hello World", resource->readAll());
+
+  CachedResourceRetriever::setMaxCacheBytes(oldMax);
+  retriever->retrieve(DART_DATA_PATH "test/hello_world.txt");
+  EXPECT_EQ(11u, CachedResourceRetriever::getCachedBytes());
+  CachedResourceRetriever::setMaxCacheBytes(4);
+  EXPECT_EQ(0u, CachedResourceRetriever::getCachedBytes());
+  // Evicting doesn't invalidate resources that were already handed out
+  EXPECT_EQ("Hello World", resource->readAll());
+
+  CachedResourceRetriever::setMaxCacheBytes(oldMax);
+}
+
+TEST(CachedResourceRetriever, retrieve_ResourceOperations)
+{
+  CachedResourceRetriever::clearCache();
+  const std::string content = "Hello World";
+
+  std::vector<char> buffer(100, '\0');
+
+  auto retriever = createRetriever();
+  auto resource = retriever->retrieve(DART_DATA_PATH "test/hello_world.txt");
+  ASSERT_TRUE(resource != nullptr);
+
+  EXPECT_EQ(content.size(), resource->getSize());
+
+  // Relative seek.
+  ASSERT_TRUE(resource->seek(2, Resource::SEEKTYPE_CUR));
+  EXPECT_EQ(2u, resource->tell());
+
+  // Absolute seek.
+  ASSERT_TRUE(resource->seek(5, Resource::SEEKTYPE_SET));
+  EXPECT_EQ(5u, resource->tell());
+
+  // Seek to the end of the file.
+  ASSERT_TRUE(resource->seek(0, Resource::SEEKTYPE_END));
+  EXPECT_EQ(content.size(), resource->tell());
+
+  ASSERT_TRUE(resource->seek(-3, Resource::SEEKTYPE_END));
+  EXPECT_EQ(content.size() - 3, resource->tell());
+
+  // Reading a block that's too large should do nothing.
+  ASSERT_TRUE(resource->seek(0, Resource::SEEKTYPE_SET));
+  ASSERT_EQ(0u, resource->read(buffer.data(), content.size() + 1, 1));
+
+  // Reading should only return full blocks.
+  buffer.assign(buffer.size(), '\0');
+  ASSERT_TRUE(resource->seek(0, Resource::SEEKTYPE_SET));
+  ASSERT_EQ(1u, resource->read(buffer.data(), 8, 1));
+  EXPECT_STREQ(content.substr(0, 8).c_str(), buffer.data());
+
+  // Reading multiple blocks
+  buffer.assign(buffer.size(), '\0');
+  ASSERT_TRUE(resource->seek(0, Resource::SEEKTYPE_SET));
+  ASSERT_EQ(2u, resource->read(buffer.data(), 4, 2));
+  EXPECT_STREQ(content.substr(0, 8).c_str(), buffer.data());
+}
@@ -0,0 +1,87 @@
+#include <string>
+#include <unordered_map>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/math/CompactMatrix.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+
+TEST(CompactMatrix, ROUND_TRIP)
+{
+  srand(42);
+  Eigen::MatrixXs mat = Eigen::MatrixXs::Random(30, 200) * 10;
+  math::CompactMatrix compact(mat);
+  EXPECT_EQ(compact.rows(), 30);
+  EXPECT_EQ(compact.cols(), 200);
+  EXPECT_EQ(compact.bytes(), 30 * 200 * sizeof(float));
+
+  // Single precision keeps about 7 significant digits
+  Eigen::MatrixXs expanded = compact.toMatrix();
+  EXPECT_TRUE(equals(expanded, mat, 1e-5));
+  EXPECT_TRUE(equals(compact.col(17), Eigen::VectorXs(mat.col(17)), 1e-5));
+
+  Eigen::VectorXs newCol = Eigen::VectorXs::Random(30);
+  compact.setCol(3, newCol);
+  EXPECT_TRUE(equals(compact.col(3), newCol, 1e-6));
+}
+
+TEST(CompactMatrix, MOT_POSES)
+{
+  biomechanics::OpenSimMot mot;
+  mot.poses = Eigen::MatrixXs::Random(10, 50);
+  Eigen::MatrixXs original = mot.poses;
+
+  mot.compactPoses();
+  EXPECT_EQ(mot.poses.size(), 0);
+  EXPECT_EQ(mot.compactedPoses.cols(), 50);
+  EXPECT_TRUE(equals(mot.getPoses(), original, 1e-6));
+
+  // Compacting again shouldn't lose anything
+  mot.compactPoses();
+  EXPECT_TRUE(equals(mot.getPoses(), original, 1e-6));
+}
+
+TEST(CompactMatrix, TRAJECTORY_ROLLOUT)
+{
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  std::unordered_map<std::string, Eigen::MatrixXs> metadata;
+  pos["identity"] = Eigen::MatrixXs::Random(4, 20);
+  vel["identity"] = Eigen::MatrixXs::Random(4, 20);
+  force["identity"] = Eigen::MatrixXs::Random(3, 20);
+  metadata["meta"] = Eigen::MatrixXs::Random(2, 2);
+  Eigen::VectorXs mass = Eigen::VectorXs::Random(2);
+  trajectory::TrajectoryRolloutReal rollout(pos, vel, force, mass, metadata);
+
+  trajectory::CompactTrajectoryRollout compact(&rollout);
+  EXPECT_EQ(compact.bytes(), ((4 + 4 + 3) * 20 + 2) * sizeof(float));
+
+  trajectory::TrajectoryRolloutReal expanded = compact.toRollout();
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(expanded.getPosesConst()), pos["identity"], 1e-6));
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(expanded.getVelsConst()), vel["identity"], 1e-6));
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(expanded.getControlForcesConst()),
+      force["identity"],
+      1e-6));
+  EXPECT_TRUE(equals(Eigen::VectorXs(expanded.getMassesConst()), mass, 1e-6));
+  // Metadata stays in full precision
+  EXPECT_EQ(expanded.getMetadata("meta"), metadata["meta"]);
+
+  // Slices don't have a flat buffer of their own, but compact the same way
+  trajectory::TrajectoryRolloutRef slice = rollout.slice(5, 10);
+  trajectory::CompactTrajectoryRollout compactSlice(&slice);
+  trajectory::TrajectoryRolloutReal expandedSlice = compactSlice.toRollout();
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(expandedSlice.getPosesConst()),
+      Eigen::MatrixXs(pos["identity"].block(0, 5, 4, 10)),
+      1e-6));
+}
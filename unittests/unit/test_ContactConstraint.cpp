@@ -109,3 +109,117 @@ TEST(ContactConstraint, ContactWithKinematicJoint)
       std::make_shared<constraint::PgsBoxedLcpSolver>(), 1e-4);
 #endif
 }
+
+//==============================================================================
+std::shared_ptr<simulation::World> createBoxOnGround(
+    const constraint::BoxedLcpSolverPtr& lcpSolver)
+{
+  auto world = std::make_shared<simulation::World>();
+  world->setConstraintSolver(
+      std::make_unique<constraint::BoxedLcpConstraintSolver>(lcpSolver));
+
+  auto ground = dynamics::Skeleton::create("ground");
+  auto groundPair = ground->createJointAndBodyNodePair<dynamics::WeldJoint>();
+  groundPair.second
+      ->createShapeNodeWith<VisualAspect, CollisionAspect, DynamicsAspect>(
+          std::make_shared<dynamics::BoxShape>(
+              Eigen::Vector3s(10.0, 10.0, 1.0)));
+  world->addSkeleton(ground);
+
+  auto box = dynamics::Skeleton::create("box");
+  auto boxPair = box->createJointAndBodyNodePair<dynamics::FreeJoint>();
+  boxPair.second
+      ->createShapeNodeWith<VisualAspect, CollisionAspect, DynamicsAspect>(
+          std::make_shared<dynamics::BoxShape>(
+              Eigen::Vector3s(0.5, 0.5, 0.5)));
+  boxPair.second->setFrictionCoeff(0.5);
+  box->setPosition(5, 0.749);
+  box->setVelocity(3, 0.2);
+  world->addSkeleton(box);
+
+  return world;
+}
+
+//==============================================================================
+void testContactWarmStart(
+    const constraint::BoxedLcpSolverPtr& lcpSolver, s_t tol)
+{
+  auto warm = createBoxOnGround(lcpSolver);
+  auto cold = createBoxOnGround(lcpSolver);
+  auto coldSolver = static_cast<constraint::BoxedLcpConstraintSolver*>(
+      cold->getConstraintSolver());
+  coldSolver->setWarmStartContactTolerance(0.0);
+
+  for (auto i = 0u; i < 50; ++i)
+  {
+    warm->step();
+    cold->step();
+    // Warm starting should only change how quickly we find the solution, not
+    // which solution we find
+    EXPECT_TRUE(equals(warm->getPositions(), cold->getPositions(), tol));
+    EXPECT_TRUE(equals(warm->getVelocities(), cold->getVelocities(), tol));
+  }
+
+  // The box should have come to rest on the ground, rather than sinking
+  // through it
+  EXPECT_GT(warm->getSkeleton("box")->getPosition(5), 0.7);
+}
+
+//==============================================================================
+TEST(ContactConstraint, ContactWarmStartMatchesColdStart)
+{
+  testContactWarmStart(
+      std::make_shared<constraint::DantzigBoxedLcpSolver>(), 1e-6);
+  testContactWarmStart(
+      std::make_shared<constraint::PgsBoxedLcpSolver>(), 1e-3);
+}
+
+//==============================================================================
+TEST(ContactConstraint, AdaptiveSelectionSkipsPrimaryForLargeLcps)
+{
+  auto world
+      = createBoxOnGround(std::make_shared<constraint::DantzigBoxedLcpSolver>());
+  auto solver = static_cast<constraint::BoxedLcpConstraintSolver*>(
+      world->getConstraintSolver());
+  // Every LCP counts as "large", so everything should go to PGS
+  solver->setAdaptiveSelectionOption(
+      constraint::BoxedLcpConstraintSolver::AdaptiveSelectionOption(true, 0));
+
+  for (auto i = 0u; i < 50; ++i)
+  {
+    world->step();
+  }
+
+  EXPECT_EQ(solver->getNumLcpSolves(constraint::ConstraintSolver::PRIMARY), 0);
+  EXPECT_GT(solver->getNumPrimarySolverSkips(), 0);
+  // PGS should still keep the box on the ground
+  EXPECT_GT(world->getSkeleton("box")->getPosition(5), 0.7);
+}
+
+//==============================================================================
+TEST(ContactConstraint, PooledConstraintsKeepReferenceCounts)
+{
+  auto world
+      = createBoxOnGround(std::make_shared<constraint::DantzigBoxedLcpSolver>());
+  dynamics::SkeletonPtr ground = world->getSkeleton("ground");
+  dynamics::SkeletonPtr box = world->getSkeleton("box");
+  dynamics::BodyNode* groundBody = ground->getBodyNode(0);
+  dynamics::BodyNode* boxBody = box->getBodyNode(0);
+  const int groundCount = groundBody->getReferenceCount();
+  const int boxCount = boxBody->getReferenceCount();
+
+  // Contact constraints are recycled from the pool on every step after the
+  // first, and each live one should hold a reference to both bodies
+  for (auto i = 0u; i < 50; ++i)
+  {
+    world->step();
+    EXPECT_GT(groundBody->getReferenceCount(), groundCount);
+    EXPECT_GT(boxBody->getReferenceCount(), boxCount);
+  }
+
+  // Destroying the world releases the pooled constraints, which should give
+  // back exactly the references they took
+  world.reset();
+  EXPECT_EQ(groundBody->getReferenceCount(), groundCount);
+  EXPECT_EQ(boxBody->getReferenceCount(), boxCount);
+}
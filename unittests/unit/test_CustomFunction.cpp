@@ -4,8 +4,11 @@
 #include <gtest/gtest.h>
 
 #include "dart/dart.hpp"
+#include "dart/math/ConstantFunction.hpp"
 #include "dart/math/LinearFunction.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/PackedCustomFunctions.hpp"
+#include "dart/math/PolynomialFunction.hpp"
 #include "dart/math/SimmSpline.hpp"
 
 #include "TestHelpers.hpp"
@@ -42,4 +45,69 @@ TEST(CustomFunction, BASIC)
   EXPECT_EQ(fn->calcValue(0.0), 0.0);
   EXPECT_EQ(fn->calcValue(1.0), 1.0);
   EXPECT_EQ(fn->calcValue(2.0), 2.0);
-}
\ No newline at end of file
+}
+//==============================================================================
+TEST(CustomFunction, PACKED_MATCHES_VIRTUAL)
+{
+  std::vector<s_t> xs;
+  std::vector<s_t> ys;
+  for (int i = 0; i < 13; i++)
+  {
+    xs.push_back(i * 0.174533);
+    ys.push_back(sin(i * 0.3) * 0.05);
+  }
+
+  std::vector<std::shared_ptr<CustomFunction>> fns;
+  fns.push_back(std::make_shared<SimmSpline>(xs, ys));
+  fns.push_back(std::make_shared<PolynomialFunction>(
+      std::vector<s_t>{0.1, -0.5, 0.25, 0.125, -0.0625}));
+  fns.push_back(std::make_shared<LinearFunction>(2.0, -1.0));
+  fns.push_back(std::make_shared<ConstantFunction>(0.3));
+
+  PackedCustomFunctions packed;
+  packed.pack(fns);
+  EXPECT_EQ(4, packed.size());
+
+  // Sweep forwards and backwards (which exercises the cached spline segment),
+  // then jump around (which exercises the binary search fallback), including
+  // points off both ends of the spline
+  std::vector<s_t> points;
+  for (int i = -10; i <= 230; i++)
+    points.push_back(i * 0.01);
+  for (int i = 230; i >= -10; i--)
+    points.push_back(i * 0.01);
+  for (int i = 0; i < 50; i++)
+    points.push_back(((i * 37) % 25) * 0.1 - 0.2);
+  for (s_t x : xs)
+    points.push_back(x);
+
+  for (s_t x : points)
+  {
+    for (int i = 0; i < fns.size(); i++)
+    {
+      Eigen::Vector4s expected;
+      expected(0) = fns[i]->calcValue(x);
+      expected(1) = fns[i]->calcDerivative(1, x);
+      expected(2) = fns[i]->calcDerivative(2, x);
+      expected(3) = fns[i]->calcDerivative(3, x);
+      Eigen::Vector4s actual = packed.evaluate(i, x);
+      // The third derivative of splines is discontinuous at the knots, so
+      // only check it away from them
+      bool atKnot = false;
+      for (s_t knot : xs)
+        atKnot |= std::abs(knot - x) < 1e-12;
+      int numToCheck = (i == 0 && atKnot) ? 3 : 4;
+      if (!equals(
+              expected.head(numToCheck).eval(),
+              actual.head(numToCheck).eval(),
+              1e-12))
+      {
+        std::cout << "Function " << i << " mismatch at x=" << x << std::endl
+                  << "Expected: " << expected.transpose() << std::endl
+                  << "Actual: " << actual.transpose() << std::endl;
+        EXPECT_TRUE(false);
+        return;
+      }
+    }
+  }
+}
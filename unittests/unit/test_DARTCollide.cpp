@@ -1,5 +1,6 @@
 #define _USE_MATH_DEFINES
 #include <algorithm> // std::sort
+#include <thread>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -4189,6 +4190,194 @@ TEST(DARTCollide, CAPSULE_CCD_SUPPORT_FN)
 }
 #endif
 
+//==============================================================================
+#ifdef ALL_TESTS
+TEST(DARTCollide, SUPPORT_HULL_MATCHES_SCAN)
+{
+  // Points on (and inside) an ellipsoid, with every point repeated, like mesh
+  // vertices shared between faces
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 500; i++)
+  {
+    Eigen::Vector3s point = Eigen::Vector3s::Random().normalized();
+    if (i % 3 == 0)
+      point *= 0.5;
+    point = point.cwiseProduct(Eigen::Vector3s(3.0, 1.0, 0.2));
+    points.push_back(point);
+    points.push_back(point);
+  }
+  math::SupportHull hull(points);
+  EXPECT_TRUE(hull.hasAdjacency());
+  EXPECT_LT(hull.getVertices().size(), points.size());
+
+  int hint = 0;
+  for (int i = 0; i < 1000; i++)
+  {
+    Eigen::Vector3s dir = Eigen::Vector3s::Random();
+    s_t bestDot = -std::numeric_limits<s_t>::infinity();
+    for (Eigen::Vector3s& point : points)
+    {
+      bestDot = std::max(bestDot, dir.dot(point));
+    }
+    hint = hull.findSupport(dir, hint);
+    EXPECT_NEAR(
+        static_cast<double>(dir.dot(hull.getVertices()[hint])),
+        static_cast<double>(bestDot),
+        1e-12);
+  }
+
+  for (Eigen::Vector3s& point : points)
+  {
+    EXPECT_LE(
+        (point - hull.getBoundingSphereCenter()).norm(),
+        hull.getBoundingSphereRadius() + 1e-12);
+  }
+
+  // Flat input can't make a 3D hull, but should still answer queries
+  std::vector<Eigen::Vector3s> flat;
+  for (int i = 0; i < 100; i++)
+  {
+    flat.push_back(Eigen::Vector3s(i % 10, i / 10, 0));
+  }
+  math::SupportHull flatHull(flat);
+  EXPECT_FALSE(flatHull.hasAdjacency());
+  EXPECT_EQ(
+      flatHull.getVertices()[flatHull.findSupport(Eigen::Vector3s(1, 1, 0))],
+      Eigen::Vector3s(9, 9, 0));
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST(DARTCollide, MESH_HULL_MATCHES_VERTEX_SCAN)
+{
+  aiScene* boxMesh = createBoxMeshUnsafe();
+  std::vector<Eigen::Vector3s> vertices;
+  for (int i = 0; i < boxMesh->mNumMeshes; i++)
+  {
+    aiMesh* m = boxMesh->mMeshes[i];
+    for (int k = 0; k < m->mNumVertices; k++)
+    {
+      vertices.emplace_back(
+          m->mVertices[k].x, m->mVertices[k].y, m->mVertices[k].z);
+    }
+  }
+  math::SupportHull hull(vertices);
+
+  Eigen::Vector3s size0 = Eigen::Vector3s(2.0, 4.0, 1.0);
+  Eigen::Vector3s size1 = Eigen::Vector3s(1.0, 1.0, 1.0);
+  Eigen::Isometry3s T0 = Eigen::Isometry3s::Identity();
+  Eigen::Isometry3s T1 = Eigen::Isometry3s::Identity();
+  T1.translation() = Eigen::Vector3s(0.2, 0.1, 0.9);
+  T1.linear() = math::eulerXYZToMatrix(Eigen::Vector3s(0.1, 0.2, 0.3));
+
+  CollisionOption option;
+  CollisionResult scanResult;
+  collideMeshMesh(
+      nullptr,
+      nullptr,
+      boxMesh,
+      size0,
+      T0,
+      boxMesh,
+      size1,
+      T1,
+      option,
+      scanResult);
+  clearCcdCache();
+  CollisionResult hullResult;
+  collideMeshMesh(
+      nullptr,
+      nullptr,
+      boxMesh,
+      size0,
+      T0,
+      boxMesh,
+      size1,
+      T1,
+      option,
+      hullResult,
+      &hull,
+      &hull);
+  EXPECT_GT(scanResult.getNumContacts(), 0);
+  EXPECT_EQ(scanResult.getNumContacts(), hullResult.getNumContacts());
+  for (int i = 0; i < scanResult.getNumContacts(); i++)
+  {
+    EXPECT_TRUE(equals(
+        scanResult.getContact(i).point, hullResult.getContact(i).point));
+  }
+
+  // Far apart, the bounding volumes reject the pair before MPR runs
+  T1.translation() = Eigen::Vector3s(0, 0, 5);
+  CollisionResult farResult;
+  collideMeshMesh(
+      nullptr,
+      nullptr,
+      boxMesh,
+      size0,
+      T0,
+      boxMesh,
+      size1,
+      T1,
+      option,
+      farResult,
+      &hull,
+      &hull);
+  EXPECT_EQ(farResult.getNumContacts(), 0);
+  EXPECT_TRUE(hullsDisjoint(&hull, size0, T0, &hull, size1, T1));
+  EXPECT_FALSE(hullsDisjoint(&hull, size0, T0, nullptr, size1, T1));
+  clearCcdCache();
+}
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST(DARTCollide, CCD_WARM_START_CACHE)
+{
+  // The cache only uses the pointers as keys, so these never get dereferenced
+  std::vector<char> storage(1024);
+  auto object = [&](int i) { return (CollisionObject*)(&storage[i]); };
+
+  clearCcdCache();
+  ccd_vec3_t& dir = getCachedCcdDir(object(0), object(1));
+  EXPECT_EQ(dir.v[0], 0.0);
+  dir.v[0] = 3.0;
+  getCachedCcdPos(object(0), object(1)).v[1] = 4.0;
+
+  // The same ordered pair comes back with its warm start intact
+  EXPECT_EQ(getCachedCcdDir(object(0), object(1)).v[0], 3.0);
+  EXPECT_EQ(getCachedCcdPos(object(0), object(1)).v[1], 4.0);
+  EXPECT_EQ(getCachedCcdDir(object(1), object(0)).v[0], 0.0);
+
+  // Other threads get their own cache
+  std::thread other([&]() {
+    EXPECT_EQ(getCcdCacheSize(), 0u);
+    EXPECT_EQ(getCachedCcdDir(object(0), object(1)).v[0], 0.0);
+  });
+  other.join();
+  EXPECT_EQ(getCachedCcdDir(object(0), object(1)).v[0], 3.0);
+
+  // Clearing resets the stale entry lazily, in place
+  std::size_t size = getCcdCacheSize();
+  clearCcdCache();
+  EXPECT_EQ(getCcdCacheSize(), size);
+  EXPECT_EQ(getCachedCcdDir(object(0), object(1)).v[0], 0.0);
+  EXPECT_EQ(getCachedCcdPos(object(0), object(1)).v[1], 0.0);
+
+  // Stale pairs get evicted, rather than growing the cache forever
+  for (int round = 0; round < 10; round++)
+  {
+    clearCcdCache();
+    for (int i = 0; i < 100; i++)
+    {
+      getCachedCcdDir(object(round * 100 + i), object(1023));
+    }
+  }
+  EXPECT_LT(getCcdCacheSize(), 500);
+  clearCcdCache();
+}
+#endif
+
 // The number of contacts shouldn't change under tiny perturbations to position,
 // and the contacts should move in predictable ways.
 
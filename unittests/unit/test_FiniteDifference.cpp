@@ -0,0 +1,170 @@
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/math/FiniteDifference.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+
+namespace {
+
+/// This is a chain of coupled sines, so output `i` only depends on inputs
+/// `i - 1`, `i`, and `i + 1`, which gives a tridiagonal Jacobian
+Eigen::VectorXs evalChain(const Eigen::VectorXs& x)
+{
+  Eigen::VectorXs out(x.size());
+  for (int i = 0; i < x.size(); i++)
+  {
+    s_t prev = i > 0 ? x(i - 1) : 0.0;
+    s_t next = i + 1 < x.size() ? x(i + 1) : 0.0;
+    out(i) = std::sin(x(i)) * (1.0 + prev) + next * next;
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(FiniteDifference, PARALLEL_MATCHES_SERIAL)
+{
+  Eigen::VectorXs x = Eigen::VectorXs::LinSpaced(8, -0.5, 0.7);
+  for (bool useRidders : {false, true})
+  {
+    s_t eps = useRidders ? 1e-3 : 1e-7;
+    Eigen::MatrixXs serial(8, 8);
+    math::finiteDifference(
+        [&](s_t eps, int dof, Eigen::VectorXs& perturbed) {
+          Eigen::VectorXs tweaked = x;
+          tweaked(dof) += eps;
+          perturbed = evalChain(tweaked);
+          return true;
+        },
+        serial,
+        eps,
+        useRidders);
+
+    std::atomic<int> numWorkers(0);
+    Eigen::MatrixXs parallel(8, 8);
+    math::finiteDifferenceParallel(
+        [&]() -> std::function<bool(s_t, int, Eigen::VectorXs&)> {
+          numWorkers++;
+          return [x](s_t eps, int dof, Eigen::VectorXs& perturbed) {
+            Eigen::VectorXs tweaked = x;
+            tweaked(dof) += eps;
+            perturbed = evalChain(tweaked);
+            return true;
+          };
+        },
+        parallel,
+        eps,
+        useRidders);
+
+    EXPECT_TRUE(equals(serial, parallel, 0));
+    EXPECT_GE(numWorkers.load(), 1);
+    EXPECT_LE(numWorkers.load(), 8);
+  }
+}
+
+TEST(FiniteDifference, COLOR_TRIDIAGONAL_COLUMNS)
+{
+  std::vector<std::vector<int>> columnRows;
+  for (int col = 0; col < 10; col++)
+  {
+    std::vector<int> rows;
+    for (int row = std::max(0, col - 1); row <= std::min(9, col + 1); row++)
+    {
+      rows.push_back(row);
+    }
+    columnRows.push_back(rows);
+  }
+
+  std::vector<std::vector<int>> groups
+      = math::colorJacobianColumns(columnRows, 10);
+  EXPECT_EQ(groups.size(), 3);
+  std::vector<int> seen(10, 0);
+  for (const std::vector<int>& group : groups)
+  {
+    std::vector<int> rowsTaken(10, 0);
+    for (int col : group)
+    {
+      seen[col]++;
+      for (int row : columnRows[col])
+      {
+        EXPECT_EQ(rowsTaken[row], 0);
+        rowsTaken[row] = 1;
+      }
+    }
+  }
+  for (int col = 0; col < 10; col++)
+  {
+    EXPECT_EQ(seen[col], 1);
+  }
+}
+
+TEST(FiniteDifference, SPARSE_MATCHES_DENSE)
+{
+  const int n = 12;
+  Eigen::VectorXs x = Eigen::VectorXs::LinSpaced(n, -0.9, 0.4);
+  std::vector<std::vector<int>> columnRows;
+  for (int col = 0; col < n; col++)
+  {
+    std::vector<int> rows;
+    for (int row = std::max(0, col - 1); row <= std::min(n - 1, col + 1);
+         row++)
+    {
+      rows.push_back(row);
+    }
+    columnRows.push_back(rows);
+  }
+
+  for (bool useRidders : {false, true})
+  {
+    s_t eps = useRidders ? 1e-3 : 1e-7;
+    Eigen::MatrixXs dense(n, n);
+    math::finiteDifference(
+        [&](s_t eps, int dof, Eigen::VectorXs& perturbed) {
+          Eigen::VectorXs tweaked = x;
+          tweaked(dof) += eps;
+          perturbed = evalChain(tweaked);
+          return true;
+        },
+        dense,
+        eps,
+        useRidders);
+
+    std::atomic<int> numEvals(0);
+    Eigen::MatrixXs sparse(n, n);
+    math::finiteDifferenceParallel(
+        [&]() -> std::function<bool(
+                  s_t, const std::vector<int>&, Eigen::VectorXs&)> {
+          return [x, &numEvals](
+                     s_t eps,
+                     const std::vector<int>& dofs,
+                     Eigen::VectorXs& perturbed) {
+            numEvals++;
+            Eigen::VectorXs tweaked = x;
+            for (int dof : dofs)
+            {
+              tweaked(dof) += eps;
+            }
+            perturbed = evalChain(tweaked);
+            return true;
+          };
+        },
+        columnRows,
+        sparse,
+        eps,
+        useRidders);
+
+    EXPECT_TRUE(equals(dense, sparse, useRidders ? 1e-8 : 1e-6));
+    // Only 3 groups of columns, instead of one per column
+    if (!useRidders)
+    {
+      EXPECT_EQ(numEvals.load(), 3 * 2);
+    }
+  }
+}
@@ -1248,3 +1248,27 @@ TEST(LIE_GROUP_OPERATORS, ADJOINT_MAPPINGS)
   }
 }
 #endif
+
+/******************************************************************************/
+#ifdef ALL_TESTS
+TEST(LIE_GROUP_OPERATORS, BATCHED_EXPONENTIAL_MAPPINGS)
+{
+  int numTest = 100;
+  Eigen::MatrixXs expmaps = Eigen::MatrixXs::Random(3, numTest) * 3;
+  // Cover the small angle expansions and the rotations by pi
+  expmaps.col(0).setZero();
+  expmaps.col(1) *= 1e-5;
+  expmaps.col(2) = Eigen::Vector3s::UnitX() * constantsd::pi();
+
+  Eigen::MatrixXs rotations = math::expMapRotBatch(expmaps);
+  Eigen::MatrixXs logs = math::logMapBatch(rotations);
+  for (int i = 0; i < numTest; ++i)
+  {
+    Eigen::Map<const Eigen::Matrix3s> R(rotations.col(i).data());
+    EXPECT_TRUE(equals(
+        Eigen::Matrix3s(R), math::expMapRot(expmaps.col(i)), 1e-12));
+    EXPECT_TRUE(equals(
+        Eigen::Vector3s(logs.col(i)), math::logMap(Eigen::Matrix3s(R)), 1e-12));
+  }
+}
+#endif
@@ -146,4 +146,56 @@ TEST(MarkerFitter, EVAL_PERFORMANCE)
   // report.saveCSVMarkerErrorReport("./test.csv");
 }
 // #endif
-// #endif
\ No newline at end of file
+// #endif
+TEST(IKErrorReport, INCREMENTAL_MATCHES_BATCH)
+{
+  OpenSimFile scaled = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/Rajagopal_scaled.osim");
+  OpenSimTRC markerTrajectories = OpenSimParser::loadTRC(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "S01DN603.trc");
+  OpenSimMot mot = OpenSimParser::loadMot(
+      scaled.skeleton,
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "S01DN603_ik.mot");
+
+  biomechanics::IKErrorReport batch(
+      scaled.skeleton,
+      scaled.markersMap,
+      mot.poses,
+      markerTrajectories.markerTimesteps);
+
+  // Feed the same trial in uneven chunks, as if it were coming out of IK
+  biomechanics::IKErrorReport incremental(
+      scaled.skeleton, scaled.markersMap, batch.markerNames);
+  int numTimesteps = markerTrajectories.markerTimesteps.size();
+  const int chunkSize = 37;
+  for (int start = 0; start < numTimesteps; start += chunkSize)
+  {
+    int size = std::min(chunkSize, numTimesteps - start);
+    std::vector<std::map<std::string, Eigen::Vector3s>> chunk(
+        markerTrajectories.markerTimesteps.begin() + start,
+        markerTrajectories.markerTimesteps.begin() + start + size);
+    incremental.addTimesteps(mot.poses.middleCols(start, size), chunk);
+  }
+
+  EXPECT_EQ(batch.rootMeanSquaredError.size(), numTimesteps);
+  EXPECT_EQ(incremental.rootMeanSquaredError.size(), numTimesteps);
+  EXPECT_NEAR(
+      batch.averageRootMeanSquaredError,
+      incremental.averageRootMeanSquaredError,
+      1e-12);
+  EXPECT_NEAR(
+      batch.averageSumSquaredError, incremental.averageSumSquaredError, 1e-12);
+  EXPECT_NEAR(batch.averageMaxError, incremental.averageMaxError, 1e-12);
+  for (std::string& name : batch.markerNames)
+  {
+    EXPECT_NEAR(
+        batch.rmseMarkerErrors[name],
+        incremental.rmseMarkerErrors[name],
+        1e-12);
+    EXPECT_EQ(
+        batch.numMarkerObservations[name],
+        incremental.numMarkerObservations[name]);
+  }
+}
@@ -0,0 +1,312 @@
+#include <atomic>
+#include <memory>
+#include <random>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/math/IKSolver.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+
+// #define ALL_TESTS
+
+namespace {
+
+/// This is a tiny IK problem over a point in the plane: put the point on the
+/// unit circle, at x = 0.3. Each instance owns its own "skeleton" state, so
+/// separate instances are safe to use from separate threads.
+struct CircleProblem
+{
+  CircleProblem(std::shared_ptr<std::atomic<int>> evalCount)
+    : state(std::make_shared<Eigen::VectorXs>(Eigen::VectorXs::Zero(2))),
+      evalCount(evalCount)
+  {
+  }
+
+  math::IKWorker makeWorker()
+  {
+    math::IKWorker worker;
+    std::shared_ptr<Eigen::VectorXs> pos = state;
+    worker.setPosAndClamp = [pos](const Eigen::VectorXs& newPos, bool clamp) {
+      *pos = newPos;
+      if (clamp)
+      {
+        *pos = pos->cwiseMax(-2.0).cwiseMin(2.0);
+      }
+      return *pos;
+    };
+    std::shared_ptr<std::atomic<int>> count = evalCount;
+    worker.eval = [pos, count](
+                      Eigen::Ref<Eigen::VectorXs> diff,
+                      Eigen::Ref<Eigen::MatrixXs> jac) {
+      (*count)++;
+      diff(0) = pos->squaredNorm() - 1.0;
+      diff(1) = (*pos)(0) - 0.3;
+      jac.setZero();
+      jac(0, 0) = 2 * (*pos)(0);
+      jac(0, 1) = 2 * (*pos)(1);
+      jac(1, 0) = 1.0;
+    };
+    return worker;
+  }
+
+  std::shared_ptr<Eigen::VectorXs> state;
+  std::shared_ptr<std::atomic<int>> evalCount;
+};
+
+std::function<void(Eigen::Ref<Eigen::VectorXs>)> makeRandomRestart(int seed)
+{
+  std::shared_ptr<std::mt19937> rng = std::make_shared<std::mt19937>(seed);
+  return [rng](Eigen::Ref<Eigen::VectorXs> pos) {
+    std::uniform_real_distribution<double> dist(-2.0, 2.0);
+    pos(0) = dist(*rng);
+    pos(1) = dist(*rng);
+  };
+}
+
+} // namespace
+
+#ifdef ALL_TESTS
+TEST(IK_SOLVER, PARALLEL_MATCHES_SERIAL)
+{
+  Eigen::VectorXs initialPos = Eigen::Vector2s(1.5, -1.5);
+  Eigen::VectorXs upperBound = Eigen::VectorXs::Constant(2, 2.0);
+  Eigen::VectorXs lowerBound = Eigen::VectorXs::Constant(2, -2.0);
+  // With a lower bound of 0 nothing gets cancelled, so both searches look at
+  // exactly the same restarts and must pick the same one
+  math::IKConfig config
+      = math::IKConfig().setMaxRestarts(16).setLossLowerBound(0);
+
+  auto count = std::make_shared<std::atomic<int>>(0);
+  CircleProblem serial(count);
+  math::IKWorker serialWorker = serial.makeWorker();
+  s_t serialLoss = math::solveIK(
+      initialPos,
+      upperBound,
+      lowerBound,
+      2,
+      serialWorker.setPosAndClamp,
+      serialWorker.eval,
+      makeRandomRestart(7),
+      config);
+
+  CircleProblem parallel(count);
+  math::IKWorker parallelWorker = parallel.makeWorker();
+  s_t parallelLoss = math::solveIKParallel(
+      initialPos,
+      upperBound,
+      lowerBound,
+      2,
+      parallelWorker.setPosAndClamp,
+      parallelWorker.eval,
+      makeRandomRestart(7),
+      [count]() { return CircleProblem(count).makeWorker(); },
+      config);
+
+  EXPECT_EQ(serialLoss, parallelLoss);
+  EXPECT_TRUE(equals(*serial.state, *parallel.state, 1e-12));
+  EXPECT_NEAR((*parallel.state)(0), 0.3, 1e-6);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(IK_SOLVER, PARALLEL_CANCELS_ONCE_SATISFIED)
+{
+  // Start right on a solution, so the very first restart is good enough and
+  // the rest should get cancelled
+  Eigen::VectorXs initialPos = Eigen::Vector2s(0.3, std::sqrt(1.0 - 0.09));
+  Eigen::VectorXs upperBound = Eigen::VectorXs::Constant(2, 2.0);
+  Eigen::VectorXs lowerBound = Eigen::VectorXs::Constant(2, -2.0);
+  const int maxRestarts = 500;
+  math::IKConfig config
+      = math::IKConfig().setMaxRestarts(maxRestarts).setLossLowerBound(1e-8);
+
+  auto count = std::make_shared<std::atomic<int>>(0);
+  CircleProblem problem(count);
+  math::IKWorker worker = problem.makeWorker();
+  s_t loss = math::solveIKParallel(
+      initialPos,
+      upperBound,
+      lowerBound,
+      2,
+      worker.setPosAndClamp,
+      worker.eval,
+      makeRandomRestart(7),
+      [count]() { return CircleProblem(count).makeWorker(); },
+      config);
+
+  EXPECT_LE(loss, 1e-8);
+  // Each restart takes at least a couple of evals, so running all of them
+  // would take far more than this
+  EXPECT_LT(count->load(), maxRestarts);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(IK_SOLVER, TEMPLATE_MATCHES_STD_FUNCTION)
+{
+  Eigen::VectorXs initialPos = Eigen::Vector2s(1.5, -1.5);
+  Eigen::VectorXs upperBound = Eigen::VectorXs::Constant(2, 2.0);
+  Eigen::VectorXs lowerBound = Eigen::VectorXs::Constant(2, -2.0);
+  math::IKConfig config = math::IKConfig().setMaxRestarts(4);
+
+  auto count = std::make_shared<std::atomic<int>>(0);
+  CircleProblem wrapped(count);
+  math::IKWorker worker = wrapped.makeWorker();
+  s_t wrappedLoss = math::solveIK(
+      initialPos,
+      upperBound,
+      lowerBound,
+      2,
+      worker.setPosAndClamp,
+      worker.eval,
+      makeRandomRestart(7),
+      config);
+
+  // The same problem, but as plain lambdas over fixed-size buffers
+  Eigen::Vector2s pos = Eigen::Vector2s::Zero();
+  std::mt19937 rng(7);
+  s_t inlinedLoss = math::solveIK<2, 2>(
+      initialPos,
+      upperBound,
+      lowerBound,
+      2,
+      [&pos](const Eigen::Vector2s& newPos, bool clamp) {
+        pos = newPos;
+        if (clamp)
+        {
+          pos = pos.cwiseMax(-2.0).cwiseMin(2.0);
+        }
+        return pos;
+      },
+      [&pos](
+          Eigen::Ref<Eigen::Vector2s> diff, Eigen::Ref<Eigen::Matrix2s> jac) {
+        diff(0) = pos.squaredNorm() - 1.0;
+        diff(1) = pos(0) - 0.3;
+        jac.setZero();
+        jac(0, 0) = 2 * pos(0);
+        jac(0, 1) = 2 * pos(1);
+        jac(1, 0) = 1.0;
+      },
+      [&rng](Eigen::Ref<Eigen::Vector2s> restart) {
+        std::uniform_real_distribution<double> dist(-2.0, 2.0);
+        restart(0) = dist(rng);
+        restart(1) = dist(rng);
+      },
+      config);
+
+  EXPECT_NEAR(wrappedLoss, inlinedLoss, 1e-12);
+  EXPECT_TRUE(equals(*wrapped.state, Eigen::VectorXs(pos), 1e-12));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(IK_SOLVER, LEVENBERG_MARQUARDT_USES_SPARSITY)
+{
+  // A planar chain of unit links, with a "marker" at the tip of each link. The
+  // marker on link i only depends on the first i + 1 joint angles.
+  const int links = 10;
+  Eigen::VectorXs state = Eigen::VectorXs::Zero(links);
+  auto forwardKinematics = [links](const Eigen::VectorXs& q) {
+    Eigen::VectorXs tips = Eigen::VectorXs::Zero(links * 2);
+    s_t angle = 0.0;
+    Eigen::Vector2s tip = Eigen::Vector2s::Zero();
+    for (int i = 0; i < links; i++)
+    {
+      angle += q(i);
+      tip += Eigen::Vector2s(cos(angle), sin(angle));
+      tips.segment<2>(i * 2) = tip;
+    }
+    return tips;
+  };
+  Eigen::VectorXs target = forwardKinematics(
+      Eigen::VectorXs::LinSpaced(links, 0.3, -0.5));
+
+  int evals = 0;
+  auto setPosAndClamp = [&state](const Eigen::VectorXs& pos, bool clamp) {
+    (void)clamp;
+    state = pos;
+    return state;
+  };
+  auto eval = [&](Eigen::Ref<Eigen::VectorXs> diff,
+                  Eigen::Ref<Eigen::MatrixXs> jac) {
+    evals++;
+    Eigen::VectorXs tips = forwardKinematics(state);
+    diff = tips - target;
+    jac.setZero();
+    Eigen::Vector2s joint = Eigen::Vector2s::Zero();
+    s_t angle = 0.0;
+    for (int j = 0; j < links; j++)
+    {
+      for (int i = j; i < links; i++)
+      {
+        Eigen::Vector2s r = tips.segment<2>(i * 2) - joint;
+        jac(i * 2, j) = -r(1);
+        jac(i * 2 + 1, j) = r(0);
+      }
+      angle += state(j);
+      joint += Eigen::Vector2s(cos(angle), sin(angle));
+    }
+  };
+
+  std::vector<std::vector<int>> sparsity;
+  for (int i = 0; i < links; i++)
+  {
+    std::vector<int> cols;
+    for (int j = 0; j <= i; j++)
+    {
+      cols.push_back(j);
+    }
+    sparsity.push_back(cols);
+    sparsity.push_back(cols);
+  }
+
+  Eigen::VectorXs initialPos = Eigen::VectorXs::Zero(links);
+  Eigen::VectorXs upperBound = Eigen::VectorXs::Constant(links, 10.0);
+  Eigen::VectorXs lowerBound = Eigen::VectorXs::Constant(links, -10.0);
+  math::IKConfig config = math::IKConfig()
+                              .setMaxStepCount(500)
+                              .setConvergenceThreshold(1e-10);
+
+  math::IKResult dls = math::refineIK(
+      initialPos,
+      upperBound,
+      lowerBound,
+      links * 2,
+      setPosAndClamp,
+      eval,
+      config);
+  int dlsEvals = evals;
+
+  evals = 0;
+  math::IKResult sparse = math::refineIK(
+      initialPos,
+      upperBound,
+      lowerBound,
+      links * 2,
+      setPosAndClamp,
+      eval,
+      math::IKConfig(config).setLevenbergMarquardt(true).setJacobianSparsity(
+          sparsity));
+  int sparseEvals = evals;
+
+  math::IKResult dense = math::refineIK(
+      initialPos,
+      upperBound,
+      lowerBound,
+      links * 2,
+      setPosAndClamp,
+      eval,
+      math::IKConfig(config).setLevenbergMarquardt(true));
+
+  EXPECT_LT(dls.loss, 1e-8);
+  EXPECT_LT(sparse.loss, 1e-12);
+  EXPECT_TRUE(sparse.clamped);
+  EXPECT_LE(sparseEvals, dlsEvals);
+  // Skipping the structural zeros mustn't change the steps we take
+  EXPECT_TRUE(equals(sparse.pos, dense.pos, 1e-10));
+}
+#endif
@@ -0,0 +1,120 @@
+#include <cmath>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/math/LBFGSB.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+
+namespace {
+
+s_t rosenbrock(const Eigen::VectorXs& x, Eigen::VectorXs& grad)
+{
+  s_t loss = 0.0;
+  grad.setZero();
+  for (int i = 0; i + 1 < x.size(); i++)
+  {
+    s_t a = 1.0 - x(i);
+    s_t b = x(i + 1) - x(i) * x(i);
+    loss += a * a + 100.0 * b * b;
+    grad(i) += -2.0 * a - 400.0 * x(i) * b;
+    grad(i + 1) += 200.0 * b;
+  }
+  return loss;
+}
+
+/// This has the same shape as the MarkerFitter subproblems: minimize
+/// |x - target|^2
+struct TargetProblem
+{
+  Eigen::VectorXs x;
+  Eigen::VectorXs target;
+
+  Eigen::VectorXs flatten()
+  {
+    return x;
+  }
+  void unflatten(Eigen::VectorXs flat)
+  {
+    x = flat;
+  }
+  s_t getLoss()
+  {
+    return (x - target).squaredNorm();
+  }
+  Eigen::VectorXs getGradient()
+  {
+    return 2 * (x - target);
+  }
+};
+
+} // namespace
+
+TEST(LBFGSB, UNBOUNDED_ROSENBROCK)
+{
+  math::LBFGSB solver(math::LBFGSBConfig().setMaxIterations(500));
+  Eigen::VectorXs x = Eigen::VectorXs::Constant(6, -1.2);
+  math::LBFGSBResult result = solver.minimize(rosenbrock, x);
+  EXPECT_TRUE(result.converged());
+  EXPECT_TRUE(equals(x, Eigen::VectorXs::Ones(6), 1e-5));
+}
+
+TEST(LBFGSB, BOUNDS_ARE_RESPECTED)
+{
+  // The unconstrained minimum is (1, 1, 1, 1), but x(0) is capped at 0.5,
+  // which moves the rest of the chain to x(i + 1) = x(i)^2
+  math::LBFGSB solver(math::LBFGSBConfig().setMaxIterations(500));
+  Eigen::VectorXs x = Eigen::VectorXs::Zero(4);
+  Eigen::VectorXs lower = Eigen::VectorXs::Constant(4, -2.0);
+  Eigen::VectorXs upper = Eigen::VectorXs::Constant(4, 2.0);
+  upper(0) = 0.5;
+  solver.minimize(rosenbrock, x, lower, upper);
+  EXPECT_NEAR(static_cast<double>(x(0)), 0.5, 1e-8);
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_GE(x(i), lower(i));
+    EXPECT_LE(x(i), upper(i));
+  }
+
+  // A start outside the box gets projected into it
+  Eigen::VectorXs y = Eigen::VectorXs::Constant(4, 5.0);
+  solver.minimize(rosenbrock, y, lower, upper);
+  EXPECT_TRUE(equals(x, y, 1e-5));
+}
+
+TEST(LBFGSB, MINIMIZE_PROBLEM)
+{
+  TargetProblem problem;
+  problem.x = Eigen::VectorXs::Zero(3);
+  problem.target = Eigen::Vector3s(1.0, -2.0, 3.0);
+
+  math::LBFGSB solver;
+  Eigen::VectorXs lower = Eigen::VectorXs::Constant(3, -1.0);
+  Eigen::VectorXs upper = Eigen::VectorXs::Constant(3, 1.0);
+  math::LBFGSBResult result = solver.minimizeProblem(problem, lower, upper);
+  EXPECT_TRUE(result.converged());
+  EXPECT_TRUE(equals(problem.x, Eigen::Vector3s(1.0, -1.0, 1.0), 1e-8));
+
+  // The workspace gets reused for the next problem of the same size
+  problem.x.setZero();
+  problem.target = Eigen::Vector3s(0.5, 0.25, -0.75);
+  result = solver.minimizeProblem(problem);
+  EXPECT_TRUE(result.converged());
+  EXPECT_TRUE(equals(problem.x, problem.target, 1e-8));
+}
+
+TEST(LBFGSB, CALLBACK_CAN_STOP)
+{
+  math::LBFGSB solver;
+  int calls = 0;
+  solver.setIterationCallback(
+      [&](int, s_t, const Eigen::VectorXs&) { return ++calls < 3; });
+  Eigen::VectorXs x = Eigen::VectorXs::Constant(4, -1.2);
+  math::LBFGSBResult result = solver.minimize(rosenbrock, x);
+  EXPECT_EQ(result.status, math::LBFGSBStatus::STOPPED_BY_CALLBACK);
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(result.iterations, 3);
+}
@@ -35,6 +35,8 @@
 #include <Eigen/Dense>
 #include <gtest/gtest.h>
 
+#include "dart/constraint/AdmmBoxedLcpSolver.hpp"
+#include "dart/constraint/BlockJacobiBoxedLcpSolver.hpp"
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
 #include "dart/constraint/LCPUtils.hpp"
 #include "dart/constraint/PgsBoxedLcpSolver.hpp"
@@ -757,4 +759,311 @@ TEST(LCP_UTILS, BLOCK_SYMMETRIC_CASE)
   std::cout << "filtered x:" << std::endl << fx << std::endl;
   std::cout << "A * fx:" << std::endl << A * fx << std::endl;
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, PGS_VARIANTS_AGREE)
+{
+  // A ring of contacts, each coupled only to its neighbors, which is the kind
+  // of block-sparse system the colored sweep is meant for
+  const int numContacts = 40;
+  const int n = numContacts * 3;
+  srand(42);
+  Eigen::MatrixXs A = 0.1 * Eigen::MatrixXs::Identity(n, n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    Eigen::MatrixXs J = Eigen::MatrixXs::Random(6, 4);
+    Eigen::MatrixXs block = J * J.transpose();
+    int next = (c + 1) % numContacts;
+    int rows[6] = {c * 3, c * 3 + 1, c * 3 + 2, next * 3, next * 3 + 1,
+                   next * 3 + 2};
+    for (int i = 0; i < 6; i++)
+      for (int j = 0; j < 6; j++)
+        A(rows[i], rows[j]) += block(i, j);
+  }
+  Eigen::VectorXs b = Eigen::VectorXs::Random(n);
+  Eigen::VectorXs lo = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs hi = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXi fIndex = Eigen::VectorXi::Zero(n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    lo(c * 3) = 0;
+    hi(c * 3) = std::numeric_limits<s_t>::infinity();
+    fIndex(c * 3) = -1;
+    for (int k = 1; k < 3; k++)
+    {
+      lo(c * 3 + k) = -0.5;
+      hi(c * 3 + k) = 0.5;
+      fIndex(c * 3 + k) = c * 3;
+    }
+  }
+
+  auto solve = [&](const PgsBoxedLcpSolver::Option& option) {
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        APadded = Eigen::MatrixXs::Zero(n, dPAD(n));
+    APadded.block(0, 0, n, n) = A;
+    Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+    Eigen::VectorXs bCopy = b;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    PgsBoxedLcpSolver solver;
+    solver.setOption(option);
+    EXPECT_TRUE(solver.solve(
+        n,
+        APadded.data(),
+        x.data(),
+        bCopy.data(),
+        0,
+        loCopy.data(),
+        hiCopy.data(),
+        fIndexCopy.data(),
+        false));
+    return x;
+  };
+
+  Eigen::VectorXs plain
+      = solve(PgsBoxedLcpSolver::Option(5000, 1e-12, 1e-12, 1e-12, false));
+  Eigen::VectorXs overRelaxed = solve(
+      PgsBoxedLcpSolver::Option(5000, 1e-12, 1e-12, 1e-12, false, 1.3));
+  Eigen::VectorXs grouped = solve(PgsBoxedLcpSolver::Option(
+      5000, 1e-12, 1e-12, 1e-12, true, 1.0, true, false));
+  Eigen::VectorXs colored = solve(PgsBoxedLcpSolver::Option(
+      5000, 1e-12, 1e-12, 1e-12, false, 1.0, true, true));
+
+  EXPECT_TRUE(equals(plain, overRelaxed, 1e-8));
+  EXPECT_TRUE(equals(plain, grouped, 1e-8));
+  EXPECT_TRUE(equals(plain, colored, 1e-8));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, ACTIVE_SET_RESOLVE)
+{
+  // Three contacts with friction, two sticking and one separating, solved from
+  // scratch by Dantzig. Then we nudge b a little, like the next timestep of
+  // resting contact, and check the active-set solve gets there from the old
+  // solution alone.
+  const int numContacts = 3;
+  const int n = numContacts * 3;
+  srand(7);
+  Eigen::MatrixXs J = Eigen::MatrixXs::Random(n, 6);
+  Eigen::MatrixXs A
+      = 0.1 * J * J.transpose() + Eigen::MatrixXs::Identity(n, n);
+  Eigen::VectorXs b = Eigen::VectorXs::Random(n);
+  Eigen::VectorXs lo = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs hi = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXi fIndex = Eigen::VectorXi::Zero(n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    b(c * 3) = c == 2 ? -1.0 : 1.0 + c;
+    lo(c * 3) = 0;
+    hi(c * 3) = std::numeric_limits<s_t>::infinity();
+    fIndex(c * 3) = -1;
+    for (int k = 1; k < 3; k++)
+    {
+      lo(c * 3 + k) = -5.0;
+      hi(c * 3 + k) = 5.0;
+      fIndex(c * 3 + k) = c * 3;
+    }
+  }
+
+  auto solve = [&](const Eigen::VectorXs& rhs) {
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        APadded = Eigen::MatrixXs::Zero(n, dPAD(n));
+    APadded.block(0, 0, n, n) = A;
+    Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+    Eigen::VectorXs bCopy = rhs;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    DantzigBoxedLcpSolver solver;
+    EXPECT_TRUE(solver.solve(
+        n,
+        APadded.data(),
+        x.data(),
+        bCopy.data(),
+        0,
+        loCopy.data(),
+        hiCopy.data(),
+        fIndexCopy.data(),
+        false));
+    return x;
+  };
+
+  Eigen::VectorXs x = solve(b);
+  EXPECT_TRUE(LCPUtils::isLCPSolutionValid(A, x, b, hi, lo, fIndex, false));
+  Eigen::VectorXs nextB = b + 1e-4 * Eigen::VectorXs::Random(n);
+  Eigen::VectorXs nextX = solve(nextB);
+
+  Eigen::VectorXs mixedX = x;
+  EXPECT_TRUE(
+      LCPUtils::solveWithActiveSet(A, mixedX, nextB, hi, lo, fIndex, true));
+  EXPECT_TRUE(LCPUtils::solveWithActiveSet(A, x, nextB, hi, lo, fIndex));
+  EXPECT_TRUE(equals(mixedX, x, 1e-10));
+  EXPECT_TRUE(
+      LCPUtils::isLCPSolutionValid(A, x, nextB, hi, lo, fIndex, false));
+  EXPECT_TRUE(equals(x, nextX, 1e-8));
+
+  // A warm start in the wrong categories shouldn't be accepted, and should
+  // leave x alone
+  Eigen::VectorXs wrong = Eigen::VectorXs::Zero(n);
+  EXPECT_FALSE(LCPUtils::solveWithActiveSet(A, wrong, nextB, hi, lo, fIndex));
+  EXPECT_TRUE(wrong.isZero());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, SOLVE_MIXED_PRECISION)
+{
+  srand(3);
+  const int n = 40;
+  Eigen::MatrixXs J = Eigen::MatrixXs::Random(n, n);
+  Eigen::MatrixXs A = J * J.transpose() + Eigen::MatrixXs::Identity(n, n);
+  Eigen::VectorXs b = Eigen::VectorXs::Random(n);
+
+  Eigen::VectorXs x = LCPUtils::solveMixedPrecision(A, b);
+  Eigen::VectorXs expected = A.completeOrthogonalDecomposition().solve(b);
+  EXPECT_TRUE(equals(x, expected, 1e-10));
+  EXPECT_LT((A * x - b).norm(), 1e-9);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, BLOCK_JACOBI_MATCHES_DANTZIG)
+{
+  // A ring of sticking contacts, each coupled to its neighbors, split into
+  // blocks of a few contacts each
+  const int numContacts = 24;
+  const int n = numContacts * 3;
+  srand(11);
+  Eigen::MatrixXs A = Eigen::MatrixXs::Identity(n, n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    Eigen::MatrixXs J = 0.3 * Eigen::MatrixXs::Random(6, 4);
+    Eigen::MatrixXs block = J * J.transpose();
+    int next = (c + 1) % numContacts;
+    int rows[6] = {c * 3, c * 3 + 1, c * 3 + 2, next * 3, next * 3 + 1,
+                   next * 3 + 2};
+    for (int i = 0; i < 6; i++)
+      for (int j = 0; j < 6; j++)
+        A(rows[i], rows[j]) += block(i, j);
+  }
+  Eigen::VectorXs b = 0.1 * Eigen::VectorXs::Random(n);
+  Eigen::VectorXs lo = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs hi = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXi fIndex = Eigen::VectorXi::Zero(n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    // Every third contact is separating
+    b(c * 3) = c % 3 == 0 ? -1.0 : 1.0;
+    lo(c * 3) = 0;
+    hi(c * 3) = std::numeric_limits<s_t>::infinity();
+    fIndex(c * 3) = -1;
+    for (int k = 1; k < 3; k++)
+    {
+      lo(c * 3 + k) = -5.0;
+      hi(c * 3 + k) = 5.0;
+      fIndex(c * 3 + k) = c * 3;
+    }
+  }
+
+  auto solve = [&](BoxedLcpSolver& solver) {
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        APadded = Eigen::MatrixXs::Zero(n, dPAD(n));
+    APadded.block(0, 0, n, n) = A;
+    Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+    Eigen::VectorXs bCopy = b;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    EXPECT_TRUE(solver.solve(
+        n,
+        APadded.data(),
+        x.data(),
+        bCopy.data(),
+        0,
+        loCopy.data(),
+        hiCopy.data(),
+        fIndexCopy.data(),
+        false));
+    return x;
+  };
+
+  DantzigBoxedLcpSolver dantzig;
+  BlockJacobiBoxedLcpSolver blockJacobi;
+  blockJacobi.setOption(BlockJacobiBoxedLcpSolver::Option(12, 200, 1e-10));
+  Eigen::VectorXs expected = solve(dantzig);
+  Eigen::VectorXs x = solve(blockJacobi);
+
+  EXPECT_GT(blockJacobi.getNumIterations(), 1);
+  EXPECT_TRUE(LCPUtils::isLCPSolutionValid(A, x, b, hi, lo, fIndex, false));
+  EXPECT_TRUE(equals(x, expected, 1e-7));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, ADMM_MATCHES_DANTZIG)
+{
+  // Contacts with friction, some sticking and some separating
+  const int numContacts = 8;
+  const int n = numContacts * 3;
+  srand(5);
+  Eigen::MatrixXs J = Eigen::MatrixXs::Random(n, 12);
+  Eigen::MatrixXs A
+      = 0.1 * J * J.transpose() + Eigen::MatrixXs::Identity(n, n);
+  Eigen::VectorXs b = 0.2 * Eigen::VectorXs::Random(n);
+  Eigen::VectorXs lo = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs hi = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXi fIndex = Eigen::VectorXi::Zero(n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    b(c * 3) = c % 3 == 0 ? -1.0 : 1.0;
+    lo(c * 3) = 0;
+    hi(c * 3) = std::numeric_limits<s_t>::infinity();
+    fIndex(c * 3) = -1;
+    for (int k = 1; k < 3; k++)
+    {
+      lo(c * 3 + k) = -5.0;
+      hi(c * 3 + k) = 5.0;
+      fIndex(c * 3 + k) = c * 3;
+    }
+  }
+
+  auto solve = [&](BoxedLcpSolver& solver) {
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        APadded = Eigen::MatrixXs::Zero(n, dPAD(n));
+    APadded.block(0, 0, n, n) = A;
+    Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+    Eigen::VectorXs bCopy = b;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    EXPECT_TRUE(solver.solve(
+        n,
+        APadded.data(),
+        x.data(),
+        bCopy.data(),
+        0,
+        loCopy.data(),
+        hiCopy.data(),
+        fIndexCopy.data(),
+        false));
+    return x;
+  };
+
+  DantzigBoxedLcpSolver dantzig;
+  AdmmBoxedLcpSolver admm;
+  Eigen::VectorXs expected = solve(dantzig);
+  Eigen::VectorXs x = solve(admm);
+  EXPECT_TRUE(LCPUtils::isLCPSolutionValid(A, x, b, hi, lo, fIndex, false));
+  EXPECT_TRUE(equals(x, expected, 1e-8));
+
+  // Solving the same problem again reuses the factorization, and the warm
+  // started duals get there in fewer iterations
+  const long firstIterations = admm.getNumIterations();
+  x = solve(admm);
+  EXPECT_EQ(admm.getNumFactorizations(), 1);
+  EXPECT_LT(admm.getNumIterations() - firstIterations, firstIterations);
+  EXPECT_TRUE(equals(x, expected, 1e-8));
+}
+#endif
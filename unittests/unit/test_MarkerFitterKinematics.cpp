@@ -1,8 +1,11 @@
+#include <chrono>
 #include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -17,6 +20,7 @@
 #include "dart/biomechanics/ForcePlate.hpp"
 #include "dart/biomechanics/IKErrorReport.hpp"
 #include "dart/biomechanics/MarkerFitter.hpp"
+#include "dart/biomechanics/MarkerFitterRemote.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BodyNode.hpp"
@@ -375,6 +379,63 @@ bool testBilevelFitProblemGradients(
 
   Eigen::VectorXs x = problem.getInitialization();
 
+  // Check that evaluating the timesteps in parallel batches matches the plain
+  // serial evaluation
+  std::vector<std::shared_ptr<dynamics::Skeleton>> threadSkeletons;
+  for (int i = 0; i < 3; i++)
+  {
+    threadSkeletons.push_back(skel->clone());
+  }
+  MarkerFitterState serialState(
+      x,
+      problem.getMarkerMapObservations(),
+      joints,
+      problem.getJointCenters(),
+      Eigen::VectorXs::Zero(0),
+      Eigen::MatrixXs::Zero(0, 0),
+      Eigen::VectorXs::Zero(0),
+      &fitter);
+  MarkerFitterState batchedState(
+      x,
+      problem.getMarkerMapObservations(),
+      joints,
+      problem.getJointCenters(),
+      Eigen::VectorXs::Zero(0),
+      Eigen::MatrixXs::Zero(0, 0),
+      Eigen::VectorXs::Zero(0),
+      &fitter,
+      threadSkeletons);
+  if (!equals(
+          serialState.markerErrorsAtTimesteps,
+          batchedState.markerErrorsAtTimesteps,
+          1e-12)
+      || !equals(
+          serialState.jointErrorsAtTimesteps,
+          batchedState.jointErrorsAtTimesteps,
+          1e-12))
+  {
+    std::cout << "Error on batched MarkerFitterState errors" << std::endl;
+    return false;
+  }
+  serialState.markerErrorsAtTimestepsGrad
+      = serialState.markerErrorsAtTimesteps;
+  serialState.jointErrorsAtTimestepsGrad = serialState.jointErrorsAtTimesteps;
+  batchedState.markerErrorsAtTimestepsGrad
+      = batchedState.markerErrorsAtTimesteps;
+  batchedState.jointErrorsAtTimestepsGrad
+      = batchedState.jointErrorsAtTimesteps;
+  Eigen::VectorXs serialGrad = serialState.flattenGradient();
+  Eigen::VectorXs batchedGrad = batchedState.flattenGradient();
+  if (!equals(serialGrad, batchedGrad, 1e-10))
+  {
+    std::cout << "Error on batched MarkerFitterState grad" << std::endl
+              << "Serial:" << std::endl
+              << serialGrad << std::endl
+              << "Batched:" << std::endl
+              << batchedGrad << std::endl;
+    return false;
+  }
+
   Eigen::VectorXs grad = problem.getGradient(x);
   Eigen::VectorXs grad_fd = problem.finiteDifferenceGradient(x);
 
@@ -6841,4 +6902,76 @@ TEST(MarkerFitter, EVAL_PERFORMANCE)
             << groupScaleCols << std::endl;
 }
 #endif
-// #endif
\ No newline at end of file
+// #endif
+#ifdef ALL_TESTS
+TEST(MarkerFitter, REMOTE_FIT_TRAJECTORY)
+{
+  std::string osimPath = "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim";
+  OpenSimFile standard = OpenSimParser::parseOsim(osimPath);
+  OpenSimTRC markerTrajectories = OpenSimParser::loadTRC(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "S01DN603.trc");
+
+  MarkerFitter fitter(standard.skeleton, standard.markersMap);
+  fitter.setInitialIKSatisfactoryLoss(0.05);
+  fitter.setInitialIKMaxRestarts(50);
+
+  std::vector<std::map<std::string, Eigen::Vector3s>> observations;
+  for (int i = 0; i < 20; i++)
+  {
+    observations.push_back(markerTrajectories.markerTimesteps[i]);
+  }
+  Eigen::VectorXs groupScales = standard.skeleton->getGroupScales();
+  Eigen::VectorXs firstPose = standard.skeleton->getPositions();
+  std::vector<Eigen::VectorXs> noJoints(
+      observations.size(), Eigen::VectorXs::Zero(0));
+
+  Eigen::MatrixXs localPoses
+      = Eigen::MatrixXs::Zero(standard.skeleton->getNumDofs(), 20);
+  Eigen::VectorXs localScores = Eigen::VectorXs::Zero(20);
+  MarkerFitter::fitTrajectory(
+      &fitter,
+      groupScales,
+      firstPose,
+      observations,
+      std::map<std::string, s_t>(),
+      std::map<std::string, Eigen::Vector3s>(),
+      std::vector<dynamics::Joint*>(),
+      noJoints,
+      Eigen::VectorXs::Zero(0),
+      noJoints,
+      Eigen::VectorXs::Zero(0),
+      localPoses,
+      localScores);
+
+  std::thread worker([]() { MarkerFitterWorker::serve(9253); });
+  worker.detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  MarkerFitterRemote remote(
+      std::vector<std::string>{"localhost:9253"}, common::Uri(osimPath));
+  Eigen::MatrixXs remotePoses
+      = Eigen::MatrixXs::Zero(standard.skeleton->getNumDofs(), 20);
+  Eigen::VectorXs remoteScores = Eigen::VectorXs::Zero(20);
+  std::future<void> future = remote.submit(
+      &fitter,
+      groupScales,
+      firstPose,
+      observations,
+      std::map<std::string, s_t>(),
+      std::map<std::string, Eigen::Vector3s>(),
+      std::vector<dynamics::Joint*>(),
+      noJoints,
+      Eigen::VectorXs::Zero(0),
+      noJoints,
+      Eigen::VectorXs::Zero(0),
+      remotePoses,
+      remoteScores,
+      false);
+  future.get();
+
+  // Restarts are random, so the poses can differ a little, but the fits
+  // should be just as good
+  EXPECT_LT((remoteScores - localScores).cwiseAbs().maxCoeff(), 1e-3);
+}
+#endif
@@ -12,6 +12,7 @@
 #include "dart/biomechanics/MarkerFitter.hpp"
 #include "dart/biomechanics/MarkerLabeller.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/biomechanics/StreamingMarkerFitter.hpp"
 
 #include "GradientTestUtils.hpp"
 #include "TestHelpers.hpp"
@@ -67,4 +68,156 @@ TEST(LABELLER, RECREATE_LABELS)
 
   labeller.evaluate(markerStringMap, markersOverTime);
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(LABELLER, BATCHED_PREDICTOR)
+{
+  // Frames with different numbers of points, so the batches need padding
+  std::vector<std::vector<Eigen::Vector3s>> pointClouds;
+  for (int t = 0; t < 5; t++)
+  {
+    std::vector<Eigen::Vector3s> cloud;
+    for (int i = 0; i <= t; i++)
+    {
+      cloud.push_back(Eigen::Vector3s(t, i, t * i));
+    }
+    pointClouds.push_back(cloud);
+  }
+
+  // This predicts a single "center" joint, at the mean of the real points
+  std::vector<int> batchSizes;
+  NeuralMarkerLabeller labeller(
+      [&](Eigen::Ref<const NeuralMarkerLabeller::PointsBatch> points,
+          Eigen::Ref<const NeuralMarkerLabeller::MaskBatch> mask) {
+        batchSizes.push_back(points.rows());
+        EXPECT_EQ(points.cols(), mask.cols() * 3);
+        Eigen::MatrixXs centers = Eigen::MatrixXs::Zero(points.rows(), 3);
+        for (int row = 0; row < points.rows(); row++)
+        {
+          int count = 0;
+          for (int i = 0; i < mask.cols(); i++)
+          {
+            if (mask(row, i))
+            {
+              centers.row(row) += points.block<1, 3>(row, i * 3);
+              count++;
+            }
+          }
+          centers.row(row) /= count;
+        }
+        return centers;
+      },
+      std::vector<std::string>{"center"},
+      2);
+
+  std::vector<std::map<std::string, Eigen::Vector3s>> joints
+      = labeller.guessJointLocations(pointClouds);
+
+  EXPECT_EQ(std::vector<int>({2, 2, 1}), batchSizes);
+  ASSERT_EQ(5, joints.size());
+  for (int t = 0; t < 5; t++)
+  {
+    Eigen::Vector3s expected = Eigen::Vector3s::Zero();
+    for (Eigen::Vector3s& point : pointClouds[t])
+    {
+      expected += point;
+    }
+    expected /= pointClouds[t].size();
+    EXPECT_TRUE(equals(expected, joints[t].at("center"), 1e-12));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LABELLER, STREAMING_TRACKER_MATCHES_RAW_TRACES)
+{
+  // Two markers moving in opposite directions, with one dropping out for a
+  // while so its trace goes inactive and a new one starts
+  std::vector<std::vector<Eigen::Vector3s>> pointClouds;
+  for (int t = 0; t < 30; t++)
+  {
+    std::vector<Eigen::Vector3s> cloud;
+    cloud.push_back(Eigen::Vector3s(0.001 * t, 0, 0));
+    if (t < 10 || t > 20)
+    {
+      cloud.push_back(Eigen::Vector3s(1 - 0.002 * t, 1, 0));
+    }
+    pointClouds.push_back(cloud);
+  }
+
+  std::vector<MarkerTrace> rawTraces
+      = MarkerTrace::createRawTraces(pointClouds, 0.01, 5);
+  ASSERT_EQ(3, rawTraces.size());
+
+  MarkerTraceTracker tracker(0.01, 5, false);
+  for (int t = 0; t < pointClouds.size(); t++)
+  {
+    std::vector<int> pointTraces = tracker.addFrame(t, pointClouds[t]);
+    ASSERT_EQ(pointClouds[t].size(), pointTraces.size());
+    for (int i = 0; i < pointTraces.size(); i++)
+    {
+      // Streaming traces only keep enough points to extrapolate
+      MarkerTrace& trace = tracker.getTraces().at(pointTraces[i]);
+      EXPECT_LE(trace.mPoints.size(), 2);
+      EXPECT_EQ(t, trace.lastTimestep());
+      EXPECT_TRUE(equals(pointClouds[t][i], trace.mPoints.back(), 1e-12));
+    }
+  }
+  // The first trace of the second marker has been dropped
+  EXPECT_EQ(2, tracker.getTraces().size());
+  EXPECT_EQ(2, tracker.getActiveTraces().size());
+}
+#endif
+#ifdef ALL_TESTS
+TEST(LABELLER, STREAMING_LABELS_MOCAP)
+{
+  OpenSimFile scaled = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/Rajagopal_scaled.osim");
+  OpenSimMot mot = OpenSimParser::loadMot(
+      scaled.skeleton,
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "S01DN603_ik.mot");
+  Eigen::MatrixXs poses = mot.poses;
+
+  StreamingMarkerFitter fitter(scaled.skeleton, scaled.markersMap, 0.02);
+  fitter.reset(poses.col(0));
+
+  int correct = 0;
+  int wrong = 0;
+  int total = 0;
+  for (int t = 0; t < 100; t++)
+  {
+    scaled.skeleton->setPositions(poses.col(t));
+    std::map<std::string, Eigen::Vector3s> markers
+        = scaled.skeleton->getMarkerMapWorldPositions(scaled.markersMap);
+    // Shuffle the points deterministically, so order gives nothing away
+    std::vector<std::string> names;
+    std::vector<Eigen::Vector3s> pointCloud;
+    for (auto& pair : markers)
+    {
+      names.push_back(pair.first);
+      pointCloud.push_back(pair.second);
+    }
+    std::rotate(names.begin(), names.begin() + (t % names.size()), names.end());
+    std::rotate(
+        pointCloud.begin(),
+        pointCloud.begin() + (t % pointCloud.size()),
+        pointCloud.end());
+
+    StreamingFrame frame = fitter.observePointCloud(pointCloud);
+    EXPECT_EQ(t, frame.time);
+    ASSERT_EQ(names.size(), frame.pointLabels.size());
+    for (int i = 0; i < names.size(); i++)
+    {
+      total++;
+      if (frame.pointLabels[i] == names[i])
+        correct++;
+      else if (frame.pointLabels[i] != "")
+        wrong++;
+    }
+    EXPECT_LT(frame.rmsMarkerError, 0.02);
+  }
+  EXPECT_GT(correct, 0.95 * total);
+  EXPECT_LT(wrong, 0.01 * total);
+}
+#endif
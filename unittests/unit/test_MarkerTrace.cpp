@@ -123,6 +123,51 @@ TEST(LABELLER, MAKE_TRACES_PARALLEL_TRACES)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(LABELLER, MAKE_TRACES_DENSE_SHUFFLED_CLOUD)
+{
+  const int TIMESTEPS = 200;
+  const int NUM_MARKERS = 150;
+
+  // Markers on a grid a few merge distances apart, each drifting in its own
+  // direction, with the order of the point cloud shuffled every frame
+  srand(42);
+  std::vector<Eigen::Vector3s> starts;
+  std::vector<Eigen::Vector3s> velocities;
+  for (int m = 0; m < NUM_MARKERS; m++)
+  {
+    starts.push_back(
+        Eigen::Vector3s(m % 5, (m / 5) % 5, m / 25) * 0.05
+        + Eigen::Vector3s::Constant(0.013));
+    velocities.push_back(Eigen::Vector3s::Random() * 0.001);
+  }
+  std::vector<std::vector<Eigen::Vector3s>> rawPoints;
+  for (int i = 0; i < TIMESTEPS; i++)
+  {
+    std::vector<Eigen::Vector3s> pointCloud;
+    for (int m = 0; m < NUM_MARKERS; m++)
+    {
+      pointCloud.push_back(starts[m] + velocities[m] * i);
+    }
+    std::random_shuffle(pointCloud.begin(), pointCloud.end());
+    rawPoints.push_back(pointCloud);
+  }
+
+  std::vector<biomechanics::MarkerTrace> traces
+      = biomechanics::MarkerTrace::createRawTraces(rawPoints);
+
+  EXPECT_EQ(traces.size(), NUM_MARKERS);
+  for (auto& trace : traces)
+  {
+    EXPECT_EQ(trace.mPoints.size(), TIMESTEPS);
+    for (int i = 1; i < trace.mPoints.size(); i++)
+    {
+      EXPECT_LT((trace.mPoints[i] - trace.mPoints[i - 1]).norm(), 0.002);
+    }
+  }
+}
+#endif
+
 /*
 #ifdef ALL_TESTS
 TEST(LABELLER, COMPUTE_JOINT_FINGERPRINTS)
@@ -0,0 +1,173 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/biomechanics/MarkerTrajectories.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+//==============================================================================
+TEST(MarkerTrajectories, ROUND_TRIP_FRAME_MAPS)
+{
+  std::vector<std::map<std::string, Eigen::Vector3s>> frames;
+  for (int t = 0; t < 20; t++)
+  {
+    frames.emplace_back();
+    frames[t]["A"] = Eigen::Vector3s::Random();
+    if (t % 3 != 0)
+      frames[t]["C"] = Eigen::Vector3s::Random();
+    if (t % 2 == 0)
+      frames[t]["B"] = Eigen::Vector3s::Random();
+  }
+
+  MarkerTrajectories trajectories = MarkerTrajectories::fromFrameMaps(frames);
+  EXPECT_EQ(trajectories.getNumFrames(), 20);
+  EXPECT_EQ(trajectories.getNumMarkers(), 3);
+  EXPECT_EQ(trajectories.getMarkerIndex("A"), 0);
+  EXPECT_EQ(trajectories.getMarkerIndex("B"), 1);
+  EXPECT_EQ(trajectories.getMarkerIndex("C"), 2);
+  EXPECT_EQ(trajectories.getMarkerIndex("D"), -1);
+
+  std::vector<std::map<std::string, Eigen::Vector3s>> recovered
+      = trajectories.toFrameMaps();
+  ASSERT_EQ(recovered.size(), frames.size());
+  for (int t = 0; t < frames.size(); t++)
+  {
+    EXPECT_EQ(recovered[t].size(), frames[t].size());
+    EXPECT_EQ(trajectories.getNumVisible(t), frames[t].size());
+    for (auto& pair : frames[t])
+    {
+      ASSERT_TRUE(recovered[t].count(pair.first) > 0);
+      EXPECT_TRUE(equals(recovered[t].at(pair.first), pair.second, 0));
+    }
+  }
+}
+
+//==============================================================================
+TEST(MarkerTrajectories, FRAME_VIEW_MATCHES_MAP)
+{
+  std::vector<std::map<std::string, Eigen::Vector3s>> frames;
+  for (int t = 0; t < 10; t++)
+  {
+    frames.emplace_back();
+    for (int i = 0; i < 6; i++)
+    {
+      if ((t + i) % 4 != 0)
+      {
+        frames[t]["m" + std::to_string(i)] = Eigen::Vector3s::Random();
+      }
+    }
+  }
+  MarkerTrajectories trajectories = MarkerTrajectories::fromFrameMaps(frames);
+
+  for (int t = 0; t < frames.size(); t++)
+  {
+    MarkerTrajectories::Frame frame = trajectories.getFrame(t);
+    EXPECT_EQ(frame.size(), frames[t].size());
+
+    // Iteration should visit exactly the visible markers, in the same order a
+    // std::map would
+    auto it = frames[t].begin();
+    for (const auto& observation : frame)
+    {
+      ASSERT_TRUE(it != frames[t].end());
+      EXPECT_EQ(observation.name, it->first);
+      EXPECT_TRUE(equals(observation.position, it->second, 0));
+      EXPECT_TRUE(frame.isVisible(it->first));
+      EXPECT_TRUE(equals(frame.at(it->first), it->second, 0));
+      ++it;
+    }
+    EXPECT_TRUE(it == frames[t].end());
+
+    // The dense block should agree with the per-marker accessors
+    Eigen::Matrix<s_t, 3, Eigen::Dynamic> block
+        = trajectories.getFramePositions(t);
+    for (int i = 0; i < trajectories.getNumMarkers(); i++)
+    {
+      EXPECT_TRUE(equals(
+          Eigen::Vector3s(block.col(i)), trajectories.getPosition(t, i), 0));
+      EXPECT_TRUE(equals(
+          Eigen::Vector3s(trajectories.getPositions().col(
+              t * trajectories.getNumMarkers() + i)),
+          trajectories.getPosition(t, i),
+          0));
+    }
+  }
+}
+
+//==============================================================================
+TEST(MarkerTrajectories, APPEND_AND_EDIT)
+{
+  std::vector<std::string> names;
+  names.push_back("x");
+  names.push_back("y");
+  MarkerTrajectories trajectories(names, 0);
+
+  for (int t = 0; t < 100; t++)
+  {
+    EXPECT_EQ(trajectories.appendFrame(), t);
+    trajectories.setPosition(t, 0, Eigen::Vector3s::Constant(t));
+    if (t % 2 == 0)
+      trajectories.setPosition(t, 1, Eigen::Vector3s::Constant(-t));
+  }
+  EXPECT_EQ(trajectories.getNumFrames(), 100);
+  EXPECT_EQ(trajectories.getPositions().cols(), 200);
+
+  for (int t = 0; t < 100; t++)
+  {
+    EXPECT_TRUE(trajectories.isVisible(t, 0));
+    EXPECT_EQ(trajectories.isVisible(t, 1), t % 2 == 0);
+    EXPECT_TRUE(equals(
+        trajectories.getPosition(t, 0),
+        Eigen::Vector3s(Eigen::Vector3s::Constant(t)),
+        0));
+  }
+
+  trajectories.swapMarkers(3, 0, 1);
+  EXPECT_FALSE(trajectories.isVisible(3, 0));
+  EXPECT_TRUE(trajectories.isVisible(3, 1));
+  EXPECT_TRUE(equals(
+      trajectories.getPosition(3, 1),
+      Eigen::Vector3s(Eigen::Vector3s::Constant(3)),
+      0));
+
+  trajectories.setHidden(4, 0);
+  EXPECT_FALSE(trajectories.isVisible(4, 0));
+  EXPECT_EQ(trajectories.getNumVisible(4), 1);
+
+  Eigen::Matrix3s R = math::expMapRot(Eigen::Vector3s::UnitZ() * 0.3);
+  Eigen::Vector3s before = trajectories.getPosition(10, 1);
+  trajectories.rotate(R);
+  Eigen::Vector3s expected = R * before;
+  EXPECT_TRUE(equals(trajectories.getPosition(10, 1), expected, 1e-12));
+}
+
+//==============================================================================
+TEST(MarkerTrajectories, TRC_COLUMNS_MATCH_MAPS)
+{
+  OpenSimTRC trc = OpenSimParser::loadTRC(
+      "dart://sample/osim/Sprinter/run0900cms.trc");
+
+  EXPECT_EQ(trc.markerTrajectories.getNumFrames(), trc.markerTimesteps.size());
+  EXPECT_EQ(trc.markerTrajectories.getNumFrames(), trc.timestamps.size());
+  for (int t = 0; t < trc.markerTimesteps.size(); t++)
+  {
+    EXPECT_EQ(
+        trc.markerTrajectories.getNumVisible(t), trc.markerTimesteps[t].size());
+    for (auto& pair : trc.markerTimesteps[t])
+    {
+      int index = trc.markerTrajectories.getMarkerIndex(pair.first);
+      ASSERT_NE(index, -1);
+      EXPECT_TRUE(trc.markerTrajectories.isVisible(t, index));
+      EXPECT_TRUE(equals(
+          trc.markerTrajectories.getPosition(t, index), pair.second, 0));
+    }
+  }
+}
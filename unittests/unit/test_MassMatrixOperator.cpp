@@ -0,0 +1,85 @@
+#include <memory>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/MassMatrixOperator.hpp"
+#include "dart/simulation/World.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+
+namespace {
+
+/// This builds a world with a three link arm and a free box, so the mass
+/// matrix has two blocks of different sizes
+WorldPtr createArmAndBoxWorld()
+{
+  WorldPtr world = World::create();
+
+  SkeletonPtr arm = Skeleton::create("arm");
+  BodyNode* parent = nullptr;
+  for (int i = 0; i < 3; i++)
+  {
+    auto pair = arm->createJointAndBodyNodePair<RevoluteJoint>(parent);
+    pair.first->setAxis(Eigen::Vector3s::UnitZ());
+    Eigen::Isometry3s fromParent = Eigen::Isometry3s::Identity();
+    fromParent.translation() = Eigen::Vector3s::UnitX() * (i == 0 ? 0 : 1);
+    pair.first->setTransformFromParentBodyNode(fromParent);
+    pair.second->createShapeNodeWith<VisualAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3s(1.0, 0.1, 0.1)));
+    pair.second->setMass(1.0 + i);
+    parent = pair.second;
+  }
+  world->addSkeleton(arm);
+
+  SkeletonPtr box = Skeleton::create("box");
+  auto boxPair = box->createJointAndBodyNodePair<FreeJoint>();
+  boxPair.second->createShapeNodeWith<VisualAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3s(0.5, 1.0, 2.0)));
+  boxPair.second->setMass(3.0);
+  world->addSkeleton(box);
+
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setVelocities(Eigen::VectorXs::Random(world->getNumDofs()));
+  return world;
+}
+
+} // namespace
+
+TEST(MASS_MATRIX_OPERATOR, MATCHES_DENSE_MASS_MATRIX)
+{
+  WorldPtr world = createArmAndBoxWorld();
+  neural::MassMatrixOperator M(world);
+  EXPECT_EQ(M.rows(), world->getNumDofs());
+  EXPECT_EQ(M.cols(), world->getNumDofs());
+
+  Eigen::MatrixXs x = Eigen::MatrixXs::Random(world->getNumDofs(), 4);
+  Eigen::MatrixXs dense = world->getMassMatrix() * x;
+  Eigen::MatrixXs implicit = M.multiply(x);
+  EXPECT_TRUE(equals(dense, implicit, 1e-9));
+}
+
+TEST(MASS_MATRIX_OPERATOR, MATCHES_DENSE_INV_MASS_MATRIX)
+{
+  WorldPtr world = createArmAndBoxWorld();
+  neural::MassMatrixOperator M(world);
+
+  Eigen::MatrixXs x = Eigen::MatrixXs::Random(world->getNumDofs(), 4);
+  Eigen::MatrixXs dense = world->getInvMassMatrix() * x;
+  Eigen::MatrixXs implicit = M.multiplyByInverse(x);
+  EXPECT_TRUE(equals(dense, implicit, 1e-9));
+
+  // Applying the operator shouldn't leave anything behind on the world
+  Eigen::VectorXs forces = world->getControlForces();
+  M.multiplyByInverse(x);
+  EXPECT_TRUE(equals(forces, world->getControlForces(), 0));
+}
@@ -37,6 +37,7 @@
 #include "dart/common/Timer.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/BlockDiagonalMatrix.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
 #include "dart/simulation/World.hpp"
@@ -1439,3 +1440,34 @@ TEST(MATH, PerformanceComparisonOfAdTJac)
   // Note: The best function for dynamic size Jacobian is AdTJac2, and the best
   //       function for fixed size Jacobian is AdTJac3
 }
+
+//==============================================================================
+TEST(MATH, BLOCK_DIAGONAL_MATRIX)
+{
+  math::BlockDiagonalMatrix M;
+  M.addBlock(Eigen::MatrixXs::Random(2, 2));
+  M.addBlock(Eigen::MatrixXs::Random(1, 1));
+  M.addBlock(Eigen::MatrixXs::Random(3, 3));
+  Eigen::MatrixXs dense = M.toDense();
+
+  EXPECT_EQ(6, M.rows());
+  EXPECT_EQ(6, M.cols());
+  EXPECT_EQ(3, M.getBlockOffset(2));
+  EXPECT_TRUE(dense.block(0, 2, 2, 4).isZero());
+  EXPECT_TRUE(dense.block(2, 3, 1, 3).isZero());
+
+  Eigen::MatrixXs A = Eigen::MatrixXs::Random(6, 4);
+  Eigen::VectorXs v = Eigen::VectorXs::Random(6);
+  Eigen::MatrixXs rightProduct = M * A;
+  Eigen::VectorXs vectorProduct = M * v;
+  Eigen::MatrixXs leftProduct = A.transpose() * M;
+  Eigen::MatrixXs sandwich = A.transpose() * (M * A);
+  EXPECT_TRUE(equals(rightProduct, (dense * A).eval(), 1e-12));
+  EXPECT_TRUE(equals(vectorProduct, (dense * v).eval(), 1e-12));
+  EXPECT_TRUE(equals(leftProduct, (A.transpose() * dense).eval(), 1e-12));
+  EXPECT_TRUE(equals(sandwich, (A.transpose() * dense * A).eval(), 1e-12));
+  EXPECT_TRUE(equals((M * M).toDense(), (dense * dense).eval(), 1e-12));
+  EXPECT_TRUE(equals((2.0 * M).toDense(), (2.0 * dense).eval(), 1e-12));
+  EXPECT_TRUE(
+      equals(M.transpose().toDense(), Eigen::MatrixXs(dense.transpose())));
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/math/MeshAdjacency.hpp"
+
+using namespace dart;
+
+namespace {
+
+/// This builds a unit cube centered at the origin, where every face is a fan
+/// of 4 triangles around a center vertex, and every face has its own copies
+/// of its vertices (like meshes coming out of Assimp do)
+void makeCube(
+    std::vector<Eigen::Vector3s>& vertices,
+    std::vector<Eigen::Vector3i>& triangles)
+{
+  const s_t corners[4][2]
+      = {{-0.5, -0.5}, {0.5, -0.5}, {0.5, 0.5}, {-0.5, 0.5}};
+  for (int axis = 0; axis < 3; axis++)
+  {
+    for (s_t sign : {-1.0, 1.0})
+    {
+      Eigen::Vector3s normal = Eigen::Vector3s::Unit(axis) * sign;
+      Eigen::Vector3s u = Eigen::Vector3s::Unit((axis + 1) % 3);
+      Eigen::Vector3s v = Eigen::Vector3s::Unit((axis + 2) % 3) * sign;
+      int center = vertices.size();
+      vertices.push_back(normal * 0.5);
+      for (int k = 0; k < 4; k++)
+      {
+        vertices.push_back(
+            normal * 0.5 + u * corners[k][0] + v * corners[k][1]);
+      }
+      for (int k = 0; k < 4; k++)
+      {
+        triangles.emplace_back(
+            center, center + 1 + k, center + 1 + (k + 1) % 4);
+      }
+    }
+  }
+}
+
+} // namespace
+
+//==============================================================================
+TEST(MeshAdjacency, CUBE)
+{
+  std::vector<Eigen::Vector3s> vertices;
+  std::vector<Eigen::Vector3i> triangles;
+  makeCube(vertices, triangles);
+
+  math::MeshAdjacency adjacency(vertices, triangles);
+  // 8 corners and 6 face centers
+  EXPECT_EQ(14u, adjacency.getVertices().size());
+  EXPECT_EQ(24u, adjacency.getTriangles().size());
+  EXPECT_TRUE(adjacency.isClosed());
+  EXPECT_TRUE(adjacency.isConvex());
+  for (int i = 0; i < vertices.size(); i++)
+  {
+    EXPECT_EQ(
+        adjacency.getWeldedIndices()[i], adjacency.findVertex(vertices[i]));
+  }
+  EXPECT_EQ(-1, adjacency.findVertex(Eigen::Vector3s(0.1, 0.2, 0.3)));
+  const std::vector<int>& twins = adjacency.getHalfEdgeTwins();
+  for (int h = 0; h < twins.size(); h++)
+  {
+    EXPECT_EQ(h, twins[twins[h]]);
+  }
+  // Face normals point out of the cube
+  for (int f = 0; f < adjacency.getTriangles().size(); f++)
+  {
+    Eigen::Vector3s centroid = Eigen::Vector3s::Zero();
+    for (int k = 0; k < 3; k++)
+      centroid += adjacency.getVertices()[adjacency.getTriangles()[f](k)] / 3;
+    EXPECT_GT(adjacency.getFaceNormals()[f].dot(centroid), 0);
+  }
+
+  // Walking out from a top corner finds the whole top face, including its
+  // center (which isn't a vertex of the convex hull), in scan order
+  auto onTop = [&](int i) { return adjacency.getVertices()[i](2) > 0.4; };
+  int start = adjacency.findVertex(Eigen::Vector3s(0.5, 0.5, 0.5));
+  std::vector<int> patch;
+  adjacency.floodFill(start, onTop, patch);
+  std::vector<int> bruteForce;
+  for (int i = 0; i < vertices.size(); i++)
+  {
+    int welded = adjacency.getWeldedIndices()[i];
+    if (onTop(welded)
+        && std::find(bruteForce.begin(), bruteForce.end(), welded)
+               == bruteForce.end())
+      bruteForce.push_back(welded);
+  }
+  EXPECT_EQ(5u, patch.size());
+  EXPECT_EQ(bruteForce, patch);
+
+  adjacency.floodFill(start, [](int) { return false; }, patch);
+  EXPECT_TRUE(patch.empty());
+}
+
+//==============================================================================
+TEST(MeshAdjacency, DENTED_AND_OPEN)
+{
+  std::vector<Eigen::Vector3s> vertices;
+  std::vector<Eigen::Vector3i> triangles;
+  makeCube(vertices, triangles);
+
+  // Pushing in the center of the last face (+z) makes a dimple
+  std::vector<Eigen::Vector3s> dented = vertices;
+  dented[25] = Eigen::Vector3s(0, 0, 0.3);
+  math::MeshAdjacency dentedAdjacency(dented, triangles);
+  EXPECT_TRUE(dentedAdjacency.isClosed());
+  EXPECT_FALSE(dentedAdjacency.isConvex());
+
+  // Dropping a triangle leaves a hole
+  std::vector<Eigen::Vector3i> open = triangles;
+  open.pop_back();
+  math::MeshAdjacency openAdjacency(vertices, open);
+  EXPECT_FALSE(openAdjacency.isClosed());
+  EXPECT_FALSE(openAdjacency.isConvex());
+}
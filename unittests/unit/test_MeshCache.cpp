@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "dart/common/LocalResourceRetriever.hpp"
+#include "dart/config.hpp"
+#include "dart/dynamics/MeshCache.hpp"
+#include "dart/dynamics/MeshShape.hpp"
+
+using namespace dart;
+
+namespace {
+
+const std::string MESH_PATH
+    = DART_DATA_PATH "urdf/drchubo/meshes/convhull_NK2.stl";
+
+} // namespace
+
+//==============================================================================
+TEST(MeshCache, SAME_URI_IS_SHARED)
+{
+  dynamics::MeshCache cache;
+  auto retriever = std::make_shared<common::LocalResourceRetriever>();
+
+  auto first = cache.load("file://" + MESH_PATH, retriever);
+  auto second = cache.load("file://" + MESH_PATH, retriever);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(cache.getNumMeshes(), 1);
+  EXPECT_EQ(cache.getNumImports(), 1);
+  EXPECT_EQ(cache.getNumHits(), 1);
+
+  // Shapes with different scales still share the mesh, and its hull
+  dynamics::MeshShape small(Eigen::Vector3s::Constant(0.5), first);
+  dynamics::MeshShape big(Eigen::Vector3s::Constant(2.0), second);
+  EXPECT_EQ(small.getSupportHull(), big.getSupportHull());
+  EXPECT_TRUE(small.getBoundingBox().getMax().isApprox(
+      big.getBoundingBox().getMax() / 4.0));
+}
+
+//==============================================================================
+TEST(MeshCache, SAME_CONTENTS_ARE_SHARED)
+{
+  dynamics::MeshCache cache;
+  auto retriever = std::make_shared<common::LocalResourceRetriever>();
+
+  // Copy the mesh somewhere else, so it has a different URI
+  const std::string copyPath = "/tmp/test_MeshCache_copy.stl";
+  {
+    std::ifstream in(MESH_PATH, std::ios::binary);
+    std::ofstream out(copyPath, std::ios::binary);
+    out << in.rdbuf();
+  }
+
+  auto original = cache.load("file://" + MESH_PATH, retriever);
+  auto copy = cache.load("file://" + copyPath, retriever);
+  ASSERT_NE(original, nullptr);
+  EXPECT_EQ(original, copy);
+  EXPECT_EQ(cache.getNumImports(), 1);
+  std::remove(copyPath.c_str());
+}
+
+//==============================================================================
+TEST(MeshCache, CACHE_OFF_ALWAYS_IMPORTS)
+{
+  dynamics::MeshCache cache;
+  cache.setEnabled(false);
+  auto retriever = std::make_shared<common::LocalResourceRetriever>();
+
+  auto first = cache.load("file://" + MESH_PATH, retriever);
+  auto second = cache.load("file://" + MESH_PATH, retriever);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(cache.getNumImports(), 2);
+  EXPECT_EQ(cache.getNumMeshes(), 0);
+}
+
+//==============================================================================
+TEST(MeshCache, MISSING_FILES_RETURN_NULL)
+{
+  dynamics::MeshCache cache;
+  auto retriever = std::make_shared<common::LocalResourceRetriever>();
+  EXPECT_EQ(
+      cache.load("file://" DART_DATA_PATH "does/not/exist.stl", retriever),
+      nullptr);
+  EXPECT_EQ(cache.getNumMeshes(), 0);
+}
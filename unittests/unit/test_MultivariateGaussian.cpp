@@ -79,6 +79,45 @@ TEST(MultivariateGaussian, BASICS)
   }
 }
 
+//==============================================================================
+TEST(MultivariateGaussian, BATCH_MATCHES_SINGLE)
+{
+  std::vector<std::string> cols;
+  cols.push_back("a");
+  cols.push_back("b");
+  cols.push_back("c");
+  srand(42);
+  Eigen::MatrixXs A = Eigen::MatrixXs::Random(3, 3);
+  Eigen::MatrixXs cov
+      = A * A.transpose() + Eigen::MatrixXs::Identity(3, 3) * 0.1;
+  Eigen::VectorXs mu = Eigen::VectorXs::Random(3);
+  MultivariateGaussian gauss(cols, mu, cov);
+
+  // The cached normalization constant should match the textbook formula
+  EXPECT_NEAR(
+      gauss.computePDF(mu),
+      1.0 / sqrt(pow(2 * M_PI, 3) * cov.determinant()),
+      1e-9);
+
+  Eigen::MatrixXs xs = Eigen::MatrixXs::Random(3, 7);
+  Eigen::VectorXs logPDFs = gauss.computeLogPDFBatch(xs);
+  Eigen::VectorXs unnormalized = gauss.computeLogPDFBatch(xs, false);
+  Eigen::MatrixXs grads = gauss.computeLogPDFGradBatch(xs);
+  for (int i = 0; i < xs.cols(); i++)
+  {
+    EXPECT_NEAR(logPDFs(i), gauss.computeLogPDF(xs.col(i)), 1e-9);
+    EXPECT_NEAR(unnormalized(i), gauss.computeLogPDF(xs.col(i), false), 1e-9);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(grads.col(i)),
+        gauss.computeLogPDFGrad(xs.col(i)),
+        1e-9));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(grads.col(i)),
+        gauss.finiteDifferenceLogPDFGrad(xs.col(i)),
+        1e-6));
+  }
+}
+
 //==============================================================================
 TEST(MultivariateGaussian, OBSERVE_2_TO_1)
 {
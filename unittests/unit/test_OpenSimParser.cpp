@@ -1,7 +1,12 @@
+#include <fstream>
+#include <sstream>
+
 #include <gtest/gtest.h>
 
 #include "dart/biomechanics/C3DLoader.hpp"
+#include "dart/biomechanics/FastTextParsing.hpp"
 #include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/biomechanics/OpenSimBatchExporter.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/realtime/Ticker.hpp"
@@ -114,6 +119,67 @@ TEST(OpenSimParser, LOAD_TRC)
 }
 #endif
 
+TEST(OpenSimParser, FAST_PARSE_DOUBLE_MATCHES_ATOF)
+{
+  std::vector<std::string> tokens = {"0",
+                                     "-0",
+                                     "679.8120727539062",
+                                     "-995.9971923828124",
+                                     "0.01",
+                                     "1.5E-3",
+                                     "-.5e2",
+                                     "9007199254740993",
+                                     "123456789012345678901234",
+                                     "1e-30",
+                                     "1e300",
+                                     "12abc",
+                                     "abc",
+                                     "-inf"};
+  for (const std::string& token : tokens)
+  {
+    double fast = parseDouble(token.data(), token.data() + token.size());
+    EXPECT_EQ(fast, atof(token.c_str())) << token;
+  }
+
+  // Tokens are read in place, without needing a terminator after them
+  std::string line = "1\t0.25 \t-3e2\r\n42";
+  const char* cursor = line.data();
+  const char* lineEnd = line.data() + line.find('\n');
+  const char* tokenStart;
+  const char* tokenEnd;
+  std::vector<double> values;
+  while (nextToken(cursor, lineEnd, tokenStart, tokenEnd))
+  {
+    values.push_back(parseDouble(tokenStart, tokenEnd));
+  }
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(values[0], 1.0);
+  EXPECT_EQ(values[1], 0.25);
+  EXPECT_EQ(values[2], -300.0);
+}
+
+TEST(OpenSimParser, BINARY_TRC_ROUND_TRIP)
+{
+  OpenSimTRC text
+      = OpenSimParser::loadTRC("dart://sample/osim/Sprinter/run0900cms.trc");
+  OpenSimParser::saveTRCBinary("./run0900cms_roundtrip.trc.bin", text);
+  OpenSimTRC binary
+      = OpenSimParser::loadTRCBinary("./run0900cms_roundtrip.trc.bin");
+
+  EXPECT_EQ(binary.timestamps, text.timestamps);
+  EXPECT_EQ(binary.framesPerSecond, text.framesPerSecond);
+  EXPECT_EQ(
+      binary.markerTrajectories.getMarkerNames(),
+      text.markerTrajectories.getMarkerNames());
+  ASSERT_EQ(
+      binary.markerTrajectories.getNumFrames(),
+      text.markerTrajectories.getNumFrames());
+  EXPECT_TRUE(
+      binary.markerTrajectories.getPositions()
+      == text.markerTrajectories.getPositions());
+  EXPECT_EQ(binary.markerTimesteps, text.markerTimesteps);
+}
+
 #ifdef ALL_TESTS
 TEST(OpenSimParser, LOAD_GRF)
 {
@@ -288,6 +354,45 @@ TEST(OpenSimParser, DELP_1990)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(OpenSimParser, PARSE_CACHE_RETURNS_INDEPENDENT_CLONES)
+{
+  OpenSimParser::clearParseCache();
+  OpenSimFile uncached = OpenSimParser::parseOsimUncached(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  OpenSimFile first = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  OpenSimFile second = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  ASSERT_TRUE(first.skeleton != nullptr);
+  ASSERT_TRUE(second.skeleton != nullptr);
+  EXPECT_NE(first.skeleton, second.skeleton);
+
+  // The cached copy builds the same Skeleton as a fresh parse
+  EXPECT_EQ(second.skeleton->getNumDofs(), uncached.skeleton->getNumDofs());
+  EXPECT_EQ(
+      second.skeleton->getNumBodyNodes(), uncached.skeleton->getNumBodyNodes());
+  EXPECT_TRUE(equals(
+      second.skeleton->getPositions(), uncached.skeleton->getPositions()));
+  EXPECT_TRUE(equals(
+      second.skeleton->getLinkMasses(), uncached.skeleton->getLinkMasses()));
+  EXPECT_EQ(second.markersMap.size(), uncached.markersMap.size());
+  for (auto& pair : second.markersMap)
+  {
+    ASSERT_TRUE(pair.second.first != nullptr);
+    EXPECT_EQ(pair.second.first->getSkeleton(), second.skeleton);
+  }
+
+  // Changing one result doesn't leak into the next one
+  first.skeleton->setBodyScales(
+      Eigen::VectorXs::Ones(first.skeleton->getNumBodyNodes() * 3) * 1.1);
+  OpenSimFile third = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  EXPECT_TRUE(equals(
+      third.skeleton->getBodyScales(), second.skeleton->getBodyScales()));
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(OpenSimParser, SCALING)
 {
@@ -359,6 +464,85 @@ TEST(OpenSimParser, MOVE_OUTPUT_MARKERS)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(OpenSimParser, BATCH_EXPORT_MATCHES_SINGLE_FILES)
+{
+  auto readFile = [](const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+  };
+
+  const std::string model
+      = "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim";
+  OpenSimFile standard = OpenSimParser::parseOsim(model);
+  std::map<std::string, Eigen::Vector3s> bodyScales;
+  for (int i = 0; i < standard.skeleton->getNumBodyNodes(); i++)
+  {
+    bodyScales[standard.skeleton->getBodyNode(i)->getName()]
+        = Eigen::Vector3s(1.1, 0.9, 1.2);
+  }
+  std::map<std::string, std::pair<std::string, Eigen::Vector3s>> markerOffsets;
+  std::vector<std::string> markerNames;
+  for (auto& pair : standard.markersMap)
+  {
+    markerOffsets[pair.first] = std::make_pair(
+        pair.second.first->getName(),
+        Eigen::Vector3s(pair.second.second + Eigen::Vector3s::Constant(0.01)));
+    markerNames.push_back(pair.first);
+  }
+
+  OpenSimBatchExporter exporter(model);
+  EXPECT_TRUE(exporter.isValid());
+
+  // Moving the markers twice in a row shouldn't leak the first move into the
+  // second file
+  exporter.saveMovedMarkers(
+      bodyScales, markerOffsets, "/tmp/test_batch_scaled_first.osim");
+  bodyScales.begin()->second = Eigen::Vector3s::Ones();
+  exporter.saveMovedMarkers(
+      bodyScales, markerOffsets, "/tmp/test_batch_scaled.osim");
+  OpenSimParser::moveOsimMarkers(
+      model, bodyScales, markerOffsets, "/tmp/test_single_scaled.osim");
+  EXPECT_EQ(
+      readFile("/tmp/test_single_scaled.osim"),
+      readFile("/tmp/test_batch_scaled.osim"));
+
+  std::vector<OpenSimExportTrial> trials;
+  for (int i = 0; i < 3; i++)
+  {
+    OpenSimExportTrial trial;
+    trial.name = "trial" + std::to_string(i);
+    for (int t = 0; t < 5; t++)
+    {
+      trial.timestamps.push_back(t * 0.01);
+    }
+    trial.poses = Eigen::MatrixXs::Random(standard.skeleton->getNumDofs(), 5);
+    trials.push_back(trial);
+  }
+  exporter.saveTrials(
+      standard.skeleton, markerNames, "scaled.osim", trials, "/tmp");
+
+  for (OpenSimExportTrial& trial : trials)
+  {
+    OpenSimParser::saveOsimInverseKinematicsXMLFile(
+        trial.name,
+        markerNames,
+        "scaled.osim",
+        trial.name + ".trc",
+        trial.name + "_ik_by_opensim.mot",
+        "/tmp/test_single_ik_setup.xml");
+    EXPECT_EQ(
+        readFile("/tmp/test_single_ik_setup.xml"),
+        readFile("/tmp/" + trial.name + "_ik_setup.xml"));
+    OpenSimMot mot = OpenSimParser::loadMot(
+        standard.skeleton, "/tmp/" + trial.name + "_ik.mot");
+    EXPECT_EQ(trial.timestamps.size(), mot.timestamps.size());
+  }
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(OpenSimParser, RATIONALIZE_CUSTOM_JOINTS)
 {
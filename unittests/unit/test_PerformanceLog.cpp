@@ -31,17 +31,21 @@
  */
 
 #include <iostream>
+#include <thread>
+#include <vector>
 
-#ifdef HAVE_PERF_UTILS
-
-#include <PerfUtils/TimeTrace.h>
 #include <gtest/gtest.h>
 
 #include "dart/performance/PerformanceLog.hpp"
 
+#ifdef HAVE_PERF_UTILS
+#include <PerfUtils/TimeTrace.h>
+#endif
+
 using namespace dart;
 using namespace dart::performance;
 
+#ifdef HAVE_PERF_UTILS
 TEST(PERFORMANCE, TIME_TRACE)
 {
   uint64_t start = PerfUtils::Cycles::rdtsc();
@@ -53,6 +57,7 @@ TEST(PERFORMANCE, TIME_TRACE)
   std::cout << PerfUtils::TimeTrace::getTrace() << std::endl;
   std::cout << "Cycles: " << (end - start) << std::endl;
 }
+#endif
 
 TEST(PERFORMANCE, TWO_ROOTS)
 {
@@ -98,4 +103,101 @@ TEST(PERFORMANCE, NESTED)
   std::cout << finalizedRoot->prettyPrint() << std::endl;
 }
 
-#endif
\ No newline at end of file
+TEST(PERFORMANCE, MULTITHREADED)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  // Enough runs per thread to spill over into more than one buffer chunk
+  int numThreads = 4;
+  int runsPerThread = 3000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++)
+  {
+    threads.emplace_back([root, runsPerThread]() {
+      PerformanceLog* worker = root->startRun("worker");
+      for (int i = 0; i < runsPerThread; i++)
+      {
+        PerformanceLog* child = worker->startRun("child");
+        child->end();
+      }
+      worker->end();
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  EXPECT_EQ(finalizedRoots.size(), 1);
+  std::shared_ptr<FinalizedPerformanceLog> worker
+      = finalizedRoots["root"]->getChild("worker");
+  EXPECT_EQ(worker->getNumRuns(), numThreads);
+  EXPECT_EQ(
+      worker->getChild("child")->getNumRuns(), numThreads * runsPerThread);
+
+  std::string trace = PerformanceLog::toChromeTraceJson();
+  EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+  int numEvents = 0;
+  for (std::size_t i = trace.find("\"ph\":\"X\""); i != std::string::npos;
+       i = trace.find("\"ph\":\"X\"", i + 1))
+  {
+    numEvents++;
+  }
+  EXPECT_EQ(numEvents, 1 + numThreads * (1 + runsPerThread));
+
+  // Starting over drops everything we've recorded so far
+  PerformanceLog::initialize();
+  EXPECT_EQ(PerformanceLog::finalize().size(), 0);
+}
+
+TEST(PERFORMANCE, COUNTERS)
+{
+  PerformanceLog::initialize();
+  // This depends on the machine, so we only check the counters if we get them
+  bool hardware = PerformanceLog::setHardwareCountersEnabled(true);
+  EXPECT_EQ(PerformanceLog::getHardwareCountersEnabled(), hardware);
+
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  std::vector<std::vector<double>> buffers;
+  for (int i = 0; i < 10; i++)
+  {
+    PerformanceLog* child = root->startRun("child");
+    buffers.emplace_back(1000, 1.0);
+    child->end();
+  }
+  root->end();
+  PerformanceLog::setHardwareCountersEnabled(false);
+  EXPECT_FALSE(PerformanceLog::getHardwareCountersEnabled());
+
+  std::shared_ptr<FinalizedPerformanceLog> child
+      = PerformanceLog::finalize()["root"]->getChild("child");
+  std::string printed = child->prettyPrint();
+  std::string trace = PerformanceLog::toChromeTraceJson();
+
+  EXPECT_EQ(child->hasCounter(INSTRUCTIONS), hardware);
+  EXPECT_EQ(child->hasCounter(CACHE_MISSES), hardware);
+  if (hardware)
+  {
+    EXPECT_GT(child->getTotalCounter(INSTRUCTIONS), 0u);
+    EXPECT_NE(printed.find("instructions"), std::string::npos);
+    EXPECT_NE(trace.find("\"instructions\":"), std::string::npos);
+  }
+
+  bool allocations = PerformanceLog::isAllocationTrackingAvailable();
+  EXPECT_EQ(child->hasCounter(ALLOCATIONS), allocations);
+  if (allocations)
+  {
+    EXPECT_GE(child->getTotalCounter(ALLOCATIONS), 10u);
+    EXPECT_GE(
+        child->getTotalCounter(ALLOCATED_BYTES), 10u * 1000 * sizeof(double));
+    EXPECT_NE(printed.find("allocated bytes"), std::string::npos);
+  }
+
+  if (!hardware && !allocations)
+  {
+    EXPECT_EQ(trace.find("\"args\""), std::string::npos);
+  }
+}
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/common/Pipeline.hpp"
+
+using namespace dart;
+using namespace common;
+
+//==============================================================================
+TEST(Pipeline, RunsEveryStageInOrder)
+{
+  Pipeline<std::vector<int>> pipeline;
+  pipeline
+      .addStage(
+          "load", [](std::vector<int>& item) { item.push_back(1); }, 3, 2)
+      .addStage(
+          "fit", [](std::vector<int>& item) { item.push_back(2); }, 2, 4)
+      .addStage(
+          "export", [](std::vector<int>& item) { item.push_back(3); });
+  EXPECT_EQ(pipeline.getNumStages(), 3);
+
+  std::vector<std::vector<int>> items;
+  for (int i = 0; i < 50; i++)
+  {
+    items.push_back(std::vector<int>{i});
+  }
+  std::vector<std::vector<int>> results = pipeline.run(items);
+
+  ASSERT_EQ(results.size(), 50u);
+  for (int i = 0; i < 50; i++)
+  {
+    EXPECT_EQ(results[i], (std::vector<int>{i, 1, 2, 3}));
+  }
+  EXPECT_TRUE(pipeline.getFailures().empty());
+  EXPECT_FALSE(pipeline.isRunning());
+
+  std::vector<PipelineStageStats> stats = pipeline.getStageStats();
+  ASSERT_EQ(stats.size(), 3u);
+  EXPECT_EQ(stats[0].name, "load");
+  EXPECT_EQ(stats[0].numWorkers, 3);
+  EXPECT_EQ(stats[1].queueCapacity, 4);
+  for (const PipelineStageStats& stage : stats)
+  {
+    EXPECT_EQ(stage.itemsProcessed, 50);
+    EXPECT_EQ(stage.itemsFailed, 0);
+    EXPECT_GT(stage.itemsPerSecond, 0.0);
+  }
+}
+
+//==============================================================================
+TEST(Pipeline, QueuesStayBounded)
+{
+  // The slow second stage should hold up the first one, rather than letting
+  // it run ahead and pile up items
+  std::atomic<int> started(0);
+  std::atomic<int> finished(0);
+  std::atomic<int> maxAhead(0);
+
+  Pipeline<int> pipeline;
+  pipeline
+      .addStage(
+          "fast",
+          [&](int&) {
+            int ahead = ++started - finished;
+            int prev = maxAhead;
+            while (ahead > prev && !maxAhead.compare_exchange_weak(prev, ahead))
+            {
+            }
+          },
+          1,
+          2)
+      .addStage(
+          "slow",
+          [&](int&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            finished++;
+          },
+          1,
+          3);
+
+  std::vector<int> items(30, 0);
+  pipeline.run(items);
+
+  // At most: 1 in the slow worker, 3 in its queue, and 1 the fast worker is
+  // blocked trying to hand off, plus the one it just started
+  EXPECT_LE(maxAhead.load(), 6);
+  std::vector<PipelineStageStats> stats = pipeline.getStageStats();
+  EXPECT_LE(stats[0].maxQueueDepth, 2);
+  EXPECT_LE(stats[1].maxQueueDepth, 3);
+  EXPECT_GT(stats[0].waitingForOutputSeconds, 0.0);
+}
+
+//==============================================================================
+TEST(Pipeline, DropsAndRecordsFailures)
+{
+  Pipeline<int> pipeline;
+  pipeline
+      .addStage(
+          "check",
+          [](int& item) {
+            if (item % 5 == 0)
+              throw std::runtime_error("bad trial " + std::to_string(item));
+          },
+          2)
+      .addStage("double", [](int& item) { item *= 2; });
+
+  std::vector<int> items;
+  for (int i = 1; i <= 20; i++)
+  {
+    items.push_back(i);
+  }
+  std::vector<int> results = pipeline.run(items);
+
+  ASSERT_EQ(results.size(), 16u);
+  int expected = 1;
+  for (int result : results)
+  {
+    if (expected % 5 == 0)
+      expected++;
+    EXPECT_EQ(result, expected * 2);
+    expected++;
+  }
+
+  std::vector<PipelineFailure> failures = pipeline.getFailures();
+  ASSERT_EQ(failures.size(), 4u);
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_EQ(failures[i].index, 5 * (i + 1) - 1);
+    EXPECT_EQ(failures[i].stage, "check");
+    EXPECT_EQ(failures[i].message, "bad trial " + std::to_string(5 * (i + 1)));
+  }
+
+  std::vector<PipelineStageStats> stats = pipeline.getStageStats();
+  EXPECT_EQ(stats[0].itemsProcessed, 16);
+  EXPECT_EQ(stats[0].itemsFailed, 4);
+  EXPECT_EQ(stats[1].itemsProcessed, 16);
+}
+
+//==============================================================================
+TEST(Pipeline, OverlapsStages)
+{
+  // Two stages that each take 10ms per item would take 200ms for 10 items
+  // one after the other. Pipelined, the second stage works on item k while
+  // the first works on item k+1, so it's closer to 110ms.
+  auto sleep = [](int&) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  };
+  Pipeline<int> pipeline;
+  pipeline.addStage("io", sleep).addStage("compute", sleep);
+
+  auto start = std::chrono::steady_clock::now();
+  pipeline.run(std::vector<int>(10, 0));
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  EXPECT_LT(elapsed, 0.18);
+}
+
+//==============================================================================
+TEST(Pipeline, CanRunAgain)
+{
+  Pipeline<int> pipeline;
+  pipeline.addStage("increment", [](int& item) { item++; }, 2);
+
+  pipeline.start();
+  for (int i = 0; i < 5; i++)
+  {
+    EXPECT_EQ(pipeline.push(i), i);
+  }
+  EXPECT_TRUE(pipeline.isRunning());
+  EXPECT_EQ(pipeline.finish(), (std::vector<int>{1, 2, 3, 4, 5}));
+
+  EXPECT_EQ(pipeline.run({10, 20}), (std::vector<int>{11, 21}));
+  EXPECT_EQ(pipeline.getStageStats()[0].itemsProcessed, 2);
+}
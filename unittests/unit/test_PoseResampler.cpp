@@ -0,0 +1,118 @@
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/PoseResampler.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/Geometry.hpp"
+
+using namespace dart;
+using namespace dynamics;
+
+namespace {
+
+/// A FreeJoint root, then a BallJoint, then a RevoluteJoint
+SkeletonPtr createSkeleton()
+{
+  SkeletonPtr skel = Skeleton::create();
+  auto root = skel->createJointAndBodyNodePair<FreeJoint>();
+  auto ball = skel->createJointAndBodyNodePair<BallJoint>(root.second);
+  skel->createJointAndBodyNodePair<RevoluteJoint>(ball.second);
+  return skel;
+}
+
+} // namespace
+
+//==============================================================================
+TEST(PoseResampler, FINDS_ROTATIONS)
+{
+  SkeletonPtr skel = createSkeleton();
+  PoseResampler resampler(skel);
+  ASSERT_EQ(2, resampler.getRotationDofs().size());
+  EXPECT_EQ(0, resampler.getRotationDofs()[0]);
+  EXPECT_EQ(6, resampler.getRotationDofs()[1]);
+}
+
+//==============================================================================
+TEST(PoseResampler, SLERPS_ROTATIONS)
+{
+  SkeletonPtr skel = createSkeleton();
+  PoseResampler resampler(skel);
+
+  Eigen::VectorXs from = Eigen::VectorXs::Zero(skel->getNumDofs());
+  Eigen::VectorXs to = Eigen::VectorXs::Zero(skel->getNumDofs());
+  from.segment<3>(0) = Eigen::Vector3s(0.3, -0.2, 0.1);
+  to.segment<3>(0) = Eigen::Vector3s(-0.4, 0.9, 0.5);
+  from.segment<3>(3) = Eigen::Vector3s(1, 2, 3);
+  to.segment<3>(3) = Eigen::Vector3s(3, 2, 1);
+  from.segment<3>(6) = Eigen::Vector3s(0.0, 0.0, 1.0);
+  to.segment<3>(6) = Eigen::Vector3s(0.0, 1.0, 0.0);
+  from(9) = -1;
+  to(9) = 2;
+
+  const s_t t = 0.25;
+  Eigen::VectorXs mid = resampler.interpolate(from, to, t);
+
+  for (int dof : resampler.getRotationDofs())
+  {
+    Eigen::Quaternion<s_t> q0(math::expMapRot(from.segment<3>(dof)));
+    Eigen::Quaternion<s_t> q1(math::expMapRot(to.segment<3>(dof)));
+    Eigen::Matrix3s expected = q0.slerp(t, q1).toRotationMatrix();
+    EXPECT_TRUE(math::expMapRot(mid.segment<3>(dof)).isApprox(expected, 1e-9));
+  }
+  // Translation and revolute dofs are linear
+  EXPECT_TRUE(mid.segment<3>(3).isApprox(Eigen::Vector3s(1.5, 2, 2.5)));
+  EXPECT_NEAR(-0.25, mid(9), 1e-12);
+}
+
+//==============================================================================
+TEST(PoseResampler, RESAMPLE_TRIAL)
+{
+  SkeletonPtr skel = createSkeleton();
+  Eigen::VectorXs originalPositions = Eigen::VectorXs::Random(skel->getNumDofs());
+  skel->setPositions(originalPositions);
+  PoseResampler resampler(skel);
+
+  const int numFrames = 500;
+  Eigen::MatrixXs poses(skel->getNumDofs(), numFrames);
+  for (int i = 0; i < numFrames; i++)
+  {
+    const s_t t = i * 0.01;
+    poses.col(i) << 0.5 * sin(t), 0.3 * cos(t), 0.2 * t, t, 2 * t, 3 * t,
+        0.4 * sin(2 * t), 0.1, 0.2 * cos(t), sin(t);
+  }
+
+  // Resampling at the original rate gives back the original poses
+  Eigen::MatrixXs same = resampler.resampleUniform(poses, 0.01, 0.01);
+  ASSERT_EQ(poses.cols(), same.cols());
+  EXPECT_TRUE(same.isApprox(poses, 1e-12));
+
+  // Upsampling to 1000Hz, in parallel and serially, gives the same answer
+  Eigen::MatrixXs fine = resampler.resampleUniform(poses, 0.01, 0.001);
+  Eigen::MatrixXs fineSerial = resampler.resampleUniform(poses, 0.01, 0.001, 1);
+  EXPECT_EQ(4991, fine.cols());
+  EXPECT_EQ(fine, fineSerial);
+  for (int i = 0; i < numFrames; i++)
+  {
+    EXPECT_TRUE(fine.col(i * 10).isApprox(poses.col(i), 1e-9));
+  }
+  // Linear dofs between samples are interpolated linearly
+  EXPECT_NEAR(
+      0.7 * poses(9, 3) + 0.3 * poses(9, 4), fine(9, 33), 1e-12);
+
+  // Times past the ends clamp to the end poses
+  std::vector<double> times;
+  for (int i = 0; i < numFrames; i++)
+    times.push_back(i * 0.01);
+  Eigen::MatrixXs clamped = resampler.resample(poses, times, {-1.0, 100.0});
+  EXPECT_EQ(poses.col(0), clamped.col(0));
+  EXPECT_EQ(poses.col(numFrames - 1), clamped.col(1));
+
+  // None of this touches the Skeleton
+  EXPECT_EQ(originalPositions, skel->getPositions());
+}
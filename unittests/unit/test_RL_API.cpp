@@ -187,6 +187,39 @@ TEST(RL_API, TEST_CUSTOM_ACTION_JAC)
   EXPECT_TRUE(equals(actionJac, actionJacFd, 1e-7));
 }
 
+//==============================================================================
+TEST(RL_API, TEST_JACS_INTO_BUFFERS)
+{
+  std::shared_ptr<simulation::World> world = simulation::World::create();
+  std::shared_ptr<dynamics::Skeleton> skel = UniversalLoader::loadSkeleton(
+      world.get(), "dart://sample/sdf/atlas/atlas_v3_no_head.sdf");
+  std::vector<int> newActionSpace;
+  newActionSpace.push_back(3);
+  newActionSpace.push_back(7);
+  world->setActionSpace(newActionSpace);
+  int dofs = world->getNumDofs();
+
+  // Buffers full of garbage, to check every entry gets written
+  Eigen::MatrixXs stateJac
+      = Eigen::MatrixXs::Constant(2 * dofs, 2 * dofs, 123.0);
+  world->getStateJacobian(stateJac);
+  EXPECT_EQ(world->getStateJacobian(), stateJac);
+
+  World::StateJacobianBlocks blocks = world->getStateJacobianBlocks();
+  EXPECT_EQ(stateJac.block(0, 0, dofs, dofs), blocks.posPos);
+  EXPECT_EQ(stateJac.block(dofs, 0, dofs, dofs), blocks.posVel);
+  EXPECT_EQ(stateJac.block(0, dofs, dofs, dofs), blocks.velPos);
+  EXPECT_EQ(stateJac.block(dofs, dofs, dofs, dofs), blocks.velVel);
+
+  Eigen::MatrixXs actionJac = Eigen::MatrixXs::Constant(2 * dofs, 2, 123.0);
+  world->getActionJacobian(actionJac);
+  EXPECT_EQ(world->getActionJacobian(), actionJac);
+
+  Eigen::MatrixXs actionVelJac = Eigen::MatrixXs::Constant(dofs, 2, 123.0);
+  world->getActionVelJacobian(actionVelJac);
+  EXPECT_EQ(actionJac.bottomRows(dofs), actionVelJac);
+}
+
 //==============================================================================
 TEST(RL_API, TEST_ADD_CUSTOM_ACTION)
 {
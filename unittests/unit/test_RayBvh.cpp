@@ -0,0 +1,109 @@
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/math/RayBvh.hpp"
+#include "dart/math/TriangleBvh.hpp"
+
+using namespace dart;
+
+//==============================================================================
+TEST(RayBvh, VISITS_EVERY_HIT_BOX)
+{
+  srand(42);
+  std::vector<Eigen::Vector3s> mins;
+  std::vector<Eigen::Vector3s> maxs;
+  for (int i = 0; i < 500; i++)
+  {
+    Eigen::Vector3s center = Eigen::Vector3s::Random() * 5;
+    Eigen::Vector3s half = Eigen::Vector3s::Random().cwiseAbs() * 0.3;
+    mins.push_back(center - half);
+    maxs.push_back(center + half);
+  }
+  math::RayBvh bvh(mins, maxs);
+  EXPECT_EQ(mins.size(), bvh.getNumBoxes());
+
+  for (int trial = 0; trial < 200; trial++)
+  {
+    Eigen::Vector3s origin = Eigen::Vector3s::Random() * 6;
+    Eigen::Vector3s dir = Eigen::Vector3s::Random() * 4;
+    // Axis aligned rays exercise the infinite inverse directions
+    if (trial % 10 == 0)
+      dir(trial % 3) = 0;
+    Eigen::Vector3s invDir = dir.cwiseInverse();
+
+    std::vector<bool> visited(mins.size(), false);
+    bvh.raycast(origin, dir, 1.0, [&](int i, s_t maxT) {
+      visited[i] = true;
+      return maxT;
+    });
+    for (int i = 0; i < mins.size(); i++)
+    {
+      s_t tEnter;
+      bool hit = math::RayBvh::intersectBox(
+          origin, invDir, mins[i], maxs[i], 1.0, tEnter);
+      if (hit)
+      {
+        EXPECT_TRUE(visited[i]);
+      }
+    }
+  }
+}
+
+//==============================================================================
+TEST(TriangleBvh, MATCHES_BRUTE_FORCE)
+{
+  srand(42);
+  std::vector<Eigen::Vector3s> vertices;
+  std::vector<Eigen::Vector3i> triangles;
+  for (int i = 0; i < 300; i++)
+  {
+    Eigen::Vector3s center = Eigen::Vector3s::Random() * 3;
+    int offset = vertices.size();
+    for (int j = 0; j < 3; j++)
+    {
+      vertices.push_back(center + Eigen::Vector3s::Random() * 0.5);
+    }
+    triangles.emplace_back(offset, offset + 1, offset + 2);
+  }
+  math::TriangleBvh bvh(vertices, triangles);
+  EXPECT_EQ(triangles.size(), bvh.getNumTriangles());
+
+  for (int trial = 0; trial < 500; trial++)
+  {
+    Eigen::Vector3s origin = Eigen::Vector3s::Random() * 4;
+    Eigen::Vector3s dir = Eigen::Vector3s::Random() * 8;
+
+    // Intersect the supporting plane of each triangle, and keep the hit if
+    // its barycentric coordinates are all non-negative
+    s_t bruteForce = std::numeric_limits<s_t>::infinity();
+    for (const Eigen::Vector3i& tri : triangles)
+    {
+      const Eigen::Vector3s& a = vertices[tri(0)];
+      const Eigen::Vector3s& b = vertices[tri(1)];
+      const Eigen::Vector3s& c = vertices[tri(2)];
+      Eigen::Vector3s n = (b - a).cross(c - a);
+      s_t t = n.dot(a - origin) / n.dot(dir);
+      if (!(t >= 0 && t <= 1))
+        continue;
+      Eigen::Vector3s p = origin + t * dir;
+      if (n.dot((b - a).cross(p - a)) >= 0 && n.dot((c - b).cross(p - b)) >= 0
+          && n.dot((a - c).cross(p - c)) >= 0)
+      {
+        bruteForce = std::min(bruteForce, t);
+      }
+    }
+
+    s_t t;
+    Eigen::Vector3s normal;
+    bool hit = bvh.raycast(origin, dir, 1.0, t, normal);
+    EXPECT_EQ(bruteForce < std::numeric_limits<s_t>::infinity(), hit);
+    if (hit)
+    {
+      EXPECT_NEAR(bruteForce, t, 1e-9);
+      EXPECT_NEAR(1.0, normal.norm(), 1e-9);
+      EXPECT_LE(normal.dot(dir), 0);
+    }
+  }
+}
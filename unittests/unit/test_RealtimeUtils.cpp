@@ -30,6 +30,7 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -40,8 +41,11 @@
 #include "dart/realtime/ControlLog.hpp"
 #include "dart/realtime/ObservationLog.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
+#include "dart/realtime/SharedMemoryPlanRing.hpp"
+#include "dart/realtime/Ticker.hpp"
 #include "dart/realtime/VectorLog.hpp"
 #include "dart/simulation/World.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
 
 #include "TestHelpers.hpp"
 #include "stdio.h"
@@ -124,6 +128,102 @@ TEST(REALTIME, VECTOR_LOG_AFTER)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, VECTOR_LOG_RECENT_VALUES)
+{
+  int dim = 2;
+  VectorLog log = VectorLog(dim);
+  for (int i = 0; i < 10; i++)
+  {
+    log.record(i * 10L, Eigen::VectorXs::Ones(dim) * i);
+  }
+
+  Eigen::MatrixXs expected = Eigen::MatrixXs::Zero(dim, 3);
+  for (int i = 0; i < 3; i++)
+  {
+    expected.col(i) = Eigen::VectorXs::Ones(dim) * (i + 4);
+  }
+  EXPECT_TRUE(equals(expected, log.getRecentValuesBefore(70L, 3)));
+  EXPECT_TRUE(equals(expected, log.getRecentValuesBefore(61L, 3)));
+  Eigen::MatrixXs view = log.getRecentValuesBeforeView(70L, 3);
+  EXPECT_TRUE(equals(expected, view));
+
+  // Without enough history, the copy gets padded with zeros on the left
+  Eigen::MatrixXs padded = Eigen::MatrixXs::Zero(dim, 3);
+  padded.col(2) = Eigen::VectorXs::Ones(dim);
+  EXPECT_TRUE(equals(padded, log.getRecentValuesBefore(15L, 3)));
+  EXPECT_EQ(log.getRecentValuesBeforeView(15L, 3).cols(), 2);
+  EXPECT_EQ(log.availableStepsBefore(15L), 2);
+  EXPECT_EQ(log.availableStepsBefore(95L), 10);
+  EXPECT_EQ(log.availableStepsBefore(-5L), -1);
+
+  log.discardBefore(40L);
+  EXPECT_EQ(log.availableStepsBefore(1000L), 6);
+  EXPECT_TRUE(equals(expected, log.getRecentValuesBefore(70L, 3)));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, VECTOR_LOG_CAPACITY)
+{
+  int dim = 2;
+  int capacity = 4;
+  VectorLog log = VectorLog(dim, capacity);
+  // Irregular timestamps, that wrap around the ring a few times
+  long times[] = {0L, 3L, 4L, 10L, 11L, 20L, 21L, 22L, 40L, 41L};
+  for (int i = 0; i < 10; i++)
+  {
+    log.record(times[i], Eigen::VectorXs::Ones(dim) * i);
+
+    int expectedSteps = std::min(i + 1, capacity);
+    EXPECT_EQ(log.availableStepsBefore(times[i] + 1), expectedSteps);
+    Eigen::MatrixXs expected = Eigen::MatrixXs::Zero(dim, expectedSteps);
+    for (int j = 0; j < expectedSteps; j++)
+    {
+      expected.col(j)
+          = Eigen::VectorXs::Ones(dim) * (i + 1 - expectedSteps + j);
+    }
+    Eigen::MatrixXs view
+        = log.getRecentValuesBeforeView(times[i] + 1, capacity);
+    EXPECT_TRUE(equals(expected, view));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, OBSERVATION_LOG_CLOSEST_BEFORE)
+{
+  ObservationLog log = ObservationLog(
+      0L,
+      Eigen::VectorXs::Zero(1),
+      Eigen::VectorXs::Zero(1),
+      Eigen::VectorXs::Ones(1));
+  for (int i = 1; i < 10; i++)
+  {
+    log.observe(
+        i * 7L,
+        Eigen::VectorXs::Ones(1) * i,
+        Eigen::VectorXs::Ones(1) * -i,
+        Eigen::VectorXs::Ones(1));
+  }
+
+  Eigen::VectorXs pos = Eigen::VectorXs::Zero(1);
+  Eigen::VectorXs vel = Eigen::VectorXs::Zero(1);
+  EXPECT_EQ(log.getClosestObservationBefore(36L, pos, vel), 35L);
+  EXPECT_EQ(pos(0), 5);
+  EXPECT_EQ(vel(0), -5);
+  Observation obs = log.getClosestObservationBefore(35L);
+  EXPECT_EQ(obs.time, 35L);
+  EXPECT_EQ(obs.pos(0), 5);
+
+  // Discarding everything still keeps the newest observation around
+  log.discardBefore(1000L);
+  obs = log.getClosestObservationBefore(1000L);
+  EXPECT_EQ(obs.time, 63L);
+  EXPECT_EQ(obs.pos(0), 9);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CONTROL_LOG)
 {
@@ -521,4 +621,159 @@ TEST(REALTIME, CONTROL_BUFFER_ESTIMATE)
   EXPECT_TRUE(equals(truePos, world->getPositions()));
   EXPECT_TRUE(equals(trueVel, world->getVelocities()));
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, CONTROL_BUFFER_ESTIMATE_CACHED)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  world->setPenetrationCorrectionEnabled(false);
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<PrismaticJoint*, BodyNode*> boxJointPair
+      = box->createJointAndBodyNodePair<PrismaticJoint>();
+  BodyNode* boxBody = boxJointPair.second;
+  std::shared_ptr<BoxShape> shape(
+      new BoxShape(Eigen::Vector3s(0.05, 0.25, 0.05)));
+  boxBody->createShapeNodeWith<VisualAspect, CollisionAspect>(shape);
+  world->addSkeleton(box);
+
+  int forceDim = world->getNumDofs();
+  int steps = 100;
+  int dt = static_cast<int>(world->getTimeStep() * 1000);
+  RealTimeControlBuffer buffer = RealTimeControlBuffer(forceDim, steps, dt);
+  buffer.setEnableStateCache(true);
+  ObservationLog log = ObservationLog(
+      0L, world->getPositions(), world->getVelocities(), world->getMasses());
+
+  Eigen::MatrixXs plan = Eigen::MatrixXs::Zero(forceDim, steps);
+  for (int i = 0; i < steps; i++)
+  {
+    plan(0, i) = sin(i * 0.1);
+  }
+  buffer.setControlForcePlan(0L, 0L, plan);
+
+  for (int i = 0; i < steps; i++)
+  {
+    world->setControlForces(buffer.getPlannedForce(i * dt));
+    world->step();
+  }
+  Eigen::VectorXs truePos = world->getPositions();
+  Eigen::VectorXs trueVel = world->getVelocities();
+
+  // The first call simulates from the observation and fills the cache, and the
+  // later calls start from the cached state. They should all agree.
+  for (int i = 0; i < 3; i++)
+  {
+    world->setPositions(Eigen::VectorXs::Random(1));
+    world->setVelocities(Eigen::VectorXs::Random(1));
+    buffer.estimateWorldStateAt(world, &log, steps * dt);
+    EXPECT_TRUE(equals(truePos, world->getPositions()));
+    EXPECT_TRUE(equals(trueVel, world->getVelocities()));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, SHARED_MEMORY_PLAN_RING)
+{
+  int dofs = 3;
+  int steps = 20;
+  int massDim = 2;
+  SharedMemoryPlanRing ring(dofs, steps, massDim, 4);
+
+  Eigen::MatrixXs pos = Eigen::MatrixXs::Zero(dofs, steps);
+  Eigen::MatrixXs vel = Eigen::MatrixXs::Zero(dofs, steps);
+  Eigen::MatrixXs force = Eigen::MatrixXs::Zero(dofs, steps);
+  Eigen::VectorXs mass = Eigen::VectorXs::Zero(massDim);
+  unsigned long lastSeen = 0;
+  long startTime = 0;
+  long duration = 0;
+  EXPECT_FALSE(ring.readLatest(
+      lastSeen, startTime, duration, pos, vel, force, mass));
+
+  // Publish more plans than there are slots, and make sure we only ever see
+  // the newest one
+  std::vector<std::unique_ptr<trajectory::TrajectoryRolloutReal>> plans;
+  for (int i = 0; i < 6; i++)
+  {
+    std::unordered_map<std::string, Eigen::MatrixXs> planPos;
+    std::unordered_map<std::string, Eigen::MatrixXs> planVel;
+    std::unordered_map<std::string, Eigen::MatrixXs> planForce;
+    planPos["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+    planVel["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+    planForce["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+    plans.emplace_back(new trajectory::TrajectoryRolloutReal(
+        planPos,
+        planVel,
+        planForce,
+        Eigen::VectorXs::Random(massDim),
+        std::unordered_map<std::string, Eigen::MatrixXs>()));
+    ring.publish(100L * i, i, plans.back().get());
+  }
+  EXPECT_EQ(ring.getNumPublished(), 6);
+
+  EXPECT_TRUE(ring.readLatest(
+      lastSeen, startTime, duration, pos, vel, force, mass));
+  EXPECT_EQ(lastSeen, 6);
+  EXPECT_EQ(startTime, 500L);
+  EXPECT_EQ(duration, 5L);
+  Eigen::MatrixXs expectedPos = plans[5]->getPosesConst();
+  Eigen::MatrixXs expectedVel = plans[5]->getVelsConst();
+  Eigen::MatrixXs expectedForce = plans[5]->getControlForcesConst();
+  Eigen::VectorXs expectedMass = plans[5]->getMassesConst();
+  EXPECT_TRUE(equals(pos, expectedPos, 0.0));
+  EXPECT_TRUE(equals(vel, expectedVel, 0.0));
+  EXPECT_TRUE(equals(force, expectedForce, 0.0));
+  EXPECT_TRUE(equals(mass, expectedMass, 0.0));
+
+  // Nothing new has been published since
+  EXPECT_FALSE(ring.readLatest(
+      lastSeen, startTime, duration, pos, vel, force, mass));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, TICKER_DOESNT_DRIFT)
+{
+  // Each tick takes a good fraction of the period, which would add up to a
+  // lot of drift if we slept a whole period after every tick
+  Ticker ticker(0.002);
+  std::atomic<int> listenerCalls(0);
+  ticker.registerTickListener([&](long /* now */) {
+    listenerCalls++;
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  });
+
+  auto startedAt = std::chrono::steady_clock::now();
+  ticker.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  ticker.stop();
+  s_t elapsedMillis = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - startedAt)
+                          .count()
+                      / 1000.0;
+
+  long ticks = ticker.getNumTicks();
+  EXPECT_EQ(ticks, listenerCalls.load());
+  // With drift, we'd only get about 80 ticks in 200ms
+  EXPECT_GE(ticks + ticker.getNumSkippedTicks(), elapsedMillis / 2 - 5);
+  EXPECT_LE(ticks, elapsedMillis / 2 + 2);
+
+  // Every tick lands in exactly one histogram bucket
+  std::vector<long> histogram = ticker.getJitterHistogram();
+  EXPECT_EQ((int)histogram.size(), Ticker::JITTER_HISTOGRAM_BUCKETS);
+  long total = 0;
+  for (long count : histogram)
+  {
+    total += count;
+  }
+  EXPECT_EQ(total, ticks);
+  EXPECT_GE(ticker.getMaxJitterNanos(), ticker.getMeanJitterNanos());
+
+  ticker.resetStats();
+  EXPECT_EQ(ticker.getNumTicks(), 0);
+  EXPECT_EQ(ticker.getMaxJitterNanos(), 0);
+}
+#endif
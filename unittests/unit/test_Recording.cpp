@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "dart/simulation/Recording.hpp"
+
+using dart::simulation::Recording;
+
+namespace {
+
+/// This makes a frame for skeletons with 2 and 3 DOFs, with `frame % 3`
+/// contacts, where every entry is derived from the frame index
+Eigen::VectorXs makeState(int frame)
+{
+  int numContacts = frame % 3;
+  Eigen::VectorXs state(5 + 6 * numContacts);
+  for (int i = 0; i < state.size(); i++)
+    state(i) = frame * 100 + i;
+  return state;
+}
+
+void expectFrames(const Recording& recording, int numFrames)
+{
+  ASSERT_EQ(numFrames, recording.getNumFrames());
+  for (int frame = 0; frame < numFrames; frame++)
+  {
+    Eigen::VectorXs state = makeState(frame);
+    EXPECT_EQ(state.segment(0, 2), recording.getConfig(frame, 0));
+    EXPECT_EQ(state.segment(2, 3), recording.getConfig(frame, 1));
+    EXPECT_EQ(state(3), recording.getGenCoord(frame, 1, 1));
+    ASSERT_EQ(frame % 3, recording.getNumContacts(frame));
+    for (int c = 0; c < frame % 3; c++)
+    {
+      EXPECT_EQ(
+          state.segment<3>(5 + 6 * c), recording.getContactPoint(frame, c));
+      EXPECT_EQ(
+          state.segment<3>(8 + 6 * c), recording.getContactForce(frame, c));
+    }
+  }
+}
+
+} // anonymous namespace
+
+TEST(Recording, addState_SpansChunks)
+{
+  Recording recording(std::vector<int>{2, 3});
+  const int numFrames = Recording::FRAMES_PER_CHUNK * 2 + 10;
+  for (int frame = 0; frame < numFrames; frame++)
+    recording.addState(makeState(frame));
+  expectFrames(recording, numFrames);
+  EXPECT_EQ(numFrames, recording.getNumFramesInMemory());
+
+  recording.clear();
+  EXPECT_EQ(0, recording.getNumFrames());
+}
+
+TEST(Recording, saveAndLoad_RoundTrips)
+{
+  const std::string path = "/tmp/test_Recording_save.bin";
+  Recording recording(std::vector<int>{2, 3});
+  const int numFrames = Recording::FRAMES_PER_CHUNK + 7;
+  for (int frame = 0; frame < numFrames; frame++)
+    recording.addState(makeState(frame));
+  ASSERT_TRUE(recording.save(path));
+
+  std::shared_ptr<Recording> loaded = Recording::load(path);
+  ASSERT_NE(nullptr, loaded);
+  EXPECT_EQ(2, loaded->getNumSkeletons());
+  EXPECT_EQ(3, loaded->getNumDofs(1));
+  expectFrames(*loaded, numFrames);
+  // Everything is read out of the file
+  EXPECT_EQ(0, loaded->getNumFramesInMemory());
+
+  // A loaded recording can keep growing
+  for (int frame = numFrames; frame < numFrames + 5; frame++)
+    loaded->addState(makeState(frame));
+  expectFrames(*loaded, numFrames + 5);
+
+  std::remove(path.c_str());
+}
+
+TEST(Recording, setSpillFile_KeepsOnlyOpenChunkInMemory)
+{
+  const std::string path = "/tmp/test_Recording_spill.bin";
+  Recording recording(std::vector<int>{2, 3});
+  for (int frame = 0; frame < 10; frame++)
+    recording.addState(makeState(frame));
+  ASSERT_TRUE(recording.setSpillFile(path));
+
+  const int numFrames = Recording::FRAMES_PER_CHUNK * 3 + 20;
+  for (int frame = 10; frame < numFrames; frame++)
+    recording.addState(makeState(frame));
+  expectFrames(recording, numFrames);
+  EXPECT_EQ(20, recording.getNumFramesInMemory());
+
+  // The spill file holds every finished chunk, and can be appended to again
+  std::shared_ptr<Recording> loaded = Recording::load(path);
+  ASSERT_NE(nullptr, loaded);
+  expectFrames(*loaded, Recording::FRAMES_PER_CHUNK * 3);
+  ASSERT_TRUE(loaded->setSpillFile(path));
+  for (int frame = Recording::FRAMES_PER_CHUNK * 3; frame < numFrames + 5;
+       frame++)
+    loaded->addState(makeState(frame));
+  expectFrames(*loaded, numFrames + 5);
+
+  EXPECT_FALSE(recording.save(path));
+  std::remove(path.c_str());
+}
@@ -53,4 +53,58 @@ TEST(Scaling, SCALE_BODY_NODES)
 
   server.blockWhileServing();
 }
-#endif
\ No newline at end of file
+#endif
+TEST(Scaling, DEFERRED_SCALES_MATCH_EAGER)
+{
+  std::shared_ptr<dynamics::Skeleton> eager
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+  std::shared_ptr<dynamics::Skeleton> deferred
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+  eager->autogroupSymmetricSuffixes();
+  deferred->autogroupSymmetricSuffixes();
+  deferred->setDeferScaleUpdates(true);
+
+  Eigen::VectorXs pos = Eigen::VectorXs::Random(eager->getNumDofs());
+  eager->setPositions(pos);
+  deferred->setPositions(pos);
+
+  for (int i = 0; i < 10; i++)
+  {
+    Eigen::VectorXs scales
+        = Eigen::VectorXs::Ones(eager->getGroupScaleDim())
+          + Eigen::VectorXs::Random(eager->getGroupScaleDim()) * 0.2;
+    eager->setGroupScales(scales);
+    deferred->setGroupScales(scales);
+
+    // Kinematics doesn't need the deferred updates
+    EXPECT_TRUE(equals(
+        eager->getJointWorldPositions(eager->getJoints()),
+        deferred->getJointWorldPositions(deferred->getJoints()),
+        1e-12));
+  }
+
+  // Dynamics queries catch the shapes and inertia up
+  EXPECT_TRUE(
+      equals(eager->getMassMatrix(), deferred->getMassMatrix(), 1e-9));
+  for (int i = 0; i < eager->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* eagerBody = eager->getBodyNode(i);
+    dynamics::BodyNode* deferredBody = deferred->getBodyNode(i);
+    EXPECT_TRUE(equals(
+        eagerBody->getInertia().getSpatialTensor(),
+        deferredBody->getInertia().getSpatialTensor(),
+        1e-9));
+    EXPECT_EQ(eagerBody->getNumShapeNodes(), deferredBody->getNumShapeNodes());
+    for (int j = 0; j < eagerBody->getNumShapeNodes(); j++)
+    {
+      EXPECT_TRUE(equals(
+          eagerBody->getShapeNode(j)->getOffset(),
+          deferredBody->getShapeNode(j)->getOffset(),
+          1e-9));
+    }
+  }
+}
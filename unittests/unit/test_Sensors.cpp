@@ -1,10 +1,12 @@
 #include <gtest/gtest.h>
 
+#include "dart/biomechanics/BatchScaleQueries.hpp"
 #include "dart/biomechanics/MarkerFitter.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/MeshShape.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/IKSolver.hpp"
@@ -96,6 +98,48 @@ TEST(Sensors, LOWEST_POINT)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(Sensors, LOWEST_POINT_MATCHES_ALL_VERTICES)
+{
+  std::shared_ptr<dynamics::Skeleton> standard
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+
+  srand(42);
+  for (int trial = 0; trial < 5; trial++)
+  {
+    standard->setPositions(standard->getRandomPose());
+    Eigen::Vector3s up = Eigen::Vector3s::Random().normalized();
+
+    // Scan every vertex of every mesh, which is what the hull lets us skip
+    s_t bruteForce = std::numeric_limits<s_t>::infinity();
+    for (int i = 0; i < standard->getNumBodyNodes(); i++)
+    {
+      dynamics::BodyNode* node = standard->getBodyNode(i);
+      for (int j = 0; j < node->getNumShapeNodes(); j++)
+      {
+        dynamics::ShapeNode* shapeNode = node->getShapeNode(j);
+        auto* mesh
+            = dynamic_cast<dynamics::MeshShape*>(shapeNode->getShape().get());
+        if (mesh == nullptr)
+          continue;
+        for (const Eigen::Vector3s& rawVertex : mesh->getVertices())
+        {
+          bruteForce = std::min(
+              bruteForce,
+              up.dot(
+                  shapeNode->getWorldTransform()
+                  * node->getScale().cwiseProduct(rawVertex)));
+        }
+      }
+    }
+
+    EXPECT_NEAR(bruteForce, standard->getLowestPoint(up), 1e-12);
+  }
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(Sensors, MARKERS_WRT_MARKERS)
 {
@@ -173,4 +217,145 @@ TEST(Sensors, MARKERS_WRT_SCALE)
     }
   }
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef ALL_TESTS
+TEST(Sensors, MARKERS_DIST_BATCHED)
+{
+  OpenSimFile file = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  std::shared_ptr<dynamics::Skeleton> standard = file.skeleton;
+
+  srand(30);
+  Eigen::VectorXs bodyScales
+      = Eigen::VectorXs::Ones(standard->getNumBodyNodes() * 3)
+        + 0.1 * Eigen::VectorXs::Random(standard->getNumBodyNodes() * 3);
+  standard->setBodyScales(bodyScales);
+
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  for (auto pair : file.markersMap)
+  {
+    markers.push_back(pair.second);
+  }
+
+  Eigen::VectorXs dists = standard->getDistToClosestVerticesToMarkers(markers);
+  Eigen::MatrixXs wrtMarkers
+      = standard->getGradientOfDistToClosestVerticesToMarkersWrtMarkers(
+          markers);
+  Eigen::MatrixXs wrtScales
+      = standard->getGradientOfDistToClosestVerticesToMarkersWrtBodyScales(
+          markers);
+
+  for (int i = 0; i < markers.size(); i++)
+  {
+    dynamics::BodyNode* node = markers[i].first;
+    const Eigen::Vector3s& marker = markers[i].second;
+
+    // Scan every vertex, which is what the k-d tree lets us skip
+    s_t bruteForce = std::numeric_limits<s_t>::infinity();
+    for (int j = 0; j < node->getNumShapeNodes(); j++)
+    {
+      auto* mesh = dynamic_cast<dynamics::MeshShape*>(
+          node->getShapeNode(j)->getShape().get());
+      if (mesh == nullptr)
+        continue;
+      for (const Eigen::Vector3s& rawVertex : mesh->getVertices())
+      {
+        bruteForce = std::min(
+            bruteForce,
+            (node->getScale().cwiseProduct(rawVertex) - marker).squaredNorm());
+      }
+    }
+    EXPECT_NEAR(bruteForce, dists(i), 1e-12);
+
+    Eigen::Vector3s markerGrad
+        = node->getGradientOfDistToClosestVerticesToMarkerWrtMarker(marker);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(wrtMarkers.block<1, 3>(i, i * 3).transpose()),
+        Eigen::VectorXs(markerGrad),
+        1e-12));
+    Eigen::Vector3s scaleGrad
+        = node->getGradientOfDistToClosestVerticesToMarkerWrtBodyScale(marker);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(
+            wrtScales.block<1, 3>(i, node->getIndexInSkeleton() * 3)
+                .transpose()),
+        Eigen::VectorXs(scaleGrad),
+        1e-12));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(Sensors, BATCH_SCALE_QUERIES_MATCH_SERIAL)
+{
+  OpenSimFile file = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  std::shared_ptr<dynamics::Skeleton> standard = file.skeleton;
+  std::shared_ptr<dynamics::Skeleton> serial = standard->cloneSkeleton();
+  Eigen::VectorXs originalScales = standard->getBodyScales();
+  Eigen::VectorXs originalPos = standard->getPositions();
+
+  srand(30);
+  const int numSamples = 5;
+  const int numScales = standard->getNumBodyNodes() * 3;
+  Eigen::MatrixXs bodyScales
+      = Eigen::MatrixXs::Ones(numSamples, numScales)
+        + 0.1 * Eigen::MatrixXs::Random(numSamples, numScales);
+  Eigen::MatrixXs poses(numSamples, standard->getNumDofs());
+  for (int i = 0; i < numSamples; i++)
+  {
+    poses.row(i) = standard->getRandomPose().transpose();
+  }
+
+  BatchScaleQueries batch(standard);
+  BatchScaleQueryResult heights = batch.getHeights(bodyScales, poses);
+  BatchScaleQueryResult lowest = batch.getLowestPoints(bodyScales, poses);
+
+  dynamics::BodyNode* femur = standard->getBodyNode("femur_r");
+  Eigen::MatrixXs markerOffsets = 0.05 * Eigen::MatrixXs::Random(numSamples, 3);
+  Eigen::MatrixXs femurScales = bodyScales.middleCols(
+      femur->getIndexInSkeleton() * 3, 3);
+  BatchScaleQueryResult markers = batch.getMarkerDistsToNearestVertex(
+      "femur_r", markerOffsets, femurScales);
+
+  for (int i = 0; i < numSamples; i++)
+  {
+    Eigen::VectorXs pose = poses.row(i);
+    serial->setBodyScales(bodyScales.row(i).transpose());
+    EXPECT_NEAR(serial->getHeight(pose), heights.values(i), 1e-12);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(heights.gradWrtBodyScales.row(i).transpose()),
+        serial->getGradientOfHeightWrtBodyScales(pose),
+        1e-12));
+
+    serial->setPositions(pose);
+    EXPECT_NEAR(serial->getLowestPoint(), lowest.values(i), 1e-12);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(lowest.gradWrtBodyScales.row(i).transpose()),
+        serial->getGradientOfLowestPointWrtBodyScales(),
+        1e-12));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(lowest.gradWrtPoses.row(i).transpose()),
+        serial->getGradientOfLowestPointWrtJoints(),
+        1e-12));
+
+    dynamics::BodyNode* serialFemur = serial->getBodyNode("femur_r");
+    Eigen::Vector3s marker = markerOffsets.row(i).transpose();
+    EXPECT_NEAR(
+        serialFemur->getDistToClosestVerticesToMarker(marker),
+        markers.values(i),
+        1e-12);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(markers.gradWrtMarkers.row(i).transpose()),
+        Eigen::VectorXs(
+            serialFemur->getGradientOfDistToClosestVerticesToMarkerWrtMarker(
+                marker)),
+        1e-12));
+  }
+
+  // The skeleton we handed over is left alone
+  EXPECT_TRUE(equals(originalScales, standard->getBodyScales(), 0));
+  EXPECT_TRUE(equals(originalPos, standard->getPositions(), 0));
+}
+#endif
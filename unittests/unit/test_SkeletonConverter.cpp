@@ -581,6 +581,43 @@ TEST(SkeletonConverter, SCALE_EQUALITY_CONSTRAINTS)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(SkeletonConverter, SPARSE_GROUP_SCALE_JACOBIANS)
+{
+  OpenSimFile file = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  std::shared_ptr<dynamics::Skeleton> osim = file.skeleton;
+  osim->autogroupSymmetricSuffixes();
+  osim->setPositions(Eigen::VectorXs::Random(osim->getNumDofs()));
+  osim->setGroupScales(
+      Eigen::VectorXs::Ones(osim->getGroupScaleDim())
+      + Eigen::VectorXs::Random(osim->getGroupScaleDim()) * 0.2);
+
+  std::vector<dynamics::Joint*> joints;
+  for (int i = 0; i < osim->getNumJoints(); i++)
+  {
+    joints.push_back(osim->getJoint(i));
+  }
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  for (auto& pair : file.markersMap)
+  {
+    markers.emplace_back(pair.second.first, pair.second.second);
+  }
+
+  Eigen::MatrixXs jointJac
+      = osim->getJointWorldPositionsJacobianWrtGroupScales(joints);
+  Eigen::MatrixXs jointJacSparse = Eigen::MatrixXs(
+      osim->getJointWorldPositionsJacobianWrtGroupScalesSparse(joints));
+  EXPECT_TRUE(equals(jointJac, jointJacSparse, 1e-12));
+
+  Eigen::MatrixXs markerJac
+      = osim->getMarkerWorldPositionsJacobianWrtGroupScales(markers);
+  Eigen::MatrixXs markerJacSparse = Eigen::MatrixXs(
+      osim->getMarkerWorldPositionsJacobianWrtGroupScalesSparse(markers));
+  EXPECT_TRUE(equals(markerJac, markerJacSparse, 1e-12));
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(SkeletonConverter, IK_JACOBIANS)
 {
@@ -1014,6 +1051,24 @@ TEST(SkeletonConverter, RAJAGOPAL)
 
   Eigen::MatrixXs convertedPoses = converter.convertMotion(poses);
 
+  // Converting in parallel chunks should fit every frame about as well
+  Eigen::MatrixXs parallelPoses = converter.convertMotionParallel(poses, 4);
+  ASSERT_EQ(parallelPoses.rows(), convertedPoses.rows());
+  ASSERT_EQ(parallelPoses.cols(), convertedPoses.cols());
+  Eigen::VectorXs originalOsim = osim->getPositions();
+  Eigen::VectorXs originalAmass = amass->getPositions();
+  for (int i = 0; i < poses.cols(); i++)
+  {
+    amass->setPositions(poses.col(i));
+    osim->setPositions(parallelPoses.col(i));
+    s_t error = (converter.getSourceMarkerWorldPositions()
+                 - converter.getTargetMarkerWorldPositions())
+                    .squaredNorm();
+    EXPECT_LT(error, 0.1);
+  }
+  osim->setPositions(originalOsim);
+  amass->setPositions(originalAmass);
+
   /*
   // Uncomment this for local testing
   std::shared_ptr<server::GUIWebsocketServer> server
@@ -206,4 +206,119 @@ TEST(SkeletonConverter, MARKER_DISTANCE)
     EXPECT_TRUE(equals(axisGroupGrad, axisGroupGrad_fd, 1e-10));
   }
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(SkeletonConverter, KINEMATICS_CONTEXT_INVALIDATION)
+{
+  std::shared_ptr<dynamics::Skeleton> osim
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  markers.push_back(
+      std::make_pair(osim->getBodyNode("radius_l"), Eigen::Vector3s::Random()));
+  markers.push_back(
+      std::make_pair(osim->getBodyNode("tibia_r"), Eigen::Vector3s::Random()));
+
+  // Warm up the shared context, and then move the skeleton in every way that
+  // should invalidate it. Each time, a fresh clone (with a cold cache) has to
+  // agree with us.
+  osim->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+  for (int i = 0; i < 3; i++)
+  {
+    if (i == 0)
+    {
+      osim->setPositions(Eigen::VectorXs::Random(osim->getNumDofs()));
+    }
+    else if (i == 1)
+    {
+      osim->getBodyNode("humerus_l")->setScale(Eigen::Vector3s(1.1, 0.9, 1.2));
+    }
+    else
+    {
+      osim->setPosition(0, osim->getPosition(0) + 0.3);
+    }
+
+    Eigen::MatrixXs jac
+        = osim->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+
+    std::shared_ptr<dynamics::Skeleton> clone = osim->cloneSkeleton();
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> cloneMarkers;
+    for (auto& pair : markers)
+    {
+      cloneMarkers.push_back(std::make_pair(
+          clone->getBodyNode(pair.first->getName()), pair.second));
+    }
+    Eigen::MatrixXs cloneJac
+        = clone->getMarkerWorldPositionsJacobianWrtJointPositions(
+            cloneMarkers);
+
+    EXPECT_TRUE(equals(jac, cloneJac, 1e-12));
+    EXPECT_EQ(
+        osim->getJointIndex(markers[0].first->getParentJoint()),
+        (int)markers[0].first->getIndexInSkeleton());
+    EXPECT_EQ(osim->getJointIndex(clone->getJoint(0)), -1);
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(SkeletonConverter, BATCH_MATCHES_SINGLE_POSE)
+{
+  std::shared_ptr<dynamics::Skeleton> osim
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  markers.push_back(
+      std::make_pair(osim->getBodyNode("radius_l"), Eigen::Vector3s::Random()));
+  markers.push_back(
+      std::make_pair(osim->getBodyNode("tibia_r"), Eigen::Vector3s::Random()));
+  std::vector<dynamics::Joint*> joints;
+  joints.push_back(osim->getJoint("walker_knee_r"));
+  joints.push_back(osim->getJoint("elbow_l"));
+
+  const int numFrames = 9;
+  Eigen::MatrixXs poses
+      = Eigen::MatrixXs::Random(osim->getNumDofs(), numFrames);
+  Eigen::VectorXs originalPos = osim->getPositions();
+
+  Eigen::MatrixXs markerBatch
+      = osim->getMarkerWorldPositionsBatch(markers, poses);
+  std::vector<Eigen::MatrixXs> markerJacBatch
+      = osim->getMarkerWorldPositionsJacobianWrtJointPositionsBatch(
+          markers, poses);
+  Eigen::MatrixXs jointBatch = osim->getJointWorldPositionsBatch(joints, poses);
+  std::vector<Eigen::MatrixXs> jointJacBatch
+      = osim->getJointWorldPositionsJacobianWrtJointPositionsBatch(
+          joints, poses);
+
+  // The batch calls shouldn't move the skeleton
+  EXPECT_TRUE(equals(osim->getPositions(), originalPos, 0));
+  EXPECT_EQ(markerJacBatch.size(), numFrames);
+  EXPECT_EQ(jointJacBatch.size(), numFrames);
+
+  for (int t = 0; t < numFrames; t++)
+  {
+    osim->setPositions(poses.col(t));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(markerBatch.col(t)),
+        osim->getMarkerWorldPositions(markers),
+        1e-12));
+    EXPECT_TRUE(equals(
+        markerJacBatch[t],
+        osim->getMarkerWorldPositionsJacobianWrtJointPositions(markers),
+        1e-12));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(jointBatch.col(t)),
+        osim->getJointWorldPositions(joints),
+        1e-12));
+    EXPECT_TRUE(equals(
+        jointJacBatch[t],
+        osim->getJointWorldPositionsJacobianWrtJointPositions(joints),
+        1e-12));
+  }
+}
+#endif
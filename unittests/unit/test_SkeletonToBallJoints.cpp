@@ -93,4 +93,30 @@ TEST(SkeletonConverter, CONVERT_OSIM)
       }
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(SkeletonConverter, CONVERT_OSIM_BATCH)
+{
+  std::shared_ptr<dynamics::Skeleton> osim
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Random(osim->getNumDofs(), 50);
+  Eigen::MatrixXs ballSpace = osim->convertPositionsToBallSpaceBatch(poses);
+  Eigen::MatrixXs recovered
+      = osim->convertPositionsFromBallSpaceBatch(ballSpace);
+  for (int t = 0; t < poses.cols(); t++)
+  {
+    Eigen::VectorXs expectedBallSpace
+        = osim->convertPositionsToBallSpace(poses.col(t));
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(ballSpace.col(t)), expectedBallSpace, 1e-12));
+    Eigen::VectorXs expectedRecovered
+        = osim->convertPositionsFromBallSpace(expectedBallSpace);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(recovered.col(t)), expectedRecovered, 1e-12));
+    EXPECT_TRUE(
+        equals(Eigen::VectorXs(poses.col(t)), expectedRecovered, 1e-12));
+  }
+}
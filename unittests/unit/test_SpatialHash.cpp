@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/math/SpatialHash.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+
+TEST(SpatialHash, FIND_NEIGHBORS_WITHIN_RADIUS)
+{
+  srand(42);
+  std::vector<Eigen::Vector3s> points;
+  math::SpatialHash hash(0.1);
+  for (int i = 0; i < 500; i++)
+  {
+    points.push_back(Eigen::Vector3s::Random());
+    hash.insert(points[i], i);
+  }
+  EXPECT_EQ(hash.size(), 500);
+
+  std::vector<int> neighbors;
+  for (s_t radius : {0.0, 0.05, 0.1, 0.25, 1.0, 10.0})
+  {
+    for (int q = 0; q < 50; q++)
+    {
+      Eigen::Vector3s query = Eigen::Vector3s::Random();
+      hash.findNeighborsWithin(query, radius, neighbors);
+      std::sort(neighbors.begin(), neighbors.end());
+      // Every point within the radius must be found, exactly once
+      EXPECT_TRUE(
+          std::adjacent_find(neighbors.begin(), neighbors.end())
+          == neighbors.end());
+      for (int i = 0; i < points.size(); i++)
+      {
+        if ((points[i] - query).norm() <= radius)
+        {
+          EXPECT_TRUE(
+              std::binary_search(neighbors.begin(), neighbors.end(), i));
+        }
+      }
+    }
+  }
+}
+
+TEST(SpatialHash, IGNORES_NON_FINITE)
+{
+  math::SpatialHash hash(1.0);
+  hash.insert(Eigen::Vector3s::Constant(std::nan("")), 0);
+  hash.insert(Eigen::Vector3s::Zero(), 1);
+  EXPECT_EQ(hash.size(), 1);
+
+  std::vector<int> neighbors;
+  hash.findNeighborsWithin(
+      Eigen::Vector3s::Zero(),
+      std::numeric_limits<s_t>::infinity(),
+      neighbors);
+  EXPECT_EQ(neighbors.size(), 1);
+  hash.findNeighbors(Eigen::Vector3s::Constant(std::nan("")), neighbors);
+  EXPECT_EQ(neighbors.size(), 0);
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/math/SphereTree.hpp"
+
+using namespace dart;
+
+namespace {
+
+/// This returns true if the sphere overlaps the box [min, max]
+bool overlaps(
+    const Eigen::Vector3s& center,
+    s_t radius,
+    const Eigen::Vector3s& min,
+    const Eigen::Vector3s& max)
+{
+  return (center - center.cwiseMax(min).cwiseMin(max)).squaredNorm()
+         <= radius * radius;
+}
+
+} // namespace
+
+//==============================================================================
+TEST(SphereTree, MATCHES_BRUTE_FORCE)
+{
+  srand(42);
+  std::vector<Eigen::Vector3s> centers;
+  std::vector<s_t> radii;
+  for (int i = 0; i < 2000; i++)
+  {
+    centers.push_back(Eigen::Vector3s::Random());
+    radii.push_back(0.01 + 0.05 * (rand() / (s_t)RAND_MAX));
+  }
+  math::SphereTree tree(centers, radii);
+  ASSERT_EQ(centers.size(), tree.getNumSpheres());
+
+  for (int trial = 0; trial < 200; trial++)
+  {
+    // Refitting to a new scale has to give the same answers as scaling by hand
+    Eigen::Vector3s scale = Eigen::Vector3s::Ones();
+    if (trial % 2 == 1)
+      scale = Eigen::Vector3s::Random().cwiseAbs()
+              + Eigen::Vector3s::Constant(0.2);
+    tree.refit(scale);
+    const s_t radiusScale = scale.maxCoeff();
+
+    Eigen::Vector3s corner = Eigen::Vector3s::Random() * 1.5;
+    Eigen::Vector3s extent = Eigen::Vector3s::Random().cwiseAbs() * 0.3;
+    Eigen::Vector3s min = corner;
+    Eigen::Vector3s max = corner + extent;
+
+    std::vector<int> expected;
+    for (int i = 0; i < centers.size(); i++)
+    {
+      if (overlaps(
+              scale.cwiseProduct(centers[i]), radii[i] * radiusScale, min, max))
+        expected.push_back(i);
+    }
+
+    std::vector<int> found;
+    tree.findOverlapping(min, max, found);
+    std::vector<int> foundOriginal;
+    for (int i : found)
+    {
+      foundOriginal.push_back(tree.getOriginalIndex(i));
+      EXPECT_TRUE(tree.getCenter(i).isApprox(
+          scale.cwiseProduct(centers[tree.getOriginalIndex(i)])));
+    }
+    std::sort(foundOriginal.begin(), foundOriginal.end());
+    EXPECT_EQ(expected, foundOriginal);
+  }
+}
+
+//==============================================================================
+TEST(SphereTree, EMPTY_AND_TINY)
+{
+  math::SphereTree empty(std::vector<Eigen::Vector3s>{}, 0.1);
+  std::vector<int> found;
+  empty.findOverlapping(
+      Eigen::Vector3s::Constant(-1), Eigen::Vector3s::Constant(1), found);
+  EXPECT_TRUE(found.empty());
+
+  std::vector<Eigen::Vector3s> centers;
+  centers.push_back(Eigen::Vector3s(1, 0, 0));
+  math::SphereTree tiny(centers, 0.1);
+  tiny.findOverlapping(
+      Eigen::Vector3s(1.05, -1, -1), Eigen::Vector3s(2, 1, 1), found);
+  EXPECT_EQ(1u, found.size());
+  found.clear();
+  // Scaling the x axis by 10 pushes the sphere out to (10, 0, 0), and makes
+  // it 10 times as big
+  tiny.refit(Eigen::Vector3s(10, 1, 1));
+  tiny.findOverlapping(
+      Eigen::Vector3s(1.05, -1, -1), Eigen::Vector3s(2, 1, 1), found);
+  EXPECT_TRUE(found.empty());
+  tiny.findOverlapping(
+      Eigen::Vector3s(10.9, -1, -1), Eigen::Vector3s(11, 1, 1), found);
+  EXPECT_EQ(1u, found.size());
+}
@@ -0,0 +1,211 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/biomechanics/SubjectOnDisk.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+namespace {
+
+const std::string OSIM_PATH
+    = "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim";
+
+SubjectOnDiskTrial makeTrial(
+    const std::string& name, int numDofs, int numFrames, int numPlates)
+{
+  SubjectOnDiskTrial trial;
+  trial.name = name;
+  trial.timestep = 0.01;
+  trial.poses = Eigen::MatrixXs::Random(numDofs, numFrames);
+  trial.velocities = Eigen::MatrixXs::Random(numDofs, numFrames);
+  trial.accelerations = Eigen::MatrixXs::Random(numDofs, numFrames);
+  for (int p = 0; p < numPlates; p++)
+  {
+    ForcePlate plate;
+    for (int t = 0; t < numFrames; t++)
+    {
+      plate.forces.push_back(Eigen::Vector3s::Random());
+      plate.centersOfPressure.push_back(Eigen::Vector3s::Random());
+      plate.moments.push_back(Eigen::Vector3s::Random());
+    }
+    trial.forcePlates.push_back(plate);
+  }
+  trial.markerRMSErrors = Eigen::VectorXs::Random(numFrames);
+  return trial;
+}
+
+void expectWindow(
+    const SubjectOnDiskTrial& trial,
+    const SubjectOnDiskFrames& frames,
+    int start,
+    int numFrames)
+{
+  ASSERT_EQ(frames.startFrame, start);
+  ASSERT_EQ(frames.poses.cols(), numFrames);
+  EXPECT_TRUE(equals(
+      frames.poses,
+      trial.poses.block(0, start, trial.poses.rows(), numFrames),
+      0));
+  EXPECT_TRUE(equals(
+      frames.velocities,
+      trial.velocities.block(0, start, trial.poses.rows(), numFrames),
+      0));
+  EXPECT_TRUE(equals(
+      frames.accelerations,
+      trial.accelerations.block(0, start, trial.poses.rows(), numFrames),
+      0));
+  EXPECT_TRUE(equals(
+      frames.markerRMSErrors,
+      trial.markerRMSErrors.segment(start, numFrames),
+      0));
+  ASSERT_EQ(frames.grfForces.rows(), 3 * trial.forcePlates.size());
+  for (int p = 0; p < trial.forcePlates.size(); p++)
+  {
+    for (int t = 0; t < numFrames; t++)
+    {
+      const ForcePlate& plate = trial.forcePlates[p];
+      EXPECT_TRUE(equals(
+          Eigen::Vector3s(frames.grfForces.block<3, 1>(p * 3, t)),
+          plate.forces[start + t],
+          0));
+      EXPECT_TRUE(equals(
+          Eigen::Vector3s(frames.grfCentersOfPressure.block<3, 1>(p * 3, t)),
+          plate.centersOfPressure[start + t],
+          0));
+      EXPECT_TRUE(equals(
+          Eigen::Vector3s(frames.grfMoments.block<3, 1>(p * 3, t)),
+          plate.moments[start + t],
+          0));
+    }
+  }
+}
+
+} // anonymous namespace
+
+//==============================================================================
+TEST(SubjectOnDisk, WRITE_AND_READ_WINDOWS)
+{
+  OpenSimFile osim = OpenSimParser::parseOsim(OSIM_PATH);
+  const int numDofs = osim.skeleton->getNumDofs();
+
+  Eigen::VectorXs bodyScales = osim.skeleton->getBodyScales();
+  bodyScales *= 1.1;
+  std::map<std::string, Eigen::Vector3s> markerOffsets;
+  std::string markerName = osim.markersMap.begin()->first;
+  markerOffsets[markerName] = Eigen::Vector3s(0.01, -0.02, 0.03);
+
+  // The first trial spans a few chunks, and the last chunk is partly full
+  std::vector<SubjectOnDiskTrial> trials;
+  trials.push_back(makeTrial(
+      "walk", numDofs, SubjectOnDisk::FRAMES_PER_CHUNK * 2 + 17, 2));
+  trials.push_back(makeTrial("static", numDofs, 5, 0));
+
+  const std::string path = "/tmp/test_SubjectOnDisk.bin";
+  ASSERT_TRUE(SubjectOnDisk::writeSubject(
+      path, OSIM_PATH, bodyScales, markerOffsets, trials));
+
+  std::shared_ptr<SubjectOnDisk> subject = SubjectOnDisk::load(path);
+  ASSERT_TRUE(subject != nullptr);
+  EXPECT_EQ(subject->getNumDofs(), numDofs);
+  EXPECT_EQ(subject->getDofNames()[0], osim.skeleton->getDof(0)->getName());
+  EXPECT_TRUE(equals(subject->getBodyScales(), bodyScales, 0));
+  EXPECT_EQ(subject->getMarkerOffsets().size(), 1);
+  ASSERT_EQ(subject->getNumTrials(), 2);
+  EXPECT_EQ(subject->getTrialName(0), "walk");
+  EXPECT_EQ(subject->getTrialName(1), "static");
+  EXPECT_EQ(subject->getTrialTimestep(0), 0.01);
+  EXPECT_EQ(subject->getTrialLength(0), trials[0].poses.cols());
+  EXPECT_EQ(subject->getTrialNumForcePlates(0), 2);
+  EXPECT_EQ(subject->getTrialNumForcePlates(1), 0);
+
+  // Windows inside one chunk, across chunk boundaries, and off the end
+  const int chunk = SubjectOnDisk::FRAMES_PER_CHUNK;
+  expectWindow(trials[0], subject->readFrames(0, 3, 10), 3, 10);
+  expectWindow(
+      trials[0], subject->readFrames(0, chunk - 5, 10), chunk - 5, 10);
+  expectWindow(
+      trials[0], subject->readFrames(0, 0, chunk * 2 + 17), 0, chunk * 2 + 17);
+  expectWindow(
+      trials[0],
+      subject->readFrames(0, chunk * 2 + 10, 100),
+      chunk * 2 + 10,
+      7);
+  expectWindow(trials[1], subject->readFrames(1, 0, 5), 0, 5);
+
+  OpenSimFile scaled = subject->readOpenSimFile();
+  ASSERT_TRUE(scaled.skeleton != nullptr);
+  EXPECT_TRUE(equals(scaled.skeleton->getBodyScales(), bodyScales, 1e-12));
+  EXPECT_TRUE(equals(
+      scaled.markersMap[markerName].second,
+      Eigen::Vector3s(
+          osim.markersMap[markerName].second + markerOffsets[markerName]),
+      1e-12));
+
+  std::remove(path.c_str());
+}
+
+//==============================================================================
+TEST(SubjectOnDisk, FILLS_IN_MISSING_DERIVATIVES)
+{
+  OpenSimFile osim = OpenSimParser::parseOsim(OSIM_PATH);
+  const int numDofs = osim.skeleton->getNumDofs();
+
+  SubjectOnDiskTrial trial;
+  trial.name = "ramp";
+  trial.timestep = 0.1;
+  trial.poses = Eigen::MatrixXs::Zero(numDofs, 4);
+  for (int t = 0; t < 4; t++)
+  {
+    // Just move a translational DOF, so the position difference is linear
+    trial.poses(3, t) = 0.5 * t * t;
+  }
+
+  const std::string path = "/tmp/test_SubjectOnDisk_derivatives.bin";
+  ASSERT_TRUE(SubjectOnDisk::writeSubject(
+      path,
+      OSIM_PATH,
+      osim.skeleton->getBodyScales(),
+      std::map<std::string, Eigen::Vector3s>(),
+      {trial}));
+  std::shared_ptr<SubjectOnDisk> subject = SubjectOnDisk::load(path);
+  ASSERT_TRUE(subject != nullptr);
+  SubjectOnDiskFrames frames = subject->readFrames(0, 0, 4);
+
+  // Central differences in the middle, one-sided at the ends
+  EXPECT_NEAR(static_cast<double>(frames.velocities(3, 0)), 5.0, 1e-9);
+  EXPECT_NEAR(static_cast<double>(frames.velocities(3, 1)), 10.0, 1e-9);
+  EXPECT_NEAR(static_cast<double>(frames.velocities(3, 2)), 20.0, 1e-9);
+  EXPECT_NEAR(static_cast<double>(frames.velocities(3, 3)), 25.0, 1e-9);
+  EXPECT_NEAR(static_cast<double>(frames.accelerations(3, 1)), 75.0, 1e-9);
+  EXPECT_TRUE(std::isnan(static_cast<double>(frames.markerRMSErrors(0))));
+
+  std::remove(path.c_str());
+}
+
+//==============================================================================
+TEST(SubjectOnDisk, REJECTS_BAD_FILES)
+{
+  const std::string path = "/tmp/test_SubjectOnDisk_bad.bin";
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "NSUB but not really a subject";
+  }
+  EXPECT_TRUE(SubjectOnDisk::load(path) == nullptr);
+  EXPECT_TRUE(
+      SubjectOnDisk::load("/tmp/test_SubjectOnDisk_missing.bin") == nullptr);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,140 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/common/ThreadPool.hpp"
+#include "dart/math/Random.hpp"
+
+using namespace dart;
+using namespace common;
+
+//==============================================================================
+TEST(ThreadPool, RunsAllTasks)
+{
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.getNumThreads(), 4u);
+
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < 1000; i++)
+  {
+    futures.push_back(pool.submit([i]() { return i * i; }));
+  }
+  pool.waitAll(futures);
+  for (int i = 0; i < 1000; i++)
+  {
+    EXPECT_EQ(futures[i].get(), i * i);
+  }
+}
+
+//==============================================================================
+TEST(ThreadPool, NestedTasksDontDeadlock)
+{
+  // More outer tasks than workers, and every outer task blocks on its own
+  // subtasks. This would deadlock if wait() didn't help run pending work.
+  ThreadPool pool(2);
+  std::atomic<int> count(0);
+
+  std::vector<std::future<void>> outer;
+  for (int i = 0; i < 8; i++)
+  {
+    outer.push_back(pool.submit([&pool, &count]() {
+      std::vector<std::future<void>> inner;
+      for (int j = 0; j < 8; j++)
+      {
+        inner.push_back(pool.submit([&count]() { count++; }));
+      }
+      pool.waitAll(inner);
+    }));
+  }
+  pool.waitAll(outer);
+  EXPECT_EQ(count.load(), 64);
+  EXPECT_FALSE(pool.isWorkerThread());
+}
+
+//==============================================================================
+TEST(ThreadPool, PropagatesExceptions)
+{
+  ThreadPool pool(2);
+  std::future<void> future
+      = pool.submit([]() { throw std::runtime_error("oops"); });
+  pool.wait(future);
+  EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+//==============================================================================
+TEST(ThreadPool, GlobalPoolIsConfigurable)
+{
+  ThreadPool::setGlobalNumThreads(3);
+  EXPECT_EQ(ThreadPool::getGlobal().getNumThreads(), 3u);
+  std::future<int> future = ThreadPool::getGlobal().submit([]() { return 7; });
+  ThreadPool::getGlobal().wait(future);
+  EXPECT_EQ(future.get(), 7);
+}
+
+//==============================================================================
+int addToEach(std::vector<int> values, int offset, std::vector<int>* out)
+{
+  for (int& value : values)
+    value += offset;
+  *out = values;
+  return values.size();
+}
+
+//==============================================================================
+TEST(ThreadPool, CopiesArgumentsLikeAsync)
+{
+  ThreadPool pool(2);
+  std::vector<int> values{1, 2, 3};
+  std::vector<int> out;
+  std::future<int> future = pool.submit(&addToEach, values, 10, &out);
+  // Changing the original after submitting mustn't affect the task
+  values.clear();
+  pool.wait(future);
+  EXPECT_EQ(future.get(), 3);
+  EXPECT_EQ(out, std::vector<int>({11, 12, 13}));
+}
+
+//==============================================================================
+std::vector<double> drawInNestedTasks(ThreadPool& pool)
+{
+  std::vector<std::future<double>> futures;
+  for (int i = 0; i < 8; i++)
+  {
+    futures.push_back(pool.submit([&pool]() {
+      std::future<double> inner = pool.submit(
+          []() { return dart::math::Random::uniform<double>(0.0, 1.0); });
+      double outer = dart::math::Random::uniform<double>(0.0, 1.0);
+      pool.wait(inner);
+      return outer + 10.0 * inner.get();
+    }));
+  }
+  pool.waitAll(futures);
+  std::vector<double> draws;
+  for (std::future<double>& future : futures)
+    draws.push_back(future.get());
+  return draws;
+}
+
+//==============================================================================
+TEST(ThreadPool, DeterministicModeSeedsEachTask)
+{
+  ThreadPool::setDeterministic(true);
+
+  dart::math::Random::setSeed(42);
+  ThreadPool pool(4);
+  std::vector<double> first = drawInNestedTasks(pool);
+  dart::math::Random::setSeed(42);
+  ThreadPool otherPool(2);
+  std::vector<double> second = drawInNestedTasks(otherPool);
+
+  // The same seed gives the same draws in every task, no matter how many
+  // workers there are or which one ran what
+  EXPECT_EQ(first, second);
+  // But different tasks don't all get the same numbers
+  EXPECT_NE(first[0], first[1]);
+
+  ThreadPool::setDeterministic(false);
+  EXPECT_EQ(ThreadPool::getTaskGenerator(), nullptr);
+}
@@ -0,0 +1,60 @@
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/math/VertexKdTree.hpp"
+
+using namespace dart;
+
+//==============================================================================
+TEST(VertexKdTree, MATCHES_BRUTE_FORCE)
+{
+  srand(42);
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 2000; i++)
+  {
+    points.push_back(Eigen::Vector3s::Random());
+  }
+  math::VertexKdTree tree(points);
+  EXPECT_EQ(points.size(), tree.getVertices().size());
+
+  for (int trial = 0; trial < 200; trial++)
+  {
+    Eigen::Vector3s query = Eigen::Vector3s::Random() * 1.5;
+    Eigen::Vector3s scale
+        = Eigen::Vector3s::Random().cwiseAbs() + Eigen::Vector3s::Constant(0.2);
+
+    s_t bruteForce = std::numeric_limits<s_t>::infinity();
+    for (const Eigen::Vector3s& point : points)
+    {
+      bruteForce
+          = std::min(bruteForce, (scale.cwiseProduct(point) - query).norm());
+    }
+
+    int nearest = tree.findNearest(query, scale);
+    ASSERT_NE(-1, nearest);
+    EXPECT_NEAR(
+        bruteForce,
+        (scale.cwiseProduct(tree.getVertices()[nearest]) - query).norm(),
+        1e-12);
+  }
+}
+
+//==============================================================================
+TEST(VertexKdTree, EMPTY_AND_TINY)
+{
+  math::VertexKdTree empty(std::vector<Eigen::Vector3s>{});
+  EXPECT_EQ(-1, empty.findNearest(Eigen::Vector3s::Zero()));
+
+  std::vector<Eigen::Vector3s> points;
+  points.push_back(Eigen::Vector3s(1, 0, 0));
+  points.push_back(Eigen::Vector3s(0, 1, 0));
+  math::VertexKdTree tiny(points);
+  int nearest = tiny.findNearest(Eigen::Vector3s(0, 0.9, 0));
+  EXPECT_TRUE(tiny.getVertices()[nearest].isApprox(Eigen::Vector3s(0, 1, 0)));
+  // Scaling the x axis by 10 pushes (1, 0, 0) out to (10, 0, 0)
+  nearest = tiny.findNearest(
+      Eigen::Vector3s(3, 0, 0), Eigen::Vector3s(10, 1, 1));
+  EXPECT_TRUE(tiny.getVertices()[nearest].isApprox(Eigen::Vector3s(0, 1, 0)));
+}